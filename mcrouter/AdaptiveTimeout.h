@@ -0,0 +1,99 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "mcrouter/LatencyHistogram.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Timeout of one destination derived from its reply latency: a quantile of
+ * the recent latencies times a factor, clamped to [minTimeout, maxTimeout].
+ *
+ * The estimate is recomputed every kUpdatePeriod replies, after which the
+ * latencies are decayed so that it follows recent traffic. It is never
+ * tightened while the destination is failing, that would only make it fail
+ * (and get TKO) faster. Not thread-safe, meant to be owned by a single proxy
+ * thread.
+ */
+class AdaptiveTimeout {
+ public:
+  static constexpr size_t kUpdatePeriod = 1024;
+
+  /**
+   * @param maxTimeout  0 means the timeout the request was routed with.
+   */
+  AdaptiveTimeout(
+      double quantile,
+      double factor,
+      std::chrono::milliseconds minTimeout,
+      std::chrono::milliseconds maxTimeout)
+      : quantile_(quantile),
+        factor_(factor),
+        minTimeout_(minTimeout),
+        maxTimeout_(maxTimeout) {}
+
+  /**
+   * Records the latency of a reply. Timed out requests should be recorded
+   * too (with latency ~ their timeout): if the timeout is too tight, the
+   * quantile lands on it and the timeout grows back.
+   *
+   * @param failing  true if the destination has failures in a row or is TKO.
+   */
+  void onReply(int64_t latencyUs, bool failing) {
+    latencies_.insertSample(latencyUs);
+    if (++samples_ % kUpdatePeriod != 0) {
+      return;
+    }
+
+    const uint64_t quantileUs = latencies_.percentile(quantile_);
+    latencies_.decay();
+    const std::chrono::milliseconds estimate(
+        std::max<int64_t>(1, std::ceil(quantileUs * factor_ / 1000.0)));
+    if (failing && estimate < estimate_) {
+      return;
+    }
+    estimate_ = estimate;
+  }
+
+  /**
+   * @return timeout for a request routed with `timeout`: `timeout` itself
+   *         until kUpdatePeriod replies were seen, the clamped estimate
+   *         afterwards.
+   */
+  std::chrono::milliseconds timeout(std::chrono::milliseconds timeout) const {
+    if (estimate_.count() == 0) {
+      return timeout;
+    }
+    const auto maxTimeout = maxTimeout_.count() != 0 ? maxTimeout_ : timeout;
+    return std::min(maxTimeout, std::max(minTimeout_, estimate_));
+  }
+
+ private:
+  const double quantile_;
+  const double factor_;
+  const std::chrono::milliseconds minTimeout_;
+  const std::chrono::milliseconds maxTimeout_;
+
+  LatencyHistogram latencies_;
+  size_t samples_{0};
+  // 0 until kUpdatePeriod replies were seen.
+  std::chrono::milliseconds estimate_{0};
+};
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
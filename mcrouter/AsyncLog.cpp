@@ -22,20 +22,16 @@
 #include <folly/File.h>
 #include <folly/FileUtil.h>
 #include <folly/fibers/EventBaseLoopController.h>
-#include <folly/json.h>
 #include <folly/system/ThreadName.h>
 
+#include "mcrouter/AsyncLogRecord.h"
+#include "mcrouter/AsyncWriter.h"
 #include "mcrouter/CarbonRouterInstance.h"
 #include "mcrouter/McrouterLogFailure.h"
 #include "mcrouter/lib/fbi/cpp/util.h"
 #include "mcrouter/options.h"
 #include "mcrouter/stats.h"
 
-constexpr folly::StringPiece kAsyncLogMagic{"AS1.0"};
-constexpr folly::StringPiece kAsyncLogMagic2{"AS2.0"};
-
-using folly::dynamic;
-
 namespace facebook {
 namespace memcache {
 namespace mcrouter {
@@ -190,6 +186,21 @@ bool AsyncLog::openFile() {
     return false;
   }
 
+  if (options_.use_asynclog_binary && st.st_size == 0) {
+    auto magic = AsyncLogRecord::kAsyncLogBinaryMagic;
+    if (folly::writeFull(fd, magic.data(), magic.size()) !=
+        static_cast<ssize_t>(magic.size())) {
+      MC_LOG_FAILURE(
+          options_,
+          failure::Category::kSystemError,
+          "Can't write header of async store {}: {}",
+          path,
+          folly::errnoStr(errno));
+      closeFd(fd);
+      return false;
+    }
+  }
+
   file_ = createFile(fd);
   if (!file_) {
     MC_LOG_FAILURE(
@@ -211,68 +222,94 @@ bool AsyncLog::openFile() {
 AsyncLog::AsyncLog(const McrouterOptions& options) : options_(options) {}
 
 /** Adds an asynchronous request to the event log. */
-void AsyncLog::writeDelete(
+bool AsyncLog::writeDelete(
+    AsyncWriter& writer,
     const AccessPoint& ap,
     folly::StringPiece key,
-    folly::StringPiece poolName) {
-  dynamic json = dynamic::array;
-  const auto& host = ap.getHost();
-  const auto port = options_.asynclog_port_override == 0
+    folly::StringPiece poolName,
+    folly::Function<void()> onWritten) {
+  AsyncLogRecord record;
+  record.timestampMs =
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::system_clock::now().time_since_epoch())
+          .count();
+  record.flavor = options_.flavor_name;
+  record.host = ap.getHost();
+  record.port = options_.asynclog_port_override == 0
       ? ap.getPort()
       : options_.asynclog_port_override;
+  record.pool = poolName.str();
+  record.key = key.str();
+
+  bool scheduleFlush;
+  {
+    std::lock_guard<std::mutex> lock(batchMutex_);
+    if (options_.use_asynclog_binary) {
+      record.appendBinary(batch_);
+    } else {
+      record.appendJson(batch_, options_.use_asynclog_version2);
+    }
+    batchCallbacks_.push_back(std::move(onWritten));
+    scheduleFlush = !flushScheduled_;
+    flushScheduled_ = true;
+  }
 
-  if (options_.use_asynclog_version2) {
-    json = dynamic::object;
-    json["f"] = options_.flavor_name;
-    json["h"] = folly::sformat("[{}]:{}", host, port);
-    json["p"] = poolName.str();
-    json["k"] = key.str();
-  } else {
-    /* ["host", port, escaped_command] */
-    json.push_back(host);
-    json.push_back(port);
-    json.push_back(folly::sformat("delete {}\r\n", key));
+  if (scheduleFlush && !writer.run([this]() { flush(); })) {
+    // Nothing else could have been added to the batch: entries are only
+    // added from this proxy's thread, and the batch was empty since no
+    // flush was scheduled.
+    std::lock_guard<std::mutex> lock(batchMutex_);
+    batch_.clear();
+    batchCallbacks_.clear();
+    flushScheduled_ = false;
+    return false;
+  }
+  return true;
+}
+
+void AsyncLog::flush() {
+  std::string batch;
+  std::vector<folly::Function<void()>> callbacks;
+  {
+    std::lock_guard<std::mutex> lock(batchMutex_);
+    batch.swap(batch_);
+    callbacks.swap(batchCallbacks_);
+    flushScheduled_ = false;
+  }
+
+  writeBatch(batch, callbacks.size());
+  for (auto& callback : callbacks) {
+    callback();
   }
+}
 
+void AsyncLog::writeBatch(const std::string& batch, size_t numEntries) {
   if (!openFile()) {
     MC_LOG_FAILURE(
         options_,
         memcache::failure::Category::kSystemError,
-        "asynclog_open() failed (key {}, pool {})",
-        key,
-        poolName);
+        "asynclog_open() failed ({} entries lost)",
+        numEntries);
     return;
   }
 
-  // ["AS1.0", 1289416829.836, "C", ["10.0.0.1", 11302, "delete foo\r\n"]]
-  // OR ["AS2.0", 1289416829.836, "C", {"f":"flavor","h":"[10.0.0.1]:11302",
-  //                                    "p":"pool_name","k":"foo\r\n"}]
-  dynamic jsonOut = dynamic::array;
-  if (options_.use_asynclog_version2) {
-    jsonOut.push_back(kAsyncLogMagic2);
-  } else {
-    jsonOut.push_back(kAsyncLogMagic);
+  ssize_t size = folly::writeFull(file_->fd(), batch.data(), batch.size());
+  if (size == -1 || size_t(size) < batch.size()) {
+    MC_LOG_FAILURE(
+        options_,
+        memcache::failure::Category::kSystemError,
+        "Error fully writing {} asynclog entries",
+        numEntries);
+    return;
   }
 
-  auto timestamp_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-                          std::chrono::system_clock::now().time_since_epoch())
-                          .count();
-  jsonOut.push_back(1e-3 * timestamp_ms);
-
-  jsonOut.push_back(std::string("C"));
-
-  jsonOut.push_back(json);
-
-  auto jstr = folly::toJson(jsonOut) + "\n";
-
-  ssize_t size = folly::writeFull(file_->fd(), jstr.data(), jstr.size());
-  if (size == -1 || size_t(size) < jstr.size()) {
+  if (options_.asynclog_fsync && fdatasync(file_->fd()) != 0) {
     MC_LOG_FAILURE(
         options_,
         memcache::failure::Category::kSystemError,
-        "Error fully writing asynclog request (key {}, pool {})",
-        key,
-        poolName);
+        "Error syncing {} asynclog entries: {}",
+        numEntries,
+        folly::errnoStr(errno));
   }
 }
 
@@ -8,8 +8,12 @@
 #pragma once
 
 #include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
 
 #include <folly/File.h>
+#include <folly/Function.h>
 #include <folly/Range.h>
 
 namespace facebook {
@@ -20,31 +24,55 @@ class McrouterOptions;
 
 namespace mcrouter {
 
+class AsyncWriter;
+
 class AsyncLog {
  public:
   explicit AsyncLog(const McrouterOptions& options);
 
   /**
    * Appends a 'delete' request entry to the asynclog.
-   * This call blocks until the entry is written to the file
-   * or an error occurs.
+   *
+   * Entries are written by writer in batches: everything appended while
+   * a batch is being written goes to the file with the next write() (and
+   * fdatasync(), see asynclog_fsync).
+   *
+   * @param onWritten  called from the writer thread once the entry is
+   *                   written or an error occurs.
+   * @return false if the entry could not be queued, onWritten won't be
+   *         called in that case.
    */
-  void writeDelete(
+  bool writeDelete(
+      AsyncWriter& writer,
       const AccessPoint& ap,
       folly::StringPiece key,
-      folly::StringPiece poolName);
+      folly::StringPiece poolName,
+      folly::Function<void()> onWritten);
 
  private:
   const McrouterOptions& options_;
   std::unique_ptr<folly::File> file_;
   time_t spoolTime_{0};
 
+  std::mutex batchMutex_;
+  // Serialized entries not yet handed to the writer thread.
+  std::string batch_;
+  std::vector<folly::Function<void()>> batchCallbacks_;
+  bool flushScheduled_{false};
+
+  /**
+   * Writes out the current batch. Runs on the writer thread.
+   */
+  void flush();
+
   /**
    * Open async log file.
    *
    * @return True if the file is ready to use. False otherwise.
    */
   bool openFile();
+
+  void writeBatch(const std::string& batch, size_t numEntries);
 };
 }
 }
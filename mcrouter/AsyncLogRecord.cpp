@@ -0,0 +1,214 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include "AsyncLogRecord.h"
+
+#include <cmath>
+
+#include <folly/Bits.h>
+#include <folly/Conv.h>
+#include <folly/Format.h>
+#include <folly/dynamic.h>
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBuf.h>
+#include <folly/json.h>
+
+#include "mcrouter/lib/carbon/CarbonProtocolReader.h"
+#include "mcrouter/lib/carbon/CarbonProtocolWriter.h"
+#include "mcrouter/lib/carbon/CarbonQueueAppender.h"
+#include "mcrouter/lib/fbi/cpp/util.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+namespace {
+
+constexpr folly::StringPiece kAsyncLogMagic{"AS1.0"};
+constexpr folly::StringPiece kAsyncLogMagic2{"AS2.0"};
+constexpr folly::StringPiece kDeletePrefix{"delete "};
+constexpr folly::StringPiece kCrlf{"\r\n"};
+
+AsyncLogRecord parseJsonRecord(folly::StringPiece line) {
+  auto json = parseJsonString(line);
+  checkRuntime(
+      json.isArray() && json.size() == 4 && json[0].isString(),
+      "Malformed async log entry: {}",
+      line);
+  AsyncLogRecord record;
+  record.timestampMs = std::llround(json[1].asDouble() * 1000);
+  const auto& entry = json[3];
+  if (json[0].stringPiece() == kAsyncLogMagic) {
+    // ["host", port, "delete key\r\n"]
+    checkRuntime(
+        entry.isArray() && entry.size() == 3,
+        "Malformed async log entry: {}",
+        line);
+    record.host = entry[0].asString();
+    record.port = folly::to<uint16_t>(entry[1].asInt());
+    auto command = entry[2].stringPiece();
+    checkRuntime(
+        command.removePrefix(kDeletePrefix) && command.removeSuffix(kCrlf),
+        "Malformed async log command: {}",
+        line);
+    record.key = command.str();
+  } else if (json[0].stringPiece() == kAsyncLogMagic2) {
+    // {"f": flavor, "h": "[host]:port", "p": pool, "k": key}
+    checkRuntime(entry.isObject(), "Malformed async log entry: {}", line);
+    record.flavor = entry["f"].asString();
+    record.pool = entry["p"].asString();
+    record.key = entry["k"].asString();
+    auto hostPort = entry["h"].stringPiece();
+    auto pos = hostPort.rfind("]:");
+    checkRuntime(
+        hostPort.startsWith('[') && pos != std::string::npos,
+        "Malformed async log host: {}",
+        line);
+    record.host = hostPort.subpiece(1, pos - 1).str();
+    record.port = folly::to<uint16_t>(hostPort.subpiece(pos + 2));
+  } else {
+    throwRuntime("Unknown async log entry version: {}", line);
+  }
+  return record;
+}
+
+} // anonymous namespace
+
+constexpr folly::StringPiece AsyncLogRecord::kAsyncLogBinaryMagic;
+
+void AsyncLogRecord::serialize(carbon::CarbonProtocolWriter& writer) const {
+  writer.writeStructBegin();
+  writer.writeField(1 /* field id */, timestampMs);
+  writer.writeField(2 /* field id */, flavor);
+  writer.writeField(3 /* field id */, host);
+  writer.writeField(4 /* field id */, port);
+  writer.writeField(5 /* field id */, pool);
+  writer.writeField(6 /* field id */, key);
+  writer.writeFieldStop();
+  writer.writeStructEnd();
+}
+
+void AsyncLogRecord::deserialize(carbon::CarbonProtocolReader& reader) {
+  reader.readStructBegin();
+  while (true) {
+    const auto pr = reader.readFieldHeader();
+    const auto fieldType = pr.first;
+    const auto fieldId = pr.second;
+
+    if (fieldType == carbon::FieldType::Stop) {
+      break;
+    }
+
+    switch (fieldId) {
+      case 1: {
+        reader.readField(timestampMs, fieldType);
+        break;
+      }
+      case 2: {
+        reader.readField(flavor, fieldType);
+        break;
+      }
+      case 3: {
+        reader.readField(host, fieldType);
+        break;
+      }
+      case 4: {
+        reader.readField(port, fieldType);
+        break;
+      }
+      case 5: {
+        reader.readField(pool, fieldType);
+        break;
+      }
+      case 6: {
+        reader.readField(key, fieldType);
+        break;
+      }
+      default: {
+        reader.skip(fieldType);
+        break;
+      }
+    }
+  }
+  reader.readStructEnd();
+}
+
+void AsyncLogRecord::appendBinary(std::string& out) const {
+  carbon::CarbonQueueAppenderStorage storage;
+  carbon::CarbonProtocolWriter writer(storage);
+  serialize(writer);
+
+  const uint32_t size = folly::Endian::little(
+      static_cast<uint32_t>(storage.computeBodySize()));
+  out.append(reinterpret_cast<const char*>(&size), sizeof(size));
+  const auto iovs = storage.getIovecs();
+  for (size_t i = 0; i < iovs.second; ++i) {
+    const struct iovec* iov = iovs.first + i;
+    out.append(static_cast<const char*>(iov->iov_base), iov->iov_len);
+  }
+}
+
+void AsyncLogRecord::appendJson(std::string& out, bool version2) const {
+  folly::dynamic entry = folly::dynamic::array;
+  if (version2) {
+    entry = folly::dynamic::object("f", flavor)(
+        "h", folly::sformat("[{}]:{}", host, port))("p", pool)("k", key);
+  } else {
+    /* ["host", port, escaped_command] */
+    entry.push_back(host);
+    entry.push_back(port);
+    entry.push_back(folly::to<std::string>(kDeletePrefix, key, kCrlf));
+  }
+  folly::dynamic jsonOut = folly::dynamic::array(
+      version2 ? kAsyncLogMagic2 : kAsyncLogMagic,
+      1e-3 * timestampMs,
+      "C",
+      std::move(entry));
+  out.append(folly::toJson(jsonOut));
+  out.push_back('\n');
+}
+
+bool AsyncLogRecord::operator==(const AsyncLogRecord& other) const {
+  return timestampMs == other.timestampMs && flavor == other.flavor &&
+      host == other.host && port == other.port && pool == other.pool &&
+      key == other.key;
+}
+
+std::vector<AsyncLogRecord> parseAsyncLog(folly::StringPiece contents) {
+  std::vector<AsyncLogRecord> records;
+  if (!contents.removePrefix(AsyncLogRecord::kAsyncLogBinaryMagic)) {
+    while (!contents.empty()) {
+      auto pos = contents.find('\n');
+      auto line = contents.subpiece(0, pos);
+      if (!line.empty()) {
+        records.push_back(parseJsonRecord(line));
+      }
+      contents.advance(
+          pos == std::string::npos ? contents.size() : pos + 1);
+    }
+    return records;
+  }
+
+  while (contents.size() >= sizeof(uint32_t)) {
+    const auto size = folly::Endian::little(
+        folly::loadUnaligned<uint32_t>(contents.data()));
+    if (contents.size() - sizeof(uint32_t) < size) {
+      break;
+    }
+    contents.advance(sizeof(uint32_t));
+    auto buf = folly::IOBuf::wrapBuffer(contents.data(), size);
+    carbon::CarbonProtocolReader reader(carbon::CarbonCursor(buf.get()));
+    records.emplace_back();
+    records.back().deserialize(reader);
+    contents.advance(size);
+  }
+  return records;
+}
+
+} // mcrouter
+} // memcache
+} // facebook
@@ -0,0 +1,76 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <folly/Range.h>
+
+namespace carbon {
+class CarbonProtocolReader;
+class CarbonProtocolWriter;
+} // carbon
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * A 'delete' that couldn't be delivered and has to be replayed later.
+ *
+ * Async log files are in one of the following formats:
+ *  - JSON lines, one per entry:
+ *    ["AS1.0", 1289416829.836, "C", ["10.0.0.1", 11302, "delete foo\r\n"]]
+ *    or
+ *    ["AS2.0", 1289416829.836, "C", {"f":"flavor","h":"[10.0.0.1]:11302",
+ *                                    "p":"pool_name","k":"foo"}]
+ *  - binary (see use_asynclog_binary): kAsyncLogBinaryMagic followed by
+ *    entries, each a 4 byte little-endian length and the carbon-serialized
+ *    AsyncLogRecord.
+ */
+struct AsyncLogRecord {
+  static constexpr folly::StringPiece kAsyncLogBinaryMagic{"\0AS3.0\n", 7};
+
+  int64_t timestampMs{0};
+  std::string flavor;
+  std::string host;
+  uint16_t port{0};
+  std::string pool;
+  std::string key;
+
+  void serialize(carbon::CarbonProtocolWriter& writer) const;
+  void deserialize(carbon::CarbonProtocolReader& reader);
+
+  /**
+   * Appends the binary form of this record (without the file magic) to out.
+   */
+  void appendBinary(std::string& out) const;
+
+  /**
+   * Appends the JSON line of this record to out.
+   *
+   * @param version2  write AS2.0 instead of AS1.0 entry
+   */
+  void appendJson(std::string& out, bool version2) const;
+
+  bool operator==(const AsyncLogRecord& other) const;
+};
+
+/**
+ * Parses contents of an async log file in any of the formats.
+ *
+ * @throw std::runtime_error  if the contents are malformed. Trailing partial
+ *                            binary record (e.g. after a crash) is ignored.
+ */
+std::vector<AsyncLogRecord> parseAsyncLog(folly::StringPiece contents);
+
+} // mcrouter
+} // memcache
+} // facebook
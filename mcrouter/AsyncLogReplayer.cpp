@@ -0,0 +1,217 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include "AsyncLogReplayer.h"
+
+#include <time.h>
+
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <boost/filesystem.hpp>
+#include <glog/logging.h>
+
+#include <folly/Conv.h>
+#include <folly/FileUtil.h>
+#include <folly/fibers/Baton.h>
+#include <folly/fibers/FiberManagerMap.h>
+#include <folly/io/async/EventBase.h>
+
+#include "mcrouter/AsyncLogRecord.h"
+#include "mcrouter/lib/network/AsyncMcClient.h"
+#include "mcrouter/lib/network/gen/Memcache.h"
+#include "mcrouter/options.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+namespace {
+
+/**
+ * Spaces sends out evenly to stay under maxRate. All fibers run on the same
+ * thread, so no synchronization is needed.
+ */
+class ReplayPacer {
+ public:
+  explicit ReplayPacer(double maxRate)
+      : interval_(
+            maxRate > 0.0 ? std::chrono::duration_cast<
+                                std::chrono::steady_clock::duration>(
+                                std::chrono::duration<double>(1.0 / maxRate))
+                          : std::chrono::steady_clock::duration::zero()),
+        next_(std::chrono::steady_clock::now()) {}
+
+  void wait() {
+    if (interval_ == std::chrono::steady_clock::duration::zero()) {
+      return;
+    }
+    const auto now = std::chrono::steady_clock::now();
+    const auto sendTime = std::max(next_, now);
+    next_ = sendTime + interval_;
+    if (sendTime > now) {
+      folly::fibers::Baton baton;
+      baton.try_wait_for(sendTime - now);
+    }
+  }
+
+ private:
+  const std::chrono::steady_clock::duration interval_;
+  std::chrono::steady_clock::time_point next_;
+};
+
+} // anonymous namespace
+
+std::vector<AsyncLogDeleteBatch> batchAsyncLogDeletes(
+    const std::vector<AsyncLogRecord>& records) {
+  std::vector<AsyncLogDeleteBatch> batches;
+  std::unordered_map<std::string, size_t> batchIndex;
+  std::vector<std::unordered_set<std::string>> seenKeys;
+  for (const auto& record : records) {
+    auto destination = folly::to<std::string>(record.host, ':', record.port);
+    auto it = batchIndex.find(destination);
+    if (it == batchIndex.end()) {
+      it = batchIndex.emplace(std::move(destination), batches.size()).first;
+      batches.emplace_back();
+      batches.back().host = record.host;
+      batches.back().port = record.port;
+      seenKeys.emplace_back();
+    }
+    if (seenKeys[it->second].insert(record.key).second) {
+      batches[it->second].keys.push_back(record.key);
+    }
+  }
+  return batches;
+}
+
+AsyncLogReplayResult replayAsyncLogDeletes(
+    const std::vector<AsyncLogDeleteBatch>& batches,
+    const AsyncLogReplayOptions& options) {
+  AsyncLogReplayResult result;
+  folly::EventBase evb;
+  auto& fm = folly::fibers::getFiberManager(evb);
+  ReplayPacer pacer(options.maxRate);
+
+  std::vector<std::unique_ptr<AsyncMcClient>> clients;
+  for (const auto& batch : batches) {
+    if (batch.keys.empty()) {
+      continue;
+    }
+    ConnectionOptions connectionOptions(
+        batch.host, batch.port, mc_ascii_protocol);
+    connectionOptions.writeTimeout = options.timeout;
+    clients.push_back(
+        std::make_unique<AsyncMcClient>(evb, std::move(connectionOptions)));
+    auto& client = *clients.back();
+
+    // Each fiber keeps one delete inflight, taking the next key once the
+    // previous one got its reply.
+    auto next = std::make_shared<size_t>(0);
+    const auto numFibers =
+        std::min(std::max<size_t>(1, options.maxInflight), batch.keys.size());
+    for (size_t i = 0; i < numFibers; ++i) {
+      fm.addTask([&batch, &client, &pacer, &options, &result, next]() {
+        while (*next < batch.keys.size()) {
+          const auto& key = batch.keys[(*next)++];
+          pacer.wait();
+          auto reply =
+              client.sendSync(McDeleteRequest(key), options.timeout);
+          if (reply.result() == mc_res_deleted ||
+              reply.result() == mc_res_notfound) {
+            ++result.deleted;
+          } else {
+            ++result.failed;
+            VLOG(1) << "Failed to replay delete of '" << key << "' to "
+                    << batch.host << ":" << batch.port << ": "
+                    << mc_res_to_string(reply.result());
+          }
+        }
+      });
+    }
+  }
+
+  while (fm.hasTasks()) {
+    evb.loopOnce();
+  }
+  for (auto& client : clients) {
+    client->closeNow();
+  }
+  clients.clear();
+  evb.loop();
+  return result;
+}
+
+bool replayAsyncSpool(
+    const std::string& spoolDir,
+    const AsyncLogReplayOptions& options) {
+  namespace fs = boost::filesystem;
+
+  // Files modified recently might still be appended to by a running router.
+  const auto cutoff = time(nullptr) - DEFAULT_ASYNCLOG_LIFETIME;
+  std::vector<fs::path> files;
+  std::vector<AsyncLogRecord> records;
+  bool ok = true;
+  boost::system::error_code ec;
+  for (fs::recursive_directory_iterator it(spoolDir, ec), end;
+       !ec && it != end;
+       it.increment(ec)) {
+    if (!fs::is_regular_file(it->status()) ||
+        fs::last_write_time(it->path()) > cutoff) {
+      continue;
+    }
+    std::string contents;
+    if (!folly::readFile(it->path().c_str(), contents)) {
+      LOG(ERROR) << "Can't read async log file " << it->path().string();
+      ok = false;
+      continue;
+    }
+    try {
+      auto fileRecords = parseAsyncLog(contents);
+      records.insert(
+          records.end(),
+          std::make_move_iterator(fileRecords.begin()),
+          std::make_move_iterator(fileRecords.end()));
+      files.push_back(it->path());
+    } catch (const std::exception& e) {
+      LOG(ERROR) << "Skipping async log file " << it->path().string() << ": "
+                 << e.what();
+      ok = false;
+    }
+  }
+  if (ec) {
+    LOG(ERROR) << "Can't list async spool " << spoolDir << ": "
+               << ec.message();
+    return false;
+  }
+
+  const auto batches = batchAsyncLogDeletes(records);
+  const auto result = replayAsyncLogDeletes(batches, options);
+  LOG(INFO) << "Replayed " << records.size() << " async log entries from "
+            << files.size() << " files to " << batches.size()
+            << " destinations: " << result.deleted << " deletes succeeded, "
+            << result.failed << " failed";
+  if (result.failed != 0) {
+    LOG(WARNING) << "Keeping async log files to retry failed deletes";
+    return false;
+  }
+
+  for (const auto& file : files) {
+    fs::remove(file, ec);
+    if (ec) {
+      LOG(ERROR) << "Can't remove async log file " << file.string() << ": "
+                 << ec.message();
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+} // mcrouter
+} // memcache
+} // facebook
@@ -0,0 +1,73 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+struct AsyncLogRecord;
+
+/**
+ * Keys to delete from one destination.
+ */
+struct AsyncLogDeleteBatch {
+  std::string host;
+  uint16_t port{0};
+  std::vector<std::string> keys;
+};
+
+struct AsyncLogReplayOptions {
+  // Deletes pipelined on the connection to each destination.
+  size_t maxInflight{16};
+  // Deletes sent per second over all destinations, 0 means no limit.
+  double maxRate{0.0};
+  std::chrono::milliseconds timeout{1000};
+};
+
+struct AsyncLogReplayResult {
+  // Deletes that were acknowledged (deleted or not found).
+  size_t deleted{0};
+  size_t failed{0};
+};
+
+/**
+ * Groups async log records by destination. Every key is deleted once per
+ * destination, no matter how many times it was logged; batches and keys
+ * keep the order in which they first appear in records.
+ */
+std::vector<AsyncLogDeleteBatch> batchAsyncLogDeletes(
+    const std::vector<AsyncLogRecord>& records);
+
+/**
+ * Sends the deletes over one ascii connection per destination, all
+ * destinations at once. Blocks until every delete got a reply or failed.
+ */
+AsyncLogReplayResult replayAsyncLogDeletes(
+    const std::vector<AsyncLogDeleteBatch>& batches,
+    const AsyncLogReplayOptions& options);
+
+/**
+ * Replays every async log file in spoolDir that isn't written to anymore,
+ * and removes the files if all their deletes were acknowledged. Otherwise
+ * the files are kept to be replayed again later (deletes are idempotent).
+ *
+ * @return false if some files couldn't be read or some deletes failed.
+ */
+bool replayAsyncSpool(
+    const std::string& spoolDir,
+    const AsyncLogReplayOptions& options);
+
+} // mcrouter
+} // memcache
+} // facebook
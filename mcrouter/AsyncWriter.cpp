@@ -83,31 +83,93 @@ bool AsyncWriter::start(folly::StringPiece threadName) {
   return true;
 }
 
-bool AsyncWriter::run(std::function<void()> f) {
+namespace {
+
+struct RunTask {
+  explicit RunTask(std::function<void()> f) : func(std::move(f)) {}
+
+  awriter_entry_t entry;
+  std::function<void()> func;
+};
+
+int runTaskPerform(awriter_entry_t* e) {
+  static_cast<RunTask*>(e->context)->func();
+  return 0;
+}
+
+void runTaskCompleted(awriter_entry_t* e, int /* result */) {
+  delete static_cast<RunTask*>(e->context);
+}
+
+// Functions passed to run() are run even after stop(), unlike writes.
+const awriter_callbacks_t kRunTaskCallbacks = {
+    &runTaskCompleted,
+    &runTaskPerform,
+};
+
+} // anonymous namespace
+
+bool AsyncWriter::run(std::function<void()> f, Priority priority) {
+  auto task = std::make_unique<RunTask>(std::move(f));
+  task->entry.context = task.get();
+  task->entry.callbacks = &kRunTaskCallbacks;
+  if (!queue(&task->entry, priority)) {
+    return false;
+  }
+  task.release();
+  return true;
+}
+
+bool AsyncWriter::queue(awriter_entry_t* e, Priority priority) {
   std::lock_guard<SFRReadLock> lock(runLock_.readLock());
   if (stopped_) {
     return false;
   }
 
-  bool decQueueSize = false;
-  if (maxQueueSize_ != 0) {
-    auto size = queueSize_.load();
-    do {
-      if (maxQueueSize_ == size) {
-        return false;
+  auto size = queueSize_.load();
+  do {
+    if (maxQueueSize_ != 0 && size >= maxQueueSize_) {
+      return false;
+    }
+  } while (!queueSize_.compare_exchange_weak(size, size + 1));
+
+  auto& q = priority == Priority::Normal ? normalQueue_ : lowQueue_;
+  // Only the first entry of a batch needs to wake up the writer; drain()
+  // picks up everything queued until it finds both queues empty.
+  if (q.insertHead(e)) {
+    fiberManager_.addTaskRemote(
+        [this]() { fiberManager_.runInMainContext([this]() { drain(); }); });
+  }
+  return true;
+}
+
+void AsyncWriter::drain() {
+  while (true) {
+    if (!normalQueue_.empty()) {
+      normalQueue_.sweep([this](awriter_entry_t* e) { execute(e); });
+      continue;
+    }
+    if (lowPending_.empty()) {
+      lowQueue_.sweep([this](awriter_entry_t* e) { lowPending_.push_back(e); });
+      if (lowPending_.empty()) {
+        return;
       }
-    } while (!queueSize_.compare_exchange_weak(size, size + 1));
-    decQueueSize = true;
+    }
+    // One at a time, so that Normal entries queued meanwhile go first.
+    auto e = lowPending_.front();
+    lowPending_.pop_front();
+    execute(e);
   }
+}
 
-  fiberManager_.addTaskRemote(
-      [this, f_ = std::move(f), decQueueSize]() mutable {
-        fiberManager_.runInMainContext(std::move(f_));
-        if (decQueueSize) {
-          --queueSize_;
-        }
-      });
-  return true;
+void AsyncWriter::execute(awriter_entry_t* e) {
+  int r = EPIPE;
+  if (e->callbacks == &kRunTaskCallbacks || isActive()) {
+    r = e->callbacks->perform_write(e);
+  }
+  // completed() may queue e again (or free it).
+  --queueSize_;
+  e->callbacks->completed(e, r);
 }
 
 void AsyncWriter::increaseMaxQueueSize(size_t add) {
@@ -123,15 +185,11 @@ void AsyncWriter::makeQueueSizeUnlimited() {
   maxQueueSize_ = 0;
 }
 
-bool awriter_queue(AsyncWriter* w, awriter_entry_t* e) {
-  return w->run([e, w]() {
-    if (!w->isActive()) {
-      e->callbacks->completed(e, EPIPE);
-      return;
-    }
-    int r = e->callbacks->perform_write(e);
-    e->callbacks->completed(e, r);
-  });
+bool awriter_queue(
+    AsyncWriter* w,
+    awriter_entry_t* e,
+    AsyncWriter::Priority priority) {
+  return w->queue(e, priority);
 }
 
 } // namespace mcrouter
@@ -10,25 +10,41 @@
 #include <unistd.h>
 
 #include <atomic>
+#include <deque>
 #include <functional>
 #include <memory>
 #include <thread>
 
+#include <folly/AtomicIntrusiveLinkedList.h>
 #include <folly/Range.h>
 #include <folly/fibers/FiberManager.h>
 #include <folly/io/async/EventBase.h>
 
+#include "mcrouter/AsyncWriterEntry.h"
 #include "mcrouter/lib/fbi/cpp/sfrlock.h"
 
 namespace facebook {
 namespace memcache {
 namespace mcrouter {
 
-// Forward declaration.
-struct awriter_entry_t;
-
+/**
+ * Runs functions and writes (see awriter_queue()) on a dedicated thread.
+ *
+ * Queueing is lock-free: entries are pushed onto an intrusive MPSC list,
+ * so awriter_queue() doesn't allocate, and the writer thread is only woken
+ * up when its queue goes from empty to non-empty.
+ */
 class AsyncWriter {
  public:
+  /**
+   * Entries of Normal priority are always run before Low priority ones
+   * (e.g. stats dumps), regardless of the order they were queued in.
+   */
+  enum class Priority {
+    Normal,
+    Low,
+  };
+
   /**
    * @param maxQueueSize: maximum number of run requests in a queue. "run" will
    *                      fail if there is already maxQueueSize requests in
@@ -64,7 +80,7 @@ class AsyncWriter {
    * @return true on success, false on failure (e.g. when we hit the queue
              size limit)
    */
-  bool run(std::function<void()> f);
+  bool run(std::function<void()> f, Priority priority = Priority::Normal);
 
   /**
    * Increase the maximum queue size. The max queue size will never decrease.
@@ -82,20 +98,41 @@ class AsyncWriter {
   ~AsyncWriter();
 
  private:
+  using Queue = folly::
+      AtomicIntrusiveLinkedList<awriter_entry_t, &awriter_entry_t::hook>;
+
   size_t maxQueueSize_;
   std::atomic<size_t> queueSize_{0};
   std::atomic<bool> stopped_{false};
   SFRLock runLock_;
 
+  Queue normalQueue_;
+  Queue lowQueue_;
+  // Low priority entries taken off lowQueue_, accessed by the writer only.
+  std::deque<awriter_entry_t*> lowPending_;
+
   folly::fibers::FiberManager fiberManager_;
   folly::EventBase eventBase_;
   std::thread thread_;
+
+  bool queue(awriter_entry_t* e, Priority priority);
+  void drain();
+  void execute(awriter_entry_t* e);
+
+  friend bool
+  awriter_queue(AsyncWriter* w, awriter_entry_t* e, Priority priority);
 };
 
 /**
+ * Queues e to be written by w. e must stay alive until its completed
+ * callback is called, and must not be queued again before that.
+ *
  * @return true on success, false otherwise
  */
-bool awriter_queue(AsyncWriter* w, awriter_entry_t* e);
+bool awriter_queue(
+    AsyncWriter* w,
+    awriter_entry_t* e,
+    AsyncWriter::Priority priority = AsyncWriter::Priority::Normal);
 
 } // mcrouter
 } // memcache
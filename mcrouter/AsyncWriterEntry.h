@@ -7,7 +7,7 @@
  */
 #pragma once
 
-#include "mcrouter/lib/fbi/queue.h"
+#include <folly/AtomicIntrusiveLinkedList.h>
 
 namespace facebook {
 namespace memcache {
@@ -22,7 +22,7 @@ struct awriter_callbacks_t {
 };
 
 struct awriter_entry_t {
-  TAILQ_ENTRY(awriter_entry_t) links;
+  folly::AtomicIntrusiveLinkedListHook<awriter_entry_t> hook;
   void* context;
   const awriter_callbacks_t* callbacks;
 };
@@ -0,0 +1,59 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include "BusyPoller.h"
+
+#include "mcrouter/ProxyStats.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+BusyPoller::BusyPoller(
+    folly::EventBase& evb,
+    std::chrono::microseconds spinTime,
+    ProxyStats& stats)
+    : evb_(evb), spinTime_(spinTime), stats_(stats) {
+  evb_.setExecutionObserver(this);
+  lastEvent_ = std::chrono::steady_clock::now();
+  evb_.runInLoop(this);
+}
+
+BusyPoller::~BusyPoller() {
+  if (evb_.getExecutionObserver() == this) {
+    evb_.setExecutionObserver(nullptr);
+  }
+}
+
+void BusyPoller::starting(uintptr_t /* id */) noexcept {
+  if (!sawEvent_) {
+    sawEvent_ = true;
+    if (!isLoopCallbackScheduled()) {
+      // Woke up from a blocking wait, start polling again.
+      evb_.runInLoop(this);
+    }
+  }
+}
+
+void BusyPoller::runLoopCallback() noexcept {
+  const auto now = std::chrono::steady_clock::now();
+  if (sawEvent_) {
+    sawEvent_ = false;
+    lastEvent_ = now;
+    stats_.increment(proxy_busy_poll_useful_loops_stat);
+  } else {
+    stats_.increment(proxy_busy_poll_idle_spins_stat);
+  }
+  // A pending loop callback makes the next iteration poll without blocking.
+  if (now - lastEvent_ < spinTime_) {
+    evb_.runInLoop(this);
+  }
+}
+
+} // mcrouter
+} // memcache
+} // facebook
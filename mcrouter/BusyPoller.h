@@ -0,0 +1,61 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include <folly/experimental/ExecutionObserver.h>
+#include <folly/io/async/EventBase.h>
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+class ProxyStats;
+
+/**
+ * Keeps an event loop polling without blocking for spinTime after the last
+ * iteration that handled an event, so that events arriving meanwhile don't
+ * pay for waking the thread up. After that the loop blocks as usual until
+ * the next event. Iterations spent polling in vain and iterations that handled
+ * events are counted in proxy_busy_poll_* stats.
+ *
+ * Uses the execution observer of the event base to notice events, so it
+ * can't be combined with another one. Must be created, used and destroyed
+ * on the event base thread.
+ */
+class BusyPoller : public folly::EventBase::LoopCallback,
+                   public folly::ExecutionObserver {
+ public:
+  BusyPoller(
+      folly::EventBase& evb,
+      std::chrono::microseconds spinTime,
+      ProxyStats& stats);
+  ~BusyPoller();
+
+  BusyPoller(const BusyPoller&) = delete;
+  BusyPoller& operator=(const BusyPoller&) = delete;
+
+  void starting(uintptr_t id) noexcept override final;
+  void runnable(uintptr_t /* id */) noexcept override final {}
+  void stopped(uintptr_t /* id */) noexcept override final {}
+
+  void runLoopCallback() noexcept override final;
+
+ private:
+  folly::EventBase& evb_;
+  const std::chrono::microseconds spinTime_;
+  ProxyStats& stats_;
+  std::chrono::steady_clock::time_point lastEvent_;
+  bool sawEvent_{false};
+};
+
+} // mcrouter
+} // memcache
+} // facebook
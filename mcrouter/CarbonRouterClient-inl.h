@@ -5,6 +5,12 @@
  *  file in the root directory of this source tree.
  *
  */
+#include <folly/fibers/FiberManager.h>
+#if FOLLY_HAS_COROUTINES
+#include <folly/Optional.h>
+#include <folly/experimental/coro/Baton.h>
+#endif
+
 #include "mcrouter/CarbonRouterInstance.h"
 #include "mcrouter/ProxyRequestContextTyped.h"
 
@@ -88,7 +94,7 @@ bool CarbonRouterClient<RouterInfo>::send(
     F&& callback,
     folly::StringPiece ipAddr) {
   auto makePreq = [this, ipAddr, &req, &callback] {
-    auto preq = createProxyRequestContext(*proxy_, req, [
+    auto preq = createProxyRequestContext(*proxyFor(req), req, [
       this,
       cb = std::forward<F>(callback)
     ](const Request& request, ReplyT<Request>&& reply) mutable {
@@ -115,6 +121,31 @@ bool CarbonRouterClient<RouterInfo>::send(
   return sendMultiImpl(1, makePreq, cancelRemaining);
 }
 
+#if FOLLY_HAS_COROUTINES
+template <class RouterInfo>
+template <class Request>
+folly::coro::Task<ReplyT<Request>> CarbonRouterClient<RouterInfo>::co_send(
+    const Request& req,
+    folly::StringPiece ipAddr) {
+  // Both live in the coroutine frame, which outlives the request: the
+  // callback is the last thing to touch them before resuming us.
+  folly::coro::Baton baton;
+  folly::Optional<ReplyT<Request>> reply;
+  auto scheduled = send(
+      req,
+      [&baton, &reply](const Request&, ReplyT<Request>&& r) {
+        reply = std::move(r);
+        baton.post();
+      },
+      ipAddr);
+  if (!scheduled) {
+    co_return ReplyT<Request>(mc_res_local_error);
+  }
+  co_await baton;
+  co_return std::move(*reply);
+}
+#endif
+
 template <class RouterInfo>
 template <class F, class G>
 bool CarbonRouterClient<RouterInfo>::sendMultiImpl(
@@ -132,9 +163,7 @@ bool CarbonRouterClient<RouterInfo>::sendMultiImpl(
         sendSameThread(makeNextPreq());
       }
     } else {
-      for (size_t i = 0; i < nreqs; ++i) {
-        sendRemoteThread(makeNextPreq());
-      }
+      sendRemoteThread(nreqs, makeNextPreq);
     }
   } else if (maxOutstandingError()) {
     for (size_t begin = 0; begin < nreqs;) {
@@ -150,9 +179,7 @@ bool CarbonRouterClient<RouterInfo>::sendMultiImpl(
           sendSameThread(makeNextPreq());
         }
       } else {
-        for (size_t i = begin; i < end; i++) {
-          sendRemoteThread(makeNextPreq());
-        }
+        sendRemoteThread(end - begin, makeNextPreq);
       }
 
       begin = end;
@@ -165,9 +192,7 @@ bool CarbonRouterClient<RouterInfo>::sendMultiImpl(
 
     while (i < nreqs) {
       n += counting_sem_lazy_wait(outstandingReqsSem(), nreqs - n);
-      for (size_t j = i; j < n; ++j) {
-        sendRemoteThread(makeNextPreq());
-      }
+      sendRemoteThread(n - i, makeNextPreq);
       i = n;
     }
   }
@@ -187,9 +212,10 @@ bool CarbonRouterClient<RouterInfo>::send(
       detail::unwrapRequest(std::declval<IterReference>()))>::type;
 
   auto makeNextPreq = [this, ipAddr, &callback, &begin]() {
+    const auto& request = detail::unwrapRequest(*begin);
     auto preq = createProxyRequestContext(
-        *proxy_,
-        detail::unwrapRequest(*begin),
+        *proxyFor(request),
+        request,
         [this, callback](
             const Request& request, ReplyT<Request>&& reply) mutable {
           detail::bumpCarbonRouterClientStats(stats_, request, reply);
@@ -225,16 +251,79 @@ bool CarbonRouterClient<RouterInfo>::send(
 }
 
 template <class RouterInfo>
+template <class F>
 void CarbonRouterClient<RouterInfo>::sendRemoteThread(
-    std::unique_ptr<ProxyRequestContext> req) {
-  proxy_->messageQueue_->blockingWriteRelaxed(
-      ProxyMessage::Type::REQUEST, req.release());
+    size_t nreqs,
+    F& makeNextPreq) {
+  if (nreqs == 0) {
+    return;
+  }
+
+  if (nreqs == 1) {
+    auto preq = makeNextPreq();
+    auto& proxy =
+        proxies_.empty() ? *proxy_ : *proxies_[preq->proxy().getId()];
+    proxy.messageQueue_->blockingWriteNoNotify(
+        ProxyMessage::Type::REQUEST, preq.release());
+    proxy.messageQueue_->notifyRelaxed();
+    return;
+  }
+
+  if (proxies_.empty()) {
+    auto batch = std::make_unique<ProxyRequestBatch>();
+    batch->reserve(nreqs);
+    for (size_t i = 0; i < nreqs; ++i) {
+      batch->push_back(makeNextPreq());
+    }
+    sendRemoteThread(*proxy_, std::move(batch));
+    return;
+  }
+
+  // Split the requests by proxy, so that each proxy still gets its share
+  // as a single message.
+  std::vector<std::unique_ptr<ProxyRequestBatch>> batches(proxies_.size());
+  for (size_t i = 0; i < nreqs; ++i) {
+    auto preq = makeNextPreq();
+    auto& batch = batches[preq->proxy().getId()];
+    if (!batch) {
+      batch = std::make_unique<ProxyRequestBatch>();
+    }
+    batch->push_back(std::move(preq));
+  }
+  for (size_t id = 0; id < batches.size(); ++id) {
+    if (batches[id]) {
+      sendRemoteThread(*proxies_[id], std::move(batches[id]));
+    }
+  }
+}
+
+template <class RouterInfo>
+void CarbonRouterClient<RouterInfo>::sendRemoteThread(
+    Proxy<RouterInfo>& proxy,
+    std::unique_ptr<ProxyRequestBatch> batch) {
+  if (batch->size() == 1) {
+    proxy.messageQueue_->blockingWriteNoNotify(
+        ProxyMessage::Type::REQUEST, batch->front().release());
+  } else {
+    proxy.messageQueue_->blockingWriteNoNotify(
+        ProxyMessage::Type::REQUEST_BATCH, batch.release());
+  }
+  proxy.messageQueue_->notifyRelaxed();
 }
 
 template <class RouterInfo>
 void CarbonRouterClient<RouterInfo>::sendSameThread(
     std::unique_ptr<ProxyRequestContext> req) {
   proxy_->messageReady(ProxyMessage::Type::REQUEST, req.release());
+  // Running the fiber manager from one of its own fibers or callbacks
+  // would re-enter its loop, the request is picked up when it's back.
+  if (runInline_ &&
+      folly::fibers::FiberManager::getFiberManagerUnsafe() == nullptr) {
+    proxy_->fiberManager().loopUntilNoReady();
+    if (auto leafFm = proxy_->leafFiberManager()) {
+      leafFm->loopUntilNoReady();
+    }
+  }
 }
 
 template <class RouterInfo>
@@ -247,7 +336,24 @@ CarbonRouterClient<RouterInfo>::CarbonRouterClient(
       router_(std::move(rtr)),
       sameThread_(sameThread) {
   if (auto router = router_.lock()) {
-    proxy_ = router->getProxy(router->nextProxyIndex());
+    index_ = router->nextProxyIndex();
+    proxy_ = router->getProxy(index_);
+    if (!sameThread_) {
+      proxyGroups_ = router->proxyGroups();
+      keyAffinity_ = router->opts().proxy_key_affinity;
+    }
+    if (proxyGroups_ != nullptr ||
+        (keyAffinity_ && router->opts().num_proxies > 1)) {
+      proxies_.reserve(router->opts().num_proxies);
+      for (size_t i = 0; i < router->opts().num_proxies; ++i) {
+        proxies_.push_back(router->getProxy(i));
+      }
+    }
+    if (proxyGroups_ != nullptr) {
+      // Requests that don't go through proxyFor().
+      const auto& defaultProxies = proxyGroups_->defaultProxies();
+      proxy_ = proxies_[defaultProxies[index_ % defaultProxies.size()]];
+    }
   }
 }
 
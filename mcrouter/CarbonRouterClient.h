@@ -7,11 +7,20 @@
  */
 #pragma once
 
+#include <memory>
+#include <vector>
+
 #include <folly/IntrusiveList.h>
+#include <folly/Portability.h>
 #include <folly/Range.h>
+#if FOLLY_HAS_COROUTINES
+#include <folly/experimental/coro/Task.h>
+#endif
 
 #include "mcrouter/CarbonRouterClientBase.h"
+#include "mcrouter/ProxyGroups.h"
 #include "mcrouter/lib/CacheClientStats.h"
+#include "mcrouter/lib/Operation.h"
 #include "mcrouter/lib/mc/msg.h"
 
 namespace facebook {
@@ -26,11 +35,16 @@ template <class RouterInfo>
 class Proxy;
 
 class ProxyRequestContext;
+using ProxyRequestBatch = std::vector<std::unique_ptr<ProxyRequestContext>>;
 
 /**
  * A mcrouter client is used to communicate with a mcrouter instance.
  * Typically a client is long lived. Request sent through a single client
- * will be sent to the same mcrouter thread that's determined once on creation.
+ * will be sent to the same mcrouter thread that's determined once on creation,
+ * unless proxy_key_affinity is enabled, in which case the thread is picked
+ * by the routing key hash of each request (all requests for a key go to the
+ * same thread, regardless of their destination), or proxy_groups dedicates
+ * threads to the routing prefix of the request.
  *
  * Create via CarbonRouterInstance::createClient().
  */
@@ -105,6 +119,24 @@ class CarbonRouterClient : public CarbonRouterClientBase {
       F&& callback,
       folly::StringPiece ipAddr = folly::StringPiece());
 
+#if FOLLY_HAS_COROUTINES
+  /**
+   * Coroutine version of send(): the returned task sends the request when
+   * it's awaited, and completes with the reply. Same semantics as the
+   * callback passed to send(), except that if the request couldn't be
+   * scheduled at all the reply is mc_res_local_error.
+   *
+   * Note: req must stay alive until the task completes (which is the case
+   *       with `co_await client.co_send(req)`).
+   * Note: for same-thread clients the task must be awaited on the proxy's
+   *       thread, as with send().
+   */
+  template <class Request>
+  folly::coro::Task<ReplyT<Request>> co_send(
+      const Request& req,
+      folly::StringPiece ipAddr = folly::StringPiece());
+#endif
+
   CacheClientCounters getStatCounters() noexcept {
     return stats_.getCounters();
   }
@@ -126,9 +158,24 @@ class CarbonRouterClient : public CarbonRouterClientBase {
  private:
   std::weak_ptr<CarbonRouterInstance<RouterInfo>> router_;
   bool sameThread_{false};
+  // Same thread only: run the proxy's fibers right after handing it requests.
+  bool runInline_{false};
 
   Proxy<RouterInfo>* proxy_{nullptr};
 
+  /**
+   * All proxies, indexed by id, if requests are assigned to proxies by
+   * routing key hash (proxy_key_affinity) or routing prefix (proxy_groups).
+   * Empty otherwise.
+   */
+  std::vector<Proxy<RouterInfo>*> proxies_;
+  // Owned by the router, nullptr if requests are not assigned to proxies by
+  // routing prefix.
+  const ProxyGroups* proxyGroups_{nullptr};
+  bool keyAffinity_{false};
+  // Picks this client's proxy within a group, without proxy_key_affinity.
+  size_t index_{0};
+
   CacheClientStats stats_;
 
   /**
@@ -165,9 +212,31 @@ class CarbonRouterClient : public CarbonRouterClientBase {
   template <class F, class G>
   bool sendMultiImpl(size_t nreqs, F&& makeNextPreq, G&& failRemaining);
 
-  void sendRemoteThread(std::unique_ptr<ProxyRequestContext> req);
+  /**
+   * Sends nreqs requests produced by makeNextPreq to their proxy threads.
+   * All the requests for one proxy cross to it as a single message, and
+   * each proxy gets at most one notification per call.
+   */
+  template <class F>
+  void sendRemoteThread(size_t nreqs, F& makeNextPreq);
+  void sendRemoteThread(
+      Proxy<RouterInfo>& proxy,
+      std::unique_ptr<ProxyRequestBatch> batch);
   void sendSameThread(std::unique_ptr<ProxyRequestContext> req);
 
+  template <class Request>
+  Proxy<RouterInfo>* proxyFor(const Request& req) const {
+    if (proxies_.empty()) {
+      return proxy_;
+    }
+    if (proxyGroups_ == nullptr) {
+      return proxies_[req.key().routingKeyHash() % proxies_.size()];
+    }
+    const auto& group = proxyGroups_->proxiesFor(req.key().routingPrefix());
+    const auto i = keyAffinity_ ? req.key().routingKeyHash() : index_;
+    return proxies_[group[i % group.size()]];
+  }
+
   friend class CarbonRouterInstance<RouterInfo>;
 };
 
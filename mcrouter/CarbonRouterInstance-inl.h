@@ -5,6 +5,9 @@
  *  file in the root directory of this source tree.
  *
  */
+#include <chrono>
+#include <cmath>
+#include <thread>
 #include <vector>
 
 #include <boost/filesystem/operations.hpp>
@@ -12,20 +15,27 @@
 #include <folly/DynamicConverter.h>
 #include <folly/MapUtil.h>
 #include <folly/Singleton.h>
+#include <folly/Try.h>
 #include <folly/fibers/FiberManager.h>
 #include <folly/io/async/EventBase.h>
+#include <folly/synchronization/Baton.h>
 
 #include "mcrouter/AsyncWriter.h"
 #include "mcrouter/CarbonRouterInstanceBase.h"
+#include "mcrouter/ConnectThrottle.h"
 #include "mcrouter/McrouterLogFailure.h"
 #include "mcrouter/McrouterLogger.h"
 #include "mcrouter/Proxy.h"
 #include "mcrouter/ProxyConfig.h"
 #include "mcrouter/ProxyConfigBuilder.h"
+#include "mcrouter/ProxyDestinationMap.h"
 #include "mcrouter/ProxyThread.h"
 #include "mcrouter/RuntimeVarsData.h"
 #include "mcrouter/ServiceInfo.h"
 #include "mcrouter/ThreadUtil.h"
+#include "mcrouter/lib/AuxiliaryCPUThreadPool.h"
+#include "mcrouter/lib/debug/FifoManager.h"
+#include "mcrouter/lib/network/ThreadLocalSSLContextProvider.h"
 #include "mcrouter/stats.h"
 
 namespace facebook {
@@ -224,12 +234,15 @@ CarbonRouterInstance<RouterInfo>::createClient(
 template <class RouterInfo>
 typename CarbonRouterClient<RouterInfo>::Pointer
 CarbonRouterInstance<RouterInfo>::createSameThreadClient(
-    size_t max_outstanding) {
-  return CarbonRouterClient<RouterInfo>::create(
+    size_t max_outstanding,
+    bool runInline) {
+  auto client = CarbonRouterClient<RouterInfo>::create(
       this->shared_from_this(),
       max_outstanding,
       /* maxOutstandingError= */ true,
       /* sameThread= */ true);
+  client->runInline_ = runInline;
+  return client;
 }
 
 template <class RouterInfo>
@@ -243,6 +256,28 @@ CarbonRouterInstance<RouterInfo>::spinUp(
     initCompression(*this);
   }
 
+  // Must be set before any destination establishes an SSL connection.
+  if (opts_.ssl_connection_cache) {
+    setClientSSLSessionCacheCapacity(opts_.ssl_session_cache_size);
+  }
+
+  // Must be set before any debug fifo is created.
+  if (!opts_.debug_fifo_root.empty() && opts_.debug_fifo_shm_ring_size > 0) {
+    if (auto fifoManager = FifoManager::getInstance()) {
+      fifoManager->setShmRingSize(opts_.debug_fifo_shm_ring_size);
+    }
+  }
+
+  // Must be set before any client is created.
+  if (!opts_.proxy_groups.empty()) {
+    try {
+      proxyGroups_ = std::make_unique<const ProxyGroups>(
+          opts_.proxy_groups, opts_.num_proxies, opts_.default_route);
+    } catch (const std::exception& e) {
+      return folly::makeUnexpected(std::string(e.what()));
+    }
+  }
+
   bool configuringFromDisk = false;
   {
     std::lock_guard<std::mutex> lg(configReconfigLock_);
@@ -394,6 +429,9 @@ void CarbonRouterInstance<RouterInfo>::spawnAuxiliaryThreads() {
   startObservingRuntimeVarsFile();
   registerOnUpdateCallbackForRxmits();
   registerForStatsUpdates();
+  registerForLatencyTkoUpdates();
+  registerForTkoSnapshots();
+  registerForDictionaryTraining();
   spawnStatLoggerThread();
 }
 
@@ -422,19 +460,10 @@ void CarbonRouterInstance<RouterInfo>::startObservingRuntimeVarsFile() {
     return;
   }
 
-  if (auto scheduler = functionScheduler()) {
-    runtimeVarsObserverHandle_ = startObservingFile(
-        opts_.runtime_vars_file,
-        scheduler,
-        std::chrono::milliseconds(opts_.file_observer_poll_period_ms),
-        std::chrono::milliseconds(opts_.file_observer_sleep_before_update_ms),
-        std::move(onUpdate));
-  } else {
-    MC_LOG_FAILURE(
-        opts(),
-        failure::Category::kSystemError,
-        "Global function scheduler not available");
-  }
+  runtimeVarsObserverHandle_ = startObservingFile(
+      opts_.runtime_vars_file,
+      std::chrono::milliseconds(opts_.file_observer_sleep_before_update_ms),
+      std::move(onUpdate));
 }
 
 template <class RouterInfo>
@@ -452,6 +481,9 @@ void CarbonRouterInstance<RouterInfo>::joinAuxiliaryThreads() noexcept {
   }
 
   deregisterForStatsUpdates();
+  deregisterForLatencyTkoUpdates();
+  deregisterForTkoSnapshots();
+  deregisterForDictionaryTraining();
 
   if (mcrouterLogger_) {
     mcrouterLogger_->stop();
@@ -480,10 +512,9 @@ folly::Expected<folly::Unit, std::string>
 CarbonRouterInstance<RouterInfo>::configure(const ProxyConfigBuilder& builder) {
   VLOG_IF(0, !opts_.constantly_reload_configs) << "started reconfiguring";
   std::vector<std::shared_ptr<ProxyConfig<RouterInfo>>> newConfigs;
+  const auto buildStartUs = nowUs();
   try {
-    for (size_t i = 0; i < opts_.num_proxies; i++) {
-      newConfigs.push_back(builder.buildConfig<RouterInfo>(*getProxy(i)));
-    }
+    newConfigs = buildConfigs(builder);
   } catch (const std::exception& e) {
     std::string error = folly::sformat("Failed to reconfigure: {}", e.what());
     MC_LOG_FAILURE(opts(), failure::Category::kInvalidConfig, error);
@@ -491,6 +522,17 @@ CarbonRouterInstance<RouterInfo>::configure(const ProxyConfigBuilder& builder) {
     return folly::makeUnexpected(std::move(error));
   }
 
+  if (opts_.warm_start_connect_fraction > 0) {
+    // Before the first config, proxies running on external event bases
+    // (e.g. the standalone server's) aren't looping yet; connect in the
+    // background then.
+    warmUpConnections(newConfigs, startTime_ != 0 || !proxyThreads_.empty());
+  }
+
+  configBuildTimes_.parseUs = builder.parseTimeUs();
+  configBuildTimes_.preprocessUs = builder.preprocessTimeUs();
+  configBuildTimes_.routeBuildUs = nowUs() - buildStartUs;
+
   for (size_t i = 0; i < opts_.num_proxies; i++) {
     proxy_config_swap(getProxy(i), newConfigs[i]);
   }
@@ -498,12 +540,101 @@ CarbonRouterInstance<RouterInfo>::configure(const ProxyConfigBuilder& builder) {
   VLOG_IF(0, !opts_.constantly_reload_configs)
       << "reconfigured " << opts_.num_proxies << " proxies with "
       << newConfigs[0]->getPools().size() << " pools, "
-      << newConfigs[0]->calcNumClients() << " clients "
+      << newConfigs[0]->calcNumClients() << " clients, "
+      << newConfigs[0]->numReusedPoolRoutes() << " reused pool routes "
       << newConfigs[0]->getConfigMd5Digest() << ")";
 
   return folly::Unit();
 }
 
+template <class RouterInfo>
+std::vector<std::shared_ptr<ProxyConfig<RouterInfo>>>
+CarbonRouterInstance<RouterInfo>::buildConfigs(
+    const ProxyConfigBuilder& builder) {
+  const size_t numProxies = opts_.num_proxies;
+  std::vector<folly::Try<std::shared_ptr<ProxyConfig<RouterInfo>>>> results(
+      numProxies);
+  std::atomic<size_t> next{0};
+  auto buildRemaining = [&]() {
+    for (size_t i = next++; i < numProxies; i = next++) {
+      results[i] = folly::makeTryWith(
+          [&]() { return builder.buildConfig<RouterInfo>(*getProxy(i)); });
+    }
+  };
+
+  auto auxPool = AuxiliaryCPUThreadPoolSingleton::try_get();
+  if (opts_.parallel_config_build && numProxies > 1 && auxPool) {
+    // Helpers pick proxies from the same counter as this thread, so those
+    // that start late (pool busy) just find nothing left to do.
+    const size_t numHelpers = numProxies - 1;
+    std::atomic<size_t> helpersLeft{numHelpers};
+    folly::Baton<> helpersDone;
+    for (size_t i = 0; i < numHelpers; i++) {
+      auxPool->getThreadPool().add([&]() {
+        buildRemaining();
+        if (--helpersLeft == 0) {
+          helpersDone.post();
+        }
+      });
+    }
+    buildRemaining();
+    helpersDone.wait();
+  } else {
+    buildRemaining();
+  }
+
+  std::vector<std::shared_ptr<ProxyConfig<RouterInfo>>> configs;
+  configs.reserve(numProxies);
+  for (auto& result : results) {
+    // Rethrows the build error, if any.
+    configs.push_back(std::move(result.value()));
+  }
+  return configs;
+}
+
+template <class RouterInfo>
+void CarbonRouterInstance<RouterInfo>::warmUpConnections(
+    const std::vector<std::shared_ptr<ProxyConfig<RouterInfo>>>& configs,
+    bool wait) {
+  auto warmUp = std::make_shared<ConnectionWarmUp>();
+  for (size_t i = 0; i < configs.size(); i++) {
+    auto* proxy = getProxy(i);
+    auto destinations = configs[i]->getDestinations();
+    warmUp->add(destinations.size());
+    proxy->eventBase().runInEventBaseThread(
+        [proxy, destinations = std::move(destinations), warmUp]() {
+          auto* destinationMap = proxy->destinationMap();
+          if (destinationMap == nullptr) {
+            // Proxy is shutting down.
+            for (size_t j = 0; j < destinations.size(); ++j) {
+              warmUp->settle(false);
+            }
+            return;
+          }
+          for (const auto& pdstn : destinations) {
+            destinationMap->connectThrottle().prewarm(pdstn, warmUp);
+          }
+        });
+  }
+  if (!wait) {
+    return;
+  }
+
+  const size_t total = warmUp->total();
+  const size_t needed = std::min<size_t>(
+      total, std::ceil(opts_.warm_start_connect_fraction * total));
+  const size_t up = warmUp->wait(
+      needed,
+      std::chrono::steady_clock::now() +
+          std::chrono::milliseconds(opts_.warm_start_timeout_ms));
+  if (up < needed) {
+    LOG(WARNING) << "Swapping config in with " << up << " of " << total
+                 << " connections up, wanted " << needed;
+  } else {
+    VLOG(1) << up << " of " << total << " connections up for the new config";
+  }
+}
+
 template <class RouterInfo>
 folly::Expected<ProxyConfigBuilder, std::string>
 CarbonRouterInstance<RouterInfo>::createConfigBuilder() {
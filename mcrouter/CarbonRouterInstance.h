@@ -108,9 +108,16 @@ class CarbonRouterInstance
    * Same as createClient(), but you must use it from the same thread that's
    * running the assigned proxy's event base.  The sends call into proxy
    * callbacks directly, bypassing the queue.
+   *
+   * @param runInline  If true, send() also starts routing the request right
+   *   away (unless called from a fiber or a fiber manager callback) instead
+   *   of at the next event loop iteration, so that requests that don't
+   *   block (e.g. served from a local cache) are replied to before send()
+   *   returns.
    */
   typename CarbonRouterClient<RouterInfo>::Pointer createSameThreadClient(
-      size_t maximum_outstanding_requests);
+      size_t maximum_outstanding_requests,
+      bool runInline = false);
 
   /**
    * Shutdown all threads started by this instance. It's a blocking call and
@@ -196,6 +203,22 @@ class CarbonRouterInstance
       NB file-based configuration is synchronous
       but server-based configuration is asynchronous */
   bool reconfigure(const ProxyConfigBuilder& builder);
+  /**
+   * Builds the config of every proxy, concurrently on the auxiliary CPU
+   * thread pool if parallel_config_build is enabled.
+   *
+   * @throw std::exception  the error of the first proxy that failed.
+   */
+  std::vector<std::shared_ptr<ProxyConfig<RouterInfo>>> buildConfigs(
+      const ProxyConfigBuilder& builder);
+  /**
+   * Connects to the destinations of `configs` in the background (see
+   * warm_start_connect_fraction). If `wait` is true, blocks until enough of
+   * them are up, or until warm_start_timeout_ms.
+   */
+  void warmUpConnections(
+      const std::vector<std::shared_ptr<ProxyConfig<RouterInfo>>>& configs,
+      bool wait);
   /** Create the ProxyConfigBuilder used to reconfigure.
   Returns error reason if constructor fails. **/
   folly::Expected<ProxyConfigBuilder, std::string> createConfigBuilder();
@@ -7,16 +7,23 @@
  */
 #include "CarbonRouterInstanceBase.h"
 
+#include <algorithm>
+#include <ctime>
 #include <memory>
+#include <vector>
 
 #include <boost/filesystem/operations.hpp>
 
+#include <folly/FileUtil.h>
 #include <folly/Singleton.h>
+#include <folly/json.h>
 #include <folly/system/ThreadName.h>
 
 #include "mcrouter/AsyncWriter.h"
+#include "mcrouter/OptionsUtil.h"
 #include "mcrouter/ProxyBase.h"
 #include "mcrouter/lib/CompressionCodecManager.h"
+#include "mcrouter/lib/CompressionOffload.h"
 #include "mcrouter/lib/fbi/cpp/util.h"
 #include "mcrouter/stats.h"
 
@@ -63,6 +70,30 @@ std::string statsUpdateFunctionName(folly::StringPiece routerName) {
       "carbon-stats-update-fn-", routerName, "-", uniqueId.fetch_add(1));
 }
 
+std::string latencyTkoFunctionName(folly::StringPiece routerName) {
+  static std::atomic<uint64_t> uniqueId(0);
+  return folly::to<std::string>(
+      "carbon-latency-tko-fn-", routerName, "-", uniqueId.fetch_add(1));
+}
+
+std::string tkoSnapshotFunctionName(folly::StringPiece routerName) {
+  static std::atomic<uint64_t> uniqueId(0);
+  return folly::to<std::string>(
+      "carbon-tko-snapshot-fn-", routerName, "-", uniqueId.fetch_add(1));
+}
+
+std::string dictionaryTrainingFunctionName(folly::StringPiece routerName) {
+  static std::atomic<uint64_t> uniqueId(0);
+  return folly::to<std::string>(
+      "carbon-dictionary-training-fn-", routerName, "-", uniqueId.fetch_add(1));
+}
+
+const char* kTkoSnapshotSfx = "tko_state";
+const char* kDictionarySfx = ".zdict";
+// zstd recommends ~100 times more samples than the dictionary size.
+constexpr size_t kDictionarySize = 110 * 1024;
+constexpr size_t kMaxDictionarySampleBytes = 100 * kDictionarySize;
+
 } // anonymous namespace
 
 CarbonRouterInstanceBase::CarbonRouterInstanceBase(McrouterOptions inputOptions)
@@ -71,7 +102,34 @@ CarbonRouterInstanceBase::CarbonRouterInstanceBase(McrouterOptions inputOptions)
       configApi_(createConfigApi(opts_)),
       rtVarsData_(std::make_shared<ObservableRuntimeVars>()),
       leaseTokenMap_(globalFunctionScheduler.try_get()),
-      statsUpdateFunctionHandle_(statsUpdateFunctionName(opts_.router_name)) {
+      statsUpdateFunctionHandle_(statsUpdateFunctionName(opts_.router_name)),
+      latencyTkoFunctionHandle_(latencyTkoFunctionName(opts_.router_name)),
+      tkoSnapshotFunctionHandle_(tkoSnapshotFunctionName(opts_.router_name)),
+      dictionaryTrainingFunctionHandle_(
+          dictionaryTrainingFunctionName(opts_.router_name)) {
+  setNumActiveProxies(
+      opts_.num_active_proxies != 0 ? opts_.num_active_proxies
+                                    : opts_.num_proxies);
+  if (opts_.max_probes_per_second > 0) {
+    probeTokenBucket_ = std::make_unique<SharedTokenBucket>(
+        opts_.max_probes_per_second,
+        opts_.max_probes_per_second,
+        folly::TokenBucket::defaultClockNow());
+  }
+  if (opts_.max_new_connections_per_second > 0) {
+    connectTokenBucket_ = std::make_unique<SharedTokenBucket>(
+        opts_.max_new_connections_per_second,
+        opts_.max_new_connections_per_second,
+        folly::TokenBucket::defaultClockNow());
+  }
+  if (opts_.compression_dictionary_training_interval_s > 0 &&
+      !opts_.compression_dictionary_dir.empty()) {
+    dictionaryTrainer_ = std::make_unique<CompressionDictionaryTrainer>(
+        opts_.compression_dictionary_sample_rate,
+        kMaxDictionarySampleBytes,
+        kDictionarySize);
+  }
+
   if (auto statsLogger = statsLogWriter()) {
     if (opts_.stats_async_queue_length) {
       statsLogger->increaseMaxQueueSize(opts_.stats_async_queue_length);
@@ -100,15 +158,66 @@ CarbonRouterInstanceBase::CarbonRouterInstanceBase(McrouterOptions inputOptions)
       LOG(ERROR) << "Invalid pool-stats-config-file : " << e.what();
     }
   }
+
+  loadTkoSnapshot();
 }
 
 void CarbonRouterInstanceBase::setUpCompressionDictionaries(
     std::unordered_map<uint32_t, CodecConfigPtr>&& codecConfigs) noexcept {
-  if (codecConfigs.empty() || compressionCodecManager_ != nullptr) {
+  if (compressionCodecManager_ != nullptr) {
+    return;
+  }
+  addTrainedDictionaries(codecConfigs);
+  if (codecConfigs.empty()) {
     return;
   }
   compressionCodecManager_ = std::make_unique<const CompressionCodecManager>(
       std::move(codecConfigs));
+  if (opts_.compression_offload_threshold > 0) {
+    compressionOffload_ = std::make_unique<CompressionOffload>(
+        *compressionCodecManager_, opts_.compression_offload_threshold);
+  }
+}
+
+void CarbonRouterInstanceBase::addTrainedDictionaries(
+    std::unordered_map<uint32_t, CodecConfigPtr>& codecConfigs) const {
+  if (opts_.compression_dictionary_dir.empty()) {
+    return;
+  }
+  std::vector<std::string> files;
+  try {
+    boost::filesystem::directory_iterator it(opts_.compression_dictionary_dir);
+    for (; it != boost::filesystem::directory_iterator(); ++it) {
+      if (it->path().extension() == kDictionarySfx) {
+        files.push_back(it->path().string());
+      }
+    }
+  } catch (const std::exception& e) {
+    LOG(ERROR) << "Failed to list compression dictionaries in "
+               << opts_.compression_dictionary_dir << ": " << e.what();
+    return;
+  }
+  // Peers loading the same directory must end up with the same ids.
+  std::sort(files.begin(), files.end());
+  uint32_t nextId = 1;
+  for (const auto& it : codecConfigs) {
+    nextId = std::max(nextId, it.first + 1);
+  }
+  for (const auto& file : files) {
+    std::string dictionary;
+    if (!folly::readFile(file.c_str(), dictionary) || dictionary.empty()) {
+      // Skipping it would shift the ids of the following ones.
+      LOG(ERROR) << "Failed to read compression dictionary " << file;
+      return;
+    }
+    codecConfigs.emplace(
+        nextId,
+        std::make_unique<CodecConfig>(
+            nextId, CompressionCodecType::ZSTD, std::move(dictionary)));
+    LOG(INFO) << "Using compression dictionary " << file << " as codec "
+              << nextId;
+    ++nextId;
+  }
 }
 
 void CarbonRouterInstanceBase::addStartupOpts(
@@ -131,12 +240,21 @@ CarbonRouterInstanceBase::getStartupOpts() const {
 
 size_t CarbonRouterInstanceBase::nextProxyIndex() {
   std::lock_guard<std::mutex> guard(nextProxyMutex_);
-  assert(nextProxy_ < opts().num_proxies);
+  assert(nextProxy_ < numActiveProxies_);
   size_t res = nextProxy_;
-  nextProxy_ = (nextProxy_ + 1) % opts().num_proxies;
+  nextProxy_ = (nextProxy_ + 1) % numActiveProxies_;
   return res;
 }
 
+void CarbonRouterInstanceBase::setNumActiveProxies(size_t n) {
+  n = std::max<size_t>(1, std::min<size_t>(n, opts_.num_proxies));
+  std::lock_guard<std::mutex> guard(nextProxyMutex_);
+  numActiveProxies_ = n;
+  if (nextProxy_ >= n) {
+    nextProxy_ = 0;
+  }
+}
+
 void CarbonRouterInstanceBase::registerForStatsUpdates() {
   if (!opts_.num_proxies) {
     return;
@@ -156,6 +274,138 @@ void CarbonRouterInstanceBase::deregisterForStatsUpdates() {
   }
 }
 
+void CarbonRouterInstanceBase::registerForLatencyTkoUpdates() {
+  if (opts_.disable_tko_tracking || opts_.latency_tko_interval_ms == 0) {
+    return;
+  }
+  if (auto scheduler = functionScheduler()) {
+    const std::chrono::milliseconds interval(opts_.latency_tko_interval_ms);
+    scheduler->addFunction(
+        [this]() { tkoTrackerMap_.updateLatencyOutliers(opts_); },
+        interval,
+        latencyTkoFunctionHandle_,
+        /*startDelay=*/interval);
+  }
+}
+
+void CarbonRouterInstanceBase::deregisterForLatencyTkoUpdates() {
+  if (opts_.disable_tko_tracking || opts_.latency_tko_interval_ms == 0) {
+    return;
+  }
+  if (auto scheduler = functionScheduler()) {
+    scheduler->cancelFunctionAndWait(latencyTkoFunctionHandle_);
+  }
+}
+
+void CarbonRouterInstanceBase::registerForTkoSnapshots() {
+  if (opts_.disable_tko_tracking || opts_.tko_snapshot_interval_ms == 0) {
+    return;
+  }
+  if (auto scheduler = functionScheduler()) {
+    const std::chrono::milliseconds interval(opts_.tko_snapshot_interval_ms);
+    scheduler->addFunction(
+        [this]() { writeTkoSnapshot(); },
+        interval,
+        tkoSnapshotFunctionHandle_,
+        /*startDelay=*/interval);
+  }
+}
+
+void CarbonRouterInstanceBase::deregisterForTkoSnapshots() {
+  if (opts_.disable_tko_tracking || opts_.tko_snapshot_interval_ms == 0) {
+    return;
+  }
+  if (auto scheduler = functionScheduler()) {
+    scheduler->cancelFunctionAndWait(tkoSnapshotFunctionHandle_);
+  }
+  writeTkoSnapshot();
+}
+
+std::string CarbonRouterInstanceBase::tkoSnapshotPath() const {
+  boost::filesystem::path path(opts_.stats_root);
+  path /= getStatPrefix(opts_) + "." + kTkoSnapshotSfx;
+  return path.string();
+}
+
+void CarbonRouterInstanceBase::writeTkoSnapshot() {
+  if (opts_.stats_root.empty() ||
+      !ensureDirExistsAndWritable(opts_.stats_root)) {
+    return;
+  }
+  folly::dynamic snapshot = folly::dynamic::object("time", time(nullptr))(
+      "tkos", tkoTrackerMap_.getTkoState());
+  if (!atomicallyWriteFileToDisk(folly::toJson(snapshot), tkoSnapshotPath())) {
+    VLOG(1) << "Failed to write TKO snapshot to " << tkoSnapshotPath();
+  }
+}
+
+void CarbonRouterInstanceBase::registerForDictionaryTraining() {
+  if (!dictionaryTrainer_) {
+    return;
+  }
+  if (auto scheduler = functionScheduler()) {
+    const std::chrono::seconds interval(
+        opts_.compression_dictionary_training_interval_s);
+    scheduler->addFunction(
+        [this]() { trainCompressionDictionaries(); },
+        interval,
+        dictionaryTrainingFunctionHandle_,
+        /*startDelay=*/interval);
+  }
+}
+
+void CarbonRouterInstanceBase::deregisterForDictionaryTraining() {
+  if (!dictionaryTrainer_) {
+    return;
+  }
+  if (auto scheduler = functionScheduler()) {
+    scheduler->cancelFunctionAndWait(dictionaryTrainingFunctionHandle_);
+  }
+}
+
+void CarbonRouterInstanceBase::trainCompressionDictionaries() {
+  const auto dictionaries = dictionaryTrainer_->train();
+  if (dictionaries.empty() ||
+      !ensureDirExistsAndWritable(opts_.compression_dictionary_dir)) {
+    return;
+  }
+  for (const auto& it : dictionaries) {
+    boost::filesystem::path path(opts_.compression_dictionary_dir);
+    path /= it.first + kDictionarySfx;
+    if (!atomicallyWriteFileToDisk(it.second, path.string())) {
+      LOG(ERROR) << "Failed to write compression dictionary " << path.string();
+      continue;
+    }
+    LOG(INFO) << "Trained a " << it.second.size()
+              << " bytes compression dictionary for " << it.first;
+  }
+}
+
+void CarbonRouterInstanceBase::loadTkoSnapshot() {
+  if (opts_.disable_tko_tracking || opts_.tko_snapshot_interval_ms == 0 ||
+      opts_.stats_root.empty()) {
+    return;
+  }
+  std::string contents;
+  if (!folly::readFile(tkoSnapshotPath().c_str(), contents)) {
+    return;
+  }
+  try {
+    auto snapshot = folly::parseJson(contents);
+    const auto age = time(nullptr) - snapshot["time"].asInt();
+    if (age < 0 || age > opts_.tko_snapshot_max_age_s) {
+      VLOG(1) << "Ignoring TKO snapshot " << age << "s old";
+      return;
+    }
+    tkoTrackerMap_.setRestoredTkoState(snapshot["tkos"]);
+    LOG(INFO) << "Restored " << snapshot["tkos"].size()
+              << " TKO hosts from a snapshot " << age << "s old";
+  } catch (const std::exception& e) {
+    LOG(ERROR) << "Invalid TKO snapshot " << tkoSnapshotPath() << ": "
+               << e.what();
+  }
+}
+
 void CarbonRouterInstanceBase::updateStats() {
   const int BIN_NUM =
       (MOVING_AVERAGE_WINDOW_SIZE_IN_SECOND /
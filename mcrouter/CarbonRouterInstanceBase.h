@@ -23,8 +23,11 @@
 #include "mcrouter/LeaseTokenMap.h"
 #include "mcrouter/Observable.h"
 #include "mcrouter/PoolStats.h"
+#include "mcrouter/ProxyGroups.h"
 #include "mcrouter/TkoTracker.h"
+#include "mcrouter/lib/CompressionDictionaryTrainer.h"
 #include "mcrouter/options.h"
+#include "mcrouter/routes/RateLimiter.h"
 
 namespace facebook {
 namespace memcache {
@@ -33,6 +36,7 @@ namespace memcache {
 struct CodecConfig;
 using CodecConfigPtr = std::unique_ptr<CodecConfig>;
 class CompressionCodecManager;
+class CompressionOffload;
 
 namespace mcrouter {
 
@@ -69,9 +73,30 @@ class CarbonRouterInstanceBase {
     return compressionCodecManager_.get();
   }
 
+  /**
+   * Returns the offload of big compressions to the CPU thread pool
+   * (compression_offload_threshold). Null if compression or offloading
+   * is disabled.
+   */
+  const CompressionOffload* compressionOffload() const {
+    return compressionOffload_.get();
+  }
+
+  /**
+   * Creates the compression codec manager with `codecConfigs`, followed by
+   * the dictionaries in compression_dictionary_dir. No-op if already done.
+   */
   void setUpCompressionDictionaries(
       std::unordered_map<uint32_t, CodecConfigPtr>&& codecConfigs) noexcept;
 
+  /**
+   * Samples values for dictionary training. Null if training is disabled
+   * (compression_dictionary_training_interval_s).
+   */
+  CompressionDictionaryTrainer* dictionaryTrainer() {
+    return dictionaryTrainer_.get();
+  }
+
   TkoTrackerMap& tkoTrackerMap() {
     return tkoTrackerMap_;
   }
@@ -81,6 +106,10 @@ class CarbonRouterInstanceBase {
     return *configApi_;
   }
 
+  /**
+   * Runtime variables. Per-request readers should use
+   * rtVarsData().snapshot(), which is lock-free.
+   */
   ObservableRuntimeVars& rtVarsData() {
     return *rtVarsData_;
   }
@@ -108,6 +137,30 @@ class CarbonRouterInstanceBase {
     return *shadowLeaseTokenMap_;
   }
 
+  /**
+   * Token buckets of the RateLimiters with "shared_name", shared by all
+   * proxies of this router.
+   */
+  SharedTokenBucketMap& sharedTokenBuckets() {
+    return sharedTokenBuckets_;
+  }
+
+  /**
+   * Router-wide budget of TKO probes (max_probes_per_second), shared by the
+   * ProbeSchedulers of all proxies. Null if probes are not rate limited.
+   */
+  SharedTokenBucket* probeTokenBucket() {
+    return probeTokenBucket_.get();
+  }
+
+  /**
+   * Router-wide budget of new connections (max_new_connections_per_second),
+   * shared by the ConnectThrottles of all proxies. Null if not rate limited.
+   */
+  SharedTokenBucket* connectTokenBucket() {
+    return connectTokenBucket_.get();
+  }
+
   const LogPostprocessCallbackFunc& postprocessCallback() const {
     return postprocessCallback_;
   }
@@ -142,6 +195,20 @@ class CarbonRouterInstanceBase {
     return configuredFromDisk_;
   }
 
+  struct ConfigBuildTimes {
+    uint64_t parseUs{0};
+    uint64_t preprocessUs{0};
+    // Wall time to build the route trees of all proxies.
+    uint64_t routeBuildUs{0};
+  };
+
+  /**
+   * Duration of the phases of the last successful (re)configuration.
+   */
+  const ConfigBuildTimes& configBuildTimes() const {
+    return configBuildTimes_;
+  }
+
   bool isRxmitReconnectionDisabled() const {
     return disableRxmitReconnection_;
   }
@@ -171,9 +238,31 @@ class CarbonRouterInstanceBase {
 
   /**
    * Bump and return the index of the next proxy to be used by clients.
+   * Only active proxies are used, see setNumActiveProxies().
    */
   size_t nextProxyIndex();
 
+  /**
+   * Changes how many proxies new clients are assigned to (the first n ones).
+   * Proxies that are no longer active keep serving the clients they have,
+   * so they drain as those clients go away. Thread-safe.
+   *
+   * @param n  clamped to [1, opts.num_proxies].
+   */
+  void setNumActiveProxies(size_t n);
+
+  size_t numActiveProxies() const {
+    return numActiveProxies_;
+  }
+
+  /**
+   * @return  proxies dedicated to routing prefixes (proxy_groups option),
+   *          nullptr if there are none.
+   */
+  const ProxyGroups* proxyGroups() const {
+    return proxyGroups_.get();
+  }
+
   /**
    * Returns a FunctionScheduler suitable for running periodic background tasks
    * on. Null may be returned if the global instance has been destroyed.
@@ -191,23 +280,61 @@ class CarbonRouterInstanceBase {
    */
   void deregisterForStatsUpdates();
 
+  /**
+   * Register this instance for periodic latency outlier detection, see
+   * TkoTrackerMap::updateLatencyOutliers(). No-op if latency TKO is off.
+   */
+  void registerForLatencyTkoUpdates();
+
+  /**
+   * Deregister this instance for periodic latency outlier detection.
+   */
+  void deregisterForLatencyTkoUpdates();
+
+  /**
+   * Register this instance for periodic TKO snapshots to disk
+   * (tko_snapshot_interval_ms). No-op if snapshots are off.
+   */
+  void registerForTkoSnapshots();
+
+  /**
+   * Deregister this instance for periodic TKO snapshots, and writes a last
+   * one.
+   */
+  void deregisterForTkoSnapshots();
+
+  /**
+   * Register this instance for periodic compression dictionary training.
+   * No-op if training is off.
+   */
+  void registerForDictionaryTraining();
+
+  /**
+   * Deregister this instance for periodic compression dictionary training.
+   */
+  void deregisterForDictionaryTraining();
+
   const McrouterOptions opts_;
   const pid_t pid_;
   const std::unique_ptr<ConfigApi> configApi_;
 
   LogPostprocessCallbackFunc postprocessCallback_;
 
-  // These next four fields are used for stats
+  // These next five fields are used for stats
   uint64_t startTime_{0};
   time_t lastConfigAttempt_{0};
   size_t configFailures_{0};
   bool configuredFromDisk_{false};
+  ConfigBuildTimes configBuildTimes_;
 
   // Stores whether we should reconnect after hitting rxmit threshold
   std::atomic<bool> disableRxmitReconnection_{false};
 
   folly::Optional<folly::observer::Observer<std::string>> rtVarsDataObserver_;
 
+  // Set on spin up, if proxy_groups is not empty.
+  std::unique_ptr<const ProxyGroups> proxyGroups_;
+
  private:
   size_t statsIndex() const {
     return statsIndex_;
@@ -219,6 +346,8 @@ class CarbonRouterInstanceBase {
 
   TkoTrackerMap tkoTrackerMap_;
   std::unique_ptr<const CompressionCodecManager> compressionCodecManager_;
+  std::unique_ptr<CompressionOffload> compressionOffload_;
+  std::unique_ptr<CompressionDictionaryTrainer> dictionaryTrainer_;
 
   // Stores data for runtime variables.
   const std::shared_ptr<ObservableRuntimeVars> rtVarsData_;
@@ -231,10 +360,16 @@ class CarbonRouterInstanceBase {
   std::unique_ptr<ShadowLeaseTokenMap> shadowLeaseTokenMap_;
   folly::once_flag shadowLeaseTokenMapInitFlag_;
 
+  SharedTokenBucketMap sharedTokenBuckets_;
+  std::unique_ptr<SharedTokenBucket> probeTokenBucket_;
+  std::unique_ptr<SharedTokenBucket> connectTokenBucket_;
+
   std::unordered_map<std::string, std::string> additionalStartupOpts_;
 
   std::mutex nextProxyMutex_;
   size_t nextProxy_{0};
+  // Modified under nextProxyMutex_.
+  std::atomic<size_t> numActiveProxies_{0};
 
   // Current stats index. Only accessed / updated  by stats background thread.
   size_t statsIndex_{0};
@@ -242,8 +377,30 @@ class CarbonRouterInstanceBase {
   // Name of the stats update function registered with the function scheduler.
   const std::string statsUpdateFunctionHandle_;
 
+  // Name of the latency TKO function registered with the function scheduler.
+  const std::string latencyTkoFunctionHandle_;
+
+  // Name of the TKO snapshot function registered with the function scheduler.
+  const std::string tkoSnapshotFunctionHandle_;
+
+  // Name of the dictionary training function registered with the function
+  // scheduler.
+  const std::string dictionaryTrainingFunctionHandle_;
+
   std::vector<std::string> statsEnabledPools_;
 
+  // Writes the TKO state to tkoSnapshotPath(), and reads it back on startup.
+  void writeTkoSnapshot();
+  void loadTkoSnapshot();
+  std::string tkoSnapshotPath() const;
+
+  // Trains dictionaries on the sampled values and writes them to
+  // compression_dictionary_dir.
+  void trainCompressionDictionaries();
+  // Adds the dictionaries from compression_dictionary_dir to codecConfigs.
+  void addTrainedDictionaries(
+      std::unordered_map<uint32_t, CodecConfigPtr>& codecConfigs) const;
+
   // Aggregates stats for all associated proxies. Should be called periodically.
   void updateStats();
 };
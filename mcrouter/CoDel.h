@@ -0,0 +1,88 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+#include "mcrouter/ProxyRequestPriority.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * CoDel (controlled delay) management of a request queue: tells which
+ * requests leaving the queue should be rejected instead of processed.
+ *
+ * The queue is overloaded if every request that left it during the last
+ * interval waited (its sojourn time) longer than the target: unlike a short
+ * burst, such a standing queue doesn't drain by itself. While overloaded,
+ * async requests that waited longer than the target are rejected, and
+ * critical ones once they waited twice as long, so that queueing delay stays
+ * bounded instead of every request ending up slow.
+ *
+ * Not thread-safe, meant to be owned by a single proxy thread.
+ */
+class CoDel {
+ public:
+  CoDel(int64_t targetUs, int64_t intervalUs)
+      : targetUs_(targetUs), intervalUs_(intervalUs) {}
+
+  /**
+   * Records a request of the given priority leaving the queue at `nowUs`,
+   * after waiting in it for `sojournUs`.
+   *
+   * @return true if the request should be rejected.
+   */
+  bool shouldShed(
+      ProxyRequestPriority priority,
+      int64_t sojournUs,
+      int64_t nowUs) {
+    const auto elapsedUs = nowUs - intervalStartUs_;
+    if (elapsedUs >= intervalUs_) {
+      // A whole interval without requests leaving means the queue was
+      // empty.
+      overloaded_ = elapsedUs < 2 * intervalUs_ &&
+          minSojournUs_ != kNoSojourn && minSojournUs_ > targetUs_;
+      minSojournUs_ = kNoSojourn;
+      intervalStartUs_ = nowUs;
+    }
+    minSojournUs_ = std::min(minSojournUs_, sojournUs);
+
+    if (!overloaded_) {
+      return false;
+    }
+    return priority == ProxyRequestPriority::kCritical
+        ? sojournUs > 2 * targetUs_
+        : sojournUs > targetUs_;
+  }
+
+  /**
+   * @return true if the last interval found the queue overloaded.
+   */
+  bool overloaded() const {
+    return overloaded_;
+  }
+
+ private:
+  static constexpr int64_t kNoSojourn = std::numeric_limits<int64_t>::max();
+
+  const int64_t targetUs_;
+  const int64_t intervalUs_;
+
+  bool overloaded_{false};
+  // Shortest sojourn time within the current interval.
+  int64_t minSojournUs_{kNoSojourn};
+  int64_t intervalStartUs_{0};
+};
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
@@ -512,6 +512,13 @@ void ConfigApi::enableReadingFromBackupFiles() {
   LOG(WARNING) << "Enabling read config from backup files.";
 }
 
+std::string ConfigApi::getConfigDumpDirectory() const {
+  if (!dumpConfigToDisk_) {
+    return "";
+  }
+  return getBackupConfigDirectory(opts_).string();
+}
+
 bool ConfigApi::shouldReadFromBackupFiles() const {
   return readFromBackupFiles_;
 }
@@ -116,6 +116,12 @@ class ConfigApi : public ConfigApiIf {
    */
   void enableReadingFromBackupFiles();
 
+  /**
+   * @return directory where config sources are backed up, or empty string
+   *         if dumping configs to disk is disabled.
+   */
+  std::string getConfigDumpDirectory() const;
+
  protected:
   const McrouterOptions& opts_;
   CallbackPool<> callbacks_;
@@ -0,0 +1,148 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include "ConfigSnapshot.h"
+
+#include <boost/filesystem.hpp>
+
+#include <folly/Conv.h>
+#include <folly/Format.h>
+#include <folly/json.h>
+#include <folly/system/MemoryMapping.h>
+
+#include "mcrouter/ConfigApi.h"
+#include "mcrouter/config.h"
+#include "mcrouter/lib/fbi/cpp/util.h"
+#include "mcrouter/options.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+namespace {
+
+const char* const kSnapshotFileName = "config-snapshot";
+const char* const kSnapshotMagic = "mcrouter-config-snapshot";
+
+std::string getSnapshotPath(
+    const McrouterOptions& opts,
+    const ConfigApi& configApi) {
+  if (!opts.config_snapshot) {
+    return "";
+  }
+  auto directory = configApi.getConfigDumpDirectory();
+  if (directory.empty()) {
+    return "";
+  }
+  return (boost::filesystem::path(directory) / kSnapshotFileName).string();
+}
+
+std::string getHeader(folly::StringPiece sourceHash) {
+  return folly::sformat(
+      "{} {} {}\n", kSnapshotMagic, ConfigSnapshot::kVersion, sourceHash);
+}
+
+} // anonymous namespace
+
+constexpr int ConfigSnapshot::kVersion;
+
+ConfigSnapshot::RecordingImportResolver::RecordingImportResolver(
+    ConfigApi& configApi)
+    : McImportResolver(configApi) {}
+
+std::string ConfigSnapshot::RecordingImportResolver::import(
+    folly::StringPiece path) {
+  auto contents = McImportResolver::import(path);
+  imports[path.str()] = Md5Hash(contents);
+  return contents;
+}
+
+ConfigSnapshot::ConfigSnapshot(
+    const McrouterOptions& opts,
+    ConfigApi& configApi,
+    folly::StringPiece jsonC,
+    const folly::StringKeyedUnorderedMap<folly::dynamic>& globalParams)
+    : configApi_(configApi),
+      importResolver_(configApi),
+      path_(getSnapshotPath(opts, configApi)) {
+  if (path_.empty()) {
+    return;
+  }
+  auto params = folly::dynamic::object();
+  for (const auto& it : globalParams) {
+    params.insert(it.first, it.second);
+  }
+  folly::json::serialization_opts serializationOpts;
+  serializationOpts.sort_keys = true;
+  // The preprocessor may behave differently in another mcrouter version.
+  sourceHash_ = Md5Hash(folly::to<std::string>(
+      MCROUTER_PACKAGE_STRING,
+      '\n',
+      folly::json::serialize(params, serializationOpts),
+      '\n',
+      jsonC));
+}
+
+folly::Optional<folly::dynamic> ConfigSnapshot::load() {
+  if (path_.empty() || !boost::filesystem::exists(path_)) {
+    return folly::none;
+  }
+  try {
+    folly::MemoryMapping mapping(path_.c_str());
+    auto data = mapping.range();
+    folly::StringPiece contents(
+        reinterpret_cast<const char*>(data.begin()), data.size());
+
+    auto header = getHeader(sourceHash_);
+    if (!contents.startsWith(header)) {
+      VLOG(1) << "Config snapshot " << path_ << " is out of date.";
+      return folly::none;
+    }
+    contents.advance(header.size());
+    auto snapshot = parseJsonString(contents);
+
+    // Imported files might have changed even if the config did not. Reading
+    // them through ConfigApi also makes sure they're observed for updates.
+    for (const auto& it : snapshot["imports"].items()) {
+      auto path = it.first.asString();
+      std::string importContents;
+      if (!configApi_.get(ConfigType::ConfigImport, path, importContents) ||
+          Md5Hash(importContents) != it.second.getString()) {
+        VLOG(1) << "Config snapshot " << path_ << " is out of date: "
+                << path << " changed.";
+        return folly::none;
+      }
+    }
+    LOG(INFO) << "Loaded preprocessed config from snapshot " << path_;
+    return std::move(snapshot["config"]);
+  } catch (const std::exception& e) {
+    LOG(WARNING) << "Failed to load config snapshot " << path_ << ": "
+                 << e.what();
+  }
+  return folly::none;
+}
+
+void ConfigSnapshot::save(const folly::dynamic& config) {
+  if (path_.empty()) {
+    return;
+  }
+  auto imports = folly::dynamic::object();
+  for (const auto& it : importResolver_.imports) {
+    imports.insert(it.first, it.second);
+  }
+  auto contents = getHeader(sourceHash_);
+  contents.append(folly::toJson(
+      folly::dynamic::object("imports", std::move(imports))("config", config)));
+  if (atomicallyWriteFileToDisk(contents, path_)) {
+    ensureHasPermission(path_, 0666);
+  } else {
+    LOG(WARNING) << "Failed to write config snapshot " << path_;
+  }
+}
+}
+}
+} // facebook::memcache::mcrouter
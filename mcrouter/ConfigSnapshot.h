@@ -0,0 +1,87 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <string>
+#include <unordered_map>
+
+#include <folly/Optional.h>
+#include <folly/Range.h>
+#include <folly/dynamic.h>
+#include <folly/experimental/StringKeyedUnorderedMap.h>
+
+#include "mcrouter/routes/McImportResolver.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+class ConfigApi;
+struct McrouterOptions;
+
+/**
+ * Fully preprocessed config saved next to the config backups in
+ * config_dump_root.
+ *
+ * Expanding macros and imports of a big config takes seconds. When neither
+ * the config, nor the global params, nor any of the files it imported have
+ * changed since the snapshot was written, the snapshot is loaded instead.
+ */
+class ConfigSnapshot {
+ public:
+  /**
+   * Bumped whenever the snapshot file format changes.
+   */
+  static constexpr int kVersion = 1;
+
+  ConfigSnapshot(
+      const McrouterOptions& opts,
+      ConfigApi& configApi,
+      folly::StringPiece jsonC,
+      const folly::StringKeyedUnorderedMap<folly::dynamic>& globalParams);
+
+  /**
+   * @return preprocessed config, or none if snapshots are disabled or there
+   *         is no up to date snapshot.
+   */
+  folly::Optional<folly::dynamic> load();
+
+  /**
+   * Imports files for the ConfigPreprocessor, remembering their hashes
+   * so that save() can record them.
+   */
+  ImportResolverIf& importResolver() {
+    return importResolver_;
+  }
+
+  /**
+   * Writes the snapshot of config preprocessed with importResolver().
+   * No-op if snapshots are disabled.
+   */
+  void save(const folly::dynamic& config);
+
+ private:
+  class RecordingImportResolver : public McImportResolver {
+   public:
+    explicit RecordingImportResolver(ConfigApi& configApi);
+
+    std::string import(folly::StringPiece path) override;
+
+    // path -> md5
+    std::unordered_map<std::string, std::string> imports;
+  };
+
+  ConfigApi& configApi_;
+  RecordingImportResolver importResolver_;
+  // empty if snapshots are disabled
+  std::string path_;
+  std::string sourceHash_;
+};
+}
+}
+} // facebook::memcache::mcrouter
@@ -0,0 +1,148 @@
+/*
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include "ConnectThrottle.h"
+
+#include <algorithm>
+
+#include <folly/TokenBucket.h>
+#include <folly/fibers/Baton.h>
+
+#include "mcrouter/CarbonRouterInstanceBase.h"
+#include "mcrouter/McrouterLogFailure.h"
+#include "mcrouter/ProxyBase.h"
+#include "mcrouter/ProxyDestination.h"
+#include "mcrouter/stats.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+ConnectThrottle::ConnectThrottle(ProxyBase& proxy)
+    : proxy_(proxy),
+      timer_(folly::AsyncTimeout::make(proxy.eventBase(), [this]() noexcept {
+        timerScheduled_ = false;
+        onTimer();
+      })) {}
+
+ConnectThrottle::~ConnectThrottle() {
+  for (auto& entry : prewarm_) {
+    if (entry.warmUp) {
+      entry.warmUp->settle(false);
+    }
+  }
+}
+
+bool ConnectThrottle::consume() {
+  auto* budget = proxy_.router().connectTokenBucket();
+  return !budget ||
+      (*budget)->consume(1.0, folly::TokenBucket::defaultClockNow());
+}
+
+bool ConnectThrottle::tryAcquire() {
+  return waiters_.empty() && consume();
+}
+
+bool ConnectThrottle::acquire(
+    const ProxyDestination& pdstn,
+    std::chrono::milliseconds timeout) {
+  if (tryAcquire()) {
+    return true;
+  }
+  proxy_.stats().increment(connects_throttled_stat);
+
+  auto& waiter = waitersByDestination_[&pdstn];
+  if (!waiter) {
+    waiter = std::make_shared<Waiter>();
+    waiter->pdstn = &pdstn;
+    waiters_.push_back(waiter);
+  }
+  // Keep the waiter alive, it is erased from the map once granted.
+  auto self = waiter;
+  folly::fibers::Baton baton;
+  self->batons.push_back(&baton);
+  scheduleTimer();
+
+  baton.try_wait_for(timeout);
+  if (self->granted) {
+    return true;
+  }
+
+  self->batons.erase(
+      std::find(self->batons.begin(), self->batons.end(), &baton));
+  if (self->batons.empty()) {
+    // Nobody waits for this connection anymore, don't spend budget on it.
+    waitersByDestination_.erase(self->pdstn);
+  }
+  proxy_.stats().increment(connects_throttle_timeouts_stat);
+  return false;
+}
+
+void ConnectThrottle::prewarm(
+    std::weak_ptr<ProxyDestination> pdstn,
+    std::shared_ptr<ConnectionWarmUp> warmUp) {
+  prewarm_.push_back(PrewarmEntry{std::move(pdstn), std::move(warmUp)});
+  scheduleTimer();
+}
+
+void ConnectThrottle::onTimer() {
+  while (!waiters_.empty()) {
+    auto& waiter = waiters_.front();
+    if (!waiter->batons.empty()) {
+      if (!consume()) {
+        break;
+      }
+      waiter->granted = true;
+      waitersByDestination_.erase(waiter->pdstn);
+      for (auto* baton : waiter->batons) {
+        baton->post();
+      }
+    }
+    waiters_.pop_front();
+  }
+
+  while (waiters_.empty() && !prewarm_.empty()) {
+    auto& entry = prewarm_.front();
+    if (auto pdstn = entry.pdstn.lock()) {
+      if (!pdstn->hasConnection()) {
+        if (!consume()) {
+          break;
+        }
+        proxy_.stats().increment(connects_prewarmed_stat);
+      }
+      pdstn->prewarm(std::move(entry.warmUp));
+    } else if (entry.warmUp) {
+      entry.warmUp->settle(false);
+    }
+    prewarm_.pop_front();
+  }
+
+  scheduleTimer();
+}
+
+void ConnectThrottle::scheduleTimer() {
+  if (timerScheduled_ || (waiters_.empty() && prewarm_.empty())) {
+    return;
+  }
+  // Check back about when the next connection is allowed.
+  const auto rate = proxy_.router().opts().max_new_connections_per_second;
+  const uint32_t intervalMs = rate == 0
+      ? 0
+      : std::min<uint32_t>(100, std::max<uint32_t>(1, 1000 / rate));
+  if (!timer_->scheduleTimeout(intervalMs)) {
+    MC_LOG_FAILURE(
+        proxy_.router().opts(),
+        failure::Category::kSystemError,
+        "failed to schedule connect throttle timer");
+    return;
+  }
+  timerScheduled_ = true;
+}
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
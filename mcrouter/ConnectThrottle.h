@@ -0,0 +1,106 @@
+/*
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <folly/io/async/AsyncTimeout.h>
+
+#include "mcrouter/ConnectionWarmUp.h"
+
+namespace folly {
+namespace fibers {
+class Baton;
+} // namespace fibers
+} // namespace folly
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+class ProxyBase;
+class ProxyDestination;
+
+/**
+ * Rate limits the new connections opened by the destinations of a proxy,
+ * using the router-wide max_new_connections_per_second budget, so that a
+ * restart doesn't connect to every server at once. Every connection attempt
+ * takes one token, reconnects included.
+ *
+ * Destinations with requests waiting for a connection are served first, in
+ * order; prewarm connections (prewarm_connections) only get the budget left
+ * over.
+ *
+ * Only accessed from the proxy thread.
+ */
+class ConnectThrottle {
+ public:
+  explicit ConnectThrottle(ProxyBase& proxy);
+  ~ConnectThrottle();
+
+  ConnectThrottle(const ConnectThrottle&) = delete;
+  ConnectThrottle& operator=(const ConnectThrottle&) = delete;
+
+  /**
+   * @return true if a new connection may be opened right now. Never succeeds
+   *         while requests are queued for a connection.
+   */
+  bool tryAcquire();
+
+  /**
+   * Blocks the calling fiber until a connection to `pdstn` may be opened, or
+   * until `timeout` expires. Concurrent requests to the same destination
+   * share a single place in the queue.
+   *
+   * @return true if the connection may be opened.
+   */
+  bool acquire(
+      const ProxyDestination& pdstn,
+      std::chrono::milliseconds timeout);
+
+  /**
+   * Calls ProxyDestination::prewarm() once there's budget left after all
+   * queued requests. If `warmUp` is set, the destination is settled in it
+   * (also if it is gone, or this throttle is destroyed first).
+   */
+  void prewarm(
+      std::weak_ptr<ProxyDestination> pdstn,
+      std::shared_ptr<ConnectionWarmUp> warmUp = nullptr);
+
+ private:
+  struct Waiter {
+    const ProxyDestination* pdstn;
+    std::vector<folly::fibers::Baton*> batons;
+    bool granted{false};
+  };
+
+  struct PrewarmEntry {
+    std::weak_ptr<ProxyDestination> pdstn;
+    std::shared_ptr<ConnectionWarmUp> warmUp;
+  };
+
+  ProxyBase& proxy_;
+  std::deque<std::shared_ptr<Waiter>> waiters_;
+  std::unordered_map<const ProxyDestination*, std::shared_ptr<Waiter>>
+      waitersByDestination_;
+  std::deque<PrewarmEntry> prewarm_;
+  std::unique_ptr<folly::AsyncTimeout> timer_;
+  bool timerScheduled_{false};
+
+  bool consume();
+  void onTimer();
+  void scheduleTimer();
+};
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
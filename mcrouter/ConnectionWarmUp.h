@@ -0,0 +1,86 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Progress of connecting to the destinations of a new config
+ * (warm_start_connect_fraction). Updated by all proxies, waited on by the
+ * thread swapping the config in.
+ *
+ * Every destination added is settled exactly once: as up once its
+ * connection is up, or as not up if it failed to connect, was closed, is
+ * TKO or went away. Waiting stops as soon as the outcome is known, instead
+ * of running into the timeout because of destinations that won't come up.
+ */
+class ConnectionWarmUp {
+ public:
+  /**
+   * Adds `n` destinations to connect to.
+   */
+  void add(size_t n) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    total_ += n;
+  }
+
+  /**
+   * Records the outcome of one destination.
+   */
+  void settle(bool up) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ++settled_;
+      if (up) {
+        ++up_;
+      }
+    }
+    cv_.notify_all();
+  }
+
+  /**
+   * Blocks until `needed` destinations are up, every destination is
+   * settled, or `deadline` passes, whichever comes first.
+   *
+   * @return number of destinations up.
+   */
+  size_t wait(size_t needed, std::chrono::steady_clock::time_point deadline) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait_until(
+        lock, deadline, [&] { return up_ >= needed || settled_ >= total_; });
+    return up_;
+  }
+
+  size_t total() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return total_;
+  }
+
+  size_t up() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return up_;
+  }
+
+ private:
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  size_t total_{0};
+  size_t settled_{0};
+  size_t up_{0};
+};
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
@@ -0,0 +1,105 @@
+/*
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Counts requests and errors over a sliding time window. The window is split
+ * into kNumBuckets buckets; whole buckets expire as time moves on.
+ *
+ * Not thread-safe, meant to be owned by a single proxy thread.
+ */
+class ErrorRateWindow {
+ public:
+  static constexpr size_t kNumBuckets = 10;
+
+  explicit ErrorRateWindow(
+      std::chrono::milliseconds window = std::chrono::seconds(10)) {
+    setWindow(window);
+  }
+
+  void setWindow(std::chrono::milliseconds window) {
+    bucketUs_ = std::max<int64_t>(
+        1,
+        std::chrono::duration_cast<std::chrono::microseconds>(window).count() /
+            kNumBuckets);
+    reset();
+  }
+
+  /**
+   * Records a request that completed at `nowUs`.
+   */
+  void record(bool error, int64_t nowUs) {
+    advance(nowUs);
+    auto idx = currentBucket_ % kNumBuckets;
+    ++requests_[idx];
+    ++totalRequests_;
+    if (error) {
+      ++errors_[idx];
+      ++totalErrors_;
+    }
+  }
+
+  /**
+   * @return requests within the window as of the last record().
+   */
+  uint64_t requests() const {
+    return totalRequests_;
+  }
+
+  /**
+   * @return errors within the window as of the last record().
+   */
+  uint64_t errors() const {
+    return totalErrors_;
+  }
+
+  void reset() {
+    requests_.fill(0);
+    errors_.fill(0);
+    totalRequests_ = 0;
+    totalErrors_ = 0;
+  }
+
+ private:
+  int64_t bucketUs_{1};
+  int64_t currentBucket_{0};
+  std::array<uint64_t, kNumBuckets> requests_{};
+  std::array<uint64_t, kNumBuckets> errors_{};
+  uint64_t totalRequests_{0};
+  uint64_t totalErrors_{0};
+
+  void advance(int64_t nowUs) {
+    const int64_t bucket = nowUs / bucketUs_;
+    if (bucket <= currentBucket_) {
+      return;
+    }
+    const int64_t expired =
+        std::min<int64_t>(bucket - currentBucket_, kNumBuckets);
+    for (int64_t i = 1; i <= expired; ++i) {
+      auto idx = (currentBucket_ + i) % kNumBuckets;
+      totalRequests_ -= requests_[idx];
+      totalErrors_ -= errors_[idx];
+      requests_[idx] = 0;
+      errors_[idx] = 0;
+    }
+    currentBucket_ = bucket;
+  }
+};
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
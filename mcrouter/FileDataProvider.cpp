@@ -7,9 +7,10 @@
  */
 #include "FileDataProvider.h"
 
-#include <poll.h>
 #include <sys/inotify.h>
 
+#include <algorithm>
+
 #include <boost/filesystem/convenience.hpp>
 #include <boost/filesystem/operations.hpp>
 #include <boost/filesystem/path.hpp>
@@ -17,6 +18,7 @@
 
 #include <folly/FileUtil.h>
 #include <folly/Format.h>
+#include <folly/ScopeGuard.h>
 
 using boost::filesystem::complete;
 using boost::filesystem::path;
@@ -32,24 +34,28 @@ const size_t INOTIFY_BUF_SIZE = 1024;
  *  We want to watch for the file being modified, moved, or deleted,
  *  and the same for any symlinks (inotify should watch the symlink itself)
  */
-const uint32_t INOTIFY_MASK =
-    IN_MODIFY | IN_MOVE_SELF | IN_DELETE_SELF | IN_DONT_FOLLOW;
+const uint32_t INOTIFY_MASK = IN_MODIFY | IN_CLOSE_WRITE | IN_MOVE_SELF |
+    IN_DELETE_SELF | IN_DONT_FOLLOW;
+
+/**
+ *  Files replaced with rename() (and symlinks swapped the same way) don't
+ *  generate any events on the watched inode, only on their directory.
+ */
+const uint32_t INOTIFY_DIR_MASK = IN_CREATE | IN_MOVED_TO | IN_ONLYDIR;
+
+void FileDataProvider::updateInotifyWatch(bool mustExist) {
+  std::unordered_map<int, std::vector<std::string>> watches;
+  auto rollback = folly::makeGuard([&]() {
+    for (const auto& it : watches) {
+      if (watches_.find(it.first) == watches_.end()) {
+        inotify_rm_watch(inotify_.fd(), it.first);
+      }
+    }
+  });
+  auto addWatch = [this](const path& watched, uint32_t mask) {
+    return inotify_add_watch(inotify_.fd(), watched.string().data(), mask);
+  };
 
-void FileDataProvider::updateInotifyWatch() {
-  /**
-   * Initiailze inotify and get the file descriptor we will use to watch for
-   * changes.
-   */
-  auto inotifyFD = inotify_init();
-  if (inotifyFD < 0) {
-    throw std::runtime_error(
-        folly::format(
-            "Failed to initialize inotify for '{}'. Errno: '{}'",
-            filePath_.data(),
-            errno)
-            .str());
-  }
-  folly::File tmpInotify(inotifyFD, /* ownsFd */ true);
   /**
    * Right now mcrouter configs are a symlink to the actual config file.
    * We need to watch both the link and the config file for changes. Just
@@ -57,14 +63,28 @@ void FileDataProvider::updateInotifyWatch() {
    */
   path link(filePath_);
   while (true) {
+    auto directory = link.parent_path();
+    if (directory.empty()) {
+      directory = ".";
+    }
+    int dirWd = addWatch(directory, INOTIFY_DIR_MASK);
+    if (dirWd < 0) {
+      throw std::runtime_error(folly::sformat(
+          "Can not add inotify watch for '{}'", directory.string()));
+    }
+    watches[dirWd].push_back(link.filename().string());
+
     // Add a watch on the current link or file
-    int wd = inotify_add_watch(inotifyFD, link.string().data(), INOTIFY_MASK);
+    int wd = addWatch(link, INOTIFY_MASK);
     if (wd < 0) {
-      throw std::runtime_error(
-          folly::format(
-              "Can not add inotify watch for '{}'", link.string().data())
-              .str());
+      if (!mustExist && errno == ENOENT) {
+        // The directory watch will tell us once it's back.
+        break;
+      }
+      throw std::runtime_error(folly::sformat(
+          "Can not add inotify watch for '{}'", link.string()));
     }
+    watches[wd];
     // Read the link (if it is one)
     boost::system::error_code ec;
     auto file = read_symlink(link, ec);
@@ -75,7 +95,15 @@ void FileDataProvider::updateInotifyWatch() {
     file = complete(file, link.parent_path());
     std::swap(link, file);
   }
-  inotify_ = std::move(tmpInotify);
+
+  rollback.dismiss();
+  for (const auto& it : watches_) {
+    if (watches.find(it.first) == watches.end()) {
+      // Fails harmlessly if the watch is gone with its inode.
+      inotify_rm_watch(inotify_.fd(), it.first);
+    }
+  }
+  watches_ = std::move(watches);
 }
 
 FileDataProvider::FileDataProvider(std::string filePath)
@@ -84,7 +112,20 @@ FileDataProvider::FileDataProvider(std::string filePath)
     throw std::runtime_error("File path empty");
   }
 
-  updateInotifyWatch();
+  /**
+   * Initiailze inotify and get the file descriptor we will use to watch for
+   * changes.
+   */
+  auto inotifyFD = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (inotifyFD < 0) {
+    throw std::runtime_error(folly::sformat(
+        "Failed to initialize inotify for '{}'. Errno: '{}'",
+        filePath_,
+        errno));
+  }
+  inotify_ = folly::File(inotifyFD, /* ownsFd */ true);
+
+  updateInotifyWatch(/* mustExist */ true);
 }
 
 std::string FileDataProvider::load() const {
@@ -101,25 +142,47 @@ bool FileDataProvider::hasUpdate() {
     return false;
   }
 
-  struct pollfd pollfd;
-  pollfd.fd = inotify_.fd();
-  pollfd.events = POLLIN;
-  auto retval = poll(&pollfd, /* nfds = */ 1, /* timeout = */ 0);
-  if (retval < 0) {
-    throw std::runtime_error(
-        folly::format("poll on inotifyFD for '{}' failed", filePath_.data())
-            .str());
-  } else if (retval > 0) {
-    struct inotify_event inotifyBuffer[INOTIFY_BUF_SIZE];
-    // Data is ready to read from inotifyFD.  We need to read it so that
-    // select doesn't immediately return next time.
-    auto len = read(inotify_.fd(), inotifyBuffer, sizeof(inotifyBuffer));
-    LOG_IF(ERROR, len < 0) << "Read from inotify failed";
-
-    updateInotifyWatch();
-    return true;
+  bool updated = false;
+  alignas(struct inotify_event) char
+      buffer[INOTIFY_BUF_SIZE * sizeof(struct inotify_event)];
+  while (true) {
+    auto len = folly::readNoInt(inotify_.fd(), buffer, sizeof(buffer));
+    if (len < 0) {
+      if (errno == EAGAIN) {
+        break;
+      }
+      throw std::runtime_error(folly::sformat(
+          "Read from inotifyFD for '{}' failed. Errno: '{}'",
+          filePath_,
+          errno));
+    }
+    for (auto pos = buffer; pos < buffer + len;) {
+      const auto* event = reinterpret_cast<const struct inotify_event*>(pos);
+      pos += sizeof(struct inotify_event) + event->len;
+      if (event->mask & IN_Q_OVERFLOW) {
+        // Events were lost, assume the worst.
+        updated = true;
+        continue;
+      }
+      auto it = watches_.find(event->wd);
+      if (it == watches_.end()) {
+        continue;
+      }
+      const auto& names = it->second;
+      // Directory events are only interesting for the names we watch.
+      if (names.empty() ||
+          (event->len > 0 &&
+           std::find(names.begin(), names.end(), event->name) !=
+               names.end())) {
+        updated = true;
+      }
+    }
+  }
+
+  if (updated) {
+    updateInotifyWatch(/* mustExist */ false);
   }
-  return false;
+  return updated;
 }
 }
 }
@@ -8,6 +8,8 @@
 #pragma once
 
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include <folly/File.h>
 
@@ -17,6 +19,10 @@ namespace mcrouter {
 /**
  * DataProvider that works with file: loads data from file and checks
  * if the file has changed.
+ *
+ * Besides the file itself (and every symlink leading to it), the
+ * directories containing them are watched, so that files atomically
+ * replaced with rename() and swapped symlinks are noticed as well.
  */
 class FileDataProvider {
  public:
@@ -35,23 +41,39 @@ class FileDataProvider {
   std::string load() const;
 
   /**
-   * Polls inotify watch to check if file has changed. Also recreates the
-   * inotify watch in case file link changed/file was deleted and created again.
+   * Reads pending inotify events without blocking. Also updates the
+   * inotify watches in case file link changed/file was deleted and
+   * created again.
    *
    * @return true if file has changed since last hasUpdate call, false otherwise
-   * @throw runtime_error if inotify watch can not be checked or recreated
+   * @throw runtime_error if inotify watch can not be checked or updated
    */
   bool hasUpdate();
 
+  /**
+   * @return inotify file descriptor, readable whenever hasUpdate() may
+   *         return true. It doesn't change during the lifetime of the
+   *         provider, so it can be waited on with poll() or an event loop.
+   */
+  int fd() const {
+    return inotify_.fd();
+  }
+
  private:
   const std::string filePath_;
   folly::File inotify_;
+  // watch descriptor -> names we're interested in, for directory watches
+  // (empty for watches of the file and symlinks themselves)
+  std::unordered_map<int, std::vector<std::string>> watches_;
 
   /**
-   * Updates the inotify watch.
+   * Updates the inotify watches.
    * Provides strong guarantee: if exception is thrown, state won't change.
+   *
+   * @param mustExist  if false, a missing file is not an error: its
+   *                   directory is still watched for the file to reappear.
    */
-  void updateInotifyWatch();
+  void updateInotifyWatch(bool mustExist);
 };
 }
 }
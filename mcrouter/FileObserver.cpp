@@ -7,12 +7,18 @@
  */
 #include "FileObserver.h"
 
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
 #include <memory>
-#include <vector>
+#include <thread>
 
 #include <glog/logging.h>
 
-#include <folly/io/async/EventBase.h>
+#include <folly/File.h>
+#include <folly/FileUtil.h>
+#include <folly/system/ThreadName.h>
 
 #include "mcrouter/FileDataProvider.h"
 #include "mcrouter/McrouterLogFailure.h"
@@ -25,87 +31,126 @@ namespace {
 
 struct FileObserverData {
   FileObserverData(
-      const std::shared_ptr<folly::FunctionScheduler>& scheduler__,
-      std::string functionName__,
-      std::shared_ptr<FileDataProvider> provider__,
+      std::unique_ptr<FileDataProvider> provider__,
       std::function<void(std::string)> onUpdate__,
-      std::chrono::milliseconds sleepBeforeUpdate__,
-      FileObserverHandle handle)
-      : scheduler(scheduler__),
-        functionName(functionName__),
-        provider(std::move(provider__)),
+      std::chrono::milliseconds sleepBeforeUpdate__)
+      : provider(std::move(provider__)),
         onUpdate(std::move(onUpdate__)),
-        sleepBeforeUpdate(sleepBeforeUpdate__),
-        token(handle) {}
-  std::weak_ptr<folly::FunctionScheduler> scheduler;
-  std::string functionName;
-  std::shared_ptr<FileDataProvider> provider;
+        sleepBeforeUpdate(sleepBeforeUpdate__) {
+    auto fd = eventfd(0, EFD_CLOEXEC);
+    if (fd < 0) {
+      throw std::runtime_error("Failed to create eventfd");
+    }
+    stopFd = folly::File(fd, /* ownsFd */ true);
+  }
+  std::unique_ptr<FileDataProvider> provider;
   std::function<void(std::string)> onUpdate;
   std::chrono::milliseconds sleepBeforeUpdate;
-  std::weak_ptr<FileObserverToken> token;
+  // Readable once observation should stop.
+  folly::File stopFd;
 };
 
-void checkForUpdate(const std::shared_ptr<FileObserverData>& data) {
-  const auto scheduler = data->scheduler.lock();
-  assert(scheduler);
-  if (!scheduler) {
-    // Should never happens since we're executed by the scheduler.
+/**
+ * Blocks until timeout expires, observation is stopped or, if
+ * waitForFile is true, there are inotify events to read.
+ *
+ * @return false if observation was stopped
+ */
+bool wait(
+    const FileObserverData& data,
+    bool waitForFile,
+    std::chrono::milliseconds timeout) {
+  struct pollfd fds[2];
+  fds[0].fd = data.stopFd.fd();
+  fds[0].events = POLLIN;
+  fds[1].fd = data.provider->fd();
+  fds[1].events = POLLIN;
+  int retval;
+  do {
+    retval = poll(fds, waitForFile ? 2 : 1, timeout.count());
+  } while (retval < 0 && errno == EINTR);
+  if (retval < 0) {
     LOG_FAILURE(
         "mcrouter",
         failure::Category::kSystemError,
-        "Global function scheduler not available");
-    return;
+        "poll failed while observing file for update. Errno: {}",
+        errno);
+    return false;
   }
-  const auto tokenRef = data->token.lock();
-  if (!tokenRef) {
-    scheduler->cancelFunction(data->functionName);
-    return;
+  return !(fds[0].revents & POLLIN);
+}
+
+void observe(const std::shared_ptr<FileObserverData>& data) {
+  folly::setThreadName("mcrfileobserver");
+  const std::chrono::milliseconds kForever(-1);
+  while (wait(*data, true, kForever)) {
+    // Writes are rarely a single syscall, let them finish.
+    if (data->sleepBeforeUpdate.count() > 0 &&
+        !wait(*data, false, data->sleepBeforeUpdate)) {
+      return;
+    }
+    try {
+      if (!data->provider->hasUpdate()) {
+        continue;
+      }
+    } catch (...) {
+      LOG_FAILURE(
+          "mcrouter",
+          failure::Category::kOther,
+          "Error while observing file for update. "
+          "Will stop watching for updates");
+      return;
+    }
+    try {
+      data->onUpdate(data->provider->load());
+    } catch (...) {
+      LOG_FAILURE(
+          "mcrouter",
+          failure::Category::kOther,
+          "Error while observing file for update");
+    }
   }
-  try {
-    if (!data->provider->hasUpdate()) {
+}
+
+class FileObserver : public FileObserverToken {
+ public:
+  explicit FileObserver(std::shared_ptr<FileObserverData> data)
+      : data_(std::move(data)), thread_([data = data_]() { observe(data); }) {}
+
+  ~FileObserver() override {
+    uint64_t val = 1;
+    if (folly::writeNoInt(data_->stopFd.fd(), &val, sizeof(val)) < 0) {
+      LOG(ERROR) << "Failed to stop file observer thread";
+      thread_.detach();
       return;
     }
-  } catch (...) {
-    LOG_FAILURE(
-        "mcrouter",
-        failure::Category::kOther,
-        "Error while observing file for update. Will stop polling for updates");
-    data->token.reset();
-    return;
+    if (thread_.get_id() == std::this_thread::get_id()) {
+      // Released from onUpdate, the thread exits right after it.
+      thread_.detach();
+    } else {
+      thread_.join();
+    }
   }
 
-  static std::atomic<uint64_t> updateId(0);
-  scheduler->addFunctionOnce(
-      [data = data]() {
-        try {
-          if (const auto ref = data->token.lock()) {
-            data->onUpdate(data->provider->load());
-          }
-        } catch (...) {
-          LOG_FAILURE(
-              "mcrouter",
-              failure::Category::kOther,
-              "Error while observing file for update");
-        }
-      },
-      folly::to<std::string>(
-          "carbon-file-observer-update-", updateId.fetch_add(1)),
-      data->sleepBeforeUpdate);
-}
+ private:
+  std::shared_ptr<FileObserverData> data_;
+  std::thread thread_;
+};
 
 } // anonymous namespace
 
 FileObserverHandle startObservingFile(
     const std::string& filePath,
-    const std::shared_ptr<folly::FunctionScheduler>& scheduler,
-    std::chrono::milliseconds pollPeriod,
     std::chrono::milliseconds sleepBeforeUpdate,
     std::function<void(std::string)> onUpdate) {
-  std::shared_ptr<FileDataProvider> provider;
+  std::shared_ptr<FileObserverData> data;
   try {
-    provider = std::make_shared<FileDataProvider>(filePath);
+    auto provider = std::make_unique<FileDataProvider>(filePath);
 
     onUpdate(provider->load());
+
+    data = std::make_shared<FileObserverData>(
+        std::move(provider), std::move(onUpdate), sleepBeforeUpdate);
   } catch (const std::exception& e) {
     VLOG(0) << "Can not start watching " << filePath
             << " for modifications: " << e.what();
@@ -113,21 +158,7 @@ FileObserverHandle startObservingFile(
   }
 
   VLOG(0) << "Watching " << filePath << " for modifications.";
-  FileObserverHandle handle = std::make_shared<FileObserverToken>();
-  static std::atomic<uint64_t> uniqueId(0);
-  auto data = std::make_shared<FileObserverData>(
-      scheduler,
-      folly::to<std::string>("carbon-file-observer-", uniqueId.fetch_add(1)),
-      std::move(provider),
-      std::move(onUpdate),
-      sleepBeforeUpdate,
-      handle);
-  scheduler->addFunction(
-      [data = data]() { checkForUpdate(data); },
-      pollPeriod,
-      data->functionName,
-      pollPeriod);
-  return handle;
+  return std::make_shared<FileObserver>(std::move(data));
 }
 
 } // mcrouter
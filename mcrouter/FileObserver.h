@@ -12,34 +12,36 @@
 #include <memory>
 #include <string>
 
-#include <folly/experimental/FunctionScheduler.h>
-
 namespace facebook {
 namespace memcache {
 namespace mcrouter {
 
 // File observation will continue so long as FileObserverHandle has a ref count
 // greater than zero.
-struct FileObserverToken {};
+struct FileObserverToken {
+  virtual ~FileObserverToken() = default;
+};
 using FileObserverHandle = std::shared_ptr<FileObserverToken>;
 
 /**
- * Starts a periodic thread that watches the given file path for changes.
+ * Starts a thread that waits for inotify events on the given file path
+ * and calls onUpdate with the new contents of the file. The file is
+ * observed even if it is atomically replaced or is a symlink that gets
+ * swapped.
  *
  * @param filePath path to the file to watch (can be a symlink)
- * @param pollPeriod milliseconds to wait between asking inotify if
- *        any updates happened
- * @param sleepAfterUpdate milliseconds to wait before calling onUpdate
- *        once an inotify event happens (as a crude protection against
- *        partial writes race condition).
- * @param onUpdate callback function to call when there is a update seen
- * @return handle that will disable observation once it has a ref count of zero.
+ * @param sleepBeforeUpdate milliseconds to wait before calling onUpdate
+ *        once an inotify event happens, to coalesce writes that come in
+ *        quick succession.
+ * @param onUpdate callback function to call when there is a update seen.
+ *        Called once with the current contents before this returns, then
+ *        from the observer thread.
+ * @return handle that will disable observation once it has a ref count of
+ *         zero. onUpdate is not called after that.
  */
 FileObserverHandle startObservingFile(
     const std::string& filePath,
-    const std::shared_ptr<folly::FunctionScheduler>& scheduler,
-    std::chrono::milliseconds pollPeriod,
-    std::chrono::milliseconds sleepBeforeUpdateMs,
+    std::chrono::milliseconds sleepBeforeUpdate,
     std::function<void(std::string)> onUpdate);
 }
 }
@@ -0,0 +1,89 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include "HotKeyTracker.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+namespace {
+
+constexpr size_t kSketchWidth = 4096;
+// Number of samples between two decays, as in TinyLFU.
+constexpr size_t kDecayPeriod = 10 * kSketchWidth;
+
+} // anonymous namespace
+
+HotKeyTracker::HotKeyTracker(size_t sampleRate, size_t topK)
+    : sampleRate_(sampleRate),
+      topK_(topK),
+      countdown_(sampleRate),
+      sketch_(
+          sampleRate ? kSketchWidth : 0,
+          std::numeric_limits<uint32_t>::max()) {}
+
+void HotKeyTracker::recordSample(folly::StringPiece key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  auto count = sketch_.increment(key);
+  auto keyStr = key.str();
+  auto it = top_.find(keyStr);
+  if (it != top_.end()) {
+    it->second = count;
+  } else if (top_.size() < topK_) {
+    top_.emplace(std::move(keyStr), count);
+  } else if (topK_ > 0) {
+    auto minIt = std::min_element(
+        top_.begin(), top_.end(), [](const auto& a, const auto& b) {
+          return a.second < b.second;
+        });
+    if (minIt->second < count) {
+      top_.erase(minIt);
+      top_.emplace(std::move(keyStr), count);
+    }
+  }
+
+  if (++samples_ >= kDecayPeriod) {
+    decay();
+  }
+}
+
+void HotKeyTracker::decay() {
+  sketch_.halve();
+  for (auto it = top_.begin(); it != top_.end();) {
+    it->second >>= 1;
+    if (it->second == 0) {
+      it = top_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  samples_ = 0;
+}
+
+std::vector<std::pair<std::string, uint64_t>> HotKeyTracker::topKeys() const {
+  std::vector<std::pair<std::string, uint64_t>> result;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    result.reserve(top_.size());
+    for (const auto& it : top_) {
+      result.emplace_back(it.first, uint64_t(it.second) * sampleRate_);
+    }
+  }
+  std::sort(result.begin(), result.end(), [](const auto& a, const auto& b) {
+    return a.second > b.second;
+  });
+  return result;
+}
+
+} // mcrouter
+} // memcache
+} // facebook
@@ -0,0 +1,74 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <folly/Range.h>
+
+#include "mcrouter/lib/CountMinSketch.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Finds the most frequently requested keys on a proxy.
+ *
+ * Every sampleRate-th key is counted in a count-min sketch, and the
+ * topK keys with the highest estimates are remembered. Counts decay
+ * (are halved) periodically, so the result reflects recent traffic.
+ *
+ * record() must only be called from the owning proxy thread; topKeys()
+ * may be called from any thread.
+ */
+class HotKeyTracker {
+ public:
+  /**
+   * @param sampleRate  count one in sampleRate keys. 0 disables tracking.
+   * @param topK        number of hot keys to remember.
+   */
+  HotKeyTracker(size_t sampleRate, size_t topK);
+
+  void record(folly::StringPiece key) {
+    if (sampleRate_ == 0 || --countdown_ > 0) {
+      return;
+    }
+    countdown_ = sampleRate_;
+    recordSample(key);
+  }
+
+  /**
+   * @return  (key, estimated number of requests) pairs, sorted by
+   *          decreasing count.
+   */
+  std::vector<std::pair<std::string, uint64_t>> topKeys() const;
+
+ private:
+  const size_t sampleRate_;
+  const size_t topK_;
+  size_t countdown_;
+
+  mutable std::mutex mutex_;
+  CountMinSketch sketch_;
+  std::unordered_map<std::string, uint32_t> top_;
+  size_t samples_{0};
+
+  void recordSample(folly::StringPiece key);
+  void decay();
+};
+
+} // mcrouter
+} // memcache
+} // facebook
@@ -0,0 +1,81 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Limit on the number of keys of one multiget routed at the same time, so
+ * that wide multigets don't make all of their destinations reply at once
+ * (incast) and overflow the switch buffers in front of mcrouter.
+ *
+ * Adjusted with AIMD from the retransmit rate of connections to destinations:
+ * a sample above rxmitThreshold halves the window (at most once per
+ * kMinDecreaseIntervalUs, samples of all destinations arrive together), any
+ * other sample grows it by 1/window. If rxmitThreshold is 0, the window
+ * stays at maxWindow.
+ *
+ * Not thread-safe, meant to be owned by a single proxy thread.
+ */
+class IncastWindow {
+ public:
+  static constexpr int64_t kMinDecreaseIntervalUs = 100 * 1000;
+
+  IncastWindow(size_t minWindow, size_t maxWindow, double rxmitThreshold)
+      : minWindow_(std::max<size_t>(1, std::min(minWindow, maxWindow))),
+        maxWindow_(std::max<size_t>(1, maxWindow)),
+        rxmitThreshold_(rxmitThreshold),
+        window_(maxWindow_) {}
+
+  /**
+   * Records a sample of retransmits per KB sent on one connection, taken at
+   * `nowUs`.
+   *
+   * @return true if window() changed.
+   */
+  bool onRetransmits(double retransPerKByte, int64_t nowUs) {
+    if (rxmitThreshold_ <= 0) {
+      return false;
+    }
+    const auto before = window();
+    if (retransPerKByte > rxmitThreshold_) {
+      if (nowUs - lastDecreaseUs_ >= kMinDecreaseIntervalUs) {
+        window_ = std::max<double>(minWindow_, window_ / 2);
+        lastDecreaseUs_ = nowUs;
+      }
+    } else {
+      window_ = std::min<double>(maxWindow_, window_ + 1 / window_);
+    }
+    return window() != before;
+  }
+
+  /**
+   * @return current limit on keys routed at once, in [minWindow, maxWindow].
+   */
+  size_t window() const {
+    return static_cast<size_t>(window_);
+  }
+
+ private:
+  const size_t minWindow_;
+  const size_t maxWindow_;
+  const double rxmitThreshold_;
+  double window_;
+  int64_t lastDecreaseUs_{std::numeric_limits<int64_t>::min() / 2};
+};
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
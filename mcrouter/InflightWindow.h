@@ -0,0 +1,108 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Limit on the number of inflight requests to one destination, adjusted with
+ * AIMD: grows by one request per window worth of replies that came back in
+ * time, halves (at most once per round trip) on replies that signal
+ * congestion. A reply signals congestion if it failed with a load related
+ * error, or if it took longer than latencyFactor times the shortest latency
+ * seen recently.
+ *
+ * Starts at maxWindow, so a destination that keeps up is throttled exactly
+ * as with a static limit. Not thread-safe, meant to be owned by a single
+ * proxy thread.
+ */
+class InflightWindow {
+ public:
+  // The shortest latency is re-learned this often, so that a destination
+  // that got slower for good isn't compared to its best day forever.
+  static constexpr int64_t kMinLatencyPeriodUs = 10 * 1000 * 1000;
+
+  InflightWindow(size_t minWindow, size_t maxWindow, double latencyFactor)
+      : minWindow_(std::max<size_t>(1, std::min(minWindow, maxWindow))),
+        maxWindow_(std::max<size_t>(1, maxWindow)),
+        latencyFactor_(latencyFactor),
+        window_(maxWindow_) {}
+
+  /**
+   * Records a reply that arrived at `nowUs`, `latencyUs` after its request
+   * was sent.
+   *
+   * @return true if window() changed.
+   */
+  bool onReply(bool failed, int64_t latencyUs, int64_t nowUs) {
+    const auto before = window();
+    if (!failed) {
+      updateMinLatency(latencyUs, nowUs);
+    }
+    const bool congested = failed ||
+        (minLatencyUs_ != kUnknownLatency &&
+         latencyUs > latencyFactor_ * minLatencyUs_);
+    if (congested) {
+      // Replies to requests sent before the last decrease don't tell
+      // anything about the new window yet.
+      if (nowUs - latencyUs >= lastDecreaseUs_) {
+        window_ = std::max<double>(minWindow_, window_ / 2);
+        lastDecreaseUs_ = nowUs;
+      }
+    } else {
+      window_ = std::min<double>(maxWindow_, window_ + 1 / window_);
+    }
+    return window() != before;
+  }
+
+  /**
+   * @return current limit on inflight requests, in [minWindow, maxWindow].
+   */
+  size_t window() const {
+    return static_cast<size_t>(window_);
+  }
+
+ private:
+  static constexpr int64_t kUnknownLatency =
+      std::numeric_limits<int64_t>::max();
+
+  const size_t minWindow_;
+  const size_t maxWindow_;
+  const double latencyFactor_;
+  double window_;
+  int64_t lastDecreaseUs_{std::numeric_limits<int64_t>::min()};
+
+  int64_t minLatencyUs_{kUnknownLatency};
+  // Shortest latency within the current period, becomes minLatencyUs_ once
+  // the period is over.
+  int64_t periodMinLatencyUs_{kUnknownLatency};
+  int64_t periodStartUs_{0};
+
+  void updateMinLatency(int64_t latencyUs, int64_t nowUs) {
+    if (nowUs - periodStartUs_ >= kMinLatencyPeriodUs) {
+      if (periodMinLatencyUs_ != kUnknownLatency) {
+        minLatencyUs_ = periodMinLatencyUs_;
+      }
+      periodMinLatencyUs_ = kUnknownLatency;
+      periodStartUs_ = nowUs;
+    }
+    periodMinLatencyUs_ = std::min(periodMinLatencyUs_, latencyUs);
+    minLatencyUs_ = std::min(minLatencyUs_, latencyUs);
+  }
+};
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
@@ -0,0 +1,111 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include "KeyPrefixStats.h"
+
+#include <folly/Bits.h>
+#include <folly/hash/SpookyHashV2.h>
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+namespace {
+
+void bump(std::atomic<uint64_t>& counter, uint64_t delta) {
+  counter.store(
+      counter.load(std::memory_order_relaxed) + delta,
+      std::memory_order_relaxed);
+}
+
+size_t numSlotsFor(const std::string& delimiter, size_t maxPrefixes) {
+  if (delimiter.empty() || maxPrefixes == 0) {
+    return 0;
+  }
+  // Keeps the table at most half full, so probe sequences stay short.
+  return folly::nextPowTwo(2 * maxPrefixes);
+}
+
+} // anonymous namespace
+
+void KeyPrefixStats::AtomicCounters::add(
+    uint64_t in,
+    uint64_t out,
+    folly::Optional<bool> hit,
+    uint64_t latency) {
+  bump(ops, 1);
+  bump(bytesIn, in);
+  bump(bytesOut, out);
+  if (hit.hasValue()) {
+    bump(*hit ? hits : misses, 1);
+  }
+  bump(latencyUs, latency);
+}
+
+KeyPrefixStats::Counters KeyPrefixStats::AtomicCounters::load() const {
+  Counters result;
+  result.ops = ops.load(std::memory_order_relaxed);
+  result.bytesIn = bytesIn.load(std::memory_order_relaxed);
+  result.bytesOut = bytesOut.load(std::memory_order_relaxed);
+  result.hits = hits.load(std::memory_order_relaxed);
+  result.misses = misses.load(std::memory_order_relaxed);
+  result.latencyUs = latencyUs.load(std::memory_order_relaxed);
+  return result;
+}
+
+KeyPrefixStats::KeyPrefixStats(std::string delimiter, size_t maxPrefixes)
+    : delimiter_(std::move(delimiter)),
+      maxPrefixes_(maxPrefixes),
+      numSlots_(numSlotsFor(delimiter_, maxPrefixes)),
+      slots_(numSlots_ ? new Slot[numSlots_] : nullptr) {}
+
+void KeyPrefixStats::record(
+    folly::StringPiece key,
+    uint64_t bytesIn,
+    uint64_t bytesOut,
+    folly::Optional<bool> hit,
+    uint64_t latencyUs) {
+  if (!enabled()) {
+    return;
+  }
+  const auto pos = key.find(delimiter_);
+  auto& counters = pos == folly::StringPiece::npos
+      ? overflow_
+      : findSlot(key.subpiece(0, pos));
+  counters.add(bytesIn, bytesOut, hit, latencyUs);
+}
+
+KeyPrefixStats::AtomicCounters& KeyPrefixStats::findSlot(
+    folly::StringPiece prefix) {
+  if (numSlots_ == 0) {
+    return overflow_;
+  }
+  const auto hash =
+      folly::hash::SpookyHashV2::Hash64(prefix.data(), prefix.size(), 0);
+  const auto mask = numSlots_ - 1;
+  for (size_t i = 0; i < kMaxProbes; ++i) {
+    auto& slot = slots_[(hash + i) & mask];
+    if (!slot.used.load(std::memory_order_relaxed)) {
+      if (numPrefixes_ >= maxPrefixes_) {
+        break;
+      }
+      slot.hash = hash;
+      slot.prefix = prefix.str();
+      slot.used.store(true, std::memory_order_release);
+      ++numPrefixes_;
+      return slot.counters;
+    }
+    if (slot.hash == hash && slot.prefix == prefix) {
+      return slot.counters;
+    }
+  }
+  return overflow_;
+}
+
+} // mcrouter
+} // memcache
+} // facebook
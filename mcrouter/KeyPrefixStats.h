@@ -0,0 +1,125 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <folly/Optional.h>
+#include <folly/Range.h>
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Request counters by key prefix (e.g. tenant), the part of the key before
+ * the first delimiter. Prefixes take slots of a fixed-size hash table as
+ * they are first seen, and keep them; requests whose key has no delimiter,
+ * or whose prefix doesn't find a slot, are counted in the overflow slot.
+ *
+ * record() must only be called from the owning proxy thread, it doesn't
+ * allocate once a prefix has its slot. foreach() may be called from any
+ * thread.
+ */
+class KeyPrefixStats {
+ public:
+  struct Counters {
+    uint64_t ops{0};
+    uint64_t bytesIn{0};
+    uint64_t bytesOut{0};
+    uint64_t hits{0};
+    uint64_t misses{0};
+    uint64_t latencyUs{0};
+  };
+
+  /**
+   * @param delimiter    empty disables the stats.
+   * @param maxPrefixes  number of prefixes tracked separately.
+   */
+  KeyPrefixStats(std::string delimiter, size_t maxPrefixes);
+
+  bool enabled() const {
+    return !delimiter_.empty();
+  }
+
+  /**
+   * @param hit  true for a hit, false for a miss, none for requests that
+   *             are neither (updates, errors).
+   */
+  void record(
+      folly::StringPiece key,
+      uint64_t bytesIn,
+      uint64_t bytesOut,
+      folly::Optional<bool> hit,
+      uint64_t latencyUs);
+
+  /**
+   * Calls func(prefix, const Counters&) for every prefix seen so far, then
+   * func("", const Counters&) for the overflow slot if it was used.
+   */
+  template <class Func>
+  void foreach(Func&& func) const {
+    for (size_t i = 0; i < numSlots_; ++i) {
+      const auto& slot = slots_[i];
+      if (slot.used.load(std::memory_order_acquire)) {
+        func(folly::StringPiece(slot.prefix), slot.counters.load());
+      }
+    }
+    auto overflow = overflow_.load();
+    if (overflow.ops != 0) {
+      func(folly::StringPiece(), overflow);
+    }
+  }
+
+ private:
+  // Written by the proxy thread only, relaxed atomics let other threads
+  // read them without tearing.
+  struct AtomicCounters {
+    std::atomic<uint64_t> ops{0};
+    std::atomic<uint64_t> bytesIn{0};
+    std::atomic<uint64_t> bytesOut{0};
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> latencyUs{0};
+
+    void add(
+        uint64_t in,
+        uint64_t out,
+        folly::Optional<bool> hit,
+        uint64_t latency);
+    Counters load() const;
+  };
+
+  struct Slot {
+    uint64_t hash{0};
+    // Set once, before `used` is published.
+    std::string prefix;
+    std::atomic<bool> used{false};
+    AtomicCounters counters;
+  };
+
+  // Slots probed for a prefix before giving up on it.
+  static constexpr size_t kMaxProbes = 8;
+
+  const std::string delimiter_;
+  const size_t maxPrefixes_;
+  const size_t numSlots_;
+  std::unique_ptr<Slot[]> slots_;
+  size_t numPrefixes_{0};
+  AtomicCounters overflow_;
+
+  AtomicCounters& findSlot(folly::StringPiece prefix);
+};
+
+} // mcrouter
+} // memcache
+} // facebook
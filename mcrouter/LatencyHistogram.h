@@ -0,0 +1,154 @@
+/*
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Log-linear histogram of latencies (in microseconds). Every power of two is
+ * split into 4 buckets, so percentiles are exact to within 25%.
+ *
+ * insertSample() may be called concurrently from any thread; counters are
+ * relaxed, so a reader racing with writers may miss a few samples.
+ */
+class LatencyHistogram {
+ public:
+  static constexpr size_t kNumBuckets = 128;
+
+  void insertSample(uint64_t latencyUs) {
+    buckets_[bucketIndex(latencyUs)].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /**
+   * @return number of samples recorded since the last reset().
+   */
+  uint64_t count() const {
+    uint64_t total = 0;
+    for (const auto& bucket : buckets_) {
+      total += bucket.load(std::memory_order_relaxed);
+    }
+    return total;
+  }
+
+  /**
+   * @param p  fraction of samples in (0, 1].
+   *
+   * @return lower bound of the bucket containing the p-th sample,
+   *         0 if there are no samples.
+   */
+  uint64_t percentile(double p) const {
+    std::array<uint64_t, kNumBuckets> counts;
+    uint64_t total = 0;
+    for (size_t i = 0; i < kNumBuckets; ++i) {
+      counts[i] = buckets_[i].load(std::memory_order_relaxed);
+      total += counts[i];
+    }
+    if (total == 0) {
+      return 0;
+    }
+    uint64_t rank = p * total;
+    if (rank == 0) {
+      rank = 1;
+    }
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kNumBuckets; ++i) {
+      seen += counts[i];
+      if (seen >= rank) {
+        return bucketLowerBound(i);
+      }
+    }
+    return bucketLowerBound(kNumBuckets - 1);
+  }
+
+  /**
+   * Halves every bucket, so that older samples weigh less than newer ones.
+   */
+  void decay() {
+    for (auto& bucket : buckets_) {
+      bucket.store(
+          bucket.load(std::memory_order_relaxed) / 2,
+          std::memory_order_relaxed);
+    }
+  }
+
+  void reset() {
+    for (auto& bucket : buckets_) {
+      bucket.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * Adds the samples of `other` to this histogram, e.g. to compute
+   * percentiles over the histograms of all proxies.
+   */
+  void merge(const LatencyHistogram& other) {
+    for (size_t i = 0; i < kNumBuckets; ++i) {
+      buckets_[i].fetch_add(
+          other.buckets_[i].load(std::memory_order_relaxed),
+          std::memory_order_relaxed);
+    }
+  }
+
+  static size_t bucketIndex(uint64_t latencyUs) {
+    if (latencyUs < 4) {
+      return latencyUs;
+    }
+    const size_t msb = 63 - __builtin_clzll(latencyUs);
+    const size_t idx = (msb - 1) * 4 + ((latencyUs >> (msb - 2)) & 3);
+    return idx < kNumBuckets ? idx : kNumBuckets - 1;
+  }
+
+  static uint64_t bucketLowerBound(size_t idx) {
+    if (idx < 4) {
+      return idx;
+    }
+    const size_t msb = idx / 4 + 1;
+    return (4 + idx % 4) << (msb - 2);
+  }
+
+ private:
+  std::array<std::atomic<uint64_t>, kNumBuckets> buckets_{};
+};
+
+/**
+ * LatencyHistogram that decays itself every kDecayPeriod samples, so that
+ * its percentiles follow recent traffic instead of the whole uptime.
+ *
+ * insertSample() must be called from a single thread, the histogram may be
+ * read from any thread.
+ */
+class RecentLatencyHistogram {
+ public:
+  static constexpr size_t kDecayPeriod = 1 << 14;
+
+  void insertSample(uint64_t latencyUs) {
+    histogram_.insertSample(latencyUs);
+    if (++numSamples_ % kDecayPeriod == 0) {
+      histogram_.decay();
+    }
+  }
+
+  const LatencyHistogram& histogram() const {
+    return histogram_;
+  }
+
+ private:
+  LatencyHistogram histogram_;
+  size_t numSamples_{0};
+};
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
@@ -7,6 +7,8 @@
  */
 #include "LeaseTokenMap.h"
 
+#include <atomic>
+
 #include <folly/Conv.h>
 
 namespace facebook {
@@ -33,6 +35,8 @@ std::string leaseTokenTimeoutFunctionName() {
 
 } // anonymous
 
+constexpr size_t LeaseTokenMap::kNumShards;
+
 LeaseTokenMap::LeaseTokenMap(
     const std::shared_ptr<folly::FunctionScheduler>& functionScheduler,
     std::chrono::milliseconds leaseTokenTtl,
@@ -57,16 +61,29 @@ LeaseTokenMap::~LeaseTokenMap() {
   }
 }
 
+size_t LeaseTokenMap::shardForThisThread() {
+  static std::atomic<size_t> nextShard(0);
+  static thread_local size_t shard =
+      nextShard.fetch_add(1, std::memory_order_relaxed) % kNumShards;
+  return shard;
+}
+
 uint64_t LeaseTokenMap::insert(std::string routeName, Item item) {
-  std::lock_guard<std::mutex> lock(mutex_);
+  const auto shardIdx = shardForThisThread();
+  auto& shard = shards_[shardIdx];
+  std::lock_guard<std::mutex> lock(shard.mutex);
+
+  // Expire as we go, so that busy shards don't wait for the cleanup timeout.
+  shard.expire(ListItem::Clock::now());
 
-  uint64_t specialToken = applyMagic(nextId_++);
+  const uint32_t id = shard.nextSeq++ * kNumShards + shardIdx;
+  uint64_t specialToken = applyMagic(id);
 
-  auto it = data_.emplace(
+  auto it = shard.data.emplace(
       specialToken,
       LeaseTokenMap::ListItem(
           specialToken, std::move(routeName), std::move(item), leaseTokenTtl_));
-  invalidationQueue_.push_back(it.first->second);
+  shard.invalidationQueue.push_back(it.first->second);
 
   return specialToken;
 }
@@ -81,11 +98,12 @@ folly::Optional<LeaseTokenMap::Item> LeaseTokenMap::query(
   }
 
   {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = data_.find(token);
-    if (it != data_.end() && it->second.routeName == routeName) {
+    auto& shard = shardFor(token);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.data.find(token);
+    if (it != shard.data.end() && it->second.routeName == routeName) {
       item.emplace(std::move(it->second.item));
-      data_.erase(it);
+      shard.data.erase(it);
     }
   }
 
@@ -100,29 +118,40 @@ uint64_t LeaseTokenMap::getOriginalLeaseToken(
   }
 
   {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = data_.find(token);
-    if (it != data_.end() && it->second.routeName == routeName) {
+    const auto& shard = shardFor(token);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.data.find(token);
+    if (it != shard.data.end() && it->second.routeName == routeName) {
       return it->second.item.originalToken;
     }
   }
   return token;
 }
 
+void LeaseTokenMap::Shard::expire(ListItem::TimePoint now) {
+  auto cur = invalidationQueue.begin();
+  while (cur != invalidationQueue.end() && cur->tokenTimeout <= now) {
+    uint64_t specialToken = cur->specialToken;
+    cur = invalidationQueue.erase(cur);
+    data.erase(specialToken);
+  }
+}
+
 void LeaseTokenMap::tokenCleanupTimeout() {
   const auto now = ListItem::Clock::now();
-  std::lock_guard<std::mutex> lock(mutex_);
-  auto cur = invalidationQueue_.begin();
-  while (cur != invalidationQueue_.end() && cur->tokenTimeout <= now) {
-    uint64_t specialToken = cur->specialToken;
-    cur = invalidationQueue_.erase(cur);
-    data_.erase(specialToken);
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.expire(now);
   }
 }
 
 size_t LeaseTokenMap::size() const {
-  std::lock_guard<std::mutex> lock(mutex_);
-  return data_.size();
+  size_t size = 0;
+  for (const auto& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    size += shard.data.size();
+  }
+  return size;
 }
 
 bool LeaseTokenMap::conflicts(uint64_t originalToken) {
@@ -7,7 +7,9 @@
  */
 #pragma once
 
+#include <array>
 #include <chrono>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <mutex>
@@ -29,6 +31,11 @@ namespace mcrouter {
 /**
  * Class responsible for mapping lease-tokens to destinations.
  * All operations are thread-safe.
+ *
+ * Tokens are spread over kNumShards independently locked shards. Every
+ * thread inserts into its own shard (proxies have a thread each), and the
+ * shard is encoded in the special token, so lease-gets of different proxies
+ * never contend, and a lease-set only locks the shard of its token.
  */
 class LeaseTokenMap {
  public:
@@ -107,6 +114,8 @@ class LeaseTokenMap {
    */
   static bool conflicts(uint64_t originalToken);
 
+  static constexpr size_t kNumShards = 16;
+
  private:
   struct ListItem {
     using Clock = std::chrono::steady_clock;
@@ -130,21 +139,37 @@ class LeaseTokenMap {
     folly::IntrusiveListHook listHook;
   };
 
-  // Hold the id of the next element to be inserted in the data structure.
-  uint32_t nextId_{0};
+  struct alignas(64) Shard {
+    // Hold the sequence number of the next element inserted in this shard.
+    uint32_t nextSeq{0};
+
+    // Underlying data structure.
+    std::unordered_map<uint64_t, ListItem> data;
+    // Keeps an in-order list of what should be invalidated. All tokens have
+    // the same TTL, so this is also the expiration order.
+    folly::IntrusiveList<ListItem, &ListItem::listHook> invalidationQueue;
+    // Mutex to synchronize access to the shard.
+    mutable std::mutex mutex;
 
-  // Underlying data structure.
-  std::unordered_map<uint64_t, ListItem> data_;
-  // Keeps an in-order list of what should be invalidated.
-  folly::IntrusiveList<ListItem, &ListItem::listHook> invalidationQueue_;
-  // Mutex to synchronize access to underlying data structure
-  mutable std::mutex mutex_;
+    // Removes expired tokens; must be called with mutex held.
+    void expire(ListItem::TimePoint now);
+  };
+
+  std::array<Shard, kNumShards> shards_;
 
   std::weak_ptr<folly::FunctionScheduler> functionScheduler_;
   const std::string timeoutFunctionName_;
   std::chrono::milliseconds leaseTokenTtl_;
 
   void tokenCleanupTimeout();
+
+  static size_t shardForThisThread();
+  Shard& shardFor(uint64_t specialToken) {
+    return shards_[specialToken % kNumShards];
+  }
+  const Shard& shardFor(uint64_t specialToken) const {
+    return shards_[specialToken % kNumShards];
+  }
 };
 
 } // mcrouter
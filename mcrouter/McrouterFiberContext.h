@@ -15,6 +15,7 @@
 #include <folly/fibers/FiberManager.h>
 
 #include "mcrouter/lib/network/ServerLoad.h"
+#include "mcrouter/stats.h"
 
 namespace facebook {
 namespace memcache {
@@ -23,6 +24,89 @@ namespace mcrouter {
 template <class RouterInfo>
 class ProxyRequestContextWithInfo;
 
+/**
+ * Owning pointer to a ProxyRequestContextWithInfo, like std::shared_ptr but
+ * with a non-atomic reference count kept in the context.
+ *
+ * Fiber locals are copied into every child fiber, so fan-out routes copy
+ * the request context once per child. All handles of a context live on its
+ * proxy thread, so they only need to share one std::shared_ptr (one atomic
+ * increment and decrement per request instead of per child fiber).
+ */
+template <class RouterInfo>
+class ProxyRequestContextHandle {
+ public:
+  using Context = ProxyRequestContextWithInfo<RouterInfo>;
+
+  ProxyRequestContextHandle() = default;
+
+  explicit ProxyRequestContextHandle(std::shared_ptr<Context> ctx)
+      : ctx_(ctx.get()) {
+    if (ctx_ && ctx_->numHandles_++ == 0) {
+      ctx_->handlesRef_ = std::move(ctx);
+    }
+  }
+
+  ProxyRequestContextHandle(const ProxyRequestContextHandle& other) noexcept
+      : ctx_(other.ctx_) {
+    if (ctx_) {
+      ++ctx_->numHandles_;
+    }
+  }
+
+  ProxyRequestContextHandle(ProxyRequestContextHandle&& other) noexcept
+      : ctx_(other.ctx_) {
+    other.ctx_ = nullptr;
+  }
+
+  ProxyRequestContextHandle& operator=(
+      const ProxyRequestContextHandle& other) noexcept {
+    return *this = ProxyRequestContextHandle(other);
+  }
+
+  ProxyRequestContextHandle& operator=(
+      ProxyRequestContextHandle&& other) noexcept {
+    if (this != &other) {
+      reset();
+      ctx_ = other.ctx_;
+      other.ctx_ = nullptr;
+    }
+    return *this;
+  }
+
+  ~ProxyRequestContextHandle() {
+    reset();
+  }
+
+  void reset() noexcept {
+    auto ctx = ctx_;
+    ctx_ = nullptr;
+    if (ctx && --ctx->numHandles_ == 0) {
+      // May destroy the context.
+      auto ref = std::move(ctx->handlesRef_);
+    }
+  }
+
+  Context* get() const noexcept {
+    return ctx_;
+  }
+
+  Context& operator*() const noexcept {
+    return *ctx_;
+  }
+
+  Context* operator->() const noexcept {
+    return ctx_;
+  }
+
+  explicit operator bool() const noexcept {
+    return ctx_ != nullptr;
+  }
+
+ private:
+  Context* ctx_{nullptr};
+};
+
 class RequestClass {
  public:
   static const RequestClass kFailover;
@@ -54,12 +138,14 @@ template <class RouterInfo>
 class fiber_local {
  private:
   struct McrouterFiberContext {
-    std::shared_ptr<ProxyRequestContextWithInfo<RouterInfo>> sharedCtx;
+    ProxyRequestContextHandle<RouterInfo> sharedCtx;
     folly::StringPiece asynclogName;
     ServerLoad load{0};
     RequestClass requestClass;
     bool failoverTag{false};
     bool failoverDisabled{false};
+    bool spilloverAllowed{false};
+    bool spilledOver{false};
   };
 
  public:
@@ -80,13 +166,17 @@ class fiber_local {
   }
 
   /**
-   * Copy all locals, run `f`, restore locals
+   * Copy all locals, run `f`, restore locals (except that a spillover in `f`
+   * is still reported, see setSpilledOver()).
    */
   template <class F>
   static typename std::result_of<F()>::type runWithLocals(F&& f) {
     auto tmp = folly::fibers::local<McrouterFiberContext>();
     auto guard = folly::makeGuard([&tmp]() mutable {
-      folly::fibers::local<McrouterFiberContext>() = std::move(tmp);
+      auto& local = folly::fibers::local<McrouterFiberContext>();
+      const bool spilledOver = local.spilledOver;
+      local = std::move(tmp);
+      local.spilledOver |= spilledOver;
     });
 
     return f();
@@ -98,15 +188,15 @@ class fiber_local {
    */
   static void setSharedCtx(
       std::shared_ptr<ProxyRequestContextWithInfo<RouterInfo>> ctx) {
-    folly::fibers::local<McrouterFiberContext>().sharedCtx = std::move(ctx);
+    folly::fibers::local<McrouterFiberContext>().sharedCtx =
+        ProxyRequestContextHandle<RouterInfo>(std::move(ctx));
   }
 
   /**
    * Get ProxyRequestContextWithInfo of current fiber (thread, if we're not on
    * fiber)
    */
-  static const std::shared_ptr<ProxyRequestContextWithInfo<RouterInfo>>&
-  getSharedCtx() {
+  static const ProxyRequestContextHandle<RouterInfo>& getSharedCtx() {
     return folly::fibers::local<McrouterFiberContext>().sharedCtx;
   }
 
@@ -186,6 +276,21 @@ class fiber_local {
     return folly::fibers::local<McrouterFiberContext>().failoverDisabled;
   }
 
+  /**
+   * @return  true iff the request of current fiber (thread, if we're not on
+   *          fiber) has a deadline and it has already passed. If so, also
+   *          bumps the deadline_exceeded_reqs stat, since the caller is
+   *          expected to skip some work.
+   */
+  static bool deadlineExceeded() {
+    auto& ctx = getSharedCtx();
+    if (ctx && ctx->deadlineExceeded()) {
+      ctx->proxy().stats().increment(deadline_exceeded_reqs_stat);
+      return true;
+    }
+    return false;
+  }
+
   static void setServerLoad(ServerLoad load) {
     folly::fibers::local<McrouterFiberContext>().load = load;
   }
@@ -193,6 +298,32 @@ class fiber_local {
   static ServerLoad getServerLoad() {
     return folly::fibers::local<McrouterFiberContext>().load;
   }
+
+  /**
+   * Set by routes that can send the request of current fiber (thread, if
+   * we're not on fiber) to another replica: destinations with a full queue
+   * then don't take it, and report a spillover instead.
+   */
+  static void setSpilloverAllowed(bool value) {
+    folly::fibers::local<McrouterFiberContext>().spilloverAllowed = value;
+  }
+
+  static bool getSpilloverAllowed() {
+    return folly::fibers::local<McrouterFiberContext>().spilloverAllowed;
+  }
+
+  /**
+   * Set by a destination that didn't take the request because of a
+   * spillover. The reply it returns is an error that the route which allowed
+   * the spillover is expected to replace with the reply of another replica.
+   */
+  static void setSpilledOver(bool value) {
+    folly::fibers::local<McrouterFiberContext>().spilledOver = value;
+  }
+
+  static bool getSpilledOver() {
+    return folly::fibers::local<McrouterFiberContext>().spilledOver;
+  }
 };
 
 } // mcrouter
@@ -25,6 +25,7 @@
 #include "mcrouter/McrouterLogFailure.h"
 #include "mcrouter/OptionsUtil.h"
 #include "mcrouter/ProxyBase.h"
+#include "mcrouter/StatsMmap.h"
 #include "mcrouter/config.h"
 #include "mcrouter/lib/fbi/cpp/util.h"
 #include "mcrouter/stats.h"
@@ -38,6 +39,7 @@ namespace {
 const char* kStatsSfx = "stats";
 const char* kStatsStartupOptionsSfx = "startup_options";
 const char* kConfigSourcesInfoFileName = "config_sources_info";
+const char* kStatsMmapSfx = "stats.mmap";
 
 std::string stats_file_path(
     const McrouterOptions& opts,
@@ -233,6 +235,7 @@ void McrouterLogger::log() {
   }
 
   write_stats_to_disk(router_.opts(), stats, requestStats);
+  logToMmap(stats);
   write_config_sources_info_to_disk(router_);
 
   for (const auto& filepath : touchStatsFilepaths_) {
@@ -244,6 +247,27 @@ void McrouterLogger::log() {
   }
 }
 
+void McrouterLogger::logToMmap(const std::vector<stat_t>& stats) {
+  if (!router_.opts().stats_mmap || statsMmapFailed_) {
+    return;
+  }
+  if (!statsMmap_) {
+    // Only the stats from stat_list.h, so that the layout never changes.
+    const std::vector<stat_t> fixedStats(
+        stats.begin(), stats.begin() + num_stats);
+    const auto path = stats_file_path(router_.opts(), kStatsMmapSfx);
+    try {
+      statsMmap_ = std::make_unique<StatsMmapWriter>(path, fixedStats);
+    } catch (const std::exception& e) {
+      LOG(ERROR) << "Failed to create " << path
+                 << ", disabling stats mmap: " << e.what();
+      statsMmapFailed_ = true;
+      return;
+    }
+  }
+  statsMmap_->write(stats);
+}
+
 } // mcrouter
 } // memcache
 } // facebook
@@ -20,6 +20,7 @@ namespace memcache {
 namespace mcrouter {
 
 class CarbonRouterInstanceBase;
+class StatsMmapWriter;
 struct stat_t;
 
 class AdditionalLoggerIf {
@@ -63,6 +64,9 @@ class McrouterLogger {
   std::unique_ptr<AdditionalLoggerIf> additionalLogger_;
 
   bool loggedStartupOptions_{false};
+  // Set if stats_mmap is enabled, created on the first log().
+  std::unique_ptr<StatsMmapWriter> statsMmap_;
+  bool statsMmapFailed_{false};
   // Name of the periodic function registered with the function scheduler.
   const std::string functionHandle_;
 
@@ -80,6 +84,11 @@ class McrouterLogger {
    * Writes startup options.
    */
   void logStartupOptions();
+
+  /**
+   * Publishes stats to the memory-mapped stats file, if enabled.
+   */
+  void logToMmap(const std::vector<stat_t>& stats);
 };
 }
 }
@@ -0,0 +1,20 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include "MemoryBudget.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+constexpr int64_t MemoryBudget::kBatchBytes;
+
+std::atomic<int64_t> MemoryBudget::used_{0};
+
+} // mcrouter
+} // memcache
+} // facebook
@@ -0,0 +1,66 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Bytes of requests and replies held by the proxies of this process, see
+ * proxy_memory_budget_mb.
+ *
+ * Every proxy owns one MemoryBudget and charges it from its own thread.
+ * Charges are published to the process-wide total in batches, so the total
+ * may be off by up to kBatchBytes per proxy.
+ */
+class MemoryBudget {
+ public:
+  static constexpr int64_t kBatchBytes = 64 * 1024;
+
+  MemoryBudget() = default;
+  ~MemoryBudget() {
+    publish();
+  }
+
+  /**
+   * @param bytes  negative to release bytes charged before.
+   */
+  void charge(int64_t bytes) {
+    unpublished_ += bytes;
+    if (unpublished_ >= kBatchBytes || unpublished_ <= -kBatchBytes) {
+      publish();
+    }
+  }
+
+  /**
+   * @return  Approximate number of bytes charged by all proxies.
+   */
+  static int64_t used() {
+    return used_.load(std::memory_order_relaxed);
+  }
+
+  MemoryBudget(const MemoryBudget&) = delete;
+  MemoryBudget& operator=(const MemoryBudget&) = delete;
+
+ private:
+  static std::atomic<int64_t> used_;
+  int64_t unpublished_{0};
+
+  void publish() {
+    used_.fetch_add(unpublished_, std::memory_order_relaxed);
+    unpublished_ = 0;
+  }
+};
+
+} // mcrouter
+} // memcache
+} // facebook
@@ -0,0 +1,110 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <deque>
+#include <unordered_map>
+#include <utility>
+
+#include <folly/Function.h>
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Sends the keys of ascii multigets at most window() at a time per
+ * multiget, holding the others back until earlier keys are replied. Keys
+ * are still sent in order.
+ *
+ * Replies may come back while a key is being sent (e.g. errors), i.e.
+ * onReplied may be called from within sendKey, which may then send further
+ * keys. The state of a multiget is dropped once none of its keys are
+ * in flight or held back.
+ *
+ * Not thread-safe, meant to be owned by a single proxy thread.
+ */
+class MultiGetPacer {
+ public:
+  // Sends one key, and calls onReplied once it is replied.
+  using SendKey = folly::Function<void(folly::Function<void()> onReplied)>;
+
+  /**
+   * @param window  current limit on the keys in flight per multiget.
+   */
+  explicit MultiGetPacer(folly::Function<size_t()> window)
+      : window_(std::move(window)) {}
+
+  /**
+   * Sends a key of multiget `multiGetId` right away if fewer than window()
+   * keys of it are in flight and none are held back, holds it back
+   * otherwise.
+   *
+   * @return false if the key was held back.
+   */
+  bool send(const void* multiGetId, SendKey sendKey) {
+    auto& multiGet = multiGets_[multiGetId];
+    if (!multiGet.deferred.empty() || multiGet.inflight >= window_()) {
+      multiGet.deferred.push_back(std::move(sendKey));
+      return false;
+    }
+    ++multiGet.inflight;
+    sendKey(onReplied(multiGetId));
+    return true;
+  }
+
+  /**
+   * @return number of multigets with keys in flight or held back.
+   */
+  size_t numMultiGets() const {
+    return multiGets_.size();
+  }
+
+ private:
+  struct MultiGetState {
+    size_t inflight{0};
+    std::deque<SendKey> deferred;
+  };
+
+  folly::Function<size_t()> window_;
+  std::unordered_map<const void*, MultiGetState> multiGets_;
+
+  folly::Function<void()> onReplied(const void* multiGetId) {
+    return [this, multiGetId]() {
+      auto it = multiGets_.find(multiGetId);
+      assert(it != multiGets_.end());
+      --it->second.inflight;
+      sendDeferred(multiGetId);
+    };
+  }
+
+  void sendDeferred(const void* multiGetId) {
+    const auto window = window_();
+    // Replies may come back before sendKey() returns, and drop the state of
+    // the multiget, so it is looked up every time.
+    auto it = multiGets_.find(multiGetId);
+    while (it != multiGets_.end() && !it->second.deferred.empty() &&
+           it->second.inflight < window) {
+      auto sendKey = std::move(it->second.deferred.front());
+      it->second.deferred.pop_front();
+      ++it->second.inflight;
+      sendKey(onReplied(multiGetId));
+      it = multiGets_.find(multiGetId);
+    }
+    if (it != multiGets_.end() && it->second.inflight == 0 &&
+        it->second.deferred.empty()) {
+      multiGets_.erase(it);
+    }
+  }
+};
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
@@ -7,6 +7,8 @@
  */
 #include <mutex>
 
+#include <folly/Likely.h>
+
 #include "mcrouter/lib/fbi/cpp/LogFailure.h"
 
 namespace facebook {
@@ -14,7 +16,8 @@ namespace memcache {
 namespace mcrouter {
 
 template <class Data>
-Observable<Data>::Observable(Data data) : data_(std::move(data)) {}
+Observable<Data>::Observable(Data data)
+    : data_(std::make_shared<const Data>(std::move(data))) {}
 
 template <class Data>
 typename Observable<Data>::CallbackHandle Observable<Data>::subscribe(
@@ -27,7 +30,7 @@ typename Observable<Data>::CallbackHandle Observable<Data>::subscribeAndCall(
     OnUpdateOldNew callback) {
   std::lock_guard<SFRReadLock> lck(dataLock_.readLock());
   try {
-    callback(Data(), data_);
+    callback(Data(), *data_);
   } catch (const std::exception& e) {
     LOG_FAILURE(
         "mcrouter",
@@ -46,16 +49,28 @@ typename Observable<Data>::CallbackHandle Observable<Data>::subscribeAndCall(
 template <class Data>
 Data Observable<Data>::get() {
   std::lock_guard<SFRReadLock> lck(dataLock_.readLock());
-  return data_;
+  return *data_;
+}
+
+template <class Data>
+const Data& Observable<Data>::snapshot() {
+  auto& local = *snapshots_;
+  if (UNLIKELY(local.version != version_.load(std::memory_order_acquire))) {
+    std::lock_guard<SFRReadLock> lck(dataLock_.readLock());
+    local.data = data_;
+    local.version = version_.load(std::memory_order_relaxed);
+  }
+  return *local.data;
 }
 
 template <class Data>
 void Observable<Data>::set(Data data) {
   std::lock_guard<SFRWriteLock> lck(dataLock_.writeLock());
   auto old = std::move(data_);
-  data_ = std::move(data);
+  data_ = std::make_shared<const Data>(std::move(data));
+  version_.fetch_add(1, std::memory_order_release);
   // no copy here, because old and data are passed by const reference
-  pool_.notify(old, data_);
+  pool_.notify(*old, *data_);
 }
 
 template <class Data>
@@ -7,7 +7,11 @@
  */
 #pragma once
 
+#include <atomic>
 #include <functional>
+#include <memory>
+
+#include <folly/ThreadLocal.h>
 
 #include "mcrouter/CallbackPool.h"
 #include "mcrouter/lib/fbi/cpp/sfrlock.h"
@@ -77,9 +81,30 @@ class Observable {
    */
   inline Data get();
 
+  /**
+   * Read path for hot code, e.g. per-request reads in routes.
+   *
+   * @return this thread's snapshot of stored data. Unless data changed since
+   *         the previous call on this thread, it takes no locks and touches
+   *         no reference counts shared with other threads. The reference
+   *         stays valid until the next snapshot() call on the same thread.
+   *
+   * NOTE: just like with RCU, old data is destroyed only once every thread
+   * that read it calls snapshot() again (or exits).
+   */
+  inline const Data& snapshot();
+
  private:
+  struct Snapshot {
+    uint64_t version{0};
+    std::shared_ptr<const Data> data;
+  };
+
   CallbackPool<const Data&, const Data&> pool_;
-  Data data_;
+  std::shared_ptr<const Data> data_;
+  // Incremented on every update of data_.
+  std::atomic<uint64_t> version_{1};
+  folly::ThreadLocal<Snapshot> snapshots_;
 
   SFRLock dataLock_;
 };
@@ -7,6 +7,8 @@
  */
 #pragma once
 
+#include <mutex>
+
 #include <folly/dynamic.h>
 #include <folly/experimental/StringKeyedUnorderedMap.h>
 
@@ -38,6 +40,7 @@ class PoolFactory {
 
   /**
    * Loads a pool from ConfigApi, expand `inherit`, etc.
+   * Thread-safe: proxies' route trees may be built concurrently.
    *
    * @param json pool json
    *
@@ -49,6 +52,9 @@ class PoolFactory {
   enum class PoolState { NEW, PARSING, PARSED };
   folly::StringKeyedUnorderedMap<std::pair<folly::dynamic, PoolState>> pools_;
   ConfigApiIf& configApi_;
+  // Protects pools_. Returned json references stay valid, since parsed
+  // pools are never modified again.
+  std::mutex mutex_;
 
   PoolJson parseNamedPool(folly::StringPiece name);
 };
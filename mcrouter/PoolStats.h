@@ -7,9 +7,16 @@
  */
 #pragma once
 
+#include <array>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include <folly/experimental/StringKeyedUnorderedMap.h>
 
 #include "mcrouter/ExponentialSmoothData.h"
+#include "mcrouter/LatencyHistogram.h"
 #include "mcrouter/stats.h"
 
 namespace facebook {
@@ -19,7 +26,8 @@ namespace mcrouter {
 class PoolStats {
  public:
   PoolStats(folly::StringPiece poolName)
-      : requestsCountStatName_(
+      : poolName_(poolName.str()),
+        requestsCountStatName_(
             folly::to<std::string>(poolName, ".requests.sum")),
         finalResultErrorStatName_(
             folly::to<std::string>(poolName, ".final_result_error.sum")),
@@ -29,6 +37,10 @@ class PoolStats {
             folly::to<std::string>(poolName, ".total_duration_us.avg")) {
     initStat(requestCountStat_, requestsCountStatName_);
     initStat(finalResultErrorStat_, finalResultErrorStatName_);
+    for (size_t i = 0; i < kNumPercentiles; ++i) {
+      totalDurationUsPercentileStatNames_[i] = folly::to<std::string>(
+          poolName, ".total_duration_us.", percentiles()[i].first);
+    }
   }
 
   std::vector<stat_t> getStats() const {
@@ -45,6 +57,23 @@ class PoolStats {
             std::move(totalDurationStat)};
   }
 
+  /**
+   * @param totalDurationUs  Total duration histogram of this pool, merged
+   *                         over all proxies.
+   *
+   * @return  total duration percentile stats of this pool.
+   */
+  std::vector<stat_t> getPercentileStats(
+      const LatencyHistogram& totalDurationUs) const {
+    std::vector<stat_t> stats(kNumPercentiles);
+    for (size_t i = 0; i < kNumPercentiles; ++i) {
+      initStat(stats[i], totalDurationUsPercentileStatNames_[i]);
+      stats[i].data.uint64 =
+          totalDurationUs.percentile(percentiles()[i].second);
+    }
+    return stats;
+  }
+
   void incrementRequestCount(uint64_t amount = 1) {
     requestCountStat_.data.uint64 += amount;
   }
@@ -59,9 +88,28 @@ class PoolStats {
 
   void addTotalDurationSample(int64_t duration) {
     totalDurationUsStat_.insertSample(duration);
+    totalDurationUsHistogram_->insertSample(duration);
+  }
+
+  const std::string& poolName() const {
+    return poolName_;
+  }
+
+  const RecentLatencyHistogram& totalDurationUs() const {
+    return *totalDurationUsHistogram_;
   }
 
  private:
+  static constexpr size_t kNumPercentiles = 4;
+
+  static const std::array<std::pair<const char*, double>, kNumPercentiles>&
+  percentiles() {
+    static const std::array<std::pair<const char*, double>, kNumPercentiles>
+        kPercentiles = {
+            {{"p50", 0.5}, {"p90", 0.9}, {"p99", 0.99}, {"p999", 0.999}}};
+    return kPercentiles;
+  }
+
   void initStat(stat_t& stat, folly::StringPiece name) const {
     stat.name = name;
     stat.group = ods_stats | count_stats;
@@ -70,14 +118,19 @@ class PoolStats {
     stat.data.uint64 = 0;
   }
 
+  const std::string poolName_;
   const std::string requestsCountStatName_;
   const std::string finalResultErrorStatName_;
   const std::string durationUsStatName_;
   const std::string totalDurationUsStatName_;
+  std::array<std::string, kNumPercentiles> totalDurationUsPercentileStatNames_;
   stat_t requestCountStat_;
   stat_t finalResultErrorStat_;
   ExponentialSmoothData<64> totalDurationUsStat_;
   ExponentialSmoothData<64> durationUsStat_;
+  // On the heap to keep PoolStats movable.
+  std::unique_ptr<RecentLatencyHistogram> totalDurationUsHistogram_{
+      std::make_unique<RecentLatencyHistogram>()};
 };
 
 } // namespace mcrouter
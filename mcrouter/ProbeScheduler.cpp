@@ -0,0 +1,108 @@
+/*
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include "ProbeScheduler.h"
+
+#include <algorithm>
+
+#include <folly/TokenBucket.h>
+
+#include "mcrouter/CarbonRouterInstanceBase.h"
+#include "mcrouter/McrouterLogFailure.h"
+#include "mcrouter/ProxyBase.h"
+#include "mcrouter/ProxyDestination.h"
+#include "mcrouter/stats.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+namespace {
+
+// 512 slots of 100ms cover the default probe_delay_max_ms in one turn.
+constexpr size_t kNumSlots = 512;
+
+} // anonymous namespace
+
+ProbeScheduler::ProbeScheduler(ProxyBase& proxy)
+    : proxy_(proxy),
+      tick_(std::max<uint32_t>(
+          1,
+          proxy.router().opts().probe_scheduler_tick_ms)),
+      slots_(kNumSlots),
+      timer_(folly::AsyncTimeout::make(proxy.eventBase(), [this]() noexcept {
+        timerScheduled_ = false;
+        onTick();
+      })) {}
+
+ProbeScheduler::~ProbeScheduler() = default;
+
+void ProbeScheduler::schedule(
+    const std::weak_ptr<ProxyDestination>& pdstn,
+    uint64_t probeId,
+    std::chrono::milliseconds delay) {
+  // Round up, so probes never fire early.
+  const size_t ticks = std::max<size_t>(
+      1, (delay.count() + tick_.count() - 1) / tick_.count());
+  insert(Entry{pdstn, probeId, 0}, ticks);
+}
+
+void ProbeScheduler::insert(Entry entry, size_t ticks) {
+  entry.rounds = (ticks - 1) / kNumSlots;
+  slots_[(currentSlot_ + ticks) % kNumSlots].push_back(std::move(entry));
+  ++size_;
+  scheduleTimer();
+}
+
+void ProbeScheduler::scheduleTimer() {
+  if (timerScheduled_ || size_ == 0) {
+    return;
+  }
+  if (!timer_->scheduleTimeout(tick_.count())) {
+    MC_LOG_FAILURE(
+        proxy_.router().opts(),
+        failure::Category::kSystemError,
+        "failed to schedule probe scheduler timer");
+    return;
+  }
+  timerScheduled_ = true;
+}
+
+void ProbeScheduler::onTick() {
+  currentSlot_ = (currentSlot_ + 1) % kNumSlots;
+
+  std::vector<Entry> slot;
+  slot.swap(slots_[currentSlot_]);
+  size_ -= slot.size();
+
+  auto* budget = proxy_.router().probeTokenBucket();
+  for (auto& entry : slot) {
+    if (entry.rounds > 0) {
+      --entry.rounds;
+      slots_[currentSlot_].push_back(std::move(entry));
+      ++size_;
+      continue;
+    }
+    auto pdstn = entry.pdstn.lock();
+    if (!pdstn || pdstn->probeId_ != entry.probeId) {
+      continue;
+    }
+    if (budget &&
+        !(*budget)->consume(1.0, folly::TokenBucket::defaultClockNow())) {
+      proxy_.stats().increment(probes_deferred_stat);
+      insert(std::move(entry), 1);
+      continue;
+    }
+    pdstn->onProbeTimer();
+  }
+
+  scheduleTimer();
+}
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
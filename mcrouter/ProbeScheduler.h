@@ -0,0 +1,91 @@
+/*
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <folly/io/async/AsyncTimeout.h>
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+class ProxyBase;
+class ProxyDestination;
+
+/**
+ * Schedules the TKO probes of all destinations of a proxy.
+ *
+ * A single timer drives a hashed timer wheel (probe_scheduler_tick_ms per
+ * slot), instead of every TKO destination arming its own timer. Probes that
+ * come due are sent subject to the router-wide max_probes_per_second budget;
+ * probes over the budget are pushed to the next tick, which also spreads out
+ * recoveries after a large outage.
+ *
+ * Only accessed from the proxy thread.
+ */
+class ProbeScheduler {
+ public:
+  explicit ProbeScheduler(ProxyBase& proxy);
+  ~ProbeScheduler();
+
+  ProbeScheduler(const ProbeScheduler&) = delete;
+  ProbeScheduler& operator=(const ProbeScheduler&) = delete;
+
+  /**
+   * @return a new probe id. A ProxyDestination takes a new id every time it
+   *         starts sending probes, which invalidates its old entries.
+   */
+  uint64_t nextProbeId() {
+    return ++lastProbeId_;
+  }
+
+  /**
+   * Schedules a probe of `pdstn` in `delay`. When it comes due (and there is
+   * budget), ProxyDestination::onProbeTimer() is called, unless `pdstn` is
+   * gone or its current probe id is not `probeId` anymore.
+   */
+  void schedule(
+      const std::weak_ptr<ProxyDestination>& pdstn,
+      uint64_t probeId,
+      std::chrono::milliseconds delay);
+
+  /**
+   * @return number of scheduled probes (including stale ones).
+   */
+  size_t size() const {
+    return size_;
+  }
+
+ private:
+  struct Entry {
+    std::weak_ptr<ProxyDestination> pdstn;
+    uint64_t probeId;
+    // Full turns of the wheel left before the entry is due.
+    size_t rounds;
+  };
+
+  ProxyBase& proxy_;
+  const std::chrono::milliseconds tick_;
+  std::vector<std::vector<Entry>> slots_;
+  size_t currentSlot_{0};
+  size_t size_{0};
+  uint64_t lastProbeId_{0};
+  std::unique_ptr<folly::AsyncTimeout> timer_;
+  bool timerScheduled_{false};
+
+  void insert(Entry entry, size_t ticks);
+  void onTick();
+  void scheduleTimer();
+};
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
@@ -5,12 +5,17 @@
  *  file in the root directory of this source tree.
  *
  */
+#include <algorithm>
+
 #include <folly/Range.h>
+#include <folly/ScopeGuard.h>
 #include <folly/fibers/EventBaseLoopController.h>
 
 #include "mcrouter/McrouterFiberContext.h"
 #include "mcrouter/ProxyRequestContextTyped.h"
+#include "mcrouter/ProxySchedulingObserver.h"
 #include "mcrouter/lib/MessageQueue.h"
+#include "mcrouter/lib/carbon/RequestReplyUtil.h"
 #include "mcrouter/lib/carbon/RoutingGroups.h"
 #include "mcrouter/lib/carbon/Stats.h"
 #include "mcrouter/lib/network/gen/Memcache.h"
@@ -43,6 +48,27 @@ bool processGetServiceInfoRequest(
   return true;
 }
 
+template <class RouterInfo, class Request>
+typename std::enable_if<Request::hasKey, void>::type recordRequestCpu(
+    Proxy<RouterInfo>& proxy,
+    const Request& req,
+    uint64_t cpuCycles) {
+  auto routingPrefix = req.key().routingPrefix();
+  if (routingPrefix.empty()) {
+    routingPrefix = proxy.getRouterOptions().default_route;
+  }
+  proxy.requestCpuStats().record(routingPrefix, Request::name, cpuCycles);
+}
+
+template <class RouterInfo, class Request>
+typename std::enable_if<!Request::hasKey, void>::type recordRequestCpu(
+    Proxy<RouterInfo>& proxy,
+    const Request&,
+    uint64_t cpuCycles) {
+  proxy.requestCpuStats().record(
+      proxy.getRouterOptions().default_route, Request::name, cpuCycles);
+}
+
 } // detail
 
 template <class RouterInfo>
@@ -56,14 +82,19 @@ template <class RouterInfo>
 template <class Request>
 void Proxy<RouterInfo>::WaitingRequest<Request>::process(
     Proxy<RouterInfo>* proxy) {
-  // timePushedOnQueue_ is nonnegative only if waiting-requests-timeout is
-  // enabled
+  // timePushedOnQueue_ is nonnegative only if waiting-requests-timeout or
+  // queue delay management is enabled
   if (timePushedOnQueue_ >= 0) {
-    const auto durationInQueueUs = nowUs() - timePushedOnQueue_;
-
-    if (durationInQueueUs >
-        1000 * static_cast<int64_t>(
-                   proxy->getRouterOptions().waiting_request_timeout_ms)) {
+    const auto& opts = proxy->getRouterOptions();
+    if (opts.proxy_max_throttled_requests > 0 &&
+        opts.waiting_request_timeout_ms > 0 &&
+        nowUs() - timePushedOnQueue_ >
+            1000 * static_cast<int64_t>(opts.waiting_request_timeout_ms)) {
+      ctx_->sendReply(mc_res_busy);
+      return;
+    }
+    if (proxy->shedQueueDelay(
+            proxy->waitingQueueCoDel_, ctx_->priority(), timePushedOnQueue_)) {
       ctx_->sendReply(mc_res_busy);
       return;
     }
@@ -72,6 +103,12 @@ void Proxy<RouterInfo>::WaitingRequest<Request>::process(
   proxy->processRequest(req_, std::move(ctx_));
 }
 
+template <class RouterInfo>
+template <class Request>
+void Proxy<RouterInfo>::WaitingRequest<Request>::reject() {
+  ctx_->sendReply(mc_res_busy);
+}
+
 template <class RouterInfo>
 template <class Request>
 typename std::enable_if_t<
@@ -82,9 +119,36 @@ Proxy<RouterInfo>::addRouteTask(
   requestStats_.template bump<Request>(carbon::RouterStatTypes::Incoming);
 
   auto funcCtx = sharedCtx;
+  const int64_t enqueuedUs =
+      router().opts().fiber_scheduling_stats ? nowUs() : 0;
 
-  fiberManager().addTaskFinally(
-      [&req, ctx = std::move(funcCtx)]() mutable {
+  // Requests that only wait on one reply can do with smaller stacks.
+  auto* fm = leafFiberManager();
+  if (!fm || !sharedCtx->proxyConfig().singleShotOnly()) {
+    fm = &fiberManager();
+  }
+  fm->addTaskFinally(
+      [&req, ctx = std::move(funcCtx), enqueuedUs]() mutable {
+        if (enqueuedUs != 0) {
+          const auto delayUs = nowUs() - enqueuedUs;
+          ctx->proxy().stats().fiberQueueDelayUs().insertSample(
+              delayUs > 0 ? delayUs : 0);
+        }
+        if (auto* timeline = ctx->timeline()) {
+          timeline->record(RequestTimeline::Event::RouteStart, nowUs());
+        }
+        auto& proxy = ctx->proxy();
+        uint64_t cpuCycles = 0;
+        auto* cpuObserver = proxy.requestCpuObserver();
+        if (cpuObserver) {
+          cpuObserver->chargeRunningFiber(&cpuCycles);
+        }
+        SCOPE_EXIT {
+          if (cpuObserver) {
+            cpuObserver->stopCharging();
+            detail::recordRequestCpu(proxy, req, cpuCycles);
+          }
+        };
         try {
           auto& proute = ctx->proxyRoute();
           fiber_local<RouterInfo>::setSharedCtx(std::move(ctx));
@@ -155,23 +219,34 @@ template <class Request>
 void Proxy<RouterInfo>::dispatchRequest(
     const Request& req,
     std::unique_ptr<ProxyRequestContextTyped<RouterInfo, Request>> ctx) {
+  if (shedQueueDelay(
+          clientQueueCoDel_, ctx->priority(), ctx->startDurationUs())) {
+    ctx->sendReply(mc_res_busy);
+    return;
+  }
+  if (!chargeMemoryBudget(req, *ctx)) {
+    ctx->sendReply(mc_res_busy);
+    return;
+  }
   if (rateLimited(ctx->priority(), req)) {
     if (getRouterOptions().proxy_max_throttled_requests > 0 &&
         numRequestsWaiting_ >=
-            getRouterOptions().proxy_max_throttled_requests) {
+            getRouterOptions().proxy_max_throttled_requests &&
+        !shedLowerPriorityRequest(ctx->priority())) {
       ctx->sendReply(mc_res_busy);
       return;
     }
     auto& queue = waitingRequests_[static_cast<int>(ctx->priority())];
+    auto senderId = ctx->senderId();
     auto w = std::make_unique<WaitingRequest<Request>>(req, std::move(ctx));
     // Only enable timeout on waitingRequests_ queue when queue throttling is
     // enabled
-    if (getRouterOptions().proxy_max_inflight_requests > 0 &&
-        getRouterOptions().proxy_max_throttled_requests > 0 &&
-        getRouterOptions().waiting_request_timeout_ms > 0) {
+    if ((getRouterOptions().proxy_max_throttled_requests > 0 &&
+         getRouterOptions().waiting_request_timeout_ms > 0) ||
+        getRouterOptions().queue_delay_target_us > 0) {
       w->setTimePushedOnQueue(nowUs());
     }
-    queue.pushBack(std::move(w));
+    queue.push(senderId, std::move(w));
     ++numRequestsWaiting_;
     stats().increment(proxy_reqs_waiting_stat);
   } else {
@@ -184,18 +259,32 @@ Proxy<RouterInfo>::Proxy(
     CarbonRouterInstanceBase& rtr,
     size_t id,
     folly::VirtualEventBase& evb)
-    : ProxyBase(rtr, id, evb, RouterInfo()) {
+    : ProxyBase(rtr, id, evb, RouterInfo()),
+      clientQueueCoDel_(
+          rtr.opts().queue_delay_target_us,
+          1000 * static_cast<int64_t>(rtr.opts().queue_delay_interval_ms)),
+      waitingQueueCoDel_(
+          rtr.opts().queue_delay_target_us,
+          1000 * static_cast<int64_t>(rtr.opts().queue_delay_interval_ms)) {
   messageQueue_ = std::make_unique<MessageQueue<ProxyMessage>>(
       router().opts().client_queue_size,
       [this](ProxyMessage&& message) {
+        if (message.type == ProxyMessage::Type::REQUEST) {
+          stats().increment(client_queue_requests_stat);
+        } else if (message.type == ProxyMessage::Type::REQUEST_BATCH) {
+          stats().increment(
+              client_queue_requests_stat,
+              reinterpret_cast<ProxyRequestBatch*>(message.data)->size());
+        }
         this->messageReady(message.type, message.data);
       },
       router().opts().client_queue_no_notify_rate,
       router().opts().client_queue_wait_threshold_us,
       &nowUs,
       [this]() { stats().incrementSafe(client_queue_notifications_stat); },
-      [this, noFlushLoops = 0](bool last) mutable {
-        bool haveTasks = fiberManager().runQueueSize() != 0;
+      [this, noFlushLoops = size_t(0)](bool last) mutable {
+        bool haveTasks = fiberManager().runQueueSize() != 0 ||
+            (leafFiberManager() && leafFiberManager()->runQueueSize() != 0);
         if (!last) {
           // If we have tasks in fiber manager, or we have pending flushes, then
           // we can guarantee that we won't block event loop.
@@ -203,7 +292,7 @@ Proxy<RouterInfo>::Proxy(
         }
         if (!flushList().empty() &&
             (!haveTasks ||
-             ++noFlushLoops >= router().opts().max_no_flush_event_loops)) {
+             ++noFlushLoops >= maxNoFlushEventLoops())) {
           noFlushLoops = 0;
           flushCallback_.setList(std::move(flushList()));
           eventBase().getEventBase().runInLoop(
@@ -227,6 +316,17 @@ Proxy<RouterInfo>* Proxy<RouterInfo>::createProxy(
     dynamic_cast<folly::fibers::EventBaseLoopController&>(
         proxyPtr->fiberManager().loopController())
         .attachEventBase(eventBase);
+    if (auto leafFm = proxyPtr->leafFiberManager()) {
+      dynamic_cast<folly::fibers::EventBaseLoopController&>(
+          leafFm->loopController())
+          .attachEventBase(eventBase);
+    }
+
+    proxyPtr->attachSchedulingObserver();
+    proxyPtr->bindNumaNode();
+    proxyPtr->bindJemallocArena();
+    proxyPtr->prefaultFiberStacks();
+    proxyPtr->startBusyPolling();
 
     std::chrono::milliseconds connectionResetInterval{
         proxyPtr->router().opts().reset_inactive_connection_interval};
@@ -306,6 +406,25 @@ void Proxy<RouterInfo>::messageReady(ProxyMessage::Type t, void* data) {
       preq->startProcessing();
     } break;
 
+    case ProxyMessage::Type::REQUEST_BATCH: {
+      std::unique_ptr<ProxyRequestBatch> batch(
+          reinterpret_cast<ProxyRequestBatch*>(data));
+      // Contexts were just written by the client thread, so they are
+      // likely in another core's cache: fetch a few ahead of the one being
+      // started.
+      constexpr size_t kPrefetchDistance = 4;
+      auto& reqs = *batch;
+      for (size_t i = 0; i < std::min(kPrefetchDistance, reqs.size()); ++i) {
+        __builtin_prefetch(reqs[i].get());
+      }
+      for (size_t i = 0; i < reqs.size(); ++i) {
+        if (i + kPrefetchDistance < reqs.size()) {
+          __builtin_prefetch(reqs[i + kPrefetchDistance].get());
+        }
+        reqs[i].release()->startProcessing();
+      }
+    } break;
+
     case ProxyMessage::Type::OLD_CONFIG: {
       auto oldConfig = reinterpret_cast<old_config_req_t<RouterInfo>*>(data);
       delete oldConfig;
@@ -369,7 +488,7 @@ void Proxy<RouterInfo>::pump() {
                router().opts().proxy_max_inflight_requests &&
            !queue.empty()) {
       --numRequestsWaiting_;
-      auto w = queue.popFront();
+      auto w = queue.pop();
       stats().decrement(proxy_reqs_waiting_stat);
 
       w->process(this);
@@ -377,6 +496,68 @@ void Proxy<RouterInfo>::pump() {
   }
 }
 
+template <class RouterInfo>
+bool Proxy<RouterInfo>::shedQueueDelay(
+    CoDel& codel,
+    ProxyRequestPriority priority,
+    int64_t enqueuedUs) {
+  if (getRouterOptions().queue_delay_target_us == 0) {
+    return false;
+  }
+  const auto now = nowUs();
+  if (!codel.shouldShed(priority, now - enqueuedUs, now)) {
+    return false;
+  }
+  stats().increment(proxy_reqs_codel_shed_stat);
+  return true;
+}
+
+template <class RouterInfo>
+bool Proxy<RouterInfo>::shedLowerPriorityRequest(
+    ProxyRequestPriority priority) {
+  auto numPriorities = static_cast<int>(ProxyRequestPriority::kNumPriorities);
+  for (int i = numPriorities - 1; i > static_cast<int>(priority); --i) {
+    auto& queue = waitingRequests_[i];
+    if (!queue.empty()) {
+      --numRequestsWaiting_;
+      auto w = queue.pop();
+      stats().decrement(proxy_reqs_waiting_stat);
+      stats().increment(proxy_reqs_shed_stat);
+
+      w->reject();
+      return true;
+    }
+  }
+  return false;
+}
+
+template <class RouterInfo>
+template <class Request>
+bool Proxy<RouterInfo>::chargeMemoryBudget(
+    const Request& req,
+    ProxyRequestContext& ctx) {
+  const auto& opts = getRouterOptions();
+  if (opts.proxy_memory_budget_mb == 0 || TNotRateLimited<Request>::value) {
+    return true;
+  }
+  int64_t bytes = req.key().fullKey().size();
+  if (const auto* value = carbon::valuePtrUnsafe(req)) {
+    bytes += value->computeChainDataLength();
+  }
+  const auto budget = static_cast<int64_t>(opts.proxy_memory_budget_mb) << 20;
+  const auto used = MemoryBudget::used();
+  if (used >= budget ||
+      (used >= budget / 5 * 4 &&
+       (ctx.priority() == ProxyRequestPriority::kAsync ||
+        bytes >= static_cast<int64_t>(
+                     opts.proxy_memory_budget_large_request_bytes)))) {
+    stats().increment(proxy_reqs_memory_shed_stat);
+    return false;
+  }
+  ctx.chargeMemory(bytes);
+  return true;
+}
+
 template <class RouterInfo>
 void proxy_config_swap(
     Proxy<RouterInfo>* proxy,
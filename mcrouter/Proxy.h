@@ -24,9 +24,11 @@
 #include <folly/Range.h>
 #include <folly/concurrency/CacheLocality.h>
 
+#include "mcrouter/CoDel.h"
 #include "mcrouter/ExponentialSmoothData.h"
 #include "mcrouter/ProxyBase.h"
 #include "mcrouter/ProxyRequestPriority.h"
+#include "mcrouter/SenderRoundRobinQueue.h"
 #include "mcrouter/config.h"
 #include "mcrouter/lib/carbon/Keys.h"
 #include "mcrouter/lib/mc/msg.h"
@@ -61,8 +63,14 @@ template <class RouterInfo, class Request>
 class ProxyRequestContextTyped;
 class ShardSplitter;
 
+/**
+ * Requests sent by one client in a single batch; travels through the proxy
+ * message queue as a single REQUEST_BATCH message.
+ */
+using ProxyRequestBatch = std::vector<std::unique_ptr<ProxyRequestContext>>;
+
 struct ProxyMessage {
-  enum class Type { REQUEST, OLD_CONFIG, SHUTDOWN };
+  enum class Type { REQUEST, REQUEST_BATCH, OLD_CONFIG, SHUTDOWN };
 
   Type type{Type::REQUEST};
   void* data{nullptr};
@@ -220,6 +228,11 @@ class Proxy : public ProxyBase {
      * (e.g. Operation and Request).
      */
     virtual void process(Proxy* proxy) = 0;
+
+    /**
+     * Reply to the request with an error without processing it.
+     */
+    virtual void reject() = 0;
   };
 
   template <class Request>
@@ -229,6 +242,7 @@ class Proxy : public ProxyBase {
         const Request& req,
         std::unique_ptr<ProxyRequestContextTyped<RouterInfo, Request>> ctx);
     void process(Proxy* proxy) final;
+    void reject() final;
     void setTimePushedOnQueue(int64_t now) {
       timePushedOnQueue_ = now;
     }
@@ -240,10 +254,46 @@ class Proxy : public ProxyBase {
     int64_t timePushedOnQueue_{-1};
   };
 
+  using WaitingRequestQueue =
+      SenderRoundRobinQueue<typename WaitingRequestBase::Queue>;
+
   /** Queue of requests we didn't start processing yet */
-  typename WaitingRequestBase::Queue
+  WaitingRequestQueue
       waitingRequests_[static_cast<int>(ProxyRequestPriority::kNumPriorities)];
 
+  /**
+   * Queue delay management (queue_delay_target_us) of the client queue
+   * (messageQueue_) and of waitingRequests_.
+   */
+  CoDel clientQueueCoDel_;
+  CoDel waitingQueueCoDel_;
+
+  /**
+   * @return  true iff the request has to be rejected instead of processed,
+   *          because it waited too long in an overloaded queue.
+   */
+  bool shedQueueDelay(
+      CoDel& codel,
+      ProxyRequestPriority priority,
+      int64_t enqueuedUs);
+
+  /**
+   * Makes room for one more waiting request of the given priority by
+   * rejecting a waiting request of lower priority.
+   *
+   * @return  true iff a request was rejected.
+   */
+  bool shedLowerPriorityRequest(ProxyRequestPriority priority);
+
+  /**
+   * Charges keys and value of the request against proxy_memory_budget_mb.
+   *
+   * @return  false iff the request has to be rejected instead, because the
+   *          process is (nearly) over its memory budget.
+   */
+  template <class Request>
+  bool chargeMemoryBudget(const Request& req, ProxyRequestContext& ctx);
+
   /** If true, we can't start processing this request right now */
   template <class Request>
   typename std::enable_if<TNotRateLimited<Request>::value, bool>::type
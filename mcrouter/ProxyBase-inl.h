@@ -27,18 +27,66 @@ ProxyBase::ProxyBase(
     : router_(rtr),
       id_(id),
       eventBase_(evb),
+      loopClock_(evb.getEventBase()),
       fiberManager_(
           typename fiber_local<RouterInfo>::ContextTypeTag(),
           std::make_unique<folly::fibers::EventBaseLoopController>(),
           getFiberManagerOptions(router_.opts())),
+      leafFiberManager_(makeLeafFiberManager<RouterInfo>(router_.opts())),
       asyncLog_(router_.opts()),
       stats_(router_.getStatsEnabledPools()),
+      hotKeyTracker_(
+          router_.opts().hot_key_sample_rate,
+          router_.opts().hot_key_top_k),
+      slowRequestTracer_(
+          router_.opts().slow_request_trace_threshold_us,
+          router_.opts().slow_request_trace_sample_rate,
+          router_.opts().slow_request_trace_buffer),
+      keyPrefixStats_(
+          router_.opts().key_prefix_stats_delimiter,
+          router_.opts().key_prefix_stats_max_prefixes),
+      requestSampleLog_(
+          router_,
+          [this]() { stats_.increment(request_samples_dropped_stat); }),
+      refillLimiter_(
+          getRefillLimiterOptions(router_.opts()),
+          [this](RefillLimiter::Result result) {
+            if (result == RefillLimiter::Result::Deduped) {
+              stats_.increment(refills_deduped_stat);
+            } else if (result == RefillLimiter::Result::Dropped) {
+              stats_.increment(refills_dropped_stat);
+            }
+          }),
       flushCallback_(*this),
       destinationMap_(std::make_unique<ProxyDestinationMap>(this)) {
   // Setup a full random seed sequence
   folly::Random::seed(randomGenerator_);
 
   statsContainer_ = std::make_unique<ProxyStatsContainer>(*this);
+
+  const auto& opts = router_.opts();
+  if (opts.multiget_max_inflight_keys > 0) {
+    incastWindow_ = std::make_unique<IncastWindow>(
+        opts.multiget_min_inflight_keys,
+        opts.multiget_max_inflight_keys,
+        opts.multiget_rxmit_threshold);
+  }
+}
+
+template <class RouterInfo>
+std::unique_ptr<folly::fibers::FiberManager> ProxyBase::makeLeafFiberManager(
+    const McrouterOptions& opts) {
+  if (opts.leaf_fibers_stack_size == 0 || opts.lazy_route_construction) {
+    return nullptr;
+  }
+  auto fmOpts = getFiberManagerOptions(opts);
+  fmOpts.stackSize = opts.leaf_fibers_stack_size;
+  // Only the main fiber manager's stacks are prefaulted.
+  fmOpts.fibersPoolResizePeriodMs = opts.fibers_pool_resize_period_ms;
+  return std::make_unique<folly::fibers::FiberManager>(
+      typename fiber_local<RouterInfo>::ContextTypeTag(),
+      std::make_unique<folly::fibers::EventBaseLoopController>(),
+      fmOpts);
 }
 
 } // mcrouter
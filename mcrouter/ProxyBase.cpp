@@ -7,15 +7,40 @@
  */
 #include "ProxyBase.h"
 
+#include <alloca.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include <folly/Bits.h>
+#include <folly/fibers/Baton.h>
+
 #include "mcrouter/CarbonRouterInstanceBase.h"
 #include "mcrouter/config-impl.h"
 #include "mcrouter/config.h"
 #include "mcrouter/options.h"
+#include "mcrouter/ProxySchedulingObserver.h"
+#include "mcrouter/ThreadUtil.h"
 
 namespace facebook {
 namespace memcache {
 namespace mcrouter {
 
+ProxyBase::~ProxyBase() {
+  if (schedulingObserver_) {
+    fiberManager_.setObserver(nullptr);
+    if (leafFiberManager_) {
+      leafFiberManager_->setObserver(nullptr);
+    }
+    auto& evb = eventBase_.getEventBase();
+    if (evb.getObserver() == schedulingObserver_) {
+      evb.setObserver(nullptr);
+    }
+  }
+}
+
 const McrouterOptions& ProxyBase::getRouterOptions() const {
   return router_.opts();
 }
@@ -27,10 +52,206 @@ folly::fibers::FiberManager::Options ProxyBase::getFiberManagerOptions(
   fmOpts.recordStackEvery = opts.fibers_record_stack_size_every;
   fmOpts.maxFibersPoolSize = opts.fibers_max_pool_size;
   fmOpts.useGuardPages = opts.fibers_use_guard_pages;
-  fmOpts.fibersPoolResizePeriodMs = opts.fibers_pool_resize_period_ms;
+  // Resizing the pool would free the prefaulted fibers once they have been
+  // idle for a period.
+  fmOpts.fibersPoolResizePeriodMs =
+      opts.fibers_prefault_stacks > 0 ? 0 : opts.fibers_pool_resize_period_ms;
   return fmOpts;
 }
 
+void ProxyBase::attachSchedulingObserver() {
+  const auto& opts = getRouterOptions();
+  // CPU time is measured with the cycle counter, only usable if it ticks at
+  // a constant rate.
+  chargeRequestCpu_ =
+      opts.request_cpu_stats && cycles::getCpuCyclesPerUs() != 0;
+  LOG_IF(WARNING, opts.request_cpu_stats && !chargeRequestCpu_)
+      << "request_cpu_stats: no constant rate CPU cycle counter, disabled";
+  if (!opts.fiber_scheduling_stats && !chargeRequestCpu_) {
+    return;
+  }
+  schedulingObserver_ = std::make_shared<ProxySchedulingObserver>(
+      stats_, opts.fiber_scheduling_stats, opts.slow_loop_threshold_us);
+  fiberManager_.setObserver(schedulingObserver_.get());
+  if (chargeRequestCpu_ && leafFiberManager_) {
+    leafFiberManager_->setObserver(schedulingObserver_.get());
+  }
+  auto& evb = eventBase_.getEventBase();
+  if (opts.fiber_scheduling_stats && !evb.getObserver()) {
+    evb.setObserver(schedulingObserver_);
+  }
+}
+
+void ProxyBase::bindNumaNode() {
+  if (!getRouterOptions().proxy_numa_spread) {
+    return;
+  }
+  const auto nodeCpus = getNumaNodeCpus();
+  // Node ids may be sparse, and memory-only nodes can't run threads.
+  const auto nodes = getNumaNodesWithCpus(nodeCpus);
+  if (nodes.size() < 2) {
+    return;
+  }
+  auto node = getThisThreadNumaNode(nodeCpus);
+  if (!node) {
+    node = nodes[getId() % nodes.size()];
+  }
+  if (bindThisThreadToNumaNode(*node, nodeCpus)) {
+    VLOG(1) << "Proxy " << getId() << " bound to NUMA node " << *node;
+  } else {
+    LOG(WARNING) << "Proxy " << getId() << " could not be bound to NUMA node "
+                 << *node;
+  }
+}
+
+void ProxyBase::bindJemallocArena() {
+  if (!getRouterOptions().proxy_jemalloc_arenas) {
+    return;
+  }
+  if (auto arena = bindThisThreadToNewJemallocArena()) {
+    jemallocArena_ = *arena;
+  }
+}
+
+namespace {
+
+// Stack space left for the frames of the fiber itself.
+constexpr size_t kPrefaultStackReserve = 4096;
+
+FOLLY_NOINLINE void touchStack(size_t bytes) {
+  auto stack = static_cast<volatile char*>(alloca(bytes));
+  const size_t pageSize = sysconf(_SC_PAGESIZE);
+  for (size_t i = 0; i < bytes; i += pageSize) {
+    stack[i] = 0;
+  }
+}
+
+} // anonymous namespace
+
+void ProxyBase::prefaultFiberStacks() {
+  const auto& opts = getRouterOptions();
+  const size_t numFibers =
+      std::min(opts.fibers_prefault_stacks, opts.fibers_max_pool_size);
+  if (numFibers == 0 || opts.fibers_stack_size <= kPrefaultStackReserve) {
+    return;
+  }
+  const size_t touchBytes = opts.fibers_stack_size - kPrefaultStackReserve;
+  // All fibers have to be alive at the same time to get different stacks.
+  // They go back to the pool once the last task wakes them up.
+  auto batons = std::make_shared<std::vector<folly::fibers::Baton>>(numFibers);
+  for (size_t i = 0; i < numFibers; ++i) {
+    fiberManager_.addTask([batons, i, touchBytes]() {
+      touchStack(touchBytes);
+      (*batons)[i].wait();
+    });
+  }
+  fiberManager_.addTask([batons]() {
+    for (auto& baton : *batons) {
+      baton.post();
+    }
+  });
+}
+
+void ProxyBase::startBusyPolling() {
+  const auto& opts = getRouterOptions();
+  if (opts.proxy_busy_poll_us == 0 ||
+      (opts.proxy_busy_poll_threads != 0 &&
+       getId() >= opts.proxy_busy_poll_threads)) {
+    return;
+  }
+  auto& evb = eventBase_.getEventBase();
+  if (evb.getExecutionObserver()) {
+    LOG(WARNING) << "Proxy " << getId() << " event base is already observed, "
+                 << "not busy polling";
+    return;
+  }
+  busyPoller_ = std::make_unique<BusyPoller>(
+      evb, std::chrono::microseconds(opts.proxy_busy_poll_us), stats_);
+}
+
+RefillLimiter::Options ProxyBase::getRefillLimiterOptions(
+    const McrouterOptions& opts) {
+  RefillLimiter::Options refillOpts;
+  refillOpts.dedupWindow =
+      std::chrono::milliseconds(opts.refill_dedup_window_ms);
+  refillOpts.maxRate = opts.refill_max_rate;
+  refillOpts.maxOutstanding = opts.refill_max_outstanding;
+  return refillOpts;
+}
+
+void ProxyBase::adjustTenantQueueDepth(
+    folly::StringPiece tenant,
+    int64_t delta) {
+  std::lock_guard<std::mutex> lock(tenantQueueDepthsMutex_);
+  auto it = tenantQueueDepths_.find(tenant.str());
+  if (it == tenantQueueDepths_.end()) {
+    it = tenantQueueDepths_.emplace(tenant.str(), 0).first;
+  }
+  it->second += delta;
+  if (it->second == 0) {
+    tenantQueueDepths_.erase(it);
+  }
+}
+
+std::unordered_map<std::string, size_t> ProxyBase::tenantQueueDepths() const {
+  std::lock_guard<std::mutex> lock(tenantQueueDepthsMutex_);
+  return tenantQueueDepths_;
+}
+
+double ProxyBase::pressure() const {
+  if (numRequestsWaiting_ > 0) {
+    return 1.0;
+  }
+  const auto& opts = getRouterOptions();
+  double p = 0.0;
+  if (opts.proxy_max_inflight_requests > 0) {
+    p = static_cast<double>(numRequestsProcessing_) /
+        opts.proxy_max_inflight_requests;
+  }
+  if (opts.shadow_shed_fibers > 0) {
+    auto fibersInUse =
+        fiberManager_.fibersAllocated() - fiberManager_.fibersPoolSize();
+    if (leafFiberManager_) {
+      fibersInUse += leafFiberManager_->fibersAllocated() -
+          leafFiberManager_->fibersPoolSize();
+    }
+    p = std::max(p, static_cast<double>(fibersInUse) / opts.shadow_shed_fibers);
+  }
+  return std::min(p, 1.0);
+}
+
+bool ProxyBase::shouldShedShadowRequest() {
+  if (!getRouterOptions().shadow_load_shedding) {
+    return false;
+  }
+  auto shedRatio = std::max(0.0, pressure() * 2 - 1);
+  if (shedRatio == 0.0) {
+    return false;
+  }
+  if (shedRatio < 1.0 &&
+      std::uniform_real_distribution<double>(0.0, 1.0)(randomGenerator_) >=
+          shedRatio) {
+    return false;
+  }
+  stats_.increment(shadow_requests_shed_stat);
+  return true;
+}
+
+size_t ProxyBase::maxNoFlushEventLoops() const {
+  const auto& opts = getRouterOptions();
+  const size_t maxLoops = std::max(opts.max_no_flush_event_loops, 0);
+  if (!opts.adaptive_flush) {
+    return maxLoops;
+  }
+  // Waiting for one more loop only pays off if it lets more requests join the
+  // same writes, i.e. if batches are already big at the current delay.
+  const auto avgBatchSize =
+      static_cast<uint64_t>(avgDestinationBatchSize_.value());
+  const size_t loops =
+      avgBatchSize < 2 ? 0 : folly::findLastSet(avgBatchSize) - 1;
+  return std::min(loops, maxLoops);
+}
+
 void ProxyBase::FlushCallback::runLoopCallback() noexcept {
   // Always reschedlue until the end of event loop.
   if (!rescheduled_) {
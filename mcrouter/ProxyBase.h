@@ -7,17 +7,34 @@
  */
 #pragma once
 
+#include <atomic>
 #include <cassert>
 #include <cstddef>
+#include <mutex>
 #include <random>
+#include <string>
+#include <unordered_map>
 
+#include <folly/Range.h>
 #include <folly/dynamic.h>
 #include <folly/fibers/FiberManager.h>
 #include <folly/io/async/VirtualEventBase.h>
 
 #include "mcrouter/AsyncLog.h"
+#include "mcrouter/BusyPoller.h"
+#include "mcrouter/ExponentialSmoothData.h"
+#include "mcrouter/HotKeyTracker.h"
+#include "mcrouter/IncastWindow.h"
+#include "mcrouter/KeyPrefixStats.h"
+#include "mcrouter/MemoryBudget.h"
 #include "mcrouter/ProxyStats.h"
+#include "mcrouter/RequestCpuStats.h"
+#include "mcrouter/RequestSampleLog.h"
+#include "mcrouter/RouteStats.h"
+#include "mcrouter/SlowRequestTracer.h"
 #include "mcrouter/config.h"
+#include "mcrouter/lib/Clocks.h"
+#include "mcrouter/lib/RefillLimiter.h"
 
 namespace facebook {
 namespace memcache {
@@ -28,6 +45,7 @@ namespace mcrouter {
 
 class CarbonRouterInstanceBase;
 class ProxyDestinationMap;
+class ProxySchedulingObserver;
 
 class ProxyBase {
  public:
@@ -42,7 +60,7 @@ class ProxyBase {
       folly::VirtualEventBase& evb,
       RouterInfo tag);
 
-  virtual ~ProxyBase() = default;
+  virtual ~ProxyBase();
 
   const CarbonRouterInstanceBase& router() const {
     return router_;
@@ -70,6 +88,23 @@ class ProxyBase {
     return fiberManager_;
   }
 
+  /**
+   * nowUs(), read at most once per iteration of the proxy event loop.
+   * For deadlines and other timestamps that don't need to be precise.
+   * Must be called from the proxy thread.
+   */
+  int64_t loopNowUs() noexcept {
+    return loopClock_.nowUs();
+  }
+
+  /**
+   * Fiber manager with leaf_fibers_stack_size stacks, for requests routed
+   * by configs with single-shot routes only. nullptr if not enabled.
+   */
+  folly::fibers::FiberManager* leafFiberManager() {
+    return leafFiberManager_.get();
+  }
+
   ProxyDestinationMap* destinationMap() {
     return destinationMap_.get();
   }
@@ -93,6 +128,112 @@ class ProxyBase {
     return statsContainer_.get();
   }
 
+  /**
+   * Stats of the route handles configured with "instrument": true.
+   */
+  RouteStatsMap& routeStats() {
+    return routeStats_;
+  }
+  const RouteStatsMap& routeStats() const {
+    return routeStats_;
+  }
+
+  RequestSampleLog& requestSampleLog() {
+    return requestSampleLog_;
+  }
+
+  MemoryBudget& memoryBudget() {
+    return memoryBudget_;
+  }
+
+  HotKeyTracker& hotKeyTracker() {
+    return hotKeyTracker_;
+  }
+  const HotKeyTracker& hotKeyTracker() const {
+    return hotKeyTracker_;
+  }
+
+  SlowRequestTracer& slowRequestTracer() {
+    return slowRequestTracer_;
+  }
+  const SlowRequestTracer& slowRequestTracer() const {
+    return slowRequestTracer_;
+  }
+
+  KeyPrefixStats& keyPrefixStats() {
+    return keyPrefixStats_;
+  }
+  const KeyPrefixStats& keyPrefixStats() const {
+    return keyPrefixStats_;
+  }
+
+  RequestCpuStats& requestCpuStats() {
+    return requestCpuStats_;
+  }
+  const RequestCpuStats& requestCpuStats() const {
+    return requestCpuStats_;
+  }
+
+  /**
+   * @return  observer measuring the CPU time of request fibers, nullptr
+   *          unless request_cpu_stats is enabled (and the CPU cycle counter
+   *          is usable). Must be called from the proxy thread.
+   */
+  ProxySchedulingObserver* requestCpuObserver() {
+    return chargeRequestCpu_ ? schedulingObserver_.get() : nullptr;
+  }
+
+  /**
+   * @return  Index of the jemalloc arena the proxy thread allocates from,
+   *          -1 unless proxy_jemalloc_arenas is enabled. Thread-safe.
+   */
+  int jemallocArena() const {
+    return jemallocArena_;
+  }
+
+  /**
+   * Limits asynchronous cache refills sent by the routes of this proxy.
+   */
+  RefillLimiter& refillLimiter() {
+    return refillLimiter_;
+  }
+
+  /**
+   * @return  limit on keys of one client multiget routed at a time, nullptr
+   *          unless multiget_max_inflight_keys is set. Must be called from
+   *          the proxy thread.
+   */
+  IncastWindow* incastWindow() {
+    return incastWindow_.get();
+  }
+
+  /**
+   * Adjusts the number of requests of the given tenant (client identity)
+   * blocked in OutstandingLimitRoutes of this proxy.
+   */
+  void adjustTenantQueueDepth(folly::StringPiece tenant, int64_t delta);
+
+  /**
+   * @return  Number of requests blocked in OutstandingLimitRoutes of this
+   *          proxy, by tenant. Thread-safe.
+   */
+  std::unordered_map<std::string, size_t> tenantQueueDepths() const;
+
+  /**
+   * @return  A number in [0, 1] estimating how close this proxy is to being
+   *          overloaded: 1 if there are requests waiting to be processed,
+   *          otherwise the highest utilization of proxy_max_inflight_requests
+   *          and shadow_shed_fibers (whichever are set).
+   */
+  double pressure() const;
+
+  /**
+   * Decides if a shadow request should be dropped because of the proxy
+   * pressure. Shadow traffic is scaled down linearly as the pressure goes
+   * from 0.5 to 1.
+   */
+  bool shouldShedShadowRequest();
+
   /** Will let through requests from the above queue if we have capacity */
   virtual void pump() = 0;
 
@@ -110,12 +251,32 @@ class ProxyBase {
     return flushList_;
   }
 
+  /**
+   * Called every time one of the destinations of this proxy writes a batch
+   * of numRequests requests.
+   */
+  void onDestinationBatch(size_t numRequests) {
+    avgDestinationBatchSize_.insertSample(numRequests);
+  }
+
+  /**
+   * @return  Number of event loops that batched requests may wait for before
+   *          they are flushed, while there are fibers ready to run.
+   *          max_no_flush_event_loops, or with adaptive_flush one loop per
+   *          doubling of the recent average batch size (capped by
+   *          max_no_flush_event_loops), so that a proxy whose batches don't
+   *          grow when flushes are delayed doesn't delay them.
+   */
+  size_t maxNoFlushEventLoops() const;
+
  private:
   CarbonRouterInstanceBase& router_;
   const size_t id_{0};
 
   folly::VirtualEventBase& eventBase_;
+  cycles::LoopCachedClock loopClock_;
   folly::fibers::FiberManager fiberManager_;
+  std::unique_ptr<folly::fibers::FiberManager> leafFiberManager_;
 
   AsyncLog asyncLog_;
 
@@ -124,9 +285,39 @@ class ProxyBase {
   ProxyStats stats_;
   std::unique_ptr<ProxyStatsContainer> statsContainer_;
 
+  HotKeyTracker hotKeyTracker_;
+
+  SlowRequestTracer slowRequestTracer_;
+
+  KeyPrefixStats keyPrefixStats_;
+
+  RequestCpuStats requestCpuStats_;
+
+  RequestSampleLog requestSampleLog_;
+
+  MemoryBudget memoryBudget_;
+
+  RouteStatsMap routeStats_;
+
+  RefillLimiter refillLimiter_;
+
+  std::unique_ptr<IncastWindow> incastWindow_;
+
+  ExponentialSmoothData<64> avgDestinationBatchSize_;
+
+  mutable std::mutex tenantQueueDepthsMutex_;
+  std::unordered_map<std::string, size_t> tenantQueueDepths_;
+
   static folly::fibers::FiberManager::Options getFiberManagerOptions(
       const McrouterOptions& opts);
 
+  template <class RouterInfo>
+  static std::unique_ptr<folly::fibers::FiberManager> makeLeafFiberManager(
+      const McrouterOptions& opts);
+
+  static RefillLimiter::Options getRefillLimiterOptions(
+      const McrouterOptions& opts);
+
  protected:
   // A queue of callbacks for flushing requests in AsyncMcClients.
   FlushList flushList_;
@@ -147,6 +338,49 @@ class ProxyBase {
 
   std::unique_ptr<ProxyDestinationMap> destinationMap_;
 
+  // Set with fiber_scheduling_stats or request_cpu_stats.
+  std::shared_ptr<ProxySchedulingObserver> schedulingObserver_;
+  bool chargeRequestCpu_{false};
+
+  // Set with proxy_busy_poll_us.
+  std::unique_ptr<BusyPoller> busyPoller_;
+
+  std::atomic<int> jemallocArena_{-1};
+
+  /**
+   * Starts recording fiber scheduling stats, if fiber_scheduling_stats is
+   * enabled, and measuring the CPU time of requests, if request_cpu_stats is
+   * enabled. Must be called from the proxy thread.
+   * Event loop times are only recorded if nobody else observes the event base.
+   */
+  void attachSchedulingObserver();
+
+  /**
+   * Binds the proxy thread to a NUMA node, if proxy_numa_spread is enabled.
+   * Must be called from the proxy thread.
+   */
+  void bindNumaNode();
+
+  /**
+   * Makes the proxy thread allocate from its own jemalloc arena, if
+   * proxy_jemalloc_arenas is enabled. Must be called from the proxy thread.
+   */
+  void bindJemallocArena();
+
+  /**
+   * Fills the fiber pool with fibers_prefault_stacks fibers whose stacks
+   * are already paged in. The pool is then never resized, see
+   * getFiberManagerOptions(). Must be called from the proxy thread.
+   */
+  void prefaultFiberStacks();
+
+  /**
+   * Starts busy polling the event loop, if proxy_busy_poll_us is set and
+   * this proxy is one of proxy_busy_poll_threads.
+   * Must be called from the proxy thread.
+   */
+  void startBusyPolling();
+
   /**
    * Incoming request rate limiting.
    *
@@ -11,10 +11,13 @@
 #include <folly/dynamic.h>
 #include <folly/json.h>
 
+#include "mcrouter/McrouterLogFailure.h"
 #include "mcrouter/PoolFactory.h"
 #include "mcrouter/Proxy.h"
 #include "mcrouter/lib/config/RouteHandleFactory.h"
 #include "mcrouter/lib/fbi/cpp/util.h"
+#include "mcrouter/routes/ErrorRoute.h"
+#include "mcrouter/routes/LazyRoute.h"
 #include "mcrouter/routes/McRouteHandleProvider.h"
 #include "mcrouter/routes/PrefixSelectorRoute.h"
 #include "mcrouter/routes/ProxyRoute.h"
@@ -24,16 +27,86 @@ namespace facebook {
 namespace memcache {
 namespace mcrouter {
 
+template <class RouterInfo>
+struct ProxyConfig<RouterInfo>::LazyRouteBuilder {
+  LazyRouteBuilder(
+      Proxy<RouterInfo>& proxy,
+      std::shared_ptr<const folly::dynamic> json_,
+      std::shared_ptr<PoolFactory> poolFactory_)
+      : json(std::move(json_)),
+        poolFactory(std::move(poolFactory_)),
+        provider(proxy, *poolFactory),
+        factory(provider, proxy.getId()) {}
+
+  // Lazy routes reference their json in here.
+  const std::shared_ptr<const folly::dynamic> json;
+  const std::shared_ptr<PoolFactory> poolFactory;
+  McRouteHandleProvider<RouterInfo> provider;
+  RouteHandleFactory<typename RouterInfo::RouteHandleIf> factory;
+  typename LazyRoute<RouterInfo>::Create create;
+};
+
 template <class RouterInfo>
 ProxyConfig<RouterInfo>::ProxyConfig(
     Proxy<RouterInfo>& proxy,
-    const folly::dynamic& json,
+    std::shared_ptr<const folly::dynamic> jsonPtr,
     std::string configMd5Digest,
-    PoolFactory& poolFactory)
+    std::shared_ptr<PoolFactory> poolFactory)
     : configMd5Digest_(std::move(configMd5Digest)) {
-  McRouteHandleProvider<RouterInfo> provider(proxy, poolFactory);
-  RouteHandleFactory<typename RouterInfo::RouteHandleIf> factory(
-      provider, proxy.getId());
+  using RouteHandleIf = typename RouterInfo::RouteHandleIf;
+
+  const auto& json = *jsonPtr;
+  std::unique_ptr<McRouteHandleProvider<RouterInfo>> eagerProvider;
+  std::unique_ptr<RouteHandleFactory<RouteHandleIf>> eagerFactory;
+  std::shared_ptr<ProxyConfig<RouterInfo>> previous;
+  if (proxy.getRouterOptions().lazy_route_construction) {
+    lazyRouteBuilder_ = std::make_unique<LazyRouteBuilder>(
+        proxy, std::move(jsonPtr), std::move(poolFactory));
+    lazyRouteBuilder_->create = [this, &proxy](const folly::dynamic& jRoute) {
+      std::shared_ptr<RouteHandleIf> route;
+      try {
+        route = lazyRouteBuilder_->factory.create(jRoute);
+      } catch (const std::exception& e) {
+        MC_LOG_FAILURE(
+            proxy.getRouterOptions(),
+            memcache::failure::Category::kInvalidConfig,
+            "Failed to build route on first use: {}",
+            e.what());
+        route = createErrorRoute<RouterInfo>("Failed to build route");
+      }
+      proxy.stats().increment(route_subtrees_materialized_stat);
+      return route;
+    };
+  } else {
+    eagerProvider = std::make_unique<McRouteHandleProvider<RouterInfo>>(
+        proxy, *poolFactory);
+    // Configs are only swapped by the thread building them, after the build:
+    // the proxy keeps its reference to the previous one until then, so ours
+    // is never the last one. Lazy configs don't reuse routes, since they keep
+    // building them after that.
+    if (proxy.getRouterOptions().reuse_unchanged_routes) {
+      previous = proxy.getConfigUnsafe();
+      if (previous) {
+        eagerProvider->setPreviousPoolRoutes(&previous->poolRoutes_);
+      }
+    }
+    eagerFactory = std::make_unique<RouteHandleFactory<RouteHandleIf>>(
+        *eagerProvider, proxy.getId());
+  }
+  auto& provider =
+      lazyRouteBuilder_ ? lazyRouteBuilder_->provider : *eagerProvider;
+  auto& factory =
+      lazyRouteBuilder_ ? lazyRouteBuilder_->factory : *eagerFactory;
+  auto makeRouteSelector = [this, &factory](const folly::dynamic& jRoute) {
+    if (!lazyRouteBuilder_) {
+      return std::make_shared<PrefixSelectorRoute<RouteHandleIf>>(
+          factory, jRoute);
+    }
+    return std::make_shared<PrefixSelectorRoute<RouteHandleIf>>(
+        jRoute, [this](const folly::dynamic& jPolicy) {
+          return makeLazyRoute<RouterInfo>(jPolicy, lazyRouteBuilder_->create);
+        });
+  };
 
   checkLogic(json.isObject(), "Config is not an object");
 
@@ -61,9 +134,8 @@ ProxyConfig<RouterInfo>::ProxyConfig(
       !jRoute || !jRoutes,
       "Invalid config: both 'route' and 'routes' are specified");
   if (jRoute) {
-    routeSelectors[proxy.getRouterOptions().default_route] = std::make_shared<
-        PrefixSelectorRoute<typename RouterInfo::RouteHandleIf>>(
-        factory, *jRoute);
+    routeSelectors[proxy.getRouterOptions().default_route] =
+        makeRouteSelector(*jRoute);
   } else if (jRoutes) { // jRoutes
     checkLogic(
         jRoutes->isArray() || jRoutes->isObject(),
@@ -76,9 +148,7 @@ ProxyConfig<RouterInfo>::ProxyConfig(
         checkLogic(jCurRoute, "RoutePolicy: no route");
         checkLogic(jAliases, "RoutePolicy: no aliases");
         checkLogic(jAliases->isArray(), "RoutePolicy: aliases is not an array");
-        auto routeSelector = std::make_shared<
-            PrefixSelectorRoute<typename RouterInfo::RouteHandleIf>>(
-            factory, *jCurRoute);
+        auto routeSelector = makeRouteSelector(*jCurRoute);
         for (const auto& alias : *jAliases) {
           checkLogic(alias.isString(), "RoutePolicy: alias is not a string");
           routeSelectors[alias.stringPiece()] = routeSelector;
@@ -87,18 +157,24 @@ ProxyConfig<RouterInfo>::ProxyConfig(
     } else { // object
       for (const auto& it : jRoutes->items()) {
         checkLogic(it.first.isString(), "RoutePolicy: alias is not a string");
-        routeSelectors[it.first.stringPiece()] = std::make_shared<
-            PrefixSelectorRoute<typename RouterInfo::RouteHandleIf>>(
-            factory, it.second);
+        routeSelectors[it.first.stringPiece()] = makeRouteSelector(it.second);
       }
     }
   } else {
     throwLogic("No route/routes in config");
   }
 
-  asyncLogRoutes_ = provider.releaseAsyncLogRoutes();
-  pools_ = provider.releasePools();
-  accessPoints_ = provider.releaseAccessPoints();
+  // Lazy configs keep everything in the provider, which keeps adding to it.
+  if (!lazyRouteBuilder_) {
+    asyncLogRoutes_ = provider.releaseAsyncLogRoutes();
+    pools_ = provider.releasePools();
+    accessPoints_ = provider.releaseAccessPoints();
+    destinations_ = provider.releaseDestinations();
+    poolNames_ = provider.releasePoolNames();
+    poolRoutes_ = provider.releasePoolRoutes();
+    numReusedPoolRoutes_ = provider.numReusedPoolRoutes();
+    singleShotOnly_ = provider.singleShotOnly();
+  }
   proxyRoute_ = std::make_shared<ProxyRoute<RouterInfo>>(proxy, routeSelectors);
   serviceInfo_ = std::make_shared<ServiceInfo<RouterInfo>>(proxy, *this);
 }
@@ -107,13 +183,38 @@ template <class RouterInfo>
 std::shared_ptr<typename RouterInfo::RouteHandleIf>
 ProxyConfig<RouterInfo>::getRouteHandleForAsyncLog(
     folly::StringPiece asyncLogName) const {
-  return tryGet(asyncLogRoutes_, asyncLogName);
+  return tryGet(
+      lazyRouteBuilder_ ? lazyRouteBuilder_->provider.asyncLogRoutes()
+                        : asyncLogRoutes_,
+      asyncLogName);
+}
+
+template <class RouterInfo>
+const folly::StringKeyedUnorderedMap<
+    std::vector<std::shared_ptr<typename RouterInfo::RouteHandleIf>>>&
+ProxyConfig<RouterInfo>::getPools() const {
+  return lazyRouteBuilder_ ? lazyRouteBuilder_->provider.pools() : pools_;
+}
+
+template <class RouterInfo>
+const folly::StringKeyedUnorderedMap<
+    std::vector<std::shared_ptr<const AccessPoint>>>&
+ProxyConfig<RouterInfo>::getAccessPoints() const {
+  return lazyRouteBuilder_ ? lazyRouteBuilder_->provider.accessPoints()
+                           : accessPoints_;
+}
+
+template <class RouterInfo>
+const std::vector<std::weak_ptr<ProxyDestination>>&
+ProxyConfig<RouterInfo>::getDestinations() const {
+  return lazyRouteBuilder_ ? lazyRouteBuilder_->provider.destinations()
+                           : destinations_;
 }
 
 template <class RouterInfo>
 size_t ProxyConfig<RouterInfo>::calcNumClients() const {
   size_t result = 0;
-  for (const auto& it : pools_) {
+  for (const auto& it : getPools()) {
     result += it.second.size();
   }
   return result;
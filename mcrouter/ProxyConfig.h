@@ -9,13 +9,13 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <folly/Range.h>
+#include <folly/dynamic.h>
 #include <folly/experimental/StringKeyedUnorderedMap.h>
 
-namespace folly {
-struct dynamic;
-} // folly
+#include "mcrouter/routes/ReusablePoolRoute.h"
 
 namespace facebook {
 namespace memcache {
@@ -32,6 +32,7 @@ template <class RouterInfo>
 class ServiceInfo;
 
 class PoolFactory;
+class ProxyDestination;
 
 /**
  * Topmost struct for mcrouter configs.
@@ -54,30 +55,63 @@ class ProxyConfig {
   std::shared_ptr<typename RouterInfo::RouteHandleIf> getRouteHandleForAsyncLog(
       folly::StringPiece asyncLogName) const;
 
+  /**
+   * With lazy_route_construction, only pools of the routes built so far.
+   */
   const folly::StringKeyedUnorderedMap<
       std::vector<std::shared_ptr<typename RouterInfo::RouteHandleIf>>>&
-  getPools() const {
-    return pools_;
-  }
+  getPools() const;
 
   const folly::StringKeyedUnorderedMap<
       std::vector<std::shared_ptr<const AccessPoint>>>&
-  getAccessPoints() const {
-    return accessPoints_;
-  }
+  getAccessPoints() const;
 
   size_t calcNumClients() const;
 
+  /**
+   * @return all destinations the pools of this config send to.
+   */
+  const std::vector<std::weak_ptr<ProxyDestination>>& getDestinations() const;
+
+  /**
+   * @return number of PoolRoutes carried over from the previous config.
+   */
+  size_t numReusedPoolRoutes() const {
+    return numReusedPoolRoutes_;
+  }
+
+  /**
+   * @return true if all routes of this config are single-shot (see
+   *         McRouteHandleProvider::singleShotOnly()). Always false with
+   *         lazy_route_construction, since routes are built on first use.
+   */
+  bool singleShotOnly() const {
+    return singleShotOnly_;
+  }
+
  private:
-  // This map (accessPoints_) needs to be destroyed as the last object in the
-  // config (after all RouteHandles) because its keys are being referenced
-  // by object in the Config.
+  // Set with lazy_route_construction: keeps what is needed to build routes
+  // after the constructor returned. Routes reference its contents, so it
+  // is destroyed last.
+  struct LazyRouteBuilder;
+  std::unique_ptr<LazyRouteBuilder> lazyRouteBuilder_;
+
+  // These maps (accessPoints_, poolNames_) need to be destroyed as the last
+  // objects in the config (after all RouteHandles) because their contents are
+  // being referenced by objects in the Config.
   folly::StringKeyedUnorderedMap<
       std::vector<std::shared_ptr<const AccessPoint>>>
       accessPoints_;
+  folly::StringKeyedUnorderedMap<std::shared_ptr<const std::string>>
+      poolNames_;
+  // Pool routes the next config may carry over.
+  ReusablePoolRouteMap<typename RouterInfo::RouteHandleIf> poolRoutes_;
+  size_t numReusedPoolRoutes_{0};
+  bool singleShotOnly_{false};
   folly::StringKeyedUnorderedMap<
       std::vector<std::shared_ptr<typename RouterInfo::RouteHandleIf>>>
       pools_;
+  std::vector<std::weak_ptr<ProxyDestination>> destinations_;
   std::shared_ptr<ProxyRoute<RouterInfo>> proxyRoute_;
   std::shared_ptr<ServiceInfo<RouterInfo>> serviceInfo_;
   std::string configMd5Digest_;
@@ -88,13 +122,13 @@ class ProxyConfig {
   /**
    * Parses config and creates ProxyRoute
    *
-   * @param jsonC config in format of JSON with comments and templates
+   * @param json preprocessed config
    */
   ProxyConfig(
       Proxy<RouterInfo>& proxy,
-      const folly::dynamic& json,
+      std::shared_ptr<const folly::dynamic> json,
       std::string configMd5Digest,
-      PoolFactory& poolFactory);
+      std::shared_ptr<PoolFactory> poolFactory);
 
   friend class ProxyConfigBuilder;
 };
@@ -10,6 +10,7 @@
 #include <folly/json.h>
 
 #include "mcrouter/ConfigApi.h"
+#include "mcrouter/ConfigSnapshot.h"
 #include "mcrouter/PoolFactory.h"
 #include "mcrouter/Proxy.h"
 #include "mcrouter/ProxyConfig.h"
@@ -17,7 +18,6 @@
 #include "mcrouter/lib/config/ConfigPreprocessor.h"
 #include "mcrouter/lib/fbi/cpp/globals.h"
 #include "mcrouter/lib/fbi/cpp/util.h"
-#include "mcrouter/routes/McImportResolver.h"
 
 namespace facebook {
 namespace memcache {
@@ -26,9 +26,7 @@ namespace mcrouter {
 ProxyConfigBuilder::ProxyConfigBuilder(
     const McrouterOptions& opts,
     ConfigApi& configApi,
-    folly::StringPiece jsonC)
-    : json_(nullptr) {
-  McImportResolver importResolver(configApi);
+    folly::StringPiece jsonC) {
   folly::StringKeyedUnorderedMap<folly::dynamic> globalParams{
       {"default-route", opts.default_route.str()},
       {"default-region", opts.default_route.getRegion().str()},
@@ -44,10 +42,29 @@ ProxyConfigBuilder::ProxyConfigBuilder(
     globalParams.emplace(param.first, param.second);
   }
 
-  json_ = ConfigPreprocessor::getConfigWithoutMacros(
-      jsonC, importResolver, std::move(globalParams));
+  ConfigSnapshot snapshot(opts, configApi, jsonC, globalParams);
+  auto startUs = nowUs();
+  folly::dynamic config;
+  if (auto snapshotConfig = snapshot.load()) {
+    config = std::move(*snapshotConfig);
+    parseTimeUs_ = nowUs() - startUs;
+  } else {
+    startUs = nowUs();
+    auto parsedConfig = parseJsonString(folly::json::stripComments(jsonC));
+    parseTimeUs_ = nowUs() - startUs;
 
-  poolFactory_ = std::make_unique<PoolFactory>(json_, configApi);
+    startUs = nowUs();
+    config = ConfigPreprocessor::expandConfigMacros(
+        std::move(parsedConfig),
+        snapshot.importResolver(),
+        std::move(globalParams));
+    preprocessTimeUs_ = nowUs() - startUs;
+
+    snapshot.save(config);
+  }
+  json_ = std::make_shared<const folly::dynamic>(std::move(config));
+
+  poolFactory_ = std::make_shared<PoolFactory>(*json_, configApi);
 
   configMd5Digest_ = Md5Hash(jsonC);
 }
@@ -38,16 +38,34 @@ class ProxyConfigBuilder {
   std::shared_ptr<ProxyConfig<RouterInfo>> buildConfig(
       Proxy<RouterInfo>& proxy) const {
     return std::shared_ptr<ProxyConfig<RouterInfo>>(new ProxyConfig<RouterInfo>(
-        proxy, json_, configMd5Digest_, *poolFactory_));
+        proxy, json_, configMd5Digest_, poolFactory_));
   }
 
   const folly::dynamic& preprocessedConfig() const {
-    return json_;
+    return *json_;
+  }
+
+  /**
+   * Time it took to parse the JSONC config, in microseconds.
+   */
+  uint64_t parseTimeUs() const {
+    return parseTimeUs_;
+  }
+
+  /**
+   * Time it took to expand macros and imports of the parsed config,
+   * in microseconds.
+   */
+  uint64_t preprocessTimeUs() const {
+    return preprocessTimeUs_;
   }
 
  private:
-  folly::dynamic json_;
-  std::unique_ptr<PoolFactory> poolFactory_;
+  // Shared with lazily built configs, which keep using them.
+  std::shared_ptr<const folly::dynamic> json_;
+  uint64_t parseTimeUs_{0};
+  uint64_t preprocessTimeUs_{0};
+  std::shared_ptr<PoolFactory> poolFactory_;
   std::string configMd5Digest_;
 };
 }
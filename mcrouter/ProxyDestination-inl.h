@@ -5,13 +5,22 @@
  *  file in the root directory of this source tree.
  *
  */
+#include <algorithm>
 #include <limits>
 #include <random>
 
+#include <folly/ScopeGuard.h>
+#include <folly/fibers/FiberManager.h>
+#include <folly/fibers/Promise.h>
+#include <folly/io/async/VirtualEventBase.h>
+
 #include "mcrouter/ProxyBase.h"
 #include "mcrouter/ProxyDestinationMap.h"
 #include "mcrouter/config-impl.h"
+#include "mcrouter/config.h"
+#include "mcrouter/lib/McTracepoints.h"
 #include "mcrouter/lib/Operation.h"
+#include "mcrouter/lib/Reply.h"
 #include "mcrouter/lib/network/AsyncMcClient.h"
 
 namespace facebook {
@@ -24,20 +33,128 @@ ReplyT<Request> ProxyDestination::send(
     DestinationRequestCtx& requestContext,
     std::chrono::milliseconds timeout,
     ReplyStatsContext& replyStatsContext) {
+  const bool halfOpenSample = reserveHalfOpenSample();
+  SCOPE_EXIT {
+    if (halfOpenSample) {
+      halfOpenSampleInflight_ = false;
+    }
+  };
+
+  if (forwardToOwner_) {
+    if (auto owner = sharedConnectionOwner()) {
+      if (halfOpenSample) {
+        onHalfOpenSampleSent();
+      }
+      auto reply = sendThroughOwner(
+          std::move(owner),
+          request,
+          requestContext,
+          timeout,
+          replyStatsContext);
+      if (halfOpenSample) {
+        onHalfOpenSampleReply(reply.result());
+      }
+      return reply;
+    }
+  }
+
+  auto* client = getAsyncMcClient(timeout);
+  if (client == nullptr) {
+    // Nothing was sent, the next request let through will be the sample.
+    return createReply<Request>(
+        ErrorReply, "Timed out waiting for a new connection to be allowed");
+  }
+  if (halfOpenSample) {
+    onHalfOpenSampleSent();
+  }
+
   proxy.destinationMap()->markAsActive(*this);
-  auto reply =
-      getAsyncMcClient().sendSync(request, timeout, &replyStatsContext);
+  MC_TRACEPOINT(
+      destination_send, &request, pdstnKey_.data(), pdstnKey_.size());
+  auto reply = client->sendSync(
+      request, timeout, &replyStatsContext, requestContext.lowPriority);
   onReply(reply.result(), requestContext, replyStatsContext);
+  MC_TRACEPOINT(
+      destination_reply,
+      &request,
+      static_cast<int>(reply.result()),
+      requestContext.startTime,
+      requestContext.endTime);
+  if (halfOpenSample) {
+    onHalfOpenSampleReply(reply.result());
+  }
   return reply;
 }
 
 template <class Request>
-bool ProxyDestination::shouldDrop() const {
-  if (!client_) {
-    return false;
+ReplyT<Request> ProxyDestination::sendThroughOwner(
+    std::shared_ptr<ProxyDestination> owner,
+    const Request& request,
+    DestinationRequestCtx& requestContext,
+    std::chrono::milliseconds timeout,
+    ReplyStatsContext& replyStatsContext) {
+  // The owner's fiber doesn't have the request context, and thus its
+  // deadline. timeout is already clamped to it, so it's turned into an
+  // absolute deadline: time spent getting to the owner's thread counts.
+  const int64_t deadlineUs =
+      timeout.count() > 0 ? nowUs() + timeout.count() * 1000 : 0;
+
+  // The current fiber is blocked until the promise is fulfilled, so it's
+  // safe for the owner's thread to use the references.
+  try {
+    return folly::fibers::await(
+        [&](folly::fibers::Promise<ReplyT<Request>> promise) mutable {
+          auto& ownerEvb = owner->proxy.eventBase();
+          ownerEvb.runInEventBaseThread([
+            owner = std::move(owner),
+            &request,
+            &requestContext,
+            deadlineUs,
+            &replyStatsContext,
+            promise = std::move(promise)
+          ]() mutable {
+            auto& fm = owner->proxy.fiberManager();
+            fm.addTask([
+              owner = std::move(owner),
+              &request,
+              &requestContext,
+              deadlineUs,
+              &replyStatsContext,
+              promise = std::move(promise)
+            ]() mutable {
+              auto timeLeft = std::chrono::milliseconds(0);
+              if (deadlineUs != 0) {
+                const auto leftUs = deadlineUs - nowUs();
+                if (leftUs < 1000) {
+                  owner->proxy.stats().increment(deadline_exceeded_reqs_stat);
+                  promise.setValue(createReply<Request>(
+                      ErrorReply,
+                      mc_res_timeout,
+                      "Request deadline exceeded"));
+                  return;
+                }
+                timeLeft = std::chrono::milliseconds(leftUs / 1000);
+              }
+              promise.setValue(owner->send(
+                  request, requestContext, timeLeft, replyStatsContext));
+            });
+          });
+        });
+  } catch (const std::exception& e) {
+    // Owner proxy went away (e.g. during shutdown) before replying.
+    return createReply<Request>(ErrorReply, e.what());
   }
+}
 
-  auto dropProbability = client_->getDropProbability<Request>();
+template <class Request>
+bool ProxyDestination::shouldDrop() const {
+  double dropProbability = 0.0;
+  for (const auto& client : clients_) {
+    if (client) {
+      dropProbability =
+          std::max(dropProbability, client->getDropProbability<Request>());
+    }
+  }
 
   if (dropProbability == 0.0) {
     return false;
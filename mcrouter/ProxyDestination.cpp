@@ -7,13 +7,14 @@
  */
 #include "ProxyDestination.h"
 
+#include <algorithm>
 #include <limits>
 #include <memory>
 #include <random>
 
 #include <folly/fibers/Fiber.h>
-#include <folly/io/async/AsyncTimeout.h>
 
+#include "mcrouter/ConnectThrottle.h"
 #include "mcrouter/McrouterLogFailure.h"
 #include "mcrouter/OptionsUtil.h"
 #include "mcrouter/TkoTracker.h"
@@ -21,6 +22,7 @@
 #include "mcrouter/config.h"
 #include "mcrouter/lib/Clocks.h"
 #include "mcrouter/lib/McResUtil.h"
+#include "mcrouter/lib/McTracepoints.h"
 #include "mcrouter/lib/network/AccessPoint.h"
 #include "mcrouter/lib/network/AsyncMcClient.h"
 #include "mcrouter/lib/network/ReplyStatsContext.h"
@@ -69,43 +71,84 @@ void ProxyDestination::schedule_next_probe() {
   delay_ms = (double)delay_ms * (1.0 + tmo_jitter_pct);
   assert(delay_ms > 0);
 
-  if (!probeTimer_->scheduleTimeout(delay_ms)) {
-    MC_LOG_FAILURE(
-        proxy.router().opts(),
-        failure::Category::kSystemError,
-        "failed to schedule probe timer for ProxyDestination");
+  if (auto* destinationMap = proxy.destinationMap()) {
+    destinationMap->probeScheduler().schedule(
+        selfPtr_, probeId_, std::chrono::milliseconds(delay_ms));
   }
 }
 
 void ProxyDestination::start_sending_probes() {
+  auto* destinationMap = proxy.destinationMap();
+  if (destinationMap == nullptr) {
+    // Proxy is shutting down.
+    return;
+  }
   probe_delay_next_ms = proxy.router().opts().probe_delay_initial_ms;
-  probeTimer_ =
-      folly::AsyncTimeout::make(proxy.eventBase(), [this]() noexcept {
-        // Note that the previous probe might still be in flight
-        if (!probeInflight_) {
-          probeInflight_ = true;
-          ++stats_.probesSent;
-          proxy.fiberManager().addTask([selfPtr = selfPtr_]() mutable {
-            auto pdstn = selfPtr.lock();
-            if (pdstn == nullptr) {
-              return;
-            }
-            pdstn->proxy.destinationMap()->markAsActive(*pdstn);
-            // will reconnect if connection was closed
-            auto reply = pdstn->getAsyncMcClient().sendSync(
-                McVersionRequest(), pdstn->shortestTimeout_);
-            pdstn->handle_tko(reply.result(), true);
-            pdstn->probeInflight_ = false;
-          });
-        }
-        schedule_next_probe();
-      });
+  probeId_ = destinationMap->probeScheduler().nextProbeId();
+  halfOpenSuccesses_ = 0;
+  canarySentSinceProbe_ = false;
+  schedule_next_probe();
+}
+
+void ProxyDestination::onProbeTimer() {
+  if (canarySentSinceProbe_) {
+    // Canaries are checking on the destination, probes are only needed
+    // while there is no traffic to pick them from.
+    canarySentSinceProbe_ = false;
+  } else if (!probeInflight_) {
+    // Note that the previous probe might still be in flight
+    probeInflight_ = true;
+    ++stats_.probesSent;
+    proxy.stats().increment(probes_sent_stat);
+    proxy.fiberManager().addTask([selfPtr = selfPtr_]() mutable {
+      auto pdstn = selfPtr.lock();
+      if (pdstn == nullptr) {
+        return;
+      }
+      pdstn->proxy.destinationMap()->markAsActive(*pdstn);
+      // will reconnect if connection was closed
+      auto* client = pdstn->getAsyncMcClient(pdstn->shortestTimeout_);
+      if (client == nullptr) {
+        // No connect budget, the next probe will try again.
+        pdstn->probeInflight_ = false;
+        return;
+      }
+      const auto startUs = nowUs();
+      auto reply =
+          client->sendSync(McVersionRequest(), pdstn->shortestTimeout_);
+      // A latency outlier has to answer the probe within the latency
+      // that got it ejected before it is let back in.
+      const bool stillSlow = pdstn->tracker->isLatencyTko() &&
+          !isErrorResult(reply.result()) &&
+          static_cast<uint64_t>(nowUs() - startUs) >=
+              pdstn->tracker->latencyTkoThresholdUs();
+      if (!stillSlow) {
+        pdstn->handle_tko(reply.result(), true);
+      }
+      pdstn->probeInflight_ = false;
+    });
+  }
   schedule_next_probe();
 }
 
+void ProxyDestination::restoreTko(bool hard) {
+  if (proxy.router().opts().disable_tko_tracking) {
+    return;
+  }
+  if (tracker->recordRestoredTko(this, hard)) {
+    if (hard) {
+      onTkoEvent(TkoLogEvent::MarkHardTko, mc_res_connect_error);
+    } else {
+      onTkoEvent(TkoLogEvent::MarkSoftTko, mc_res_timeout);
+    }
+    start_sending_probes();
+  }
+}
+
 void ProxyDestination::stop_sending_probes() {
   stats_.probesSent = 0;
-  probeTimer_.reset();
+  // Entries left in ProbeScheduler are ignored once the id changes.
+  probeId_ = 0;
 }
 
 void ProxyDestination::handle_tko(const mc_res_t result, bool is_probe_req) {
@@ -139,59 +182,190 @@ void ProxyDestination::handle_tko(const mc_res_t result, bool is_probe_req) {
   tracker->recordSuccess(this);
 }
 
-void ProxyDestination::handleRxmittingConnection() {
-  if (!client_) {
+void ProxyDestination::handleErrorRateTko(mc_res_t result) {
+  if (!errorRateTko_.enabled() ||
+      proxy.router().opts().disable_tko_tracking) {
+    return;
+  }
+  // While TKO, replies are half-open samples and are judged on their own.
+  if (tracker->isTko()) {
+    return;
+  }
+
+  errorRateWindow_.record(
+      isSoftTkoErrorResult(result) || isHardTkoErrorResult(result),
+      proxy.loopNowUs());
+  if (errorRateWindow_.requests() < errorRateTko_.minRequests ||
+      errorRateWindow_.errors() <
+          errorRateTko_.threshold * errorRateWindow_.requests()) {
+    return;
+  }
+
+  errorRateWindow_.reset();
+  if (tracker->recordErrorRateTrip(this)) {
+    onTkoEvent(TkoLogEvent::MarkErrorRateTko, result);
+    start_sending_probes();
+  }
+}
+
+bool ProxyDestination::reserveHalfOpenSample() {
+  // Requests to a TKO destination only get here if may_send() let them
+  // through as a sample.
+  if (!tracker->isTko() || !tracker->isSoftTko() ||
+      !tracker->isResponsible(this) || halfOpenSampleInflight_) {
+    return false;
+  }
+  halfOpenSampleInflight_ = true;
+  return true;
+}
+
+void ProxyDestination::onHalfOpenSampleReply(mc_res_t result) {
+  // Failures were already accounted for in onReply().
+  if (isErrorResult(result)) {
+    halfOpenSuccesses_ = 0;
+    return;
+  }
+  if (!tracker->isTko()) {
     return;
   }
+  const size_t required = tracker->isErrorRateTko()
+      ? 1
+      : std::max<size_t>(1, proxy.router().opts().tko_canary_successes);
+  if (++halfOpenSuccesses_ < required) {
+    return;
+  }
+  halfOpenSuccesses_ = 0;
+  handle_tko(result, /* is_probe_req= */ true);
+}
+
+void ProxyDestination::updateErrorRateTko(
+    const ErrorRateTkoSettings& settings) {
+  if (!settings.enabled() ||
+      (errorRateTko_.enabled() &&
+       errorRateTko_.threshold <= settings.threshold)) {
+    return;
+  }
+  errorRateTko_ = settings;
+  errorRateWindow_.setWindow(settings.window);
+}
+
+void ProxyDestination::updateAdaptiveTimeout(
+    mc_res_t result,
+    int64_t latencyUs) {
+  if (!adaptiveTimeout_) {
+    return;
+  }
+  // Timed out requests are counted too, see AdaptiveTimeout::onReply().
+  if (isErrorResult(result) && result != mc_res_timeout) {
+    return;
+  }
+  adaptiveTimeout_->onReply(
+      latencyUs,
+      tracker->consecutiveFailureCount() > 0 || tracker->isTko());
+}
+
+void ProxyDestination::updateInflightWindow(
+    mc_res_t result,
+    int64_t latencyUs) {
+  if (!inflightWindow_) {
+    return;
+  }
+  const bool congested = result == mc_res_timeout ||
+      result == mc_res_connect_timeout || result == mc_res_busy ||
+      result == mc_res_try_again;
+  if (!inflightWindow_->onReply(congested, latencyUs, nowUs())) {
+    return;
+  }
+  const auto maxPending = proxy.router().opts().target_max_pending_requests;
+  for (auto& client : clients_) {
+    if (client) {
+      client->setThrottle(inflightWindow_->window(), maxPending);
+    }
+  }
+}
+
+std::chrono::milliseconds ProxyDestination::effectiveTimeout(
+    std::chrono::milliseconds timeout) const {
+  return adaptiveTimeout_ ? adaptiveTimeout_->timeout(timeout) : timeout;
+}
+
+void ProxyDestination::handleLatencyTko(mc_res_t result, int64_t latencyUs) {
+  const auto& opts = proxy.router().opts();
+  if (opts.disable_tko_tracking || opts.latency_tko_interval_ms == 0) {
+    return;
+  }
+  // Errors (timeouts in particular) are accounted for by soft/hard TKO.
+  if (!isErrorResult(result)) {
+    tracker->recordLatency(latencyUs);
+  }
+  if (tracker->latencyOutlierPending() &&
+      tracker->recordLatencyOutlier(this)) {
+    onTkoEvent(TkoLogEvent::MarkLatencyTko, result);
+    start_sending_probes();
+  }
+}
+
+void ProxyDestination::handleRxmittingConnection() {
   const auto retransCycles = proxy.router().opts().collect_rxmit_stats_every_hz;
-  if (retransCycles > 0) {
-    const auto curCycles = cycles::getCpuCycles();
-    if (curCycles > lastRetransCycles_ + retransCycles) {
-      lastRetransCycles_ = curCycles;
-      const auto currRetransPerKByte = client_->getRetransmissionInfo();
-      if (currRetransPerKByte >= 0.0) {
-        stats_.retransPerKByte = currRetransPerKByte;
-        proxy.stats().setValue(
-            retrans_per_kbyte_max_stat,
-            std::max(
-                proxy.stats().getValue(retrans_per_kbyte_max_stat),
-                static_cast<uint64_t>(currRetransPerKByte)));
-        proxy.stats().increment(
-            retrans_per_kbyte_sum_stat,
-            static_cast<int64_t>(currRetransPerKByte));
-        proxy.stats().increment(retrans_num_total_stat);
-      }
+  if (retransCycles == 0) {
+    return;
+  }
+  const auto curCycles = cycles::getCpuCycles();
+  if (curCycles <= lastRetransCycles_ + retransCycles) {
+    return;
+  }
+  lastRetransCycles_ = curCycles;
 
-      if (proxy.router().isRxmitReconnectionDisabled()) {
-        return;
+  for (auto& client : clients_) {
+    if (!client) {
+      continue;
+    }
+    const auto currRetransPerKByte = client->getRetransmissionInfo();
+    if (currRetransPerKByte >= 0.0) {
+      stats_.retransPerKByte = currRetransPerKByte;
+      proxy.stats().setValue(
+          retrans_per_kbyte_max_stat,
+          std::max(
+              proxy.stats().getValue(retrans_per_kbyte_max_stat),
+              static_cast<uint64_t>(currRetransPerKByte)));
+      proxy.stats().increment(
+          retrans_per_kbyte_sum_stat,
+          static_cast<int64_t>(currRetransPerKByte));
+      proxy.stats().increment(retrans_num_total_stat);
+      if (auto incastWindow = proxy.incastWindow()) {
+        incastWindow->onRetransmits(currRetransPerKByte, nowUs());
       }
+    }
 
-      if (rxmitsToCloseConnection_ > 0 &&
-          currRetransPerKByte >= rxmitsToCloseConnection_) {
-        std::uniform_int_distribution<uint64_t> dist(
-            1, kReconnectionHoldoffFactor);
-        const uint64_t reconnectionJitters =
-            retransCycles * dist(proxy.randomGenerator());
-        if (lastConnCloseCycles_ + reconnectionJitters > curCycles) {
-          return;
-        }
-        client_->closeNow();
-        proxy.stats().increment(retrans_closed_connections_stat);
-        lastConnCloseCycles_ = curCycles;
-
-        const auto maxThreshold =
-            proxy.router().opts().max_rxmit_reconnect_threshold;
-        const uint64_t maxRxmitReconnThreshold = maxThreshold == 0
-            ? std::numeric_limits<uint64_t>::max()
-            : maxThreshold;
-        rxmitsToCloseConnection_ =
-            std::min(maxRxmitReconnThreshold, 2 * rxmitsToCloseConnection_);
-      } else if (3 * currRetransPerKByte < rxmitsToCloseConnection_) {
-        const auto minThreshold =
-            proxy.router().opts().min_rxmit_reconnect_threshold;
-        rxmitsToCloseConnection_ =
-            std::max(minThreshold, rxmitsToCloseConnection_ / 2);
+    if (proxy.router().isRxmitReconnectionDisabled()) {
+      continue;
+    }
+
+    if (rxmitsToCloseConnection_ > 0 &&
+        currRetransPerKByte >= rxmitsToCloseConnection_) {
+      std::uniform_int_distribution<uint64_t> dist(
+          1, kReconnectionHoldoffFactor);
+      const uint64_t reconnectionJitters =
+          retransCycles * dist(proxy.randomGenerator());
+      if (lastConnCloseCycles_ + reconnectionJitters > curCycles) {
+        continue;
       }
+      client->closeNow();
+      proxy.stats().increment(retrans_closed_connections_stat);
+      lastConnCloseCycles_ = curCycles;
+
+      const auto maxThreshold =
+          proxy.router().opts().max_rxmit_reconnect_threshold;
+      const uint64_t maxRxmitReconnThreshold = maxThreshold == 0
+          ? std::numeric_limits<uint64_t>::max()
+          : maxThreshold;
+      rxmitsToCloseConnection_ =
+          std::min(maxRxmitReconnThreshold, 2 * rxmitsToCloseConnection_);
+    } else if (3 * currRetransPerKByte < rxmitsToCloseConnection_) {
+      const auto minThreshold =
+          proxy.router().opts().min_rxmit_reconnect_threshold;
+      rxmitsToCloseConnection_ =
+          std::max(minThreshold, rxmitsToCloseConnection_ / 2);
     }
   }
 }
@@ -201,6 +375,7 @@ void ProxyDestination::onReply(
     DestinationRequestCtx& destreqCtx,
     const ReplyStatsContext& replyStatsContext) {
   handle_tko(result, false);
+  handleErrorRateTko(result);
 
   if (!stats_.results) {
     stats_.results = std::make_unique<std::array<uint64_t, mc_nres>>();
@@ -210,6 +385,15 @@ void ProxyDestination::onReply(
 
   int64_t latency = destreqCtx.endTime - destreqCtx.startTime;
   stats_.avgLatency.insertSample(latency);
+  if (proxy.router().opts().destination_latency_histograms) {
+    if (!stats_.latencies) {
+      stats_.latencies = std::make_unique<RecentLatencyHistogram>();
+    }
+    stats_.latencies->insertSample(latency);
+  }
+  handleLatencyTko(result, latency);
+  updateAdaptiveTimeout(result, latency);
+  updateInflightWindow(result, latency);
 
   if (accessPoint_->compressed()) {
     if (replyStatsContext.usedCodecId > 0) {
@@ -224,29 +408,55 @@ void ProxyDestination::onReply(
         reply_traffic_after_compression_stat,
         replyStatsContext.replySizeAfterCompression);
   }
+  if (replyStatsContext.valueCopied) {
+    proxy.stats().increment(reply_values_copied_stat);
+  }
 
   handleRxmittingConnection();
 }
 
 size_t ProxyDestination::getPendingRequestCount() const {
   folly::SpinLockGuard g(clientLock_);
-  return client_ ? client_->getPendingRequestCount() : 0;
+  size_t count = 0;
+  for (const auto& client : clients_) {
+    if (client) {
+      count += client->getPendingRequestCount();
+    }
+  }
+  return count;
 }
 
 size_t ProxyDestination::getInflightRequestCount() const {
   folly::SpinLockGuard g(clientLock_);
-  return client_ ? client_->getInflightRequestCount() : 0;
+  size_t count = 0;
+  for (const auto& client : clients_) {
+    if (client) {
+      count += client->getInflightRequestCount();
+    }
+  }
+  return count;
 }
 
 std::shared_ptr<ProxyDestination> ProxyDestination::create(
     ProxyBase& proxy,
-    std::shared_ptr<AccessPoint> ap,
+    std::shared_ptr<const AccessPoint> ap,
+    const ProxyDestinationKey& key,
+    std::string printableKey,
     std::chrono::milliseconds timeout,
     uint64_t qosClass,
     uint64_t qosPath,
-    folly::StringPiece routerInfoName) {
+    folly::StringPiece routerInfoName,
+    size_t numConnections) {
   std::shared_ptr<ProxyDestination> ptr(new ProxyDestination(
-      proxy, std::move(ap), timeout, qosClass, qosPath, routerInfoName));
+      proxy,
+      std::move(ap),
+      key,
+      std::move(printableKey),
+      timeout,
+      qosClass,
+      qosPath,
+      routerInfoName,
+      numConnections));
   ptr->selfPtr_ = ptr;
   return ptr;
 }
@@ -262,52 +472,166 @@ ProxyDestination::~ProxyDestination() {
     proxy.destinationMap()->removeDestination(*this);
   }
 
-  if (client_) {
-    client_->setStatusCallbacks(nullptr, nullptr);
-    client_->closeNow();
+  for (auto& client : clients_) {
+    if (client) {
+      client->setStatusCallbacks(nullptr, nullptr);
+      client->closeNow();
+    }
   }
 
+  settleWarmUp(false);
   onTransitionFromState(stats_.state);
   proxy.stats().decrement(num_servers_stat);
 }
 
 ProxyDestination::ProxyDestination(
     ProxyBase& proxy_,
-    std::shared_ptr<AccessPoint> ap,
+    std::shared_ptr<const AccessPoint> ap,
+    const ProxyDestinationKey& key,
+    std::string printableKey,
     std::chrono::milliseconds timeout,
     uint64_t qosClass,
     uint64_t qosPath,
-    folly::StringPiece routerInfoName)
+    folly::StringPiece routerInfoName,
+    size_t numConnections)
     : proxy(proxy_),
+      clients_(std::max<size_t>(numConnections, 1)),
+      needsConnect_(clients_.size(), true),
+      numConnections_(clients_.size()),
       accessPoint_(std::move(ap)),
       shortestTimeout_(timeout),
       qosClass_(qosClass),
       qosPath_(qosPath),
       routerInfoName_(routerInfoName),
       rxmitsToCloseConnection_(
-          proxy.router().opts().min_rxmit_reconnect_threshold) {
+          proxy.router().opts().min_rxmit_reconnect_threshold),
+      destinationKey_(key),
+      pdstnKey_(std::move(printableKey)),
+      forwardToOwner_(
+          proxy.router().opts().shared_destination_connections &&
+          proxy.router().opts().num_proxies > 1) {
+  const auto& opts = proxy.router().opts();
+  if (opts.adaptive_timeout_quantile > 0.0) {
+    adaptiveTimeout_ = std::make_unique<AdaptiveTimeout>(
+        opts.adaptive_timeout_quantile,
+        opts.adaptive_timeout_factor,
+        std::chrono::milliseconds(opts.adaptive_timeout_min_ms),
+        std::chrono::milliseconds(opts.adaptive_timeout_max_ms));
+  }
+  if (opts.target_inflight_aimd && opts.target_max_inflight_requests > 0) {
+    inflightWindow_ = std::make_unique<InflightWindow>(
+        opts.target_min_inflight_requests,
+        opts.target_max_inflight_requests,
+        opts.target_inflight_latency_factor);
+  }
   proxy.stats().increment(num_servers_new_stat);
   proxy.stats().increment(num_servers_stat);
 }
 
-bool ProxyDestination::may_send() const {
-  return !tracker->isTko();
+std::shared_ptr<ProxyDestination> ProxyDestination::sharedConnectionOwner() {
+  if (auto owner = sharedOwner_.lock()) {
+    return owner;
+  }
+
+  const auto numProxies = proxy.router().opts().num_proxies;
+  // Keys are the same in all proxies, see AccessPoint::intern().
+  const auto ownerId = destinationKey_.hash % numProxies;
+  if (ownerId == proxy.getId()) {
+    forwardToOwner_ = false;
+    return nullptr;
+  }
+
+  auto owner =
+      proxy.router().getProxyBase(ownerId)->destinationMap()->findByKey(
+          destinationKey_);
+  sharedOwner_ = owner;
+  return owner;
+}
+
+bool ProxyDestination::spilloverSaturated() {
+  const auto& opts = proxy.router().opts();
+  // Queues are only bounded with an inflight limit.
+  if (opts.target_max_inflight_requests == 0 ||
+      opts.target_max_pending_requests == 0) {
+    return false;
+  }
+  size_t minPending = std::numeric_limits<size_t>::max();
+  {
+    folly::SpinLockGuard g(clientLock_);
+    for (const auto& client : clients_) {
+      // A connection yet to be established takes requests too.
+      minPending = std::min(
+          minPending, client ? client->getPendingRequestCount() : 0);
+    }
+  }
+  const auto maxPending = opts.target_max_pending_requests;
+  if (!spilloverSaturated_) {
+    if (minPending >= maxPending) {
+      spilloverSaturated_ = true;
+      proxy.stats().increment(destination_spillover_saturated_stat);
+    }
+  } else if (minPending <= maxPending * opts.spillover_resume_pending_ratio) {
+    spilloverSaturated_ = false;
+  }
+  return spilloverSaturated_;
+}
+
+bool ProxyDestination::may_send() {
+  if (!tracker->isTko()) {
+    return true;
+  }
+  // Half-open: the proxy probing a soft TKO lets a sample of real requests
+  // through, one at a time. Error rate TKOs do it with the pool's
+  // half_open_ratio, others with tko_canary_ratio.
+  if (!tracker->isSoftTko() || !tracker->isResponsible(this) ||
+      halfOpenSampleInflight_) {
+    return false;
+  }
+  const double errorRateRatio =
+      tracker->isErrorRateTko() ? errorRateTko_.halfOpenRatio : 0.0;
+  const double ratio = isCanaryDue(proxy.loopNowUs())
+      ? proxy.router().opts().tko_canary_ratio
+      : errorRateRatio;
+  return ratio > 0.0 &&
+      std::generate_canonical<double, std::numeric_limits<double>::digits>(
+          proxy.randomGenerator()) < ratio;
+}
+
+bool ProxyDestination::isCanaryDue(int64_t nowUs) const {
+  const auto& opts = proxy.router().opts();
+  const double errorRateRatio =
+      tracker->isErrorRateTko() ? errorRateTko_.halfOpenRatio : 0.0;
+  // Latency outliers are left to probes, which check the latency too.
+  return opts.tko_canary_ratio > errorRateRatio && !tracker->isLatencyTko() &&
+      nowUs - lastCanaryUs_ >=
+          static_cast<int64_t>(opts.tko_canary_interval_ms) * 1000;
+}
+
+void ProxyDestination::onHalfOpenSampleSent() {
+  const auto now = proxy.loopNowUs();
+  if (isCanaryDue(now)) {
+    lastCanaryUs_ = now;
+    canarySentSinceProbe_ = true;
+  }
+  proxy.stats().increment(tko_canaries_sent_stat);
 }
 
 void ProxyDestination::resetInactive() {
-  // No need to reset non-existing client.
-  if (client_) {
-    std::unique_ptr<AsyncMcClient> client;
-    {
-      folly::SpinLockGuard g(clientLock_);
-      client = std::move(client_);
+  for (size_t i = 0; i < clients_.size(); ++i) {
+    // No need to reset non-existing client.
+    if (clients_[i]) {
+      std::unique_ptr<AsyncMcClient> client;
+      {
+        folly::SpinLockGuard g(clientLock_);
+        client = std::move(clients_[i]);
+      }
+      client->closeNow();
     }
-    client->closeNow();
   }
 }
 
-void ProxyDestination::initializeAsyncMcClient() {
-  assert(!client_);
+void ProxyDestination::initializeAsyncMcClient(size_t idx) {
+  assert(idx < clients_.size() && !clients_[idx]);
 
   ConnectionOptions options(accessPoint_);
   auto& opts = proxy.router().opts();
@@ -315,6 +639,10 @@ void ProxyDestination::initializeAsyncMcClient() {
   options.tcpKeepAliveIdle = opts.keepalive_idle_s;
   options.tcpKeepAliveInterval = opts.keepalive_interval_s;
   options.writeTimeout = shortestTimeout_;
+  options.maxWriteBatchBytes = opts.max_write_batch_size;
+  options.maxWriteBatchIovecs = opts.max_write_batch_iovecs;
+  options.zeroCopyThreshold = opts.zero_copy_threshold;
+  options.batchCaretRequests = opts.batch_caret_requests;
   options.sessionCachingEnabled = opts.ssl_connection_cache;
   options.sslServiceIdentity = opts.ssl_service_identity;
   options.routerInfoName = routerInfoName_;
@@ -331,6 +659,8 @@ void ProxyDestination::initializeAsyncMcClient() {
   if (accessPoint_->compressed()) {
     if (auto codecManager = proxy.router().getCodecManager()) {
       options.compressionCodecMap = codecManager->getCodecMap();
+      options.compressRequests = opts.compress_requests;
+      options.compressionOffload = proxy.router().compressionOffload();
     }
   }
 
@@ -345,20 +675,23 @@ void ProxyDestination::initializeAsyncMcClient() {
           opts.pem_key_path,
           opts.pem_ca_path,
           folly::none,
-          true);
+          true /* clientContext */,
+          opts.enable_ssl_ktls);
     };
   }
 
   auto client =
       std::make_unique<AsyncMcClient>(proxy.eventBase(), std::move(options));
+  auto& clientRef = *client;
   {
     folly::SpinLockGuard g(clientLock_);
-    client_ = std::move(client);
+    clients_[idx] = std::move(client);
   }
+  needsConnect_[idx] = true;
 
-  client_->setFlushList(&proxy.flushList());
+  clientRef.setFlushList(&proxy.flushList());
 
-  client_->setRequestStatusCallbacks(
+  clientRef.setRequestStatusCallbacks(
       [this](int pending, int inflight) {
         if (pending != 0) {
           proxy.stats().increment(destination_pending_reqs_stat, pending);
@@ -380,10 +713,18 @@ void ProxyDestination::initializeAsyncMcClient() {
       [this](size_t numToSend) {
         proxy.stats().increment(destination_batches_sum_stat);
         proxy.stats().increment(destination_requests_sum_stat, numToSend);
+        proxy.onDestinationBatch(numToSend);
+        ++stats_.batches;
+        stats_.batchedRequests += numToSend;
+      },
+      [this](size_t numWrites) {
+        proxy.stats().increment(destination_writes_sum_stat, numWrites);
+        stats_.writes += numWrites;
       });
 
-  client_->setStatusCallbacks(
+  clientRef.setStatusCallbacks(
       [this](const folly::AsyncSocket& socket) mutable {
+        settleWarmUp(true);
         setState(State::kUp);
         if (const auto* sslSocket =
                 socket.getUnderlyingTransport<folly::AsyncSSLSocket>()) {
@@ -396,11 +737,14 @@ void ProxyDestination::initializeAsyncMcClient() {
           }
         }
       },
-      [pdstnPtr = selfPtr_](AsyncMcClient::ConnectionDownReason reason) {
+      [pdstnPtr = selfPtr_, idx](AsyncMcClient::ConnectionDownReason reason) {
         auto pdstn = pdstnPtr.lock();
         if (!pdstn) {
           return;
         }
+        // The next request reconnects, see getAsyncMcClient().
+        pdstn->needsConnect_[idx] = true;
+        pdstn->settleWarmUp(false);
 
         if (reason == AsyncMcClient::ConnectionDownReason::ABORTED) {
           pdstn->setState(State::kClosed);
@@ -408,7 +752,7 @@ void ProxyDestination::initializeAsyncMcClient() {
           // In case of server going away, we should gracefully close the
           // connection (i.e. allow remaining outstanding requests to drain).
           if (reason == AsyncMcClient::ConnectionDownReason::SERVER_GONE_AWAY) {
-            pdstn->closeGracefully();
+            pdstn->closeGracefully(idx);
           }
           pdstn->setState(State::kDown);
           pdstn->handle_tko(mc_res_connect_error, /* is_probe_req= */ false);
@@ -416,39 +760,161 @@ void ProxyDestination::initializeAsyncMcClient() {
       });
 
   if (opts.target_max_inflight_requests > 0) {
-    client_->setThrottle(
-        opts.target_max_inflight_requests, opts.target_max_pending_requests);
+    clientRef.setThrottle(
+        inflightWindow_ ? inflightWindow_->window()
+                        : opts.target_max_inflight_requests,
+        opts.target_max_pending_requests);
   }
 }
 
 void ProxyDestination::closeGracefully() {
-  if (client_) {
+  for (size_t i = 0; i < clients_.size(); ++i) {
+    closeGracefully(i);
+  }
+}
+
+void ProxyDestination::closeGracefully(size_t idx) {
+  if (clients_[idx]) {
     // In case we have outstanding probe, we should close now, to get it
     // properly cleared.
     if (probeInflight_) {
-      client_->closeNow();
+      clients_[idx]->closeNow();
     }
     // Check again, in case we reset it in closeNow()
-    if (client_) {
-      client_->setStatusCallbacks(nullptr, nullptr);
+    if (clients_[idx]) {
+      clients_[idx]->setStatusCallbacks(nullptr, nullptr);
       std::unique_ptr<AsyncMcClient> client;
       {
         folly::SpinLockGuard g(clientLock_);
-        client = std::move(client_);
+        client = std::move(clients_[idx]);
       }
       client.reset();
     }
   }
 }
 
-AsyncMcClient& ProxyDestination::getAsyncMcClient() {
-  if (!client_) {
-    initializeAsyncMcClient();
+AsyncMcClient* ProxyDestination::getAsyncMcClient(
+    std::chrono::milliseconds connectTimeout) {
+  // Pick the connection with the fewest outstanding requests. New
+  // connections are only established once all existing ones are busy.
+  size_t best = clients_.size();
+  size_t bestLoad = std::numeric_limits<size_t>::max();
+  size_t firstEmpty = clients_.size();
+  for (size_t i = 0; i < clients_.size(); ++i) {
+    if (!clients_[i]) {
+      firstEmpty = std::min(firstEmpty, i);
+      continue;
+    }
+    const auto load = clients_[i]->getPendingRequestCount() +
+        clients_[i]->getInflightRequestCount();
+    if (load < bestLoad) {
+      best = i;
+      bestLoad = load;
+    }
+  }
+  if (best == clients_.size()) {
+    best = firstEmpty;
+    initializeAsyncMcClient(best);
+  } else if (
+      firstEmpty != clients_.size() && bestLoad > 0 &&
+      proxy.destinationMap()->connectThrottle().tryAcquire()) {
+    // Extra connections are opened only if the connect budget allows right
+    // away, otherwise the busy one is used.
+    best = firstEmpty;
+    initializeAsyncMcClient(best);
+    needsConnect_[best] = false;
+  }
+
+  // Every connection attempt, including reconnects of connections that went
+  // down, takes exactly one max_new_connections_per_second token. Requests
+  // that come while the connection is being established don't.
+  if (needsConnect_[best]) {
+    if (proxy.router().connectTokenBucket() != nullptr &&
+        !proxy.destinationMap()->connectThrottle().acquire(
+            *this, connectTimeout)) {
+      return nullptr;
+    }
+    needsConnect_[best] = false;
+    if (!clients_[best]) {
+      // Closed while waiting for the budget.
+      initializeAsyncMcClient(best);
+      needsConnect_[best] = false;
+    }
+  }
+  return clients_[best].get();
+}
+
+bool ProxyDestination::hasConnection() const {
+  for (const auto& client : clients_) {
+    if (client) {
+      return true;
+    }
   }
-  return *client_;
+  return false;
+}
+
+void ProxyDestination::prewarm(std::shared_ptr<ConnectionWarmUp> warmUp) {
+  if (warmUp) {
+    if (stats_.state == State::kUp) {
+      warmUp->settle(true);
+      return;
+    }
+    if (tracker->isTko()) {
+      // Won't be up any time soon, don't hold the new config back for it.
+      warmUp->settle(false);
+      return;
+    }
+    settleWarmUp(false);
+    warmUp_ = std::move(warmUp);
+  }
+  if (hasConnection()) {
+    if (stats_.state != State::kNew) {
+      // The connection is down or closed, the next request reconnects.
+      settleWarmUp(false);
+    }
+    // Otherwise already connecting.
+    return;
+  }
+  // ConnectThrottle already took the connect budget for this connection.
+  initializeAsyncMcClient(0);
+  needsConnect_[0] = false;
+  proxy.fiberManager().addTask([selfPtr = selfPtr_]() {
+    auto pdstn = selfPtr.lock();
+    if (pdstn == nullptr) {
+      return;
+    }
+    pdstn->proxy.destinationMap()->markAsActive(*pdstn);
+    // Connection failures are accounted for by the status callbacks.
+    if (auto* client = pdstn->getAsyncMcClient(pdstn->shortestTimeout_)) {
+      client->sendSync(McVersionRequest(), pdstn->shortestTimeout_);
+    }
+  });
+}
+
+void ProxyDestination::settleWarmUp(bool up) {
+  if (warmUp_) {
+    warmUp_->settle(up);
+    warmUp_.reset();
+  }
+}
+
+void ProxyDestination::updateNumConnections(size_t numConnections) {
+  if (numConnections <= numConnections_) {
+    return;
+  }
+  folly::SpinLockGuard g(clientLock_);
+  clients_.resize(numConnections);
+  needsConnect_.resize(numConnections, true);
+  numConnections_ = numConnections;
 }
 
 void ProxyDestination::onTkoEvent(TkoLogEvent event, mc_res_t result) const {
+  MC_TRACEPOINT(
+      tko_event,
+      pdstnKey_.data(),
+      pdstnKey_.size(),
+      static_cast<int>(event));
+
   auto logUtil = [this, result](folly::StringPiece eventStr) {
     VLOG(1) << accessPoint_->toHostPortString() << " " << eventStr
             << ". Total hard TKOs: " << tracker->globalTkos().hardTkos
@@ -463,6 +929,12 @@ void ProxyDestination::onTkoEvent(TkoLogEvent event, mc_res_t result) const {
     case TkoLogEvent::MarkSoftTko:
       logUtil("marked soft TKO");
       break;
+    case TkoLogEvent::MarkLatencyTko:
+      logUtil("marked soft TKO as a latency outlier");
+      break;
+    case TkoLogEvent::MarkErrorRateTko:
+      logUtil("marked soft TKO for a high error rate");
+      break;
     case TkoLogEvent::UnMarkTko:
       logUtil("unmarked TKO");
       break;
@@ -522,8 +994,10 @@ void ProxyDestination::updateShortestTimeout(
   if (shortestTimeout_.count() == 0 || shortestTimeout_ > timeout) {
     shortestTimeout_ = timeout;
     folly::SpinLockGuard g(clientLock_);
-    if (client_) {
-      client_->updateWriteTimeout(shortestTimeout_);
+    for (auto& client : clients_) {
+      if (client) {
+        client->updateWriteTimeout(shortestTimeout_);
+      }
     }
   }
 }
@@ -10,21 +10,23 @@
 #include <array>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <folly/IntrusiveList.h>
 #include <folly/Range.h>
 #include <folly/SpinLock.h>
 
+#include "mcrouter/AdaptiveTimeout.h"
+#include "mcrouter/ErrorRateWindow.h"
 #include "mcrouter/ExponentialSmoothData.h"
+#include "mcrouter/InflightWindow.h"
+#include "mcrouter/LatencyHistogram.h"
+#include "mcrouter/ProxyDestinationMap.h"
 #include "mcrouter/TkoLog.h"
 #include "mcrouter/config.h"
 #include "mcrouter/lib/Operation.h"
 #include "mcrouter/lib/mc/msg.h"
 
-namespace folly {
-class AsyncTimeout;
-} // namespace folly
-
 namespace facebook {
 namespace memcache {
 
@@ -35,12 +37,32 @@ struct ReplyStatsContext;
 namespace mcrouter {
 
 class ProxyBase;
-class ProxyDestinationMap;
+class ConnectionWarmUp;
 class TkoTracker;
 
+/**
+ * Per-pool settings of the windowed error rate circuit breaker. Once at least
+ * minRequests requests were sent within window and at least threshold of them
+ * failed with a TKO error, the destination is marked soft TKO. While TKO, up
+ * to halfOpenRatio of real requests are let through, and the first one that
+ * succeeds unmarks the destination (as does a successful probe).
+ */
+struct ErrorRateTkoSettings {
+  double threshold{0.0}; // 0 means disabled
+  size_t minRequests{20};
+  std::chrono::milliseconds window{10000};
+  double halfOpenRatio{0.01};
+
+  bool enabled() const {
+    return threshold > 0.0;
+  }
+};
+
 struct DestinationRequestCtx {
   int64_t startTime{0};
   int64_t endTime{0};
+  // Sent only once no other request to the destination waits to be sent.
+  bool lowPriority{false};
 
   explicit DestinationRequestCtx(int64_t now) : startTime(now) {}
 };
@@ -58,9 +80,16 @@ class ProxyDestination {
   struct Stats {
     State state{State::kNew};
     ExponentialSmoothData<16> avgLatency;
+    // Only allocated if destination_latency_histograms is set.
+    std::unique_ptr<RecentLatencyHistogram> latencies;
     std::unique_ptr<std::array<uint64_t, mc_nres>> results;
     size_t probesSent{0};
     double retransPerKByte{0.0};
+    // Writer loops that sent requests, requests they sent and the socket
+    // writes they took.
+    size_t batches{0};
+    size_t batchedRequests{0};
+    size_t writes{0};
   };
 
   ProxyBase& proxy; // for convenience
@@ -78,12 +107,20 @@ class ProxyDestination {
       ReplyStatsContext& replyStatsContext);
 
   // returns true if okay to send req using this client
-  bool may_send() const;
+  bool may_send();
 
   // Returns true if the current request should be dropped
   template <class Request>
   bool shouldDrop() const;
 
+  /**
+   * @return true if requests that can go to another replica should: once
+   *         target_max_pending_requests requests are queued on every
+   *         connection, until the least loaded one drains to
+   *         spillover_resume_pending_ratio of that.
+   */
+  bool spilloverSaturated();
+
   /**
    * @return stats for ProxyDestination
    */
@@ -103,13 +140,67 @@ class ProxyDestination {
   void updateShortestTimeout(std::chrono::milliseconds timeout);
 
   /**
-   * Gracefully closes the connection, allowing it to properly drain if
+   * @return timeout to use for a request routed with `timeout`. That is
+   *         `timeout` itself, unless adaptive timeouts are enabled
+   *         (adaptive_timeout_quantile) and enough replies were seen to
+   *         estimate the latency quantile of this destination.
+   */
+  std::chrono::milliseconds effectiveTimeout(
+      std::chrono::milliseconds timeout) const;
+
+  /**
+   * Makes sure at least numConnections connections are used for this
+   * destination. Requests are dispatched to the connection with the fewest
+   * pending + inflight requests.
+   */
+  void updateNumConnections(size_t numConnections);
+
+  size_t numConnections() const {
+    return numConnections_;
+  }
+
+  /**
+   * @return true if at least one connection to this destination was opened
+   *         (it may not be up yet).
+   */
+  bool hasConnection() const;
+
+  /**
+   * Opens a connection in the background, without waiting for a request.
+   * Called by ConnectThrottle for prewarm_connections and warm start.
+   *
+   * @param warmUp  if set, this destination is settled in it once its
+   *                connection is up or failed. Right away if it is already
+   *                up, TKO, or its connection is down.
+   */
+  void prewarm(std::shared_ptr<ConnectionWarmUp> warmUp = nullptr);
+
+  /**
+   * Marks this destination TKO (hard or soft) because it was TKO before a
+   * restart, and starts probing it, unless it's already TKO.
+   */
+  void restoreTko(bool hard);
+
+  /**
+   * Enables the error rate circuit breaker with `settings`. If several pools
+   * configure it for this destination, the lowest threshold wins.
+   */
+  void updateErrorRateTko(const ErrorRateTkoSettings& settings);
+
+  /**
+   * Gracefully closes all connections, allowing them to properly drain if
    * possible.
    */
   void closeGracefully();
 
  private:
-  std::unique_ptr<AsyncMcClient> client_;
+  // Connections to the destination. Has numConnections_ slots, nullptr means
+  // the connection wasn't established yet (or was closed).
+  std::vector<std::unique_ptr<AsyncMcClient>> clients_;
+  // True for the slots whose next request (re)connects, and thus has to
+  // take a connect token first.
+  std::vector<bool> needsConnect_;
+  size_t numConnections_{1};
   const std::shared_ptr<const AccessPoint> accessPoint_;
   // Ensure proxy thread doesn't reset AsyncMcClient
   // while config and stats threads may be accessing it
@@ -123,50 +214,152 @@ class ProxyDestination {
 
   Stats stats_;
 
+  // nullptr unless adaptive_timeout_quantile.
+  std::unique_ptr<AdaptiveTimeout> adaptiveTimeout_;
+
+  // Inflight limit of the connections, nullptr unless target_inflight_aimd.
+  std::unique_ptr<InflightWindow> inflightWindow_;
+
+  ErrorRateTkoSettings errorRateTko_;
+  ErrorRateWindow errorRateWindow_;
+  // Set by send() for the duration of a half-open sample, see
+  // reserveHalfOpenSample().
+  bool halfOpenSampleInflight_{false};
+  // Successful samples in a row since the destination was marked TKO.
+  size_t halfOpenSuccesses_{0};
+  // When the last tko_canary_ratio sample was sent.
+  int64_t lastCanaryUs_{0};
+  bool canarySentSinceProbe_{false};
+
+  // See spilloverSaturated().
+  bool spilloverSaturated_{false};
+
+  // Warm up waiting for a connection to this destination to come up.
+  std::shared_ptr<ConnectionWarmUp> warmUp_;
+
   uint64_t lastRetransCycles_{0}; // Cycles when restransmits were last fetched
   uint64_t rxmitsToCloseConnection_{0};
   uint64_t lastConnCloseCycles_{0}; // Cycles when connection was last closed
 
   int probe_delay_next_ms{0};
   bool probeInflight_{false};
-  // The string is stored in ProxyDestinationMap::destinations_
-  folly::StringPiece pdstnKey_; ///< consists of ap, server_timeout
+  // Id of the probes scheduled in ProbeScheduler, 0 if not sending probes.
+  uint64_t probeId_{0};
+  const ProxyDestinationKey destinationKey_;
+  // Printable form of destinationKey_ for logs and stats.
+  const std::string pdstnKey_; ///< consists of ap, server_timeout
 
-  std::unique_ptr<folly::AsyncTimeout> probeTimer_;
+  // True while requests may need to be forwarded to another proxy's
+  // destination, see sharedConnectionOwner().
+  bool forwardToOwner_{false};
+  std::weak_ptr<ProxyDestination> sharedOwner_;
 
   static std::shared_ptr<ProxyDestination> create(
       ProxyBase& proxy,
-      std::shared_ptr<AccessPoint> ap,
+      std::shared_ptr<const AccessPoint> ap,
+      const ProxyDestinationKey& key,
+      std::string printableKey,
       std::chrono::milliseconds timeout,
       uint64_t qosClass,
       uint64_t qosPath,
-      folly::StringPiece routerInfoName);
+      folly::StringPiece routerInfoName,
+      size_t numConnections);
 
   void setState(State st);
 
+  // Settles warmUp_, if any, and forgets it.
+  void settleWarmUp(bool up);
+
   void start_sending_probes();
   void stop_sending_probes();
 
   void schedule_next_probe();
 
+  // Called by ProbeScheduler when the next probe is due.
+  void onProbeTimer();
+
   void handle_tko(const mc_res_t result, bool is_probe_req);
 
+  // Counts the reply in the error rate window and marks this destination TKO
+  // if the error rate is over the threshold.
+  void handleErrorRateTko(mc_res_t result);
+
+  // Feeds the reply latency to adaptiveTimeout_.
+  void updateAdaptiveTimeout(mc_res_t result, int64_t latencyUs);
+
+  // Feeds inflightWindow_ and applies it to the connections if it changed.
+  void updateInflightWindow(mc_res_t result, int64_t latencyUs);
+
+  // Called by send() to turn the request into the half-open sample if the
+  // destination is TKO. Returns false if it isn't, or a sample is already
+  // in flight. may_send() only decides, so requests it let through that
+  // never reach send() (dropped, spilled over, ...) don't hold the sample.
+  bool reserveHalfOpenSample();
+
+  // Whether a sample let through now would be a tko_canary_ratio canary,
+  // rather than an error rate half-open sample.
+  bool isCanaryDue(int64_t nowUs) const;
+
+  // Called by send() once the half-open sample is actually sent. Canaries
+  // are counted (and make probes unnecessary) from here, not from
+  // may_send(), which may let through requests that are never sent.
+  void onHalfOpenSampleSent();
+
+  // Unmarks TKO once enough real requests let through by may_send() in a row
+  // succeeded: one for error rate TKOs, tko_canary_successes for others.
+  void onHalfOpenSampleReply(mc_res_t result);
+
+  // Feeds the latency outlier detector and ejects this destination if it
+  // was picked as an outlier, see TkoTrackerMap::updateLatencyOutliers().
+  void handleLatencyTko(mc_res_t result, int64_t latencyUs);
+
+  /**
+   * In shared connection mode (shared_destination_connections), returns the
+   * ProxyDestination with the same key owned by the proxy that holds the
+   * connections to this destination. Returns nullptr if requests should be
+   * sent from this proxy (this proxy is the owner, the mode is off, or the
+   * owner doesn't have this destination yet).
+   */
+  std::shared_ptr<ProxyDestination> sharedConnectionOwner();
+
+  /**
+   * Sends the request through owner's connections on owner's proxy thread,
+   * and blocks the current fiber until the reply comes back. timeout runs
+   * from the call, the request times out without being sent if it's used
+   * up by the time the owner's thread gets to it.
+   */
+  template <class Request>
+  static ReplyT<Request> sendThroughOwner(
+      std::shared_ptr<ProxyDestination> owner,
+      const Request& request,
+      DestinationRequestCtx& requestContext,
+      std::chrono::milliseconds timeout,
+      ReplyStatsContext& replyStatsContext);
+
   // Process tko, stats and duration timer.
   void onReply(
       const mc_res_t result,
       DestinationRequestCtx& destreqCtx,
       const ReplyStatsContext& replyStatsContext);
 
-  AsyncMcClient& getAsyncMcClient();
-  void initializeAsyncMcClient();
+  // Returns the least loaded connection, establishing it if needed. A
+  // connection that has to be (re)established waits for the
+  // max_new_connections_per_second budget first, nullptr is returned if it
+  // didn't come in `connectTimeout`.
+  AsyncMcClient* getAsyncMcClient(std::chrono::milliseconds connectTimeout);
+  void initializeAsyncMcClient(size_t idx);
+  void closeGracefully(size_t idx);
 
   ProxyDestination(
       ProxyBase& proxy,
-      std::shared_ptr<AccessPoint> ap,
+      std::shared_ptr<const AccessPoint> ap,
+      const ProxyDestinationKey& key,
+      std::string printableKey,
       std::chrono::milliseconds timeout,
       uint64_t qosClass,
       uint64_t qosPath,
-      folly::StringPiece routerInfoName);
+      folly::StringPiece routerInfoName,
+      size_t numConnections);
 
   void onTkoEvent(TkoLogEvent event, mc_res_t result) const;
 
@@ -181,6 +374,7 @@ class ProxyDestination {
 
   std::weak_ptr<ProxyDestination> selfPtr_;
 
+  friend class ProbeScheduler;
   friend class ProxyDestinationMap;
 };
 
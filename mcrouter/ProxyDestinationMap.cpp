@@ -7,9 +7,11 @@
  */
 #include "ProxyDestinationMap.h"
 
+#include <functional>
 #include <memory>
 
 #include <folly/Format.h>
+#include <folly/hash/Hash.h>
 #include <folly/io/async/AsyncTimeout.h>
 #include <folly/io/async/EventBase.h>
 
@@ -26,12 +28,17 @@ namespace mcrouter {
 
 namespace {
 
-std::string genProxyDestinationKey(
+bool keyedByTimeout(const AccessPoint& ap) {
+  // we cannot send requests with different timeouts for ASCII, since
+  // it will break in-order nature of the protocol
+  return ap.getProtocol() == mc_ascii_protocol ||
+      ap.getProtocol() == mc_meta_protocol;
+}
+
+std::string genPrintableKey(
     const AccessPoint& ap,
     std::chrono::milliseconds timeout) {
-  if (ap.getProtocol() == mc_ascii_protocol) {
-    // we cannot send requests with different timeouts for ASCII, since
-    // it will break in-order nature of the protocol
+  if (keyedByTimeout(ap)) {
     return folly::sformat("{}-{}", ap.toString(), timeout.count());
   } else {
     return ap.toString();
@@ -40,6 +47,15 @@ std::string genProxyDestinationKey(
 
 } // anonymous
 
+ProxyDestinationKey::ProxyDestinationKey(
+    const AccessPoint& internedAp,
+    std::chrono::milliseconds timeout)
+    : accessPoint(&internedAp),
+      timeoutMs(keyedByTimeout(internedAp) ? timeout.count() : 0),
+      hash(folly::hash::hash_combine(
+          std::hash<const AccessPoint*>()(accessPoint),
+          timeoutMs)) {}
+
 struct ProxyDestinationMap::StateList {
   using List =
       folly::IntrusiveList<ProxyDestination, &ProxyDestination::stateListHook_>;
@@ -53,18 +69,28 @@ ProxyDestinationMap::ProxyDestinationMap(ProxyBase* proxy)
       inactivityTimeout_(0) {}
 
 std::shared_ptr<ProxyDestination> ProxyDestinationMap::emplace(
-    std::shared_ptr<AccessPoint> ap,
+    std::shared_ptr<const AccessPoint> ap,
     std::chrono::milliseconds timeout,
     uint64_t qosClass,
     uint64_t qosPath,
-    folly::StringPiece routerInfoName) {
-  auto key = genProxyDestinationKey(*ap, timeout);
+    folly::StringPiece routerInfoName,
+    size_t numConnections) {
+  assert(AccessPoint::intern(*ap) == ap);
+  ProxyDestinationKey key(*ap, timeout);
+  auto printableKey = genPrintableKey(*ap, timeout);
   auto destination = ProxyDestination::create(
-      *proxy_, std::move(ap), timeout, qosClass, qosPath, routerInfoName);
+      *proxy_,
+      std::move(ap),
+      key,
+      std::move(printableKey),
+      timeout,
+      qosClass,
+      qosPath,
+      routerInfoName,
+      numConnections);
   {
     std::lock_guard<std::mutex> lck(destinationsLock_);
-    auto destIt = destinations_.emplace(key, destination);
-    destination->pdstnKey_ = destIt.first->first;
+    destinations_.emplace(key, destination);
   }
 
   // Update shared area of ProxyDestinations with same key from different
@@ -72,6 +98,34 @@ std::shared_ptr<ProxyDestination> ProxyDestinationMap::emplace(
   proxy_->router().tkoTrackerMap().updateTracker(
       *destination, proxy_->router().opts().failures_until_tko);
 
+  // Hosts that were TKO before a restart start out TKO.
+  if (auto hard = proxy_->router().tkoTrackerMap().popRestoredTko(
+          destination->accessPoint()->toHostPortString())) {
+    proxy_->eventBase().runInEventBaseThread(
+        [weakDestination = std::weak_ptr<ProxyDestination>(destination),
+         hard = *hard]() {
+          if (auto pdstn = weakDestination.lock()) {
+            pdstn->restoreTko(hard);
+          }
+        });
+  }
+
+  // Destinations are usually created on the config thread, the prewarm
+  // queue lives on the proxy thread.
+  if (numPrewarmed_.load() < proxy_->router().opts().prewarm_connections &&
+      numPrewarmed_++ < proxy_->router().opts().prewarm_connections) {
+    proxy_->eventBase().runInEventBaseThread(
+        [weakDestination = std::weak_ptr<ProxyDestination>(destination)]() {
+          auto pdstn = weakDestination.lock();
+          if (!pdstn) {
+            return;
+          }
+          if (auto* destinationMap = pdstn->proxy.destinationMap()) {
+            destinationMap->connectThrottle().prewarm(weakDestination);
+          }
+        });
+  }
+
   return destination;
 }
 
@@ -82,16 +136,26 @@ std::shared_ptr<ProxyDestination> ProxyDestinationMap::emplace(
 std::shared_ptr<ProxyDestination> ProxyDestinationMap::find(
     const AccessPoint& ap,
     std::chrono::milliseconds timeout) const {
-  auto key = genProxyDestinationKey(ap, timeout);
+  ProxyDestinationKey key(ap, timeout);
   {
     std::lock_guard<std::mutex> lck(destinationsLock_);
     return find(key);
   }
 }
 
+std::shared_ptr<ProxyDestination> ProxyDestinationMap::findByKey(
+    const ProxyDestinationKey& key) const {
+  std::lock_guard<std::mutex> lck(destinationsLock_);
+  auto it = destinations_.find(key);
+  if (it == destinations_.end()) {
+    return nullptr;
+  }
+  return it->second.lock();
+}
+
 // Note: caller must be holding destionationsLock_.
 std::shared_ptr<ProxyDestination> ProxyDestinationMap::find(
-    const std::string& key) const {
+    const ProxyDestinationKey& key) const {
   auto it = destinations_.find(key);
   if (it == destinations_.end()) {
     return nullptr;
@@ -107,10 +171,15 @@ void ProxyDestinationMap::removeDestination(ProxyDestination& destination) {
   }
   {
     std::lock_guard<std::mutex> lck(destinationsLock_);
-    destinations_.erase(destination.pdstnKey_);
+    destinations_.erase(destination.destinationKey_);
   }
 }
 
+folly::StringPiece ProxyDestinationMap::printableKey(
+    const ProxyDestination& destination) {
+  return destination.pdstnKey_;
+}
+
 void ProxyDestinationMap::markAsActive(ProxyDestination& destination) {
   if (destination.stateList_ == active_.get()) {
     return;
@@ -142,6 +211,20 @@ void ProxyDestinationMap::setResetTimer(std::chrono::milliseconds interval) {
   scheduleTimer(true /* initialAttempt */);
 }
 
+ProbeScheduler& ProxyDestinationMap::probeScheduler() {
+  if (!probeScheduler_) {
+    probeScheduler_ = std::make_unique<ProbeScheduler>(*proxy_);
+  }
+  return *probeScheduler_;
+}
+
+ConnectThrottle& ProxyDestinationMap::connectThrottle() {
+  if (!connectThrottle_) {
+    connectThrottle_ = std::make_unique<ConnectThrottle>(*proxy_);
+  }
+  return *connectThrottle_;
+}
+
 void ProxyDestinationMap::scheduleTimer(bool initialAttempt) {
   if (!resetTimer_->scheduleTimeout(inactivityTimeout_)) {
     MC_LOG_FAILURE(
@@ -7,6 +7,7 @@
  */
 #pragma once
 
+#include <atomic>
 #include <chrono>
 #include <memory>
 #include <mutex>
@@ -15,9 +16,11 @@
 #include <vector>
 
 #include <folly/Range.h>
-#include <folly/experimental/StringKeyedUnorderedMap.h>
 #include <folly/io/async/AsyncTimeout.h>
 
+#include "mcrouter/ConnectThrottle.h"
+#include "mcrouter/ProbeScheduler.h"
+
 namespace facebook {
 namespace memcache {
 
@@ -28,6 +31,32 @@ namespace mcrouter {
 class ProxyBase;
 class ProxyDestination;
 
+/**
+ * Identifies a ProxyDestination within a process: an interned AccessPoint
+ * (see AccessPoint::intern()) and, for protocols that can't mix timeouts on
+ * one connection, the timeout. The hash is computed once, and neither
+ * hashing nor comparison touches the AccessPoint itself.
+ */
+struct ProxyDestinationKey {
+  ProxyDestinationKey(
+      const AccessPoint& internedAp,
+      std::chrono::milliseconds timeout);
+
+  const AccessPoint* accessPoint;
+  int64_t timeoutMs;
+  size_t hash;
+
+  bool operator==(const ProxyDestinationKey& other) const {
+    return accessPoint == other.accessPoint && timeoutMs == other.timeoutMs;
+  }
+
+  struct Hash {
+    size_t operator()(const ProxyDestinationKey& key) const {
+      return key.hash;
+    }
+  };
+};
+
 /**
  * Manages lifetime of ProxyDestinations. Main goal is to reuse same
  * ProxyDestinations (thus do not close opened connecitons) during
@@ -49,20 +78,33 @@ class ProxyDestinationMap {
   /**
    * If ProxyDestination is already stored in this object - returns it;
    * otherwise, returns nullptr.
+   *
+   * @param ap  must be interned, see AccessPoint::intern().
    */
   std::shared_ptr<ProxyDestination> find(
       const AccessPoint& ap,
       std::chrono::milliseconds timeout) const;
+  /**
+   * Same as find(ap, timeout), for a key of a ProxyDestination of any
+   * proxy (see ProxyDestination::destinationKey_). Safe to call from any
+   * thread.
+   */
+  std::shared_ptr<ProxyDestination> findByKey(
+      const ProxyDestinationKey& key) const;
+
   /**
    * If ProxyDestination is already stored in this object - returns it;
    * otherwise creates a new one.
+   *
+   * @param ap  must be interned, see AccessPoint::intern().
    */
   std::shared_ptr<ProxyDestination> emplace(
-      std::shared_ptr<AccessPoint> ap,
+      std::shared_ptr<const AccessPoint> ap,
       std::chrono::milliseconds timeout,
       uint64_t qosClass,
       uint64_t qosPath,
-      folly::StringPiece routerInfoName);
+      folly::StringPiece routerInfoName,
+      size_t numConnections = 1);
 
   /**
    * Remove destination from both active and inactive lists
@@ -88,8 +130,21 @@ class ProxyDestinationMap {
   void setResetTimer(std::chrono::milliseconds interval);
 
   /**
-   * Calls f(Key, const ProxyDestination&) for each destination stored
-   * in ProxyDestinationMap. The whole map is locked during the call.
+   * Scheduler of the TKO probes of this proxy's destinations. Created on
+   * first use; must only be used from the proxy thread.
+   */
+  ProbeScheduler& probeScheduler();
+
+  /**
+   * Rate limiter of the new connections of this proxy's destinations.
+   * Created on first use; must only be used from the proxy thread.
+   */
+  ConnectThrottle& connectThrottle();
+
+  /**
+   * Calls f(StringPiece key, const ProxyDestination&) for each destination
+   * stored in ProxyDestinationMap, where key is the printable form of the
+   * destination's key. The whole map is locked during the call.
    *
    * TODO: replace with getStats()
    */
@@ -103,7 +158,7 @@ class ProxyDestinationMap {
       std::lock_guard<std::mutex> lock(destinationsLock_);
       for (auto& it : destinations_) {
         if (std::shared_ptr<const ProxyDestination> d = it.second.lock()) {
-          f(it.first, *d);
+          f(printableKey(*d), *d);
           toFree.push_back(std::move(d));
         }
       }
@@ -116,7 +171,11 @@ class ProxyDestinationMap {
   struct StateList;
 
   ProxyBase* proxy_;
-  folly::StringKeyedUnorderedMap<std::weak_ptr<ProxyDestination>> destinations_;
+  std::unordered_map<
+      ProxyDestinationKey,
+      std::weak_ptr<ProxyDestination>,
+      ProxyDestinationKey::Hash>
+      destinations_;
   mutable std::mutex destinationsLock_;
 
   std::unique_ptr<StateList> active_;
@@ -124,13 +183,20 @@ class ProxyDestinationMap {
 
   uint32_t inactivityTimeout_;
   std::unique_ptr<folly::AsyncTimeout> resetTimer_;
+  std::unique_ptr<ProbeScheduler> probeScheduler_;
+  std::unique_ptr<ConnectThrottle> connectThrottle_;
+  // Number of destinations queued for prewarm (see prewarm_connections).
+  std::atomic<size_t> numPrewarmed_{0};
 
   /**
    * If ProxyDestination is already stored in this object - returns it;
    * otherwise, returns nullptr.
    * Note: caller must be holding destionationsLock_.
    */
-  std::shared_ptr<ProxyDestination> find(const std::string& key) const;
+  std::shared_ptr<ProxyDestination> find(
+      const ProxyDestinationKey& key) const;
+
+  static folly::StringPiece printableKey(const ProxyDestination& destination);
 
   /**
    * Schedules timeout for resetting inactive connections.
@@ -0,0 +1,110 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include "ProxyGroups.h"
+
+#include <stdexcept>
+
+#include <folly/Conv.h>
+#include <folly/String.h>
+
+#include "mcrouter/RoutingPrefix.h"
+#include "mcrouter/lib/fbi/cpp/util.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+namespace {
+
+size_t parseProxyId(folly::StringPiece s, size_t numProxies) {
+  auto id = folly::tryTo<size_t>(s);
+  checkLogic(
+      id.hasValue() && id.value() < numProxies,
+      "proxy_groups: invalid proxy id '{}', expected 0 to {}",
+      s,
+      numProxies - 1);
+  return id.value();
+}
+
+} // anonymous namespace
+
+ProxyGroups::ProxyGroups(
+    folly::StringPiece spec,
+    size_t numProxies,
+    folly::StringPiece defaultRoute)
+    : defaultRoute_(defaultRoute.str()) {
+  std::vector<bool> taken(numProxies, false);
+  std::vector<folly::StringPiece> items;
+  folly::split(',', spec, items, /* ignoreEmpty */ true);
+  for (auto item : items) {
+    auto colon = item.rfind(':');
+    checkLogic(
+        colon != folly::StringPiece::npos,
+        "proxy_groups: invalid group '{}', expected "
+        "<routing prefix>:<first proxy id>[-<last proxy id>]",
+        item);
+
+    std::string prefix;
+    try {
+      prefix = RoutingPrefix(item.subpiece(0, colon)).str();
+    } catch (const std::invalid_argument& e) {
+      throwLogic("proxy_groups: {}", e.what());
+    }
+    for (const auto& group : groups_) {
+      checkLogic(
+          group.first != prefix,
+          "proxy_groups: duplicate routing prefix {}",
+          prefix);
+    }
+
+    folly::StringPiece firstStr;
+    folly::StringPiece lastStr;
+    auto range = item.subpiece(colon + 1);
+    if (!folly::split('-', range, firstStr, lastStr)) {
+      firstStr = lastStr = range;
+    }
+    auto first = parseProxyId(firstStr, numProxies);
+    auto last = parseProxyId(lastStr, numProxies);
+    checkLogic(first <= last, "proxy_groups: invalid range '{}'", range);
+
+    std::vector<size_t> ids;
+    for (auto id = first; id <= last; ++id) {
+      checkLogic(
+          !taken[id], "proxy_groups: proxy {} is in more than one group", id);
+      taken[id] = true;
+      ids.push_back(id);
+    }
+    groups_.emplace_back(std::move(prefix), std::move(ids));
+  }
+
+  for (size_t id = 0; id < numProxies; ++id) {
+    if (!taken[id]) {
+      defaultProxies_.push_back(id);
+    }
+  }
+  checkLogic(
+      !defaultProxies_.empty(),
+      "proxy_groups: no proxy is left for the other routing prefixes");
+}
+
+const std::vector<size_t>& ProxyGroups::proxiesFor(
+    folly::StringPiece routingPrefix) const {
+  if (routingPrefix.empty()) {
+    routingPrefix = defaultRoute_;
+  }
+  for (const auto& group : groups_) {
+    if (routingPrefix == group.first) {
+      return group.second;
+    }
+  }
+  return defaultProxies_;
+}
+
+} // mcrouter
+} // memcache
+} // facebook
@@ -0,0 +1,79 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <folly/Range.h>
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Dedicated proxy threads for routing prefixes (proxy_groups option), so
+ * that a flood of requests to one routing prefix (e.g. a tenant's) only
+ * slows down the proxies of that prefix.
+ *
+ * Every configured routing prefix gets its own range of proxy ids. Requests
+ * for any other routing prefix, and requests without one, go to the default
+ * group: the proxies not given to any routing prefix.
+ */
+class ProxyGroups {
+ public:
+  /**
+   * @param spec          comma separated list of
+   *                      "<routing prefix>:<first proxy id>[-<last proxy id>]",
+   *                      e.g. "/a/tenant1/:0-3,/a/tenant2/:4". Empty for no
+   *                      groups.
+   * @param numProxies    total number of proxies.
+   * @param defaultRoute  routing prefix of requests without one.
+   *
+   * @throws std::logic_error if spec is malformed, ranges overlap or are out
+   *         of [0, numProxies), or no proxy is left for the default group.
+   */
+  ProxyGroups(
+      folly::StringPiece spec,
+      size_t numProxies,
+      folly::StringPiece defaultRoute);
+
+  bool empty() const {
+    return groups_.empty();
+  }
+
+  /**
+   * @param routingPrefix  routing prefix of the request, empty if it has
+   *                       none.
+   *
+   * @return  ids of the proxies serving requests with the given routing
+   *          prefix. Never empty.
+   */
+  const std::vector<size_t>& proxiesFor(
+      folly::StringPiece routingPrefix) const;
+
+  /**
+   * @return  ids of the proxies not dedicated to any routing prefix.
+   */
+  const std::vector<size_t>& defaultProxies() const {
+    return defaultProxies_;
+  }
+
+ private:
+  // There are only a few groups, looked up on every request: a linear scan
+  // doesn't need to copy the routing prefix into a std::string.
+  std::vector<std::pair<std::string, std::vector<size_t>>> groups_;
+  std::vector<size_t> defaultProxies_;
+  std::string defaultRoute_;
+};
+
+} // mcrouter
+} // memcache
+} // facebook
@@ -7,6 +7,7 @@
  */
 #include "ProxyRequestContext.h"
 
+#include <algorithm>
 #include <memory>
 
 #include "mcrouter/CarbonRouterClientBase.h"
@@ -20,8 +21,14 @@ namespace mcrouter {
 ProxyRequestContext::ProxyRequestContext(
     ProxyBase& pr,
     ProxyRequestPriority priority__)
-    : proxyBase_(pr), priority_(priority__) {
+    : proxyBase_(pr),
+      arena_(pr.getRouterOptions().request_arena_max_bytes),
+      priority_(priority__) {
   proxyBase_.stats().incrementSafe(proxy_request_num_outstanding_stat);
+  auto deadlineMs = proxyBase_.getRouterOptions().request_deadline_ms;
+  if (deadlineMs > 0) {
+    tightenDeadline(std::chrono::milliseconds(deadlineMs));
+  }
 }
 
 ProxyRequestContext::~ProxyRequestContext() {
@@ -32,6 +39,10 @@ ProxyRequestContext::~ProxyRequestContext() {
 
   assert(replied_);
 
+  if (chargedBytes_ != 0) {
+    proxyBase_.memoryBudget().charge(-chargedBytes_);
+  }
+
   if (processing_) {
     --proxyBase_.numRequestsProcessing_;
     proxyBase_.stats().decrement(proxy_reqs_processing_stat);
@@ -62,6 +73,32 @@ void ProxyRequestContext::setSenderIdForTest(uint64_t id) {
   senderIdForTest_ = id;
 }
 
+void ProxyRequestContext::chargeMemory(int64_t bytes) {
+  proxyBase_.memoryBudget().charge(bytes);
+  chargedBytes_ += bytes;
+}
+
+void ProxyRequestContext::tightenDeadline(std::chrono::milliseconds budget) {
+  auto deadline = proxyBase_.loopNowUs() + budget.count() * 1000;
+  if (deadlineUs_ == 0 || deadline < deadlineUs_) {
+    deadlineUs_ = deadline;
+  }
+}
+
+bool ProxyRequestContext::deadlineExceeded() const {
+  return deadlineUs_ != 0 && proxyBase_.loopNowUs() >= deadlineUs_;
+}
+
+std::chrono::milliseconds ProxyRequestContext::clampToDeadline(
+    std::chrono::milliseconds timeout) const {
+  if (deadlineUs_ == 0) {
+    return timeout;
+  }
+  auto leftMs = std::max<int64_t>(
+      (deadlineUs_ - proxyBase_.loopNowUs() + 999) / 1000, 1);
+  return std::min(timeout, std::chrono::milliseconds(leftMs));
+}
+
 ProxyRequestContext::ProxyRequestContext(
     RecordingT,
     ProxyBase& pr,
@@ -69,6 +106,7 @@ ProxyRequestContext::ProxyRequestContext(
     ShardSplitCallback shardSplitCallback)
     /* pr.nextRequestId() is not threadsafe */
     : proxyBase_(pr),
+      arena_(0),
       recording_(true) {
   new (&recordingState_)
       std::unique_ptr<RecordingState>(std::make_unique<RecordingState>());
@@ -7,6 +7,7 @@
  */
 #pragma once
 
+#include <chrono>
 #include <memory>
 #include <string>
 
@@ -14,6 +15,7 @@
 #include <folly/fibers/FiberManager.h>
 
 #include "mcrouter/ProxyRequestPriority.h"
+#include "mcrouter/RequestArena.h"
 #include "mcrouter/config-impl.h"
 #include "mcrouter/lib/mc/msg.h"
 
@@ -31,6 +33,8 @@ class ProxyRoute;
 
 class ProxyBase;
 class CarbonRouterClientBase;
+template <class RouterInfo>
+class ProxyRequestContextHandle;
 class ShardSplitter;
 
 struct PoolContext {
@@ -97,6 +101,13 @@ class ProxyRequestContext {
     return priority_;
   }
 
+  /**
+   * Charges bytes held on behalf of this request against the memory budget
+   * of the proxy. Everything charged is released on destruction.
+   * Should be called only from the attached proxy thread.
+   */
+  void chargeMemory(int64_t bytes);
+
   /**
    * Continues processing current request.
    * Should be called only from the attached proxy thread.
@@ -126,6 +137,40 @@ class ProxyRequestContext {
     requester_ = std::move(requester);
   }
 
+  /**
+   * Time (as returned by nowUs()) by which this request should be replied,
+   * or 0 if there's no deadline. Routes use it to avoid doing work whose
+   * result nobody is going to wait for.
+   */
+  int64_t deadlineUs() const {
+    return deadlineUs_;
+  }
+
+  /**
+   * Moves the deadline to nowUs() + budget, unless the current one is earlier.
+   */
+  void tightenDeadline(std::chrono::milliseconds budget);
+
+  /**
+   * @return  true iff the request has a deadline and it has already passed.
+   */
+  bool deadlineExceeded() const;
+
+  /**
+   * @return  timeout, clamped to the time left until the deadline (but at
+   *          least 1ms).
+   */
+  std::chrono::milliseconds clampToDeadline(
+      std::chrono::milliseconds timeout) const;
+
+  /**
+   * Memory released when this request completes, see RequestArena.
+   * Should be called only from the attached proxy thread.
+   */
+  RequestArena& arena() {
+    return arena_;
+  }
+
   void setFinalResult(mc_res_t result) {
     finalResult_ = result;
   }
@@ -173,6 +218,13 @@ class ProxyRequestContext {
 
   std::string userIpAddr_;
 
+  int64_t deadlineUs_{0};
+
+  /** Bytes charged to proxyBase_.memoryBudget() by this request */
+  int64_t chargedBytes_{0};
+
+  RequestArena arena_;
+
   ProxyRequestPriority priority_{ProxyRequestPriority::kCritical};
 
   bool failoverDisabled_{false};
@@ -181,6 +233,13 @@ class ProxyRequestContext {
   bool processing_{false};
   bool recording_{false};
 
+  /**
+   * Number of ProxyRequestContextHandles pointing to this context, and the
+   * single reference to it they share while there are any.
+   */
+  uint32_t numHandles_{0};
+  std::shared_ptr<ProxyRequestContext> handlesRef_;
+
   ProxyRequestContext(const ProxyRequestContext&) = delete;
   ProxyRequestContext(ProxyRequestContext&&) noexcept = delete;
   ProxyRequestContext& operator=(const ProxyRequestContext&) = delete;
@@ -208,6 +267,8 @@ class ProxyRequestContext {
 
  private:
   friend class ProxyBase;
+  template <class RouterInfo>
+  friend class ProxyRequestContextHandle;
 };
 
 } // mcrouter
@@ -7,6 +7,8 @@
  */
 #include "mcrouter/Proxy.h"
 #include "mcrouter/lib/McKey.h"
+#include "mcrouter/lib/McResUtil.h"
+#include "mcrouter/lib/RecyclingAllocator.h"
 #include "mcrouter/lib/fbi/cpp/TypeList.h"
 #include "mcrouter/lib/network/CarbonMessageList.h"
 #include "mcrouter/lib/network/gen/Memcache.h"
@@ -19,6 +21,10 @@ namespace detail {
 
 /**
  * Implementation class for storing the callback along with the context.
+ *
+ * Contexts are usually created and destroyed on the same proxy thread, so
+ * their memory is recycled per thread instead of going through malloc for
+ * every request.
  */
 template <class RouterInfo, class Request, class F>
 class ProxyRequestContextTypedWithCallback
@@ -32,6 +38,16 @@ class ProxyRequestContextTypedWithCallback
       : ProxyRequestContextTyped<RouterInfo, Request>(pr, req, priority__),
         f_(std::forward<F>(f)) {}
 
+  static void* operator new(size_t size) {
+    assert(size == sizeof(ProxyRequestContextTypedWithCallback));
+    return ThreadLocalRecycler<ProxyRequestContextTypedWithCallback>::
+        allocate();
+  }
+
+  static void operator delete(void* p) {
+    ThreadLocalRecycler<ProxyRequestContextTypedWithCallback>::deallocate(p);
+  }
+
  protected:
   void sendReplyImpl(ReplyT<Request>&& reply) final {
     auto req = this->req_;
@@ -52,8 +68,7 @@ bool precheckKey(
   constexpr bool kIsMemcacheRequest =
       ListContains<McRequestList, Request>::value;
 
-  auto key = req.key().fullKey();
-  auto err = isKeyValid<kIsMemcacheRequest>(key);
+  auto err = isKeyValid<kIsMemcacheRequest>(req.key());
   if (err != mc_req_err_valid) {
     ReplyT<Request> reply(mc_res_local_error);
     carbon::setMessageIfPresent(reply, mc_req_err_to_string(err));
@@ -134,6 +149,28 @@ void ProxyRequestContextTyped<RouterInfo, Request>::sendReply(
   }
   this->replied_ = true;
   auto result = reply.result();
+  if (auto* timeline = this->timeline()) {
+    timeline->record(RequestTimeline::Event::ReplySent, nowUs());
+  }
+
+  auto& prefixStats = this->proxy().keyPrefixStats();
+  if (prefixStats.enabled()) {
+    const auto* reqValue = carbon::valuePtrUnsafe(*req_);
+    const auto* replyValue = carbon::valuePtrUnsafe(reply);
+    folly::Optional<bool> hit;
+    if (isHitResult(result)) {
+      hit = true;
+    } else if (isMissResult(result)) {
+      hit = false;
+    }
+    const auto key = req_->key().keyWithoutRoute();
+    prefixStats.record(
+        key,
+        key.size() + (reqValue ? reqValue->computeChainDataLength() : 0),
+        replyValue ? replyValue->computeChainDataLength() : 0,
+        hit,
+        nowUs() - this->startDurationUs());
+  }
 
   sendReplyImpl(std::move(reply));
   req_ = nullptr;
@@ -167,6 +204,7 @@ void ProxyRequestContextTyped<RouterInfo, Request>::startProcessing() {
     return;
   }
 
+  this->proxy_.hotKeyTracker().record(req_->key().fullKey());
   this->proxy_.dispatchRequest(*req_, std::move(self));
 }
 
@@ -184,7 +222,8 @@ ProxyRequestContextTyped<RouterInfo, Request>::process(
          for these operations. */
       [](ProxyRequestContext* ctx) {
         folly::fibers::runInMainContext([ctx] { delete ctx; });
-      });
+      },
+      RecyclingAllocator<ProxyRequestContext>());
 }
 
 template <class RouterInfo, class Request, class F>
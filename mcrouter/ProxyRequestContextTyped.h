@@ -7,12 +7,17 @@
  */
 #pragma once
 
+#include <memory>
+
 #include <folly/Utility.h>
 
 #include "mcrouter/ProxyRequestContext.h"
 #include "mcrouter/ProxyRequestLogger.h"
+#include "mcrouter/SlowRequestTracer.h"
+#include "mcrouter/lib/McTracepoints.h"
 #include "mcrouter/lib/RequestLoggerContext.h"
 #include "mcrouter/lib/carbon/NoopAdditionalLogger.h"
+#include "mcrouter/lib/carbon/RequestReplyUtil.h"
 
 namespace facebook {
 namespace memcache {
@@ -91,10 +96,16 @@ class ProxyRequestContextWithInfo : public ProxyRequestContext {
   }
 
   ~ProxyRequestContextWithInfo() override {
+    const auto durationUs = nowUs() - startDurationUs_;
+    if (!recording()) {
+      proxy_.stats().totalDurationUs().insertSample(durationUs);
+      MC_TRACEPOINT(
+          request_done, this, durationUs, static_cast<int>(finalResult_));
+    }
     if (auto poolStats = proxy_.stats().getPoolStats(poolStatIndex_)) {
       poolStats->incrementFinalResultErrorCount(
           isErrorResult(finalResult_) ? 1 : 0);
-      poolStats->addTotalDurationSample(nowUs() - startDurationUs_);
+      poolStats->addTotalDurationSample(durationUs);
     }
     if (reqComplete_) {
       fiber_local<RouterInfo>::runWithoutLocals(
@@ -102,6 +113,13 @@ class ProxyRequestContextWithInfo : public ProxyRequestContext {
     }
   }
 
+  /**
+   * Timeline of this request, nullptr unless slow request tracing is on.
+   */
+  RequestTimeline* timeline() const {
+    return timeline_.get();
+  }
+
   /**
    * Called once a reply is received to record a stats sample if required.
    */
@@ -121,6 +139,16 @@ class ProxyRequestContextWithInfo : public ProxyRequestContext {
       return;
     }
 
+    if (timeline_) {
+      timeline_->record(
+          RequestTimeline::Event::DestinationSend, startTimeUs, poolName);
+      timeline_->record(
+          RequestTimeline::Event::DestinationReply,
+          endTimeUs,
+          poolName,
+          reply.result());
+    }
+
     if (auto poolStats = proxy_.stats().getPoolStats(poolStatIndex)) {
       poolStats->incrementRequestCount(1);
       poolStats->addDurationSample(endTimeUs - startTimeUs);
@@ -138,6 +166,14 @@ class ProxyRequestContextWithInfo : public ProxyRequestContext {
     logger_->template log<Request>(loggerContext);
     assert(additionalLogger_.hasValue());
     additionalLogger_->log(request, reply, loggerContext);
+    proxy_.requestSampleLog().record(request, loggerContext);
+
+    // Reply values are held until the reply to the client is sent.
+    if (proxy_.getRouterOptions().proxy_memory_budget_mb != 0) {
+      if (const auto* value = carbon::valuePtrUnsafe(reply)) {
+        chargeMemory(value->computeChainDataLength());
+      }
+    }
   }
 
  private:
@@ -155,6 +191,25 @@ class ProxyRequestContextWithInfo : public ProxyRequestContext {
 
   Proxy<RouterInfo>& proxy_;
 
+  int64_t startDurationUs() const {
+    return startDurationUs_;
+  }
+
+  /**
+   * Hands the timeline to the slow request tracer. Called before the config
+   * goes away, since the timeline points to pool names in it.
+   */
+  void finishTimeline() {
+    if (timeline_ &&
+        proxy_.slowRequestTracer().finish(
+            *timeline_, nowUs() - startDurationUs_)) {
+      proxy_.stats().increment(slow_requests_traced_stat);
+    }
+    timeline_.reset();
+  }
+
+  std::unique_ptr<RequestTimeline> timeline_;
+
  private:
   ProxyRequestContextWithInfo(
       RecordingT,
@@ -223,13 +278,27 @@ class ProxyRequestContextTyped
       std::unique_ptr<Type> preq,
       std::shared_ptr<const ProxyConfig<RouterInfo>> config);
 
+  ~ProxyRequestContextTyped() override {
+    this->finishTimeline();
+  }
+
  protected:
   ProxyRequestContextTyped(
       Proxy<RouterInfo>& pr,
       const Request& req,
       ProxyRequestPriority priority__)
       : ProxyRequestContextWithInfo<RouterInfo>(pr, priority__),
-        req_(&req) {}
+        req_(&req) {
+    const auto key = req.key().fullKey();
+    MC_TRACEPOINT(request_start, this, &req, key.data(), key.size());
+    if (pr.slowRequestTracer().enabled()) {
+      this->timeline_ = std::make_unique<RequestTimeline>(
+          this->startDurationUs(), Request::name, key);
+    }
+    if (req.timeoutBudgetMs() > 0) {
+      this->tightenDeadline(std::chrono::milliseconds(req.timeoutBudgetMs()));
+    }
+  }
 
   std::shared_ptr<const ProxyConfig<RouterInfo>> config_;
 
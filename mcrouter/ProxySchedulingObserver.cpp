@@ -0,0 +1,89 @@
+/*
+ *  Copyright (c) 2016-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include "ProxySchedulingObserver.h"
+
+#include <glog/logging.h>
+
+#include "mcrouter/ProxyStats.h"
+#include "mcrouter/config.h"
+#include "mcrouter/lib/Clocks.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+ProxySchedulingObserver::ProxySchedulingObserver(
+    ProxyStats& stats,
+    bool recordDelays,
+    uint64_t slowLoopThresholdUs)
+    : stats_(stats),
+      recordDelays_(recordDelays),
+      slowLoopThresholdUs_(slowLoopThresholdUs) {}
+
+void ProxySchedulingObserver::chargeRunningFiber(uint64_t* cpuCycles) {
+  if (charges_.empty()) {
+    runningSinceCycles_ = cycles::getCpuCycles();
+  }
+  charges_[runningFiber_] = cpuCycles;
+}
+
+void ProxySchedulingObserver::stopCharging() {
+  auto it = charges_.find(runningFiber_);
+  if (it == charges_.end()) {
+    return;
+  }
+  *it->second += cycles::getCpuCycles() - runningSinceCycles_;
+  charges_.erase(it);
+}
+
+void ProxySchedulingObserver::runnable(uintptr_t id) noexcept {
+  if (recordDelays_) {
+    runnableSinceUs_[id] = nowUs();
+  }
+}
+
+void ProxySchedulingObserver::starting(uintptr_t id) noexcept {
+  runningFiber_ = id;
+  if (!charges_.empty()) {
+    runningSinceCycles_ = cycles::getCpuCycles();
+  }
+  auto it = runnableSinceUs_.find(id);
+  if (it == runnableSinceUs_.end()) {
+    return;
+  }
+  const auto delayUs = nowUs() - it->second;
+  runnableSinceUs_.erase(it);
+  stats_.fiberRunnableDelayUs().insertSample(delayUs > 0 ? delayUs : 0);
+}
+
+void ProxySchedulingObserver::stopped(uintptr_t id) noexcept {
+  if (!charges_.empty()) {
+    auto it = charges_.find(id);
+    if (it != charges_.end()) {
+      *it->second += cycles::getCpuCycles() - runningSinceCycles_;
+    }
+  }
+  runningFiber_ = 0;
+}
+
+void ProxySchedulingObserver::loopSample(
+    int64_t busyTimeUs,
+    int64_t /* idleTimeUs */) {
+  const uint64_t busyUs = busyTimeUs > 0 ? busyTimeUs : 0;
+  stats_.loopBusyUs().insertSample(busyUs);
+  if (slowLoopThresholdUs_ != 0 && busyUs > slowLoopThresholdUs_) {
+    stats_.increment(proxy_slow_loops_stat);
+    VLOG(1) << "Proxy event loop iteration was busy for " << busyUs
+            << "us (threshold " << slowLoopThresholdUs_ << "us), "
+            << runnableSinceUs_.size() << " fibers waiting to run";
+  }
+}
+
+} // mcrouter
+} // memcache
+} // facebook
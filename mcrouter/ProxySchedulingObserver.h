@@ -0,0 +1,84 @@
+/*
+ *  Copyright (c) 2016-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+
+#include <folly/experimental/ExecutionObserver.h>
+#include <folly/io/async/EventBase.h>
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+class ProxyStats;
+
+/**
+ * Records how long the fibers of a proxy wait to run once runnable, and how
+ * long each iteration of the proxy event loop is busy, into ProxyStats.
+ *
+ * Also measures the CPU time of fibers that asked for it (see
+ * chargeRunningFiber()): the time from every switch into the fiber to the
+ * switch out of it.
+ *
+ * Must only be used from the proxy thread.
+ */
+class ProxySchedulingObserver : public folly::ExecutionObserver,
+                                public folly::EventBaseObserver {
+ public:
+  /**
+   * @param recordDelays         Record fiber and event loop delays
+   *                             (fiber_scheduling_stats).
+   * @param slowLoopThresholdUs  Loop iterations busy for longer than this
+   *                             are counted as slow, and logged. 0 disables.
+   */
+  ProxySchedulingObserver(
+      ProxyStats& stats,
+      bool recordDelays,
+      uint64_t slowLoopThresholdUs);
+
+  /**
+   * Adds the CPU time (in cycles::getCpuCycles() ticks) the running fiber
+   * spends from now on to *cpuCycles, until it calls stopCharging().
+   * Must be called from a fiber of an observed fiber manager.
+   */
+  void chargeRunningFiber(uint64_t* cpuCycles);
+
+  /**
+   * Stops charging the running fiber, see chargeRunningFiber().
+   */
+  void stopCharging();
+
+  void starting(uintptr_t id) noexcept override final;
+  void runnable(uintptr_t id) noexcept override final;
+  void stopped(uintptr_t id) noexcept override final;
+
+  uint32_t getSampleRate() const override final {
+    return 1;
+  }
+  void loopSample(int64_t busyTimeUs, int64_t idleTimeUs) override final;
+
+ private:
+  ProxyStats& stats_;
+  const bool recordDelays_;
+  const uint64_t slowLoopThresholdUs_;
+  // Fiber id -> time (us) when it became runnable.
+  std::unordered_map<uintptr_t, int64_t> runnableSinceUs_;
+
+  uintptr_t runningFiber_{0};
+  // When the running fiber started running, only kept while some fiber is
+  // charged.
+  uint64_t runningSinceCycles_{0};
+  // Fiber id -> where its CPU time is added up.
+  std::unordered_map<uintptr_t, uint64_t*> charges_;
+};
+
+} // mcrouter
+} // memcache
+} // facebook
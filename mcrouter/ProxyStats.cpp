@@ -28,14 +28,17 @@ void ProxyStats::aggregate(size_t statId) {
   }
 
   for (int j = 0; j < num_stats; ++j) {
+    auto& value = stats_[j].data.uint64;
     if (stats_[j].group & rate_stats) {
+      const auto current = __atomic_load_n(&value, __ATOMIC_RELAXED);
       statsNumWithinWindow_[j] -= statsBin_[j][statId];
-      statsBin_[j][statId] = stats_[j].data.uint64;
+      statsBin_[j][statId] = current - lastAggregated_[j];
       statsNumWithinWindow_[j] += statsBin_[j][statId];
-      stats_[j].data.uint64 = 0;
+      lastAggregated_[j] = current;
     } else if (stats_[j].group & (max_stats | max_max_stats)) {
-      statsBin_[j][statId] = stats_[j].data.uint64;
-      stats_[j].data.uint64 = 0;
+      // The proxy may still store a max it read before the swap, which then
+      // counts towards the next bin too. Good enough for a max.
+      statsBin_[j][statId] = __atomic_exchange_n(&value, 0, __ATOMIC_RELAXED);
     }
   }
 }
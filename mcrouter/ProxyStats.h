@@ -7,11 +7,14 @@
  */
 #pragma once
 
+#include <cassert>
 #include <mutex>
+#include <vector>
 
 #include <folly/experimental/StringKeyedUnorderedMap.h>
 
 #include "mcrouter/ExponentialSmoothData.h"
+#include "mcrouter/LatencyHistogram.h"
 #include "mcrouter/PoolStats.h"
 #include "mcrouter/stats.h"
 
@@ -27,12 +30,19 @@ class ProxyStats {
    * Aggregate proxy stat with the given index.
    * Caller must be holding stats lock (i.e. must call lock() before).
    *
+   * Never writes the counters updated by increment(), so the proxy thread
+   * doesn't need to synchronize with the stats thread: rate stats are binned
+   * as the delta since the previous aggregation, and max stats are swapped
+   * with 0 atomically.
+   *
    * @param statId   Index of the stat to aggregate.
    */
   void aggregate(size_t statId);
 
   /**
    * Lock stats for the duration of the lock_guard life.
+   * Only protects the time bins between aggregate() and the readers; updating
+   * the stats never takes it.
    */
   std::unique_lock<std::mutex> lock() const;
 
@@ -40,6 +50,43 @@ class ProxyStats {
     return durationUs_;
   }
 
+  /**
+   * End-to-end latencies of the requests routed by this proxy.
+   */
+  RecentLatencyHistogram& totalDurationUs() {
+    return totalDurationUs_;
+  }
+  const RecentLatencyHistogram& totalDurationUs() const {
+    return totalDurationUs_;
+  }
+
+  /**
+   * Scheduling delays of the fibers of this proxy, and event loop busy times
+   * of its thread. Only recorded with fiber_scheduling_stats.
+   *
+   * fiberQueueDelayUs: from routing task creation to its first run.
+   * fiberRunnableDelayUs: from any fiber becoming runnable to it running.
+   * loopBusyUs: busy time of each event loop iteration.
+   */
+  RecentLatencyHistogram& fiberQueueDelayUs() {
+    return fiberQueueDelayUs_;
+  }
+  const RecentLatencyHistogram& fiberQueueDelayUs() const {
+    return fiberQueueDelayUs_;
+  }
+  RecentLatencyHistogram& fiberRunnableDelayUs() {
+    return fiberRunnableDelayUs_;
+  }
+  const RecentLatencyHistogram& fiberRunnableDelayUs() const {
+    return fiberRunnableDelayUs_;
+  }
+  RecentLatencyHistogram& loopBusyUs() {
+    return loopBusyUs_;
+  }
+  const RecentLatencyHistogram& loopBusyUs() const {
+    return loopBusyUs_;
+  }
+
   size_t numBinsUsed() const {
     return numBinsUsed_;
   }
@@ -73,13 +120,19 @@ class ProxyStats {
   double getRateValue(size_t statId) const;
 
   /**
-   * Increment the stat.
+   * Increment the stat. Must only be called from the proxy thread, and never
+   * on a stat that is also updated with incrementSafe().
    *
    * @param stat    Stat to increment
    * @param amount  Amount to increment the stat
    */
   void increment(stat_name_t stat, int64_t amount = 1) {
-    stat_incr(stats_, stat, amount);
+    // Single writer: a relaxed load/store pair is enough, and unlike an
+    // atomic add doesn't need a locked instruction.
+    auto& value = stats_[stat].data.uint64;
+    __atomic_store_n(
+        &value, __atomic_load_n(&value, __ATOMIC_RELAXED) + amount,
+        __ATOMIC_RELAXED);
   }
 
   /**
@@ -119,17 +172,29 @@ class ProxyStats {
    * @param newValue  New value of the stat
    */
   void setValue(stat_name_t stat, int64_t newValue) {
-    stat_set_uint64(stats_, stat, newValue);
+    assert(stats_[stat].type == stat_uint64);
+    __atomic_store_n(&stats_[stat].data.uint64, newValue, __ATOMIC_RELAXED);
   }
 
   uint64_t getValue(stat_name_t stat) const {
-    return stat_get_uint64(stats_, stat);
+    return __atomic_load_n(&stats_[stat].data.uint64, __ATOMIC_RELAXED);
   }
   uint64_t getConfigAge(uint64_t now) const {
     return stat_get_config_age(stats_, now);
   }
-  const stat_t& getStat(size_t statId) const {
-    return stats_[statId];
+  /**
+   * Snapshot of the stat, safe to take from any thread.
+   * NOTE: rate stats are never reset, use the time bins for those.
+   */
+  stat_t getStat(size_t statId) const {
+    stat_t stat = stats_[statId];
+    stat.data.uint64 =
+        __atomic_load_n(&stats_[statId].data.uint64, __ATOMIC_RELAXED);
+    return stat;
+  }
+
+  const std::vector<PoolStats>& poolStats() const {
+    return poolStats_;
   }
 
   folly::StringKeyedUnorderedMap<stat_t> getAggregatedPoolStatsMap() const {
@@ -164,6 +229,10 @@ class ProxyStats {
   std::vector<PoolStats> poolStats_;
 
   ExponentialSmoothData<64> durationUs_;
+  RecentLatencyHistogram totalDurationUs_;
+  RecentLatencyHistogram fiberQueueDelayUs_;
+  RecentLatencyHistogram fiberRunnableDelayUs_;
+  RecentLatencyHistogram loopBusyUs_;
 
   // we are wasting some memory here to get faster mapping from stat name to
   // statsBin_[] and statsNumWithinWindow_[] entry. i.e., the statsBin_[]
@@ -178,7 +247,8 @@ class ProxyStats {
    * is a rate_stat) or the max (if it is a max_stat) of "stat_name" in the
    * "idx"th time bin. The updater thread updates these circular arrays once
    * every MOVING_AVERAGE_WINDOW_SIZE_IN_SECOND second by setting the oldest
-   * time bin to stats[stat_name], and then reset stats[stat_name] to 0.
+   * time bin to the growth of stats[stat_name] since the previous update
+   * (for rate stats), or by swapping stats[stat_name] with 0 (for max stats).
    */
   uint64_t statsBin_[num_stats]
                     [MOVING_AVERAGE_WINDOW_SIZE_IN_SECOND /
@@ -191,6 +261,12 @@ class ProxyStats {
    */
   uint64_t statsNumWithinWindow_[num_stats]{};
 
+  /*
+   * lastAggregated_[stat_name] is the value of rate stat "stat_name" at the
+   * previous aggregation. Only accessed by the updater thread.
+   */
+  uint64_t lastAggregated_[num_stats]{};
+
   /*
    * the number of bins currently used, which is initially set to 0, and is
    * increased by 1 every MOVING_AVERAGE_WINDOW_SIZE_IN_SECOND seconds.
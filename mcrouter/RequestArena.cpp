@@ -0,0 +1,95 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include "RequestArena.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+namespace {
+
+char* alignUp(char* p, size_t align) {
+  auto addr = reinterpret_cast<uintptr_t>(p);
+  return reinterpret_cast<char*>((addr + align - 1) & ~(align - 1));
+}
+
+} // anonymous namespace
+
+RequestArena::~RequestArena() {
+  while (cleanups_) {
+    auto* cleanup = cleanups_;
+    cleanups_ = cleanup->next;
+    cleanup->destroy(cleanup->obj);
+  }
+  while (blocks_) {
+    auto* block = blocks_;
+    blocks_ = block->next;
+    ::operator delete(block);
+  }
+}
+
+void* RequestArena::allocate(size_t size, size_t align) {
+  if (maxBytes_ == 0) {
+    return nullptr;
+  }
+  auto* p = alignUp(pos_, align);
+  if (p <= end_ && size <= static_cast<size_t>(end_ - p)) {
+    pos_ = p + size;
+    return p;
+  }
+
+  // Allocations too big for a regular block get a block of their own, the
+  // current block keeps serving small ones.
+  const auto needed = sizeof(Block) + align + size;
+  const bool dedicated = needed > kBlockSize / 4;
+  const auto blockSize = std::max(needed, kBlockSize);
+  const auto takenBytes = dedicated ? needed : blockSize;
+  if (heapBytes_ + takenBytes > maxBytes_) {
+    return nullptr;
+  }
+  auto* block = static_cast<Block*>(::operator new(takenBytes));
+  block->next = blocks_;
+  blocks_ = block;
+  heapBytes_ += takenBytes;
+
+  auto* data = reinterpret_cast<char*>(block + 1);
+  p = alignUp(data, align);
+  if (!dedicated) {
+    pos_ = p + size;
+    end_ = reinterpret_cast<char*>(block) + blockSize;
+  }
+  return p;
+}
+
+folly::Optional<folly::StringPiece> RequestArena::concat(
+    std::initializer_list<folly::StringPiece> pieces) {
+  size_t size = 0;
+  for (auto piece : pieces) {
+    size += piece.size();
+  }
+  auto* data = static_cast<char*>(allocate(size, 1));
+  if (data == nullptr) {
+    return folly::none;
+  }
+  auto* pos = data;
+  for (auto piece : pieces) {
+    if (!piece.empty()) {
+      std::memcpy(pos, piece.data(), piece.size());
+      pos += piece.size();
+    }
+  }
+  return folly::StringPiece(data, size);
+}
+
+} // mcrouter
+} // memcache
+} // facebook
@@ -0,0 +1,119 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <cstddef>
+#include <initializer_list>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include <folly/Optional.h>
+#include <folly/Range.h>
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Bump pointer arena owned by a ProxyRequestContext, for memory that routes
+ * need for as long as the request is processed (e.g. modified keys).
+ * Everything is released at once when the request completes, instead of one
+ * malloc/free pair per allocation.
+ *
+ * The first kInlineSize bytes live in the arena itself, then blocks of
+ * kBlockSize bytes are taken from the heap. Once the arena would go above
+ * maxBytes (request_arena_max_bytes), allocations fail and callers fall back
+ * to the heap, so that a request can't hold on to unbounded memory.
+ *
+ * Not thread-safe, must only be used from the proxy thread.
+ */
+class RequestArena {
+ public:
+  static constexpr size_t kInlineSize = 256;
+  static constexpr size_t kBlockSize = 4096;
+
+  /**
+   * @param maxBytes  Heap bytes the arena may take, 0 disables the arena.
+   */
+  explicit RequestArena(size_t maxBytes) : maxBytes_(maxBytes) {}
+
+  RequestArena(const RequestArena&) = delete;
+  RequestArena& operator=(const RequestArena&) = delete;
+
+  ~RequestArena();
+
+  /**
+   * @param align  power of 2, at most alignof(std::max_align_t).
+   * @return  `size` bytes valid until the arena is destroyed, nullptr if the
+   *          arena is disabled or full.
+   */
+  void* allocate(size_t size, size_t align = alignof(std::max_align_t));
+
+  /**
+   * Constructs a T in the arena, destroyed with it.
+   *
+   * @return  nullptr if the arena is disabled or full.
+   */
+  template <class T, class... Args>
+  T* create(Args&&... args) {
+    if (std::is_trivially_destructible<T>::value) {
+      auto* mem = allocate(sizeof(T), alignof(T));
+      return mem ? new (mem) T(std::forward<Args>(args)...) : nullptr;
+    }
+    auto* cleanup =
+        static_cast<Cleanup*>(allocate(sizeof(Cleanup), alignof(Cleanup)));
+    auto* mem = cleanup ? allocate(sizeof(T), alignof(T)) : nullptr;
+    if (mem == nullptr) {
+      return nullptr;
+    }
+    auto* obj = new (mem) T(std::forward<Args>(args)...);
+    cleanup->destroy = [](void* p) { static_cast<T*>(p)->~T(); };
+    cleanup->obj = obj;
+    cleanup->next = cleanups_;
+    cleanups_ = cleanup;
+    return obj;
+  }
+
+  /**
+   * Concatenates `pieces` into the arena.
+   *
+   * @return  folly::none if the arena is disabled or full.
+   */
+  folly::Optional<folly::StringPiece> concat(
+      std::initializer_list<folly::StringPiece> pieces);
+
+  /**
+   * @return  Heap bytes taken by the arena.
+   */
+  size_t heapBytes() const {
+    return heapBytes_;
+  }
+
+ private:
+  struct Block {
+    Block* next;
+  };
+  struct Cleanup {
+    void (*destroy)(void*);
+    void* obj;
+    Cleanup* next;
+  };
+
+  const size_t maxBytes_;
+  size_t heapBytes_{0};
+  char* pos_{inline_};
+  char* end_{inline_ + kInlineSize};
+  Block* blocks_{nullptr};
+  Cleanup* cleanups_{nullptr};
+  alignas(std::max_align_t) char inline_[kInlineSize];
+};
+
+} // mcrouter
+} // memcache
+} // facebook
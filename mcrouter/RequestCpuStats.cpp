@@ -0,0 +1,41 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include "RequestCpuStats.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+namespace {
+
+void add(
+    folly::StringKeyedUnorderedMap<RequestCpuStats::Counters>& map,
+    folly::StringPiece name,
+    uint64_t cpuCycles) {
+  auto it = map.find(name);
+  if (it == map.end()) {
+    it = map.emplace(name, RequestCpuStats::Counters()).first;
+  }
+  ++it->second.requests;
+  it->second.cpuCycles += cpuCycles;
+}
+
+} // anonymous namespace
+
+void RequestCpuStats::record(
+    folly::StringPiece routingPrefix,
+    folly::StringPiece requestName,
+    uint64_t cpuCycles) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  add(byRoutingPrefix_, routingPrefix, cpuCycles);
+  add(byRequest_, requestName, cpuCycles);
+}
+
+} // mcrouter
+} // memcache
+} // facebook
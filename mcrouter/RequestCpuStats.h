@@ -0,0 +1,71 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+
+#include <folly/Range.h>
+#include <folly/experimental/StringKeyedUnorderedMap.h>
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * CPU time spent routing requests (request_cpu_stats), by routing prefix and
+ * by request type, so that tenants and operations can be charged for the
+ * proxy CPU they use.
+ *
+ * Written by a single proxy thread, readable from any thread.
+ */
+class RequestCpuStats {
+ public:
+  struct Counters {
+    uint64_t requests{0};
+    // In cycles::getCpuCycles() ticks.
+    uint64_t cpuCycles{0};
+  };
+
+  void record(
+      folly::StringPiece routingPrefix,
+      folly::StringPiece requestName,
+      uint64_t cpuCycles);
+
+  /**
+   * Calls func(routingPrefix, const Counters&) for every routing prefix.
+   */
+  template <class Func>
+  void foreachRoutingPrefix(Func&& func) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& it : byRoutingPrefix_) {
+      func(it.first, it.second);
+    }
+  }
+
+  /**
+   * Calls func(requestName, const Counters&) for every request type.
+   */
+  template <class Func>
+  void foreachRequest(Func&& func) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& it : byRequest_) {
+      func(it.first, it.second);
+    }
+  }
+
+ private:
+  // Only contended while stats are read.
+  mutable std::mutex mutex_;
+  folly::StringKeyedUnorderedMap<Counters> byRoutingPrefix_;
+  folly::StringKeyedUnorderedMap<Counters> byRequest_;
+};
+
+} // mcrouter
+} // memcache
+} // facebook
@@ -0,0 +1,294 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include "RequestSampleLog.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+
+#include <folly/Bits.h>
+#include <folly/File.h>
+#include <folly/FileUtil.h>
+#include <folly/String.h>
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBuf.h>
+
+#include "mcrouter/AsyncWriter.h"
+#include "mcrouter/CarbonRouterInstanceBase.h"
+#include "mcrouter/McrouterLogFailure.h"
+#include "mcrouter/lib/RequestLoggerContext.h"
+#include "mcrouter/lib/carbon/CarbonProtocolReader.h"
+#include "mcrouter/lib/carbon/CarbonProtocolWriter.h"
+#include "mcrouter/lib/carbon/CarbonQueueAppender.h"
+#include "mcrouter/lib/fbi/cpp/util.h"
+#include "mcrouter/lib/network/AccessPoint.h"
+#include "mcrouter/options.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+constexpr folly::StringPiece RequestSample::kMagic;
+
+void RequestSample::serialize(carbon::CarbonProtocolWriter& writer) const {
+  writer.writeStructBegin();
+  writer.writeField(1 /* field id */, startTimeUs);
+  writer.writeField(2 /* field id */, latencyUs);
+  writer.writeField(3 /* field id */, keyHash);
+  writer.writeField(4 /* field id */, operation);
+  writer.writeField(5 /* field id */, pool);
+  writer.writeField(6 /* field id */, host);
+  writer.writeField(7 /* field id */, port);
+  writer.writeField(8 /* field id */, static_cast<int16_t>(result));
+  writer.writeField(9 /* field id */, replySize);
+  writer.writeField(10 /* field id */, serverLoad);
+  writer.writeFieldStop();
+  writer.writeStructEnd();
+}
+
+void RequestSample::deserialize(carbon::CarbonProtocolReader& reader) {
+  reader.readStructBegin();
+  while (true) {
+    const auto pr = reader.readFieldHeader();
+    const auto fieldType = pr.first;
+    const auto fieldId = pr.second;
+
+    if (fieldType == carbon::FieldType::Stop) {
+      break;
+    }
+
+    switch (fieldId) {
+      case 1: {
+        reader.readField(startTimeUs, fieldType);
+        break;
+      }
+      case 2: {
+        reader.readField(latencyUs, fieldType);
+        break;
+      }
+      case 3: {
+        reader.readField(keyHash, fieldType);
+        break;
+      }
+      case 4: {
+        reader.readField(operation, fieldType);
+        break;
+      }
+      case 5: {
+        reader.readField(pool, fieldType);
+        break;
+      }
+      case 6: {
+        reader.readField(host, fieldType);
+        break;
+      }
+      case 7: {
+        reader.readField(port, fieldType);
+        break;
+      }
+      case 8: {
+        int16_t res;
+        reader.readField(res, fieldType);
+        result = static_cast<mc_res_t>(res);
+        break;
+      }
+      case 9: {
+        reader.readField(replySize, fieldType);
+        break;
+      }
+      case 10: {
+        reader.readField(serverLoad, fieldType);
+        break;
+      }
+      default: {
+        reader.skip(fieldType);
+        break;
+      }
+    }
+  }
+  reader.readStructEnd();
+}
+
+void RequestSample::appendBinary(std::string& out) const {
+  carbon::CarbonQueueAppenderStorage storage;
+  carbon::CarbonProtocolWriter writer(storage);
+  serialize(writer);
+
+  const uint32_t size = folly::Endian::little(
+      static_cast<uint32_t>(storage.computeBodySize()));
+  out.append(reinterpret_cast<const char*>(&size), sizeof(size));
+  const auto iovs = storage.getIovecs();
+  for (size_t i = 0; i < iovs.second; ++i) {
+    const struct iovec* iov = iovs.first + i;
+    out.append(static_cast<const char*>(iov->iov_base), iov->iov_len);
+  }
+}
+
+bool RequestSample::operator==(const RequestSample& other) const {
+  return startTimeUs == other.startTimeUs && latencyUs == other.latencyUs &&
+      keyHash == other.keyHash && operation == other.operation &&
+      pool == other.pool && host == other.host && port == other.port &&
+      result == other.result && replySize == other.replySize &&
+      serverLoad == other.serverLoad;
+}
+
+std::vector<RequestSample> parseRequestSampleLog(folly::StringPiece contents) {
+  checkRuntime(
+      contents.removePrefix(RequestSample::kMagic),
+      "Not a request sample log");
+
+  std::vector<RequestSample> samples;
+  while (contents.size() >= sizeof(uint32_t)) {
+    const auto size = folly::Endian::little(
+        folly::loadUnaligned<uint32_t>(contents.data()));
+    if (contents.size() - sizeof(uint32_t) < size) {
+      break;
+    }
+    contents.advance(sizeof(uint32_t));
+    auto buf = folly::IOBuf::wrapBuffer(contents.data(), size);
+    carbon::CarbonProtocolReader reader(carbon::CarbonCursor(buf.get()));
+    samples.emplace_back();
+    samples.back().deserialize(reader);
+    contents.advance(size);
+  }
+  return samples;
+}
+
+/**
+ * Single producer (proxy thread), single consumer (writer thread) ring.
+ * Slots are reused, so copying a sample in doesn't allocate once the
+ * strings in a slot have grown big enough.
+ */
+struct RequestSampleLog::Ring {
+  Ring(std::string path_, size_t capacity)
+      : path(std::move(path_)), slots(capacity) {}
+
+  const std::string path;
+  std::vector<RequestSample> slots;
+  // Next slot to write out, advanced by the writer.
+  std::atomic<size_t> head{0};
+  // Next slot to fill, advanced by the proxy.
+  std::atomic<size_t> tail{0};
+  std::atomic<bool> flushScheduled{false};
+
+  // Accessed by the writer only.
+  folly::File file;
+  std::string buffer;
+
+  /**
+   * Writes out all filled slots. Runs on the writer thread.
+   */
+  void flush() {
+    // Samples recorded from now on will schedule another flush.
+    flushScheduled = false;
+
+    auto h = head.load(std::memory_order_relaxed);
+    const auto t = tail.load();
+    buffer.clear();
+    for (; h != t; ++h) {
+      slots[h % slots.size()].appendBinary(buffer);
+    }
+    head.store(t, std::memory_order_release);
+
+    if (buffer.empty() || !openFile()) {
+      return;
+    }
+    auto size = folly::writeFull(file.fd(), buffer.data(), buffer.size());
+    if (size == -1 || static_cast<size_t>(size) < buffer.size()) {
+      LOG_FAILURE(
+          "mcrouter",
+          failure::Category::kSystemError,
+          "Error writing request samples to {}: {}",
+          path,
+          folly::errnoStr(errno));
+    }
+  }
+
+  bool openFile() {
+    if (file) {
+      return true;
+    }
+    int fd = folly::openNoInt(
+        path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0666);
+    if (fd < 0) {
+      LOG_FAILURE(
+          "mcrouter",
+          failure::Category::kSystemError,
+          "Can not open request sample log {}: {}",
+          path,
+          folly::errnoStr(errno));
+      return false;
+    }
+    file = folly::File(fd, /* ownsFd */ true);
+    struct stat st;
+    if (::fstat(fd, &st) == 0 && st.st_size == 0) {
+      buffer.insert(0, RequestSample::kMagic.str());
+    }
+    return true;
+  }
+};
+
+RequestSampleLog::RequestSampleLog(
+    CarbonRouterInstanceBase& router,
+    folly::Function<void()> onDropped)
+    : router_(router), onDropped_(std::move(onDropped)) {
+  const auto& opts = router_.opts();
+  if (opts.request_sample_rate != 0 && !opts.request_sample_log_file.empty() &&
+      opts.request_sample_ring_size != 0) {
+    sampleRate_ = opts.request_sample_rate;
+    countdown_ = sampleRate_;
+    ring_ = std::make_shared<Ring>(
+        opts.request_sample_log_file, opts.request_sample_ring_size);
+  }
+}
+
+RequestSampleLog::~RequestSampleLog() = default;
+
+void RequestSampleLog::recordSample(
+    folly::StringPiece operation,
+    uint32_t keyHash,
+    const RequestLoggerContext& loggerContext) {
+  auto& ring = *ring_;
+  const auto t = ring.tail.load(std::memory_order_relaxed);
+  if (t - ring.head.load(std::memory_order_acquire) == ring.slots.size()) {
+    onDropped_();
+    return;
+  }
+
+  auto& sample = ring.slots[t % ring.slots.size()];
+  sample.startTimeUs = loggerContext.startTimeUs;
+  sample.latencyUs = loggerContext.endTimeUs - loggerContext.startTimeUs;
+  sample.keyHash = keyHash;
+  sample.operation.assign(operation.begin(), operation.end());
+  sample.pool.assign(
+      loggerContext.poolName.begin(), loggerContext.poolName.end());
+  sample.host = loggerContext.ap.getHost();
+  sample.port = loggerContext.ap.getPort();
+  sample.result = loggerContext.replyResult;
+  sample.replySize =
+      loggerContext.replyStatsContext.replySizeAfterCompression;
+  sample.serverLoad = loggerContext.replyStatsContext.serverLoad.raw();
+  ring.tail.store(t + 1);
+
+  if (ring.flushScheduled.exchange(true)) {
+    return;
+  }
+  auto writer = router_.statsLogWriter();
+  if (!writer ||
+      !writer->run(
+          [ring = ring_]() { ring->flush(); }, AsyncWriter::Priority::Low)) {
+    // Samples stay in the ring, the next one will retry.
+    ring.flushScheduled = false;
+  }
+}
+
+} // mcrouter
+} // memcache
+} // facebook
@@ -0,0 +1,122 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <folly/Function.h>
+#include <folly/Range.h>
+
+#include "mcrouter/lib/mc/msg.h"
+
+namespace carbon {
+class CarbonProtocolReader;
+class CarbonProtocolWriter;
+} // carbon
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+class CarbonRouterInstanceBase;
+struct RequestLoggerContext;
+
+/**
+ * One sampled destination request.
+ *
+ * Request sample log files start with kMagic followed by samples, each
+ * a 4 byte little-endian length and the carbon-serialized RequestSample.
+ */
+struct RequestSample {
+  static constexpr folly::StringPiece kMagic{"\0RS1.0\n", 7};
+
+  int64_t startTimeUs{0};
+  int64_t latencyUs{0};
+  uint32_t keyHash{0};
+  std::string operation;
+  std::string pool;
+  std::string host;
+  uint16_t port{0};
+  mc_res_t result{mc_res_unknown};
+  uint32_t replySize{0};
+  // ServerLoad::raw() reported with the reply
+  uint32_t serverLoad{0};
+
+  void serialize(carbon::CarbonProtocolWriter& writer) const;
+  void deserialize(carbon::CarbonProtocolReader& reader);
+
+  /**
+   * Appends the binary form of this sample (without the file magic) to out.
+   */
+  void appendBinary(std::string& out) const;
+
+  bool operator==(const RequestSample& other) const;
+};
+
+/**
+ * Parses contents of a request sample log file.
+ *
+ * @throw std::runtime_error  if the magic is missing. Trailing partial
+ *                            sample (e.g. after a crash) is ignored.
+ */
+std::vector<RequestSample> parseRequestSampleLog(folly::StringPiece contents);
+
+/**
+ * Writes every sampleRate-th destination request of a proxy to
+ * request_sample_log_file.
+ *
+ * Samples are copied into a fixed size ring, which the stats log writer
+ * drains in the background at low priority. The proxy never blocks on it:
+ * samples that don't fit into the ring are dropped.
+ *
+ * record() must only be called from the owning proxy thread.
+ */
+class RequestSampleLog {
+ public:
+  /**
+   * @param onDropped  called (on the proxy thread) for every sample dropped
+   *                   because the ring was full.
+   */
+  RequestSampleLog(
+      CarbonRouterInstanceBase& router,
+      folly::Function<void()> onDropped);
+  ~RequestSampleLog();
+
+  template <class Request>
+  void record(const Request& req, const RequestLoggerContext& loggerContext) {
+    if (sampleRate_ == 0 || --countdown_ > 0) {
+      return;
+    }
+    countdown_ = sampleRate_;
+    recordSample(Request::name, req.key().routingKeyHash(), loggerContext);
+  }
+
+ private:
+  struct Ring;
+
+  CarbonRouterInstanceBase& router_;
+  folly::Function<void()> onDropped_;
+  // 0 if sampling is disabled
+  size_t sampleRate_{0};
+  size_t countdown_{0};
+  // Shared with the flushes queued on the writer.
+  std::shared_ptr<Ring> ring_;
+
+  void recordSample(
+      folly::StringPiece operation,
+      uint32_t keyHash,
+      const RequestLoggerContext& loggerContext);
+};
+
+} // mcrouter
+} // memcache
+} // facebook
@@ -0,0 +1,25 @@
+/*
+ *  Copyright (c) 2016-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include "RouteStats.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+std::shared_ptr<RouteStats> RouteStatsMap::get(folly::StringPiece name) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto& stats = stats_[name.str()];
+  if (!stats) {
+    stats = std::make_shared<RouteStats>();
+  }
+  return stats;
+}
+
+} // mcrouter
+} // memcache
+} // facebook
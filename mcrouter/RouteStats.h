@@ -0,0 +1,91 @@
+/*
+ *  Copyright (c) 2016-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <folly/Range.h>
+
+#include "mcrouter/LatencyHistogram.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Call counts, error counts and latencies of an instrumented route handle.
+ *
+ * Written by a single proxy thread, readable from any thread.
+ */
+class RouteStats {
+ public:
+  void record(uint64_t latencyUs, bool error) {
+    bump(calls_);
+    if (error) {
+      bump(errors_);
+    }
+    latencyUs_.insertSample(latencyUs);
+  }
+
+  uint64_t calls() const {
+    return __atomic_load_n(&calls_, __ATOMIC_RELAXED);
+  }
+  uint64_t errors() const {
+    return __atomic_load_n(&errors_, __ATOMIC_RELAXED);
+  }
+  const RecentLatencyHistogram& latencyUs() const {
+    return latencyUs_;
+  }
+
+ private:
+  uint64_t calls_{0};
+  uint64_t errors_{0};
+  RecentLatencyHistogram latencyUs_;
+
+  static void bump(uint64_t& counter) {
+    __atomic_store_n(
+        &counter, __atomic_load_n(&counter, __ATOMIC_RELAXED) + 1,
+        __ATOMIC_RELAXED);
+  }
+};
+
+/**
+ * RouteStats of the instrumented route handles of one proxy, by name.
+ * Stats survive reconfigurations: route handles with the same name keep
+ * adding to the same RouteStats.
+ */
+class RouteStatsMap {
+ public:
+  /**
+   * @return  Stats for the given route name, created if needed.
+   */
+  std::shared_ptr<RouteStats> get(folly::StringPiece name);
+
+  /**
+   * Calls func(name, const RouteStats&) for every route.
+   */
+  template <class Func>
+  void foreach(Func&& func) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& it : stats_) {
+      func(it.first, *it.second);
+    }
+  }
+
+ private:
+  mutable std::mutex mutex_;
+  std::map<std::string, std::shared_ptr<RouteStats>> stats_;
+};
+
+} // mcrouter
+} // memcache
+} // facebook
@@ -0,0 +1,73 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <utility>
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Waiting requests of a single priority. Every sender (client) gets its own
+ * FIFO queue, and senders with waiting requests are served round-robin, so
+ * that one client with a large backlog can't starve the others.
+ *
+ * List is a FIFO owning its items, e.g. UniqueIntrusiveList: it must
+ * provide pushBack(), popFront() and empty().
+ */
+template <class List>
+class SenderRoundRobinQueue {
+ public:
+  using Item = decltype(std::declval<List&>().popFront());
+
+  bool empty() const {
+    return senders_.empty();
+  }
+
+  void push(uint64_t senderId, Item item) {
+    auto& queue = queues_[senderId];
+    if (queue.empty()) {
+      senders_.push_back(senderId);
+    }
+    queue.pushBack(std::move(item));
+  }
+
+  /**
+   * Pops the oldest item of the next sender in round-robin order.
+   * Must not be called on an empty queue.
+   */
+  Item pop() {
+    assert(!senders_.empty());
+    auto senderId = senders_.front();
+    senders_.pop_front();
+
+    auto it = queues_.find(senderId);
+    assert(it != queues_.end());
+    auto item = it->second.popFront();
+    if (it->second.empty()) {
+      queues_.erase(it);
+    } else {
+      senders_.push_back(senderId);
+    }
+    return item;
+  }
+
+ private:
+  std::unordered_map<uint64_t, List> queues_;
+  /** Senders with waiting items, in round-robin order */
+  std::deque<uint64_t> senders_;
+};
+
+} // mcrouter
+} // memcache
+} // facebook
@@ -19,6 +19,7 @@
 #include "mcrouter/config.h"
 #include "mcrouter/lib/network/AsyncMcServer.h"
 #include "mcrouter/lib/network/AsyncMcServerWorker.h"
+#include "mcrouter/lib/network/SocketTakeover.h"
 #include "mcrouter/standalone_options.h"
 
 namespace facebook {
@@ -43,8 +44,8 @@ void serverLoop(
   // Manually override proxy assignment
   routerClient->setProxy(proxy);
 
-  worker.setOnRequest(
-      RequestHandlerType(*routerClient, standaloneOpts.retain_source_ip));
+  worker.setOnRequest(RequestHandlerType(
+      *routerClient, standaloneOpts.retain_source_ip, proxy));
   worker.setOnConnectionAccepted([proxy]() {
     proxy->stats().increment(successful_client_connections_stat);
     proxy->stats().increment(num_clients_stat);
@@ -53,6 +54,19 @@ void serverLoop(
       [proxy](facebook::memcache::McServerSession&) {
         proxy->stats().decrement(num_clients_stat);
       });
+  worker.setOnReadsDeferred([proxy](facebook::memcache::McServerSession&) {
+    proxy->stats().increment(client_reads_deferred_stat);
+  });
+  worker.setOnRepliesWritten(
+      [proxy](facebook::memcache::McServerSession&, size_t numReplies) {
+        proxy->stats().increment(client_reply_writes_stat);
+        proxy->stats().increment(client_replies_written_stat, numReplies);
+      });
+  worker.setOnHandshakeOffloaded([proxy](std::chrono::microseconds queueTime) {
+    proxy->stats().increment(ssl_handshakes_offloaded_stat);
+    proxy->stats().increment(
+        ssl_handshake_queue_time_us_stat, queueTime.count());
+  });
 
   // Setup compression on each worker.
   if (standaloneOpts.enable_server_compression) {
@@ -93,10 +107,17 @@ bool runServer(
     opts.pemKeyPath = mcrouterOpts.pem_key_path;
     opts.pemCaPath = mcrouterOpts.pem_ca_path;
     opts.tfoEnabledForSsl = mcrouterOpts.enable_ssl_tfo;
+    opts.ktlsEnabledForSsl = mcrouterOpts.enable_ssl_ktls;
     opts.tfoQueueSize = standaloneOpts.tfo_queue_size;
+    opts.numHandshakeThreads = standaloneOpts.ssl_handshake_threads;
+    opts.sslHandshakeTimeout =
+        std::chrono::milliseconds(standaloneOpts.ssl_handshake_timeout_ms);
+    opts.reusePortPerWorker = standaloneOpts.reuse_port_per_worker;
+    opts.reusePortCpuSteering = standaloneOpts.reuse_port_cpu_steering;
   }
 
   opts.numThreads = mcrouterOpts.num_proxies;
+  opts.threadCpus = standaloneOpts.worker_cpus;
 
   opts.setPerThreadMaxConns(standaloneOpts.max_conns, opts.numThreads);
   opts.tcpListenBacklog = standaloneOpts.tcp_listen_backlog;
@@ -104,6 +125,13 @@ bool runServer(
   opts.worker.maxInFlight = standaloneOpts.max_client_outstanding_reqs;
   opts.worker.sendTimeout =
       std::chrono::milliseconds{standaloneOpts.client_timeout_ms};
+  opts.worker.zeroCopyThreshold = standaloneOpts.reply_zero_copy_threshold;
+  opts.worker.caretFrameSize = standaloneOpts.caret_reply_frame_size;
+  opts.worker.maxRequestsPerLoop = standaloneOpts.max_requests_per_loop;
+  opts.worker.idleBufferReleaseTimeout = std::chrono::milliseconds{
+      standaloneOpts.idle_buffer_release_timeout_ms};
+  opts.worker.goAwayTimeout =
+      std::chrono::milliseconds{standaloneOpts.go_away_timeout_ms};
   if (!mcrouterOpts.debug_fifo_root.empty()) {
     opts.worker.debugFifoPath = getServerDebugFifoFullPath(mcrouterOpts);
   }
@@ -114,11 +142,30 @@ bool runServer(
     opts.cpuControllerOpts.enableServerLoad = true;
     opts.cpuControllerOpts.target = 0; // Disable drop probability.
   }
+  opts.worker.overloadRequestBudget =
+      standaloneOpts.overload_requests_per_client;
+  opts.worker.overloadCpuThreshold = standaloneOpts.overload_cpu_percent;
+  if (opts.worker.overloadRequestBudget > 0 &&
+      standaloneOpts.server_load_interval_ms == 0) {
+    LOG(WARNING) << "--overload-requests-per-client has no effect without "
+                    "--server-load-interval-ms";
+  }
 
   /* Default to one read per event to help latency-sensitive workloads.
      We can make this an option if this needs to be adjusted. */
   opts.worker.maxReadsPerEvent = 1;
 
+  const auto& takeoverPath = standaloneOpts.takeover_socket_path;
+  if (!takeoverPath.empty()) {
+    try {
+      if (auto sockets = requestTakeover(takeoverPath)) {
+        opts.takeoverSockets = std::move(*sockets);
+      }
+    } catch (const std::exception& e) {
+      LOG(ERROR) << "Failed to take over listening sockets: " << e.what();
+    }
+  }
+
   try {
     LOG(INFO) << "Spawning AsyncMcServer";
 
@@ -171,6 +218,14 @@ bool runServer(
         },
         [&shutdownBaton]() { shutdownBaton.post(); });
 
+    std::unique_ptr<TakeoverServer> takeoverServer;
+    if (!takeoverPath.empty()) {
+      takeoverServer = std::make_unique<TakeoverServer>(
+          takeoverPath,
+          [&server]() { return server.listeningSockets(); },
+          [&server]() { server.shutdown(); });
+    }
+
     shutdownBaton.wait();
   } catch (const std::exception& e) {
     LOG(ERROR) << e.what();
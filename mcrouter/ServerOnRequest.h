@@ -0,0 +1,154 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <folly/Function.h>
+
+#include "mcrouter/CarbonRouterClient.h"
+#include "mcrouter/MultiGetPacer.h"
+#include "mcrouter/ProxyBase.h"
+#include "mcrouter/config.h"
+#include "mcrouter/lib/network/AsyncMcServer.h"
+#include "mcrouter/lib/network/AsyncMcServerWorker.h"
+#include "mcrouter/lib/network/McServerRequestContext.h"
+#include "mcrouter/lib/network/gen/Memcache.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+template <class Request>
+struct ServerRequestContext {
+  McServerRequestContext ctx;
+  Request req;
+
+  ServerRequestContext(McServerRequestContext&& ctx_, Request&& req_)
+      : ctx(std::move(ctx_)), req(std::move(req_)) {}
+};
+
+template <class RouterInfo>
+class ServerOnRequest {
+ public:
+  template <class Request>
+  using ReplyFunction =
+      void (*)(McServerRequestContext&& ctx, ReplyT<Request>&& reply);
+
+  /**
+   * @param proxy  proxy the client sends to, paces ascii multigets with its
+   *               incastWindow() if set.
+   */
+  ServerOnRequest(
+      CarbonRouterClient<RouterInfo>& client,
+      bool retainSourceIp,
+      ProxyBase* proxy = nullptr)
+      : client_(client),
+        retainSourceIp_(retainSourceIp),
+        proxy_(proxy),
+        multiGetPacer_([proxy]() { return proxy->incastWindow()->window(); }) {
+  }
+
+  template <class Request>
+  void onRequest(McServerRequestContext&& ctx, Request&& req) {
+    using Reply = ReplyT<Request>;
+    send(std::move(ctx), std::move(req), &McServerRequestContext::reply<Reply>);
+  }
+
+  void onRequest(McServerRequestContext&& ctx, McVersionRequest&&) {
+    McVersionReply reply(mc_res_ok);
+    reply.value() =
+        folly::IOBuf(folly::IOBuf::COPY_BUFFER, MCROUTER_PACKAGE_STRING);
+
+    McServerRequestContext::reply(std::move(ctx), std::move(reply));
+  }
+
+  void onRequest(McServerRequestContext&& ctx, McQuitRequest&&) {
+    McServerRequestContext::reply(std::move(ctx), McQuitReply(mc_res_ok));
+  }
+
+  void onRequest(McServerRequestContext&& ctx, McShutdownRequest&&) {
+    McServerRequestContext::reply(std::move(ctx), McShutdownReply(mc_res_ok));
+  }
+
+  template <class Request>
+  void send(
+      McServerRequestContext&& ctx,
+      Request&& req,
+      ReplyFunction<Request> replyFn) {
+    auto incastWindow = proxy_ ? proxy_->incastWindow() : nullptr;
+    if (incastWindow && ctx.multiOpId()) {
+      sendPaced(std::move(ctx), std::move(req), replyFn);
+    } else {
+      sendNow(std::move(ctx), std::move(req), replyFn);
+    }
+  }
+
+ private:
+  CarbonRouterClient<RouterInfo>& client_;
+  bool retainSourceIp_{false};
+  ProxyBase* proxy_{nullptr};
+  // Only used if proxy_ has an incast window.
+  MultiGetPacer multiGetPacer_;
+
+  template <class Request>
+  void sendNow(
+      McServerRequestContext&& ctx,
+      Request&& req,
+      ReplyFunction<Request> replyFn,
+      folly::Function<void()> onReplied = nullptr) {
+    auto rctx = std::make_unique<ServerRequestContext<Request>>(
+        std::move(ctx), std::move(req));
+    auto& reqRef = rctx->req;
+    auto& sessionRef = rctx->ctx.session();
+
+    auto cb = [
+      sctx = std::move(rctx),
+      replyFn,
+      onReplied = std::move(onReplied)
+    ](const Request&, ReplyT<Request>&& reply) mutable {
+      replyFn(std::move(sctx->ctx), std::move(reply));
+      if (onReplied) {
+        onReplied();
+      }
+    };
+
+    if (retainSourceIp_) {
+      auto peerIp = sessionRef.getSocketAddress().getAddressStr();
+      client_.send(reqRef, std::move(cb), peerIp);
+    } else {
+      client_.send(reqRef, std::move(cb));
+    }
+  }
+
+  /**
+   * Sends a key of an ascii multiget through multiGetPacer_.
+   *
+   * Callbacks refer to this, which is kept alive by the sessions whose
+   * requests are outstanding.
+   */
+  template <class Request>
+  void sendPaced(
+      McServerRequestContext&& ctx,
+      Request&& req,
+      ReplyFunction<Request> replyFn) {
+    const auto multiGetId = ctx.multiOpId();
+    auto sendKey = [
+      this,
+      ctx = std::move(ctx),
+      req = std::move(req),
+      replyFn
+    ](folly::Function<void()> onReplied) mutable {
+      sendNow(std::move(ctx), std::move(req), replyFn, std::move(onReplied));
+    };
+    if (!multiGetPacer_.send(multiGetId, std::move(sendKey))) {
+      proxy_->stats().increment(multiget_keys_deferred_stat);
+    }
+  }
+};
+} // mcrouter
+} // memcache
+} // facebook
@@ -7,6 +7,7 @@
  */
 #pragma once
 
+#include <algorithm>
 #include <functional>
 #include <memory>
 #include <string>
@@ -335,6 +336,107 @@ ServiceInfo<RouterInfo>::ServiceInfoImpl::ServiceInfoImpl(
         return toPrettySortedJson(builder.preprocessedConfig());
       });
 
+  commands_.emplace(
+      "hot_keys", [this](const std::vector<folly::StringPiece>& args) {
+        if (args.size() > 1) {
+          throw std::runtime_error("hot_keys: at most 1 arg expected");
+        }
+        auto& router = proxy_.router();
+        size_t limit = args.empty() ? router.opts().hot_key_top_k
+                                    : folly::to<size_t>(args[0]);
+
+        // Each proxy only sees its share of the traffic, so sum up
+        // the estimates across all of them.
+        std::unordered_map<std::string, uint64_t> counts;
+        for (size_t i = 0; i < router.opts().num_proxies; ++i) {
+          if (auto proxy = router.getProxyBase(i)) {
+            for (auto& it : proxy->hotKeyTracker().topKeys()) {
+              counts[std::move(it.first)] += it.second;
+            }
+          }
+        }
+        std::vector<std::pair<std::string, uint64_t>> sorted(
+            counts.begin(), counts.end());
+        std::sort(
+            sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
+              return a.second > b.second;
+            });
+        sorted.resize(std::min(sorted.size(), limit));
+
+        std::string res;
+        for (const auto& it : sorted) {
+          if (!res.empty()) {
+            res.push_back('\n');
+          }
+          res += folly::sformat("{} {}", it.first, it.second);
+        }
+        return res;
+      });
+
+  commands_.emplace(
+      "slow_requests", [this](const std::vector<folly::StringPiece>& args) {
+        if (!args.empty()) {
+          throw std::runtime_error("slow_requests: no args expected");
+        }
+        auto& router = proxy_.router();
+        std::string res;
+        for (size_t i = 0; i < router.opts().num_proxies; ++i) {
+          if (auto proxy = router.getProxyBase(i)) {
+            for (const auto& timeline : proxy->slowRequestTracer().recent()) {
+              if (!res.empty()) {
+                res.push_back('\n');
+              }
+              res += folly::sformat("proxy {}: {}", i, timeline);
+            }
+          }
+        }
+        return res;
+      });
+
+  commands_.emplace(
+      "tenant_queue_depths",
+      [this](const std::vector<folly::StringPiece>& /* args */) {
+        auto& router = proxy_.router();
+        std::unordered_map<std::string, size_t> depths;
+        for (size_t i = 0; i < router.opts().num_proxies; ++i) {
+          if (auto proxy = router.getProxyBase(i)) {
+            for (auto& it : proxy->tenantQueueDepths()) {
+              depths[it.first] += it.second;
+            }
+          }
+        }
+        std::vector<std::pair<std::string, size_t>> sorted(
+            depths.begin(), depths.end());
+        std::sort(
+            sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
+              return a.second > b.second;
+            });
+
+        std::string res;
+        for (const auto& it : sorted) {
+          if (!res.empty()) {
+            res.push_back('\n');
+          }
+          res += folly::sformat("{} {}", it.first, it.second);
+        }
+        return res;
+      });
+
+  commands_.emplace(
+      "active_proxies", [this](const std::vector<folly::StringPiece>& args) {
+        auto& router = proxy_.router();
+        if (args.size() == 1) {
+          auto before = router.numActiveProxies();
+          router.setNumActiveProxies(folly::to<size_t>(args[0]));
+          return folly::sformat("{} -> {}", before, router.numActiveProxies());
+        } else if (args.empty()) {
+          return folly::to<std::string>(router.numActiveProxies());
+        }
+        throw std::runtime_error(
+            "expected at most 1 argument, got " +
+            folly::to<std::string>(args.size()));
+      });
+
   commands_.emplace(
       "hostid", [](const std::vector<folly::StringPiece>& /* args */) {
         return folly::to<std::string>(globals::hostid());
@@ -0,0 +1,83 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include "SlowRequestTracer.h"
+
+#include <algorithm>
+
+#include <folly/Format.h>
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+namespace {
+
+const char* eventName(RequestTimeline::Event event) {
+  switch (event) {
+    case RequestTimeline::Event::RouteStart:
+      return "route_start";
+    case RequestTimeline::Event::DestinationSend:
+      return "send";
+    case RequestTimeline::Event::DestinationReply:
+      return "reply";
+    case RequestTimeline::Event::ReplySent:
+      return "reply_sent";
+  }
+  return "unknown";
+}
+
+} // anonymous namespace
+
+constexpr size_t RequestTimeline::kMaxEvents;
+
+std::string RequestTimeline::toString(int64_t durationUs) const {
+  auto res = folly::sformat("{}us {} {}:", durationUs, operation_, key_);
+  for (size_t i = 0; i < numEvents_; ++i) {
+    const auto& entry = events_[i];
+    res += folly::sformat(" +{}us {}", entry.offsetUs, eventName(entry.event));
+    if (!entry.pool.empty()) {
+      res += folly::sformat(" {}", entry.pool);
+    }
+    if (entry.event == Event::DestinationReply) {
+      res += folly::sformat(" {}", mc_res_to_string(entry.result));
+    }
+    res += ',';
+  }
+  if (numDropped_ != 0) {
+    res += folly::sformat(" {} more events", numDropped_);
+  } else if (numEvents_ != 0) {
+    res.pop_back();
+  }
+  return res;
+}
+
+SlowRequestTracer::SlowRequestTracer(
+    uint64_t thresholdUs,
+    size_t sampleRate,
+    size_t capacity)
+    : thresholdUs_(capacity != 0 ? thresholdUs : 0),
+      sampleRate_(std::max<size_t>(sampleRate, 1)),
+      capacity_(capacity),
+      countdown_(sampleRate_) {}
+
+void SlowRequestTracer::keep(std::string timeline) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (timelines_.size() == capacity_) {
+    timelines_.pop_front();
+  }
+  timelines_.push_back(std::move(timeline));
+}
+
+std::vector<std::string> SlowRequestTracer::recent() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return std::vector<std::string>(timelines_.begin(), timelines_.end());
+}
+
+} // mcrouter
+} // memcache
+} // facebook
@@ -0,0 +1,143 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <folly/Range.h>
+
+#include "mcrouter/lib/mc/msg.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * What happened to a request and when, relative to the request start.
+ * Holds at most kMaxEvents events, later ones are only counted.
+ */
+class RequestTimeline {
+ public:
+  enum class Event : uint8_t {
+    RouteStart,
+    DestinationSend,
+    DestinationReply,
+    ReplySent,
+  };
+
+  static constexpr size_t kMaxEvents = 16;
+
+  RequestTimeline(
+      int64_t startUs,
+      const char* operation,
+      folly::StringPiece key)
+      : startUs_(startUs), operation_(operation), key_(key.str()) {}
+
+  /**
+   * @param pool  Pool of the destination for destination events. Must stay
+   *              valid until the timeline is finished.
+   */
+  void record(
+      Event event,
+      int64_t timeUs,
+      folly::StringPiece pool = folly::StringPiece(),
+      mc_res_t result = mc_res_unknown) {
+    if (numEvents_ == kMaxEvents) {
+      ++numDropped_;
+      return;
+    }
+    auto& entry = events_[numEvents_++];
+    entry.offsetUs = timeUs > startUs_ ? timeUs - startUs_ : 0;
+    entry.event = event;
+    entry.result = result;
+    entry.pool = pool;
+  }
+
+  /**
+   * One line: duration, operation, key and the events with their offsets.
+   */
+  std::string toString(int64_t durationUs) const;
+
+ private:
+  struct Entry {
+    int64_t offsetUs;
+    folly::StringPiece pool;
+    mc_res_t result;
+    Event event;
+  };
+
+  const int64_t startUs_;
+  const char* const operation_;
+  const std::string key_;
+  std::array<Entry, kMaxEvents> events_;
+  size_t numEvents_{0};
+  size_t numDropped_{0};
+};
+
+/**
+ * Keeps the timelines of the most recent slow requests of a proxy.
+ *
+ * Requests that take at least thresholdUs are slow, one in sampleRate of
+ * them is kept, and the last `capacity` kept ones can be read.
+ *
+ * finish() must only be called from the owning proxy thread; recent()
+ * may be called from any thread.
+ */
+class SlowRequestTracer {
+ public:
+  /**
+   * @param thresholdUs  0 disables tracing.
+   */
+  SlowRequestTracer(uint64_t thresholdUs, size_t sampleRate, size_t capacity);
+
+  /**
+   * If false, requests don't need a timeline.
+   */
+  bool enabled() const {
+    return thresholdUs_ != 0;
+  }
+
+  /**
+   * @return  true if the timeline was kept.
+   */
+  bool finish(const RequestTimeline& timeline, int64_t durationUs) {
+    if (!enabled() || durationUs < static_cast<int64_t>(thresholdUs_) ||
+        --countdown_ > 0) {
+      return false;
+    }
+    countdown_ = sampleRate_;
+    keep(timeline.toString(durationUs));
+    return true;
+  }
+
+  /**
+   * @return  kept timelines, most recent last.
+   */
+  std::vector<std::string> recent() const;
+
+ private:
+  const uint64_t thresholdUs_;
+  const size_t sampleRate_;
+  const size_t capacity_;
+  size_t countdown_;
+
+  mutable std::mutex mutex_;
+  std::deque<std::string> timelines_;
+
+  void keep(std::string timeline);
+};
+
+} // mcrouter
+} // memcache
+} // facebook
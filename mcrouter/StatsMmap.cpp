@@ -0,0 +1,124 @@
+/*
+ *  Copyright (c) 2016-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include "StatsMmap.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+
+#include <folly/Exception.h>
+#include <folly/File.h>
+
+#include "mcrouter/stats.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+constexpr uint32_t StatsMmapHeader::kMagic;
+constexpr uint32_t StatsMmapHeader::kVersion;
+constexpr size_t StatsMmapEntry::kMaxNameLength;
+
+namespace {
+
+bool isExported(const stat_t& stat) {
+  return stat.type == stat_uint64 || stat.type == stat_int64 ||
+      stat.type == stat_double;
+}
+
+uint64_t nowMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+} // anonymous
+
+StatsMmapWriter::StatsMmapWriter(
+    const std::string& path,
+    const std::vector<stat_t>& stats) {
+  for (size_t i = 0; i < stats.size(); ++i) {
+    if (isExported(stats[i])) {
+      statIndices_.push_back(i);
+    }
+  }
+  size_ = sizeof(StatsMmapHeader) +
+      statIndices_.size() * sizeof(StatsMmapEntry);
+
+  // Build the file aside and rename it, so that readers never map a
+  // partially initialized (or truncated) file.
+  const auto tmpPath = path + ".tmp";
+  folly::File file(tmpPath, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  folly::checkUnixError(
+      ftruncate(file.fd(), size_), "Can't resize stats file ", tmpPath);
+  data_ = mmap(
+      nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, file.fd(), 0);
+  if (data_ == MAP_FAILED) {
+    data_ = nullptr;
+    folly::throwSystemError("Can't mmap stats file ", tmpPath);
+  }
+
+  auto& hdr = header();
+  hdr.magic = StatsMmapHeader::kMagic;
+  hdr.version = StatsMmapHeader::kVersion;
+  hdr.sequence = 0;
+  hdr.updateTimeMs = 0;
+  hdr.numEntries = statIndices_.size();
+  hdr.entrySize = sizeof(StatsMmapEntry);
+  for (size_t i = 0; i < statIndices_.size(); ++i) {
+    const auto& stat = stats[statIndices_[i]];
+    auto& entry = entries()[i];
+    const auto nameLength =
+        std::min(stat.name.size(), StatsMmapEntry::kMaxNameLength);
+    std::memcpy(entry.name, stat.name.data(), nameLength);
+    entry.name[nameLength] = '\0';
+    entry.type = stat.type;
+    entry.value = stat.data.uint64;
+  }
+
+  if (rename(tmpPath.c_str(), path.c_str()) != 0) {
+    munmap(data_, size_);
+    data_ = nullptr;
+    folly::throwSystemError("Can't rename stats file to ", path);
+  }
+}
+
+StatsMmapWriter::~StatsMmapWriter() {
+  if (data_) {
+    munmap(data_, size_);
+  }
+}
+
+void StatsMmapWriter::write(const std::vector<stat_t>& stats) {
+  auto& hdr = header();
+  const auto sequence = hdr.sequence;
+  __atomic_store_n(&hdr.sequence, sequence + 1, __ATOMIC_RELAXED);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  for (size_t i = 0; i < statIndices_.size(); ++i) {
+    const auto idx = statIndices_[i];
+    if (idx >= stats.size()) {
+      break;
+    }
+    auto& entry = entries()[i];
+    __atomic_store_n(&entry.type, stats[idx].type, __ATOMIC_RELAXED);
+    __atomic_store_n(&entry.value, stats[idx].data.uint64, __ATOMIC_RELAXED);
+  }
+  __atomic_store_n(&hdr.updateTimeMs, nowMs(), __ATOMIC_RELAXED);
+
+  __atomic_store_n(&hdr.sequence, sequence + 2, __ATOMIC_RELEASE);
+}
+
+} // mcrouter
+} // memcache
+} // facebook
@@ -0,0 +1,105 @@
+/*
+ *  Copyright (c) 2016-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+struct stat_t;
+
+/**
+ * Layout of the stats file written by StatsMmapWriter:
+ *
+ *   StatsMmapHeader, followed by header.numEntries StatsMmapEntry.
+ *
+ * All integers are in host byte order. Entries never change their order or
+ * names for the lifetime of the file, so readers may cache the name -> index
+ * mapping and then only re-read the values.
+ *
+ * The snapshot is protected by a seqlock: readers load `sequence`, copy the
+ * values, then load `sequence` again, and retry if it changed or is odd.
+ */
+struct StatsMmapHeader {
+  static constexpr uint32_t kMagic = 0x5453434d; // "MCST"
+  static constexpr uint32_t kVersion = 1;
+
+  uint32_t magic;
+  uint32_t version;
+  uint64_t sequence;
+  // Wall clock time of the last update, in milliseconds since epoch.
+  uint64_t updateTimeMs;
+  uint32_t numEntries;
+  uint32_t entrySize;
+};
+
+struct StatsMmapEntry {
+  static constexpr size_t kMaxNameLength = 47;
+
+  // NUL-terminated.
+  char name[kMaxNameLength + 1];
+  // One of stat_type_t: stat_uint64, stat_int64 or stat_double.
+  uint32_t type;
+  uint32_t reserved;
+  // Raw bits of the value, as in stat_t::data.
+  uint64_t value;
+};
+
+static_assert(sizeof(StatsMmapHeader) == 32, "Stats file layout changed");
+static_assert(sizeof(StatsMmapEntry) == 64, "Stats file layout changed");
+
+/**
+ * Exports numeric stats through a memory-mapped file, so that external
+ * monitoring can scrape them without sending a request to mcrouter.
+ *
+ * Not thread-safe: all updates must come from the same thread.
+ */
+class StatsMmapWriter {
+ public:
+  /**
+   * Creates (or truncates) the file at `path` and maps it.
+   * Entries are created for the numeric stats in `stats`, in order.
+   *
+   * @throw std::system_error  if the file can't be created or mapped.
+   */
+  StatsMmapWriter(const std::string& path, const std::vector<stat_t>& stats);
+  ~StatsMmapWriter();
+
+  StatsMmapWriter(const StatsMmapWriter&) = delete;
+  StatsMmapWriter& operator=(const StatsMmapWriter&) = delete;
+
+  /**
+   * Publishes a new snapshot. `stats` must have the same stats, in the same
+   * order, as the ones passed to the constructor; types may differ (e.g. rate
+   * stats converted to stat_double).
+   */
+  void write(const std::vector<stat_t>& stats);
+
+ private:
+  void* data_{nullptr};
+  size_t size_{0};
+  // Indices in the stats vector of the exported stats.
+  std::vector<size_t> statIndices_;
+
+  StatsMmapHeader& header() {
+    return *static_cast<StatsMmapHeader*>(data_);
+  }
+  StatsMmapEntry* entries() {
+    return reinterpret_cast<StatsMmapEntry*>(
+        static_cast<char*>(data_) + sizeof(StatsMmapHeader));
+  }
+};
+
+} // mcrouter
+} // memcache
+} // facebook
@@ -7,7 +7,21 @@
  */
 #include "ThreadUtil.h"
 
+#include <pthread.h>
+#include <sched.h>
+
+#ifdef __linux__
+#include <linux/mempolicy.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <folly/Conv.h>
+#include <folly/FileUtil.h>
 #include <folly/Format.h>
+#include <folly/String.h>
+#include <folly/memory/MallctlHelper.h>
+#include <folly/memory/Malloc.h>
 #include <folly/system/ThreadName.h>
 
 #include "mcrouter/options.h"
@@ -24,6 +38,164 @@ void mcrouterSetThisThreadName(
     LOG(WARNING) << "Unable to set thread name to " << name;
   }
 }
+
+folly::Optional<unsigned> bindThisThreadToNewJemallocArena() {
+  if (!folly::usingJEMalloc()) {
+    return folly::none;
+  }
+  try {
+    unsigned arena;
+    folly::mallctlRead("arenas.create", &arena);
+    folly::mallctlWrite("thread.arena", arena);
+    // Cached allocations came from the old arena.
+    folly::mallctlCall("thread.tcache.flush");
+    return arena;
+  } catch (const std::exception& e) {
+    LOG(WARNING) << "Unable to bind thread to a new jemalloc arena: "
+                 << e.what();
+    return folly::none;
+  }
+}
+
+folly::Optional<JemallocArenaStats> getJemallocArenaStats(unsigned arena) {
+  if (!folly::usingJEMalloc()) {
+    return folly::none;
+  }
+  try {
+    // Stats are only refreshed when the epoch is bumped.
+    folly::mallctlWrite<uint64_t>("epoch", 1);
+    auto prefix = folly::sformat("stats.arenas.{}.", arena);
+    size_t small;
+    size_t large;
+    size_t pactive;
+    size_t pageSize;
+    folly::mallctlRead((prefix + "small.allocated").c_str(), &small);
+    folly::mallctlRead((prefix + "large.allocated").c_str(), &large);
+    folly::mallctlRead((prefix + "pactive").c_str(), &pactive);
+    folly::mallctlRead("arenas.page", &pageSize);
+    JemallocArenaStats stats;
+    stats.allocated = small + large;
+    stats.active = pactive * pageSize;
+    return stats;
+  } catch (const std::exception&) {
+    return folly::none;
+  }
+}
+
+std::vector<size_t> parseCpuList(folly::StringPiece list) {
+  std::vector<size_t> cpus;
+  std::vector<folly::StringPiece> ranges;
+  folly::split(
+      ',', folly::trimWhitespace(list), ranges, true /* ignoreEmpty */);
+  for (auto range : ranges) {
+    auto first = range.split_step('-');
+    const auto begin = folly::to<size_t>(first);
+    const auto end = range.empty() ? begin : folly::to<size_t>(range);
+    for (auto cpu = begin; cpu <= end; ++cpu) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+std::vector<std::vector<size_t>> getNumaNodeCpus() {
+  std::vector<std::vector<size_t>> nodeCpus;
+  try {
+    std::string online;
+    if (!folly::readFile("/sys/devices/system/node/online", online)) {
+      return nodeCpus;
+    }
+    for (auto node : parseCpuList(online)) {
+      std::string cpuList;
+      auto path =
+          folly::sformat("/sys/devices/system/node/node{}/cpulist", node);
+      if (!folly::readFile(path.c_str(), cpuList)) {
+        return {};
+      }
+      nodeCpus.resize(node + 1);
+      nodeCpus[node] = parseCpuList(cpuList);
+    }
+  } catch (const std::exception& e) {
+    LOG(WARNING) << "Unable to read NUMA topology: " << e.what();
+    return {};
+  }
+  return nodeCpus;
+}
+
+std::vector<size_t> getNumaNodesWithCpus(
+    const std::vector<std::vector<size_t>>& nodeCpus) {
+  std::vector<size_t> nodes;
+  for (size_t node = 0; node < nodeCpus.size(); ++node) {
+    if (!nodeCpus[node].empty()) {
+      nodes.push_back(node);
+    }
+  }
+  return nodes;
+}
+
+folly::Optional<size_t> getThisThreadNumaNode(
+    const std::vector<std::vector<size_t>>& nodeCpus) {
+  cpu_set_t cpuSet;
+  CPU_ZERO(&cpuSet);
+  if (pthread_getaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) != 0) {
+    return folly::none;
+  }
+  for (size_t node = 0; node < nodeCpus.size(); ++node) {
+    size_t onNode = 0;
+    for (auto cpu : nodeCpus[node]) {
+      if (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &cpuSet)) {
+        ++onNode;
+      }
+    }
+    if (onNode != 0) {
+      if (onNode != static_cast<size_t>(CPU_COUNT(&cpuSet))) {
+        return folly::none;
+      }
+      return node;
+    }
+  }
+  return folly::none;
+}
+
+bool bindThisThreadToNumaNode(
+    size_t node,
+    const std::vector<std::vector<size_t>>& nodeCpus) {
+  if (node >= nodeCpus.size() || nodeCpus[node].empty()) {
+    return false;
+  }
+  auto currentNode = getThisThreadNumaNode(nodeCpus);
+  if (!currentNode || *currentNode != node) {
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    for (auto cpu : nodeCpus[node]) {
+      if (cpu < CPU_SETSIZE) {
+        CPU_SET(cpu, &cpuSet);
+      }
+    }
+    int err = pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+    if (err != 0) {
+      LOG(WARNING) << "Unable to bind thread to CPUs of NUMA node " << node
+                   << ": " << folly::errnoStr(err);
+      return false;
+    }
+  }
+#ifdef __linux__
+  constexpr size_t kBitsPerLong = 8 * sizeof(unsigned long);
+  std::vector<unsigned long> nodeMask(node / kBitsPerLong + 1);
+  nodeMask[node / kBitsPerLong] = 1UL << (node % kBitsPerLong);
+  // The kernel ignores the last bit of maxnode.
+  const unsigned long maxNode = nodeMask.size() * kBitsPerLong + 1;
+  if (syscall(
+          SYS_set_mempolicy, MPOL_PREFERRED, nodeMask.data(), maxNode) != 0) {
+    LOG(WARNING) << "Unable to prefer memory of NUMA node " << node << ": "
+                 << folly::errnoStr(errno);
+    return false;
+  }
+  return true;
+#else
+  return false;
+#endif
+}
 }
 }
 } // facebook::memcache::mcrouter
@@ -7,6 +7,10 @@
  */
 #pragma once
 
+#include <cstddef>
+#include <vector>
+
+#include <folly/Optional.h>
 #include <folly/Range.h>
 
 namespace facebook {
@@ -19,6 +23,65 @@ namespace mcrouter {
 void mcrouterSetThisThreadName(
     const McrouterOptions& opts,
     folly::StringPiece prefix);
+
+/**
+ * Creates a new jemalloc arena and makes the calling thread allocate from it.
+ *
+ * @return index of the new arena, or none if mcrouter doesn't run with
+ *         jemalloc or the arena couldn't be created.
+ */
+folly::Optional<unsigned> bindThisThreadToNewJemallocArena();
+
+struct JemallocArenaStats {
+  // bytes allocated by the application
+  size_t allocated{0};
+  // bytes in pages backing those allocations
+  size_t active{0};
+};
+
+/**
+ * @return current stats of the given jemalloc arena, or none if they aren't
+ *         available (e.g. jemalloc was built without stats).
+ */
+folly::Optional<JemallocArenaStats> getJemallocArenaStats(unsigned arena);
+
+/**
+ * Parses lists like "0-3,8,10-11" used by sysfs.
+ *
+ * @throws std::exception  if the list is malformed.
+ */
+std::vector<size_t> parseCpuList(folly::StringPiece list);
+
+/**
+ * @return  CPUs of every NUMA node, indexed by node. Empty if the system
+ *          doesn't expose its NUMA topology. Node ids may have gaps, and
+ *          nodes may have no CPUs (e.g. memory-only nodes).
+ */
+std::vector<std::vector<size_t>> getNumaNodeCpus();
+
+/**
+ * @return  Ids of the nodes that have CPUs, in increasing order.
+ */
+std::vector<size_t> getNumaNodesWithCpus(
+    const std::vector<std::vector<size_t>>& nodeCpus);
+
+/**
+ * @return  The node all CPUs the calling thread may run on belong to, or none
+ *          if they span several nodes.
+ */
+folly::Optional<size_t> getThisThreadNumaNode(
+    const std::vector<std::vector<size_t>>& nodeCpus);
+
+/**
+ * Restricts the calling thread to the CPUs of the given NUMA node (unless
+ * it already runs on that node only) and makes it prefer memory of that node
+ * for pages it touches first.
+ *
+ * @return  false if either could not be set.
+ */
+bool bindThisThreadToNumaNode(
+    size_t node,
+    const std::vector<std::vector<size_t>>& nodeCpus);
 }
 }
 } // facebook::memcache::mcrouter
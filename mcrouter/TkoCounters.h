@@ -19,6 +19,11 @@ namespace mcrouter {
 struct TkoCounters {
   std::atomic<size_t> softTkos{0};
   std::atomic<size_t> hardTkos{0};
+  // Boxes ejected for being latency outliers. These are also counted in
+  // softTkos (or hardTkos once they fail hard).
+  std::atomic<size_t> latencyTkos{0};
+  // Boxes ejected for a high error rate, also counted in softTkos/hardTkos.
+  std::atomic<size_t> errorRateTkos{0};
 
   size_t totalTko() const {
     return softTkos + hardTkos;
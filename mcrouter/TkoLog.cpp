@@ -22,6 +22,10 @@ std::string TkoLog::eventName() const {
       return "mark_hard_tko";
     case TkoLogEvent::MarkSoftTko:
       return "mark_soft_tko";
+    case TkoLogEvent::MarkLatencyTko:
+      return "mark_latency_tko";
+    case TkoLogEvent::MarkErrorRateTko:
+      return "mark_error_rate_tko";
     case TkoLogEvent::RemoveFromConfig:
       return "remove_from_config";
     case TkoLogEvent::UnMarkTko:
@@ -24,6 +24,8 @@ namespace mcrouter {
 enum class TkoLogEvent {
   MarkHardTko,
   MarkSoftTko,
+  MarkLatencyTko,
+  MarkErrorRateTko,
   RemoveFromConfig,
   UnMarkTko
 };
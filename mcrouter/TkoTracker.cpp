@@ -7,13 +7,18 @@
  */
 #include "TkoTracker.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <functional>
+#include <unordered_map>
+#include <vector>
 
 #include <folly/MapUtil.h>
 
 #include "mcrouter/ProxyDestination.h"
 #include "mcrouter/TkoCounters.h"
+#include "mcrouter/options.h"
 
 namespace facebook {
 namespace memcache {
@@ -130,6 +135,52 @@ bool TkoTracker::recordHardFailure(ProxyDestination* pdstn) {
   return success;
 }
 
+bool TkoTracker::recordLatencyOutlier(ProxyDestination* pdstn) {
+  /* Only one proxy gets to act on the flag */
+  if (!latencyOutlierPending_.exchange(false)) {
+    return false;
+  }
+  if (!markSoftTko(pdstn)) {
+    return false;
+  }
+  latencyTko_ = true;
+  ++trackerMap_.globalTkos_.latencyTkos;
+  return true;
+}
+
+bool TkoTracker::recordErrorRateTrip(ProxyDestination* pdstn) {
+  ++consecutiveFailureCount_;
+
+  if (!markSoftTko(pdstn)) {
+    return false;
+  }
+  errorRateTko_ = true;
+  ++trackerMap_.globalTkos_.errorRateTkos;
+  return true;
+}
+
+bool TkoTracker::recordRestoredTko(ProxyDestination* pdstn, bool hard) {
+  if (hard) {
+    return recordHardFailure(pdstn);
+  }
+  ++consecutiveFailureCount_;
+  return markSoftTko(pdstn);
+}
+
+bool TkoTracker::markSoftTko(ProxyDestination* pdstn) {
+  if (isTko()) {
+    return false;
+  }
+
+  incrementSoftTkoCount();
+  if (!setSumFailures(reinterpret_cast<uintptr_t>(pdstn))) {
+    /* Someone else marked the box TKO in the meantime */
+    decrementSoftTkoCount();
+    return false;
+  }
+  return true;
+}
+
 bool TkoTracker::isResponsible(ProxyDestination* pdstn) const {
   return (sumFailures_ & ~1) == reinterpret_cast<uintptr_t>(pdstn);
 }
@@ -145,6 +196,16 @@ bool TkoTracker::recordSuccess(ProxyDestination* pdstn) {
     if (isHardTko()) {
       --trackerMap_.globalTkos_.hardTkos;
     }
+    if (latencyTko_) {
+      latencyTko_ = false;
+      --trackerMap_.globalTkos_.latencyTkos;
+      /* Start from a clean slate, the old samples got the box ejected */
+      latencies_.reset();
+    }
+    if (errorRateTko_) {
+      errorRateTko_ = false;
+      --trackerMap_.globalTkos_.errorRateTkos;
+    }
     sumFailures_ = 0;
     consecutiveFailureCount_ = 0;
     return true;
@@ -199,6 +260,154 @@ void TkoTrackerMap::updateTracker(
   pdstn.tracker = std::move(tracker);
 }
 
+void TkoTrackerMap::addToLatencyPool(
+    folly::StringPiece pool,
+    const ProxyDestination& pdstn) {
+  auto key = pdstn.accessPoint()->toHostPortString();
+  std::lock_guard<std::mutex> lock(mx_);
+  latencyPools_[pool][key] = pdstn.tracker;
+}
+
+folly::dynamic TkoTrackerMap::getTkoState() const {
+  auto state = folly::dynamic::object();
+  foreachTkoTracker(
+      [&state](folly::StringPiece key, const TkoTracker& tracker) {
+        if (tracker.isHardTko()) {
+          state[key] = "hard";
+        } else if (tracker.isSoftTko()) {
+          state[key] = "soft";
+        }
+      });
+  return state;
+}
+
+void TkoTrackerMap::setRestoredTkoState(const folly::dynamic& state) {
+  if (!state.isObject()) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mx_);
+  restoredTkos_.clear();
+  for (const auto& it : state.items()) {
+    if (it.first.isString() && it.second.isString()) {
+      restoredTkos_[it.first.stringPiece()] = it.second.stringPiece() == "hard";
+    }
+  }
+}
+
+folly::Optional<bool> TkoTrackerMap::popRestoredTko(folly::StringPiece key) {
+  std::lock_guard<std::mutex> lock(mx_);
+  if (restoredTkos_.empty()) {
+    return folly::none;
+  }
+  auto it = restoredTkos_.find(key);
+  if (it == restoredTkos_.end()) {
+    return folly::none;
+  }
+  const bool hard = it->second;
+  restoredTkos_.erase(it);
+  return hard;
+}
+
+void TkoTrackerMap::updateLatencyOutliers(const McrouterOptions& opts) {
+  // As in foreachTkoTracker(), trackers must be released after "mx_" is
+  // unlocked, since destroying one locks "mx_".
+  std::vector<std::vector<std::shared_ptr<TkoTracker>>> pools;
+  {
+    std::lock_guard<std::mutex> lock(mx_);
+    pools.reserve(latencyPools_.size());
+    for (auto poolIt = latencyPools_.begin(); poolIt != latencyPools_.end();) {
+      auto& members = poolIt->second;
+      std::vector<std::shared_ptr<TkoTracker>> trackers;
+      trackers.reserve(members.size());
+      for (auto it = members.begin(); it != members.end();) {
+        if (auto tracker = it->second.lock()) {
+          trackers.push_back(std::move(tracker));
+          ++it;
+        } else {
+          it = members.erase(it);
+        }
+      }
+      if (members.empty()) {
+        poolIt = latencyPools_.erase(poolIt);
+      } else {
+        pools.push_back(std::move(trackers));
+        ++poolIt;
+      }
+    }
+  }
+
+  // A host may be in several pools, take a single snapshot of its latency.
+  std::unordered_map<const TkoTracker*, uint64_t> latencies;
+  for (const auto& trackers : pools) {
+    for (const auto& tracker : trackers) {
+      if (latencies.count(tracker.get())) {
+        continue;
+      }
+      uint64_t latency = 0;
+      if (!tracker->isTko() &&
+          tracker->latencies_.count() >=
+              static_cast<uint64_t>(opts.latency_tko_min_samples)) {
+        latency = tracker->latencies_.percentile(opts.latency_tko_percentile);
+      }
+      tracker->latencies_.reset();
+      latencies.emplace(tracker.get(), latency);
+    }
+  }
+
+  std::vector<std::pair<uint64_t, TkoTracker*>> candidates;
+  std::vector<uint64_t> values;
+  for (const auto& trackers : pools) {
+    size_t ejected = 0;
+    candidates.clear();
+    values.clear();
+    for (const auto& tracker : trackers) {
+      if (tracker->isLatencyTko() || tracker->latencyOutlierPending()) {
+        ++ejected;
+        continue;
+      }
+      auto latency = latencies[tracker.get()];
+      if (latency > 0) {
+        candidates.emplace_back(latency, tracker.get());
+        values.push_back(latency);
+      }
+    }
+    // Need a handful of hosts for the median to mean anything.
+    if (values.size() < 3) {
+      continue;
+    }
+
+    auto mid = values.begin() + values.size() / 2;
+    std::nth_element(values.begin(), mid, values.end());
+    const uint64_t threshold = std::max<uint64_t>(
+        opts.latency_tko_min_latency_us,
+        opts.latency_tko_multiplier * *mid);
+
+    // Rounded up, so that pools of fewer than 1 / max_fraction hosts can
+    // still eject one.
+    const size_t maxEjected = static_cast<size_t>(
+        std::ceil(opts.latency_tko_max_fraction * trackers.size()));
+    if (ejected >= maxEjected) {
+      continue;
+    }
+    // Slowest first, so the cap ejects the worst offenders.
+    std::sort(
+        candidates.begin(),
+        candidates.end(),
+        [](const std::pair<uint64_t, TkoTracker*>& a,
+           const std::pair<uint64_t, TkoTracker*>& b) {
+          return a.first > b.first;
+        });
+    for (const auto& candidate : candidates) {
+      if (candidate.first < threshold || ejected >= maxEjected) {
+        break;
+      }
+      candidate.second->latencyTkoThresholdUs_ = threshold;
+      candidate.second->latencyOutlierPending_ = true;
+      ++ejected;
+    }
+  }
+}
+
 std::unordered_map<std::string, std::pair<bool, size_t>>
 TkoTrackerMap::getSuspectServers() const {
   std::unordered_map<std::string, std::pair<bool, size_t>> result;
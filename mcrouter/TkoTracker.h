@@ -15,15 +15,19 @@
 #include <unordered_map>
 #include <utility>
 
+#include <folly/Optional.h>
 #include <folly/Range.h>
+#include <folly/dynamic.h>
 #include <folly/experimental/StringKeyedUnorderedMap.h>
 
+#include "mcrouter/LatencyHistogram.h"
 #include "mcrouter/TkoCounters.h"
 
 namespace facebook {
 namespace memcache {
 namespace mcrouter {
 
+class McrouterOptions;
 class ProxyDestination;
 class TkoTrackerMap;
 
@@ -41,6 +45,13 @@ class TkoTrackerMap;
  * soft to hard TKO, but once hard TKO the box must send a successful reply to
  * be unmarked.
  *
+ * Latency TKOs are soft TKOs of boxes that reply, but much slower than the
+ * rest of their pool. TkoTrackerMap periodically compares latency
+ * histograms and flags outliers; the next proxy to get a reply from a flagged
+ * box marks it TKO and becomes responsible for probing it. Error rate TKOs
+ * work the same way, but are triggered by a proxy whose sliding window error
+ * rate went over the pool's threshold.
+ *
  * Perf implications: recordSuccess() with no previous failures and isTko()
  * are lock-free, so the common (no error results) path is fast.
  *
@@ -115,6 +126,90 @@ class TkoTracker {
    */
   bool recordHardFailure(ProxyDestination* pdstn);
 
+  /**
+   * @return Was the destination marked TKO for being a latency outlier?
+   */
+  bool isLatencyTko() const {
+    return latencyTko_;
+  }
+
+  /**
+   * @return latency (in us) above which the destination was considered an
+   *         outlier when it was last flagged.
+   */
+  uint64_t latencyTkoThresholdUs() const {
+    return latencyTkoThresholdUs_;
+  }
+
+  /**
+   * Can be called from any proxy thread.
+   * Records the latency of a successful reply for outlier detection.
+   */
+  void recordLatency(uint64_t latencyUs) {
+    latencies_.insertSample(latencyUs);
+  }
+
+  /**
+   * @return true if TkoTrackerMap flagged the destination as a latency
+   *         outlier and no proxy has marked it TKO yet.
+   */
+  bool latencyOutlierPending() const {
+    return latencyOutlierPending_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Can be called from any proxy thread.
+   * Marks the destination soft TKO if it was flagged as a latency outlier.
+   *
+   * @param pdstn  a pointer to the calling proxydestination for tracking
+   *               responsibility.
+   *
+   * @return true if the host was marked TKO by this call.  In this case, the
+   *         calling proxy is responsible for sending probes and calling
+   *         recordSuccess() once a probe is successful.
+   */
+  bool recordLatencyOutlier(ProxyDestination* pdstn);
+
+  /**
+   * @return Was the destination marked TKO for a high error rate?
+   */
+  bool isErrorRateTko() const {
+    return errorRateTko_;
+  }
+
+  /**
+   * Can be called from any proxy thread.
+   * Signal that the error rate seen by `pdstn` went over its pool's
+   * error_rate_tko threshold - marks the host soft TKO right away.
+   *
+   * @param pdstn  a pointer to the calling proxydestination for tracking
+   *               responsibility.
+   *
+   * @return true if the host was marked TKO by this call.  In this case, the
+   *         calling proxy is responsible for sending probes and calling
+   *         recordSuccess() once a probe is successful.
+   */
+  bool recordErrorRateTrip(ProxyDestination* pdstn);
+
+  /**
+   * Can be called from any proxy thread.
+   * Marks the host TKO because it was TKO before a restart (see
+   * TkoTrackerMap::setRestoredTkoState()).
+   *
+   * @param hard   whether to mark it hard or soft TKO.
+   *
+   * @return true if the host was marked TKO by this call.  In this case, the
+   *         calling proxy is responsible for sending probes and calling
+   *         recordSuccess() once a probe is successful.
+   */
+  bool recordRestoredTko(ProxyDestination* pdstn, bool hard);
+
+  /**
+   * @return true if `pdstn` is responsible for the TKO state (i.e. for
+   *         sending probes).
+   */
+  bool isResponsible(ProxyDestination* pdstn) const;
+
   /**
    * Resets all consecutive failures accumulated so far
    * (unmarking any TKO status).
@@ -155,6 +250,15 @@ class TkoTracker {
 
   std::atomic<size_t> consecutiveFailureCount_{0};
 
+  // Latencies of successful replies since the last outlier check.
+  LatencyHistogram latencies_;
+  // Set by TkoTrackerMap, consumed by the proxy that marks the box TKO.
+  std::atomic<bool> latencyOutlierPending_{false};
+  std::atomic<uint64_t> latencyTkoThresholdUs_{0};
+  // Only modified by the responsible proxy.
+  std::atomic<bool> latencyTko_{false};
+  std::atomic<bool> errorRateTko_{false};
+
   /**
    * Decrement the global counter of current soft TKOs
    */
@@ -170,8 +274,9 @@ class TkoTracker {
      other proxies may not modify state */
   bool setSumFailures(uintptr_t value);
 
-  /* Return true if this thread is responsible for the TKO state */
-  bool isResponsible(ProxyDestination* pdstn) const;
+  /* Marks the box soft TKO with pdstn responsible, unless it is TKO
+     already. Returns true on success. */
+  bool markSoftTko(ProxyDestination* pdstn);
 
   /**
    * @param tkoThreshold    Require this many soft failures to mark
@@ -212,6 +317,39 @@ class TkoTrackerMap {
   std::unordered_map<std::string, std::pair<bool, size_t>> getSuspectServers()
       const;
 
+  /**
+   * Makes `pdstn` a member of `pool` for latency outlier detection:
+   * its latency is compared with the latencies of other pool members.
+   */
+  void addToLatencyPool(folly::StringPiece pool, const ProxyDestination& pdstn);
+
+  /**
+   * Compares the latency_tko_percentile latency of every destination
+   * (over the samples recorded since the previous call) with the median of
+   * its pool, and flags destinations slower than
+   * max(latency_tko_min_latency_us, latency_tko_multiplier * median)
+   * as latency outliers. At most latency_tko_max_fraction of each pool
+   * (rounded up) is ejected at a time. Should be called periodically.
+   */
+  void updateLatencyOutliers(const McrouterOptions& opts);
+
+  /**
+   * @return hosts currently TKO. Format: {host:port => "hard" | "soft"}
+   */
+  folly::dynamic getTkoState() const;
+
+  /**
+   * Remembers the hosts of a getTkoState() result (e.g. from before a
+   * restart), to be marked TKO again when their tracker is created.
+   */
+  void setRestoredTkoState(const folly::dynamic& state);
+
+  /**
+   * If `key` was TKO in the restored state, forgets it and returns whether it
+   * was a hard TKO. Only the first caller for a given key gets a value.
+   */
+  folly::Optional<bool> popRestoredTko(folly::StringPiece key);
+
   const TkoCounters& globalTkos() const {
     return globalTkos_;
   }
@@ -219,6 +357,12 @@ class TkoTrackerMap {
  private:
   mutable std::mutex mx_;
   folly::StringKeyedUnorderedMap<std::weak_ptr<TkoTracker>> trackers_;
+  // host key => was hard TKO, see setRestoredTkoState()
+  folly::StringKeyedUnorderedMap<bool> restoredTkos_;
+  // pool name => { host key => tracker }
+  folly::StringKeyedUnorderedMap<
+      folly::StringKeyedUnorderedMap<std::weak_ptr<TkoTracker>>>
+      latencyPools_;
 
   // Total number of boxes marked as TKO.
   TkoCounters globalTkos_;
@@ -7,8 +7,12 @@
  */
 #pragma once
 
+#include <type_traits>
+#include <utility>
+
 #include <folly/Singleton.h>
 #include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/fibers/FiberManager.h>
 #include <folly/synchronization/CallOnce.h>
 
 namespace facebook {
@@ -33,6 +37,33 @@ class AuxiliaryCPUThreadPool {
 using AuxiliaryCPUThreadPoolSingleton =
     folly::Singleton<AuxiliaryCPUThreadPool>;
 
+/**
+ * Runs CPU-heavy func on the AuxiliaryCPUThreadPool and returns its result.
+ *
+ * Must be called from a fiber, which is suspended until func is done and
+ * then resumes on its own proxy thread. Meanwhile the event base keeps
+ * serving other requests, and func is picked up by whichever thread pool
+ * thread is idle first. func runs inline if the thread pool is gone
+ * (shutting down). func must return a value and must not touch state of
+ * the proxy.
+ *
+ * @throws  whatever func throws.
+ */
+template <class F>
+typename std::result_of<F&()>::type runOnAuxiliaryCPUThreadPool(F&& func) {
+  using Result = typename std::result_of<F&()>::type;
+  auto singleton = AuxiliaryCPUThreadPoolSingleton::try_get_fast();
+  if (!singleton) {
+    return func();
+  }
+  auto& threadPool = singleton->getThreadPool();
+  return folly::fibers::await([&](folly::fibers::Promise<Result> promise) {
+    threadPool.add([&func, promise = std::move(promise)]() mutable {
+      promise.setWith(func);
+    });
+  });
+}
+
 } // mcrouter
 } // memcache
 } // facebook
@@ -35,6 +35,11 @@ class Ch3HashFunc {
     return "Ch3";
   }
 
+  /* The result only depends on the key and n, see HashSelector */
+  static constexpr bool memoizable() {
+    return true;
+  }
+
  private:
   size_t n_;
 };
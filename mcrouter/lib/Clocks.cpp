@@ -7,10 +7,81 @@
  */
 #include "Clocks.h"
 
+#include <chrono>
+
+#if defined(__x86_64__)
+#include <cpuid.h>
+#endif
+
 namespace facebook {
 namespace memcache {
 namespace cycles {
 
+namespace {
+
+// Long enough for the error of the two clock reads at each end to be
+// negligible (a few parts per million), short enough to do at startup.
+constexpr std::chrono::microseconds kCalibrationTime{1000};
+
+int64_t steadyNowUs() noexcept {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+bool hasConstantRateCpuCycles() noexcept {
+#if defined(__x86_64__)
+  // Invariant TSC: constant rate in all P-, C- and T-states, in sync across
+  // cores.
+  unsigned int eax, ebx, ecx, edx;
+  if (__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) == 0 ||
+      eax < 0x80000007) {
+    return false;
+  }
+  __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+  return (edx & (1 << 8)) != 0;
+#else
+  // The powerpc timebase and the aarch64 virtual counter tick at a fixed
+  // frequency.
+  return true;
+#endif
+}
+
+struct Calibration {
+  double cyclesPerUs{0.0};
+  double usPerCycle{0.0};
+  uint64_t baseCycles{0};
+  int64_t baseUs{0};
+
+  Calibration() noexcept {
+    if (!hasConstantRateCpuCycles()) {
+      return;
+    }
+    const auto startUs = steadyNowUs();
+    const auto startCycles = getCpuCycles();
+    int64_t endUs;
+    do {
+      endUs = steadyNowUs();
+    } while (endUs - startUs < kCalibrationTime.count());
+    const auto endCycles = getCpuCycles();
+    if (endCycles <= startCycles) {
+      return;
+    }
+    cyclesPerUs = static_cast<double>(endCycles - startCycles) /
+        static_cast<double>(endUs - startUs);
+    usPerCycle = 1.0 / cyclesPerUs;
+    baseCycles = endCycles;
+    baseUs = endUs;
+  }
+};
+
+const Calibration& calibration() noexcept {
+  static const Calibration calibration;
+  return calibration;
+}
+
+} // anonymous namespace
+
 uint64_t getCpuCycles() noexcept {
 #if defined(__x86_64__)
   uint64_t hi;
@@ -31,6 +102,21 @@ uint64_t getCpuCycles() noexcept {
 #endif
 }
 
+double getCpuCyclesPerUs() noexcept {
+  return calibration().cyclesPerUs;
+}
+
+int64_t nowUs() noexcept {
+  const auto& c = calibration();
+  if (c.cyclesPerUs == 0.0) {
+    return steadyNowUs();
+  }
+  // Signed, as cores may disagree by a few cycles right after calibration.
+  const auto elapsedCycles =
+      static_cast<int64_t>(getCpuCycles() - c.baseCycles);
+  return c.baseUs + static_cast<int64_t>(elapsedCycles * c.usPerCycle);
+}
+
 } // cycles
 } // memcache
 } // facebook
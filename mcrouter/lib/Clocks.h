@@ -9,6 +9,8 @@
 
 #include <cstdint>
 
+#include <folly/io/async/EventBase.h>
+
 namespace facebook {
 namespace memcache {
 namespace cycles {
@@ -25,6 +27,52 @@ namespace cycles {
  */
 uint64_t getCpuCycles() noexcept;
 
+/**
+ * Returns how many getCpuCycles() ticks make a microsecond, as measured
+ * against steady_clock the first time any of the functions below is called
+ * (which takes about a millisecond), or 0 if getCpuCycles() doesn't tick at
+ * a constant rate, synchronized across cores, on this machine.
+ * Thread-safe.
+ */
+double getCpuCyclesPerUs() noexcept;
+
+/**
+ * Returns monotonic time in microseconds, on the same epoch as steady_clock
+ * (up to the calibration error), computed from getCpuCycles() without a
+ * system call. Falls back to steady_clock if getCpuCyclesPerUs() is 0.
+ * Thread-safe.
+ */
+int64_t nowUs() noexcept;
+
+/**
+ * nowUs(), read at most once per iteration of an event loop: every call made
+ * during the same loop iteration returns the same value. For timestamps that
+ * can be off by the duration of a loop iteration, e.g. deadlines and TKO
+ * windows, not for latencies.
+ *
+ * Must only be used from the thread of the event base.
+ */
+class LoopCachedClock : private folly::EventBase::LoopCallback {
+ public:
+  explicit LoopCachedClock(folly::EventBase& evb) : evb_(evb) {}
+
+  int64_t nowUs() noexcept {
+    if (!isLoopCallbackScheduled()) {
+      nowUs_ = cycles::nowUs();
+      // Runs at the end of this iteration, making the next call read the
+      // clock again.
+      evb_.runInLoop(this);
+    }
+    return nowUs_;
+  }
+
+ private:
+  folly::EventBase& evb_;
+  int64_t nowUs_{0};
+
+  void runLoopCallback() noexcept override final {}
+};
+
 } // cycles
 } // memcache
 } // facebook
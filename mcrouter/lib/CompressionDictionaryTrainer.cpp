@@ -0,0 +1,95 @@
+/*
+ *  Copyright (c) 2016-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include "CompressionDictionaryTrainer.h"
+
+#include <algorithm>
+
+#include <folly/Format.h>
+#include <folly/io/IOBuf.h>
+#include <glog/logging.h>
+
+#if FOLLY_HAVE_LIBZSTD && !defined(DISABLE_COMPRESSION)
+#include <zdict.h>
+#endif
+
+namespace facebook {
+namespace memcache {
+
+namespace {
+
+// Too few samples make zstd fail or produce a useless dictionary.
+constexpr size_t kMinSamples = 100;
+// Values bigger than this are mostly compressible without a dictionary.
+constexpr size_t kMaxSampleSize = 16 * 1024;
+
+} // anonymous
+
+CompressionDictionaryTrainer::CompressionDictionaryTrainer(
+    double sampleRate,
+    size_t maxSampleBytes,
+    size_t dictionarySize)
+    : sampleRate_(sampleRate),
+      maxSampleBytes_(maxSampleBytes),
+      dictionarySize_(dictionarySize) {}
+
+void CompressionDictionaryTrainer::addSample(
+    folly::StringPiece key,
+    const folly::IOBuf& value) {
+  const auto size = value.computeChainDataLength();
+  if (size == 0 || size > kMaxSampleSize) {
+    return;
+  }
+  auto samples = samples_.wlock();
+  auto& keySamples = (*samples)[key.str()];
+  if (keySamples.data.size() + size > maxSampleBytes_) {
+    return;
+  }
+  for (const auto& buf : value) {
+    keySamples.data.append(
+        reinterpret_cast<const char*>(buf.data()), buf.size());
+  }
+  keySamples.sizes.push_back(size);
+}
+
+std::vector<std::pair<std::string, std::string>>
+CompressionDictionaryTrainer::train() {
+  std::unordered_map<std::string, Samples> samples;
+  samples_.wlock()->swap(samples);
+
+  std::vector<std::pair<std::string, std::string>> dictionaries;
+#if FOLLY_HAVE_LIBZSTD && !defined(DISABLE_COMPRESSION)
+  for (const auto& it : samples) {
+    const auto& keySamples = it.second;
+    if (keySamples.sizes.size() < kMinSamples) {
+      continue;
+    }
+    std::string dictionary(dictionarySize_, '\0');
+    const size_t dictionaryLength = ZDICT_trainFromBuffer(
+        &dictionary[0],
+        dictionary.size(),
+        keySamples.data.data(),
+        keySamples.sizes.data(),
+        static_cast<unsigned>(keySamples.sizes.size()));
+    if (ZDICT_isError(dictionaryLength)) {
+      LOG(WARNING) << folly::sformat(
+          "Failed to train a compression dictionary for {} on {} samples: {}",
+          it.first,
+          keySamples.sizes.size(),
+          ZDICT_getErrorName(dictionaryLength));
+      continue;
+    }
+    dictionary.resize(dictionaryLength);
+    dictionaries.emplace_back(it.first, std::move(dictionary));
+  }
+  std::sort(dictionaries.begin(), dictionaries.end());
+#endif
+  return dictionaries;
+}
+
+} // memcache
+} // facebook
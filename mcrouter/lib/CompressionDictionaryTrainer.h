@@ -0,0 +1,82 @@
+/*
+ *  Copyright (c) 2016-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <folly/Random.h>
+#include <folly/Range.h>
+#include <folly/Synchronized.h>
+
+namespace folly {
+class IOBuf;
+} // folly
+
+namespace facebook {
+namespace memcache {
+
+/**
+ * Samples values (grouped by an arbitrary key, e.g. the pool name) and trains
+ * zstd dictionaries on them.
+ *
+ * Thread-safe.
+ */
+class CompressionDictionaryTrainer {
+ public:
+  /**
+   * @param sampleRate           Fraction of values to sample.
+   * @param maxSampleBytes       Samples kept per key between two trainings.
+   * @param dictionarySize       Maximum size of the trained dictionaries.
+   */
+  CompressionDictionaryTrainer(
+      double sampleRate,
+      size_t maxSampleBytes,
+      size_t dictionarySize);
+
+  /**
+   * @return true if the next value should be passed to addSample().
+   */
+  bool shouldSample() const {
+    return folly::Random::randDouble01() < sampleRate_;
+  }
+
+  /**
+   * Keeps `value` as a sample for `key`, unless `key` already has
+   * maxSampleBytes of samples or `value` is too big to be useful.
+   */
+  void addSample(folly::StringPiece key, const folly::IOBuf& value);
+
+  /**
+   * Trains a dictionary for every key with enough samples, and drops all
+   * samples.
+   *
+   * @return  (key, dictionary) pairs, sorted by key. Always empty if zstd
+   *          is not available.
+   */
+  std::vector<std::pair<std::string, std::string>> train();
+
+ private:
+  struct Samples {
+    // Samples back to back, as zstd wants them.
+    std::string data;
+    std::vector<size_t> sizes;
+  };
+
+  const double sampleRate_;
+  const size_t maxSampleBytes_;
+  const size_t dictionarySize_;
+
+  folly::Synchronized<std::unordered_map<std::string, Samples>> samples_;
+};
+
+} // memcache
+} // facebook
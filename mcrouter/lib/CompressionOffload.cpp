@@ -0,0 +1,130 @@
+/*
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include "CompressionOffload.h"
+
+#include <chrono>
+#include <stdexcept>
+
+#include <folly/Executor.h>
+#include <folly/Format.h>
+#include <folly/fibers/FiberManager.h>
+#include <folly/io/IOBuf.h>
+#include <folly/io/async/EventBase.h>
+
+#include "mcrouter/lib/AuxiliaryCPUThreadPool.h"
+#include "mcrouter/lib/Compression.h"
+#include "mcrouter/lib/CompressionCodecManager.h"
+
+namespace facebook {
+namespace memcache {
+
+namespace {
+
+int64_t nowUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Must be called from the thread that uses the codec.
+CompressionCodec& getCodec(
+    const CompressionCodecManager& codecManager,
+    uint32_t codecId) {
+  const auto* codecMap = codecManager.getCodecMap();
+  auto* codec = codecMap ? codecMap->get(codecId) : nullptr;
+  if (codec == nullptr) {
+    throw std::runtime_error(
+        folly::sformat("Compression codec id {} not found", codecId));
+  }
+  return *codec;
+}
+
+size_t totalLength(const struct iovec* iov, size_t iovcnt) {
+  size_t len = 0;
+  for (size_t i = 0; i < iovcnt; ++i) {
+    len += iov[i].iov_len;
+  }
+  return len;
+}
+
+} // anonymous
+
+folly::Executor* CompressionOffload::getExecutor() const {
+  if (executor_) {
+    return executor_;
+  }
+  auto singleton = mcrouter::AuxiliaryCPUThreadPoolSingleton::try_get_fast();
+  return singleton ? &singleton->getThreadPool() : nullptr;
+}
+
+void CompressionOffload::recordOffload(size_t bytes, int64_t enqueuedUs)
+    const {
+  numOffloaded_.fetch_add(1, std::memory_order_relaxed);
+  bytesOffloaded_.fetch_add(bytes, std::memory_order_relaxed);
+  queueDelayUs_.fetch_add(nowUs() - enqueuedUs, std::memory_order_relaxed);
+}
+
+std::unique_ptr<folly::IOBuf> CompressionOffload::compress(
+    uint32_t codecId,
+    const struct iovec* iov,
+    size_t iovcnt) const {
+  auto* executor = getExecutor();
+  if (!executor) {
+    // Thread pool is gone (shutting down), compress inline.
+    return getCodec(codecManager_, codecId).compress(iov, iovcnt);
+  }
+  const auto enqueuedUs = nowUs();
+  return folly::fibers::await(
+      [&](folly::fibers::Promise<std::unique_ptr<folly::IOBuf>> promise) {
+        executor->add([&, promise = std::move(promise)]() mutable {
+          recordOffload(totalLength(iov, iovcnt), enqueuedUs);
+          promise.setWith([&] {
+            return getCodec(codecManager_, codecId).compress(iov, iovcnt);
+          });
+        });
+      });
+}
+
+void CompressionOffload::uncompress(
+    uint32_t codecId,
+    std::unique_ptr<folly::IOBuf> data,
+    size_t uncompressedLength,
+    folly::EventBase& evb,
+    folly::Function<void(folly::Try<std::unique_ptr<folly::IOBuf>>)>
+        callback) const {
+  auto work = [this,
+               codecId,
+               data = std::move(data),
+               uncompressedLength,
+               enqueuedUs = nowUs()]() {
+    recordOffload(uncompressedLength, enqueuedUs);
+    return folly::makeTryWith([&] {
+      return getCodec(codecManager_, codecId)
+          .uncompress(*data, uncompressedLength);
+    });
+  };
+
+  auto* executor = getExecutor();
+  if (!executor) {
+    callback(work());
+    return;
+  }
+  executor->add([
+    &evb,
+    work = std::move(work),
+    callback = std::move(callback)
+  ]() mutable {
+    evb.runInEventBaseThread([
+      result = work(),
+      callback = std::move(callback)
+    ]() mutable { callback(std::move(result)); });
+  });
+}
+
+} // memcache
+} // facebook
@@ -0,0 +1,128 @@
+/*
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <sys/uio.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include <folly/Function.h>
+#include <folly/Try.h>
+
+namespace folly {
+class EventBase;
+class Executor;
+class IOBuf;
+} // folly
+
+namespace facebook {
+namespace memcache {
+
+class CompressionCodecManager;
+
+/**
+ * Runs compression and decompression of big payloads on the
+ * AuxiliaryCPUThreadPool, so that they don't stall the event base thread
+ * (and every other request on it).
+ *
+ * Codecs are not thread-safe: the work is done by the codec with the same id
+ * from the thread pool thread's own CompressionCodecMap.
+ *
+ * Thread-safe.
+ */
+class CompressionOffload {
+ public:
+  /**
+   * @param codecManager  Must outlive this object.
+   * @param threshold     Uncompressed size from which work is offloaded.
+   * @param executor      Runs the work instead of the AuxiliaryCPUThreadPool
+   *                      if set. Must outlive this object.
+   */
+  CompressionOffload(
+      const CompressionCodecManager& codecManager,
+      size_t threshold,
+      folly::Executor* executor = nullptr)
+      : codecManager_(codecManager),
+        threshold_(threshold),
+        executor_(executor) {}
+
+  bool shouldOffload(size_t uncompressedSize) const {
+    return uncompressedSize >= threshold_;
+  }
+
+  size_t threshold() const {
+    return threshold_;
+  }
+
+  /**
+   * Compresses `iov` with codec `codecId` on the thread pool. Must be called
+   * from a fiber, which is suspended until the data is compressed.
+   * `iov` must stay valid until then.
+   *
+   * @throws if the codec is not found or compression fails.
+   */
+  std::unique_ptr<folly::IOBuf>
+  compress(uint32_t codecId, const struct iovec* iov, size_t iovcnt) const;
+
+  /**
+   * Uncompresses `data` with codec `codecId` on the thread pool, then calls
+   * `callback` with the result (or the error) on `evb`'s thread.
+   */
+  void uncompress(
+      uint32_t codecId,
+      std::unique_ptr<folly::IOBuf> data,
+      size_t uncompressedLength,
+      folly::EventBase& evb,
+      folly::Function<void(folly::Try<std::unique_ptr<folly::IOBuf>>)>
+          callback) const;
+
+  /**
+   * @return number of compressions and decompressions offloaded.
+   */
+  uint64_t numOffloaded() const {
+    return numOffloaded_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @return total uncompressed size of the offloaded work.
+   */
+  uint64_t bytesOffloaded() const {
+    return bytesOffloaded_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @return total time the offloaded work waited in the thread pool queue,
+   *         in microseconds.
+   */
+  uint64_t queueDelayUs() const {
+    return queueDelayUs_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  const CompressionCodecManager& codecManager_;
+  const size_t threshold_;
+  folly::Executor* const executor_;
+
+  // Updated by the const methods above, which clients use through a const
+  // pointer (ConnectionOptions).
+  mutable std::atomic<uint64_t> numOffloaded_{0};
+  mutable std::atomic<uint64_t> bytesOffloaded_{0};
+  mutable std::atomic<uint64_t> queueDelayUs_{0};
+
+  /**
+   * @return executor to offload to, nullptr if the thread pool is gone
+   *         (shutting down).
+   */
+  folly::Executor* getExecutor() const;
+
+  void recordOffload(size_t bytes, int64_t enqueuedUs) const;
+};
+
+} // memcache
+} // facebook
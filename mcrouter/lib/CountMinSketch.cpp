@@ -0,0 +1,84 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include "CountMinSketch.h"
+
+#include <algorithm>
+
+#include <folly/hash/SpookyHashV2.h>
+#include <folly/lang/Bits.h>
+
+namespace facebook {
+namespace memcache {
+
+constexpr size_t CountMinSketch::kDepth;
+
+CountMinSketch::CountMinSketch(
+    size_t width,
+    uint32_t maxCount,
+    size_t resetPeriod)
+    : counters_(kDepth * folly::nextPowTwo(std::max<size_t>(width, 16))),
+      mask_(counters_.size() / kDepth - 1),
+      maxCount_(maxCount),
+      resetPeriod_(resetPeriod) {}
+
+void CountMinSketch::indices(folly::StringPiece key, size_t (&idx)[kDepth])
+    const {
+  uint64_t h1 = 0;
+  uint64_t h2 = 0;
+  folly::hash::SpookyHashV2::Hash128(key.data(), key.size(), &h1, &h2);
+  // Double hashing: derive all row indices from two independent hashes.
+  h2 |= 1;
+  for (size_t i = 0; i < kDepth; ++i) {
+    idx[i] = i * (mask_ + 1) + ((h1 + i * h2) & mask_);
+  }
+}
+
+uint32_t CountMinSketch::increment(folly::StringPiece key) {
+  size_t idx[kDepth];
+  indices(key, idx);
+
+  uint32_t minCount = maxCount_;
+  for (auto i : idx) {
+    minCount = std::min(minCount, counters_[i]);
+  }
+  // Conservative update: only bump the counters that are at the minimum.
+  if (minCount < maxCount_) {
+    for (auto i : idx) {
+      if (counters_[i] == minCount) {
+        ++counters_[i];
+      }
+    }
+    ++minCount;
+  }
+
+  if (resetPeriod_ && ++increments_ >= resetPeriod_) {
+    halve();
+  }
+  return minCount;
+}
+
+uint32_t CountMinSketch::estimate(folly::StringPiece key) const {
+  size_t idx[kDepth];
+  indices(key, idx);
+
+  uint32_t minCount = maxCount_;
+  for (auto i : idx) {
+    minCount = std::min(minCount, counters_[i]);
+  }
+  return minCount;
+}
+
+void CountMinSketch::halve() {
+  for (auto& counter : counters_) {
+    counter >>= 1;
+  }
+  increments_ = 0;
+}
+
+} // memcache
+} // facebook
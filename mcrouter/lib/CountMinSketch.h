@@ -0,0 +1,74 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <folly/Range.h>
+
+namespace facebook {
+namespace memcache {
+
+/**
+ * Approximate per-key access counter (count-min sketch with conservative
+ * update). Counters saturate at maxCount. To track recent rather than
+ * all-time popularity, all counters can be halved periodically, either
+ * manually with halve() or automatically every resetPeriod increments
+ * (as in TinyLFU).
+ */
+class CountMinSketch {
+ public:
+  /**
+   * @param width        number of counters per row, rounded up to a power
+   *                     of two.
+   * @param maxCount     value at which counters saturate.
+   * @param resetPeriod  number of increments after which all counters are
+   *                     halved. 0 means never halve automatically.
+   */
+  CountMinSketch(size_t width, uint32_t maxCount, size_t resetPeriod = 0);
+
+  /**
+   * Counts one access to key.
+   *
+   * @return  estimated number of accesses to key, including this one.
+   */
+  uint32_t increment(folly::StringPiece key);
+
+  /**
+   * @return  estimated number of accesses to key.
+   */
+  uint32_t estimate(folly::StringPiece key) const;
+
+  /**
+   * Halves all counters.
+   */
+  void halve();
+
+  /**
+   * @return  number of counters per row.
+   */
+  size_t width() const {
+    return mask_ + 1;
+  }
+
+ private:
+  static constexpr size_t kDepth = 4;
+
+  std::vector<uint32_t> counters_;
+  size_t mask_;
+  uint32_t maxCount_;
+  size_t resetPeriod_;
+  size_t increments_{0};
+
+  void indices(folly::StringPiece key, size_t (&idx)[kDepth]) const;
+};
+
+} // memcache
+} // facebook
@@ -9,7 +9,7 @@
 
 #include <folly/Range.h>
 
-#include "mcrouter/lib/fbi/hash.h"
+#include "mcrouter/lib/Crc32HashHelper.h"
 
 namespace folly {
 struct dynamic;
@@ -24,7 +24,7 @@ class Crc32HashFunc {
   explicit Crc32HashFunc(size_t n) : n_(n) {}
 
   size_t operator()(folly::StringPiece hashable) const {
-    auto res = crc32_hash(hashable.data(), hashable.size());
+    auto res = crc32Hash(hashable.data(), hashable.size());
     return (res & 0x7fffffff) % n_;
   }
 
@@ -32,6 +32,11 @@ class Crc32HashFunc {
     return "Crc32";
   }
 
+  /* The result only depends on the key and n, see HashSelector */
+  static constexpr bool memoizable() {
+    return true;
+  }
+
  private:
   size_t n_;
 };
@@ -0,0 +1,173 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include "Crc32HashHelper.h"
+
+#include <cstring>
+
+#include <folly/CpuId.h>
+
+#include "mcrouter/lib/fbi/hash.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define MCROUTER_CRC32_PCLMUL 1
+#elif defined(__aarch64__) && defined(__GNUC__) && defined(__linux__)
+#include <arm_acle.h>
+#include <sys/auxv.h>
+#ifndef HWCAP_CRC32
+#define HWCAP_CRC32 (1 << 7)
+#endif
+#define MCROUTER_CRC32_ARMV8 1
+#endif
+
+namespace facebook {
+namespace memcache {
+
+namespace {
+
+#ifdef MCROUTER_CRC32_PCLMUL
+
+// Folding constants for the bit-reflected CRC32 polynomial 0x04C11DB7, see
+// "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction"
+// (Intel, 2009). k1 = x^(4*128+32) mod P, k2 = x^(4*128-32) mod P,
+// k3 = x^(128+32) mod P, k4 = x^(128-32) mod P, k5 = x^64 mod P,
+// all bit-reflected and shifted left by 1.
+constexpr uint64_t kK1 = 0x154442bd4;
+constexpr uint64_t kK2 = 0x1c6e41596;
+constexpr uint64_t kK3 = 0x1751997d0;
+constexpr uint64_t kK4 = 0x0ccaa009e;
+constexpr uint64_t kK5 = 0x163cd6124;
+// Barrett reduction: P' and mu = x^64 / P, bit-reflected.
+constexpr uint64_t kPoly = 0x1db710641;
+constexpr uint64_t kMu = 0x1f7011641;
+
+__attribute__((target("sse4.1,pclmul"))) inline __m128i fold(
+    __m128i x,
+    __m128i k,
+    __m128i next) {
+  const __m128i lo = _mm_clmulepi64_si128(x, k, 0x00);
+  const __m128i hi = _mm_clmulepi64_si128(x, k, 0x11);
+  return _mm_xor_si128(_mm_xor_si128(lo, hi), next);
+}
+
+__attribute__((target("sse4.1,pclmul"))) uint32_t
+crc32UpdatePclmul(uint32_t crc, const char* key, size_t len) {
+  if (len < 16) {
+    return crc32_update(crc, key, len);
+  }
+  auto load = [](const char* p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+  };
+
+  __m128i x = _mm_xor_si128(load(key), _mm_cvtsi32_si128(crc));
+  key += 16;
+  len -= 16;
+
+  if (len >= 48) {
+    // Four independent lanes of 16 bytes, folded 64 bytes at a time.
+    __m128i x1 = x;
+    __m128i x2 = load(key);
+    __m128i x3 = load(key + 16);
+    __m128i x4 = load(key + 32);
+    key += 48;
+    len -= 48;
+    const __m128i k12 = _mm_set_epi64x(kK2, kK1);
+    while (len >= 64) {
+      x1 = fold(x1, k12, load(key));
+      x2 = fold(x2, k12, load(key + 16));
+      x3 = fold(x3, k12, load(key + 32));
+      x4 = fold(x4, k12, load(key + 48));
+      key += 64;
+      len -= 64;
+    }
+    const __m128i k34 = _mm_set_epi64x(kK4, kK3);
+    x = fold(x1, k34, x2);
+    x = fold(x, k34, x3);
+    x = fold(x, k34, x4);
+  }
+
+  const __m128i k34 = _mm_set_epi64x(kK4, kK3);
+  while (len >= 16) {
+    x = fold(x, k34, load(key));
+    key += 16;
+    len -= 16;
+  }
+
+  // 128 -> 64 bits.
+  const __m128i mask32 = _mm_set_epi32(0, 0, 0, ~0);
+  x = _mm_xor_si128(
+      _mm_clmulepi64_si128(x, k34, 0x10), _mm_srli_si128(x, 8));
+  // 64 -> 32 bits.
+  x = _mm_xor_si128(
+      _mm_clmulepi64_si128(
+          _mm_and_si128(x, mask32), _mm_set_epi64x(0, kK5), 0x00),
+      _mm_srli_si128(x, 4));
+  // Barrett reduction.
+  const __m128i poly = _mm_set_epi64x(kMu, kPoly);
+  __m128i t = _mm_clmulepi64_si128(_mm_and_si128(x, mask32), poly, 0x10);
+  t = _mm_clmulepi64_si128(_mm_and_si128(t, mask32), poly, 0x00);
+  crc = _mm_extract_epi32(_mm_xor_si128(x, t), 1);
+
+  return crc32_update(crc, key, len);
+}
+
+#endif // MCROUTER_CRC32_PCLMUL
+
+#ifdef MCROUTER_CRC32_ARMV8
+
+__attribute__((target("+crc"))) uint32_t
+crc32UpdateArmv8(uint32_t crc, const char* key, size_t len) {
+  for (; len >= 8; key += 8, len -= 8) {
+    uint64_t word;
+    memcpy(&word, key, sizeof(word));
+    crc = __crc32d(crc, word);
+  }
+  for (; len > 0; ++key, --len) {
+    crc = __crc32b(crc, *key);
+  }
+  return crc;
+}
+
+#endif // MCROUTER_CRC32_ARMV8
+
+} // anonymous namespace
+
+Crc32Kernel bestCrc32Kernel() {
+  static const Crc32Kernel kBest = []() {
+#if defined(MCROUTER_CRC32_PCLMUL)
+    folly::CpuId cpuId;
+    if (cpuId.sse41() && cpuId.pclmuldq()) {
+      return Crc32Kernel::PCLMUL;
+    }
+#elif defined(MCROUTER_CRC32_ARMV8)
+    if (getauxval(AT_HWCAP) & HWCAP_CRC32) {
+      return Crc32Kernel::ARMV8;
+    }
+#endif
+    return Crc32Kernel::SCALAR;
+  }();
+  return kBest;
+}
+
+uint32_t crc32Hash(const char* key, size_t len, Crc32Kernel kernel) {
+  switch (kernel) {
+#ifdef MCROUTER_CRC32_PCLMUL
+    case Crc32Kernel::PCLMUL:
+      return ~crc32UpdatePclmul(~0U, key, len);
+#endif
+#ifdef MCROUTER_CRC32_ARMV8
+    case Crc32Kernel::ARMV8:
+      return ~crc32UpdateArmv8(~0U, key, len);
+#endif
+    default:
+      return crc32_hash(key, len);
+  }
+}
+
+} // namespace memcache
+} // namespace facebook
@@ -0,0 +1,43 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <inttypes.h>
+#include <stddef.h>
+
+namespace facebook {
+namespace memcache {
+
+/**
+ * Implementations of crc32Hash() below. Only the ones supported by the CPU
+ * may be used. All of them return the same results as crc32_hash().
+ */
+enum class Crc32Kernel {
+  SCALAR,
+  // x86-64 carry-less multiplication. The SSE4.2 crc32 instruction computes
+  // CRC-32C, a different polynomial, so it can't be used here.
+  PCLMUL,
+  // ARMv8 CRC32 extension.
+  ARMV8,
+};
+
+/**
+ * @return  the fastest kernel supported by this CPU.
+ */
+Crc32Kernel bestCrc32Kernel();
+
+/**
+ * Same as crc32_hash(key, len) from mcrouter/lib/fbi/hash.h.
+ */
+uint32_t crc32Hash(
+    const char* key,
+    size_t len,
+    Crc32Kernel kernel = bestCrc32Kernel());
+
+} // namespace memcache
+} // namespace facebook
@@ -0,0 +1,60 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace facebook {
+namespace memcache {
+
+/**
+ * wyrand: a 64 bit generator with one multiplication per number and 8 bytes
+ * of state. Not cryptographically secure, meant for picking destinations on
+ * the request path. Satisfies UniformRandomBitGenerator.
+ *
+ * Not thread-safe: every route (and so every proxy) owns its own.
+ */
+class WyRand {
+ public:
+  using result_type = uint64_t;
+
+  explicit WyRand(uint64_t seed) : state_(seed) {}
+
+  static constexpr result_type min() {
+    return 0;
+  }
+
+  static constexpr result_type max() {
+    return std::numeric_limits<result_type>::max();
+  }
+
+  result_type operator()() {
+    state_ += 0xa0761d6478bd642fULL;
+    const auto product = static_cast<unsigned __int128>(state_) *
+        (state_ ^ 0xe7037ed1a0b428dbULL);
+    return static_cast<uint64_t>(product >> 64) ^
+        static_cast<uint64_t>(product);
+  }
+
+ private:
+  uint64_t state_;
+};
+
+/**
+ * Maps a random 64 bit number to [0, n) with a multiplication instead of a
+ * division (Lemire's multiply-shift). The bias is at most n / 2^64.
+ */
+inline size_t randomIndex(uint64_t random, size_t n) {
+  return static_cast<size_t>(
+      (static_cast<unsigned __int128>(random) * n) >> 64);
+}
+
+} // memcache
+} // facebook
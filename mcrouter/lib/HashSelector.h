@@ -7,22 +7,47 @@
  */
 #pragma once
 
+#include <type_traits>
 #include <utility>
 
 #include <folly/Conv.h>
 #include <folly/Range.h>
 #include <folly/fibers/FiberManager.h>
+#include <folly/hash/Hash.h>
+#include <folly/hash/SpookyHashV2.h>
 
 #include "mcrouter/lib/HashUtil.h"
 
 namespace facebook {
 namespace memcache {
 
+namespace detail {
+
+template <class HashFunc, class = void>
+struct IsMemoizableHashFunc : std::false_type {};
+
+template <class HashFunc>
+struct IsMemoizableHashFunc<
+    HashFunc,
+    typename std::enable_if<HashFunc::memoizable()>::type> : std::true_type {};
+
+} // detail
+
+/**
+ * Picks a destination by hashing the routing key.
+ *
+ * Hash functions whose result only depends on the key and the number of
+ * destinations declare `static constexpr bool memoizable()`. Their results
+ * are memoized on the request (see carbon::Keys::memoizedRoutingKeyHash),
+ * so selectors with the same function, salt and size hash the key once.
+ */
 template <class HashFunc>
 class HashSelector {
  public:
   HashSelector(std::string salt, HashFunc hashFunc)
-      : salt_(std::move(salt)), hashFunc_(std::move(hashFunc)) {}
+      : salt_(std::move(salt)),
+        hashFunc_(std::move(hashFunc)),
+        typeHash_(hashType(type())) {}
 
   std::string type() const {
     return folly::to<std::string>(
@@ -31,6 +56,38 @@ class HashSelector {
 
   template <class Request>
   size_t select(const Request& req, size_t size) const {
+    return selectImpl(req, size, detail::IsMemoizableHashFunc<HashFunc>());
+  }
+
+ private:
+  const std::string salt_;
+  const HashFunc hashFunc_;
+  // Identifies the hash function and salt, see memoizedRoutingKeyHash().
+  const uint64_t typeHash_;
+
+  static uint64_t hashType(folly::StringPiece type) {
+    return folly::hash::SpookyHashV2::Hash64(type.data(), type.size(), 0);
+  }
+
+  template <class Request>
+  size_t selectImpl(const Request& req, size_t size, std::true_type) const {
+    auto hashId = folly::hash::hash_128_to_64(typeHash_, size);
+    if (UNLIKELY(hashId == 0)) {
+      hashId = 1;
+    }
+    return req.key().memoizedRoutingKeyHash(
+        hashId, [this, &req, size](folly::StringPiece) {
+          return selectInMainContext(req, size);
+        });
+  }
+
+  template <class Request>
+  size_t selectImpl(const Request& req, size_t size, std::false_type) const {
+    return selectInMainContext(req, size);
+  }
+
+  template <class Request>
+  size_t selectInMainContext(const Request& req, size_t size) const {
     /* Hash functions can be stack-intensive,
        so jump back to the main context */
     return folly::fibers::runInMainContext([this, &req, size]() {
@@ -40,10 +97,6 @@ class HashSelector {
     });
   }
 
- private:
-  const std::string salt_;
-  const HashFunc hashFunc_;
-
   template <class Request>
   size_t selectInternal(const Request& req, size_t size) const {
     size_t n = 0;
@@ -92,5 +92,63 @@ coalesceIovecs(const struct iovec* iov, size_t iovcnt, size_t destCapacity) {
   }
   return coalesceSlow(iov, iovcnt, destCapacity);
 }
+
+namespace {
+const folly::IOBuf* findOwningBuf(
+    const folly::IOBuf* owner,
+    const struct iovec& iov) {
+  if (owner == nullptr) {
+    return nullptr;
+  }
+  auto begin = reinterpret_cast<const uint8_t*>(iov.iov_base);
+  auto cur = owner;
+  do {
+    if (cur->isManagedOne() && begin >= cur->data() &&
+        begin + iov.iov_len <= cur->tail()) {
+      return cur;
+    }
+    cur = cur->next();
+  } while (cur != owner);
+  return nullptr;
+}
+} // anonymous namespace
+
+std::unique_ptr<folly::IOBuf> iovecsToSharedIOBuf(
+    const struct iovec* iov,
+    size_t iovcnt,
+    const folly::IOBuf* owner) {
+  std::unique_ptr<folly::IOBuf> head;
+  auto appendBuf = [&head](std::unique_ptr<folly::IOBuf> buf) {
+    if (head) {
+      head->prependChain(std::move(buf));
+    } else {
+      head = std::move(buf);
+    }
+  };
+
+  size_t i = 0;
+  while (i < iovcnt) {
+    if (auto buf = findOwningBuf(owner, iov[i])) {
+      auto shared = buf->cloneOne();
+      shared->trimStart(
+          reinterpret_cast<const uint8_t*>(iov[i].iov_base) - shared->data());
+      shared->trimEnd(shared->length() - iov[i].iov_len);
+      appendBuf(std::move(shared));
+      ++i;
+      continue;
+    }
+    // Copy a run of consecutive iovecs that we can't share.
+    size_t j = i;
+    size_t size = 0;
+    while (j < iovcnt && !findOwningBuf(owner, iov[j])) {
+      size += iov[j].iov_len;
+      ++j;
+    }
+    appendBuf(std::make_unique<folly::IOBuf>(
+        coalesceSlow(iov + i, j - i, size)));
+    i = j;
+  }
+  return head ? std::move(head) : std::make_unique<folly::IOBuf>();
+}
 }
 } // facebook::memcache
@@ -36,23 +36,6 @@ bool hasSameMemoryRegion(const folly::IOBuf& a, const folly::IOBuf& b);
 
 void copyInto(char* raw, const folly::IOBuf& buf);
 
-template <typename InputIterator>
-folly::IOBuf concatAll(InputIterator begin, InputIterator end) {
-  folly::IOBuf out;
-  if (begin == end) {
-    return out;
-  }
-
-  (*begin)->cloneInto(out);
-  ++begin;
-  while (begin != end) {
-    out.prependChain(std::move((*begin)->clone()));
-    ++begin;
-  }
-
-  return out;
-}
-
 /**
  * Given a coalesced IOBuf and a range of bytes [begin, begin + size) inside it,
  * clones into out IOBuf so that cloned.data() == begin and
@@ -108,5 +91,16 @@ copyAsString(const folly::IOBuf& source, const uint8_t* begin, size_t size) {
  */
 folly::IOBuf
 coalesceIovecs(const struct iovec* iov, size_t iovcnt, size_t destCapacity);
+
+/**
+ * Builds an IOBuf chain with the data referenced by iovecs, suitable for
+ * writes that may outlive the iovecs (e.g. MSG_ZEROCOPY).
+ * Iovecs that point inside one of the (managed) buffers of `owner` share that
+ * buffer, all other data is copied. `owner` may be nullptr.
+ */
+std::unique_ptr<folly::IOBuf> iovecsToSharedIOBuf(
+    const struct iovec* iov,
+    size_t iovcnt,
+    const folly::IOBuf* owner);
 }
 } // facebook::memcache
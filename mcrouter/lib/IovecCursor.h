@@ -68,6 +68,24 @@ class IovecCursor {
    */
   void readInto(uint8_t* dest, size_t size);
 
+  /**
+   * Number of bytes that can be read from data() without crossing into the
+   * next iovec.
+   */
+  inline size_t contiguousLength() const {
+    return curBufLen_;
+  }
+
+  /**
+   * Pointer to the current position of this cursor.
+   * NOTE: Only valid if contiguousLength() > 0.
+   */
+  inline const uint8_t* data() const {
+    assert(curBufLen_ > 0);
+    return reinterpret_cast<const uint8_t*>(iov_[iovIndex_].iov_base) +
+        curBufPos_;
+  }
+
   /**
    * Get the total length of this cursor (i.e. the sum of the length of
    * all iovecs).
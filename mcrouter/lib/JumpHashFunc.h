@@ -0,0 +1,68 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <stdexcept>
+
+#include <folly/Range.h>
+#include <folly/hash/SpookyHashV2.h>
+
+namespace facebook {
+namespace memcache {
+
+/**
+ * Jump consistent hash (Lamping, Veach: "A Fast, Minimal Memory, Consistent
+ * Hash Algorithm"). Needs no state besides the pool size, and moves only
+ * 1/n of the keys when a server is added to (or removed from) the end
+ * of the pool.
+ */
+inline size_t jumpConsistentHash(uint64_t key, size_t n) {
+  int64_t b = -1;
+  int64_t j = 0;
+  while (j < static_cast<int64_t>(n)) {
+    b = j;
+    key = key * 2862933555777941757ULL + 1;
+    j = static_cast<int64_t>(
+        (b + 1) * (static_cast<double>(1LL << 31) /
+                   static_cast<double>((key >> 33) + 1)));
+  }
+  return b;
+}
+
+/* Jump consistent hashing function object */
+class JumpHashFunc {
+ public:
+  explicit JumpHashFunc(size_t n) : n_(n) {
+    if (!n_) {
+      throw std::logic_error("Pool size out of range for Jump");
+    }
+  }
+
+  size_t operator()(folly::StringPiece hashable) const {
+    constexpr uint64_t kHashSeed = 0xface2018;
+    return jumpConsistentHash(
+        folly::hash::SpookyHashV2::Hash64(
+            hashable.data(), hashable.size(), kHashSeed),
+        n_);
+  }
+
+  static const char* type() {
+    return "Jump";
+  }
+
+  /* The result only depends on the key and n, see HashSelector */
+  static constexpr bool memoizable() {
+    return true;
+  }
+
+ private:
+  size_t n_;
+};
+
+} // namespace memcache
+} // namespace facebook
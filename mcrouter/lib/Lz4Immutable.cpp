@@ -26,6 +26,8 @@ constexpr uint64_t kPrime5Bytes = 889523592379ULL;
 constexpr size_t kMinMatch = 4;
 // Size of the copies.
 constexpr size_t kCopyLength = 8;
+// Size of the copies when the buffers have enough slack (one vector move).
+constexpr size_t kWildCopyLength = 16;
 // Size of the last literals.
 constexpr size_t kLastLiterals = 5;
 // We will look for matches until there is just this number of bytes remaining.
@@ -146,6 +148,35 @@ void wildCopy(uint8_t* dest, IovecCursor& cursor, size_t count) {
   } while (dest < destEnd);
 }
 
+/**
+ * Copies "count" bytes, kWildCopyLength at a time (the fixed size memcpy
+ * compiles to a single vector load/store).
+ *
+ * Note: may read and write up to kWildCopyLength - 1 bytes past "count",
+ * callers have to make sure both buffers have room for it.
+ */
+void wildCopy16(uint8_t* dest, const uint8_t* src, size_t count) {
+  const uint8_t* const destEnd = dest + count;
+  do {
+    std::memcpy(dest, src, kWildCopyLength);
+    dest += kWildCopyLength;
+    src += kWildCopyLength;
+  } while (dest < destEnd);
+}
+
+/**
+ * @return true if "count" bytes can be wildCopy16()'ed from "source" into
+ *         "dest" without going past either buffer.
+ */
+bool canWildCopy16(
+    const uint8_t* dest,
+    const uint8_t* destLimit,
+    const IovecCursor& source,
+    size_t count) {
+  return source.contiguousLength() >= count + kWildCopyLength &&
+      dest + count + kWildCopyLength <= destLimit;
+}
+
 void writeLE(void* dest, uint16_t val) {
   uint16_t valLE = folly::Endian::little(val);
   std::memcpy(dest, &valLE, sizeof(uint16_t));
@@ -396,8 +427,14 @@ size_t Lz4Immutable::compressCommon(
         *token = static_cast<uint8_t>(literalLen << kMlBits);
       }
 
-      // Copy literals to output buffer.
-      wildCopy(output, anchorCursor, literalLen);
+      // Copy literals to output buffer. The anchor is re-positioned after the
+      // match, so it doesn't matter how far the copy moves it.
+      if (LIKELY(
+              canWildCopy16(output, outputLimit, anchorCursor, literalLen))) {
+        wildCopy16(output, anchorCursor.data(), literalLen);
+      } else {
+        wildCopy(output, anchorCursor, literalLen);
+      }
       output += literalLen;
     }
 
@@ -488,10 +525,9 @@ std::unique_ptr<folly::IOBuf> Lz4Immutable::decompress(
     return folly::IOBuf::create(0);
   }
 
-  // Creates a match cursor - a cursor that will keep track of matches
-  // found in the dictionary.
-  struct iovec dicIov = getDictionaryIovec(state_);
-  const IovecCursor dicCursor(&dicIov, 1);
+  // Matches are only found in the dictionary, which is contiguous.
+  const uint8_t* const dictionary = state_.dictionary->data();
+  const size_t dictionarySize = state_.dictionary->length();
 
   // Destination (uncompressed) buffer.
   auto destination = folly::IOBuf::create(uncompressedSize);
@@ -502,7 +538,6 @@ std::unique_ptr<folly::IOBuf> Lz4Immutable::decompress(
   const uint8_t* outputLimit = output + uncompressedSize;
 
   IovecCursor source(iov, iovcnt);
-  IovecCursor match = dicCursor;
 
   // Main loop
   while (true) {
@@ -529,12 +564,17 @@ std::unique_ptr<folly::IOBuf> Lz4Immutable::decompress(
       output += literalLength;
       break; // Necessarily EOF, due to parsing restrictions
     }
-    safeCopy(output, source, literalLength);
+    if (LIKELY(canWildCopy16(output, outputLimit, source, literalLength))) {
+      wildCopy16(output, source.data(), literalLength);
+      source.advance(literalLength);
+    } else {
+      safeCopy(output, source, literalLength);
+    }
     output = cpy;
 
     // Get match offset
     uint16_t offset = peekLE(source);
-    size_t matchPos = dicCursor.totalLength() + (output - outputStart) - offset;
+    size_t matchPos = dictionarySize + (output - outputStart) - offset;
     source.advance(2);
 
     // Get match length
@@ -549,8 +589,19 @@ std::unique_ptr<folly::IOBuf> Lz4Immutable::decompress(
     matchLength += kMinMatch;
 
     // Copy match
-    match.seek(matchPos);
-    safeCopy(output, match, matchLength);
+    if (UNLIKELY(
+            matchPos + matchLength > dictionarySize ||
+            output + matchLength > outputLimit)) {
+      // Corrupted input.
+      return nullptr;
+    }
+    if (LIKELY(
+            matchPos + matchLength + kWildCopyLength <= dictionarySize &&
+            output + matchLength + kWildCopyLength <= outputLimit)) {
+      wildCopy16(output, dictionary + matchPos, matchLength);
+    } else {
+      std::memcpy(output, dictionary + matchPos, matchLength);
+    }
     output += matchLength;
   }
 
@@ -0,0 +1,111 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include "MaglevHashFunc.h"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+
+#include <folly/dynamic.h>
+#include <folly/hash/Hash.h>
+
+#include "mcrouter/lib/SharedImmutable.h"
+#include "mcrouter/lib/WeightedCh3HashFunc.h"
+#include "mcrouter/lib/fbi/cpp/util.h"
+
+namespace facebook {
+namespace memcache {
+
+namespace {
+
+constexpr size_t kMinEntriesPerServer = 100;
+constexpr std::array<uint32_t, 9> kTableSizes = {{65537,
+                                                  131071,
+                                                  262147,
+                                                  524287,
+                                                  1048573,
+                                                  2097143,
+                                                  4194301,
+                                                  8388617,
+                                                  16777213}};
+
+size_t chooseTableSize(size_t n) {
+  for (auto size : kTableSizes) {
+    if (size >= n * kMinEntriesPerServer) {
+      return size;
+    }
+  }
+  return kTableSizes.back();
+}
+
+std::vector<uint32_t> buildTable(const std::vector<double>& weights) {
+  const size_t n = weights.size();
+  checkLogic(
+      n > 0 && n < kTableSizes.back(), "MaglevHashFunc: invalid pool size");
+  double maxWeight = 0;
+  for (auto weight : weights) {
+    checkLogic(weight >= 0, "MaglevHashFunc: weight is negative");
+    maxWeight = std::max(maxWeight, weight);
+  }
+  checkLogic(maxWeight > 0, "MaglevHashFunc: all weights are zero");
+
+  const uint64_t m = chooseTableSize(n);
+  std::vector<uint64_t> offsets(n);
+  std::vector<uint64_t> skips(n);
+  std::vector<uint64_t> next(n, 0);
+  std::vector<double> credits(n, 0.0);
+  for (size_t i = 0; i < n; ++i) {
+    offsets[i] = folly::hash::twang_mix64(2 * i) % m;
+    skips[i] = folly::hash::twang_mix64(2 * i + 1) % (m - 1) + 1;
+  }
+
+  constexpr auto kEmpty = std::numeric_limits<uint32_t>::max();
+  std::vector<uint32_t> table(m, kEmpty);
+  size_t filled = 0;
+  while (filled < m) {
+    for (size_t i = 0; i < n && filled < m; ++i) {
+      credits[i] += weights[i] / maxWeight;
+      while (credits[i] >= 1.0 && filled < m) {
+        credits[i] -= 1.0;
+        // Walk i's permutation of the table up to the next free entry.
+        uint64_t entry;
+        do {
+          entry = (offsets[i] + next[i] * skips[i]) % m;
+          ++next[i];
+        } while (table[entry] != kEmpty);
+        table[entry] = i;
+        ++filled;
+      }
+    }
+  }
+  return table;
+}
+
+std::vector<double> parseWeights(const folly::dynamic& json, size_t n) {
+  if (json.isObject() && json.count("weights")) {
+    return ch3wParseWeights(json, n);
+  }
+  return std::vector<double>(n, 1.0);
+}
+
+} // anonymous namespace
+
+MaglevHashFunc::MaglevHashFunc(const std::vector<double>& weights)
+    : table_(std::make_shared<const std::vector<uint32_t>>(
+          buildTable(weights))) {}
+
+MaglevHashFunc::MaglevHashFunc(const folly::dynamic& json, size_t n)
+    : table_(getSharedImmutable<std::vector<uint32_t>>(
+          folly::dynamic::array(type(), n, json),
+          [&]() {
+            return std::make_shared<const std::vector<uint32_t>>(
+                buildTable(parseWeights(json, n)));
+          })) {}
+
+} // namespace memcache
+} // namespace facebook
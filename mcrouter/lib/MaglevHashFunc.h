@@ -0,0 +1,78 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <folly/Range.h>
+#include <folly/hash/SpookyHashV2.h>
+
+namespace folly {
+struct dynamic;
+} // namespace folly
+
+namespace facebook {
+namespace memcache {
+
+/**
+ * Maglev hashing (Eisenbud et al.: "Maglev: A Fast and Reliable Software
+ * Network Load Balancer").
+ *
+ * A lookup table of prime size M (at least 100 entries per server where
+ * possible) is filled once, at construction. Every server walks its own
+ * permutation of the table (offset and skip derived from its index) and
+ * claims the next free entry it meets; servers take turns proportionally
+ * to their weights. A key then maps to table[hash(key) % M], i.e. a single
+ * lookup regardless of pool size and weights.
+ *
+ * Changing one weight (or the number of servers) only remaps a small
+ * fraction of the table, although less precisely than Ch3: some keys
+ * of unaffected servers may move as well.
+ */
+class MaglevHashFunc {
+ public:
+  /**
+   * @param weights  A list of non-negative server weights, at least one of
+   *                 them must be positive. Pool size is weights.size().
+   */
+  explicit MaglevHashFunc(const std::vector<double>& weights);
+
+  /**
+   * @param json  Json object that may contain "weights": [ ... ] in the
+   *              WeightedCh3HashFunc format. All weights are 1.0 if missing.
+   * @param n     Number of servers in the config.
+   */
+  MaglevHashFunc(const folly::dynamic& json, size_t n);
+
+  size_t operator()(folly::StringPiece key) const {
+    constexpr uint64_t kHashSeed = 0xface2018;
+    auto h =
+        folly::hash::SpookyHashV2::Hash64(key.data(), key.size(), kHashSeed);
+    return (*table_)[h % table_->size()];
+  }
+
+  /**
+   * @return  Size of the lookup table (a prime number).
+   */
+  size_t tableSize() const {
+    return table_->size();
+  }
+
+  static const char* type() {
+    return "Maglev";
+  }
+
+ private:
+  // Shared by the copies of this function object and, when built from
+  // config, by all functions built from the same config.
+  std::shared_ptr<const std::vector<uint32_t>> table_;
+};
+
+} // namespace memcache
+} // namespace facebook
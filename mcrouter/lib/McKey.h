@@ -11,6 +11,7 @@
 
 #include <folly/Range.h>
 
+#include "mcrouter/lib/carbon/Keys.h"
 #include "mcrouter/lib/mc/msg.h"
 #include "mcrouter/lib/mc/protocol.h"
 
@@ -47,5 +48,26 @@ mc_req_err_t isKeyValid(folly::StringPiece key) {
   return mc_req_err_valid;
 }
 
+/**
+ * Same as above, but uses the result of the scan for spaces and control
+ * characters that carbon::Keys does when the key is set.
+ */
+template <bool DoSpaceAndCtrlCheck, class Storage>
+mc_req_err_t isKeyValid(const carbon::Keys<Storage>& keys) {
+  if (keys.empty()) {
+    return mc_req_err_no_key;
+  }
+
+  if (keys.size() > MC_KEY_MAX_LEN) {
+    return mc_req_err_key_too_long;
+  }
+
+  if (DoSpaceAndCtrlCheck && keys.hasSpaceOrCtrl()) {
+    return mc_req_err_space_or_ctrl;
+  }
+
+  return mc_req_err_valid;
+}
+
 } // memcache
 } // facebook
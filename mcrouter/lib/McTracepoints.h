@@ -0,0 +1,36 @@
+/*
+ *  Copyright (c) 2016-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <folly/tracing/StaticTracepoint.h>
+
+/**
+ * USDT probes on the request path, under the "mcrouter" provider, e.g.
+ *
+ *   bpftrace -e 'usdt:/path/to/mcrouter:mcrouter:request_done
+ *                { @us = hist(arg1); }'
+ *
+ * A probe is a single nop when nothing is attached. Arguments are still
+ * evaluated, so only pass values that are already at hand.
+ *
+ * Probes (arguments):
+ *   request_start (ctx, request, key data, key length)
+ *   request_done (ctx, duration us, result)
+ *   destination_send (request, destination key data, destination key length)
+ *   destination_reply (request, result, start us, end us)
+ *   client_write (client, request id)
+ *   client_reply (client, request id, result)
+ *   server_request (session, request id)
+ *   server_reply (session, request id)
+ *   tko_event (destination key data, destination key length, TkoLogEvent)
+ *
+ * `ctx` is the ProxyRequestContext, `request` the address of the request
+ * being routed; request_start carries both so scripts can join them (routes
+ * that rewrite the request send a copy, with a different address).
+ */
+#define MC_TRACEPOINT(name, ...) FOLLY_SDT(mcrouter, name, __VA_ARGS__)
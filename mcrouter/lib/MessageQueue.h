@@ -263,6 +263,34 @@ class MessageQueue {
     }
   }
 
+  /**
+   * Batched version of blockingWriteRelaxed(): puts a new element into the
+   * queue without notifying the reader. Can be called from any thread.
+   * The writer must call notifyRelaxed() once after the last write of the
+   * batch, so that the whole batch costs at most one wake up.
+   * If the queue is full, the reader is notified before blocking, as it may
+   * otherwise never wake up to make room.
+   */
+  template <class... Args>
+  void blockingWriteNoNotify(Args&&... args) noexcept {
+    if (queue_.write(args...)) {
+      return;
+    }
+    if (notifier_.shouldNotify()) {
+      doNotify();
+    }
+    queue_.blockingWrite(std::forward<Args>(args)...);
+  }
+
+  /**
+   * Finishes a batch of blockingWriteNoNotify() calls.
+   */
+  void notifyRelaxed() noexcept {
+    if (notifier_.shouldNotifyRelaxed()) {
+      doNotify();
+    }
+  }
+
  private:
   static constexpr int64_t kWakeupEveryMs = 2;
   folly::MPMCQueue<T> queue_;
@@ -0,0 +1,97 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include "PerfectStringIndex.h"
+
+#include <algorithm>
+#include <limits>
+
+#include <folly/Bits.h>
+
+#include "mcrouter/lib/fbi/cpp/util.h"
+
+namespace facebook {
+namespace memcache {
+
+constexpr size_t PerfectStringIndex::kNotFound;
+
+PerfectStringIndex::PerfectStringIndex(std::vector<std::string> keys)
+    : keys_(std::move(keys)) {
+  if (keys_.empty()) {
+    return;
+  }
+  checkLogic(
+      keys_.size() < std::numeric_limits<uint32_t>::max() / 2,
+      "PerfectStringIndex: too many keys");
+
+  const size_t n = keys_.size();
+  displacements_.assign(folly::nextPowTwo(std::max<size_t>(n / 2, 1)), 0);
+
+  std::vector<uint64_t> hashes(n);
+  std::vector<std::vector<uint32_t>> buckets(displacements_.size());
+  for (size_t i = 0; i < n; ++i) {
+    hashes[i] = hashKey(keys_[i]);
+    buckets[hashes[i] & (displacements_.size() - 1)].push_back(i);
+  }
+
+  // Place the biggest buckets first, while the table is still empty.
+  std::vector<uint32_t> order(buckets.size());
+  for (size_t b = 0; b < buckets.size(); ++b) {
+    order[b] = b;
+  }
+  std::sort(order.begin(), order.end(), [&buckets](uint32_t a, uint32_t b) {
+    return buckets[a].size() > buckets[b].size();
+  });
+
+  // With twice as many slots as keys a displacement is found after a few
+  // attempts; the table only grows if keys have identical hashes, i.e.
+  // if there are duplicates.
+  constexpr uint32_t kMaxDisplacement = 1 << 16;
+  const uint32_t kUnused = n;
+  slots_.assign(folly::nextPowTwo(2 * n), kUnused);
+  std::vector<size_t> candidate;
+  for (auto b : order) {
+    const auto& bucket = buckets[b];
+    if (bucket.empty()) {
+      break;
+    }
+    uint32_t disp = 0;
+    for (; disp < kMaxDisplacement; ++disp) {
+      candidate.clear();
+      for (auto i : bucket) {
+        auto s = slot(hashes[i], disp);
+        if (slots_[s] != kUnused ||
+            std::find(candidate.begin(), candidate.end(), s) !=
+                candidate.end()) {
+          break;
+        }
+        candidate.push_back(s);
+      }
+      if (candidate.size() == bucket.size()) {
+        break;
+      }
+    }
+    if (disp == kMaxDisplacement) {
+      for (size_t i = 1; i < bucket.size(); ++i) {
+        for (size_t j = 0; j < i; ++j) {
+          checkLogic(
+              keys_[bucket[i]] != keys_[bucket[j]],
+              "PerfectStringIndex: duplicate key {}",
+              keys_[bucket[i]]);
+        }
+      }
+      throwLogic("PerfectStringIndex: can't build the index");
+    }
+    displacements_[b] = disp;
+    for (size_t k = 0; k < bucket.size(); ++k) {
+      slots_[candidate[k]] = bucket[k];
+    }
+  }
+}
+
+} // memcache
+} // facebook
@@ -0,0 +1,79 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <folly/Range.h>
+#include <folly/hash/Hash.h>
+#include <folly/hash/SpookyHashV2.h>
+
+namespace facebook {
+namespace memcache {
+
+/**
+ * Perfect hash of a fixed set of strings to their positions in that set
+ * ("hash and displace"): keys are hashed into buckets, and every bucket
+ * stores a displacement that sends all of its keys to distinct slots of
+ * the table. A lookup is one key hash, two array loads and one string
+ * comparison, with no probing.
+ *
+ * Meant to be built once (e.g. at config load) for a few thousand keys
+ * at most.
+ */
+class PerfectStringIndex {
+ public:
+  static constexpr size_t kNotFound = static_cast<size_t>(-1);
+
+  PerfectStringIndex() = default;
+
+  /**
+   * @param keys  Distinct strings to index.
+   *
+   * @throws std::logic_error if keys contain duplicates.
+   */
+  explicit PerfectStringIndex(std::vector<std::string> keys);
+
+  /**
+   * @return  position of key in the vector passed to the constructor,
+   *          or kNotFound.
+   */
+  size_t find(folly::StringPiece key) const {
+    if (keys_.empty()) {
+      return kNotFound;
+    }
+    const uint64_t hash = hashKey(key);
+    const auto disp = displacements_[hash & (displacements_.size() - 1)];
+    const auto idx = slots_[slot(hash, disp)];
+    return idx < keys_.size() && keys_[idx] == key ? idx : kNotFound;
+  }
+
+  size_t size() const {
+    return keys_.size();
+  }
+
+ private:
+  std::vector<std::string> keys_;
+  // Per bucket displacement, power of 2 size.
+  std::vector<uint32_t> displacements_;
+  // Position in keys_ for every slot (or keys_.size() if unused),
+  // power of 2 size.
+  std::vector<uint32_t> slots_;
+
+  static uint64_t hashKey(folly::StringPiece key) {
+    return folly::hash::SpookyHashV2::Hash64(key.data(), key.size(), 0);
+  }
+
+  size_t slot(uint64_t hash, uint32_t displacement) const {
+    return folly::hash::twang_mix64(hash + displacement) & (slots_.size() - 1);
+  }
+};
+
+} // memcache
+} // facebook
@@ -0,0 +1,130 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <cstddef>
+#include <new>
+
+namespace facebook {
+namespace memcache {
+
+/**
+ * Per-thread free list of memory blocks of sizeof(T) bytes. Blocks freed on
+ * a thread are handed out again by the next allocations on the same thread,
+ * so objects created and destroyed on the same thread over and over (e.g.
+ * request contexts on a proxy thread) don't go through malloc at all.
+ * At most kMaxCached blocks are kept per thread, the rest is freed.
+ *
+ * Blocks may be freed on a different thread than the one that allocated
+ * them. Must not be used during thread-local storage destruction.
+ */
+template <class T, size_t kMaxCached = 1024>
+class ThreadLocalRecycler {
+ public:
+  static void* allocate() {
+    auto& cache = getCache();
+    if (auto node = cache.head) {
+      cache.head = node->next;
+      --cache.size;
+      return node;
+    }
+    return ::operator new(kBlockSize);
+  }
+
+  static void deallocate(void* p) {
+    auto& cache = getCache();
+    if (cache.size >= kMaxCached) {
+      ::operator delete(p);
+      return;
+    }
+    auto node = static_cast<Node*>(p);
+    node->next = cache.head;
+    cache.head = node;
+    ++cache.size;
+  }
+
+  /**
+   * @return number of blocks cached by this thread.
+   */
+  static size_t cachedBlocks() {
+    return getCache().size;
+  }
+
+ private:
+  struct Node {
+    Node* next;
+  };
+
+  static constexpr size_t kBlockSize =
+      sizeof(T) > sizeof(Node) ? sizeof(T) : sizeof(Node);
+  static_assert(
+      alignof(T) <= alignof(std::max_align_t),
+      "ThreadLocalRecycler doesn't support over-aligned types");
+
+  struct Cache {
+    Node* head{nullptr};
+    size_t size{0};
+
+    ~Cache() {
+      while (head) {
+        auto next = head->next;
+        ::operator delete(head);
+        head = next;
+      }
+    }
+  };
+
+  static Cache& getCache() {
+    static thread_local Cache cache;
+    return cache;
+  }
+};
+
+/**
+ * Standard allocator that takes single objects from ThreadLocalRecycler,
+ * e.g. for the control blocks of std::shared_ptr. Arrays are allocated
+ * as usual.
+ */
+template <class T>
+class RecyclingAllocator {
+ public:
+  using value_type = T;
+
+  RecyclingAllocator() = default;
+
+  template <class U>
+  /* implicit */ RecyclingAllocator(const RecyclingAllocator<U>&) {}
+
+  T* allocate(size_t n) {
+    if (n == 1) {
+      return static_cast<T*>(ThreadLocalRecycler<T>::allocate());
+    }
+    return static_cast<T*>(::operator new(n * sizeof(T)));
+  }
+
+  void deallocate(T* p, size_t n) {
+    if (n == 1) {
+      ThreadLocalRecycler<T>::deallocate(p);
+    } else {
+      ::operator delete(p);
+    }
+  }
+
+  template <class U>
+  bool operator==(const RecyclingAllocator<U>&) const {
+    return true;
+  }
+
+  template <class U>
+  bool operator!=(const RecyclingAllocator<U>&) const {
+    return false;
+  }
+};
+
+} // memcache
+} // facebook
@@ -0,0 +1,68 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include "RefillLimiter.h"
+
+namespace facebook {
+namespace memcache {
+
+RefillLimiter::RefillLimiter(
+    Options opts,
+    folly::Function<void(Result)> onResult)
+    : opts_(opts), onResult_(std::move(onResult)) {}
+
+RefillLimiter::Result RefillLimiter::admit(
+    folly::StringPiece key,
+    Clock::time_point now) {
+  auto result = decide(key, now);
+  if (onResult_) {
+    onResult_(result);
+  }
+  return result;
+}
+
+RefillLimiter::Result RefillLimiter::decide(
+    folly::StringPiece key,
+    Clock::time_point now) {
+  const bool dedup = opts_.dedupWindow.count() > 0;
+  std::string keyStr;
+  if (dedup) {
+    while (!recent_.empty() && recent_.front().first <= now) {
+      recentKeys_.erase(recent_.front().second);
+      recent_.pop_front();
+    }
+    keyStr = key.str();
+    if (recentKeys_.count(keyStr)) {
+      return Result::Deduped;
+    }
+  }
+
+  if (opts_.maxOutstanding > 0 && outstanding_ >= opts_.maxOutstanding) {
+    return Result::Dropped;
+  }
+
+  if (opts_.maxRate > 0) {
+    if (now - rateWindowStart_ >= std::chrono::seconds(1)) {
+      rateWindowStart_ = now;
+      rateWindowCount_ = 0;
+    }
+    if (rateWindowCount_ >= opts_.maxRate) {
+      return Result::Dropped;
+    }
+    ++rateWindowCount_;
+  }
+
+  if (dedup) {
+    recentKeys_.insert(keyStr);
+    recent_.emplace_back(now + opts_.dedupWindow, std::move(keyStr));
+  }
+  ++outstanding_;
+  return Result::Admitted;
+}
+
+} // memcache
+} // facebook
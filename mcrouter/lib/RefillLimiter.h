@@ -0,0 +1,119 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <utility>
+
+#include <folly/Function.h>
+#include <folly/Range.h>
+#include <folly/ScopeGuard.h>
+#include <folly/fibers/FiberManager.h>
+
+namespace facebook {
+namespace memcache {
+
+/**
+ * Limits the fire-and-forget writes that refill a cache from another one
+ * (e.g. WarmUpRoute's cold adds, L1L2CacheRoute's L1 adds).
+ *
+ * A refill is dropped if there were maxRate refills in the last second or
+ * maxOutstanding refills are in flight, and deduplicated if the same key was
+ * refilled less than dedupWindow ago. A zero option disables the
+ * corresponding limit.
+ *
+ * Not thread-safe: meant to be owned by a proxy and shared by all of its
+ * routes.
+ */
+class RefillLimiter {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  struct Options {
+    std::chrono::milliseconds dedupWindow{0};
+    size_t maxRate{0};
+    size_t maxOutstanding{0};
+  };
+
+  enum class Result { Admitted, Deduped, Dropped };
+
+  /**
+   * @param onResult  called with the outcome of every admit(), e.g. to
+   *                  update stats.
+   */
+  explicit RefillLimiter(
+      Options opts,
+      folly::Function<void(Result)> onResult = nullptr);
+
+  /**
+   * Decides if a refill of key should be sent now. Every admitted refill
+   * has to be followed by a call to done() once it completes.
+   */
+  Result admit(folly::StringPiece key) {
+    return admit(key, Clock::now());
+  }
+  Result admit(folly::StringPiece key, Clock::time_point now);
+
+  void done() {
+    --outstanding_;
+  }
+
+  size_t outstanding() const {
+    return outstanding_;
+  }
+
+ private:
+  const Options opts_;
+  folly::Function<void(Result)> onResult_;
+
+  size_t outstanding_{0};
+
+  // Rate limit: number of refills admitted in the current one second window.
+  Clock::time_point rateWindowStart_;
+  size_t rateWindowCount_{0};
+
+  // Keys refilled within the last dedupWindow, oldest first.
+  std::deque<std::pair<Clock::time_point, std::string>> recent_;
+  std::unordered_set<std::string> recentKeys_;
+
+  Result decide(folly::StringPiece key, Clock::time_point now);
+};
+
+/**
+ * Sends req to target in a new fiber, without waiting for the reply, if
+ * limiter (may be nullptr) admits it.
+ */
+template <class RouteHandleIf, class Request>
+void sendRefill(
+    RefillLimiter* limiter,
+    std::shared_ptr<RouteHandleIf> target,
+    Request req) {
+  if (limiter &&
+      limiter->admit(req.key().fullKey()) !=
+          RefillLimiter::Result::Admitted) {
+    return;
+  }
+  folly::fibers::addTask(
+      [ limiter, target = std::move(target), req = std::move(req) ]() {
+        SCOPE_EXIT {
+          if (limiter) {
+            limiter->done();
+          }
+        };
+        target->route(req);
+      });
+}
+
+} // memcache
+} // facebook
@@ -24,23 +24,11 @@ RendezvousHashFunc::RendezvousHashFunc(
 }
 
 size_t RendezvousHashFunc::operator()(folly::StringPiece key) const {
-  uint64_t maxScore = 0;
-  size_t maxScorePos = 0;
-
   const uint64_t keyHash =
       murmur_hash_64A(key.data(), key.size(), kRendezvousExtraHashSeed);
 
-  size_t pos = 0;
-  for (const auto hash : endpointHashes_) {
-    const uint64_t score = hash128to64(hash, keyHash);
-    if (score > maxScore) {
-      maxScore = score;
-      maxScorePos = pos;
-    }
-    ++pos;
-  }
-
-  return maxScorePos;
+  return rendezvousMaxScorePos(
+      endpointHashes_.data(), endpointHashes_.size(), keyHash);
 }
 } // namespace memcache
 } // namespace facebook
@@ -0,0 +1,157 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include "RendezvousHashHelper.h"
+
+#include <folly/CpuId.h>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define MCROUTER_RENDEZVOUS_SIMD 1
+#endif
+
+namespace facebook {
+namespace memcache {
+
+namespace {
+
+constexpr uint64_t kMul = 0x9ddfea08eb382d69ULL;
+
+size_t maxScorePosScalar(
+    const uint64_t* hashes,
+    size_t n,
+    uint64_t keyHash,
+    size_t begin = 0,
+    uint64_t maxScore = 0,
+    size_t maxScorePos = 0) {
+  for (size_t i = begin; i < n; ++i) {
+    const uint64_t score = hash128to64(hashes[i], keyHash);
+    if (score > maxScore) {
+      maxScore = score;
+      maxScorePos = i;
+    }
+  }
+  return maxScorePos;
+}
+
+void scoresScalar(
+    const uint64_t* hashes,
+    size_t n,
+    uint64_t keyHash,
+    uint64_t* scores,
+    size_t begin = 0) {
+  for (size_t i = begin; i < n; ++i) {
+    scores[i] = hash128to64(hashes[i], keyHash);
+  }
+}
+
+#ifdef MCROUTER_RENDEZVOUS_SIMD
+
+// AVX2 has no 64-bit multiply, and emulating it with 32-bit ones turns out
+// slower than the scalar code, so there's only an AVX-512 kernel.
+__attribute__((target("avx512f,avx512dq"))) inline __m512i
+hash128to64Avx512(__m512i upper, __m512i lower) {
+  const __m512i mul = _mm512_set1_epi64(kMul);
+  __m512i a = _mm512_mullo_epi64(_mm512_xor_si512(lower, upper), mul);
+  a = _mm512_xor_si512(a, _mm512_srli_epi64(a, 47));
+  __m512i b = _mm512_mullo_epi64(_mm512_xor_si512(upper, a), mul);
+  b = _mm512_xor_si512(b, _mm512_srli_epi64(b, 47));
+  return _mm512_mullo_epi64(b, mul);
+}
+
+__attribute__((target("avx512f,avx512dq"))) size_t
+maxScorePosAvx512(const uint64_t* hashes, size_t n, uint64_t keyHash) {
+  constexpr size_t kLanes = 8;
+  if (n < kLanes) {
+    return maxScorePosScalar(hashes, n, keyHash);
+  }
+  const __m512i key = _mm512_set1_epi64(keyHash);
+  const __m512i step = _mm512_set1_epi64(kLanes);
+  __m512i idx = _mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7);
+  __m512i best = _mm512_setzero_si512();
+  __m512i bestIdx = idx;
+  size_t i = 0;
+  for (; i + kLanes <= n; i += kLanes) {
+    auto score = hash128to64Avx512(_mm512_loadu_si512(hashes + i), key);
+    auto greater = _mm512_cmpgt_epu64_mask(score, best);
+    best = _mm512_mask_mov_epi64(best, greater, score);
+    bestIdx = _mm512_mask_mov_epi64(bestIdx, greater, idx);
+    idx = _mm512_add_epi64(idx, step);
+  }
+
+  // The lowest position among the lanes holding the highest score.
+  uint64_t maxScore = _mm512_reduce_max_epu64(best);
+  auto isMax = _mm512_cmpeq_epu64_mask(best, _mm512_set1_epi64(maxScore));
+  size_t maxScorePos = _mm512_mask_reduce_min_epu64(isMax, bestIdx);
+  return maxScorePosScalar(hashes, n, keyHash, i, maxScore, maxScorePos);
+}
+
+__attribute__((target("avx512f,avx512dq"))) void scoresAvx512(
+    const uint64_t* hashes,
+    size_t n,
+    uint64_t keyHash,
+    uint64_t* scores) {
+  const __m512i key = _mm512_set1_epi64(keyHash);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm512_storeu_si512(
+        scores + i, hash128to64Avx512(_mm512_loadu_si512(hashes + i), key));
+  }
+  scoresScalar(hashes, n, keyHash, scores, i);
+}
+
+#endif // MCROUTER_RENDEZVOUS_SIMD
+
+} // anonymous namespace
+
+RendezvousKernel bestRendezvousKernel() {
+  static const RendezvousKernel kBest = []() {
+#ifdef MCROUTER_RENDEZVOUS_SIMD
+    folly::CpuId cpuId;
+    if (cpuId.avx512f() && cpuId.avx512dq()) {
+      return RendezvousKernel::AVX512;
+    }
+#endif
+    return RendezvousKernel::SCALAR;
+  }();
+  return kBest;
+}
+
+size_t rendezvousMaxScorePos(
+    const uint64_t* hashes,
+    size_t n,
+    uint64_t keyHash,
+    RendezvousKernel kernel) {
+  switch (kernel) {
+#ifdef MCROUTER_RENDEZVOUS_SIMD
+    case RendezvousKernel::AVX512:
+      return maxScorePosAvx512(hashes, n, keyHash);
+#endif
+    default:
+      return maxScorePosScalar(hashes, n, keyHash);
+  }
+}
+
+void rendezvousScores(
+    const uint64_t* hashes,
+    size_t n,
+    uint64_t keyHash,
+    uint64_t* scores,
+    RendezvousKernel kernel) {
+  switch (kernel) {
+#ifdef MCROUTER_RENDEZVOUS_SIMD
+    case RendezvousKernel::AVX512:
+      scoresAvx512(hashes, n, keyHash, scores);
+      return;
+#endif
+    default:
+      scoresScalar(hashes, n, keyHash, scores);
+  }
+}
+
+} // namespace memcache
+} // namespace facebook
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <inttypes.h>
+#include <stddef.h>
 
 namespace facebook {
 namespace memcache {
@@ -40,5 +41,39 @@ inline double convertInt64ToDouble01(const uint64_t value) {
   return (value & fiftyThreeOnes) / fiftyThreeZeros;
 }
 
+/**
+ * Implementations of the batch scoring functions below. Only the ones
+ * supported by the CPU may be used.
+ */
+enum class RendezvousKernel {
+  SCALAR,
+  AVX512,
+};
+
+/**
+ * @return  the fastest kernel supported by this CPU.
+ */
+RendezvousKernel bestRendezvousKernel();
+
+/**
+ * @return  position of the highest hash128to64(hashes[i], keyHash) over
+ *          i < n, the first one if there are several; 0 if n == 0.
+ */
+size_t rendezvousMaxScorePos(
+    const uint64_t* hashes,
+    size_t n,
+    uint64_t keyHash,
+    RendezvousKernel kernel = bestRendezvousKernel());
+
+/**
+ * Sets scores[i] = hash128to64(hashes[i], keyHash) for every i < n.
+ */
+void rendezvousScores(
+    const uint64_t* hashes,
+    size_t n,
+    uint64_t keyHash,
+    uint64_t* scores,
+    RendezvousKernel kernel = bestRendezvousKernel());
+
 } // namespace memcache
 } // namespace facebook
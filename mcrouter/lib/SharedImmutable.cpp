@@ -0,0 +1,110 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include "SharedImmutable.h"
+
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+
+#include <folly/hash/Hash.h>
+
+namespace facebook {
+namespace memcache {
+
+namespace {
+
+using Key = std::pair<std::type_index, folly::dynamic>;
+
+struct KeyHash {
+  size_t operator()(const Key& key) const {
+    return folly::hash::hash_combine(key.first, key.second);
+  }
+};
+
+class SharedImmutables {
+ public:
+  std::shared_ptr<const void> find(
+      std::type_index type,
+      const folly::dynamic& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = objects_.find(Key(type, key));
+    return it == objects_.end() ? nullptr : it->second.lock();
+  }
+
+  std::shared_ptr<const void> add(
+      std::type_index type,
+      const folly::dynamic& key,
+      std::shared_ptr<const void> obj) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& entry = objects_[Key(type, key)];
+    if (auto existing = entry.lock()) {
+      return existing;
+    }
+    entry = obj;
+    // Drop expired entries once the table doubled, so that old configs
+    // don't accumulate across reconfigurations.
+    if (objects_.size() >= 2 * sizeAfterPrune_) {
+      prune();
+    }
+    return obj;
+  }
+
+  size_t numLive() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    prune();
+    return objects_.size();
+  }
+
+ private:
+  std::mutex mutex_;
+  std::unordered_map<Key, std::weak_ptr<const void>, KeyHash> objects_;
+  size_t sizeAfterPrune_{16};
+
+  void prune() {
+    for (auto it = objects_.begin(); it != objects_.end();) {
+      if (it->second.expired()) {
+        it = objects_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    sizeAfterPrune_ = std::max<size_t>(16, objects_.size());
+  }
+};
+
+SharedImmutables& sharedImmutables() {
+  // Leaked: may be used by route handles destroyed during static destruction.
+  static auto* instance = new SharedImmutables();
+  return *instance;
+}
+
+} // anonymous
+
+namespace detail {
+
+std::shared_ptr<const void> findSharedImmutable(
+    std::type_index type,
+    const folly::dynamic& key) {
+  return sharedImmutables().find(type, key);
+}
+
+std::shared_ptr<const void> addSharedImmutable(
+    std::type_index type,
+    const folly::dynamic& key,
+    std::shared_ptr<const void> obj) {
+  return sharedImmutables().add(type, key, std::move(obj));
+}
+
+} // detail
+
+size_t numSharedImmutables() {
+  return sharedImmutables().numLive();
+}
+
+} // memcache
+} // facebook
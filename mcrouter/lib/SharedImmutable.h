@@ -0,0 +1,71 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <memory>
+#include <typeindex>
+#include <utility>
+
+#include <folly/dynamic.h>
+
+namespace facebook {
+namespace memcache {
+
+namespace detail {
+
+std::shared_ptr<const void> findSharedImmutable(
+    std::type_index type,
+    const folly::dynamic& key);
+
+/**
+ * Registers obj under (type, key), unless a live object is already
+ * registered there, in which case that one is returned instead.
+ */
+std::shared_ptr<const void> addSharedImmutable(
+    std::type_index type,
+    const folly::dynamic& key,
+    std::shared_ptr<const void> obj);
+
+} // detail
+
+/**
+ * Returns an immutable object built from config, shared by everyone asking
+ * for the same type and key while any of them holds it.
+ *
+ * Every proxy builds its own route tree from the same config, so objects
+ * that are pure functions of the config (hash function tables, weights)
+ * would otherwise be duplicated num_proxies times. Thread-safe; the table
+ * only holds weak references.
+ *
+ * @param key     JSON that fully determines the object, e.g. its config
+ *                together with any other constructor argument.
+ * @param create  Called to build the object if there is no live one; returns
+ *                std::shared_ptr<const T>. May be called concurrently for
+ *                the same key, in which case all but one of the results are
+ *                dropped.
+ */
+template <class T, class Create>
+std::shared_ptr<const T> getSharedImmutable(
+    const folly::dynamic& key,
+    Create&& create) {
+  const std::type_index type(typeid(T));
+  if (auto obj = detail::findSharedImmutable(type, key)) {
+    return std::static_pointer_cast<const T>(std::move(obj));
+  }
+  std::shared_ptr<const T> obj = create();
+  return std::static_pointer_cast<const T>(
+      detail::addSharedImmutable(type, key, std::move(obj)));
+}
+
+/**
+ * @return number of live shared objects. For tests.
+ */
+size_t numSharedImmutables();
+
+} // memcache
+} // facebook
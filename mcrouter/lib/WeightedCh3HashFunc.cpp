@@ -10,6 +10,7 @@
 #include <folly/dynamic.h>
 #include <folly/hash/SpookyHashV2.h>
 
+#include "mcrouter/lib/SharedImmutable.h"
 #include "mcrouter/lib/fbi/cpp/util.h"
 #include "mcrouter/lib/fbi/hash.h"
 
@@ -79,13 +80,19 @@ size_t weightedCh3Hash(
 }
 
 WeightedCh3HashFunc::WeightedCh3HashFunc(std::vector<double> weights)
-    : weights_(std::move(weights)) {}
+    : weights_(
+          std::make_shared<const std::vector<double>>(std::move(weights))) {}
 
 WeightedCh3HashFunc::WeightedCh3HashFunc(const folly::dynamic& json, size_t n)
-    : weights_(ch3wParseWeights(json, n)) {}
+    : weights_(getSharedImmutable<std::vector<double>>(
+          folly::dynamic::array(type(), n, json),
+          [&]() {
+            return std::make_shared<const std::vector<double>>(
+                ch3wParseWeights(json, n));
+          })) {}
 
 size_t WeightedCh3HashFunc::operator()(folly::StringPiece key) const {
-  return weightedCh3Hash(key, weights_);
+  return weightedCh3Hash(key, *weights_);
 }
 
 } // namespace memcache
@@ -7,7 +7,9 @@
  */
 #pragma once
 
+#include <memory>
 #include <unordered_map>
+#include <vector>
 
 #include <folly/Range.h>
 
@@ -76,7 +78,7 @@ class WeightedCh3HashFunc {
    * @return Saved weights.
    */
   const std::vector<double>& weights() const {
-    return weights_;
+    return *weights_;
   }
 
   static const char* type() {
@@ -84,7 +86,9 @@ class WeightedCh3HashFunc {
   }
 
  private:
-  const std::vector<double> weights_;
+  // Shared by the copies of this function object and, when built from
+  // config, by all functions built from the same config.
+  std::shared_ptr<const std::vector<double>> weights_;
 };
 
 } // namespace memcache
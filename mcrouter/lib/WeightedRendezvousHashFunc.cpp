@@ -7,6 +7,7 @@
  */
 #include "WeightedRendezvousHashFunc.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 
@@ -55,14 +56,20 @@ size_t WeightedRendezvousHashFunc::operator()(folly::StringPiece key) const {
   const uint64_t keyHash =
       murmur_hash_64A(key.data(), key.size(), kRendezvousExtraHashSeed);
 
-  for (size_t i = 0; i < endpointHashes_.size(); ++i) {
-    uint64_t scoreInt = hash128to64(endpointHashes_[i], keyHash);
-    // Borrow from https://en.wikipedia.org/wiki/Rendezvous_hashing.
-    double score = endpointWeights_[i] *
-        (1.0 / (-std::log(convertInt64ToDouble01(scoreInt))));
-    if (score > maxScore) {
-      maxScore = score;
-      maxScorePos = i;
+  // Mix the key with a batch of endpoints at once, then weigh the scores.
+  constexpr size_t kBatchSize = 64;
+  uint64_t scoreInts[kBatchSize];
+  for (size_t begin = 0; begin < endpointHashes_.size(); begin += kBatchSize) {
+    const auto n = std::min(kBatchSize, endpointHashes_.size() - begin);
+    rendezvousScores(endpointHashes_.data() + begin, n, keyHash, scoreInts);
+    for (size_t j = 0; j < n; ++j) {
+      // Borrow from https://en.wikipedia.org/wiki/Rendezvous_hashing.
+      double score = endpointWeights_[begin + j] *
+          (1.0 / (-std::log(convertInt64ToDouble01(scoreInts[j]))));
+      if (score > maxScore) {
+        maxScore = score;
+        maxScorePos = begin + j;
+      }
     }
   }
 
@@ -9,9 +9,19 @@
 
 #if FOLLY_HAVE_LIBZSTD && !defined(DISABLE_COMPRESSION)
 
+#include <algorithm>
+
 namespace facebook {
 namespace memcache {
 
+namespace {
+
+// Output is produced in a chain of buffers of at most this size, so that big
+// values don't need one big allocation.
+constexpr size_t kMaxOutputChunkSize = 128 * 1024;
+
+} // anonymous
+
 ZstdCompressionCodec::ZstdCompressionCodec(
     std::unique_ptr<folly::IOBuf> dictionary,
     uint32_t id,
@@ -50,59 +60,106 @@ std::unique_ptr<folly::IOBuf> ZstdCompressionCodec::compress(
     const struct iovec* iov,
     size_t iovcnt) {
   assert(iov);
-  folly::IOBuf data =
-      coalesceIovecs(iov, iovcnt, IovecCursor::computeTotalLength(iov, iovcnt));
-  auto bytes = data.coalesce();
-  size_t compressBound = ZSTD_compressBound(bytes.size());
-  auto buffer = folly::IOBuf::create(compressBound);
-
-  size_t const compressedSize = ZSTD_compress_usingCDict(
-      zstdCContext_.get(),
-      buffer->writableTail(),
-      compressBound,
-      bytes.data(),
-      bytes.size(),
-      zstdCDict_.get());
-
-  if (ZSTD_isError(compressedSize)) {
-    throw std::runtime_error(folly::sformat(
-        "ZSTD codec: Failed to compress. Error: {}",
-        ZSTD_getErrorName(compressedSize)));
-  }
+  const size_t uncompressedLength =
+      IovecCursor::computeTotalLength(iov, iovcnt);
+  auto* cctx = zstdCContext_.get();
+  ZSTD_CCtx_reset(cctx, ZSTD_reset_session_only);
+  ZSTD_CCtx_refCDict(cctx, zstdCDict_.get());
+  // Keeps the uncompressed size in the frame header, like ZSTD_compress does.
+  ZSTD_CCtx_setPledgedSrcSize(cctx, uncompressedLength);
 
-  buffer->append(compressedSize);
-  return buffer;
+  OutputChain out(std::min(
+      ZSTD_compressBound(uncompressedLength), kMaxOutputChunkSize));
+  for (size_t i = 0; i <= iovcnt; ++i) {
+    // One more round without input to end the frame.
+    const bool last = i == iovcnt;
+    ZSTD_inBuffer input = {
+        last ? nullptr : iov[i].iov_base, last ? 0 : iov[i].iov_len, 0};
+    size_t ret;
+    do {
+      ret = ZSTD_compressStream2(
+          cctx,
+          &out.buffer(),
+          &input,
+          last ? ZSTD_e_end : ZSTD_e_continue);
+      if (ZSTD_isError(ret)) {
+        throw std::runtime_error(folly::sformat(
+            "ZSTD codec: Failed to compress. Error: {}",
+            ZSTD_getErrorName(ret)));
+      }
+    } while (last ? ret != 0 : input.pos < input.size);
+  }
+  return out.finish();
 }
 
 std::unique_ptr<folly::IOBuf> ZstdCompressionCodec::uncompress(
     const struct iovec* iov,
     size_t iovcnt,
     size_t uncompressedLength) {
-  folly::IOBuf data =
-      coalesceIovecs(iov, iovcnt, IovecCursor::computeTotalLength(iov, iovcnt));
-  auto bytes = data.coalesce();
-  auto buffer = folly::IOBuf::create(uncompressedLength);
-
-  size_t const bytesWritten = ZSTD_decompress_usingDDict(
-      zstdDContext_.get(),
-      buffer->writableTail(),
-      buffer->capacity(),
-      bytes.data(),
-      bytes.size(),
-      zstdDDict_.get());
-
-  if (ZSTD_isError(bytesWritten)) {
-    throw std::runtime_error(folly::sformat(
-        "ZSTD codec: decompression returned invalid value. Error: {} ",
-        ZSTD_getErrorName(bytesWritten)));
-  }
+  auto* dctx = zstdDContext_.get();
+  ZSTD_DCtx_reset(dctx, ZSTD_reset_session_only);
+  ZSTD_DCtx_refDDict(dctx, zstdDDict_.get());
 
-  assert(bytesWritten == uncompressedLength);
+  OutputChain out(
+      uncompressedLength > 0
+          ? std::min(uncompressedLength, kMaxOutputChunkSize)
+          : kMaxOutputChunkSize);
+  // 0 once the frame is fully decoded and flushed.
+  size_t ret = 1;
+  for (size_t i = 0; i <= iovcnt && ret != 0; ++i) {
+    // Once the input is consumed, keep going while output is pending.
+    const bool last = i == iovcnt;
+    ZSTD_inBuffer input = {
+        last ? nullptr : iov[i].iov_base, last ? 0 : iov[i].iov_len, 0};
+    do {
+      auto& output = out.buffer();
+      ret = ZSTD_decompressStream(dctx, &output, &input);
+      if (ZSTD_isError(ret)) {
+        throw std::runtime_error(folly::sformat(
+            "ZSTD codec: decompression returned invalid value. Error: {} ",
+            ZSTD_getErrorName(ret)));
+      }
+      if (last && ret != 0 && output.pos < output.size) {
+        throw std::runtime_error("ZSTD codec: truncated input");
+      }
+    } while (input.pos < input.size || (last && ret != 0));
+  }
 
-  buffer->append(bytesWritten);
+  auto buffer = out.finish();
+  assert(
+      uncompressedLength == 0 ||
+      buffer->computeChainDataLength() == uncompressedLength);
   return buffer;
 }
 
+ZstdCompressionCodec::OutputChain::OutputChain(size_t chunkSize)
+    : chunkSize_(chunkSize) {}
+
+ZSTD_outBuffer& ZstdCompressionCodec::OutputChain::buffer() {
+  if (tail_ == nullptr || output_.pos == output_.size) {
+    if (tail_ != nullptr) {
+      tail_->append(output_.pos);
+    }
+    auto chunk = folly::IOBuf::create(chunkSize_);
+    tail_ = chunk.get();
+    if (head_) {
+      head_->prependChain(std::move(chunk));
+    } else {
+      head_ = std::move(chunk);
+    }
+    output_ = {tail_->writableTail(), tail_->tailroom(), 0};
+  }
+  return output_;
+}
+
+std::unique_ptr<folly::IOBuf> ZstdCompressionCodec::OutputChain::finish() {
+  if (tail_ == nullptr) {
+    return folly::IOBuf::create(0);
+  }
+  tail_->append(output_.pos);
+  return std::move(head_);
+}
+
 } // memcache
 } // facebook
 #endif // FOLLY_HAVE_LIBZSTD && !defined(DISABLE_COMPRESSION)
@@ -38,6 +38,24 @@ class ZstdCompressionCodec : public CompressionCodec {
   template <class T>
   using UPtr = std::unique_ptr<T, size_t (*)(T*)>;
 
+  // Chain of bounded size output buffers that zstd streams into.
+  class OutputChain {
+   public:
+    explicit OutputChain(size_t chunkSize);
+
+    // Buffer with room for more output, adds a new chunk if the last one is
+    // full.
+    ZSTD_outBuffer& buffer();
+
+    std::unique_ptr<folly::IOBuf> finish();
+
+   private:
+    const size_t chunkSize_;
+    std::unique_ptr<folly::IOBuf> head_;
+    folly::IOBuf* tail_{nullptr};
+    ZSTD_outBuffer output_{nullptr, 0, 0};
+  };
+
   const std::unique_ptr<folly::IOBuf> dictionary_;
   int compressionLevel_{1};
 
@@ -8,6 +8,30 @@
 #include "CarbonProtocolReader.h"
 
 namespace carbon {
+
+namespace {
+
+/**
+ * Size of a container item of the given type on the wire, or 0 if it is
+ * not fixed. Booleans in containers take a byte each.
+ */
+size_t fixedItemSize(const FieldType fieldType) {
+  switch (fieldType) {
+    case FieldType::True:
+    case FieldType::False:
+    case FieldType::Int8:
+      return 1;
+    case FieldType::Float:
+      return sizeof(float);
+    case FieldType::Double:
+      return sizeof(double);
+    default:
+      return 0;
+  }
+}
+
+} // anonymous
+
 void CarbonProtocolReader::skipLinearContainer() {
   const auto pr = readLinearContainerFieldSizeAndInnerType();
   skipLinearContainerItems(pr);
@@ -17,8 +41,12 @@ void CarbonProtocolReader::skipLinearContainerItems(
     std::pair<FieldType, uint32_t> pr) {
   const auto fieldType = pr.first;
   const auto len = pr.second;
+  if (const auto itemSize = fixedItemSize(fieldType)) {
+    cursor_.skip(itemSize * len);
+    return;
+  }
   for (uint32_t i = 0; i < len; ++i) {
-    skip(fieldType);
+    skipContainerItem(fieldType);
   }
 }
 
@@ -32,9 +60,25 @@ void CarbonProtocolReader::skipKVContainerItems(
   const auto len = pr.second;
   const auto keyType = pr.first.first;
   const auto valType = pr.first.second;
+  const auto keySize = fixedItemSize(keyType);
+  const auto valSize = fixedItemSize(valType);
+  if (keySize != 0 && valSize != 0) {
+    cursor_.skip((keySize + valSize) * len);
+    return;
+  }
   for (uint32_t i = 0; i < len; ++i) {
-    skip(keyType);
-    skip(valType);
+    skipContainerItem(keyType);
+    skipContainerItem(valType);
+  }
+}
+
+void CarbonProtocolReader::skipContainerItem(const FieldType ft) {
+  // Unlike struct fields, booleans in containers are not folded into the
+  // type and take a byte each.
+  if (ft == FieldType::True || ft == FieldType::False) {
+    cursor_.skip(1);
+  } else {
+    skip(ft);
   }
 }
 
@@ -45,31 +89,25 @@ void CarbonProtocolReader::skip(const FieldType ft) {
       break;
     }
     case FieldType::Int8: {
-      readRaw<int8_t>();
-      break;
-    }
-    case FieldType::Int16: {
-      readRaw<int16_t>();
-      break;
-    }
-    case FieldType::Int32: {
-      readRaw<int32_t>();
+      cursor_.skip(1);
       break;
     }
+    case FieldType::Int16:
+    case FieldType::Int32:
     case FieldType::Int64: {
-      readRaw<int64_t>();
+      skipVarint();
       break;
     }
     case FieldType::Double: {
-      readRaw<double>();
+      cursor_.skip(sizeof(double));
       break;
     }
     case FieldType::Float: {
-      readRaw<float>();
+      cursor_.skip(sizeof(float));
       break;
     }
     case FieldType::Binary: {
-      readRaw<std::string>();
+      cursor_.skip(readVarint<uint32_t>());
       break;
     }
     case FieldType::List: {
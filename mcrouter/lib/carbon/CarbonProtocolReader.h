@@ -15,6 +15,7 @@
 #include <type_traits>
 #include <utility>
 
+#include <folly/Likely.h>
 #include <folly/Optional.h>
 #include <folly/io/Cursor.h>
 #include <folly/io/IOBuf.h>
@@ -273,19 +274,47 @@ class CarbonProtocolReader {
     return rv;
   }
 
+  /**
+   * Skips a value of the given type without decoding or copying it.
+   */
   void skip(const FieldType fieldType);
 
+  /**
+   * Like skip(), but also returns the wire bytes of the skipped value in
+   * `buf` (sharing the underlying buffers, no copy). This allows decoding of
+   * large or rarely used values to be deferred until they are needed, with
+   * a new CarbonProtocolReader over `buf`.
+   */
+  void skipInto(const FieldType fieldType, folly::IOBuf& buf) {
+    auto start = cursor_;
+    skip(fieldType);
+    start.clone(buf, cursor_ - start);
+  }
+
  private:
   void skipLinearContainer();
   void skipLinearContainerItems(std::pair<FieldType, uint32_t> pr);
   void skipKVContainer();
   void skipKVContainerItems(
       std::pair<std::pair<FieldType, FieldType>, uint32_t> pr);
+  void skipContainerItem(const FieldType fieldType);
 
   uint8_t readByte() {
     return cursor_.template read<uint8_t>();
   }
 
+  void skipVarint() {
+    uint64_t value;
+    if (LIKELY(cursor_.length() >= sizeof(uint64_t))) {
+      if (auto len = util::decodeVarint8(cursor_.data(), value)) {
+        cursor_.skip(len);
+        return;
+      }
+    }
+    while (readByte() & 0x80) {
+    }
+  }
+
   template <class T>
   typename std::enable_if<std::numeric_limits<T>::is_integer, T>::type
   readZigzagVarint() {
@@ -308,6 +337,15 @@ class CarbonProtocolReader {
         sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8,
         "readVarint() may only be used with 16-, 32-, or 64-bit integers");
 
+    // Fast path: the varint is within the current buffer.
+    if (LIKELY(cursor_.length() >= sizeof(uint64_t))) {
+      uint64_t value;
+      if (auto len = util::decodeVarint8(cursor_.data(), value)) {
+        cursor_.skip(len);
+        return static_cast<T>(value);
+      }
+    }
+
     UnsignedT urv = 0;
     uint8_t iter = 0;
     uint8_t byte;
@@ -8,12 +8,57 @@
 #include "mcrouter/lib/carbon/CarbonQueueAppender.h"
 
 #include <cstring>
+#include <memory>
+#include <vector>
 
 namespace carbon {
 
+namespace {
+
+// Grown iovec arrays are only needed by messages with many IOBuf fields, keep
+// a few around per thread so that those don't allocate.
+constexpr size_t kMaxPooledIovecArrays{8};
+
+std::vector<std::unique_ptr<struct iovec[]>>& iovecPool() {
+  static thread_local std::vector<std::unique_ptr<struct iovec[]>> pool;
+  return pool;
+}
+
+} // anonymous
+
+bool CarbonQueueAppenderStorage::growIovecs() {
+  if (iovsCapacity_ >= kMaxIovecs) {
+    return false;
+  }
+
+  std::unique_ptr<struct iovec[]> grown;
+  auto& pool = iovecPool();
+  if (!pool.empty()) {
+    grown = std::move(pool.back());
+    pool.pop_back();
+  } else {
+    grown = std::make_unique<struct iovec[]>(kMaxIovecs);
+  }
+
+  std::memcpy(grown.get(), iovs_, nIovsUsed_ * sizeof(struct iovec));
+  iovs_ = grown.release();
+  iovsCapacity_ = kMaxIovecs;
+  return true;
+}
+
+void CarbonQueueAppenderStorage::releaseIovecsSlow() {
+  std::unique_ptr<struct iovec[]> grown(iovs_);
+  auto& pool = iovecPool();
+  if (pool.size() < kMaxPooledIovecArrays) {
+    pool.push_back(std::move(grown));
+  }
+  iovs_ = inlineIovs_;
+  iovsCapacity_ = kInlineIovecs;
+}
+
 void CarbonQueueAppenderStorage::coalesce() {
   VLOG(4) << "Out of iovecs, coalescing in Caret message serialization";
-  assert(nIovsUsed_ == kMaxIovecs);
+  assert(nIovsUsed_ == iovsCapacity_);
 
   finalizeLastIovec();
 
@@ -23,21 +68,22 @@ void CarbonQueueAppenderStorage::coalesce() {
 
   size_t newCapacity = 0;
   // coalesce() should always be triggered before writing header
-  for (size_t i = 1; i < kMaxIovecs; ++i) {
+  for (size_t i = 1; i < iovsCapacity_; ++i) {
     newCapacity += iovs_[i].iov_len;
   }
 
   auto newBuf = folly::IOBuf(folly::IOBuf::CREATE, newCapacity);
 
-  for (size_t i = 1; i < kMaxIovecs; ++i) {
+  for (size_t i = 1; i < iovsCapacity_; ++i) {
     std::memcpy(newBuf.writableTail(), iovs_[i].iov_base, iovs_[i].iov_len);
     newBuf.append(iovs_[i].iov_len);
   }
 
-  // Release old IOBufs and reset head to new large buffer
-  head_ = std::move(newBuf);
+  // Release old IOBufs and hold on to the new large buffer instead
+  iovs_[1] = {newBuf.writableData(), newBuf.length()};
   ++nIovsUsed_;
-  iovs_[1] = {const_cast<uint8_t*>(head_->data()), head_->length()};
+  releaseBufs();
+  holdBuf(std::move(newBuf));
 }
 
 } // carbon
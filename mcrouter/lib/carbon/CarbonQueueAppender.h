@@ -9,6 +9,7 @@
 
 #include <sys/uio.h>
 
+#include <memory>
 #include <type_traits>
 #include <utility>
 
@@ -33,6 +34,10 @@ class CarbonQueueAppenderStorage {
   CarbonQueueAppenderStorage& operator=(const CarbonQueueAppenderStorage&) =
       delete;
 
+  ~CarbonQueueAppenderStorage() {
+    releaseIovecs();
+  }
+
   void append(const folly::IOBuf& buf) {
     // IOBuf copy is a very expensive procedure (64 bytes object + atomic
     // operation), avoid incuring that cost for small buffers.
@@ -44,22 +49,18 @@ class CarbonQueueAppenderStorage {
 
     finalizeLastIovec();
 
-    if (nIovsUsed_ == kMaxIovecs) {
+    if (nIovsUsed_ == iovsCapacity_ && !growIovecs()) {
       coalesce();
     }
 
-    assert(nIovsUsed_ < kMaxIovecs);
+    assert(nIovsUsed_ < iovsCapacity_);
 
     struct iovec* nextIov = iovs_ + nIovsUsed_;
-    const auto nFilled = buf.fillIov(nextIov, kMaxIovecs - nIovsUsed_);
+    const auto nFilled = buf.fillIov(nextIov, iovsCapacity_ - nIovsUsed_);
 
     if (nFilled > 0) {
       nIovsUsed_ += nFilled;
-      if (!head_) {
-        head_ = buf;
-      } else {
-        head_->prependChain(buf.clone());
-      }
+      holdBuf(buf.cloneAsValue());
     } else {
       if (buf.empty()) {
         return;
@@ -72,14 +73,14 @@ class CarbonQueueAppenderStorage {
   }
 
   void push(const uint8_t* buf, size_t len) {
-    if (nIovsUsed_ == kMaxIovecs) {
+    if (nIovsUsed_ == iovsCapacity_ && !growIovecs()) {
       // In this case, it would be possible to use the last iovec if
       // canUsePreviousIov_ is true, but we simplify logic by foregoing this
       // optimization.
       coalesce();
     }
 
-    assert(nIovsUsed_ < kMaxIovecs);
+    assert(nIovsUsed_ < iovsCapacity_);
 
     if (storageIdx_ + len <= sizeof(storage_)) {
       if (!canUsePreviousIov_) {
@@ -104,7 +105,8 @@ class CarbonQueueAppenderStorage {
 
   void reset() {
     storageIdx_ = kMaxHeaderLength;
-    head_.clear();
+    releaseBufs();
+    releaseIovecs();
     // Reserve first element of iovs_ for header, which won't be filled in
     // until after body data is serialized.
     iovs_[0] = {storage_, 0};
@@ -129,6 +131,20 @@ class CarbonQueueAppenderStorage {
     return bodySize - headerOverlap_;
   }
 
+  /**
+   * @return  the largest IOBuf appended without copying (typically the value),
+   *          or nullptr if there's none.
+   */
+  const folly::IOBuf* largestHeldBuf() const {
+    const folly::IOBuf* largest = nullptr;
+    for (size_t i = 0; i < nInlineBufs_; ++i) {
+      if (!largest || inlineBufs_[i].length() > largest->length()) {
+        largest = &inlineBufs_[i];
+      }
+    }
+    return largest;
+  }
+
   // Hack: we expose headerBuf_ so users can write directly to it.
   // It is the responsibility of the user to report how much data was written
   // via reportHeaderSize().
@@ -151,8 +167,13 @@ class CarbonQueueAppenderStorage {
   }
 
  private:
-  static constexpr size_t kMaxIovecs{32};
+  // Most messages fit in kInlineIovecs. Messages with more IOBuf fields
+  // switch to a pooled array of kMaxIovecs (IOV_MAX on Linux), and only get
+  // coalesced beyond that.
+  static constexpr size_t kInlineIovecs{32};
+  static constexpr size_t kMaxIovecs{1024};
   static constexpr size_t kInlineIOBufLen{128};
+  static constexpr size_t kMaxInlineIOBufs{4};
 
   // Copied from UmbrellaProtocol.h, which will eventually die
   static constexpr size_t kMaxAdditionalFields = 3;
@@ -175,29 +196,84 @@ class CarbonQueueAppenderStorage {
   // else. The remaining iovecs are used for the message body. Note that we do
   // not share iovs_[0] with body data, even if it would be possible, e.g., we
   // do not append the CT_STRUCT (struct beginning delimiter) to iovs_[0].
-  struct iovec iovs_[kMaxIovecs];
-
-  // Chain of IOBufs used for IOBuf fields, like key and value. Note that we
-  // also maintain views into this data via iovs_.
+  // iovs_ points either to inlineIovs_ or to an array from the thread-local
+  // pool (see growIovecs()).
+  struct iovec inlineIovs_[kInlineIovecs];
+  struct iovec* iovs_{inlineIovs_};
+  size_t iovsCapacity_{kInlineIovecs};
+
+  // IOBufs used for IOBuf fields, like key and value. Note that we also
+  // maintain views into this data via iovs_. The first kMaxInlineIOBufs are
+  // held by value, so that serializing a typical request (key + value) only
+  // bumps refcounts and doesn't heap-allocate IOBuf objects. Any further
+  // IOBufs are chained to head_.
+  folly::IOBuf inlineBufs_[kMaxInlineIOBufs];
+  size_t nInlineBufs_{0};
   folly::Optional<folly::IOBuf> head_;
 
+  void holdBuf(folly::IOBuf&& buf) {
+    if (nInlineBufs_ < kMaxInlineIOBufs) {
+      inlineBufs_[nInlineBufs_++] = std::move(buf);
+    } else if (!head_) {
+      head_ = std::move(buf);
+    } else {
+      head_->prependChain(std::make_unique<folly::IOBuf>(std::move(buf)));
+    }
+  }
+
+  void releaseBufs() {
+    for (size_t i = 0; i < nInlineBufs_; ++i) {
+      inlineBufs_[i] = folly::IOBuf();
+    }
+    nInlineBufs_ = 0;
+    head_.clear();
+  }
+
   FOLLY_NOINLINE void appendNoInline(const folly::IOBuf& buf) {
     append(buf);
   }
 
+  /**
+   * Moves iovs_ to a kMaxIovecs array from the thread-local pool.
+   *
+   * @return  false if iovs_ is already that big.
+   */
+  bool growIovecs();
+
+  /**
+   * Returns the array taken by growIovecs() (if any) to the pool, and points
+   * iovs_ back to inlineIovs_. Doesn't preserve the contents.
+   */
+  void releaseIovecs() {
+    if (iovs_ != inlineIovs_) {
+      releaseIovecsSlow();
+    }
+  }
+
+  void releaseIovecsSlow();
+
   FOLLY_NOINLINE void appendSlow(const folly::IOBuf& buf) {
+    // The chain didn't fit in the remaining iovecs, first try with more
+    // of them.
+    if (growIovecs()) {
+      const auto nFilled =
+          buf.fillIov(iovs_ + nIovsUsed_, iovsCapacity_ - nIovsUsed_);
+      if (nFilled > 0) {
+        nIovsUsed_ += nFilled;
+        holdBuf(buf.cloneAsValue());
+        return;
+      }
+    }
+
     struct iovec* nextIov = iovs_ + nIovsUsed_;
     auto bufCopy = buf;
     bufCopy.coalesce();
-    const auto nFilledRetry = bufCopy.fillIov(nextIov, kMaxIovecs - nIovsUsed_);
+    const auto nFilledRetry =
+        bufCopy.fillIov(nextIov, iovsCapacity_ - nIovsUsed_);
     assert(nFilledRetry == 1);
     (void)nFilledRetry;
     ++nIovsUsed_;
-    if (!head_) {
-      head_ = std::move(bufCopy);
-    } else {
-      head_->prependChain(bufCopy.clone());
-    }
+    holdBuf(std::move(bufCopy));
   }
 
   void finalizeLastIovec() {
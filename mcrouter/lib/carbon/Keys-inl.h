@@ -39,23 +39,49 @@ Keys<Storage>& Keys<Storage>::operator=(Keys<Storage>&& other) noexcept {
   return *this;
 }
 
+template <class Storage>
+void Keys<Storage>::copyInline(const Keys<Storage>& other, std::true_type) {
+  inline_ = other.inline_;
+  const auto delta = inline_.data - other.inline_.data;
+  const auto begin = other.routingPrefix_.begin() + delta;
+  key_ = folly::IOBuf(
+      folly::IOBuf::WRAP_BUFFER,
+      begin,
+      other.keyWithoutRoute_.end() - other.routingPrefix_.begin());
+  keyWithoutRoute_.reset(
+      other.keyWithoutRoute_.begin() + delta, other.keyWithoutRoute_.size());
+  routingPrefix_.reset(begin, other.routingPrefix_.size());
+  routingKey_.reset(
+      other.routingKey_.begin() + delta, other.routingKey_.size());
+  routingKeyHash_ = other.routingKeyHash_;
+  hasSpaceOrCtrl_ = other.hasSpaceOrCtrl_;
+  copyMemoizedHashes(other);
+}
+
 template <class Storage>
 void Keys<Storage>::update() {
   const folly::StringPiece key = fullKey();
   keyWithoutRoute_ = key;
   routingPrefix_.reset(key.begin(), 0);
-  if (!key.empty() && *key.begin() == '/') {
-    size_t pos = 1;
-    for (int i = 0; i < 2; ++i) {
-      pos = key.find('/', pos);
-      if (pos == std::string::npos) {
+  hasSpaceOrCtrl_ = false;
+  // One pass finds both the end of the routing prefix ("/region/cluster/")
+  // and whether the key has spaces or control characters. The two don't
+  // overlap: '/' is neither.
+  const bool maybeRouted = !key.empty() && *key.begin() == '/';
+  int slashesLeft = maybeRouted ? 2 : 0;
+  for (size_t i = maybeRouted ? 1 : 0; i < key.size(); ++i) {
+    const char c = key[i];
+    if (UNLIKELY(isSpaceOrCtrl(c))) {
+      hasSpaceOrCtrl_ = true;
+      if (slashesLeft == 0) {
+        break;
+      }
+    } else if (slashesLeft > 0 && c == '/' && --slashesLeft == 0) {
+      keyWithoutRoute_.advance(i + 1);
+      routingPrefix_.reset(key.begin(), i + 1);
+      if (hasSpaceOrCtrl_) {
         break;
       }
-      ++pos;
-    }
-    if (pos != std::string::npos) {
-      keyWithoutRoute_.advance(pos);
-      routingPrefix_.reset(key.begin(), pos);
     }
   }
   routingKey_ = keyWithoutRoute_;
@@ -71,6 +97,7 @@ void Keys<Storage>::update() {
     }
   }
   routingKeyHash_ = 0;
+  resetMemoizedHashes();
 }
 
 } // carbon
@@ -7,10 +7,12 @@
  */
 #pragma once
 
+#include <cstring>
 #include <iostream>
 #include <string>
 #include <type_traits>
 
+#include <folly/Likely.h>
 #include <folly/Range.h>
 #include <folly/hash/SpookyHashV2.h>
 #include <folly/io/IOBuf.h>
@@ -30,6 +32,47 @@ inline folly::IOBuf makeKey<folly::IOBuf>(folly::StringPiece sp) {
   return folly::IOBuf(folly::IOBuf::COPY_BUFFER, sp.data(), sp.size());
 }
 
+namespace detail {
+
+/**
+ * Keys up to this size set from a StringPiece are stored in the Keys object
+ * itself instead of a heap allocated IOBuf.
+ */
+constexpr size_t kMaxInlineKeySize = 64;
+
+// std::string has its own small string optimization.
+template <class Storage>
+struct KeyInlineBuffer {
+  bool contains(const char*) const {
+    return false;
+  }
+
+  void assign(std::string& key, folly::StringPiece sp) {
+    key.assign(sp.data(), sp.size());
+  }
+};
+
+template <>
+struct KeyInlineBuffer<folly::IOBuf> {
+  char data[kMaxInlineKeySize];
+
+  bool contains(const char* p) const {
+    return p >= data && p <= data + kMaxInlineKeySize;
+  }
+
+  void assign(folly::IOBuf& key, folly::StringPiece sp) {
+    if (sp.size() > kMaxInlineKeySize) {
+      key = makeKey<folly::IOBuf>(sp);
+      return;
+    }
+    // sp may point into data already.
+    std::memmove(data, sp.data(), sp.size());
+    key = folly::IOBuf(folly::IOBuf::WRAP_BUFFER, data, sp.size());
+  }
+};
+
+} // detail
+
 /**
  * Holds all the references to the various parts of the key.
  *
@@ -48,13 +91,12 @@ class Keys {
     update();
   }
 
-  explicit Keys(folly::StringPiece sp) : key_(makeKey<Storage>(sp)) {
+  explicit Keys(folly::StringPiece sp) {
+    inline_.assign(key_, sp);
     update();
   }
 
-  explicit Keys(const char* key) : key_(makeKey<Storage>(key)) {
-    update();
-  }
+  explicit Keys(const char* key) : Keys(folly::StringPiece(key)) {}
 
   Keys(const Keys& other);
   Keys& operator=(const Keys& other);
@@ -74,7 +116,7 @@ class Keys {
   }
 
   Keys& operator=(folly::StringPiece key) {
-    key_ = makeKey<Storage>(key);
+    inline_.assign(key_, key);
     update();
     return *this;
   }
@@ -113,14 +155,50 @@ class Keys {
     return routingKeyHash_;
   }
 
+  /**
+   * Returns hashFunc(routingKey()), memoized under hashId, so that routes
+   * hashing the same key the same way (e.g. a pool and its shadow, or a
+   * retry into the same pool) compute it once per request. The last
+   * kNumMemoizedHashes results are kept.
+   *
+   * hashId must uniquely identify the hash function and all of its
+   * parameters (salt, pool size, ...). 0 is reserved.
+   */
+  template <class HashFunc>
+  uint32_t memoizedRoutingKeyHash(uint64_t hashId, HashFunc&& hashFunc) const {
+    for (const auto& entry : memoizedHashes_) {
+      if (entry.hashId == hashId) {
+        return entry.hash;
+      }
+    }
+    auto& entry = memoizedHashes_[nextMemoizedHash_];
+    nextMemoizedHash_ = (nextMemoizedHash_ + 1) % kNumMemoizedHashes;
+    entry.hash = hashFunc(routingKey());
+    entry.hashId = hashId;
+    return entry.hash;
+  }
+
   bool hasHashStop() const {
     return routingKey_.size() != keyWithoutRoute_.size();
   }
 
+  /**
+   * True if the key has a space or a control character. Found in the same
+   * pass over the key that looks for the routing prefix, so that validating
+   * the key (see isKeyValid() in McKey.h) doesn't scan it again.
+   */
+  bool hasSpaceOrCtrl() const {
+    return hasSpaceOrCtrl_;
+  }
+
   // Hack to save some CPU in DestinationRoute. Avoid if possible.
   void stripRoutingPrefix() {
     trimStart(routingPrefix().size());
     routingPrefix_.reset(fullKey().begin(), 0);
+    if (hasSpaceOrCtrl_) {
+      // Might have been in the prefix.
+      hasSpaceOrCtrl_ = findSpaceOrCtrl(fullKey()) != std::string::npos;
+    }
   }
 
   // TODO(jmswen) Would be nice not to expose raw storage. Only needed in
@@ -130,15 +208,40 @@ class Keys {
   }
 
  private:
+  static constexpr size_t kNumMemoizedHashes = 2;
+
+  struct MemoizedHash {
+    uint64_t hashId{0};
+    uint32_t hash{0};
+  };
+
   static constexpr bool usingStringStorage =
       std::is_same<Storage, std::string>::value;
 
   void update();
 
+  static bool isSpaceOrCtrl(char c) {
+    // iscntrl(c) || isspace(c)
+    return static_cast<unsigned char>(c) <= 0x20 ||
+        static_cast<unsigned char>(c) == 0x7F;
+  }
+
+  static size_t findSpaceOrCtrl(folly::StringPiece sp) {
+    for (size_t i = 0; i < sp.size(); ++i) {
+      if (isSpaceOrCtrl(sp[i])) {
+        return i;
+      }
+    }
+    return std::string::npos;
+  }
+
   // Assumes that this->key_ has been set to the desired value that StringPiece
-  // members of *this should point into.
+  // members of *this should point into, unless other stores its key inline.
   void initStringPieces(const Keys& other) {
-    if (usingStringStorage &&
+    if (other.isInline()) {
+      copyInline(other, std::is_same<Storage, folly::IOBuf>());
+    } else if (
+        usingStringStorage &&
         reinterpret_cast<const char*>(key_.data()) !=
             other.routingPrefix().begin()) {
       update();
@@ -147,11 +250,35 @@ class Keys {
     }
   }
 
+  // routingPrefix_ always starts at the beginning of the key, even after
+  // stripRoutingPrefix(), and is valid even if other.key_ was moved from.
+  bool isInline() const {
+    return inline_.contains(routingPrefix_.begin());
+  }
+
+  void copyInline(const Keys& other, std::true_type /* IOBuf storage */);
+  void copyInline(const Keys&, std::false_type) {}
+
   void copyStringPieces(const Keys& other) {
     keyWithoutRoute_ = other.keyWithoutRoute_;
     routingPrefix_ = other.routingPrefix_;
     routingKey_ = other.routingKey_;
     routingKeyHash_ = other.routingKeyHash_;
+    hasSpaceOrCtrl_ = other.hasSpaceOrCtrl_;
+    copyMemoizedHashes(other);
+  }
+
+  void copyMemoizedHashes(const Keys& other) {
+    for (size_t i = 0; i < kNumMemoizedHashes; ++i) {
+      memoizedHashes_[i] = other.memoizedHashes_[i];
+    }
+    nextMemoizedHash_ = other.nextMemoizedHash_;
+  }
+
+  void resetMemoizedHashes() {
+    for (auto& entry : memoizedHashes_) {
+      entry = MemoizedHash();
+    }
   }
 
   static size_t size(const folly::IOBuf& buf) {
@@ -177,10 +304,14 @@ class Keys {
   Storage key_;
 
  private:
+  detail::KeyInlineBuffer<Storage> inline_;
   folly::StringPiece keyWithoutRoute_;
   folly::StringPiece routingPrefix_;
   folly::StringPiece routingKey_;
   mutable uint32_t routingKeyHash_{0};
+  bool hasSpaceOrCtrl_{false};
+  mutable uint8_t nextMemoizedHash_{0};
+  mutable MemoizedHash memoizedHashes_[kNumMemoizedHashes];
 };
 
 } // carbon
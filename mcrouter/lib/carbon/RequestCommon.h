@@ -7,6 +7,7 @@
  */
 #pragma once
 
+#include <cstdint>
 #include <utility>
 
 #include "mcrouter/lib/Ref.h"
@@ -22,7 +23,8 @@ class RequestCommon {
 #ifndef LIBMC_FBTRACE_DISABLE
   RequestCommon() = default;
 
-  RequestCommon(const RequestCommon& other) {
+  RequestCommon(const RequestCommon& other)
+      : timeoutBudgetMs_(other.timeoutBudgetMs_) {
     if (other.fbtraceInfo()) {
       fbtraceInfo_ =
           McFbtraceRef::moveRef(mc_fbtrace_info_deep_copy(other.fbtraceInfo()));
@@ -66,6 +68,18 @@ class RequestCommon {
 #endif
   }
 
+  /**
+   * Time in ms the sender of this request is going to wait for the reply, as
+   * received over the wire. 0 if unknown.
+   */
+  uint32_t timeoutBudgetMs() const {
+    return timeoutBudgetMs_;
+  }
+
+  void setTimeoutBudgetMs(uint32_t timeoutBudgetMs) {
+    timeoutBudgetMs_ = timeoutBudgetMs;
+  }
+
 #ifndef LIBMC_FBTRACE_DISABLE
   mc_fbtrace_info_s* fbtraceInfo() const {
     return fbtraceInfo_.get();
@@ -82,6 +96,8 @@ class RequestCommon {
  private:
   static constexpr size_t kTraceIdSize = 11;
 
+  uint32_t timeoutBudgetMs_{0};
+
 #ifndef LIBMC_FBTRACE_DISABLE
   struct McFbtraceRefPolicy {
     struct Deleter {
@@ -7,6 +7,16 @@
  */
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <folly/lang/Bits.h>
+
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
 namespace carbon {
 namespace util {
 
@@ -34,5 +44,42 @@ inline int64_t unzigzag(const uint64_t i) {
   return (i >> 1) ^ -(i & 1);
 }
 
+/**
+ * Decodes a varint from the 8 bytes at p, which must all be readable.
+ * All 8 bytes are handled at once: the 7-bit groups are gathered with pext
+ * if the build targets BMI2, or with shifts and masks otherwise.
+ *
+ * @return  number of bytes the varint takes, or 0 if it is longer than
+ *          8 bytes (values of 56 bits and more), in which case callers
+ *          need to decode it a byte at a time.
+ */
+inline size_t decodeVarint8(const uint8_t* p, uint64_t& value) {
+  uint64_t word;
+  std::memcpy(&word, p, sizeof(word));
+  word = folly::Endian::little(word);
+  const uint64_t stops = ~word & 0x8080808080808080ULL;
+  if (stops == 0) {
+    return 0;
+  }
+  // The stop bit is the top bit of the varint's last byte.
+  const size_t bits = __builtin_ctzll(stops) + 1;
+  if (bits < 64) {
+    word &= (uint64_t(1) << bits) - 1;
+  }
+#ifdef __BMI2__
+  value = _pext_u64(word, 0x7f7f7f7f7f7f7f7fULL);
+#else
+  word &= 0x7f7f7f7f7f7f7f7fULL;
+  word = ((word & 0x7f007f007f007f00ULL) >> 1) |
+      (word & 0x007f007f007f007fULL);
+  word = ((word & 0x3fff00003fff0000ULL) >> 2) |
+      (word & 0x00003fff00003fffULL);
+  word = ((word & 0x0fffffff00000000ULL) >> 4) |
+      (word & 0x000000000fffffffULL);
+  value = word;
+#endif
+  return bits / 8;
+}
+
 } // util
 } // carbon
@@ -9,6 +9,9 @@
 #include <memory>
 #include <utility>
 
+#include <folly/AtomicIntrusiveLinkedList.h>
+#include <folly/Function.h>
+
 namespace carbon {
 namespace detail {
 
@@ -34,11 +37,39 @@ class Client {
 
   void closeNow();
 
+  /**
+   * Queues a task to be run on a new fiber on the client's thread. Can be
+   * called from any thread.
+   *
+   * @return  true if the queue was empty, in which case the caller must
+   *          schedule drainRequests() on the client's thread.
+   */
+  bool enqueueRequest(folly::Function<void()> task) {
+    return queue_.insertHead(new QueuedRequest(std::move(task)));
+  }
+
+  /**
+   * Starts a fiber for every queued task. Must be called from a fiber on the
+   * client's thread.
+   */
+  void drainRequests();
+
  private:
+  struct QueuedRequest {
+    explicit QueuedRequest(folly::Function<void()> t) : task(std::move(t)) {}
+
+    folly::Function<void()> task;
+    folly::AtomicIntrusiveLinkedListHook<QueuedRequest> hook;
+  };
+
   const facebook::memcache::ConnectionOptions connectionOptions_;
   const ExternalCarbonConnectionImpl::Options options_;
   facebook::memcache::AsyncMcClient client_;
   counting_sem_t outstandingReqsSem_;
+  // Requests handed off by other threads, that haven't been started yet.
+  // Only the request that finds the queue empty wakes up the client's thread,
+  // so a burst of requests costs a single handoff.
+  folly::AtomicIntrusiveLinkedList<QueuedRequest, &QueuedRequest::hook> queue_;
 };
 
 class ThreadInfo {
@@ -76,13 +107,14 @@ class ExternalCarbonConnectionImpl::Impl {
 
   template <class Request, class F>
   void sendRequestOne(const Request& req, F&& f) {
-    auto threadInfo = threadInfo_.lock();
+    auto& conn = pickConnection();
+    auto threadInfo = conn.threadInfo.lock();
     if (!threadInfo) {
       throw CarbonConnectionRecreateException(
           "Singleton<ThreadPool> was destroyed!");
     }
 
-    auto client = client_.lock();
+    auto client = conn.client.lock();
     assert(client);
 
     if (client->limitRequests(1) == 0) {
@@ -90,8 +122,11 @@ class ExternalCarbonConnectionImpl::Impl {
       return;
     }
 
-    threadInfo->addTaskRemote(
-        [ clientWeak = client_, &req, f = std::forward<F>(f) ]() mutable {
+    enqueue(
+        *threadInfo,
+        *client,
+        conn.client,
+        [ clientWeak = conn.client, &req, f = std::forward<F>(f) ]() mutable {
           auto cl = clientWeak.lock();
           if (!cl) {
             folly::fibers::runInMainContext(
@@ -113,13 +148,14 @@ class ExternalCarbonConnectionImpl::Impl {
   void sendRequestMulti(
       std::vector<std::reference_wrapper<const Request>>&& reqs,
       F&& f) {
-    auto threadInfo = threadInfo_.lock();
+    auto& conn = pickConnection();
+    auto threadInfo = conn.threadInfo.lock();
     if (!threadInfo) {
       throw CarbonConnectionRecreateException(
           "Singleton<ThreadPool> was destroyed!");
     }
 
-    auto cl = client_.lock();
+    auto cl = conn.client.lock();
     assert(cl);
 
     auto ctx =
@@ -138,8 +174,11 @@ class ExternalCarbonConnectionImpl::Impl {
         break;
       }
 
-      threadInfo->addTaskRemote(
-          [ clientWeak = client_, ctx, i, num, f ]() mutable {
+      enqueue(
+          *threadInfo,
+          *cl,
+          conn.client,
+          [ clientWeak = conn.client, ctx, i, num, f ]() mutable {
             auto client = clientWeak.lock();
             if (!client) {
               folly::fibers::runInMainContext([&ctx, i, num, &f]() mutable {
@@ -176,8 +215,29 @@ class ExternalCarbonConnectionImpl::Impl {
   }
 
  private:
-  std::weak_ptr<detail::ThreadInfo> threadInfo_;
-  std::weak_ptr<detail::Client> client_;
+  struct Connection {
+    std::weak_ptr<detail::ThreadInfo> threadInfo;
+    std::weak_ptr<detail::Client> client;
+  };
+
+  std::vector<Connection> connections_;
+
+  Connection& pickConnection();
+
+  template <class F>
+  void enqueue(
+      detail::ThreadInfo& threadInfo,
+      detail::Client& client,
+      std::weak_ptr<detail::Client> clientWeak,
+      F&& task) {
+    if (client.enqueueRequest(std::forward<F>(task))) {
+      threadInfo.addTaskRemote([clientWeak = std::move(clientWeak)] {
+        if (auto c = clientWeak.lock()) {
+          c->drainRequests();
+        }
+      });
+    }
+  }
 };
 
 template <class Request>
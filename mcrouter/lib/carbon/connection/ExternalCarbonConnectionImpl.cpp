@@ -7,6 +7,7 @@
  */
 #include "ExternalCarbonConnectionImpl.h"
 
+#include <algorithm>
 #include <memory>
 #include <mutex>
 #include <thread>
@@ -16,6 +17,7 @@
 
 #include <folly/ScopeGuard.h>
 #include <folly/Singleton.h>
+#include <folly/ThreadId.h>
 #include <folly/fibers/EventBaseLoopController.h>
 #include <folly/fibers/FiberManager.h>
 #include <folly/io/async/EventBaseManager.h>
@@ -47,6 +49,19 @@ Client::Client(
 
 Client::~Client() {
   closeNow();
+  // Fail requests that were never started. The client can't be locked
+  // anymore, so the tasks just report an error to their callbacks.
+  queue_.sweep([](QueuedRequest* request) {
+    request->task();
+    delete request;
+  });
+}
+
+void Client::drainRequests() {
+  queue_.sweep([](QueuedRequest* request) {
+    folly::fibers::addTask(std::move(request->task));
+    delete request;
+  });
 }
 
 size_t Client::limitRequests(size_t requestsCount) {
@@ -180,42 +195,68 @@ ExternalCarbonConnectionImpl::Impl::Impl(
     ExternalCarbonConnectionImpl::Options options) {
   auto pool = threadPool.try_get();
 
-  auto info = pool->createClient(connectionOptions, options);
-  client_ = info.first;
-  threadInfo_ = info.second;
+  // The pool assigns threads round robin, so consecutive clients end up on
+  // different threads.
+  const size_t numConnections = std::max<size_t>(
+      1,
+      std::min<size_t>(
+          options.numConnections,
+          FLAGS_cacheclient_external_connection_threads));
+  connections_.reserve(numConnections);
+  for (size_t i = 0; i < numConnections; ++i) {
+    auto info = pool->createClient(connectionOptions, options);
+    connections_.push_back(Connection{info.second, info.first});
+  }
 }
 
 ExternalCarbonConnectionImpl::Impl::~Impl() {
-  if (auto threadInfo = threadInfo_.lock()) {
-    threadInfo->releaseClient(client_);
+  for (auto& conn : connections_) {
+    if (auto threadInfo = conn.threadInfo.lock()) {
+      threadInfo->releaseClient(conn.client);
+    }
   }
 }
 
-bool ExternalCarbonConnectionImpl::Impl::healthCheck() {
-  folly::fibers::Baton baton;
-  bool ret = false;
-
-  auto clientWeak = client_;
-  auto threadInfo = threadInfo_.lock();
-  if (!threadInfo) {
-    throw CarbonConnectionRecreateException(
-        "Singleton<ThreadPool> was destroyed!");
+ExternalCarbonConnectionImpl::Impl::Connection&
+ExternalCarbonConnectionImpl::Impl::pickConnection() {
+  if (connections_.size() == 1) {
+    return connections_[0];
   }
+  // Pin each calling thread to a connection, so that requests from a thread
+  // are sent in order.
+  return connections_[folly::getCurrentThreadID() % connections_.size()];
+}
 
-  threadInfo->addTaskRemote([clientWeak, &baton, &ret]() {
-    auto client = clientWeak.lock();
-    if (!client) {
-      baton.post();
-      return;
+bool ExternalCarbonConnectionImpl::Impl::healthCheck() {
+  for (auto& conn : connections_) {
+    folly::fibers::Baton baton;
+    bool ret = false;
+
+    auto clientWeak = conn.client;
+    auto threadInfo = conn.threadInfo.lock();
+    if (!threadInfo) {
+      throw CarbonConnectionRecreateException(
+          "Singleton<ThreadPool> was destroyed!");
     }
 
-    auto reply = client->sendRequest(facebook::memcache::McVersionRequest());
-    ret = !facebook::memcache::isErrorResult(reply.result());
-    baton.post();
-  });
+    threadInfo->addTaskRemote([clientWeak, &baton, &ret]() {
+      auto client = clientWeak.lock();
+      if (!client) {
+        baton.post();
+        return;
+      }
 
-  baton.wait();
-  return ret;
+      auto reply = client->sendRequest(facebook::memcache::McVersionRequest());
+      ret = !facebook::memcache::isErrorResult(reply.result());
+      baton.post();
+    });
+
+    baton.wait();
+    if (!ret) {
+      return false;
+    }
+  }
+  return true;
 }
 
 ExternalCarbonConnectionImpl::ExternalCarbonConnectionImpl(
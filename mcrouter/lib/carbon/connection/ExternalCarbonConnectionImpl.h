@@ -24,8 +24,13 @@ class ExternalCarbonConnectionImpl {
   struct Options {
     Options() {}
 
+    // Limit on outstanding requests, per connection.
     size_t maxOutstanding{0};
     bool maxOutstandingError{false};
+    // Number of connections to open to the destination, each of them on a
+    // different I/O thread (up to --cacheclient_external_connection_threads).
+    // All requests sent from a given thread go through the same connection.
+    size_t numConnections{1};
   };
 
   explicit ExternalCarbonConnectionImpl(
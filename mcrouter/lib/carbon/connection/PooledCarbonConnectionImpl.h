@@ -7,6 +7,7 @@
  */
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -16,6 +17,7 @@
 #include <folly/Random.h>
 
 #include "mcrouter/lib/CacheClientStats.h"
+#include "mcrouter/lib/carbon/RequestReplyUtil.h"
 #include "mcrouter/lib/carbon/connection/CarbonConnectionUtil.h"
 
 namespace carbon {
@@ -23,23 +25,74 @@ namespace carbon {
 template <class If>
 class PooledCarbonConnectionImpl {
  public:
+  struct Options {
+    Options() {}
+
+    // Send the requests of a batch one by one, spread over the connections.
+    bool splitBatchedRequests{false};
+    // Send every request over the connection with the fewer outstanding
+    // requests (sent through this pool) of two randomly chosen ones, instead
+    // of a random one.
+    bool leastLoaded{false};
+    // If > 0, requests with values of at least this many bytes are sent over
+    // the first largeRequestConnections connections, and all other requests
+    // over the rest of them, so that small requests don't wait behind big
+    // values. Ignored if there aren't enough connections.
+    size_t largeRequestThreshold{0};
+    size_t largeRequestConnections{1};
+  };
+
   explicit PooledCarbonConnectionImpl(
       std::vector<std::unique_ptr<If>> connections,
       bool splitBatchedRequests = false)
+      : PooledCarbonConnectionImpl(
+            std::move(connections),
+            makeOptions(splitBatchedRequests)) {}
+
+  PooledCarbonConnectionImpl(
+      std::vector<std::unique_ptr<If>> connections,
+      Options options)
       : connections_(std::move(connections)),
-        splitBatchedRequests_(splitBatchedRequests) {}
+        options_(std::move(options)),
+        segregateLargeRequests_(
+            options_.largeRequestThreshold > 0 &&
+            options_.largeRequestConnections > 0 &&
+            options_.largeRequestConnections < connections_.size()) {
+    if (options_.leastLoaded) {
+      outstanding_ =
+          std::make_shared<std::vector<std::atomic<size_t>>>(
+              connections_.size());
+    }
+  }
 
   template <class Request>
   void sendRequestOne(const Request& req, RequestCb<Request> cb) {
-    connections_[folly::Random::rand32(connections_.size())]->sendRequestOne(
-        req, std::move(cb));
+    const auto clientId = pickConnection(req);
+    connections_[clientId]->sendRequestOne(
+        req, trackOutstanding(clientId, 1, std::move(cb)));
   }
 
   template <class Request>
   void sendRequestMulti(
       std::vector<std::reference_wrapper<const Request>>&& reqs,
       RequestCb<Request> cb) {
-    if (splitBatchedRequests_) {
+    if (reqs.empty()) {
+      return;
+    }
+    if (options_.leastLoaded || segregateLargeRequests_) {
+      if (options_.splitBatchedRequests) {
+        for (const Request& req : reqs) {
+          const auto clientId = pickConnection(req);
+          connections_[clientId]->sendRequestOne(
+              req, trackOutstanding(clientId, 1, cb));
+        }
+      } else {
+        const auto clientId = pickConnection(reqs.front().get());
+        const auto n = reqs.size();
+        connections_[clientId]->sendRequestMulti(
+            std::move(reqs), trackOutstanding(clientId, n, std::move(cb)));
+      }
+    } else if (options_.splitBatchedRequests) {
       auto clientId = folly::Random::rand32(connections_.size());
       for (const Request& req : reqs) {
         connections_[clientId]->sendRequestOne(req, cb);
@@ -78,12 +131,67 @@ class PooledCarbonConnectionImpl {
     for (size_t i = 0; i < connections_.size(); ++i) {
       newConnections.push_back(connections_[i]->recreate());
     }
-    return std::make_unique<Impl>(
-        std::move(newConnections), splitBatchedRequests_);
+    return std::make_unique<Impl>(std::move(newConnections), options_);
   }
 
  private:
   std::vector<std::unique_ptr<If>> connections_;
-  bool splitBatchedRequests_;
+  const Options options_;
+  const bool segregateLargeRequests_;
+  // Requests sent over each connection that haven't got a reply yet. Shared
+  // with the callbacks, which may outlive the pool. Only set if
+  // options_.leastLoaded.
+  std::shared_ptr<std::vector<std::atomic<size_t>>> outstanding_;
+
+  static Options makeOptions(bool splitBatchedRequests) {
+    Options options;
+    options.splitBatchedRequests = splitBatchedRequests;
+    return options;
+  }
+
+  template <class Request>
+  size_t pickConnection(const Request& req) {
+    size_t begin = 0;
+    size_t end = connections_.size();
+    if (segregateLargeRequests_) {
+      const auto* value = valuePtrUnsafe(req);
+      if (value &&
+          value->computeChainDataLength() >= options_.largeRequestThreshold) {
+        end = options_.largeRequestConnections;
+      } else {
+        begin = options_.largeRequestConnections;
+      }
+    }
+
+    const size_t n = end - begin;
+    const size_t first = begin + folly::Random::rand32(n);
+    if (!outstanding_ || n == 1) {
+      return first;
+    }
+    // Power of two choices.
+    size_t second = begin + folly::Random::rand32(n - 1);
+    if (second >= first) {
+      ++second;
+    }
+    const auto& outstanding = *outstanding_;
+    return outstanding[second].load(std::memory_order_relaxed) <
+            outstanding[first].load(std::memory_order_relaxed)
+        ? second
+        : first;
+  }
+
+  template <class Request>
+  RequestCb<Request>
+  trackOutstanding(size_t clientId, size_t numRequests, RequestCb<Request> cb) {
+    if (!outstanding_) {
+      return cb;
+    }
+    (*outstanding_)[clientId].fetch_add(numRequests, std::memory_order_relaxed);
+    return [ outstanding = outstanding_, clientId, cb = std::move(cb) ](
+        const Request& req, facebook::memcache::ReplyT<Request>&& reply) {
+      (*outstanding)[clientId].fetch_sub(1, std::memory_order_relaxed);
+      cb(req, std::move(reply));
+    };
+  }
 };
 } // carbon
@@ -8,6 +8,7 @@
 #include <sys/uio.h>
 
 #include <cstring>
+#include <memory>
 #include <string>
 
 #include <gtest/gtest.h>
@@ -55,6 +56,7 @@ void checkKeyFilledProperly(const Key& key) {
   EXPECT_EQ("abcdefghijklmnopqrstuvwxyz", key.routingKey());
   EXPECT_NE(0, key.routingKeyHash());
   EXPECT_TRUE(key.hasHashStop());
+  EXPECT_FALSE(key.hasSpaceOrCtrl());
 }
 
 } // anonymous
@@ -167,6 +169,31 @@ TEST(CarbonBasic, defaultConstructed) {
   EXPECT_EQ(0, req.flags());
 }
 
+TEST(CarbonBasic, spaceOrCtrl) {
+  TestRequest req("/region/cluster/key");
+  EXPECT_FALSE(req.key().hasSpaceOrCtrl());
+  EXPECT_EQ("/region/cluster/", req.key().routingPrefix());
+
+  req.key() = "/region/cluster/a key";
+  EXPECT_TRUE(req.key().hasSpaceOrCtrl());
+  EXPECT_EQ("/region/cluster/", req.key().routingPrefix());
+  EXPECT_EQ("a key", req.key().keyWithoutRoute());
+
+  req.key() = "/reg\tion/cluster/key";
+  EXPECT_TRUE(req.key().hasSpaceOrCtrl());
+  EXPECT_EQ("/reg\tion/cluster/", req.key().routingPrefix());
+  req.key().stripRoutingPrefix();
+  EXPECT_FALSE(req.key().hasSpaceOrCtrl());
+
+  req.key() = "key\x7f";
+  EXPECT_TRUE(req.key().hasSpaceOrCtrl());
+  TestRequest copy(req);
+  EXPECT_TRUE(copy.key().hasSpaceOrCtrl());
+
+  req.key() = "key";
+  EXPECT_FALSE(req.key().hasSpaceOrCtrl());
+}
+
 TEST(CarbonBasic, setAndGet) {
   TestRequest req(kKeyLiteral);
   TestRequestStringKey req2(kKeyLiteral);
@@ -529,6 +556,74 @@ TEST(CarbonTest, keysIobuf) {
   }
 }
 
+TEST(CarbonTest, keysIobufInline) {
+  // Small keys are stored in the request itself.
+  auto req = std::make_unique<TestRequest>(kKeyLiteral);
+  EXPECT_FALSE(req->key().raw().isManagedOne());
+  checkKeyFilledProperly(req->key());
+
+  // Copies and moves must not point into the original request.
+  TestRequest copy(*req);
+  TestRequest moved(std::move(*req));
+  TestRequest assigned;
+  assigned = moved;
+  TestRequest stripped(moved);
+  stripped.key().stripRoutingPrefix();
+  const auto hash = moved.key().routingKeyHash();
+  req.reset();
+  checkKeyFilledProperly(copy.key());
+  checkKeyFilledProperly(assigned.key());
+  TestRequest strippedCopy(stripped);
+  stripped.key() = "";
+  EXPECT_EQ(
+      "abcdefghijklmnopqrstuvwxyz|#|afterhashstop",
+      strippedCopy.key().fullKey());
+  EXPECT_EQ("", strippedCopy.key().routingPrefix());
+  EXPECT_EQ("abcdefghijklmnopqrstuvwxyz", strippedCopy.key().routingKey());
+  EXPECT_EQ(hash, strippedCopy.key().routingKeyHash());
+
+  // Assigning a part of the key to itself.
+  moved.key() = moved.key().routingKey();
+  EXPECT_EQ("abcdefghijklmnopqrstuvwxyz", moved.key().fullKey());
+  EXPECT_EQ(hash, moved.key().routingKeyHash());
+
+  const std::string longKey(100, 'k');
+  TestRequest longReq(longKey);
+  EXPECT_TRUE(longReq.key().raw().isManagedOne());
+  EXPECT_EQ(longKey, TestRequest(longReq).key().fullKey());
+}
+
+TEST(CarbonTest, keysMemoizedHash) {
+  TestRequest req(kKeyLiteral);
+  size_t calls = 0;
+  auto hash = [&calls](folly::StringPiece key) {
+    ++calls;
+    return static_cast<uint32_t>(key.size());
+  };
+  EXPECT_EQ(26, req.key().memoizedRoutingKeyHash(1, hash));
+  EXPECT_EQ(26, req.key().memoizedRoutingKeyHash(1, hash));
+  EXPECT_EQ(1, calls);
+  EXPECT_EQ(26, req.key().memoizedRoutingKeyHash(2, hash));
+  EXPECT_EQ(2, calls);
+
+  // Copies keep the memoized hashes.
+  TestRequest copy(req);
+  EXPECT_EQ(26, copy.key().memoizedRoutingKeyHash(1, hash));
+  EXPECT_EQ(2, calls);
+
+  // Evicts the oldest one.
+  EXPECT_EQ(26, req.key().memoizedRoutingKeyHash(3, hash));
+  EXPECT_EQ(26, req.key().memoizedRoutingKeyHash(2, hash));
+  EXPECT_EQ(3, calls);
+  EXPECT_EQ(26, req.key().memoizedRoutingKeyHash(1, hash));
+  EXPECT_EQ(4, calls);
+
+  // Changing the key forgets them.
+  req.key() = "abc";
+  EXPECT_EQ(3, req.key().memoizedRoutingKeyHash(1, hash));
+  EXPECT_EQ(5, calls);
+}
+
 TEST(CarbonTest, keysString) {
   {
     TestRequestStringKey req;
@@ -5,12 +5,15 @@
  *  file in the root directory of this source tree.
  *
  */
+#include <algorithm>
 #include <limits>
 #include <utility>
 #include <vector>
 
+#include <folly/io/IOBuf.h>
 #include <gtest/gtest.h>
 
+#include "mcrouter/lib/carbon/CarbonProtocolReader.h"
 #include "mcrouter/lib/carbon/Util.h"
 #include "mcrouter/lib/carbon/test/Util.h"
 
@@ -34,3 +37,107 @@ TEST(SerializedFormat, integers) {
         }
       }));
 }
+
+TEST(SerializedFormat, skip) {
+  const uint8_t bytes[] = {
+      // list<bool> of 3 items
+      0x31, 0x01, 0x02, 0x01,
+      // list<double> of 2 items
+      0x27, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+      // map<string, int64> of 1 item
+      0x01, 0x86, 0x03, 'a', 'b', 'c', 0xff, 0x01,
+      // binary
+      0x03, 'x', 'y', 'z',
+      // sentinel
+      0x7f};
+  auto buf = folly::IOBuf::wrapBuffer(bytes, sizeof(bytes));
+  carbon::CarbonProtocolReader reader(carbon::CarbonCursor(buf.get()));
+
+  reader.skip(carbon::FieldType::List);
+  reader.skip(carbon::FieldType::List);
+  reader.skip(carbon::FieldType::Map);
+  folly::IOBuf binary;
+  reader.skipInto(carbon::FieldType::Binary, binary);
+  EXPECT_EQ("\x03xyz", folly::StringPiece(binary.coalesce()));
+
+  int8_t sentinel;
+  reader.readRawInto(sentinel);
+  EXPECT_EQ(0x7f, sentinel);
+}
+
+TEST(SerializedFormat, binarySharesBuffer) {
+  // Keys and values are read without allocating: they point into the
+  // buffer the message was read into.
+  const uint8_t bytes[] = {0x03, 'a', 'b', 'c', 0x02, 'x', 'y'};
+  auto buf = folly::IOBuf::wrapBuffer(bytes, sizeof(bytes));
+  carbon::CarbonProtocolReader reader(carbon::CarbonCursor(buf.get()));
+
+  folly::IOBuf key;
+  folly::IOBuf value;
+  reader.readRawInto(key);
+  reader.readRawInto(value);
+  EXPECT_EQ("abc", folly::StringPiece(key.coalesce()));
+  EXPECT_EQ("xy", folly::StringPiece(value.coalesce()));
+  EXPECT_EQ(bytes + 1, key.data());
+  EXPECT_EQ(bytes + 5, value.data());
+  EXPECT_FALSE(key.isChained());
+  EXPECT_FALSE(value.isChained());
+}
+
+namespace {
+
+std::vector<uint8_t> encodeVarint(uint64_t value) {
+  std::vector<uint8_t> bytes;
+  while (value >= 0x80) {
+    bytes.push_back(static_cast<uint8_t>(value) | 0x80);
+    value >>= 7;
+  }
+  bytes.push_back(static_cast<uint8_t>(value));
+  return bytes;
+}
+
+} // anonymous namespace
+
+TEST(SerializedFormat, decodeVarint8) {
+  for (size_t bits = 0; bits <= 64; ++bits) {
+    // A power of two, all ones and alternating bits, bits wide.
+    const uint64_t ones = bits == 0 ? 0 : ~uint64_t(0) >> (64 - bits);
+    for (uint64_t value : {bits < 64 ? uint64_t(1) << bits : ones,
+                           ones,
+                           ones & uint64_t(0x5555555555555555)}) {
+      auto bytes = encodeVarint(value);
+      const auto len = bytes.size();
+      bytes.resize(std::max<size_t>(len, 8), 0xff);
+      uint64_t decoded = 0;
+      if (len > 8) {
+        EXPECT_EQ(0, carbon::util::decodeVarint8(bytes.data(), decoded));
+      } else {
+        EXPECT_EQ(len, carbon::util::decodeVarint8(bytes.data(), decoded));
+        EXPECT_EQ(value, decoded);
+      }
+    }
+  }
+}
+
+TEST(SerializedFormat, varintsAcrossBuffers) {
+  // Every varint both within one buffer and split between two of them.
+  const std::vector<int64_t> values = {
+      0, -1, 63, -64, 1 << 20, -(1 << 20), std::numeric_limits<int64_t>::max(),
+      std::numeric_limits<int64_t>::min()};
+  std::vector<uint8_t> bytes;
+  for (auto value : values) {
+    auto encoded = encodeVarint(carbon::util::zigzag(value));
+    bytes.insert(bytes.end(), encoded.begin(), encoded.end());
+  }
+  for (size_t split = 0; split <= bytes.size(); ++split) {
+    auto buf = folly::IOBuf::copyBuffer(bytes.data(), split);
+    buf->appendChain(
+        folly::IOBuf::copyBuffer(bytes.data() + split, bytes.size() - split));
+    carbon::CarbonProtocolReader reader(carbon::CarbonCursor(buf.get()));
+    for (auto value : values) {
+      int64_t decoded;
+      reader.readRawInto(decoded);
+      EXPECT_EQ(value, decoded);
+    }
+  }
+}
@@ -7,8 +7,11 @@
  */
 #include "ConfigPreprocessor.h"
 
+#include <map>
 #include <memory>
+#include <mutex>
 #include <random>
+#include <unordered_map>
 
 #include <folly/Format.h>
 #include <folly/IPAddress.h>
@@ -16,6 +19,7 @@
 #include <folly/Random.h>
 #include <folly/String.h>
 #include <folly/hash/Hash.h>
+#include <folly/hash/SpookyHashV2.h>
 #include <folly/json.h>
 
 #include "mcrouter/lib/config/ImportResolverIf.h"
@@ -160,6 +164,124 @@ size_t unescapeUntil(StringPiece from, string& to, char c) {
   return string::npos;
 }
 
+constexpr StringPiece kImportCall{"@import("};
+
+void addLiteralImportPath(StringPiece path, vector<string>& paths) {
+  path = trim(path);
+  // Paths built from params or macros are only known during expansion.
+  if (!path.empty() && path.find_first_of("%@\\") == string::npos) {
+    paths.push_back(path.str());
+  }
+}
+
+/**
+ * Appends to paths the paths of the @import calls in json whose path is a
+ * literal, e.g. "@import(pools.json)".
+ */
+void collectImportPaths(const dynamic& json, vector<string>& paths) {
+  if (json.isString()) {
+    auto str = json.stringPiece();
+    if (str.startsWith(kImportCall) && str.endsWith(')')) {
+      str.advance(kImportCall.size());
+      str.pop_back();
+      addLiteralImportPath(str.split_step(','), paths);
+    }
+  } else if (json.isArray()) {
+    for (const auto& item : json) {
+      collectImportPaths(item, paths);
+    }
+  } else if (json.isObject()) {
+    auto type = json.get_ptr("type");
+    auto path = json.get_ptr("path");
+    if (type && type->isString() && type->stringPiece() == "import" && path &&
+        path->isString()) {
+      addLiteralImportPath(path->stringPiece(), paths);
+    }
+    for (const auto& it : json.items()) {
+      collectImportPaths(it.second, paths);
+    }
+  }
+}
+
+void prefetchImports(const dynamic& json, ImportResolverIf& importResolver) {
+  vector<string> paths;
+  collectImportPaths(json, paths);
+  if (!paths.empty()) {
+    importResolver.prefetch(paths);
+  }
+}
+
+/**
+ * Imported files parsed by recent expansions, by hash of their contents,
+ * so that unchanged imports are not parsed again on every reconfiguration.
+ * Entries not used by any of the last kGenerations expansions are dropped.
+ * Shared by all router instances in the process.
+ */
+class ParsedImportCache {
+ public:
+  static ParsedImportCache& get() {
+    // Leaked, so that it outlives expansions on detached threads.
+    static auto cache = new ParsedImportCache();
+    return *cache;
+  }
+
+  /**
+   * Called when an expansion starts.
+   */
+  void newGeneration() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++generation_;
+    for (auto it = entries_.begin(); it != entries_.end();) {
+      if (it->second.lastUsed + kGenerations < generation_) {
+        it = entries_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  /**
+   * @return  jsonC without comments, parsed.
+   * @throws  folly::ParseError if jsonC is invalid
+   */
+  dynamic parse(StringPiece jsonC) {
+    Key key;
+    folly::hash::SpookyHashV2::Hash128(
+        jsonC.data(), jsonC.size(), &key.first, &key.second);
+    std::shared_ptr<const dynamic> parsed;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = entries_.find(key);
+      if (it != entries_.end()) {
+        it->second.lastUsed = generation_;
+        parsed = it->second.json;
+      }
+    }
+    if (parsed) {
+      return *parsed;
+    }
+
+    parsed = std::make_shared<const dynamic>(
+        parseJsonString(stripComments(jsonC)));
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_[key] = Entry{parsed, generation_};
+    return *parsed;
+  }
+
+ private:
+  static constexpr uint64_t kGenerations = 4;
+
+  using Key = std::pair<uint64_t, uint64_t>;
+  struct Entry {
+    std::shared_ptr<const dynamic> json;
+    uint64_t lastUsed;
+  };
+
+  std::mutex mutex_;
+  std::map<Key, Entry> entries_;
+  uint64_t generation_{0};
+};
+
 } // anonymous
 
 ///////////////////////////////Macro////////////////////////////////////////////
@@ -263,6 +385,19 @@ class ConfigPreprocessor::Context {
     return false;
   }
 
+  /**
+   * @return object with all locals of this context, which must all be
+   *         expanded. Identifies a macro call for memoization.
+   */
+  dynamic expandedLocals() const {
+    auto result = dynamic::object();
+    for (const auto& it : locals_) {
+      assert(it.second.second == VarState::EXPAND);
+      result.insert(it.first, it.second.first);
+    }
+    return result;
+  }
+
   void doLazyExpand(StringPiece key) {
     auto& it = locals_.find(key)->second;
     assert(it.second == VarState::LAZY_EXPAND || it.second == VarState::EXPAND);
@@ -298,8 +433,13 @@ class ConfigPreprocessor::Macro {
       StringPiece name,
       const vector<dynamic>& params,
       Func f,
-      bool autoExpand = true)
-      : prep_(prep), f_(std::move(f)), autoExpand_(autoExpand), name_(name) {
+      bool autoExpand = true,
+      bool memoize = false)
+      : prep_(prep),
+        f_(std::move(f)),
+        autoExpand_(autoExpand),
+        memoize_(memoize && autoExpand),
+        name_(name) {
     initParams(params);
   }
 
@@ -334,7 +474,7 @@ class ConfigPreprocessor::Macro {
         result.addExpanded(std::get<0>(params_[i]), std::get<1>(params_[i]));
       }
     }
-    return f_(std::move(result));
+    return call(std::move(result));
   }
 
   dynamic getResult(dynamic&& obj, const Context& ctx) const {
@@ -359,18 +499,41 @@ class ConfigPreprocessor::Macro {
         }
       }
     }
-    return f_(std::move(result));
+    return call(std::move(result));
   }
 
  private:
   const ConfigPreprocessor& prep_;
   Func f_;
   bool autoExpand_{true};
+  bool memoize_{false};
   // name, default, required?
   vector<std::tuple<string, dynamic, bool>> params_;
   size_t maxParamCnt_{0};
   size_t minParamCnt_{0};
   StringPiece name_;
+  // arguments -> result of previous calls
+  mutable std::unordered_map<dynamic, dynamic> memo_;
+
+  dynamic call(Context&& ctx) const {
+    if (!memoize_ || !prep_.memoizeMacros_) {
+      return f_(std::move(ctx));
+    }
+    // Arguments are already expanded and the macro can't see its caller's
+    // scope, so the result only depends on them unless the expansion made
+    // a non-deterministic call.
+    auto args = ctx.expandedLocals();
+    auto it = memo_.find(args);
+    if (it != memo_.end()) {
+      return it->second;
+    }
+    const auto numImpureCalls = prep_.numImpureCalls_;
+    auto result = f_(std::move(ctx));
+    if (prep_.numImpureCalls_ == numImpureCalls) {
+      memo_.emplace(std::move(args), result);
+    }
+    return result;
+  }
 
   void initParams(const vector<dynamic>& params) {
     maxParamCnt_ = minParamCnt_ = params.size();
@@ -480,8 +643,9 @@ class ConfigPreprocessor::BuiltIns {
     try {
       auto jsonC = importResolver.import(pathStr);
       // result may contain comments, macros, etc.
-      result =
-          p.expandMacros(parseJsonString(stripComments(jsonC)), Context(p));
+      auto parsed = ParsedImportCache::get().parse(jsonC);
+      prefetchImports(parsed, importResolver);
+      result = p.expandMacros(std::move(parsed), Context(p));
     } catch (const std::exception& e) {
       if (auto defaultVal = ctx.tryExpandRawArg("default")) {
         p.importCache_.emplace(pathStr, *defaultVal);
@@ -725,6 +889,7 @@ class ConfigPreprocessor::BuiltIns {
       return array;
     }
 
+    ++ctx.prep().numImpureCalls_;
     std::shuffle(array.begin(), array.end(), defaultEngine);
     return array;
   }
@@ -1714,10 +1879,11 @@ void ConfigPreprocessor::addMacro(
     StringPiece name,
     const vector<dynamic>& params,
     Macro::Func func,
-    bool autoExpand) {
+    bool autoExpand,
+    bool memoize) {
   auto it = macros_.emplace(name, nullptr).first;
   it->second = std::make_unique<Macro>(
-      *this, it->first, params, std::move(func), autoExpand);
+      *this, it->first, params, std::move(func), autoExpand, memoize);
 }
 
 dynamic ConfigPreprocessor::replaceParams(
@@ -1870,8 +2036,8 @@ dynamic ConfigPreprocessor::expandMacros(dynamic json, const Context& context)
       // do the initialization in two steps: first add them to context,
       // then lazily expand
       for (auto& it : jVars->items()) {
-        auto var = const_cast<dynamic&>(it.second);
-        extContext->addLocal(it.first.stringPiece(), std::move(var));
+        extContext->addLocal(
+            it.first.stringPiece(), std::move(const_cast<dynamic&>(it.second)));
       }
       for (const auto& varName : jVars->keys()) {
         extContext->doLazyExpand(varName.stringPiece());
@@ -1963,7 +2129,7 @@ void ConfigPreprocessor::parseMacroDef(
     auto f = [res, this](Context&& ctx) {
       return expandMacros(res, std::move(ctx));
     };
-    addMacro(key, params, std::move(f));
+    addMacro(key, params, std::move(f), true, /* memoize */ true);
   } else if (objType == "constDef") {
     checkLogic(obj.isObject(), "constDef is not an object");
     addConst(key, tryGet(obj, "result", "constDef"));
@@ -1994,9 +2160,25 @@ dynamic ConfigPreprocessor::getConfigWithoutMacros(
     ImportResolverIf& importResolver,
     folly::StringKeyedUnorderedMap<dynamic> globalParams,
     size_t nestedLimit) {
-  auto config = parseJsonString(stripComments(jsonC));
+  return expandConfigMacros(
+      parseJsonString(stripComments(jsonC)),
+      importResolver,
+      std::move(globalParams),
+      nestedLimit);
+}
+
+dynamic ConfigPreprocessor::expandConfigMacros(
+    dynamic config,
+    ImportResolverIf& importResolver,
+    folly::StringKeyedUnorderedMap<dynamic> globalParams,
+    size_t nestedLimit) {
   checkLogic(config.isObject(), "config is not an object");
 
+  ParsedImportCache::get().newGeneration();
+  // Loads all imports known upfront in parallel, instead of one by one as
+  // they're expanded.
+  prefetchImports(config, importResolver);
+
   ConfigPreprocessor prep(importResolver, std::move(globalParams), nestedLimit);
 
   // parse and add macros
@@ -2005,6 +2187,8 @@ dynamic ConfigPreprocessor::getConfigWithoutMacros(
     prep.parseMacroDefs(std::move(*jmacros));
     config.erase("macros");
   }
+  // Macro definitions and consts can't change from now on.
+  prep.memoizeMacros_ = true;
 
   return prep.expandMacros(std::move(config), Context(prep));
 }
@@ -44,6 +44,18 @@ class ConfigPreprocessor {
       folly::StringKeyedUnorderedMap<folly::dynamic> globalParams,
       size_t nestedLimit = 250);
 
+  /**
+   * Same as getConfigWithoutMacros(), for a config that was already parsed
+   * from JSONC.
+   *
+   * @throws std::logic_error if config is invalid
+   */
+  static folly::dynamic expandConfigMacros(
+      folly::dynamic config,
+      ImportResolverIf& importResolver,
+      folly::StringKeyedUnorderedMap<folly::dynamic> globalParams,
+      size_t nestedLimit = 250);
+
  private:
   /**
    * Inner representation of macro object
@@ -74,6 +86,18 @@ class ConfigPreprocessor {
 
   mutable size_t nestedLimit_;
 
+  /**
+   * Whether results of user-defined macros may be reused for calls with
+   * the same arguments. Set once all macro definitions are parsed.
+   */
+  bool memoizeMacros_{false};
+
+  /**
+   * Number of non-deterministic built-in calls so far (e.g. @shuffle without
+   * seed). Macro results that involved such calls are not memoized.
+   */
+  mutable size_t numImpureCalls_{0};
+
   /**
    * Create preprocessor with given macros
    *
@@ -126,7 +150,8 @@ class ConfigPreprocessor {
       folly::StringPiece name,
       const std::vector<folly::dynamic>& params,
       std::function<folly::dynamic(Context&&)> func,
-      bool autoExpand = true);
+      bool autoExpand = true,
+      bool memoize = false);
 
   void parseMacroDef(const folly::dynamic& key, const folly::dynamic& obj);
 
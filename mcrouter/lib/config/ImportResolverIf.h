@@ -8,6 +8,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include <folly/Range.h>
 
@@ -27,6 +28,14 @@ class ImportResolverIf {
    */
   virtual std::string import(folly::StringPiece path) = 0;
 
+  /**
+   * Called with the paths of @import macros found in a config (or in an
+   * imported file) before it's expanded, so that implementations can start
+   * loading them ahead of the import() calls. Paths built from macros or
+   * params are only known at import() time. No-op by default.
+   */
+  virtual void prefetch(const std::vector<std::string>& /* paths */) {}
+
   virtual ~ImportResolverIf() {}
 };
 }
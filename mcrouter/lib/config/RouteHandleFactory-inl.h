@@ -83,6 +83,7 @@ RouteHandleFactory<RouteHandleIf>::createNamed(
 template <class RouteHandleIf>
 std::vector<std::shared_ptr<RouteHandleIf>>
 RouteHandleFactory<RouteHandleIf>::createList(const folly::dynamic& json) {
+  ++numCreateCalls_;
   if (json.isArray()) {
     std::vector<RouteHandlePtr> ret;
     // merge all inner lists into result
@@ -75,6 +75,15 @@ class RouteHandleFactory {
     return threadId_;
   }
 
+  /**
+   * @return number of create()/createList() calls so far, including nested
+   *         ones and those answered from already built named routes. Lets a
+   *         provider tell whether building a route depended on others.
+   */
+  size_t numCreateCalls() const noexcept {
+    return numCreateCalls_;
+  }
+
  private:
   RouteHandleProviderIf<RouteHandleIf>& provider_;
 
@@ -84,6 +93,7 @@ class RouteHandleFactory {
   folly::StringKeyedUnorderedMap<std::vector<RouteHandlePtr>> seen_;
   /// Thread where route handles created by this factory will be used
   size_t threadId_;
+  size_t numCreateCalls_{0};
 
   const std::vector<RouteHandlePtr>& createNamed(
       folly::StringPiece name,
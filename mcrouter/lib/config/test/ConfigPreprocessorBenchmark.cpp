@@ -0,0 +1,115 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <string>
+
+#include <folly/Benchmark.h>
+#include <folly/Format.h>
+#include <folly/dynamic.h>
+#include <folly/init/Init.h>
+#include <folly/json.h>
+
+#include "mcrouter/lib/config/ConfigPreprocessor.h"
+#include "mcrouter/lib/config/ImportResolverIf.h"
+
+using namespace facebook::memcache;
+
+namespace {
+
+class NoImportResolver : public ImportResolverIf {
+  std::string import(folly::StringPiece path) final {
+    throw std::runtime_error("Can not import " + path.str());
+  }
+};
+
+/**
+ * Builds a config shaped like production ones: pools are generated by
+ * macros from a region and a size, and every route prefix builds its route
+ * tree from the same few pool macros.
+ */
+std::string makeConfig(size_t numPrefixes, size_t numRegions) {
+  auto macros = folly::parseJson(R"({
+    "servers": {
+      "type": "macroDef",
+      "params": ["region", "size"],
+      "result": {
+        "type": "transform",
+        "dictionary": "@range(1, %size%)",
+        "itemTransform": {"region": "%region%", "host": "%item%"}
+      }
+    },
+    "pool": {
+      "type": "macroDef",
+      "params": ["region", {"name": "size", "default": 100}],
+      "result": {
+        "name": "pool.%region%",
+        "servers": "@servers(%region%,%size%)",
+        "protocol": "caret"
+      }
+    },
+    "route": {
+      "type": "macroDef",
+      "params": ["local", "remote"],
+      "result": {
+        "type": "FailoverRoute",
+        "children": [
+          {"type": "PoolRoute", "pool": "@pool(%local%)"},
+          {"type": "PoolRoute", "pool": "@pool(%remote%)"}
+        ]
+      }
+    }
+  })");
+
+  auto routes = folly::dynamic::array();
+  for (size_t i = 0; i < numPrefixes; ++i) {
+    auto local = folly::sformat("region{}", i % numRegions);
+    auto remote = folly::sformat("region{}", (i + 1) % numRegions);
+    routes.push_back(folly::dynamic::object(
+        "aliases", folly::dynamic::array(folly::sformat("/{}/a/", i)))(
+        "route", folly::sformat("@route({},{})", local, remote)));
+  }
+  return folly::toJson(
+      folly::dynamic::object("macros", std::move(macros))("routes", routes));
+}
+
+void preprocess(size_t iters, size_t numPrefixes, size_t numRegions) {
+  std::string config;
+  BENCHMARK_SUSPEND {
+    config = makeConfig(numPrefixes, numRegions);
+  }
+  NoImportResolver resolver;
+  for (size_t i = 0; i < iters; ++i) {
+    folly::doNotOptimizeAway(ConfigPreprocessor::getConfigWithoutMacros(
+        config, resolver, {}));
+  }
+}
+
+// Every prefix calls the macros with different arguments.
+void unique(size_t iters, size_t numPrefixes) {
+  preprocess(iters, numPrefixes, numPrefixes);
+}
+
+// Prefixes share a handful of regions, as in most real configs.
+void repeated(size_t iters, size_t numPrefixes) {
+  preprocess(iters, numPrefixes, 4);
+}
+
+} // anonymous namespace
+
+BENCHMARK_PARAM(unique, 100)
+BENCHMARK_RELATIVE_PARAM(repeated, 100)
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK_PARAM(unique, 1000)
+BENCHMARK_RELATIVE_PARAM(repeated, 1000)
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv, true /* removeFlags */);
+  folly::runBenchmarks();
+  return 0;
+}
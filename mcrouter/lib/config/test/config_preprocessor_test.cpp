@@ -5,6 +5,7 @@
  *  file in the root directory of this source tree.
  *
  */
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -154,3 +155,98 @@ TEST(ConfigPreprocessorTest, comments) {
 
   EXPECT_EQ(orig, expand);
 }
+
+TEST(ConfigPreprocessorTest, memoizedMacros) {
+  MockImportResolver resolver;
+
+  auto json = ConfigPreprocessor::getConfigWithoutMacros(
+      R"({
+        "macros": {
+          "pool": {
+            "type": "macroDef",
+            "params": ["name", {"name": "opt", "optional": true}],
+            "result": {
+              "name": "%name%",
+              "hasOpt": "@defined(opt)",
+              "servers": "@shuffle(@range(0, 99), 5)"
+            }
+          },
+          "shuffled": {
+            "type": "macroDef",
+            "params": ["unused"],
+            "result": "@shuffle(@range(0, 99))"
+          }
+        },
+        "a": "@pool(a)",
+        "b": "@pool(b)",
+        "a2": "@pool(a)",
+        "aOpt": "@pool(a,x)",
+        "s1": "@shuffled(x)",
+        "s2": "@shuffled(x)"
+      })",
+      resolver,
+      kGlobalParams);
+
+  EXPECT_EQ("a", json["a"]["name"].asString());
+  EXPECT_EQ("b", json["b"]["name"].asString());
+  EXPECT_EQ(json["a"], json["a2"]);
+  EXPECT_FALSE(json["a"]["hasOpt"].asBool());
+  EXPECT_TRUE(json["aOpt"]["hasOpt"].asBool());
+  EXPECT_EQ(json["a"]["servers"], json["b"]["servers"]);
+  // Unseeded shuffles are not deterministic, so they are not memoized.
+  EXPECT_NE(json["s1"], json["s2"]);
+}
+
+namespace {
+
+class PrefetchRecordingResolver : public ImportResolverIf {
+ public:
+  std::vector<std::string> prefetched;
+
+  std::string import(folly::StringPiece path) final {
+    if (path == "outer") {
+      return R"({ "inner": "@import(inner)" })";
+    }
+    return "\"" + path.str() + "\"";
+  }
+
+  void prefetch(const std::vector<std::string>& paths) final {
+    prefetched.insert(prefetched.end(), paths.begin(), paths.end());
+  }
+};
+
+} // anonymous namespace
+
+TEST(ConfigPreprocessorTest, prefetchImports) {
+  PrefetchRecordingResolver resolver;
+
+  auto json = ConfigPreprocessor::getConfigWithoutMacros(
+      R"({
+        "macros": {
+          "imp": {
+            "type": "macroDef",
+            "params": ["name"],
+            "result": "@import(%name%)"
+          }
+        },
+        "a": "@import(a)",
+        "b": { "type": "import", "path": "b" },
+        "list": ["@import(c, default)"],
+        "outer": "@import(outer)",
+        "dynamic": "@imp(d)"
+      })",
+      resolver,
+      kGlobalParams);
+
+  EXPECT_EQ("a", json["a"].asString());
+  EXPECT_EQ("b", json["b"].asString());
+  EXPECT_EQ("c", json["list"][0].asString());
+  EXPECT_EQ("inner", json["outer"]["inner"].asString());
+  EXPECT_EQ("d", json["dynamic"].asString());
+
+  std::sort(resolver.prefetched.begin(), resolver.prefetched.end());
+  // Paths of nested imports are prefetched once their parent is imported;
+  // paths that depend on macro params are only known at expansion time.
+  std::vector<std::string> expected = {"a", "b", "c", "inner", "outer"};
+  EXPECT_EQ(expected, resolver.prefetched);
+}
@@ -9,6 +9,7 @@
 
 #include <chrono>
 
+#include <folly/Random.h>
 #include <folly/Range.h>
 
 namespace facebook {
@@ -175,12 +176,28 @@ bool ConnectionFifo::isConnected() const noexcept {
   return debugFifo_ && debugFifo_->isConnected();
 }
 
+void ConnectionFifo::refreshFilter() noexcept {
+  const auto version = debugFifo_->filterVersion();
+  if (version == filterVersion_) {
+    return;
+  }
+  filterVersion_ = version;
+  filter_ = debugFifo_->filter();
+  sampledOut_ = filter_ && filter_->sampleRate > 1 &&
+      folly::Random::rand32(filter_->sampleRate) != 0;
+}
+
 bool ConnectionFifo::startMessage(
     MessageDirection direction,
     uint32_t typeId) noexcept {
   if (!isConnected()) {
     return false;
   }
+  refreshFilter();
+  skipMessage_ = filter_ && (sampledOut_ || !filter_->matchesType(typeId));
+  if (skipMessage_) {
+    return false;
+  }
   currentMessageHeader_.setDirection(direction);
   currentMessageHeader_.setTypeId(typeId);
   currentMessageHeader_.setTimeUs(timeSinceEpoch());
@@ -188,8 +205,20 @@ bool ConnectionFifo::startMessage(
   return true;
 }
 
+bool ConnectionFifo::startRequest(
+    MessageDirection direction,
+    uint32_t typeId,
+    folly::StringPiece key,
+    size_t valueSize) noexcept {
+  if (!startMessage(direction, typeId)) {
+    return false;
+  }
+  skipMessage_ = filter_ && !filter_->matchesRequest(key, valueSize);
+  return !skipMessage_;
+}
+
 bool ConnectionFifo::writeData(const void* buf, size_t len) noexcept {
-  if (!isConnected()) {
+  if (!isConnected() || skipMessage_) {
     return false;
   }
   iovec iov[1];
@@ -246,7 +275,7 @@ bool ConnectionFifo::writeData(
   // | PACKET HEADER | PACKET BODY |
   // -------------------------------
 
-  if (!isConnected() || iovcnt == 0) {
+  if (!isConnected() || skipMessage_ || iovcnt == 0) {
     return false;
   }
 
@@ -10,6 +10,7 @@
 #include <folly/Range.h>
 #include <folly/io/async/AsyncTransport.h>
 
+#include "mcrouter/lib/carbon/RequestReplyUtil.h"
 #include "mcrouter/lib/debug/ConnectionFifoProtocol.h"
 #include "mcrouter/lib/debug/Fifo.h"
 
@@ -50,11 +51,35 @@ class ConnectionFifo {
   /**
    * Starts a new message.
    *
+   * If the reader published a filter (see FifoFilter) and the message doesn't
+   * pass it, returns false and the following writeData() calls are ignored
+   * until the next message starts.
+   *
    * @param direction   Whether the data was received or sent by connection.
    * @param typeId      Id of the type of the message.
    */
   bool startMessage(MessageDirection direction, uint32_t typeId) noexcept;
 
+  /**
+   * Same as startMessage(), but also checks the key and value size of the
+   * request against the reader's filter. Callers that have the parsed request
+   * should prefer this, and only serialize it if this returns true.
+   */
+  bool startRequest(
+      MessageDirection direction,
+      uint32_t typeId,
+      folly::StringPiece key,
+      size_t valueSize) noexcept;
+  template <class Request>
+  bool startRequest(MessageDirection direction, const Request& req) noexcept {
+    const auto valueBuf = carbon::valuePtrUnsafe(req);
+    return startRequest(
+        direction,
+        Request::typeId,
+        req.key().fullKey(),
+        valueBuf ? valueBuf->computeChainDataLength() : 0);
+  }
+
   /**
    * Writes data to the FIFO, but only if there is reader (i.e. mcpiper)
    * connected to it.
@@ -69,6 +94,16 @@ class ConnectionFifo {
   std::shared_ptr<Fifo> debugFifo_;
   MessageHeader currentMessageHeader_;
   uint32_t nextPacketId_{0};
+
+  // Cached copy of debugFifo_->filter().
+  std::shared_ptr<const FifoFilter> filter_;
+  uint64_t filterVersion_{0};
+  // Whether this connection was left out by the filter's sampling.
+  bool sampledOut_{false};
+  // Whether the current message didn't pass the filter.
+  bool skipMessage_{false};
+
+  void refreshFilter() noexcept;
 };
 
 } // memcache
@@ -13,6 +13,7 @@
 #include <unistd.h>
 
 #include <cstring>
+#include <memory>
 
 #include <boost/filesystem.hpp>
 
@@ -20,6 +21,7 @@
 
 #include <folly/FileUtil.h>
 
+#include "mcrouter/lib/debug/ShmRing.h"
 #include "mcrouter/lib/fbi/cpp/util.h"
 
 namespace facebook {
@@ -48,9 +50,14 @@ bool isFifo(const char* fifoPath) {
   return (stat(fifoPath, &st) != -1) && S_ISFIFO(st.st_mode);
 }
 
+// A ring is considered disconnected if its reader hasn't been seen for this
+// long.
+constexpr uint64_t kRingReaderTimeoutMs = 3000;
+
 } // anonymous namespace
 
-Fifo::Fifo(std::string path) : path_(std::move(path)) {
+Fifo::Fifo(std::string path, size_t ringSize)
+    : path_(std::move(path)), ringSize_(ringSize) {
   if (UNLIKELY(path_.empty())) {
     throw std::invalid_argument("Fifo path cannot be empty");
   }
@@ -68,6 +75,9 @@ Fifo::~Fifo() {
 }
 
 bool Fifo::tryConnect() noexcept {
+  if (ringSize_ > 0) {
+    return tryConnectRing();
+  }
   if (isConnected()) {
     return true;
   }
@@ -99,6 +109,56 @@ bool Fifo::tryConnect() noexcept {
   return false;
 }
 
+bool Fifo::tryConnectRing() noexcept {
+  if (!ring_) {
+    try {
+      ring_ = std::make_unique<ShmRingWriter>(path_, ringSize_);
+    } catch (const std::exception& e) {
+      static bool logged{false};
+      if (!logged) {
+        VLOG(1) << "Error creating debug ring at \"" << path_
+                << "\": " << e.what();
+        logged = true;
+      }
+      return false;
+    }
+  }
+
+  // Stop writing shortly after the reader goes away, so that the ring isn't
+  // filled with data nobody will read.
+  const bool connected = ring_->hasReader(kRingReaderTimeoutMs);
+  ringConnected_.store(connected, std::memory_order_release);
+  return connected;
+}
+
+void Fifo::refreshFilter() noexcept {
+  const auto path = FifoFilter::filterPath(path_);
+  struct stat st;
+  ino_t inode = 0;
+  time_t mtime = 0;
+  if (stat(path.c_str(), &st) == 0) {
+    inode = st.st_ino;
+    mtime = st.st_mtime;
+  }
+  if (inode == filterInode_ && mtime == filterMtime_) {
+    return;
+  }
+  filterInode_ = inode;
+  filterMtime_ = mtime;
+
+  std::shared_ptr<const FifoFilter> filter;
+  std::string contents;
+  if (inode != 0 && folly::readFile(path.c_str(), contents)) {
+    if (auto parsed = FifoFilter::fromJson(contents)) {
+      filter = std::make_shared<const FifoFilter>(std::move(*parsed));
+    } else {
+      VLOG(1) << "Invalid debug fifo filter at \"" << path << "\"";
+    }
+  }
+  *filter_.wlock() = std::move(filter);
+  filterVersion_.fetch_add(1, std::memory_order_release);
+}
+
 void Fifo::disconnect() noexcept {
   auto oldFd = fd_.exchange(-1);
   if (oldFd >= 0) {
@@ -114,6 +174,10 @@ bool Fifo::write(void* buf, size_t len) noexcept {
 }
 
 bool Fifo::write(const struct iovec* iov, size_t iovcnt) noexcept {
+  if (ringSize_ > 0) {
+    return isConnected() && ring_->write(iov, iovcnt);
+  }
+
   if (folly::writevNoInt(fd_, iov, iovcnt) == -1) {
     if (errno != EAGAIN) {
       PLOG(WARNING) << "Error writing to debug pipe.";
@@ -7,18 +7,31 @@
  */
 #pragma once
 
+#include <sys/types.h>
 #include <sys/uio.h>
 
 #include <atomic>
+#include <memory>
 #include <string>
 
+#include <folly/Synchronized.h>
+
+#include "mcrouter/lib/debug/FifoFilter.h"
+
 namespace facebook {
 namespace memcache {
 
+class ShmRingWriter;
+
 /**
  * Writes data to a named pipe (fifo) for debugging purposes.
  * Instances of this file have a one-to-one mapping with actual FIFOs on disk.
  *
+ * Alternatively, when created with a non-zero ring size, data is written to
+ * a shared memory ring (see ShmRing.h) at the same path instead. Writes then
+ * never make syscalls, and old data is overwritten if the reader falls
+ * behind. The ring is "connected" while a reader keeps its heartbeat fresh.
+ *
  * Notes:
  *  - Unless specified otherwise, methods of this class are thread-safe.
  *  - Life of Fifo is managed by FifoManager.
@@ -48,6 +61,9 @@ class Fifo {
    * Tells whether this fifo is connectted.
    */
   bool isConnected() const noexcept {
+    if (ringSize_ > 0) {
+      return ringConnected_.load(std::memory_order_acquire);
+    }
     return fd_ >= 0;
   }
 
@@ -65,19 +81,57 @@ class Fifo {
   bool write(const struct iovec* iov, size_t iovcnt) noexcept;
   bool write(void* buf, size_t len) noexcept;
 
+  /**
+   * Filter published by the reader of this fifo, if any.
+   */
+  std::shared_ptr<const FifoFilter> filter() const {
+    return *filter_.rlock();
+  }
+
+  /**
+   * Incremented every time filter() changes, so that users can cheaply tell
+   * whether they need to fetch it again.
+   */
+  uint64_t filterVersion() const noexcept {
+    return filterVersion_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * Reloads the filter from its file if the file changed.
+   * Note: This method is not thread-safe.
+   */
+  void refreshFilter() noexcept;
+
  private:
   /**
    * Creates a fifo on the given path.
    *
+   * @param ringSize  If non-zero, write to a shared memory ring of (about)
+   *                  this many bytes instead of a named pipe.
+   *
    * @throw std::invalid_argument  If path is empty.
    */
-  explicit Fifo(std::string path);
+  explicit Fifo(std::string path, size_t ringSize = 0);
 
   // Path of the fifo
   const std::string path_;
   // Fifo file descriptor.
   std::atomic<int> fd_{-1};
 
+  // Size of the shared memory ring, 0 if writing to a named pipe.
+  const size_t ringSize_;
+  // Created lazily by tryConnect(), published by ringConnected_.
+  std::unique_ptr<ShmRingWriter> ring_;
+  std::atomic<bool> ringConnected_{false};
+
+  bool tryConnectRing() noexcept;
+
+  folly::Synchronized<std::shared_ptr<const FifoFilter>> filter_;
+  std::atomic<uint64_t> filterVersion_{0};
+  // Identity of the last loaded filter file, 0 if there was none.
+  ino_t filterInode_{0};
+  time_t filterMtime_{0};
+
   /**
    * Disconnects the pipe.
    */
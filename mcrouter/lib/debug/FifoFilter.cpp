@@ -0,0 +1,79 @@
+/*
+ *  Copyright (c) 2016-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include "FifoFilter.h"
+
+#include <algorithm>
+
+#include <folly/dynamic.h>
+#include <folly/json.h>
+
+namespace facebook {
+namespace memcache {
+
+constexpr folly::StringPiece FifoFilter::kFileSuffix;
+
+bool FifoFilter::matchesType(uint32_t typeId) const noexcept {
+  if (typeIds.empty() || typeId == 0) {
+    return true;
+  }
+  // Request type ids are odd, reply type id is request type id + 1.
+  const uint32_t requestTypeId = (typeId % 2 == 1) ? typeId : typeId - 1;
+  return std::find(typeIds.begin(), typeIds.end(), requestTypeId) !=
+      typeIds.end();
+}
+
+bool FifoFilter::matchesRequest(folly::StringPiece key, size_t valueSize) const
+    noexcept {
+  return key.startsWith(keyPrefix) && valueSize >= valueMinSize &&
+      valueSize <= valueMaxSize;
+}
+
+std::string FifoFilter::toJson() const {
+  folly::dynamic types = folly::dynamic::array;
+  for (auto typeId : typeIds) {
+    types.push_back(typeId);
+  }
+  folly::dynamic json = folly::dynamic::object("type_ids", std::move(types))(
+      "key_prefix", keyPrefix)("value_min_size", valueMinSize)(
+      "value_max_size", valueMaxSize)("sample_rate", sampleRate);
+  return folly::toJson(json);
+}
+
+folly::Optional<FifoFilter> FifoFilter::fromJson(folly::StringPiece json) {
+  FifoFilter filter;
+  try {
+    auto parsed = folly::parseJson(json);
+    if (auto types = parsed.get_ptr("type_ids")) {
+      for (const auto& typeId : *types) {
+        filter.typeIds.push_back(typeId.asInt());
+      }
+    }
+    if (auto prefix = parsed.get_ptr("key_prefix")) {
+      filter.keyPrefix = prefix->getString();
+    }
+    if (auto minSize = parsed.get_ptr("value_min_size")) {
+      filter.valueMinSize = minSize->asInt();
+    }
+    if (auto maxSize = parsed.get_ptr("value_max_size")) {
+      filter.valueMaxSize = maxSize->asInt();
+    }
+    if (auto sampleRate = parsed.get_ptr("sample_rate")) {
+      filter.sampleRate = std::max<int64_t>(1, sampleRate->asInt());
+    }
+  } catch (const std::exception&) {
+    return folly::none;
+  }
+  return filter;
+}
+
+std::string FifoFilter::filterPath(const std::string& fifoPath) {
+  return fifoPath + kFileSuffix.str();
+}
+
+} // memcache
+} // facebook
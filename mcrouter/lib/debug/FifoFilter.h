@@ -0,0 +1,70 @@
+/*
+ *  Copyright (c) 2016-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <folly/Optional.h>
+#include <folly/Range.h>
+
+namespace facebook {
+namespace memcache {
+
+/**
+ * Describes which traffic a debug fifo reader (i.e. mcpiper) is interested
+ * in, so that mcrouter doesn't serialize and write anything else.
+ *
+ * The reader publishes it as JSON in a file next to the fifo (see
+ * filterPath()). Only the first reader's filter makes sense: all readers of
+ * a fifo share the same data.
+ */
+struct FifoFilter {
+  // Request type ids to mirror; replies are matched by their request type.
+  // Empty means all types.
+  std::vector<uint32_t> typeIds;
+  // Only mirror requests whose full key starts with this prefix.
+  std::string keyPrefix;
+  // Only mirror requests whose value size is in this range.
+  uint32_t valueMinSize{0};
+  uint32_t valueMaxSize{std::numeric_limits<uint32_t>::max()};
+  // Mirror one connection out of sampleRate. Whole connections are sampled,
+  // so that requests and their replies are kept together.
+  uint32_t sampleRate{1};
+
+  /**
+   * Tells whether messages of the given type (request or reply) pass the
+   * filter.
+   */
+  bool matchesType(uint32_t typeId) const noexcept;
+
+  /**
+   * Tells whether a request with the given key and value size passes the
+   * filter. Doesn't check the type.
+   */
+  bool matchesRequest(folly::StringPiece key, size_t valueSize) const noexcept;
+
+  std::string toJson() const;
+
+  /**
+   * @return  The parsed filter, or none if `json` is not a valid filter.
+   */
+  static folly::Optional<FifoFilter> fromJson(folly::StringPiece json);
+
+  /**
+   * Path of the filter file of the fifo at `fifoPath`.
+   */
+  static std::string filterPath(const std::string& fifoPath);
+
+  static constexpr folly::StringPiece kFileSuffix{".filter"};
+};
+
+} // memcache
+} // facebook
@@ -38,6 +38,7 @@ FifoManager::FifoManager() {
       fifos_.withRLock([](const auto& fifos) {
         for (auto& kv : fifos) {
           kv.second->tryConnect();
+          kv.second->refreshFilter();
         }
       });
 
@@ -88,9 +89,10 @@ std::shared_ptr<Fifo> FifoManager::find(const std::string& fifoPath) {
 }
 
 std::shared_ptr<Fifo> FifoManager::createAndStore(const std::string& fifoPath) {
-  return fifos_.withWLock([&fifoPath](auto& fifos) {
-    auto it =
-        fifos.emplace(fifoPath, std::shared_ptr<Fifo>(new Fifo(fifoPath)));
+  const auto ringSize = shmRingSize_.load(std::memory_order_relaxed);
+  return fifos_.withWLock([&fifoPath, ringSize](auto& fifos) {
+    auto it = fifos.emplace(
+        fifoPath, std::shared_ptr<Fifo>(new Fifo(fifoPath, ringSize)));
     return it.first->second;
   });
 }
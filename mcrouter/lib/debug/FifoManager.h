@@ -7,6 +7,7 @@
  */
 #pragma once
 
+#include <atomic>
 #include <condition_variable>
 #include <memory>
 #include <thread>
@@ -43,6 +44,14 @@ class FifoManager {
    */
   std::shared_ptr<Fifo> fetchThreadLocal(const std::string& fifoBasePath);
 
+  /**
+   * Makes fifos created from now on write to shared memory rings of the
+   * given size instead of named pipes. 0 (the default) means named pipes.
+   */
+  void setShmRingSize(size_t size) {
+    shmRingSize_.store(size, std::memory_order_relaxed);
+  }
+
   /**
    * Removes all elements from the fifo manager.
    */
@@ -62,6 +71,8 @@ class FifoManager {
       folly::SharedMutex>
       fifos_;
 
+  std::atomic<size_t> shmRingSize_{0};
+
   // Thread that connects to fifos
   std::thread thread_;
   bool running_{true};
@@ -0,0 +1,213 @@
+/*
+ *  Copyright (c) 2016-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include "ShmRing.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+#include <folly/Bits.h>
+#include <folly/Exception.h>
+#include <folly/File.h>
+#include <folly/FileUtil.h>
+
+namespace facebook {
+namespace memcache {
+
+constexpr uint32_t ShmRingHeader::kMagic;
+constexpr uint32_t ShmRingHeader::kVersion;
+
+namespace {
+
+constexpr size_t kMinCapacity = 4096;
+constexpr size_t kRecordAlignment = 8;
+constexpr size_t kLengthSize = sizeof(uint32_t);
+
+uint64_t nowMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+uint64_t recordSize(size_t dataLength) {
+  return (kLengthSize + dataLength + kRecordAlignment - 1) &
+      ~(kRecordAlignment - 1);
+}
+
+void* mapFile(int fd, size_t size, int prot, const std::string& path) {
+  void* addr = mmap(nullptr, size, prot, MAP_SHARED, fd, 0);
+  if (addr == MAP_FAILED) {
+    folly::throwSystemError("Can't mmap ring ", path);
+  }
+  return addr;
+}
+
+} // anonymous
+
+ShmRingWriter::ShmRingWriter(const std::string& path, size_t capacity) {
+  capacity = folly::nextPowTwo(std::max(capacity, kMinCapacity));
+  mask_ = capacity - 1;
+  mappedSize_ = sizeof(ShmRingHeader) + capacity;
+
+  // Build the ring aside and rename it, so that readers never map a
+  // partially initialized file.
+  const auto tmpPath = path + ".tmp";
+  folly::File file(tmpPath, O_RDWR | O_CREAT | O_TRUNC, 0666);
+  folly::checkUnixError(
+      ftruncate(file.fd(), mappedSize_), "Can't resize ring ", tmpPath);
+  auto addr =
+      mapFile(file.fd(), mappedSize_, PROT_READ | PROT_WRITE, tmpPath);
+  header_ = static_cast<ShmRingHeader*>(addr);
+  data_ = static_cast<char*>(addr) + sizeof(ShmRingHeader);
+
+  header_->magic = ShmRingHeader::kMagic;
+  header_->version = ShmRingHeader::kVersion;
+  header_->capacity = capacity;
+  header_->reserved = 0;
+  header_->committed = 0;
+  header_->readerHeartbeatMs = 0;
+
+  if (rename(tmpPath.c_str(), path.c_str()) != 0) {
+    munmap(header_, mappedSize_);
+    folly::throwSystemError("Can't rename ring to ", path);
+  }
+}
+
+ShmRingWriter::~ShmRingWriter() {
+  munmap(header_, mappedSize_);
+}
+
+bool ShmRingWriter::write(const struct iovec* iov, size_t iovcnt) noexcept {
+  size_t length = 0;
+  for (size_t i = 0; i < iovcnt; ++i) {
+    length += iov[i].iov_len;
+  }
+  const uint64_t size = recordSize(length);
+  if (size > (mask_ + 1) / 2) {
+    return false;
+  }
+
+  const auto start = header_->committed;
+  const auto end = start + size;
+  __atomic_store_n(&header_->reserved, end, __ATOMIC_RELAXED);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  // Records are 8-byte aligned, so the length never wraps.
+  const uint32_t length32 = length;
+  std::memcpy(data_ + (start & mask_), &length32, kLengthSize);
+  auto pos = start + kLengthSize;
+  for (size_t i = 0; i < iovcnt; ++i) {
+    auto src = static_cast<const char*>(iov[i].iov_base);
+    size_t left = iov[i].iov_len;
+    while (left > 0) {
+      const auto offset = pos & mask_;
+      const auto chunk = std::min<size_t>(left, mask_ + 1 - offset);
+      std::memcpy(data_ + offset, src, chunk);
+      src += chunk;
+      left -= chunk;
+      pos += chunk;
+    }
+  }
+
+  __atomic_store_n(&header_->committed, end, __ATOMIC_RELEASE);
+  return true;
+}
+
+bool ShmRingWriter::hasReader(uint64_t timeoutMs) const noexcept {
+  const auto heartbeat =
+      __atomic_load_n(&header_->readerHeartbeatMs, __ATOMIC_RELAXED);
+  return heartbeat != 0 && heartbeat + timeoutMs >= nowMs();
+}
+
+ShmRingReader::ShmRingReader(const std::string& path) {
+  folly::File file(path, O_RDWR);
+  ShmRingHeader header;
+  if (folly::preadFull(file.fd(), &header, sizeof(header), 0) !=
+          sizeof(header) ||
+      header.magic != ShmRingHeader::kMagic ||
+      header.version != ShmRingHeader::kVersion ||
+      header.capacity == 0 ||
+      (header.capacity & (header.capacity - 1)) != 0) {
+    throw std::runtime_error(path + " is not a debug fifo ring");
+  }
+  mask_ = header.capacity - 1;
+  mappedSize_ = sizeof(ShmRingHeader) + header.capacity;
+  auto addr = mapFile(file.fd(), mappedSize_, PROT_READ | PROT_WRITE, path);
+  header_ = static_cast<ShmRingHeader*>(addr);
+  data_ = static_cast<const char*>(addr) + sizeof(ShmRingHeader);
+  pos_ = __atomic_load_n(&header_->committed, __ATOMIC_ACQUIRE);
+}
+
+ShmRingReader::~ShmRingReader() {
+  munmap(header_, mappedSize_);
+}
+
+bool ShmRingReader::isRing(const std::string& path) noexcept {
+  try {
+    folly::File file(path, O_RDONLY);
+    uint32_t magic = 0;
+    return folly::preadFull(file.fd(), &magic, sizeof(magic), 0) ==
+        sizeof(magic) &&
+        magic == ShmRingHeader::kMagic;
+  } catch (const std::exception&) {
+    return false;
+  }
+}
+
+uint64_t ShmRingReader::read(
+    folly::FunctionRef<void(folly::ByteRange)> onRecord) {
+  __atomic_store_n(&header_->readerHeartbeatMs, nowMs(), __ATOMIC_RELAXED);
+
+  const uint64_t capacity = mask_ + 1;
+  const auto committed =
+      __atomic_load_n(&header_->committed, __ATOMIC_ACQUIRE);
+  uint64_t lost = 0;
+  while (pos_ < committed) {
+    uint32_t length;
+    std::memcpy(&length, data_ + (pos_ & mask_), kLengthSize);
+    const auto size = recordSize(length);
+    const bool sane = size <= capacity / 2 && pos_ + size <= committed;
+    if (sane) {
+      record_.resize(length);
+      auto pos = pos_ + kLengthSize;
+      size_t copied = 0;
+      while (copied < length) {
+        const auto offset = pos & mask_;
+        const auto chunk =
+            std::min<size_t>(length - copied, capacity - offset);
+        std::memcpy(&record_[copied], data_ + offset, chunk);
+        copied += chunk;
+        pos += chunk;
+      }
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const auto reserved =
+        __atomic_load_n(&header_->reserved, __ATOMIC_RELAXED);
+    if (!sane || reserved > pos_ + capacity) {
+      // Overwritten while (or before) we read it: resync to the end.
+      lost += committed - pos_;
+      pos_ = committed;
+      break;
+    }
+
+    pos_ += size;
+    onRecord(folly::ByteRange(
+        reinterpret_cast<const uint8_t*>(record_.data()), record_.size()));
+  }
+  return lost;
+}
+
+} // memcache
+} // facebook
@@ -0,0 +1,136 @@
+/*
+ *  Copyright (c) 2016-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <sys/uio.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <folly/Function.h>
+#include <folly/Range.h>
+
+namespace facebook {
+namespace memcache {
+
+/**
+ * Layout of a shared memory ring file:
+ *
+ *   ShmRingHeader, followed by `capacity` bytes of records.
+ *
+ * Each record is a 4-byte length followed by the data, padded to 8 bytes.
+ * Positions (`reserved`, `committed`) count bytes ever written, the offset
+ * in the data area is position % capacity.
+ *
+ * The writer never waits for readers: old records are overwritten. Readers
+ * detect it by checking, after copying a record, that `reserved` hasn't
+ * moved more than `capacity` past the start of the record.
+ */
+struct ShmRingHeader {
+  static constexpr uint32_t kMagic = 0x676e6972; // "ring"
+  static constexpr uint32_t kVersion = 1;
+
+  uint32_t magic;
+  uint32_t version;
+  uint64_t capacity;
+  // End of the record being written (equal to committed when idle).
+  uint64_t reserved;
+  // End of the last complete record.
+  uint64_t committed;
+  // Updated by readers, wall clock in milliseconds.
+  uint64_t readerHeartbeatMs;
+  uint64_t unused[3];
+};
+
+static_assert(sizeof(ShmRingHeader) == 64, "ShmRing layout changed");
+
+/**
+ * Single producer side of the ring. write() never blocks and makes no
+ * syscalls.
+ *
+ * Not thread-safe: write() must always be called from the same thread.
+ */
+class ShmRingWriter {
+ public:
+  /**
+   * Creates (replacing any existing file) and maps a ring at `path`.
+   *
+   * @param capacity  Size of the data area, rounded up to a power of two.
+   * @throw std::system_error  if the file can't be created or mapped.
+   */
+  ShmRingWriter(const std::string& path, size_t capacity);
+  ~ShmRingWriter();
+
+  ShmRingWriter(const ShmRingWriter&) = delete;
+  ShmRingWriter& operator=(const ShmRingWriter&) = delete;
+
+  /**
+   * Appends one record made of the given buffers.
+   *
+   * @return  false if the record is too big for the ring (more than half of
+   *          its capacity), true otherwise.
+   */
+  bool write(const struct iovec* iov, size_t iovcnt) noexcept;
+
+  /**
+   * @return  True if a reader updated its heartbeat in the last
+   *          `timeoutMs` milliseconds.
+   */
+  bool hasReader(uint64_t timeoutMs) const noexcept;
+
+ private:
+  ShmRingHeader* header_{nullptr};
+  char* data_{nullptr};
+  size_t mappedSize_{0};
+  uint64_t mask_{0};
+};
+
+/**
+ * Consumer side of the ring. Any number of readers can read the same ring,
+ * each has its own position.
+ */
+class ShmRingReader {
+ public:
+  /**
+   * Maps an existing ring. Starts reading at the current end of the ring.
+   *
+   * @throw std::system_error   if the file can't be opened or mapped.
+   * @throw std::runtime_error  if the file is not a ring.
+   */
+  explicit ShmRingReader(const std::string& path);
+  ~ShmRingReader();
+
+  ShmRingReader(const ShmRingReader&) = delete;
+  ShmRingReader& operator=(const ShmRingReader&) = delete;
+
+  /**
+   * @return  True if `path` looks like a ring file (checks the magic only).
+   */
+  static bool isRing(const std::string& path) noexcept;
+
+  /**
+   * Calls `onRecord` with every complete record written since the previous
+   * call, and updates the reader heartbeat.
+   *
+   * @return  Number of bytes of records lost because the writer overwrote
+   *          them before they could be read.
+   */
+  uint64_t read(folly::FunctionRef<void(folly::ByteRange)> onRecord);
+
+ private:
+  ShmRingHeader* header_{nullptr};
+  const char* data_{nullptr};
+  size_t mappedSize_{0};
+  uint64_t mask_{0};
+  uint64_t pos_{0};
+  std::string record_;
+};
+
+} // memcache
+} // facebook
@@ -0,0 +1,168 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+
+#include <folly/Bits.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "mcrouter/lib/fbi/cpp/util.h"
+
+namespace facebook {
+namespace memcache {
+
+namespace detail {
+
+// Uncompressed trie, only used while building a CompactTrie.
+struct CompactTrieBuildNode {
+  std::map<unsigned char, std::unique_ptr<CompactTrieBuildNode>> next;
+  uint32_t value{static_cast<uint32_t>(-1)};
+};
+
+} // detail
+
+template <class Value>
+constexpr uint32_t CompactTrie<Value>::kNoValue;
+
+template <class Value>
+CompactTrie<Value>::CompactTrie(
+    std::vector<std::pair<std::string, Value>> items) {
+  using BuildNode = detail::CompactTrieBuildNode;
+
+  checkLogic(
+      items.size() < kNoValue, "CompactTrie: too many items: {}", items.size());
+  BuildNode root;
+  values_.reserve(items.size());
+  for (auto& item : items) {
+    auto node = &root;
+    for (unsigned char c : item.first) {
+      auto& next = node->next[c];
+      if (!next) {
+        next = std::make_unique<BuildNode>();
+      }
+      node = next.get();
+    }
+    checkLogic(
+        node->value == kNoValue, "CompactTrie: duplicate key {}", item.first);
+    node->value = values_.size();
+    values_.push_back(std::move(item.second));
+  }
+
+  // Lay nodes out breadth first, so that siblings end up next to each other.
+  struct Pending {
+    const BuildNode* node;
+    uint32_t index;
+  };
+  nodes_.emplace_back();
+  nodes_[0].value = root.value;
+  firstChars_.push_back('\0');
+  std::deque<Pending> queue{{&root, 0}};
+  while (!queue.empty()) {
+    auto pending = queue.front();
+    queue.pop_front();
+    nodes_[pending.index].childrenBegin = nodes_.size();
+    nodes_[pending.index].numChildren = pending.node->next.size();
+    for (const auto& edge : pending.node->next) {
+      Node child;
+      child.labelBegin = labels_.size();
+      labels_.push_back(edge.first);
+      // Merge chains of nodes that have one child and no value.
+      const BuildNode* node = edge.second.get();
+      while (node->value == kNoValue && node->next.size() == 1) {
+        labels_.push_back(node->next.begin()->first);
+        node = node->next.begin()->second.get();
+      }
+      child.labelSize = labels_.size() - child.labelBegin;
+      child.value = node->value;
+      queue.push_back({node, static_cast<uint32_t>(nodes_.size())});
+      nodes_.push_back(child);
+      firstChars_.push_back(edge.first);
+    }
+  }
+  firstChars_.append(16, '\0');
+  nodes_.shrink_to_fit();
+  labels_.shrink_to_fit();
+}
+
+template <class Value>
+const Value* CompactTrie<Value>::find(folly::StringPiece key) const {
+  auto result = walk(key);
+  return result.second ? &values_[nodes_[result.first].value] : nullptr;
+}
+
+template <class Value>
+const Value* CompactTrie<Value>::findPrefix(folly::StringPiece key) const {
+  auto result = walk(key);
+  return result.first != kNoValue ? &values_[nodes_[result.first].value]
+                                  : nullptr;
+}
+
+template <class Value>
+std::pair<uint32_t, bool> CompactTrie<Value>::walk(
+    folly::StringPiece key) const {
+  uint32_t best = nodes_[0].value != kNoValue ? 0 : kNoValue;
+  const Node* node = &nodes_[0];
+  size_t pos = 0;
+  while (pos < key.size()) {
+    auto childIdx = findChild(*node, key[pos]);
+    if (childIdx == kNoValue) {
+      return {best, false};
+    }
+    const auto& child = nodes_[childIdx];
+    if (key.size() - pos < child.labelSize ||
+        std::memcmp(
+            labels_.data() + child.labelBegin + 1,
+            key.data() + pos + 1,
+            child.labelSize - 1) != 0) {
+      return {best, false};
+    }
+    pos += child.labelSize;
+    if (child.value != kNoValue) {
+      best = childIdx;
+    }
+    node = &child;
+  }
+  return {best, best != kNoValue && node == &nodes_[best]};
+}
+
+template <class Value>
+uint32_t CompactTrie<Value>::findChild(const Node& node, char c) const {
+  const char* chars = firstChars_.data() + node.childrenBegin;
+#ifdef __SSE2__
+  const __m128i needle = _mm_set1_epi8(c);
+  for (uint32_t i = 0; i < node.numChildren; i += 16) {
+    auto block =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(chars + i));
+    uint32_t mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, needle));
+    auto remaining = node.numChildren - i;
+    if (remaining < 16) {
+      mask &= (1u << remaining) - 1;
+    }
+    if (mask) {
+      return node.childrenBegin + i + folly::findFirstSet(mask) - 1;
+    }
+  }
+  return kNoValue;
+#else
+  auto found =
+      static_cast<const char*>(std::memchr(chars, c, node.numChildren));
+  return found ? node.childrenBegin + (found - chars) : kNoValue;
+#endif
+}
+
+} // memcache
+} // facebook
@@ -0,0 +1,113 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <folly/Range.h>
+
+namespace facebook {
+namespace memcache {
+
+/**
+ * Immutable radix trie laid out in a few contiguous arrays.
+ *
+ * Meant for maps that are built once (e.g. at config load) and then only
+ * queried: chains of single-child nodes are merged into one node with a
+ * multi-character label, and the children of a node are stored next to each
+ * other, so that a lookup touches one small node per matched label. The
+ * child to follow is found by comparing the next key character with the
+ * first characters of all the children at once (16 per SSE2 instruction).
+ *
+ * @param Value type of stored value.
+ */
+template <class Value>
+class CompactTrie {
+  static_assert(
+      sizeof(folly::StringPiece::value_type) == 1,
+      "CompactTrie works only with 8 bit character types");
+
+ public:
+  CompactTrie() : CompactTrie(std::vector<std::pair<std::string, Value>>()) {}
+
+  /**
+   * @param items  Keys and values to store. Keys must be unique.
+   */
+  explicit CompactTrie(std::vector<std::pair<std::string, Value>> items);
+
+  /**
+   * Builds a CompactTrie from any container of (key, value) pairs, e.g. from
+   * a Trie.
+   */
+  template <class Container>
+  static CompactTrie fromContainer(const Container& container) {
+    std::vector<std::pair<std::string, Value>> items;
+    for (const auto& it : container) {
+      items.emplace_back(std::string(it.first), it.second);
+    }
+    return CompactTrie(std::move(items));
+  }
+
+  /**
+   * @return  Value for given key, nullptr if there's no such key.
+   */
+  const Value* find(folly::StringPiece key) const;
+
+  /**
+   * @return  Value of the longest prefix of key stored in the trie,
+   *          nullptr if no prefix of key is stored.
+   */
+  const Value* findPrefix(folly::StringPiece key) const;
+
+  size_t size() const {
+    return values_.size();
+  }
+
+ private:
+  static constexpr uint32_t kNoValue = static_cast<uint32_t>(-1);
+
+  struct Node {
+    // Label of the edge leading to this node, in labels_.
+    uint32_t labelBegin{0};
+    uint32_t labelSize{0};
+    // Children are nodes_[childrenBegin, childrenBegin + numChildren),
+    // sorted by the first character of their label.
+    uint32_t childrenBegin{0};
+    uint32_t numChildren{0};
+    uint32_t value{kNoValue};
+  };
+
+  std::vector<Node> nodes_;
+  // firstChars_[i] is the first character of nodes_[i]'s label. Padded, so
+  // that it's always safe to load 16 characters from any child group.
+  std::string firstChars_;
+  std::string labels_;
+  std::vector<Value> values_;
+
+  /**
+   * Walks the trie along key.
+   *
+   * @return  pair of (index of the deepest node with a value whose label
+   *          path is a prefix of key, true if that path is key itself),
+   *          or (kNoValue, false).
+   */
+  std::pair<uint32_t, bool> walk(folly::StringPiece key) const;
+
+  /**
+   * @return  index of the child of node whose label starts with c,
+   *          or kNoValue.
+   */
+  uint32_t findChild(const Node& node, char c) const;
+};
+
+} // memcache
+} // facebook
+
+#include "CompactTrie-inl.h"
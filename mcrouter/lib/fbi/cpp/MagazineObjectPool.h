@@ -0,0 +1,330 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <folly/ThreadLocal.h>
+
+namespace facebook {
+namespace memcache {
+
+/// MagazineObjectPool is a thread-safe ObjectPool that doesn't take a lock.
+///
+/// Every thread caches free objects in two magazines (arrays of up to
+/// magazineSize objects) of its own, so that most alloc() and free() calls
+/// only touch thread-local memory. Once both are full (or empty), a whole
+/// magazine is exchanged with a global depot, which holds up to
+/// maxCapacity / magazineSize magazines in lock-free slots. Objects freed
+/// while the depot is full go back to the Allocator, so at most maxCapacity
+/// objects are cached in the depot, plus at most 2 * magazineSize per thread.
+///
+/// Objects may be freed by another thread than the one allocating them, and
+/// the Allocator must be thread-safe. Caches of exiting threads are moved to
+/// the depot.
+template <typename T, typename Allocator = std::allocator<T>>
+class MagazineObjectPool {
+ public:
+  struct Stats {
+    // Number of alloc() calls.
+    uint64_t allocs{0};
+    // Number of allocs not served from the pool.
+    uint64_t allocatorAllocs{0};
+    // Number of freed objects given back to the Allocator.
+    uint64_t allocatorDeallocs{0};
+    // Number of magazines currently in the depot.
+    size_t depotMagazines{0};
+  };
+
+  /// @param maxCapacity   Maximum number of objects cached in the depot.
+  /// @param magazineSize  Number of objects exchanged with the depot at once.
+  explicit MagazineObjectPool(size_t maxCapacity, size_t magazineSize = 64)
+      : magazineSize_(magazineSize > 0 ? magazineSize : 1),
+        numSlots_(maxCapacity / magazineSize_),
+        depot_(new std::atomic<Magazine*>[numSlots_]),
+        caches_(std::make_unique<folly::ThreadLocal<Cache, CacheTag>>()) {
+    for (size_t i = 0; i < numSlots_; ++i) {
+      depot_[i].store(nullptr, std::memory_order_relaxed);
+    }
+  }
+
+  MagazineObjectPool(const MagazineObjectPool&) = delete;
+  MagazineObjectPool& operator=(const MagazineObjectPool&) = delete;
+
+  /// Must not race with any other call.
+  ~MagazineObjectPool() {
+    // Moves the caches of all threads to the depot.
+    caches_.reset();
+    for (size_t i = 0; i < numSlots_; ++i) {
+      if (auto* magazine = depot_[i].load(std::memory_order_relaxed)) {
+        deallocateAll(*magazine);
+        delete magazine;
+      }
+    }
+  }
+
+  /// Allocate an object
+  /// @param    args        Arguments to forward to T's constructor
+  /// @return               Pointer to object on success.
+  ///
+  /// @throws               any exception thrown while constructing T,
+  ///                       any exception thrown by the allocator while
+  ///                       allocating the object
+  template <typename... Args>
+  T* alloc(Args&&... args) {
+    auto& cache = localCache();
+    increment(cache.allocs);
+    auto* obj = getFromCache(cache);
+    if (obj == nullptr) {
+      increment(cache.allocatorAllocs);
+      obj = std::allocator_traits<Allocator>::allocate(allocator_, 1);
+    }
+
+    try {
+      std::allocator_traits<Allocator>::construct(
+          allocator_, obj, std::forward<Args>(args)...);
+      return obj;
+    } catch (...) {
+      addToCache(cache, obj);
+      throw;
+    }
+  }
+
+  /// Frees the object previously allocated by alloc (on any thread), after
+  /// invoking the destructor. If obj == nullptr it's a NOOP.
+  void free(T* obj) {
+    if (obj == nullptr) {
+      return;
+    }
+    std::allocator_traits<Allocator>::destroy(allocator_, obj);
+    addToCache(localCache(), obj);
+  }
+
+ private:
+  class RecacheDeleter {
+   public:
+    explicit RecacheDeleter(MagazineObjectPool& pool) : pool_(&pool) {}
+
+    void operator()(T* p) {
+      pool_->free(p);
+    }
+
+   private:
+    MagazineObjectPool* pool_;
+  };
+
+ public:
+  using UniquePtr = std::unique_ptr<T, RecacheDeleter>;
+
+  /**
+   * Same as alloc(), but returns a unique_ptr with custom deleter that will
+   * automatically release memory back to the pool on destruction.
+   */
+  template <class... Args>
+  UniquePtr make(Args&&... args) {
+    return takeOwnership(alloc(std::forward<Args>(args)...));
+  }
+
+  /**
+   * Convert a raw T* to a UniquePtr that will automatically release memory back
+   * to the pool on destruction. The caller must ensure that it is appropriate
+   * and safe to deallocate p via this->free().
+   */
+  UniquePtr takeOwnership(T* p) {
+    return UniquePtr(p, RecacheDeleter(*this));
+  }
+
+  /**
+   * Sums up the counters of all threads. Thread-safe, but the result is only
+   * exact if no other thread uses the pool.
+   */
+  Stats stats() const {
+    Stats result;
+    result.allocs = exitedAllocs_.load(std::memory_order_relaxed);
+    result.allocatorAllocs =
+        exitedAllocatorAllocs_.load(std::memory_order_relaxed);
+    result.allocatorDeallocs =
+        exitedAllocatorDeallocs_.load(std::memory_order_relaxed);
+    for (const auto& cache : caches_->accessAllThreads()) {
+      result.allocs += cache.allocs.load(std::memory_order_relaxed);
+      result.allocatorAllocs +=
+          cache.allocatorAllocs.load(std::memory_order_relaxed);
+      result.allocatorDeallocs +=
+          cache.allocatorDeallocs.load(std::memory_order_relaxed);
+    }
+    result.depotMagazines = depotMagazines_.load(std::memory_order_relaxed);
+    return result;
+  }
+
+ private:
+  struct Magazine {
+    std::vector<T*> objects;
+  };
+
+  struct CacheTag {};
+
+  struct Cache {
+    Cache() = default;
+    Cache(const Cache&) = delete;
+    Cache& operator=(const Cache&) = delete;
+
+    ~Cache() {
+      if (pool == nullptr) {
+        return;
+      }
+      pool->retire(std::move(loaded));
+      pool->retire(std::move(previous));
+      pool->exitedAllocs_ += allocs.load(std::memory_order_relaxed);
+      pool->exitedAllocatorAllocs_ +=
+          allocatorAllocs.load(std::memory_order_relaxed);
+      pool->exitedAllocatorDeallocs_ +=
+          allocatorDeallocs.load(std::memory_order_relaxed);
+    }
+
+    MagazineObjectPool* pool{nullptr};
+    std::unique_ptr<Magazine> loaded;
+    std::unique_ptr<Magazine> previous;
+
+    // Only written by the owning thread.
+    std::atomic<uint64_t> allocs{0};
+    std::atomic<uint64_t> allocatorAllocs{0};
+    std::atomic<uint64_t> allocatorDeallocs{0};
+  };
+
+  const size_t magazineSize_;
+  const size_t numSlots_;
+  // Lock-free depot: a magazine is owned by whoever swapped it out of its
+  // slot, so a slot can't be popped twice.
+  std::unique_ptr<std::atomic<Magazine*>[]> depot_;
+  std::atomic<size_t> depotMagazines_{0};
+
+  std::atomic<uint64_t> exitedAllocs_{0};
+  std::atomic<uint64_t> exitedAllocatorAllocs_{0};
+  std::atomic<uint64_t> exitedAllocatorDeallocs_{0};
+
+  Allocator allocator_;
+
+  std::unique_ptr<folly::ThreadLocal<Cache, CacheTag>> caches_;
+
+  static void increment(std::atomic<uint64_t>& counter) {
+    counter.store(
+        counter.load(std::memory_order_relaxed) + 1,
+        std::memory_order_relaxed);
+  }
+
+  Cache& localCache() {
+    auto& cache = **caches_;
+    if (cache.pool == nullptr) {
+      cache.pool = this;
+      cache.loaded = newMagazine();
+      cache.previous = newMagazine();
+    }
+    return cache;
+  }
+
+  std::unique_ptr<Magazine> newMagazine() const {
+    auto magazine = std::make_unique<Magazine>();
+    magazine->objects.reserve(magazineSize_);
+    return magazine;
+  }
+
+  // @return  Memory for an object, nullptr if none is cached.
+  T* getFromCache(Cache& cache) {
+    if (cache.loaded->objects.empty()) {
+      if (!cache.previous->objects.empty()) {
+        std::swap(cache.loaded, cache.previous);
+      } else if (auto full = popFromDepot()) {
+        cache.loaded = std::move(full);
+      } else {
+        return nullptr;
+      }
+    }
+    auto* obj = cache.loaded->objects.back();
+    cache.loaded->objects.pop_back();
+    return obj;
+  }
+
+  // Caches memory of an already destroyed object.
+  void addToCache(Cache& cache, T* obj) noexcept {
+    if (cache.loaded->objects.size() == magazineSize_) {
+      if (cache.previous->objects.size() == magazineSize_) {
+        if (pushToDepot(cache.previous)) {
+          cache.previous = newMagazine();
+        } else {
+          cache.allocatorDeallocs.store(
+              cache.allocatorDeallocs.load(std::memory_order_relaxed) +
+                  cache.previous->objects.size(),
+              std::memory_order_relaxed);
+          deallocateAll(*cache.previous);
+        }
+      }
+      std::swap(cache.loaded, cache.previous);
+    }
+    // Never reallocates, capacity is magazineSize_.
+    cache.loaded->objects.push_back(obj);
+  }
+
+  // Moves a magazine of an exiting thread to the depot.
+  void retire(std::unique_ptr<Magazine> magazine) {
+    if (!magazine || magazine->objects.empty()) {
+      return;
+    }
+    if (!pushToDepot(magazine)) {
+      exitedAllocatorDeallocs_ += magazine->objects.size();
+      deallocateAll(*magazine);
+    }
+  }
+
+  // @return  true if the magazine was moved to the depot, false if the depot
+  //          is full.
+  bool pushToDepot(std::unique_ptr<Magazine>& magazine) {
+    // Counted before it's published, so that the count never underflows.
+    ++depotMagazines_;
+    for (size_t i = 0; i < numSlots_; ++i) {
+      Magazine* expected = nullptr;
+      if (depot_[i].load(std::memory_order_relaxed) == nullptr &&
+          depot_[i].compare_exchange_strong(
+              expected, magazine.get(), std::memory_order_release)) {
+        magazine.release();
+        return true;
+      }
+    }
+    --depotMagazines_;
+    return false;
+  }
+
+  std::unique_ptr<Magazine> popFromDepot() {
+    if (depotMagazines_.load(std::memory_order_relaxed) == 0) {
+      return nullptr;
+    }
+    for (size_t i = 0; i < numSlots_; ++i) {
+      if (depot_[i].load(std::memory_order_relaxed) != nullptr) {
+        if (auto* magazine =
+                depot_[i].exchange(nullptr, std::memory_order_acquire)) {
+          --depotMagazines_;
+          return std::unique_ptr<Magazine>(magazine);
+        }
+      }
+    }
+    return nullptr;
+  }
+
+  void deallocateAll(Magazine& magazine) {
+    for (auto* obj : magazine.objects) {
+      std::allocator_traits<Allocator>::deallocate(allocator_, obj, 1);
+    }
+    magazine.objects.clear();
+  }
+};
+
+} // memcache
+} // facebook
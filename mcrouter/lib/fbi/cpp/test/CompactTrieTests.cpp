@@ -0,0 +1,107 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/lib/fbi/cpp/CompactTrie.h"
+#include "mcrouter/lib/fbi/cpp/Trie.h"
+#include "mcrouter/lib/fbi/cpp/util.h"
+
+using facebook::memcache::CompactTrie;
+using facebook::memcache::Trie;
+
+TEST(CompactTrie, SanityTest) {
+  CompactTrie<int> trie({{"hello", 1}, {"world", 2}, {"!helloo~", 3}});
+
+  EXPECT_EQ(3, trie.size());
+  EXPECT_EQ(1, *trie.find("hello"));
+  EXPECT_EQ(2, *trie.find("world"));
+  EXPECT_EQ(3, *trie.find("!helloo~"));
+
+  EXPECT_EQ(nullptr, trie.find(""));
+  EXPECT_EQ(nullptr, trie.find("hell"));
+  EXPECT_EQ(nullptr, trie.find("helloo"));
+  EXPECT_EQ(nullptr, trie.find("worlds"));
+}
+
+TEST(CompactTrie, Empty) {
+  CompactTrie<int> trie;
+  EXPECT_EQ(0, trie.size());
+  EXPECT_EQ(nullptr, trie.find(""));
+  EXPECT_EQ(nullptr, trie.findPrefix("abc"));
+}
+
+TEST(CompactTrie, FindPrefix) {
+  CompactTrie<int> trie({{"", 0},
+                         {"/a/", 1},
+                         {"/a/b", 2},
+                         {"/a/bcd", 3},
+                         {"/b/", 4},
+                         {"\xff", 5}});
+
+  EXPECT_EQ(0, *trie.findPrefix(""));
+  EXPECT_EQ(0, *trie.findPrefix("/a"));
+  EXPECT_EQ(1, *trie.findPrefix("/a/"));
+  EXPECT_EQ(1, *trie.findPrefix("/a/x"));
+  EXPECT_EQ(2, *trie.findPrefix("/a/bc"));
+  EXPECT_EQ(3, *trie.findPrefix("/a/bcde"));
+  EXPECT_EQ(4, *trie.findPrefix("/b/key"));
+  EXPECT_EQ(5, *trie.findPrefix("\xff\xfe"));
+  EXPECT_EQ(0, *trie.findPrefix("/c/key"));
+
+  CompactTrie<int> noRoot({{"abc", 1}});
+  EXPECT_EQ(nullptr, noRoot.findPrefix("ab"));
+  EXPECT_EQ(nullptr, noRoot.findPrefix("abd"));
+  EXPECT_EQ(1, *noRoot.findPrefix("abcd"));
+}
+
+TEST(CompactTrie, ManyChildren) {
+  // More children than fit in one SIMD comparison.
+  std::vector<std::pair<std::string, int>> items;
+  for (int c = 0; c < 256; ++c) {
+    items.emplace_back(std::string(1, static_cast<char>(c)) + "key", c);
+  }
+  CompactTrie<int> trie(std::move(items));
+  for (int c = 0; c < 256; ++c) {
+    auto key = std::string(1, static_cast<char>(c)) + "key:suffix";
+    ASSERT_NE(nullptr, trie.findPrefix(key));
+    EXPECT_EQ(c, *trie.findPrefix(key));
+  }
+}
+
+TEST(CompactTrie, MatchesTrie) {
+  srand(1234);
+  Trie<int> trie;
+  std::vector<std::string> keys;
+  for (int i = 0; i < 1000; ++i) {
+    keys.push_back(facebook::memcache::randomString(0, 6, "abc"));
+    trie.emplace(keys.back(), i);
+  }
+  auto compact = CompactTrie<int>::fromContainer(trie);
+
+  for (int i = 0; i < 1000; ++i) {
+    auto key = facebook::memcache::randomString(0, 8, "abcd");
+    auto expected = trie.findPrefix(key);
+    auto actual = compact.findPrefix(key);
+    if (expected == trie.end()) {
+      EXPECT_EQ(nullptr, actual);
+    } else {
+      ASSERT_NE(nullptr, actual);
+      EXPECT_EQ(expected->second, *actual);
+    }
+    auto exact = trie.find(key);
+    EXPECT_EQ(exact != trie.end(), compact.find(key) != nullptr);
+  }
+}
+
+TEST(CompactTrie, DuplicateKey) {
+  EXPECT_THROW(CompactTrie<int>({{"a", 1}, {"a", 2}}), std::logic_error);
+}
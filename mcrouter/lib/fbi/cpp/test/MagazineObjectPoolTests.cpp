@@ -0,0 +1,126 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/lib/fbi/cpp/MagazineObjectPool.h"
+
+using namespace facebook::memcache;
+
+namespace {
+
+std::atomic<int> nAllocations{0};
+std::atomic<int> nDeAllocations{0};
+
+template <typename T>
+struct CountingAllocator : public std::allocator<T> {
+  template <typename U>
+  struct rebind {
+    using other = CountingAllocator<U>;
+  };
+
+  T* allocate(size_t n) {
+    ++nAllocations;
+    return std::allocator<T>::allocate(n);
+  }
+
+  void deallocate(T* p, size_t n) {
+    ++nDeAllocations;
+    std::allocator<T>::deallocate(p, n);
+  }
+};
+
+struct TestType {
+  explicit TestType(int v) : val(v) {}
+  int val;
+};
+
+using Pool = MagazineObjectPool<TestType, CountingAllocator<TestType>>;
+
+} // anonymous namespace
+
+TEST(MagazineObjectPool, Basic) {
+  nAllocations = 0;
+  nDeAllocations = 0;
+  {
+    // Depot of 2 magazines of 2 objects.
+    Pool pool(4, 2);
+    std::vector<TestType*> objs;
+    for (int i = 0; i < 10; ++i) {
+      objs.push_back(pool.alloc(i));
+      EXPECT_EQ(i, objs.back()->val);
+    }
+    EXPECT_EQ(10, nAllocations);
+
+    // 4 objects stay in the thread's magazines, 4 in the depot, the rest is
+    // deallocated.
+    for (auto* obj : objs) {
+      pool.free(obj);
+    }
+    auto stats = pool.stats();
+    EXPECT_EQ(10, stats.allocs);
+    EXPECT_EQ(10, stats.allocatorAllocs);
+    EXPECT_EQ(2, stats.allocatorDeallocs);
+    EXPECT_EQ(2, stats.depotMagazines);
+    EXPECT_EQ(2, nDeAllocations);
+
+    objs.clear();
+    for (int i = 0; i < 8; ++i) {
+      objs.push_back(pool.alloc(i));
+    }
+    stats = pool.stats();
+    EXPECT_EQ(18, stats.allocs);
+    EXPECT_EQ(10, stats.allocatorAllocs);
+    EXPECT_EQ(0, stats.depotMagazines);
+    EXPECT_EQ(10, nAllocations);
+
+    auto ptr = pool.make(42);
+    EXPECT_EQ(42, ptr->val);
+    EXPECT_EQ(11, nAllocations);
+    ptr.reset();
+    for (auto* obj : objs) {
+      pool.free(obj);
+    }
+  }
+  EXPECT_EQ(nAllocations, nDeAllocations);
+}
+
+TEST(MagazineObjectPool, ManyThreads) {
+  nAllocations = 0;
+  nDeAllocations = 0;
+  {
+    Pool pool(64, 4);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+      threads.emplace_back([&pool] {
+        for (int i = 0; i < 10000; ++i) {
+          std::vector<TestType*> objs;
+          for (int j = 0; j < i % 11; ++j) {
+            objs.push_back(pool.alloc(j));
+          }
+          for (auto* obj : objs) {
+            pool.free(obj);
+          }
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    // Caches of exited threads are moved to the depot.
+    auto stats = pool.stats();
+    EXPECT_EQ(8 * 10000, stats.allocs);
+    EXPECT_LE(stats.depotMagazines, 16);
+    EXPECT_EQ(nAllocations, stats.allocatorAllocs);
+    EXPECT_EQ(nDeAllocations, stats.allocatorDeallocs);
+  }
+  EXPECT_EQ(nAllocations, nDeAllocations);
+}
@@ -15,8 +15,10 @@
 #include <folly/experimental/StringKeyedUnorderedMap.h>
 #include <folly/init/Init.h>
 
+#include "mcrouter/lib/fbi/cpp/CompactTrie.h"
 #include "mcrouter/lib/fbi/cpp/Trie.h"
 
+using facebook::memcache::CompactTrie;
 using facebook::memcache::Trie;
 
 namespace {
@@ -62,6 +64,7 @@ class KeyPrefixMap : public folly::StringKeyedUnorderedMap<Value> {
 std::vector<std::string> keysToGet[3];
 
 Trie<int> randTrie[3];
+CompactTrie<int> randCompactTrie[3];
 KeyPrefixMap<int> randMap[3];
 int x = 0;
 
@@ -98,6 +101,8 @@ void prepareRand() {
       randMap[i].emplace(keys[i][j], i + j + 1);
     }
 
+    randCompactTrie[i] = CompactTrie<int>::fromContainer(randTrie[i]);
+
     for (size_t j = 0; j < keys[i].size(); ++j) {
       keysToGet[i].push_back(keys[i][j] + ":hit");
     }
@@ -119,6 +124,22 @@ void runGet(Container& c, int id) {
   }
 }
 
+void runGetCompact(const CompactTrie<int>& c, int id) {
+  auto& keys = keysToGet[id];
+  for (size_t i = 0; i < keys.size(); ++i) {
+    auto r = c.find(keys[i]);
+    x += r ? *r : 0;
+  }
+}
+
+void runGetPrefixCompact(const CompactTrie<int>& c, int id) {
+  auto& keys = keysToGet[id];
+  for (size_t i = 0; i < keys.size(); ++i) {
+    auto r = c.findPrefix(keys[i]);
+    x += r ? *r : 0;
+  }
+}
+
 template <class Container>
 void runGetPrefix(Container& c, int id) {
   auto& keys = keysToGet[id];
@@ -138,6 +159,10 @@ BENCHMARK_RELATIVE(Map_get0) {
   runGet(randMap[0], 0);
 }
 
+BENCHMARK_RELATIVE(CompactTrie_get0) {
+  runGetCompact(randCompactTrie[0], 0);
+}
+
 BENCHMARK(Trie_get1) {
   runGet(randTrie[1], 1);
 }
@@ -146,6 +171,10 @@ BENCHMARK_RELATIVE(Map_get1) {
   runGet(randMap[1], 1);
 }
 
+BENCHMARK_RELATIVE(CompactTrie_get1) {
+  runGetCompact(randCompactTrie[1], 1);
+}
+
 BENCHMARK(Trie_get2) {
   runGet(randTrie[2], 2);
 }
@@ -154,6 +183,10 @@ BENCHMARK_RELATIVE(Map_get2) {
   runGet(randMap[2], 2);
 }
 
+BENCHMARK_RELATIVE(CompactTrie_get2) {
+  runGetCompact(randCompactTrie[2], 2);
+}
+
 BENCHMARK(Trie_get_prefix0) {
   runGetPrefix(randTrie[0], 0);
 }
@@ -162,6 +195,10 @@ BENCHMARK_RELATIVE(Map_get_prefix0) {
   runGet(randMap[0], 0);
 }
 
+BENCHMARK_RELATIVE(CompactTrie_get_prefix0) {
+  runGetPrefixCompact(randCompactTrie[0], 0);
+}
+
 BENCHMARK(Trie_get_prefix1) {
   runGetPrefix(randTrie[1], 1);
 }
@@ -170,6 +207,10 @@ BENCHMARK_RELATIVE(Map_get_prefix1) {
   runGet(randMap[1], 1);
 }
 
+BENCHMARK_RELATIVE(CompactTrie_get_prefix1) {
+  runGetPrefixCompact(randCompactTrie[1], 1);
+}
+
 BENCHMARK(Trie_get_prefix2) {
   runGetPrefix(randTrie[2], 2);
 }
@@ -178,6 +219,10 @@ BENCHMARK_RELATIVE(Map_get_prefix2) {
   runGet(randMap[2], 2);
 }
 
+BENCHMARK_RELATIVE(CompactTrie_get_prefix2) {
+  runGetPrefixCompact(randCompactTrie[2], 2);
+}
+
 int main(int argc, char** argv) {
   folly::init(&argc, &argv, true /* removeFlags */);
   prepareRand();
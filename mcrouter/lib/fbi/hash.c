@@ -274,16 +274,15 @@ static const unsigned int crc32tab[256] = {
     0xb40bbe37, 0xc30c8ea1, 0x5a05df1b, 0x2d02ef8d,
 };
 
-uint32_t crc32_hash(const char* const key, const size_t len) {
-	uint32_t crc;
-	unsigned int i;
-
-	crc = ~0;
+uint32_t crc32_update(uint32_t crc, const char* const key, const size_t len) {
+  size_t i;
 
-	for (i = 0; i < len; i++) {
-        crc = (crc >> 8) ^ crc32tab[(crc ^ (key[i])) & 0xff];
-    }
+  for (i = 0; i < len; i++) {
+    crc = (crc >> 8) ^ crc32tab[(crc ^ (key[i])) & 0xff];
+  }
+  return crc;
+}
 
-	//crc = (~crc >> 16) & 0x7fff;
-    return (~crc);
+uint32_t crc32_hash(const char* const key, const size_t len) {
+  return ~crc32_update(~0, key, len);
 }
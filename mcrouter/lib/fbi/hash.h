@@ -62,6 +62,12 @@ murmur_hash_64A(const void* const key, const size_t len, const uint32_t seed);
  */
 uint32_t crc32_hash(const char* const key, const size_t len);
 
+/**
+ * Feeds |len| more characters of |key| to a CRC32 computation in progress.
+ * crc32_hash(key, len) == ~crc32_update(~0, key, len).
+ */
+uint32_t crc32_update(uint32_t crc, const char* const key, const size_t len);
+
 __END_DECLS
 
 #endif /* #if !defined(_facebook_ch_hash_h_) */
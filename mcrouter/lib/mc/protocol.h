@@ -23,6 +23,8 @@ typedef enum mc_protocol_e {
   mc_binary_protocol = 2,
   mc_umbrella_protocol_DONOTUSE = 3, /* New code should use Caret or ASCII */
   mc_caret_protocol = 4,
+  /* ASCII with memcached meta commands (mg/ms/md), client only */
+  mc_meta_protocol = 5,
   mc_nprotocols, // placeholder
 } mc_protocol_t;
 
@@ -35,6 +37,8 @@ static inline mc_protocol_t mc_string_to_protocol(const char* str) {
     return mc_umbrella_protocol_DONOTUSE;
   } else if (!strcmp(str, "caret")) {
     return mc_caret_protocol;
+  } else if (!strcmp(str, "meta")) {
+    return mc_meta_protocol;
   } else {
     return mc_unknown_protocol;
   }
@@ -42,7 +46,7 @@ static inline mc_protocol_t mc_string_to_protocol(const char* str) {
 
 static inline const char* mc_protocol_to_string(const mc_protocol_t value) {
   static const char* const strings[] = {
-      "unknown-protocol", "ascii", "binary", "umbrella", "caret",
+      "unknown-protocol", "ascii", "binary", "umbrella", "caret", "meta",
   };
   return strings[value < mc_nprotocols ? value : mc_unknown_protocol];
 }
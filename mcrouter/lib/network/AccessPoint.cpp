@@ -7,8 +7,12 @@
  */
 #include "AccessPoint.h"
 
+#include <mutex>
+#include <unordered_map>
+
 #include <folly/Conv.h>
 #include <folly/IPAddress.h>
+#include <folly/hash/Hash.h>
 
 #include "mcrouter/lib/fbi/cpp/util.h"
 
@@ -67,10 +71,77 @@ mc_protocol_t parseProtocol(folly::StringPiece str) {
     return mc_caret_protocol;
   } else if (str == "umbrella") {
     return mc_umbrella_protocol_DONOTUSE;
+  } else if (str == "meta") {
+    return mc_meta_protocol;
+  } else if (str == "binary") {
+    return mc_binary_protocol;
   }
   throw std::runtime_error("Invalid protocol");
 }
 
+/**
+ * Interned AccessPoints, compared by value. Entries are removed by the
+ * deleter of the interned AccessPoint.
+ */
+class AccessPointInterner {
+ public:
+  std::shared_ptr<const AccessPoint> intern(const AccessPoint& ap) {
+    const Key key{&ap, ap.hash()};
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = accessPoints_.find(key);
+    if (it != accessPoints_.end()) {
+      if (auto existing = it->second.lock()) {
+        return existing;
+      }
+      // Being destroyed; its deleter is waiting for the lock.
+      accessPoints_.erase(it);
+    }
+    auto* copy = new AccessPoint(ap);
+    std::shared_ptr<const AccessPoint> result(
+        copy, [this](const AccessPoint* interned) { remove(interned); });
+    accessPoints_.emplace(Key{copy, key.hash}, result);
+    return result;
+  }
+
+ private:
+  struct Key {
+    const AccessPoint* accessPoint;
+    size_t hash;
+  };
+  struct KeyHash {
+    size_t operator()(const Key& key) const {
+      return key.hash;
+    }
+  };
+  struct KeyEqual {
+    bool operator()(const Key& a, const Key& b) const {
+      return *a.accessPoint == *b.accessPoint;
+    }
+  };
+
+  std::mutex mutex_;
+  std::unordered_map<Key, std::weak_ptr<const AccessPoint>, KeyHash, KeyEqual>
+      accessPoints_;
+
+  void remove(const AccessPoint* interned) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = accessPoints_.find(Key{interned, interned->hash()});
+      // Might have been replaced already, see intern().
+      if (it != accessPoints_.end() && it->first.accessPoint == interned) {
+        accessPoints_.erase(it);
+      }
+    }
+    delete interned;
+  }
+};
+
+AccessPointInterner& accessPointInterner() {
+  // Leaked: interned AccessPoints may outlive static destruction.
+  static auto* interner = new AccessPointInterner();
+  return *interner;
+}
+
 } // anonymous
 
 AccessPoint::AccessPoint(
@@ -161,6 +232,27 @@ std::shared_ptr<AccessPoint> AccessPoint::create(
   }
 }
 
+std::shared_ptr<const AccessPoint> AccessPoint::intern(const AccessPoint& ap) {
+  return accessPointInterner().intern(ap);
+}
+
+bool AccessPoint::operator==(const AccessPoint& other) const {
+  return host_ == other.host_ && port_ == other.port_ &&
+      protocol_ == other.protocol_ && useSsl_ == other.useSsl_ &&
+      compressed_ == other.compressed_ && isV6_ == other.isV6_ &&
+      unixDomainSocket_ == other.unixDomainSocket_;
+}
+
+size_t AccessPoint::hash() const {
+  return folly::hash::hash_combine(
+      host_,
+      port_,
+      static_cast<int>(protocol_),
+      useSsl_,
+      compressed_,
+      unixDomainSocket_);
+}
+
 void AccessPoint::disableCompression() {
   compressed_ = false;
 }
@@ -45,6 +45,21 @@ struct AccessPoint {
       uint16_t portOverride = 0,
       bool defaultCompressed = false);
 
+  /**
+   * @return the process-wide AccessPoint equal to ap. Interned AccessPoints
+   *         are shared by all proxies and configs using them, so they may be
+   *         compared and hashed by address. Thread-safe.
+   */
+  static std::shared_ptr<const AccessPoint> intern(const AccessPoint& ap);
+
+  bool operator==(const AccessPoint& other) const;
+
+  bool operator!=(const AccessPoint& other) const {
+    return !(*this == other);
+  }
+
+  size_t hash() const;
+
   const std::string& getHost() const {
     return host_;
   }
@@ -29,6 +29,30 @@ struct AsciiSerializedRequest::PrepareImplWrapper {
     s.prepareImpl(request);
     return true;
   }
+
+  template <class Request>
+  using PrepareMetaType =
+      decltype(std::declval<AsciiSerializedRequest>().prepareMetaImpl(
+          std::declval<const Request&>()));
+
+  template <class Request>
+  typename std::enable_if<
+      std::is_same<PrepareMetaType<Request>, std::false_type>::value,
+      bool>::type static prepareMeta(
+      AsciiSerializedRequest& s,
+      const Request& request) {
+    return prepare(s, request);
+  }
+
+  template <class Request>
+  typename std::enable_if<
+      std::is_same<PrepareMetaType<Request>, void>::value,
+      bool>::type static prepareMeta(
+      AsciiSerializedRequest& s,
+      const Request& request) {
+    s.prepareMetaImpl(request);
+    return true;
+  }
 };
 
 template <class Arg1, class Arg2>
@@ -55,6 +79,18 @@ bool AsciiSerializedRequest::prepare(
   return r;
 }
 
+template <class Request>
+bool AsciiSerializedRequest::prepareMeta(
+    const Request& request,
+    const struct iovec*& iovOut,
+    size_t& niovOut) {
+  iovsCount_ = 0;
+  auto r = PrepareImplWrapper::prepareMeta(*this, request);
+  iovOut = iovs_;
+  niovOut = iovsCount_;
+  return r;
+}
+
 template <class Arg1, class Arg2>
 void AsciiSerializedReply::addStrings(Arg1&& arg1, Arg2&& arg2) {
   addString(std::forward<Arg1>(arg1));
@@ -7,6 +7,10 @@
  */
 #include "AsciiSerialized.h"
 
+#include <cstring>
+
+#include <folly/Conv.h>
+
 #include "mcrouter/lib/IOBufUtil.h"
 #include "mcrouter/lib/McResUtil.h"
 
@@ -25,25 +29,39 @@ void AsciiSerializedRequest::addString(folly::StringPiece str) {
   addString(folly::ByteRange(str));
 }
 
+void AsciiSerializedRequest::addValue(const folly::IOBuf& value) {
+  // Reference every buffer of a chained value instead of coalescing it: the
+  // same request is often serialized for many destinations (All*Route,
+  // ShadowRoute), and coalescing copies of it would copy the value each time.
+  // One iovec is left for the trailing "\r\n".
+  const auto nFilled =
+      value.fillIov(iovs_ + iovsCount_, kMaxIovs - iovsCount_ - 1);
+  if (nFilled > 0 || value.empty()) {
+    iovsCount_ += nFilled;
+    return;
+  }
+  // Too many buffers, fall back to coalescing.
+  addString(coalesceAndGetRange(const_cast<folly::IOBuf&>(value)));
+}
+
 template <class Request>
 void AsciiSerializedRequest::keyValueRequestCommon(
     folly::StringPiece prefix,
     const Request& request) {
-  auto value = coalesceAndGetRange(const_cast<folly::IOBuf&>(request.value()));
   auto len = snprintf(
       printBuffer_,
       kMaxBufferLength,
       " %lu %d %zd\r\n",
       request.flags(),
       request.exptime(),
-      value.size());
+      request.value().computeChainDataLength());
   assert(len > 0 && static_cast<size_t>(len) < kMaxBufferLength);
   addStrings(
       prefix,
       request.key().fullKey(),
-      folly::StringPiece(printBuffer_, static_cast<size_t>(len)),
-      value,
-      "\r\n");
+      folly::StringPiece(printBuffer_, static_cast<size_t>(len)));
+  addValue(request.value());
+  addString("\r\n");
 }
 
 // Get-like ops.
@@ -85,26 +103,24 @@ void AsciiSerializedRequest::prepareImpl(const McPrependRequest& request) {
 }
 
 void AsciiSerializedRequest::prepareImpl(const McCasRequest& request) {
-  auto value = coalesceAndGetRange(const_cast<folly::IOBuf&>(request.value()));
   auto len = snprintf(
       printBuffer_,
       kMaxBufferLength,
       " %lu %d %zd %lu\r\n",
       request.flags(),
       request.exptime(),
-      value.size(),
+      request.value().computeChainDataLength(),
       request.casToken());
   assert(len > 0 && static_cast<size_t>(len) < kMaxBufferLength);
   addStrings(
       "cas ",
       request.key().fullKey(),
-      folly::StringPiece(printBuffer_, static_cast<size_t>(len)),
-      value,
-      "\r\n");
+      folly::StringPiece(printBuffer_, static_cast<size_t>(len)));
+  addValue(request.value());
+  addString("\r\n");
 }
 
 void AsciiSerializedRequest::prepareImpl(const McLeaseSetRequest& request) {
-  auto value = coalesceAndGetRange(const_cast<folly::IOBuf&>(request.value()));
   auto len = snprintf(
       printBuffer_,
       kMaxBufferLength,
@@ -112,14 +128,14 @@ void AsciiSerializedRequest::prepareImpl(const McLeaseSetRequest& request) {
       request.leaseToken(),
       request.flags(),
       request.exptime(),
-      value.size());
+      request.value().computeChainDataLength());
   assert(len > 0 && static_cast<size_t>(len) < kMaxBufferLength);
   addStrings(
       "lease-set ",
       request.key().fullKey(),
-      folly::StringPiece(printBuffer_, static_cast<size_t>(len)),
-      value,
-      "\r\n");
+      folly::StringPiece(printBuffer_, static_cast<size_t>(len)));
+  addValue(request.value());
+  addString("\r\n");
 }
 
 // Arithmetic ops.
@@ -184,6 +200,84 @@ void AsciiSerializedRequest::prepareImpl(const McFlushAllRequest& request) {
   addString("\r\n");
 }
 
+// Meta commands.
+template <class Request>
+void AsciiSerializedRequest::metaSetCommon(
+    const char* mode,
+    const Request& request) {
+  auto len = snprintf(
+      printBuffer_,
+      kMaxBufferLength,
+      " %zd F%lu T%d%s\r\n",
+      request.value().computeChainDataLength(),
+      request.flags(),
+      request.exptime(),
+      mode);
+  assert(len > 0 && static_cast<size_t>(len) < kMaxBufferLength);
+  addStrings(
+      "ms ",
+      request.key().fullKey(),
+      folly::StringPiece(printBuffer_, static_cast<size_t>(len)));
+  addValue(request.value());
+  addString("\r\n");
+}
+
+void AsciiSerializedRequest::prepareMetaImpl(const McGetRequest& request) {
+  addStrings("mg ", request.key().fullKey(), " v f\r\n");
+}
+
+void AsciiSerializedRequest::prepareMetaImpl(const McGetsRequest& request) {
+  addStrings("mg ", request.key().fullKey(), " v f c\r\n");
+}
+
+void AsciiSerializedRequest::prepareMetaImpl(const McSetRequest& request) {
+  metaSetCommon("", request);
+}
+
+void AsciiSerializedRequest::prepareMetaImpl(const McAddRequest& request) {
+  metaSetCommon(" ME", request);
+}
+
+void AsciiSerializedRequest::prepareMetaImpl(const McReplaceRequest& request) {
+  metaSetCommon(" MR", request);
+}
+
+void AsciiSerializedRequest::prepareMetaImpl(const McAppendRequest& request) {
+  metaSetCommon(" MA", request);
+}
+
+void AsciiSerializedRequest::prepareMetaImpl(const McPrependRequest& request) {
+  metaSetCommon(" MP", request);
+}
+
+void AsciiSerializedRequest::prepareMetaImpl(const McCasRequest& request) {
+  auto len = snprintf(
+      printBuffer_,
+      kMaxBufferLength,
+      " %zd F%lu T%d C%lu\r\n",
+      request.value().computeChainDataLength(),
+      request.flags(),
+      request.exptime(),
+      request.casToken());
+  assert(len > 0 && static_cast<size_t>(len) < kMaxBufferLength);
+  addStrings(
+      "ms ",
+      request.key().fullKey(),
+      folly::StringPiece(printBuffer_, static_cast<size_t>(len)));
+  addValue(request.value());
+  addString("\r\n");
+}
+
+void AsciiSerializedRequest::prepareMetaImpl(const McDeleteRequest& request) {
+  if (request.exptime() != 0) {
+    // md has no equivalent of the delete delay, the reply parser accepts both
+    // forms.
+    prepareImpl(request);
+    return;
+  }
+  addStrings("md ", request.key().fullKey(), "\r\n");
+}
+
 void AsciiSerializedReply::clear() {
   iovsCount_ = 0;
   iobuf_.clear();
@@ -202,6 +296,38 @@ void AsciiSerializedReply::addString(folly::StringPiece str) {
   addString(folly::ByteRange(str));
 }
 
+void AsciiSerializedReply::addValueHeader(
+    folly::StringPiece prefix,
+    folly::StringPiece key,
+    std::initializer_list<uint64_t> numbers) {
+  // " " + up to 20 digits per number, then "\r\n".
+  constexpr size_t kMaxNumbersLength = 3 * 21 + 2;
+  assert(numbers.size() <= 3);
+
+  char* pos = printBuffer_;
+  const bool keyFits =
+      prefix.size() + key.size() + kMaxNumbersLength <= kMaxBufferLength;
+  if (keyFits) {
+    std::memcpy(pos, prefix.data(), prefix.size());
+    pos += prefix.size();
+    std::memcpy(pos, key.data(), key.size());
+    pos += key.size();
+  }
+  for (auto number : numbers) {
+    *pos++ = ' ';
+    pos += folly::uint64ToBufferUnsafe(number, pos);
+  }
+  *pos++ = '\r';
+  *pos++ = '\n';
+
+  folly::StringPiece formatted(printBuffer_, pos);
+  if (keyFits) {
+    addString(formatted);
+  } else {
+    addStrings(prefix, key, formatted);
+  }
+}
+
 void AsciiSerializedReply::handleError(
     mc_res_t result,
     uint16_t errorCode,
@@ -263,20 +389,7 @@ void AsciiSerializedReply::prepareImpl(
       addString("END\r\n");
     } else {
       const auto valueStr = coalesceAndGetRange(reply.value());
-
-      const auto len = snprintf(
-          printBuffer_,
-          kMaxBufferLength,
-          " %lu %zu\r\n",
-          reply.flags(),
-          valueStr.size());
-      assert(len > 0);
-      assert(static_cast<size_t>(len) < kMaxBufferLength);
-
-      addStrings(
-          "VALUE ",
-          key,
-          folly::StringPiece(printBuffer_, static_cast<size_t>(len)));
+      addValueHeader("VALUE ", key, {reply.flags(), valueStr.size()});
       assert(!iobuf_.hasValue());
       // value was coalesced in coalesceAndGetRange()
       iobuf_ = std::move(reply.value());
@@ -297,20 +410,8 @@ void AsciiSerializedReply::prepareImpl(
     folly::StringPiece key) {
   if (isHitResult(reply.result())) {
     const auto valueStr = coalesceAndGetRange(reply.value());
-    const auto len = snprintf(
-        printBuffer_,
-        kMaxBufferLength,
-        " %lu %zu %lu\r\n",
-        reply.flags(),
-        valueStr.size(),
-        reply.casToken());
-    assert(len > 0);
-    assert(static_cast<size_t>(len) < kMaxBufferLength);
-
-    addStrings(
-        "VALUE ",
-        key,
-        folly::StringPiece(printBuffer_, static_cast<size_t>(len)));
+    addValueHeader(
+        "VALUE ", key, {reply.flags(), valueStr.size(), reply.casToken()});
     assert(!iobuf_.hasValue());
     // value was coalesced in coalescedAndGetRange()
     iobuf_ = std::move(reply.value());
@@ -383,35 +484,18 @@ void AsciiSerializedReply::prepareImpl(
   const auto valueStr = coalesceAndGetRange(reply.value());
 
   if (reply.result() == mc_res_found) {
-    const auto len = snprintf(
-        printBuffer_,
-        kMaxBufferLength,
-        " %lu %zu\r\n",
-        reply.flags(),
-        valueStr.size());
-    assert(len > 0);
-    assert(static_cast<size_t>(len) < kMaxBufferLength);
-
-    addStrings(
-        "VALUE ",
-        key,
-        folly::StringPiece(printBuffer_, static_cast<size_t>(len)));
+    addValueHeader("VALUE ", key, {reply.flags(), valueStr.size()});
     assert(!iobuf_.hasValue());
     // value was coalesced in coalescedAndGetRange()
     iobuf_ = std::move(reply.value());
     addStrings(valueStr, "\r\n");
   } else if (reply.result() == mc_res_notfound) {
-    const auto len = snprintf(
-        printBuffer_,
-        kMaxBufferLength,
-        " %lu %lu %zu\r\n",
-        reply.leaseToken(),
-        reply.flags(),
-        valueStr.size());
-    addStrings(
+    addValueHeader(
         "LVALUE ",
         key,
-        folly::StringPiece(printBuffer_, static_cast<size_t>(len)));
+        {static_cast<uint64_t>(reply.leaseToken()),
+         reply.flags(),
+         valueStr.size()});
     iobuf_ = std::move(reply.value());
     addStrings(valueStr, "\r\n");
   } else if (reply.result() == mc_res_notfoundhot) {
@@ -7,6 +7,8 @@
  */
 #pragma once
 
+#include <initializer_list>
+
 #include <folly/Optional.h>
 #include <folly/Range.h>
 
@@ -43,13 +45,26 @@ class AsciiSerializedRequest {
   bool
   prepare(const Request& request, const struct iovec*& iovOut, size_t& niovOut);
 
+  /**
+   * Same as prepare(), but uses memcached meta commands (mg, ms, md) for the
+   * requests that have one. Other requests use the classic commands, which
+   * memcached accepts on the same connection.
+   */
+  template <class Request>
+  bool prepareMeta(
+      const Request& request,
+      const struct iovec*& iovOut,
+      size_t& niovOut);
+
  private:
-  // We need at most 5 iovecs (lease-set):
+  // We need at least 5 iovecs (lease-set):
   //   command + key + printBuffer + value + "\r\n"
-  static constexpr size_t kMaxIovs = 8;
-  // The longest print buffer we need is for lease-set/cas operations.
-  // It requires 2 uint64, 2 uint32 + 4 spaces + "\r\n" + '\0' = 67 chars.
-  static constexpr size_t kMaxBufferLength = 80;
+  // The rest is used for values made of several IOBufs.
+  static constexpr size_t kMaxIovs = 16;
+  // The longest print buffer we need is for meta cas (ms with C).
+  // It requires 3 uint64, 1 int32 + 4 spaces + "F", "T", "C" + "\r\n" + '\0'
+  // = 82 chars.
+  static constexpr size_t kMaxBufferLength = 96;
 
   struct iovec iovs_[kMaxIovs];
   size_t iovsCount_{0};
@@ -57,6 +72,7 @@ class AsciiSerializedRequest {
 
   void addString(folly::ByteRange range);
   void addString(folly::StringPiece str);
+  void addValue(const folly::IOBuf& value);
 
   template <class Arg1, class Arg2>
   void addStrings(Arg1&& arg1, Arg2&& arg2);
@@ -95,6 +111,24 @@ class AsciiSerializedRequest {
   template <class Request>
   std::false_type prepareImpl(const Request& request);
 
+  template <class Request>
+  void metaSetCommon(const char* mode, const Request& request);
+
+  // Meta commands.
+  void prepareMetaImpl(const McGetRequest& request);
+  void prepareMetaImpl(const McGetsRequest& request);
+  void prepareMetaImpl(const McSetRequest& request);
+  void prepareMetaImpl(const McAddRequest& request);
+  void prepareMetaImpl(const McReplaceRequest& request);
+  void prepareMetaImpl(const McAppendRequest& request);
+  void prepareMetaImpl(const McPrependRequest& request);
+  void prepareMetaImpl(const McCasRequest& request);
+  void prepareMetaImpl(const McDeleteRequest& request);
+
+  // Everything else uses the classic command.
+  template <class Request>
+  std::false_type prepareMetaImpl(const Request& request);
+
   struct PrepareImplWrapper;
 };
 
@@ -147,9 +181,17 @@ class AsciiSerializedReply {
     return true;
   }
 
+  /**
+   * @return  IOBuf field of the serialized reply (if any).
+   */
+  const folly::IOBuf* valueBuf() const {
+    return iobuf_.get_pointer();
+  }
+
  private:
-  // See comment in prepareImpl for McMetagetReply for explanation
-  static constexpr size_t kMaxBufferLength = 100;
+  // Large enough for the metaget reply (see prepareImpl for McMetagetReply),
+  // and for value headers (see addValueHeader) of keys up to ~120 chars.
+  static constexpr size_t kMaxBufferLength = 192;
 
   static const size_t kMaxIovs = 16;
   struct iovec iovs_[kMaxIovs];
@@ -171,6 +213,16 @@ class AsciiSerializedReply {
   template <class Arg, class... Args>
   void addStrings(Arg&& arg, Args&&... args);
 
+  /**
+   * Adds "<prefix><key> <number>...\r\n" (e.g. "VALUE key flags length")
+   * formatted into printBuffer_, as a single iovec if the key fits.
+   * At most three numbers.
+   */
+  void addValueHeader(
+      folly::StringPiece prefix,
+      folly::StringPiece key,
+      std::initializer_list<uint64_t> numbers);
+
   // Get-like ops
   void prepareImpl(McGetReply&& reply, folly::StringPiece key);
   void prepareImpl(McGetsReply&& reply, folly::StringPiece key);
@@ -30,17 +30,19 @@ inline void AsyncMcClient::setStatusCallbacks(
 
 inline void AsyncMcClient::setRequestStatusCallbacks(
     std::function<void(int pendingDiff, int inflightDiff)> onStateChange,
-    std::function<void(int numToSend)> onWrite) {
+    std::function<void(int numToSend)> onWrite,
+    std::function<void(size_t numWrites)> onWritesDone) {
   base_->setRequestStatusCallbacks(
-      std::move(onStateChange), std::move(onWrite));
+      std::move(onStateChange), std::move(onWrite), std::move(onWritesDone));
 }
 
 template <class Request>
 ReplyT<Request> AsyncMcClient::sendSync(
     const Request& request,
     std::chrono::milliseconds timeout,
-    ReplyStatsContext* replyContext) {
-  return base_->sendSync(request, timeout, replyContext);
+    ReplyStatsContext* replyContext,
+    bool lowPriority) {
+  return base_->sendSync(request, timeout, replyContext, lowPriority);
 }
 
 inline void AsyncMcClient::setThrottle(size_t maxInflight, size_t maxPending) {
@@ -79,21 +79,29 @@ class AsyncMcClient {
    *                          write data to network. The numToSend argument
    *                          holds the number of requests that will be sent in
    *                          a single batch.
+   * @param onWritesDone      Will be called after such a batch was handed to
+   *                          the socket, with the number of socket writes it
+   *                          took.
    */
   void setRequestStatusCallbacks(
       std::function<void(int pendingDiff, int inflightDiff)> onStateChange,
-      std::function<void(int numToSend)> onWrite);
+      std::function<void(int numToSend)> onWrite,
+      std::function<void(size_t numWrites)> onWritesDone = nullptr);
 
   /**
    * Send request synchronously (i.e. blocking call).
    * Note: it must be called only from fiber context. It will block the current
    *       stack and will send request only when we loop EventBase.
+   *
+   * @param lowPriority  Requests waiting to be sent are sent before any
+   *                     low priority ones, regardless of arrival order.
    */
   template <class Request>
   ReplyT<Request> sendSync(
       const Request& request,
       std::chrono::milliseconds timeout,
-      ReplyStatsContext* replyContext = nullptr);
+      ReplyStatsContext* replyContext = nullptr,
+      bool lowPriority = false);
 
   /**
    * Set throttling options.
@@ -5,6 +5,7 @@
  *  file in the root directory of this source tree.
  *
  */
+#include "mcrouter/lib/McTracepoints.h"
 #include "mcrouter/lib/Reply.h"
 #include "mcrouter/lib/network/FBTrace.h"
 #include "mcrouter/lib/network/ReplyStatsContext.h"
@@ -16,7 +17,8 @@ template <class Request>
 ReplyT<Request> AsyncMcClientImpl::sendSync(
     const Request& request,
     std::chrono::milliseconds timeout,
-    ReplyStatsContext* replyContext) {
+    ReplyStatsContext* replyContext,
+    bool lowPriority) {
   DestructorGuard dg(this);
 
   assert(folly::fibers::onFiber());
@@ -41,7 +43,11 @@ ReplyT<Request> AsyncMcClientImpl::sendSync(
       queue_,
       [](ParserT& parser) { parser.expectNext<Request>(); },
       requestStatusCallbacks_.onStateChange,
-      supportedCompressionCodecs_);
+      supportedCompressionCodecs_,
+      timeout,
+      requestCompressionCodecMap_,
+      connectionOptions_.compressionOffload);
+  ctx.lowPriority = lowPriority;
   sendCommon(ctx);
 
   // Wait for the reply.
@@ -66,7 +72,14 @@ void AsyncMcClientImpl::replyReady(
   assert(connectionState_ == ConnectionState::UP);
   DestructorGuard dg(this);
 
+  // The server advertises its credit window with every reply, and every
+  // reply gives a credit back.
+  serverCreditWindow_ = parser_->getCreditWindow();
+  MC_TRACEPOINT(client_reply, this, reqId, static_cast<int>(r.result()));
   queue_.reply(reqId, std::move(r), replyStatsContext);
+  if (serverCreditWindow_ != 0) {
+    scheduleNextWriterLoop();
+  }
 }
 
 template <class Request>
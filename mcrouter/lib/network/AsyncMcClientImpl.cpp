@@ -9,6 +9,7 @@
 
 #include <netinet/tcp.h>
 
+#include <algorithm>
 #include <memory>
 
 #include <folly/SingletonThreadLocal.h>
@@ -16,8 +17,11 @@
 #include <folly/io/async/AsyncSSLSocket.h>
 #include <folly/io/async/EventBase.h>
 
+#include "mcrouter/lib/IOBufUtil.h"
+#include "mcrouter/lib/McTracepoints.h"
 #include "mcrouter/lib/debug/FifoManager.h"
 #include "mcrouter/lib/fbi/cpp/LogFailure.h"
+#include "mcrouter/lib/network/CaretBatcher.h"
 #include "mcrouter/lib/network/McSSLUtil.h"
 #include "mcrouter/lib/network/ThreadLocalSSLContextProvider.h"
 
@@ -26,8 +30,7 @@ namespace memcache {
 
 constexpr size_t kReadBufferSizeMin = 256;
 constexpr size_t kReadBufferSizeMax = 4096;
-constexpr size_t kStackIovecs = 128;
-constexpr size_t kMaxBatchSize = 24576 /* 24KB */;
+constexpr size_t kMinWriteBatchIovecs = 16;
 
 namespace {
 class OnEventBaseDestructionCallback : public folly::EventBase::LoopCallback {
@@ -71,6 +74,11 @@ inline size_t calculateIovecsTotalSize(const struct iovec* iovecs, size_t num) {
   return size;
 }
 
+// Replies of text protocols come in the order of requests.
+inline bool isInOrderProtocol(mc_protocol_t protocol) {
+  return protocol == mc_ascii_protocol || protocol == mc_meta_protocol;
+}
+
 std::string getServiceIdentity(const ConnectionOptions& opts) {
   return opts.sslServiceIdentity.empty() ? opts.accessPoint->toHostPortString()
                                          : opts.sslServiceIdentity;
@@ -94,16 +102,24 @@ AsyncMcClientImpl::AsyncMcClientImpl(
     folly::VirtualEventBase& eventBase,
     ConnectionOptions options)
     : eventBase_(eventBase.getEventBase()),
-      queue_(options.accessPoint->getProtocol() != mc_ascii_protocol),
-      outOfOrder_(options.accessPoint->getProtocol() != mc_ascii_protocol),
+      queue_(!isInOrderProtocol(options.accessPoint->getProtocol())),
+      outOfOrder_(!isInOrderProtocol(options.accessPoint->getProtocol())),
       writer_(*this),
       connectionOptions_(std::move(options)),
+      writeIovecs_(std::max<size_t>(
+          connectionOptions_.maxWriteBatchIovecs, kMinWriteBatchIovecs)),
       eventBaseDestructionCallback_(
           std::make_unique<OnEventBaseDestructionCallback>(*this)) {
   eventBase.runOnDestruction(eventBaseDestructionCallback_.get());
+  batchCaretRequests_ = connectionOptions_.batchCaretRequests &&
+      connectionOptions_.accessPoint->getProtocol() == mc_caret_protocol;
   if (connectionOptions_.compressionCodecMap) {
     supportedCompressionCodecs_ =
         connectionOptions_.compressionCodecMap->getIdRange();
+    if (connectionOptions_.compressRequests &&
+        connectionOptions_.accessPoint->getProtocol() == mc_caret_protocol) {
+      requestCompressionCodecMap_ = connectionOptions_.compressionCodecMap;
+    }
   }
 }
 
@@ -143,11 +159,13 @@ void AsyncMcClientImpl::setStatusCallbacks(
 
 void AsyncMcClientImpl::setRequestStatusCallbacks(
     std::function<void(int pendingDiff, int inflightDiff)> onStateChange,
-    std::function<void(int numToSend)> onWrite) {
+    std::function<void(int numToSend)> onWrite,
+    std::function<void(size_t numWrites)> onWritesDone) {
   DestructorGuard dg(this);
 
-  requestStatusCallbacks_ =
-      RequestStatusCallbacks{std::move(onStateChange), std::move(onWrite)};
+  requestStatusCallbacks_ = RequestStatusCallbacks{std::move(onStateChange),
+                                                   std::move(onWrite),
+                                                   std::move(onWritesDone)};
 }
 
 AsyncMcClientImpl::~AsyncMcClientImpl() {
@@ -196,11 +214,17 @@ void AsyncMcClientImpl::sendCommon(McClientRequestContextBase& req) {
 
 size_t AsyncMcClientImpl::getNumToSend() const {
   size_t numToSend = queue_.getPendingRequestCount();
-  if (maxInflight_ != 0) {
-    if (maxInflight_ <= getInflightRequestCount()) {
+  size_t maxInflight = maxInflight_;
+  if (serverCreditWindow_ != 0) {
+    maxInflight = maxInflight == 0
+        ? serverCreditWindow_
+        : std::min(maxInflight, serverCreditWindow_);
+  }
+  if (maxInflight != 0) {
+    if (maxInflight <= getInflightRequestCount()) {
       numToSend = 0;
     } else {
-      numToSend = std::min(numToSend, maxInflight_ - getInflightRequestCount());
+      numToSend = std::min(numToSend, maxInflight - getInflightRequestCount());
     }
   }
   return numToSend;
@@ -232,17 +256,21 @@ void AsyncMcClientImpl::pushMessages() {
     requestStatusCallbacks_.onWrite(numToSend);
   }
 
-  std::array<struct iovec, kStackIovecs> iovecs;
+  auto& iovecs = writeIovecs_;
+  const size_t maxIovecs = iovecs.size();
+  const size_t maxBatchSize = connectionOptions_.maxWriteBatchBytes;
   size_t iovsUsed = 0;
   size_t batchSize = 0;
+  size_t numWrites = 0;
   McClientRequestContextBase* tail = nullptr;
 
-  auto sendBatchFun = [this](
+  auto sendBatchFun = [this, &numWrites](
                           McClientRequestContextBase* tailReq,
                           const struct iovec* iov,
                           size_t iovCnt,
                           bool last) {
     tailReq->isBatchTail = true;
+    ++numWrites;
     socket_->writev(
         this,
         iov,
@@ -250,6 +278,21 @@ void AsyncMcClientImpl::pushMessages() {
         last ? folly::WriteFlags::NONE : folly::WriteFlags::CORK);
     return connectionState_ == ConnectionState::UP;
   };
+  // Sends the requests accumulated in iovecs.
+  auto sendAccumulatedFun = [&](bool last) {
+    if (batchCaretRequests_) {
+      if (auto batch = CaretBatcher::batch(iovecs.data(), iovsUsed)) {
+        tail->isBatchTail = true;
+        ++numWrites;
+        socket_->writeChain(
+            this,
+            std::move(batch),
+            last ? folly::WriteFlags::NONE : folly::WriteFlags::CORK);
+        return connectionState_ == ConnectionState::UP;
+      }
+    }
+    return sendBatchFun(tail, iovecs.data(), iovsUsed, last);
+  };
 
   while (getPendingRequestCount() != 0 && numToSend > 0 &&
          /* we might be already not UP, because of failed writev */
@@ -258,21 +301,49 @@ void AsyncMcClientImpl::pushMessages() {
 
     auto iov = req.reqContext.getIovs();
     auto iovcnt = req.reqContext.getIovsCount();
-    if (debugFifo_.isConnected()) {
-      debugFifo_.startMessage(MessageDirection::Sent, req.reqContext.typeId());
+    if (debugFifo_.isConnected() &&
+        debugFifo_.startRequest(
+            MessageDirection::Sent,
+            req.reqContext.typeId(),
+            req.key,
+            req.valueBuf ? req.valueBuf->computeChainDataLength() : 0)) {
       debugFifo_.writeData(iov, iovcnt);
     }
 
-    if (iovsUsed + iovcnt > kStackIovecs && iovsUsed) {
+    if (zeroCopyEnabled_ && req.valueBuf &&
+        req.valueBuf->computeChainDataLength() >=
+            connectionOptions_.zeroCopyThreshold) {
+      // Large request: flush what we batched and send it without copying the
+      // value into the socket buffer.
+      if (iovsUsed) {
+        if (!sendAccumulatedFun(false)) {
+          break;
+        }
+        iovsUsed = 0;
+        batchSize = 0;
+      }
+      queue_.markNextAsSending();
+      req.isBatchTail = true;
+      ++numWrites;
+      socket_->writeChain(
+          this,
+          iovecsToSharedIOBuf(iov, iovcnt, req.valueBuf),
+          (numToSend == 1 ? folly::WriteFlags::NONE : folly::WriteFlags::CORK) |
+              folly::WriteFlags::WRITE_MSG_ZEROCOPY);
+      --numToSend;
+      continue;
+    }
+
+    if (iovsUsed + iovcnt > maxIovecs && iovsUsed) {
       // We're out of inline iovecs, flush what we batched.
-      if (!sendBatchFun(tail, iovecs.data(), iovsUsed, false)) {
+      if (!sendAccumulatedFun(false)) {
         break;
       }
       iovsUsed = 0;
       batchSize = 0;
     }
 
-    if (iovcnt >= kStackIovecs || (iovsUsed == 0 && numToSend == 1)) {
+    if (iovcnt >= maxIovecs || (iovsUsed == 0 && numToSend == 1)) {
       // Req is either too big to batch or it's the last one, so just send it
       // alone.
       queue_.markNextAsSending();
@@ -280,9 +351,9 @@ void AsyncMcClientImpl::pushMessages() {
     } else {
       auto size = calculateIovecsTotalSize(iov, iovcnt);
 
-      if (size + batchSize > kMaxBatchSize && iovsUsed) {
+      if (size + batchSize > maxBatchSize && iovsUsed) {
         // We already accumulated too much data, flush what we have.
-        if (!sendBatchFun(tail, iovecs.data(), iovsUsed, false)) {
+        if (!sendAccumulatedFun(false)) {
           break;
         }
         iovsUsed = 0;
@@ -290,7 +361,7 @@ void AsyncMcClientImpl::pushMessages() {
       }
 
       queue_.markNextAsSending();
-      if (size >= kMaxBatchSize || (iovsUsed == 0 && numToSend == 1)) {
+      if (size >= maxBatchSize || (iovsUsed == 0 && numToSend == 1)) {
         // Req is either too big to batch or it's the last one, so just send it
         // alone.
         sendBatchFun(&req, iov, iovcnt, numToSend == 1);
@@ -302,13 +373,16 @@ void AsyncMcClientImpl::pushMessages() {
 
         if (numToSend == 1) {
           // This was the last request flush everything.
-          sendBatchFun(tail, iovecs.data(), iovsUsed, true);
+          sendAccumulatedFun(true);
         }
       }
     }
 
     --numToSend;
   }
+  if (requestStatusCallbacks_.onWritesDone && numWrites > 0) {
+    requestStatusCallbacks_.onWritesDone(numWrites);
+  }
   if (connectionState_ == ConnectionState::UP && pendingGoAwayReply_) {
     // Note: we're not waiting for all requests to be sent, since that may take
     // a while and if we didn't succeed in one loop, this means that we're
@@ -564,6 +638,7 @@ void AsyncMcClientImpl::connectSuccess() noexcept {
   assert(connectionState_ == ConnectionState::CONNECTING);
   DestructorGuard dg(this);
   connectionState_ = ConnectionState::UP;
+  ++connectionGeneration_;
 
   if (statusCallbacks_.onUp) {
     statusCallbacks_.onUp(*socket_);
@@ -579,6 +654,11 @@ void AsyncMcClientImpl::connectSuccess() noexcept {
     }
   }
 
+  // Zero-copy only makes sense for plaintext sockets, SSL has to encrypt
+  // into its own buffers anyway.
+  zeroCopyEnabled_ = connectionOptions_.zeroCopyThreshold > 0 &&
+      !connectionOptions_.sslContextProvider && socket_->setZeroCopy(true);
+
   if (connectionOptions_.sslContextProvider &&
       connectionOptions_.sessionCachingEnabled) {
     auto* sslSocket = socket_->getUnderlyingTransport<folly::AsyncSSLSocket>();
@@ -589,6 +669,8 @@ void AsyncMcClientImpl::connectSuccess() noexcept {
   assert(getInflightRequestCount() == 0);
   assert(queue_.getParserInitializer() == nullptr);
 
+  // A new server session may have a different window.
+  serverCreditWindow_ = 0;
   scheduleNextWriterLoop();
   parser_ = std::make_unique<ParserT>(
       *this,
@@ -597,6 +679,36 @@ void AsyncMcClientImpl::connectSuccess() noexcept {
       connectionOptions_.useJemallocNodumpAllocator,
       connectionOptions_.compressionCodecMap,
       &debugFifo_);
+  parser_->setMetaCommands(
+      connectionOptions_.accessPoint->getProtocol() == mc_meta_protocol);
+  if (auto offload = connectionOptions_.compressionOffload) {
+    parser_->setDecompressionOffload(
+        offload->threshold(),
+        [this, offload, generation = connectionGeneration_](
+            uint32_t codecId,
+            std::unique_ptr<folly::IOBuf> body,
+            size_t uncompressedSize,
+            ParserT::DeliverUncompressedFunc deliver) {
+          offload->uncompress(
+              codecId,
+              std::move(body),
+              uncompressedSize,
+              eventBase_,
+              [this,
+               generation,
+               dg = DestructorGuard(this),
+               deliver = std::move(deliver)](
+                  folly::Try<std::unique_ptr<folly::IOBuf>> result) mutable {
+                // The request was already failed if the connection went down
+                // in the meantime, even if a new one is up by now.
+                if (connectionState_ != ConnectionState::UP ||
+                    connectionGeneration_ != generation) {
+                  return;
+                }
+                deliver(std::move(result));
+              });
+        });
+  }
   socket_->setReadCB(this);
 }
 
@@ -727,6 +839,7 @@ void AsyncMcClientImpl::writeSuccess() noexcept {
   do {
     auto& req = queue_.markNextAsSent();
     last = req.isBatchTail;
+    MC_TRACEPOINT(client_write, this, req.id);
     req.scheduleTimeout();
   } while (!last);
 
@@ -9,6 +9,7 @@
 
 #include <chrono>
 #include <string>
+#include <vector>
 
 #include <folly/fibers/Baton.h>
 #include <folly/io/IOBufQueue.h>
@@ -67,13 +68,15 @@ class AsyncMcClientImpl : public folly::DelayedDestruction,
 
   void setRequestStatusCallbacks(
       std::function<void(int pendingDiff, int inflightDiff)> onStateChange,
-      std::function<void(int numToSend)> onWrite);
+      std::function<void(int numToSend)> onWrite,
+      std::function<void(size_t numWrites)> onWritesDone);
 
   template <class Request>
   ReplyT<Request> sendSync(
       const Request& request,
       std::chrono::milliseconds timeout,
-      ReplyStatsContext* replyContext);
+      ReplyStatsContext* replyContext,
+      bool lowPriority);
 
   void setThrottle(size_t maxInflight, size_t maxPending);
 
@@ -116,6 +119,7 @@ class AsyncMcClientImpl : public folly::DelayedDestruction,
   struct RequestStatusCallbacks {
     std::function<void(int pendingDiff, int inflightDiff)> onStateChange;
     std::function<void(size_t numToSend)> onWrite;
+    std::function<void(size_t numWrites)> onWritesDone;
   };
 
   folly::EventBase& eventBase_;
@@ -126,6 +130,10 @@ class AsyncMcClientImpl : public folly::DelayedDestruction,
 
   // Socket related variables.
   ConnectionState connectionState_{ConnectionState::DOWN};
+  // Incremented every time a connection goes UP. Replies that complete
+  // asynchronously (offloaded decompression) are only delivered to the
+  // connection they were read from.
+  uint64_t connectionGeneration_{0};
   folly::AsyncSocket::UniquePtr socket_;
   ConnectionStatusCallbacks statusCallbacks_;
   RequestStatusCallbacks requestStatusCallbacks_;
@@ -134,6 +142,8 @@ class AsyncMcClientImpl : public folly::DelayedDestruction,
   ConnectionFifo debugFifo_;
 
   CodecIdRange supportedCompressionCodecs_ = CodecIdRange::Empty;
+  // Codecs to compress requests with, nullptr if they are sent uncompressed.
+  const CompressionCodecMap* requestCompressionCodecMap_{nullptr};
 
   McClientRequestContextQueue queue_;
 
@@ -142,10 +152,17 @@ class AsyncMcClientImpl : public folly::DelayedDestruction,
 
   bool outOfOrder_{false};
   bool pendingGoAwayReply_{false};
+  // Whether MSG_ZEROCOPY is enabled on the current socket.
+  bool zeroCopyEnabled_{false};
+  // Whether requests written together are merged into caret batch frames.
+  bool batchCaretRequests_{false};
 
   // Throttle options (disabled by default).
   size_t maxPending_{0};
   size_t maxInflight_{0};
+  // Max number of inflight requests the server (caret only) accepts on this
+  // connection, from the last reply. 0 if unlimited or unknown.
+  size_t serverCreditWindow_{0};
 
   // Writer loop related variables.
   class WriterLoop : public folly::EventBase::LoopCallback {
@@ -168,6 +185,10 @@ class AsyncMcClientImpl : public folly::DelayedDestruction,
 
   ConnectionOptions connectionOptions_;
 
+  // Scratch iovec storage used by pushMessages() to coalesce requests into a
+  // single writev() call. Sized from ConnectionOptions::maxWriteBatchIovecs.
+  std::vector<struct iovec> writeIovecs_;
+
   std::unique_ptr<folly::EventBase::LoopCallback> eventBaseDestructionCallback_;
 
   // We need to be able to get shared_ptr to ourself and shared_from_this()
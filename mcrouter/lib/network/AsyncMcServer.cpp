@@ -7,8 +7,12 @@
  */
 #include "AsyncMcServer.h"
 
+#include <linux/filter.h>
+#include <pthread.h>
+#include <sched.h>
 #include <signal.h>
 #include <sys/resource.h>
+#include <sys/socket.h>
 #include <sys/time.h>
 
 #include <chrono>
@@ -18,11 +22,13 @@
 #include <memory>
 #include <mutex>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include <folly/Conv.h>
 #include <folly/SharedMutex.h>
 #include <folly/String.h>
+#include <folly/io/async/AsyncSSLSocket.h>
 #include <folly/io/async/AsyncServerSocket.h>
 #include <folly/io/async/EventBase.h>
 #include <folly/io/async/SSLContext.h>
@@ -31,6 +37,7 @@
 #include <wangle/ssl/TLSTicketKeySeeds.h>
 
 #include "mcrouter/lib/network/AsyncMcServerWorker.h"
+#include "mcrouter/lib/network/McSSLUtil.h"
 #include "mcrouter/lib/network/ThreadLocalSSLContextProvider.h"
 
 namespace facebook {
@@ -75,6 +82,53 @@ class ShutdownPipe : public folly::EventHandler {
   }
 };
 
+/**
+ * Attaches a classic BPF program to the reuseport groups of the given socket
+ * that picks the listener with index (receiving CPU % numListeners).
+ * Listeners are indexed in the order they started listening.
+ */
+void attachCpuSteeringProgram(
+    folly::AsyncServerSocket& socket,
+    size_t numListeners) {
+#ifdef SO_ATTACH_REUSEPORT_CBPF
+  struct sock_filter code[] = {
+      {BPF_LD | BPF_W | BPF_ABS, 0, 0, SKF_AD_OFF + SKF_AD_CPU},
+      {BPF_ALU | BPF_MOD | BPF_K, 0, 0, static_cast<uint32_t>(numListeners)},
+      {BPF_RET | BPF_A, 0, 0, 0},
+  };
+  struct sock_fprog prog;
+  prog.len = sizeof(code) / sizeof(code[0]);
+  prog.filter = code;
+
+  for (auto fd : socket.getSockets()) {
+    if (setsockopt(
+            fd,
+            SOL_SOCKET,
+            SO_ATTACH_REUSEPORT_CBPF,
+            &prog,
+            sizeof(prog)) != 0) {
+      LOG(ERROR) << "Failed to attach reuseport CPU steering program: "
+                 << folly::errnoStr(errno);
+    }
+  }
+#else
+  (void)socket;
+  (void)numListeners;
+  LOG(ERROR) << "Reuseport CPU steering is not supported on this platform";
+#endif
+}
+
+void pinCurrentThreadToCpu(size_t cpu) {
+  cpu_set_t cpuSet;
+  CPU_ZERO(&cpuSet);
+  CPU_SET(cpu, &cpuSet);
+  int err = pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+  if (err != 0) {
+    LOG(ERROR) << "Failed to pin server thread to CPU " << cpu << ": "
+               << folly::errnoStr(err);
+  }
+}
+
 } // anonymous namespace
 
 /**
@@ -148,6 +202,149 @@ class McServerThreadSpawnController {
   std::shared_future<void> acceptorFuture_{acceptorPromise_.get_future()};
 };
 
+/**
+ * Does server-side SSL handshakes on its own thread, and hands the
+ * established connections over to the workers.
+ */
+class SSLHandshakeThread {
+ public:
+  /**
+   * @param timeout  handshakes taking longer are failed, 0 means no timeout.
+   * @param maxInFlight  connections accepted while this many are in
+   *                     handshake are closed, 0 means no limit.
+   */
+  SSLHandshakeThread(std::chrono::milliseconds timeout, size_t maxInFlight)
+      : timeout_(timeout), maxInFlight_(maxInFlight) {}
+
+  ~SSLHandshakeThread() {
+    shutdown();
+  }
+
+  /**
+   * Starts the handshake of an accepted connection. Once established, the
+   * connection is added to `worker`, which runs on `workerEvb`.
+   * Safe to call from other threads.
+   */
+  void offload(
+      int fd,
+      std::shared_ptr<folly::SSLContext> context,
+      AsyncMcServerWorker& worker,
+      folly::EventBase& workerEvb) {
+    const auto queuedAt = std::chrono::steady_clock::now();
+    thread_.getEventBase()->runInEventBaseThread(
+        [ this, fd, context = std::move(context), &worker, &workerEvb,
+          queuedAt ]() {
+          if (stopped_) {
+            ::close(fd);
+            return;
+          }
+          // Connections in handshake don't count towards the limit of the
+          // workers yet, so they are limited here.
+          if (maxInFlight_ != 0 && inFlight_.size() >= maxInFlight_) {
+            LOG_EVERY_N(WARNING, 1000)
+                << "Too many SSL handshakes in flight (" << inFlight_.size()
+                << "), closing new connection";
+            ::close(fd);
+            return;
+          }
+          auto handshake =
+              std::make_unique<Handshake>(*this, worker, workerEvb);
+          handshake->queueTime =
+              std::chrono::duration_cast<std::chrono::microseconds>(
+                  std::chrono::steady_clock::now() - queuedAt);
+          handshake->socket.reset(new folly::AsyncSSLSocket(
+              context, thread_.getEventBase(), fd, /* server = */ true));
+          auto& socket = *handshake->socket;
+          auto& cb = *handshake;
+          inFlight_.emplace(&cb, std::move(handshake));
+          socket.sslAccept(&cb, timeout_);
+        });
+  }
+
+  /**
+   * Closes the connections still in handshake, and makes the thread close
+   * new ones. Safe to call from other threads.
+   */
+  void shutdown() {
+    thread_.getEventBase()->runInEventBaseThreadAndWait([this]() {
+      stopped_ = true;
+      inFlight_.clear();
+    });
+  }
+
+ private:
+  struct Handshake : public folly::AsyncSSLSocket::HandshakeCB {
+    Handshake(
+        SSLHandshakeThread& owner_,
+        AsyncMcServerWorker& worker_,
+        folly::EventBase& workerEvb_)
+        : owner(owner_), worker(worker_), workerEvb(workerEvb_) {}
+
+    ~Handshake() override {
+      // Closing the socket may call handshakeErr(), so it has to happen
+      // while this is still a Handshake.
+      socket.reset();
+    }
+
+    SSLHandshakeThread& owner;
+    AsyncMcServerWorker& worker;
+    folly::EventBase& workerEvb;
+    folly::AsyncSSLSocket::UniquePtr socket;
+    std::chrono::microseconds queueTime{0};
+
+    bool handshakeVer(
+        folly::AsyncSSLSocket* sock,
+        bool preverifyOk,
+        X509_STORE_CTX* ctx) noexcept final {
+      return McSSLUtil::verifySSL(sock, preverifyOk, ctx);
+    }
+
+    // The socket can't be moved or destroyed from its own callbacks.
+    void handshakeSuc(folly::AsyncSSLSocket*) noexcept final {
+      owner.thread_.getEventBase()->runInLoop(
+          [ o = &owner, h = this ]() { o->handOver(h); });
+    }
+
+    void handshakeErr(
+        folly::AsyncSSLSocket*,
+        const folly::AsyncSocketException&) noexcept final {
+      owner.thread_.getEventBase()->runInLoop(
+          [ o = &owner, h = this ]() { o->inFlight_.erase(h); });
+    }
+  };
+
+  // Only accessed from thread_. Callbacks scheduled by handshakes may
+  // outlive them, so they look handshakes up by address.
+  std::unordered_map<Handshake*, std::unique_ptr<Handshake>> inFlight_;
+  bool stopped_{false};
+  const std::chrono::milliseconds timeout_;
+  const size_t maxInFlight_;
+  // Last, so that the thread is joined before the members it uses go away.
+  folly::ScopedEventBaseThread thread_{"mc-handshake"};
+
+  void handOver(Handshake* h) {
+    auto it = inFlight_.find(h);
+    if (it == inFlight_.end()) {
+      // Closed by shutdown().
+      return;
+    }
+    auto handshake = std::move(it->second);
+    inFlight_.erase(it);
+
+    auto socket = std::move(handshake->socket);
+    socket->detachEventBase();
+    auto& workerEvb = handshake->workerEvb;
+    workerEvb.runInEventBaseThread(
+        [ socket = std::move(socket), &worker = handshake->worker, &workerEvb,
+          queueTime = handshake->queueTime ]() mutable {
+          socket->attachEventBase(&workerEvb);
+          if (worker.isAlive()) {
+            worker.addHandshakedClientSocket(std::move(socket), queueTime);
+          }
+        });
+  }
+};
+
 class McServerThread {
  public:
   explicit McServerThread(AsyncMcServer& server, size_t id)
@@ -185,6 +382,11 @@ class McServerThread {
     worker_.setOnShutdownOperation([&]() { server_.shutdown(); });
 
     thread_ = std::thread{[this]() {
+      const auto& cpus = server_.opts_.threadCpus;
+      if (!cpus.empty()) {
+        pinCurrentThreadToCpu(cpus[id_ % cpus.size()]);
+      }
+
       SCOPE_EXIT {
         // We must detroy the EventBase in it's own thread.
         // The reason is that we might have already scheduled something
@@ -201,6 +403,9 @@ class McServerThread {
 
         server_.threadsSpawnController_->startAccepting(
             [this]() { startAccepting(); }, accepting_);
+        if (!accepting_ && server_.opts_.reusePortPerWorker) {
+          startAcceptingOwnSockets();
+        }
       } catch (...) {
         // if an exception is thrown, something went wrong before startup.
         return;
@@ -212,9 +417,9 @@ class McServerThread {
       // If we don't do this, the TAsyncSSLServerSocket destructor
       // will try to do it, and a segfault will result if the
       // socket destructor runs after the threads' destructors.
+      socket_.reset();
+      sslSocket_.reset();
       if (accepting_) {
-        socket_.reset();
-        sslSocket_.reset();
         for (auto& acceptor : acceptorsKeepAlive_) {
           acceptor.first->add(
               [keepAlive = std::move(acceptor.second)]() mutable {
@@ -229,9 +434,9 @@ class McServerThread {
   /* Safe to call from other threads */
   void shutdown() {
     auto result = evb_->runInEventBaseThread([&]() {
+      socket_.reset();
+      sslSocket_.reset();
       if (accepting_) {
-        socket_.reset();
-        sslSocket_.reset();
         for (auto& acceptor : acceptorsKeepAlive_) {
           acceptor.first
               ->add([keepAlive = std::move(acceptor.second)]() mutable {
@@ -267,6 +472,20 @@ class McServerThread {
     fn_ = std::move(fn);
   }
 
+  /* Safe to call from other threads */
+  void addListeningSockets(TakeoverSockets& sockets) {
+    evb_->runImmediatelyOrRunInEventBaseThreadAndWait([&]() {
+      if (socket_) {
+        auto fds = socket_->getSockets();
+        sockets.fds.insert(sockets.fds.end(), fds.begin(), fds.end());
+      }
+      if (sslSocket_) {
+        auto fds = sslSocket_->getSockets();
+        sockets.sslFds.insert(sockets.sslFds.end(), fds.begin(), fds.end());
+      }
+    });
+  }
+
  private:
   class AcceptCallback : public folly::AsyncServerSocket::AcceptCallback {
    public:
@@ -282,12 +501,25 @@ class McServerThread {
             opts.pemCertPath,
             opts.pemKeyPath,
             opts.pemCaPath,
-            server.getTicketKeySeeds());
+            server.getTicketKeySeeds(),
+            false /* clientContext */,
+            opts.ktlsEnabledForSsl);
 
         if (sslCtx) {
           sslCtx->setVerificationOption(
               folly::SSLContext::SSLVerifyPeerEnum::VERIFY_REQ_CLIENT_CERT);
-          mcServerThread_->worker_.addSecureClientSocket(fd, std::move(sslCtx));
+          auto& handshakeThreads = mcServerThread_->server_.handshakeThreads_;
+          if (!handshakeThreads.empty()) {
+            auto& next = mcServerThread_->server_.nextHandshakeThread_;
+            handshakeThreads[next++ % handshakeThreads.size()]->offload(
+                fd,
+                std::move(sslCtx),
+                mcServerThread_->worker_,
+                mcServerThread_->eventBase());
+          } else {
+            mcServerThread_->worker_.addSecureClientSocket(
+                fd, std::move(sslCtx));
+          }
         } else {
           ::close(fd);
         }
@@ -330,7 +562,32 @@ class McServerThread {
     CHECK(accepting_);
     auto& opts = server_.opts_;
 
-    if (opts.existingSocketFd != -1) {
+    if (opts.reusePortPerWorker) {
+      startAcceptingReusePort();
+      return;
+    }
+
+    const auto& takeover = opts.takeoverSockets;
+    if (!takeover.fds.empty() || !takeover.sslFds.empty()) {
+      checkLogic(
+          opts.existingSocketFd == -1 && opts.unixDomainSockPath.empty(),
+          "Can't use taken over sockets with existing or unix domain socket");
+      checkLogic(
+          takeover.sslFds.empty() ||
+              (!opts.pemCertPath.empty() && !opts.pemKeyPath.empty() &&
+               !opts.pemCaPath.empty()),
+          "All of pemCertPath, pemKeyPath, pemCaPath required"
+          " with taken over SSL sockets");
+      // Sockets are already listening, listen() again only sets the backlog.
+      if (!takeover.fds.empty()) {
+        socket_.reset(new folly::AsyncServerSocket());
+        socket_->useExistingSockets(takeover.fds);
+      }
+      if (!takeover.sslFds.empty()) {
+        sslSocket_.reset(new folly::AsyncServerSocket());
+        sslSocket_->useExistingSockets(takeover.sslFds);
+      }
+    } else if (opts.existingSocketFd != -1) {
       checkLogic(
           opts.ports.empty() && opts.sslPorts.empty(),
           "Can't use ports if using existing socket");
@@ -412,6 +669,89 @@ class McServerThread {
       }
     }
   }
+
+  /**
+   * Binds and starts listening on SO_REUSEPORT sockets for every thread
+   * (in thread order, so that listener indices match thread ids), then
+   * starts accepting on this thread's own sockets. Other threads start
+   * accepting on theirs once the acceptor is done.
+   *
+   * @throw   If anything goes wrong when binding or listening.
+   */
+  void startAcceptingReusePort() {
+    auto& opts = server_.opts_;
+    checkLogic(
+        opts.existingSocketFd == -1 && opts.unixDomainSockPath.empty() &&
+            opts.takeoverSockets.fds.empty() &&
+            opts.takeoverSockets.sslFds.empty(),
+        "reusePortPerWorker is only supported when listening on ports");
+    checkLogic(
+        !opts.ports.empty() || !opts.sslPorts.empty(),
+        "At least one port (plain or SSL) must be speicified");
+    checkLogic(
+        opts.sslPorts.empty() ||
+            (!opts.pemCertPath.empty() && !opts.pemKeyPath.empty() &&
+             !opts.pemCaPath.empty()),
+        "All of pemCertPath, pemKeyPath, pemCaPath required with sslPorts");
+
+    for (auto& t : server_.threads_) {
+      t->bindReusePortSockets();
+    }
+
+    if (opts.reusePortCpuSteering) {
+      if (socket_) {
+        attachCpuSteeringProgram(*socket_, server_.threads_.size());
+      }
+      if (sslSocket_) {
+        attachCpuSteeringProgram(*sslSocket_, server_.threads_.size());
+      }
+    }
+
+    startAcceptingOwnSockets();
+  }
+
+  void bindReusePortSockets() {
+    auto& opts = server_.opts_;
+    auto makeSocket = [&opts](const std::vector<uint16_t>& ports, bool ssl) {
+      folly::AsyncServerSocket::UniquePtr socket(
+          new folly::AsyncServerSocket());
+      socket->setReusePortEnabled(true);
+      for (auto port : ports) {
+        socket->bind(port);
+      }
+      if (ssl && opts.tfoEnabledForSsl) {
+        socket->setTFOEnabled(true, opts.tfoQueueSize);
+      } else {
+        socket->setTFOEnabled(false, 0);
+      }
+      socket->listen(opts.tcpListenBacklog);
+      return socket;
+    };
+
+    if (!opts.ports.empty()) {
+      socket_ = makeSocket(opts.ports, false /* ssl */);
+    }
+    if (!opts.sslPorts.empty()) {
+      sslSocket_ = makeSocket(opts.sslPorts, true /* ssl */);
+    }
+  }
+
+  /**
+   * Accept connections from this thread's own sockets on its own EventBase.
+   * Must be called from the thread's EventBase thread.
+   */
+  void startAcceptingOwnSockets() {
+    if (socket_) {
+      socket_->attachEventBase(evb_.get());
+      socket_->addAcceptCallback(&acceptCallback_, evb_.get());
+      socket_->startAccepting();
+    }
+    if (sslSocket_) {
+      sslSocket_->attachEventBase(evb_.get());
+      sslSocket_->addAcceptCallback(&sslAcceptCallback_, evb_.get());
+      sslSocket_->startAccepting();
+    }
+  }
 };
 
 void AsyncMcServer::Options::setPerThreadMaxConns(
@@ -475,6 +815,17 @@ AsyncMcServer::AsyncMcServer(Options opts) : opts_(std::move(opts)) {
     throw std::invalid_argument(folly::sformat(
         "Unexpected option: opts_.numThreads={}", opts_.numThreads));
   }
+  auto maxInFlightHandshakes = opts_.maxInFlightHandshakes;
+  if (maxInFlightHandshakes == 0 && opts_.numHandshakeThreads > 0) {
+    const auto maxConns = opts_.worker.maxConns * opts_.numThreads;
+    maxInFlightHandshakes =
+        (maxConns + opts_.numHandshakeThreads - 1) / opts_.numHandshakeThreads;
+  }
+  for (size_t i = 0; i < opts_.numHandshakeThreads; ++i) {
+    handshakeThreads_.emplace_back(std::make_unique<SSLHandshakeThread>(
+        opts_.sslHandshakeTimeout, maxInFlightHandshakes));
+  }
+
   threadsSpawnController_ = std::make_unique<McServerThreadSpawnController>();
   threads_.emplace_back(std::make_unique<McServerThread>(
       McServerThread::Acceptor, *this, /*id*/ 0));
@@ -491,6 +842,14 @@ std::vector<folly::EventBase*> AsyncMcServer::eventBases() const {
   return out;
 }
 
+TakeoverSockets AsyncMcServer::listeningSockets() const {
+  TakeoverSockets sockets;
+  for (auto& t : threads_) {
+    t->addListeningSockets(sockets);
+  }
+  return sockets;
+}
+
 AsyncMcServer::~AsyncMcServer() {
   /* Need to place the destructor here, since this is the only
      translation unit that knows about McServerThread */
@@ -543,6 +902,10 @@ void AsyncMcServer::shutdown() {
     onShutdown_();
   }
 
+  // Before the workers, so that no more connections are handed to them.
+  for (auto& thread : handshakeThreads_) {
+    thread->shutdown();
+  }
   for (auto& thread : threads_) {
     thread->shutdown();
   }
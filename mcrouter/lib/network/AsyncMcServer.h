@@ -8,6 +8,7 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -20,6 +21,7 @@
 
 #include "mcrouter/lib/network/AsyncMcServerWorkerOptions.h"
 #include "mcrouter/lib/network/CongestionController.h"
+#include "mcrouter/lib/network/SocketTakeover.h"
 
 namespace folly {
 class EventBase;
@@ -36,6 +38,7 @@ namespace memcache {
 class AsyncMcServerWorker;
 class McServerThread;
 class McServerThreadSpawnController;
+class SSLHandshakeThread;
 
 /**
  * A multithreaded, asynchronous MC protocol server.
@@ -54,6 +57,14 @@ class AsyncMcServer {
      */
     int existingSocketFd{-1};
 
+    /**
+     * Listening sockets taken over from another server (see
+     * SocketTakeover.h), used instead of binding ports/sslPorts.
+     * The server will not bind() them.
+     * Not supported with reusePortPerWorker.
+     */
+    TakeoverSockets takeoverSockets;
+
     /**
      * Create Unix Domain Socket to listen on.
      * If this is used (not empty), port must be empty,
@@ -98,6 +109,56 @@ class AsyncMcServer {
     bool tfoEnabledForSsl{false};
     uint32_t tfoQueueSize{0};
 
+    /**
+     * Switch SSL connections to kernel TLS after the handshake.
+     */
+    bool ktlsEnabledForSsl{false};
+
+    /**
+     * If positive, SSL handshakes of new connections are done on this many
+     * dedicated threads, and the connections are handed to the worker
+     * threads once established. Keeps a burst of handshakes (e.g. clients
+     * reconnecting at once) from stalling requests on open connections.
+     */
+    size_t numHandshakeThreads{0};
+
+    /**
+     * Connections whose handshake on a handshake thread takes longer than
+     * this are closed. 0 means no timeout.
+     */
+    std::chrono::milliseconds sslHandshakeTimeout{5000};
+
+    /**
+     * Max number of connections in handshake on each handshake thread,
+     * further ones are closed right away. 0 means the share of the thread
+     * in the connection limit of all workers (worker.maxConns times
+     * numThreads), or unlimited if there's no such limit.
+     */
+    size_t maxInFlightHandshakes{0};
+
+    /**
+     * If true, every thread binds its own SO_REUSEPORT listening socket(s)
+     * on ports/sslPorts and accepts connections on its own EventBase,
+     * instead of a single acceptor thread handing connections out.
+     * Only supported when listening on ports.
+     */
+    bool reusePortPerWorker{false};
+
+    /**
+     * With reusePortPerWorker, attach a reuseport BPF program that steers
+     * each new connection to worker (receiving CPU % numThreads).
+     * Most effective when worker i is pinned to CPU i and NIC queues are
+     * aligned with CPUs.
+     */
+    bool reusePortCpuSteering{false};
+
+    /**
+     * If non-empty, thread i is pinned to CPU threadCpus[i % size()].
+     * Combined with reusePortCpuSteering and NIC RX queues mapped to the
+     * same CPUs, a connection is received, accepted and served on one core.
+     */
+    std::vector<uint16_t> threadCpus;
+
     /**
      * Number of threads to spawn, must be positive.
      */
@@ -191,6 +252,12 @@ class AsyncMcServer {
    */
   void join();
 
+  /**
+   * @return  The listening sockets, to hand them over to another server.
+   *          Can only be called after spawn() and before shutdown().
+   */
+  TakeoverSockets listeningSockets() const;
+
   /**
    * Getter/setter for seeds to be used to generate keys encrypting TLS tickets.
    */
@@ -202,6 +269,8 @@ class AsyncMcServer {
   Options opts_;
   std::unique_ptr<McServerThreadSpawnController> threadsSpawnController_;
   std::vector<std::unique_ptr<McServerThread>> threads_;
+  std::vector<std::unique_ptr<SSLHandshakeThread>> handshakeThreads_;
+  std::atomic<size_t> nextHandshakeThread_{0};
 
   std::unique_ptr<wangle::TLSCredProcessor> ticketKeySeedPoller_;
   wangle::TLSTicketKeySeeds tlsTicketKeySeeds_;
@@ -34,6 +34,16 @@ bool AsyncMcServerWorker::addSecureClientSocket(
   return addClientSocket(std::move(sslSocket), userCtxt);
 }
 
+bool AsyncMcServerWorker::addHandshakedClientSocket(
+    folly::AsyncSSLSocket::UniquePtr socket,
+    std::chrono::microseconds queueTime,
+    void* userCtxt) {
+  if (onHandshakeOffloaded_) {
+    onHandshakeOffloaded_(queueTime);
+  }
+  return addClientSocket(std::move(socket), userCtxt);
+}
+
 bool AsyncMcServerWorker::addClientSocket(int fd, void* userCtxt) {
   auto socket =
       folly::AsyncSocket::UniquePtr(new folly::AsyncSocket(&eventBase_, fd));
@@ -61,6 +71,11 @@ McServerSession* AsyncMcServerWorker::addClientTransport(
 
   transport->setSendTimeout(opts_.sendTimeout.count());
 
+  if (opts_.idleBufferReleaseTimeout.count() != 0 &&
+      !idleBufferReleaseTimer_) {
+    scheduleIdleBufferRelease();
+  }
+
   try {
     return std::addressof(tracker_.add(
         std::move(transport),
@@ -74,12 +89,22 @@ McServerSession* AsyncMcServerWorker::addClientTransport(
   }
 }
 
+void AsyncMcServerWorker::scheduleIdleBufferRelease() {
+  idleBufferReleaseTimer_ = folly::AsyncTimeout::make(eventBase_, [this]() {
+    tracker_.releaseIdleBuffers(
+        std::chrono::steady_clock::now() - opts_.idleBufferReleaseTimeout);
+    idleBufferReleaseTimer_->scheduleTimeout(opts_.idleBufferReleaseTimeout);
+  });
+  idleBufferReleaseTimer_->scheduleTimeout(opts_.idleBufferReleaseTimeout);
+}
+
 void AsyncMcServerWorker::shutdown() {
   if (!isAlive_) {
     return;
   }
 
   isAlive_ = false;
+  idleBufferReleaseTimer_.reset();
   tracker_.closeAll();
 }
 
@@ -12,7 +12,9 @@
 #include <unordered_set>
 
 #include <folly/Optional.h>
+#include <folly/io/async/AsyncSSLSocket.h>
 #include <folly/io/async/AsyncSocket.h>
+#include <folly/io/async/AsyncTimeout.h>
 #include <folly/io/async/AsyncTransport.h>
 
 #include "mcrouter/lib/network/AsyncMcServerWorkerOptions.h"
@@ -60,6 +62,19 @@ class AsyncMcServerWorker {
       const std::shared_ptr<folly::SSLContext>& context,
       void* userCtxt = nullptr);
 
+  /**
+   * Moves in ownership of an SSL client socket whose handshake was done on
+   * another thread (see AsyncMcServer::Options::numHandshakeThreads).
+   * The socket must already be attached to this worker's EventBase.
+   *
+   * @param queueTime  How long the handshake waited for its thread.
+   * @return    true on success, false on error
+   */
+  bool addHandshakedClientSocket(
+      folly::AsyncSSLSocket::UniquePtr socket,
+      std::chrono::microseconds queueTime,
+      void* userCtxt = nullptr);
+
   /**
    * Certain situations call for a user to provide their own
    * AsyncTransportWrapper rather than an accepted socket. Move in an
@@ -155,6 +170,32 @@ class AsyncMcServerWorker {
     tracker_.setOnShutdownOperation(std::move(cb));
   }
 
+  /**
+   * Will be called every time a session puts off parsing what it read to
+   * the next loop iteration (see
+   * AsyncMcServerWorkerOptions::maxRequestsPerLoop).
+   */
+  void setOnReadsDeferred(std::function<void(McServerSession&)> cb) {
+    tracker_.setOnReadsDeferred(std::move(cb));
+  }
+
+  /**
+   * Will be called every time a session hands a batch of replies to the
+   * transport, with the number of replies in the batch.
+   */
+  void setOnRepliesWritten(std::function<void(McServerSession&, size_t)> cb) {
+    tracker_.setOnRepliesWritten(std::move(cb));
+  }
+
+  /**
+   * Will be called for every socket added with addHandshakedClientSocket(),
+   * with the time its handshake waited for a handshake thread.
+   */
+  void setOnHandshakeOffloaded(
+      std::function<void(std::chrono::microseconds)> cb) {
+    onHandshakeOffloaded_ = std::move(cb);
+  }
+
   void setCompressionCodecMap(const CompressionCodecMap* codecMap) {
     compressionCodecMap_ = codecMap;
   }
@@ -186,6 +227,7 @@ class AsyncMcServerWorker {
 
   std::shared_ptr<McServerOnRequest> onRequest_;
   std::function<void()> onAccepted_;
+  std::function<void(std::chrono::microseconds)> onHandshakeOffloaded_;
 
   const CompressionCodecMap* compressionCodecMap_{nullptr};
 
@@ -194,6 +236,12 @@ class AsyncMcServerWorker {
   /* Open sessions and closing sessions that still have pending writes */
   ConnectionTracker tracker_;
 
+  /* Periodically frees read buffers of idle sessions, see
+     AsyncMcServerWorkerOptions::idleBufferReleaseTimeout */
+  std::unique_ptr<folly::AsyncTimeout> idleBufferReleaseTimer_;
+
+  void scheduleIdleBufferRelease();
+
   AsyncMcServerWorker(const AsyncMcServerWorker&) = delete;
   AsyncMcServerWorker& operator=(const AsyncMcServerWorker&) = delete;
 
@@ -62,6 +62,15 @@ struct AsyncMcServerWorkerOptions {
    */
   size_t maxInFlight{0};
 
+  /**
+   * Each connection hands at most this many requests to the application per
+   * event loop iteration. The rest of what was read is parsed in the
+   * following iterations, after other connections had their turn, so that
+   * clients with deep pipelines can't starve the others.
+   * Applies to caret and umbrella only. If 0, there is no limit.
+   */
+  size_t maxRequestsPerLoop{0};
+
   /**
    * Max connections used at any moment.
    */
@@ -77,6 +86,27 @@ struct AsyncMcServerWorkerOptions {
    */
   size_t maxBufferSize{4096};
 
+  /**
+   * Read buffers of connections that didn't receive anything for this long
+   * are freed, and allocated again on the next read.
+   * If 0, read buffers are kept for the lifetime of the connection.
+   */
+  std::chrono::milliseconds idleBufferReleaseTimeout{0};
+
+  /**
+   * Replies with values of at least this many bytes are written with
+   * MSG_ZEROCOPY. Ignored for SSL connections. If 0, zero-copy is disabled.
+   */
+  size_t zeroCopyThreshold{0};
+
+  /**
+   * Caret replies with bodies bigger than this many bytes are written in
+   * frames of this size, interleaved with other replies, to clients that can
+   * reassemble them. Ignored if singleWrite is set. If 0, replies are never
+   * fragmented.
+   */
+  size_t caretFrameSize{0};
+
   /**
    * String that will be returned for 'VERSION' commands.
    */
@@ -93,6 +123,16 @@ struct AsyncMcServerWorkerOptions {
    */
   std::shared_ptr<CpuController> cpuController;
 
+  /**
+   * While cpuController reports at least overloadCpuThreshold percent load,
+   * each connection may send this many requests per second (with bursts of
+   * up to as many). Connections over the budget stop being read from until
+   * they are back within it, so that the heaviest clients are throttled
+   * first. If 0, connections are never throttled this way.
+   */
+  size_t overloadRequestBudget{0};
+  double overloadCpuThreshold{90.0};
+
   /**
    * The congestion controller for memory utilization at the server.
    */
@@ -0,0 +1,327 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include "BinaryProtocol.h"
+
+#include <cstring>
+#include <initializer_list>
+#include <string>
+#include <utility>
+
+#include <folly/Bits.h>
+#include <folly/Format.h>
+
+namespace facebook {
+namespace memcache {
+
+namespace {
+
+template <class T>
+T readBigEndian(const uint8_t* buf) {
+  T value;
+  std::memcpy(&value, buf, sizeof(T));
+  return folly::Endian::big(value);
+}
+
+struct BinaryBody {
+  folly::ByteRange extras;
+  folly::ByteRange key;
+  // Offset of the value in the message.
+  size_t valueOffset;
+  size_t valueLength;
+};
+
+BinaryBody splitBody(
+    const BinaryReplyHeader& header,
+    const folly::IOBuf& buffer) {
+  if (header.extrasLength + header.keyLength > header.bodyLength ||
+      kBinaryHeaderLength + header.bodyLength > buffer.length()) {
+    throw std::runtime_error(folly::sformat(
+        "Malformed binary reply: body of {} bytes with {} bytes of extras "
+        "and {} of key",
+        header.bodyLength,
+        header.extrasLength,
+        header.keyLength));
+  }
+  BinaryBody body;
+  const auto* extras = buffer.data() + kBinaryHeaderLength;
+  body.extras = folly::ByteRange(extras, header.extrasLength);
+  body.key = folly::ByteRange(extras + header.extrasLength, header.keyLength);
+  body.valueOffset =
+      kBinaryHeaderLength + header.extrasLength + header.keyLength;
+  body.valueLength =
+      header.bodyLength - header.extrasLength - header.keyLength;
+  return body;
+}
+
+folly::IOBuf valueOf(const folly::IOBuf& buffer, const BinaryBody& body) {
+  folly::IOBuf value;
+  buffer.cloneOneInto(value);
+  value.trimStart(body.valueOffset);
+  value.trimEnd(value.length() - body.valueLength);
+  return value;
+}
+
+mc_res_t errorResult(uint16_t status) {
+  switch (static_cast<BinaryStatus>(status)) {
+    case BinaryStatus::VALUE_TOO_LARGE:
+    case BinaryStatus::INVALID_ARGUMENTS:
+    case BinaryStatus::NON_NUMERIC_VALUE:
+      return mc_res_client_error;
+    case BinaryStatus::UNKNOWN_COMMAND:
+    case BinaryStatus::NOT_SUPPORTED:
+      return mc_res_bad_command;
+    case BinaryStatus::BUSY:
+      return mc_res_busy;
+    case BinaryStatus::TEMPORARY_FAILURE:
+      return mc_res_try_again;
+    default:
+      return mc_res_remote_error;
+  }
+}
+
+/**
+ * Sets the result from the status: NO_ERROR and the statuses listed are
+ * the expected outcomes of the command, anything else is an error described
+ * by the value.
+ *
+ * @return  true iff status is NO_ERROR.
+ */
+template <class Reply>
+bool parseStatus(
+    const BinaryReplyHeader& header,
+    const folly::IOBuf& buffer,
+    Reply& reply,
+    mc_res_t okResult,
+    std::initializer_list<std::pair<BinaryStatus, mc_res_t>> expected) {
+  if (header.status == static_cast<uint16_t>(BinaryStatus::NO_ERROR)) {
+    reply.result() = okResult;
+    return true;
+  }
+  for (const auto& it : expected) {
+    if (header.status == static_cast<uint16_t>(it.first)) {
+      reply.result() = it.second;
+      return false;
+    }
+  }
+  reply.result() = errorResult(header.status);
+  const auto body = splitBody(header, buffer);
+  reply.message() = std::string(
+      reinterpret_cast<const char*>(buffer.data() + body.valueOffset),
+      body.valueLength);
+  return false;
+}
+
+template <class Reply>
+void parseGetLikeReply(
+    const BinaryReplyHeader& header,
+    const folly::IOBuf& buffer,
+    Reply& reply) {
+  if (!parseStatus(
+          header,
+          buffer,
+          reply,
+          mc_res_found,
+          {{BinaryStatus::KEY_NOT_FOUND, mc_res_notfound}})) {
+    return;
+  }
+  const auto body = splitBody(header, buffer);
+  if (body.extras.size() >= sizeof(uint32_t)) {
+    reply.flags() = readBigEndian<uint32_t>(body.extras.data());
+  }
+  reply.value() = valueOf(buffer, body);
+}
+
+template <class Reply>
+void parseStorageReply(
+    const BinaryReplyHeader& header,
+    const folly::IOBuf& buffer,
+    Reply& reply) {
+  parseStatus(
+      header,
+      buffer,
+      reply,
+      mc_res_stored,
+      {{BinaryStatus::KEY_NOT_FOUND, mc_res_notfound},
+       {BinaryStatus::KEY_EXISTS, mc_res_exists},
+       {BinaryStatus::ITEM_NOT_STORED, mc_res_notstored}});
+}
+
+template <class Reply>
+void parseArithmeticReply(
+    const BinaryReplyHeader& header,
+    const folly::IOBuf& buffer,
+    Reply& reply) {
+  if (!parseStatus(
+          header,
+          buffer,
+          reply,
+          mc_res_stored,
+          {{BinaryStatus::KEY_NOT_FOUND, mc_res_notfound}})) {
+    return;
+  }
+  const auto body = splitBody(header, buffer);
+  if (body.valueLength != sizeof(uint64_t)) {
+    throw std::runtime_error(folly::sformat(
+        "Malformed binary arithmetic reply: value of {} bytes",
+        body.valueLength));
+  }
+  reply.delta() = readBigEndian<uint64_t>(buffer.data() + body.valueOffset);
+}
+
+} // anonymous namespace
+
+UmbrellaParseStatus
+binaryParseHeader(const uint8_t* buf, size_t nbuf, UmbrellaMessageInfo& info) {
+  if (nbuf == 0) {
+    return UmbrellaParseStatus::NOT_ENOUGH_DATA;
+  }
+  if (buf[0] != kBinaryReplyMagicByte) {
+    return UmbrellaParseStatus::MESSAGE_PARSE_ERROR;
+  }
+  if (nbuf < kBinaryHeaderLength) {
+    return UmbrellaParseStatus::NOT_ENOUGH_DATA;
+  }
+
+  const auto header = binaryParseReplyHeader(buf);
+  if (header.extrasLength + header.keyLength > header.bodyLength) {
+    return UmbrellaParseStatus::MESSAGE_PARSE_ERROR;
+  }
+  info = UmbrellaMessageInfo();
+  info.headerSize = kBinaryHeaderLength;
+  info.bodySize = header.bodyLength;
+  info.reqId = header.opaque;
+  return UmbrellaParseStatus::OK;
+}
+
+BinaryReplyHeader binaryParseReplyHeader(const uint8_t* buf) {
+  BinaryReplyHeader header;
+  header.opcode = buf[1];
+  header.keyLength = readBigEndian<uint16_t>(buf + 2);
+  header.extrasLength = buf[4];
+  header.status = readBigEndian<uint16_t>(buf + 6);
+  header.bodyLength = readBigEndian<uint32_t>(buf + 8);
+  header.opaque = readBigEndian<uint32_t>(buf + 12);
+  header.cas = readBigEndian<uint64_t>(buf + 16);
+  return header;
+}
+
+void binaryParseReply(
+    const BinaryReplyHeader& header,
+    const folly::IOBuf& buffer,
+    McGetReply& reply) {
+  parseGetLikeReply(header, buffer, reply);
+}
+
+void binaryParseReply(
+    const BinaryReplyHeader& header,
+    const folly::IOBuf& buffer,
+    McGetsReply& reply) {
+  parseGetLikeReply(header, buffer, reply);
+  if (reply.result() == mc_res_found) {
+    reply.casToken() = header.cas;
+  }
+}
+
+void binaryParseReply(
+    const BinaryReplyHeader& header,
+    const folly::IOBuf& buffer,
+    McSetReply& reply) {
+  parseStorageReply(header, buffer, reply);
+}
+
+void binaryParseReply(
+    const BinaryReplyHeader& header,
+    const folly::IOBuf& buffer,
+    McAddReply& reply) {
+  parseStorageReply(header, buffer, reply);
+}
+
+void binaryParseReply(
+    const BinaryReplyHeader& header,
+    const folly::IOBuf& buffer,
+    McReplaceReply& reply) {
+  parseStorageReply(header, buffer, reply);
+}
+
+void binaryParseReply(
+    const BinaryReplyHeader& header,
+    const folly::IOBuf& buffer,
+    McAppendReply& reply) {
+  parseStorageReply(header, buffer, reply);
+}
+
+void binaryParseReply(
+    const BinaryReplyHeader& header,
+    const folly::IOBuf& buffer,
+    McPrependReply& reply) {
+  parseStorageReply(header, buffer, reply);
+}
+
+void binaryParseReply(
+    const BinaryReplyHeader& header,
+    const folly::IOBuf& buffer,
+    McCasReply& reply) {
+  parseStorageReply(header, buffer, reply);
+}
+
+void binaryParseReply(
+    const BinaryReplyHeader& header,
+    const folly::IOBuf& buffer,
+    McIncrReply& reply) {
+  parseArithmeticReply(header, buffer, reply);
+}
+
+void binaryParseReply(
+    const BinaryReplyHeader& header,
+    const folly::IOBuf& buffer,
+    McDecrReply& reply) {
+  parseArithmeticReply(header, buffer, reply);
+}
+
+void binaryParseReply(
+    const BinaryReplyHeader& header,
+    const folly::IOBuf& buffer,
+    McDeleteReply& reply) {
+  parseStatus(
+      header,
+      buffer,
+      reply,
+      mc_res_deleted,
+      {{BinaryStatus::KEY_NOT_FOUND, mc_res_notfound}});
+}
+
+void binaryParseReply(
+    const BinaryReplyHeader& header,
+    const folly::IOBuf& buffer,
+    McTouchReply& reply) {
+  parseStatus(
+      header,
+      buffer,
+      reply,
+      mc_res_touched,
+      {{BinaryStatus::KEY_NOT_FOUND, mc_res_notfound}});
+}
+
+void binaryParseReply(
+    const BinaryReplyHeader& header,
+    const folly::IOBuf& buffer,
+    McVersionReply& reply) {
+  if (parseStatus(header, buffer, reply, mc_res_ok, {})) {
+    reply.value() = valueOf(buffer, splitBody(header, buffer));
+  }
+}
+
+void binaryParseReply(
+    const BinaryReplyHeader& header,
+    const folly::IOBuf& buffer,
+    McFlushAllReply& reply) {
+  parseStatus(header, buffer, reply, mc_res_ok, {});
+}
+
+} // memcache
+} // facebook
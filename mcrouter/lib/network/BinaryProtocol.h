@@ -0,0 +1,159 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+#include <folly/io/IOBuf.h>
+
+#include "mcrouter/lib/network/UmbrellaProtocol.h"
+#include "mcrouter/lib/network/gen/Memcache.h"
+
+namespace facebook {
+namespace memcache {
+
+/**
+ * Memcached binary protocol, see
+ * https://github.com/memcached/memcached/wiki/BinaryProtocolRevamped
+ */
+constexpr uint8_t kBinaryRequestMagicByte = 0x80;
+constexpr uint8_t kBinaryReplyMagicByte = 0x81;
+constexpr size_t kBinaryHeaderLength = 24;
+
+enum class BinaryOpcode : uint8_t {
+  GET = 0x00,
+  SET = 0x01,
+  ADD = 0x02,
+  REPLACE = 0x03,
+  DELETE = 0x04,
+  INCREMENT = 0x05,
+  DECREMENT = 0x06,
+  FLUSH = 0x08,
+  VERSION = 0x0b,
+  APPEND = 0x0e,
+  PREPEND = 0x0f,
+  TOUCH = 0x1c,
+};
+
+enum class BinaryStatus : uint16_t {
+  NO_ERROR = 0x00,
+  KEY_NOT_FOUND = 0x01,
+  KEY_EXISTS = 0x02,
+  VALUE_TOO_LARGE = 0x03,
+  INVALID_ARGUMENTS = 0x04,
+  ITEM_NOT_STORED = 0x05,
+  NON_NUMERIC_VALUE = 0x06,
+  UNKNOWN_COMMAND = 0x81,
+  OUT_OF_MEMORY = 0x82,
+  NOT_SUPPORTED = 0x83,
+  INTERNAL_ERROR = 0x84,
+  BUSY = 0x85,
+  TEMPORARY_FAILURE = 0x86,
+};
+
+struct BinaryReplyHeader {
+  uint8_t opcode{0};
+  uint16_t keyLength{0};
+  uint8_t extrasLength{0};
+  uint16_t status{0};
+  uint32_t bodyLength{0};
+  uint32_t opaque{0};
+  uint64_t cas{0};
+};
+
+/**
+ * Parses the header of a binary protocol reply, so that McParser can frame
+ * it like caret messages: headerSize is the fixed header size, bodySize
+ * includes extras and key, and reqId is the opaque field.
+ */
+UmbrellaParseStatus
+binaryParseHeader(const uint8_t* buf, size_t nbuf, UmbrellaMessageInfo& info);
+
+/**
+ * @param buf  Beginning of a reply, at least kBinaryHeaderLength bytes.
+ */
+BinaryReplyHeader binaryParseReplyHeader(const uint8_t* buf);
+
+/**
+ * Fills the reply from a binary protocol message.
+ *
+ * @param header  Parsed header of the message.
+ * @param buffer  Coalesced IOBuf that holds the entire message
+ *                (header and body). Values reference it, they are not copied.
+ * @throws std::runtime_error  If the message is malformed.
+ */
+void binaryParseReply(
+    const BinaryReplyHeader& header,
+    const folly::IOBuf& buffer,
+    McGetReply& reply);
+void binaryParseReply(
+    const BinaryReplyHeader& header,
+    const folly::IOBuf& buffer,
+    McGetsReply& reply);
+void binaryParseReply(
+    const BinaryReplyHeader& header,
+    const folly::IOBuf& buffer,
+    McSetReply& reply);
+void binaryParseReply(
+    const BinaryReplyHeader& header,
+    const folly::IOBuf& buffer,
+    McAddReply& reply);
+void binaryParseReply(
+    const BinaryReplyHeader& header,
+    const folly::IOBuf& buffer,
+    McReplaceReply& reply);
+void binaryParseReply(
+    const BinaryReplyHeader& header,
+    const folly::IOBuf& buffer,
+    McAppendReply& reply);
+void binaryParseReply(
+    const BinaryReplyHeader& header,
+    const folly::IOBuf& buffer,
+    McPrependReply& reply);
+void binaryParseReply(
+    const BinaryReplyHeader& header,
+    const folly::IOBuf& buffer,
+    McCasReply& reply);
+void binaryParseReply(
+    const BinaryReplyHeader& header,
+    const folly::IOBuf& buffer,
+    McIncrReply& reply);
+void binaryParseReply(
+    const BinaryReplyHeader& header,
+    const folly::IOBuf& buffer,
+    McDecrReply& reply);
+void binaryParseReply(
+    const BinaryReplyHeader& header,
+    const folly::IOBuf& buffer,
+    McDeleteReply& reply);
+void binaryParseReply(
+    const BinaryReplyHeader& header,
+    const folly::IOBuf& buffer,
+    McTouchReply& reply);
+void binaryParseReply(
+    const BinaryReplyHeader& header,
+    const folly::IOBuf& buffer,
+    McVersionReply& reply);
+void binaryParseReply(
+    const BinaryReplyHeader& header,
+    const folly::IOBuf& buffer,
+    McFlushAllReply& reply);
+
+/**
+ * Requests without a binary command are never serialized
+ * (see BinarySerializedRequest), so their replies can't be received.
+ */
+template <class Reply>
+void binaryParseReply(const BinaryReplyHeader&, const folly::IOBuf&, Reply&) {
+  throw std::runtime_error("Unexpected binary reply");
+}
+
+} // memcache
+} // facebook
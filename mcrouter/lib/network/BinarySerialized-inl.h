@@ -0,0 +1,49 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+namespace facebook {
+namespace memcache {
+
+struct BinarySerializedRequest::PrepareImplWrapper {
+  template <class Request>
+  using PrepareType =
+      decltype(std::declval<BinarySerializedRequest>().prepareImpl(
+          std::declval<const Request&>()));
+
+  template <class Request>
+  typename std::enable_if<
+      std::is_same<PrepareType<Request>, std::false_type>::value,
+      bool>::type static prepare(BinarySerializedRequest&, const Request&) {
+    return false;
+  }
+
+  template <class Request>
+  typename std::enable_if<
+      std::is_same<PrepareType<Request>, void>::value,
+      bool>::
+      type static prepare(BinarySerializedRequest& s, const Request& request) {
+    s.prepareImpl(request);
+    return true;
+  }
+};
+
+template <class Request>
+bool BinarySerializedRequest::prepare(
+    const Request& request,
+    uint32_t reqId,
+    const struct iovec*& iovOut,
+    size_t& niovOut) {
+  iovsCount_ = 0;
+  reqId_ = reqId;
+  auto r = PrepareImplWrapper::prepare(*this, request);
+  iovOut = iovs_;
+  niovOut = iovsCount_;
+  return r;
+}
+
+} // memcache
+} // facebook
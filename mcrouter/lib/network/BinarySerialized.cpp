@@ -0,0 +1,189 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include "BinarySerialized.h"
+
+#include <cassert>
+#include <cstring>
+
+#include <folly/Bits.h>
+
+#include "mcrouter/lib/IOBufUtil.h"
+
+namespace facebook {
+namespace memcache {
+
+namespace {
+
+template <class T>
+uint8_t* writeBigEndian(uint8_t* buf, T value) {
+  value = folly::Endian::big(value);
+  std::memcpy(buf, &value, sizeof(T));
+  return buf + sizeof(T);
+}
+
+// Tells memcached to fail incr/decr of missing keys, like ascii does.
+constexpr uint32_t kNoAutoCreateExptime = 0xffffffff;
+
+} // anonymous namespace
+
+void BinarySerializedRequest::addString(folly::ByteRange range) {
+  assert(iovsCount_ < kMaxIovs);
+  iovs_[iovsCount_].iov_base = const_cast<unsigned char*>(range.begin());
+  iovs_[iovsCount_].iov_len = range.size();
+  ++iovsCount_;
+}
+
+void BinarySerializedRequest::addValue(const folly::IOBuf& value) {
+  // Same as in AsciiSerializedRequest: reference every buffer of a chained
+  // value, unless there are too many of them.
+  const auto nFilled =
+      value.fillIov(iovs_ + iovsCount_, kMaxIovs - iovsCount_);
+  if (nFilled > 0 || value.empty()) {
+    iovsCount_ += nFilled;
+    return;
+  }
+  addString(folly::ByteRange(
+      coalesceAndGetRange(const_cast<folly::IOBuf&>(value))));
+}
+
+void BinarySerializedRequest::addHeader(
+    BinaryOpcode opcode,
+    folly::StringPiece key,
+    uint8_t extrasLength,
+    size_t valueLength,
+    uint64_t cas) {
+  assert(extrasLength <= kMaxExtrasLength);
+  auto* buf = header_;
+  *buf++ = kBinaryRequestMagicByte;
+  *buf++ = static_cast<uint8_t>(opcode);
+  buf = writeBigEndian<uint16_t>(buf, key.size());
+  *buf++ = extrasLength;
+  *buf++ = 0; // data type
+  buf = writeBigEndian<uint16_t>(buf, 0); // vbucket
+  buf = writeBigEndian<uint32_t>(
+      buf, extrasLength + key.size() + valueLength);
+  buf = writeBigEndian<uint32_t>(buf, reqId_);
+  writeBigEndian<uint64_t>(buf, cas);
+
+  addString(folly::ByteRange(header_, kBinaryHeaderLength + extrasLength));
+  if (!key.empty()) {
+    addString(folly::ByteRange(key));
+  }
+}
+
+template <class Request>
+void BinarySerializedRequest::storageRequestCommon(
+    BinaryOpcode opcode,
+    const Request& request,
+    uint64_t cas) {
+  uint8_t extrasLength = 0;
+  // Append and prepend keep the flags and exptime of the item.
+  if (opcode != BinaryOpcode::APPEND && opcode != BinaryOpcode::PREPEND) {
+    auto* extras = header_ + kBinaryHeaderLength;
+    // Binary protocol flags are 32 bits wide.
+    extras = writeBigEndian<uint32_t>(extras, request.flags());
+    writeBigEndian<uint32_t>(extras, request.exptime());
+    extrasLength = 2 * sizeof(uint32_t);
+  }
+  addHeader(
+      opcode,
+      request.key().fullKey(),
+      extrasLength,
+      request.value().computeChainDataLength(),
+      cas);
+  addValue(request.value());
+}
+
+void BinarySerializedRequest::arithmeticRequestCommon(
+    BinaryOpcode opcode,
+    folly::StringPiece key,
+    int64_t delta) {
+  auto* extras = header_ + kBinaryHeaderLength;
+  extras = writeBigEndian<uint64_t>(extras, delta);
+  extras = writeBigEndian<uint64_t>(extras, 0); // initial value
+  writeBigEndian<uint32_t>(extras, kNoAutoCreateExptime);
+  addHeader(opcode, key, kMaxExtrasLength, 0);
+}
+
+// Get-like ops.
+void BinarySerializedRequest::prepareImpl(const McGetRequest& request) {
+  addHeader(BinaryOpcode::GET, request.key().fullKey(), 0, 0);
+}
+
+void BinarySerializedRequest::prepareImpl(const McGetsRequest& request) {
+  // Every get reply carries the cas.
+  addHeader(BinaryOpcode::GET, request.key().fullKey(), 0, 0);
+}
+
+// Update-like ops.
+void BinarySerializedRequest::prepareImpl(const McSetRequest& request) {
+  storageRequestCommon(BinaryOpcode::SET, request);
+}
+
+void BinarySerializedRequest::prepareImpl(const McAddRequest& request) {
+  storageRequestCommon(BinaryOpcode::ADD, request);
+}
+
+void BinarySerializedRequest::prepareImpl(const McReplaceRequest& request) {
+  storageRequestCommon(BinaryOpcode::REPLACE, request);
+}
+
+void BinarySerializedRequest::prepareImpl(const McAppendRequest& request) {
+  storageRequestCommon(BinaryOpcode::APPEND, request);
+}
+
+void BinarySerializedRequest::prepareImpl(const McPrependRequest& request) {
+  storageRequestCommon(BinaryOpcode::PREPEND, request);
+}
+
+void BinarySerializedRequest::prepareImpl(const McCasRequest& request) {
+  // Binary set with a cas is a compare-and-swap.
+  storageRequestCommon(BinaryOpcode::SET, request, request.casToken());
+}
+
+// Arithmetic ops.
+void BinarySerializedRequest::prepareImpl(const McIncrRequest& request) {
+  arithmeticRequestCommon(
+      BinaryOpcode::INCREMENT, request.key().fullKey(), request.delta());
+}
+
+void BinarySerializedRequest::prepareImpl(const McDecrRequest& request) {
+  arithmeticRequestCommon(
+      BinaryOpcode::DECREMENT, request.key().fullKey(), request.delta());
+}
+
+// Delete op.
+void BinarySerializedRequest::prepareImpl(const McDeleteRequest& request) {
+  // Binary delete has no exptime, memcached ignores it in ascii too.
+  addHeader(BinaryOpcode::DELETE, request.key().fullKey(), 0, 0);
+}
+
+// Touch op.
+void BinarySerializedRequest::prepareImpl(const McTouchRequest& request) {
+  writeBigEndian<uint32_t>(header_ + kBinaryHeaderLength, request.exptime());
+  addHeader(
+      BinaryOpcode::TOUCH, request.key().fullKey(), sizeof(uint32_t), 0);
+}
+
+// Version op.
+void BinarySerializedRequest::prepareImpl(const McVersionRequest&) {
+  addHeader(BinaryOpcode::VERSION, folly::StringPiece(), 0, 0);
+}
+
+// FlushAll op.
+void BinarySerializedRequest::prepareImpl(const McFlushAllRequest& request) {
+  uint8_t extrasLength = 0;
+  if (request.delay() != 0) {
+    writeBigEndian<uint32_t>(header_ + kBinaryHeaderLength, request.delay());
+    extrasLength = sizeof(uint32_t);
+  }
+  addHeader(BinaryOpcode::FLUSH, folly::StringPiece(), extrasLength, 0);
+}
+
+} // memcache
+} // facebook
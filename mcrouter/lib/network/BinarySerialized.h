@@ -0,0 +1,116 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <sys/uio.h>
+
+#include <cstdint>
+#include <type_traits>
+
+#include <folly/Range.h>
+#include <folly/io/IOBuf.h>
+
+#include "mcrouter/lib/network/BinaryProtocol.h"
+#include "mcrouter/lib/network/gen/Memcache.h"
+
+namespace facebook {
+namespace memcache {
+
+/**
+ * Class for serializing requests in memcached binary protocol.
+ */
+class BinarySerializedRequest {
+ public:
+  BinarySerializedRequest() = default;
+
+  BinarySerializedRequest(const BinarySerializedRequest&) = delete;
+  BinarySerializedRequest& operator=(const BinarySerializedRequest&) = delete;
+  BinarySerializedRequest(BinarySerializedRequest&&) = delete;
+  BinarySerializedRequest& operator=(BinarySerializedRequest&&) = delete;
+
+  /**
+   * Prepare buffers for given Request.
+   *
+   * @param request
+   * @param reqId    Id of the request, sent as the opaque field and echoed
+   *                 back in the reply.
+   * @param iovOut   will be set to the beginning of array of ivecs that
+   *                 reference serialized data.
+   * @param niovOut  number of valid iovecs referenced by iovOut.
+   * @return true iff message was successfully prepared.
+   */
+  template <class Request>
+  bool prepare(
+      const Request& request,
+      uint32_t reqId,
+      const struct iovec*& iovOut,
+      size_t& niovOut);
+
+ private:
+  // header + key + value. The rest is used for values made of several
+  // IOBufs.
+  static constexpr size_t kMaxIovs = 16;
+  // The longest extras are for incr/decr: delta, initial value and exptime.
+  static constexpr size_t kMaxExtrasLength = 20;
+
+  struct iovec iovs_[kMaxIovs];
+  size_t iovsCount_{0};
+  uint32_t reqId_{0};
+  // Header followed by the extras.
+  uint8_t header_[kBinaryHeaderLength + kMaxExtrasLength];
+
+  void addString(folly::ByteRange range);
+  void addValue(const folly::IOBuf& value);
+
+  /**
+   * Writes the header, adds it with the extras and the key to iovs_.
+   * The extras must be written to header_ + kBinaryHeaderLength before.
+   */
+  void addHeader(
+      BinaryOpcode opcode,
+      folly::StringPiece key,
+      uint8_t extrasLength,
+      size_t valueLength,
+      uint64_t cas = 0);
+
+  template <class Request>
+  void storageRequestCommon(
+      BinaryOpcode opcode,
+      const Request& request,
+      uint64_t cas = 0);
+  void arithmeticRequestCommon(
+      BinaryOpcode opcode,
+      folly::StringPiece key,
+      int64_t delta);
+
+  void prepareImpl(const McGetRequest& request);
+  void prepareImpl(const McGetsRequest& request);
+  void prepareImpl(const McSetRequest& request);
+  void prepareImpl(const McAddRequest& request);
+  void prepareImpl(const McReplaceRequest& request);
+  void prepareImpl(const McAppendRequest& request);
+  void prepareImpl(const McPrependRequest& request);
+  void prepareImpl(const McCasRequest& request);
+  void prepareImpl(const McIncrRequest& request);
+  void prepareImpl(const McDecrRequest& request);
+  void prepareImpl(const McDeleteRequest& request);
+  void prepareImpl(const McTouchRequest& request);
+  void prepareImpl(const McVersionRequest& request);
+  void prepareImpl(const McFlushAllRequest& request);
+
+  // Everything else is false.
+  template <class Request>
+  std::false_type prepareImpl(const Request& request);
+
+  struct PrepareImplWrapper;
+};
+
+} // memcache
+} // facebook
+
+#include "BinarySerialized-inl.h"
@@ -0,0 +1,156 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include "CarbonFastSerializers.h"
+
+#include <cstdint>
+#include <limits>
+#include <string>
+
+#include <folly/Likely.h>
+
+#include "mcrouter/lib/carbon/CarbonQueueAppender.h"
+#include "mcrouter/lib/carbon/Fields.h"
+#include "mcrouter/lib/carbon/Util.h"
+#include "mcrouter/lib/fbi/cpp/util.h"
+#include "mcrouter/lib/network/gen/MemcacheMessages.h"
+
+namespace facebook {
+namespace memcache {
+
+namespace {
+
+constexpr uint8_t kMaxVarintLength = 10;
+
+/**
+ * Small buffer for the non-IOBuf parts of a message, flushed to the storage
+ * before every IOBuf and at the end.
+ */
+class FieldBuffer {
+ public:
+  explicit FieldBuffer(carbon::CarbonQueueAppenderStorage& storage)
+      : storage_(storage) {}
+
+  /**
+   * Field header of a field that is `delta` ids after the previous one, as
+   * CarbonProtocolWriter::writeFieldHeader() writes it for delta <= 15.
+   */
+  void header(carbon::FieldType type, uint8_t delta) {
+    data_[size_++] = (delta << 4) | static_cast<uint8_t>(type);
+  }
+
+  void varint(uint64_t val) {
+    while (val >= 0x80) {
+      data_[size_++] = 0x80 | (static_cast<uint8_t>(val) & 0x7f);
+      val >>= 7;
+    }
+    data_[size_++] = static_cast<uint8_t>(val);
+  }
+
+  void binary(const folly::IOBuf& buf) {
+    const auto len = buf.computeChainDataLength();
+    checkRuntime(
+        len <= std::numeric_limits<uint32_t>::max(),
+        "Input to serializeCarbonStruct() too long (len = {})",
+        len);
+    varint(len);
+    flush();
+    storage_.append(buf);
+  }
+
+  void binary(const std::string& s) {
+    checkRuntime(
+        s.size() <= std::numeric_limits<uint32_t>::max(),
+        "Input to serializeCarbonStruct() too long (len = {})",
+        s.size());
+    varint(s.size());
+    flush();
+    storage_.push(reinterpret_cast<const uint8_t*>(s.data()), s.size());
+  }
+
+  void stop() {
+    data_[size_++] = static_cast<uint8_t>(carbon::FieldType::Stop);
+    flush();
+  }
+
+ private:
+  carbon::CarbonQueueAppenderStorage& storage_;
+  // Enough for all the fixed-size parts of the messages below.
+  uint8_t data_[4 * (1 + kMaxVarintLength)];
+  size_t size_{0};
+
+  void flush() {
+    if (size_ > 0) {
+      storage_.push(data_, size_);
+      size_ = 0;
+    }
+  }
+};
+
+} // anonymous
+
+void serializeCarbonStruct(
+    const McGetRequest& request,
+    carbon::CarbonQueueAppenderStorage& storage) {
+  FieldBuffer out(storage);
+  int16_t lastId = 0;
+
+  // 1: key
+  if (!request.key().empty()) {
+    out.header(carbon::FieldType::Binary, 1 - lastId);
+    out.binary(request.key().raw());
+    lastId = 1;
+  }
+  // 2: flags
+  if (FOLLY_UNLIKELY(request.flags() != 0)) {
+    out.header(carbon::FieldType::Int64, 2 - lastId);
+    out.varint(carbon::util::zigzag(static_cast<int64_t>(request.flags())));
+  }
+  out.stop();
+}
+
+void serializeCarbonStruct(
+    const McGetReply& reply,
+    carbon::CarbonQueueAppenderStorage& storage) {
+  FieldBuffer out(storage);
+  int16_t lastId = 0;
+
+  // 1: result
+  const auto result = static_cast<int16_t>(reply.result());
+  if (result != 0) {
+    out.header(carbon::FieldType::Int16, 1 - lastId);
+    out.varint(carbon::util::zigzag(result));
+    lastId = 1;
+  }
+  // 2: value
+  if (reply.value().hasValue()) {
+    out.header(carbon::FieldType::Binary, 2 - lastId);
+    out.binary(*reply.value());
+    lastId = 2;
+  }
+  // 3: flags
+  if (reply.flags() != 0) {
+    out.header(carbon::FieldType::Int64, 3 - lastId);
+    out.varint(carbon::util::zigzag(static_cast<int64_t>(reply.flags())));
+    lastId = 3;
+  }
+  // 4: message
+  if (FOLLY_UNLIKELY(!reply.message().empty())) {
+    out.header(carbon::FieldType::Binary, 4 - lastId);
+    out.binary(reply.message());
+    lastId = 4;
+  }
+  // 5: appSpecificErrorCode
+  if (FOLLY_UNLIKELY(reply.appSpecificErrorCode() != 0)) {
+    out.header(carbon::FieldType::Int16, 5 - lastId);
+    out.varint(carbon::util::zigzag(reply.appSpecificErrorCode()));
+  }
+  out.stop();
+}
+
+} // memcache
+} // facebook
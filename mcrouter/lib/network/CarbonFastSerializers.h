@@ -0,0 +1,38 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+namespace carbon {
+class CarbonQueueAppenderStorage;
+} // carbon
+
+namespace facebook {
+namespace memcache {
+
+class McGetReply;
+class McGetRequest;
+
+/**
+ * Hand-rolled serializers for the hottest message types, picked over the
+ * generic serializeCarbonStruct() by overload resolution.
+ *
+ * They produce exactly the same bytes as the generated serialize() methods,
+ * but write the (constant) field headers, varints and stop byte in as few
+ * storage pushes as possible, without the CarbonProtocolWriter bookkeeping.
+ * They must be kept in sync with the field ids and types in Memcache.idl.
+ */
+void serializeCarbonStruct(
+    const McGetRequest& request,
+    carbon::CarbonQueueAppenderStorage& storage);
+
+void serializeCarbonStruct(
+    const McGetReply& reply,
+    carbon::CarbonQueueAppenderStorage& storage);
+
+} // memcache
+} // facebook
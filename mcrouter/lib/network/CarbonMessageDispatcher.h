@@ -7,6 +7,10 @@
  */
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
 #include <folly/io/Cursor.h>
 #include <folly/io/IOBuf.h>
 
@@ -14,6 +18,7 @@
 #include "mcrouter/lib/carbon/CarbonProtocolWriter.h"
 #include "mcrouter/lib/carbon/CarbonQueueAppender.h"
 #include "mcrouter/lib/carbon/RequestReplyUtil.h"
+#include "mcrouter/lib/network/CarbonFastSerializers.h"
 #include "mcrouter/lib/network/CaretHeader.h"
 #include "mcrouter/lib/network/TypedMsg.h"
 
@@ -89,6 +94,8 @@ class CarbonMessageDispatcher {
     carbon::CarbonProtocolReader reader(cur);
     M req;
     req.setTraceId(headerInfo.traceId);
+    req.setTimeoutBudgetMs(std::min<uint64_t>(
+        headerInfo.timeoutBudgetMs, std::numeric_limits<uint32_t>::max()));
     req.deserialize(reader);
     static_cast<Proc&>(me).onTypedMessage(
         std::move(req), std::forward<Args>(args)...);
@@ -0,0 +1,155 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include "CaretBatcher.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include <folly/GroupVarint.h>
+#include <folly/Range.h>
+#include <folly/Varint.h>
+
+#include "mcrouter/lib/network/CaretHeader.h"
+#include "mcrouter/lib/network/UmbrellaProtocol.h"
+
+namespace facebook {
+namespace memcache {
+
+namespace {
+
+// Upper bound on the bytes batching adds per message: the reqId delta and
+// body size varints, and for the first message of a batch, the BATCH_SIZE
+// field and the longer body size of the batch header.
+constexpr size_t kMaxBatchOverhead = 2 * folly::kMaxVarintLength32 +
+    2 * folly::kMaxVarintLength64 + sizeof(uint32_t);
+
+struct Message {
+  UmbrellaMessageInfo info;
+  // Serialized additional fields, compared to tell if messages can be merged.
+  folly::StringPiece fields;
+  // Index of the iovec the message starts with.
+  size_t iovIdx;
+};
+
+bool canMerge(const Message& a, const Message& b) {
+  return a.info.typeId == b.info.typeId && a.fields == b.fields;
+}
+
+uint8_t* copyMessage(
+    const struct iovec* iovs,
+    const Message& message,
+    size_t offset,
+    uint8_t* out) {
+  auto iovIdx = message.iovIdx;
+  size_t left = message.info.headerSize + message.info.bodySize - offset;
+  while (left > 0) {
+    const auto& iov = iovs[iovIdx++];
+    if (offset >= iov.iov_len) {
+      offset -= iov.iov_len;
+      continue;
+    }
+    const auto len = std::min(iov.iov_len - offset, left);
+    std::memcpy(out, static_cast<const uint8_t*>(iov.iov_base) + offset, len);
+    out += len;
+    left -= len;
+    offset = 0;
+  }
+  return out;
+}
+
+} // anonymous
+
+std::unique_ptr<folly::IOBuf> CaretBatcher::batch(
+    const struct iovec* iovs,
+    size_t iovCount) {
+  std::vector<Message> messages;
+  size_t totalSize = 0;
+  bool mergeable = false;
+  size_t iovIdx = 0;
+  while (iovIdx < iovCount) {
+    Message message;
+    message.iovIdx = iovIdx;
+    const auto* header = static_cast<const char*>(iovs[iovIdx].iov_base);
+    if (caretParseHeader(
+            reinterpret_cast<const uint8_t*>(header),
+            iovs[iovIdx].iov_len,
+            message.info) != UmbrellaParseStatus::OK ||
+        message.info.reqId == kCaretConnectionControlReqId ||
+        message.info.moreFragments != 0 || message.info.batchSize != 0) {
+      return nullptr;
+    }
+    const auto fieldsOffset =
+        1 /* magic byte */ + folly::GroupVarint32::encodedSize(header + 1);
+    message.fields = folly::StringPiece(
+        header + fieldsOffset, message.info.headerSize - fieldsOffset);
+
+    // The next message starts with the next iovec.
+    const size_t size = message.info.headerSize + message.info.bodySize;
+    size_t left = size;
+    while (left > 0) {
+      if (iovIdx == iovCount || iovs[iovIdx].iov_len > left) {
+        return nullptr;
+      }
+      left -= iovs[iovIdx++].iov_len;
+    }
+
+    if (!messages.empty() && canMerge(messages.back(), message)) {
+      mergeable = true;
+    }
+    totalSize += size;
+    messages.push_back(message);
+  }
+  if (!mergeable) {
+    return nullptr;
+  }
+
+  auto buf =
+      folly::IOBuf::create(totalSize + messages.size() * kMaxBatchOverhead);
+  auto* out = buf->writableTail();
+  for (size_t begin = 0; begin < messages.size();) {
+    auto end = begin + 1;
+    while (end < messages.size() && canMerge(messages[begin], messages[end])) {
+      ++end;
+    }
+    if (end - begin == 1) {
+      out = copyMessage(iovs, messages[begin], 0, out);
+      begin = end;
+      continue;
+    }
+
+    auto info = messages[begin].info;
+    info.bodySize = 0;
+    info.batchSize = end - begin;
+    auto reqId = info.reqId;
+    for (auto i = begin; i < end; ++i) {
+      const auto& item = messages[i].info;
+      const uint32_t reqIdDelta = item.reqId - reqId;
+      info.bodySize += folly::encodedVarintSize(reqIdDelta) +
+          folly::encodedVarintSize(item.bodySize) + item.bodySize;
+      reqId = item.reqId;
+    }
+    out += caretPrepareHeader(info, reinterpret_cast<char*>(out));
+
+    reqId = info.reqId;
+    for (auto i = begin; i < end; ++i) {
+      const auto& item = messages[i].info;
+      const uint32_t reqIdDelta = item.reqId - reqId;
+      out += folly::encodeVarint(reqIdDelta, out);
+      out += folly::encodeVarint(item.bodySize, out);
+      out = copyMessage(iovs, messages[i], item.headerSize, out);
+      reqId = item.reqId;
+    }
+    begin = end;
+  }
+  buf->append(out - buf->writableTail());
+  return buf;
+}
+
+} // memcache
+} // facebook
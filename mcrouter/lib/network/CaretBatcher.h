@@ -0,0 +1,47 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <sys/uio.h>
+
+#include <cstddef>
+#include <memory>
+
+#include <folly/io/IOBuf.h>
+
+namespace facebook {
+namespace memcache {
+
+/**
+ * Merges runs of consecutive caret messages that have the same typeId and the
+ * same additional fields into batch frames, so that small messages don't pay
+ * for a header each, and the receiver parses one header per batch.
+ *
+ * A batch frame is a caret message with BATCH_SIZE set to the number of
+ * messages in it. Its header has the typeId, reqId and additional fields of
+ * the first message. Its body has, for every message, the reqId delta from
+ * the previous message (0 for the first one) and the body size as varints,
+ * followed by the body. McParser splits batches back into messages.
+ */
+class CaretBatcher {
+ public:
+  /**
+   * @param iovs      Serialized caret messages, every one starting with its
+   *                  header at the beginning of an iovec.
+   * @param iovCount  Number of iovecs in iovs.
+   *
+   * @return  copy of the messages with the runs merged into batches, nullptr
+   *          if no two messages can be merged or iovs could not be parsed.
+   */
+  static std::unique_ptr<folly::IOBuf> batch(
+      const struct iovec* iovs,
+      size_t iovCount);
+};
+
+} // memcache
+} // facebook
@@ -0,0 +1,85 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include "CaretFragmenter.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "mcrouter/lib/network/UmbrellaProtocol.h"
+
+namespace facebook {
+namespace memcache {
+
+CaretFragmenter::CaretFragmenter(
+    const struct iovec* iovs,
+    size_t iovCount,
+    size_t frameSize)
+    : iovs_(iovs), iovCount_(iovCount), frameSize_(frameSize) {
+  assert(frameSize_ > 0);
+  size_t totalSize = 0;
+  for (size_t i = 0; i < iovCount_; ++i) {
+    totalSize += iovs_[i].iov_len;
+  }
+  if (totalSize <= frameSize_) {
+    return;
+  }
+  // The header is never split between iovecs.
+  if (caretParseHeader(
+          reinterpret_cast<const uint8_t*>(iovs_[0].iov_base),
+          iovs_[0].iov_len,
+          info_) != UmbrellaParseStatus::OK ||
+      info_.moreFragments != 0 || info_.batchSize != 0 ||
+      info_.reqId == kCaretConnectionControlReqId ||
+      totalSize != info_.headerSize + info_.bodySize ||
+      info_.bodySize <= frameSize_) {
+    return;
+  }
+  iovOffset_ = info_.headerSize;
+  remaining_ = info_.bodySize;
+  shouldFragment_ = true;
+}
+
+std::pair<const struct iovec*, size_t> CaretFragmenter::nextFrame() {
+  assert(shouldFragment_ && !done());
+
+  UmbrellaMessageInfo frame;
+  if (first_) {
+    frame = info_;
+  }
+  frame.typeId = info_.typeId;
+  frame.reqId = info_.reqId;
+  frame.bodySize = std::min(frameSize_, remaining_);
+  frame.moreFragments = remaining_ > frame.bodySize ? 1 : 0;
+
+  frameIovs_.clear();
+  frameIovs_.push_back({header_, caretPrepareHeader(frame, header_)});
+
+  size_t left = frame.bodySize;
+  while (left > 0) {
+    assert(iovIdx_ < iovCount_);
+    const auto& iov = iovs_[iovIdx_];
+    const size_t len = std::min(iov.iov_len - iovOffset_, left);
+    if (len > 0) {
+      frameIovs_.push_back(
+          {static_cast<char*>(iov.iov_base) + iovOffset_, len});
+    }
+    left -= len;
+    iovOffset_ += len;
+    if (iovOffset_ == iov.iov_len) {
+      ++iovIdx_;
+      iovOffset_ = 0;
+    }
+  }
+
+  remaining_ -= frame.bodySize;
+  first_ = false;
+  return std::make_pair(frameIovs_.data(), frameIovs_.size());
+}
+
+} // memcache
+} // facebook
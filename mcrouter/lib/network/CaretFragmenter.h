@@ -0,0 +1,79 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <sys/uio.h>
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "mcrouter/lib/network/CaretHeader.h"
+
+namespace facebook {
+namespace memcache {
+
+/**
+ * Splits a serialized caret message into frames of at most frameSize body
+ * bytes, so that other messages can be written between them.
+ *
+ * Every frame is a caret message with the same reqId and typeId, and all but
+ * the last one have MORE_FRAGMENTS set. The first frame carries all the other
+ * additional fields of the original header. McParser reassembles the frames.
+ *
+ * The message data is referenced, not copied: it must outlive the fragmenter.
+ */
+class CaretFragmenter {
+ public:
+  /**
+   * @param iovs       Serialized message, starting with its caret header.
+   * @param iovCount   Number of iovecs in iovs.
+   * @param frameSize  Max frame body size, > 0.
+   */
+  CaretFragmenter(const struct iovec* iovs, size_t iovCount, size_t frameSize);
+
+  /**
+   * @return  false iff the message has to be sent as is: its body fits in
+   *          one frame, or it could not be parsed.
+   */
+  bool shouldFragment() const {
+    return shouldFragment_;
+  }
+
+  /**
+   * @return  true iff all the frames were returned by nextFrame().
+   */
+  bool done() const {
+    return !first_ && remaining_ == 0;
+  }
+
+  /**
+   * @return  iovecs of the next frame (header and body), valid until the next
+   *          call.
+   */
+  std::pair<const struct iovec*, size_t> nextFrame();
+
+ private:
+  UmbrellaMessageInfo info_;
+  const struct iovec* iovs_;
+  const size_t iovCount_;
+  const size_t frameSize_;
+  bool shouldFragment_{false};
+  bool first_{true};
+
+  // Position of the first body byte not returned yet.
+  size_t iovIdx_{0};
+  size_t iovOffset_{0};
+  size_t remaining_{0};
+
+  char header_[kMaxHeaderLength];
+  std::vector<struct iovec> frameIovs_;
+};
+
+} // memcache
+} // facebook
@@ -49,6 +49,17 @@ struct UmbrellaMessageInfo {
   uint64_t uncompressedBodySize{0};
   uint64_t dropProbability{0}; // Use uint64_t to store a double.
   ServerLoad serverLoad{0};
+  // Time the sender is willing to wait for the reply, 0 if unknown.
+  uint64_t timeoutBudgetMs{0};
+  // Replies only: number of unreplied requests the server accepts on this
+  // connection, 0 if unlimited.
+  uint64_t creditWindow{0};
+  // Non-zero iff the message continues in the next frame with the same reqId.
+  uint64_t moreFragments{0};
+  // Requests only: non-zero iff the sender can reassemble fragmented replies.
+  uint64_t acceptsFragments{0};
+  // Number of messages in a batch frame, 0 if not a batch (see CaretBatcher).
+  uint64_t batchSize{0};
 };
 
 enum class CaretAdditionalFieldType {
@@ -72,6 +83,21 @@ enum class CaretAdditionalFieldType {
 
   // Load on the server
   SERVER_LOAD = 7,
+
+  // Time in ms the sender of a request is going to wait for the reply
+  TIMEOUT_BUDGET_MS = 8,
+
+  // Max number of unreplied requests the server accepts on the connection
+  CREDIT_WINDOW = 9,
+
+  // Message is fragmented and this is not its last frame
+  MORE_FRAGMENTS = 10,
+
+  // Sender of the request can reassemble fragmented replies
+  ACCEPTS_FRAGMENTS = 11,
+
+  // Message is a batch of this many messages
+  BATCH_SIZE = 12,
 };
 
 } // memcache
@@ -5,6 +5,9 @@
  *  file in the root directory of this source tree.
  *
  */
+#include <folly/fibers/FiberManager.h>
+
+#include "mcrouter/lib/CompressionOffload.h"
 #include "mcrouter/lib/network/CarbonMessageDispatcher.h"
 #include "mcrouter/lib/network/UmbrellaProtocol.h"
 
@@ -16,6 +19,8 @@ bool CaretSerializedMessage::prepare(
     const Request& req,
     size_t reqId,
     const CodecIdRange& supportedCodecs,
+    std::chrono::milliseconds timeoutBudget,
+    const CompressionCodecMap* compressionCodecMap,
     const struct iovec*& iovOut,
     size_t& niovOut) noexcept {
   return fill(
@@ -24,6 +29,8 @@ bool CaretSerializedMessage::prepare(
       Request::typeId,
       req.traceToInts(),
       supportedCodecs,
+      timeoutBudget,
+      compressionCodecMap,
       iovOut,
       niovOut);
 }
@@ -36,6 +43,7 @@ bool CaretSerializedMessage::prepare(
     const CompressionCodecMap* compressionCodecMap,
     double dropProbability,
     ServerLoad serverLoad,
+    uint32_t creditWindow,
     const struct iovec*& iovOut,
     size_t& niovOut) noexcept {
   return fill(
@@ -47,6 +55,7 @@ bool CaretSerializedMessage::prepare(
       compressionCodecMap,
       dropProbability,
       serverLoad,
+      creditWindow,
       iovOut,
       niovOut);
 }
@@ -58,6 +67,8 @@ bool CaretSerializedMessage::fill(
     size_t typeId,
     std::pair<uint64_t, uint64_t> traceId,
     const CodecIdRange& supportedCodecs,
+    std::chrono::milliseconds timeoutBudget,
+    const CompressionCodecMap* compressionCodecMap,
     const struct iovec*& iovOut,
     size_t& niovOut) {
   // Serialize body into storage_. Note we must defer serialization of header.
@@ -69,10 +80,26 @@ bool CaretSerializedMessage::fill(
   }
 
   UmbrellaMessageInfo info;
+
+  // Maybe compress. The server looks the codec up by id in its own map.
+  if (compressionCodecMap != nullptr) {
+    auto uncompressedSize = storage_.computeBodySize();
+    auto codec = compressionCodecMap->getBest(
+        compressionCodecMap->getIdRange(), uncompressedSize, typeId);
+    if (maybeCompress(codec, uncompressedSize)) {
+      info.usedCodecId = codec->id();
+      info.uncompressedBodySize = uncompressedSize;
+    }
+  }
   if (!supportedCodecs.isEmpty()) {
     info.supportedCodecsFirstId = supportedCodecs.firstId;
     info.supportedCodecsSize = supportedCodecs.size;
   }
+  if (timeoutBudget.count() > 0) {
+    info.timeoutBudgetMs = timeoutBudget.count();
+  }
+  // McParser reassembles fragmented replies.
+  info.acceptsFragments = 1;
   fillImpl(
       info, reqId, typeId, traceId, 0.0, ServerLoad::zero(), iovOut, niovOut);
   return true;
@@ -88,6 +115,7 @@ bool CaretSerializedMessage::fill(
     const CompressionCodecMap* compressionCodecMap,
     double dropProbability,
     ServerLoad serverLoad,
+    uint32_t creditWindow,
     const struct iovec*& iovOut,
     size_t& niovOut) {
   // Serialize and (maybe) compress body of message.
@@ -110,6 +138,7 @@ bool CaretSerializedMessage::fill(
     info.usedCodecId = codec->id();
     info.uncompressedBodySize = uncompressedSize;
   }
+  info.creditWindow = creditWindow;
 
   fillImpl(
       info,
@@ -138,7 +167,13 @@ inline bool CaretSerializedMessage::maybeCompress(
   static constexpr size_t kCompressionOverhead = 4;
   try {
     const auto iovs = storage_.getIovecs();
-    auto compressedBuf = codec->compress(iovs.first, iovs.second);
+    // Big bodies are compressed on the thread pool while the fiber waits.
+    const bool offload = compressionOffload_ &&
+        compressionOffload_->shouldOffload(uncompressedSize) &&
+        folly::fibers::onFiber();
+    auto compressedBuf = offload
+        ? compressionOffload_->compress(codec->id(), iovs.first, iovs.second)
+        : codec->compress(iovs.first, iovs.second);
     auto compressedSize = compressedBuf->computeChainDataLength();
     if ((compressedSize + kCompressionOverhead) < uncompressedSize) {
       storage_.reset();
@@ -146,7 +181,7 @@ inline bool CaretSerializedMessage::maybeCompress(
       return true;
     }
   } catch (const std::exception& e) {
-    LOG(ERROR) << "Error compressing reply: " << e.what();
+    LOG(ERROR) << "Error compressing message: " << e.what();
   }
 
   return false;
@@ -0,0 +1,169 @@
+/*
+ *  Copyright (c) 2015-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <chrono>
+#include <utility>
+
+#include <folly/Range.h>
+#include <folly/Varint.h>
+
+#include "mcrouter/lib/Compression.h"
+#include "mcrouter/lib/CompressionCodecManager.h"
+#include "mcrouter/lib/carbon/CarbonQueueAppender.h"
+#include "mcrouter/lib/network/ServerLoad.h"
+#include "mcrouter/lib/network/UmbrellaProtocol.h"
+
+namespace facebook {
+namespace memcache {
+
+struct CodecIdRange;
+class CompressionCodec;
+class CompressionOffload;
+
+/**
+ * Class for serializing requests in the form of Carbon structs.
+ */
+class CaretSerializedMessage {
+ public:
+  CaretSerializedMessage() = default;
+
+  CaretSerializedMessage(const CaretSerializedMessage&) = delete;
+  CaretSerializedMessage& operator=(const CaretSerializedMessage&) = delete;
+  CaretSerializedMessage(CaretSerializedMessage&&) noexcept = delete;
+  CaretSerializedMessage& operator=(CaretSerializedMessage&&) = delete;
+
+  void clear() {
+    storage_.reset();
+  }
+
+  /**
+   * If set, bodies that `offload` deems big enough are compressed on its
+   * thread pool when preparing from a fiber.
+   */
+  void setCompressionOffload(const CompressionOffload* offload) {
+    compressionOffload_ = offload;
+  }
+
+  /**
+   * Prepare requests for serialization for an Operation
+   *
+   * @param req               Request
+   * @param iovOut            Set to the beginning of array of ivecs that
+   *                          reference serialized data.
+   * @param supportedCodecs   Range of supported compression codecs.
+   * @param timeoutBudget     Time the sender is going to wait for the reply,
+   *                          0 if unknown.
+   * @param compressionCodecMap  Codecs to compress the request body with,
+   *                             nullptr to send it uncompressed. The server
+   *                             must have the same codecs.
+   * @param niovOut           Number of valid iovecs referenced by iovOut.
+   *
+   * @return true iff message was successfully prepared.
+   */
+  template <class Request>
+  bool prepare(
+      const Request& req,
+      size_t reqId,
+      const CodecIdRange& supportedCodecs,
+      std::chrono::milliseconds timeoutBudget,
+      const CompressionCodecMap* compressionCodecMap,
+      const struct iovec*& iovOut,
+      size_t& niovOut) noexcept;
+
+  /**
+   * Prepare replies for serialization
+   *
+   * @param reply                 TypedReply.
+   * @param reqId                 Request id.
+   * @param supportedCodecs       Range of supported codecs.
+   * @param compressionCodecMap   Map of available codecs.
+   * @param dropProbability       Probability to drop subsequent request.
+   * @param serverLoad            Represents load on the server.
+   * @param creditWindow          Max number of unreplied requests the server
+   *                              accepts on the connection, 0 if unlimited.
+   * @param iovOut                Will be set to the beginning of
+   *                              array of iovecs
+   * @param niovOut               Number of valid iovecs referenced by iovOut.
+   *
+   * @return true if message was successfully prepared.
+   */
+  template <class Reply>
+  bool prepare(
+      Reply&& reply,
+      size_t reqId,
+      const CodecIdRange& supportedCodecs,
+      const CompressionCodecMap* compressionCodecMap,
+      double dropProbability,
+      ServerLoad serverLoad,
+      uint32_t creditWindow,
+      const struct iovec*& iovOut,
+      size_t& niovOut) noexcept;
+
+  /**
+   * @return  IOBuf owning the biggest chunk of serialized data (if any).
+   */
+  const folly::IOBuf* valueBuf() const {
+    return storage_.largestHeldBuf();
+  }
+
+ private:
+  carbon::CarbonQueueAppenderStorage storage_;
+  const CompressionOffload* compressionOffload_{nullptr};
+
+  template <class Message>
+  bool fill(
+      const Message& message,
+      uint32_t reqId,
+      size_t typeId,
+      std::pair<uint64_t, uint64_t> traceId,
+      const CodecIdRange& supportedCodecs,
+      std::chrono::milliseconds timeoutBudget,
+      const CompressionCodecMap* compressionCodecMap,
+      const struct iovec*& iovOut,
+      size_t& niovOut);
+
+  template <class Message>
+  bool fill(
+      const Message& message,
+      uint32_t reqId,
+      size_t typeId,
+      std::pair<uint64_t, uint64_t> traceId,
+      const CodecIdRange& supportedCodecs,
+      const CompressionCodecMap* compressionCodecMap,
+      double dropProbability,
+      ServerLoad serverLoad,
+      uint32_t creditWindow,
+      const struct iovec*& iovOut,
+      size_t& niovOut);
+
+  void fillImpl(
+      UmbrellaMessageInfo& info,
+      uint32_t reqId,
+      size_t typeId,
+      std::pair<uint64_t, uint64_t> traceId,
+      double dropProbability,
+      ServerLoad serverLoad,
+      const struct iovec*& iovOut,
+      size_t& niovOut);
+
+  /**
+   * Compress body of message in storage_
+   *
+   * @param codec             Compression codec to use in compression.
+   * @param uncompressedSize  Original (uncompressed) size of the body of the
+   *                          message.
+   * @return                  True if compression succeeds. Otherwise, false.
+   */
+  bool maybeCompress(CompressionCodec* codec, size_t uncompressedSize);
+};
+
+} // memcache
+} // facebook
+
+#include "mcrouter/lib/network/CaretSerializedMessage-inl.h"
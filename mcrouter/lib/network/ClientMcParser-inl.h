@@ -60,7 +60,11 @@ template <class Request>
 typename std::enable_if<ListContains<McRequestList, Request>::value>::type
 ClientMcParser<Callback>::expectNext() {
   if (parser_.protocol() == mc_ascii_protocol) {
-    asciiParser_.initializeReplyParser<Request>();
+    if (metaCommands_) {
+      asciiParser_.initializeMetaReplyParser<Request>();
+    } else {
+      asciiParser_.initializeReplyParser<Request>();
+    }
     replyForwarder_ = &ClientMcParser<Callback>::forwardAsciiReply<Request>;
     if (UNLIKELY(debugFifo_ && debugFifo_->isConnected())) {
       debugFifo_->startMessage(
@@ -72,6 +76,9 @@ ClientMcParser<Callback>::expectNext() {
   } else if (parser_.protocol() == mc_caret_protocol) {
     umbrellaOrCaretForwarder_ =
         &ClientMcParser<Callback>::forwardCaretReply<Request>;
+  } else if (parser_.protocol() == mc_binary_protocol) {
+    umbrellaOrCaretForwarder_ =
+        &ClientMcParser<Callback>::forwardBinaryReply<Request>;
   }
 }
 
@@ -87,16 +94,18 @@ ClientMcParser<Callback>::expectNext() {
 template <class Callback>
 template <class Request>
 void ClientMcParser<Callback>::forwardAsciiReply() {
+  const bool valueCopied = asciiParser_.valueCopied();
   auto reply = asciiParser_.getReply<ReplyT<Request>>();
-  uint32_t replySize = carbon::valueRangeSlow(reply).size();
-  callback_.replyReady(
-      std::move(reply),
-      0, /* reqId */
-      ReplyStatsContext(
-          0 /* usedCodecId  */,
-          replySize /* reply size before compression */,
-          replySize /* reply size after compression */,
-          ServerLoad::zero()));
+  // Don't use valueRangeSlow() here, it would coalesce the value.
+  const auto valuePtr = carbon::valuePtrUnsafe(reply);
+  uint32_t replySize = valuePtr ? valuePtr->computeChainDataLength() : 0;
+  ReplyStatsContext replyStatsContext(
+      0 /* usedCodecId  */,
+      replySize /* reply size before compression */,
+      replySize /* reply size after compression */,
+      ServerLoad::zero());
+  replyStatsContext.valueCopied = valueCopied;
+  callback_.replyReady(std::move(reply), 0 /* reqId */, replyStatsContext);
   replyForwarder_ = nullptr;
 }
 
@@ -129,6 +138,33 @@ void ClientMcParser<Callback>::forwardCaretReply(
   const folly::IOBuf* finalBuffer = &buffer;
   size_t offset = headerInfo.headerSize;
 
+  // Big bodies are uncompressed off this thread, the reply is delivered
+  // once that's done.
+  if (headerInfo.usedCodecId > 0 && decompressionOffload_ &&
+      headerInfo.uncompressedBodySize >= decompressionOffloadThreshold_) {
+    decompressionOffload_(
+        headerInfo.usedCodecId,
+        folly::IOBuf::copyBuffer(
+            buffer.data() + headerInfo.headerSize, headerInfo.bodySize),
+        headerInfo.uncompressedBodySize,
+        [cb = &callback_, reqId, stats = getReplyStats(headerInfo)](
+            folly::Try<std::unique_ptr<folly::IOBuf>> uncompressed) {
+          ReplyT<Request> reply;
+          try {
+            folly::io::Cursor cur(uncompressed.value().get());
+            carbon::CarbonProtocolReader reader(cur);
+            reply.deserialize(reader);
+          } catch (const std::exception& e) {
+            cb->parseError(
+                mc_res_remote_error,
+                folly::sformat("Failed to uncompress reply: {}", e.what()));
+            return;
+          }
+          cb->replyReady(std::move(reply), reqId, stats);
+        });
+    return;
+  }
+
   // Uncompress if compressed
   std::unique_ptr<folly::IOBuf> uncompressedBuf;
   if (headerInfo.usedCodecId > 0) {
@@ -146,6 +182,25 @@ void ClientMcParser<Callback>::forwardCaretReply(
   callback_.replyReady(std::move(reply), reqId, getReplyStats(headerInfo));
 }
 
+template <class Callback>
+template <class Request>
+void ClientMcParser<Callback>::forwardBinaryReply(
+    const UmbrellaMessageInfo& headerInfo,
+    const folly::IOBuf& buffer,
+    uint64_t reqId) {
+  ReplyT<Request> reply;
+  binaryParseReply(binaryParseReplyHeader(buffer.data()), buffer, reply);
+
+  callback_.replyReady(
+      std::move(reply),
+      reqId,
+      ReplyStatsContext(
+          0 /* usedCodecId */,
+          headerInfo.bodySize,
+          headerInfo.bodySize,
+          ServerLoad::zero()));
+}
+
 template <class Callback>
 std::unique_ptr<folly::IOBuf> ClientMcParser<Callback>::decompress(
     const UmbrellaMessageInfo& headerInfo,
@@ -221,6 +276,31 @@ bool ClientMcParser<Callback>::caretMessageReady(
   }
 }
 
+template <class Callback>
+bool ClientMcParser<Callback>::binaryMessageReady(
+    const UmbrellaMessageInfo& headerInfo,
+    const folly::IOBuf& buffer) {
+  if (UNLIKELY(parser_.protocol() != mc_binary_protocol)) {
+    const auto reason = folly::sformat(
+        "Expected {} protocol, but received binary!",
+        mc_protocol_to_string(parser_.protocol()));
+    callback_.parseError(mc_res_local_error, reason);
+    return false;
+  }
+
+  try {
+    if (callback_.nextReplyAvailable(headerInfo.reqId)) {
+      (this->*umbrellaOrCaretForwarder_)(headerInfo, buffer, headerInfo.reqId);
+    }
+    return true;
+  } catch (const std::exception& e) {
+    const auto reason =
+        folly::sformat("Error parsing binary message: {}", e.what());
+    callback_.parseError(mc_res_local_error, reason);
+    return false;
+  }
+}
+
 template <class Callback>
 void ClientMcParser<Callback>::handleAscii(folly::IOBuf& readBuffer) {
   if (UNLIKELY(parser_.protocol() != mc_ascii_protocol)) {
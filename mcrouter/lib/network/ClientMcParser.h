@@ -10,11 +10,14 @@
 #include <type_traits>
 #include <utility>
 
+#include <folly/Function.h>
 #include <folly/Range.h>
+#include <folly/Try.h>
 #include <folly/io/IOBuf.h>
 
 #include "mcrouter/lib/CompressionCodecManager.h"
 #include "mcrouter/lib/debug/ConnectionFifo.h"
+#include "mcrouter/lib/network/BinaryProtocol.h"
 #include "mcrouter/lib/network/McAsciiParser.h"
 #include "mcrouter/lib/network/McParser.h"
 #include "mcrouter/lib/network/ReplyStatsContext.h"
@@ -69,8 +72,46 @@ class ClientMcParser : private McParser::ParserCallback {
     parser_.setProtocol(protocol);
   }
 
+  /**
+   * Expect meta command replies for ASCII requests serialized with
+   * mc_meta_protocol.
+   */
+  void setMetaCommands(bool metaCommands) {
+    metaCommands_ = metaCommands;
+  }
+
+  using DeliverUncompressedFunc =
+      folly::Function<void(folly::Try<std::unique_ptr<folly::IOBuf>>)>;
+  using DecompressionOffloadFunc = folly::Function<void(
+      uint32_t codecId,
+      std::unique_ptr<folly::IOBuf> body,
+      size_t uncompressedSize,
+      DeliverUncompressedFunc deliver)>;
+
+  /**
+   * Caret replies with an uncompressed body of at least `threshold` bytes are
+   * handed to `offload` instead of being uncompressed inline. `offload` must
+   * call `deliver` with the uncompressed body on this parser's thread, and
+   * only while the callback is alive.
+   */
+  void setDecompressionOffload(
+      size_t threshold,
+      DecompressionOffloadFunc offload) {
+    decompressionOffloadThreshold_ = threshold;
+    decompressionOffload_ = std::move(offload);
+  }
+
   double getDropProbability() const;
 
+  /**
+   * @return  Max number of unreplied requests the server accepts, as
+   *          advertised in the last caret reply. 0 if unlimited or unknown.
+   */
+  size_t getCreditWindow() const {
+    return parser_.protocol() == mc_caret_protocol ? parser_.getCreditWindow()
+                                                   : 0;
+  }
+
  private:
   McParser parser_;
   McClientAsciiParser asciiParser_;
@@ -86,6 +127,11 @@ class ClientMcParser : private McParser::ParserCallback {
 
   const CompressionCodecMap* compressionCodecMap_{nullptr};
 
+  size_t decompressionOffloadThreshold_{0};
+  DecompressionOffloadFunc decompressionOffload_;
+
+  bool metaCommands_{false};
+
   template <class Request>
   void forwardAsciiReply();
 
@@ -101,6 +147,12 @@ class ClientMcParser : private McParser::ParserCallback {
       const folly::IOBuf& buffer,
       uint64_t reqId);
 
+  template <class Request>
+  void forwardBinaryReply(
+      const UmbrellaMessageInfo& headerInfo,
+      const folly::IOBuf& buffer,
+      uint64_t reqId);
+
   std::unique_ptr<folly::IOBuf> decompress(
       const UmbrellaMessageInfo& headerInfo,
       const folly::IOBuf& buffer);
@@ -112,6 +164,12 @@ class ClientMcParser : private McParser::ParserCallback {
   bool caretMessageReady(
       const UmbrellaMessageInfo& headerInfo,
       const folly::IOBuf& buffer) final;
+  bool chainedMessagesSupported() const final {
+    return true;
+  }
+  bool binaryMessageReady(
+      const UmbrellaMessageInfo& headerInfo,
+      const folly::IOBuf& buffer) final;
   void handleAscii(folly::IOBuf& readBuffer) final;
   void parseError(mc_res_t result, folly::StringPiece reason) final;
 
@@ -13,6 +13,7 @@
 #include <folly/io/async/AsyncSocket.h>
 
 #include "mcrouter/lib/CompressionCodecManager.h"
+#include "mcrouter/lib/CompressionOffload.h"
 #include "mcrouter/lib/mc/protocol.h"
 #include "mcrouter/lib/network/AccessPoint.h"
 
@@ -66,6 +67,22 @@ struct ConnectionOptions {
    */
   std::chrono::milliseconds writeTimeout{0};
 
+  /**
+   * Upper bounds on the amount of data the writer loop coalesces into a single
+   * writev() call. Larger batches mean fewer syscalls per event loop iteration
+   * for busy destinations, at the cost of bigger individual writes.
+   */
+  size_t maxWriteBatchBytes{24576 /* 24KB */};
+  size_t maxWriteBatchIovecs{128};
+
+  /**
+   * Requests with values of at least this many bytes are sent with
+   * MSG_ZEROCOPY, the values are kept alive until the kernel reports
+   * completion.
+   * Ignored for SSL connections. 0 disables zero-copy sends.
+   */
+  size_t zeroCopyThreshold{0};
+
   /**
    * Informs whether QoS is enabled.
    */
@@ -117,6 +134,26 @@ struct ConnectionOptions {
    */
   const CompressionCodecMap* compressionCodecMap{nullptr};
 
+  /**
+   * If true, caret request bodies are also compressed with
+   * compressionCodecMap. The server must have the same codecs.
+   */
+  bool compressRequests{false};
+
+  /**
+   * If true, caret requests written together that have the same type and
+   * header fields are merged into batch frames (see CaretBatcher). The
+   * server must understand batches.
+   */
+  bool batchCaretRequests{false};
+
+  /**
+   * If set, big request bodies are compressed, and big reply bodies
+   * uncompressed, on the AuxiliaryCPUThreadPool instead of the event base
+   * thread. Must outlive the connection.
+   */
+  const CompressionOffload* compressionOffload{nullptr};
+
   /**
    * Service identity of the destination service when SSL is used.
    */
@@ -7,9 +7,16 @@
  */
 #include "ConnectionTracker.h"
 
+#include <iterator>
+
 namespace facebook {
 namespace memcache {
 
+namespace {
+// Number of least recently used sessions considered for eviction.
+constexpr size_t kEvictionCandidates = 8;
+} // anonymous
+
 ConnectionTracker::ConnectionTracker(size_t maxConns) : maxConns_(maxConns) {}
 
 McServerSession& ConnectionTracker::add(
@@ -55,6 +62,15 @@ bool ConnectionTracker::writesPending() const {
   return false;
 }
 
+size_t ConnectionTracker::releaseIdleBuffers(
+    std::chrono::steady_clock::time_point idleSince) {
+  size_t released = 0;
+  for (auto& session : sessions_) {
+    released += session.releaseReadBufferIfIdle(idleSince);
+  }
+  return released;
+}
+
 void ConnectionTracker::touch(McServerSession& session) {
   static uint64_t numCalls = 0;
   // Find the connection and bring it to the front of the LRU.
@@ -70,8 +86,18 @@ void ConnectionTracker::evict() {
   if (sessions_.empty()) {
     return;
   }
-  auto& session = sessions_.back();
-  session.close();
+  // The LRU order is approximate (see touch()), so among the few least
+  // recently used sessions close the one holding the most memory: idle
+  // sessions with released buffers cost almost nothing to keep.
+  auto victim = std::prev(sessions_.end());
+  auto it = victim;
+  for (size_t i = 1; i < kEvictionCandidates && it != sessions_.begin(); ++i) {
+    --it;
+    if (it->readBufferCapacity() > victim->readBufferCapacity()) {
+      victim = it;
+    }
+  }
+  victim->close();
 }
 
 void ConnectionTracker::onWriteQuiescence(McServerSession& session) {
@@ -102,5 +128,19 @@ void ConnectionTracker::onShutdown() {
   }
 }
 
+void ConnectionTracker::onReadsDeferred(McServerSession& session) {
+  if (onReadsDeferred_) {
+    onReadsDeferred_(session);
+  }
+}
+
+void ConnectionTracker::onRepliesWritten(
+    McServerSession& session,
+    size_t numReplies) {
+  if (onRepliesWritten_) {
+    onRepliesWritten_(session, numReplies);
+  }
+}
+
 } // memcache
 } // facebook
@@ -7,6 +7,7 @@
  */
 #pragma once
 
+#include <chrono>
 #include <functional>
 #include <memory>
 
@@ -44,6 +45,14 @@ class ConnectionTracker : public McServerSession::StateCallback {
     onShutdown_ = std::move(cb);
   }
 
+  void setOnReadsDeferred(std::function<void(McServerSession&)> cb) {
+    onReadsDeferred_ = std::move(cb);
+  }
+
+  void setOnRepliesWritten(std::function<void(McServerSession&, size_t)> cb) {
+    onRepliesWritten_ = std::move(cb);
+  }
+
   /**
    * Creates a new entry in the LRU and places the connection at the front.
    *
@@ -67,12 +76,22 @@ class ConnectionTracker : public McServerSession::StateCallback {
    */
   bool writesPending() const;
 
+  /**
+   * Frees read buffers of the sessions that didn't read anything since
+   * idleSince.
+   *
+   * @return  number of bytes freed.
+   */
+  size_t releaseIdleBuffers(std::chrono::steady_clock::time_point idleSince);
+
  private:
   McServerSession::Queue sessions_;
   std::function<void(McServerSession&)> onWriteQuiescence_;
   std::function<void(McServerSession&)> onCloseStart_;
   std::function<void(McServerSession&)> onCloseFinish_;
   std::function<void()> onShutdown_;
+  std::function<void(McServerSession&)> onReadsDeferred_;
+  std::function<void(McServerSession&, size_t)> onRepliesWritten_;
   size_t maxConns_{0};
 
   void touch(McServerSession& session);
@@ -84,6 +103,8 @@ class ConnectionTracker : public McServerSession::StateCallback {
   void onCloseStart(McServerSession& session) final;
   void onCloseFinish(McServerSession& session) final;
   void onShutdown() final;
+  void onReadsDeferred(McServerSession& session) final;
+  void onRepliesWritten(McServerSession& session, size_t numReplies) final;
 };
 }
 } // facebook::memcache
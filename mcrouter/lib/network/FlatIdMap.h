@@ -0,0 +1,158 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <folly/lang/Bits.h>
+
+namespace facebook {
+namespace memcache {
+
+/**
+ * Open-addressing map from request id to a non-owning pointer.
+ *
+ * Specialized for ids that are handed out in (mostly) increasing order with a
+ * fixed stride of 2, as AsyncMcClient does: consecutive ids land in
+ * consecutive slots, so as long as the number of live ids stays below the
+ * capacity, a lookup touches a single slot. Collisions (e.g. a very old
+ * request still waiting for a reply) are resolved with linear probing, and
+ * erase uses backward-shift deletion, so there are no tombstones.
+ *
+ * The table grows whenever it becomes half full.
+ */
+template <class T>
+class FlatIdMap {
+ public:
+  explicit FlatIdMap(size_t initialCapacity = kDefaultCapacity)
+      : entries_(folly::nextPowTwo(
+            initialCapacity < kMinCapacity ? kMinCapacity : initialCapacity)),
+        mask_(entries_.size() - 1) {}
+
+  FlatIdMap(const FlatIdMap&) = delete;
+  FlatIdMap& operator=(const FlatIdMap&) = delete;
+
+  size_t size() const {
+    return size_;
+  }
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  size_t capacity() const {
+    return entries_.size();
+  }
+
+  /**
+   * Inserts value with the given id. The id must not be present in the map,
+   * and value must not be nullptr.
+   */
+  void insert(uint64_t id, T* value) {
+    assert(value != nullptr);
+    if ((size_ + 1) * 2 > entries_.size()) {
+      grow();
+    }
+    insertNoGrow(id, value);
+    ++size_;
+  }
+
+  /**
+   * @return  value with the given id, or nullptr if there's no such id.
+   */
+  T* find(uint64_t id) const {
+    for (size_t i = slotFor(id);; i = (i + 1) & mask_) {
+      const auto& entry = entries_[i];
+      if (entry.value == nullptr) {
+        return nullptr;
+      }
+      if (entry.id == id) {
+        return entry.value;
+      }
+    }
+  }
+
+  /**
+   * Removes the given id from the map.
+   *
+   * @return  true if the id was present in the map.
+   */
+  bool erase(uint64_t id) {
+    size_t i = slotFor(id);
+    for (;; i = (i + 1) & mask_) {
+      if (entries_[i].value == nullptr) {
+        return false;
+      }
+      if (entries_[i].id == id) {
+        break;
+      }
+    }
+
+    // Backward-shift deletion: move subsequent entries of the probe sequence
+    // into the hole, unless they're already at (or before) their home slot.
+    for (size_t j = (i + 1) & mask_; entries_[j].value != nullptr;
+         j = (j + 1) & mask_) {
+      const size_t home = slotFor(entries_[j].id);
+      const bool canMove =
+          (i <= j) ? (home <= i || home > j) : (home <= i && home > j);
+      if (canMove) {
+        entries_[i] = entries_[j];
+        i = j;
+      }
+    }
+    entries_[i] = Entry();
+    --size_;
+    return true;
+  }
+
+ private:
+  static constexpr size_t kDefaultCapacity = 128;
+  static constexpr size_t kMinCapacity = 8;
+
+  struct Entry {
+    uint64_t id{0};
+    T* value{nullptr};
+  };
+
+  std::vector<Entry> entries_;
+  size_t mask_;
+  size_t size_{0};
+
+  size_t slotFor(uint64_t id) const {
+    // Ids are increasing with a stride of 2, drop the lowest bit so that
+    // consecutive ids use consecutive slots.
+    return static_cast<size_t>(id >> 1) & mask_;
+  }
+
+  void insertNoGrow(uint64_t id, T* value) {
+    size_t i = slotFor(id);
+    while (entries_[i].value != nullptr) {
+      assert(entries_[i].id != id);
+      i = (i + 1) & mask_;
+    }
+    entries_[i].id = id;
+    entries_[i].value = value;
+  }
+
+  void grow() {
+    std::vector<Entry> old(entries_.size() * 2);
+    old.swap(entries_);
+    mask_ = entries_.size() - 1;
+    for (const auto& entry : old) {
+      if (entry.value != nullptr) {
+        insertNoGrow(entry.id, entry.value);
+      }
+    }
+  }
+};
+
+} // memcache
+} // facebook
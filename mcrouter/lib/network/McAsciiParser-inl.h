@@ -136,6 +136,39 @@ void McClientAsciiParser::initializeReplyParser() {
       typeid(Request).name());
 }
 
+template <>
+void McClientAsciiParser::initializeMetaReplyParser<McGetRequest>();
+
+template <>
+void McClientAsciiParser::initializeMetaReplyParser<McGetsRequest>();
+
+template <>
+void McClientAsciiParser::initializeMetaReplyParser<McSetRequest>();
+
+template <>
+void McClientAsciiParser::initializeMetaReplyParser<McAddRequest>();
+
+template <>
+void McClientAsciiParser::initializeMetaReplyParser<McReplaceRequest>();
+
+template <>
+void McClientAsciiParser::initializeMetaReplyParser<McAppendRequest>();
+
+template <>
+void McClientAsciiParser::initializeMetaReplyParser<McPrependRequest>();
+
+template <>
+void McClientAsciiParser::initializeMetaReplyParser<McCasRequest>();
+
+template <>
+void McClientAsciiParser::initializeMetaReplyParser<McDeleteRequest>();
+
+// Requests without a meta command are sent as classic commands.
+template <class Request>
+void McClientAsciiParser::initializeMetaReplyParser() {
+  initializeReplyParser<Request>();
+}
+
 /**
  * Append piece of IOBuf in range [posStart, posEnd) to destination IOBuf.
  */
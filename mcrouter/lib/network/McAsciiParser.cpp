@@ -7,6 +7,8 @@
  */
 #include "McAsciiParser.h"
 
+#include <cstring>
+
 #include <folly/String.h>
 
 #include "mcrouter/lib/fbi/cpp/LogFailure.h"
@@ -74,26 +76,33 @@ folly::StringPiece McAsciiParserBase::getErrorDescription() const {
 
 bool McAsciiParserBase::readValue(folly::IOBuf& buffer, folly::IOBuf& to) {
   if (remainingIOBufLength_) {
-    // Copy IOBuf for part of (or whole) value.
     size_t offset = p_ - reinterpret_cast<const char*>(buffer.data()) + 1;
     size_t toUse = std::min(buffer.length() - offset, remainingIOBufLength_);
-    buffer.cloneOneInto(to);
-    // Adjust buffer pointers.
-    to.trimStart(offset);
-    to.trimEnd(buffer.length() - offset - toUse);
 
-    remainingIOBufLength_ -= toUse;
-    // Move the state machine to the proper character.
-    p_ += toUse;
+    if (toUse == remainingIOBufLength_) {
+      // Whole value is in the buffer, share it instead of copying.
+      buffer.cloneOneInto(to);
+      to.trimStart(offset);
+      to.trimEnd(buffer.length() - offset - toUse);
+      remainingIOBufLength_ = 0;
+      // Move the state machine to the proper character.
+      p_ += toUse;
+      return true;
+    }
 
-    // Now if we don't have enough data, we need to preallocate second piece
-    // for remaining buffer and signal partial read.
-    if (remainingIOBufLength_) {
-      auto secondPiece = folly::IOBuf::createCombined(remainingIOBufLength_);
-      currentIOBuf_ = secondPiece.get();
-      to.appendChain(std::move(secondPiece));
-      return false;
+    // The value straddles the end of the buffer. Copy the part we already
+    // have into a buffer large enough for the whole value, the rest will be
+    // read directly into it. That way the value remains contiguous.
+    to = folly::IOBuf(folly::IOBuf::CREATE, remainingIOBufLength_);
+    if (toUse > 0) {
+      std::memcpy(to.writableTail(), p_ + 1, toUse);
+      to.append(toUse);
+      valueCopied_ = true;
     }
+    remainingIOBufLength_ -= toUse;
+    p_ += toUse;
+    currentIOBuf_ = &to;
+    return false;
   }
 
   return true;
@@ -60,6 +60,14 @@ class McAsciiParserBase {
    */
   folly::StringPiece getErrorDescription() const;
 
+  /**
+   * @return  true iff the value of the current message was (partially) copied
+   *          out of the read buffer, because it didn't fit into it.
+   */
+  bool valueCopied() const noexcept {
+    return valueCopied_;
+  }
+
  protected:
   void handleError(folly::IOBuf& buffer);
   /**
@@ -90,6 +98,7 @@ class McAsciiParserBase {
   size_t remainingIOBufLength_{0};
   State state_{State::UNINIT};
   bool negative_{false};
+  bool valueCopied_{false};
 
   // Variables used by ragel.
   int savedCs_;
@@ -116,6 +125,14 @@ class McClientAsciiParser : public McAsciiParserBase {
   template <class Request>
   void initializeReplyParser();
 
+  /**
+   * Same as initializeReplyParser(), for requests serialized with
+   * AsciiSerializedRequest::prepareMeta(): parses meta command replies for
+   * requests that have a meta command, classic replies otherwise.
+   */
+  template <class Request>
+  void initializeMetaReplyParser();
+
   /**
    * Obtain the message that was parsed.
    *
@@ -141,9 +158,27 @@ class McClientAsciiParser : public McAsciiParserBase {
   template <class Reply>
   void consumeStorageReplyCommon(folly::IOBuf& buffer);
 
+  template <class Reply>
+  void initializeMetaStorageReplyCommon();
+  template <class Reply>
+  void consumeMetaStorageReplyCommon(folly::IOBuf& buffer);
+  template <class Request>
+  void consumeMetaMessage(folly::IOBuf& buffer);
+
   template <class Request>
   void consumeMessage(folly::IOBuf& buffer);
 
+  /**
+   * Fast path for the most common get-like replies ("VALUE ..." with the whole
+   * value in buffer, or "END"). Only handles well-formed replies at the very
+   * beginning of a message.
+   *
+   * @return  true iff the reply was completely parsed, false if the regular
+   *          state machine should be used instead (nothing is consumed).
+   */
+  template <class Reply>
+  bool consumeGetLikeFast(folly::IOBuf& buffer, Reply& message);
+
   template <class Reply>
   void consumeErrorMessage(const folly::IOBuf& buffer);
 
@@ -197,6 +232,26 @@ class McServerAsciiParser : public McAsciiParserBase {
  private:
   void opTypeConsumer(folly::IOBuf& buffer);
 
+  /**
+   * Fast path for the most common requests: "get <key> [<key> ...]\r\n" and
+   * "set <key> <flags> <exptime> <bytes> [noreply]\r\n<value>\r\n", with
+   * single spaces and the whole request in buffer. Only handles requests at
+   * the very beginning of a message.
+   *
+   * @return  true iff the request was completely parsed and passed to the
+   *          callback, false if the regular state machine should be used
+   *          instead (nothing is consumed).
+   */
+  bool consumeRequestFast(folly::IOBuf& buffer);
+  bool consumeGetFast(
+      folly::IOBuf& buffer,
+      const char* keysStart,
+      const char* lineEnd);
+  bool consumeSetFast(
+      folly::IOBuf& buffer,
+      const char* keyStart,
+      const char* lineEnd);
+
   // Get-like.
   template <class Request>
   void initGetLike();
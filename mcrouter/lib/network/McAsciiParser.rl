@@ -7,6 +7,12 @@
  */
 #include "mcrouter/lib/network/McAsciiParser.h"
 
+#include <cstring>
+#include <type_traits>
+
+#include <folly/Range.h>
+
+#include "mcrouter/lib/IOBufUtil.h"
 #include "mcrouter/lib/mc/msg.h"
 #include "mcrouter/lib/McOperation.h"
 #include "mcrouter/lib/network/gen/Memcache.h"
@@ -195,8 +201,144 @@ client_error = 'CLIENT_ERROR' (' ' error_code ' ')? ' '? error_message
                %{ message.result() = mc_res_client_error; };
 
 error = command_error | server_error | client_error;
+
+# Meta command replies (mg, ms, md).
+# Return flags that were not asked for, or are not used (e.g. O, k).
+meta_skip_flag = alpha (any -- (cntrl | space))*;
+meta_flags = (' '+ meta_skip_flag)* ' '*;
+meta_miss = 'EN' @{ message.result() = mc_res_notfound; };
+meta_not_found = 'NF' @{ message.result() = mc_res_notfound; };
+VA = 'VA' % { message.result() = mc_res_found; };
 }%%
 
+namespace {
+
+/**
+ * Parses unsigned integer starting at p and terminated by delim.
+ * @return  pointer past the delimiter, nullptr if input is not a well-formed
+ *          number followed by delim.
+ */
+inline const char* parseUIntFast(
+    const char* p,
+    const char* end,
+    char delim,
+    uint64_t& out) {
+  // 19 digits always fit into uint64_t.
+  constexpr ptrdiff_t kMaxDigits = 19;
+  const char* start = p;
+  uint64_t value = 0;
+  while (p != end && static_cast<unsigned char>(*p - '0') < 10) {
+    value = value * 10 + (*p - '0');
+    ++p;
+  }
+  if (p == start || p == end || *p != delim || p - start > kMaxDigits) {
+    return nullptr;
+  }
+  out = value;
+  return p + 1;
+}
+
+/**
+ * @return  pointer to the first space or control character at or after p,
+ *          end if there is none.
+ */
+inline const char* findKeyEndFast(const char* p, const char* end) {
+  while (p != end && static_cast<unsigned char>(*p) > ' ' && *p != 0x7f) {
+    ++p;
+  }
+  return p;
+}
+
+/**
+ * Skips the key starting at p, which must be followed by a single space.
+ * @return  pointer past the space, nullptr if the key is malformed.
+ */
+inline const char* skipKeyFast(const char* p, const char* end) {
+  const char* start = p;
+  p = findKeyEndFast(p, end);
+  if (p == start || p == end || *p != ' ') {
+    return nullptr;
+  }
+  return p + 1;
+}
+
+inline void setCasTokenFast(McGetReply&, uint64_t) {}
+inline void setCasTokenFast(McGetsReply& message, uint64_t cas) {
+  message.casToken() = cas;
+}
+
+} // anonymous
+
+template <class Reply>
+bool McClientAsciiParser::consumeGetLikeFast(
+    folly::IOBuf& buffer,
+    Reply& message) {
+  constexpr bool kHasCas = std::is_same<Reply, McGetsReply>::value;
+  constexpr folly::StringPiece kEnd = "END\r\n";
+  constexpr folly::StringPiece kValue = "VALUE ";
+  constexpr folly::StringPiece kValueTrailer = "\r\nEND\r\n";
+
+  const folly::StringPiece data(p_, pe_);
+  if (data.startsWith(kEnd)) {
+    message.result() = mc_res_notfound;
+    p_ += kEnd.size();
+    state_ = State::COMPLETE;
+    return true;
+  }
+  if (!data.startsWith(kValue)) {
+    return false;
+  }
+
+  // memchr is vectorized by libc, so this is the only full scan of the header.
+  auto lineEnd = static_cast<const char*>(
+      memchr(p_ + kValue.size(), '\n', data.size() - kValue.size()));
+  if (lineEnd == nullptr || *(lineEnd - 1) != '\r') {
+    return false;
+  }
+  const char* p = skipKeyFast(p_ + kValue.size(), lineEnd);
+  uint64_t flags = 0;
+  uint64_t valueLength = 0;
+  uint64_t cas = 0;
+  if (p == nullptr || (p = parseUIntFast(p, lineEnd, ' ', flags)) == nullptr) {
+    return false;
+  }
+  if (kHasCas) {
+    p = parseUIntFast(p, lineEnd, ' ', valueLength);
+    if (p != nullptr) {
+      p = parseUIntFast(p, lineEnd, '\r', cas);
+    }
+  } else {
+    p = parseUIntFast(p, lineEnd, '\r', valueLength);
+  }
+  if (p != lineEnd) {
+    return false;
+  }
+
+  // The whole value and the trailer have to be in the buffer, partial values
+  // are handled by the state machine.
+  const char* valueStart = lineEnd + 1;
+  const size_t available = pe_ - valueStart;
+  if (valueLength > available ||
+      available - valueLength < kValueTrailer.size() ||
+      folly::StringPiece(valueStart + valueLength, kValueTrailer.size()) !=
+          kValueTrailer) {
+    return false;
+  }
+
+  message.result() = mc_res_found;
+  message.flags() = flags;
+  setCasTokenFast(message, cas);
+  message.value().emplace();
+  cloneInto(
+      *message.value(),
+      buffer,
+      reinterpret_cast<const uint8_t*>(valueStart),
+      valueLength);
+  p_ = valueStart + valueLength + kValueTrailer.size();
+  state_ = State::COMPLETE;
+  return true;
+}
+
 // McGet reply.
 %%{
 machine mc_ascii_get_reply;
@@ -210,6 +352,10 @@ write data;
 template <>
 void McClientAsciiParser::consumeMessage<McGetRequest>(folly::IOBuf& buffer) {
   auto& message = currentMessage_.get<McGetReply>();
+  if (savedCs_ == mc_ascii_get_reply_en_get_reply &&
+      consumeGetLikeFast(buffer, message)) {
+    return;
+  }
   %%{
     machine mc_ascii_get_reply;
     write init nocs;
@@ -230,6 +376,10 @@ write data;
 template <>
 void McClientAsciiParser::consumeMessage<McGetsRequest>(folly::IOBuf& buffer) {
   auto& message = currentMessage_.get<McGetsReply>();
+  if (savedCs_ == mc_ascii_gets_reply_en_gets_reply &&
+      consumeGetLikeFast(buffer, message)) {
+    return;
+  }
   %%{
     machine mc_ascii_gets_reply;
     write init nocs;
@@ -450,6 +600,108 @@ void McClientAsciiParser::consumeMessage<McFlushAllRequest>(
   }%%
 }
 
+// Meta get reply.
+%%{
+machine mc_ascii_meta_get_reply;
+include mc_ascii_common;
+
+meta_get_flag = 'f' flags | (alpha - 'f') (any -- (cntrl | space))*;
+meta_get_hit = VA ' '+ value_bytes (' '+ meta_get_flag)* ' '* new_line
+               @reply_value_data new_line;
+meta_get = meta_get_hit | meta_miss;
+meta_get_reply := (meta_get | error) msg_end;
+
+write data;
+}%%
+
+template <>
+void McClientAsciiParser::consumeMetaMessage<McGetRequest>(
+    folly::IOBuf& buffer) {
+  auto& message = currentMessage_.get<McGetReply>();
+  %%{
+    machine mc_ascii_meta_get_reply;
+    write init nocs;
+    write exec;
+  }%%
+}
+
+// Meta gets reply.
+%%{
+machine mc_ascii_meta_gets_reply;
+include mc_ascii_common;
+
+meta_gets_flag = 'f' flags | 'c' cas_id |
+                 (alpha - [fc]) (any -- (cntrl | space))*;
+meta_gets_hit = VA ' '+ value_bytes (' '+ meta_gets_flag)* ' '* new_line
+                @reply_value_data new_line;
+meta_gets = meta_gets_hit | meta_miss;
+meta_gets_reply := (meta_gets | error) msg_end;
+
+write data;
+}%%
+
+template <>
+void McClientAsciiParser::consumeMetaMessage<McGetsRequest>(
+    folly::IOBuf& buffer) {
+  auto& message = currentMessage_.get<McGetsReply>();
+  %%{
+    machine mc_ascii_meta_gets_reply;
+    write init nocs;
+    write exec;
+  }%%
+}
+
+// Meta storage reply.
+%%{
+machine mc_ascii_meta_storage_reply;
+include mc_ascii_common;
+
+meta_stored = 'HD' @{ message.result() = mc_res_stored; };
+meta_not_stored = 'NS' @{ message.result() = mc_res_notstored; };
+meta_exists = 'EX' @{ message.result() = mc_res_exists; };
+
+meta_storage = (meta_stored | meta_not_stored | meta_exists | meta_not_found)
+               meta_flags;
+meta_storage_reply := (meta_storage | error) msg_end;
+
+write data;
+}%%
+
+template <class Reply>
+void McClientAsciiParser::consumeMetaStorageReplyCommon(folly::IOBuf& buffer) {
+  auto& message = currentMessage_.get<Reply>();
+  %%{
+    machine mc_ascii_meta_storage_reply;
+    write init nocs;
+    write exec;
+  }%%
+}
+
+// Meta delete reply. Deletes with a delay are sent as classic commands.
+%%{
+machine mc_ascii_meta_delete_reply;
+include mc_ascii_common;
+
+meta_deleted = 'HD' @{ message.result() = mc_res_deleted; };
+
+meta_delete = ((meta_deleted | meta_not_found) meta_flags) | deleted |
+              not_found;
+meta_delete_reply := (meta_delete | error) msg_end;
+
+write data;
+}%%
+
+template <>
+void McClientAsciiParser::consumeMetaMessage<McDeleteRequest>(
+    folly::IOBuf& buffer) {
+  auto& message = currentMessage_.get<McDeleteReply>();
+  %%{
+    machine mc_ascii_meta_delete_reply;
+    write init nocs;
+    write exec;
+  }%%
+}
+
 template <>
 void McClientAsciiParser::initializeReplyParser<McGetRequest>() {
   initializeCommon<McGetReply>();
@@ -576,6 +828,68 @@ void McClientAsciiParser::initializeStorageReplyCommon() {
   consumer_ = &McClientAsciiParser::consumeStorageReplyCommon<Reply>;
 }
 
+template <class Reply>
+void McClientAsciiParser::initializeMetaStorageReplyCommon() {
+  initializeCommon<Reply>();
+  savedCs_ = mc_ascii_meta_storage_reply_en_meta_storage_reply;
+  errorCs_ = mc_ascii_meta_storage_reply_error;
+  consumer_ = &McClientAsciiParser::consumeMetaStorageReplyCommon<Reply>;
+}
+
+template <>
+void McClientAsciiParser::initializeMetaReplyParser<McGetRequest>() {
+  initializeCommon<McGetReply>();
+  savedCs_ = mc_ascii_meta_get_reply_en_meta_get_reply;
+  errorCs_ = mc_ascii_meta_get_reply_error;
+  consumer_ = &McClientAsciiParser::consumeMetaMessage<McGetRequest>;
+}
+
+template <>
+void McClientAsciiParser::initializeMetaReplyParser<McGetsRequest>() {
+  initializeCommon<McGetsReply>();
+  savedCs_ = mc_ascii_meta_gets_reply_en_meta_gets_reply;
+  errorCs_ = mc_ascii_meta_gets_reply_error;
+  consumer_ = &McClientAsciiParser::consumeMetaMessage<McGetsRequest>;
+}
+
+template <>
+void McClientAsciiParser::initializeMetaReplyParser<McSetRequest>() {
+  initializeMetaStorageReplyCommon<McSetReply>();
+}
+
+template <>
+void McClientAsciiParser::initializeMetaReplyParser<McAddRequest>() {
+  initializeMetaStorageReplyCommon<McAddReply>();
+}
+
+template <>
+void McClientAsciiParser::initializeMetaReplyParser<McReplaceRequest>() {
+  initializeMetaStorageReplyCommon<McReplaceReply>();
+}
+
+template <>
+void McClientAsciiParser::initializeMetaReplyParser<McAppendRequest>() {
+  initializeMetaStorageReplyCommon<McAppendReply>();
+}
+
+template <>
+void McClientAsciiParser::initializeMetaReplyParser<McPrependRequest>() {
+  initializeMetaStorageReplyCommon<McPrependReply>();
+}
+
+template <>
+void McClientAsciiParser::initializeMetaReplyParser<McCasRequest>() {
+  initializeMetaStorageReplyCommon<McCasReply>();
+}
+
+template <>
+void McClientAsciiParser::initializeMetaReplyParser<McDeleteRequest>() {
+  initializeCommon<McDeleteReply>();
+  savedCs_ = mc_ascii_meta_delete_reply_en_meta_delete_reply;
+  errorCs_ = mc_ascii_meta_delete_reply_error;
+  consumer_ = &McClientAsciiParser::consumeMetaMessage<McDeleteRequest>;
+}
+
 template <class Reply>
 void McClientAsciiParser::initializeCommon() {
   assert(state_ == State::UNINIT);
@@ -583,6 +897,7 @@ void McClientAsciiParser::initializeCommon() {
   currentUInt_ = 0;
   currentIOBuf_ = nullptr;
   remainingIOBufLength_ = 0;
+  valueCopied_ = false;
   state_ = State::PARTIAL;
 
   currentMessage_.emplace<Reply>();
@@ -1097,6 +1412,138 @@ void McServerAsciiParser::opTypeConsumer(folly::IOBuf&) {
   }%%
 }
 
+bool McServerAsciiParser::consumeRequestFast(folly::IOBuf& buffer) {
+  constexpr folly::StringPiece kGet = "get ";
+  constexpr folly::StringPiece kSet = "set ";
+  static_assert(kGet.size() == kSet.size(), "");
+
+  const folly::StringPiece data(p_, pe_);
+  const bool isGet = data.startsWith(kGet);
+  if (!isGet && !data.startsWith(kSet)) {
+    return false;
+  }
+
+  // memchr is vectorized by libc, so this is the only full scan of the line.
+  auto lineEnd = static_cast<const char*>(
+      memchr(p_ + kGet.size(), '\n', data.size() - kGet.size()));
+  if (lineEnd == nullptr || *(lineEnd - 1) != '\r') {
+    return false;
+  }
+  return isGet ? consumeGetFast(buffer, p_ + kGet.size(), lineEnd)
+               : consumeSetFast(buffer, p_ + kSet.size(), lineEnd);
+}
+
+bool McServerAsciiParser::consumeGetFast(
+    folly::IOBuf& buffer,
+    const char* keysStart,
+    const char* lineEnd) {
+  const char* keysEnd = lineEnd - 1;
+  // Check all the keys first: the state machine has to see the whole request
+  // if any of them is malformed, and keys mustn't be passed to the callback
+  // twice.
+  for (const char* p = keysStart;; ++p) {
+    const char* keyEnd = findKeyEndFast(p, keysEnd);
+    if (keyEnd == p) {
+      return false;
+    }
+    if (keyEnd == keysEnd) {
+      break;
+    }
+    if (*keyEnd != ' ') {
+      return false;
+    }
+    p = keyEnd;
+  }
+
+  p_ = lineEnd + 1;
+  for (const char* p = keysStart; p < keysEnd;) {
+    auto keyEnd = static_cast<const char*>(memchr(p, ' ', keysEnd - p));
+    if (keyEnd == nullptr) {
+      keyEnd = keysEnd;
+    }
+    McGetRequest req;
+    folly::IOBuf key;
+    cloneInto(key, buffer, reinterpret_cast<const uint8_t*>(p), keyEnd - p);
+    req.key() = std::move(key);
+    callback_->onRequest(std::move(req));
+    p = keyEnd + 1;
+  }
+  callback_->multiOpEnd();
+  return true;
+}
+
+bool McServerAsciiParser::consumeSetFast(
+    folly::IOBuf& buffer,
+    const char* keyStart,
+    const char* lineEnd) {
+  constexpr folly::StringPiece kNoreply = "noreply\r";
+  constexpr folly::StringPiece kValueTrailer = "\r\n";
+
+  const char* keyEnd = findKeyEndFast(keyStart, lineEnd);
+  if (keyEnd == keyStart || *keyEnd != ' ') {
+    return false;
+  }
+  uint64_t flags = 0;
+  uint64_t exptime = 0;
+  uint64_t valueLength = 0;
+  const char* p = parseUIntFast(keyEnd + 1, lineEnd, ' ', flags);
+  if (p == nullptr) {
+    return false;
+  }
+  const bool negative = *p == '-';
+  if (negative) {
+    ++p;
+  }
+  if ((p = parseUIntFast(p, lineEnd, ' ', exptime)) == nullptr) {
+    return false;
+  }
+  bool noreply = false;
+  const char* valueLengthStart = p;
+  p = parseUIntFast(valueLengthStart, lineEnd, '\r', valueLength);
+  if (p == nullptr) {
+    p = parseUIntFast(valueLengthStart, lineEnd, ' ', valueLength);
+    if (p == nullptr || folly::StringPiece(p, lineEnd) != kNoreply) {
+      return false;
+    }
+    noreply = true;
+  } else if (p != lineEnd) {
+    return false;
+  }
+
+  // The whole value and the trailer have to be in the buffer, partial values
+  // are handled by the state machine.
+  const char* valueStart = lineEnd + 1;
+  const size_t available = pe_ - valueStart;
+  if (valueLength > available ||
+      available - valueLength < kValueTrailer.size() ||
+      folly::StringPiece(valueStart + valueLength, kValueTrailer.size()) !=
+          kValueTrailer) {
+    return false;
+  }
+
+  McSetRequest req;
+  folly::IOBuf key;
+  cloneInto(
+      key,
+      buffer,
+      reinterpret_cast<const uint8_t*>(keyStart),
+      keyEnd - keyStart);
+  req.key() = std::move(key);
+  req.flags() = flags;
+  const auto exptimeValue = static_cast<int32_t>(exptime);
+  req.exptime() = negative ? -exptimeValue : exptimeValue;
+  if (valueLength > 0) {
+    cloneInto(
+        req.value(),
+        buffer,
+        reinterpret_cast<const uint8_t*>(valueStart),
+        valueLength);
+  }
+  p_ = valueStart + valueLength + kValueTrailer.size();
+  callback_->onRequest(std::move(req), noreply);
+  return true;
+}
+
 void McServerAsciiParser::finishReq() {
   state_ = State::UNINIT;
 }
@@ -1111,6 +1558,11 @@ McAsciiParserBase::State McServerAsciiParser::consume(folly::IOBuf& buffer) {
   while (p_ != pe_) {
     // Initialize operation parser.
     if (state_ == State::UNINIT) {
+      if (consumeRequestFast(buffer)) {
+        buffer.trimStart(p_ - reinterpret_cast<const char*>(buffer.data()));
+        continue;
+      }
+
       savedCs_ = mc_ascii_req_type_en_command;
       errorCs_ = mc_ascii_req_type_error;
 
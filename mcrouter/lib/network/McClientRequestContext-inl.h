@@ -6,6 +6,7 @@
  *
  */
 #include "mcrouter/lib/Reply.h"
+#include "mcrouter/lib/carbon/RequestReplyUtil.h"
 #include "mcrouter/lib/fbi/cpp/LogFailure.h"
 
 namespace facebook {
@@ -46,9 +47,21 @@ McClientRequestContextBase::McClientRequestContextBase(
     McClientRequestContextQueue& queue,
     InitializerFuncPtr initializer,
     const std::function<void(int pendingDiff, int inflightDiff)>& onStateChange,
-    const CodecIdRange& supportedCodecs)
-    : reqContext(request, reqid, protocol, supportedCodecs),
+    const CodecIdRange& supportedCodecs,
+    std::chrono::milliseconds timeout,
+    const CompressionCodecMap* compressionCodecMap,
+    const CompressionOffload* compressionOffload)
+    : reqContext(
+          request,
+          reqid,
+          protocol,
+          supportedCodecs,
+          timeout,
+          compressionCodecMap,
+          compressionOffload),
       id(reqid),
+      valueBuf(carbon::valuePtrUnsafe(request)),
+      key(request.key().fullKey()),
       queue_(queue),
       replyType_(typeid(ReplyT<Request>)),
       replyStorage_(reinterpret_cast<void*>(&replyStorage)),
@@ -127,7 +140,10 @@ McClientRequestContext<Request>::McClientRequestContext(
     McClientRequestContextQueue& queue,
     McClientRequestContextBase::InitializerFuncPtr func,
     const std::function<void(int pendingDiff, int inflightDiff)>& onStateChange,
-    const CodecIdRange& supportedCodecs)
+    const CodecIdRange& supportedCodecs,
+    std::chrono::milliseconds timeout,
+    const CompressionCodecMap* compressionCodecMap,
+    const CompressionOffload* compressionOffload)
     : McClientRequestContextBase(
           request,
           reqid,
@@ -136,7 +152,10 @@ McClientRequestContext<Request>::McClientRequestContext(
           queue,
           std::move(func),
           onStateChange,
-          supportedCodecs)
+          supportedCodecs,
+          timeout,
+          compressionCodecMap,
+          compressionOffload)
 #ifndef LIBMC_FBTRACE_DISABLE
       ,
       fbtraceInfo_(getFbTraceInfo(request))
@@ -159,21 +178,20 @@ void McClientRequestContextQueue::reply(
   // Get the context and erase it from the queue and map.
   McClientRequestContextBase* ctx{nullptr};
   if (outOfOrder_) {
-    auto iter = getContextById(id);
-    if (iter != set_.end()) {
-      ctx = &(*iter);
-      if (iter->state() == State::PENDING_REPLY_QUEUE) {
-        pendingReplyQueue_.erase(pendingReplyQueue_.iterator_to(*iter));
-        set_.erase(iter);
-      } else if (iter->state() == State::WRITE_QUEUE) {
+    ctx = getContextById(id);
+    if (ctx) {
+      if (ctx->state() == State::PENDING_REPLY_QUEUE) {
+        pendingReplyQueue_.erase(pendingReplyQueue_.iterator_to(*ctx));
+        idMap_.erase(id);
+      } else if (ctx->state() == State::WRITE_QUEUE) {
         // We didn't get write callback yet, so need to properly handle that.
-        set_.erase(iter);
+        idMap_.erase(id);
       } else {
         LOG_FAILURE(
             "AsyncMcClient",
             failure::Category::kOther,
             "Received reply for a request in an unexpected state {}!",
-            static_cast<uint64_t>(iter->state()));
+            static_cast<uint64_t>(ctx->state()));
         return;
       }
 
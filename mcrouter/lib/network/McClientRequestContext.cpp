@@ -80,21 +80,7 @@ McClientRequestContextBase::~McClientRequestContextBase() {
 
 McClientRequestContextQueue::McClientRequestContextQueue(
     bool outOfOrder) noexcept
-    : outOfOrder_(outOfOrder),
-      buckets_(kDefaultNumBuckets),
-      set_(McClientRequestContextBase::UnorderedSet::bucket_traits(
-          buckets_.data(),
-          buckets_.size())) {}
-
-void McClientRequestContextQueue::growBucketsArray() {
-  // Allocate buckets array that is twice bigger than the current one.
-  std::vector<McClientRequestContextBase::UnorderedSet::bucket_type> tmp(
-      buckets_.size() * 2);
-  set_.rehash(McClientRequestContextBase::UnorderedSet::bucket_traits(
-      tmp.data(), tmp.size()));
-  // Use swap here, since it has better defined behaviour regarding iterators.
-  buckets_.swap(tmp);
-}
+    : outOfOrder_(outOfOrder) {}
 
 size_t McClientRequestContextQueue::getPendingRequestCount() const noexcept {
   return pendingQueue_.size();
@@ -117,6 +103,7 @@ void McClientRequestContextQueue::failAllPending(
   assert(pendingReplyQueue_.empty());
   assert(writeQueue_.empty());
   assert(repliedQueue_.empty());
+  firstLowPriorityPending_ = nullptr;
   failQueue(pendingQueue_, error, errorMessage);
 }
 
@@ -135,14 +122,21 @@ void McClientRequestContextQueue::markAsPending(
     McClientRequestContextBase& req) {
   assert(req.state() == State::NONE);
   req.setState(State::PENDING_QUEUE);
-  pendingQueue_.push_back(req);
+  if (req.lowPriority) {
+    pendingQueue_.push_back(req);
+    if (!firstLowPriorityPending_) {
+      firstLowPriorityPending_ = &req;
+    }
+  } else if (firstLowPriorityPending_) {
+    // Jumps ahead of low priority requests.
+    pendingQueue_.insert(
+        pendingQueue_.iterator_to(*firstLowPriorityPending_), req);
+  } else {
+    pendingQueue_.push_back(req);
+  }
 
   if (outOfOrder_) {
-    // We hit the number of allocated buckets, grow the array.
-    if (set_.size() >= buckets_.size()) {
-      growBucketsArray();
-    }
-    set_.insert(req);
+    idMap_.insert(req.id, &req);
   }
 }
 
@@ -152,7 +146,7 @@ McClientRequestContextBase& McClientRequestContextQueue::peekNextPending() {
 
 McClientRequestContextBase& McClientRequestContextQueue::markNextAsSending() {
   auto& req = pendingQueue_.front();
-  pendingQueue_.pop_front();
+  unlinkPending(req);
   assert(req.state() == State::PENDING_QUEUE);
   req.setState(State::WRITE_QUEUE);
   writeQueue_.push_back(req);
@@ -200,20 +194,15 @@ void McClientRequestContextQueue::failQueue(
   }
 }
 
-McClientRequestContextBase::UnorderedSet::iterator
-McClientRequestContextQueue::getContextById(uint64_t id) {
-  return set_.find(
-      id,
-      std::hash<uint64_t>(),
-      [](uint64_t i, const McClientRequestContextBase& ctx) {
-        return i == ctx.id;
-      });
+McClientRequestContextBase* McClientRequestContextQueue::getContextById(
+    uint64_t id) const {
+  return idMap_.find(id);
 }
 
 void McClientRequestContextQueue::removeFromSet(
     McClientRequestContextBase& req) {
   if (outOfOrder_) {
-    set_.erase(req);
+    idMap_.erase(req.id);
   }
 }
 
@@ -221,10 +210,19 @@ void McClientRequestContextQueue::removePending(
     McClientRequestContextBase& req) {
   assert(req.state() == State::PENDING_QUEUE);
   removeFromSet(req);
-  pendingQueue_.erase(pendingQueue_.iterator_to(req));
+  unlinkPending(req);
   req.setState(State::NONE);
 }
 
+void McClientRequestContextQueue::unlinkPending(
+    McClientRequestContextBase& req) {
+  auto next = pendingQueue_.erase(pendingQueue_.iterator_to(req));
+  if (&req == firstLowPriorityPending_) {
+    // Everything after the first low priority request is low priority too.
+    firstLowPriorityPending_ = next == pendingQueue_.end() ? nullptr : &*next;
+  }
+}
+
 void McClientRequestContextQueue::removePendingReply(
     McClientRequestContextBase& req) {
   assert(req.state() == State::PENDING_REPLY_QUEUE);
@@ -241,9 +239,8 @@ void McClientRequestContextQueue::removePendingReply(
 McClientRequestContextBase::InitializerFuncPtr
 McClientRequestContextQueue::getParserInitializer(uint64_t reqId) {
   if (outOfOrder_) {
-    auto it = getContextById(reqId);
-    if (it != set_.end()) {
-      return it->initializer_;
+    if (auto ctx = getContextById(reqId)) {
+      return ctx->initializer_;
     }
   } else {
     // In inorder protocol we expect to receive timedout requests first.
@@ -10,14 +10,13 @@
 #include <chrono>
 #include <typeindex>
 
-#include <boost/intrusive/unordered_set.hpp>
-
 #include <folly/IntrusiveList.h>
 #include <folly/fibers/Baton.h>
 
 #include "mcrouter/lib/McOperation.h"
 #include "mcrouter/lib/network/ClientMcParser.h"
 #include "mcrouter/lib/network/FBTrace.h"
+#include "mcrouter/lib/network/FlatIdMap.h"
 #include "mcrouter/lib/network/McSerializedRequest.h"
 #include "mcrouter/lib/network/ReplyStatsContext.h"
 
@@ -26,20 +25,36 @@ namespace memcache {
 
 class AsyncMcClientImpl;
 struct CodecIdRange;
+class CompressionCodecMap;
+class CompressionOffload;
 class McClientRequestContextQueue;
 
 /**
  * Class for storing per request data that is required for proper requests
  * processing inside of AsyncMcClient.
  */
-class McClientRequestContextBase
-    : public boost::intrusive::unordered_set_base_hook<> {
+class McClientRequestContextBase {
  public:
   using InitializerFuncPtr = void (*)(ClientMcParser<AsyncMcClientImpl>&);
 
   McSerializedRequest reqContext;
   uint64_t id;
   bool isBatchTail{false};
+  /**
+   * Low priority requests are only sent once no other request waits to be
+   * sent.
+   */
+  bool lowPriority{false};
+  /**
+   * Value of the request (if any). Used to avoid copying it on zero-copy
+   * sends. Valid while the request is being processed.
+   */
+  const folly::IOBuf* valueBuf{nullptr};
+  /**
+   * Full key of the request, used to filter debug fifo traffic. Same
+   * lifetime as valueBuf.
+   */
+  folly::StringPiece key;
 
   McClientRequestContextBase(const McClientRequestContextBase&) = delete;
   McClientRequestContextBase& operator=(
@@ -98,7 +113,10 @@ class McClientRequestContextBase
       InitializerFuncPtr initializer,
       const std::function<void(int pendingDiff, int inflightDiff)>&
           onStateChange,
-      const CodecIdRange& supportedCodecs);
+      const CodecIdRange& supportedCodecs,
+      std::chrono::milliseconds timeout,
+      const CompressionCodecMap* compressionCodecMap,
+      const CompressionOffload* compressionOffload);
 
   virtual void sendTraceOnReply() = 0;
 
@@ -156,27 +174,10 @@ class McClientRequestContextBase
   void reply(Reply&& r);
 
  public:
-  struct Equal {
-    bool operator()(
-        const McClientRequestContextBase& a,
-        const McClientRequestContextBase& b) const {
-      return a.id == b.id;
-    }
-  };
-
-  struct Hash {
-    size_t operator()(const McClientRequestContextBase& ctx) const {
-      return std::hash<uint64_t>()(ctx.id);
-    }
-  };
-
   using Queue = folly::CountedIntrusiveList<
       McClientRequestContextBase,
       &McClientRequestContextBase::hook_>;
-  using UnorderedSet = boost::intrusive::unordered_set<
-      McClientRequestContextBase,
-      boost::intrusive::equal<Equal>,
-      boost::intrusive::hash<Hash>>;
+  using IdMap = FlatIdMap<McClientRequestContextBase>;
 };
 
 template <class Request>
@@ -192,7 +193,10 @@ class McClientRequestContext : public McClientRequestContextBase {
       McClientRequestContextBase::InitializerFuncPtr,
       const std::function<void(int pendingDiff, int inflightDiff)>&
           onStateChange,
-      const CodecIdRange& supportedCodecs);
+      const CodecIdRange& supportedCodecs,
+      std::chrono::milliseconds timeout,
+      const CompressionCodecMap* compressionCodecMap,
+      const CompressionOffload* compressionOffload);
 
   std::string getContextTypeStr() const final;
 
@@ -300,8 +304,6 @@ class McClientRequestContextQueue {
   std::string debugInfo() const;
 
  private:
-  static constexpr size_t kDefaultNumBuckets = 128;
-
   // Friend to allow access to remove* mothods.
   template <class Request>
   friend class McClientRequestContext;
@@ -309,8 +311,10 @@ class McClientRequestContextQueue {
   using State = McClientRequestContextBase::ReqState;
 
   bool outOfOrder_{false};
-  // Queue of requests, that are queued to be sent.
+  // Queue of requests, that are queued to be sent. Low priority requests
+  // are at the end, starting with firstLowPriorityPending_ (if any).
   McClientRequestContextBase::Queue pendingQueue_;
+  McClientRequestContextBase* firstLowPriorityPending_{nullptr};
   // Queue of requests, that are currently being written to the socket.
   McClientRequestContextBase::Queue writeQueue_;
   // Queue of requests, that are already sent and are waiting for replies.
@@ -318,10 +322,9 @@ class McClientRequestContextQueue {
   // A special internal queue for request that were replied before it's been
   // completely written.
   McClientRequestContextBase::Queue repliedQueue_;
-  // Unordered set of requests. Used only in case of out-of-order protocol
+  // Map of requests by id. Used only in case of out-of-order protocol
   // for fast request lookup.
-  std::vector<McClientRequestContextBase::UnorderedSet::bucket_type> buckets_;
-  McClientRequestContextBase::UnorderedSet set_;
+  McClientRequestContextBase::IdMap idMap_;
 
   // Storage for parser initializers for timed out requests.
   std::queue<McClientRequestContextBase::InitializerFuncPtr>
@@ -332,8 +335,7 @@ class McClientRequestContextQueue {
       mc_res_t error,
       folly::StringPiece errorMessage);
 
-  McClientRequestContextBase::UnorderedSet::iterator getContextById(
-      uint64_t id);
+  McClientRequestContextBase* getContextById(uint64_t id) const;
   void removeFromSet(McClientRequestContextBase& req);
 
   /**
@@ -341,6 +343,11 @@ class McClientRequestContextQueue {
    */
   void removePending(McClientRequestContextBase& req);
 
+  /**
+   * Unlinks req from pendingQueue_, keeping firstLowPriorityPending_ valid.
+   */
+  void unlinkPending(McClientRequestContextBase& req);
+
   /**
    * Removes given request from pending reply queue and from id map.
    *
@@ -354,8 +361,6 @@ class McClientRequestContextQueue {
    */
   void clearStoredInitializers();
 
-  void growBucketsArray();
-
   std::string getFirstAliveRequestInfo() const;
 };
 }
@@ -8,24 +8,35 @@
 #include "McParser.h"
 
 #include <algorithm>
+#include <cstring>
 #include <new>
 #include <utility>
 
 #include <folly/Format.h>
 #include <folly/ThreadLocal.h>
+#include <folly/Varint.h>
 #include <folly/experimental/JemallocNodumpAllocator.h>
 #include <folly/io/Cursor.h>
 #include <folly/lang/Bits.h>
 
-#include "mcrouter/lib/Clocks.h"
 #include "mcrouter/lib/network/UmbrellaProtocol.h"
 
 namespace facebook {
 namespace memcache {
 
 namespace {
-// Adjust buffer size after this many CPU cycles (~2 billion)
-constexpr uint64_t kAdjustBufferSizeCpuCycles = 1UL << 31;
+// Weight of the newest message in the moving average of message sizes is
+// 1 / 2^kMessageSizeAvgShift.
+constexpr size_t kMessageSizeAvgShift = 3;
+// Read buffer should fit this many average messages, so that a single read
+// can bring in a batch of replies.
+constexpr size_t kMessagesPerReadBuffer = 4;
+// Empty read buffer is reallocated if its capacity exceeds the target size
+// by this factor.
+constexpr size_t kReadBufferShrinkFactor = 2;
+// Bodies of caret frames that take at least 1 / kSharedFrameFactor of the read
+// buffer are shared with it rather than copied.
+constexpr size_t kSharedFrameFactor = 2;
 
 size_t mcOpToRequestTypeId(mc_op_t mc_op) {
   switch (mc_op) {
@@ -81,6 +92,7 @@ McParser::McParser(
     ConnectionFifo* debugFifo)
     : callback_(callback),
       bufferSize_(minBufferSize),
+      minBufferSize_(minBufferSize),
       maxBufferSize_(maxBufferSize),
       debugFifo_(debugFifo),
       readBuffer_(folly::IOBuf::CREATE, bufferSize_),
@@ -92,11 +104,31 @@ McParser::McParser(
 
 void McParser::reset() {
   readBuffer_.clear();
+  messageSizeRecorded_ = false;
+  partialMessages_.clear();
+  partialBytes_ = 0;
+}
+
+size_t McParser::releaseReadBuffer() {
+  if (readBuffer_.length() != 0) {
+    return 0;
+  }
+  const auto released = readBuffer_.capacity();
+  readBuffer_ = folly::IOBuf();
+  return released;
 }
 
 std::pair<void*, size_t> McParser::getReadBuffer() {
   assert(!readBuffer_.isChained());
-  readBuffer_.unshareOne();
+  if (readBuffer_.capacity() == 0) {
+    // Released by releaseReadBuffer().
+    readBuffer_ = folly::IOBuf(folly::IOBuf::CREATE, bufferSize_);
+  }
+  if (readBuffer_.isSharedOne()) {
+    // Parsed replies may hold clones of large values in the buffer: rather
+    // than duplicating all of it, move the unparsed data to a new buffer.
+    reallocReadBuffer(bufferSize_);
+  }
   if (!readBuffer_.length()) {
     assert(readBuffer_.capacity() > 0);
     /* If we read everything, reset pointers to 0 and re-use the buffer */
@@ -111,13 +143,16 @@ std::pair<void*, size_t> McParser::getReadBuffer() {
   return std::make_pair(readBuffer_.writableTail(), readBuffer_.tailroom());
 }
 
-bool McParser::readUmbrellaOrCaretData() {
+bool McParser::readFramedData() {
   while (readBuffer_.length() > 0) {
     // Parse header
     UmbrellaParseStatus parseStatus;
     if (protocol_ == mc_umbrella_protocol_DONOTUSE) {
       parseStatus = umbrellaParseHeader(
           readBuffer_.data(), readBuffer_.length(), umMsgInfo_);
+    } else if (protocol_ == mc_binary_protocol) {
+      parseStatus = binaryParseHeader(
+          readBuffer_.data(), readBuffer_.length(), umMsgInfo_);
     } else {
       parseStatus = caretParseHeader(
           readBuffer_.data(), readBuffer_.length(), umMsgInfo_);
@@ -136,6 +171,10 @@ bool McParser::readUmbrellaOrCaretData() {
     }
 
     const auto messageSize = umMsgInfo_.headerSize + umMsgInfo_.bodySize;
+    if (!messageSizeRecorded_) {
+      recordMessageSize(messageSize);
+      messageSizeRecorded_ = true;
+    }
 
     // Parse message body
     // Case 1: Entire message (and possibly part of next) is in the buffer
@@ -159,6 +198,14 @@ bool McParser::readUmbrellaOrCaretData() {
       bool cbStatus;
       if (protocol_ == mc_umbrella_protocol_DONOTUSE) {
         cbStatus = callback_.umMessageReady(umMsgInfo_, readBuffer_);
+      } else if (protocol_ == mc_binary_protocol) {
+        cbStatus = callback_.binaryMessageReady(umMsgInfo_, readBuffer_);
+      } else if (umMsgInfo_.batchSize != 0) {
+        cbStatus = caretBatchReady();
+      } else if (UNLIKELY(
+                     umMsgInfo_.moreFragments != 0 ||
+                     !partialMessages_.empty())) {
+        cbStatus = caretFrameReady();
       } else {
         cbStatus = callback_.caretMessageReady(umMsgInfo_, readBuffer_);
       }
@@ -168,6 +215,10 @@ bool McParser::readUmbrellaOrCaretData() {
         return false;
       }
       readBuffer_.trimStart(messageSize);
+      messageSizeRecorded_ = false;
+      if (UNLIKELY(parsingPaused_)) {
+        return true;
+      }
       continue;
     }
 
@@ -177,15 +228,18 @@ bool McParser::readUmbrellaOrCaretData() {
     }
 
     // Case 3: We have the full header, but not the full body. If needed,
-    // reallocate into a buffer large enough for full header and body. Then
-    // return to wait for remaining data.
+    // reallocate into a buffer large enough for full header and body, so that
+    // the rest of the message is read directly into a single right-sized
+    // buffer. Then return to wait for remaining data.
     if (readBuffer_.length() + readBuffer_.tailroom() < messageSize) {
       assert(!readBuffer_.isChained());
-      readBuffer_.unshareOne();
-      bufferSize_ = std::max<size_t>(bufferSize_, messageSize);
-      readBuffer_.reserve(
-          0 /* minHeadroom */,
-          bufferSize_ - readBuffer_.length() /* minTailroom */);
+      if (readBuffer_.isSharedOne()) {
+        reallocReadBuffer(messageSize);
+      } else {
+        readBuffer_.reserve(
+            0 /* minHeadroom */,
+            messageSize - readBuffer_.length() /* minTailroom */);
+      }
     }
 #ifdef FOLLY_JEMALLOC_NODUMP_ALLOCATOR_SUPPORTED
     if (useJemallocNodumpAllocator_) {
@@ -196,18 +250,142 @@ bool McParser::readUmbrellaOrCaretData() {
   }
 
   // We parsed everything, read buffer is empty.
-  // Try to shrink it to reduce memory footprint
-  if (bufferSize_ > maxBufferSize_) {
-    auto curCycles = cycles::getCpuCycles();
-    if (curCycles > lastShrinkCycles_ + kAdjustBufferSizeCpuCycles) {
-      lastShrinkCycles_ = curCycles;
-      bufferSize_ = maxBufferSize_;
-      readBuffer_ = folly::IOBuf(folly::IOBuf::CREATE, bufferSize_);
+  // Shrink it if it's much bigger than what recent messages need, e.g. after
+  // an occasional large message, to reduce memory footprint.
+  const auto keepSize = std::max(bufferSize_, avgMessageSize_);
+  if (readBuffer_.capacity() > keepSize * kReadBufferShrinkFactor) {
+    readBuffer_ = folly::IOBuf(folly::IOBuf::CREATE, bufferSize_);
+  }
+  return true;
+}
+
+bool McParser::caretFrameReady() {
+  auto it = partialMessages_.find(umMsgInfo_.reqId);
+  if (it == partialMessages_.end()) {
+    if (umMsgInfo_.moreFragments == 0) {
+      return callback_.caretMessageReady(umMsgInfo_, readBuffer_);
     }
+    if (partialMessages_.size() >= maxPartialMessages_) {
+      callback_.parseError(
+          mc_res_remote_error,
+          folly::sformat(
+              "More than {} fragmented caret messages at a time",
+              maxPartialMessages_));
+      return false;
+    }
+    it = partialMessages_.emplace(umMsgInfo_.reqId, PartialMessage()).first;
+    it->second.info = umMsgInfo_;
+  } else if (umMsgInfo_.typeId != it->second.info.typeId) {
+    callback_.parseError(
+        mc_res_remote_error,
+        folly::sformat(
+            "Caret frame of type {} continues message {} of type {}",
+            umMsgInfo_.typeId,
+            umMsgInfo_.reqId,
+            it->second.info.typeId));
+    return false;
+  }
+
+  if (partialBytes_ + umMsgInfo_.bodySize > maxPartialBytes_) {
+    callback_.parseError(
+        mc_res_remote_error,
+        folly::sformat(
+            "Fragmented caret messages take more than {} bytes",
+            maxPartialBytes_));
+    return false;
+  }
+  partialBytes_ += umMsgInfo_.bodySize;
+
+  // readBuffer_ is reused for the next frames, so small bodies are copied.
+  // Large ones take most of the buffer anyway: share it instead, the next
+  // getReadBuffer() moves what follows to a new buffer.
+  if (umMsgInfo_.bodySize * kSharedFrameFactor >= readBuffer_.capacity()) {
+    auto body = readBuffer_.cloneOne();
+    body->trimStart(umMsgInfo_.headerSize);
+    body->trimEnd(body->length() - umMsgInfo_.bodySize);
+    it->second.body.append(std::move(body));
+  } else {
+    it->second.body.append(folly::IOBuf::copyBuffer(
+        readBuffer_.data() + umMsgInfo_.headerSize, umMsgInfo_.bodySize));
+  }
+  if (umMsgInfo_.moreFragments != 0) {
+    return true;
+  }
+
+  // Last frame: pass the message as if it came in one piece, with the
+  // additional fields of the first frame.
+  partialBytes_ -= it->second.body.chainLength();
+  auto message = it->second.body.move();
+  umMsgInfo_ = it->second.info;
+  partialMessages_.erase(it);
+  if (!message) {
+    message = folly::IOBuf::create(0);
+  }
+  if (umMsgInfo_.usedCodecId != 0 || !callback_.chainedMessagesSupported()) {
+    message->coalesce();
+  }
+  umMsgInfo_.headerSize = 0;
+  umMsgInfo_.bodySize = message->length();
+  umMsgInfo_.moreFragments = 0;
+  return callback_.caretMessageReady(umMsgInfo_, *message);
+}
+
+bool McParser::caretBatchReady() {
+  if (umMsgInfo_.moreFragments != 0) {
+    callback_.parseError(mc_res_remote_error, "Fragmented caret batch");
+    return false;
+  }
+
+  // Messages are passed in readBuffer_, with headerSize as the offset of
+  // their bodies.
+  auto info = umMsgInfo_;
+  info.batchSize = 0;
+  folly::ByteRange range(
+      readBuffer_.data() + umMsgInfo_.headerSize, umMsgInfo_.bodySize);
+  for (uint64_t i = 0; i < umMsgInfo_.batchSize; ++i) {
+    const auto reqIdDelta = folly::tryDecodeVarint(range);
+    const auto bodySize =
+        reqIdDelta ? folly::tryDecodeVarint(range) : reqIdDelta;
+    if (!bodySize || *bodySize > range.size()) {
+      callback_.parseError(mc_res_remote_error, "Malformed caret batch");
+      return false;
+    }
+    info.reqId += static_cast<uint32_t>(*reqIdDelta);
+    info.headerSize = range.begin() - readBuffer_.data();
+    info.bodySize = *bodySize;
+    range.advance(*bodySize);
+    if (!callback_.caretMessageReady(info, readBuffer_)) {
+      return false;
+    }
+  }
+  if (!range.empty()) {
+    callback_.parseError(mc_res_remote_error, "Malformed caret batch");
+    return false;
   }
   return true;
 }
 
+void McParser::reallocReadBuffer(size_t capacity) {
+  folly::IOBuf buffer(
+      folly::IOBuf::CREATE, std::max(capacity, readBuffer_.length()));
+  if (readBuffer_.length() > 0) {
+    std::memcpy(
+        buffer.writableTail(), readBuffer_.data(), readBuffer_.length());
+    buffer.append(readBuffer_.length());
+  }
+  readBuffer_ = std::move(buffer);
+}
+
+void McParser::recordMessageSize(size_t size) {
+  avgMessageSize_ -= avgMessageSize_ >> kMessageSizeAvgShift;
+  avgMessageSize_ += size >> kMessageSizeAvgShift;
+  bufferSize_ = std::min(
+      std::max(
+          folly::nextPowTwo(avgMessageSize_ * kMessagesPerReadBuffer),
+          minBufferSize_),
+      maxBufferSize_);
+}
+
 bool McParser::readDataAvailable(size_t len) {
   // Caller is responsible for ensuring the read buffer has enough tailroom
   readBuffer_.append(len);
@@ -223,7 +401,7 @@ bool McParser::readDataAvailable(size_t len) {
     } else {
       assert(
           protocol_ == mc_umbrella_protocol_DONOTUSE ||
-          protocol_ == mc_caret_protocol);
+          protocol_ == mc_caret_protocol || protocol_ == mc_binary_protocol);
       outOfOrder_ = true;
     }
   }
@@ -232,7 +410,18 @@ bool McParser::readDataAvailable(size_t len) {
     callback_.handleAscii(readBuffer_);
     return true;
   }
-  return readUmbrellaOrCaretData();
+  if (UNLIKELY(parsingPaused_)) {
+    return true;
+  }
+  return readFramedData();
+}
+
+bool McParser::resumeParsing() {
+  parsingPaused_ = false;
+  if (protocol_ == mc_ascii_protocol) {
+    return true;
+  }
+  return readFramedData();
 }
 
 double McParser::getDropProbability() const {
@@ -7,10 +7,13 @@
  */
 #pragma once
 
+#include <unordered_map>
+
 #include <folly/io/IOBufQueue.h>
 
 #include "mcrouter/lib/debug/ConnectionFifo.h"
 #include "mcrouter/lib/mc/protocol.h"
+#include "mcrouter/lib/network/BinaryProtocol.h"
 #include "mcrouter/lib/network/UmbrellaProtocol.h"
 
 namespace facebook {
@@ -25,6 +28,8 @@ inline mc_protocol_t determineProtocol(uint8_t firstByte) {
       return mc_caret_protocol;
     case ENTRY_LIST_MAGIC_BYTE:
       return mc_umbrella_protocol_DONOTUSE;
+    case kBinaryReplyMagicByte:
+      return mc_binary_protocol;
     default:
       return mc_ascii_protocol;
   }
@@ -54,14 +59,44 @@ class McParser {
      * Caret header and after the full Caret message body is in the read buffer.
      *
      * @param headerInfo  Parsed header data (header size, body size, etc.)
-     * @param buffer      Coalesced IOBuf that holds the entire message
-     *                    (header and body)
+     *                    For messages of a batch, headerSize is the offset
+     *                    of the body in buffer.
+     * @param buffer      IOBuf that holds the entire message (header and
+     *                    body). Coalesced, unless it was reassembled from
+     *                    frames, isn't compressed and
+     *                    chainedMessagesSupported() is true.
      * @return            False on any parse errors.
      */
     virtual bool caretMessageReady(
         const UmbrellaMessageInfo& headerInfo,
         const folly::IOBuf& buffer) = 0;
 
+    /**
+     * Called after a full memcached binary protocol reply is in the read
+     * buffer. Only clients speak binary protocol, so by default it's a parse
+     * error.
+     *
+     * @param headerInfo  Header sizes and reqId (see binaryParseHeader).
+     * @param buffer      Coalesced IOBuf that holds the entire message
+     *                    (header and body)
+     * @return            False on any parse errors.
+     */
+    virtual bool binaryMessageReady(
+        const UmbrellaMessageInfo& /* headerInfo */,
+        const folly::IOBuf& /* buffer */) {
+      parseError(mc_res_remote_error, "Unexpected binary protocol message");
+      return false;
+    }
+
+    /**
+     * @return  true if caretMessageReady() can handle chained buffers, so
+     *          that large messages received in frames aren't copied into a
+     *          single buffer.
+     */
+    virtual bool chainedMessagesSupported() const {
+      return false;
+    }
+
     /**
      * Handle ascii data read.
      * The user is responsible for clearing or advancing the readBuffer.
@@ -116,8 +151,53 @@ class McParser {
 
   double getDropProbability() const;
 
+  /**
+   * @return  Credit window advertised in the last caret message header,
+   *          0 if none.
+   */
+  uint64_t getCreditWindow() const {
+    return umMsgInfo_.creditWindow;
+  }
+
   void reset();
 
+  /**
+   * Frees the read buffer if it holds no unparsed data. The next
+   * getReadBuffer() allocates a new one.
+   *
+   * @return  number of bytes freed.
+   */
+  size_t releaseReadBuffer();
+
+  size_t readBufferCapacity() const {
+    return readBuffer_.capacity();
+  }
+
+  /**
+   * Stops parsing framed (non-ascii) data after the message that is being
+   * handed to the callback, e.g. so that other connections get a turn.
+   * Data read meanwhile is buffered. Has no effect on ascii.
+   */
+  void pauseParsing() {
+    parsingPaused_ = true;
+  }
+
+  /**
+   * Parses whatever was buffered while parsing was paused.
+   * @return false  On any parse error.
+   */
+  bool resumeParsing();
+
+  /**
+   * Limits the caret messages being reassembled from frames at a time: at
+   * most maxMessages of them, holding at most maxBytes of body in total.
+   * Going over either limit is a parse error.
+   */
+  void setPartialMessageLimits(size_t maxMessages, size_t maxBytes) {
+    maxPartialMessages_ = maxMessages;
+    maxPartialBytes_ = maxBytes;
+  }
+
  private:
   bool seenFirstByte_{false};
   bool outOfOrder_{false};
@@ -125,13 +205,22 @@ class McParser {
   mc_protocol_t protocol_{mc_unknown_protocol};
 
   ParserCallback& callback_;
+  // Size of read buffer we're aiming for, adjusted according to the sizes
+  // of recently parsed messages within [minBufferSize_, maxBufferSize_].
   size_t bufferSize_{256};
+  size_t minBufferSize_{256};
   size_t maxBufferSize_{4096};
+  // Moving average of umbrella/caret message sizes on this connection.
+  // Ascii values are read directly into right-sized buffers by
+  // McAsciiParser, so they don't contribute.
+  size_t avgMessageSize_{0};
+  // True iff size of the message currently being read was already recorded.
+  bool messageSizeRecorded_{false};
+  // See pauseParsing().
+  bool parsingPaused_{false};
 
   ConnectionFifo* debugFifo_{nullptr};
 
-  uint64_t lastShrinkCycles_{0};
-
   folly::IOBuf readBuffer_;
 
   /**
@@ -139,12 +228,47 @@ class McParser {
    */
   UmbrellaMessageInfo umMsgInfo_;
 
+  /**
+   * Caret messages received in frames, by reqId (see CaretFragmenter): header
+   * of the first frame and the bodies received so far.
+   */
+  struct PartialMessage {
+    UmbrellaMessageInfo info;
+    folly::IOBufQueue body{folly::IOBufQueue::cacheChainLength()};
+  };
+  std::unordered_map<uint32_t, PartialMessage> partialMessages_;
+  // Body bytes held by partialMessages_, and limits (see
+  // setPartialMessageLimits()).
+  size_t partialBytes_{0};
+  size_t maxPartialMessages_{1024};
+  size_t maxPartialBytes_{64 * 1024 * 1024};
+
   /**
    * Custom allocator states and method
    */
   bool useJemallocNodumpAllocator_{false};
 
-  bool readUmbrellaOrCaretData();
+  /**
+   * Parses the umbrella, caret or binary messages in readBuffer_: they all
+   * start with a header that has the body size.
+   */
+  bool readFramedData();
+  /**
+   * Handles the caret frame at the beginning of readBuffer_: buffers its body
+   * and passes the reassembled message to the callback after the last frame.
+   */
+  bool caretFrameReady();
+  /**
+   * Passes the messages of the caret batch at the beginning of readBuffer_
+   * (see CaretBatcher) to the callback, one by one.
+   */
+  bool caretBatchReady();
+  /**
+   * Replaces readBuffer_ with a new buffer of at least the given capacity
+   * that holds a copy of its unparsed data.
+   */
+  void reallocReadBuffer(size_t capacity);
+  void recordMessageSize(size_t size);
 };
 
 inline McParser::ParserCallback::~ParserCallback() {}
@@ -58,7 +58,10 @@ McSerializedRequest::McSerializedRequest(
     const Request& req,
     size_t reqId,
     mc_protocol_t protocol,
-    const CodecIdRange& compressionCodecs)
+    const CodecIdRange& compressionCodecs,
+    std::chrono::milliseconds timeoutBudget,
+    const CompressionCodecMap* compressionCodecMap,
+    const CompressionOffload* compressionOffload)
     : protocol_(protocol), typeId_(Request::typeId) {
   switch (protocol_) {
     case mc_ascii_protocol:
@@ -71,13 +74,40 @@ McSerializedRequest::McSerializedRequest(
         result_ = Result::ERROR;
       }
       break;
+    case mc_meta_protocol:
+      new (&asciiRequest_) AsciiSerializedRequest;
+      if (detail::getKeySize(req) > MC_KEY_MAX_LEN_ASCII) {
+        result_ = Result::BAD_KEY;
+        return;
+      }
+      if (!asciiRequest_.prepareMeta(req, iovsBegin_, iovsCount_)) {
+        result_ = Result::ERROR;
+      }
+      break;
+    case mc_binary_protocol:
+      new (&binaryRequest_) BinarySerializedRequest;
+      if (detail::getKeySize(req) > MC_KEY_MAX_LEN_ASCII) {
+        result_ = Result::BAD_KEY;
+        return;
+      }
+      if (!binaryRequest_.prepare(req, reqId, iovsBegin_, iovsCount_)) {
+        result_ = Result::ERROR;
+      }
+      break;
     case mc_caret_protocol:
       new (&caretRequest_) CaretSerializedMessage;
       if (detail::getKeySize(req) > MC_KEY_MAX_LEN_UMBRELLA) {
         return;
       }
+      caretRequest_.setCompressionOffload(compressionOffload);
       if (!caretRequest_.prepare(
-              req, reqId, compressionCodecs, iovsBegin_, iovsCount_)) {
+              req,
+              reqId,
+              compressionCodecs,
+              timeoutBudget,
+              compressionCodecMap,
+              iovsBegin_,
+              iovsCount_)) {
         result_ = Result::ERROR;
       }
       break;
@@ -91,7 +121,6 @@ McSerializedRequest::McSerializedRequest(
           req, umbrellaMessage_, reqId, iovsBegin_, iovsCount_);
       break;
     case mc_unknown_protocol:
-    case mc_binary_protocol:
     case mc_nprotocols:
       checkLogic(false, "Used unsupported protocol! Value: {}", (int)protocol_);
       result_ = Result::ERROR;
@@ -13,8 +13,12 @@ namespace memcache {
 McSerializedRequest::~McSerializedRequest() {
   switch (protocol_) {
     case mc_ascii_protocol:
+    case mc_meta_protocol:
       asciiRequest_.~AsciiSerializedRequest();
       break;
+    case mc_binary_protocol:
+      binaryRequest_.~BinarySerializedRequest();
+      break;
     case mc_caret_protocol:
       caretRequest_.~CaretSerializedMessage();
       break;
@@ -22,7 +26,6 @@ McSerializedRequest::~McSerializedRequest() {
       umbrellaMessage_.~UmbrellaSerializedMessage();
       break;
     case mc_unknown_protocol:
-    case mc_binary_protocol:
     case mc_nprotocols:
       break;
   }
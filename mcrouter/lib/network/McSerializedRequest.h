@@ -7,10 +7,12 @@
  */
 #pragma once
 
+#include <chrono>
 #include <memory>
 
 #include "mcrouter/lib/mc/protocol.h"
 #include "mcrouter/lib/network/AsciiSerialized.h"
+#include "mcrouter/lib/network/BinarySerialized.h"
 #include "mcrouter/lib/network/CaretSerializedMessage.h"
 #include "mcrouter/lib/network/UmbrellaProtocol.h"
 
@@ -18,6 +20,8 @@ namespace facebook {
 namespace memcache {
 
 struct CodecIdRange;
+class CompressionCodecMap;
+class CompressionOffload;
 
 /**
  * A class for serializing memcache requests into iovs.
@@ -36,13 +40,22 @@ class McSerializedRequest {
    * @param protocol          Protocol to serialize the request.
    * @param supportedCodecs   Range of supported compression codecs.
    *                          Only used for caret.
+   * @param timeoutBudget     Time the sender is going to wait for the reply,
+   *                          passed to the server. Only used for caret.
+   * @param compressionCodecMap  Codecs to compress the request with, nullptr
+   *                             to send it uncompressed. Only used for caret.
+   * @param compressionOffload   If set, big bodies are compressed off the
+   *                             calling fiber's thread. Only used for caret.
    */
   template <class Request>
   McSerializedRequest(
       const Request& req,
       size_t reqId,
       mc_protocol_t protocol,
-      const CodecIdRange& supportedCodecs);
+      const CodecIdRange& supportedCodecs,
+      std::chrono::milliseconds timeoutBudget = std::chrono::milliseconds(0),
+      const CompressionCodecMap* compressionCodecMap = nullptr,
+      const CompressionOffload* compressionOffload = nullptr);
 
   ~McSerializedRequest();
 
@@ -68,6 +81,7 @@ class McSerializedRequest {
 
   union {
     AsciiSerializedRequest asciiRequest_;
+    BinarySerializedRequest binaryRequest_;
     UmbrellaSerializedMessage umbrellaMessage_;
     CaretSerializedMessage caretRequest_;
   };
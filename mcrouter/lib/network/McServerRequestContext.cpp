@@ -7,6 +7,10 @@
  */
 #include "McServerRequestContext.h"
 
+#include <algorithm>
+#include <limits>
+
+#include "mcrouter/lib/McTracepoints.h"
 #include "mcrouter/lib/network/McServerSession.h"
 #include "mcrouter/lib/network/MultiOpParent.h"
 
@@ -22,13 +26,15 @@ McServerRequestContext::McServerRequestContext(
     McServerSession& s,
     uint64_t r,
     bool nr,
-    std::shared_ptr<MultiOpParent> parent,
+    MultiOpParent* parent,
     bool isEndContext)
     : session_(&s), isEndContext_(isEndContext), noReply_(nr), reqid_(r) {
+  MC_TRACEPOINT(server_request, session_, reqid_);
   if (parent) {
-    asciiState_ = std::make_unique<AsciiState>();
-    asciiState_->parent_ = std::move(parent);
-    asciiState_->parent_->recordRequest();
+    asciiState_ = parent->allocateState();
+    asciiState_->parent_ = parent;
+    parent->addRef();
+    parent->recordRequest();
   }
 
   session_->onTransactionStarted(hasParent() || isEndContext_);
@@ -41,8 +47,9 @@ McServerRequestContext::McServerRequestContext(
       noReply_(other.noReply_),
       replied_(other.replied_),
       reqid_(other.reqid_),
-      asciiState_(std::move(other.asciiState_)) {
+      asciiState_(other.asciiState_) {
   other.session_ = nullptr;
+  other.asciiState_ = nullptr;
 }
 
 McServerRequestContext& McServerRequestContext::operator=(
@@ -52,9 +59,11 @@ McServerRequestContext& McServerRequestContext::operator=(
   reqid_ = other.reqid_;
   noReply_ = other.noReply_;
   replied_ = other.replied_;
-  asciiState_ = std::move(other.asciiState_);
+  releaseAsciiState();
+  asciiState_ = other.asciiState_;
 
   other.session_ = nullptr;
+  other.asciiState_ = nullptr;
 
   return *this;
 }
@@ -65,6 +74,22 @@ McServerRequestContext::~McServerRequestContext() {
     assert(replied_);
     session_->onTransactionCompleted(hasParent() || isEndContext_);
   }
+  releaseAsciiState();
+}
+
+void McServerRequestContext::releaseAsciiState() {
+  if (!asciiState_) {
+    return;
+  }
+  if (auto parent = asciiState_->parent_) {
+    // The state itself is freed with the parent.
+    asciiState_->key_.clear();
+    asciiState_->parent_ = nullptr;
+    parent->removeRef();
+  } else {
+    delete asciiState_;
+  }
+  asciiState_ = nullptr;
 }
 
 // Note: defined in .cpp in order to avoid circular dependency between
@@ -110,5 +135,13 @@ ServerLoad McServerRequestContext::getServerLoad() const noexcept {
   return ServerLoad::zero();
 }
 
+uint32_t McServerRequestContext::getCreditWindow() const noexcept {
+  if (session_) {
+    return static_cast<uint32_t>(std::min<size_t>(
+        session_->options_.maxInFlight, std::numeric_limits<uint32_t>::max()));
+  }
+  return 0;
+}
+
 } // memcache
 } // facebook
@@ -27,6 +27,13 @@ class McServerOnRequestWrapper;
 class McServerSession;
 class MultiOpParent;
 
+/**
+ * Drops a reference to a MultiOpParent; defined in MultiOpParent.cpp.
+ */
+struct MultiOpParentDeleter {
+  void operator()(MultiOpParent* parent) const;
+};
+
 /**
  * API for users of McServer to send back a reply for a request.
  *
@@ -61,6 +68,21 @@ class McServerRequestContext {
 
   ServerLoad getServerLoad() const noexcept;
 
+  /**
+   * Max number of unreplied requests the session accepts before it stops
+   * reading (AsyncMcServerWorkerOptions::maxInFlight), advertised to caret
+   * clients as their credit window. 0 if unlimited.
+   */
+  uint32_t getCreditWindow() const noexcept;
+
+  /**
+   * Identifies the ascii multi-get this request was split from, nullptr if
+   * it is a request of its own.
+   */
+  const void* multiOpId() const noexcept {
+    return hasParent() ? asciiState_->parent_ : nullptr;
+  }
+
  private:
   McServerSession* session_;
 
@@ -71,10 +93,14 @@ class McServerRequestContext {
 
   uint64_t reqid_;
   struct AsciiState {
-    std::shared_ptr<MultiOpParent> parent_;
+    // If set, this state was allocated by the parent (which we hold a
+    // reference to), otherwise it's owned by the context.
+    MultiOpParent* parent_{nullptr};
     folly::Optional<folly::IOBuf> key_;
   };
-  std::unique_ptr<AsciiState> asciiState_;
+  AsciiState* asciiState_{nullptr};
+
+  void releaseAsciiState();
 
   template <class Reply>
   bool noReply(const Reply& r) const;
@@ -100,7 +126,7 @@ class McServerRequestContext {
 
   folly::Optional<folly::IOBuf>& asciiKey() {
     if (!asciiState_) {
-      asciiState_ = std::make_unique<AsciiState>();
+      asciiState_ = new AsciiState();
     }
     return asciiState_->key_;
   }
@@ -142,7 +168,7 @@ class McServerRequestContext {
       McServerSession& s,
       uint64_t r,
       bool nr = false,
-      std::shared_ptr<MultiOpParent> parent = nullptr,
+      MultiOpParent* parent = nullptr,
       bool isEndContext = false);
 };
 
@@ -33,12 +33,12 @@ void McServerSession::asciiRequestReady(
   }
 
   if (carbon::GetLike<Request>::value && !currentMultiop_) {
-    currentMultiop_ = std::make_shared<MultiOpParent>(*this, tailReqid_++);
+    currentMultiop_ = MultiOpParent::create(*this, tailReqid_++);
   }
   uint64_t reqid;
   reqid = tailReqid_++;
 
-  McServerRequestContext ctx(*this, reqid, noreply, currentMultiop_);
+  McServerRequestContext ctx(*this, reqid, noreply, currentMultiop_.get());
 
   ctx.asciiKey().emplace(req.key().raw().cloneOneAsValue());
 
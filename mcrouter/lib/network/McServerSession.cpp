@@ -7,11 +7,20 @@
  */
 #include "McServerSession.h"
 
+#include <sys/socket.h>
+
+#include <algorithm>
 #include <memory>
+#include <stdexcept>
 
+#include <folly/Format.h>
+#include <folly/String.h>
 #include <folly/small_vector.h>
 
+#include "mcrouter/lib/IOBufUtil.h"
+#include "mcrouter/lib/McTracepoints.h"
 #include "mcrouter/lib/debug/FifoManager.h"
+#include "mcrouter/lib/network/CpuController.h"
 #include "mcrouter/lib/network/McSSLUtil.h"
 #include "mcrouter/lib/network/McServerRequestContext.h"
 #include "mcrouter/lib/network/MultiOpParent.h"
@@ -84,12 +93,14 @@ McServerSession::McServerSession(
           transport_.get(),
           onRequest_->name())),
       sendWritesCallback_(*this),
+      fairShareCallback_(*this),
       compressionCodecMap_(codecMap),
       parser_(
           *this,
           options_.minBufferSize,
           options_.maxBufferSize,
           &debugFifo_),
+      blockedReplies_(options_.maxInFlight),
       userCtxt_(userCtxt) {
   try {
     transport_->getPeerAddress(&socketAddress_);
@@ -97,11 +108,44 @@ McServerSession::McServerSession(
     // std::system_error or other exception, leave IP address empty
     LOG(WARNING) << "Failed to get socket address: " << e.what();
   }
+  if (socketAddress_.getFamily() == AF_UNIX) {
+    initPeerCredentials();
+  }
 
   auto socket = transport_->getUnderlyingTransport<folly::AsyncSSLSocket>();
   if (socket != nullptr) {
-    socket->sslAccept(this, /* timeout = */ std::chrono::milliseconds::zero());
+    if (socket->getSSLState() == folly::AsyncSSLSocket::STATE_ESTABLISHED) {
+      // The handshake was done on a handshake thread.
+      handshakeSuc(socket);
+    } else {
+      socket->sslAccept(
+          this, /* timeout = */ std::chrono::milliseconds::zero());
+    }
+  } else if (options_.zeroCopyThreshold > 0) {
+    if (auto plainSocket =
+            transport_->getUnderlyingTransport<folly::AsyncSocket>()) {
+      zeroCopyEnabled_ = plainSocket->setZeroCopy(true);
+    }
+  }
+}
+
+void McServerSession::initPeerCredentials() {
+  auto socket = transport_->getUnderlyingTransport<folly::AsyncSocket>();
+  if (socket == nullptr) {
+    return;
   }
+  struct ucred cred;
+  socklen_t credLen = sizeof(cred);
+  const int fd = socket->getFd();
+  if (::getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &credLen) != 0) {
+    LOG(WARNING) << "Failed to get peer credentials: "
+                 << folly::errnoStr(errno);
+    return;
+  }
+  peerCredentials_ = cred;
+  // Unix domain sockets can't do SSL, so the peer's uid takes the place of
+  // the cert's common name.
+  clientCommonName_ = folly::sformat("uid:{}", cred.uid);
 }
 
 void McServerSession::pause(PauseReason reason) {
@@ -128,6 +172,76 @@ void McServerSession::onTransactionStarted(bool isSubRequest) {
       pause(PAUSE_THROTTLED);
     }
   }
+  if (options_.overloadRequestBudget > 0 && !isSubRequest) {
+    chargeOverloadBudget();
+  }
+  if (options_.maxRequestsPerLoop > 0 && !isSubRequest) {
+    countRequestThisLoop();
+  }
+}
+
+void McServerSession::countRequestThisLoop() {
+  if (requestsThisLoop_++ == 0) {
+    eventBase_.runInLoop(&fairShareCallback_);
+  }
+  if (requestsThisLoop_ < options_.maxRequestsPerLoop || readsDeferred_ ||
+      !parser_.outOfOrder()) {
+    return;
+  }
+
+  DestructorGuard dg(this);
+  readsDeferred_ = true;
+  parser_.pauseParsing();
+  pause(PAUSE_FAIR_SHARE);
+  stateCb_.onReadsDeferred(*this);
+}
+
+void McServerSession::onLoopEnd() {
+  DestructorGuard dg(this);
+
+  requestsThisLoop_ = 0;
+  if (!readsDeferred_) {
+    return;
+  }
+  readsDeferred_ = false;
+  if (state_ != STREAMING) {
+    return;
+  }
+  // Loop callbacks added from here on run in the next iteration, so this
+  // parses at most maxRequestsPerLoop requests, possibly deferring again.
+  if (!parser_.resumeParsing()) {
+    close();
+    return;
+  }
+  if (!readsDeferred_) {
+    resume(PAUSE_FAIR_SHARE);
+  }
+}
+
+void McServerSession::chargeOverloadBudget() {
+  const auto& cpuController = options_.cpuController;
+  if (!cpuController ||
+      cpuController->getServerLoad().percentLoad() <
+          options_.overloadCpuThreshold) {
+    overloadBudget_.reset();
+    return;
+  }
+
+  // Requests already in the read buffer still go through, pushing the
+  // resume further out (by at most a second).
+  const auto refillTime =
+      overloadBudget_.charge(std::chrono::steady_clock::now());
+  if (refillTime.count() == 0) {
+    return;
+  }
+
+  DestructorGuard dg(this);
+  pause(PAUSE_OVER_BUDGET);
+  if (!overBudgetTimeout_) {
+    overBudgetTimeout_ = folly::AsyncTimeout::make(
+        eventBase_, [this]() noexcept { resume(PAUSE_OVER_BUDGET); });
+  }
+  overBudgetTimeout_->scheduleTimeout(refillTime);
 }
 
 void McServerSession::checkClosed() {
@@ -166,6 +280,7 @@ void McServerSession::onTransactionCompleted(bool isSubRequest) {
 
 void McServerSession::reply(std::unique_ptr<WriteBuffer> wb, uint64_t reqid) {
   DestructorGuard dg(this);
+  MC_TRACEPOINT(server_reply, this, reqid);
 
   if (parser_.outOfOrder()) {
     queueWrite(std::move(wb));
@@ -173,15 +288,14 @@ void McServerSession::reply(std::unique_ptr<WriteBuffer> wb, uint64_t reqid) {
     if (reqid == headReqid_) {
       /* head of line reply, write it and all contiguous blocked replies */
       queueWrite(std::move(wb));
-      auto it = blockedReplies_.find(++headReqid_);
-      while (it != blockedReplies_.end()) {
-        queueWrite(std::move(it->second));
-        blockedReplies_.erase(it);
-        it = blockedReplies_.find(++headReqid_);
+      auto next = blockedReplies_.take(++headReqid_);
+      while (next) {
+        queueWrite(std::move(next));
+        next = blockedReplies_.take(++headReqid_);
       }
     } else {
       /* can't write this reply now, save for later */
-      blockedReplies_.emplace(reqid, std::move(wb));
+      blockedReplies_.insert(headReqid_, reqid, std::move(wb));
     }
   }
 }
@@ -210,6 +324,7 @@ void McServerSession::close() {
 
   // Reset timeout if set, since we're shutting down anyway.
   goAwayTimeout_ = nullptr;
+  overBudgetTimeout_ = nullptr;
 
   // Regardless of the reason we're closing, we should immediately stop reading
   // from the socket or we may get into invalid state.
@@ -239,11 +354,22 @@ void McServerSession::getReadBuffer(void** bufReturn, size_t* lenReturn) {
 
 void McServerSession::readDataAvailable(size_t len) noexcept {
   DestructorGuard dg(this);
+  if (options_.idleBufferReleaseTimeout.count() != 0) {
+    lastReadTime_ = std::chrono::steady_clock::now();
+  }
   if (!parser_.readDataAvailable(len)) {
     close();
   }
 }
 
+size_t McServerSession::releaseReadBufferIfIdle(
+    std::chrono::steady_clock::time_point idleSince) {
+  if (state_ != STREAMING || lastReadTime_ > idleSince) {
+    return 0;
+  }
+  return parser_.releaseReadBuffer();
+}
+
 void McServerSession::readEOF() noexcept {
   close();
 }
@@ -316,12 +442,33 @@ void McServerSession::caretRequestReady(
   }
 
   updateCompressionCodecIdRange(headerInfo);
+  if (headerInfo.acceptsFragments != 0) {
+    peerAcceptsFragments_ = true;
+  }
 
   if (headerInfo.reqId == kCaretConnectionControlReqId) {
     processConnectionControlMessage(headerInfo);
     return;
   }
 
+  if (UNLIKELY(headerInfo.usedCodecId > 0)) {
+    // Handlers expect plain carbon bodies.
+    auto body = uncompressRequest(headerInfo, reqBody);
+    auto info = headerInfo;
+    info.headerSize = 0;
+    info.bodySize = body->computeChainDataLength();
+    info.usedCodecId = 0;
+    info.uncompressedBodySize = 0;
+    dispatchCaretRequest(info, *body);
+    return;
+  }
+
+  dispatchCaretRequest(headerInfo, reqBody);
+}
+
+void McServerSession::dispatchCaretRequest(
+    const UmbrellaMessageInfo& headerInfo,
+    const folly::IOBuf& reqBody) {
   McServerRequestContext ctx(*this, headerInfo.reqId);
 
   if (McVersionRequest::typeId == headerInfo.typeId &&
@@ -342,6 +489,24 @@ void McServerSession::caretRequestReady(
   }
 }
 
+std::unique_ptr<folly::IOBuf> McServerSession::uncompressRequest(
+    const UmbrellaMessageInfo& headerInfo,
+    const folly::IOBuf& reqBody) {
+  auto* codec = compressionCodecMap_
+      ? compressionCodecMap_->get(headerInfo.usedCodecId)
+      : nullptr;
+  if (!codec) {
+    throw std::runtime_error(folly::sformat(
+        "Request compressed with unknown codec id {}",
+        headerInfo.usedCodecId));
+  }
+  // Caret header and body are in one coalesced IOBuf.
+  return codec->uncompress(
+      reqBody.data() + headerInfo.headerSize,
+      headerInfo.bodySize,
+      headerInfo.uncompressedBodySize);
+}
+
 void McServerSession::processConnectionControlMessage(
     const UmbrellaMessageInfo& headerInfo) {
   DestructorGuard dg(this);
@@ -393,8 +558,14 @@ void McServerSession::queueWrite(std::unique_ptr<WriteBuffer> wb) {
     }
     const struct iovec* iovs = wb->getIovsBegin();
     size_t iovCount = wb->getIovsCount();
+    auto zeroCopyBuf = zeroCopyChain(*wb);
     writeBufs_.push(std::move(wb));
-    transport_->writev(this, iovs, iovCount);
+    if (zeroCopyBuf) {
+      transport_->writeChain(
+          this, std::move(zeroCopyBuf), folly::WriteFlags::WRITE_MSG_ZEROCOPY);
+    } else {
+      transport_->writev(this, iovs, iovCount);
+    }
     if (!writeBufs_.empty()) {
       /* We only need to pause if the sendmsg() call didn't write everything
          in one go */
@@ -402,6 +573,7 @@ void McServerSession::queueWrite(std::unique_ptr<WriteBuffer> wb) {
     }
   } else {
     pendingWrites_.pushBack(std::move(wb));
+    ++numPendingWrites_;
 
     if (!writeScheduled_) {
       eventBase_.runInLoop(&sendWritesCallback_, /* thisIteration= */ true);
@@ -410,18 +582,70 @@ void McServerSession::queueWrite(std::unique_ptr<WriteBuffer> wb) {
   }
 }
 
+void McServerSession::SendWritesCallback::runLoopCallback() noexcept {
+  // If other requests of this session are still being processed, delay
+  // the write once until the end of current loop (e.g. after
+  // runActiveFibers() callback), so that replies produced in this iteration
+  // go out in the same writev. Otherwise there is nothing to wait for.
+  if (!rescheduled_ && session_.inFlight_ > session_.numPendingWrites_) {
+    rescheduled_ = true;
+    session_.eventBase_.runInLoop(this, /* thisIteration= */ true);
+    return;
+  }
+  rescheduled_ = false;
+  session_.sendWrites();
+}
+
 void McServerSession::sendWrites() {
   DestructorGuard dg(this);
 
   writeScheduled_ = false;
+  numPendingWrites_ = 0;
+  size_t numReplies = 0;
 
+  const bool mayFragment = options_.caretFrameSize > 0 &&
+      peerAcceptsFragments_ && parser_.protocol() == mc_caret_protocol;
   folly::small_vector<struct iovec, kIovecVectorSize> iovs;
+  folly::small_vector<FragmentedWrite*, 4> newFragmentedWrites;
+  WriteBuffer* batchTail = nullptr;
   while (!pendingWrites_.empty()) {
     auto wb = pendingWrites_.popFront();
     if (!wb->noReply()) {
+      ++numReplies;
       if (UNLIKELY(debugFifo_.isConnected())) {
         writeToDebugFifo(wb.get());
       }
+      if (mayFragment) {
+        CaretFragmenter fragmenter(
+            wb->getIovsBegin(), wb->getIovsCount(), options_.caretFrameSize);
+        if (fragmenter.shouldFragment()) {
+          // Its frames are written after this batch.
+          fragmentedWrites_.push_back(std::make_unique<FragmentedWrite>(
+              *this, std::move(wb), std::move(fragmenter)));
+          newFragmentedWrites.push_back(fragmentedWrites_.back().get());
+          continue;
+        }
+      }
+      if (auto zeroCopyBuf = zeroCopyChain(*wb)) {
+        // Flush what we batched so far and write this reply in a separate
+        // batch, so that its value is not copied into the socket buffer.
+        if (batchTail != nullptr) {
+          batchTail->markEndOfBatch();
+          batchTail = nullptr;
+          transport_->writev(
+              this, iovs.data(), iovs.size(), folly::WriteFlags::CORK);
+          iovs.clear();
+        }
+        wb->markEndOfBatch();
+        writeBufs_.push(std::move(wb));
+        transport_->writeChain(
+            this,
+            std::move(zeroCopyBuf),
+            (pendingWrites_.empty() ? folly::WriteFlags::NONE
+                                    : folly::WriteFlags::CORK) |
+                folly::WriteFlags::WRITE_MSG_ZEROCOPY);
+        continue;
+      }
       iovs.insert(
           iovs.end(),
           wb->getIovsBegin(),
@@ -430,10 +654,69 @@ void McServerSession::sendWrites() {
     if (pendingWrites_.empty()) {
       wb->markEndOfBatch();
     }
+    batchTail = wb.get();
     writeBufs_.push(std::move(wb));
   }
 
-  transport_->writev(this, iovs.data(), iovs.size());
+  if (batchTail != nullptr) {
+    // The last pending write may have been fragmented.
+    batchTail->markEndOfBatch();
+    transport_->writev(this, iovs.data(), iovs.size());
+  }
+  for (auto* fw : newFragmentedWrites) {
+    writeNextFrame(*fw);
+  }
+  if (numReplies > 0) {
+    stateCb_.onRepliesWritten(*this, numReplies);
+  }
+}
+
+void McServerSession::writeNextFrame(FragmentedWrite& fw) {
+  auto frame = fw.fragmenter().nextFrame();
+  transport_->writev(&fw, frame.first, frame.second);
+}
+
+void McServerSession::frameWritten(FragmentedWrite& fw, bool success) {
+  DestructorGuard dg(this);
+
+  if (success && !fw.fragmenter().done()) {
+    writeNextFrame(fw);
+    return;
+  }
+
+  auto it = std::find_if(
+      fragmentedWrites_.begin(),
+      fragmentedWrites_.end(),
+      [&fw](const std::unique_ptr<FragmentedWrite>& p) {
+        return p.get() == &fw;
+      });
+  assert(it != fragmentedWrites_.end());
+  // Destroying the write releases the reply and completes its transaction.
+  auto done = std::move(*it);
+  fragmentedWrites_.erase(it);
+  done.reset();
+
+  if (!success) {
+    close();
+  } else if (
+      writeBufs_.empty() && fragmentedWrites_.empty() && state_ == STREAMING) {
+    stateCb_.onWriteQuiescence(*this);
+    /* No-op if not paused */
+    resume(PAUSE_WRITE);
+  }
+}
+
+std::unique_ptr<folly::IOBuf> McServerSession::zeroCopyChain(
+    const WriteBuffer& wb) const {
+  if (!zeroCopyEnabled_) {
+    return nullptr;
+  }
+  auto valueBuf = wb.valueBuf();
+  if (valueBuf == nullptr ||
+      valueBuf->computeChainDataLength() < options_.zeroCopyThreshold) {
+    return nullptr;
+  }
+  return iovecsToSharedIOBuf(wb.getIovsBegin(), wb.getIovsCount(), valueBuf);
 }
 
 void McServerSession::writeToDebugFifo(const WriteBuffer* wb) noexcept {
@@ -462,7 +745,7 @@ void McServerSession::writeSuccess() noexcept {
   DestructorGuard dg(this);
   completeWrite();
 
-  if (writeBufs_.empty() && state_ == STREAMING) {
+  if (writeBufs_.empty() && fragmentedWrites_.empty() && state_ == STREAMING) {
     stateCb_.onWriteQuiescence(*this);
     /* No-op if not paused */
     resume(PAUSE_WRITE);
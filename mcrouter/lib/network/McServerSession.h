@@ -7,7 +7,14 @@
  */
 #pragma once
 
+#include <sys/socket.h>
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
 #include <folly/IntrusiveList.h>
+#include <folly/Optional.h>
 #include <folly/io/async/AsyncSSLSocket.h>
 #include <folly/io/async/AsyncSocket.h>
 #include <folly/io/async/AsyncTransport.h>
@@ -17,6 +24,9 @@
 #include "mcrouter/lib/CompressionCodecManager.h"
 #include "mcrouter/lib/debug/ConnectionFifo.h"
 #include "mcrouter/lib/network/AsyncMcServerWorkerOptions.h"
+#include "mcrouter/lib/network/CaretFragmenter.h"
+#include "mcrouter/lib/network/OverloadBudget.h"
+#include "mcrouter/lib/network/ReplyReorderBuffer.h"
 #include "mcrouter/lib/network/ServerMcParser.h"
 #include "mcrouter/lib/network/WriteBuffer.h"
 #include "mcrouter/lib/network/gen/Memcache.h"
@@ -52,6 +62,15 @@ class McServerSession : public folly::DelayedDestruction,
     virtual void onCloseStart(McServerSession&) = 0;
     virtual void onCloseFinish(McServerSession&) = 0;
     virtual void onShutdown() = 0;
+    /**
+     * Parsing was put off until the next loop iteration, see
+     * AsyncMcServerWorkerOptions::maxRequestsPerLoop.
+     */
+    virtual void onReadsDeferred(McServerSession&) {}
+    /**
+     * numReplies replies were handed to the transport in one batch.
+     */
+    virtual void onRepliesWritten(McServerSession&, size_t /* numReplies */) {}
   };
 
   /**
@@ -120,6 +139,19 @@ class McServerSession : public folly::DelayedDestruction,
     return inFlight_ > 0;
   }
 
+  /**
+   * Frees the read buffer if nothing was read since idleSince (only tracked
+   * if options.idleBufferReleaseTimeout is set).
+   *
+   * @return  number of bytes freed.
+   */
+  size_t releaseReadBufferIfIdle(
+      std::chrono::steady_clock::time_point idleSince);
+
+  size_t readBufferCapacity() const {
+    return parser_.readBufferCapacity();
+  }
+
   /**
    * Allow clients to pause and resume reading form the sockets.
    * See pause(PauseReason) and resume(PauseReason) below.
@@ -147,13 +179,22 @@ class McServerSession : public folly::DelayedDestruction,
 
   /**
    * @return  the client's common name obtained from the
-   *          SSL cert if this is an SSL session. Else it
-   *          returns empty string.
+   *          SSL cert if this is an SSL session, "uid:<uid>" of
+   *          the peer process if this is a unix domain socket
+   *          session. Else it returns empty string.
    */
   folly::StringPiece getClientCommonName() const noexcept {
     return clientCommonName_;
   }
 
+  /**
+   * @return  pid, uid and gid of the peer process (SO_PEERCRED) if this
+   *          session is over a unix domain socket. Else folly::none.
+   */
+  const folly::Optional<struct ucred>& getPeerCredentials() const noexcept {
+    return peerCredentials_;
+  }
+
   /**
    * @return the EventBase for this thread
    */
@@ -198,8 +239,12 @@ class McServerSession : public folly::DelayedDestruction,
   // Pointer to current buffer. Updated by getReadBuffer()
   std::pair<void*, size_t> curBuffer_;
 
+  // Time of the last read, if options_.idleBufferReleaseTimeout is set.
+  std::chrono::steady_clock::time_point lastReadTime_;
+
   // All writes to be written at the end of the loop in a single batch.
   WriteBuffer::List pendingWrites_;
+  size_t numPendingWrites_{0};
 
   /**
    * Queue of write buffers.
@@ -211,6 +256,51 @@ class McServerSession : public folly::DelayedDestruction,
    */
   bool writeScheduled_{false};
 
+  /**
+   * True iff MSG_ZEROCOPY is enabled on the transport.
+   */
+  bool zeroCopyEnabled_{false};
+
+  /**
+   * True iff the client told us it can reassemble fragmented caret replies.
+   */
+  bool peerAcceptsFragments_{false};
+
+  /**
+   * A caret reply bigger than options_.caretFrameSize, written one frame at
+   * a time: the next frame is only written once the previous one was, so
+   * that replies queued meanwhile get written between the frames.
+   */
+  class FragmentedWrite : public folly::AsyncTransportWrapper::WriteCallback {
+   public:
+    FragmentedWrite(
+        McServerSession& session,
+        std::unique_ptr<WriteBuffer> wb,
+        CaretFragmenter fragmenter)
+        : session_(session),
+          wb_(std::move(wb)),
+          fragmenter_(std::move(fragmenter)) {}
+
+    CaretFragmenter& fragmenter() {
+      return fragmenter_;
+    }
+
+    void writeSuccess() noexcept final {
+      session_.frameWritten(*this, true /* success */);
+    }
+    void writeErr(size_t, const folly::AsyncSocketException&) noexcept final {
+      session_.frameWritten(*this, false /* success */);
+    }
+
+   private:
+    McServerSession& session_;
+    // Owns the serialized reply referenced by fragmenter_.
+    std::unique_ptr<WriteBuffer> wb_;
+    CaretFragmenter fragmenter_;
+  };
+
+  std::vector<std::unique_ptr<FragmentedWrite>> fragmentedWrites_;
+
   /**
    * Total number of alive McTransactions in the system.
    */
@@ -224,21 +314,46 @@ class McServerSession : public folly::DelayedDestruction,
    */
   size_t realRequestsInFlight_{0};
 
+  // Of options_.overloadRequestBudget requests per second.
+  OverloadBudget overloadBudget_{
+      static_cast<double>(options_.overloadRequestBudget)};
+  std::unique_ptr<folly::AsyncTimeout> overBudgetTimeout_;
+
   struct SendWritesCallback : public folly::EventBase::LoopCallback {
     explicit SendWritesCallback(McServerSession& session) : session_(session) {}
+    void runLoopCallback() noexcept final;
+    McServerSession& session_;
+    bool rescheduled_{false};
+  };
+
+  SendWritesCallback sendWritesCallback_;
+
+  /**
+   * Requests handed to the application in this loop iteration, see
+   * options_.maxRequestsPerLoop.
+   */
+  size_t requestsThisLoop_{0};
+  // True iff parsing is put off until the end of this loop iteration.
+  bool readsDeferred_{false};
+
+  struct FairShareCallback : public folly::EventBase::LoopCallback {
+    explicit FairShareCallback(McServerSession& session)
+        : session_(session) {}
     void runLoopCallback() noexcept final {
-      session_.sendWrites();
+      session_.onLoopEnd();
     }
     McServerSession& session_;
   };
 
-  SendWritesCallback sendWritesCallback_;
+  FairShareCallback fairShareCallback_;
 
   /* OR-able bits of pauseState_ */
   enum PauseReason : uint64_t {
     PAUSE_THROTTLED = 1 << 0,
     PAUSE_WRITE = 1 << 1,
     PAUSE_USER = 1 << 2,
+    PAUSE_OVER_BUDGET = 1 << 3,
+    PAUSE_FAIR_SHARE = 1 << 4,
   };
 
   /* Reads are enabled iff pauseState_ == 0 */
@@ -254,13 +369,13 @@ class McServerSession : public folly::DelayedDestruction,
 
   /* headReqid_ <= tailReqid_.  Since we must output replies sequentially,
      headReqid_ tracks the last reply id we're allowed to sent out.
-     Out of order replies are stalled in the blockedReplies_ queue. */
+     Out of order replies are stalled in the blockedReplies_ ring. */
   uint64_t headReqid_{0}; /**< Id of next unblocked reply */
   uint64_t tailReqid_{0}; /**< Id to assign to next request */
-  std::unordered_map<uint64_t, std::unique_ptr<WriteBuffer>> blockedReplies_;
+  ReplyReorderBuffer<std::unique_ptr<WriteBuffer>> blockedReplies_;
 
   /* If non-null, a multi-op operation is being parsed.*/
-  std::shared_ptr<MultiOpParent> currentMultiop_;
+  std::unique_ptr<MultiOpParent, MultiOpParentDeleter> currentMultiop_;
 
   folly::SocketAddress socketAddress_;
 
@@ -270,10 +385,21 @@ class McServerSession : public folly::DelayedDestruction,
    */
   std::string clientCommonName_;
 
+  /**
+   * Credentials of the peer process, if this session is over
+   * a unix domain socket.
+   */
+  folly::Optional<struct ucred> peerCredentials_;
+
   void* userCtxt_{nullptr};
 
   std::unique_ptr<folly::AsyncTimeout> goAwayTimeout_;
 
+  /**
+   * Reads the peer's credentials off a unix domain socket.
+   */
+  void initPeerCredentials();
+
   /**
    * pause()/resume() reads from the socket (TODO: does not affect the already
    * read buffer - requests in it will still be processed).
@@ -289,6 +415,12 @@ class McServerSession : public folly::DelayedDestruction,
    */
   void sendWrites();
 
+  /**
+   * @return  chain to be written with MSG_ZEROCOPY if wb is big enough,
+   *          nullptr otherwise.
+   */
+  std::unique_ptr<folly::IOBuf> zeroCopyChain(const WriteBuffer& wb) const;
+
   /**
    * Check if no outstanding transactions, and close socket and
    * call onCloseFinish_() if so.
@@ -321,6 +453,16 @@ class McServerSession : public folly::DelayedDestruction,
   void caretRequestReady(
       const UmbrellaMessageInfo& headerInfo,
       const folly::IOBuf& reqBody);
+  void dispatchCaretRequest(
+      const UmbrellaMessageInfo& headerInfo,
+      const folly::IOBuf& reqBody);
+  /**
+   * Uncompresses the body of a request compressed by the client.
+   * Throws if the codec is not available.
+   */
+  std::unique_ptr<folly::IOBuf> uncompressRequest(
+      const UmbrellaMessageInfo& headerInfo,
+      const folly::IOBuf& reqBody);
 
   void processConnectionControlMessage(const UmbrellaMessageInfo& headerInfo);
 
@@ -349,6 +491,9 @@ class McServerSession : public folly::DelayedDestruction,
 
   void completeWrite();
 
+  void writeNextFrame(FragmentedWrite& fw);
+  void frameWritten(FragmentedWrite& fw, bool success);
+
   /* TAsyncTransport's writeCallback */
   void writeSuccess() noexcept final;
   void writeErr(
@@ -368,6 +513,23 @@ class McServerSession : public folly::DelayedDestruction,
   void onTransactionStarted(bool isSubRequest);
   void onTransactionCompleted(bool isSubRequest);
 
+  /**
+   * Takes a token for a new request if the server is overloaded, pausing
+   * reads until the bucket refills if it ran dry.
+   */
+  void chargeOverloadBudget();
+
+  /**
+   * Defers parsing to the next loop iteration once this one has seen
+   * options_.maxRequestsPerLoop requests.
+   */
+  void countRequestThisLoop();
+
+  /**
+   * Resets the per-iteration request count and parses what was deferred.
+   */
+  void onLoopEnd();
+
   void writeToDebugFifo(const WriteBuffer* wb) noexcept;
 
   /**
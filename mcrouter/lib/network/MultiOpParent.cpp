@@ -7,12 +7,42 @@
  */
 #include "MultiOpParent.h"
 
+#include <algorithm>
+
 namespace facebook {
 namespace memcache {
 
+constexpr size_t MultiOpParent::kInlineStates;
+constexpr size_t MultiOpParent::kMaxBlockStates;
+
+void MultiOpParentDeleter::operator()(MultiOpParent* parent) const {
+  parent->removeRef();
+}
+
+std::unique_ptr<MultiOpParent, MultiOpParentDeleter> MultiOpParent::create(
+    McServerSession& session,
+    uint64_t blockReqid) {
+  return std::unique_ptr<MultiOpParent, MultiOpParentDeleter>(
+      new MultiOpParent(session, blockReqid));
+}
+
 MultiOpParent::MultiOpParent(McServerSession& session, uint64_t blockReqid)
     : session_(session), block_(session, blockReqid, true /* noReply */) {}
 
+MultiOpParent::AsciiState* MultiOpParent::allocateState() {
+  if (numStates_ < kInlineStates) {
+    return &inlineStates_[numStates_++];
+  }
+  if (blockUsed_ == blockSize_) {
+    blockSize_ = std::min(
+        blockSize_ == 0 ? 2 * kInlineStates : 2 * blockSize_, kMaxBlockStates);
+    blocks_.push_back(std::make_unique<AsciiState[]>(blockSize_));
+    blockUsed_ = 0;
+  }
+  ++numStates_;
+  return &blocks_.back()[blockUsed_++];
+}
+
 bool MultiOpParent::reply(
     mc_res_t result,
     uint32_t errorCode,
@@ -7,7 +7,11 @@
  */
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include <folly/Optional.h>
 
@@ -43,10 +47,21 @@ class McServerSession;
  * write anything to the transport (same as if 'noreply' was set).
  *
  * Finally the end context will write out the stored error reply.
+ *
+ * Allocation: the per-key state of the sub-request contexts (key, back
+ * pointer) is allocated by the parent, inline for the first few keys and
+ * then in growing blocks, and freed all at once with the parent. The parent
+ * is reference counted by the session and the sub-request contexts; all of
+ * them live in the session's thread, so the count is not atomic.
  */
 class MultiOpParent {
  public:
-  MultiOpParent(McServerSession& session, uint64_t blockReqid);
+  /**
+   * Creates a parent holding one reference, owned by the returned pointer.
+   */
+  static std::unique_ptr<MultiOpParent, MultiOpParentDeleter> create(
+      McServerSession& session,
+      uint64_t blockReqid);
 
   /**
    * Examine the reply result of one of the sub-requests. If it's an error
@@ -79,6 +94,12 @@ class MultiOpParent {
   }
 
  private:
+  using AsciiState = McServerRequestContext::AsciiState;
+
+  static constexpr size_t kInlineStates = 4;
+  static constexpr size_t kMaxBlockStates = 256;
+
+  size_t refs_{1};
   size_t waiting_{0};
   folly::Optional<McGetReply> reply_;
   bool error_{false};
@@ -87,7 +108,32 @@ class MultiOpParent {
   McServerRequestContext block_;
   folly::Optional<McServerRequestContext> end_;
 
+  std::array<AsciiState, kInlineStates> inlineStates_;
+  std::vector<std::unique_ptr<AsciiState[]>> blocks_;
+  size_t numStates_{0};
+  size_t blockSize_{0};
+  size_t blockUsed_{0};
+
+  MultiOpParent(McServerSession& session, uint64_t blockReqid);
+
   void release();
+
+  /**
+   * State of a new sub-request context, valid while this parent lives.
+   */
+  AsciiState* allocateState();
+
+  void addRef() {
+    ++refs_;
+  }
+  void removeRef() {
+    if (--refs_ == 0) {
+      delete this;
+    }
+  }
+
+  friend class McServerRequestContext;
+  friend struct MultiOpParentDeleter;
 };
 }
 } // facebook::memcache
@@ -0,0 +1,76 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+
+namespace facebook {
+namespace memcache {
+
+/**
+ * Token bucket of `budget` requests per second of one server session, only
+ * drained while the server is overloaded.
+ *
+ * Requests already read from the socket still go through once the bucket
+ * ran dry, putting it in debt. The debt is capped at one burst (`budget`
+ * tokens), so a session never waits more than a second for the bucket to
+ * refill, however many requests it had buffered.
+ */
+class OverloadBudget {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit OverloadBudget(double budget) : budget_(budget), tokens_(budget) {}
+
+  /**
+   * Refills the bucket, once the server is no longer overloaded: every
+   * session starts an overload with a full bucket.
+   */
+  void reset() {
+    tokens_ = budget_;
+    updated_ = Clock::time_point();
+  }
+
+  /**
+   * Takes a token for a new request.
+   *
+   * @return  0 if the request was within the budget, otherwise how long to
+   *          stop reading requests until the bucket is refilled.
+   */
+  std::chrono::milliseconds charge(Clock::time_point now) {
+    if (updated_ != Clock::time_point()) {
+      const std::chrono::duration<double> elapsed = now - updated_;
+      tokens_ = std::min(budget_, tokens_ + elapsed.count() * budget_);
+    }
+    updated_ = now;
+    tokens_ = std::max(-budget_, tokens_ - 1.0);
+    if (tokens_ >= 0.0) {
+      return std::chrono::milliseconds(0);
+    }
+    return std::chrono::milliseconds(
+        static_cast<int64_t>(std::ceil(-tokens_ * 1000 / budget_)));
+  }
+
+  /**
+   * @return  tokens left, negative if in debt.
+   */
+  double tokens() const {
+    return tokens_;
+  }
+
+ private:
+  const double budget_;
+  double tokens_;
+  Clock::time_point updated_;
+};
+
+} // memcache
+} // facebook
@@ -0,0 +1,118 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <folly/lang/Bits.h>
+
+namespace facebook {
+namespace memcache {
+
+/**
+ * Holds replies that completed before the replies to earlier requests, for
+ * protocols that must reply in request order.
+ *
+ * Request ids are consecutive, so a reply is stored in the slot
+ * (id mod capacity) of a ring buffer: as long as all ids that can be stored
+ * are within [head, head + capacity), where head is the id of the oldest
+ * request without a reply, every id has a slot of its own and inserts and
+ * takes are O(1) without hashing. The ring grows when a reply for an id
+ * further than capacity from head is inserted. Nothing is allocated until
+ * the first insert, so connections that never reorder replies don't pay
+ * for the ring.
+ *
+ * T must be default constructible, with the default value meaning
+ * "no reply" (e.g. std::unique_ptr).
+ */
+template <class T>
+class ReplyReorderBuffer {
+ public:
+  /**
+   * @param initialCapacity  size of the ring once allocated, e.g. the
+   *                         maximum number of requests in flight.
+   */
+  explicit ReplyReorderBuffer(size_t initialCapacity = kDefaultCapacity)
+      : initialCapacity_(folly::nextPowTwo(
+            initialCapacity < kMinCapacity ? kMinCapacity : initialCapacity)) {
+  }
+
+  ReplyReorderBuffer(const ReplyReorderBuffer&) = delete;
+  ReplyReorderBuffer& operator=(const ReplyReorderBuffer&) = delete;
+
+  size_t size() const {
+    return size_;
+  }
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  size_t capacity() const {
+    return slots_.empty() ? initialCapacity_ : slots_.size();
+  }
+
+  /**
+   * Stores the reply with the given id. head is the id of the oldest request
+   * without a reply; id must be greater than head and not stored yet.
+   */
+  void insert(uint64_t head, uint64_t id, T value) {
+    assert(id > head);
+    if (id - head >= slots_.size()) {
+      grow(head, std::max<uint64_t>(initialCapacity_, id - head + 1));
+    }
+    auto& slot = slots_[id & mask_];
+    assert(slot == T());
+    slot = std::move(value);
+    ++size_;
+  }
+
+  /**
+   * Removes the reply with the given id.
+   *
+   * @return  the reply, or T() if there's no reply with this id.
+   */
+  T take(uint64_t id) {
+    if (size_ == 0) {
+      return T();
+    }
+    auto& slot = slots_[id & mask_];
+    T value = std::move(slot);
+    slot = T();
+    if (value != T()) {
+      --size_;
+    }
+    return value;
+  }
+
+ private:
+  static constexpr size_t kDefaultCapacity = 16;
+  static constexpr size_t kMinCapacity = 8;
+
+  const size_t initialCapacity_;
+  std::vector<T> slots_;
+  size_t mask_{0};
+  size_t size_{0};
+
+  void grow(uint64_t head, uint64_t minCapacity) {
+    std::vector<T> old(folly::nextPowTwo(minCapacity));
+    old.swap(slots_);
+    mask_ = slots_.size() - 1;
+    for (uint64_t id = head; id < head + old.size(); ++id) {
+      slots_[id & mask_] = std::move(old[id & (old.size() - 1)]);
+    }
+  }
+};
+
+} // memcache
+} // facebook
@@ -35,6 +35,9 @@ struct ReplyStatsContext {
   uint32_t replySizeBeforeCompression{0};
   uint32_t replySizeAfterCompression{0};
   ServerLoad serverLoad{0};
+  // True iff the reply value couldn't be shared with the read buffer and had
+  // to be copied (e.g. it straddled the end of the buffer).
+  bool valueCopied{false};
 };
 
 } // memcache
@@ -167,11 +167,13 @@ template <class Callback>
 template <class Request>
 void ServerMcParser<Callback>::writeToPipe(const Request& req) {
   assert(debugFifo_);
+  if (!debugFifo_->startRequest(MessageDirection::Received, req)) {
+    return;
+  }
   AsciiSerializedRequest debugSerializedRequest;
   const struct iovec* iov;
   size_t iovLen;
   debugSerializedRequest.prepare(req, iov, iovLen);
-  debugFifo_->startMessage(MessageDirection::Received, Request::typeId);
   debugFifo_->writeData(iov, iovLen);
 }
 }
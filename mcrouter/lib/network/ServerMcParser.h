@@ -52,6 +52,28 @@ class ServerMcParser : private McParser::ParserCallback {
     return parser_.outOfOrder();
   }
 
+  /**
+   * See McParser::releaseReadBuffer().
+   */
+  size_t releaseReadBuffer() {
+    return parser_.releaseReadBuffer();
+  }
+
+  size_t readBufferCapacity() const {
+    return parser_.readBufferCapacity();
+  }
+
+  /**
+   * See McParser::pauseParsing() and McParser::resumeParsing().
+   */
+  void pauseParsing() {
+    parser_.pauseParsing();
+  }
+
+  bool resumeParsing() {
+    return parser_.resumeParsing();
+  }
+
   /**
    * @return error message from ascii parser about parsing error.
    */
@@ -0,0 +1,242 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include "SocketTakeover.h"
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+
+#include <folly/File.h>
+#include <folly/FileUtil.h>
+#include <folly/String.h>
+#include <glog/logging.h>
+
+#include "mcrouter/lib/fbi/cpp/util.h"
+
+namespace facebook {
+namespace memcache {
+
+namespace {
+
+// Most fds the kernel passes in one message (SCM_MAX_FD).
+constexpr size_t kMaxFds = 253;
+
+struct sockaddr_un makeAddress(const std::string& path) {
+  struct sockaddr_un addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  checkLogic(
+      path.size() < sizeof(addr.sun_path),
+      "Takeover socket path {} is too long",
+      path);
+  std::memcpy(addr.sun_path, path.data(), path.size());
+  return addr;
+}
+
+bool sendWithFds(
+    int fd,
+    const void* data,
+    size_t size,
+    const std::vector<int>& fds) {
+  struct iovec iov;
+  iov.iov_base = const_cast<void*>(data);
+  iov.iov_len = size;
+  struct msghdr msg;
+  std::memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+
+  std::vector<char> control(CMSG_SPACE(sizeof(int) * fds.size()));
+  if (!fds.empty()) {
+    msg.msg_control = control.data();
+    msg.msg_controllen = control.size();
+    auto* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+    std::memcpy(CMSG_DATA(cmsg), fds.data(), sizeof(int) * fds.size());
+  }
+  return ::sendmsg(fd, &msg, MSG_NOSIGNAL) == static_cast<ssize_t>(size);
+}
+
+/**
+ * @return  false if the message or its fds were truncated.
+ */
+bool receiveWithFds(int fd, void* data, size_t size, std::vector<int>& fds) {
+  struct iovec iov;
+  iov.iov_base = data;
+  iov.iov_len = size;
+  struct msghdr msg;
+  std::memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  std::vector<char> control(CMSG_SPACE(sizeof(int) * kMaxFds));
+  msg.msg_control = control.data();
+  msg.msg_controllen = control.size();
+
+  ssize_t received;
+  do {
+    received = ::recvmsg(fd, &msg, MSG_CMSG_CLOEXEC);
+  } while (received < 0 && errno == EINTR);
+
+  for (auto* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+       cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+      const size_t n = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+      const auto* begin = reinterpret_cast<const int*>(CMSG_DATA(cmsg));
+      fds.insert(fds.end(), begin, begin + n);
+    }
+  }
+  return received == static_cast<ssize_t>(size) &&
+      !(msg.msg_flags & MSG_CTRUNC);
+}
+
+} // anonymous
+
+folly::Optional<TakeoverSockets> requestTakeover(const std::string& path) {
+  const auto addr = makeAddress(path);
+  int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  checkRuntime(
+      fd >= 0, "Can not create socket: {}", folly::errnoStr(errno));
+  folly::File conn(fd, /* ownsFd */ true);
+
+  if (::connect(
+          fd, reinterpret_cast<const struct sockaddr*>(&addr), sizeof(addr)) !=
+      0) {
+    if (errno == ENOENT || errno == ECONNREFUSED) {
+      return folly::none;
+    }
+    throwRuntime(
+        "Can not connect to takeover socket {}: {}",
+        path,
+        folly::errnoStr(errno));
+  }
+
+  uint32_t counts[2];
+  std::vector<int> fds;
+  const bool received = receiveWithFds(fd, counts, sizeof(counts), fds);
+  if (!received || fds.size() != size_t{counts[0]} + counts[1]) {
+    for (auto receivedFd : fds) {
+      ::close(receivedFd);
+    }
+    throwRuntime("Malformed takeover message from {}", path);
+  }
+
+  TakeoverSockets sockets;
+  sockets.fds.assign(fds.begin(), fds.begin() + counts[0]);
+  sockets.sslFds.assign(fds.begin() + counts[0], fds.end());
+
+  // The old server stops accepting once it gets this.
+  const char ack = 1;
+  if (folly::writeFull(fd, &ack, 1) != 1) {
+    LOG(WARNING) << "Failed to acknowledge takeover through " << path << ": "
+                 << folly::errnoStr(errno);
+  }
+  LOG(INFO) << "Took over " << fds.size() << " listening sockets through "
+            << path;
+  return sockets;
+}
+
+TakeoverServer::TakeoverServer(
+    std::string path,
+    folly::Function<TakeoverSockets()> getSockets,
+    folly::Function<void()> onTakenOver)
+    : path_(std::move(path)),
+      getSockets_(std::move(getSockets)),
+      onTakenOver_(std::move(onTakenOver)) {
+  const auto addr = makeAddress(path_);
+  listenFd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  checkRuntime(
+      listenFd_ >= 0, "Can not create socket: {}", folly::errnoStr(errno));
+
+  std::remove(path_.c_str());
+  if (::bind(
+          listenFd_,
+          reinterpret_cast<const struct sockaddr*>(&addr),
+          sizeof(addr)) != 0 ||
+      // Whoever connects gets our listening sockets.
+      ::chmod(path_.c_str(), 0600) != 0 || ::listen(listenFd_, 1) != 0) {
+    auto error = folly::errnoStr(errno);
+    ::close(listenFd_);
+    throwRuntime("Can not listen on takeover socket {}: {}", path_, error);
+  }
+
+  thread_ = std::thread([this]() { serve(); });
+}
+
+TakeoverServer::~TakeoverServer() {
+  stopping_ = true;
+  // Wakes up accept().
+  ::shutdown(listenFd_, SHUT_RDWR);
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  ::close(listenFd_);
+}
+
+void TakeoverServer::serve() {
+  while (!stopping_) {
+    int fd = ::accept4(listenFd_, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) {
+        continue;
+      }
+      if (!stopping_) {
+        LOG(ERROR) << "Takeover socket " << path_
+                   << " failed: " << folly::errnoStr(errno);
+      }
+      return;
+    }
+    folly::File conn(fd, /* ownsFd */ true);
+    if (handOver(fd)) {
+      onTakenOver_();
+      return;
+    }
+  }
+}
+
+bool TakeoverServer::handOver(int fd) {
+  struct ucred cred;
+  socklen_t credLen = sizeof(cred);
+  if (::getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &credLen) != 0 ||
+      cred.uid != ::geteuid()) {
+    LOG(WARNING) << "Rejected takeover request through " << path_
+                 << " from another user";
+    return false;
+  }
+
+  auto sockets = getSockets_();
+  const uint32_t counts[2] = {static_cast<uint32_t>(sockets.fds.size()),
+                              static_cast<uint32_t>(sockets.sslFds.size())};
+  auto fds = std::move(sockets.fds);
+  fds.insert(fds.end(), sockets.sslFds.begin(), sockets.sslFds.end());
+  if (fds.size() > kMaxFds) {
+    LOG(ERROR) << "Too many listening sockets to hand over: " << fds.size();
+    return false;
+  }
+  if (!sendWithFds(fd, counts, sizeof(counts), fds)) {
+    LOG(ERROR) << "Failed to hand over listening sockets through " << path_
+               << ": " << folly::errnoStr(errno);
+    return false;
+  }
+
+  char ack;
+  if (folly::readFull(fd, &ack, 1) != 1) {
+    LOG(ERROR) << "Takeover through " << path_ << " was not acknowledged";
+    return false;
+  }
+  LOG(INFO) << "Listening sockets were taken over through " << path_;
+  return true;
+}
+
+} // memcache
+} // facebook
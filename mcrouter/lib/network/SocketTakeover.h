@@ -0,0 +1,86 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <folly/Function.h>
+#include <folly/Optional.h>
+
+namespace facebook {
+namespace memcache {
+
+/**
+ * Listening sockets of a server.
+ */
+struct TakeoverSockets {
+  std::vector<int> fds;
+  std::vector<int> sslFds;
+};
+
+/**
+ * Takes over the listening sockets of the server process that serves
+ * takeover requests on the unix socket at path (see TakeoverServer).
+ * Once this returns, the old process stops accepting connections. Connections
+ * that arrive meanwhile wait in the listen backlog for the caller to accept
+ * them.
+ *
+ * @return  none if nothing listens at path.
+ * @throws std::runtime_error  if the takeover failed midway.
+ */
+folly::Optional<TakeoverSockets> requestTakeover(const std::string& path);
+
+/**
+ * Serves a single takeover request on a unix socket, from its own thread.
+ *
+ * Takeover protocol: the new process connects and receives the number of
+ * plain and SSL fds (two uint32_t) with all the fds attached (SCM_RIGHTS).
+ * It replies with one byte once it owns them, after which onTakenOver is
+ * called and the server stops.
+ */
+class TakeoverServer {
+ public:
+  /**
+   * Starts listening on path, replacing whatever was there.
+   *
+   * @param getSockets   called on the takeover thread for every request.
+   * @param onTakenOver  called on the takeover thread after the sockets were
+   *                     handed over, e.g. to gracefully shut down.
+   *
+   * @throws std::runtime_error  if listening on path fails.
+   */
+  TakeoverServer(
+      std::string path,
+      folly::Function<TakeoverSockets()> getSockets,
+      folly::Function<void()> onTakenOver);
+
+  /**
+   * Stops serving (unless already taken over) and joins the thread.
+   */
+  ~TakeoverServer();
+
+  TakeoverServer(const TakeoverServer&) = delete;
+  TakeoverServer& operator=(const TakeoverServer&) = delete;
+
+ private:
+  const std::string path_;
+  folly::Function<TakeoverSockets()> getSockets_;
+  folly::Function<void()> onTakenOver_;
+  int listenFd_{-1};
+  std::atomic<bool> stopping_{false};
+  std::thread thread_;
+
+  void serve();
+  bool handOver(int fd);
+};
+
+} // memcache
+} // facebook
@@ -7,6 +7,7 @@
  */
 #include "ThreadLocalSSLContextProvider.h"
 
+#include <atomic>
 #include <unordered_map>
 
 #include <folly/Singleton.h>
@@ -39,10 +40,12 @@ struct CertPaths {
   folly::StringPiece pemKeyPath;
   folly::StringPiece pemCaPath;
   bool isClient;
+  bool ktls;
 
   bool operator==(const CertPaths& other) const {
     return pemCertPath == other.pemCertPath && pemKeyPath == other.pemKeyPath &&
-        pemCaPath == other.pemCaPath && isClient == other.isClient;
+        pemCaPath == other.pemCaPath && isClient == other.isClient &&
+        ktls == other.ktls;
   }
 };
 
@@ -59,7 +62,11 @@ struct ContextInfo {
 struct CertPathsHasher {
   size_t operator()(const CertPaths& paths) const {
     return folly::Hash()(
-        paths.pemCertPath, paths.pemKeyPath, paths.pemCaPath, paths.isClient);
+        paths.pemCertPath,
+        paths.pemKeyPath,
+        paths.pemCaPath,
+        paths.isClient,
+        paths.ktls);
   }
 };
 
@@ -133,6 +140,31 @@ bool configureSSLContext(
   return true;
 }
 
+/**
+ * Asks OpenSSL to switch connections created from this context to kernel TLS
+ * (TLS_TX/TLS_RX) once the handshake is done. Connections using ciphers that
+ * the kernel doesn't support silently stay in userspace.
+ */
+void enableKernelTls(folly::SSLContext& sslContext) {
+#ifdef SSL_OP_ENABLE_KTLS
+  try {
+    sslContext.setOptions(SSL_OP_ENABLE_KTLS);
+  } catch (const std::runtime_error& ex) {
+    LOG_FAILURE(
+        "SSLCert",
+        failure::Category::kSystemError,
+        "Failed to apply SSL_OP_ENABLE_KTLS flag onto SSLContext: {}",
+        ex.what());
+  }
+#else
+  (void)sslContext;
+  LOG_FAILURE(
+      "SSLCert",
+      failure::Category::kBadEnvironment,
+      "Kernel TLS was requested, but OpenSSL was built without kTLS support");
+#endif
+}
+
 using TicketCacheLayer = wangle::LRUPersistentCache<
     std::string,
     wangle::SSLSessionCacheData,
@@ -151,12 +183,15 @@ class SSLTicketCache
   }
 };
 
-// global thread safe ticket cache
+std::atomic<size_t> ticketCacheCapacity{100};
+std::atomic<bool> ticketCacheCreated{false};
+
+// global thread safe ticket cache, shared by clients on all threads
 // TODO(jmswen) Try to come up with a cleaner approach here that doesn't require
 // leaking.
 folly::LeakySingleton<SSLTicketCache> ticketCache([] {
-  // create cache layer of max size 100;
-  auto cacheLayer = std::make_shared<TicketCacheLayer>(100);
+  ticketCacheCreated = true;
+  auto cacheLayer = std::make_shared<TicketCacheLayer>(ticketCacheCapacity);
   return new SSLTicketCache(std::move(cacheLayer));
 });
 
@@ -214,12 +249,29 @@ std::shared_ptr<SSLContext> createClientSSLContext(
 
 } // anonymous
 
+void setClientSSLSessionCacheCapacity(size_t capacity) {
+  if (ticketCacheCreated) {
+    if (capacity != ticketCacheCapacity) {
+      LOG_FAILURE(
+          "SSLCert",
+          failure::Category::kInvalidOption,
+          "Client SSL session cache is already created with capacity {}, "
+          "ignoring new capacity {}",
+          ticketCacheCapacity.load(),
+          capacity);
+    }
+    return;
+  }
+  ticketCacheCapacity = capacity;
+}
+
 std::shared_ptr<SSLContext> getSSLContext(
     folly::StringPiece pemCertPath,
     folly::StringPiece pemKeyPath,
     folly::StringPiece pemCaPath,
     folly::Optional<wangle::TLSTicketKeySeeds> ticketKeySeeds,
-    bool clientContext) {
+    bool clientContext,
+    bool enableKtls) {
   static constexpr std::chrono::minutes kSslReloadInterval{30};
   thread_local std::unordered_map<CertPaths, ContextInfo, CertPathsHasher>
       localContexts;
@@ -229,6 +281,7 @@ std::shared_ptr<SSLContext> getSSLContext(
   paths.pemKeyPath = pemKeyPath;
   paths.pemCaPath = pemCaPath;
   paths.isClient = clientContext;
+  paths.ktls = enableKtls;
 
   auto iter = localContexts.find(paths);
   if (localContexts.find(paths) == localContexts.end()) {
@@ -254,6 +307,9 @@ std::shared_ptr<SSLContext> getSSLContext(
         : createServerSSLContext(
               pemCertPath, pemKeyPath, pemCaPath, std::move(ticketKeySeeds));
     if (updated) {
+      if (enableKtls) {
+        enableKernelTls(*updated);
+      }
       contextInfo.lastLoadTime = now;
       contextInfo.context = std::move(updated);
     }
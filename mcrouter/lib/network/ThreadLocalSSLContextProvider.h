@@ -47,13 +47,25 @@ class ClientSSLContext : public folly::SSLContext {
  * Manages sets of certificates on per thread basis.
  * Each set will be loaded only once per thread and will be reloaded if it's
  * older than 5 minutes.
+ *
+ * If enableKtls is true, connections using the context are switched to kernel
+ * TLS after the handshake (when supported by OpenSSL and the kernel).
  */
 std::shared_ptr<folly::SSLContext> getSSLContext(
     folly::StringPiece pemCertPath,
     folly::StringPiece pemKeyPath,
     folly::StringPiece pemCaPath,
     folly::Optional<wangle::TLSTicketKeySeeds> = folly::none,
-    bool clientContext = false);
+    bool clientContext = false,
+    bool enableKtls = false);
+
+/**
+ * Sets the number of SSL sessions kept in the client session cache. The cache
+ * is shared by all threads and keyed by destination's service identity, so a
+ * session established by any thread can be resumed by the others.
+ * Has to be called before the first client SSL context is created.
+ */
+void setClientSSLSessionCacheCapacity(size_t capacity);
 
 } // memcache
 } // facebook
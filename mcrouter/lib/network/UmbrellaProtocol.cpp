@@ -14,6 +14,7 @@
 #include <folly/io/IOBuf.h>
 #include <folly/lang/Bits.h>
 
+#include "mcrouter/lib/carbon/Util.h"
 #include "mcrouter/lib/mc/umbrella.h"
 #include "mcrouter/lib/network/ServerLoad.h"
 
@@ -77,6 +78,11 @@ void resetAdditionalFields(UmbrellaMessageInfo& info) {
   info.uncompressedBodySize = 0;
   info.dropProbability = 0;
   info.serverLoad = ServerLoad::zero();
+  info.timeoutBudgetMs = 0;
+  info.creditWindow = 0;
+  info.moreFragments = 0;
+  info.acceptsFragments = 0;
+  info.batchSize = 0;
 }
 
 size_t getNumAdditionalFields(const UmbrellaMessageInfo& info) {
@@ -105,6 +111,21 @@ size_t getNumAdditionalFields(const UmbrellaMessageInfo& info) {
   if (!info.serverLoad.isZero()) {
     ++nAdditionalFields;
   }
+  if (info.timeoutBudgetMs != 0) {
+    ++nAdditionalFields;
+  }
+  if (info.creditWindow != 0) {
+    ++nAdditionalFields;
+  }
+  if (info.moreFragments != 0) {
+    ++nAdditionalFields;
+  }
+  if (info.acceptsFragments != 0) {
+    ++nAdditionalFields;
+  }
+  if (info.batchSize != 0) {
+    ++nAdditionalFields;
+  }
   return nAdditionalFields;
 }
 
@@ -151,10 +172,40 @@ size_t serializeAdditionalFields(
       buf, CaretAdditionalFieldType::DROP_PROBABILITY, info.dropProbability);
   buf += serializeAdditionalFieldIfNonZero(
       buf, CaretAdditionalFieldType::SERVER_LOAD, info.serverLoad.raw());
+  buf += serializeAdditionalFieldIfNonZero(
+      buf, CaretAdditionalFieldType::TIMEOUT_BUDGET_MS, info.timeoutBudgetMs);
+  buf += serializeAdditionalFieldIfNonZero(
+      buf, CaretAdditionalFieldType::CREDIT_WINDOW, info.creditWindow);
+  buf += serializeAdditionalFieldIfNonZero(
+      buf, CaretAdditionalFieldType::MORE_FRAGMENTS, info.moreFragments);
+  buf += serializeAdditionalFieldIfNonZero(
+      buf, CaretAdditionalFieldType::ACCEPTS_FRAGMENTS, info.acceptsFragments);
+  buf += serializeAdditionalFieldIfNonZero(
+      buf, CaretAdditionalFieldType::BATCH_SIZE, info.batchSize);
 
   return buf - destination;
 }
 
+/**
+ * Decodes a varint from the beginning of range and advances past it.
+ *
+ * @return  false if range ends before the varint does.
+ */
+bool decodeVarint(folly::StringPiece& range, uint64_t& value) {
+  if (range.size() >= sizeof(uint64_t)) {
+    if (auto len = carbon::util::decodeVarint8(
+            reinterpret_cast<const uint8_t*>(range.data()), value)) {
+      range.advance(len);
+      return true;
+    }
+  }
+  if (auto maybeValue = folly::tryDecodeVarint(range)) {
+    value = *maybeValue;
+    return true;
+  }
+  return false;
+}
+
 } // anonymous namespace
 
 UmbrellaParseStatus umbrellaParseHeader(
@@ -231,22 +282,14 @@ UmbrellaParseStatus caretParseHeader(
   // Additional fields are sequence of (key,value) pairs
   resetAdditionalFields(headerInfo);
   for (uint32_t i = 0; i < additionalFields; i++) {
-    size_t fieldType;
-    if (auto maybeFieldType = folly::tryDecodeVarint(range)) {
-      fieldType = *maybeFieldType;
-    } else {
-      return UmbrellaParseStatus::NOT_ENOUGH_DATA;
-    }
-
-    size_t fieldValue;
-    if (auto maybeFieldValue = folly::tryDecodeVarint(range)) {
-      fieldValue = *maybeFieldValue;
-    } else {
+    uint64_t fieldType;
+    uint64_t fieldValue;
+    if (!decodeVarint(range, fieldType) || !decodeVarint(range, fieldValue)) {
       return UmbrellaParseStatus::NOT_ENOUGH_DATA;
     }
 
     if (fieldType >
-        static_cast<uint64_t>(CaretAdditionalFieldType::SERVER_LOAD)) {
+        static_cast<uint64_t>(CaretAdditionalFieldType::BATCH_SIZE)) {
       // Additional Field Type not recognized, ignore.
       continue;
     }
@@ -276,6 +319,21 @@ UmbrellaParseStatus caretParseHeader(
       case CaretAdditionalFieldType::SERVER_LOAD:
         headerInfo.serverLoad = ServerLoad(fieldValue);
         break;
+      case CaretAdditionalFieldType::TIMEOUT_BUDGET_MS:
+        headerInfo.timeoutBudgetMs = fieldValue;
+        break;
+      case CaretAdditionalFieldType::CREDIT_WINDOW:
+        headerInfo.creditWindow = fieldValue;
+        break;
+      case CaretAdditionalFieldType::MORE_FRAGMENTS:
+        headerInfo.moreFragments = fieldValue;
+        break;
+      case CaretAdditionalFieldType::ACCEPTS_FRAGMENTS:
+        headerInfo.acceptsFragments = fieldValue;
+        break;
+      case CaretAdditionalFieldType::BATCH_SIZE:
+        headerInfo.batchSize = fieldValue;
+        break;
       }
   }
 
@@ -55,6 +55,7 @@ WriteBuffer::prepareTyped(
           compressionCodecMap,
           ctx_->getDropProbability(),
           ctx_->getServerLoad(),
+          ctx_->getCreditWindow(),
           iovsBegin_,
           iovsCount_);
 
@@ -92,6 +93,7 @@ WriteBuffer::prepareTyped(
       compressionCodecMap,
       ctx_->getDropProbability(),
       ctx_->getServerLoad(),
+      ctx_->getCreditWindow(),
       iovsBegin_,
       iovsCount_);
 }
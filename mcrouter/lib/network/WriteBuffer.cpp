@@ -78,6 +78,19 @@ void WriteBuffer::clear() {
   }
 }
 
+const folly::IOBuf* WriteBuffer::valueBuf() const {
+  switch (protocol_) {
+    case mc_ascii_protocol:
+      return asciiReply_.valueBuf();
+
+    case mc_caret_protocol:
+      return caretReply_.valueBuf();
+
+    default:
+      return nullptr;
+  }
+}
+
 bool WriteBuffer::noReply() const {
   return ctx_.hasValue() && ctx_->hasParent() && ctx_->parent().error();
 }
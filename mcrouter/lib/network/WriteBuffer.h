@@ -97,6 +97,12 @@ class WriteBuffer {
    */
   bool noReply() const;
 
+  /**
+   * @return  IOBuf holding the value of the serialized reply, if the reply
+   *          references it without copying. Used for zero-copy writes.
+   */
+  const folly::IOBuf* valueBuf() const;
+
   bool isSubRequest() const;
   bool isEndContext() const;
 
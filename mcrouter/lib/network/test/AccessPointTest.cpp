@@ -160,4 +160,38 @@ TEST(AccessPoint, port_override) {
   EXPECT_TRUE(ap->useSsl());
 }
 
+TEST(AccessPoint, intern) {
+  auto proto = mc_caret_protocol;
+  auto ap1 = AccessPoint::create("127.0.0.1:12345", proto);
+  auto ap2 = AccessPoint::create("127.0.0.1:12345", proto);
+  auto ap3 = AccessPoint::create("127.0.0.1:12345", proto, true /* ssl */);
+  ASSERT_TRUE(ap1 && ap2 && ap3);
+  EXPECT_EQ(*ap1, *ap2);
+  EXPECT_NE(*ap1, *ap3);
+
+  auto interned1 = AccessPoint::intern(*ap1);
+  auto interned2 = AccessPoint::intern(*ap2);
+  auto interned3 = AccessPoint::intern(*ap3);
+  EXPECT_EQ(interned1, interned2);
+  EXPECT_NE(interned1, interned3);
+  EXPECT_EQ(*ap1, *interned1);
+  EXPECT_EQ(*ap3, *interned3);
+
+  // Interned copy doesn't change with the original.
+  auto compressed = AccessPoint::create(
+      "127.0.0.1:12345", proto, false, 0, true /* compressed */);
+  auto internedCompressed = AccessPoint::intern(*compressed);
+  EXPECT_NE(interned1, internedCompressed);
+  compressed->disableCompression();
+  EXPECT_TRUE(internedCompressed->compressed());
+  EXPECT_EQ(interned1, AccessPoint::intern(*compressed));
+
+  // Released AccessPoints are interned again.
+  interned1.reset();
+  interned2.reset();
+  auto reinterned = AccessPoint::intern(*ap2);
+  EXPECT_EQ(*ap2, *reinterned);
+  EXPECT_EQ(reinterned, AccessPoint::intern(*ap2));
+}
+
 } // anonymous
@@ -0,0 +1,92 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <sys/uio.h>
+
+#include <folly/Benchmark.h>
+#include <folly/Optional.h>
+#include <folly/init/Init.h>
+#include <folly/io/IOBuf.h>
+
+#include "mcrouter/lib/network/AsciiSerialized.h"
+#include "mcrouter/lib/network/gen/Memcache.h"
+
+using namespace facebook::memcache;
+
+namespace {
+
+template <class Reply, class MakeReply>
+void serializeReplies(size_t iters, MakeReply makeReply) {
+  AsciiSerializedReply serialized;
+  folly::Optional<folly::IOBuf> key;
+  BENCHMARK_SUSPEND {
+    key.emplace(folly::IOBuf::COPY_BUFFER, "someprefix:somekey:1234567");
+  }
+  const struct iovec* iov;
+  size_t niov;
+  for (size_t i = 0; i < iters; ++i) {
+    Reply reply = makeReply();
+    serialized.prepare(std::move(reply), key, iov, niov);
+    folly::doNotOptimizeAway(iov);
+    serialized.clear();
+  }
+}
+
+folly::IOBuf value() {
+  static const folly::IOBuf kValue(
+      folly::IOBuf::COPY_BUFFER, std::string(100, 'v'));
+  return kValue;
+}
+
+} // anonymous namespace
+
+BENCHMARK(get_hit, iters) {
+  serializeReplies<McGetReply>(iters, []() {
+    McGetReply reply(mc_res_found);
+    reply.value() = value();
+    reply.flags() = 123;
+    return reply;
+  });
+}
+
+BENCHMARK(gets_hit, iters) {
+  serializeReplies<McGetsReply>(iters, []() {
+    McGetsReply reply(mc_res_found);
+    reply.value() = value();
+    reply.flags() = 123;
+    reply.casToken() = 1234567890;
+    return reply;
+  });
+}
+
+BENCHMARK(lease_get_hit, iters) {
+  serializeReplies<McLeaseGetReply>(iters, []() {
+    McLeaseGetReply reply(mc_res_found);
+    reply.value() = value();
+    reply.flags() = 123;
+    return reply;
+  });
+}
+
+BENCHMARK(lease_get_miss, iters) {
+  serializeReplies<McLeaseGetReply>(iters, []() {
+    McLeaseGetReply reply(mc_res_notfound);
+    reply.leaseToken() = 1234567890;
+    return reply;
+  });
+}
+
+BENCHMARK(set_stored, iters) {
+  serializeReplies<McSetReply>(
+      iters, []() { return McSetReply(mc_res_stored); });
+}
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv, true /* removeFlags */);
+  folly::runBenchmarks();
+  return 0;
+}
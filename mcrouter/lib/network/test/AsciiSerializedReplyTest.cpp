@@ -0,0 +1,91 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <sys/uio.h>
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <folly/Optional.h>
+#include <folly/io/IOBuf.h>
+
+#include "mcrouter/lib/network/AsciiSerialized.h"
+#include "mcrouter/lib/network/gen/Memcache.h"
+
+using namespace facebook::memcache;
+
+namespace {
+
+template <class Reply>
+std::string serialize(Reply reply, const std::string& key, size_t& niov) {
+  AsciiSerializedReply serialized;
+  folly::Optional<folly::IOBuf> keyBuf(
+      folly::IOBuf(folly::IOBuf::COPY_BUFFER, key));
+  const struct iovec* iov;
+  EXPECT_TRUE(serialized.prepare(std::move(reply), keyBuf, iov, niov));
+  std::string result;
+  for (size_t i = 0; i < niov; ++i) {
+    result.append(static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
+  }
+  return result;
+}
+
+template <class Reply>
+Reply makeHit(folly::StringPiece value, uint64_t flags) {
+  Reply reply(mc_res_found);
+  reply.value() = folly::IOBuf(folly::IOBuf::COPY_BUFFER, value);
+  reply.flags() = flags;
+  return reply;
+}
+
+} // anonymous namespace
+
+TEST(AsciiSerializedReply, getHit) {
+  size_t niov;
+  EXPECT_EQ(
+      "VALUE key 5 3\r\nabc\r\n",
+      serialize(makeHit<McGetReply>("abc", 5), "key", niov));
+  // Header, value, trailer.
+  EXPECT_EQ(3, niov);
+
+  EXPECT_EQ(
+      "VALUE key 18446744073709551615 0\r\n\r\n",
+      serialize(makeHit<McGetReply>("", uint64_t(-1)), "key", niov));
+}
+
+TEST(AsciiSerializedReply, getHitLongKey) {
+  const std::string key(200, 'k');
+  size_t niov;
+  EXPECT_EQ(
+      "VALUE " + key + " 0 3\r\nabc\r\n",
+      serialize(makeHit<McGetReply>("abc", 0), key, niov));
+  // The key doesn't fit into the header buffer and gets its own iovec.
+  EXPECT_EQ(5, niov);
+}
+
+TEST(AsciiSerializedReply, getsHit) {
+  auto reply = makeHit<McGetsReply>("abc", 1);
+  reply.casToken() = 1234567890123;
+  size_t niov;
+  EXPECT_EQ(
+      "VALUE key 1 3 1234567890123\r\nabc\r\n",
+      serialize(std::move(reply), "key", niov));
+  EXPECT_EQ(3, niov);
+}
+
+TEST(AsciiSerializedReply, leaseGet) {
+  size_t niov;
+  EXPECT_EQ(
+      "VALUE key 2 1\r\na\r\n",
+      serialize(makeHit<McLeaseGetReply>("a", 2), "key", niov));
+
+  McLeaseGetReply miss(mc_res_notfound);
+  miss.leaseToken() = 42;
+  EXPECT_EQ(
+      "LVALUE key 42 0 0\r\n\r\n", serialize(std::move(miss), "key", niov));
+}
@@ -0,0 +1,133 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <sys/uio.h>
+
+#include <memory>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <folly/io/IOBuf.h>
+
+#include "mcrouter/lib/CompressionCodecManager.h"
+#include "mcrouter/lib/network/McSerializedRequest.h"
+#include "mcrouter/lib/network/gen/Memcache.h"
+
+using namespace facebook::memcache;
+
+namespace {
+
+std::string toString(const McSerializedRequest& serialized) {
+  std::string result;
+  for (size_t i = 0; i < serialized.getIovsCount(); ++i) {
+    const auto& iov = serialized.getIovs()[i];
+    result.append(static_cast<const char*>(iov.iov_base), iov.iov_len);
+  }
+  return result;
+}
+
+folly::IOBuf makeChain(size_t numBufs, char c) {
+  folly::IOBuf chain;
+  for (size_t i = 0; i < numBufs; ++i) {
+    auto buf = folly::IOBuf::copyBuffer(std::string(10, c + i));
+    if (i == 0) {
+      chain = std::move(*buf);
+    } else {
+      chain.prependChain(std::move(buf));
+    }
+  }
+  return chain;
+}
+
+} // anonymous namespace
+
+TEST(AsciiSerializedRequest, chainedValueIsNotCoalesced) {
+  McSetRequest req("key");
+  req.value() = makeChain(3, 'a');
+  req.exptime() = 5;
+
+  McSerializedRequest serialized(
+      req, 0, mc_ascii_protocol, CodecIdRange::Empty);
+  ASSERT_EQ(McSerializedRequest::Result::OK, serialized.serializationResult());
+  EXPECT_EQ(
+      "set key 0 5 30\r\n"
+      "aaaaaaaaaabbbbbbbbbbcccccccccc\r\n",
+      toString(serialized));
+  EXPECT_TRUE(req.value().isChained());
+
+  // The value is referenced, not copied.
+  bool found = false;
+  for (size_t i = 0; i < serialized.getIovsCount(); ++i) {
+    found = found || serialized.getIovs()[i].iov_base == req.value().data();
+  }
+  EXPECT_TRUE(found);
+}
+
+TEST(AsciiSerializedRequest, longChainIsCoalesced) {
+  McLeaseSetRequest req("key");
+  req.value() = makeChain(20, 'a');
+  req.leaseToken() = 7;
+
+  McSerializedRequest serialized(
+      req, 0, mc_ascii_protocol, CodecIdRange::Empty);
+  ASSERT_EQ(McSerializedRequest::Result::OK, serialized.serializationResult());
+
+  std::string value;
+  for (size_t i = 0; i < 20; ++i) {
+    value.append(10, 'a' + i);
+  }
+  EXPECT_EQ(
+      "lease-set key 7 0 0 200\r\n" + value + "\r\n", toString(serialized));
+}
+
+TEST(AsciiSerializedRequest, emptyValue) {
+  McSetRequest req("key");
+
+  McSerializedRequest serialized(
+      req, 0, mc_ascii_protocol, CodecIdRange::Empty);
+  ASSERT_EQ(McSerializedRequest::Result::OK, serialized.serializationResult());
+  EXPECT_EQ("set key 0 0 0\r\n\r\n", toString(serialized));
+}
+
+TEST(AsciiSerializedRequest, metaCommands) {
+  auto serialize = [](const auto& req) {
+    McSerializedRequest serialized(
+        req, 0, mc_meta_protocol, CodecIdRange::Empty);
+    EXPECT_EQ(
+        McSerializedRequest::Result::OK, serialized.serializationResult());
+    return toString(serialized);
+  };
+
+  EXPECT_EQ("mg key v f\r\n", serialize(McGetRequest("key")));
+  EXPECT_EQ("mg key v f c\r\n", serialize(McGetsRequest("key")));
+
+  McSetRequest set("key");
+  set.value() = folly::IOBuf(folly::IOBuf::COPY_BUFFER, "value");
+  set.flags() = 3;
+  set.exptime() = -1;
+  EXPECT_EQ("ms key 5 F3 T-1\r\nvalue\r\n", serialize(set));
+
+  McAddRequest add("key");
+  add.value() = folly::IOBuf(folly::IOBuf::COPY_BUFFER, "value");
+  EXPECT_EQ("ms key 5 F0 T0 ME\r\nvalue\r\n", serialize(add));
+
+  McCasRequest cas("key");
+  cas.value() = folly::IOBuf(folly::IOBuf::COPY_BUFFER, "value");
+  cas.casToken() = 7;
+  EXPECT_EQ("ms key 5 F0 T0 C7\r\nvalue\r\n", serialize(cas));
+
+  EXPECT_EQ("md key\r\n", serialize(McDeleteRequest("key")));
+  McDeleteRequest del("key");
+  del.exptime() = 10;
+  EXPECT_EQ("delete key 10\r\n", serialize(del));
+
+  // No meta command, the classic one is used.
+  McIncrRequest incr("key");
+  incr.delta() = 2;
+  EXPECT_EQ("incr key 2\r\n", serialize(incr));
+}
@@ -5,16 +5,23 @@
  *  file in the root directory of this source tree.
  *
  */
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include <gtest/gtest.h>
 
+#include <folly/Executor.h>
 #include <folly/FileUtil.h>
+#include <folly/Format.h>
 #include <folly/ScopeGuard.h>
 #include <folly/fibers/EventBaseLoopController.h>
 #include <folly/fibers/FiberManager.h>
 #include <folly/io/async/EventBase.h>
 
+#include "mcrouter/lib/CompressionCodecManager.h"
+#include "mcrouter/lib/CompressionOffload.h"
 #include "mcrouter/lib/network/McSSLUtil.h"
 #include "mcrouter/lib/network/ThreadLocalSSLContextProvider.h"
 #include "mcrouter/lib/network/gen/Memcache.h"
@@ -295,6 +302,215 @@ TEST(AsyncMcClient, outstandingThrottleSsl) {
   outstandingThrottleTest(validClientSsl());
 }
 
+TEST(AsyncMcClient, lowPriorityPending) {
+  TestServer::Config config;
+  config.outOfOrder = false;
+  auto server = TestServer::create(std::move(config));
+  TestClient client(
+      "localhost", server->getListenPort(), 200, mc_ascii_protocol);
+  // One request at a time, so that the rest waits in the pending queue.
+  client.setThrottle(1, 0);
+  std::vector<std::string> replied;
+  auto sendGet = [&](std::string key, bool lowPriority) {
+    client.sendGet(
+        key,
+        mc_res_found,
+        200,
+        [&replied, key](const ReplyStatsContext&) { replied.push_back(key); },
+        lowPriority);
+  };
+  sendGet("async1", true /* lowPriority */);
+  sendGet("async2", true /* lowPriority */);
+  sendGet("critical1", false /* lowPriority */);
+  sendGet("critical2", false /* lowPriority */);
+  client.waitForReplies();
+  EXPECT_EQ(
+      std::vector<std::string>({"critical1", "critical2", "async1", "async2"}),
+      replied);
+  client.sendGet("shutdown", mc_res_notfound);
+  client.waitForReplies();
+  server->join();
+}
+
+TEST(AsyncMcClient, caretCreditWindow) {
+  TestServer::Config config;
+  config.outOfOrder = false;
+  config.useSsl = false;
+  config.maxInflight = 2;
+  auto server = TestServer::create(std::move(config));
+  TestClient client(
+      "localhost", server->getListenPort(), 200, mc_caret_protocol, noSsl());
+  // The first reply advertises the server's window.
+  client.sendGet("test", mc_res_found);
+  client.waitForReplies();
+  for (size_t i = 0; i < 5; ++i) {
+    client.sendGet("hold", mc_res_timeout);
+  }
+  client.waitForReplies();
+  EXPECT_EQ(2, client.getMaxInflightReqs());
+  client.sendGet("shutdown", mc_res_notfound);
+  client.waitForReplies();
+  server->join();
+  EXPECT_EQ(1, server->getAcceptedConns());
+}
+
+TEST(AsyncMcClient, caretRequestCompression) {
+  const std::string prefix = "tier:region:cluster:service:object_type:";
+  std::unordered_map<uint32_t, CodecConfigPtr> codecConfigs;
+  codecConfigs.emplace(
+      1, std::make_unique<CodecConfig>(1, CompressionCodecType::LZ4, prefix));
+  CompressionCodecManager codecManager(std::move(codecConfigs));
+
+  TestServer::Config config;
+  config.outOfOrder = false;
+  config.useSsl = false;
+  config.compressionCodecMap = codecManager.getCodecMap();
+  auto server = TestServer::create(std::move(config));
+  TestClient client(
+      "localhost",
+      server->getListenPort(),
+      200,
+      mc_caret_protocol,
+      noSsl(),
+      0 /* qosClass */,
+      0 /* qosPath */,
+      "" /* serviceIdentity */,
+      codecManager.getCodecMap(),
+      false /* enableTfo */,
+      true /* compressRequests */);
+  // The server replies with the key as the value.
+  for (size_t i = 0; i < 10; ++i) {
+    client.sendGet(folly::sformat("{}{}{}", prefix, prefix, i), mc_res_found);
+  }
+  client.sendGet("shutdown", mc_res_notfound);
+  client.waitForReplies();
+  server->join();
+  EXPECT_EQ(1, server->getAcceptedConns());
+}
+
+namespace {
+
+// Runs the offloaded work only when asked to.
+class QueuedExecutor : public folly::Executor {
+ public:
+  void add(folly::Func func) override {
+    funcs_.push_back(std::move(func));
+  }
+
+  size_t size() const {
+    return funcs_.size();
+  }
+
+  void runAll() {
+    auto funcs = std::move(funcs_);
+    funcs_.clear();
+    for (auto& func : funcs) {
+      func();
+    }
+  }
+
+ private:
+  std::vector<folly::Func> funcs_;
+};
+
+std::unique_ptr<CompressionCodecManager> makeLz4CodecManager() {
+  std::unordered_map<uint32_t, CodecConfigPtr> codecConfigs;
+  codecConfigs.emplace(
+      1, std::make_unique<CodecConfig>(1, CompressionCodecType::LZ4, ""));
+  return std::make_unique<CompressionCodecManager>(std::move(codecConfigs));
+}
+
+} // anonymous namespace
+
+TEST(AsyncMcClient, caretReplyDecompressionOffload) {
+  auto codecManager = makeLz4CodecManager();
+  QueuedExecutor executor;
+  CompressionOffload offload(*codecManager, 1 /* threshold */, &executor);
+
+  TestServer::Config config;
+  config.outOfOrder = false;
+  config.useSsl = false;
+  config.compressionCodecMap = codecManager->getCodecMap();
+  auto server = TestServer::create(std::move(config));
+  TestClient client(
+      "localhost",
+      server->getListenPort(),
+      200,
+      mc_caret_protocol,
+      noSsl(),
+      0 /* qosClass */,
+      0 /* qosPath */,
+      "" /* serviceIdentity */,
+      codecManager->getCodecMap(),
+      false /* enableTfo */,
+      false /* compressRequests */,
+      &offload);
+
+  // The reply is only delivered once it's uncompressed.
+  client.sendGet("value_size:10000", mc_res_found);
+  while (executor.size() == 0) {
+    client.loopOnce();
+  }
+  executor.runAll();
+  client.waitForReplies();
+  EXPECT_EQ(1, offload.numOffloaded());
+  EXPECT_EQ(10000, offload.bytesOffloaded());
+
+  client.sendGet("shutdown", mc_res_notfound);
+  client.waitForReplies();
+  server->join();
+  EXPECT_EQ(1, server->getAcceptedConns());
+}
+
+TEST(AsyncMcClient, caretReplyDecompressionOffloadAfterReconnect) {
+  auto codecManager = makeLz4CodecManager();
+  QueuedExecutor executor;
+  CompressionOffload offload(*codecManager, 1 /* threshold */, &executor);
+
+  TestServer::Config config;
+  config.outOfOrder = false;
+  config.useSsl = false;
+  config.compressionCodecMap = codecManager->getCodecMap();
+  auto server = TestServer::create(std::move(config));
+  TestClient client(
+      "localhost",
+      server->getListenPort(),
+      200,
+      mc_caret_protocol,
+      noSsl(),
+      0 /* qosClass */,
+      0 /* qosPath */,
+      "" /* serviceIdentity */,
+      codecManager->getCodecMap(),
+      false /* enableTfo */,
+      false /* compressRequests */,
+      &offload);
+
+  client.sendGet("value_size:10000", mc_res_aborted);
+  while (executor.size() == 0) {
+    client.loopOnce();
+  }
+  // The first request fails with its connection, and a new connection is
+  // up before its reply is uncompressed.
+  client.getClient().closeNow();
+  client.waitForReplies();
+  client.sendGet("value_size:20000", mc_res_found);
+  while (executor.size() < 2) {
+    client.loopOnce();
+  }
+
+  // The stale reply must not be delivered on the new connection, where it
+  // would be taken for (or break) the second request.
+  executor.runAll();
+  client.waitForReplies();
+  EXPECT_EQ(2, offload.numOffloaded());
+
+  client.sendGet("shutdown", mc_res_notfound);
+  client.waitForReplies();
+  server->join();
+  EXPECT_EQ(2, server->getAcceptedConns());
+}
+
 void connectionErrorTest(SSLContextProvider ssl) {
   TestServer::Config config;
   config.outOfOrder = false;
@@ -402,6 +618,50 @@ TEST(AsyncMcClient, qosClass4) {
   qosTest(mc_ascii_protocol, validClientSsl(), 4, 3);
 }
 
+TEST(AsyncMcClient, writesDoneCounts) {
+  TestServer::Config config;
+  config.outOfOrder = false;
+  config.useSsl = false;
+  auto server = TestServer::create(std::move(config));
+  TestClient client(
+      "localhost", server->getListenPort(), 200, mc_ascii_protocol);
+
+  size_t batches = 0;
+  size_t requests = 0;
+  size_t writes = 0;
+  client.getClient().setRequestStatusCallbacks(
+      nullptr,
+      [&](int numToSend) {
+        ++batches;
+        requests += numToSend;
+      },
+      [&](size_t numWrites) { writes += numWrites; });
+
+  // Small requests of one batch share a single write.
+  for (size_t i = 0; i < 10; ++i) {
+    client.sendGet("test" + std::to_string(i), mc_res_found);
+  }
+  client.waitForReplies();
+  EXPECT_EQ(10, requests);
+  EXPECT_GE(batches, 1);
+  EXPECT_EQ(batches, writes);
+
+  // Values that don't fit maxWriteBatchBytes together are split across
+  // several writes.
+  batches = requests = writes = 0;
+  const std::string value(16384, 'x');
+  for (size_t i = 0; i < 4; ++i) {
+    client.sendSet("key" + std::to_string(i), value, mc_res_stored);
+  }
+  client.waitForReplies();
+  EXPECT_EQ(4, requests);
+  EXPECT_GT(writes, batches);
+
+  client.sendGet("shutdown", mc_res_notfound);
+  client.waitForReplies();
+  server->join();
+}
+
 void reconnectTest(mc_protocol_t protocol) {
   auto bigValue = genBigValue();
 
@@ -5,9 +5,20 @@
  *  file in the root directory of this source tree.
  *
  */
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include <gtest/gtest.h>
 
+#include <folly/Format.h>
+
 #include "mcrouter/lib/network/McSSLUtil.h"
+#include "mcrouter/lib/network/test/ClientSocket.h"
 #include "mcrouter/lib/network/test/TestClientServerUtil.h"
 
 using namespace facebook::memcache;
@@ -80,3 +91,223 @@ TEST(AsyncMcServer, sslVerify) {
   server->join();
   EXPECT_EQ(1, server->getAcceptedConns());
 }
+
+namespace {
+
+// Number of requests handed to the server in each event loop iteration that
+// had any. Only touched by the (single) server thread.
+std::vector<size_t> requestsPerLoop;
+size_t requestsThisLoop = 0;
+
+struct CountPerLoopOnRequest : public TestServerOnRequest {
+  CountPerLoopOnRequest(folly::fibers::Baton& shutdownLock, bool outOfOrder)
+      : TestServerOnRequest(shutdownLock, outOfOrder) {}
+
+  template <class Request>
+  void onRequest(McServerRequestContext&& ctx, Request&& req) {
+    if (requestsThisLoop++ == 0) {
+      ctx.session().getEventBase().runInLoop([]() {
+        requestsPerLoop.push_back(requestsThisLoop);
+        requestsThisLoop = 0;
+      });
+    }
+    TestServerOnRequest::onRequest(std::move(ctx), std::move(req));
+  }
+};
+
+} // anonymous namespace
+
+TEST(AsyncMcServer, maxRequestsPerLoop) {
+  requestsPerLoop.clear();
+  requestsThisLoop = 0;
+
+  TestServer::Config config;
+  config.outOfOrder = true;
+  config.useSsl = false;
+  // High enough not to pause reads by itself.
+  config.maxInflight = 100;
+  config.maxRequestsPerLoop = 4;
+  auto server = TestServer::create<CountPerLoopOnRequest>(std::move(config));
+
+  // All requests are written at once, so without the cap they would all be
+  // parsed in the same loop iteration.
+  TestClient client(
+      "localhost", server->getListenPort(), 200, mc_caret_protocol, noSsl());
+  const size_t kNumRequests = 50;
+  for (size_t i = 0; i < kNumRequests; ++i) {
+    client.sendGet(folly::sformat("key{}", i), mc_res_found, 1000);
+  }
+  // Parsing resumed every time until all of them got their reply.
+  client.waitForReplies();
+  client.sendGet("shutdown", mc_res_notfound);
+  client.waitForReplies();
+  server->join();
+
+  size_t total = 0;
+  for (auto n : requestsPerLoop) {
+    EXPECT_LE(n, 4);
+    total += n;
+  }
+  EXPECT_EQ(kNumRequests + 1, total);
+  EXPECT_GE(requestsPerLoop.size(), (kNumRequests + 3) / 4);
+}
+
+TEST(AsyncMcServer, maxRequestsPerLoopDisabled) {
+  requestsPerLoop.clear();
+  requestsThisLoop = 0;
+
+  TestServer::Config config;
+  config.outOfOrder = true;
+  config.useSsl = false;
+  config.maxInflight = 100;
+  auto server = TestServer::create<CountPerLoopOnRequest>(std::move(config));
+
+  TestClient client(
+      "localhost", server->getListenPort(), 200, mc_caret_protocol, noSsl());
+  const size_t kNumRequests = 50;
+  for (size_t i = 0; i < kNumRequests; ++i) {
+    client.sendGet(folly::sformat("key{}", i), mc_res_found, 1000);
+  }
+  client.waitForReplies();
+  client.sendGet("shutdown", mc_res_notfound);
+  client.waitForReplies();
+  server->join();
+
+  size_t maxPerLoop = 0;
+  for (auto n : requestsPerLoop) {
+    maxPerLoop = std::max(maxPerLoop, n);
+  }
+  EXPECT_GT(maxPerLoop, 4);
+}
+
+namespace {
+
+// A connection that never starts its handshake.
+// @return true if the server closed it within `timeout`.
+bool isClosedByServer(ClientSocket& sock, std::chrono::milliseconds timeout) {
+  try {
+    sock.sendRequest("", 1, timeout);
+  } catch (const std::runtime_error& e) {
+    return folly::StringPiece(e.what()).find("timeout") == std::string::npos;
+  }
+  return false;
+}
+
+TestServer::Config handshakeOffloadConfig() {
+  // Undo the verifier installed by sslVerify.
+  McSSLUtil::setApplicationSSLVerifier(nullptr);
+  TestServer::Config config;
+  config.outOfOrder = false;
+  config.numHandshakeThreads = 1;
+  return config;
+}
+
+} // anonymous namespace
+
+TEST(AsyncMcServer, sslHandshakeOffload) {
+  auto config = handshakeOffloadConfig();
+  config.numHandshakeThreads = 2;
+  auto server = TestServer::create(std::move(config));
+
+  for (size_t i = 0; i < 4; ++i) {
+    TestClient client(
+        "localhost",
+        server->getListenPort(),
+        200,
+        mc_ascii_protocol,
+        validClientSsl());
+    client.sendGet("empty", mc_res_found);
+    client.waitForReplies();
+  }
+
+  server->shutdown();
+  server->join();
+  EXPECT_EQ(4, server->getAcceptedConns());
+}
+
+TEST(AsyncMcServer, sslHandshakeOffloadFailure) {
+  auto server = TestServer::create(handshakeOffloadConfig());
+
+  TestClient brokenClient(
+      "localhost",
+      server->getListenPort(),
+      200,
+      mc_ascii_protocol,
+      brokenSsl());
+  brokenClient.sendGet("empty", mc_res_connect_error);
+  brokenClient.waitForReplies();
+
+  TestClient client(
+      "localhost",
+      server->getListenPort(),
+      200,
+      mc_ascii_protocol,
+      validClientSsl());
+  client.sendGet("empty", mc_res_found);
+  client.waitForReplies();
+
+  server->shutdown();
+  server->join();
+  // The failed connection never made it to the worker.
+  EXPECT_EQ(1, server->getAcceptedConns());
+}
+
+TEST(AsyncMcServer, sslHandshakeOffloadTimeout) {
+  auto config = handshakeOffloadConfig();
+  config.sslHandshakeTimeoutMs = 100;
+  auto server = TestServer::create(std::move(config));
+
+  ClientSocket idle(server->getListenPort());
+  EXPECT_TRUE(isClosedByServer(idle, std::chrono::seconds(2)));
+
+  server->shutdown();
+  server->join();
+  EXPECT_EQ(0, server->getAcceptedConns());
+}
+
+TEST(AsyncMcServer, sslHandshakeOffloadMaxInFlight) {
+  auto config = handshakeOffloadConfig();
+  config.maxInFlightHandshakes = 1;
+  auto server = TestServer::create(std::move(config));
+
+  auto idle = std::make_unique<ClientSocket>(server->getListenPort());
+  /* sleep override */
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  ClientSocket refused(server->getListenPort());
+  EXPECT_TRUE(isClosedByServer(refused, std::chrono::seconds(2)));
+  EXPECT_FALSE(isClosedByServer(*idle, std::chrono::milliseconds(100)));
+
+  // Once the idle connection goes away, there's room again.
+  idle.reset();
+  /* sleep override */
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  TestClient client(
+      "localhost",
+      server->getListenPort(),
+      200,
+      mc_ascii_protocol,
+      validClientSsl());
+  client.sendGet("empty", mc_res_found);
+  client.waitForReplies();
+
+  server->shutdown();
+  server->join();
+  EXPECT_EQ(1, server->getAcceptedConns());
+}
+
+TEST(AsyncMcServer, sslHandshakeOffloadShutdown) {
+  auto server = TestServer::create(handshakeOffloadConfig());
+
+  ClientSocket idle(server->getListenPort());
+  /* sleep override */
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  // Doesn't wait for the handshake (5s timeout) to finish.
+  const auto start = std::chrono::steady_clock::now();
+  server->shutdown();
+  server->join();
+  EXPECT_LT(
+      std::chrono::steady_clock::now() - start, std::chrono::seconds(2));
+  EXPECT_TRUE(isClosedByServer(idle, std::chrono::seconds(1)));
+  EXPECT_EQ(0, server->getAcceptedConns());
+}
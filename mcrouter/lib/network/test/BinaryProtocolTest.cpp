@@ -0,0 +1,289 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <folly/io/IOBuf.h>
+
+#include "mcrouter/lib/CompressionCodecManager.h"
+#include "mcrouter/lib/network/BinaryProtocol.h"
+#include "mcrouter/lib/network/McParser.h"
+#include "mcrouter/lib/network/McSerializedRequest.h"
+#include "mcrouter/lib/network/gen/Memcache.h"
+
+using namespace facebook::memcache;
+
+namespace {
+
+std::string toString(const McSerializedRequest& serialized) {
+  std::string result;
+  for (size_t i = 0; i < serialized.getIovsCount(); ++i) {
+    const auto& iov = serialized.getIovs()[i];
+    result.append(static_cast<const char*>(iov.iov_base), iov.iov_len);
+  }
+  return result;
+}
+
+/**
+ * Builds a binary reply: header with the given fields, then body.
+ */
+std::string makeReply(
+    BinaryOpcode opcode,
+    BinaryStatus status,
+    uint32_t opaque,
+    const std::string& extras,
+    const std::string& value,
+    uint64_t cas = 0) {
+  std::string header(kBinaryHeaderLength, '\0');
+  header[0] = static_cast<char>(kBinaryReplyMagicByte);
+  header[1] = static_cast<char>(opcode);
+  header[4] = static_cast<char>(extras.size());
+  header[6] = static_cast<char>(static_cast<uint16_t>(status) >> 8);
+  header[7] = static_cast<char>(static_cast<uint16_t>(status) & 0xff);
+  const uint32_t bodyLength = extras.size() + value.size();
+  for (size_t i = 0; i < 4; ++i) {
+    header[8 + i] = static_cast<char>(bodyLength >> (8 * (3 - i)));
+    header[12 + i] = static_cast<char>(opaque >> (8 * (3 - i)));
+  }
+  for (size_t i = 0; i < 8; ++i) {
+    header[16 + i] = static_cast<char>(cas >> (8 * (7 - i)));
+  }
+  return header + extras + value;
+}
+
+template <class Reply>
+Reply parseReply(const std::string& data) {
+  auto buf = folly::IOBuf::copyBuffer(data);
+  Reply reply;
+  binaryParseReply(binaryParseReplyHeader(buf->data()), *buf, reply);
+  return reply;
+}
+
+struct Message {
+  UmbrellaMessageInfo info;
+  std::string data;
+};
+
+class TestParserCallback : public McParser::ParserCallback {
+ public:
+  std::vector<Message> messages;
+  bool error{false};
+
+  bool umMessageReady(const UmbrellaMessageInfo&, const folly::IOBuf&)
+      override {
+    error = true;
+    return false;
+  }
+
+  bool caretMessageReady(const UmbrellaMessageInfo&, const folly::IOBuf&)
+      override {
+    error = true;
+    return false;
+  }
+
+  bool binaryMessageReady(
+      const UmbrellaMessageInfo& headerInfo,
+      const folly::IOBuf& buffer) override {
+    messages.push_back(Message{
+        headerInfo,
+        std::string(
+            reinterpret_cast<const char*>(buffer.data()),
+            headerInfo.headerSize + headerInfo.bodySize)});
+    return true;
+  }
+
+  void handleAscii(folly::IOBuf&) override {
+    error = true;
+  }
+
+  void parseError(mc_res_t, folly::StringPiece) override {
+    error = true;
+  }
+};
+
+} // anonymous namespace
+
+TEST(BinaryProtocol, serializeGet) {
+  McGetRequest req("key");
+  McSerializedRequest serialized(
+      req, 0x01020304, mc_binary_protocol, CodecIdRange::Empty);
+  ASSERT_EQ(McSerializedRequest::Result::OK, serialized.serializationResult());
+  EXPECT_EQ(
+      std::string(
+          "\x80\x00\x00\x03\x00\x00\x00\x00"
+          "\x00\x00\x00\x03\x01\x02\x03\x04"
+          "\x00\x00\x00\x00\x00\x00\x00\x00"
+          "key",
+          27),
+      toString(serialized));
+}
+
+TEST(BinaryProtocol, serializeSet) {
+  McSetRequest req("key");
+  req.value() = folly::IOBuf(folly::IOBuf::COPY_BUFFER, "value");
+  req.flags() = 0x0a0b;
+  req.exptime() = 0x10;
+  McSerializedRequest serialized(
+      req, 7, mc_binary_protocol, CodecIdRange::Empty);
+  ASSERT_EQ(McSerializedRequest::Result::OK, serialized.serializationResult());
+  EXPECT_EQ(
+      std::string(
+          "\x80\x01\x00\x03\x08\x00\x00\x00"
+          "\x00\x00\x00\x10\x00\x00\x00\x07"
+          "\x00\x00\x00\x00\x00\x00\x00\x00"
+          "\x00\x00\x0a\x0b\x00\x00\x00\x10"
+          "keyvalue",
+          40),
+      toString(serialized));
+}
+
+TEST(BinaryProtocol, serializeCasAndIncr) {
+  McCasRequest cas("key");
+  cas.casToken() = 0x0102;
+  McSerializedRequest serializedCas(
+      cas, 1, mc_binary_protocol, CodecIdRange::Empty);
+  ASSERT_EQ(
+      McSerializedRequest::Result::OK, serializedCas.serializationResult());
+  const auto casData = toString(serializedCas);
+  ASSERT_EQ(kBinaryHeaderLength + 8 + 3, casData.size());
+  EXPECT_EQ(static_cast<char>(BinaryOpcode::SET), casData[1]);
+  EXPECT_EQ(std::string("\0\0\0\0\0\0\x01\x02", 8), casData.substr(16, 8));
+
+  McIncrRequest incr("key");
+  incr.delta() = 5;
+  McSerializedRequest serializedIncr(
+      incr, 1, mc_binary_protocol, CodecIdRange::Empty);
+  ASSERT_EQ(
+      McSerializedRequest::Result::OK, serializedIncr.serializationResult());
+  const auto incrData = toString(serializedIncr);
+  ASSERT_EQ(kBinaryHeaderLength + 20 + 3, incrData.size());
+  EXPECT_EQ(static_cast<char>(BinaryOpcode::INCREMENT), incrData[1]);
+  EXPECT_EQ(
+      std::string(
+          "\0\0\0\0\0\0\0\x05"
+          "\0\0\0\0\0\0\0\0"
+          "\xff\xff\xff\xff",
+          20),
+      incrData.substr(kBinaryHeaderLength, 20));
+}
+
+TEST(BinaryProtocol, unsupportedRequest) {
+  McLeaseGetRequest req("key");
+  McSerializedRequest serialized(
+      req, 1, mc_binary_protocol, CodecIdRange::Empty);
+  EXPECT_EQ(
+      McSerializedRequest::Result::ERROR, serialized.serializationResult());
+}
+
+TEST(BinaryProtocol, parseGetReply) {
+  auto reply = parseReply<McGetsReply>(makeReply(
+      BinaryOpcode::GET,
+      BinaryStatus::NO_ERROR,
+      1,
+      std::string("\x00\x00\x00\x0b", 4),
+      "value",
+      0x1234));
+  EXPECT_EQ(mc_res_found, reply.result());
+  EXPECT_EQ(11, reply.flags());
+  EXPECT_EQ(0x1234, reply.casToken());
+  ASSERT_TRUE(reply.value().hasValue());
+  EXPECT_EQ("value", reply.value()->moveToFbString().toStdString());
+
+  auto miss = parseReply<McGetReply>(makeReply(
+      BinaryOpcode::GET, BinaryStatus::KEY_NOT_FOUND, 1, "", "Not found"));
+  EXPECT_EQ(mc_res_notfound, miss.result());
+  EXPECT_FALSE(miss.value().hasValue());
+}
+
+TEST(BinaryProtocol, parseStorageReplies) {
+  EXPECT_EQ(
+      mc_res_stored,
+      parseReply<McSetReply>(
+          makeReply(BinaryOpcode::SET, BinaryStatus::NO_ERROR, 1, "", ""))
+          .result());
+  EXPECT_EQ(
+      mc_res_exists,
+      parseReply<McCasReply>(
+          makeReply(BinaryOpcode::SET, BinaryStatus::KEY_EXISTS, 1, "", ""))
+          .result());
+  EXPECT_EQ(
+      mc_res_notstored,
+      parseReply<McAddReply>(makeReply(
+                                 BinaryOpcode::ADD,
+                                 BinaryStatus::ITEM_NOT_STORED,
+                                 1,
+                                 "",
+                                 ""))
+          .result());
+
+  auto error = parseReply<McSetReply>(makeReply(
+      BinaryOpcode::SET, BinaryStatus::OUT_OF_MEMORY, 1, "", "Out of memory"));
+  EXPECT_EQ(mc_res_remote_error, error.result());
+  EXPECT_EQ("Out of memory", error.message());
+
+  auto busy = parseReply<McSetReply>(
+      makeReply(BinaryOpcode::SET, BinaryStatus::BUSY, 1, "", ""));
+  EXPECT_EQ(mc_res_busy, busy.result());
+}
+
+TEST(BinaryProtocol, parseArithmeticReply) {
+  auto reply = parseReply<McIncrReply>(makeReply(
+      BinaryOpcode::INCREMENT,
+      BinaryStatus::NO_ERROR,
+      1,
+      "",
+      std::string("\0\0\0\0\0\0\x01\x00", 8)));
+  EXPECT_EQ(mc_res_stored, reply.result());
+  EXPECT_EQ(256, reply.delta());
+
+  EXPECT_THROW(
+      parseReply<McIncrReply>(makeReply(
+          BinaryOpcode::INCREMENT, BinaryStatus::NO_ERROR, 1, "", "1")),
+      std::runtime_error);
+}
+
+TEST(BinaryProtocol, parserFramesReplies) {
+  const auto first = makeReply(
+      BinaryOpcode::GET,
+      BinaryStatus::NO_ERROR,
+      3,
+      std::string("\0\0\0\0", 4),
+      std::string(1000, 'v'));
+  const auto second =
+      makeReply(BinaryOpcode::DELETE, BinaryStatus::NO_ERROR, 5, "", "");
+  const auto data = first + second;
+
+  TestParserCallback cb;
+  McParser parser(cb, 256, 4096);
+  size_t pos = 0;
+  while (pos < data.size()) {
+    auto buf = parser.getReadBuffer();
+    // Feed the data in small pieces to test partial headers and bodies.
+    const auto len = std::min<size_t>({buf.second, data.size() - pos, 10});
+    std::memcpy(buf.first, data.data() + pos, len);
+    ASSERT_TRUE(parser.readDataAvailable(len));
+    pos += len;
+  }
+
+  EXPECT_FALSE(cb.error);
+  EXPECT_EQ(mc_binary_protocol, parser.protocol());
+  EXPECT_TRUE(parser.outOfOrder());
+  ASSERT_EQ(2, cb.messages.size());
+  EXPECT_EQ(3, cb.messages[0].info.reqId);
+  EXPECT_EQ(kBinaryHeaderLength, cb.messages[0].info.headerSize);
+  EXPECT_EQ(1004, cb.messages[0].info.bodySize);
+  EXPECT_EQ(first, cb.messages[0].data);
+  EXPECT_EQ(5, cb.messages[1].info.reqId);
+  EXPECT_EQ(second, cb.messages[1].data);
+}
@@ -0,0 +1,86 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <sys/uio.h>
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <folly/io/IOBuf.h>
+
+#include "mcrouter/lib/carbon/CarbonProtocolWriter.h"
+#include "mcrouter/lib/carbon/CarbonQueueAppender.h"
+#include "mcrouter/lib/network/CarbonFastSerializers.h"
+#include "mcrouter/lib/network/gen/Memcache.h"
+
+using namespace facebook::memcache;
+
+namespace {
+
+std::string toString(carbon::CarbonQueueAppenderStorage& storage) {
+  std::string out;
+  const auto iovs = storage.getIovecs();
+  for (size_t i = 0; i < iovs.second; ++i) {
+    out.append(
+        static_cast<const char*>(iovs.first[i].iov_base),
+        iovs.first[i].iov_len);
+  }
+  return out;
+}
+
+template <class Message>
+void expectSameAsGeneric(const Message& message) {
+  carbon::CarbonQueueAppenderStorage generic;
+  carbon::CarbonProtocolWriter writer(generic);
+  message.serialize(writer);
+
+  carbon::CarbonQueueAppenderStorage fast;
+  serializeCarbonStruct(message, fast);
+
+  EXPECT_EQ(toString(generic), toString(fast));
+}
+
+} // anonymous
+
+TEST(CarbonFastSerializers, getRequest) {
+  expectSameAsGeneric(McGetRequest());
+  expectSameAsGeneric(McGetRequest("key"));
+  expectSameAsGeneric(McGetRequest(std::string(1000, 'k')));
+
+  McGetRequest withFlags("key");
+  withFlags.flags() = 0xdeadbeefcafe;
+  expectSameAsGeneric(withFlags);
+
+  McGetRequest onlyFlags;
+  onlyFlags.flags() = 1;
+  expectSameAsGeneric(onlyFlags);
+}
+
+TEST(CarbonFastSerializers, getReply) {
+  expectSameAsGeneric(McGetReply());
+  expectSameAsGeneric(McGetReply(mc_res_notfound));
+
+  McGetReply hit(mc_res_found);
+  hit.value() = folly::IOBuf(folly::IOBuf::COPY_BUFFER, "value");
+  hit.flags() = 123;
+  expectSameAsGeneric(hit);
+
+  McGetReply bigHit(mc_res_found);
+  bigHit.value() =
+      folly::IOBuf(folly::IOBuf::COPY_BUFFER, std::string(10000, 'v'));
+  expectSameAsGeneric(bigHit);
+
+  McGetReply emptyValue(mc_res_found);
+  emptyValue.value() = folly::IOBuf();
+  expectSameAsGeneric(emptyValue);
+
+  McGetReply error(mc_res_remote_error);
+  error.message() = "something went wrong";
+  error.appSpecificErrorCode() = -17;
+  expectSameAsGeneric(error);
+}
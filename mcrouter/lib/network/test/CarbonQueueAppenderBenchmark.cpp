@@ -0,0 +1,129 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <string>
+#include <vector>
+
+#include <folly/Benchmark.h>
+#include <folly/init/Init.h>
+#include <folly/io/IOBuf.h>
+
+#include "mcrouter/lib/carbon/CarbonProtocolWriter.h"
+#include "mcrouter/lib/carbon/CarbonQueueAppender.h"
+#include "mcrouter/lib/network/CarbonFastSerializers.h"
+#include "mcrouter/lib/network/gen/Memcache.h"
+
+using namespace facebook::memcache;
+
+namespace {
+
+template <class Message>
+void serializeMessage(size_t iters, const Message& message) {
+  carbon::CarbonQueueAppenderStorage storage;
+  for (size_t i = 0; i < iters; ++i) {
+    carbon::CarbonProtocolWriter writer(storage);
+    message.serialize(writer);
+    folly::doNotOptimizeAway(storage.getIovecs().second);
+    storage.reset();
+  }
+}
+
+template <class Message>
+void serializeMessageFast(size_t iters, const Message& message) {
+  carbon::CarbonQueueAppenderStorage storage;
+  for (size_t i = 0; i < iters; ++i) {
+    serializeCarbonStruct(message, storage);
+    folly::doNotOptimizeAway(storage.getIovecs().second);
+    storage.reset();
+  }
+}
+
+McGetReply makeGetHit() {
+  McGetReply reply(mc_res_found);
+  reply.value() = folly::IOBuf(folly::IOBuf::COPY_BUFFER, std::string(64, 'v'));
+  reply.flags() = 123;
+  return reply;
+}
+
+void appendIOBufs(size_t iters, size_t numBufs, size_t bufSize) {
+  std::vector<folly::IOBuf> bufs;
+  BENCHMARK_SUSPEND {
+    for (size_t i = 0; i < numBufs; ++i) {
+      bufs.emplace_back(folly::IOBuf::COPY_BUFFER, std::string(bufSize, 'v'));
+    }
+  }
+  carbon::CarbonQueueAppenderStorage storage;
+  for (size_t i = 0; i < iters; ++i) {
+    for (const auto& buf : bufs) {
+      storage.append(buf);
+    }
+    folly::doNotOptimizeAway(storage.getIovecs().second);
+    storage.reset();
+  }
+}
+
+} // anonymous namespace
+
+BENCHMARK(get_smallKey, iters) {
+  McGetRequest req;
+  BENCHMARK_SUSPEND {
+    req = McGetRequest(std::string(32, 'k'));
+  }
+  serializeMessage(iters, req);
+}
+
+BENCHMARK_RELATIVE(get_smallKey_fast, iters) {
+  McGetRequest req;
+  BENCHMARK_SUSPEND {
+    req = McGetRequest(std::string(32, 'k'));
+  }
+  serializeMessageFast(iters, req);
+}
+
+BENCHMARK(getReply_hit, iters) {
+  McGetReply reply;
+  BENCHMARK_SUSPEND {
+    reply = makeGetHit();
+  }
+  serializeMessage(iters, reply);
+}
+
+BENCHMARK_RELATIVE(getReply_hit_fast, iters) {
+  McGetReply reply;
+  BENCHMARK_SUSPEND {
+    reply = makeGetHit();
+  }
+  serializeMessageFast(iters, reply);
+}
+
+BENCHMARK(set_smallKey_smallValue, iters) {
+  McSetRequest req;
+  BENCHMARK_SUSPEND {
+    req = McSetRequest(std::string(32, 'k'));
+    req.value() = folly::IOBuf(folly::IOBuf::COPY_BUFFER, std::string(64, 'v'));
+  }
+  serializeMessage(iters, req);
+}
+
+BENCHMARK(append_8_smallIOBufs, iters) {
+  appendIOBufs(iters, 8, 16);
+}
+
+BENCHMARK(append_8_largeIOBufs, iters) {
+  appendIOBufs(iters, 8, 1024);
+}
+
+// More IOBufs than CarbonQueueAppenderStorage has inline iovecs.
+BENCHMARK(append_100_largeIOBufs, iters) {
+  appendIOBufs(iters, 100, 1024);
+}
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv, true /* removeFlags */);
+  folly::runBenchmarks();
+  return 0;
+}
@@ -129,7 +129,8 @@ TEST(CarbonQueueAppender, manyFields) {
 
   carbon::CarbonProtocolWriter writer(storage);
 
-  // This will trigger CarbonQueueAppenderStorage::coalesce() logic
+  // Small IOBufs are copied into the storage's inline buffer, so this
+  // doesn't run out of iovecs.
   manyFields.serialize(writer);
 
   UmbrellaMessageInfo info;
@@ -205,3 +206,56 @@ TEST(CarbonQueueAppender, manyFields) {
   EXPECT_STREQ(str1, reinterpret_cast<const char*>(manyFields2.buf39().data()));
   EXPECT_STREQ(str2, reinterpret_cast<const char*>(manyFields2.buf40().data()));
 }
+
+TEST(CarbonQueueAppender, manyLargeIOBufs) {
+  carbon::CarbonQueueAppenderStorage storage;
+
+  // IOBufs larger than the inline threshold are referenced, not copied. Use
+  // more of them than the storage keeps by value, so that the overflow chain
+  // is exercised as well.
+  std::string expected;
+  for (char c = 'a'; c < 'a' + 8; ++c) {
+    const std::string chunk(200, c);
+    expected += chunk;
+    storage.append(folly::IOBuf(folly::IOBuf::COPY_BUFFER, chunk));
+  }
+
+  std::string actual;
+  const auto iovs = storage.getIovecs();
+  for (size_t i = 0; i < iovs.second; ++i) {
+    const struct iovec* iov = iovs.first + i;
+    actual.append(static_cast<const char*>(iov->iov_base), iov->iov_len);
+  }
+  EXPECT_EQ(expected, actual);
+
+  storage.reset();
+  EXPECT_EQ(0, storage.computeBodySize());
+}
+
+TEST(CarbonQueueAppender, moreIOBufsThanInlineIovecs) {
+  carbon::CarbonQueueAppenderStorage storage;
+
+  // Every IOBuf takes an iovec, which is more than the storage has inline.
+  // The iovec array must grow instead of coalescing the IOBufs.
+  for (int round = 0; round < 2; ++round) {
+    std::string expected;
+    for (size_t i = 0; i < 100; ++i) {
+      const std::string chunk(200, 'a' + i % 26);
+      expected += chunk;
+      storage.append(folly::IOBuf(folly::IOBuf::COPY_BUFFER, chunk));
+    }
+
+    std::string actual;
+    const auto iovs = storage.getIovecs();
+    EXPECT_EQ(100, iovs.second);
+    for (size_t i = 0; i < iovs.second; ++i) {
+      const struct iovec* iov = iovs.first + i;
+      actual.append(static_cast<const char*>(iov->iov_base), iov->iov_len);
+    }
+    EXPECT_EQ(expected, actual);
+
+    // The storage is reusable after reset(), with a pooled iovec array.
+    storage.reset();
+    EXPECT_EQ(0, storage.computeBodySize());
+  }
+}
@@ -0,0 +1,198 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBuf.h>
+
+#include "mcrouter/lib/CompressionCodecManager.h"
+#include "mcrouter/lib/network/CaretBatcher.h"
+#include "mcrouter/lib/network/CaretSerializedMessage.h"
+#include "mcrouter/lib/network/McParser.h"
+#include "mcrouter/lib/network/gen/Memcache.h"
+
+using namespace facebook::memcache;
+
+namespace {
+
+struct Request {
+  UmbrellaMessageInfo info;
+  std::string key;
+};
+
+class TestParserCallback : public McParser::ParserCallback {
+ public:
+  std::vector<Request> requests;
+  bool error{false};
+
+  bool umMessageReady(const UmbrellaMessageInfo&, const folly::IOBuf&)
+      override {
+    error = true;
+    return false;
+  }
+
+  bool caretMessageReady(
+      const UmbrellaMessageInfo& headerInfo,
+      const folly::IOBuf& buffer) override {
+    Request request;
+    request.info = headerInfo;
+    folly::io::Cursor cur(&buffer);
+    cur += headerInfo.headerSize;
+    carbon::CarbonProtocolReader reader(cur);
+    if (headerInfo.typeId == McGetRequest::typeId) {
+      McGetRequest req;
+      req.deserialize(reader);
+      request.key = req.key().fullKey().str();
+    } else {
+      McDeleteRequest req;
+      req.deserialize(reader);
+      request.key = req.key().fullKey().str();
+    }
+    requests.push_back(std::move(request));
+    return true;
+  }
+
+  void handleAscii(folly::IOBuf&) override {
+    error = true;
+  }
+
+  void parseError(mc_res_t, folly::StringPiece) override {
+    error = true;
+  }
+};
+
+class Requests {
+ public:
+  template <class Request>
+  void add(const Request& req, size_t reqId) {
+    messages_.push_back(std::make_unique<CaretSerializedMessage>());
+    const struct iovec* iovs;
+    size_t iovCount;
+    ASSERT_TRUE(messages_.back()->prepare(
+        req,
+        reqId,
+        CodecIdRange::Empty,
+        std::chrono::milliseconds(0),
+        nullptr /* compressionCodecMap */,
+        iovs,
+        iovCount));
+    iovs_.insert(iovs_.end(), iovs, iovs + iovCount);
+  }
+
+  const std::vector<struct iovec>& iovs() const {
+    return iovs_;
+  }
+
+  std::string data() const {
+    std::string data;
+    for (const auto& iov : iovs_) {
+      data.append(static_cast<const char*>(iov.iov_base), iov.iov_len);
+    }
+    return data;
+  }
+
+ private:
+  std::vector<std::unique_ptr<CaretSerializedMessage>> messages_;
+  std::vector<struct iovec> iovs_;
+};
+
+void feed(McParser& parser, const std::string& data) {
+  size_t pos = 0;
+  while (pos < data.size()) {
+    auto buf = parser.getReadBuffer();
+    const auto len = std::min(buf.second, data.size() - pos);
+    std::memcpy(buf.first, data.data() + pos, len);
+    ASSERT_TRUE(parser.readDataAvailable(len));
+    pos += len;
+  }
+}
+
+} // anonymous
+
+TEST(CaretBatcher, nothingToMerge) {
+  Requests requests;
+  requests.add(McGetRequest("a"), 1);
+  requests.add(McDeleteRequest("b"), 2);
+  requests.add(McGetRequest("c"), 3);
+
+  EXPECT_EQ(
+      nullptr,
+      CaretBatcher::batch(requests.iovs().data(), requests.iovs().size()));
+}
+
+TEST(CaretBatcher, batches) {
+  Requests requests;
+  requests.add(McGetRequest("a"), 1);
+  requests.add(McGetRequest("bb"), 2);
+  requests.add(McGetRequest("ccc"), 4);
+  requests.add(McDeleteRequest("d"), 5);
+  requests.add(McGetRequest("e"), 6);
+  requests.add(McGetRequest("f"), 7);
+
+  auto batched =
+      CaretBatcher::batch(requests.iovs().data(), requests.iovs().size());
+  ASSERT_NE(nullptr, batched);
+  EXPECT_LT(batched->computeChainDataLength(), requests.data().size());
+
+  TestParserCallback cb;
+  McParser parser(cb, 256, 4096);
+  feed(parser, batched->moveToFbString().toStdString());
+
+  EXPECT_FALSE(cb.error);
+  ASSERT_EQ(6, cb.requests.size());
+  const std::vector<std::pair<uint32_t, std::string>> expected = {
+      {1, "a"}, {2, "bb"}, {4, "ccc"}, {5, "d"}, {6, "e"}, {7, "f"}};
+  for (size_t i = 0; i < expected.size(); ++i) {
+    EXPECT_EQ(expected[i].first, cb.requests[i].info.reqId);
+    EXPECT_EQ(expected[i].second, cb.requests[i].key);
+    EXPECT_EQ(0, cb.requests[i].info.batchSize);
+    EXPECT_EQ(1, cb.requests[i].info.acceptsFragments);
+  }
+  EXPECT_EQ(McDeleteRequest::typeId, cb.requests[3].info.typeId);
+}
+
+TEST(CaretBatcher, malformedBatch) {
+  Requests requests;
+  requests.add(McGetRequest("a"), 1);
+  requests.add(McGetRequest("b"), 2);
+  auto batched =
+      CaretBatcher::batch(requests.iovs().data(), requests.iovs().size());
+  ASSERT_NE(nullptr, batched);
+  auto data = batched->moveToFbString().toStdString();
+
+  // Drop the last byte of the last body, and claim the batch is one byte
+  // shorter.
+  UmbrellaMessageInfo info;
+  ASSERT_EQ(
+      UmbrellaParseStatus::OK,
+      caretParseHeader(
+          reinterpret_cast<const uint8_t*>(data.data()), data.size(), info));
+  EXPECT_EQ(2, info.batchSize);
+  --info.bodySize;
+  char header[kMaxHeaderLength];
+  const auto headerSize = caretPrepareHeader(info, header);
+  data = std::string(header, headerSize) +
+      data.substr(info.headerSize, info.bodySize);
+
+  TestParserCallback cb;
+  McParser parser(cb, 256, 4096);
+  auto buf = parser.getReadBuffer();
+  ASSERT_GE(buf.second, data.size());
+  std::memcpy(buf.first, data.data(), data.size());
+  EXPECT_FALSE(parser.readDataAvailable(data.size()));
+  EXPECT_TRUE(cb.error);
+}
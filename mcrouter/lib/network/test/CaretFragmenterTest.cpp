@@ -0,0 +1,343 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBuf.h>
+
+#include "mcrouter/lib/CompressionCodecManager.h"
+#include "mcrouter/lib/carbon/RequestReplyUtil.h"
+#include "mcrouter/lib/network/CaretFragmenter.h"
+#include "mcrouter/lib/network/CaretSerializedMessage.h"
+#include "mcrouter/lib/network/McParser.h"
+#include "mcrouter/lib/network/gen/Memcache.h"
+
+using namespace facebook::memcache;
+
+namespace {
+
+struct Message {
+  UmbrellaMessageInfo info;
+  McGetReply reply;
+};
+
+class TestParserCallback : public McParser::ParserCallback {
+ public:
+  std::vector<Message> messages;
+  bool error{false};
+  bool chained{false};
+  // Whether the last message was passed in more than one buffer.
+  bool lastMessageChained{false};
+
+  bool chainedMessagesSupported() const override {
+    return chained;
+  }
+
+  bool umMessageReady(const UmbrellaMessageInfo&, const folly::IOBuf&)
+      override {
+    error = true;
+    return false;
+  }
+
+  bool caretMessageReady(
+      const UmbrellaMessageInfo& headerInfo,
+      const folly::IOBuf& buffer) override {
+    lastMessageChained = buffer.isChained();
+    Message message;
+    message.info = headerInfo;
+    folly::io::Cursor cur(&buffer);
+    cur += headerInfo.headerSize;
+    carbon::CarbonProtocolReader reader(cur);
+    message.reply.deserialize(reader);
+    messages.push_back(std::move(message));
+    return true;
+  }
+
+  void handleAscii(folly::IOBuf&) override {
+    error = true;
+  }
+
+  void parseError(mc_res_t, folly::StringPiece) override {
+    error = true;
+  }
+};
+
+McGetReply makeReply(size_t valueSize) {
+  McGetReply reply(mc_res_found);
+  reply.value() =
+      folly::IOBuf(folly::IOBuf::COPY_BUFFER, std::string(valueSize, 'v'));
+  return reply;
+}
+
+std::string toString(const struct iovec* iovs, size_t iovCount) {
+  std::string data;
+  for (size_t i = 0; i < iovCount; ++i) {
+    data.append(static_cast<const char*>(iovs[i].iov_base), iovs[i].iov_len);
+  }
+  return data;
+}
+
+void feed(McParser& parser, const std::string& data) {
+  size_t pos = 0;
+  while (pos < data.size()) {
+    auto buf = parser.getReadBuffer();
+    const auto len = std::min(buf.second, data.size() - pos);
+    std::memcpy(buf.first, data.data() + pos, len);
+    ASSERT_TRUE(parser.readDataAvailable(len));
+    pos += len;
+  }
+}
+
+/**
+ * @return  false iff the parser reported an error on some part of data.
+ */
+bool feedUntilError(McParser& parser, const std::string& data) {
+  size_t pos = 0;
+  while (pos < data.size()) {
+    auto buf = parser.getReadBuffer();
+    const auto len = std::min(buf.second, data.size() - pos);
+    std::memcpy(buf.first, data.data() + pos, len);
+    if (!parser.readDataAvailable(len)) {
+      return false;
+    }
+    pos += len;
+  }
+  return true;
+}
+
+/**
+ * @return  frames of a reply with the given reqId and value size.
+ */
+std::vector<std::string>
+makeFrames(uint32_t reqId, size_t valueSize, size_t frameSize) {
+  CaretSerializedMessage message;
+  const struct iovec* iovs;
+  size_t iovCount;
+  EXPECT_TRUE(message.prepare(
+      makeReply(valueSize),
+      reqId,
+      CodecIdRange::Empty,
+      nullptr /* compressionCodecMap */,
+      0.0 /* dropProbability */,
+      ServerLoad::zero(),
+      0 /* creditWindow */,
+      iovs,
+      iovCount));
+
+  std::vector<std::string> frames;
+  CaretFragmenter fragmenter(iovs, iovCount, frameSize);
+  EXPECT_TRUE(fragmenter.shouldFragment());
+  while (!fragmenter.done()) {
+    auto frame = fragmenter.nextFrame();
+    frames.push_back(toString(frame.first, frame.second));
+  }
+  return frames;
+}
+
+} // anonymous
+
+TEST(CaretFragmenter, smallMessage) {
+  CaretSerializedMessage message;
+  const struct iovec* iovs;
+  size_t iovCount;
+  ASSERT_TRUE(message.prepare(
+      makeReply(10),
+      1 /* reqId */,
+      CodecIdRange::Empty,
+      nullptr /* compressionCodecMap */,
+      0.0 /* dropProbability */,
+      ServerLoad::zero(),
+      0 /* creditWindow */,
+      iovs,
+      iovCount));
+
+  CaretFragmenter fragmenter(iovs, iovCount, 1024);
+  EXPECT_FALSE(fragmenter.shouldFragment());
+}
+
+TEST(CaretFragmenter, interleavedFrames) {
+  CaretSerializedMessage big;
+  const struct iovec* bigIovs;
+  size_t bigIovCount;
+  ASSERT_TRUE(big.prepare(
+      makeReply(1000),
+      1 /* reqId */,
+      CodecIdRange::Empty,
+      nullptr /* compressionCodecMap */,
+      0.0 /* dropProbability */,
+      ServerLoad::zero(),
+      7 /* creditWindow */,
+      bigIovs,
+      bigIovCount));
+
+  CaretSerializedMessage small;
+  const struct iovec* smallIovs;
+  size_t smallIovCount;
+  ASSERT_TRUE(small.prepare(
+      makeReply(5),
+      2 /* reqId */,
+      CodecIdRange::Empty,
+      nullptr /* compressionCodecMap */,
+      0.0 /* dropProbability */,
+      ServerLoad::zero(),
+      7 /* creditWindow */,
+      smallIovs,
+      smallIovCount));
+
+  CaretFragmenter fragmenter(bigIovs, bigIovCount, 300);
+  ASSERT_TRUE(fragmenter.shouldFragment());
+
+  // First frame of the big reply, the small reply, then the other frames.
+  std::string data;
+  auto frame = fragmenter.nextFrame();
+  data += toString(frame.first, frame.second);
+  data += toString(smallIovs, smallIovCount);
+  size_t numFrames = 1;
+  while (!fragmenter.done()) {
+    frame = fragmenter.nextFrame();
+    data += toString(frame.first, frame.second);
+    ++numFrames;
+  }
+  EXPECT_EQ(4, numFrames);
+
+  TestParserCallback cb;
+  McParser parser(cb, 256, 4096);
+  feed(parser, data);
+
+  EXPECT_FALSE(cb.error);
+  ASSERT_EQ(2, cb.messages.size());
+  EXPECT_EQ(2, cb.messages[0].info.reqId);
+  EXPECT_EQ("vvvvv", carbon::valueRangeSlow(cb.messages[0].reply).str());
+  EXPECT_EQ(1, cb.messages[1].info.reqId);
+  EXPECT_EQ(McGetReply::typeId, cb.messages[1].info.typeId);
+  EXPECT_EQ(7, cb.messages[1].info.creditWindow);
+  EXPECT_EQ(0, cb.messages[1].info.moreFragments);
+  EXPECT_EQ(mc_res_found, cb.messages[1].reply.result());
+  EXPECT_EQ(
+      std::string(1000, 'v'),
+      carbon::valueRangeSlow(cb.messages[1].reply).str());
+}
+
+TEST(CaretFragmenter, largeFramesNotCoalesced) {
+  CaretSerializedMessage message;
+  const struct iovec* iovs;
+  size_t iovCount;
+  ASSERT_TRUE(message.prepare(
+      makeReply(100000),
+      1 /* reqId */,
+      CodecIdRange::Empty,
+      nullptr /* compressionCodecMap */,
+      0.0 /* dropProbability */,
+      ServerLoad::zero(),
+      0 /* creditWindow */,
+      iovs,
+      iovCount));
+
+  CaretFragmenter fragmenter(iovs, iovCount, 32768);
+  ASSERT_TRUE(fragmenter.shouldFragment());
+  std::string data;
+  while (!fragmenter.done()) {
+    auto frame = fragmenter.nextFrame();
+    data += toString(frame.first, frame.second);
+  }
+
+  for (bool chained : {false, true}) {
+    TestParserCallback cb;
+    cb.chained = chained;
+    McParser parser(cb, 256, 4096);
+    feed(parser, data);
+
+    EXPECT_FALSE(cb.error);
+    ASSERT_EQ(1, cb.messages.size());
+    EXPECT_EQ(chained, cb.lastMessageChained);
+    EXPECT_EQ(
+        std::string(100000, 'v'),
+        carbon::valueRangeSlow(cb.messages[0].reply).str());
+  }
+}
+
+TEST(CaretFragmenter, tooManyPartialMessages) {
+  auto first = makeFrames(1 /* reqId */, 1000, 300);
+  auto second = makeFrames(2 /* reqId */, 1000, 300);
+
+  // Messages reassembled one after the other are within the limit.
+  {
+    TestParserCallback cb;
+    McParser parser(cb, 256, 4096);
+    parser.setPartialMessageLimits(1, 1 << 20);
+    std::string data;
+    for (const auto& frame : first) {
+      data += frame;
+    }
+    for (const auto& frame : second) {
+      data += frame;
+    }
+    EXPECT_TRUE(feedUntilError(parser, data));
+    EXPECT_FALSE(cb.error);
+    EXPECT_EQ(2, cb.messages.size());
+  }
+
+  // Interleaved, there are two at a time.
+  {
+    TestParserCallback cb;
+    McParser parser(cb, 256, 4096);
+    parser.setPartialMessageLimits(1, 1 << 20);
+    EXPECT_FALSE(feedUntilError(parser, first[0] + second[0]));
+    EXPECT_TRUE(cb.error);
+    EXPECT_TRUE(cb.messages.empty());
+  }
+}
+
+TEST(CaretFragmenter, tooManyPartialBytes) {
+  auto frames = makeFrames(1 /* reqId */, 1000, 300);
+  std::string data;
+  for (const auto& frame : frames) {
+    data += frame;
+  }
+
+  {
+    TestParserCallback cb;
+    McParser parser(cb, 256, 4096);
+    parser.setPartialMessageLimits(16, 2000);
+    EXPECT_TRUE(feedUntilError(parser, data));
+    EXPECT_FALSE(cb.error);
+    ASSERT_EQ(1, cb.messages.size());
+  }
+
+  {
+    TestParserCallback cb;
+    McParser parser(cb, 256, 4096);
+    parser.setPartialMessageLimits(16, 500);
+    EXPECT_FALSE(feedUntilError(parser, data));
+    EXPECT_TRUE(cb.error);
+    EXPECT_TRUE(cb.messages.empty());
+  }
+}
+
+TEST(CaretFragmenter, partialBytesAreReleased) {
+  // Each message fits the limit, but not the two of them together.
+  TestParserCallback cb;
+  McParser parser(cb, 256, 4096);
+  parser.setPartialMessageLimits(16, 1500);
+  std::string data;
+  for (uint32_t reqId = 1; reqId <= 3; ++reqId) {
+    for (const auto& frame : makeFrames(reqId, 1000, 300)) {
+      data += frame;
+    }
+  }
+  EXPECT_TRUE(feedUntilError(parser, data));
+  EXPECT_FALSE(cb.error);
+  EXPECT_EQ(3, cb.messages.size());
+}
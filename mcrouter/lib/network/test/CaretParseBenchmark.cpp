@@ -0,0 +1,85 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <chrono>
+#include <string>
+
+#include <folly/Benchmark.h>
+#include <folly/init/Init.h>
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBuf.h>
+
+#include "mcrouter/lib/carbon/CarbonProtocolReader.h"
+#include "mcrouter/lib/network/McSerializedRequest.h"
+#include "mcrouter/lib/network/UmbrellaProtocol.h"
+#include "mcrouter/lib/network/gen/Memcache.h"
+
+using namespace facebook::memcache;
+
+namespace {
+
+/**
+ * Serializes req the way AsyncMcClient sends it: caret, with a timeout
+ * budget additional field.
+ */
+template <class Request>
+std::unique_ptr<folly::IOBuf> serialize(const Request& req) {
+  McSerializedRequest serialized(
+      req,
+      12345 /* reqId */,
+      mc_caret_protocol,
+      CodecIdRange::Empty,
+      std::chrono::milliseconds(200));
+  std::string bytes;
+  for (size_t i = 0; i < serialized.getIovsCount(); ++i) {
+    const auto& iov = serialized.getIovs()[i];
+    bytes.append(static_cast<const char*>(iov.iov_base), iov.iov_len);
+  }
+  return folly::IOBuf::copyBuffer(bytes);
+}
+
+/**
+ * Parses the header and the body of a caret request, like the server does
+ * for every request it reads.
+ */
+template <class Request>
+void parse(size_t iters, const Request& req) {
+  std::unique_ptr<folly::IOBuf> buf;
+  BENCHMARK_SUSPEND {
+    buf = serialize(req);
+  }
+  for (size_t i = 0; i < iters; ++i) {
+    UmbrellaMessageInfo info;
+    caretParseHeader(buf->data(), buf->length(), info);
+    folly::io::Cursor cur(buf.get());
+    cur += info.headerSize;
+    carbon::CarbonProtocolReader reader(cur);
+    Request parsed;
+    parsed.deserialize(reader);
+    folly::doNotOptimizeAway(parsed);
+  }
+}
+
+} // anonymous namespace
+
+BENCHMARK(caret_get, iters) {
+  parse(iters, McGetRequest("someprefix:1234567890:somesuffix"));
+}
+
+BENCHMARK(caret_set_smallValue, iters) {
+  McSetRequest req("someprefix:1234567890:somesuffix");
+  req.value() = folly::IOBuf(folly::IOBuf::COPY_BUFFER, std::string(100, 'v'));
+  req.exptime() = 3600;
+  req.flags() = 0x1234;
+  parse(iters, req);
+}
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv, true /* removeFlags */);
+  folly::runBenchmarks();
+  return 0;
+}
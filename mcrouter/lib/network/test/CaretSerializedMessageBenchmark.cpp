@@ -0,0 +1,64 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <string>
+
+#include <folly/Benchmark.h>
+#include <folly/init/Init.h>
+
+#include "mcrouter/lib/network/McSerializedRequest.h"
+#include "mcrouter/lib/network/gen/Memcache.h"
+
+using namespace facebook::memcache;
+
+namespace {
+
+McSetRequest makeSetRequest(size_t keySize, size_t valueSize) {
+  McSetRequest req(std::string(keySize, 'k'));
+  req.value() =
+      folly::IOBuf(folly::IOBuf::COPY_BUFFER, std::string(valueSize, 'v'));
+  return req;
+}
+
+void serialize(
+    size_t iters,
+    mc_protocol_t protocol,
+    size_t keySize,
+    size_t valueSize) {
+  McSetRequest req;
+  BENCHMARK_SUSPEND {
+    req = makeSetRequest(keySize, valueSize);
+  }
+  for (size_t i = 0; i < iters; ++i) {
+    McSerializedRequest serialized(req, i, protocol, CodecIdRange::Empty);
+    folly::doNotOptimizeAway(serialized.getIovsCount());
+  }
+}
+
+} // anonymous namespace
+
+BENCHMARK(caret_set_smallKey_smallValue, iters) {
+  serialize(iters, mc_caret_protocol, 32, 64);
+}
+
+BENCHMARK(caret_set_largeKey_largeValue, iters) {
+  serialize(iters, mc_caret_protocol, 200, 4096);
+}
+
+BENCHMARK(ascii_set_smallKey_smallValue, iters) {
+  serialize(iters, mc_ascii_protocol, 32, 64);
+}
+
+BENCHMARK(ascii_set_largeKey_largeValue, iters) {
+  serialize(iters, mc_ascii_protocol, 200, 4096);
+}
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv, true /* removeFlags */);
+  folly::runBenchmarks();
+  return 0;
+}
@@ -0,0 +1,112 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <algorithm>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include <folly/Benchmark.h>
+#include <folly/init/Init.h>
+
+#include "mcrouter/lib/network/FlatIdMap.h"
+
+using facebook::memcache::FlatIdMap;
+
+namespace {
+
+constexpr size_t kInflight = 4096;
+
+/**
+ * Simulates a pipeline with kInflight requests in flight: every iteration
+ * inserts a new id and looks up + erases one of the ids in the window.
+ * For in order replies the oldest id is replied first, for out of order
+ * replies the order within the window is shuffled.
+ */
+template <class Map, class Insert, class Reply>
+void runPipeline(size_t iters, bool outOfOrder, Insert insert, Reply reply) {
+  Map map;
+  std::vector<uint64_t> replyOrder;
+  int value = 0;
+
+  BENCHMARK_SUSPEND {
+    replyOrder.reserve(iters);
+    for (size_t i = 0; i < iters; ++i) {
+      replyOrder.push_back(2 * i + 1);
+    }
+    if (outOfOrder) {
+      std::mt19937 gen(42);
+      for (size_t i = 0; i < iters; i += kInflight) {
+        auto end = std::min(iters, i + kInflight);
+        std::shuffle(replyOrder.begin() + i, replyOrder.begin() + end, gen);
+      }
+    }
+  }
+
+  uint64_t nextId = 1;
+  size_t replied = 0;
+  for (size_t i = 0; i < iters; ++i) {
+    insert(map, nextId, &value);
+    nextId += 2;
+    // Reply to the window once it's completely in flight.
+    if ((i + 1) % kInflight == 0 || i + 1 == iters) {
+      for (; replied <= i; ++replied) {
+        folly::doNotOptimizeAway(reply(map, replyOrder[replied]));
+      }
+    }
+  }
+}
+
+void flatIdMap(size_t iters, bool outOfOrder) {
+  runPipeline<FlatIdMap<int>>(
+      iters,
+      outOfOrder,
+      [](FlatIdMap<int>& map, uint64_t id, int* v) { map.insert(id, v); },
+      [](FlatIdMap<int>& map, uint64_t id) {
+        auto v = map.find(id);
+        map.erase(id);
+        return v;
+      });
+}
+
+void unorderedMap(size_t iters, bool outOfOrder) {
+  using Map = std::unordered_map<uint64_t, int*>;
+  runPipeline<Map>(
+      iters,
+      outOfOrder,
+      [](Map& map, uint64_t id, int* v) { map.emplace(id, v); },
+      [](Map& map, uint64_t id) {
+        auto it = map.find(id);
+        auto v = it->second;
+        map.erase(it);
+        return v;
+      });
+}
+
+} // anonymous namespace
+
+BENCHMARK(unorderedMap_inOrder, iters) {
+  unorderedMap(iters, false);
+}
+
+BENCHMARK_RELATIVE(flatIdMap_inOrder, iters) {
+  flatIdMap(iters, false);
+}
+
+BENCHMARK(unorderedMap_outOfOrder, iters) {
+  unorderedMap(iters, true);
+}
+
+BENCHMARK_RELATIVE(flatIdMap_outOfOrder, iters) {
+  flatIdMap(iters, true);
+}
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv, true /* removeFlags */);
+  folly::runBenchmarks();
+  return 0;
+}
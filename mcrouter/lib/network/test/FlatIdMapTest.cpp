@@ -0,0 +1,82 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <algorithm>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/lib/network/FlatIdMap.h"
+
+using facebook::memcache::FlatIdMap;
+
+TEST(FlatIdMap, basic) {
+  FlatIdMap<int> map;
+  int a = 1, b = 2;
+  EXPECT_TRUE(map.empty());
+  map.insert(1, &a);
+  map.insert(3, &b);
+  EXPECT_EQ(2, map.size());
+  EXPECT_EQ(&a, map.find(1));
+  EXPECT_EQ(&b, map.find(3));
+  EXPECT_EQ(nullptr, map.find(5));
+
+  EXPECT_TRUE(map.erase(1));
+  EXPECT_FALSE(map.erase(1));
+  EXPECT_EQ(nullptr, map.find(1));
+  EXPECT_EQ(&b, map.find(3));
+  EXPECT_EQ(1, map.size());
+}
+
+TEST(FlatIdMap, grow) {
+  FlatIdMap<int> map(8);
+  std::vector<int> values(1000);
+  for (size_t i = 0; i < values.size(); ++i) {
+    map.insert(2 * i + 1, &values[i]);
+  }
+  EXPECT_EQ(values.size(), map.size());
+  EXPECT_GE(map.capacity(), 2 * values.size());
+  for (size_t i = 0; i < values.size(); ++i) {
+    EXPECT_EQ(&values[i], map.find(2 * i + 1));
+  }
+}
+
+TEST(FlatIdMap, collisionsAndOutOfOrderErase) {
+  // Keep a few old ids alive while the id space wraps around the table many
+  // times, so that probe sequences overlap, and erase in random order.
+  FlatIdMap<int> map(16);
+  std::unordered_map<uint64_t, int*> expected;
+  std::vector<int> values(4096);
+  std::mt19937 gen(42);
+
+  uint64_t nextId = 1;
+  for (size_t i = 0; i < values.size(); ++i) {
+    map.insert(nextId, &values[i]);
+    expected[nextId] = &values[i];
+    nextId += 2;
+
+    if (expected.size() > 12) {
+      std::vector<uint64_t> ids;
+      for (const auto& it : expected) {
+        ids.push_back(it.first);
+      }
+      std::sort(ids.begin(), ids.end());
+      // Erase a random one, but never the oldest.
+      std::uniform_int_distribution<size_t> dist(1, ids.size() - 1);
+      auto id = ids[dist(gen)];
+      EXPECT_TRUE(map.erase(id));
+      expected.erase(id);
+    }
+
+    ASSERT_EQ(expected.size(), map.size());
+    for (const auto& it : expected) {
+      ASSERT_EQ(it.second, map.find(it.first));
+    }
+  }
+}
@@ -0,0 +1,260 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+#include <folly/Benchmark.h>
+#include <folly/Conv.h>
+#include <folly/Format.h>
+#include <folly/init/Init.h>
+
+#include "mcrouter/lib/network/ClientMcParser.h"
+#include "mcrouter/lib/network/ServerMcParser.h"
+#include "mcrouter/lib/network/gen/Memcache.h"
+
+using namespace facebook::memcache;
+
+namespace {
+
+/**
+ * Feeds a stream of ascii get replies into ClientMcParser, as AsyncMcClient
+ * does with data read from the socket.
+ */
+class GetReplyConsumer {
+ public:
+  GetReplyConsumer() : parser_(*this, 4096, 65536) {
+    parser_.setProtocol(mc_ascii_protocol);
+  }
+
+  void consume(folly::StringPiece data, size_t readSize) {
+    while (!data.empty()) {
+      auto buffer = parser_.getReadBuffer();
+      auto len = std::min({buffer.second, data.size(), readSize});
+      std::memcpy(buffer.first, data.data(), len);
+      parser_.readDataAvailable(len);
+      data.advance(len);
+    }
+  }
+
+  size_t numReplies() const {
+    return numReplies_;
+  }
+
+ private:
+  using ParserT = ClientMcParser<GetReplyConsumer>;
+  friend ParserT;
+
+  ParserT parser_;
+  size_t numReplies_{0};
+
+  void replyReady(McGetReply&& reply, uint64_t, ReplyStatsContext) {
+    folly::doNotOptimizeAway(reply.result());
+    ++numReplies_;
+  }
+
+  template <class Reply>
+  void replyReady(Reply&&, uint64_t, ReplyStatsContext) {}
+
+  bool nextReplyAvailable(uint64_t) {
+    parser_.expectNext<McGetRequest>();
+    return true;
+  }
+
+  void parseError(mc_res_t, folly::StringPiece reason) {
+    LOG(FATAL) << "Unexpected parse error: " << reason;
+  }
+
+  void handleConnectionControlMessage(const UmbrellaMessageInfo&) {}
+};
+
+/**
+ * Generates replies for a batch of gets: every missRatio-th key is a miss.
+ */
+std::string makeReplyStream(
+    size_t numReplies,
+    size_t keySize,
+    size_t valueSize,
+    size_t missRatio) {
+  const std::string value(valueSize, 'v');
+  std::string out;
+  for (size_t i = 0; i < numReplies; ++i) {
+    if (missRatio != 0 && i % missRatio == 0) {
+      out.append("END\r\n");
+      continue;
+    }
+    auto key = folly::to<std::string>(i);
+    key.resize(keySize, 'k');
+    folly::format(&out, "VALUE {} {} {}\r\n", key, i, valueSize);
+    out.append(value).append("\r\nEND\r\n");
+  }
+  return out;
+}
+
+void parse(
+    size_t iters,
+    size_t keySize,
+    size_t valueSize,
+    size_t missRatio,
+    size_t readSize) {
+  std::string stream;
+  BENCHMARK_SUSPEND {
+    stream = makeReplyStream(1000, keySize, valueSize, missRatio);
+  }
+  for (size_t i = 0; i < iters; ++i) {
+    GetReplyConsumer consumer;
+    consumer.consume(stream, readSize);
+    folly::doNotOptimizeAway(consumer.numReplies());
+  }
+}
+
+/**
+ * Feeds a stream of ascii requests into ServerMcParser, as McServerSession
+ * does with data read from the socket.
+ */
+class RequestConsumer {
+ public:
+  RequestConsumer() : parser_(*this, 4096, 65536) {}
+
+  void consume(folly::StringPiece data, size_t readSize) {
+    while (!data.empty()) {
+      auto buffer = parser_.getReadBuffer();
+      auto len = std::min({buffer.second, data.size(), readSize});
+      std::memcpy(buffer.first, data.data(), len);
+      parser_.readDataAvailable(len);
+      data.advance(len);
+    }
+  }
+
+  size_t numRequests() const {
+    return numRequests_;
+  }
+
+ private:
+  using ParserT = ServerMcParser<RequestConsumer>;
+  friend ParserT;
+
+  ParserT parser_;
+  size_t numRequests_{0};
+
+  template <class Request>
+  void onRequest(Request&& req, bool /* noreply */) {
+    folly::doNotOptimizeAway(req.key().routingKey());
+    ++numRequests_;
+  }
+
+  void multiOpEnd() {}
+
+  void caretRequestReady(const UmbrellaMessageInfo&, const folly::IOBuf&) {}
+
+  template <class Request>
+  void umbrellaRequestReady(Request&&, uint64_t) {}
+
+  void parseError(mc_res_t, folly::StringPiece reason) {
+    LOG(FATAL) << "Unexpected parse error: " << reason;
+  }
+};
+
+/**
+ * Generates numRequests requests: gets with keysPerGet keys each, or sets if
+ * keysPerGet is 0.
+ */
+std::string makeRequestStream(
+    size_t numRequests,
+    size_t keySize,
+    size_t keysPerGet,
+    size_t valueSize) {
+  const std::string value(valueSize, 'v');
+  std::string out;
+  for (size_t i = 0; i < numRequests; ++i) {
+    auto key = folly::to<std::string>(i);
+    key.resize(keySize, 'k');
+    if (keysPerGet == 0) {
+      folly::format(&out, "set {} {} 0 {}\r\n", key, i, valueSize);
+      out.append(value).append("\r\n");
+      continue;
+    }
+    out.append("get");
+    for (size_t j = 0; j < keysPerGet; ++j) {
+      out.append(" ").append(key);
+    }
+    out.append("\r\n");
+  }
+  return out;
+}
+
+void parseRequests(
+    size_t iters,
+    size_t keySize,
+    size_t keysPerGet,
+    size_t valueSize,
+    size_t readSize) {
+  std::string stream;
+  BENCHMARK_SUSPEND {
+    stream = makeRequestStream(1000, keySize, keysPerGet, valueSize);
+  }
+  for (size_t i = 0; i < iters; ++i) {
+    RequestConsumer consumer;
+    consumer.consume(stream, readSize);
+    folly::doNotOptimizeAway(consumer.numRequests());
+  }
+}
+
+} // anonymous namespace
+
+BENCHMARK(get_smallValues_allHits, iters) {
+  parse(iters, 32, 64, 0, 65536);
+}
+
+BENCHMARK(get_smallValues_halfMisses, iters) {
+  parse(iters, 32, 64, 2, 65536);
+}
+
+BENCHMARK(get_allMisses, iters) {
+  parse(iters, 32, 64, 1, 65536);
+}
+
+BENCHMARK(get_mediumValues_allHits, iters) {
+  parse(iters, 64, 1024, 0, 65536);
+}
+
+BENCHMARK(get_smallValues_smallReads, iters) {
+  parse(iters, 32, 64, 0, 1024);
+}
+
+BENCHMARK(get_largeValues_allHits, iters) {
+  parse(iters, 64, 16384, 0, 65536);
+}
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK(server_get_singleKey, iters) {
+  parseRequests(iters, 32, 1, 0, 65536);
+}
+
+BENCHMARK(server_get_multiKey, iters) {
+  parseRequests(iters, 32, 10, 0, 65536);
+}
+
+BENCHMARK(server_get_smallReads, iters) {
+  parseRequests(iters, 32, 1, 0, 1024);
+}
+
+BENCHMARK(server_set_smallValues, iters) {
+  parseRequests(iters, 32, 0, 64, 65536);
+}
+
+BENCHMARK(server_set_mediumValues, iters) {
+  parseRequests(iters, 64, 0, 1024, 65536);
+}
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv, true /* removeFlags */);
+  folly::runBenchmarks();
+  return 0;
+}
@@ -11,6 +11,7 @@
 
 #include <gtest/gtest.h>
 
+#include <folly/Format.h>
 #include <folly/io/IOBuf.h>
 
 #include "mcrouter/lib/network/ClientMcParser.h"
@@ -43,6 +44,10 @@ class McAsciiParserHarness {
 
   void runTest(int maxPieceSize);
 
+  void setMetaCommands() {
+    metaCommands_ = true;
+  }
+
  private:
   using ParserT = ClientMcParser<McAsciiParserHarness>;
   friend ParserT;
@@ -87,6 +92,7 @@ class McAsciiParserHarness {
   size_t currentId_{0};
   folly::IOBuf data_;
   bool errorState_{false};
+  bool metaCommands_{false};
 
   template <class Reply>
   void replyReady(
@@ -123,6 +129,7 @@ class McAsciiParserHarness {
     currentId_ = 0;
     errorState_ = false;
     parser_ = std::make_unique<ParserT>(*this, 1024, 4096);
+    parser_->setMetaCommands(metaCommands_);
     for (auto range : data_) {
       while (range.size() > 0 && !errorState_) {
         auto buffer = parser_->getReadBuffer();
@@ -269,6 +276,36 @@ TYPED_TEST(McAsciiParserTestGet, GetHit_Error) {
   h.runTest(1);
 }
 
+TYPED_TEST(McAsciiParserTestGet, GetHit_BadTrailer) {
+  McAsciiParserHarness h("VALUE t 10 2\r\nte\r\nEDN\r\n");
+  h.expectNext<TypeParam>(ReplyT<TypeParam>(), true);
+  h.runTest(1);
+}
+
+TYPED_TEST(McAsciiParserTestGet, GetHit_ControlCharInKey) {
+  McAsciiParserHarness h("VALUE t\x01t 10 2\r\nte\r\nEND\r\n");
+  h.expectNext<TypeParam>(ReplyT<TypeParam>(), true);
+  h.runTest(1);
+}
+
+TYPED_TEST(McAsciiParserTestGet, GetHit_NoCarriageReturn) {
+  McAsciiParserHarness h("VALUE test 17 5\ntest \nEND\n");
+  h.expectNext<TypeParam>(
+      setFlags(setValue(ReplyT<TypeParam>(mc_res_found), "test "), 17));
+  h.runTest(1);
+}
+
+TYPED_TEST(McAsciiParserTestGet, GetHit_LargeValue) {
+  std::string value(10000, 'v');
+  auto data = folly::sformat(
+      "VALUE test 17 {}\r\n{}\r\nEND\r\nEND\r\n", value.size(), value);
+  McAsciiParserHarness h(data.c_str());
+  h.expectNext<TypeParam>(
+      setFlags(setValue(ReplyT<TypeParam>(mc_res_found), value), 17));
+  h.expectNext<TypeParam>(ReplyT<TypeParam>(mc_res_notfound));
+  h.runTest(-1);
+}
+
 TYPED_TEST(McAsciiParserTestGet, GetMiss) {
   McAsciiParserHarness h("END\r\n");
   h.expectNext<TypeParam>(ReplyT<TypeParam>(mc_res_notfound));
@@ -586,6 +623,115 @@ TEST(McAsciiParserTestFlushAll, FlushAll) {
   h.runTest(0);
 }
 
+/**
+ * Test meta command replies
+ */
+TEST(McAsciiParserTestMeta, GetHitMiss) {
+  McAsciiParserHarness h("VA 2 f10\r\nte\r\nEN\r\n");
+  h.setMetaCommands();
+  h.expectNext<McGetRequest>(
+      setFlags(setValue(McGetReply(mc_res_found), "te"), 10));
+  h.expectNext<McGetRequest>(McGetReply(mc_res_notfound));
+  h.runTest(2);
+}
+
+TEST(McAsciiParserTestMeta, GetHit_UnknownFlags) {
+  McAsciiParserHarness h("VA 5  Oabc f7 kdGVzdA== \r\ntest \r\n");
+  h.setMetaCommands();
+  h.expectNext<McGetRequest>(
+      setFlags(setValue(McGetReply(mc_res_found), "test "), 7));
+  h.runTest(1);
+}
+
+TEST(McAsciiParserTestMeta, GetHit_BadFlags) {
+  McAsciiParserHarness h("VA 2 f1x\r\nte\r\n");
+  h.setMetaCommands();
+  h.expectNext<McGetRequest>(McGetReply(), true);
+  h.runTest(1);
+}
+
+TEST(McAsciiParserTestMeta, GetsHit) {
+  McAsciiParserHarness h("VA 10 c573 f1120\r\ntest test \r\n");
+  h.setMetaCommands();
+  h.expectNext<McGetsRequest>(setCas(
+      setFlags(setValue(McGetsReply(mc_res_found), "test test "), 1120), 573));
+  h.runTest(1);
+}
+
+TEST(McAsciiParserTestMeta, Storage) {
+  McAsciiParserHarness h("HD\r\nNS\r\nEX\r\nNF Oabc\r\n");
+  h.setMetaCommands();
+  h.expectNext<McSetRequest>(McSetReply(mc_res_stored));
+  h.expectNext<McAddRequest>(McAddReply(mc_res_notstored));
+  h.expectNext<McCasRequest>(McCasReply(mc_res_exists));
+  h.expectNext<McCasRequest>(McCasReply(mc_res_notfound));
+  h.runTest(1);
+}
+
+TEST(McAsciiParserTestMeta, Delete) {
+  McAsciiParserHarness h("HD\r\nNF\r\nDELETED\r\n");
+  h.setMetaCommands();
+  h.expectNext<McDeleteRequest>(McDeleteReply(mc_res_deleted));
+  h.expectNext<McDeleteRequest>(McDeleteReply(mc_res_notfound));
+  h.expectNext<McDeleteRequest>(McDeleteReply(mc_res_deleted));
+  h.runTest(1);
+}
+
+TEST(McAsciiParserTestMeta, Errors) {
+  McAsciiParserHarness h("SERVER_ERROR out of memory\r\nCLIENT_ERROR bad\r\n");
+  h.setMetaCommands();
+  h.expectNext<McSetRequest>(
+      replyWithMessage<McSetReply>(mc_res_remote_error, "out of memory"));
+  h.expectNext<McGetRequest>(
+      replyWithMessage<McGetReply>(mc_res_client_error, "bad"));
+  h.runTest(1);
+}
+
+TEST(McAsciiParserTestMeta, ClassicCommands) {
+  McAsciiParserHarness h("TOUCHED\r\n3636\r\n");
+  h.setMetaCommands();
+  h.expectNext<McTouchRequest>(McTouchReply(mc_res_touched));
+  h.expectNext<McIncrRequest>(setDelta(McIncrReply(mc_res_stored), 3636));
+  h.runTest(1);
+}
+
+TEST(McClientAsciiParser, GetHitValueSharesBuffer) {
+  McClientAsciiParser parser;
+  parser.initializeReplyParser<McGetRequest>();
+  IOBuf buffer(IOBuf::COPY_BUFFER, "VALUE t 0 10\r\n0123456789\r\nEND\r\n");
+  EXPECT_EQ(McAsciiParserBase::State::COMPLETE, parser.consume(buffer));
+  EXPECT_FALSE(parser.valueCopied());
+
+  auto reply = parser.getReply<McGetReply>();
+  ASSERT_TRUE(reply.value().hasValue());
+  EXPECT_TRUE(reply.value()->isShared());
+  EXPECT_EQ("0123456789", carbon::valueRangeSlow(reply));
+}
+
+TEST(McClientAsciiParser, GetHitStraddlingValueIsContiguous) {
+  McClientAsciiParser parser;
+  parser.initializeReplyParser<McGetRequest>();
+  IOBuf first(IOBuf::COPY_BUFFER, "VALUE t 0 10\r\n01234");
+  EXPECT_EQ(McAsciiParserBase::State::PARTIAL, parser.consume(first));
+  ASSERT_TRUE(parser.hasReadBuffer());
+
+  // The rest of the value is read directly into the value buffer.
+  auto readBuffer = parser.getReadBuffer();
+  ASSERT_EQ(5, readBuffer.second);
+  memcpy(readBuffer.first, "56789", 5);
+  parser.readDataAvailable(5);
+  EXPECT_FALSE(parser.hasReadBuffer());
+
+  IOBuf rest(IOBuf::COPY_BUFFER, "\r\nEND\r\n");
+  EXPECT_EQ(McAsciiParserBase::State::COMPLETE, parser.consume(rest));
+  EXPECT_TRUE(parser.valueCopied());
+
+  auto reply = parser.getReply<McGetReply>();
+  ASSERT_TRUE(reply.value().hasValue());
+  EXPECT_FALSE(reply.value()->isChained());
+  EXPECT_EQ("0123456789", carbon::valueRangeSlow(reply));
+}
+
 TEST(McAsciiParserHarness, AllAtOnce) {
   /**
    *    * Parse all non-failure tests as one stream.
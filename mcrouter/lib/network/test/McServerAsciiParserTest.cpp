@@ -749,3 +749,41 @@ TEST(McServerAsciiParserHarness, allOps) {
           "flush_all\r\n"
           "flush_regex ^reGex$\r\n");
 }
+
+// get and set requests that are entirely in the buffer take a fast path, the
+// rest falls back to the state machine.
+TEST(McServerAsciiParserHarness, getAndSetFastPath) {
+  TestRunner()
+      .expectNext(McGetRequest("a"))
+      .expectNext(McGetRequest("bb"))
+      .expectNext(McGetRequest("ccc"))
+      .expectMultiOpEnd()
+      .expectNext(createUpdateLike<McSetRequest>("a", "xyz", 1, -2))
+      .expectNext(createUpdateLike<McSetRequest>("bb", "", 3, 4), true)
+      .expectNext(McGetRequest("d"))
+      .expectMultiOpEnd()
+      .expectNext(createUpdateLike<McSetRequest>("e", "abc", 5, 6))
+      .expectNext(McGetRequest("f"))
+      .expectMultiOpEnd()
+      .run(
+          "get a bb ccc\r\n"
+          "set a 1 -2 3\r\nxyz\r\n"
+          "set bb 3 4 0 noreply\r\n\r\n"
+          "get d\r\n"
+          "set e 5 6 3\r\nabc\n"
+          "get f  \r\n");
+
+  // Values spanning "\r\n" and overly long numbers.
+  TestRunner()
+      .expectNext(createUpdateLike<McSetRequest>("a", "x\r\ny", 1, 2))
+      .expectNext(createUpdateLike<McSetRequest>("b", "z", 1, 2))
+      .run(
+          "set a 1 2 4\r\nx\r\ny\r\n"
+          "set b 00000000000000000001 2 1\r\nz\r\n");
+
+  // Keys before a malformed one are still passed to the callback.
+  TestRunner()
+      .expectNext(McGetRequest("a"))
+      .expectError()
+      .run("get a b\x7f c\r\n");
+}
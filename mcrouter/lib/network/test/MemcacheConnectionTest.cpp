@@ -6,6 +6,8 @@
  *
  */
 #include <gtest/gtest.h>
+#include <atomic>
+#include <string>
 #include <vector>
 
 #include <folly/Conv.h>
@@ -103,6 +105,56 @@ TEST(MemcachePooledConnectionTest, PooledExternalConnection) {
   server->join();
 }
 
+TEST(MemcachePooledConnectionTest, PooledExternalConnectionLeastLoaded) {
+  TestServer::Config config;
+  config.outOfOrder = false;
+  config.useSsl = false;
+  auto server = TestServer::create(std::move(config));
+  std::vector<std::unique_ptr<facebook::memcache::MemcacheConnection>> conns;
+  for (int i = 0; i < 4; i++) {
+    conns.push_back(
+        std::make_unique<facebook::memcache::MemcacheExternalConnection>(
+            facebook::memcache::ConnectionOptions(
+                "localhost", server->getListenPort(), mc_caret_protocol)));
+  }
+  carbon::PooledCarbonConnectionImpl<
+      facebook::memcache::MemcacheConnection>::Options options;
+  options.splitBatchedRequests = true;
+  options.leastLoaded = true;
+  options.largeRequestThreshold = 1024;
+  auto pooledConn =
+      std::make_unique<facebook::memcache::MemcachePooledConnection>(
+          std::move(conns), options);
+
+  facebook::memcache::McSetRequest smallReq("small");
+  smallReq.value() = folly::IOBuf(folly::IOBuf::COPY_BUFFER, "value");
+  facebook::memcache::McSetRequest largeReq("large");
+  largeReq.value() =
+      folly::IOBuf(folly::IOBuf::COPY_BUFFER, std::string(4096, 'v'));
+  std::vector<std::reference_wrapper<const facebook::memcache::McSetRequest>>
+      reqs;
+  for (int i = 0; i < 10; ++i) {
+    reqs.push_back(i % 2 ? smallReq : largeReq);
+  }
+
+  folly::fibers::Baton baton;
+  std::atomic<int> replies{0};
+  pooledConn->sendRequestMulti(
+      std::move(reqs),
+      [&baton, &replies](
+          const facebook::memcache::McSetRequest& /* req */,
+          facebook::memcache::McSetReply&& reply) {
+        EXPECT_EQ(mc_res_stored, reply.result());
+        if (++replies == 10) {
+          baton.post();
+        }
+      });
+  baton.wait();
+  pooledConn.reset();
+  server->shutdown();
+  server->join();
+}
+
 TEST(MemcacheInternalConnectionTest, simpleInternalConnection) {
   folly::SingletonVault::singleton()->destroyInstances();
   folly::SingletonVault::singleton()->reenableInstances();
@@ -0,0 +1,75 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <chrono>
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/lib/network/OverloadBudget.h"
+
+using namespace facebook::memcache;
+
+using std::chrono::milliseconds;
+
+TEST(OverloadBudget, burstWithinBudget) {
+  OverloadBudget budget(10);
+  const auto now = OverloadBudget::Clock::now();
+  for (size_t i = 0; i < 10; ++i) {
+    EXPECT_EQ(milliseconds(0), budget.charge(now));
+  }
+  EXPECT_DOUBLE_EQ(0.0, budget.tokens());
+}
+
+TEST(OverloadBudget, pausesUntilRefilled) {
+  OverloadBudget budget(10);
+  const auto now = OverloadBudget::Clock::now();
+  for (size_t i = 0; i < 10; ++i) {
+    budget.charge(now);
+  }
+  // One token short, refilled at 10 per second.
+  EXPECT_EQ(milliseconds(100), budget.charge(now));
+  EXPECT_EQ(milliseconds(200), budget.charge(now));
+
+  // Refilled meanwhile.
+  EXPECT_EQ(milliseconds(0), budget.charge(now + milliseconds(1000)));
+}
+
+TEST(OverloadBudget, debtIsCappedAtOneBurst) {
+  OverloadBudget budget(10);
+  const auto now = OverloadBudget::Clock::now();
+  // A whole read buffer of requests arrives at once.
+  for (size_t i = 0; i < 1000; ++i) {
+    budget.charge(now);
+  }
+  EXPECT_DOUBLE_EQ(-10.0, budget.tokens());
+  EXPECT_EQ(milliseconds(1000), budget.charge(now));
+
+  // A second is enough to get out of debt.
+  EXPECT_EQ(milliseconds(0), budget.charge(now + milliseconds(1100)));
+}
+
+TEST(OverloadBudget, refillIsCappedAtOneBurst) {
+  OverloadBudget budget(10);
+  auto now = OverloadBudget::Clock::now();
+  budget.charge(now);
+  now += std::chrono::seconds(60);
+  for (size_t i = 0; i < 10; ++i) {
+    EXPECT_EQ(milliseconds(0), budget.charge(now));
+  }
+  EXPECT_LT(milliseconds(0), budget.charge(now));
+}
+
+TEST(OverloadBudget, reset) {
+  OverloadBudget budget(10);
+  const auto now = OverloadBudget::Clock::now();
+  for (size_t i = 0; i < 20; ++i) {
+    budget.charge(now);
+  }
+  budget.reset();
+  EXPECT_DOUBLE_EQ(10.0, budget.tokens());
+  EXPECT_EQ(milliseconds(0), budget.charge(now));
+}
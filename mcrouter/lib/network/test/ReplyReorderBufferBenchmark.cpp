@@ -0,0 +1,80 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <memory>
+#include <unordered_map>
+
+#include <folly/Benchmark.h>
+#include <folly/init/Init.h>
+
+#include "mcrouter/lib/network/ReplyReorderBuffer.h"
+
+using facebook::memcache::ReplyReorderBuffer;
+
+namespace {
+
+constexpr uint64_t kPipelineDepth = 256;
+
+/**
+ * Simulates an in-order session with kPipelineDepth requests in flight where
+ * the oldest request is always the slow one: the replies to all the others
+ * are stalled until it completes, then all of them are flushed.
+ */
+template <class Stall, class Take>
+void runPipeline(size_t iters, Stall stall, Take take) {
+  uint64_t head = 0;
+  size_t written = 0;
+  while (written < iters) {
+    for (uint64_t id = head + 1; id < head + kPipelineDepth; ++id) {
+      stall(head, id, std::make_unique<int>(0));
+    }
+    // The slow reply arrives.
+    ++head;
+    ++written;
+    while (auto next = take(head)) {
+      folly::doNotOptimizeAway(next);
+      ++head;
+      ++written;
+    }
+  }
+}
+
+} // anonymous namespace
+
+BENCHMARK(unorderedMap, iters) {
+  std::unordered_map<uint64_t, std::unique_ptr<int>> blocked;
+  runPipeline(
+      iters,
+      [&blocked](uint64_t, uint64_t id, std::unique_ptr<int> value) {
+        blocked.emplace(id, std::move(value));
+      },
+      [&blocked](uint64_t id) {
+        std::unique_ptr<int> value;
+        auto it = blocked.find(id);
+        if (it != blocked.end()) {
+          value = std::move(it->second);
+          blocked.erase(it);
+        }
+        return value;
+      });
+}
+
+BENCHMARK_RELATIVE(replyReorderBuffer, iters) {
+  ReplyReorderBuffer<std::unique_ptr<int>> blocked(kPipelineDepth);
+  runPipeline(
+      iters,
+      [&blocked](uint64_t head, uint64_t id, std::unique_ptr<int> value) {
+        blocked.insert(head, id, std::move(value));
+      },
+      [&blocked](uint64_t id) { return blocked.take(id); });
+}
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv, true /* removeFlags */);
+  folly::runBenchmarks();
+  return 0;
+}
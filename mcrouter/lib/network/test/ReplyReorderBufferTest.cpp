@@ -0,0 +1,78 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/lib/network/ReplyReorderBuffer.h"
+
+using facebook::memcache::ReplyReorderBuffer;
+
+TEST(ReplyReorderBuffer, basic) {
+  ReplyReorderBuffer<std::unique_ptr<int>> buffer;
+  EXPECT_TRUE(buffer.empty());
+  EXPECT_EQ(nullptr, buffer.take(0));
+
+  buffer.insert(0, 2, std::make_unique<int>(2));
+  buffer.insert(0, 1, std::make_unique<int>(1));
+  EXPECT_EQ(2, buffer.size());
+
+  EXPECT_EQ(nullptr, buffer.take(3));
+  auto one = buffer.take(1);
+  ASSERT_NE(nullptr, one);
+  EXPECT_EQ(1, *one);
+  EXPECT_EQ(nullptr, buffer.take(1));
+  auto two = buffer.take(2);
+  ASSERT_NE(nullptr, two);
+  EXPECT_EQ(2, *two);
+  EXPECT_TRUE(buffer.empty());
+}
+
+TEST(ReplyReorderBuffer, wrapAround) {
+  ReplyReorderBuffer<std::unique_ptr<int>> buffer(8);
+  uint64_t head = 0;
+  for (int i = 0; i < 100; ++i) {
+    // Reply to head + 1 .. head + 7 first, then to head.
+    for (int j = 7; j >= 1; --j) {
+      buffer.insert(head, head + j, std::make_unique<int>(head + j));
+    }
+    ++head;
+    while (auto next = buffer.take(head)) {
+      EXPECT_EQ(head, *next);
+      ++head;
+    }
+    EXPECT_TRUE(buffer.empty());
+  }
+  EXPECT_EQ(8, buffer.capacity());
+}
+
+TEST(ReplyReorderBuffer, grow) {
+  ReplyReorderBuffer<std::unique_ptr<int>> buffer(8);
+  const uint64_t kHead = 5;
+  std::vector<int> ids(1000);
+  for (size_t i = 0; i < ids.size(); ++i) {
+    ids[i] = kHead + 1 + i;
+  }
+  std::mt19937 gen(42);
+  std::shuffle(ids.begin(), ids.end(), gen);
+  for (auto id : ids) {
+    buffer.insert(kHead, id, std::make_unique<int>(id));
+  }
+  EXPECT_EQ(ids.size(), buffer.size());
+  EXPECT_LE(ids.size() + 1, buffer.capacity());
+
+  for (size_t i = 0; i < ids.size(); ++i) {
+    auto value = buffer.take(kHead + 1 + i);
+    ASSERT_NE(nullptr, value);
+    EXPECT_EQ(kHead + 1 + i, *value);
+  }
+  EXPECT_TRUE(buffer.empty());
+}
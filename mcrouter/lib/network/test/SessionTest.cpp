@@ -5,11 +5,14 @@
  *  file in the root directory of this source tree.
  *
  */
+#include <chrono>
 #include <string>
 #include <vector>
 
 #include <gtest/gtest.h>
 
+#include <folly/Conv.h>
+
 #include "mcrouter/lib/network/AsyncMcServerWorkerOptions.h"
 #include "mcrouter/lib/network/test/SessionTestHarness.h"
 
@@ -32,6 +35,35 @@ TEST(Session, basic) {
   t.closeSession();
 }
 
+TEST(Session, multiget) {
+  AsyncMcServerWorkerOptions opts;
+  SessionTestHarness t(opts);
+
+  // Enough keys to go past the per-key state allocated inline in the parent.
+  std::string request = "get";
+  std::string expected;
+  for (size_t i = 0; i < 40; ++i) {
+    auto key = folly::to<std::string>("key", i);
+    request += " " + key;
+    expected += folly::to<std::string>(
+        "VALUE ", key, " 0 ", key.size() + 6, "\r\n", key, "_value\r\n");
+  }
+  expected += "END\r\n";
+
+  t.pause();
+  t.inputPackets(request + "\r\n");
+  EXPECT_TRUE(t.flushWrites().empty());
+  t.resume();
+
+  std::string written;
+  for (const auto& write : t.flushWrites()) {
+    written += write;
+  }
+  EXPECT_EQ(expected, written);
+
+  t.closeSession();
+}
+
 TEST(Session, throttle) {
   AsyncMcServerWorkerOptions opts;
   opts.maxInFlight = 2;
@@ -112,6 +144,41 @@ TEST(Session, throttleBigPacket) {
   t.closeSession();
 }
 
+TEST(Session, releaseIdleReadBuffer) {
+  AsyncMcServerWorkerOptions opts;
+  opts.idleBufferReleaseTimeout = std::chrono::milliseconds(1000);
+  SessionTestHarness t(opts);
+  auto& session = t.session();
+
+  t.inputPackets("get key\r\n");
+  EXPECT_EQ(
+      vector<string>({"VALUE key 0 9\r\nkey_value\r\nEND\r\n"}),
+      t.flushWrites());
+  const auto capacity = session.readBufferCapacity();
+  EXPECT_LT(0, capacity);
+
+  // Read after idleSince.
+  EXPECT_EQ(
+      0,
+      session.releaseReadBufferIfIdle(
+          std::chrono::steady_clock::now() - std::chrono::hours(1)));
+  EXPECT_EQ(capacity, session.readBufferCapacity());
+
+  EXPECT_EQ(
+      capacity,
+      session.releaseReadBufferIfIdle(std::chrono::steady_clock::now()));
+  EXPECT_EQ(0, session.readBufferCapacity());
+
+  // Allocated again on the next read.
+  t.inputPackets("get key\r\n");
+  EXPECT_EQ(
+      vector<string>({"VALUE key 0 9\r\nkey_value\r\nEND\r\n"}),
+      t.flushWrites());
+  EXPECT_LT(0, session.readBufferCapacity());
+
+  t.closeSession();
+}
+
 TEST(Session, quit) {
   AsyncMcServerWorkerOptions opts;
   SessionTestHarness t(opts);
@@ -116,6 +116,10 @@ class SessionTestHarness {
     session_.close();
   }
 
+  McServerSession& session() {
+    return session_;
+  }
+
   /**
    * Returns the list of currently accumulated paused requests' keys.
    */
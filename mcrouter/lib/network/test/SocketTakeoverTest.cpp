@@ -0,0 +1,83 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <folly/File.h>
+#include <folly/FileUtil.h>
+#include <folly/experimental/TestUtil.h>
+#include <folly/synchronization/Baton.h>
+
+#include "mcrouter/lib/network/SocketTakeover.h"
+
+using namespace facebook::memcache;
+
+using folly::test::TemporaryDirectory;
+
+namespace {
+
+std::string readAll(int fd, size_t size) {
+  std::string data(size, '\0');
+  EXPECT_EQ(size, folly::readFull(fd, &data[0], size));
+  return data;
+}
+
+} // anonymous namespace
+
+TEST(SocketTakeover, handOver) {
+  TemporaryDirectory dir("socket_takeover_test");
+  const auto path = (dir.path() / "takeover").string();
+
+  // Stand-ins for listening sockets: the ends we keep tell whether the
+  // received fds are the same sockets.
+  int plain[2];
+  int ssl[2];
+  ASSERT_EQ(0, ::socketpair(AF_UNIX, SOCK_STREAM, 0, plain));
+  ASSERT_EQ(0, ::socketpair(AF_UNIX, SOCK_STREAM, 0, ssl));
+  folly::File plainPeer(plain[1], true);
+  folly::File sslPeer(ssl[1], true);
+
+  folly::Baton<> takenOver;
+  {
+    TakeoverServer server(
+        path,
+        [&]() {
+          TakeoverSockets sockets;
+          sockets.fds.push_back(plain[0]);
+          sockets.sslFds.push_back(ssl[0]);
+          return sockets;
+        },
+        [&]() { takenOver.post(); });
+
+    auto sockets = requestTakeover(path);
+    ASSERT_TRUE(sockets.hasValue());
+    ASSERT_EQ(1, sockets->fds.size());
+    ASSERT_EQ(1, sockets->sslFds.size());
+    folly::File plainFile(sockets->fds[0], true);
+    folly::File sslFile(sockets->sslFds[0], true);
+
+    EXPECT_TRUE(takenOver.try_wait_for(std::chrono::seconds(5)));
+
+    ASSERT_EQ(5, folly::writeFull(plainFile.fd(), "plain", 5));
+    EXPECT_EQ("plain", readAll(plainPeer.fd(), 5));
+    ASSERT_EQ(3, folly::writeFull(sslFile.fd(), "ssl", 3));
+    EXPECT_EQ("ssl", readAll(sslPeer.fd(), 3));
+  }
+  ::close(plain[0]);
+  ::close(ssl[0]);
+}
+
+TEST(SocketTakeover, nobodyListening) {
+  TemporaryDirectory dir("socket_takeover_test");
+  EXPECT_FALSE(requestTakeover((dir.path() / "takeover").string()).hasValue());
+}
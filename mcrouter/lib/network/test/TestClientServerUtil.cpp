@@ -158,6 +158,7 @@ TestServer::TestServer(Config config)
   opts_.worker.sendTimeout = std::chrono::milliseconds{config.timeoutMs};
   opts_.worker.goAwayTimeout =
       std::chrono::milliseconds{config.goAwayTimeoutMs};
+  opts_.worker.maxRequestsPerLoop = config.maxRequestsPerLoop;
   opts_.setPerThreadMaxConns(config.maxConns, opts_.numThreads);
   if (config.useSsl) {
     opts_.pemKeyPath = config.keyPath;
@@ -167,6 +168,10 @@ TestServer::TestServer(Config config)
       opts_.tfoEnabledForSsl = true;
       opts_.tfoQueueSize = 100000;
     }
+    opts_.numHandshakeThreads = config.numHandshakeThreads;
+    opts_.sslHandshakeTimeout =
+        std::chrono::milliseconds{config.sslHandshakeTimeoutMs};
+    opts_.maxInFlightHandshakes = config.maxInFlightHandshakes;
   }
 }
 
@@ -230,13 +235,17 @@ TestClient::TestClient(
     uint64_t qosPath,
     std::string serviceIdentity,
     const CompressionCodecMap* compressionCodecMap,
-    bool enableTfo)
+    bool enableTfo,
+    bool compressRequests,
+    const CompressionOffload* compressionOffload)
     : fm_(std::make_unique<folly::fibers::EventBaseLoopController>()) {
   dynamic_cast<folly::fibers::EventBaseLoopController&>(fm_.loopController())
       .attachEventBase(eventBase_);
   ConnectionOptions opts(host, port, protocol);
   opts.writeTimeout = std::chrono::milliseconds(timeoutMs);
   opts.compressionCodecMap = compressionCodecMap;
+  opts.compressRequests = compressRequests;
+  opts.compressionOffload = compressionOffload;
   if (ssl) {
     opts.sslContextProvider = std::move(ssl);
     opts.sessionCachingEnabled = true;
@@ -297,14 +306,16 @@ void TestClient::sendGet(
     std::string key,
     mc_res_t expectedResult,
     uint32_t timeoutMs,
-    std::function<void(const ReplyStatsContext&)> replyStatsCallback) {
+    std::function<void(const ReplyStatsContext&)> replyStatsCallback,
+    bool lowPriority) {
   inflight_++;
   fm_.addTask([
     key = std::move(key),
     expectedResult,
     replyStatsCallback = std::move(replyStatsCallback),
     this,
-    timeoutMs
+    timeoutMs,
+    lowPriority
   ]() {
     McGetRequest req(key);
     if (req.key().fullKey() == "trace_id") {
@@ -314,7 +325,10 @@ void TestClient::sendGet(
     try {
       ReplyStatsContext replyStatsContext;
       auto reply = client_->sendSync(
-          req, std::chrono::milliseconds(timeoutMs), &replyStatsContext);
+          req,
+          std::chrono::milliseconds(timeoutMs),
+          &replyStatsContext,
+          lowPriority);
       if (replyStatsCallback) {
         replyStatsCallback(replyStatsContext);
       }
@@ -43,6 +43,7 @@ namespace facebook {
 namespace memcache {
 
 class CompressionCodecMap;
+class CompressionOffload;
 struct ReplyStatsContext;
 
 namespace test {
@@ -98,8 +99,12 @@ class TestServer {
     size_t numThreads = 1;
     bool useTicketKeySeeds = false;
     size_t goAwayTimeoutMs = 1000;
+    size_t maxRequestsPerLoop = 0;
     const CompressionCodecMap* compressionCodecMap = nullptr;
     bool tfoEnabled = false;
+    size_t numHandshakeThreads = 0;
+    int sslHandshakeTimeoutMs = 5000;
+    size_t maxInFlightHandshakes = 0;
     std::string caPath = getDefaultCaPath();
     std::string certPath = getDefaultCertPath();
     std::string keyPath = getDefaultKeyPath();
@@ -191,7 +196,9 @@ class TestClient {
       uint64_t qosPath = 0,
       std::string serviceIdentity = "",
       const CompressionCodecMap* compressionCodecMap = nullptr,
-      bool enableTfo = false);
+      bool enableTfo = false,
+      bool compressRequests = false,
+      const CompressionOffload* compressionOffload = nullptr);
 
   void setThrottle(size_t maxInflight, size_t maxOutstanding) {
     client_->setThrottle(maxInflight, maxOutstanding);
@@ -206,7 +213,8 @@ class TestClient {
       mc_res_t expectedResult,
       uint32_t timeoutMs = 200,
       std::function<void(const ReplyStatsContext&)> replyStatsCallback =
-          nullptr);
+          nullptr,
+      bool lowPriority = false);
 
   void sendSet(
       std::string key,
@@ -7,11 +7,15 @@
  */
 #pragma once
 
+#include <algorithm>
+#include <exception>
 #include <memory>
 #include <string>
 #include <vector>
 
-#include <folly/fibers/AddTasks.h>
+#include <folly/Optional.h>
+#include <folly/fibers/Baton.h>
+#include <folly/fibers/FiberManager.h>
 
 #include "mcrouter/lib/McResUtil.h"
 #include "mcrouter/lib/Operation.h"
@@ -24,10 +28,13 @@ namespace memcache {
 
 /**
  * Sends the same request to all child route handles.
- * Collects replies until some result appears (half + 1) times
- * (or all results if that never happens).
+ * Collects replies until the most common result is known, i.e. until no
+ * other result can appear as often with the replies still outstanding
+ * (e.g. when some result appears (half + 1) times).
  * Responds with one of the replies with the most common result.
  * Ties are broken using Reply::reduce().
+ * Children that reply after that complete asynchronously, and their replies
+ * are dropped.
  */
 template <class RouteHandleIf>
 class AllMajorityRoute {
@@ -50,40 +57,90 @@ class AllMajorityRoute {
 
   template <class Request>
   ReplyT<Request> route(const Request& req) const {
-    using Reply = ReplyT<Request>;
-
-    std::vector<std::function<Reply()>> funcs;
-    funcs.reserve(children_.size());
-    auto reqCopy = std::make_shared<Request>(req);
+    auto state = std::make_shared<State<Request>>(req);
     for (auto& rh : children_) {
-      funcs.push_back([reqCopy, rh]() { return rh->route(*reqCopy); });
+      folly::fibers::addTask([state, rh, n = children_.size()]() {
+        auto reply = routeChild(*rh, state->req);
+        // Replies that come after the outcome was decided are dropped right
+        // away instead of being kept until the last child is done.
+        if (state->decided) {
+          return;
+        }
+        if (state->add(std::move(reply), n)) {
+          state->decided = true;
+          state->baton.post();
+        }
+      });
     }
 
-    size_t counts[mc_nres];
-    std::fill(counts, counts + mc_nres, 0);
-    size_t majorityCount = 0;
-    Reply majorityReply = createReply(DefaultReply, req);
+    state->baton.wait();
+    return std::move(state->majorityReply.value());
+  }
+
+ private:
+  const std::vector<std::shared_ptr<RouteHandleIf>> children_;
+
+  /**
+   * Nothing waits for the children's fibers, so an exception thrown by a
+   * child is counted as an error reply instead of leaving the caller
+   * waiting forever.
+   */
+  template <class Request>
+  static ReplyT<Request> routeChild(RouteHandleIf& rh, const Request& req) {
+    try {
+      return rh.route(req);
+    } catch (const std::exception& e) {
+      return createReply<Request>(ErrorReply, e.what());
+    }
+  }
 
-    auto taskIt = folly::fibers::addTasks(funcs.begin(), funcs.end());
-    taskIt.reserve(children_.size() / 2 + 1);
-    while (taskIt.hasNext() && majorityCount < children_.size() / 2 + 1) {
-      auto reply = taskIt.awaitNext();
-      auto result = reply.result();
+  /**
+   * Shared by the caller and the children's fibers, so that children still
+   * in flight don't need the caller's stack.
+   */
+  template <class Request>
+  struct State {
+    explicit State(const Request& r) : req(r) {}
 
+    const Request req;
+    folly::fibers::Baton baton;
+    folly::Optional<ReplyT<Request>> majorityReply;
+    size_t counts[mc_nres] = {};
+    size_t majorityCount{0};
+    size_t numReplies{0};
+    bool decided{false};
+
+    /**
+     * Accounts for one more reply.
+     *
+     * @return true iff the outcome can't change anymore: no other result
+     *         can reach majorityCount with the replies still outstanding.
+     */
+    bool add(ReplyT<Request>&& reply, size_t numChildren) {
+      const auto result = reply.result();
       ++counts[result];
+      ++numReplies;
       if ((counts[result] == majorityCount &&
-           worseThan(reply.result(), majorityReply.result())) ||
-          (counts[result] > majorityCount)) {
+           worseThan(result, majorityReply->result())) ||
+          counts[result] > majorityCount) {
         majorityReply = std::move(reply);
         majorityCount = counts[result];
       }
-    }
 
-    return majorityReply;
-  }
-
- private:
-  const std::vector<std::shared_ptr<RouteHandleIf>> children_;
+      const size_t outstanding = numChildren - numReplies;
+      if (outstanding == 0) {
+        return true;
+      }
+      // A result that wasn't seen yet can only get 'outstanding' replies.
+      size_t runnerUpCount = 0;
+      for (size_t i = 0; i < mc_nres; ++i) {
+        if (i != static_cast<size_t>(majorityReply->result())) {
+          runnerUpCount = std::max(runnerUpCount, counts[i]);
+        }
+      }
+      return runnerUpCount + outstanding < majorityCount;
+    }
+  };
 };
 }
 } // facebook::memcache
@@ -16,6 +16,7 @@
 #include "mcrouter/lib/McOperation.h"
 #include "mcrouter/lib/McResUtil.h"
 #include "mcrouter/lib/Operation.h"
+#include "mcrouter/lib/RefillLimiter.h"
 #include "mcrouter/lib/Reply.h"
 #include "mcrouter/lib/RouteHandleTraverser.h"
 #include "mcrouter/lib/carbon/RoutingGroups.h"
@@ -37,6 +38,8 @@ namespace memcache {
  * If we try to fetch "ncache" value from L1 we'll return a miss and refill
  * L1 from L2 every ncacheUpdatePeriod "ncache" requests.
  *
+ * Asynchronous L1 updates go through refillLimiter, if any.
+ *
  * NOTE: Doesn't work with lease get, gets and metaget.
  * Always overrides expiration time for L2 -> L1 update request.
  * Client is responsible for L2 consistency, sets and deletes are forwarded
@@ -62,13 +65,15 @@ class L1L2CacheRoute {
       std::shared_ptr<RouteHandleIf> l2,
       uint32_t upgradingL1Exptime,
       size_t ncacheExptime,
-      size_t ncacheUpdatePeriod)
+      size_t ncacheUpdatePeriod,
+      RefillLimiter* refillLimiter = nullptr)
       : l1_(std::move(l1)),
         l2_(std::move(l2)),
         upgradingL1Exptime_(upgradingL1Exptime),
         ncacheExptime_(ncacheExptime),
         ncacheUpdatePeriod_(ncacheUpdatePeriod),
-        ncacheUpdateCounter_(ncacheUpdatePeriod) {
+        ncacheUpdateCounter_(ncacheUpdatePeriod),
+        refillLimiter_(refillLimiter) {
     assert(l1_ != nullptr);
     assert(l2_ != nullptr);
   }
@@ -96,15 +101,13 @@ class L1L2CacheRoute {
     /* else */
     auto l2Reply = l2_->route(req);
     if (isHitResult(l2Reply.result())) {
-      folly::fibers::addTask([
-        l1 = l1_,
-        addReq = l1UpdateFromL2<McAddRequest>(req, l2Reply, upgradingL1Exptime_)
-      ]() { l1->route(addReq); });
+      sendRefill(
+          refillLimiter_,
+          l1_,
+          l1UpdateFromL2<McAddRequest>(req, l2Reply, upgradingL1Exptime_));
     } else if (isMissResult(l2Reply.result()) && ncacheUpdatePeriod_) {
-      folly::fibers::addTask(
-          [ l1 = l1_, addReq = l1Ncache<McAddRequest>(req, ncacheExptime_) ]() {
-            l1->route(addReq);
-          });
+      sendRefill(
+          refillLimiter_, l1_, l1Ncache<McAddRequest>(req, ncacheExptime_));
     }
     return l2Reply;
   }
@@ -123,6 +126,7 @@ class L1L2CacheRoute {
   size_t ncacheExptime_{0};
   size_t ncacheUpdatePeriod_{0};
   size_t ncacheUpdateCounter_{0};
+  RefillLimiter* const refillLimiter_;
 
   template <class ToRequest, class Request, class Reply>
   static ToRequest l1UpdateFromL2(
@@ -7,12 +7,13 @@
  */
 #pragma once
 
-#include <chrono>
 #include <memory>
-#include <random>
 #include <string>
 #include <vector>
 
+#include <folly/Random.h>
+
+#include "mcrouter/lib/FastRandom.h"
 #include "mcrouter/lib/McOperation.h"
 #include "mcrouter/lib/RouteHandleTraverser.h"
 
@@ -21,6 +22,9 @@ namespace memcache {
 
 /**
  * Sends the request to a random destination from list of children.
+ *
+ * Routes are built per proxy, so the generator is never shared between
+ * threads.
  */
 template <class RouteHandleIf>
 class RandomRoute {
@@ -37,20 +41,18 @@ class RandomRoute {
   }
 
   explicit RandomRoute(std::vector<std::shared_ptr<RouteHandleIf>> children)
-      : children_(std::move(children)),
-        gen_(std::ranlux24_base(
-            std::chrono::system_clock::now().time_since_epoch().count())) {
+      : children_(std::move(children)), gen_(folly::Random::rand64()) {
     assert(!children_.empty());
   }
 
   template <class Request>
   ReplyT<Request> route(const Request& req) {
-    return children_[gen_() % children_.size()]->route(req);
+    return children_[randomIndex(gen_(), children_.size())]->route(req);
   }
 
  private:
   const std::vector<std::shared_ptr<RouteHandleIf>> children_;
-  std::ranlux24_base gen_;
+  WyRand gen_;
 };
 }
 } // facebook::memcache
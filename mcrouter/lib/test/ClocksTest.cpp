@@ -0,0 +1,75 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <chrono>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include <folly/io/async/EventBase.h>
+
+#include "mcrouter/lib/Clocks.h"
+
+using namespace facebook::memcache;
+
+namespace {
+
+int64_t steadyNowUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+} // anonymous namespace
+
+TEST(Clocks, nowUsFollowsSteadyClock) {
+  // Calibrates.
+  cycles::nowUs();
+
+  const auto steadyStart = steadyNowUs();
+  const auto start = cycles::nowUs();
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  const auto end = cycles::nowUs();
+  const auto steadyEnd = steadyNowUs();
+
+  // Same epoch as steady_clock.
+  EXPECT_NEAR(steadyStart, start, 1000);
+  EXPECT_NEAR(steadyEnd, end, 1000);
+  // And the same rate, within 1%.
+  EXPECT_NEAR(steadyEnd - steadyStart, end - start, 500);
+}
+
+TEST(Clocks, nowUsIsMonotonic) {
+  auto prev = cycles::nowUs();
+  for (int i = 0; i < 100000; ++i) {
+    const auto now = cycles::nowUs();
+    ASSERT_LE(prev, now);
+    prev = now;
+  }
+}
+
+TEST(Clocks, loopCachedClock) {
+  folly::EventBase evb;
+  cycles::LoopCachedClock clock(evb);
+
+  int64_t first = 0;
+  int64_t second = 0;
+  int64_t nextIteration = 0;
+  evb.runInEventBaseThread([&]() {
+    first = clock.nowUs();
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    second = clock.nowUs();
+    evb.runInLoop([&]() {
+      evb.runInLoop([&]() { nextIteration = clock.nowUs(); });
+    });
+  });
+  evb.loop();
+
+  EXPECT_NE(0, first);
+  EXPECT_EQ(first, second);
+  EXPECT_GE(nextIteration, first + 2000);
+}
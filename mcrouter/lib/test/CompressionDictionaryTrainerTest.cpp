@@ -0,0 +1,81 @@
+/*
+ *  Copyright (c) 2016-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <gtest/gtest.h>
+
+#include <folly/Format.h>
+#include <folly/io/IOBuf.h>
+
+#include "mcrouter/lib/Compression.h"
+#include "mcrouter/lib/CompressionDictionaryTrainer.h"
+
+using facebook::memcache::CompressionCodecType;
+using facebook::memcache::CompressionDictionaryTrainer;
+using facebook::memcache::createCompressionCodec;
+
+namespace {
+
+std::unique_ptr<folly::IOBuf> makeValue(size_t i) {
+  return folly::IOBuf::copyBuffer(folly::sformat(
+      "{{\"user_id\":{},\"name\":\"user{}\",\"status\":\"active\","
+      "\"country\":\"{}\",\"score\":{}}}",
+      i,
+      i,
+      i % 3 == 0 ? "US" : "BR",
+      i * 7 % 1000));
+}
+
+} // anonymous namespace
+
+TEST(CompressionDictionaryTrainer, notEnoughSamples) {
+  CompressionDictionaryTrainer trainer(1.0, 1024 * 1024, 4096);
+  for (size_t i = 0; i < 10; ++i) {
+    trainer.addSample("pool", *makeValue(i));
+  }
+  EXPECT_TRUE(trainer.train().empty());
+}
+
+TEST(CompressionDictionaryTrainer, sampleBytesAreBounded) {
+  CompressionDictionaryTrainer trainer(1.0, 1024, 4096);
+  for (size_t i = 0; i < 1000; ++i) {
+    trainer.addSample("pool", *makeValue(i));
+  }
+  // Only ~1KB of samples were kept, too few to train.
+  EXPECT_TRUE(trainer.train().empty());
+}
+
+#if FOLLY_HAVE_LIBZSTD && !defined(DISABLE_COMPRESSION)
+TEST(CompressionDictionaryTrainer, trainPerKey) {
+  CompressionDictionaryTrainer trainer(1.0, 1024 * 1024, 4096);
+  for (size_t i = 0; i < 2000; ++i) {
+    trainer.addSample("poolB", *makeValue(i));
+    trainer.addSample("poolA", *makeValue(i + 5000));
+  }
+  trainer.addSample("poolC", *makeValue(1));
+
+  auto dictionaries = trainer.train();
+  ASSERT_EQ(2, dictionaries.size());
+  EXPECT_EQ("poolA", dictionaries[0].first);
+  EXPECT_EQ("poolB", dictionaries[1].first);
+
+  auto& dictionary = dictionaries[0].second;
+  EXPECT_GT(dictionary.size(), 0);
+  EXPECT_LE(dictionary.size(), 4096);
+  auto codec = createCompressionCodec(
+      CompressionCodecType::ZSTD,
+      folly::IOBuf::wrapBuffer(dictionary.data(), dictionary.size()),
+      1);
+  auto value = makeValue(123456);
+  auto compressed = codec->compress(*value);
+  auto uncompressed =
+      codec->uncompress(*compressed, value->computeChainDataLength());
+  EXPECT_EQ(value->coalesce(), uncompressed->coalesce());
+
+  // Samples are dropped after training.
+  EXPECT_TRUE(trainer.train().empty());
+}
+#endif // FOLLY_HAVE_LIBZSTD && !defined(DISABLE_COMPRESSION)
@@ -347,6 +347,28 @@ TEST(ZstdCompressionCodec, uncompressChainedWithCompressionLevel) {
 
   testUncompressChained(compressor.get(), *getAsciiReply(), 3);
 }
+
+TEST(ZstdCompressionCodec, hugeValueIsStreamedInChunks) {
+  auto compressor = createCompressionCodec(
+      CompressionCodecType::ZSTD, getAsciiDictionary(), 1);
+  std::string value;
+  while (value.size() < 1024 * 1024) {
+    value.append(getRandomLargeReply()->moveToFbString().toStdString());
+  }
+  auto data = folly::IOBuf::copyBuffer(value);
+  auto chainedData = buildChain(*data, 100);
+
+  auto compressedData = compressor->compress(*chainedData);
+  auto uncompressedData =
+      compressor->uncompress(*compressedData, value.size());
+  EXPECT_GT(uncompressedData->countChainElements(), 1);
+  auto cur = uncompressedData.get();
+  do {
+    EXPECT_LE(cur->capacity(), 128 * 1024);
+    cur = cur->next();
+  } while (cur != uncompressedData.get());
+  EXPECT_EQ(value, uncompressedData->moveToFbString().toStdString());
+}
 #endif // FOLLY_HAVE_LIBZSTD && !defined(DISABLE_COMPRESSION)
 
 TEST(Lz4ImmutableCompressionCodec, compressAndUncompress) {
@@ -0,0 +1,49 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <gtest/gtest.h>
+
+#include "mcrouter/lib/CountMinSketch.h"
+
+using namespace facebook::memcache;
+
+TEST(CountMinSketch, estimates) {
+  CountMinSketch sketch(64, 1000);
+  EXPECT_EQ(0, sketch.estimate("a"));
+  EXPECT_EQ(1, sketch.increment("a"));
+  EXPECT_EQ(2, sketch.increment("a"));
+  EXPECT_EQ(2, sketch.estimate("a"));
+  EXPECT_EQ(0, sketch.estimate("b"));
+}
+
+TEST(CountMinSketch, saturates) {
+  CountMinSketch sketch(64, 15);
+  for (size_t i = 0; i < 100; ++i) {
+    sketch.increment("a");
+  }
+  EXPECT_EQ(15, sketch.estimate("a"));
+}
+
+TEST(CountMinSketch, halve) {
+  CountMinSketch sketch(64, 1000);
+  for (size_t i = 0; i < 10; ++i) {
+    sketch.increment("a");
+  }
+  sketch.halve();
+  EXPECT_EQ(5, sketch.estimate("a"));
+}
+
+TEST(CountMinSketch, resetPeriod) {
+  CountMinSketch sketch(64, 1000, 8 /* resetPeriod */);
+  for (size_t i = 0; i < 7; ++i) {
+    sketch.increment("a");
+  }
+  EXPECT_EQ(7, sketch.estimate("a"));
+  // The 8th increment triggers halving.
+  sketch.increment("a");
+  EXPECT_EQ(4, sketch.estimate("a"));
+}
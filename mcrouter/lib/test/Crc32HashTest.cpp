@@ -6,10 +6,14 @@
  *
  */
 #include <algorithm>
+#include <random>
+#include <string>
 
 #include <gtest/gtest.h>
 
 #include "mcrouter/lib/Crc32HashFunc.h"
+#include "mcrouter/lib/Crc32HashHelper.h"
+#include "mcrouter/lib/fbi/hash.h"
 
 using namespace facebook::memcache;
 
@@ -43,3 +47,23 @@ TEST(Crc32Func, basic) {
   std::reverse(test_max_key.begin(), test_max_key.end());
   EXPECT_EQ(97630, func_99999(test_max_key));
 }
+
+TEST(Crc32Func, kernels) {
+  EXPECT_EQ(0xcbf43926, crc32Hash("123456789", 9));
+  if (bestCrc32Kernel() == Crc32Kernel::SCALAR) {
+    return;
+  }
+  std::mt19937 gen(42);
+  for (size_t len = 0; len < 300; ++len) {
+    std::string key(len + 1, '\0');
+    for (auto& c : key) {
+      c = gen();
+    }
+    // Unaligned keys too.
+    for (size_t offset = 0; offset < 2; ++offset) {
+      EXPECT_EQ(
+          crc32_hash(key.data() + offset, len),
+          crc32Hash(key.data() + offset, len));
+    }
+  }
+}
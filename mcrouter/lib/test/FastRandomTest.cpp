@@ -0,0 +1,46 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/lib/FastRandom.h"
+
+using namespace facebook::memcache;
+
+TEST(FastRandom, deterministic) {
+  WyRand gen1(42);
+  WyRand gen2(42);
+  WyRand gen3(43);
+  bool differs = false;
+  for (int i = 0; i < 100; ++i) {
+    const auto x = gen1();
+    EXPECT_EQ(x, gen2());
+    differs |= x != gen3();
+  }
+  EXPECT_TRUE(differs);
+}
+
+TEST(FastRandom, randomIndex) {
+  EXPECT_EQ(0, randomIndex(0, 10));
+  EXPECT_EQ(9, randomIndex(UINT64_MAX, 10));
+  EXPECT_EQ(0, randomIndex(UINT64_MAX, 1));
+
+  constexpr size_t kBuckets = 7;
+  constexpr size_t kRounds = 70000;
+  std::vector<size_t> counts(kBuckets);
+  WyRand gen(1);
+  for (size_t i = 0; i < kRounds; ++i) {
+    auto idx = randomIndex(gen(), kBuckets);
+    ASSERT_LT(idx, kBuckets);
+    ++counts[idx];
+  }
+  for (auto count : counts) {
+    EXPECT_NEAR(kRounds / kBuckets, count, kRounds / kBuckets / 10);
+  }
+}
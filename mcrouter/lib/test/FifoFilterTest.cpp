@@ -0,0 +1,66 @@
+/*
+ *  Copyright (c) 2016-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <gtest/gtest.h>
+
+#include "mcrouter/lib/debug/FifoFilter.h"
+
+using namespace facebook::memcache;
+
+TEST(FifoFilter, matchesType) {
+  FifoFilter filter;
+  EXPECT_TRUE(filter.matchesType(1));
+  EXPECT_TRUE(filter.matchesType(4));
+
+  filter.typeIds = {1, 5};
+  EXPECT_TRUE(filter.matchesType(1));
+  EXPECT_TRUE(filter.matchesType(2)); // reply of 1
+  EXPECT_FALSE(filter.matchesType(3));
+  EXPECT_FALSE(filter.matchesType(4));
+  EXPECT_TRUE(filter.matchesType(6)); // reply of 5
+  // Unknown type.
+  EXPECT_TRUE(filter.matchesType(0));
+}
+
+TEST(FifoFilter, matchesRequest) {
+  FifoFilter filter;
+  EXPECT_TRUE(filter.matchesRequest("anything", 1000));
+
+  filter.keyPrefix = "foo:";
+  filter.valueMinSize = 10;
+  filter.valueMaxSize = 100;
+  EXPECT_TRUE(filter.matchesRequest("foo:bar", 10));
+  EXPECT_TRUE(filter.matchesRequest("foo:bar", 100));
+  EXPECT_FALSE(filter.matchesRequest("foo:bar", 9));
+  EXPECT_FALSE(filter.matchesRequest("foo:bar", 101));
+  EXPECT_FALSE(filter.matchesRequest("bar:foo", 50));
+}
+
+TEST(FifoFilter, json) {
+  FifoFilter filter;
+  filter.typeIds = {1, 7};
+  filter.keyPrefix = "foo:";
+  filter.valueMinSize = 1;
+  filter.valueMaxSize = 2;
+  filter.sampleRate = 100;
+
+  auto parsed = FifoFilter::fromJson(filter.toJson());
+  ASSERT_TRUE(parsed.hasValue());
+  EXPECT_EQ(filter.typeIds, parsed->typeIds);
+  EXPECT_EQ(filter.keyPrefix, parsed->keyPrefix);
+  EXPECT_EQ(filter.valueMinSize, parsed->valueMinSize);
+  EXPECT_EQ(filter.valueMaxSize, parsed->valueMaxSize);
+  EXPECT_EQ(filter.sampleRate, parsed->sampleRate);
+
+  parsed = FifoFilter::fromJson("{}");
+  ASSERT_TRUE(parsed.hasValue());
+  EXPECT_TRUE(parsed->typeIds.empty());
+  EXPECT_EQ(1, parsed->sampleRate);
+
+  EXPECT_FALSE(FifoFilter::fromJson("not json").hasValue());
+  EXPECT_FALSE(FifoFilter::fromJson("{\"key_prefix\": 1}").hasValue());
+}
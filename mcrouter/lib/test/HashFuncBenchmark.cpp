@@ -0,0 +1,169 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <random>
+#include <string>
+#include <vector>
+
+#include <folly/Benchmark.h>
+#include <folly/Format.h>
+#include <folly/Optional.h>
+#include <folly/init/Init.h>
+
+#include "mcrouter/lib/Ch3HashFunc.h"
+#include "mcrouter/lib/Crc32HashHelper.h"
+#include "mcrouter/lib/JumpHashFunc.h"
+#include "mcrouter/lib/MaglevHashFunc.h"
+#include "mcrouter/lib/WeightedCh3HashFunc.h"
+
+using namespace facebook::memcache;
+
+namespace {
+
+constexpr size_t kNumKeys = 1024;
+
+const std::vector<std::string>& keys() {
+  static const std::vector<std::string> kKeys = []() {
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < kNumKeys; ++i) {
+      keys.push_back(folly::sformat("someprefix:{}:somesuffix", i));
+    }
+    return keys;
+  }();
+  return kKeys;
+}
+
+// Weights between 0.5 and 1.0, like in a pool with several hardware types.
+std::vector<double> weights(size_t n) {
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<double> dist(0.5, 1.0);
+  std::vector<double> weights;
+  for (size_t i = 0; i < n; ++i) {
+    weights.push_back(dist(gen));
+  }
+  return weights;
+}
+
+template <class HashFunc>
+void hashKeys(size_t iters, const HashFunc& func) {
+  const auto& allKeys = keys();
+  for (size_t i = 0; i < iters; ++i) {
+    folly::doNotOptimizeAway(func(allKeys[i % kNumKeys]));
+  }
+}
+
+void ch3(size_t iters, size_t n) {
+  folly::Optional<Ch3HashFunc> func;
+  BENCHMARK_SUSPEND {
+    func.emplace(n);
+  }
+  hashKeys(iters, *func);
+}
+
+void weightedCh3(size_t iters, size_t n) {
+  folly::Optional<WeightedCh3HashFunc> func;
+  BENCHMARK_SUSPEND {
+    func.emplace(weights(n));
+  }
+  hashKeys(iters, *func);
+}
+
+void maglev(size_t iters, size_t n) {
+  folly::Optional<MaglevHashFunc> func;
+  BENCHMARK_SUSPEND {
+    func.emplace(weights(n));
+  }
+  hashKeys(iters, *func);
+}
+
+void maglevBuild(size_t iters, size_t n) {
+  std::vector<double> w;
+  BENCHMARK_SUSPEND {
+    w = weights(n);
+  }
+  for (size_t i = 0; i < iters; ++i) {
+    MaglevHashFunc func(w);
+    folly::doNotOptimizeAway(func);
+  }
+}
+
+void jump(size_t iters, size_t n) {
+  folly::Optional<JumpHashFunc> func;
+  BENCHMARK_SUSPEND {
+    func.emplace(n);
+  }
+  hashKeys(iters, *func);
+}
+
+void crc32(size_t iters, size_t keyLength, Crc32Kernel kernel) {
+  std::vector<std::string> lengthKeys;
+  BENCHMARK_SUSPEND {
+    for (const auto& key : keys()) {
+      auto k = key;
+      k.resize(keyLength, 'x');
+      lengthKeys.push_back(std::move(k));
+    }
+  }
+  for (size_t i = 0; i < iters; ++i) {
+    const auto& key = lengthKeys[i % kNumKeys];
+    folly::doNotOptimizeAway(crc32Hash(key.data(), key.size(), kernel));
+  }
+}
+
+void crc32Scalar(size_t iters, size_t keyLength) {
+  crc32(iters, keyLength, Crc32Kernel::SCALAR);
+}
+
+void crc32Best(size_t iters, size_t keyLength) {
+  crc32(iters, keyLength, bestCrc32Kernel());
+}
+
+} // anonymous namespace
+
+BENCHMARK_PARAM(ch3, 100)
+BENCHMARK_RELATIVE_PARAM(weightedCh3, 100)
+BENCHMARK_RELATIVE_PARAM(maglev, 100)
+BENCHMARK_RELATIVE_PARAM(jump, 100)
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK_PARAM(ch3, 2000)
+BENCHMARK_RELATIVE_PARAM(weightedCh3, 2000)
+BENCHMARK_RELATIVE_PARAM(maglev, 2000)
+BENCHMARK_RELATIVE_PARAM(jump, 2000)
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK_PARAM(ch3, 20000)
+BENCHMARK_RELATIVE_PARAM(weightedCh3, 20000)
+BENCHMARK_RELATIVE_PARAM(maglev, 20000)
+BENCHMARK_RELATIVE_PARAM(jump, 20000)
+
+BENCHMARK_DRAW_LINE();
+
+// Table construction, done once per config load.
+BENCHMARK_PARAM(maglevBuild, 2000)
+
+BENCHMARK_DRAW_LINE();
+
+// By key length.
+BENCHMARK_PARAM(crc32Scalar, 16)
+BENCHMARK_RELATIVE_PARAM(crc32Best, 16)
+BENCHMARK_PARAM(crc32Scalar, 32)
+BENCHMARK_RELATIVE_PARAM(crc32Best, 32)
+BENCHMARK_PARAM(crc32Scalar, 64)
+BENCHMARK_RELATIVE_PARAM(crc32Best, 64)
+BENCHMARK_PARAM(crc32Scalar, 128)
+BENCHMARK_RELATIVE_PARAM(crc32Best, 128)
+BENCHMARK_PARAM(crc32Scalar, 250)
+BENCHMARK_RELATIVE_PARAM(crc32Best, 250)
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv, true /* removeFlags */);
+  folly::runBenchmarks();
+  return 0;
+}
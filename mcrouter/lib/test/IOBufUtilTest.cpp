@@ -0,0 +1,61 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <folly/io/IOBuf.h>
+
+#include "mcrouter/lib/IOBufUtil.h"
+
+using namespace facebook::memcache;
+
+namespace {
+
+struct iovec toIovec(const void* data, size_t len) {
+  return {const_cast<void*>(data), len};
+}
+
+} // anonymous namespace
+
+TEST(IOBufUtil, iovecsToSharedIOBufCopiesWithoutOwner) {
+  std::string header = "VALUE key 0 5\r\n";
+  std::string value = "12345";
+  struct iovec iovs[] = {toIovec(header.data(), header.size()),
+                         toIovec(value.data(), value.size())};
+
+  auto buf = iovecsToSharedIOBuf(iovs, 2, nullptr);
+  EXPECT_EQ(header + value, buf->moveToFbString().toStdString());
+}
+
+TEST(IOBufUtil, iovecsToSharedIOBufSharesOwner) {
+  std::string header = "VALUE key 0 5\r\n";
+  std::string footer = "\r\nEND\r\n";
+  auto value = folly::IOBuf::copyBuffer("0123456789");
+  struct iovec iovs[] = {toIovec(header.data(), header.size()),
+                         toIovec(value->data() + 2, 5),
+                         toIovec(footer.data(), footer.size())};
+
+  auto buf = iovecsToSharedIOBuf(iovs, 3, value.get());
+  EXPECT_EQ(3, buf->countChainElements());
+  EXPECT_TRUE(value->isShared());
+  // The middle element references the owner's memory.
+  EXPECT_EQ(value->data() + 2, buf->next()->data());
+  EXPECT_EQ(5, buf->next()->length());
+  EXPECT_EQ(header + "23456" + footer, buf->moveToFbString().toStdString());
+}
+
+TEST(IOBufUtil, iovecsToSharedIOBufCopiesUnmanagedOwner) {
+  std::string data = "0123456789";
+  folly::IOBuf value(folly::IOBuf::WRAP_BUFFER, data.data(), data.size());
+  struct iovec iovs[] = {toIovec(data.data(), data.size())};
+
+  auto buf = iovecsToSharedIOBuf(iovs, 1, &value);
+  EXPECT_NE(reinterpret_cast<const uint8_t*>(data.data()), buf->data());
+  EXPECT_EQ(data, buf->moveToFbString().toStdString());
+}
@@ -0,0 +1,55 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <folly/Conv.h>
+
+#include "mcrouter/lib/JumpHashFunc.h"
+
+using namespace facebook::memcache;
+
+TEST(JumpHashFunc, basic) {
+  JumpHashFunc func_1(1);
+  EXPECT_EQ(0, func_1(""));
+  EXPECT_EQ(0, func_1("sample"));
+
+  // Known values of the reference implementation.
+  EXPECT_EQ(0, jumpConsistentHash(0, 100));
+  EXPECT_EQ(55, jumpConsistentHash(1, 100));
+  EXPECT_EQ(87, jumpConsistentHash(0xdeadbeef, 100));
+
+  EXPECT_THROW(JumpHashFunc(0), std::logic_error);
+}
+
+TEST(JumpHashFunc, balanced) {
+  JumpHashFunc func(10);
+  std::vector<size_t> counts(10, 0);
+  for (size_t i = 0; i < 100000; ++i) {
+    ++counts[func(folly::to<std::string>(i))];
+  }
+  for (auto count : counts) {
+    EXPECT_NEAR(10000, count, 500);
+  }
+}
+
+TEST(JumpHashFunc, addServer) {
+  JumpHashFunc before(10);
+  JumpHashFunc after(11);
+  size_t moved = 0;
+  for (size_t i = 0; i < 10000; ++i) {
+    auto key = folly::to<std::string>(i);
+    if (before(key) != after(key)) {
+      // Keys only move to the new server.
+      EXPECT_EQ(10, after(key));
+      ++moved;
+    }
+  }
+  EXPECT_NEAR(10000 / 11, moved, 100);
+}
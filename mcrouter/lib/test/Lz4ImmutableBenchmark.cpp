@@ -0,0 +1,189 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <string>
+#include <vector>
+
+#include <folly/Benchmark.h>
+#include <folly/Format.h>
+#include <folly/Random.h>
+#include <folly/init/Init.h>
+#include <folly/io/IOBuf.h>
+#include <lz4.h>
+
+#include "mcrouter/lib/Lz4Immutable.h"
+
+using namespace facebook::memcache;
+
+namespace {
+
+constexpr size_t kNumValues = 64;
+
+// Serialized-object-like values, so that the dictionary helps.
+std::string makeValue(size_t size, uint32_t seed) {
+  std::string value;
+  while (value.size() < size) {
+    value.append(folly::sformat(
+        "{{\"id\":{},\"type\":\"user\",\"name\":\"name{}\",\"active\":{},"
+        "\"friends\":[{},{},{}]}}",
+        seed,
+        seed % 97,
+        seed % 2 == 0 ? "true" : "false",
+        seed * 7,
+        seed * 13,
+        seed * 31));
+    seed = seed * 1103515245 + 12345;
+  }
+  value.resize(size);
+  return value;
+}
+
+const folly::IOBuf& dictionary() {
+  static const auto kDictionary = []() {
+    std::string dic;
+    for (uint32_t i = 0; dic.size() < 16 * 1024; ++i) {
+      dic.append(makeValue(200, i));
+    }
+    return folly::IOBuf::copyBuffer(dic);
+  }();
+  return *kDictionary;
+}
+
+std::vector<std::unique_ptr<folly::IOBuf>> values(size_t size) {
+  std::vector<std::unique_ptr<folly::IOBuf>> result;
+  for (size_t i = 0; i < kNumValues; ++i) {
+    result.push_back(
+        folly::IOBuf::copyBuffer(makeValue(size, folly::Random::rand32())));
+  }
+  return result;
+}
+
+class Lz4Upstream {
+ public:
+  Lz4Upstream() : stream_(LZ4_createStream()) {
+    LZ4_loadDict(
+        stream_,
+        reinterpret_cast<const char*>(dictionary().data()),
+        dictionary().length());
+  }
+  ~Lz4Upstream() {
+    LZ4_freeStream(stream_);
+  }
+
+  std::unique_ptr<folly::IOBuf> compress(const folly::IOBuf& data) const {
+    LZ4_stream_t streamCopy = *stream_;
+    const size_t bound = LZ4_compressBound(data.length());
+    auto buffer = folly::IOBuf::create(bound);
+    const int size = LZ4_compress_fast_continue(
+        &streamCopy,
+        reinterpret_cast<const char*>(data.data()),
+        reinterpret_cast<char*>(buffer->writableTail()),
+        data.length(),
+        bound,
+        1);
+    buffer->append(size);
+    return buffer;
+  }
+
+  std::unique_ptr<folly::IOBuf> decompress(
+      const folly::IOBuf& data,
+      size_t uncompressedSize) const {
+    auto buffer = folly::IOBuf::create(uncompressedSize);
+    const int size = LZ4_decompress_safe_usingDict(
+        reinterpret_cast<const char*>(data.data()),
+        reinterpret_cast<char*>(buffer->writableTail()),
+        data.length(),
+        uncompressedSize,
+        reinterpret_cast<const char*>(dictionary().data()),
+        dictionary().length());
+    buffer->append(size);
+    return buffer;
+  }
+
+ private:
+  LZ4_stream_t* stream_;
+};
+
+template <class Codec>
+void compress(size_t iters, size_t size) {
+  std::unique_ptr<Codec> codec;
+  std::vector<std::unique_ptr<folly::IOBuf>> data;
+  BENCHMARK_SUSPEND {
+    codec = std::make_unique<Codec>();
+    data = values(size);
+  }
+  for (size_t i = 0; i < iters; ++i) {
+    folly::doNotOptimizeAway(codec->compress(*data[i % kNumValues]));
+  }
+}
+
+template <class Codec>
+void decompress(size_t iters, size_t size) {
+  std::unique_ptr<Codec> codec;
+  std::vector<std::unique_ptr<folly::IOBuf>> data;
+  BENCHMARK_SUSPEND {
+    codec = std::make_unique<Codec>();
+    for (auto& value : values(size)) {
+      data.push_back(codec->compress(*value));
+    }
+  }
+  for (size_t i = 0; i < iters; ++i) {
+    folly::doNotOptimizeAway(codec->decompress(*data[i % kNumValues], size));
+  }
+}
+
+class Lz4ImmutableCodec : public Lz4Immutable {
+ public:
+  Lz4ImmutableCodec() : Lz4Immutable(dictionary().clone()) {}
+};
+
+void lz4Compress(size_t iters, size_t size) {
+  compress<Lz4Upstream>(iters, size);
+}
+void lz4ImmutableCompress(size_t iters, size_t size) {
+  compress<Lz4ImmutableCodec>(iters, size);
+}
+void lz4Decompress(size_t iters, size_t size) {
+  decompress<Lz4Upstream>(iters, size);
+}
+void lz4ImmutableDecompress(size_t iters, size_t size) {
+  decompress<Lz4ImmutableCodec>(iters, size);
+}
+
+} // anonymous namespace
+
+BENCHMARK_PARAM(lz4Compress, 200)
+BENCHMARK_RELATIVE_PARAM(lz4ImmutableCompress, 200)
+BENCHMARK_PARAM(lz4Decompress, 200)
+BENCHMARK_RELATIVE_PARAM(lz4ImmutableDecompress, 200)
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK_PARAM(lz4Compress, 1024)
+BENCHMARK_RELATIVE_PARAM(lz4ImmutableCompress, 1024)
+BENCHMARK_PARAM(lz4Decompress, 1024)
+BENCHMARK_RELATIVE_PARAM(lz4ImmutableDecompress, 1024)
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK_PARAM(lz4Compress, 4096)
+BENCHMARK_RELATIVE_PARAM(lz4ImmutableCompress, 4096)
+BENCHMARK_PARAM(lz4Decompress, 4096)
+BENCHMARK_RELATIVE_PARAM(lz4ImmutableDecompress, 4096)
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK_PARAM(lz4Compress, 16384)
+BENCHMARK_RELATIVE_PARAM(lz4ImmutableCompress, 16384)
+BENCHMARK_PARAM(lz4Decompress, 16384)
+BENCHMARK_RELATIVE_PARAM(lz4ImmutableDecompress, 16384)
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv, true /* removeFlags */);
+  folly::runBenchmarks();
+  return 0;
+}
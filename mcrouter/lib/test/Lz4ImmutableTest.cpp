@@ -391,3 +391,13 @@ TEST(Lz4Immutable, compress_into) {
   decompressed = compressor.decompress(&iov, 1, source->length());
   checkEqual(source, decompressed);
 }
+
+TEST(Lz4Immutable, decompress_wrongSize) {
+  Lz4Immutable compressor(getAsciiDictionary());
+  auto source = getRandomAsciiData();
+  auto compressed = compressor.compress(*source);
+
+  // Data doesn't fit, must fail instead of writing past the buffer.
+  EXPECT_EQ(
+      nullptr, compressor.decompress(*compressed, source->length() - 10));
+}
@@ -0,0 +1,92 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <algorithm>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <folly/Conv.h>
+#include <folly/json.h>
+
+#include "mcrouter/lib/MaglevHashFunc.h"
+
+using namespace facebook::memcache;
+
+namespace {
+
+std::vector<size_t> keyCounts(const MaglevHashFunc& func, size_t n) {
+  std::vector<size_t> counts(n, 0);
+  for (size_t i = 0; i < 100000; ++i) {
+    auto idx = func(folly::to<std::string>("key:", i));
+    EXPECT_LT(idx, n);
+    ++counts[idx];
+  }
+  return counts;
+}
+
+} // anonymous namespace
+
+TEST(MaglevHashFunc, tableSize) {
+  EXPECT_EQ(65537, MaglevHashFunc(std::vector<double>(1, 1.0)).tableSize());
+  EXPECT_EQ(262147, MaglevHashFunc(std::vector<double>(2000, 1.0)).tableSize());
+}
+
+TEST(MaglevHashFunc, singleServer) {
+  MaglevHashFunc func(std::vector<double>(1, 1.0));
+  EXPECT_EQ(0, func(""));
+  EXPECT_EQ(0, func("sample"));
+}
+
+TEST(MaglevHashFunc, balanced) {
+  MaglevHashFunc func(std::vector<double>(10, 1.0));
+  for (auto count : keyCounts(func, 10)) {
+    EXPECT_NEAR(10000, count, 500);
+  }
+}
+
+TEST(MaglevHashFunc, weighted) {
+  MaglevHashFunc func({1.0, 0.5, 0.0, 1.0});
+  auto counts = keyCounts(func, 4);
+  EXPECT_NEAR(40000, counts[0], 1000);
+  EXPECT_NEAR(20000, counts[1], 1000);
+  EXPECT_EQ(0, counts[2]);
+  EXPECT_NEAR(40000, counts[3], 1000);
+}
+
+TEST(MaglevHashFunc, reducedWeight) {
+  std::vector<double> weights(10, 1.0);
+  MaglevHashFunc before(weights);
+  weights[3] = 0.7;
+  MaglevHashFunc after(weights);
+
+  size_t moved = 0;
+  for (size_t i = 0; i < 10000; ++i) {
+    auto key = folly::to<std::string>(i);
+    if (before(key) != after(key)) {
+      ++moved;
+      EXPECT_NE(3, after(key));
+    }
+  }
+  // ~3% of the keys have to move off server 3; few others should.
+  EXPECT_LT(moved, 600);
+}
+
+TEST(MaglevHashFunc, json) {
+  MaglevHashFunc func(folly::parseJson(R"({"weights": [1.0, 0.0]})"), 2);
+  for (size_t i = 0; i < 100; ++i) {
+    EXPECT_EQ(0, func(folly::to<std::string>(i)));
+  }
+  MaglevHashFunc unweighted(folly::dynamic::object(), 2);
+  EXPECT_NEAR(50000, keyCounts(unweighted, 2)[1], 1000);
+}
+
+TEST(MaglevHashFunc, invalidWeights) {
+  EXPECT_THROW(MaglevHashFunc({0.0, 0.0}), std::logic_error);
+  EXPECT_THROW(MaglevHashFunc({1.0, -1.0}), std::logic_error);
+  EXPECT_THROW(MaglevHashFunc(std::vector<double>()), std::logic_error);
+}
@@ -0,0 +1,46 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <folly/Conv.h>
+
+#include "mcrouter/lib/PerfectStringIndex.h"
+
+using namespace facebook::memcache;
+
+TEST(PerfectStringIndex, empty) {
+  PerfectStringIndex index;
+  EXPECT_EQ(0, index.size());
+  EXPECT_EQ(PerfectStringIndex::kNotFound, index.find(""));
+  EXPECT_EQ(PerfectStringIndex::kNotFound, index.find("/a/b/"));
+}
+
+TEST(PerfectStringIndex, findsEveryKey) {
+  for (size_t n : {1, 2, 3, 17, 1000}) {
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < n; ++i) {
+      keys.push_back(folly::to<std::string>("/region", i % 7, "/c", i, "/"));
+    }
+    PerfectStringIndex index(keys);
+    EXPECT_EQ(n, index.size());
+    for (size_t i = 0; i < n; ++i) {
+      EXPECT_EQ(i, index.find(keys[i]));
+    }
+    EXPECT_EQ(PerfectStringIndex::kNotFound, index.find(""));
+    EXPECT_EQ(PerfectStringIndex::kNotFound, index.find("/region0/c/"));
+    EXPECT_EQ(PerfectStringIndex::kNotFound, index.find("/region0/c0"));
+  }
+}
+
+TEST(PerfectStringIndex, duplicates) {
+  std::vector<std::string> keys = {"/a/b/", "/a/c/", "/a/b/"};
+  EXPECT_THROW(PerfectStringIndex{keys}, std::logic_error);
+}
@@ -0,0 +1,81 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <chrono>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <folly/Benchmark.h>
+#include <folly/init/Init.h>
+
+#include "mcrouter/lib/FastRandom.h"
+#include "mcrouter/lib/network/gen/Memcache.h"
+#include "mcrouter/lib/routes/RandomRoute.h"
+#include "mcrouter/lib/test/RouteHandleTestUtil.h"
+#include "mcrouter/lib/test/TestRouteHandle.h"
+
+using namespace facebook::memcache;
+
+namespace {
+
+using TestHandle = TestHandleImpl<TestRouteHandleIf>;
+
+// Selection alone, the way RandomRoute picked a child before and now.
+
+void ranluxModulo(size_t iters, size_t n) {
+  std::ranlux24_base gen(
+      std::chrono::system_clock::now().time_since_epoch().count());
+  for (size_t i = 0; i < iters; ++i) {
+    folly::doNotOptimizeAway(gen() % n);
+  }
+}
+
+void wyRandIndex(size_t iters, size_t n) {
+  WyRand gen(42);
+  for (size_t i = 0; i < iters; ++i) {
+    folly::doNotOptimizeAway(randomIndex(gen(), n));
+  }
+}
+
+void randomRoute(size_t iters, size_t n) {
+  std::unique_ptr<TestRouteHandle<RandomRoute<TestRouteHandleIf>>> rh;
+  McGetRequest req("key");
+  BENCHMARK_SUSPEND {
+    std::vector<std::shared_ptr<TestHandle>> handles;
+    for (size_t i = 0; i < n; ++i) {
+      handles.push_back(
+          std::make_shared<TestHandle>(GetRouteTestData(mc_res_found, "a")));
+    }
+    rh = std::make_unique<TestRouteHandle<RandomRoute<TestRouteHandleIf>>>(
+        get_route_handles(handles));
+  }
+  for (size_t i = 0; i < iters; ++i) {
+    folly::doNotOptimizeAway(rh->route(req));
+  }
+}
+
+} // anonymous namespace
+
+BENCHMARK_PARAM(ranluxModulo, 3)
+BENCHMARK_RELATIVE_PARAM(wyRandIndex, 3)
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK_PARAM(ranluxModulo, 100)
+BENCHMARK_RELATIVE_PARAM(wyRandIndex, 100)
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK_PARAM(randomRoute, 3)
+BENCHMARK_PARAM(randomRoute, 100)
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv, true /* removeFlags */);
+  folly::runBenchmarks();
+  return 0;
+}
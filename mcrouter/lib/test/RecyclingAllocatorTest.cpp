@@ -0,0 +1,82 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <memory>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/lib/RecyclingAllocator.h"
+
+using namespace facebook::memcache;
+
+namespace {
+
+struct Block {
+  char data[100];
+};
+
+struct Counted {
+  explicit Counted(int& destroyed_) : destroyed(destroyed_) {}
+  ~Counted() {
+    ++destroyed;
+  }
+  int& destroyed;
+};
+
+} // anonymous namespace
+
+TEST(ThreadLocalRecycler, reuse) {
+  using Recycler = ThreadLocalRecycler<Block, 2>;
+  auto p1 = Recycler::allocate();
+  auto p2 = Recycler::allocate();
+  auto p3 = Recycler::allocate();
+  EXPECT_EQ(0, Recycler::cachedBlocks());
+
+  Recycler::deallocate(p1);
+  Recycler::deallocate(p2);
+  // Over the limit, freed.
+  Recycler::deallocate(p3);
+  EXPECT_EQ(2, Recycler::cachedBlocks());
+
+  EXPECT_EQ(p2, Recycler::allocate());
+  EXPECT_EQ(p1, Recycler::allocate());
+  EXPECT_EQ(0, Recycler::cachedBlocks());
+
+  // Freed on another thread, cached there.
+  std::thread([p1]() {
+    Recycler::deallocate(p1);
+    EXPECT_EQ(1, Recycler::cachedBlocks());
+  }).join();
+  EXPECT_EQ(0, Recycler::cachedBlocks());
+  Recycler::deallocate(p2);
+}
+
+TEST(RecyclingAllocator, sharedPtr) {
+  int destroyed = 0;
+  void* controlBlock = nullptr;
+  {
+    std::shared_ptr<Counted> ptr(
+        new Counted(destroyed),
+        [](Counted* c) { delete c; },
+        RecyclingAllocator<Counted>());
+  }
+  EXPECT_EQ(1, destroyed);
+
+  // The control block of the next pointer reuses the memory of the first.
+  {
+    auto ptr = std::allocate_shared<Counted>(
+        RecyclingAllocator<Counted>(), destroyed);
+    controlBlock = ptr.get();
+  }
+  {
+    auto ptr = std::allocate_shared<Counted>(
+        RecyclingAllocator<Counted>(), destroyed);
+    EXPECT_EQ(controlBlock, ptr.get());
+  }
+  EXPECT_EQ(3, destroyed);
+}
@@ -0,0 +1,75 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <chrono>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/lib/RefillLimiter.h"
+
+using namespace facebook::memcache;
+
+using Result = RefillLimiter::Result;
+using std::chrono::milliseconds;
+
+TEST(RefillLimiter, noLimits) {
+  RefillLimiter limiter(RefillLimiter::Options{});
+  for (size_t i = 0; i < 100; ++i) {
+    EXPECT_EQ(Result::Admitted, limiter.admit("key"));
+  }
+  EXPECT_EQ(100, limiter.outstanding());
+}
+
+TEST(RefillLimiter, dedup) {
+  RefillLimiter::Options opts;
+  opts.dedupWindow = milliseconds(100);
+  RefillLimiter limiter(opts);
+
+  auto now = RefillLimiter::Clock::now();
+  EXPECT_EQ(Result::Admitted, limiter.admit("a", now));
+  EXPECT_EQ(Result::Admitted, limiter.admit("b", now));
+  EXPECT_EQ(Result::Deduped, limiter.admit("a", now + milliseconds(50)));
+  // Completion doesn't matter, only the time since the last refill.
+  limiter.done();
+  EXPECT_EQ(Result::Deduped, limiter.admit("a", now + milliseconds(99)));
+  EXPECT_EQ(Result::Admitted, limiter.admit("a", now + milliseconds(100)));
+  EXPECT_EQ(Result::Admitted, limiter.admit("b", now + milliseconds(100)));
+}
+
+TEST(RefillLimiter, maxOutstanding) {
+  RefillLimiter::Options opts;
+  opts.maxOutstanding = 2;
+  RefillLimiter limiter(opts);
+
+  EXPECT_EQ(Result::Admitted, limiter.admit("a"));
+  EXPECT_EQ(Result::Admitted, limiter.admit("b"));
+  EXPECT_EQ(Result::Dropped, limiter.admit("c"));
+  limiter.done();
+  EXPECT_EQ(Result::Admitted, limiter.admit("c"));
+}
+
+TEST(RefillLimiter, maxRate) {
+  RefillLimiter::Options opts;
+  opts.maxRate = 3;
+  std::vector<Result> results;
+  RefillLimiter limiter(opts, [&results](Result r) { results.push_back(r); });
+
+  auto now = RefillLimiter::Clock::now();
+  for (size_t i = 0; i < 5; ++i) {
+    limiter.admit("key", now + milliseconds(i));
+  }
+  EXPECT_EQ(
+      (std::vector<Result>{Result::Admitted,
+                           Result::Admitted,
+                           Result::Admitted,
+                           Result::Dropped,
+                           Result::Dropped}),
+      results);
+
+  EXPECT_EQ(Result::Admitted, limiter.admit("key", now + milliseconds(1000)));
+}
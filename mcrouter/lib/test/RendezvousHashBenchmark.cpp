@@ -0,0 +1,113 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <random>
+#include <string>
+#include <vector>
+
+#include <folly/Benchmark.h>
+#include <folly/Format.h>
+#include <folly/Optional.h>
+#include <folly/init/Init.h>
+
+#include "mcrouter/lib/RendezvousHashFunc.h"
+#include "mcrouter/lib/RendezvousHashHelper.h"
+#include "mcrouter/lib/WeightedRendezvousHashFunc.h"
+#include "mcrouter/lib/test/HashTestUtil.h"
+
+using namespace facebook::memcache;
+
+namespace {
+
+constexpr size_t kNumKeys = 1024;
+
+std::vector<uint64_t> randomHashes(size_t n) {
+  std::mt19937_64 gen(42);
+  std::vector<uint64_t> hashes(n);
+  for (auto& hash : hashes) {
+    hash = gen();
+  }
+  return hashes;
+}
+
+void maxScorePos(size_t iters, size_t n, RendezvousKernel kernel) {
+  std::vector<uint64_t> hashes;
+  std::vector<uint64_t> keyHashes;
+  BENCHMARK_SUSPEND {
+    hashes = randomHashes(n);
+    keyHashes = randomHashes(kNumKeys);
+  }
+  for (size_t i = 0; i < iters; ++i) {
+    folly::doNotOptimizeAway(rendezvousMaxScorePos(
+        hashes.data(), n, keyHashes[i % kNumKeys], kernel));
+  }
+}
+
+void scalar(size_t iters, size_t n) {
+  maxScorePos(iters, n, RendezvousKernel::SCALAR);
+}
+
+void best(size_t iters, size_t n) {
+  maxScorePos(iters, n, bestRendezvousKernel());
+}
+
+std::vector<std::string> genKeys() {
+  std::vector<std::string> keys;
+  for (size_t i = 0; i < kNumKeys; ++i) {
+    keys.push_back(folly::sformat("someprefix:{}:somesuffix", i));
+  }
+  return keys;
+}
+
+void rendezvousFunc(size_t iters, size_t n) {
+  std::vector<std::string> keys;
+  auto endpoints = test::genEndpoints(n);
+  folly::Optional<RendezvousHashFunc> func;
+  BENCHMARK_SUSPEND {
+    keys = genKeys();
+    func.emplace(endpoints.second);
+  }
+  for (size_t i = 0; i < iters; ++i) {
+    folly::doNotOptimizeAway((*func)(keys[i % kNumKeys]));
+  }
+}
+
+void weightedRendezvousFunc(size_t iters, size_t n) {
+  std::vector<std::string> keys;
+  auto endpoints = test::genEndpoints(n);
+  folly::Optional<WeightedRendezvousHashFunc> func;
+  BENCHMARK_SUSPEND {
+    keys = genKeys();
+    func.emplace(
+        endpoints.second,
+        test::genWeights(endpoints.second, std::vector<double>(n, 0.75)));
+  }
+  for (size_t i = 0; i < iters; ++i) {
+    folly::doNotOptimizeAway((*func)(keys[i % kNumKeys]));
+  }
+}
+
+} // anonymous namespace
+
+BENCHMARK_PARAM(scalar, 50)
+BENCHMARK_RELATIVE_PARAM(best, 50)
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK_PARAM(scalar, 500)
+BENCHMARK_RELATIVE_PARAM(best, 500)
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK_PARAM(rendezvousFunc, 500)
+BENCHMARK_PARAM(weightedRendezvousFunc, 500)
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv, true /* removeFlags */);
+  folly::runBenchmarks();
+  return 0;
+}
@@ -6,12 +6,14 @@
  *
  */
 #include <algorithm>
+#include <random>
 
 #include <gtest/gtest.h>
 
 #include <folly/Conv.h>
 
 #include "mcrouter/lib/RendezvousHashFunc.h"
+#include "mcrouter/lib/RendezvousHashHelper.h"
 #include "mcrouter/lib/test/HashTestUtil.h"
 
 using namespace facebook::memcache;
@@ -107,3 +109,36 @@ TEST(RendezvousHashFunc, rendezvous_rehash) {
   auto midRemoved = endpoints;
   EXPECT_EQ(removeCompare(midRemoved, midRemoved.begin() + n / 2), 15);
 }
+
+TEST(RendezvousHashFunc, kernels) {
+  if (bestRendezvousKernel() == RendezvousKernel::SCALAR) {
+    return;
+  }
+  std::mt19937_64 gen(42);
+  for (size_t n = 0; n < 100; ++n) {
+    std::vector<uint64_t> hashes(n);
+    for (auto& hash : hashes) {
+      hash = gen();
+    }
+    // Duplicate endpoints tie, the first one should win.
+    if (n > 10 && n % 3 == 0) {
+      for (size_t i = 5; i < n; ++i) {
+        hashes[i] = hashes[i % 5];
+      }
+    }
+    for (size_t k = 0; k < 100; ++k) {
+      uint64_t keyHash = gen();
+      EXPECT_EQ(
+          rendezvousMaxScorePos(
+              hashes.data(), n, keyHash, RendezvousKernel::SCALAR),
+          rendezvousMaxScorePos(hashes.data(), n, keyHash));
+
+      std::vector<uint64_t> expected(n);
+      std::vector<uint64_t> actual(n);
+      rendezvousScores(
+          hashes.data(), n, keyHash, expected.data(), RendezvousKernel::SCALAR);
+      rendezvousScores(hashes.data(), n, keyHash, actual.data());
+      EXPECT_EQ(expected, actual);
+    }
+  }
+}
@@ -251,6 +251,72 @@ TEST(routeHandleTest, allMajorityTie) {
   }
 }
 
+TEST(routeHandleTest, allMajorityDecidedEarly) {
+  TestFiberManager fm;
+
+  // No majority, but the last reply can't change the most common result.
+  vector<std::shared_ptr<TestHandle>> test_handles{
+      make_shared<TestHandle>(GetRouteTestData(mc_res_remote_error, "a")),
+      make_shared<TestHandle>(GetRouteTestData(mc_res_remote_error, "b")),
+      make_shared<TestHandle>(GetRouteTestData(mc_res_remote_error, "c")),
+      make_shared<TestHandle>(GetRouteTestData(mc_res_notfound, "d")),
+      make_shared<TestHandle>(GetRouteTestData(mc_res_found, "e")),
+      make_shared<TestHandle>(GetRouteTestData(mc_res_found, "f"))};
+
+  TestRouteHandle<AllMajorityRoute<TestRouteHandleIf>> rh(
+      get_route_handles(test_handles));
+
+  test_handles[5]->pause();
+
+  fm.runAll({[&]() {
+    auto reply = rh.route(McGetRequest("key"));
+
+    EXPECT_EQ(mc_res_remote_error, reply.result());
+    EXPECT_EQ(vector<string>{}, test_handles[5]->saw_keys);
+
+    test_handles[5]->unpause();
+  }});
+
+  for (auto& h : test_handles) {
+    EXPECT_EQ(vector<string>{"key"}, h->saw_keys);
+  }
+}
+
+TEST(routeHandleTest, allMajorityThrowingChild) {
+  TestFiberManager fm;
+
+  auto found = make_shared<TestHandle>(GetRouteTestData(mc_res_found, "a"));
+  vector<std::shared_ptr<TestRouteHandleIf>> children{
+      make_shared<TestRouteHandle<ThrowingRoute<TestRouteHandleIf>>>(),
+      found->rh,
+      make_shared<TestRouteHandle<ThrowingRoute<TestRouteHandleIf>>>()};
+  TestRouteHandle<AllMajorityRoute<TestRouteHandleIf>> rh(std::move(children));
+
+  fm.runAll({[&]() {
+    // The exceptions are counted as error replies and outvote "a".
+    auto reply = rh.route(McGetRequest("key"));
+    EXPECT_EQ(mc_res_local_error, reply.result());
+  }});
+
+  EXPECT_EQ(vector<string>{"key"}, found->saw_keys);
+}
+
+TEST(routeHandleTest, allMajorityAllChildrenThrow) {
+  TestFiberManager fm;
+
+  vector<std::shared_ptr<TestRouteHandleIf>> children{
+      make_shared<TestRouteHandle<ThrowingRoute<TestRouteHandleIf>>>(),
+      make_shared<TestRouteHandle<ThrowingRoute<TestRouteHandleIf>>>()};
+  TestRouteHandle<AllMajorityRoute<TestRouteHandleIf>> rh(std::move(children));
+
+  bool replied = false;
+  fm.runAll({[&]() {
+    EXPECT_EQ(mc_res_local_error, rh.route(McGetRequest("key")).result());
+    replied = true;
+  }});
+  EXPECT_TRUE(replied);
+}
+
 TEST(routeHandleTest, allFastest) {
   TestFiberManager fm;
 
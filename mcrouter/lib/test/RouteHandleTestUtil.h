@@ -8,6 +8,7 @@
 #pragma once
 
 #include <memory>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
@@ -279,6 +280,23 @@ struct RecordingRoute {
   }
 };
 
+/* Throws from every route() call */
+template <class RouteHandleIf>
+struct ThrowingRoute {
+  static std::string routeName() {
+    return "throwing";
+  }
+
+  template <class Request>
+  void traverse(const Request&, const RouteHandleTraverser<RouteHandleIf>&)
+      const {}
+
+  template <class Request>
+  ReplyT<Request> route(const Request&) {
+    throw std::runtime_error("route failed");
+  }
+};
+
 template <class RouteHandleIf>
 inline std::vector<std::shared_ptr<RouteHandleIf>> get_route_handles(
     const std::vector<std::shared_ptr<TestHandleImpl<RouteHandleIf>>>& hs) {
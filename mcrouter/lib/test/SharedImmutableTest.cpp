@@ -0,0 +1,95 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <folly/json.h>
+
+#include "mcrouter/lib/SharedImmutable.h"
+#include "mcrouter/lib/WeightedCh3HashFunc.h"
+
+using namespace facebook::memcache;
+
+namespace {
+
+std::shared_ptr<const std::string> getString(
+    const folly::dynamic& key,
+    size_t& numCreated) {
+  return getSharedImmutable<std::string>(key, [&]() {
+    ++numCreated;
+    return std::make_shared<const std::string>(folly::toJson(key));
+  });
+}
+
+} // anonymous namespace
+
+TEST(SharedImmutable, sameKey) {
+  size_t numCreated = 0;
+  auto a = getString(folly::dynamic::array(1, "a"), numCreated);
+  auto b = getString(folly::dynamic::array(1, "a"), numCreated);
+  EXPECT_EQ(a, b);
+  EXPECT_EQ(1, numCreated);
+
+  auto c = getString(folly::dynamic::array(1, "c"), numCreated);
+  EXPECT_NE(a, c);
+  EXPECT_EQ(2, numCreated);
+}
+
+TEST(SharedImmutable, differentTypes) {
+  const folly::dynamic key = "key";
+  auto str = getSharedImmutable<std::string>(
+      key, []() { return std::make_shared<const std::string>("str"); });
+  auto vec = getSharedImmutable<std::vector<int>>(
+      key, []() { return std::make_shared<const std::vector<int>>(3, 1); });
+  EXPECT_EQ("str", *str);
+  EXPECT_EQ(3, vec->size());
+}
+
+TEST(SharedImmutable, expired) {
+  size_t numCreated = 0;
+  const auto key = folly::dynamic::object("expired", true);
+  getString(key, numCreated);
+  // Nobody held the first one.
+  auto str = getString(key, numCreated);
+  EXPECT_EQ(2, numCreated);
+
+  const auto numLive = numSharedImmutables();
+  str.reset();
+  EXPECT_EQ(numLive - 1, numSharedImmutables());
+}
+
+TEST(SharedImmutable, concurrent) {
+  std::vector<std::shared_ptr<const std::string>> results(8);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < results.size(); ++i) {
+    threads.emplace_back([&results, i]() {
+      size_t numCreated = 0;
+      results[i] = getString("concurrent", numCreated);
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (const auto& result : results) {
+    EXPECT_EQ(results[0], result);
+  }
+}
+
+TEST(SharedImmutable, weightedCh3HashFunc) {
+  auto json = folly::parseJson(R"({"weights": [1.0, 0.5, 0.25]})");
+  WeightedCh3HashFunc a(json, 3);
+  WeightedCh3HashFunc b(json, 3);
+  EXPECT_EQ(&a.weights(), &b.weights());
+
+  WeightedCh3HashFunc c(json, 4);
+  EXPECT_NE(&a.weights(), &c.weights());
+  EXPECT_EQ(4, c.weights().size());
+}
@@ -0,0 +1,119 @@
+/*
+ *  Copyright (c) 2016-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <folly/experimental/TestUtil.h>
+
+#include "mcrouter/lib/debug/ShmRing.h"
+
+using namespace facebook::memcache;
+
+namespace {
+
+bool writeString(ShmRingWriter& writer, const std::string& str) {
+  iovec iov[2];
+  const auto half = str.size() / 2;
+  iov[0].iov_base = const_cast<char*>(str.data());
+  iov[0].iov_len = half;
+  iov[1].iov_base = const_cast<char*>(str.data() + half);
+  iov[1].iov_len = str.size() - half;
+  return writer.write(iov, 2);
+}
+
+std::vector<std::string> readAll(ShmRingReader& reader, uint64_t& lost) {
+  std::vector<std::string> records;
+  lost = reader.read([&records](folly::ByteRange record) {
+    records.emplace_back(folly::StringPiece(record).str());
+  });
+  return records;
+}
+
+} // anonymous
+
+TEST(ShmRing, roundTrip) {
+  folly::test::TemporaryDirectory dir;
+  const auto path = (dir.path() / "ring").string();
+
+  ShmRingWriter writer(path, 4096);
+  EXPECT_TRUE(ShmRingReader::isRing(path));
+  EXPECT_FALSE(ShmRingReader::isRing((dir.path() / "missing").string()));
+
+  // Records written before the reader attaches are not seen.
+  EXPECT_TRUE(writeString(writer, "before"));
+  ShmRingReader reader(path);
+
+  EXPECT_TRUE(writeString(writer, "hello"));
+  EXPECT_TRUE(writeString(writer, ""));
+  EXPECT_TRUE(writeString(writer, "world!"));
+
+  uint64_t lost;
+  auto records = readAll(reader, lost);
+  EXPECT_EQ(0, lost);
+  EXPECT_EQ((std::vector<std::string>{"hello", "", "world!"}), records);
+
+  records = readAll(reader, lost);
+  EXPECT_TRUE(records.empty());
+}
+
+TEST(ShmRing, wrapAround) {
+  folly::test::TemporaryDirectory dir;
+  const auto path = (dir.path() / "ring").string();
+
+  ShmRingWriter writer(path, 4096);
+  ShmRingReader reader(path);
+
+  // 1000 bytes records don't divide the capacity, so some of them wrap.
+  for (char c = 'a'; c <= 'z'; ++c) {
+    const std::string str(1000, c);
+    EXPECT_TRUE(writeString(writer, str));
+    uint64_t lost;
+    auto records = readAll(reader, lost);
+    EXPECT_EQ(0, lost);
+    ASSERT_EQ(1, records.size());
+    EXPECT_EQ(str, records[0]);
+  }
+}
+
+TEST(ShmRing, overwrite) {
+  folly::test::TemporaryDirectory dir;
+  const auto path = (dir.path() / "ring").string();
+
+  ShmRingWriter writer(path, 4096);
+  ShmRingReader reader(path);
+
+  EXPECT_FALSE(writeString(writer, std::string(4096, 'x')));
+  for (size_t i = 0; i < 10; ++i) {
+    EXPECT_TRUE(writeString(writer, std::string(1000, 'x')));
+  }
+
+  uint64_t lost;
+  auto records = readAll(reader, lost);
+  EXPECT_GT(lost, 0);
+
+  // The reader resynced and sees new records again.
+  EXPECT_TRUE(writeString(writer, "after"));
+  records = readAll(reader, lost);
+  EXPECT_EQ(0, lost);
+  EXPECT_EQ(std::vector<std::string>{"after"}, records);
+}
+
+TEST(ShmRing, heartbeat) {
+  folly::test::TemporaryDirectory dir;
+  const auto path = (dir.path() / "ring").string();
+
+  ShmRingWriter writer(path, 4096);
+  EXPECT_FALSE(writer.hasReader(1000));
+
+  ShmRingReader reader(path);
+  uint64_t lost;
+  readAll(reader, lost);
+  EXPECT_TRUE(writer.hasReader(1000));
+}
@@ -15,6 +15,7 @@
 #include <time.h>
 
 #include <algorithm>
+#include <chrono>
 #include <memory>
 #include <stdexcept>
 #include <string>
@@ -28,6 +29,7 @@
 #include <folly/Range.h>
 #include <folly/Singleton.h>
 
+#include "mcrouter/AsyncLogReplayer.h"
 #include "mcrouter/CarbonRouterInstance.h"
 #include "mcrouter/McrouterLogFailure.h"
 #include "mcrouter/Proxy.h"
@@ -458,6 +460,17 @@ int main(int argc, char** argv) {
   // do this immediately after setting up log file
   notify_command_line(argc, argv);
 
+  if (standaloneOpts.replay_async_spool) {
+    AsyncLogReplayOptions replayOpts;
+    replayOpts.maxInflight = standaloneOpts.replay_max_inflight;
+    replayOpts.maxRate = standaloneOpts.replay_rate;
+    replayOpts.timeout = std::chrono::milliseconds(opts.server_timeout_ms);
+    exit(
+        replayAsyncSpool(opts.async_spool, replayOpts)
+            ? 0
+            : kExitStatusTransientError);
+  }
+
   if (!validate_options()) {
     print_usage_and_die(argv[0], kExitStatusUnrecoverableError);
   }
@@ -16,6 +16,7 @@
 #include "mcrouter/ProxyBase.h"
 #include "mcrouter/config.h"
 #include "mcrouter/flavor.h"
+#include "mcrouter/lib/CompressionCodecManager.h"
 #include "mcrouter/options.h"
 #include "mcrouter/routes/McrouterRouteHandle.h"
 #include "mcrouter/standalone_options.h"
@@ -101,8 +102,10 @@ void logFailover(ProxyBase& proxy, const FailoverContext& failoverContext) {}
 
 void initFailureLogger() {}
 
-bool initCompression(CarbonRouterInstanceBase&) {
-  return false;
+bool initCompression(CarbonRouterInstanceBase& router) {
+  // Only trained dictionaries (compression_dictionary_dir) are available.
+  router.setUpCompressionDictionaries({});
+  return router.getCodecManager() != nullptr;
 }
 
 void scheduleSingletonCleanup() {}
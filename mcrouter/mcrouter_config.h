@@ -26,6 +26,7 @@ static_assert(false, "mcrouter: invalid build");
 #include <folly/experimental/observer/Observer.h>
 #include <folly/io/async/EventBase.h>
 
+#include "mcrouter/lib/Clocks.h"
 #include "mcrouter/lib/Operation.h"
 #include "mcrouter/lib/carbon/NoopAdditionalLogger.h"
 
@@ -85,11 +86,10 @@ inline bool alwaysSendToMainShardSplit(uint64_t /* flags */) {
 
 /**
  * @return monotonic time suitable for measuring intervals in microseconds.
+ *         Same epoch as steady_clock, but doesn't make a system call.
  */
 inline int64_t nowUs() {
-  return std::chrono::duration_cast<std::chrono::microseconds>(
-             std::chrono::steady_clock::now().time_since_epoch())
-      .count();
+  return cycles::nowUs();
 }
 
 /**
@@ -76,6 +76,22 @@ MCROUTER_OPTION_TOGGLE(
     no_short,
     "Enable using the asynclog version 2.0")
 
+MCROUTER_OPTION_TOGGLE(
+    use_asynclog_binary,
+    false,
+    "use-asynclog-binary",
+    no_short,
+    "Write asynclog entries as length-prefixed carbon structs instead of"
+    " JSON lines. Takes precedence over use-asynclog-version2.")
+
+MCROUTER_OPTION_TOGGLE(
+    asynclog_fsync,
+    false,
+    "asynclog-fsync",
+    no_short,
+    "fdatasync() asynclog files after every batch of entries, before"
+    " replying to the requests in it.")
+
 MCROUTER_OPTION_INTEGER(
     size_t,
     num_proxies,
@@ -84,6 +100,17 @@ MCROUTER_OPTION_INTEGER(
     no_short,
     "adjust how many proxy threads to run")
 
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    num_active_proxies,
+    0,
+    "num-active-proxies",
+    no_short,
+    "New clients are only assigned to the first num-active-proxies proxies,"
+    " the rest only serve clients they already have. Can be changed at"
+    " runtime with the __mcrouter__.active_proxies(N) command. 0 means all"
+    " proxies are active.")
+
 MCROUTER_OPTION_INTEGER(
     size_t,
     client_queue_size,
@@ -112,6 +139,100 @@ MCROUTER_OPTION_INTEGER(
     "Force client queue notification if last drain was at least this long ago."
     "  If 0, this logic is disabled.")
 
+MCROUTER_OPTION_TOGGLE(
+    proxy_key_affinity,
+    false,
+    "proxy-key-affinity",
+    no_short,
+    "Send each client request to the proxy thread picked by its routing key"
+    " hash instead of the client's fixed proxy, so that all requests for a"
+    " key are handled by the same proxy (e.g. for per-proxy caches and"
+    " coalescing). The proxy is not tied to the destination the key is"
+    " routed to. Does not apply to same-thread clients.")
+
+MCROUTER_OPTION_STRING(
+    proxy_groups,
+    "",
+    "proxy-groups",
+    no_short,
+    "Dedicate proxy threads to routing prefixes, so that load on one routing"
+    " prefix doesn't slow down the others. Comma separated list of"
+    " <routing prefix>:<first proxy id>[-<last proxy id>], e.g."
+    " '/a/b/:0-3,/c/d/:4'. Requests for other routing prefixes go to the"
+    " remaining proxies. Does not apply to same-thread clients.")
+
+MCROUTER_OPTION_TOGGLE(
+    shared_destination_connections,
+    false,
+    "shared-destination-connections",
+    no_short,
+    "Open connections to each destination from a single owner proxy thread"
+    " (picked by destination key hash); other proxies hand their requests"
+    " to the owner's thread. Cuts the number of connections per destination"
+    " from num-proxies to one, at the cost of a thread hop per request.")
+
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    hot_key_sample_rate,
+    128,
+    "hot-key-sample-rate",
+    no_short,
+    "Count one in this many requests on each proxy to find hot keys (see"
+    " __mcrouter__.hot_keys). 0 disables hot key tracking.")
+
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    hot_key_top_k,
+    32,
+    "hot-key-top-k",
+    no_short,
+    "Number of hot keys tracked on each proxy.")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    slow_request_trace_threshold_us,
+    0,
+    "slow-request-trace-threshold-us",
+    no_short,
+    "Record a timeline (routing, destination sends and replies) for every"
+    " request, and keep the ones that take at least this long for the"
+    " slow_requests command. 0 disables it.")
+
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    slow_request_trace_sample_rate,
+    1,
+    "slow-request-trace-sample-rate",
+    no_short,
+    "Keep the timeline of one in this many slow requests.")
+
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    slow_request_trace_buffer,
+    32,
+    "slow-request-trace-buffer",
+    no_short,
+    "Number of slow request timelines kept on each proxy.")
+
+MCROUTER_OPTION_STRING(
+    key_prefix_stats_delimiter,
+    "",
+    "key-prefix-stats-delimiter",
+    no_short,
+    "If set, requests are counted by key prefix: the key (without routing"
+    " prefix) up to the first occurrence of this delimiter. See"
+    " 'stats prefixes'. Empty disables the counters.")
+
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    key_prefix_stats_max_prefixes,
+    256,
+    "key-prefix-stats-max-prefixes",
+    no_short,
+    "Number of key prefixes counted separately on each proxy; the first ones"
+    " seen get the slots. Other prefixes and keys without the delimiter are"
+    " counted together.")
+
 MCROUTER_OPTION_INTEGER(
     size_t,
     big_value_split_threshold,
@@ -127,8 +248,19 @@ MCROUTER_OPTION_INTEGER(
     10,
     "big-value-batch-size",
     no_short,
-    "If nonzero, big value chunks are written/read in batches of at most"
-    " this size.  Used to prevent queue build up with really large values")
+    "If nonzero, at most this many big value chunks are written/read"
+    " concurrently, a new one is sent as soon as another one completes."
+    " Used to prevent queue build up with really large values")
+
+MCROUTER_OPTION_STRING(
+    big_value_compression,
+    "",
+    "big-value-compression",
+    no_short,
+    "If set to 'lz4' or 'zstd', big values are compressed before being split"
+    " into chunks, and a checksum is verified when they are read back."
+    " Readers understand such values regardless of this option, but older"
+    " mcrouter versions don't, so only enable it once all are upgraded.")
 
 MCROUTER_OPTION_INTEGER(
     size_t,
@@ -147,6 +279,18 @@ MCROUTER_OPTION_INTEGER(
     "Size of stack in bytes to allocate per fiber."
     " 0 means use fibers library default.")
 
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    leaf_fibers_stack_size,
+    0,
+    "leaf-fibers-stack-size",
+    no_short,
+    "If non-zero, requests are routed on fibers with stacks of this many"
+    " bytes when the config only has single-shot routes (pools, hashing,"
+    " key/exptime modification, no failover, shadowing or fan-out). Such"
+    " requests only wait on one reply, so they need much less stack than"
+    " fibers-stack-size. Ignored with lazy-route-construction.")
+
 MCROUTER_OPTION_INTEGER(
     size_t,
     fibers_record_stack_size_every,
@@ -163,6 +307,18 @@ MCROUTER_OPTION_TOGGLE(
     no_short,
     "If enabled, protect limited amount of fiber stacks with guard pages")
 
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    fibers_prefault_stacks,
+    0,
+    "fibers-prefault-stacks",
+    no_short,
+    "Number of fibers (at most fibers-max-pool-size) every proxy creates at"
+    " startup, with their whole stacks touched, so that request bursts don't"
+    " page fault stacks in. The pool of these fibers is then never resized"
+    " (fibers-pool-resize-period-ms), so that they are kept. 0 (the default)"
+    " disables it.")
+
 MCROUTER_OPTION_STRING(
     runtime_vars_file,
     MCROUTER_RUNTIME_VARS_DEFAULT,
@@ -176,16 +332,16 @@ MCROUTER_OPTION_INTEGER(
     100,
     "file-observer-poll-period-ms",
     no_short,
-    "How often to check inotify for updates on the tracked files.")
+    "DEPRECATED. No longer used, files are observed with inotify events.")
 
 MCROUTER_OPTION_INTEGER(
     uint32_t,
     file_observer_sleep_before_update_ms,
-    1000,
+    10,
     "file-observer-sleep-before-update-ms",
     no_short,
-    "How long to sleep for after an update occured"
-    " (a hack to avoid partial writes).")
+    "How long to wait after a file change before reading the file, so that"
+    " writes in quick succession are read at once.")
 
 MCROUTER_OPTION_INTEGER(
     uint32_t,
@@ -195,7 +351,8 @@ MCROUTER_OPTION_INTEGER(
     no_short,
     "Free unnecessary fibers in the fibers pool every"
     " fibers-pool-resize-period-ms milliseconds.  If value is 0, periodic"
-    " resizing of the free pool is disabled.")
+    " resizing of the free pool is disabled. Ignored by proxies with"
+    " fibers-prefault-stacks.")
 
 MCROUTER_OPTION_GROUP("Network")
 
@@ -232,6 +389,53 @@ MCROUTER_OPTION_INTEGER(
     "Maximum number of non-blocking event loops before we flush batched "
     "requests")
 
+MCROUTER_OPTION_TOGGLE(
+    adaptive_flush,
+    false,
+    "adaptive-flush",
+    no_short,
+    "Scale the number of event loops batched requests wait for before a "
+    "flush (up to max-no-flush-event-loops) with the observed average "
+    "destination batch size: flush right away while batches stay small")
+
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    max_write_batch_size,
+    24576,
+    "max-write-batch-size",
+    no_short,
+    "Maximum number of bytes coalesced into a single write syscall to a"
+    " destination. Larger values reduce the number of syscalls per event loop"
+    " iteration for busy destinations.")
+
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    max_write_batch_iovecs,
+    128,
+    "max-write-batch-iovecs",
+    no_short,
+    "Maximum number of iovecs coalesced into a single write syscall to a"
+    " destination.")
+
+MCROUTER_OPTION_TOGGLE(
+    batch_caret_requests,
+    false,
+    "batch-caret-requests",
+    no_short,
+    "If enabled, caret requests written to a destination together that have"
+    " the same type and header fields are sent in batch frames with a single"
+    " header. Destinations must understand caret batches.")
+
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    zero_copy_threshold,
+    0,
+    "zero-copy-threshold",
+    no_short,
+    "Requests to destinations with values of at least this many bytes are"
+    " sent with MSG_ZEROCOPY (plaintext connections only). 0 disables"
+    " zero-copy sends.")
+
 MCROUTER_OPTION_INTEGER(
     unsigned int,
     reset_inactive_connection_interval,
@@ -269,6 +473,45 @@ MCROUTER_OPTION_INTEGER(
     " per target per thread.  Requests that would exceed this limit are dropped"
     " immediately.")
 
+MCROUTER_OPTION_DOUBLE(
+    double,
+    spillover_resume_pending_ratio,
+    0.5,
+    "spillover-resume-pending-ratio",
+    no_short,
+    "A target whose queue reached target-max-pending-requests keeps"
+    " spilling requests over to the next children of failover routes with"
+    " \"spillover\" enabled until its queue drains to this fraction of the"
+    " limit.")
+
+MCROUTER_OPTION_TOGGLE(
+    target_inflight_aimd,
+    false,
+    "target-inflight-aimd",
+    no_short,
+    "Only active if target-max-inflight-requests is nonzero. Adjust the"
+    " inflight limit of every target between target-min-inflight-requests and"
+    " target-max-inflight-requests: grow it while replies come back in time,"
+    " halve it on timeouts, busy replies and replies slower than"
+    " target-inflight-latency-factor times the shortest recent latency.")
+
+MCROUTER_OPTION_INTEGER(
+    uint64_t,
+    target_min_inflight_requests,
+    1,
+    "target-min-inflight-requests",
+    no_short,
+    "Lowest inflight limit per target per thread with target-inflight-aimd")
+
+MCROUTER_OPTION_DOUBLE(
+    double,
+    target_inflight_latency_factor,
+    2.0,
+    "target-inflight-latency-factor",
+    no_short,
+    "With target-inflight-aimd, replies slower than this many times the"
+    " shortest recent latency of the target shrink its inflight limit")
+
 MCROUTER_OPTION_INTEGER(
     size_t,
     target_max_shadow_requests,
@@ -279,6 +522,52 @@ MCROUTER_OPTION_INTEGER(
     " per target per thread.  Requests that would exceed this limit are dropped"
     " immediately.")
 
+MCROUTER_OPTION_TOGGLE(
+    shadow_load_shedding,
+    false,
+    "shadow-load-shedding",
+    no_short,
+    "If enabled, shadow traffic is scaled down when the proxy is under"
+    " pressure (see shadow-shed-fibers and proxy-max-inflight-requests),"
+    " and dropped entirely while requests are waiting to be processed.")
+
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    shadow_shed_fibers,
+    0,
+    "shadow-shed-fibers",
+    no_short,
+    "If nonzero, shadow traffic is scaled down as the number of fibers in use"
+    " per proxy grows from half of this value, and dropped above it.")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    refill_dedup_window_ms,
+    0,
+    "refill-dedup-window-ms",
+    no_short,
+    "If nonzero, asynchronous refills (WarmUpRoute cold adds, L1L2CacheRoute"
+    " L1 adds) of a key refilled less than this many milliseconds ago by the"
+    " same proxy are skipped.")
+
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    refill_max_rate,
+    0,
+    "refill-max-rate",
+    no_short,
+    "If nonzero, each proxy sends at most this many asynchronous refills per"
+    " second; further refills are dropped.")
+
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    refill_max_outstanding,
+    0,
+    "refill-max-outstanding",
+    no_short,
+    "If nonzero, each proxy has at most this many asynchronous refills in"
+    " flight; further refills are dropped.")
+
 MCROUTER_OPTION_INTEGER(
     size_t,
     proxy_max_inflight_requests,
@@ -287,7 +576,9 @@ MCROUTER_OPTION_INTEGER(
     no_short,
     "If non-zero, sets the limit on maximum incoming requests that will be routed"
     " in parallel by each proxy thread.  Requests over limit will be queued up"
-    " until the number of inflight requests drops.")
+    " until the number of inflight requests drops. Queued critical requests"
+    " are always let through before async ones; within a priority, clients"
+    " are served round-robin.")
 
 MCROUTER_OPTION_INTEGER(
     size_t,
@@ -298,8 +589,30 @@ MCROUTER_OPTION_INTEGER(
     "Only active if proxy-max-inflight-requests is non-zero. "
     "Hard limit on the number of requests to queue per proxy after "
     "there are already proxy-max-inflight-requests requests in flight for the "
-    "proxy. Further requests will be rejected with an error immediately. 0 means "
-    "disabled.")
+    "proxy. Further requests will be rejected with an error immediately, unless"
+    " a lower priority request is waiting, which is rejected instead. 0 means"
+    " disabled.")
+
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    proxy_memory_budget_mb,
+    0,
+    "proxy-memory-budget-mb",
+    no_short,
+    "Budget for the bytes of keys and values of all requests and replies in"
+    " flight in this process. Above 80% of the budget async requests and"
+    " requests larger than proxy-memory-budget-large-request-bytes are"
+    " rejected with a busy error, above the budget all requests are."
+    " 0 means disabled.")
+
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    proxy_memory_budget_large_request_bytes,
+    64 * 1024,
+    "proxy-memory-budget-large-request-bytes",
+    no_short,
+    "Requests of at least this many bytes are rejected first once"
+    " proxy-memory-budget-mb is nearly used up.")
 
 MCROUTER_OPTION_STRING(
     pem_cert_path,
@@ -365,6 +678,17 @@ MCROUTER_OPTION_TOGGLE(
     no_short,
     "If enabled, limited number of SSL sessions will be cached")
 
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    ssl_session_cache_size,
+    100,
+    "ssl-session-cache-size",
+    no_short,
+    "Maximum number of SSL sessions cached when ssl-connection-cache is"
+    " enabled. The cache is shared by all proxy threads, so it should fit a"
+    " session for every SSL destination to avoid full handshakes after mass"
+    " reconnects.")
+
 MCROUTER_OPTION_TOGGLE(
     enable_compression,
     false,
@@ -374,6 +698,65 @@ MCROUTER_OPTION_TOGGLE(
     "compression algorithms/dictionaries supported by the client. Only "
     "compresses caret protocol replies.")
 
+MCROUTER_OPTION_STRING(
+    compression_scope,
+    "all",
+    "compression-scope",
+    no_short,
+    "Pools that enable-compression applies to: 'all', 'cross_cluster' (pools"
+    " in another cluster or region) or 'cross_region' (pools in another"
+    " region). Pools are classified by their region and cluster like for"
+    " cross-region-timeout-ms, pools without them count as local. A pool's"
+    " own enable_compression takes precedence.")
+
+MCROUTER_OPTION_TOGGLE(
+    compress_requests,
+    false,
+    "compress-requests",
+    no_short,
+    "If enabled, requests to compressed caret destinations will also be "
+    "compressed, typically with a dictionary trained on the keys. "
+    "Destinations must support the same compression codecs.")
+
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    compression_offload_threshold,
+    0,
+    "compression-offload-threshold",
+    no_short,
+    "Requests to and replies from compressed caret destinations whose"
+    " uncompressed body is at least this many bytes are compressed and"
+    " uncompressed on the auxiliary CPU thread pool instead of the proxy"
+    " thread. 0 disables offloading.")
+
+MCROUTER_OPTION_STRING(
+    compression_dictionary_dir,
+    "",
+    "compression-dictionary-dir",
+    no_short,
+    "Directory of trained zstd dictionaries (<pool>.zdict). On startup they"
+    " are added as compression codecs, with ids following the configured"
+    " codecs in file name order, and negotiated with peers like them. Peers"
+    " must load the same directory.")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    compression_dictionary_training_interval_s,
+    0,
+    "compression-dictionary-training-interval-s",
+    no_short,
+    "If non-zero (and compression-dictionary-dir is set), values routed to"
+    " each pool are sampled, and a zstd dictionary is trained on them and"
+    " written to compression-dictionary-dir this often.")
+
+MCROUTER_OPTION_DOUBLE(
+    double,
+    compression_dictionary_sample_rate,
+    0.001,
+    "compression-dictionary-sample-rate",
+    no_short,
+    "Fraction of values sampled for dictionary training.")
+
 MCROUTER_OPTION_GROUP("Routing configuration")
 
 MCROUTER_OPTION_TOGGLE(
@@ -416,6 +799,15 @@ MCROUTER_OPTION_INTEGER(
     "Max age of backup config files that mcrouter is allowed to use"
     " (in seconds). 0 to disable using dumped configs.")
 
+MCROUTER_OPTION_TOGGLE(
+    config_snapshot,
+    false,
+    "config-snapshot",
+    no_short,
+    "If enabled, the preprocessed config is also saved to config-dump-root,"
+    " and loaded from there on startup unless the config or its imports"
+    " changed. Saves expanding macros of big configs on every restart.")
+
 MCROUTER_OPTION_STRING(
     config_file,
     "",
@@ -493,6 +885,33 @@ MCROUTER_OPTION_INTEGER(
     no_short,
     "Delay after a reconfiguration is complete.")
 
+MCROUTER_OPTION_TOGGLE(
+    parallel_config_build,
+    true,
+    "disable-parallel-config-build",
+    no_short,
+    "If enabled, build the route trees of all proxies concurrently on the"
+    " auxiliary CPU thread pool when (re)configuring")
+
+MCROUTER_OPTION_TOGGLE(
+    lazy_route_construction,
+    false,
+    "lazy-route-construction",
+    no_short,
+    "If enabled, the route of each routing prefix and of each policy of a"
+    " PrefixSelectorRoute is only built on the first request using it."
+    " Errors in such routes are then only reported at that point, and such"
+    " requests get an error reply.")
+
+MCROUTER_OPTION_TOGGLE(
+    reuse_unchanged_routes,
+    true,
+    "disable-reuse-unchanged-routes",
+    no_short,
+    "If enabled, pool routes whose config didn't change are carried over"
+    " into the new config on reconfiguration, with their state (rate"
+    " limiters, load balancer loads), instead of being rebuilt")
+
 MCROUTER_OPTION_STRING_MAP(
     config_params,
     "config-params",
@@ -527,6 +946,93 @@ MCROUTER_OPTION_INTEGER(
     no_short,
     "TKO probe retry max timeout in ms")
 
+MCROUTER_OPTION_DOUBLE(
+    double,
+    tko_canary_ratio,
+    0.0,
+    "tko-canary-ratio",
+    no_short,
+    "Fraction of requests to a soft TKO destination (other than a latency"
+    " outlier) sent to it anyway, one at a time and at most once every"
+    " tko-canary-interval-ms. The destination is unmarked TKO after"
+    " tko-canary-successes of them succeed in a row. Probes are only sent"
+    " while there are no requests to pick canaries from. 0 disables.")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    tko_canary_interval_ms,
+    100,
+    "tko-canary-interval-ms",
+    no_short,
+    "Minimum time between two canary requests to a TKO destination,"
+    " see tko-canary-ratio")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    tko_canary_successes,
+    3,
+    "tko-canary-successes",
+    no_short,
+    "Canary requests that have to succeed in a row to unmark a destination"
+    " TKO, see tko-canary-ratio")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    probe_scheduler_tick_ms,
+    100,
+    "probe-scheduler-tick-ms",
+    no_short,
+    "Granularity of the timer wheel that schedules TKO probes, in ms.")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    max_probes_per_second,
+    0,
+    "max-probes-per-second",
+    no_short,
+    "Max TKO probes per second sent by all proxies of this router (0 means"
+    " unlimited). Probes over the budget are postponed.")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    max_new_connections_per_second,
+    0,
+    "max-new-connections-per-second",
+    no_short,
+    "Max new connections per second opened by all proxies of this router (0"
+    " means unlimited), reconnects included. Connections needed by queued"
+    " requests go first; requests wait for one up to their timeout.")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    prewarm_connections,
+    0,
+    "prewarm-connections",
+    no_short,
+    "Number of destinations per proxy to connect to in the background as"
+    " soon as they are configured, before any request needs them. Prewarm"
+    " connections get the max-new-connections-per-second budget last.")
+
+MCROUTER_OPTION_DOUBLE(
+    double,
+    warm_start_connect_fraction,
+    0.0,
+    "warm-start-connect-fraction",
+    no_short,
+    "If positive, connect to all destinations of a new config in the"
+    " background (subject to max-new-connections-per-second), and only swap"
+    " the config in once this fraction of them is connected, or after"
+    " warm-start-timeout-ms.")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    warm_start_timeout_ms,
+    10000,
+    "warm-start-timeout-ms",
+    no_short,
+    "Max time to wait for warm-start-connect-fraction of the connections of"
+    " a new config to be up before swapping it in anyway.")
+
 MCROUTER_OPTION_INTEGER(
     int,
     failures_until_tko,
@@ -535,6 +1041,77 @@ MCROUTER_OPTION_INTEGER(
     no_short,
     "Mark as TKO after this many failures")
 
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    latency_tko_interval_ms,
+    0,
+    "latency-tko-interval-ms",
+    no_short,
+    "If non-zero, every this many ms compare the latency of every destination"
+    " with the median latency of its pool and mark slow outliers soft TKO."
+    " They come back once a probe replies fast enough.")
+
+MCROUTER_OPTION_DOUBLE(
+    double,
+    latency_tko_percentile,
+    0.9,
+    "latency-tko-percentile",
+    no_short,
+    "Latency percentile (in (0, 1]) compared by latency TKO.")
+
+MCROUTER_OPTION_DOUBLE(
+    double,
+    latency_tko_multiplier,
+    3.0,
+    "latency-tko-multiplier",
+    no_short,
+    "A destination is a latency outlier if its latency is above this many"
+    " times the median latency of its pool.")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    latency_tko_min_latency_us,
+    20000,
+    "latency-tko-min-latency-us",
+    no_short,
+    "Destinations faster than this are never latency outliers.")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    latency_tko_min_samples,
+    100,
+    "latency-tko-min-samples",
+    no_short,
+    "Replies a destination needs within an interval to be checked for"
+    " latency TKO.")
+
+MCROUTER_OPTION_DOUBLE(
+    double,
+    latency_tko_max_fraction,
+    0.1,
+    "latency-tko-max-fraction",
+    no_short,
+    "Max fraction of a pool that may be latency TKO at the same time,"
+    " rounded up: any non-zero value lets small pools eject one host.")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    tko_snapshot_interval_ms,
+    0,
+    "tko-snapshot-interval-ms",
+    no_short,
+    "If non-zero, the hosts currently TKO are saved to a file in stats-root"
+    " this often (and on shutdown). On startup, hosts from a recent enough"
+    " snapshot (tko-snapshot-max-age-s) start out TKO and get probed.")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    tko_snapshot_max_age_s,
+    300,
+    "tko-snapshot-max-age-s",
+    no_short,
+    "TKO snapshots older than this are ignored on startup.")
+
 MCROUTER_OPTION_TOGGLE(
     allow_only_gets,
     false,
@@ -554,6 +1131,51 @@ MCROUTER_OPTION_INTEGER(
     "Timeout for talking to destination servers (e.g. memcached), "
     "in milliseconds. Must be greater than 0.")
 
+MCROUTER_OPTION_DOUBLE(
+    double,
+    adaptive_timeout_quantile,
+    0.0,
+    "adaptive-timeout-quantile",
+    no_short,
+    "If non-zero (e.g. 0.999), destination timeouts are derived from this"
+    " quantile of the observed reply latency of each destination, times"
+    " adaptive-timeout-factor. Configured timeouts are used until enough"
+    " replies were seen.")
+
+MCROUTER_OPTION_DOUBLE(
+    double,
+    adaptive_timeout_factor,
+    2.0,
+    "adaptive-timeout-factor",
+    no_short,
+    "Adaptive timeout is the latency quantile times this factor.")
+
+MCROUTER_OPTION_INTEGER(
+    unsigned int,
+    adaptive_timeout_min_ms,
+    10,
+    "adaptive-timeout-min-ms",
+    no_short,
+    "Lower bound of adaptive timeouts, in milliseconds.")
+
+MCROUTER_OPTION_TOGGLE(
+    destination_latency_histograms,
+    false,
+    "destination-latency-histograms",
+    no_short,
+    "If enabled, keep a latency histogram for every destination and report"
+    " its percentiles in 'stats servers'. Takes about 1KB per destination"
+    " per proxy.")
+
+MCROUTER_OPTION_INTEGER(
+    unsigned int,
+    adaptive_timeout_max_ms,
+    0,
+    "adaptive-timeout-max-ms",
+    no_short,
+    "Upper bound of adaptive timeouts, in milliseconds. 0 means the"
+    " configured (static) timeout of the route.")
+
 MCROUTER_OPTION_INTEGER(
     unsigned int,
     cross_region_timeout_ms,
@@ -563,6 +1185,27 @@ MCROUTER_OPTION_INTEGER(
     "Timeouts for talking to cross region pool. "
     "If specified (non 0) takes precedence over every other timeout.")
 
+MCROUTER_OPTION_INTEGER(
+    unsigned int,
+    request_deadline_ms,
+    0,
+    "request-deadline-ms",
+    no_short,
+    "Total time budget of a request, in milliseconds. Destination timeouts "
+    "are clamped to the time left, and failover stops once the budget is "
+    "used up. Clients can also send a (smaller) budget with a caret request. "
+    "0 means no deadline.")
+
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    request_arena_max_bytes,
+    16384,
+    "request-arena-max-bytes",
+    no_short,
+    "Heap bytes every request may take for its arena, which routes allocate"
+    " short-lived memory from, released at once when the request completes."
+    " Above it, allocations go to the heap. 0 disables the arena.")
+
 MCROUTER_OPTION_INTEGER(
     unsigned int,
     cross_cluster_timeout_ms,
@@ -591,6 +1234,27 @@ MCROUTER_OPTION_INTEGER(
     " discarded. Enabled only if value is non-zero and"
     " if proxy-max-throttled-requests is enabled.")
 
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    queue_delay_target_us,
+    0,
+    "queue-delay-target-us",
+    no_short,
+    "CoDel management of the client and waiting request queues of each proxy."
+    " If every request leaving a queue during queue-delay-interval-ms waited"
+    " longer than this, async requests waiting longer than this are rejected"
+    " with a busy error, and so are critical requests waiting twice as long."
+    " 0 disables.")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    queue_delay_interval_ms,
+    100,
+    "queue-delay-interval-ms",
+    no_short,
+    "Interval over which queue-delay-target-us looks at the shortest wait in"
+    " the queue.")
+
 MCROUTER_OPTION_GROUP("Custom Memory Allocation")
 
 MCROUTER_OPTION_TOGGLE(
@@ -603,6 +1267,45 @@ MCROUTER_OPTION_TOGGLE(
     " part of any core dump. This is achieved by setting MADV_DONTDUMP on"
     " explicitly created jemalloc arenas. The default value is false.")
 
+MCROUTER_OPTION_TOGGLE(
+    proxy_jemalloc_arenas,
+    false,
+    "proxy-jemalloc-arenas",
+    no_short,
+    "Give every proxy thread (and so the server worker running on it) its"
+    " own jemalloc arena, to avoid contention on shared arenas. Per-arena"
+    " allocation stats are reported by 'stats arenas'.")
+
+MCROUTER_OPTION_TOGGLE(
+    proxy_numa_spread,
+    false,
+    "proxy-numa-spread",
+    no_short,
+    "Spread proxy threads round-robin across NUMA nodes: every proxy thread"
+    " is restricted to the CPUs of its node and prefers memory of that node."
+    " Threads already pinned within one node (e.g. by worker-cpus) stay"
+    " there and only get the memory preference.")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    proxy_busy_poll_us,
+    0,
+    "proxy-busy-poll-us",
+    no_short,
+    "Keep proxy event loops (and server workers running on them) polling"
+    " without sleeping for this many microseconds after the last event, so"
+    " that requests arriving meanwhile are not delayed by thread wake-ups."
+    " Burns a core per busy thread. 0 (the default) disables it.")
+
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    proxy_busy_poll_threads,
+    0,
+    "proxy-busy-poll-threads",
+    no_short,
+    "With proxy-busy-poll-us, only the first this many proxy threads busy"
+    " poll. 0 (the default) means all of them.")
+
 MCROUTER_OPTION_GROUP("Logging")
 
 MCROUTER_OPTION_STRING(
@@ -619,6 +1322,16 @@ MCROUTER_OPTION_STRING(
     no_short,
     "Root directory for debug fifos. If empty, debug fifos are disabled.")
 
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    debug_fifo_shm_ring_size,
+    0,
+    "debug-fifo-shm-ring-size",
+    no_short,
+    "If non-zero, debug fifos are shared memory ring buffers of this many"
+    " bytes instead of named pipes. Writing to a ring never makes syscalls,"
+    " old data is overwritten if mcpiper falls behind.")
+
 MCROUTER_OPTION_INTEGER(
     unsigned int,
     stats_logging_interval,
@@ -627,6 +1340,14 @@ MCROUTER_OPTION_INTEGER(
     no_short,
     "Time in ms between stats reports, or 0 for no logging")
 
+MCROUTER_OPTION_TOGGLE(
+    stats_mmap,
+    false,
+    "stats-mmap",
+    no_short,
+    "If enabled, also export numeric stats to a memory-mapped binary file"
+    " under stats_root, updated every stats_logging_interval")
+
 MCROUTER_OPTION_INTEGER(
     unsigned int,
     logging_rtt_outlier_threshold_us,
@@ -636,6 +1357,33 @@ MCROUTER_OPTION_INTEGER(
     "surpassing this threshold rtt time means we will log it as an outlier. "
     "0 (the default) means that we will do no logging of outliers.")
 
+MCROUTER_OPTION_TOGGLE(
+    fiber_scheduling_stats,
+    false,
+    "fiber-scheduling-stats",
+    no_short,
+    "If enabled, measure how long proxy fibers wait to run and how long each"
+    " proxy event loop iteration is busy (fiber_*_delay_us_* and"
+    " proxy_loop_busy_us_* stats)")
+
+MCROUTER_OPTION_INTEGER(
+    unsigned int,
+    slow_loop_threshold_us,
+    0,
+    "slow-loop-threshold-us",
+    no_short,
+    "With fiber_scheduling_stats, proxy event loop iterations busy for longer"
+    " than this are counted and logged. 0 (the default) disables it.")
+
+MCROUTER_OPTION_TOGGLE(
+    request_cpu_stats,
+    false,
+    "request-cpu-stats",
+    no_short,
+    "If enabled, measure the proxy CPU time spent routing every request, while"
+    " its fibers run, and add it up by routing prefix and by request type"
+    " ('stats cpu').")
+
 MCROUTER_OPTION_INTEGER(
     unsigned int,
     stats_async_queue_length,
@@ -644,6 +1392,32 @@ MCROUTER_OPTION_INTEGER(
     no_short,
     "Asynchronous queue size for logging.")
 
+MCROUTER_OPTION_INTEGER(
+    unsigned int,
+    request_sample_rate,
+    0,
+    "request-sample-rate",
+    no_short,
+    "Log one in this many destination requests of every proxy (key hash,"
+    " operation, destination, latency, result) to request-sample-log-file."
+    " 0 (the default) disables request sampling.")
+
+MCROUTER_OPTION_STRING(
+    request_sample_log_file,
+    "",
+    "request-sample-log-file",
+    no_short,
+    "File sampled requests are appended to, see request-sample-rate")
+
+MCROUTER_OPTION_INTEGER(
+    unsigned int,
+    request_sample_ring_size,
+    4096,
+    "request-sample-ring-size",
+    no_short,
+    "Number of sampled requests every proxy buffers until they're written"
+    " out. Samples that don't fit are dropped (request_samples_dropped).")
+
 MCROUTER_OPTION_TOGGLE(
     enable_failure_logging,
     true,
@@ -698,6 +1472,35 @@ MCROUTER_OPTION_INTEGER(
     " threshold is always at most max-rxmit-reconnect-threshold rxmits/kb."
     " If max-rxmit-reconnect-threshold is 0, the dynamic threshold is unbounded.")
 
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    multiget_max_inflight_keys,
+    0,
+    "multiget-max-inflight-keys",
+    no_short,
+    "If non-zero, route at most this many keys of one client's ascii multiget"
+    " at a time; the other keys are sent as replies for earlier ones come"
+    " back, spreading the replies of wide multigets over time. 0 disables it.")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    multiget_min_inflight_keys,
+    4,
+    "multiget-min-inflight-keys",
+    no_short,
+    "Lowest limit multiget-max-inflight-keys is lowered to while retransmits"
+    " are above multiget-rxmit-threshold.")
+
+MCROUTER_OPTION_INTEGER(
+    uint64_t,
+    multiget_rxmit_threshold,
+    0,
+    "multiget-rxmit-threshold",
+    no_short,
+    "If non-zero, halve the multiget-max-inflight-keys limit whenever a"
+    " connection to a destination sees more retransmits per kb than this, and"
+    " grow it back slowly otherwise. Needs collect-rxmit-stats-every-hz.")
+
 MCROUTER_OPTION_INTEGER(
     int,
     asynclog_port_override,
@@ -730,6 +1533,15 @@ MCROUTER_OPTION_TOGGLE(
     no_short,
     "enable TFO when connecting/accepting via SSL")
 
+MCROUTER_OPTION_TOGGLE(
+    enable_ssl_ktls,
+    false,
+    "enable-ssl-ktls",
+    no_short,
+    "Switch SSL connections (both to destinations and from clients) to kernel"
+    " TLS after the handshake, so that encryption is done by the kernel."
+    " Requires OpenSSL and kernel with kTLS support.")
+
 #ifdef ADDITIONAL_OPTIONS_FILE
 #include ADDITIONAL_OPTIONS_FILE
 #endif
@@ -7,7 +7,9 @@
  */
 #pragma once
 
+#include <functional>
 #include <iterator>
+#include <memory>
 #include <type_traits>
 
 #include <folly/Range.h>
@@ -47,27 +49,32 @@ InputIterator reduce(InputIterator begin, InputIterator end) {
 template <class FuncIt>
 std::vector<typename std::result_of<
     typename std::iterator_traits<FuncIt>::value_type()>::type>
-BigValueRoute::collectAllByBatches(FuncIt beginF, FuncIt endF) const {
+BigValueRoute::collectAllWindowed(FuncIt beginF, FuncIt endF) const {
   using Reply = typename std::result_of<
       typename std::iterator_traits<FuncIt>::value_type()>::type;
 
-  auto batchSize = options_.batchSize;
   const size_t rangeSize = std::distance(beginF, endF);
-  if (batchSize == 0) {
-    batchSize = rangeSize;
+  auto windowSize = options_.batchSize;
+  if (windowSize == 0 || windowSize > rangeSize) {
+    windowSize = rangeSize;
   }
 
-  std::vector<Reply> allReplies;
-  size_t b = 0;
-  size_t e = std::min(rangeSize, batchSize);
-  while (b < rangeSize) {
-    auto replies = folly::fibers::collectAll(beginF + b, beginF + e);
-    for (auto& r : replies) {
-      allReplies.emplace_back(std::move(r));
-    }
-    b = e;
-    e = std::min(rangeSize, e + batchSize);
+  // Each worker picks the next unsent request as soon as its previous one
+  // completes, so there are always windowSize requests in flight (instead of
+  // waiting for the slowest request of every batch).
+  std::vector<Reply> allReplies(rangeSize);
+  size_t next = 0;
+  std::vector<std::function<void()>> workers;
+  workers.reserve(windowSize);
+  for (size_t i = 0; i < windowSize; ++i) {
+    workers.emplace_back([&beginF, &allReplies, &next, rangeSize]() {
+      while (next < rangeSize) {
+        auto idx = next++;
+        allReplies[idx] = (*(beginF + idx))();
+      }
+    });
   }
+  folly::fibers::collectAll(workers.begin(), workers.end());
   return allReplies;
 }
 
@@ -103,9 +110,9 @@ BigValueRoute::route(const Request& req) const {
     fs.push_back([&target, &chunkReq]() { return target.route(chunkReq); });
   }
 
-  auto replies = collectAllByBatches(fs.begin(), fs.end());
+  auto replies = collectAllWindowed(fs.begin(), fs.end());
   return mergeChunkGetReplies(
-      replies.begin(), replies.end(), std::move(initialReply));
+      replies.begin(), replies.end(), chunksInfo, std::move(initialReply));
 }
 
 template <class Request>
@@ -126,7 +133,7 @@ ReplyT<Request> BigValueRoute::route(
     fs.push_back([&target, &chunkReq]() { return target.route(chunkReq); });
   }
 
-  auto replies = collectAllByBatches(fs.begin(), fs.end());
+  auto replies = collectAllWindowed(fs.begin(), fs.end());
 
   // reply for all chunk update requests
   auto reducedReply = detail::reduce(replies.begin(), replies.end());
@@ -169,6 +176,7 @@ template <typename InputIterator, class Reply>
 Reply BigValueRoute::mergeChunkGetReplies(
     InputIterator begin,
     InputIterator end,
+    const ChunksInfo& info,
     Reply&& initialReply) const {
   auto reducedReplyIt = detail::reduce(begin, end);
   if (!isHitResult(reducedReplyIt->result())) {
@@ -177,15 +185,27 @@ Reply BigValueRoute::mergeChunkGetReplies(
 
   initialReply.result() = reducedReplyIt->result();
 
-  std::vector<std::unique_ptr<folly::IOBuf>> dataVec;
-  while (begin != end) {
-    if (begin->value().hasValue()) {
-      dataVec.push_back(begin->value()->clone());
+  // Chain the chunks together instead of copying them into one buffer.
+  folly::IOBuf value;
+  bool empty = true;
+  for (; begin != end; ++begin) {
+    if (!begin->value().hasValue()) {
+      continue;
+    }
+    if (empty) {
+      value = std::move(*begin->value());
+      empty = false;
+    } else {
+      value.prependChain(
+          std::make_unique<folly::IOBuf>(std::move(*begin->value())));
     }
-    ++begin;
   }
 
-  initialReply.value() = concatAll(dataVec.begin(), dataVec.end());
+  if (!decodeValue(info, value)) {
+    return Reply(mc_res_notfound);
+  }
+
+  initialReply.value() = std::move(value);
   return initialReply;
 }
 
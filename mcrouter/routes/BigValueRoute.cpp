@@ -7,10 +7,13 @@
  */
 #include "BigValueRoute.h"
 
+#include <array>
+
 #include <folly/Format.h>
 #include <folly/fibers/WhenN.h>
 
 #include "mcrouter/lib/AuxiliaryCPUThreadPool.h"
+#include "mcrouter/lib/fbi/cpp/util.h"
 #include "mcrouter/routes/McrouterRouteHandle.h"
 
 namespace facebook {
@@ -68,12 +71,12 @@ McLeaseGetReply BigValueRoute::doLeaseGetRoute(
     getsMetadataReply = target.route(getsMetadataReq);
   });
   tasks.emplace_back([ this, &replies, fs = std::move(fs) ]() mutable {
-    replies = collectAllByBatches(fs.begin(), fs.end());
+    replies = collectAllWindowed(fs.begin(), fs.end());
   });
 
   folly::fibers::collectAll(tasks.begin(), tasks.end());
   const auto reducedReply = mergeChunkGetReplies(
-      replies.begin(), replies.end(), std::move(initialReply));
+      replies.begin(), replies.end(), chunksInfo, std::move(initialReply));
 
   // Return reducedReply on hit or error
   if (!isMissResult(reducedReply.result())) {
@@ -119,26 +122,63 @@ McLeaseGetReply BigValueRoute::doLeaseGetRoute(
 
 BigValueRoute::ChunksInfo::ChunksInfo(folly::StringPiece replyValue)
     : infoVersion_(1), valid_(true) {
-  // Verify that replyValue is of the form version-numChunks-suffix,
-  // where version, numChunks and suffix should be numeric
-  uint32_t version;
-  int charsRead;
+  // Verify that replyValue is of the form version-numChunks-suffix (version 1)
+  // or version-numChunks-suffix-compression-uncompressedSize (version 2),
+  // where all the fields should be numeric
+  int charsRead = 0;
   valid_ &=
       (sscanf(
            replyValue.data(),
            "%u-%u-%lu%n",
-           &version,
+           &infoVersion_,
            &numChunks_,
            &suffix_,
            &charsRead) == 3);
+  if (valid_ && infoVersion_ == 2) {
+    uint32_t compression;
+    int moreCharsRead = 0;
+    valid_ &=
+        (sscanf(
+             replyValue.data() + charsRead,
+             "-%u-%zu%n",
+             &compression,
+             &uncompressedSize_,
+             &moreCharsRead) == 2);
+    charsRead += moreCharsRead;
+    compression_ = static_cast<CompressionCodecType>(compression);
+  } else {
+    valid_ &= (infoVersion_ == 1);
+  }
   valid_ &= (static_cast<size_t>(charsRead) == replyValue.size());
-  valid_ &= (version == infoVersion_);
 }
 
 BigValueRoute::ChunksInfo::ChunksInfo(uint32_t chunks, uint64_t suffix__)
     : infoVersion_(1), numChunks_(chunks), suffix_(suffix__), valid_(true) {}
 
+BigValueRoute::ChunksInfo::ChunksInfo(
+    uint32_t chunks,
+    uint64_t suffix__,
+    CompressionCodecType compression__,
+    size_t uncompressedSize__)
+    : infoVersion_(2),
+      numChunks_(chunks),
+      suffix_(suffix__),
+      compression_(compression__),
+      uncompressedSize_(uncompressedSize__),
+      valid_(true) {}
+
 folly::IOBuf BigValueRoute::ChunksInfo::toStringType() const {
+  if (infoVersion_ == 2) {
+    return folly::IOBuf(
+        folly::IOBuf::COPY_BUFFER,
+        folly::sformat(
+            "{}-{}-{}-{}-{}",
+            infoVersion_,
+            numChunks_,
+            suffix_,
+            static_cast<uint32_t>(compression_),
+            uncompressedSize_));
+  }
   return folly::IOBuf(
       folly::IOBuf::COPY_BUFFER,
       folly::sformat("{}-{}-{}", infoVersion_, numChunks_, suffix_));
@@ -156,13 +196,53 @@ bool BigValueRoute::ChunksInfo::valid() const {
   return valid_;
 }
 
+bool BigValueRoute::ChunksInfo::hasChecksum() const {
+  return infoVersion_ >= 2;
+}
+
+CompressionCodecType BigValueRoute::ChunksInfo::compression() const {
+  return compression_;
+}
+
+size_t BigValueRoute::ChunksInfo::uncompressedSize() const {
+  return uncompressedSize_;
+}
+
+namespace {
+
+/**
+ * Codecs are not thread-safe, so every thread (proxy or thread pool) creates
+ * its own on first use.
+ */
+CompressionCodec* getCodec(CompressionCodecType type) {
+  static thread_local std::array<std::unique_ptr<CompressionCodec>, 4> codecs;
+  auto idx = static_cast<size_t>(type);
+  if (idx >= codecs.size()) {
+    return nullptr;
+  }
+  if (!codecs[idx]) {
+    codecs[idx] = createCompressionCodec(
+        type, folly::IOBuf::create(0) /* no dictionary */, 0 /* id */);
+  }
+  return codecs[idx].get();
+}
+
+} // anonymous
+
 BigValueRoute::BigValueRoute(
     std::shared_ptr<MemcacheRouteHandleIf> ch,
     BigValueRouteOptions options)
     : ch_(std::move(ch)), options_(options) {
   assert(ch_ != nullptr);
+  if (options_.compression != CompressionCodecType::NO_COMPRESSION) {
+    checkLogic(
+        getCodec(options_.compression) != nullptr,
+        "BigValueRoute: compression codec {} is not available",
+        static_cast<uint32_t>(options_.compression));
+  }
 }
 
+
 folly::IOBuf BigValueRoute::createChunkKey(
     folly::StringPiece baseKey,
     uint32_t chunkIndex,
@@ -177,38 +257,64 @@ namespace {
 // Hashes value on a separate CPU thread pool, preempts fiber until hashing is
 // complete.
 uint64_t hashBigValue(const folly::IOBuf& value) {
-  if (auto singleton = AuxiliaryCPUThreadPoolSingleton::try_get_fast()) {
-    auto& threadPool = singleton->getThreadPool();
-    return folly::fibers::await([&](folly::fibers::Promise<uint64_t> promise) {
-      threadPool.add([ promise = std::move(promise), &value ]() mutable {
-        auto hash = folly::IOBufHash()(value);
-        // Note: for compatibility with old code running in production we're
-        // using only 32-bits of hash.
-        promise.setValue(hash & ((1ull << 32) - 1));
-      });
-    });
-  }
-  throwRuntime(
-      "Mcrouter CPU Thread pool is not running, cannot calculate hash for big "
-      "value!");
+  return runOnAuxiliaryCPUThreadPool([&value]() -> uint64_t {
+    auto hash = folly::IOBufHash()(value);
+    // Note: for compatibility with old code running in production we're
+    // using only 32-bits of hash.
+    return hash & ((1ull << 32) - 1);
+  });
 }
 
 } // anonymous
 
+bool BigValueRoute::decodeValue(const ChunksInfo& info, folly::IOBuf& value)
+    const {
+  if (info.compression() != CompressionCodecType::NO_COMPRESSION) {
+    if (getCodec(info.compression()) == nullptr) {
+      return false;
+    }
+    try {
+      value = std::move(*runOnAuxiliaryCPUThreadPool([&]() {
+        return getCodec(info.compression())
+            ->uncompress(value, info.uncompressedSize());
+      }));
+    } catch (const std::exception&) {
+      return false;
+    }
+  }
+  return !info.hasChecksum() || hashBigValue(value) == info.suffix();
+}
+
 std::pair<std::vector<McSetRequest>, BigValueRoute::ChunksInfo>
 BigValueRoute::chunkUpdateRequests(
     folly::StringPiece baseKey,
     const folly::IOBuf& value,
     int32_t exptime) const {
-  int numChunks = (value.computeChainDataLength() + options_.threshold - 1) /
+  const auto suffix = hashBigValue(value);
+  const folly::IOBuf* data = &value;
+  std::unique_ptr<folly::IOBuf> compressed;
+  if (options_.compression != CompressionCodecType::NO_COMPRESSION) {
+    compressed = runOnAuxiliaryCPUThreadPool([&]() {
+      return getCodec(options_.compression)->compress(value);
+    });
+    data = compressed.get();
+  }
+
+  int numChunks = (data->computeChainDataLength() + options_.threshold - 1) /
       options_.threshold;
-  ChunksInfo info(numChunks, hashBigValue(value));
+  ChunksInfo info = compressed
+      ? ChunksInfo(
+            numChunks,
+            suffix,
+            options_.compression,
+            value.computeChainDataLength())
+      : ChunksInfo(numChunks, suffix);
 
   std::vector<McSetRequest> bigSetReqs;
   bigSetReqs.reserve(numChunks);
 
   folly::IOBuf chunkValue;
-  folly::io::Cursor cursor(&value);
+  folly::io::Cursor cursor(data);
   for (int i = 0; i < numChunks; ++i) {
     cursor.cloneAtMost(chunkValue, options_.threshold);
     bigSetReqs.emplace_back(createChunkKey(baseKey, i, info.suffix()));
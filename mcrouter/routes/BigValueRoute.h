@@ -7,12 +7,14 @@
  */
 #pragma once
 
+#include <memory>
 #include <vector>
 
 #include <folly/Format.h>
 #include <folly/Traits.h>
 
 #include "mcrouter/ProxyRequestContext.h"
+#include "mcrouter/lib/Compression.h"
 #include "mcrouter/lib/McOperation.h"
 #include "mcrouter/lib/Operation.h"
 #include "mcrouter/lib/RouteHandleTraverser.h"
@@ -49,6 +51,11 @@ namespace mcrouter {
  * to child route handle and return reply. Else, return worse of the
  * replies for chunk updates
  *
+ * If compression is configured, big values are compressed before being
+ * split, and the chunks info records the codec, the uncompressed size and
+ * uses the value's hash as a checksum. Such values are uncompressed and
+ * verified after all the chunks are fetched; a corrupt value is a miss.
+ *
  * Default behavior for other type of operations
  */
 class BigValueRoute {
@@ -93,19 +100,40 @@ class BigValueRoute {
    public:
     explicit ChunksInfo(folly::StringPiece replyValue);
     explicit ChunksInfo(uint32_t numChunks, uint64_t suffix__);
+    /**
+     * Info of a compressed value. suffix__ must be the hash of the
+     * uncompressed value, it is verified on reads.
+     */
+    ChunksInfo(
+        uint32_t numChunks,
+        uint64_t suffix__,
+        CompressionCodecType compression__,
+        size_t uncompressedSize__);
 
     folly::IOBuf toStringType() const;
     uint32_t numChunks() const;
     uint64_t suffix() const;
     bool valid() const;
+    bool hasChecksum() const;
+    CompressionCodecType compression() const;
+    size_t uncompressedSize() const;
 
    private:
-    const uint32_t infoVersion_;
+    uint32_t infoVersion_;
     uint32_t numChunks_;
     uint64_t suffix_;
+    CompressionCodecType compression_{CompressionCodecType::NO_COMPRESSION};
+    size_t uncompressedSize_{0};
     bool valid_;
   };
 
+  /**
+   * Uncompresses the merged chunks (if needed) and verifies the checksum.
+   *
+   * @return  false if the value is corrupt.
+   */
+  bool decodeValue(const ChunksInfo& info, folly::IOBuf& value) const;
+
   McLeaseGetReply doLeaseGetRoute(
       const McLeaseGetRequest& req,
       size_t retriesLeft) const;
@@ -113,7 +141,7 @@ class BigValueRoute {
   template <class FuncIt>
   std::vector<typename std::result_of<
       typename std::iterator_traits<FuncIt>::value_type()>::type>
-  collectAllByBatches(FuncIt beginF, FuncIt endF) const;
+  collectAllWindowed(FuncIt beginF, FuncIt endF) const;
 
   std::pair<std::vector<McSetRequest>, ChunksInfo> chunkUpdateRequests(
       folly::StringPiece baseKey,
@@ -129,6 +157,7 @@ class BigValueRoute {
   Reply mergeChunkGetReplies(
       InputIterator begin,
       InputIterator end,
+      const ChunksInfo& info,
       Reply&& initReply) const;
 
   folly::IOBuf
@@ -7,15 +7,26 @@
  */
 #pragma once
 
+#include <cstddef>
+
+#include "mcrouter/lib/Compression.h"
+
 namespace facebook {
 namespace memcache {
 namespace mcrouter {
 
 struct BigValueRouteOptions {
-  constexpr explicit BigValueRouteOptions(size_t threshold_, size_t batchSize_)
-      : threshold(threshold_), batchSize(batchSize_) {}
+  constexpr explicit BigValueRouteOptions(
+      size_t threshold_,
+      size_t batchSize_,
+      CompressionCodecType compression_ = CompressionCodecType::NO_COMPRESSION)
+      : threshold(threshold_),
+        batchSize(batchSize_),
+        compression(compression_) {}
   const size_t threshold;
   const size_t batchSize;
+  // Codec used to compress big values before splitting them into chunks.
+  const CompressionCodecType compression;
 };
 
 } // mcrouter
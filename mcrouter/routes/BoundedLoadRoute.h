@@ -0,0 +1,189 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <cassert>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <folly/Conv.h>
+#include <folly/Range.h>
+#include <folly/ScopeGuard.h>
+#include <folly/dynamic.h>
+#include <folly/fibers/FiberManager.h>
+
+#include "mcrouter/McrouterFiberContext.h"
+#include "mcrouter/ProxyBase.h"
+#include "mcrouter/lib/Ch3HashFunc.h"
+#include "mcrouter/lib/HashUtil.h"
+#include "mcrouter/lib/RouteHandleTraverser.h"
+#include "mcrouter/lib/fbi/cpp/util.h"
+#include "mcrouter/lib/routes/NullRoute.h"
+#include "mcrouter/routes/McRouteHandleBuilder.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Consistent hashing with bounded loads.
+ *
+ * Each key is hashed with Ch3 like in a regular hash route. If the chosen
+ * child already has more requests in flight than (1 + epsilon) times the
+ * average over all children, the key is rehashed (with salts "1", "2", ...)
+ * until a child under the bound is found; after kMaxRehashes attempts the
+ * children following the first choice are tried in order. Only the keys of
+ * overloaded children move, and they move back as soon as the load drops,
+ * so hot keys spread out without disturbing the rest of the keyspace.
+ *
+ * In-flight counts are local to the route (i.e. to the proxy).
+ */
+template <class RouterInfo>
+class BoundedLoadRoute {
+ private:
+  using RouteHandleIf = typename RouterInfo::RouteHandleIf;
+
+ public:
+  static constexpr size_t kMaxRehashes = 8;
+
+  std::string routeName() const {
+    return folly::to<std::string>(
+        "hash|BoundedLoadCh3|epsilon=",
+        epsilon_,
+        (salt_.empty() ? "" : "|salt=" + salt_));
+  }
+
+  template <class Request>
+  void traverse(
+      const Request& req,
+      const RouteHandleTraverser<RouteHandleIf>& t) const {
+    t(*children_[select(req)], req);
+  }
+
+  BoundedLoadRoute(
+      std::vector<std::shared_ptr<RouteHandleIf>> children,
+      std::string salt,
+      double epsilon)
+      : children_(std::move(children)),
+        salt_(std::move(salt)),
+        epsilon_(epsilon),
+        hashFunc_(children_.size()),
+        inflight_(children_.size(), 0) {
+    assert(children_.size() >= 2);
+  }
+
+  template <class Request>
+  ReplyT<Request> route(const Request& req) {
+    auto idx = select(req);
+    ++inflight_[idx];
+    ++totalInflight_;
+    SCOPE_EXIT {
+      --inflight_[idx];
+      --totalInflight_;
+    };
+    return children_[idx]->route(req);
+  }
+
+ private:
+  const std::vector<std::shared_ptr<RouteHandleIf>> children_;
+  const std::string salt_;
+  const double epsilon_;
+  const Ch3HashFunc hashFunc_;
+  std::vector<size_t> inflight_;
+  size_t totalInflight_{0};
+
+  template <class Request>
+  size_t select(const Request& req) const {
+    // Hash functions can be stack-intensive so jump back to the main context
+    return folly::fibers::runInMainContext(
+        [this, &req]() { return selectInternal(req.key().routingKey()); });
+  }
+
+  size_t selectInternal(folly::StringPiece key) const {
+    const size_t n = children_.size();
+    // Load of a child with this request added must not exceed the bound.
+    const double bound =
+        std::ceil((totalInflight_ + 1) * (1.0 + epsilon_) / n);
+
+    auto idx = hash(key, 0);
+    if (inflight_[idx] + 1 <= bound) {
+      return idx;
+    }
+
+    if (auto& ctx = fiber_local<RouterInfo>::getSharedCtx()) {
+      ctx->proxy().stats().increment(bounded_load_spills_stat);
+    }
+    for (size_t i = 1; i <= kMaxRehashes; ++i) {
+      auto next = hash(key, i);
+      if (inflight_[next] + 1 <= bound) {
+        return next;
+      }
+    }
+    // The bound is above the average, so some child is always under it.
+    for (size_t i = 1; i < n; ++i) {
+      auto next = (idx + i) % n;
+      if (inflight_[next] + 1 <= bound) {
+        return next;
+      }
+    }
+    return idx;
+  }
+
+  size_t hash(folly::StringPiece key, size_t attempt) const {
+    if (salt_.empty() && attempt == 0) {
+      return hashFunc_(key);
+    }
+    auto salt = attempt == 0 ? salt_ : folly::to<std::string>(salt_, attempt);
+    return hashWithSalt(key, salt, [this](folly::StringPiece sp) {
+      return hashFunc_(sp);
+    });
+  }
+};
+
+template <class RouterInfo>
+constexpr size_t BoundedLoadRoute<RouterInfo>::kMaxRehashes;
+
+/**
+ * @param json  May contain "salt" and "epsilon" (default 0.25): a child
+ *              gets at most (1 + epsilon) times the average in-flight load.
+ */
+template <class RouterInfo>
+typename RouterInfo::RouteHandlePtr createBoundedLoadRoute(
+    const folly::dynamic& json,
+    std::vector<typename RouterInfo::RouteHandlePtr> children) {
+  if (children.empty()) {
+    return createNullRoute<typename RouterInfo::RouteHandleIf>();
+  }
+  if (children.size() == 1) {
+    return std::move(children[0]);
+  }
+
+  std::string salt;
+  double epsilon = 0.25;
+  if (json.isObject()) {
+    if (auto jsalt = json.get_ptr("salt")) {
+      checkLogic(jsalt->isString(), "BoundedLoadCh3: salt is not a string");
+      salt = jsalt->getString();
+    }
+    if (auto jepsilon = json.get_ptr("epsilon")) {
+      checkLogic(
+          jepsilon->isNumber(), "BoundedLoadCh3: epsilon is not a number");
+      epsilon = jepsilon->asDouble();
+      checkLogic(epsilon > 0, "BoundedLoadCh3: epsilon should be positive");
+    }
+  }
+
+  return makeRouteHandleWithInfo<RouterInfo, BoundedLoadRoute>(
+      std::move(children), std::move(salt), epsilon);
+}
+
+} // mcrouter
+} // memcache
+} // facebook
@@ -0,0 +1,305 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <folly/Optional.h>
+#include <folly/Range.h>
+#include <folly/fibers/Baton.h>
+#include <folly/hash/Hash.h>
+
+#include "mcrouter/McrouterFiberContext.h"
+#include "mcrouter/ProxyBase.h"
+#include "mcrouter/ProxyRequestContext.h"
+#include "mcrouter/lib/McResUtil.h"
+#include "mcrouter/lib/Reply.h"
+#include "mcrouter/lib/RouteHandleTraverser.h"
+#include "mcrouter/lib/config/RouteHandleBuilder.h"
+#include "mcrouter/lib/network/gen/Memcache.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Coalesces identical in-flight gets: while a get for some key is being
+ * processed by the child route, further gets for the same key don't go to
+ * the child, but wait for the in-flight one and get a copy of its reply.
+ *
+ * Lease-gets are collapsed as well if leaseFillTimeout is not zero. When the
+ * first lease-get misses and gets a lease token, the following lease-gets
+ * for the key (which memcached would answer with a hot miss, making clients
+ * retry) keep waiting until the lease-set with that token passes through
+ * this route, and are served its value. Lease-gets that waited for longer
+ * than leaseFillTimeout, or whose fill failed, are sent to the child.
+ * This route should be below any route translating lease tokens
+ * (FailoverRoute), so that it sees the tokens returned by memcached.
+ *
+ * All other requests are passed through as is.
+ *
+ * Leases whose fill timed out are swept on every lease-get, so keys that
+ * are never filled don't pile up.
+ *
+ * Route handles are per proxy, so the map of in-flight keys is too, and no
+ * synchronization is needed.
+ */
+template <class RouterInfo>
+class CoalescingRoute {
+ private:
+  using RouteHandleIf = typename RouterInfo::RouteHandleIf;
+
+ public:
+  std::string routeName() const {
+    return "coalescing";
+  }
+
+  template <class Request>
+  void traverse(
+      const Request& req,
+      const RouteHandleTraverser<RouteHandleIf>& t) const {
+    t(*target_, req);
+  }
+
+  explicit CoalescingRoute(
+      std::shared_ptr<RouteHandleIf> target,
+      bool coalesceGets = true,
+      std::chrono::milliseconds leaseFillTimeout = std::chrono::milliseconds(0))
+      : target_(std::move(target)),
+        coalesceGets_(coalesceGets),
+        leaseFillTimeout_(leaseFillTimeout) {}
+
+  template <class Request>
+  ReplyT<Request> route(const Request& req) {
+    return target_->route(req);
+  }
+
+  McGetReply route(const McGetRequest& req) {
+    if (!coalesceGets_) {
+      return target_->route(req);
+    }
+    const auto key = req.key().fullKey();
+    auto it = inflight_.find(key);
+    if (it != inflight_.end()) {
+      auto entry = it->second;
+      auto& stats = fiber_local<RouterInfo>::getSharedCtx()->proxy().stats();
+      stats.increment(coalesced_get_reqs_stat);
+      stats.increment(coalesced_get_reqs_waiting_stat);
+
+      folly::fibers::Baton baton;
+      entry->waiters.push_back(&baton);
+      baton.wait();
+
+      stats.decrement(coalesced_get_reqs_waiting_stat);
+      return *entry->reply;
+    }
+
+    // The key is owned by req, which outlives the map entry.
+    auto entry = std::make_shared<Entry>();
+    inflight_.emplace(key, entry);
+    try {
+      entry->reply = target_->route(req);
+    } catch (const std::exception& e) {
+      entry->reply = createReply<McGetRequest>(ErrorReply, e.what());
+      wakeUpWaiters(key, *entry);
+      throw;
+    }
+    wakeUpWaiters(key, *entry);
+    return *entry->reply;
+  }
+
+  McLeaseGetReply route(const McLeaseGetRequest& req) {
+    if (leaseFillTimeout_.count() == 0) {
+      return target_->route(req);
+    }
+
+    sweepExpiredLeases();
+
+    const auto key = req.key().fullKey();
+    auto it = leases_.find(key.str());
+    if (it != leases_.end() && it->second->fillExpired()) {
+      auto expired = it->second;
+      finishLease(key, expired);
+      it = leases_.end();
+    }
+    if (it != leases_.end()) {
+      return waitForLease(req, it->second);
+    }
+
+    auto entry = std::make_shared<LeaseEntry>();
+    leases_.emplace(key.str(), entry);
+    McLeaseGetReply reply;
+    try {
+      reply = target_->route(req);
+    } catch (const std::exception& e) {
+      entry->reply = createReply<McLeaseGetRequest>(ErrorReply, e.what());
+      finishLease(key, entry);
+      throw;
+    }
+
+    if (isMissResult(reply.result()) &&
+        static_cast<uint64_t>(reply.leaseToken()) > kHotMissLeaseToken) {
+      // The client of this request is going to fill the key, keep the
+      // waiters (and the following lease-gets) until it does.
+      entry->fillToken = reply.leaseToken();
+      entry->fillDeadline = LeaseEntry::Clock::now() + leaseFillTimeout_;
+      fillDeadlines_.emplace_back(entry->fillDeadline, key.str());
+      return reply;
+    }
+    entry->reply = reply;
+    finishLease(key, entry);
+    return reply;
+  }
+
+  McLeaseSetReply route(const McLeaseSetRequest& req) {
+    auto reply = target_->route(req);
+    if (leaseFillTimeout_.count() == 0) {
+      return reply;
+    }
+
+    auto it = leases_.find(req.key().fullKey().str());
+    if (it == leases_.end() || it->second->fillToken == 0 ||
+        it->second->fillToken != req.leaseToken()) {
+      return reply;
+    }
+    auto entry = it->second;
+    if (isStoredResult(reply.result())) {
+      McLeaseGetReply filled(mc_res_found);
+      filled.value() = req.value();
+      filled.flags() = req.flags();
+      entry->reply = std::move(filled);
+      fiber_local<RouterInfo>::getSharedCtx()->proxy().stats().increment(
+          lease_fills_shared_stat);
+    }
+    finishLease(req.key().fullKey(), entry);
+    return reply;
+  }
+
+  /**
+   * @return  number of keys with a lease-get in flight or a fill pending.
+   */
+  size_t leasesPending() const {
+    return leases_.size();
+  }
+
+ private:
+  struct Entry {
+    folly::Optional<McGetReply> reply;
+    std::vector<folly::fibers::Baton*> waiters;
+  };
+
+  struct LeaseEntry {
+    using Clock = std::chrono::steady_clock;
+
+    // Set when the waiters should return it, otherwise they go to the child.
+    folly::Optional<McLeaseGetReply> reply;
+    std::vector<folly::fibers::Baton*> waiters;
+    // Lease token handed out by the first lease-get, 0 while it's in flight.
+    int64_t fillToken{0};
+    Clock::time_point fillDeadline;
+
+    bool fillExpired() const {
+      return fillToken != 0 && Clock::now() >= fillDeadline;
+    }
+  };
+
+  static constexpr uint64_t kHotMissLeaseToken = 1;
+
+  const std::shared_ptr<RouteHandleIf> target_;
+  const bool coalesceGets_;
+  const std::chrono::milliseconds leaseFillTimeout_;
+  std::unordered_map<
+      folly::StringPiece,
+      std::shared_ptr<Entry>,
+      folly::hasher<folly::StringPiece>>
+      inflight_;
+  // Keys are owned by the map: a lease may outlive the lease-get.
+  std::unordered_map<std::string, std::shared_ptr<LeaseEntry>> leases_;
+  // Keys of the pending fills in the order they were handed out. All fills
+  // have the same timeout, so the deadlines are sorted too.
+  std::deque<std::pair<typename LeaseEntry::Clock::time_point, std::string>>
+      fillDeadlines_;
+
+  void wakeUpWaiters(folly::StringPiece key, Entry& entry) {
+    inflight_.erase(key);
+    for (auto* baton : entry.waiters) {
+      baton->post();
+    }
+  }
+
+  McLeaseGetReply waitForLease(
+      const McLeaseGetRequest& req,
+      std::shared_ptr<LeaseEntry> entry) {
+    auto& stats = fiber_local<RouterInfo>::getSharedCtx()->proxy().stats();
+    stats.increment(coalesced_lease_get_reqs_stat);
+    stats.increment(coalesced_get_reqs_waiting_stat);
+
+    folly::fibers::Baton baton;
+    entry->waiters.push_back(&baton);
+    const bool posted = baton.try_wait_for(leaseFillTimeout_);
+    stats.decrement(coalesced_get_reqs_waiting_stat);
+
+    if (!posted) {
+      auto& waiters = entry->waiters;
+      waiters.erase(
+          std::remove(waiters.begin(), waiters.end(), &baton), waiters.end());
+    } else if (entry->reply) {
+      return *entry->reply;
+    }
+    return target_->route(req);
+  }
+
+  void sweepExpiredLeases() {
+    const auto now = LeaseEntry::Clock::now();
+    while (!fillDeadlines_.empty() && fillDeadlines_.front().first <= now) {
+      auto it = leases_.find(fillDeadlines_.front().second);
+      // The key may have been filled (and even leased again) since.
+      if (it != leases_.end() && it->second->fillExpired()) {
+        auto expired = it->second;
+        finishLease(fillDeadlines_.front().second, expired);
+      }
+      fillDeadlines_.pop_front();
+    }
+  }
+
+  void finishLease(
+      folly::StringPiece key,
+      const std::shared_ptr<LeaseEntry>& entry) {
+    auto it = leases_.find(key.str());
+    if (it != leases_.end() && it->second == entry) {
+      leases_.erase(it);
+    }
+    for (auto* baton : entry->waiters) {
+      baton->post();
+    }
+    entry->waiters.clear();
+  }
+};
+
+template <class RouterInfo>
+constexpr uint64_t CoalescingRoute<RouterInfo>::kHotMissLeaseToken;
+
+template <class RouterInfo>
+std::shared_ptr<typename RouterInfo::RouteHandleIf> makeCoalescingRoute(
+    std::shared_ptr<typename RouterInfo::RouteHandleIf> target,
+    bool coalesceGets = true,
+    std::chrono::milliseconds leaseFillTimeout = std::chrono::milliseconds(0)) {
+  return makeRouteHandleWithInfo<RouterInfo, CoalescingRoute>(
+      std::move(target), coalesceGets, leaseFillTimeout);
+}
+
+} // mcrouter
+} // memcache
+} // facebook
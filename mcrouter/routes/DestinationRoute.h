@@ -25,6 +25,7 @@
 #include "mcrouter/config.h"
 #include "mcrouter/lib/Reply.h"
 #include "mcrouter/lib/RouteHandleTraverser.h"
+#include "mcrouter/lib/carbon/RequestReplyUtil.h"
 #include "mcrouter/lib/config/RouteHandleBuilder.h"
 #include "mcrouter/lib/fbi/cpp/util.h"
 #include "mcrouter/lib/network/gen/Memcache.h"
@@ -130,6 +131,11 @@ class DestinationRoute {
       return constructAndLog(req, *ctx, BusyReply);
     }
 
+    if (fiber_local<RouterInfo>::deadlineExceeded()) {
+      return constructAndLog(
+          req, *ctx, ErrorReply, mc_res_timeout, "Request deadline exceeded");
+    }
+
     if (poolStatIndex_ >= 0) {
       ctx->setPoolStatsIndex(poolStatIndex_);
     }
@@ -142,6 +148,15 @@ class DestinationRoute {
       return constructAndLog(req, *ctx, DefaultReply, req);
     }
 
+    if (fiber_local<RouterInfo>::getSpilloverAllowed() &&
+        !requestClass.is(RequestClass::kShadow) &&
+        destination_->spilloverSaturated()) {
+      // Not logged: the request goes to another replica instead.
+      fiber_local<RouterInfo>::setSpilledOver(true);
+      return createReply<Request>(
+          ErrorReply, "Destination queue is full, request spilled over");
+    }
+
     auto proxy = &ctx->proxy();
     if (requestClass.is(RequestClass::kShadow)) {
       if (proxy->router().opts().target_max_shadow_requests > 0 &&
@@ -190,6 +205,7 @@ class DestinationRoute {
       const Request& req,
       ProxyRequestContextWithInfo<RouterInfo>& ctx) const {
     DestinationRequestCtx dctx(nowUs());
+    dctx.lowPriority = ctx.priority() == ProxyRequestPriority::kAsync;
     folly::Optional<Request> newReq;
     folly::StringPiece strippedRoutingPrefix;
     if (!keepRoutingPrefix_ && !req.key().routingPrefix().empty()) {
@@ -207,7 +223,11 @@ class DestinationRoute {
 
     const auto& reqToSend = newReq ? *newReq : req;
     ReplyStatsContext replyContext;
-    auto reply = destination_->send(reqToSend, dctx, timeout_, replyContext);
+    auto reply = destination_->send(
+        reqToSend,
+        dctx,
+        ctx.clampToDeadline(destination_->effectiveTimeout(timeout_)),
+        replyContext);
     ctx.onReplyReceived(
         poolName_,
         *destination_->accessPoint(),
@@ -221,9 +241,26 @@ class DestinationRoute {
         replyContext);
 
     fiber_local<RouterInfo>::setServerLoad(replyContext.serverLoad);
+    sampleForDictionaryTraining(ctx, reqToSend, reply);
     return reply;
   }
 
+  template <class Request>
+  void sampleForDictionaryTraining(
+      ProxyRequestContextWithInfo<RouterInfo>& ctx,
+      const Request& req,
+      const ReplyT<Request>& reply) const {
+    auto* trainer = ctx.proxy().router().dictionaryTrainer();
+    if (LIKELY(trainer == nullptr) || !trainer->shouldSample()) {
+      return;
+    }
+    if (auto value = carbon::valuePtrUnsafe(req)) {
+      trainer->addSample(poolName_, *value);
+    } else if (auto value = carbon::valuePtrUnsafe(reply)) {
+      trainer->addSample(poolName_, *value);
+    }
+  }
+
   template <class Request>
   bool spool(const Request& req) const {
     auto asynclogName = fiber_local<RouterInfo>::getAsynclogName();
@@ -239,10 +276,8 @@ class DestinationRoute {
     folly::fibers::Baton b;
     auto res = false;
     if (auto asyncWriter = proxy->router().asyncWriter()) {
-      res = asyncWriter->run([&b, &ap, proxy, key, asynclogName]() {
-        proxy->asyncLog().writeDelete(ap, key, asynclogName);
-        b.post();
-      });
+      res = proxy->asyncLog().writeDelete(
+          *asyncWriter, ap, key, asynclogName, [&b]() { b.post(); });
     }
     if (!res) {
       MC_LOG_FAILURE(
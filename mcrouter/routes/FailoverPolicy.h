@@ -7,6 +7,8 @@
  */
 #pragma once
 
+#include <algorithm>
+#include <chrono>
 #include <memory>
 #include <vector>
 
@@ -14,8 +16,12 @@
 
 #include <folly/dynamic.h>
 
+#include "mcrouter/McrouterFiberContext.h"
+#include "mcrouter/config.h"
+#include "mcrouter/lib/McResUtil.h"
 #include "mcrouter/lib/Operation.h"
 #include "mcrouter/lib/fbi/cpp/ParsingUtil.h"
+#include "mcrouter/lib/network/ServerLoad.h"
 
 namespace facebook {
 namespace memcache {
@@ -207,6 +213,191 @@ class FailoverLeastFailuresPolicy {
 
   std::vector<size_t> recentErrorCount_;
 };
+
+/**
+ * Sends the request to the first child, and fails over to the other children
+ * ordered by how busy they were last seen, so that failover traffic goes to
+ * the least loaded replica instead of always the second child.
+ *
+ * Config: {"type": "LoadAwarePolicy", "max_tries": N, "metric": M,
+ *          "ttl_ms": T}
+ *  - max_tries: how many children to try, defaults to all of them;
+ *  - metric: "load" orders by the server load reported in replies (as used
+ *    by LoadBalancerRoute), error replies count as fully loaded; "latency"
+ *    orders by a moving average of the latency of each child;
+ *  - ttl_ms: observations older than this are forgotten (default 1000).
+ * Children without a recent observation keep their config order, ahead of
+ * the ones that were seen busy.
+ */
+template <typename RouteHandleIf, typename RouterInfo>
+class FailoverLoadAwarePolicy {
+ public:
+  static constexpr bool optimizeNoFailoverRouteCase = true;
+  using RouteHandlePtr = std::shared_ptr<RouteHandleIf>;
+
+  FailoverLoadAwarePolicy(
+      const std::vector<std::shared_ptr<RouteHandleIf>>& children,
+      const folly::dynamic& policyConfig)
+      : children_(children),
+        maxTries_(children_.size()),
+        costs_(children_.size()) {
+    if (auto jMaxTries = policyConfig.get_ptr("max_tries")) {
+      maxTries_ = static_cast<size_t>(
+          parseInt(*jMaxTries, "max_tries", 1, children_.size()));
+    }
+    if (auto jMetric = policyConfig.get_ptr("metric")) {
+      auto metric = parseString(*jMetric, "metric");
+      if (metric == "latency") {
+        useLatency_ = true;
+      } else {
+        checkLogic(
+            metric == "load",
+            "Failover: LoadAwarePolicy metric should be 'load' or 'latency'");
+      }
+    }
+    if (auto jTtl = policyConfig.get_ptr("ttl_ms")) {
+      ttlUs_ = parseTimeout(*jTtl, "ttl_ms").count() * 1000;
+    }
+  }
+
+  class ChildProxy {
+   public:
+    ChildProxy(FailoverLoadAwarePolicy& failoverPolicy, size_t index)
+        : failoverPolicy_(failoverPolicy), index_(index) {}
+
+    template <class Request>
+    ReplyT<Request> route(const Request& req) {
+      return fiber_local<RouterInfo>::runWithLocals([this, &req]() {
+        fiber_local<RouterInfo>::setServerLoad(ServerLoad::zero());
+        const auto start = nowUs();
+        auto reply = failoverPolicy_.children_[index_]->route(req);
+        const auto end = nowUs();
+        failoverPolicy_.observe(
+            index_,
+            isErrorResult(reply.result()),
+            fiber_local<RouterInfo>::getServerLoad(),
+            end - start,
+            end);
+        return reply;
+      });
+    }
+
+   private:
+    FailoverLoadAwarePolicy& failoverPolicy_;
+    size_t index_;
+  };
+
+  class Iterator : public boost::iterator_facade<
+                       Iterator,
+                       ChildProxy,
+                       std::forward_iterator_tag,
+                       ChildProxy> {
+   public:
+    Iterator(FailoverLoadAwarePolicy& failoverPolicy, size_t id)
+        : policy_(failoverPolicy), id_(id) {}
+
+    size_t getTrueIndex() const {
+      return id_ == 0 ? id_ : order_[id_];
+    }
+
+   private:
+    void increment() {
+      if (id_ == 0) {
+        order_ = policy_.getLeastLoadedRouteIndices();
+      }
+      ++id_;
+    }
+
+    bool equal(const Iterator& other) const {
+      return id_ == other.id_;
+    }
+
+    ChildProxy dereference() const {
+      return ChildProxy(policy_, getTrueIndex());
+    }
+
+    friend class boost::iterator_core_access;
+
+    FailoverLoadAwarePolicy& policy_;
+    std::vector<size_t> order_;
+    size_t id_;
+  };
+
+  Iterator begin() {
+    return Iterator(*this, 0);
+  }
+
+  Iterator end() {
+    return Iterator(*this, maxTries_);
+  }
+
+  // Returns the stat to increment when failover occurs.
+  stat_name_t getFailoverStat() const {
+    return failover_load_aware_policy_stat;
+  }
+
+  // Returns the stat when all failover destinations are exhausted.
+  stat_name_t getFailoverFailedStat() const {
+    return failover_load_aware_policy_failed_stat;
+  }
+
+ private:
+  struct Cost {
+    // Load percent or latency (us) moving average, 0 if unknown.
+    double value{0.0};
+    // Time of the last observation.
+    int64_t updateUs{0};
+  };
+
+  const std::vector<RouteHandlePtr>& children_;
+  size_t maxTries_;
+  bool useLatency_{false};
+  int64_t ttlUs_{1000000};
+  std::vector<Cost> costs_;
+
+  void observe(
+      size_t idx,
+      bool isError,
+      ServerLoad load,
+      int64_t latencyUs,
+      int64_t now) {
+    auto& cost = costs_[idx];
+    if (useLatency_) {
+      // Errors (timeouts in particular) show up as high latency.
+      cost.value = fresh(cost, now) ? (cost.value + latencyUs) / 2
+                                    : static_cast<double>(latencyUs);
+    } else if (isError) {
+      cost.value = 100.0;
+    } else if (!load.isZero()) {
+      cost.value = load.percentLoad();
+    } else {
+      // Nothing reported, keep what we knew.
+      return;
+    }
+    cost.updateUs = now;
+  }
+
+  bool fresh(const Cost& cost, int64_t now) const {
+    return cost.updateUs != 0 && now - cost.updateUs <= ttlUs_;
+  }
+
+  std::vector<size_t> getLeastLoadedRouteIndices() const {
+    const auto now = nowUs();
+    std::vector<double> current(costs_.size());
+    std::vector<size_t> indices(costs_.size());
+    for (size_t i = 0; i < costs_.size(); ++i) {
+      current[i] = fresh(costs_[i], now) ? costs_[i].value : 0.0;
+      indices[i] = i;
+    }
+    // 0th index always goes first.
+    std::stable_sort(
+        indices.begin() + 1, indices.end(), [&current](size_t a, size_t b) {
+          return current[a] < current[b];
+        });
+    indices.resize(maxTries_);
+    return indices;
+  }
+};
 }
 }
 } // facebook::memcache::mcrouter
@@ -67,6 +67,23 @@ makeFailoverRouteLeastFailures(
       std::move(rh), std::forward<Args>(args)...);
 }
 
+template <
+    class RouterInfo,
+    template <class...> class RouteHandle,
+    class... Args>
+std::shared_ptr<typename RouterInfo::RouteHandleIf> makeFailoverRouteLoadAware(
+    std::vector<std::shared_ptr<typename RouterInfo::RouteHandleIf>> rh,
+    Args&&... args) {
+  if (rh.size() <= 1) {
+    return makeNullOrSingletonRoute(std::move(rh));
+  }
+
+  using FailoverPolicyT =
+      FailoverLoadAwarePolicy<typename RouterInfo::RouteHandleIf, RouterInfo>;
+  return makeRouteHandleWithInfo<RouterInfo, RouteHandle, FailoverPolicyT>(
+      std::move(rh), std::forward<Args>(args)...);
+}
+
 template <
     class RouterInfo,
     template <class...> class RouteHandle,
@@ -87,6 +104,7 @@ makeFailoverRouteWithPolicyAndFailoverError(
   std::unique_ptr<FailoverRateLimiter> rateLimiter;
   bool failoverTagging = false;
   bool enableLeasePairing = false;
+  bool spillover = false;
   std::string name;
   if (json.isObject()) {
     if (auto jLeasePairing = json.get_ptr("enable_lease_pairing")) {
@@ -110,6 +128,10 @@ makeFailoverRouteWithPolicyAndFailoverError(
     if (auto jFailoverLimit = json.get_ptr("failover_limit")) {
       rateLimiter = std::make_unique<FailoverRateLimiter>(*jFailoverLimit);
     }
+    if (auto jSpillover = json.get_ptr("spillover")) {
+      checkLogic(jSpillover->isBool(), "Failover: spillover is not bool");
+      spillover = jSpillover->getBool();
+    }
   }
 
   return makeRouteHandleWithInfo<
@@ -124,6 +146,7 @@ makeFailoverRouteWithPolicyAndFailoverError(
       enableLeasePairing,
       std::move(name),
       policyConfig,
+      spillover,
       std::forward<Args>(args)...);
 }
 
@@ -188,6 +211,21 @@ makeFailoverRouteWithFailoverErrorSettings(
           std::move(failoverErrors),
           std::forward<Args>(args)...);
     }
+    if (parseString(*jPolicyType, "type") == "LoadAwarePolicy") {
+      using FailoverPolicyT = FailoverLoadAwarePolicy<
+          typename RouterInfo::RouteHandleIf,
+          RouterInfo>;
+      return makeFailoverRouteWithPolicyAndFailoverError<
+          RouterInfo,
+          RouteHandle,
+          FailoverPolicyT,
+          FailoverErrorsSettingsT>(
+          json,
+          std::move(children),
+          *jFailoverPolicy,
+          std::move(failoverErrors),
+          std::forward<Args>(args)...);
+    }
   }
   using FailoverPolicyT =
       FailoverInOrderPolicy<typename RouterInfo::RouteHandleIf>;
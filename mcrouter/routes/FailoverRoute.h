@@ -55,6 +55,11 @@ inline std::string getFailoverRouteName(std::string name, size_t numTargets) {
  * Sends the same request sequentially to each destination in the list in order,
  * until the first non-error reply.  If all replies result in errors, returns
  * the last destination's reply.
+ *
+ * With spillover, destinations of all but the last child don't queue
+ * requests once their queue is full (see ProxyDestination::
+ * spilloverSaturated()): the request goes to the next child right away,
+ * whatever failover_errors and failover_limit say.
  */
 template <
     class RouterInfo,
@@ -90,14 +95,16 @@ class FailoverRoute {
       bool failoverTagging,
       bool enableLeasePairing,
       std::string name,
-      const folly::dynamic& policyConfig)
+      const folly::dynamic& policyConfig,
+      bool spillover = false)
       : name_(detail::getFailoverRouteName(std::move(name), targets.size())),
         targets_(std::move(targets)),
         failoverErrors_(std::move(failoverErrors)),
         rateLimiter_(std::move(rateLimiter)),
         failoverTagging_(failoverTagging),
         failoverPolicy_(targets_, policyConfig),
-        enableLeasePairing_(enableLeasePairing) {
+        enableLeasePairing_(enableLeasePairing),
+        spillover_(spillover) {
     assert(!targets_.empty());
     assert(!enableLeasePairing_ || !name_.empty());
   }
@@ -170,6 +177,7 @@ class FailoverRoute {
   const bool failoverTagging_{false};
   FailoverPolicyT failoverPolicy_;
   const bool enableLeasePairing_{false};
+  const bool spillover_{false};
 
   template <class Request>
   inline ReplyT<Request> doRoute(const Request& req) {
@@ -189,8 +197,13 @@ class FailoverRoute {
     };
 
     auto iter = failoverPolicy_.begin();
-    auto normalReply = iter->route(req);
+    auto normal = iter;
     ++iter;
+    const bool canSpill = spillover_ && iter != failoverPolicy_.end() &&
+        !fiber_local<RouterInfo>::getSharedCtx()->failoverDisabled();
+    bool spilled = false;
+    auto normalReply = routeMaySpill(
+        canSpill, spilled, [&normal, &req]() { return normal->route(req); });
     if (iter == failoverPolicy_.end()) {
       if (isErrorResult(normalReply.result())) {
         proxy.stats().increment(failover_all_failed_stat);
@@ -205,28 +218,36 @@ class FailoverRoute {
     if (fiber_local<RouterInfo>::getSharedCtx()->failoverDisabled()) {
       return normalReply;
     }
-    switch (shouldFailover(normalReply, req)) {
-      case FailoverErrorsSettingsBase::FailoverType::NONE:
-        return normalReply;
-      case FailoverErrorsSettingsBase::FailoverType::CONDITIONAL:
-        conditionalFailover = true;
-        break;
-      default:
-        break;
+    if (fiber_local<RouterInfo>::deadlineExceeded()) {
+      return normalReply;
     }
+    if (spilled) {
+      proxy.stats().increment(failover_spillover_stat);
+    } else {
+      switch (shouldFailover(normalReply, req)) {
+        case FailoverErrorsSettingsBase::FailoverType::NONE:
+          return normalReply;
+        case FailoverErrorsSettingsBase::FailoverType::CONDITIONAL:
+          conditionalFailover = true;
+          break;
+        default:
+          break;
+      }
 
-    proxy.stats().increment(failover_all_stat);
-    proxy.stats().increment(failoverPolicy_.getFailoverStat());
+      proxy.stats().increment(failover_all_stat);
+      proxy.stats().increment(failoverPolicy_.getFailoverStat());
 
-    if (rateLimiter_ && !rateLimiter_->failoverAllowed()) {
-      proxy.stats().increment(failover_rate_limited_stat);
-      return normalReply;
+      if (rateLimiter_ && !rateLimiter_->failoverAllowed()) {
+        proxy.stats().increment(failover_rate_limited_stat);
+        return normalReply;
+      }
     }
 
     // Failover
     return fiber_local<RouterInfo>::runWithLocals(
         [this,
          iter,
+         canSpill,
          &req,
          &proxy,
          &normalReply,
@@ -235,8 +256,13 @@ class FailoverRoute {
           fiber_local<RouterInfo>::setFailoverTag(failoverTagging_);
           fiber_local<RouterInfo>::addRequestClass(RequestClass::kFailover);
           auto doFailover = [this, &req, &proxy, &normalReply](
-              typename FailoverPolicyT::Iterator& child) {
-            auto failoverReply = child->route(req);
+              typename FailoverPolicyT::Iterator& child,
+              bool canSpillChild,
+              bool& spilledChild) {
+            auto failoverReply = routeMaySpill(
+                canSpillChild, spilledChild, [&child, &req]() {
+                  return child->route(req);
+                });
             FailoverContext failoverContext(
                 child.getTrueIndex(),
                 targets_.size() - 1,
@@ -253,8 +279,13 @@ class FailoverRoute {
             childIndex = cur.getTrueIndex();
           };
           auto nx = cur;
+          bool spilledChild = false;
           for (++nx; nx != failoverPolicy_.end(); ++cur, ++nx) {
-            auto failoverReply = doFailover(cur);
+            auto failoverReply = doFailover(cur, canSpill, spilledChild);
+            if (spilledChild) {
+              proxy.stats().increment(failover_spillover_stat);
+              continue;
+            }
             switch (shouldFailover(failoverReply, req)) {
               case FailoverErrorsSettingsBase::FailoverType::NONE:
                 return failoverReply;
@@ -264,9 +295,13 @@ class FailoverRoute {
               default:
                 break;
             }
+            // Nobody is waiting for the next reply anymore.
+            if (fiber_local<RouterInfo>::deadlineExceeded()) {
+              return failoverReply;
+            }
           }
 
-          auto failoverReply = doFailover(cur);
+          auto failoverReply = doFailover(cur, false, spilledChild);
           if (isErrorResult(failoverReply.result())) {
             proxy.stats().increment(failover_all_failed_stat);
             proxy.stats().increment(failoverPolicy_.getFailoverFailedStat());
@@ -276,6 +311,31 @@ class FailoverRoute {
         });
   }
 
+  /**
+   * Routes to a child with `route`. If spillover is enabled, the child may
+   * spill the request over iff canSpill, which is then reported in spilled.
+   */
+  template <class F>
+  typename std::result_of<F()>::type
+  routeMaySpill(bool canSpill, bool& spilled, F&& route) {
+    spilled = false;
+    if (!spillover_) {
+      return route();
+    }
+    return fiber_local<RouterInfo>::runWithLocals(
+        [canSpill, &spilled, &route]() {
+          fiber_local<RouterInfo>::setSpilloverAllowed(canSpill);
+          fiber_local<RouterInfo>::setSpilledOver(false);
+          auto reply = route();
+          // Another child of a route in between may have replied since.
+          spilled = fiber_local<RouterInfo>::getSpilledOver() &&
+              isErrorResult(reply.result());
+          // Handled here, not to be reported to the parents.
+          fiber_local<RouterInfo>::setSpilledOver(false);
+          return reply;
+        });
+  }
+
   template <class Request>
   FailoverErrorsSettingsBase::FailoverType shouldFailover(
       const ReplyT<Request>& reply,
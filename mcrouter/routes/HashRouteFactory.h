@@ -12,15 +12,19 @@
 #include "mcrouter/lib/Ch3HashFunc.h"
 #include "mcrouter/lib/Crc32HashFunc.h"
 #include "mcrouter/lib/HashSelector.h"
+#include "mcrouter/lib/JumpHashFunc.h"
+#include "mcrouter/lib/MaglevHashFunc.h"
 #include "mcrouter/lib/RendezvousHashFunc.h"
 #include "mcrouter/lib/SelectionRouteFactory.h"
 #include "mcrouter/lib/WeightedCh3HashFunc.h"
 #include "mcrouter/lib/config/RouteHandleFactory.h"
 #include "mcrouter/lib/routes/NullRoute.h"
 #include "mcrouter/lib/routes/SelectionRoute.h"
+#include "mcrouter/routes/BoundedLoadRoute.h"
 #include "mcrouter/routes/LatestRoute.h"
 #include "mcrouter/routes/LoadBalancerRoute.h"
 #include "mcrouter/routes/McRouteHandleBuilder.h"
+#include "mcrouter/routes/RuntimeWeightedCh3HashFunc.h"
 #include "mcrouter/routes/ShardHashFunc.h"
 
 namespace facebook {
@@ -42,11 +46,16 @@ typename RouterInfo::RouteHandlePtr createHashRoute(
       createHashSelector<HashFunc>(std::move(salt), std::move(func)));
 }
 
+/**
+ * @param rtVars  runtime variables of the router, needed for weights taken
+ *                from a runtime variable ("weights_rv").
+ */
 template <class RouterInfo>
 std::shared_ptr<typename RouterInfo::RouteHandleIf> createHashRoute(
     const folly::dynamic& json,
     std::vector<std::shared_ptr<typename RouterInfo::RouteHandleIf>> rh,
-    size_t threadId) {
+    size_t threadId,
+    ObservableRuntimeVars* rtVars = nullptr) {
   std::string salt;
   folly::StringPiece funcType = Ch3HashFunc::type();
   if (json.isObject()) {
@@ -75,9 +84,22 @@ std::shared_ptr<typename RouterInfo::RouteHandleIf> createHashRoute(
     return createHashRoute<RouterInfo, Crc32HashFunc>(
         std::move(rh), std::move(salt), Crc32HashFunc(n));
   } else if (funcType == WeightedCh3HashFunc::type()) {
+    if (json.get_ptr("weights_rv")) {
+      checkLogic(rtVars, "HashRoute: weights_rv is not supported here");
+      RuntimeWeightedCh3HashFunc func{json, n, *rtVars};
+      return createHashRoute<RouterInfo, RuntimeWeightedCh3HashFunc>(
+          std::move(rh), std::move(salt), std::move(func));
+    }
     WeightedCh3HashFunc func{json, n};
     return createHashRoute<RouterInfo, WeightedCh3HashFunc>(
         std::move(rh), std::move(salt), std::move(func));
+  } else if (funcType == MaglevHashFunc::type()) {
+    MaglevHashFunc func{json, n};
+    return createHashRoute<RouterInfo, MaglevHashFunc>(
+        std::move(rh), std::move(salt), std::move(func));
+  } else if (funcType == JumpHashFunc::type()) {
+    return createHashRoute<RouterInfo, JumpHashFunc>(
+        std::move(rh), std::move(salt), JumpHashFunc(n));
   } else if (funcType == ConstShardHashFunc::type()) {
     return createHashRoute<RouterInfo, ConstShardHashFunc>(
         std::move(rh), std::move(salt), ConstShardHashFunc(n));
@@ -104,6 +126,8 @@ std::shared_ptr<typename RouterInfo::RouteHandleIf> createHashRoute(
     return createLatestRoute<RouterInfo>(json, std::move(rh), threadId);
   } else if (funcType == "LoadBalancer") {
     return createLoadBalancerRoute<RouterInfo>(json, std::move(rh));
+  } else if (funcType == "BoundedLoadCh3") {
+    return createBoundedLoadRoute<RouterInfo>(json, std::move(rh));
   }
   throwLogic("Unknown hash function: {}", funcType);
 }
@@ -111,7 +135,8 @@ std::shared_ptr<typename RouterInfo::RouteHandleIf> createHashRoute(
 template <class RouterInfo>
 std::shared_ptr<typename RouterInfo::RouteHandleIf> makeHashRoute(
     RouteHandleFactory<typename RouterInfo::RouteHandleIf>& factory,
-    const folly::dynamic& json) {
+    const folly::dynamic& json,
+    ObservableRuntimeVars* rtVars = nullptr) {
   std::vector<std::shared_ptr<typename RouterInfo::RouteHandleIf>> children;
   if (json.isObject()) {
     if (auto jchildren = json.get_ptr("children")) {
@@ -121,7 +146,7 @@ std::shared_ptr<typename RouterInfo::RouteHandleIf> makeHashRoute(
     children = factory.createList(json);
   }
   return createHashRoute<RouterInfo>(
-      json, std::move(children), factory.getThreadId());
+      json, std::move(children), factory.getThreadId(), rtVars);
 }
 
 } // mcrouter
@@ -0,0 +1,267 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <folly/Optional.h>
+#include <folly/dynamic.h>
+#include <folly/fibers/Baton.h>
+#include <folly/fibers/FiberManager.h>
+
+#include "mcrouter/McrouterFiberContext.h"
+#include "mcrouter/ProxyBase.h"
+#include "mcrouter/ProxyRequestContext.h"
+#include "mcrouter/config.h"
+#include "mcrouter/lib/McResUtil.h"
+#include "mcrouter/lib/Reply.h"
+#include "mcrouter/lib/RouteHandleTraverser.h"
+#include "mcrouter/lib/carbon/RoutingGroups.h"
+#include "mcrouter/lib/config/RouteHandleBuilder.h"
+#include "mcrouter/lib/config/RouteHandleFactory.h"
+#include "mcrouter/lib/fbi/cpp/ParsingUtil.h"
+#include "mcrouter/lib/fbi/cpp/util.h"
+#include "mcrouter/lib/routes/NullRoute.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Tracks a quantile of the most recent latency samples.
+ */
+class LatencyQuantile {
+ public:
+  static constexpr size_t kWindow = 512;
+  // Recompute the quantile after this many new samples.
+  static constexpr size_t kUpdatePeriod = 64;
+
+  explicit LatencyQuantile(double quantile) : quantile_(quantile) {}
+
+  void add(int64_t latencyUs) {
+    samples_[next_++ % kWindow] = latencyUs;
+    if (next_ % kUpdatePeriod == 0) {
+      update();
+    }
+  }
+
+  /**
+   * @return  latency quantile in microseconds, or none if there aren't
+   *          enough samples yet.
+   */
+  folly::Optional<int64_t> value() const {
+    if (next_ < kWindow) {
+      return folly::none;
+    }
+    return value_;
+  }
+
+ private:
+  const double quantile_;
+  std::array<int64_t, kWindow> samples_;
+  size_t next_{0};
+  int64_t value_{0};
+
+  void update() {
+    size_t n = next_ < kWindow ? next_ : kWindow;
+    std::array<int64_t, kWindow> sorted;
+    std::copy(samples_.begin(), samples_.begin() + n, sorted.begin());
+    auto nth = sorted.begin() + static_cast<size_t>(quantile_ * (n - 1));
+    std::nth_element(sorted.begin(), nth, sorted.begin() + n);
+    value_ = *nth;
+  }
+};
+
+/**
+ * Sends get-like requests to the first child. If there's no reply after the
+ * tracked latency quantile of the first child (e.g. p95), sends a copy of the
+ * request to the next child, and so on. Returns the first non-error reply,
+ * or the last error reply if all of them failed. Late replies complete
+ * asynchronously.
+ *
+ * The number of hedged requests is capped at maxHedgePercent of all get-like
+ * requests. No hedging happens until enough latency samples are collected.
+ * All other requests only go to the first child.
+ */
+template <class RouterInfo>
+class HedgedRoute {
+ private:
+  using RouteHandleIf = typename RouterInfo::RouteHandleIf;
+
+ public:
+  static std::string routeName() {
+    return "hedged";
+  }
+
+  template <class Request>
+  void traverse(
+      const Request& req,
+      const RouteHandleTraverser<RouteHandleIf>& t) const {
+    t(children_, req);
+  }
+
+  HedgedRoute(
+      std::vector<std::shared_ptr<RouteHandleIf>> children,
+      double quantile,
+      double maxHedgePercent,
+      std::chrono::milliseconds minDelay)
+      : children_(std::move(children)),
+        latency_(std::make_shared<LatencyQuantile>(quantile)),
+        hedgeRate_(maxHedgePercent / 100),
+        minDelay_(minDelay) {
+    assert(children_.size() >= 2);
+  }
+
+  template <class Request>
+  ReplyT<Request> route(const Request& req, carbon::GetLikeT<Request> = 0) {
+    using Reply = ReplyT<Request>;
+
+    // Let bursts of up to kMaxHedgeBurst hedges through.
+    hedgeBudget_ = std::min(hedgeBudget_ + hedgeRate_, kMaxHedgeBurst);
+
+    auto delayUs = latency_->value();
+    auto state = std::make_shared<State<Reply>>();
+    auto reqCopy = std::make_shared<Request>(req);
+    sendTo(0, state, reqCopy);
+    if (!delayUs) {
+      state->baton.wait();
+      return std::move(*state->reply);
+    }
+
+    auto delay = std::max<std::chrono::milliseconds>(
+        minDelay_,
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::microseconds(*delayUs + 999)));
+    for (size_t i = 1; i < children_.size(); ++i) {
+      if (state->baton.try_wait_for(delay) || hedgeBudget_ < 1.0) {
+        break;
+      }
+      hedgeBudget_ -= 1.0;
+      if (auto& ctx = fiber_local<RouterInfo>::getSharedCtx()) {
+        ctx->proxy().stats().increment(hedged_reqs_stat);
+      }
+      sendTo(i, state, reqCopy);
+    }
+    state->baton.wait();
+    return std::move(*state->reply);
+  }
+
+  template <class Request>
+  ReplyT<Request> route(
+      const Request& req,
+      carbon::OtherThanT<Request, carbon::GetLike<>> = 0) {
+    return children_[0]->route(req);
+  }
+
+ private:
+  static constexpr double kMaxHedgeBurst = 10.0;
+
+  template <class Reply>
+  struct State {
+    folly::fibers::Baton baton;
+    folly::Optional<Reply> reply;
+    size_t outstanding{0};
+  };
+
+  const std::vector<std::shared_ptr<RouteHandleIf>> children_;
+  // Shared with the requests still in flight, which may complete after the
+  // route handle is gone.
+  const std::shared_ptr<LatencyQuantile> latency_;
+  const double hedgeRate_;
+  const std::chrono::milliseconds minDelay_;
+  double hedgeBudget_{0.0};
+
+  template <class Request, class Reply>
+  void sendTo(
+      size_t idx,
+      const std::shared_ptr<State<Reply>>& state,
+      const std::shared_ptr<Request>& req) {
+    ++state->outstanding;
+    auto rh = children_[idx];
+    // Only the first child's latency defines when to hedge.
+    auto latency = idx == 0 ? latency_ : nullptr;
+    folly::fibers::addTask([rh, latency, state, req]() {
+      const auto start = nowUs();
+      // Nothing waits for this fiber, so an exception has to become a
+      // reply, or the caller would wait forever.
+      Reply reply;
+      try {
+        reply = rh->route(*req);
+      } catch (const std::exception& e) {
+        reply = createReply<Request>(ErrorReply, e.what());
+      }
+      if (latency) {
+        latency->add(nowUs() - start);
+      }
+      --state->outstanding;
+      if (state->reply.hasValue()) {
+        return;
+      }
+      if (!isFailoverErrorResult(reply.result()) || state->outstanding == 0) {
+        state->reply = std::move(reply);
+        state->baton.post();
+      }
+    });
+  }
+};
+
+template <class RouterInfo>
+constexpr double HedgedRoute<RouterInfo>::kMaxHedgeBurst;
+
+template <class RouterInfo>
+typename RouterInfo::RouteHandlePtr makeHedgedRoute(
+    RouteHandleFactory<typename RouterInfo::RouteHandleIf>& factory,
+    const folly::dynamic& json) {
+  checkLogic(json.isObject(), "HedgedRoute: should be an object");
+  auto jchildren = json.get_ptr("children");
+  checkLogic(jchildren, "HedgedRoute: no children");
+  auto children = factory.createList(*jchildren);
+  if (children.empty()) {
+    return createNullRoute<typename RouterInfo::RouteHandleIf>();
+  }
+  if (children.size() == 1) {
+    return std::move(children[0]);
+  }
+
+  double quantile = 0.95;
+  if (auto jquantile = json.get_ptr("quantile")) {
+    checkLogic(
+        jquantile->isNumber(), "HedgedRoute: quantile is not a number");
+    quantile = jquantile->asDouble();
+    checkLogic(
+        quantile > 0 && quantile < 1,
+        "HedgedRoute: quantile should be between 0 and 1");
+  }
+  double maxHedgePercent = 5;
+  if (auto jpercent = json.get_ptr("max_hedge_percent")) {
+    checkLogic(
+        jpercent->isNumber(),
+        "HedgedRoute: max_hedge_percent is not a number");
+    maxHedgePercent = jpercent->asDouble();
+    checkLogic(
+        maxHedgePercent >= 0 && maxHedgePercent <= 100,
+        "HedgedRoute: max_hedge_percent should be between 0 and 100");
+  }
+  std::chrono::milliseconds minDelay(1);
+  if (auto jminDelay = json.get_ptr("min_delay_ms")) {
+    minDelay = parseTimeout(*jminDelay, "min_delay_ms");
+  }
+
+  return makeRouteHandleWithInfo<RouterInfo, HedgedRoute>(
+      std::move(children), quantile, maxHedgePercent, minDelay);
+}
+
+} // mcrouter
+} // memcache
+} // facebook
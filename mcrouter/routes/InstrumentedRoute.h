@@ -0,0 +1,77 @@
+/*
+ *  Copyright (c) 2016-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "mcrouter/RouteStats.h"
+#include "mcrouter/config.h"
+#include "mcrouter/lib/McResUtil.h"
+#include "mcrouter/lib/Reply.h"
+#include "mcrouter/lib/RouteHandleTraverser.h"
+#include "mcrouter/lib/config/RouteHandleBuilder.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Forwards requests to the target, and records the number of calls, errors
+ * and the latency of the target into RouteStats.
+ *
+ * Created for route handles configured with "instrument": true.
+ */
+template <class RouterInfo>
+class InstrumentedRoute {
+ private:
+  using RouteHandleIf = typename RouterInfo::RouteHandleIf;
+
+ public:
+  static std::string routeName() {
+    return "instrumented";
+  }
+
+  InstrumentedRoute(
+      std::shared_ptr<RouteHandleIf> target,
+      std::shared_ptr<RouteStats> stats)
+      : target_(std::move(target)), stats_(std::move(stats)) {}
+
+  template <class Request>
+  void traverse(
+      const Request& req,
+      const RouteHandleTraverser<RouteHandleIf>& t) const {
+    t(*target_, req);
+  }
+
+  template <class Request>
+  ReplyT<Request> route(const Request& req) {
+    const auto startUs = nowUs();
+    auto reply = target_->route(req);
+    const auto latencyUs = nowUs() - startUs;
+    stats_->record(
+        latencyUs > 0 ? latencyUs : 0, isErrorResult(reply.result()));
+    return reply;
+  }
+
+ private:
+  const std::shared_ptr<RouteHandleIf> target_;
+  const std::shared_ptr<RouteStats> stats_;
+};
+
+template <class RouterInfo>
+std::shared_ptr<typename RouterInfo::RouteHandleIf> makeInstrumentedRoute(
+    std::shared_ptr<typename RouterInfo::RouteHandleIf> target,
+    std::shared_ptr<RouteStats> stats) {
+  return makeRouteHandleWithInfo<RouterInfo, InstrumentedRoute>(
+      std::move(target), std::move(stats));
+}
+
+} // mcrouter
+} // memcache
+} // facebook
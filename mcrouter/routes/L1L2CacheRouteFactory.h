@@ -26,21 +26,27 @@ typename RouterInfo::RouteHandlePtr makeL1L2CacheRoute(
     typename RouterInfo::RouteHandlePtr l2,
     uint32_t upgradingL1Exptime,
     size_t ncacheExptime,
-    size_t ncacheUpdatePeriod) {
+    size_t ncacheUpdatePeriod,
+    RefillLimiter* refillLimiter) {
   return makeRouteHandle<typename RouterInfo::RouteHandleIf, L1L2CacheRoute>(
       std::move(l1),
       std::move(l2),
       upgradingL1Exptime,
       ncacheExptime,
-      ncacheUpdatePeriod);
+      ncacheUpdatePeriod,
+      refillLimiter);
 }
 
 } // detail
 
+/**
+ * @param refillLimiter  limits asynchronous L1 updates, may be nullptr.
+ */
 template <class RouterInfo>
 typename RouterInfo::RouteHandlePtr makeL1L2CacheRoute(
     RouteHandleFactory<typename RouterInfo::RouteHandleIf>& factory,
-    const folly::dynamic& json) {
+    const folly::dynamic& json,
+    RefillLimiter* refillLimiter = nullptr) {
   checkLogic(json.isObject(), "L1L2CacheRoute should be an object");
   checkLogic(json.count("l1"), "L1L2CacheRoute: no l1 route");
   checkLogic(json.count("l2"), "L1L2CacheRoute: no l2 route");
@@ -73,7 +79,8 @@ typename RouterInfo::RouteHandlePtr makeL1L2CacheRoute(
       factory.create(json["l2"]),
       upgradingL1Exptime,
       ncacheExptime,
-      ncacheUpdatePeriod);
+      ncacheUpdatePeriod,
+      refillLimiter);
 }
 } // mcrouter
 } // memcache
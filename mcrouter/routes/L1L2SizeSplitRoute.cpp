@@ -7,17 +7,21 @@
  */
 #include "L1L2SizeSplitRoute.h"
 
+#include <exception>
 #include <limits>
 #include <memory>
 #include <string>
 #include <utility>
 
 #include <folly/Range.h>
+#include <folly/Optional.h>
 #include <folly/dynamic.h>
+#include <folly/fibers/Baton.h>
 #include <folly/fibers/FiberManager.h>
 
 #include "mcrouter/lib/IOBufUtil.h"
 #include "mcrouter/lib/McResUtil.h"
+#include "mcrouter/lib/Reply.h"
 #include "mcrouter/lib/config/RouteHandleFactory.h"
 #include "mcrouter/lib/fbi/cpp/util.h"
 #include "mcrouter/lib/mc/msg.h"
@@ -35,8 +39,14 @@ McGetReply L1L2SizeSplitRoute::route(const McGetRequest& req) const {
     r.flags() |= MC_MSG_FLAG_SIZE_SPLIT;
     return r;
   }();
+  if (likelySplit(req)) {
+    return routeSpeculative(req, l1ReqWithFlag);
+  }
   auto reply = l1_->route(l1ReqWithFlag);
-  if (isHitResult(reply.result()) && (reply.flags() & MC_MSG_FLAG_SIZE_SPLIT)) {
+  const bool split =
+      isHitResult(reply.result()) && (reply.flags() & MC_MSG_FLAG_SIZE_SPLIT);
+  setSplitHint(req, split);
+  if (split) {
     // Real value lives in the L2 pool
     // Note that for both get and set, keys read from/written to L2 are not
     // suffixed with |==|<rand>.
@@ -46,8 +56,40 @@ McGetReply L1L2SizeSplitRoute::route(const McGetRequest& req) const {
   return reply;
 }
 
+McGetReply L1L2SizeSplitRoute::routeSpeculative(
+    const McGetRequest& req,
+    const McGetRequest& l1ReqWithFlag) const {
+  struct State {
+    folly::fibers::Baton baton;
+    folly::Optional<McGetReply> reply;
+  };
+  // The L2 get may outlive this call if L1 has the value itself.
+  auto state = std::make_shared<State>();
+  folly::fibers::addTask([l2 = l2_, state, req]() {
+    // The baton has to be posted even if L2 throws, the caller may be
+    // waiting on it.
+    try {
+      state->reply = l2->route(req);
+    } catch (const std::exception& e) {
+      state->reply = createReply<McGetRequest>(ErrorReply, e.what());
+    }
+    state->baton.post();
+  });
+
+  auto reply = l1_->route(l1ReqWithFlag);
+  const bool split =
+      isHitResult(reply.result()) && (reply.flags() & MC_MSG_FLAG_SIZE_SPLIT);
+  setSplitHint(req, split);
+  if (!split) {
+    return reply;
+  }
+  state->baton.wait();
+  return std::move(*state->reply);
+}
+
 McSetReply L1L2SizeSplitRoute::route(const McSetRequest& req) const {
   if (fullSetShouldGoToL1(req)) {
+    setSplitHint(req, false);
     return l1_->route(req);
   }
 
@@ -70,6 +112,7 @@ McSetReply L1L2SizeSplitRoute::route(const McSetRequest& req) const {
         return r;
       }();
       reply = l1_->route(l1Sentinel);
+      setSplitHint(req, isStoredResult(reply.result()));
     }
     return reply;
   }
@@ -247,16 +290,26 @@ std::shared_ptr<MemcacheRouteHandleIf> makeL1L2SizeSplitRoute(
     bothFullSet = json["both_full_set"].getBool();
   }
 
+  bool speculativeL2Get = false;
+  if (json.count("speculative_l2_get")) {
+    checkLogic(
+        json["speculative_l2_get"].isBool(),
+        "L1L2SizeSplitRoute: speculative_l2_get is not a boolean");
+    speculativeL2Get = json["speculative_l2_get"].getBool();
+  }
+
   return std::make_shared<MemcacheRouteHandle<L1L2SizeSplitRoute>>(
       factory.create(json["l1"]),
       factory.create(json["l2"]),
       threshold,
       ttlThreshold,
       failureTtl,
-      bothFullSet);
+      bothFullSet,
+      speculativeL2Get);
 }
 
 constexpr folly::StringPiece L1L2SizeSplitRoute::kHashAlias;
+constexpr size_t L1L2SizeSplitRoute::kNumSplitKeyHints;
 
 } // namespace mcrouter
 } // namespace memcache
@@ -11,6 +11,7 @@
 #include <random>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include <folly/Conv.h>
 #include <folly/Random.h>
@@ -49,6 +50,11 @@ constexpr size_t numDigitsBase10(uint64_t n) {
  *
  * Currently, only plain sets and gets are supported.
  *
+ * With speculativeL2Get, gets for keys that recently turned out to be split
+ * (as remembered in a small per-route bitmap indexed by the key hash) are
+ * sent to L2 in parallel with L1, saving a round trip if L1 returns a
+ * sentinel. The L2 reply is dropped if L1 returns the value itself.
+ *
  * There are potential consistency issues in both routes, no lease support, etc.
  */
 class L1L2SizeSplitRoute {
@@ -71,13 +77,15 @@ class L1L2SizeSplitRoute {
       size_t threshold,
       int32_t ttlThreshold,
       int32_t failureTtl,
-      bool bothFullSet)
+      bool bothFullSet,
+      bool speculativeL2Get = false)
       : l1_(std::move(l1)),
         l2_(std::move(l2)),
         threshold_(threshold),
         ttlThreshold_(ttlThreshold),
         failureTtl_(failureTtl),
-        bothFullSet_(bothFullSet) {
+        bothFullSet_(bothFullSet),
+        splitKeyHints_(speculativeL2Get ? kNumSplitKeyHints : 0) {
     assert(l1_ != nullptr);
     assert(l2_ != nullptr);
     folly::Random::seed(randomGenerator_);
@@ -100,6 +108,7 @@ class L1L2SizeSplitRoute {
   static constexpr size_t kMaxMcKeyLength = 255;
   static constexpr size_t kExtraKeySpaceNeeded = kHashAlias.size() +
       detail::numDigitsBase10(std::numeric_limits<uint64_t>::max());
+  static constexpr size_t kNumSplitKeyHints = 1 << 14;
 
   const std::shared_ptr<MemcacheRouteHandleIf> l1_;
   const std::shared_ptr<MemcacheRouteHandleIf> l2_;
@@ -108,6 +117,26 @@ class L1L2SizeSplitRoute {
   const int32_t failureTtl_{0};
   const bool bothFullSet_{false};
   mutable std::mt19937 randomGenerator_;
+  // Whether the last get or set of a key with this hash was split between
+  // L1 and L2. Empty unless speculative L2 gets are enabled.
+  mutable std::vector<bool> splitKeyHints_;
+
+  template <class Request>
+  bool likelySplit(const Request& req) const {
+    return !splitKeyHints_.empty() &&
+        splitKeyHints_[req.key().routingKeyHash() % kNumSplitKeyHints];
+  }
+
+  template <class Request>
+  void setSplitHint(const Request& req, bool split) const {
+    if (!splitKeyHints_.empty()) {
+      splitKeyHints_[req.key().routingKeyHash() % kNumSplitKeyHints] = split;
+    }
+  }
+
+  McGetReply routeSpeculative(
+      const McGetRequest& req,
+      const McGetRequest& l1ReqWithFlag) const;
 
   McLeaseGetReply doLeaseGetRoute(
       const McLeaseGetRequest& req,
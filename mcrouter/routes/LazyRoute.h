@@ -0,0 +1,86 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#include <folly/dynamic.h>
+#include <folly/fibers/FiberManager.h>
+
+#include "mcrouter/lib/Reply.h"
+#include "mcrouter/lib/RouteHandleTraverser.h"
+#include "mcrouter/lib/config/RouteHandleBuilder.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Builds the route described by json on the first request (or traversal)
+ * that goes through it, and forwards everything to it from then on.
+ *
+ * Only a fraction of routing prefixes gets traffic on any given host, so
+ * building the rest up front is a waste of startup time and memory.
+ * Must only be used from the thread of the proxy owning it; json and create
+ * must outlive the route.
+ */
+template <class RouterInfo>
+class LazyRoute {
+ private:
+  using RouteHandleIf = typename RouterInfo::RouteHandleIf;
+  using RouteHandlePtr = typename RouterInfo::RouteHandlePtr;
+
+ public:
+  using Create = std::function<RouteHandlePtr(const folly::dynamic&)>;
+
+  std::string routeName() const {
+    return target_ ? "lazy|materialized" : "lazy";
+  }
+
+  LazyRoute(const folly::dynamic& json, const Create& create)
+      : json_(json), create_(create) {}
+
+  template <class Request>
+  void traverse(
+      const Request& req,
+      const RouteHandleTraverser<RouteHandleIf>& t) const {
+    t(*target(), req);
+  }
+
+  template <class Request>
+  ReplyT<Request> route(const Request& req) const {
+    return target()->route(req);
+  }
+
+ private:
+  const folly::dynamic& json_;
+  const Create& create_;
+  mutable RouteHandlePtr target_;
+
+  const RouteHandlePtr& target() const {
+    if (!target_) {
+      // Building routes needs much more stack than fibers have.
+      target_ =
+          folly::fibers::runInMainContext([this]() { return create_(json_); });
+    }
+    return target_;
+  }
+};
+
+template <class RouterInfo>
+typename RouterInfo::RouteHandlePtr makeLazyRoute(
+    const folly::dynamic& json,
+    const typename LazyRoute<RouterInfo>::Create& create) {
+  return makeRouteHandleWithInfo<RouterInfo, LazyRoute>(json, create);
+}
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
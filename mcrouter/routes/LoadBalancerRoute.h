@@ -9,8 +9,11 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <fstream>
+#include <limits>
 #include <string>
+#include <tuple>
 #include <utility>
 
 #include <folly/Conv.h>
@@ -35,6 +38,11 @@ namespace mcrouter {
  * of the servers is used as 'weight' to the WeightedCh3Hash function to
  * determine the next destination server.
  *
+ * The PEAK_EWMA algorithm doesn't need server-reported loads: it picks the
+ * better of two random children by their peak-EWMA round trip time multiplied
+ * by the number of requests outstanding to them. Error replies count as at
+ * least ewma_error_penalty_ms.
+ *
  * @tparam RouteHandleInfo   The Router
  */
 template <class RouterInfo>
@@ -47,16 +55,27 @@ class LoadBalancerRoute {
   enum class AlgorithmType : std::uint8_t {
     WEIGHTED_HASHING = 1,
     TWO_RANDOM_CHOICES = 2,
+    PEAK_EWMA = 3,
   };
 
   static constexpr folly::StringPiece kWeightedHashing = "weighted-hashing";
   static constexpr folly::StringPiece kTwoRandomChoices = "two-random-choices";
+  static constexpr folly::StringPiece kPeakEwma = "peak-ewma";
 
   std::string routeName() const {
-    return folly::to<std::string>(
-        "loadbalancer|",
-        algorithm_ == AlgorithmType::WEIGHTED_HASHING ? kWeightedHashing
-                                                      : kTwoRandomChoices);
+    folly::StringPiece algorithm;
+    switch (algorithm_) {
+      case AlgorithmType::WEIGHTED_HASHING:
+        algorithm = kWeightedHashing;
+        break;
+      case AlgorithmType::TWO_RANDOM_CHOICES:
+        algorithm = kTwoRandomChoices;
+        break;
+      case AlgorithmType::PEAK_EWMA:
+        algorithm = kPeakEwma;
+        break;
+    }
+    return folly::to<std::string>("loadbalancer|", algorithm);
   }
 
   /**
@@ -73,7 +92,12 @@ class LoadBalancerRoute {
    *                                std::min(failoverCount, children.size())
    * @param algorithm               Load balancing algorithm to use.
    * @param seed                    seed for random number generator used in
-   *                                the two random choices algorithm.
+   *                                the two random choices and peak EWMA
+   *                                algorithms.
+   * @param ewmaDecayTime           time constant of the RTT moving average
+   *                                used in the peak EWMA algorithm.
+   * @param ewmaErrorPenalty        RTT recorded by the peak EWMA algorithm
+   *                                for an error reply that came back faster.
    */
   LoadBalancerRoute(
       std::vector<std::shared_ptr<RouteHandleIf>> children,
@@ -82,7 +106,9 @@ class LoadBalancerRoute {
       ServerLoad defaultServerLoad,
       size_t failoverCount,
       AlgorithmType algorithm = AlgorithmType::WEIGHTED_HASHING,
-      uint32_t seed = nowUs())
+      uint32_t seed = nowUs(),
+      std::chrono::microseconds ewmaDecayTime = std::chrono::seconds(1),
+      std::chrono::microseconds ewmaErrorPenalty = std::chrono::seconds(1))
       : children_(std::move(children)),
         salt_(std::move(salt)),
         loadTtl_(loadTtl),
@@ -92,7 +118,10 @@ class LoadBalancerRoute {
         loadComplements_(children_.size(), 1.0),
         expTimes_(children_.size(), std::chrono::microseconds(0)),
         gen_(seed),
-        algorithm_(algorithm) {
+        algorithm_(algorithm),
+        ewmaDecayTimeUs_(std::max<double>(ewmaDecayTime.count(), 1)),
+        ewmaErrorPenaltyUs_(ewmaErrorPenalty.count()),
+        rtts_(algorithm_ == AlgorithmType::PEAK_EWMA ? children_.size() : 0) {
     assert(children_.size() >= 2);
   }
 
@@ -109,6 +138,9 @@ class LoadBalancerRoute {
     if (algorithm_ == AlgorithmType::TWO_RANDOM_CHOICES) {
       return routeTwoRandomChoices(req);
     }
+    if (algorithm_ == AlgorithmType::PEAK_EWMA) {
+      return routePeakEwma(req);
+    }
     // first try
     size_t idx = selectWeightedHashing(req, loadComplements_, salt_);
     auto reply = doRoute(req, idx);
@@ -168,6 +200,22 @@ class LoadBalancerRoute {
   // Load balancing algorithm
   AlgorithmType algorithm_;
 
+  // Round trip time tracking for the PeakEwma algorithm.
+  struct RttState {
+    // Peak-EWMA of the round trip time, in microseconds.
+    double ewmaUs{0.0};
+    // Time of the last update of ewmaUs.
+    int64_t lastUpdateUs{0};
+    // Number of requests sent and not replied yet.
+    size_t outstanding{0};
+  };
+  // Time constant of the moving average, in microseconds.
+  const double ewmaDecayTimeUs_;
+  // RTT recorded at least for an error reply, in microseconds.
+  const int64_t ewmaErrorPenaltyUs_;
+  // One entry per child, only used by the PeakEwma algorithm.
+  std::vector<RttState> rtts_;
+
   // route the request and update server load.
   template <class Request>
   ReplyT<Request>
@@ -230,6 +278,65 @@ class LoadBalancerRoute {
     return rep;
   }
 
+  template <class Request>
+  ReplyT<Request> routePeakEwma(const Request& req) {
+    auto idxs = selectRandomPair();
+    auto now = nowUs();
+    size_t idx = peakEwmaCost(idxs.first, now) <= peakEwmaCost(idxs.second, now)
+        ? idxs.first
+        : idxs.second;
+
+    auto& state = rtts_[idx];
+    ++state.outstanding;
+    auto reply = children_[idx]->route(req);
+    --state.outstanding;
+
+    // A child failing fast (e.g. TKO or connection refused) would otherwise
+    // look like the fastest one and attract traffic. Errors are recorded
+    // with at least the penalty RTT instead, which steers traffic away from
+    // a slow or broken child until the penalty decays.
+    auto end = nowUs();
+    auto rttUs = end - now;
+    if (isErrorResult(reply.result())) {
+      rttUs = std::max(rttUs, ewmaErrorPenaltyUs_);
+    }
+    observeRtt(state, rttUs, end);
+    return reply;
+  }
+
+  /**
+   * Expected cost of sending one more request to a child: its RTT estimate
+   * (decayed up to now) times the number of requests it's working on.
+   */
+  double peakEwmaCost(size_t idx, int64_t now) const {
+    const auto& state = rtts_[idx];
+    double ewma = decayedRtt(state, now);
+    if (ewma == 0.0 && state.outstanding > 0) {
+      // No RTT measured yet, but there are requests in flight: don't pile
+      // everything up on this child until we know how fast it is.
+      return std::numeric_limits<double>::max();
+    }
+    return ewma * (state.outstanding + 1);
+  }
+
+  double decayedRtt(const RttState& state, int64_t now) const {
+    auto elapsed = std::max<int64_t>(now - state.lastUpdateUs, 0);
+    return state.ewmaUs * std::exp(-elapsed / ewmaDecayTimeUs_);
+  }
+
+  void observeRtt(RttState& state, int64_t rttUs, int64_t now) {
+    double rtt = std::max<int64_t>(rttUs, 0);
+    auto elapsed = std::max<int64_t>(now - state.lastUpdateUs, 0);
+    auto w = std::exp(-elapsed / ewmaDecayTimeUs_);
+    state.lastUpdateUs = now;
+    if (rtt > state.ewmaUs) {
+      // Peak sensitive: jump up to a worse RTT right away.
+      state.ewmaUs = rtt;
+    } else {
+      state.ewmaUs = state.ewmaUs * w + rtt * (1.0 - w);
+    }
+  }
+
   template <class Request>
   size_t selectWeightedHashingInternal(
       const Request& req,
@@ -261,6 +368,20 @@ class LoadBalancerRoute {
    *
    */
   std::pair<size_t, size_t> selectTwoRandomChoices() {
+    size_t x;
+    size_t y;
+    std::tie(x, y) = selectRandomPair();
+
+    if (loadComplements_[x] > loadComplements_[y]) {
+      return std::make_pair<size_t, size_t>(x, y);
+    }
+    return std::make_pair<size_t, size_t>(y, x);
+  }
+
+  /**
+   * @return  two distinct random child idxs.
+   */
+  std::pair<size_t, size_t> selectRandomPair() {
     uint32_t x = 0;
     uint32_t y = 1;
     if (children_.size() > 2) {
@@ -270,11 +391,7 @@ class LoadBalancerRoute {
         y = children_.size() - 1;
       }
     }
-
-    if (loadComplements_[x] > loadComplements_[y]) {
-      return std::make_pair<size_t, size_t>(x, y);
-    }
-    return std::make_pair<size_t, size_t>(y, x);
+    return std::make_pair<size_t, size_t>(x, y);
   }
 
   template <class Request>
@@ -293,6 +410,8 @@ template <class RouterInfo>
 constexpr folly::StringPiece LoadBalancerRoute<RouterInfo>::kWeightedHashing;
 template <class RouterInfo>
 constexpr folly::StringPiece LoadBalancerRoute<RouterInfo>::kTwoRandomChoices;
+template <class RouterInfo>
+constexpr folly::StringPiece LoadBalancerRoute<RouterInfo>::kPeakEwma;
 
 template <class RouterInfo>
 struct LoadBalancerRouteOptions {
@@ -302,6 +421,8 @@ struct LoadBalancerRouteOptions {
   size_t failoverCount{1};
   typename LoadBalancerRoute<RouterInfo>::AlgorithmType algorithm{
       LoadBalancerRoute<RouterInfo>::AlgorithmType::WEIGHTED_HASHING};
+  std::chrono::microseconds ewmaDecayTime{1000 * 1000}; // 1 second
+  std::chrono::microseconds ewmaErrorPenalty{1000 * 1000}; // 1 second
 };
 
 template <class RouterInfo>
@@ -351,11 +472,33 @@ LoadBalancerRouteOptions<RouterInfo> parseLoadBalancerRouteJson(
         algorithmStr == LoadBalancerRoute<RouterInfo>::kTwoRandomChoices) {
       options.algorithm =
           LoadBalancerRoute<RouterInfo>::AlgorithmType::TWO_RANDOM_CHOICES;
+    } else if (algorithmStr == LoadBalancerRoute<RouterInfo>::kPeakEwma) {
+      options.algorithm =
+          LoadBalancerRoute<RouterInfo>::AlgorithmType::PEAK_EWMA;
     } else {
       throwLogic("Unknown algorithm: {}", algorithmStr);
     }
   }
 
+  if (auto jDecayTime = json.get_ptr("ewma_decay_time_ms")) {
+    checkLogic(
+        jDecayTime->isInt() && jDecayTime->getInt() > 0,
+        "LoadBalancerRoute: ewma_decay_time_ms is not a positive integer");
+    options.ewmaDecayTime =
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::milliseconds(jDecayTime->getInt()));
+  }
+
+  if (auto jErrorPenalty = json.get_ptr("ewma_error_penalty_ms")) {
+    checkLogic(
+        jErrorPenalty->isInt() && jErrorPenalty->getInt() >= 0,
+        "LoadBalancerRoute: ewma_error_penalty_ms is not a non-negative "
+        "integer");
+    options.ewmaErrorPenalty =
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::milliseconds(jErrorPenalty->getInt()));
+  }
+
   return options;
 }
 
@@ -376,7 +519,10 @@ typename RouterInfo::RouteHandlePtr createLoadBalancerRoute(
       options.loadTtl,
       options.defaultServerLoad,
       options.failoverCount,
-      options.algorithm);
+      options.algorithm,
+      nowUs(),
+      options.ewmaDecayTime,
+      options.ewmaErrorPenalty);
 }
 
 template <class RouterInfo>
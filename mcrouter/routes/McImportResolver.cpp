@@ -14,16 +14,80 @@ namespace facebook {
 namespace memcache {
 namespace mcrouter {
 
+constexpr size_t McImportResolver::kMaxPrefetchThreads;
+
 McImportResolver::McImportResolver(ConfigApiIf& configApi)
     : configApi_(configApi) {}
 
+McImportResolver::~McImportResolver() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    prefetchQueue_.clear();
+  }
+  for (auto& thread : prefetchThreads_) {
+    thread.join();
+  }
+}
+
 std::string McImportResolver::import(folly::StringPiece path) {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto it = prefetched_.find(path.str());
+    if (it != prefetched_.end()) {
+      // References to elements stay valid when other paths are added.
+      auto& prefetched = it->second;
+      prefetchedCv_.wait(lock, [&prefetched]() { return prefetched.done; });
+      if (prefetched.loaded) {
+        return prefetched.contents;
+      }
+    }
+  }
+
   std::string ret;
   if (!configApi_.get(ConfigType::ConfigImport, path.str(), ret)) {
     throw std::runtime_error("Can not read " + path.str());
   }
   return ret;
 }
+
+void McImportResolver::prefetch(const std::vector<std::string>& paths) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto& path : paths) {
+    if (prefetched_.emplace(path, Prefetched()).second) {
+      prefetchQueue_.push_back(path);
+    }
+  }
+  while (numRunningThreads_ < kMaxPrefetchThreads &&
+         numRunningThreads_ < prefetchQueue_.size()) {
+    ++numRunningThreads_;
+    prefetchThreads_.emplace_back([this]() { runPrefetchThread(); });
+  }
+}
+
+void McImportResolver::runPrefetchThread() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!prefetchQueue_.empty()) {
+    auto path = std::move(prefetchQueue_.front());
+    prefetchQueue_.pop_front();
+    lock.unlock();
+
+    std::string contents;
+    bool loaded = false;
+    try {
+      loaded = configApi_.get(ConfigType::ConfigImport, path, contents);
+    } catch (...) {
+      // import() will retry and report the error.
+    }
+
+    lock.lock();
+    auto& prefetched = prefetched_[path];
+    prefetched.done = true;
+    prefetched.loaded = loaded;
+    prefetched.contents = std::move(contents);
+    prefetchedCv_.notify_all();
+  }
+  --numRunningThreads_;
+}
 }
 }
 } // facebook::memcache::mcrouter
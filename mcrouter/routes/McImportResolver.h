@@ -7,7 +7,13 @@
  */
 #pragma once
 
+#include <condition_variable>
+#include <deque>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 #include <folly/Range.h>
 
@@ -26,14 +32,39 @@ class ConfigApiIf;
 class McImportResolver : public ImportResolverIf {
  public:
   explicit McImportResolver(ConfigApiIf& configApi);
+  ~McImportResolver() override;
 
   /**
    * @throws std::runtime_error if can not load file
    */
   std::string import(folly::StringPiece path) override;
 
+  /**
+   * Loads the files on up to kMaxPrefetchThreads threads of its own, so
+   * that a config with many imports doesn't read (or fetch) them one by one.
+   * configApi.get() must be thread-safe.
+   */
+  void prefetch(const std::vector<std::string>& paths) override;
+
  private:
+  static constexpr size_t kMaxPrefetchThreads = 16;
+
+  struct Prefetched {
+    bool done{false};
+    bool loaded{false};
+    std::string contents;
+  };
+
   ConfigApiIf& configApi_;
+
+  std::mutex mutex_;
+  std::condition_variable prefetchedCv_;
+  std::unordered_map<std::string, Prefetched> prefetched_;
+  std::deque<std::string> prefetchQueue_;
+  std::vector<std::thread> prefetchThreads_;
+  size_t numRunningThreads_{0};
+
+  void runPrefetchThread();
 };
 }
 }
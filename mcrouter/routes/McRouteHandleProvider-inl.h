@@ -8,6 +8,7 @@
 #include <memory>
 
 #include <folly/Conv.h>
+#include <folly/MapUtil.h>
 #include <folly/Range.h>
 
 #include "mcrouter/CarbonRouterInstanceBase.h"
@@ -27,6 +28,7 @@
 #include "mcrouter/routes/ExtraRouteHandleProviderIf.h"
 #include "mcrouter/routes/FailoverRoute.h"
 #include "mcrouter/routes/HashRouteFactory.h"
+#include "mcrouter/routes/InstrumentedRoute.h"
 #include "mcrouter/routes/PoolRouteUtils.h"
 #include "mcrouter/routes/RateLimitRoute.h"
 #include "mcrouter/routes/RateLimiter.h"
@@ -129,6 +131,10 @@ McRouteHandleProvider<RouterInfo>::makePool(
       timeout = parseTimeout(*jTimeout, "server_timeout");
     }
 
+    // Pools without region/cluster are treated as within cluster, but don't
+    // get within_cluster_timeout_ms.
+    enum class Locality { kWithinCluster, kCrossCluster, kCrossRegion };
+    auto locality = Locality::kWithinCluster;
     if (!region.empty() && !cluster.empty()) {
       auto& route = opts.default_route;
       if (region == route.getRegion() && cluster == route.getCluster()) {
@@ -136,10 +142,12 @@ McRouteHandleProvider<RouterInfo>::makePool(
           timeout = std::chrono::milliseconds(opts.within_cluster_timeout_ms);
         }
       } else if (region == route.getRegion()) {
+        locality = Locality::kCrossCluster;
         if (opts.cross_cluster_timeout_ms != 0) {
           timeout = std::chrono::milliseconds(opts.cross_cluster_timeout_ms);
         }
       } else {
+        locality = Locality::kCrossRegion;
         if (opts.cross_region_timeout_ms != 0) {
           timeout = std::chrono::milliseconds(opts.cross_region_timeout_ms);
         }
@@ -155,12 +163,23 @@ McRouteHandleProvider<RouterInfo>::makePool(
         protocol = mc_caret_protocol;
       } else if (equalStr("umbrella", str, folly::AsciiCaseInsensitive())) {
         protocol = mc_umbrella_protocol_DONOTUSE;
+      } else if (equalStr("meta", str, folly::AsciiCaseInsensitive())) {
+        protocol = mc_meta_protocol;
+      } else if (equalStr("binary", str, folly::AsciiCaseInsensitive())) {
+        protocol = mc_binary_protocol;
       } else {
         throwLogic("Unknown protocol '{}'", str);
       }
     }
 
-    bool enableCompression = proxy_.router().opts().enable_compression;
+    bool enableCompression = opts.enable_compression;
+    if (opts.compression_scope == "cross_cluster") {
+      enableCompression &= locality != Locality::kWithinCluster;
+    } else if (opts.compression_scope == "cross_region") {
+      enableCompression &= locality == Locality::kCrossRegion;
+    } else if (opts.compression_scope != "all") {
+      throwLogic("Unknown compression_scope: '{}'", opts.compression_scope);
+    }
     if (auto jCompression = json.get_ptr("enable_compression")) {
       enableCompression = parseBool(*jCompression, "enable_compression");
     }
@@ -182,6 +201,42 @@ McRouteHandleProvider<RouterInfo>::makePool(
       }
     }
 
+    size_t numConnections = 1;
+    if (auto jNumConnections = json.get_ptr("num_connections")) {
+      numConnections = parseInt(*jNumConnections, "num_connections", 1, 1024);
+    }
+
+    ErrorRateTkoSettings errorRateTko;
+    if (auto jErrorRateTko = json.get_ptr("error_rate_tko")) {
+      checkLogic(
+          jErrorRateTko->isObject(), "error_rate_tko must be an object");
+      auto jThreshold = jErrorRateTko->get_ptr("threshold");
+      checkLogic(
+          jThreshold && jThreshold->isNumber(),
+          "error_rate_tko.threshold is not a number");
+      errorRateTko.threshold = jThreshold->asDouble();
+      checkLogic(
+          errorRateTko.threshold > 0 && errorRateTko.threshold <= 1,
+          "error_rate_tko.threshold should be in (0, 1]");
+      if (auto jMinRequests = jErrorRateTko->get_ptr("min_requests")) {
+        errorRateTko.minRequests = parseInt(
+            *jMinRequests, "error_rate_tko.min_requests", 1, 1000000);
+      }
+      if (auto jWindow = jErrorRateTko->get_ptr("window_ms")) {
+        errorRateTko.window =
+            parseTimeout(*jWindow, "error_rate_tko.window_ms");
+      }
+      if (auto jRatio = jErrorRateTko->get_ptr("half_open_ratio")) {
+        checkLogic(
+            jRatio->isNumber(),
+            "error_rate_tko.half_open_ratio is not a number");
+        errorRateTko.halfOpenRatio = jRatio->asDouble();
+        checkLogic(
+            errorRateTko.halfOpenRatio >= 0 && errorRateTko.halfOpenRatio <= 1,
+            "error_rate_tko.half_open_ratio should be in [0, 1]");
+      }
+    }
+
     bool useSsl = false;
     if (auto jUseSsl = json.get_ptr("use_ssl")) {
       useSsl = parseBool(*jUseSsl, "use_ssl");
@@ -237,21 +292,42 @@ McRouteHandleProvider<RouterInfo>::makePool(
           ap->disableCompression();
         }
       }
+      // Proxies and pools share one copy of each AccessPoint, which also
+      // keys ProxyDestinationMap.
+      auto internedAp = AccessPoint::intern(*ap);
 
       auto it = accessPoints_.find(name);
       if (it == accessPoints_.end()) {
         std::vector<std::shared_ptr<const AccessPoint>> accessPoints;
         it = accessPoints_.emplace(name, std::move(accessPoints)).first;
       }
-      it->second.push_back(ap);
-      folly::StringPiece nameSp = it->first;
+      it->second.push_back(internedAp);
+      auto& poolName = poolNames_[name];
+      if (!poolName) {
+        poolName = std::make_shared<const std::string>(name);
+      }
+      folly::StringPiece nameSp = *poolName;
 
-      auto pdstn = proxy_.destinationMap()->find(*ap, timeout);
+      auto pdstn = proxy_.destinationMap()->find(*internedAp, timeout);
       if (!pdstn) {
         pdstn = proxy_.destinationMap()->emplace(
-            std::move(ap), timeout, qosClass, qosPath, RouterInfo::name);
+            std::move(internedAp),
+            timeout,
+            qosClass,
+            qosPath,
+            RouterInfo::name,
+            numConnections);
+      }
+      if (seenDestinations_.insert(pdstn.get()).second) {
+        destinations_.push_back(pdstn);
       }
       pdstn->updateShortestTimeout(timeout);
+      pdstn->updateNumConnections(numConnections);
+      pdstn->updateErrorRateTko(errorRateTko);
+      if (opts.latency_tko_interval_ms > 0) {
+        proxy_.router().tkoTrackerMap().addToLatencyPool(name, *pdstn);
+      }
+      poolProxyDestinations_[name].push_back(pdstn);
 
       destinations.push_back(makeDestinationRoute<RouterInfo>(
           std::move(pdstn),
@@ -286,6 +362,15 @@ McRouteHandleProvider<RouterInfo>::makePoolRoute(
   }
 
   auto poolJson = poolFactory_.parsePool(*jpool);
+  const bool reusable = proxy_.router().opts().reuse_unchanged_routes;
+  folly::dynamic reuseKey = nullptr;
+  if (reusable) {
+    reuseKey = folly::dynamic::array(json, poolJson.name, poolJson.json);
+    if (auto route = reusePoolRoute(reuseKey, poolJson.name)) {
+      return route;
+    }
+  }
+  const auto numCreateCalls = factory.numCreateCalls();
   auto destinations = makePool(factory, poolJson);
 
   try {
@@ -303,6 +388,11 @@ McRouteHandleProvider<RouterInfo>::makePoolRoute(
       jhashWithWeights = folly::dynamic::object(
           "hash_func", WeightedCh3HashFunc::type())("weights", *jWeights);
     }
+    // Weights that can change without a reconfiguration.
+    if (auto jWeightsRv = poolJson.json.get_ptr("weights_rv")) {
+      jhashWithWeights["hash_func"] = WeightedCh3HashFunc::type();
+      jhashWithWeights["weights_rv"] = *jWeightsRv;
+    }
 
     if (auto jTags = poolJson.json.get_ptr("tags")) {
       jhashWithWeights["tags"] = *jTags;
@@ -323,17 +413,23 @@ McRouteHandleProvider<RouterInfo>::makePoolRoute(
       }
     }
     auto route = createHashRoute<RouterInfo>(
-        jhashWithWeights, std::move(destinations), factory.getThreadId());
+        jhashWithWeights,
+        std::move(destinations),
+        factory.getThreadId(),
+        &proxy_.router().rtVarsData());
 
     auto asynclogName = poolJson.name;
     bool needAsynclog = true;
     if (json.isObject()) {
       if (auto jrates = json.get_ptr("rates")) {
-        route = createRateLimitRoute(std::move(route), RateLimiter(*jrates));
+        route = createRateLimitRoute(
+            std::move(route),
+            RateLimiter(*jrates, &proxy_.router().sharedTokenBuckets()));
       }
       if (auto jsplits = json.get_ptr("shard_splits")) {
         route = makeShardSplitRoute<RouterInfo>(
-            std::move(route), ShardSplitter(*jsplits));
+            std::move(route),
+            ShardSplitter(*jsplits, proxy_.router().functionScheduler()));
       }
       if (auto jasynclog = json.get_ptr("asynclog")) {
         needAsynclog = parseBool(*jasynclog, "asynclog");
@@ -346,12 +442,84 @@ McRouteHandleProvider<RouterInfo>::makePoolRoute(
       route = createAsynclogRoute(std::move(route), asynclogName.str());
     }
 
+    // Routes built from other routes depend on more than this json.
+    if (reusable && factory.numCreateCalls() == numCreateCalls) {
+      savePoolRoute(
+          std::move(reuseKey),
+          poolJson.name,
+          route,
+          needAsynclog ? asynclogName.str() : std::string());
+    }
     return route;
   } catch (const std::exception& e) {
     throwLogic("PoolRoute {}: {}", poolJson.name, e.what());
   }
 }
 
+template <class RouterInfo>
+std::shared_ptr<typename RouterInfo::RouteHandleIf>
+McRouteHandleProvider<RouterInfo>::reusePoolRoute(
+    const folly::dynamic& key,
+    folly::StringPiece poolName) {
+  // Identical PoolRoutes in one config get separate state, as they would
+  // have if they were built.
+  if (!previousPoolRoutes_ || poolRoutes_.count(key)) {
+    return nullptr;
+  }
+  auto it = previousPoolRoutes_->find(key);
+  if (it == previousPoolRoutes_->end()) {
+    return nullptr;
+  }
+  const auto& entry = it->second;
+
+  if (pools_.find(poolName) == pools_.end()) {
+    pools_.emplace(poolName, entry.poolDestinations);
+    if (!entry.accessPoints.empty()) {
+      accessPoints_.emplace(poolName, entry.accessPoints);
+    }
+    if (entry.poolName) {
+      poolNames_.emplace(poolName, entry.poolName);
+    }
+    poolProxyDestinations_.emplace(poolName, entry.proxyDestinations);
+    for (const auto& weakDestination : entry.proxyDestinations) {
+      auto pdstn = weakDestination.lock();
+      if (pdstn && seenDestinations_.insert(pdstn.get()).second) {
+        destinations_.push_back(pdstn);
+      }
+    }
+  }
+  if (!entry.asynclogName.empty()) {
+    asyncLogRoutes_.emplace(entry.asynclogName, entry.route);
+  }
+
+  ++numReusedPoolRoutes_;
+  return poolRoutes_.emplace(key, entry).first->second.route;
+}
+
+template <class RouterInfo>
+void McRouteHandleProvider<RouterInfo>::savePoolRoute(
+    folly::dynamic key,
+    folly::StringPiece poolName,
+    RouteHandlePtr route,
+    std::string asynclogName) {
+  ReusablePoolRoute<RouteHandleIf> entry;
+  if (auto name = folly::get_ptr(poolNames_, poolName)) {
+    entry.poolName = *name;
+  }
+  entry.route = std::move(route);
+  if (auto destinations = folly::get_ptr(pools_, poolName)) {
+    entry.poolDestinations = *destinations;
+  }
+  if (auto accessPoints = folly::get_ptr(accessPoints_, poolName)) {
+    entry.accessPoints = *accessPoints;
+  }
+  if (auto pdstns = folly::get_ptr(poolProxyDestinations_, poolName)) {
+    entry.proxyDestinations = *pdstns;
+  }
+  entry.asynclogName = std::move(asynclogName);
+  poolRoutes_.emplace(std::move(key), std::move(entry));
+}
+
 template <class RouterInfo>
 typename McRouteHandleProvider<RouterInfo>::RouteHandleFactoryMap
 McRouteHandleProvider<RouterInfo>::buildRouteMap() {
@@ -389,12 +557,65 @@ template <>
 typename McRouteHandleProvider<MemcacheRouterInfo>::RouteHandleFactoryMap
 McRouteHandleProvider<MemcacheRouterInfo>::buildRouteMap();
 
+template <class RouterInfo>
+std::vector<std::shared_ptr<typename RouterInfo::RouteHandleIf>>
+McRouteHandleProvider<RouterInfo>::makeInstrumented(
+    std::vector<RouteHandlePtr> routes,
+    const folly::dynamic& json) {
+  for (size_t i = 0; i < routes.size(); ++i) {
+    std::string name;
+    if (auto jName = json.get_ptr("name")) {
+      checkLogic(jName->isString(), "name is not a string");
+      name = jName->getString();
+    } else {
+      name = routes[i]->routeName();
+    }
+    if (routes.size() > 1) {
+      name = folly::to<std::string>(name, ".", i);
+    }
+    routes[i] = makeInstrumentedRoute<RouterInfo>(
+        std::move(routes[i]), proxy_.routeStats().get(name));
+  }
+  return routes;
+}
+
+template <class RouterInfo>
+bool McRouteHandleProvider<RouterInfo>::isSingleShot(
+    folly::StringPiece type,
+    const folly::dynamic& json) {
+  if (type == "PoolRoute") {
+    // Pool options that add failover, shadows or key-based fan-out.
+    return !json.isObject() ||
+        (!json.get_ptr("shadows") && !json.get_ptr("slow_warmup") &&
+         !json.get_ptr("shard_splits"));
+  }
+  return type == "Pool" || type == "HashRoute" || type == "HostIdRoute" ||
+      type == "RandomRoute" || type == "LoadBalancerRoute" ||
+      type == "ModifyKeyRoute" || type == "ModifyExptimeRoute" ||
+      type == "OperationSelectorRoute" || type == "NullRoute" ||
+      type == "ErrorRoute" || type == "DevNullRoute";
+}
+
 template <class RouterInfo>
 std::vector<std::shared_ptr<typename RouterInfo::RouteHandleIf>>
 McRouteHandleProvider<RouterInfo>::create(
     RouteHandleFactory<RouteHandleIf>& factory,
     folly::StringPiece type,
     const folly::dynamic& json) {
+  if (singleShotOnly_ && !isSingleShot(type, json)) {
+    singleShotOnly_ = false;
+  }
+
+  if (json.isObject()) {
+    if (auto jInstrument = json.get_ptr("instrument")) {
+      if (parseBool(*jInstrument, "instrument")) {
+        auto targetJson = json;
+        targetJson.erase("instrument");
+        return makeInstrumented(create(factory, type, targetJson), json);
+      }
+    }
+  }
+
   if (type == "Pool") {
     return makePool(factory, poolFactory_.parsePool(json));
   } else if (type == "ShadowRoute") {
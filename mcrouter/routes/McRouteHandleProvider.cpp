@@ -7,6 +7,7 @@
  */
 #include "McRouteHandleProvider.h"
 
+#include "mcrouter/lib/RefillLimiter.h"
 #include "mcrouter/lib/network/gen/MemcacheRouterInfo.h"
 #include "mcrouter/lib/routes/NullRoute.h"
 #include "mcrouter/routes/AllAsyncRouteFactory.h"
@@ -19,6 +20,7 @@
 #include "mcrouter/routes/FailoverRoute.h"
 #include "mcrouter/routes/FailoverWithExptimeRouteFactory.h"
 #include "mcrouter/routes/HashRouteFactory.h"
+#include "mcrouter/routes/HedgedRoute.h"
 #include "mcrouter/routes/HostIdRouteFactory.h"
 #include "mcrouter/routes/L1L2CacheRouteFactory.h"
 #include "mcrouter/routes/L1L2SizeSplitRoute.h"
@@ -30,9 +32,13 @@
 #include "mcrouter/routes/MissFailoverRoute.h"
 #include "mcrouter/routes/ModifyExptimeRoute.h"
 #include "mcrouter/routes/ModifyKeyRoute.h"
+#include "mcrouter/routes/NearCacheRoute.h"
+#include "mcrouter/routes/NegativeCacheRoute.h"
 #include "mcrouter/routes/OperationSelectorRoute.h"
 #include "mcrouter/routes/OutstandingLimitRoute.h"
 #include "mcrouter/routes/RandomRouteFactory.h"
+#include "mcrouter/routes/RefreshAheadRoute.h"
+#include "mcrouter/routes/ReplicationRoute.h"
 #include "mcrouter/routes/ShadowRoute.h"
 
 namespace facebook {
@@ -43,7 +49,8 @@ using McRouteHandleFactory = RouteHandleFactory<McrouterRouteHandleIf>;
 
 McrouterRouteHandlePtr makeWarmUpRoute(
     McRouteHandleFactory& factory,
-    const folly::dynamic& json);
+    const folly::dynamic& json,
+    RefillLimiter* refillLimiter);
 
 template <>
 std::unique_ptr<ExtraRouteHandleProviderIf<MemcacheRouterInfo>>
@@ -65,11 +72,17 @@ McRouteHandleProvider<MemcacheRouterInfo>::buildRouteMap() {
       {"FailoverWithExptimeRoute",
        &makeFailoverWithExptimeRoute<MemcacheRouterInfo>},
       {"HashRoute",
-       [](McRouteHandleFactory& factory, const folly::dynamic& json) {
-         return makeHashRoute<McrouterRouterInfo>(factory, json);
+       [this](McRouteHandleFactory& factory, const folly::dynamic& json) {
+         return makeHashRoute<McrouterRouterInfo>(
+             factory, json, &proxy_.router().rtVarsData());
        }},
+      {"HedgedRoute", &makeHedgedRoute<MemcacheRouterInfo>},
       {"HostIdRoute", &makeHostIdRoute<MemcacheRouterInfo>},
-      {"L1L2CacheRoute", &makeL1L2CacheRoute<MemcacheRouterInfo>},
+      {"L1L2CacheRoute",
+       [this](McRouteHandleFactory& factory, const folly::dynamic& json) {
+         return makeL1L2CacheRoute<MemcacheRouterInfo>(
+             factory, json, &proxy_.refillLimiter());
+       }},
       {"L1L2SizeSplitRoute", &makeL1L2SizeSplitRoute},
       {"LatestRoute", &makeLatestRoute<MemcacheRouterInfo>},
       {"LoadBalancerRoute", &makeLoadBalancerRoute<MemcacheRouterInfo>},
@@ -78,6 +91,8 @@ McRouteHandleProvider<MemcacheRouterInfo>::buildRouteMap() {
       {"MissFailoverRoute", &makeMissFailoverRoute<MemcacheRouterInfo>},
       {"ModifyKeyRoute", &makeModifyKeyRoute<MemcacheRouterInfo>},
       {"ModifyExptimeRoute", &makeModifyExptimeRoute<MemcacheRouterInfo>},
+      {"NearCacheRoute", &makeNearCacheRoute<MemcacheRouterInfo>},
+      {"NegativeCacheRoute", &makeNegativeCacheRoute<MemcacheRouterInfo>},
       {"NullRoute", &makeNullRoute<MemcacheRouteHandleIf>},
       {"OperationSelectorRoute",
        &makeOperationSelectorRoute<MemcacheRouterInfo>},
@@ -88,10 +103,16 @@ McRouteHandleProvider<MemcacheRouterInfo>::buildRouteMap() {
       {"PrefixPolicyRoute", &makeOperationSelectorRoute<MemcacheRouterInfo>},
       {"RandomRoute", &makeRandomRoute<MemcacheRouterInfo>},
       {"RateLimitRoute",
-       [](McRouteHandleFactory& factory, const folly::dynamic& json) {
-         return makeRateLimitRoute(factory, json);
+       [this](McRouteHandleFactory& factory, const folly::dynamic& json) {
+         return makeRateLimitRoute(
+             factory, json, &proxy_.router().sharedTokenBuckets());
+       }},
+      {"RefreshAheadRoute", &makeRefreshAheadRoute<MemcacheRouterInfo>},
+      {"ReplicationRoute", &makeReplicationRoute<MemcacheRouterInfo>},
+      {"WarmUpRoute",
+       [this](McRouteHandleFactory& factory, const folly::dynamic& json) {
+         return makeWarmUpRoute(factory, json, &proxy_.refillLimiter());
        }},
-      {"WarmUpRoute", &makeWarmUpRoute},
   };
   return map;
 }
@@ -11,6 +11,7 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include <folly/Range.h>
@@ -18,10 +19,7 @@
 #include "mcrouter/PoolFactory.h"
 #include "mcrouter/lib/config/RouteHandleProviderIf.h"
 #include "mcrouter/routes/McrouterRouteHandle.h"
-
-namespace folly {
-struct dynamic;
-} // folly
+#include "mcrouter/routes/ReusablePoolRoute.h"
 
 namespace facebook {
 namespace memcache {
@@ -30,6 +28,7 @@ namespace mcrouter {
 template <class RouteHandleIf>
 class ExtraRouteHandleProviderIf;
 class ProxyBase;
+class ProxyDestination;
 
 /**
  * RouteHandleProviderIf implementation that can create mcrouter-specific
@@ -70,6 +69,71 @@ class McRouteHandleProvider
     return std::move(accessPoints_);
   }
 
+  std::vector<std::weak_ptr<ProxyDestination>> releaseDestinations() {
+    seenDestinations_.clear();
+    return std::move(destinations_);
+  }
+
+  /**
+   * Names of the pools, referenced by their destination routes.
+   */
+  folly::StringKeyedUnorderedMap<std::shared_ptr<const std::string>>
+  releasePoolNames() {
+    return std::move(poolNames_);
+  }
+
+  /**
+   * Lets PoolRoutes built from the same json as in the previous config be
+   * carried over instead of being built again. PoolRoutes whose building
+   * depends on other routes (e.g. slow_warmup failover targets) are always
+   * rebuilt. `previous` must outlive the provider.
+   */
+  void setPreviousPoolRoutes(
+      const ReusablePoolRouteMap<RouteHandleIf>* previous) {
+    previousPoolRoutes_ = previous;
+  }
+
+  ReusablePoolRouteMap<RouteHandleIf> releasePoolRoutes() {
+    return std::move(poolRoutes_);
+  }
+
+  size_t numReusedPoolRoutes() const {
+    return numReusedPoolRoutes_;
+  }
+
+  /**
+   * @return true if every route created so far is single-shot: it sends
+   *         each request to at most one child, at most once, without
+   *         spawning fibers (e.g. pools, hashing, key modification; not
+   *         failover, shadowing or fan-out).
+   */
+  bool singleShotOnly() const {
+    return singleShotOnly_;
+  }
+
+  /**
+   * Everything created so far, for providers that keep creating routes
+   * after the config was built (see LazyRoute).
+   */
+  const folly::StringKeyedUnorderedMap<RouteHandlePtr>& asyncLogRoutes() const {
+    return asyncLogRoutes_;
+  }
+
+  const folly::StringKeyedUnorderedMap<std::vector<RouteHandlePtr>>& pools()
+      const {
+    return pools_;
+  }
+
+  const folly::StringKeyedUnorderedMap<
+      std::vector<std::shared_ptr<const AccessPoint>>>&
+  accessPoints() const {
+    return accessPoints_;
+  }
+
+  const std::vector<std::weak_ptr<ProxyDestination>>& destinations() const {
+    return destinations_;
+  }
+
   ~McRouteHandleProvider() override;
 
  private:
@@ -88,6 +152,23 @@ class McRouteHandleProvider
       std::vector<std::shared_ptr<const AccessPoint>>>
       accessPoints_;
 
+  // poolName -> name referenced by the pool's destination routes
+  folly::StringKeyedUnorderedMap<std::shared_ptr<const std::string>>
+      poolNames_;
+
+  // poolName -> ProxyDestinations of the pool
+  folly::StringKeyedUnorderedMap<std::vector<std::weak_ptr<ProxyDestination>>>
+      poolProxyDestinations_;
+
+  // All destinations used by the pools, without duplicates.
+  std::vector<std::weak_ptr<ProxyDestination>> destinations_;
+  std::unordered_set<const ProxyDestination*> seenDestinations_;
+
+  const ReusablePoolRouteMap<RouteHandleIf>* previousPoolRoutes_{nullptr};
+  ReusablePoolRouteMap<RouteHandleIf> poolRoutes_;
+  size_t numReusedPoolRoutes_{0};
+  bool singleShotOnly_{true};
+
   const RouteHandleFactoryMap routeMap_;
 
   const std::vector<RouteHandlePtr>& makePool(
@@ -98,10 +179,34 @@ class McRouteHandleProvider
       RouteHandleFactory<RouteHandleIf>& factory,
       const folly::dynamic& json);
 
+  /**
+   * @return the PoolRoute built for `key` in the previous config, after
+   *         registering its pool into this config; nullptr if there's none.
+   */
+  RouteHandlePtr reusePoolRoute(
+      const folly::dynamic& key,
+      folly::StringPiece poolName);
+
+  void savePoolRoute(
+      folly::dynamic key,
+      folly::StringPiece poolName,
+      RouteHandlePtr route,
+      std::string asynclogName);
+
+  /**
+   * Wraps routes created from `json` with InstrumentedRoutes, named after
+   * json["name"] or, if not set, the route name.
+   */
+  std::vector<RouteHandlePtr> makeInstrumented(
+      std::vector<RouteHandlePtr> routes,
+      const folly::dynamic& json);
+
   RouteHandlePtr createAsynclogRoute(
       RouteHandlePtr route,
       std::string asynclogName);
 
+  static bool isSingleShot(folly::StringPiece type, const folly::dynamic& json);
+
   RouteHandleFactoryMap buildRouteMap();
 
   // This can be removed when the buildRouteMap specialization for
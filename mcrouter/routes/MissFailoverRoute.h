@@ -68,6 +68,9 @@ class MissFailoverRoute {
         [ this, &req, bestReply = std::move(reply) ]() mutable {
           fiber_local<RouterInfo>::addRequestClass(RequestClass::kFailover);
           for (size_t i = 1; i < targets_.size(); ++i) {
+            if (fiber_local<RouterInfo>::deadlineExceeded()) {
+              break;
+            }
             auto failoverReply = targets_[i]->route(req);
             if (isHitResult(failoverReply.result())) {
               return failoverReply;
@@ -7,6 +7,7 @@
  */
 #pragma once
 
+#include <array>
 #include <cctype>
 #include <memory>
 #include <string>
@@ -16,6 +17,8 @@
 #include <folly/Optional.h>
 #include <folly/dynamic.h>
 
+#include "mcrouter/McrouterFiberContext.h"
+#include "mcrouter/ProxyRequestContextTyped.h"
 #include "mcrouter/RoutingPrefix.h"
 #include "mcrouter/lib/McKey.h"
 #include "mcrouter/lib/Operation.h"
@@ -51,8 +54,11 @@ namespace mcrouter {
  * "foo" => "/a/b/foo"
  * "/b/c/o" => "/a/b/fooo"
  */
-template <class RouteHandleIf>
+template <class RouterInfo>
 class ModifyKeyRoute {
+ private:
+  using RouteHandleIf = typename RouterInfo::RouteHandleIf;
+
  public:
   static std::string routeName() {
     return "modify-key";
@@ -84,11 +90,20 @@ class ModifyKeyRoute {
 
   template <class Request>
   ReplyT<Request> route(const Request& req) const {
-    const auto key = getModifiedKey(req.key());
-    if (key) {
-      return routeReqWithKey(req, key.value());
+    const auto parts = getModifiedKeyParts(req.key());
+    if (!parts) {
+      return target_->route(req);
+    }
+    // The new key is only needed while routing, so it's built in the arena
+    // of the request rather than on the heap.
+    if (auto& ctx = fiber_local<RouterInfo>::getSharedCtx()) {
+      const auto key =
+          ctx->arena().concat({(*parts)[0], (*parts)[1], (*parts)[2]});
+      if (key) {
+        return routeReqWithKey(req, *key);
+      }
     }
-    return target_->route(req);
+    return routeReqWithKey(req, join(*parts));
   }
 
  private:
@@ -98,9 +113,25 @@ class ModifyKeyRoute {
   const bool modifyInplace_;
   const folly::Optional<std::string> keyReplace_;
 
+  // The modified key is the concatenation of these.
+  using KeyParts = std::array<folly::StringPiece, 3>;
+
+  static std::string join(const KeyParts& parts) {
+    return folly::to<std::string>(parts[0], parts[1], parts[2]);
+  }
+
   template <class StringLike>
   folly::Optional<std::string> getModifiedKey(
       const carbon::Keys<StringLike>& reqKey) const {
+    if (auto parts = getModifiedKeyParts(reqKey)) {
+      return join(*parts);
+    }
+    return folly::none;
+  }
+
+  template <class StringLike>
+  folly::Optional<KeyParts> getModifiedKeyParts(
+      const carbon::Keys<StringLike>& reqKey) const {
     folly::StringPiece rp = routingPrefix_.hasValue() ? routingPrefix_.value()
                                                       : reqKey.routingPrefix();
 
@@ -108,15 +139,15 @@ class ModifyKeyRoute {
         reqKey.keyWithoutRoute().startsWith(keyReplace_.value())) {
       auto keyWithoutRoute = reqKey.keyWithoutRoute();
       keyWithoutRoute.advance(keyReplace_.value().size());
-      return folly::to<std::string>(rp, keyPrefix_, keyWithoutRoute);
+      return KeyParts{{rp, keyPrefix_, keyWithoutRoute}};
     } else if (!reqKey.keyWithoutRoute().startsWith(keyPrefix_)) {
       auto keyWithoutRoute = reqKey.keyWithoutRoute();
       if (modifyInplace_ && keyWithoutRoute.size() >= keyPrefix_.size()) {
         keyWithoutRoute.advance(keyPrefix_.size());
       }
-      return folly::to<std::string>(rp, keyPrefix_, keyWithoutRoute);
+      return KeyParts{{rp, keyPrefix_, keyWithoutRoute}};
     } else if (routingPrefix_.hasValue() && rp != reqKey.routingPrefix()) {
-      return folly::to<std::string>(rp, reqKey.keyWithoutRoute());
+      return KeyParts{{rp, reqKey.keyWithoutRoute(), folly::StringPiece()}};
     }
     return folly::none;
   }
@@ -126,15 +157,15 @@ class ModifyKeyRoute {
       const {
     constexpr bool kIsMemcacheRequest =
         ListContains<McRequestList, Request>::value;
-    const auto err = isKeyValid<kIsMemcacheRequest>(key);
+    auto cloneReq = req;
+    cloneReq.key() = key;
+    const auto err = isKeyValid<kIsMemcacheRequest>(cloneReq.key());
     if (err != mc_req_err_valid) {
       return createReply<Request>(
           ErrorReply,
           "ModifyKeyRoute: invalid key: " +
               std::string(mc_req_err_to_string(err)));
     }
-    auto cloneReq = req;
-    cloneReq.key() = key;
     return target_->route(cloneReq);
   }
 };
@@ -191,7 +222,7 @@ typename RouterInfo::RouteHandlePtr makeModifyKeyRoute(
         joverwrite->isBool(), "ModifyKeyRoute: modify_inplace is not a bool");
     modifyInplace = joverwrite->asBool();
   }
-  return makeRouteHandle<typename RouterInfo::RouteHandleIf, ModifyKeyRoute>(
+  return makeRouteHandleWithInfo<RouterInfo, ModifyKeyRoute>(
       factory.create(*jtarget),
       std::move(routingPrefix),
       std::move(keyPrefix),
@@ -0,0 +1,80 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include "NearCache.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "mcrouter/lib/McResUtil.h"
+#include "mcrouter/lib/carbon/RequestReplyUtil.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+constexpr uint32_t NearCache::kMaxAdmissionThreshold;
+
+NearCache::NearCache(Options opts)
+    : opts_(std::move(opts)),
+      sketch_(
+          opts_.capacity * 8,
+          kMaxAdmissionThreshold,
+          opts_.capacity * 80 /* resetPeriod */),
+      cache_(std::max<size_t>(opts_.capacity, 1)) {}
+
+const McGetReply* NearCache::find(folly::StringPiece key, int64_t nowMs) {
+  auto it = cache_.find(key.str());
+  if (it == cache_.end()) {
+    return nullptr;
+  }
+  if (it->second.expiresAtMs <= nowMs) {
+    cache_.erase(it);
+    return nullptr;
+  }
+  return &it->second.reply;
+}
+
+bool NearCache::recordMiss(folly::StringPiece key) {
+  return sketch_.increment(key) >= opts_.admissionThreshold;
+}
+
+bool NearCache::insert(
+    folly::StringPiece key,
+    const McGetReply& reply,
+    int64_t nowMs) {
+  if (!isHitResult(reply.result())) {
+    return false;
+  }
+  auto value = carbon::valuePtrUnsafe(reply);
+  auto valueSize = value ? value->computeChainDataLength() : 0;
+  if (valueSize > opts_.maxValueSize) {
+    return false;
+  }
+
+  Entry entry{reply, nowMs + opts_.ttl.count()};
+  // Own a compact copy of the value instead of pinning the (possibly much
+  // larger) network buffer it points into.
+  if (value) {
+    folly::IOBuf copy(folly::IOBuf::CREATE, valueSize);
+    for (auto range : *value) {
+      std::memcpy(copy.writableTail(), range.data(), range.size());
+      copy.append(range.size());
+    }
+    entry.reply.value() = std::move(copy);
+  }
+  cache_.set(key.str(), std::move(entry));
+  return true;
+}
+
+void NearCache::erase(folly::StringPiece key) {
+  cache_.erase(key.str());
+}
+
+} // mcrouter
+} // memcache
+} // facebook
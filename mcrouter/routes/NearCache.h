@@ -0,0 +1,84 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include <folly/Range.h>
+#include <folly/container/EvictingCacheMap.h>
+
+#include "mcrouter/lib/CountMinSketch.h"
+#include "mcrouter/lib/network/gen/Memcache.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Small LRU cache of get replies with a per-entry TTL. A key is admitted
+ * only once the sketch considers it hot.
+ * Not thread-safe: meant to be owned by a single proxy.
+ */
+class NearCache {
+ public:
+  struct Options {
+    size_t capacity{1000};
+    std::chrono::milliseconds ttl{100};
+    size_t maxValueSize{4096};
+    uint32_t admissionThreshold{4};
+  };
+
+  /**
+   * Maximum admissionThreshold: counts above it aren't tracked.
+   */
+  static constexpr uint32_t kMaxAdmissionThreshold = 15;
+
+  explicit NearCache(Options opts);
+
+  /**
+   * @return  cached reply for key, or nullptr if there's no such entry or
+   *          it has expired.
+   */
+  const McGetReply* find(folly::StringPiece key, int64_t nowMs);
+
+  /**
+   * Records a miss for key.
+   *
+   * @return  true iff a reply for key should be inserted into the cache.
+   */
+  bool recordMiss(folly::StringPiece key);
+
+  /**
+   * Caches a copy of reply, if it's a hit small enough to be cached.
+   *
+   * @return  true iff reply was inserted.
+   */
+  bool insert(folly::StringPiece key, const McGetReply& reply, int64_t nowMs);
+
+  void erase(folly::StringPiece key);
+
+  size_t size() const {
+    return cache_.size();
+  }
+
+ private:
+  struct Entry {
+    McGetReply reply;
+    int64_t expiresAtMs;
+  };
+
+  const Options opts_;
+  CountMinSketch sketch_;
+  folly::EvictingCacheMap<std::string, Entry> cache_;
+};
+
+} // mcrouter
+} // memcache
+} // facebook
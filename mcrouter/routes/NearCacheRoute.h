@@ -0,0 +1,138 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include <folly/dynamic.h>
+
+#include "mcrouter/McrouterFiberContext.h"
+#include "mcrouter/ProxyBase.h"
+#include "mcrouter/ProxyRequestContext.h"
+#include "mcrouter/config.h"
+#include "mcrouter/lib/RouteHandleTraverser.h"
+#include "mcrouter/lib/carbon/RoutingGroups.h"
+#include "mcrouter/lib/config/RouteHandleBuilder.h"
+#include "mcrouter/lib/config/RouteHandleFactory.h"
+#include "mcrouter/lib/fbi/cpp/ParsingUtil.h"
+#include "mcrouter/lib/fbi/cpp/util.h"
+#include "mcrouter/lib/network/gen/Memcache.h"
+#include "mcrouter/routes/NearCache.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Serves gets for hot keys from a small in-process cache.
+ *
+ * Each get miss is counted in a count-min sketch; once a key's count reaches
+ * the admission threshold, its next hit reply from the child is cached for
+ * a short TTL. Any non-get request passing through this route invalidates
+ * the key. Writes that don't go through this route (or through another
+ * proxy) are only picked up after the TTL expires.
+ */
+template <class RouterInfo>
+class NearCacheRoute {
+ private:
+  using RouteHandleIf = typename RouterInfo::RouteHandleIf;
+
+ public:
+  static std::string routeName() {
+    return "near-cache";
+  }
+
+  template <class Request>
+  void traverse(
+      const Request& req,
+      const RouteHandleTraverser<RouteHandleIf>& t) const {
+    t(*target_, req);
+  }
+
+  NearCacheRoute(std::shared_ptr<RouteHandleIf> target, NearCache::Options opts)
+      : target_(std::move(target)), cache_(std::move(opts)) {}
+
+  McGetReply route(const McGetRequest& req) {
+    const auto key = req.key().fullKey();
+    const auto now = nowUs() / 1000;
+    auto& stats = fiber_local<RouterInfo>::getSharedCtx()->proxy().stats();
+    if (auto cached = cache_.find(key, now)) {
+      stats.increment(near_cache_hits_stat);
+      return *cached;
+    }
+
+    if (!cache_.recordMiss(key)) {
+      return target_->route(req);
+    }
+
+    // Don't cache the reply if the key may have been modified while the
+    // request was in flight.
+    const auto invalidations = invalidations_;
+    auto reply = target_->route(req);
+    if (invalidations == invalidations_ && cache_.insert(key, reply, now)) {
+      stats.increment(near_cache_admissions_stat);
+    }
+    return reply;
+  }
+
+  template <class Request>
+  ReplyT<Request> route(const Request& req, carbon::GetLikeT<Request> = 0) {
+    return target_->route(req);
+  }
+
+  template <class Request>
+  ReplyT<Request> route(
+      const Request& req,
+      carbon::OtherThanT<Request, carbon::GetLike<>> = 0) {
+    cache_.erase(req.key().fullKey());
+    ++invalidations_;
+    return target_->route(req);
+  }
+
+ private:
+  const std::shared_ptr<RouteHandleIf> target_;
+  NearCache cache_;
+  uint64_t invalidations_{0};
+};
+
+template <class RouterInfo>
+typename RouterInfo::RouteHandlePtr makeNearCacheRoute(
+    RouteHandleFactory<typename RouterInfo::RouteHandleIf>& factory,
+    const folly::dynamic& json) {
+  checkLogic(json.isObject(), "NearCacheRoute: should be an object");
+  auto jtarget = json.get_ptr("target");
+  checkLogic(jtarget, "NearCacheRoute: no target");
+  auto target = factory.create(*jtarget);
+
+  NearCache::Options opts;
+  if (auto jcapacity = json.get_ptr("capacity")) {
+    opts.capacity = parseInt(*jcapacity, "capacity", 1, 10000000);
+  }
+  if (auto jttl = json.get_ptr("ttl_ms")) {
+    opts.ttl = parseTimeout(*jttl, "ttl_ms");
+  }
+  if (auto jmaxValueSize = json.get_ptr("max_value_size")) {
+    opts.maxValueSize =
+        parseInt(*jmaxValueSize, "max_value_size", 0, 1024 * 1024);
+  }
+  if (auto jthreshold = json.get_ptr("admission_threshold")) {
+    opts.admissionThreshold = parseInt(
+        *jthreshold,
+        "admission_threshold",
+        1,
+        NearCache::kMaxAdmissionThreshold);
+  }
+
+  return makeRouteHandleWithInfo<RouterInfo, NearCacheRoute>(
+      std::move(target), std::move(opts));
+}
+
+} // mcrouter
+} // memcache
+} // facebook
@@ -0,0 +1,107 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include "NegativeCache.h"
+
+#include <algorithm>
+
+#include <folly/Bits.h>
+#include <folly/hash/Hash.h>
+#include <folly/hash/SpookyHashV2.h>
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+constexpr size_t NegativeCache::kSlotsPerBucket;
+
+namespace {
+
+size_t numBuckets(size_t capacity) {
+  return folly::nextPowTwo(
+      std::max<size_t>(2, (capacity + NegativeCache::kSlotsPerBucket - 1) /
+                             NegativeCache::kSlotsPerBucket));
+}
+
+} // anonymous namespace
+
+NegativeCache::NegativeCache(Options opts)
+    : ttlMs_(static_cast<uint32_t>(opts.ttl.count())),
+      bucketMask_(numBuckets(opts.capacity) - 1),
+      slots_((bucketMask_ + 1) * kSlotsPerBucket) {}
+
+NegativeCache::Location NegativeCache::locate(folly::StringPiece key) const {
+  const auto hash =
+      folly::hash::SpookyHashV2::Hash64(key.data(), key.size(), 0);
+  Location loc;
+  loc.fingerprint = static_cast<uint32_t>(hash >> 32);
+  if (loc.fingerprint == 0) {
+    loc.fingerprint = 1;
+  }
+  loc.bucket1 = hash & bucketMask_;
+  // Partial-key cuckoo hashing: the alternative bucket only depends on the
+  // bucket and the fingerprint.
+  loc.bucket2 = (loc.bucket1 ^ folly::hash::twang_mix64(loc.fingerprint)) &
+      bucketMask_;
+  return loc;
+}
+
+bool NegativeCache::contains(folly::StringPiece key, int64_t nowMs) const {
+  const auto loc = locate(key);
+  for (auto idx : {loc.bucket1, loc.bucket2}) {
+    const auto* b = bucket(idx);
+    for (size_t i = 0; i < kSlotsPerBucket; ++i) {
+      if (b[i].fingerprint == loc.fingerprint) {
+        return !expired(b[i], nowMs);
+      }
+    }
+  }
+  return false;
+}
+
+void NegativeCache::insert(folly::StringPiece key, int64_t nowMs) {
+  const auto loc = locate(key);
+  const uint32_t expiresAtMs = static_cast<uint32_t>(nowMs) + ttlMs_;
+
+  // Refresh the existing entry, otherwise take a free or expired slot, or
+  // else the one that would expire first.
+  Slot* victim = nullptr;
+  for (auto idx : {loc.bucket1, loc.bucket2}) {
+    auto* b = bucket(idx);
+    for (size_t i = 0; i < kSlotsPerBucket; ++i) {
+      if (b[i].fingerprint == loc.fingerprint) {
+        b[i].expiresAtMs = expiresAtMs;
+        return;
+      }
+      if (!victim ||
+          (!isFree(*victim, nowMs) &&
+           (isFree(b[i], nowMs) ||
+            static_cast<int32_t>(b[i].expiresAtMs - victim->expiresAtMs) <
+                0))) {
+        victim = &b[i];
+      }
+    }
+  }
+  victim->fingerprint = loc.fingerprint;
+  victim->expiresAtMs = expiresAtMs;
+}
+
+void NegativeCache::erase(folly::StringPiece key) {
+  const auto loc = locate(key);
+  for (auto idx : {loc.bucket1, loc.bucket2}) {
+    auto* b = bucket(idx);
+    for (size_t i = 0; i < kSlotsPerBucket; ++i) {
+      if (b[i].fingerprint == loc.fingerprint) {
+        b[i] = Slot();
+      }
+    }
+  }
+}
+
+} // mcrouter
+} // memcache
+} // facebook
@@ -0,0 +1,104 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <folly/Range.h>
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Remembers keys that recently missed, for a short TTL.
+ *
+ * Keys are not stored: like in a cuckoo filter, every key has a 32 bit
+ * fingerprint that can live in one of two buckets of kSlotsPerBucket slots,
+ * 8 bytes per slot including the expiration time. When both buckets are
+ * full, the entry closest to expiring is replaced.
+ * Unlike a bloom filter, entries can be erased, and false positives (another
+ * key with the same fingerprint in one of the buckets) are about
+ * 2 * kSlotsPerBucket / 2^32.
+ *
+ * Not thread-safe: meant to be owned by a single proxy.
+ */
+class NegativeCache {
+ public:
+  struct Options {
+    size_t capacity{10000};
+    std::chrono::milliseconds ttl{1000};
+  };
+
+  static constexpr size_t kSlotsPerBucket = 4;
+
+  explicit NegativeCache(Options opts);
+
+  /**
+   * @return  true iff key was inserted less than ttl ago and not erased
+   *          since (or a key with the same fingerprint was).
+   */
+  bool contains(folly::StringPiece key, int64_t nowMs) const;
+
+  /**
+   * Remembers a miss for key until nowMs + ttl.
+   */
+  void insert(folly::StringPiece key, int64_t nowMs);
+
+  void erase(folly::StringPiece key);
+
+  /**
+   * @return  number of entries that may be stored.
+   */
+  size_t capacity() const {
+    return slots_.size();
+  }
+
+ private:
+  struct Slot {
+    // 0 means the slot is empty.
+    uint32_t fingerprint{0};
+    // Truncated to 32 bits, compared with wrap-around.
+    uint32_t expiresAtMs{0};
+  };
+
+  struct Location {
+    size_t bucket1;
+    size_t bucket2;
+    uint32_t fingerprint;
+  };
+
+  const uint32_t ttlMs_;
+  const size_t bucketMask_;
+  std::vector<Slot> slots_;
+
+  Location locate(folly::StringPiece key) const;
+
+  static bool expired(const Slot& slot, int64_t nowMs) {
+    return static_cast<int32_t>(
+               slot.expiresAtMs - static_cast<uint32_t>(nowMs)) <= 0;
+  }
+
+  static bool isFree(const Slot& slot, int64_t nowMs) {
+    return slot.fingerprint == 0 || expired(slot, nowMs);
+  }
+
+  Slot* bucket(size_t idx) {
+    return &slots_[idx * kSlotsPerBucket];
+  }
+  const Slot* bucket(size_t idx) const {
+    return &slots_[idx * kSlotsPerBucket];
+  }
+};
+
+} // mcrouter
+} // memcache
+} // facebook
@@ -0,0 +1,126 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include <folly/dynamic.h>
+
+#include "mcrouter/McrouterFiberContext.h"
+#include "mcrouter/ProxyBase.h"
+#include "mcrouter/ProxyRequestContext.h"
+#include "mcrouter/config.h"
+#include "mcrouter/lib/RouteHandleTraverser.h"
+#include "mcrouter/lib/carbon/RoutingGroups.h"
+#include "mcrouter/lib/config/RouteHandleBuilder.h"
+#include "mcrouter/lib/config/RouteHandleFactory.h"
+#include "mcrouter/lib/fbi/cpp/ParsingUtil.h"
+#include "mcrouter/lib/fbi/cpp/util.h"
+#include "mcrouter/lib/network/gen/Memcache.h"
+#include "mcrouter/routes/NegativeCache.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Answers gets for keys that recently missed with a local miss.
+ *
+ * Every get that the child replies to with notfound is remembered for a
+ * short TTL, and the following gets for the key are answered locally until
+ * then. Any non-get request passing through this route forgets the key.
+ * Writes that don't go through this route (or through another proxy) are
+ * only seen after the TTL expires, and there is a small chance of false
+ * misses (see NegativeCache).
+ */
+template <class RouterInfo>
+class NegativeCacheRoute {
+ private:
+  using RouteHandleIf = typename RouterInfo::RouteHandleIf;
+
+ public:
+  static std::string routeName() {
+    return "negative-cache";
+  }
+
+  template <class Request>
+  void traverse(
+      const Request& req,
+      const RouteHandleTraverser<RouteHandleIf>& t) const {
+    t(*target_, req);
+  }
+
+  NegativeCacheRoute(
+      std::shared_ptr<RouteHandleIf> target,
+      NegativeCache::Options opts)
+      : target_(std::move(target)), cache_(std::move(opts)) {}
+
+  McGetReply route(const McGetRequest& req) {
+    const auto key = req.key().fullKey();
+    auto& stats = fiber_local<RouterInfo>::getSharedCtx()->proxy().stats();
+    if (cache_.contains(key, nowUs() / 1000)) {
+      stats.increment(negative_cache_hits_stat);
+      return McGetReply(mc_res_notfound);
+    }
+    stats.increment(negative_cache_misses_stat);
+
+    // Don't remember the miss if the key may have been modified while the
+    // request was in flight.
+    const auto invalidations = invalidations_;
+    auto reply = target_->route(req);
+    if (reply.result() == mc_res_notfound && invalidations == invalidations_) {
+      cache_.insert(key, nowUs() / 1000);
+    }
+    return reply;
+  }
+
+  template <class Request>
+  ReplyT<Request> route(const Request& req, carbon::GetLikeT<Request> = 0) {
+    return target_->route(req);
+  }
+
+  template <class Request>
+  ReplyT<Request> route(
+      const Request& req,
+      carbon::OtherThanT<Request, carbon::GetLike<>> = 0) {
+    cache_.erase(req.key().fullKey());
+    ++invalidations_;
+    return target_->route(req);
+  }
+
+ private:
+  const std::shared_ptr<RouteHandleIf> target_;
+  NegativeCache cache_;
+  uint64_t invalidations_{0};
+};
+
+template <class RouterInfo>
+typename RouterInfo::RouteHandlePtr makeNegativeCacheRoute(
+    RouteHandleFactory<typename RouterInfo::RouteHandleIf>& factory,
+    const folly::dynamic& json) {
+  checkLogic(json.isObject(), "NegativeCacheRoute: should be an object");
+  auto jtarget = json.get_ptr("target");
+  checkLogic(jtarget, "NegativeCacheRoute: no target");
+  auto target = factory.create(*jtarget);
+
+  NegativeCache::Options opts;
+  if (auto jcapacity = json.get_ptr("capacity")) {
+    opts.capacity = parseInt(*jcapacity, "capacity", 1, 100000000);
+  }
+  if (auto jttl = json.get_ptr("ttl_ms")) {
+    opts.ttl = parseTimeout(*jttl, "ttl_ms");
+  }
+
+  return makeRouteHandleWithInfo<RouterInfo, NegativeCacheRoute>(
+      std::move(target), std::move(opts));
+}
+
+} // mcrouter
+} // memcache
+} // facebook
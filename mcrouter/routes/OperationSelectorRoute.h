@@ -44,27 +44,27 @@ class OperationSelectorRoute {
       carbon::RequestIdMap<RoutableRequests, RouteHandlePtr> operationPolicies,
       RouteHandlePtr&& defaultPolicy)
       : operationPolicies_(std::move(operationPolicies)),
-        defaultPolicy_(std::move(defaultPolicy)) {}
+        defaultPolicy_(std::move(defaultPolicy)) {
+    using IdMap = carbon::RequestIdMap<RoutableRequests, RouteHandleIf*>;
+    for (size_t id = IdMap::kMinId; id <= IdMap::kMaxId; ++id) {
+      const auto& rh = operationPolicies_.getById(id);
+      targets_.set(id, rh ? rh.get() : defaultPolicy_.get());
+    }
+  }
 
   template <class Request>
   void traverse(
       const Request& req,
       const RouteHandleTraverser<RouteHandleIf>& t) const {
-    if (const auto& rh =
-            operationPolicies_.template getByRequestType<Request>()) {
+    if (auto* rh = targets_.template getByRequestType<Request>()) {
       t(*rh, req);
-    } else if (defaultPolicy_) {
-      t(*defaultPolicy_, req);
     }
   }
 
   template <class Request>
   ReplyT<Request> route(const Request& req) const {
-    if (const auto& rh =
-            operationPolicies_.template getByRequestType<Request>()) {
+    if (auto* rh = targets_.template getByRequestType<Request>()) {
       return rh->route(req);
-    } else if (defaultPolicy_) {
-      return defaultPolicy_->route(req);
     }
 
     return ReplyT<Request>();
@@ -74,6 +74,10 @@ class OperationSelectorRoute {
   const carbon::RequestIdMap<RoutableRequests, RouteHandlePtr>
       operationPolicies_;
   const RouteHandlePtr defaultPolicy_;
+  // Target of every request type with the default policy folded in, so that
+  // route() is a single load at an offset known at compile time. Pointers
+  // are owned by operationPolicies_ and defaultPolicy_.
+  carbon::RequestIdMap<RoutableRequests, RouteHandleIf*> targets_;
 };
 
 template <class RouterInfo>
@@ -7,8 +7,12 @@
  */
 #pragma once
 
+#include <algorithm>
+#include <limits>
 #include <list>
 #include <memory>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <folly/Conv.h>
@@ -22,6 +26,7 @@
 #include "mcrouter/lib/Operation.h"
 #include "mcrouter/lib/Reply.h"
 #include "mcrouter/lib/RouteHandleTraverser.h"
+#include "mcrouter/lib/carbon/RequestReplyUtil.h"
 #include "mcrouter/lib/carbon/RoutingGroups.h"
 #include "mcrouter/lib/config/RouteHandleBuilder.h"
 #include "mcrouter/options.h"
@@ -38,10 +43,26 @@ class RouteHandleFactory;
 
 namespace mcrouter {
 
+/**
+ * Identity used to group the requests blocked in OutstandingLimitRoute.
+ */
+enum class OutstandingLimitFairness {
+  // Client connection
+  SENDER_ID,
+  // Client IP address
+  CLIENT_IP,
+  // Routing prefix of the key
+  ROUTING_PREFIX,
+};
+
 /*
  * No more than N requests will be allowed to be concurrently processed by child
- * route. All blocked requests will be sent one request per sender id in
- * round-robin fashion to guarantee fairness.
+ * route. All blocked requests are grouped by client identity (see
+ * OutstandingLimitFairness). Groups are served with deficit round robin:
+ * every time a group gets its turn, its deficit grows by quantum bytes, and
+ * its requests are let through while their size (key + value) fits into the
+ * deficit. With quantum 0, every request costs the same, i.e. one request per
+ * group per turn. Requests with no identity get a group of their own.
  */
 template <class RouterInfo>
 class OutstandingLimitRoute {
@@ -62,27 +83,33 @@ class OutstandingLimitRoute {
 
   OutstandingLimitRoute(
       std::shared_ptr<RouteHandleIf> target,
-      size_t maxOutstanding)
-      : target_(std::move(target)), maxOutstanding_(maxOutstanding) {}
+      size_t maxOutstanding,
+      OutstandingLimitFairness fairness = OutstandingLimitFairness::SENDER_ID,
+      size_t quantum = 0)
+      : target_(std::move(target)),
+        maxOutstanding_(maxOutstanding),
+        fairness_(fairness),
+        quantum_(quantum) {}
 
   template <class Request>
   ReplyT<Request> route(const Request& req) {
     if (outstanding_ == maxOutstanding_) {
       auto& ctx = fiber_local<RouterInfo>::getSharedCtx();
-      auto senderId = ctx->senderId();
+      auto tenant = getTenant(req, *ctx);
       auto& entry = [&]() -> QueueEntry& {
-        auto entry_it = senderIdToEntry_.find(senderId);
-        if (entry_it != senderIdToEntry_.end()) {
+        auto entry_it = tenantToEntry_.find(tenant);
+        if (entry_it != tenantToEntry_.end()) {
           return *entry_it->second;
         }
-        blockedRequests_.push_back(std::make_unique<QueueEntry>(senderId));
-        if (senderId) {
-          senderIdToEntry_[senderId] = blockedRequests_.back().get();
+        blockedRequests_.push_back(std::make_unique<QueueEntry>(tenant));
+        if (!tenant.empty()) {
+          tenantToEntry_[tenant] = blockedRequests_.back().get();
         }
         return *blockedRequests_.back();
       }();
 
-      auto& stats = ctx->proxy().stats();
+      auto& proxy = ctx->proxy();
+      auto& stats = proxy.stats();
       folly::fibers::Baton baton;
       int64_t waitingSince = 0;
       if (carbon::GetLike<Request>::value) {
@@ -92,8 +119,14 @@ class OutstandingLimitRoute {
         ++currentUpdateReqsWaiting_;
         waitingSince = nowUs();
       }
-      entry.batons.push_back(&baton);
+      entry.waiters.push_back(Waiter{&baton, getCost(req)});
+      if (!tenant.empty()) {
+        proxy.adjustTenantQueueDepth(tenant, 1);
+      }
       baton.wait();
+      if (!tenant.empty()) {
+        proxy.adjustTenantQueueDepth(tenant, -1);
+      }
       if (waitingSince > 0) {
         if (carbon::GetLike<Request>::value) {
           stats.increment(
@@ -122,19 +155,7 @@ class OutstandingLimitRoute {
 
     SCOPE_EXIT {
       if (!blockedRequests_.empty()) {
-        auto entry = std::move(blockedRequests_.front());
-        blockedRequests_.pop_front();
-
-        assert(!entry->batons.empty());
-
-        entry->batons.front()->post();
-        entry->batons.pop_front();
-
-        if (!entry->batons.empty()) {
-          blockedRequests_.push_back(std::move(entry));
-        } else {
-          senderIdToEntry_.erase(entry->senderId);
-        }
+        releaseNext();
       } else {
         outstanding_--;
       }
@@ -146,29 +167,126 @@ class OutstandingLimitRoute {
  private:
   const std::shared_ptr<RouteHandleIf> target_;
   const size_t maxOutstanding_;
+  const OutstandingLimitFairness fairness_;
+  const size_t quantum_;
   size_t outstanding_{0};
   size_t currentGetReqsWaiting_{0};
   size_t currentUpdateReqsWaiting_{0};
 
+  struct Waiter {
+    folly::fibers::Baton* baton;
+    size_t cost;
+  };
+
   struct QueueEntry {
     QueueEntry(QueueEntry&&) = delete;
     QueueEntry& operator=(QueueEntry&&) = delete;
 
-    explicit QueueEntry(size_t senderId_) : senderId(senderId_) {}
-    size_t senderId;
-    std::list<folly::fibers::Baton*> batons;
+    explicit QueueEntry(std::string tenant_) : tenant(std::move(tenant_)) {}
+    const std::string tenant;
+    std::list<Waiter> waiters;
+    size_t deficit{0};
+    // Whether the entry already got its quantum in the current turn.
+    bool hasQuantum{false};
   };
 
   std::list<std::unique_ptr<QueueEntry>> blockedRequests_;
-  std::unordered_map<size_t, QueueEntry*> senderIdToEntry_;
+  std::unordered_map<std::string, QueueEntry*> tenantToEntry_;
+
+  template <class Request>
+  std::string getTenant(
+      const Request& req,
+      const ProxyRequestContextWithInfo<RouterInfo>& ctx) const {
+    switch (fairness_) {
+      case OutstandingLimitFairness::SENDER_ID:
+        return ctx.senderId() ? folly::to<std::string>(ctx.senderId()) : "";
+      case OutstandingLimitFairness::CLIENT_IP:
+        return ctx.userIpAddress();
+      case OutstandingLimitFairness::ROUTING_PREFIX:
+        return req.key().routingPrefix().str();
+    }
+    return "";
+  }
+
+  template <class Request>
+  size_t getCost(const Request& req) const {
+    if (quantum_ == 0) {
+      return 1;
+    }
+    auto value = carbon::valuePtrUnsafe(req);
+    return req.key().fullKey().size() +
+        (value ? value->computeChainDataLength() : 0);
+  }
+
+  /**
+   * Lets the next blocked request through, according to deficit round robin.
+   */
+  void releaseNext() {
+    const size_t quantum = quantum_ == 0 ? 1 : quantum_;
+    skipIdleTurns(quantum);
+    while (true) {
+      auto& entry = *blockedRequests_.front();
+      assert(!entry.waiters.empty());
+      if (!entry.hasQuantum) {
+        entry.deficit += quantum;
+        entry.hasQuantum = true;
+      }
+
+      auto waiter = entry.waiters.front();
+      if (waiter.cost <= entry.deficit) {
+        entry.deficit -= waiter.cost;
+        entry.waiters.pop_front();
+        waiter.baton->post();
+        if (entry.waiters.empty()) {
+          tenantToEntry_.erase(entry.tenant);
+          blockedRequests_.pop_front();
+        } else if (entry.waiters.front().cost > entry.deficit) {
+          endTurn();
+        }
+        return;
+      }
+      endTurn();
+    }
+  }
+
+  /**
+   * If no blocked request can be let through in the coming round, credits
+   * every group with the quanta of all the rounds before the first one
+   * that lets a request through. Otherwise a request costing many quanta
+   * would take a pass over all the groups per quantum.
+   */
+  void skipIdleTurns(size_t quantum) {
+    size_t rounds = std::numeric_limits<size_t>::max();
+    for (const auto& entry : blockedRequests_) {
+      const auto cost = entry->waiters.front().cost;
+      // A group in the middle of its turn can always let a request through.
+      if (entry->hasQuantum || cost <= entry->deficit + quantum) {
+        return;
+      }
+      const auto quantaNeeded = (cost - entry->deficit + quantum - 1) / quantum;
+      rounds = std::min(rounds, quantaNeeded - 1);
+    }
+    for (auto& entry : blockedRequests_) {
+      entry->deficit += rounds * quantum;
+    }
+  }
+
+  void endTurn() {
+    auto entry = std::move(blockedRequests_.front());
+    blockedRequests_.pop_front();
+    entry->hasQuantum = false;
+    blockedRequests_.push_back(std::move(entry));
+  }
 };
 
 template <class RouterInfo>
 std::shared_ptr<typename RouterInfo::RouteHandleIf> makeOutstandingLimitRoute(
     std::shared_ptr<typename RouterInfo::RouteHandleIf> normalRoute,
-    size_t maxOutstanding) {
+    size_t maxOutstanding,
+    OutstandingLimitFairness fairness = OutstandingLimitFairness::SENDER_ID,
+    size_t quantum = 0) {
   return makeRouteHandleWithInfo<RouterInfo, OutstandingLimitRoute>(
-      std::move(normalRoute), maxOutstanding);
+      std::move(normalRoute), maxOutstanding, fairness, quantum);
 }
 
 } // mcrouter
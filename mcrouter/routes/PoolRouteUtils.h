@@ -7,6 +7,7 @@
  */
 #pragma once
 
+#include <chrono>
 #include <memory>
 #include <vector>
 
@@ -14,6 +15,7 @@
 
 #include "mcrouter/lib/fbi/cpp/ParsingUtil.h"
 #include "mcrouter/lib/fbi/cpp/util.h"
+#include "mcrouter/routes/CoalescingRoute.h"
 #include "mcrouter/routes/OutstandingLimitRoute.h"
 #include "mcrouter/routes/SlowWarmUpRoute.h"
 #include "mcrouter/routes/SlowWarmUpRouteSettings.h"
@@ -35,7 +37,12 @@ class ExtraRouteHandleProviderIf;
  * @param poolName        The name of the pool that "destinations" belong to.
  * @param json            Json containing basic PoolRoute settings:
  *                           - "max_outstanding" (optional),
+ *                           - "max_outstanding_fairness" (optional),
+ *                           - "max_outstanding_quantum" (optional),
  *                           - "slow_warmup" (optional),
+ *                           - "coalesce_gets" (optional),
+ *                           - "coalesce_lease_gets",
+ *                             "lease_fill_timeout_ms" (optional),
  *                           - "shadows", "shadow_policy" (optional)
  * @param proxy           Instance of ProxyBase.
  * @param extraProvider   Extra route handle provider.
@@ -56,10 +63,29 @@ std::vector<typename RouterInfo::RouteHandlePtr> wrapPoolDestinations(
     if (json.isObject()) {
       if (auto maxOutstandingJson = json.get_ptr("max_outstanding")) {
         auto v = parseInt(*maxOutstandingJson, "max_outstanding", 0, 1000000);
+        auto fairness = OutstandingLimitFairness::SENDER_ID;
+        if (auto fairnessJson = json.get_ptr("max_outstanding_fairness")) {
+          auto str = parseString(*fairnessJson, "max_outstanding_fairness");
+          if (str == "client_ip") {
+            fairness = OutstandingLimitFairness::CLIENT_IP;
+          } else if (str == "routing_prefix") {
+            fairness = OutstandingLimitFairness::ROUTING_PREFIX;
+          } else {
+            checkLogic(
+                str == "sender",
+                "max_outstanding_fairness should be one of 'sender', "
+                "'client_ip' or 'routing_prefix'");
+          }
+        }
+        size_t quantum = 0;
+        if (auto quantumJson = json.get_ptr("max_outstanding_quantum")) {
+          quantum = parseInt(
+              *quantumJson, "max_outstanding_quantum", 0, 1024 * 1024 * 1024);
+        }
         if (v) {
           for (auto& destination : destinations) {
             destination = makeOutstandingLimitRoute<RouterInfo>(
-                std::move(destination), v);
+                std::move(destination), v, fairness, quantum);
           }
         }
       }
@@ -91,6 +117,27 @@ std::vector<typename RouterInfo::RouteHandlePtr> wrapPoolDestinations(
         }
       }
 
+      bool coalesceGets = false;
+      if (auto coalesceJson = json.get_ptr("coalesce_gets")) {
+        coalesceGets = parseBool(*coalesceJson, "coalesce_gets");
+      }
+      std::chrono::milliseconds leaseFillTimeout{0};
+      if (auto coalesceJson = json.get_ptr("coalesce_lease_gets")) {
+        if (parseBool(*coalesceJson, "coalesce_lease_gets")) {
+          leaseFillTimeout = std::chrono::milliseconds(1000);
+          if (auto timeoutJson = json.get_ptr("lease_fill_timeout_ms")) {
+            leaseFillTimeout =
+                parseTimeout(*timeoutJson, "lease_fill_timeout_ms");
+          }
+        }
+      }
+      if (coalesceGets || leaseFillTimeout.count() > 0) {
+        for (auto& destination : destinations) {
+          destination = makeCoalescingRoute<RouterInfo>(
+              std::move(destination), coalesceGets, leaseFillTimeout);
+        }
+      }
+
       if (json.count("shadows")) {
         destinations = makeShadowRoutes(
             factory, json, std::move(destinations), proxy, extraProvider);
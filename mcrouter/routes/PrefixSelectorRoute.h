@@ -39,11 +39,21 @@ class PrefixSelectorRoute {
 
   PrefixSelectorRoute(
       RouteHandleFactory<RouteHandleIf>& factory,
-      const folly::dynamic& json) {
+      const folly::dynamic& json)
+      : PrefixSelectorRoute(json, [&factory](const folly::dynamic& jRoute) {
+          return factory.create(jRoute);
+        }) {}
+
+  /**
+   * @param create  builds the RouteHandle of each policy and of the wildcard
+   *                from its json.
+   */
+  template <class Create>
+  PrefixSelectorRoute(const folly::dynamic& json, Create&& create) {
     // if json is not PrefixSelectorRoute, just treat it as a wildcard.
     if (!json.isObject() || !json.count("type") || !json["type"].isString() ||
         json["type"].stringPiece() != "PrefixSelectorRoute") {
-      wildcard = factory.create(json);
+      wildcard = create(json);
       return;
     }
 
@@ -65,12 +75,12 @@ class PrefixSelectorRoute {
       // order is important
       std::sort(items.begin(), items.end());
       for (const auto& it : items) {
-        policies.emplace(it.first, factory.create(*it.second));
+        policies.emplace(it.first, create(*it.second));
       }
     }
 
     if (jWildcard) {
-      wildcard = factory.create(*jWildcard);
+      wildcard = create(*jWildcard);
     }
   }
 };
@@ -10,7 +10,9 @@
 #include <folly/Optional.h>
 
 #include "mcrouter/Proxy.h"
+#include "mcrouter/lib/Compression.h"
 #include "mcrouter/lib/config/RouteHandleBuilder.h"
+#include "mcrouter/lib/fbi/cpp/util.h"
 #include "mcrouter/lib/network/gen/MemcacheRouteHandleIf.h"
 #include "mcrouter/routes/LoggingRoute.h"
 #include "mcrouter/routes/McRouteHandleBuilder.h"
@@ -33,8 +35,20 @@ typename std::enable_if<
 wrapWithBigValueRoute(
     std::shared_ptr<RouteHandleIf> ch,
     const McrouterOptions& routerOpts) {
+  auto compression = CompressionCodecType::NO_COMPRESSION;
+  if (routerOpts.big_value_compression == "lz4") {
+    compression = CompressionCodecType::LZ4;
+  } else if (routerOpts.big_value_compression == "zstd") {
+    compression = CompressionCodecType::ZSTD;
+  } else if (!routerOpts.big_value_compression.empty()) {
+    throwLogic(
+        "Unknown big_value_compression: '{}'",
+        routerOpts.big_value_compression);
+  }
   BigValueRouteOptions options(
-      routerOpts.big_value_split_threshold, routerOpts.big_value_batch_size);
+      routerOpts.big_value_split_threshold,
+      routerOpts.big_value_batch_size,
+      compression);
   return makeBigValueRoute(std::move(ch), std::move(options));
 }
 
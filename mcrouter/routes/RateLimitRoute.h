@@ -78,14 +78,16 @@ std::shared_ptr<RouteHandleIf> createRateLimitRoute(
 template <class RouteHandleIf>
 std::shared_ptr<RouteHandleIf> makeRateLimitRoute(
     RouteHandleFactory<RouteHandleIf>& factory,
-    const folly::dynamic& json) {
+    const folly::dynamic& json,
+    SharedTokenBucketMap* sharedBuckets = nullptr) {
   checkLogic(json.isObject(), "RateLimitRoute is not an object");
   auto jtarget = json.get_ptr("target");
   checkLogic(jtarget, "RateLimitRoute: target not found");
   auto target = factory.create(*jtarget);
   auto jrates = json.get_ptr("rates");
   checkLogic(jrates, "RateLimitRoute: rates not found");
-  return createRateLimitRoute(std::move(target), RateLimiter(*jrates));
+  return createRateLimitRoute(
+      std::move(target), RateLimiter(*jrates, sharedBuckets));
 }
 
 } // mcrouter
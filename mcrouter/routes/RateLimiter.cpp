@@ -7,6 +7,7 @@
  */
 #include "RateLimiter.h"
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -44,27 +45,87 @@ asPositiveDoubleDefault(const dynamic& obj, const string& keyName, double def) {
 
 } // anonymous
 
-RateLimiter::RateLimiter(const folly::dynamic& json) {
-  checkLogic(json.isObject(), "RateLimiter settings json is not an object");
+std::shared_ptr<SharedTokenBucket>
+SharedTokenBucketMap::get(const std::string& name, double rate, double burst) {
+  auto key = folly::to<string>(name, '|', rate, '|', burst);
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto& weak = buckets_[key];
+  if (auto bucket = weak.lock()) {
+    return bucket;
+  }
+  auto bucket = std::make_shared<SharedTokenBucket>(
+      rate, burst, folly::TokenBucket::defaultClockNow());
+  weak = bucket;
+  // Forget buckets that are not used anymore.
+  for (auto it = buckets_.begin(); it != buckets_.end();) {
+    if (it->second.expired()) {
+      it = buckets_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  return bucket;
+}
 
+RateLimiter::Bucket::Bucket(
+    double rate,
+    double burst,
+    std::shared_ptr<SharedTokenBucket> shared)
+    : local_(rate, burst, folly::TokenBucket::defaultClockNow()),
+      shared_(std::move(shared)),
+      batch_(std::max(1.0, std::min(rate / 1000, burst))),
+      backoff_(batch_ / rate) {}
+
+bool RateLimiter::Bucket::refill() {
   auto now = folly::TokenBucket::defaultClockNow();
+  if (now < retryAt_) {
+    return false;
+  }
+  credit_ += (*shared_)->consumeOrDrain(batch_ - credit_, now);
+  if (credit_ >= 1.0) {
+    credit_ -= 1.0;
+    return true;
+  }
+  // The shared bucket is empty. Under overload every request would end up
+  // here, so leave it alone until about a batch could have accumulated.
+  retryAt_ = now + backoff_;
+  return false;
+}
+
+RateLimiter::RateLimiter(
+    const folly::dynamic& json,
+    SharedTokenBucketMap* sharedBuckets) {
+  checkLogic(json.isObject(), "RateLimiter settings json is not an object");
+
+  std::string sharedName;
+  if (auto jsharedName = json.get_ptr("shared_name")) {
+    checkLogic(jsharedName->isString(), "shared_name is not a string");
+    checkLogic(sharedBuckets, "shared_name is not supported here");
+    sharedName = jsharedName->getString();
+  }
+
+  auto makeBucket = [&](folly::StringPiece op) {
+    double rate = asPositiveDouble(json, folly::to<string>(op, "_rate"));
+    double burst =
+        asPositiveDoubleDefault(json, folly::to<string>(op, "_burst"), rate);
+    std::shared_ptr<SharedTokenBucket> shared;
+    if (!sharedName.empty()) {
+      shared = sharedBuckets->get(
+          folly::to<string>(sharedName, '|', op), rate, burst);
+    }
+    return Bucket(rate, burst, std::move(shared));
+  };
 
   if (json.count("gets_rate")) {
-    double rate = asPositiveDouble(json, "gets_rate");
-    double burst = asPositiveDoubleDefault(json, "gets_burst", rate);
-    getsTb_ = folly::TokenBucket(rate, burst, now);
+    getsTb_ = makeBucket("gets");
   }
 
   if (json.count("sets_rate")) {
-    double rate = asPositiveDouble(json, "sets_rate");
-    double burst = asPositiveDoubleDefault(json, "sets_burst", rate);
-    setsTb_ = folly::TokenBucket(rate, burst, now);
+    setsTb_ = makeBucket("sets");
   }
 
   if (json.count("deletes_rate")) {
-    double rate = asPositiveDouble(json, "deletes_rate");
-    double burst = asPositiveDoubleDefault(json, "deletes_burst", rate);
-    deletesTb_ = folly::TokenBucket(rate, burst, now);
+    deletesTb_ = makeBucket("deletes");
   }
 }
 
@@ -7,6 +7,12 @@
  */
 #pragma once
 
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <folly/CachelinePadded.h>
 #include <folly/Optional.h>
 #include <folly/TokenBucket.h>
 
@@ -20,6 +26,27 @@ namespace facebook {
 namespace memcache {
 namespace mcrouter {
 
+using SharedTokenBucket = folly::CachelinePadded<folly::TokenBucket>;
+
+/**
+ * Token buckets shared by all the RateLimiters of a router with the same
+ * "shared_name" (e.g. by the copies of a route in every proxy's config).
+ * Thread-safe.
+ */
+class SharedTokenBucketMap {
+ public:
+  /**
+   * @return  Token bucket for given name and settings; created if there's no
+   *          such bucket in use.
+   */
+  std::shared_ptr<SharedTokenBucket>
+  get(const std::string& name, double rate, double burst);
+
+ private:
+  std::mutex mutex_;
+  std::unordered_map<std::string, std::weak_ptr<SharedTokenBucket>> buckets_;
+};
+
 /**
  * This is a container for TokenBucket rate limiters for different
  * operation types.
@@ -39,28 +66,29 @@ class RateLimiter {
    *              performed for that operation.
    *              If some *_burst key is missing, burst is set
    *              equal to rate.
+   *
+   *              If "shared_name" is set, the limits are enforced across
+   *              all the RateLimiters with the same name and settings that
+   *              are created with the same sharedBuckets (normally the
+   *              router's), i.e. across all proxies instead of per proxy.
    */
-  explicit RateLimiter(const folly::dynamic& json);
+  explicit RateLimiter(
+      const folly::dynamic& json,
+      SharedTokenBucketMap* sharedBuckets = nullptr);
 
   template <class Request>
   bool canPassThrough(carbon::GetLikeT<Request> = 0) {
-    return LIKELY(
-        !getsTb_ ||
-        getsTb_->consume(1.0, folly::TokenBucket::defaultClockNow()));
+    return LIKELY(!getsTb_ || getsTb_->consume());
   }
 
   template <class Request>
   bool canPassThrough(carbon::UpdateLikeT<Request> = 0) {
-    return LIKELY(
-        !setsTb_ ||
-        setsTb_->consume(1.0, folly::TokenBucket::defaultClockNow()));
+    return LIKELY(!setsTb_ || setsTb_->consume());
   }
 
   template <class Request>
   bool canPassThrough(carbon::DeleteLikeT<Request> = 0) {
-    return LIKELY(
-        !deletesTb_ ||
-        deletesTb_->consume(1.0, folly::TokenBucket::defaultClockNow()));
+    return LIKELY(!deletesTb_ || deletesTb_->consume());
   }
 
   template <class Request>
@@ -79,9 +107,56 @@ class RateLimiter {
   std::string toDebugStr() const;
 
  private:
-  folly::Optional<folly::TokenBucket> getsTb_;
-  folly::Optional<folly::TokenBucket> setsTb_;
-  folly::Optional<folly::TokenBucket> deletesTb_;
+  /**
+   * Either a TokenBucket of its own, or a share of a SharedTokenBucket.
+   * To keep the shared bucket off the hot path, tokens are taken from it in
+   * batches of about a millisecond worth of rate and then spent locally.
+   * Once the shared bucket comes back empty, it is not asked again until
+   * about a batch worth of time has passed, so it is touched at most about
+   * rate / batch times per second even when over the limit.
+   */
+  class Bucket {
+   public:
+    Bucket(
+        double rate,
+        double burst,
+        std::shared_ptr<SharedTokenBucket> shared);
+
+    bool consume() {
+      if (!shared_) {
+        return local_.consume(1.0, folly::TokenBucket::defaultClockNow());
+      }
+      if (credit_ >= 1.0) {
+        credit_ -= 1.0;
+        return true;
+      }
+      return refill();
+    }
+
+    double rate() const {
+      return local_.rate();
+    }
+    double burst() const {
+      return local_.burst();
+    }
+
+   private:
+    // Only used for rate/burst if shared_ is set.
+    folly::TokenBucket local_;
+    std::shared_ptr<SharedTokenBucket> shared_;
+    double batch_{1.0};
+    double credit_{0.0};
+    // Seconds to leave an empty shared bucket alone for.
+    double backoff_{0.0};
+    // defaultClockNow() before which the shared bucket is known to be empty.
+    double retryAt_{0.0};
+
+    bool refill();
+  };
+
+  folly::Optional<Bucket> getsTb_;
+  folly::Optional<Bucket> setsTb_;
+  folly::Optional<Bucket> deletesTb_;
 };
 }
 }
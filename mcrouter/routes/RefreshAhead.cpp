@@ -0,0 +1,81 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include "RefreshAhead.h"
+
+#include <algorithm>
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+namespace {
+
+// Larger exptimes are absolute unix times, as in memcached.
+constexpr int32_t kMaxRelativeExptime = 60 * 60 * 24 * 30;
+
+} // anonymous namespace
+
+constexpr uint32_t RefreshAhead::kMaxHotThreshold;
+
+RefreshAhead::RefreshAhead(Options opts)
+    : opts_(std::move(opts)),
+      sketch_(
+          opts_.capacity * 8,
+          kMaxHotThreshold,
+          opts_.capacity * 80 /* resetPeriod */),
+      keys_(std::max<size_t>(opts_.capacity, 1)) {}
+
+folly::Optional<uint32_t> RefreshAhead::recordGet(
+    folly::StringPiece key,
+    int64_t nowMs) {
+  sketch_.increment(key);
+  auto it = keys_.find(key.str());
+  if (it == keys_.end()) {
+    return folly::none;
+  }
+  auto& entry = it->second;
+  if (entry.expiresAtMs <= nowMs) {
+    // Too late, the key is gone.
+    keys_.erase(it);
+    return folly::none;
+  }
+  if (entry.refreshing ||
+      entry.expiresAtMs - nowMs > opts_.refreshAhead.count()) {
+    return folly::none;
+  }
+  entry.refreshing = true;
+  return entry.ttlSec;
+}
+
+void RefreshAhead::recordSet(
+    folly::StringPiece key,
+    int32_t exptime,
+    int64_t nowMs) {
+  if (exptime <= 0 || sketch_.estimate(key) < opts_.hotThreshold) {
+    keys_.erase(key.str());
+    return;
+  }
+  int64_t ttlMs = exptime > kMaxRelativeExptime
+      ? int64_t(exptime) * 1000 - nowMs
+      : int64_t(exptime) * 1000;
+  if (ttlMs <= 0) {
+    keys_.erase(key.str());
+    return;
+  }
+  keys_.set(
+      key.str(),
+      Entry{nowMs + ttlMs, static_cast<uint32_t>((ttlMs + 999) / 1000), false});
+}
+
+void RefreshAhead::erase(folly::StringPiece key) {
+  keys_.erase(key.str());
+}
+
+} // mcrouter
+} // memcache
+} // facebook
@@ -0,0 +1,86 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include <folly/Optional.h>
+#include <folly/Range.h>
+#include <folly/container/EvictingCacheMap.h>
+
+#include "mcrouter/lib/CountMinSketch.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Remembers when hot keys expire, to refresh them shortly before.
+ *
+ * Gets are counted in a count-min sketch. Sets of keys the sketch considers
+ * hot are tracked (up to `capacity` keys, least recently used ones are
+ * forgotten) along with the exptime they set. Once a tracked key is within
+ * `refreshAhead` of its expiry, exactly one get is picked to refresh it,
+ * until the key is set again.
+ *
+ * Not thread-safe: meant to be owned by a single proxy.
+ */
+class RefreshAhead {
+ public:
+  struct Options {
+    size_t capacity{1000};
+    std::chrono::milliseconds refreshAhead{10000};
+    uint32_t hotThreshold{4};
+  };
+
+  /**
+   * Maximum hotThreshold: counts above it aren't tracked.
+   */
+  static constexpr uint32_t kMaxHotThreshold = 15;
+
+  explicit RefreshAhead(Options opts);
+
+  /**
+   * Records a get for key.
+   *
+   * @return  exptime (relative, in seconds) the key was last set with, if
+   *          this get should refresh it.
+   */
+  folly::Optional<uint32_t> recordGet(folly::StringPiece key, int64_t nowMs);
+
+  /**
+   * Records a successful update of key.
+   *
+   * @param exptime  memcache exptime of the update: 0 for no expiry, up to 30
+   *                 days relative, absolute unix time above.
+   */
+  void recordSet(folly::StringPiece key, int32_t exptime, int64_t nowMs);
+
+  void erase(folly::StringPiece key);
+
+  size_t size() const {
+    return keys_.size();
+  }
+
+ private:
+  struct Entry {
+    int64_t expiresAtMs;
+    uint32_t ttlSec;
+    bool refreshing;
+  };
+
+  const Options opts_;
+  CountMinSketch sketch_;
+  folly::EvictingCacheMap<std::string, Entry> keys_;
+};
+
+} // mcrouter
+} // memcache
+} // facebook
@@ -0,0 +1,187 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include <folly/dynamic.h>
+#include <folly/fibers/FiberManager.h>
+
+#include "mcrouter/McrouterFiberContext.h"
+#include "mcrouter/ProxyBase.h"
+#include "mcrouter/ProxyRequestContext.h"
+#include "mcrouter/config.h"
+#include "mcrouter/lib/McResUtil.h"
+#include "mcrouter/lib/RouteHandleTraverser.h"
+#include "mcrouter/lib/carbon/RoutingGroups.h"
+#include "mcrouter/lib/config/RouteHandleBuilder.h"
+#include "mcrouter/lib/config/RouteHandleFactory.h"
+#include "mcrouter/lib/fbi/cpp/ParsingUtil.h"
+#include "mcrouter/lib/fbi/cpp/util.h"
+#include "mcrouter/lib/network/gen/Memcache.h"
+#include "mcrouter/routes/RefreshAhead.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Refreshes hot keys shortly before they expire, so that they don't all
+ * miss at once every TTL period (causing miss storms and lease contention).
+ *
+ * Sets of hot keys passing through this route are tracked with their
+ * exptime, see RefreshAhead. Once such a key is about to expire, exactly one
+ * get hit is picked to refresh it:
+ *  - without "refill", that get gets a miss reply, so that its client
+ *    refills the key as if it had expired, while other clients still hit;
+ *  - with "refill", the get is replied as is and mcrouter fetches the value
+ *    from the refill route in the background and sets it into "target"
+ *    again, with the exptime of the last set.
+ * Other requests passing through this route stop tracking the key.
+ */
+template <class RouterInfo>
+class RefreshAheadRoute {
+ private:
+  using RouteHandleIf = typename RouterInfo::RouteHandleIf;
+
+ public:
+  static std::string routeName() {
+    return "refresh-ahead";
+  }
+
+  template <class Request>
+  void traverse(
+      const Request& req,
+      const RouteHandleTraverser<RouteHandleIf>& t) const {
+    t(*target_, req);
+  }
+
+  RefreshAheadRoute(
+      std::shared_ptr<RouteHandleIf> target,
+      std::shared_ptr<RouteHandleIf> refill,
+      RefreshAhead::Options opts)
+      : target_(std::move(target)),
+        refill_(std::move(refill)),
+        refreshAhead_(std::make_shared<RefreshAhead>(std::move(opts))) {}
+
+  McGetReply route(const McGetRequest& req) {
+    auto reply = target_->route(req);
+    const auto exptime =
+        refreshAhead_->recordGet(req.key().fullKey(), wallNowMs());
+    if (!exptime || !isHitResult(reply.result())) {
+      return reply;
+    }
+
+    fiber_local<RouterInfo>::getSharedCtx()->proxy().stats().increment(
+        refresh_ahead_triggers_stat);
+    if (!refill_) {
+      return McGetReply(mc_res_notfound);
+    }
+    sendRefresh(req.key().fullKey(), *exptime);
+    return reply;
+  }
+
+  template <class Request>
+  ReplyT<Request> route(const Request& req, carbon::GetLikeT<Request> = 0) {
+    return target_->route(req);
+  }
+
+  template <class Request>
+  ReplyT<Request> route(const Request& req, carbon::UpdateLikeT<Request> = 0) {
+    auto reply = target_->route(req);
+    if (isStoredResult(reply.result())) {
+      refreshAhead_->recordSet(
+          req.key().fullKey(), req.exptime(), wallNowMs());
+    } else {
+      refreshAhead_->erase(req.key().fullKey());
+    }
+    return reply;
+  }
+
+  template <class Request>
+  ReplyT<Request> route(
+      const Request& req,
+      carbon::OtherThanT<Request, carbon::GetLike<>, carbon::UpdateLike<>> =
+          0) {
+    refreshAhead_->erase(req.key().fullKey());
+    return target_->route(req);
+  }
+
+ private:
+  const std::shared_ptr<RouteHandleIf> target_;
+  const std::shared_ptr<RouteHandleIf> refill_;
+  // Shared with background refreshes, which may outlive the route.
+  const std::shared_ptr<RefreshAhead> refreshAhead_;
+
+  // Exptimes may be absolute unix times, so this is wall clock time.
+  static int64_t wallNowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+  }
+
+  void sendRefresh(folly::StringPiece key, uint32_t exptime) {
+    folly::fibers::addTask([
+      target = target_,
+      refill = refill_,
+      refreshAhead = refreshAhead_,
+      key = key.str(),
+      exptime
+    ]() {
+      auto reply = refill->route(McGetRequest(key));
+      if (!isHitResult(reply.result())) {
+        return;
+      }
+      McSetRequest set(key);
+      if (auto value = carbon::valuePtrUnsafe(reply)) {
+        set.value() = value->cloneAsValue();
+      }
+      set.flags() = reply.flags();
+      set.exptime() = exptime;
+      if (isStoredResult(target->route(set).result())) {
+        refreshAhead->recordSet(key, exptime, wallNowMs());
+      }
+    });
+  }
+};
+
+template <class RouterInfo>
+typename RouterInfo::RouteHandlePtr makeRefreshAheadRoute(
+    RouteHandleFactory<typename RouterInfo::RouteHandleIf>& factory,
+    const folly::dynamic& json) {
+  checkLogic(json.isObject(), "RefreshAheadRoute: should be an object");
+  auto jtarget = json.get_ptr("target");
+  checkLogic(jtarget, "RefreshAheadRoute: no target");
+  auto target = factory.create(*jtarget);
+
+  typename RouterInfo::RouteHandlePtr refill;
+  if (auto jrefill = json.get_ptr("refill")) {
+    refill = factory.create(*jrefill);
+  }
+
+  RefreshAhead::Options opts;
+  if (auto jcapacity = json.get_ptr("capacity")) {
+    opts.capacity = parseInt(*jcapacity, "capacity", 1, 10000000);
+  }
+  if (auto jrefreshAhead = json.get_ptr("refresh_ahead_ms")) {
+    opts.refreshAhead = parseTimeout(*jrefreshAhead, "refresh_ahead_ms");
+  }
+  if (auto jthreshold = json.get_ptr("hot_threshold")) {
+    opts.hotThreshold = parseInt(
+        *jthreshold, "hot_threshold", 1, RefreshAhead::kMaxHotThreshold);
+  }
+
+  return makeRouteHandleWithInfo<RouterInfo, RefreshAheadRoute>(
+      std::move(target), std::move(refill), std::move(opts));
+}
+
+} // mcrouter
+} // memcache
+} // facebook
@@ -0,0 +1,265 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <cassert>
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <folly/Optional.h>
+#include <folly/dynamic.h>
+#include <folly/fibers/Baton.h>
+#include <folly/fibers/FiberManager.h>
+
+#include "mcrouter/McrouterFiberContext.h"
+#include "mcrouter/ProxyBase.h"
+#include "mcrouter/ProxyRequestContext.h"
+#include "mcrouter/lib/McResUtil.h"
+#include "mcrouter/lib/RouteHandleTraverser.h"
+#include "mcrouter/lib/config/RouteHandleBuilder.h"
+#include "mcrouter/lib/config/RouteHandleFactory.h"
+#include "mcrouter/lib/fbi/cpp/ParsingUtil.h"
+#include "mcrouter/lib/fbi/cpp/util.h"
+#include "mcrouter/lib/network/gen/Memcache.h"
+#include "mcrouter/lib/routes/NullRoute.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Replicates sets and deletes to a remote region asynchronously, coalescing
+ * writes to the same key on the way.
+ *
+ * Like AllAsyncRoute, sets and deletes are not waited for. They are kept for
+ * up to `window`, during which a later set or delete of the same key
+ * replaces the pending one (the last writer wins), so only the last write of
+ * every key crosses the link. Pending writes are sent out together when the
+ * window expires or maxBatchSize keys are pending, and end up close to each
+ * other on the target's connections, where they are batched and compressed
+ * by the transport.
+ *
+ * A set that fails is replaced with a delete of its key, so that the remote
+ * region doesn't keep serving the old value. Deletes that fail (including
+ * those) are spooled to the asynclog named asynclogName, if it's not empty.
+ *
+ * All other requests are sent to the target as is.
+ *
+ * Route handles are per proxy, so are the pending writes, and no
+ * synchronization is needed.
+ */
+template <class RouterInfo>
+class ReplicationRoute {
+ private:
+  using RouteHandleIf = typename RouterInfo::RouteHandleIf;
+
+ public:
+  static std::string routeName() {
+    return "replication";
+  }
+
+  template <class Request>
+  void traverse(
+      const Request& req,
+      const RouteHandleTraverser<RouteHandleIf>& t) const {
+    t(*state_->target, req);
+  }
+
+  ReplicationRoute(
+      std::shared_ptr<RouteHandleIf> target,
+      std::chrono::milliseconds window,
+      size_t maxBatchSize,
+      std::string asynclogName)
+      : state_(std::make_shared<State>(
+            std::move(target),
+            window,
+            maxBatchSize,
+            std::move(asynclogName))) {
+    assert(maxBatchSize > 0);
+  }
+
+  McSetReply route(const McSetRequest& req) {
+    add(req);
+    return NullRoute<RouteHandleIf>::route(req);
+  }
+
+  McDeleteReply route(const McDeleteRequest& req) {
+    add(req);
+    return NullRoute<RouteHandleIf>::route(req);
+  }
+
+  template <class Request>
+  ReplyT<Request> route(const Request& req) {
+    return state_->target->route(req);
+  }
+
+ private:
+  // Exactly one of the two is set.
+  struct Write {
+    folly::Optional<McSetRequest> set;
+    folly::Optional<McDeleteRequest> del;
+  };
+
+  // Shared with the fibers sending the writes, which may still be running
+  // after the route handle is gone.
+  struct State {
+    State(
+        std::shared_ptr<RouteHandleIf> target_,
+        std::chrono::milliseconds window_,
+        size_t maxBatchSize_,
+        std::string asynclogName_)
+        : target(std::move(target_)),
+          window(window_),
+          maxBatchSize(maxBatchSize_),
+          asynclogName(std::move(asynclogName_)) {}
+
+    const std::shared_ptr<RouteHandleIf> target;
+    const std::chrono::milliseconds window;
+    const size_t maxBatchSize;
+    const std::string asynclogName;
+
+    // Pending writes in the order their keys were first written, and the
+    // position of every key in it.
+    std::vector<Write> writes;
+    std::unordered_map<std::string, size_t> positions;
+    // Set while the flushing fiber waits for the window to expire.
+    folly::fibers::Baton* flushBaton{nullptr};
+  };
+
+  const std::shared_ptr<State> state_;
+
+  static void assign(Write& write, const McSetRequest& req) {
+    write.set = req;
+    write.del.clear();
+  }
+
+  static void assign(Write& write, const McDeleteRequest& req) {
+    write.del = req;
+    write.set.clear();
+  }
+
+  template <class Request>
+  void add(const Request& req) {
+    auto& state = *state_;
+    auto key = req.key().fullKey().str();
+    auto it = state.positions.find(key);
+    if (it != state.positions.end()) {
+      assign(state.writes[it->second], req);
+      if (auto& ctx = fiber_local<RouterInfo>::getSharedCtx()) {
+        ctx->proxy().stats().increment(replication_writes_coalesced_stat);
+      }
+      return;
+    }
+
+    state.positions.emplace(std::move(key), state.writes.size());
+    state.writes.emplace_back();
+    assign(state.writes.back(), req);
+    if (state.writes.size() == 1) {
+      scheduleFlush(state_);
+    } else if (
+        state.writes.size() >= state.maxBatchSize &&
+        state.flushBaton != nullptr) {
+      state.flushBaton->post();
+    }
+  }
+
+  static void scheduleFlush(std::shared_ptr<State> state) {
+    folly::fibers::addTask([state = std::move(state)]() {
+      if (state->writes.size() < state->maxBatchSize) {
+        folly::fibers::Baton baton;
+        state->flushBaton = &baton;
+        baton.try_wait_for(state->window);
+        state->flushBaton = nullptr;
+      }
+      flush(state);
+    });
+  }
+
+  static void flush(const std::shared_ptr<State>& state) {
+    auto writes = std::move(state->writes);
+    state->writes.clear();
+    state->positions.clear();
+    if (auto& ctx = fiber_local<RouterInfo>::getSharedCtx()) {
+      ctx->proxy().stats().increment(replication_batches_stat);
+    }
+    for (auto& write : writes) {
+      folly::fibers::addTask([state, write = std::move(write)]() {
+        send(*state, write);
+      });
+    }
+  }
+
+  static void send(const State& state, const Write& write) {
+    fiber_local<RouterInfo>::runWithLocals([&state, &write]() {
+      if (!state.asynclogName.empty()) {
+        fiber_local<RouterInfo>::setAsynclogName(state.asynclogName);
+      }
+      if (write.del) {
+        state.target->route(*write.del);
+        return;
+      }
+      auto reply = state.target->route(*write.set);
+      if (!isErrorResult(reply.result())) {
+        return;
+      }
+      if (auto& ctx = fiber_local<RouterInfo>::getSharedCtx()) {
+        ctx->proxy().stats().increment(replication_sets_invalidated_stat);
+      }
+      state.target->route(McDeleteRequest(write.set->key().fullKey()));
+    });
+  }
+};
+
+/**
+ * ReplicationRoute config:
+ * {
+ *   "type": "ReplicationRoute",
+ *   "target": route handle of the remote region,
+ *   "window_ms": int, how long writes are kept for coalescing (default 5),
+ *   "max_batch_size": int, writes are sent out once that many keys are
+ *                     pending (default 1000),
+ *   "asynclog_name": string, asynclog to spool failed deletes to (optional)
+ * }
+ */
+template <class RouterInfo>
+typename RouterInfo::RouteHandlePtr makeReplicationRoute(
+    RouteHandleFactory<typename RouterInfo::RouteHandleIf>& factory,
+    const folly::dynamic& json) {
+  checkLogic(json.isObject(), "ReplicationRoute: should be an object");
+  auto jtarget = json.get_ptr("target");
+  checkLogic(jtarget, "ReplicationRoute: no target");
+
+  std::chrono::milliseconds window(5);
+  if (auto jwindow = json.get_ptr("window_ms")) {
+    window = parseTimeout(*jwindow, "window_ms");
+  }
+  size_t maxBatchSize = 1000;
+  if (auto jmaxBatchSize = json.get_ptr("max_batch_size")) {
+    maxBatchSize = parseInt(
+        *jmaxBatchSize,
+        "max_batch_size",
+        1,
+        std::numeric_limits<int32_t>::max());
+  }
+  std::string asynclogName;
+  if (auto jasynclogName = json.get_ptr("asynclog_name")) {
+    asynclogName = parseString(*jasynclogName, "asynclog_name").str();
+  }
+
+  return makeRouteHandleWithInfo<RouterInfo, ReplicationRoute>(
+      factory.create(*jtarget), window, maxBatchSize, std::move(asynclogName));
+}
+
+} // mcrouter
+} // memcache
+} // facebook
@@ -0,0 +1,52 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <folly/dynamic.h>
+
+namespace facebook {
+namespace memcache {
+
+struct AccessPoint;
+
+namespace mcrouter {
+
+class ProxyDestination;
+
+/**
+ * A PoolRoute built for a config, with what building it added to the
+ * provider, so that the next config can carry it over (with its runtime
+ * state: rate limiter buckets, load balancer loads, ...) if it's unchanged.
+ */
+template <class RouteHandleIf>
+struct ReusablePoolRoute {
+  // Referenced by the destination routes, so it must outlive route.
+  std::shared_ptr<const std::string> poolName;
+  std::shared_ptr<RouteHandleIf> route;
+  std::vector<std::shared_ptr<RouteHandleIf>> poolDestinations;
+  std::vector<std::shared_ptr<const AccessPoint>> accessPoints;
+  std::vector<std::weak_ptr<ProxyDestination>> proxyDestinations;
+  // Empty if route isn't an asynclog route.
+  std::string asynclogName;
+};
+
+/**
+ * Reusable pool routes, keyed by the PoolRoute json and the final pool json.
+ */
+template <class RouteHandleIf>
+using ReusablePoolRouteMap =
+    std::unordered_map<folly::dynamic, ReusablePoolRoute<RouteHandleIf>>;
+
+} // mcrouter
+} // memcache
+} // facebook
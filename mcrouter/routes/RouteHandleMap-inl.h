@@ -12,6 +12,7 @@
 #include <unordered_set>
 #include <vector>
 
+#include <folly/Conv.h>
 #include <folly/fibers/FiberManager.h>
 #include <folly/hash/Hash.h>
 
@@ -120,6 +121,23 @@ RouteHandleMap<RouteHandleIf>::RouteHandleMap(
 
   assert(byRoute_.find(defaultRoute_) != byRoute_.end());
   defaultRouteMap_ = byRoute_[defaultRoute_];
+
+  std::vector<std::string> prefixes;
+  for (const auto& it : byRoute_) {
+    prefixes.push_back(it.first.str());
+    prefixTargets_.push_back(makePrefixTargets(*it.second));
+  }
+  for (const auto& it : byRegion_) {
+    auto prefix = folly::to<std::string>("/", it.first, "/*/");
+    if (prefix != "/*/*/") {
+      prefixes.push_back(std::move(prefix));
+      prefixTargets_.push_back(makePrefixTargets(*it.second));
+    }
+  }
+  prefixes.push_back("/*/*/");
+  prefixTargets_.push_back(makePrefixTargets(*allRoutes_));
+  prefixIndex_ = PerfectStringIndex(std::move(prefixes));
+  defaultTargets_ = makePrefixTargets(*defaultRouteMap_);
 }
 
 template <class RouteHandleIf>
@@ -203,31 +221,25 @@ RouteHandleMap<RouteHandleIf>::getTargetsForKeyFast(
   const std::vector<std::shared_ptr<RouteHandleIf>>* result = nullptr;
   if (prefix.empty()) {
     // empty prefix => route to default route
-    result = &defaultRouteMap_->getTargetsForKey(key);
-  } else if (prefix == "/*/*/") {
-    // route to all routes
-    result = &allRoutes_->getTargetsForKey(key);
+    result = &defaultTargets_.get(key);
   } else {
-    auto starPos = prefix.find("*");
-    if (starPos == std::string::npos) {
-      // no stars at all
-      auto it = byRoute_.find(prefix);
-      if (it != byRoute_.end()) {
-        result = &it->second->getTargetsForKey(key);
-      } else {
+    // configured cluster, /region/*/ or /*/*/
+    auto idx = prefixIndex_.find(prefix);
+    if (idx != PerfectStringIndex::kNotFound) {
+      result = &prefixTargets_[idx].get(key);
+    } else {
+      auto starPos = prefix.find("*");
+      if (starPos == std::string::npos) {
         // cluster in question isn't in config, try the fallback
         result = getTargetsForKeyFallback(prefix, key);
+      } else if (prefix.endsWith("/*/") && starPos == prefix.size() - 2) {
+        // region in question isn't in config
+        result = &emptyV_;
       }
-    } else if (prefix.endsWith("/*/") && starPos == prefix.size() - 2) {
-      // route to all clusters of some region (/region/*/)
-      auto region = prefix.subpiece(1, prefix.size() - 4);
-      auto it = byRegion_.find(region);
-      result =
-          it == byRegion_.end() ? &emptyV_ : &it->second->getTargetsForKey(key);
     }
   }
   if (sendInvalidRouteToDefault_ && result != nullptr && result->empty()) {
-    return &defaultRouteMap_->getTargetsForKey(key);
+    return &defaultTargets_.get(key);
   }
   return result;
 }
@@ -17,6 +17,7 @@
 #include <folly/experimental/StringKeyedUnorderedMap.h>
 
 #include "mcrouter/config.h"
+#include "mcrouter/lib/PerfectStringIndex.h"
 #include "mcrouter/routes/RoutePolicyMap.h"
 #include "mcrouter/routes/RouteSelectorMap.h"
 
@@ -65,6 +66,31 @@ class RouteHandleMap {
   folly::StringKeyedUnorderedMap<std::shared_ptr<RoutePolicyMap<RouteHandleIf>>>
       byRoute_;
 
+  /**
+   * Flat dispatch for getTargetsForKeyFast, built once from the maps above
+   * (which own the policy maps for the lifetime of the config): every
+   * routing prefix, /region/*/ and /*/*/ is perfectly hashed to an entry
+   * with raw pointers.
+   */
+  struct PrefixTargets {
+    const RoutePolicyMap<RouteHandleIf>* policies;
+    // Set if the targets don't depend on the key.
+    const std::vector<std::shared_ptr<RouteHandleIf>>* targets;
+
+    const std::vector<std::shared_ptr<RouteHandleIf>>& get(
+        folly::StringPiece key) const {
+      return targets ? *targets : policies->getTargetsForKey(key);
+    }
+  };
+  PerfectStringIndex prefixIndex_;
+  std::vector<PrefixTargets> prefixTargets_;
+  PrefixTargets defaultTargets_;
+
+  static PrefixTargets makePrefixTargets(
+      const RoutePolicyMap<RouteHandleIf>& policies) {
+    return {&policies, policies.keyIndependentTargets()};
+  }
+
   void foreachRoutePolicy(
       folly::StringPiece prefix,
       std::function<void(const std::shared_ptr<RoutePolicyMap<RouteHandleIf>>&)>
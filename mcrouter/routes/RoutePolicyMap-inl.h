@@ -71,25 +71,29 @@ RoutePolicyMap<RouteHandleIf>::RoutePolicyMap(
     }
   }
 
-  ut_.emplace("", std::move(wildcards));
+  Trie<std::vector<std::shared_ptr<RouteHandleIf>>> ut;
+  ut.emplace("", std::move(wildcards));
   // we iterate over keys in lexicographic order, so all prefixes of key will go
   // before key itself
   for (auto& it : t) {
-    auto existing = ut_.findPrefix(it.first);
+    auto existing = ut.findPrefix(it.first);
     // at least empty string should be there
-    assert(existing != ut_.end());
-    ut_.emplace(it.first, detail::overrideItems(existing->second, it.second));
+    assert(existing != ut.end());
+    ut.emplace(it.first, detail::overrideItems(existing->second, it.second));
   }
-  for (auto& it : ut_) {
+  for (auto& it : ut) {
     it.second = detail::orderedUnique(it.second);
   }
+  // Lookups happen on every request, so use the compact layout for them.
+  ut_ = CompactTrie<std::vector<std::shared_ptr<RouteHandleIf>>>::fromContainer(
+      ut);
 }
 
 template <class RouteHandleIf>
 const std::vector<std::shared_ptr<RouteHandleIf>>&
 RoutePolicyMap<RouteHandleIf>::getTargetsForKey(folly::StringPiece key) const {
   auto result = ut_.findPrefix(key);
-  return result == ut_.end() ? emptyV_ : result->second;
+  return result ? *result : emptyV_;
 }
 }
 }
@@ -12,6 +12,7 @@
 
 #include <folly/Range.h>
 
+#include "mcrouter/lib/fbi/cpp/CompactTrie.h"
 #include "mcrouter/lib/fbi/cpp/Trie.h"
 
 namespace facebook {
@@ -58,6 +59,16 @@ class RoutePolicyMap {
   const std::vector<std::shared_ptr<RouteHandleIf>>& getTargetsForKey(
       folly::StringPiece key) const;
 
+  /**
+   * @return targets for every key if no cluster has key prefix policies
+   *         (i.e. getTargetsForKey doesn't depend on the key), nullptr
+   *         otherwise.
+   */
+  const std::vector<std::shared_ptr<RouteHandleIf>>* keyIndependentTargets()
+      const {
+    return ut_.size() == 1 ? ut_.find("") : nullptr;
+  }
+
  private:
   const std::vector<std::shared_ptr<RouteHandleIf>> emptyV_;
   /**
@@ -66,7 +77,7 @@ class RoutePolicyMap {
    * 2) targets for string of length n+1 S[0..n] are targets for S[0..n-1] with
    *    OperationSelectorRoutes for key prefix == S[0..n] overridden.
    */
-  Trie<std::vector<std::shared_ptr<RouteHandleIf>>> ut_;
+  CompactTrie<std::vector<std::shared_ptr<RouteHandleIf>>> ut_;
 };
 }
 }
@@ -0,0 +1,68 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include "RuntimeWeightedCh3HashFunc.h"
+
+#include <folly/dynamic.h>
+
+#include "mcrouter/RuntimeVarsData.h"
+#include "mcrouter/lib/fbi/cpp/util.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+RuntimeWeightedCh3HashFunc::RuntimeWeightedCh3HashFunc(
+    const folly::dynamic& json,
+    size_t n,
+    ObservableRuntimeVars& rtVars) {
+  checkLogic(json.isObject(), "WeightedCh3HashFunc: not an object");
+  auto jWeightsRv = json.get_ptr("weights_rv");
+  checkLogic(
+      jWeightsRv && jWeightsRv->isString(),
+      "WeightedCh3HashFunc: weights_rv is not a string");
+  auto weightsRv = jWeightsRv->getString();
+
+  auto weights = json.get_ptr("weights")
+      ? ch3wParseWeights(json, n)
+      : std::vector<double>(n, 1.0);
+  weights_ = std::make_shared<Observable<Weights>>(
+      std::make_shared<const std::vector<double>>(std::move(weights)));
+
+  handle_ = std::make_shared<ObservableRuntimeVars::CallbackHandle>(
+      rtVars.subscribeAndCall(
+          [weights = weights_, weightsRv = std::move(weightsRv), n](
+              std::shared_ptr<const RuntimeVarsData> /* oldVars */,
+              std::shared_ptr<const RuntimeVarsData> newVars) {
+            if (!newVars) {
+              return;
+            }
+            auto val = newVars->getVariableByName(weightsRv);
+            if (val == nullptr) {
+              return;
+            }
+            checkLogic(
+                val.isArray() && val.size() == n,
+                "runtime vars: {} is not an array of {} weights",
+                weightsRv,
+                n);
+            std::vector<double> newWeights;
+            for (const auto& w : val) {
+              checkLogic(
+                  w.isNumber() && 0 <= w.asDouble() && w.asDouble() <= 1,
+                  "runtime vars: {} has a weight out of [0, 1]",
+                  weightsRv);
+              newWeights.push_back(w.asDouble());
+            }
+            weights->set(std::make_shared<const std::vector<double>>(
+                std::move(newWeights)));
+          }));
+}
+
+} // mcrouter
+} // memcache
+} // facebook
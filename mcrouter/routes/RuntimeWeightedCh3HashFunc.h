@@ -0,0 +1,84 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <folly/Range.h>
+
+#include "mcrouter/Observable.h"
+#include "mcrouter/lib/WeightedCh3HashFunc.h"
+
+namespace folly {
+struct dynamic;
+} // folly
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+class RuntimeVarsData;
+
+using ObservableRuntimeVars =
+    Observable<std::shared_ptr<const RuntimeVarsData>>;
+
+/**
+ * WeightedCh3HashFunc with weights taken from a runtime variable, so that
+ * they can be changed without a reconfiguration: no route is rebuilt and no
+ * destination is touched.
+ *
+ * New weights are swapped in atomically, and picked up by every proxy on its
+ * next request. Until the variable is set (or if it is invalid), the weights
+ * of the config are used.
+ */
+class RuntimeWeightedCh3HashFunc {
+ public:
+  /**
+   * @param json    Json object of the following format:
+   *                {
+   *                  "weights_rv": name of the runtime variable, an array
+   *                                of weights in [0, 1],
+   *                  "weights": [ ... ] (optional, all 1.0 if missing)
+   *                }
+   * @param n       Number of servers in the config.
+   * @param rtVars  Runtime variables of the router, must outlive this
+   *                function object.
+   */
+  RuntimeWeightedCh3HashFunc(
+      const folly::dynamic& json,
+      size_t n,
+      ObservableRuntimeVars& rtVars);
+
+  size_t operator()(folly::StringPiece key) const {
+    return weightedCh3Hash(key, *weights_->snapshot());
+  }
+
+  /**
+   * @return Current weights.
+   */
+  std::vector<double> weights() const {
+    return *weights_->get();
+  }
+
+  static const char* type() {
+    return WeightedCh3HashFunc::type();
+  }
+
+ private:
+  using Weights = std::shared_ptr<const std::vector<double>>;
+
+  // Shared by the copies of this function object.
+  std::shared_ptr<Observable<Weights>> weights_;
+  std::shared_ptr<ObservableRuntimeVars::CallbackHandle> handle_;
+};
+
+} // mcrouter
+} // memcache
+} // facebook
@@ -46,6 +46,8 @@ namespace mcrouter {
  * hash is within settings range
  * Key range might be updated at runtime.
  * We can shadow to multiple shadow destinations for a given normal route.
+ * Shadow requests are scaled down when the proxy is under pressure
+ * (see ProxyBase::shouldShedShadowRequest()).
  */
 template <class RouterInfo, class ShadowPolicy>
 class ShadowRoute {
@@ -145,7 +147,13 @@ class ShadowRoute {
       return settings->shouldShadowKey(req);
     }
 
-    return settings->shouldShadow(req, ctx->proxy().randomGenerator());
+    if (!settings->shouldShadow(req, ctx->proxy().randomGenerator())) {
+      return false;
+    }
+
+    // Checked last (and before the request is copied) so that only requests
+    // that would actually be shadowed are counted as shed.
+    return !ctx->proxy().shouldShedShadowRequest();
   }
 
   template <class Request>
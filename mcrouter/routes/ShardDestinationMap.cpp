@@ -0,0 +1,108 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include "ShardDestinationMap.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "mcrouter/lib/fbi/cpp/util.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+constexpr uint32_t ShardDestinationMap::kNotFound;
+
+void ShardDestinationMap::set(uint32_t shard, uint32_t destination) {
+  checkLogic(!frozen_, "ShardDestinationMap: set() after freeze()");
+  checkLogic(
+      destination != kNotFound,
+      "ShardDestinationMap: invalid destination {}",
+      destination);
+  pending_[shard] = destination;
+}
+
+void ShardDestinationMap::freeze() {
+  if (frozen_) {
+    return;
+  }
+  frozen_ = true;
+  size_ = pending_.size();
+
+  uint64_t maxShard = 0;
+  for (const auto& it : pending_) {
+    maxShard = std::max<uint64_t>(maxShard, it.first);
+  }
+
+  // The dense array takes 4 bytes per possible shard id, the sparse layout
+  // about 11 bytes per shard.
+  const size_t n = pending_.size();
+  dense_ = n == 0 || maxShard < 2 * n + n / 2;
+  if (dense_) {
+    destinations_.assign(n == 0 ? 0 : maxShard + 1, kNotFound);
+    for (const auto& it : pending_) {
+      destinations_[it.first] = it.second;
+    }
+    decltype(pending_)().swap(pending_);
+    return;
+  }
+
+  // Buckets of 4 keys on average, placed biggest first into 1.25n slots.
+  displacements_.assign(std::max<size_t>(n / 4, 1), 0);
+  slots_.assign(n + n / 4 + 1, Entry{0, kNotFound});
+
+  std::vector<std::vector<std::pair<uint32_t, uint32_t>>> buckets(
+      displacements_.size());
+  for (const auto& it : pending_) {
+    auto hash = folly::hash::twang_mix64(it.first);
+    buckets[reduce(hash >> 32, buckets.size())].push_back(it);
+  }
+  decltype(pending_)().swap(pending_);
+
+  std::vector<uint32_t> order(buckets.size());
+  for (size_t b = 0; b < buckets.size(); ++b) {
+    order[b] = b;
+  }
+  std::sort(order.begin(), order.end(), [&buckets](uint32_t a, uint32_t b) {
+    return buckets[a].size() > buckets[b].size();
+  });
+
+  std::vector<uint32_t> candidate;
+  for (auto b : order) {
+    const auto& bucket = buckets[b];
+    if (bucket.empty()) {
+      break;
+    }
+    // Shard ids are distinct and so are their hashes, there is always a
+    // displacement that separates them; it takes a few hundred attempts at
+    // most in practice.
+    for (uint32_t disp = 0;; ++disp) {
+      candidate.clear();
+      for (const auto& it : bucket) {
+        auto s = slot(folly::hash::twang_mix64(it.first), disp);
+        if (slots_[s].destination != kNotFound ||
+            std::find(candidate.begin(), candidate.end(), s) !=
+                candidate.end()) {
+          break;
+        }
+        candidate.push_back(s);
+      }
+      if (candidate.size() == bucket.size()) {
+        displacements_[b] = disp;
+        break;
+      }
+    }
+    for (size_t k = 0; k < bucket.size(); ++k) {
+      slots_[candidate[k]] = Entry{bucket[k].first, bucket[k].second};
+    }
+  }
+}
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
@@ -0,0 +1,123 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+#include <folly/hash/Hash.h>
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Read-only map shardId -> destinationId, for ShardSelectors that handle
+ * large or sparse shard ids.
+ *
+ * The map is filled with set() and then frozen with freeze(), which picks
+ * the layout by density:
+ *  - dense: an array indexed by shard id, if the ids are compact enough
+ *    for it to be no bigger than the sparse layout;
+ *  - sparse: a minimal perfect hash ("hash and displace") of the shard
+ *    ids into a table of (shard, destination) pairs with a load factor of
+ *    0.8, about 11 bytes per shard.
+ * Unlike std::unordered_map there are no per-entry allocations, no
+ * probing, and a lookup touches two cache lines at most.
+ */
+class ShardDestinationMap {
+ public:
+  static constexpr uint32_t kNotFound = std::numeric_limits<uint32_t>::max();
+
+  ShardDestinationMap() = default;
+
+  /**
+   * Maps shard to destination, overriding the previous mapping.
+   * Only valid before freeze().
+   */
+  void set(uint32_t shard, uint32_t destination);
+
+  /**
+   * Only valid before freeze().
+   */
+  bool contains(uint32_t shard) const {
+    return pending_.find(shard) != pending_.end();
+  }
+
+  /**
+   * Builds the lookup layout. No-op if already frozen.
+   */
+  void freeze();
+
+  /**
+   * @return destination of shard, or kNotFound. Only valid after freeze().
+   */
+  uint32_t find(uint32_t shard) const {
+    if (dense_) {
+      return shard < destinations_.size() ? destinations_[shard] : kNotFound;
+    }
+    const uint64_t hash = folly::hash::twang_mix64(shard);
+    const auto disp = displacements_[reduce(hash >> 32, displacements_.size())];
+    const auto& entry = slots_[slot(hash, disp)];
+    return entry.shard == shard ? entry.destination : kNotFound;
+  }
+
+  /**
+   * @return number of mapped shards.
+   */
+  size_t size() const {
+    return size_;
+  }
+
+  bool isDense() const {
+    return dense_;
+  }
+
+  /**
+   * @return bytes used by the lookup layout.
+   */
+  size_t memoryUsage() const {
+    return destinations_.capacity() * sizeof(uint32_t) +
+        displacements_.capacity() * sizeof(uint32_t) +
+        slots_.capacity() * sizeof(Entry);
+  }
+
+ private:
+  struct Entry {
+    uint32_t shard;
+    // kNotFound for unused slots.
+    uint32_t destination;
+  };
+
+  // Mappings added before freeze().
+  std::unordered_map<uint32_t, uint32_t> pending_;
+  bool frozen_{false};
+  bool dense_{true};
+  size_t size_{0};
+  // Dense layout: destinations by shard id.
+  std::vector<uint32_t> destinations_;
+  // Sparse layout: per bucket displacements and the hash table.
+  std::vector<uint32_t> displacements_;
+  std::vector<Entry> slots_;
+
+  // Maps a 32-bit hash to [0, n) without a division.
+  static uint32_t reduce(uint32_t hash, size_t n) {
+    return (static_cast<uint64_t>(hash) * n) >> 32;
+  }
+
+  uint32_t slot(uint64_t hash, uint32_t displacement) const {
+    return reduce(folly::hash::twang_mix64(hash + displacement), slots_.size());
+  }
+};
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
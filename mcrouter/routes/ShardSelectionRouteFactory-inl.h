@@ -13,6 +13,7 @@
 #include "mcrouter/routes/ErrorRoute.h"
 #include "mcrouter/routes/LatestRoute.h"
 #include "mcrouter/routes/LoadBalancerRoute.h"
+#include "mcrouter/routes/ShardDestinationMap.h"
 
 namespace facebook {
 namespace memcache {
@@ -61,6 +62,12 @@ inline std::unordered_map<uint32_t, uint32_t> prepareMap(
     size_t /* maxShardId */) {
   return std::unordered_map<uint32_t, uint32_t>(numDistinctShards);
 }
+template <>
+inline ShardDestinationMap prepareMap(
+    size_t /* numDistinctShards */,
+    size_t /* maxShardId */) {
+  return ShardDestinationMap();
+}
 
 inline bool containsShard(const std::vector<uint16_t>& vec, size_t shard) {
   return vec.at(shard) != std::numeric_limits<uint16_t>::max();
@@ -70,6 +77,27 @@ inline bool containsShard(
     size_t shard) {
   return (map.find(shard) != map.end());
 }
+inline bool containsShard(const ShardDestinationMap& map, size_t shard) {
+  return map.contains(shard);
+}
+
+template <class MapType>
+void setShard(MapType& map, size_t shard, size_t destination) {
+  map[shard] = destination;
+}
+inline void
+setShard(ShardDestinationMap& map, size_t shard, size_t destination) {
+  map.set(shard, destination);
+}
+
+/**
+ * Called once all shards are set, before the map is handed to a selector.
+ */
+template <class MapType>
+void finalizeMap(MapType& /* map */) {}
+inline void finalizeMap(ShardDestinationMap& map) {
+  map.freeze();
+}
 
 template <class RouterInfo>
 const folly::dynamic& getPoolJson(
@@ -128,16 +156,17 @@ MapType getShardsMap(const folly::dynamic& json, size_t numDestinations) {
     for (size_t j = 0; j < allShards[i].size(); ++j) {
       size_t shard = allShards[i][j];
       if (!containsShard(shardsMap, shard)) {
-        shardsMap[shard] = i;
+        setShard(shardsMap, shard, i);
       } else {
         // Shard is served by two destinations, picking one randomly
         if (folly::Random::oneIn(2)) {
-          shardsMap[shard] = i;
+          setShard(shardsMap, shard, i);
         }
       }
     }
   }
 
+  finalizeMap(shardsMap);
   return shardsMap;
 }
 
@@ -210,7 +239,7 @@ void buildChildrenLatestRoutes(
         std::move(childrenRouteHandles),
         options,
         std::vector<double>(numChildren, 1.0)));
-    shardToDestinationIndexMap[shardId] = destinations.size() - 1;
+    setShard(shardToDestinationIndexMap, shardId, destinations.size() - 1);
   });
 }
 
@@ -228,7 +257,7 @@ void buildChildrenLoadBalancerRoutes(
     auto childrenRouteHandles = std::move(item.second);
     destinations.push_back(createLoadBalancerRoute<RouterInfo>(
         std::move(childrenRouteHandles), options));
-    shardToDestinationIndexMap[shardId] = destinations.size() - 1;
+    setShard(shardToDestinationIndexMap, shardId, destinations.size() - 1);
   });
 }
 
@@ -327,6 +356,7 @@ typename RouterInfo::RouteHandlePtr createEagerShardSelectionRoute(
         childrenType);
   }
 
+  detail::finalizeMap(shardToDestinationIndexMap);
   ShardSelector selector(std::move(shardToDestinationIndexMap));
 
   typename RouterInfo::RouteHandlePtr outOfRangeDestination = nullptr;
@@ -67,6 +67,10 @@ namespace mcrouter {
  *                       accepts a MapType shardsMap that maps
  *                       shardId -> destinationId.
  * @tparam MapType       C++ type container that maps shardId -> destinationId.
+ *                       One of std::vector<uint16_t> (indexed by shard id),
+ *                       std::unordered_map<uint32_t, uint32_t> or
+ *                       ShardDestinationMap (picks a dense array or a perfect
+ *                       hash by density; use it for large, sparse shard ids).
  *
  * @param factory               RouteHandleFactory to create destinations.
  * @param json                  JSON object with RouteHandle representation.
@@ -117,7 +121,8 @@ typename RouterInfo::RouteHandlePtr createShardSelectionRoute(
  *                       for handling the request. The ShardSelector constructor
  *                       accepts a shardsMap (unordered_map) that maps
  *                       shardId -> destinationId.
- * @tparam MapType       C++ type container that maps shardId -> destinationId.
+ * @tparam MapType       C++ type container that maps shardId -> destinationId,
+ *                       see createShardSelectionRoute.
  *
  * @param factory               RouteHandleFactory to create destinations.
  * @param json                  JSON object with RouteHandle representation.
@@ -7,8 +7,15 @@
  */
 #include "ShardSplitter.h"
 
+#include <algorithm>
+
+#include <folly/Bits.h>
+#include <folly/Conv.h>
 #include <folly/dynamic.h>
+#include <folly/experimental/FunctionScheduler.h>
+#include <folly/hash/SpookyHashV2.h>
 
+#include "mcrouter/lib/SharedImmutable.h"
 #include "mcrouter/lib/fbi/cpp/globals.h"
 #include "mcrouter/lib/fbi/cpp/util.h"
 #include "mcrouter/routes/ShardHashFunc.h"
@@ -40,34 +47,65 @@ size_t checkShardSplitSize(
   }
   return static_cast<size_t>(split);
 }
+
+uint64_t hashShard(folly::StringPiece shard) {
+  return folly::hash::SpookyHashV2::Hash64(shard.data(), shard.size(), 0);
+}
+
+std::string switchFunctionName() {
+  static std::atomic<uint64_t> uniqueId(0);
+  return folly::to<std::string>(
+      "shard-split-migration-", uniqueId.fetch_add(1));
+}
 } // anonymous
 
-size_t ShardSplitter::ShardSplitInfo::getSplitSizeForCurrentHost() const {
-  if (migrating_) {
-    auto now = std::chrono::system_clock::now();
-    if (now < startTime_) {
-      return oldSplitSize_;
-    } else if (now > startTime_ + migrationPeriod_) {
-      migrating_ = false;
-      return newSplitSize_;
-    } else {
-      double point = std::chrono::duration_cast<std::chrono::duration<double>>(
-                         now - startTime_)
-                         .count() /
-          migrationPeriod_.count();
-      return globals::hostid() % kHostIdModulo /
-                  static_cast<double>(kHostIdModulo) <
-              point
-          ? newSplitSize_
-          : oldSplitSize_;
-    }
+ShardSplitter::ShardSplitInfo::ShardSplitInfo(
+    size_t oldSplitSize,
+    size_t newSplitSize,
+    std::chrono::system_clock::time_point startTime,
+    std::chrono::duration<double> migrationPeriod,
+    bool fanoutDeletes)
+    : oldSplitSize_(oldSplitSize),
+      newSplitSize_(newSplitSize),
+      startTime_(startTime),
+      migrationPeriod_(migrationPeriod),
+      // Hosts move to the new split size in order of their hostid, spread
+      // evenly over the migration period.
+      switchTime_(
+          startTime +
+          std::chrono::duration_cast<std::chrono::system_clock::duration>(
+              migrationPeriod * (globals::hostid() % kHostIdModulo) /
+              static_cast<double>(kHostIdModulo))),
+      fanoutDeletes_(fanoutDeletes),
+      phase_(Phase::Migrating) {}
+
+size_t ShardSplitter::ShardSplitInfo::checkMigration(
+    std::chrono::system_clock::time_point now) const {
+  if (now > switchTime_) {
+    phase_.store(Phase::New, std::memory_order_relaxed);
+    return newSplitSize_;
   }
-  return newSplitSize_;
+  return oldSplitSize_;
 }
 
-ShardSplitter::ShardSplitter(const folly::dynamic& json) {
+ShardSplitter::ShardSplitter(
+    const folly::dynamic& json,
+    const std::shared_ptr<folly::FunctionScheduler>& functionScheduler)
+    : table_(getSharedImmutable<Table>(
+          folly::dynamic::array(
+              "ShardSplitter",
+              json,
+              reinterpret_cast<int64_t>(functionScheduler.get())),
+          [&]() { return buildTable(json, functionScheduler); })) {}
+
+std::shared_ptr<const ShardSplitter::Table> ShardSplitter::buildTable(
+    const folly::dynamic& json,
+    const std::shared_ptr<folly::FunctionScheduler>& functionScheduler) {
   checkLogic(json.isObject(), "ShardSplitter: config is not an object");
 
+  auto table = std::make_shared<Table>();
+  auto& shardSplits = table->shardSplits;
+
   auto now = std::chrono::system_clock::now();
   for (const auto& it : json.items()) {
     checkLogic(
@@ -83,7 +121,7 @@ ShardSplitter::ShardSplitter(const folly::dynamic& json) {
     if (it.second.isInt()) {
       auto splitCnt = checkShardSplitSize(shardId, it.second, "shard_splits");
       if (splitCnt != 1) {
-        shardSplits_.emplace(it.first.c_str(), ShardSplitInfo(splitCnt));
+        shardSplits.emplace(it.first.c_str(), ShardSplitInfo(splitCnt));
       }
     } else if (it.second.isObject()) {
       auto oldSplitJson = it.second.getDefault("old_split_size", 1);
@@ -120,11 +158,11 @@ ShardSplitter::ShardSplitter(const folly::dynamic& json) {
           "ShardSplitter: fanout_deletes is not bool for {}",
           shardId);
       if (now > startTime + migrationPeriod || newSplit == oldSplit) {
-        shardSplits_.emplace(
+        shardSplits.emplace(
             shardId.str(),
             ShardSplitInfo(newSplit, fanoutDeletesJson.asBool()));
       } else {
-        shardSplits_.emplace(
+        shardSplits.emplace(
             shardId.str(),
             ShardSplitInfo(
                 oldSplit,
@@ -135,6 +173,82 @@ ShardSplitter::ShardSplitter(const folly::dynamic& json) {
       }
     }
   }
+
+  buildIndex(*table);
+
+  if (functionScheduler) {
+    for (const auto& it : shardSplits) {
+      const auto& split = it.second;
+      if (split.phase_.load() != ShardSplitInfo::Phase::Migrating) {
+        continue;
+      }
+      if (now > split.switchTime_) {
+        split.phase_.store(ShardSplitInfo::Phase::New);
+      } else {
+        split.phase_.store(ShardSplitInfo::Phase::Old);
+        table->pendingSwitches.push_back(&split);
+      }
+    }
+    std::sort(
+        table->pendingSwitches.begin(),
+        table->pendingSwitches.end(),
+        [](const ShardSplitInfo* a, const ShardSplitInfo* b) {
+          return a->switchTime_ < b->switchTime_;
+        });
+  }
+  if (!table->pendingSwitches.empty()) {
+    scheduleSwitches(table, functionScheduler, 0);
+  }
+  return table;
+}
+
+void ShardSplitter::buildIndex(Table& table) {
+  table.index.assign(
+      folly::nextPowTwo(2 * table.shardSplits.size() + 1),
+      Table::Slot{0, folly::StringPiece(), nullptr});
+  const size_t mask = table.index.size() - 1;
+  for (const auto& it : table.shardSplits) {
+    auto hash = hashShard(it.first);
+    auto pos = hash & mask;
+    while (table.index[pos].split != nullptr) {
+      pos = (pos + 1) & mask;
+    }
+    table.index[pos] = Table::Slot{hash, it.first, &it.second};
+  }
+}
+
+void ShardSplitter::scheduleSwitches(
+    std::shared_ptr<const Table> table,
+    std::shared_ptr<folly::FunctionScheduler> functionScheduler,
+    size_t next) {
+  const auto& pending = table->pendingSwitches;
+  auto now = std::chrono::system_clock::now();
+  while (next < pending.size() && now > pending[next]->switchTime_) {
+    pending[next]->phase_.store(
+        ShardSplitInfo::Phase::New, std::memory_order_relaxed);
+    ++next;
+  }
+  if (next == pending.size()) {
+    return;
+  }
+
+  auto delay = std::chrono::duration_cast<std::chrono::milliseconds>(
+                   pending[next]->switchTime_ - now) +
+      std::chrono::milliseconds(1);
+  // Timers don't keep the table or the scheduler alive: a timer firing
+  // after its config is gone does nothing.
+  std::weak_ptr<const Table> weakTable(table);
+  std::weak_ptr<folly::FunctionScheduler> weakScheduler(functionScheduler);
+  functionScheduler->addFunctionOnce(
+      [weakTable, weakScheduler, next]() {
+        auto table = weakTable.lock();
+        auto scheduler = weakScheduler.lock();
+        if (table && scheduler) {
+          scheduleSwitches(std::move(table), std::move(scheduler), next);
+        }
+      },
+      switchFunctionName(),
+      delay);
 }
 
 const ShardSplitter::ShardSplitInfo* ShardSplitter::getShardSplit(
@@ -144,11 +258,16 @@ const ShardSplitter::ShardSplitInfo* ShardSplitter::getShardSplit(
     return nullptr;
   }
 
-  auto splitIt = shardSplits_.find(shard);
-  if (splitIt == shardSplits_.end()) {
-    return nullptr;
+  const auto& index = table_->index;
+  const size_t mask = index.size() - 1;
+  const auto hash = hashShard(shard);
+  for (auto pos = hash & mask; index[pos].split != nullptr;
+       pos = (pos + 1) & mask) {
+    if (index[pos].hash == hash && index[pos].shard == shard) {
+      return index[pos].split;
+    }
   }
-  return &splitIt->second;
+  return nullptr;
 }
 
 } // mcrouter
@@ -7,7 +7,10 @@
  */
 #pragma once
 
+#include <atomic>
 #include <chrono>
+#include <memory>
+#include <vector>
 
 #include <folly/Range.h>
 #include <folly/experimental/StringKeyedUnorderedMap.h>
@@ -16,6 +19,7 @@
 
 namespace folly {
 struct dynamic;
+class FunctionScheduler;
 } // folly
 
 namespace facebook {
@@ -31,20 +35,23 @@ class ShardSplitter {
           newSplitSize_(splits),
           migrationPeriod_{0},
           fanoutDeletes_(fanoutDeletes),
-          migrating_(false) {}
+          phase_(Phase::New) {}
 
     ShardSplitInfo(
         size_t oldSplitSize,
         size_t newSplitSize,
         std::chrono::system_clock::time_point startTime,
         std::chrono::duration<double> migrationPeriod,
-        bool fanoutDeletes)
-        : oldSplitSize_(oldSplitSize),
-          newSplitSize_(newSplitSize),
-          startTime_(startTime),
-          migrationPeriod_(migrationPeriod),
-          fanoutDeletes_(fanoutDeletes),
-          migrating_(true) {}
+        bool fanoutDeletes);
+
+    ShardSplitInfo(const ShardSplitInfo& other)
+        : oldSplitSize_(other.oldSplitSize_),
+          newSplitSize_(other.newSplitSize_),
+          startTime_(other.startTime_),
+          migrationPeriod_(other.migrationPeriod_),
+          switchTime_(other.switchTime_),
+          fanoutDeletes_(other.fanoutDeletes_),
+          phase_(other.phase_.load(std::memory_order_relaxed)) {}
 
     bool fanoutDeletesEnabled() const {
       return fanoutDeletes_;
@@ -55,18 +62,55 @@ class ShardSplitter {
     size_t getNewSplitSize() const {
       return newSplitSize_;
     }
-    size_t getSplitSizeForCurrentHost() const;
+    size_t getSplitSizeForCurrentHost() const {
+      switch (phase_.load(std::memory_order_relaxed)) {
+        case Phase::New:
+          return newSplitSize_;
+        case Phase::Old:
+          return oldSplitSize_;
+        case Phase::Migrating:
+          break;
+      }
+      return checkMigration(std::chrono::system_clock::now());
+    }
 
    private:
+    enum class Phase : uint8_t {
+      // Migrating, the current host's split size depends on the time.
+      Migrating,
+      // The current host uses the old split size until a timer moves it
+      // into the New phase at switchTime_.
+      Old,
+      // The current host uses the new split size.
+      New,
+    };
+
     const size_t oldSplitSize_;
     const size_t newSplitSize_;
     const std::chrono::system_clock::time_point startTime_;
     const std::chrono::duration<double> migrationPeriod_;
+    // Point of the migration at which the current host switches to the new
+    // split size.
+    const std::chrono::system_clock::time_point switchTime_;
     const bool fanoutDeletes_;
-    mutable bool migrating_;
+    mutable std::atomic<Phase> phase_;
+
+    size_t checkMigration(std::chrono::system_clock::time_point now) const;
+
+    friend class ShardSplitter;
   };
 
-  explicit ShardSplitter(const folly::dynamic& json);
+  /**
+   * @param json  Shard splits config.
+   * @param functionScheduler  If set, migration phases of the current host
+   *                           are switched by timers on this scheduler, and
+   *                           getSplitSizeForCurrentHost() never reads the
+   *                           clock.
+   */
+  explicit ShardSplitter(
+      const folly::dynamic& json,
+      const std::shared_ptr<folly::FunctionScheduler>& functionScheduler =
+          nullptr);
 
   /**
    * Returns information about shard split if it exists. If it does, stores
@@ -80,11 +124,42 @@ class ShardSplitter {
       folly::StringPiece& shardId) const;
 
   const folly::StringKeyedUnorderedMap<ShardSplitInfo>& getShardSplits() const {
-    return shardSplits_;
+    return table_->shardSplits;
   }
 
  private:
-  folly::StringKeyedUnorderedMap<ShardSplitInfo> shardSplits_;
+  /**
+   * Immutable after construction, shared by copies of the splitter and,
+   * weakly, by the migration timers.
+   */
+  struct Table {
+    folly::StringKeyedUnorderedMap<ShardSplitInfo> shardSplits;
+    // Open addressing index over shardSplits, at most half full.
+    struct Slot {
+      uint64_t hash;
+      folly::StringPiece shard;
+      // nullptr for empty slots.
+      const ShardSplitInfo* split;
+    };
+    std::vector<Slot> index;
+    // Splits in the Old phase, by switch time.
+    std::vector<const ShardSplitInfo*> pendingSwitches;
+  };
+
+  std::shared_ptr<const Table> table_;
+
+  /**
+   * Tables are shared by all splitters built from the same config (e.g. by
+   * every proxy's route tree), see getSharedImmutable().
+   */
+  static std::shared_ptr<const Table> buildTable(
+      const folly::dynamic& json,
+      const std::shared_ptr<folly::FunctionScheduler>& functionScheduler);
+  static void buildIndex(Table& table);
+  static void scheduleSwitches(
+      std::shared_ptr<const Table> table,
+      std::shared_ptr<folly::FunctionScheduler> functionScheduler,
+      size_t next);
 };
 } // mcrouter
 } // memcache
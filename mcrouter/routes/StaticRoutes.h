@@ -0,0 +1,365 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <cassert>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <folly/Conv.h>
+#include <folly/dynamic.h>
+
+#include "mcrouter/lib/Ch3HashFunc.h"
+#include "mcrouter/lib/FailoverErrorsSettings.h"
+#include "mcrouter/lib/HashSelector.h"
+#include "mcrouter/lib/RouteHandleTraverser.h"
+#include "mcrouter/lib/carbon/RequestReplyUtil.h"
+#include "mcrouter/lib/carbon/TypeList.h"
+#include "mcrouter/lib/config/RouteHandleFactory.h"
+#include "mcrouter/lib/fbi/cpp/util.h"
+#include "mcrouter/routes/DestinationRoute.h"
+
+/**
+ * Building blocks for route trees whose shape is fixed at compile time and
+ * only the host lists come from the config.
+ *
+ * A static route holds its children by value, with their concrete types, so
+ * the calls between levels are direct and can be inlined; the tree is
+ * wrapped in a single RouteHandle by makeStaticRoute(). E.g.
+ *
+ *   using EdgeRoute = StaticOperationSelectorRoute<
+ *       McrouterRouterInfo,
+ *       carbon::List<McGetRequest>,
+ *       StaticFailoverRoute<
+ *           McrouterRouterInfo,
+ *           StaticHashRoute<McrouterRouterInfo, StaticChildRoute<...>>>,
+ *       StaticChildRoute<McrouterRouterInfo>>;
+ *
+ *   {"EdgeRoute", &makeStaticRoute<McrouterRouterInfo, EdgeRoute>}
+ *
+ * registered in the RouteHandleFactoryMap, can then be configured as
+ *
+ *   {
+ *     "type": "EdgeRoute",
+ *     "selected": {
+ *       "children": [ {"children": "Pool|A"}, {"children": "Pool|B"} ]
+ *     },
+ *     "default_policy": "PoolRoute|A"
+ *   }
+ *
+ * where the "children" of StaticHashRoutes are the pools' host lists.
+ */
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Leaf of a static route tree: any route handle created by the factory.
+ * Handles of type RouterInfo::RouteHandle<Leaf> (destinations by default)
+ * are called directly, other handles through the virtual interface.
+ */
+template <class RouterInfo, class Leaf = DestinationRoute<RouterInfo>>
+class StaticChildRoute {
+ private:
+  using RouteHandleIf = typename RouterInfo::RouteHandleIf;
+  using RouteHandlePtr = typename RouterInfo::RouteHandlePtr;
+  using LeafHandle = typename RouterInfo::template RouteHandle<Leaf>;
+
+ public:
+  static StaticChildRoute create(
+      RouteHandleFactory<RouteHandleIf>& factory,
+      const folly::dynamic& json) {
+    auto rh = factory.create(json);
+    checkLogic(rh != nullptr, "StaticChildRoute: can't create child");
+    return StaticChildRoute(std::move(rh));
+  }
+
+  static std::vector<StaticChildRoute> createList(
+      RouteHandleFactory<RouteHandleIf>& factory,
+      const folly::dynamic& json) {
+    std::vector<StaticChildRoute> children;
+    for (auto& rh : factory.createList(json)) {
+      children.emplace_back(std::move(rh));
+    }
+    return children;
+  }
+
+  explicit StaticChildRoute(RouteHandlePtr rh)
+      : rh_(std::move(rh)), leaf_(dynamic_cast<LeafHandle*>(rh_.get())) {
+    assert(rh_);
+  }
+
+  std::string routeName() const {
+    return rh_->routeName();
+  }
+
+  template <class Request>
+  void traverse(
+      const Request& req,
+      const RouteHandleTraverser<RouteHandleIf>& t) const {
+    t(*rh_, req);
+  }
+
+  template <class Request>
+  ReplyT<Request> route(const Request& req) const {
+    // LeafHandle::route() is final, so this call is not virtual.
+    return leaf_ ? leaf_->route(req) : rh_->route(req);
+  }
+
+ private:
+  RouteHandlePtr rh_;
+  LeafHandle* leaf_;
+};
+
+namespace detail {
+
+template <class Child>
+struct StaticListCreator {
+  template <class RouteHandleIf>
+  static std::vector<Child> create(
+      RouteHandleFactory<RouteHandleIf>& factory,
+      const folly::dynamic& json) {
+    checkLogic(json.isArray(), "Static route: children is not an array");
+    std::vector<Child> children;
+    for (const auto& jchild : json) {
+      children.push_back(Child::create(factory, jchild));
+    }
+    return children;
+  }
+};
+
+// Leaves also accept pools ("Pool|name" or pool objects).
+template <class RouterInfo, class Leaf>
+struct StaticListCreator<StaticChildRoute<RouterInfo, Leaf>> {
+  template <class RouteHandleIf>
+  static std::vector<StaticChildRoute<RouterInfo, Leaf>> create(
+      RouteHandleFactory<RouteHandleIf>& factory,
+      const folly::dynamic& json) {
+    return StaticChildRoute<RouterInfo, Leaf>::createList(factory, json);
+  }
+};
+
+template <class Child, class RouteHandleIf>
+std::vector<Child> createStaticChildren(
+    RouteHandleFactory<RouteHandleIf>& factory,
+    const folly::dynamic& json,
+    folly::StringPiece routeName) {
+  checkLogic(json.isObject(), "{}: config is not an object", routeName);
+  auto jchildren = json.get_ptr("children");
+  checkLogic(jchildren != nullptr, "{}: 'children' not found", routeName);
+  auto children = StaticListCreator<Child>::create(factory, *jchildren);
+  checkLogic(!children.empty(), "{}: no children", routeName);
+  return children;
+}
+
+} // detail
+
+/**
+ * Sends to one of the children by hash of the routing key, like HashRoute.
+ * HashFunc has to be constructible from the number of children.
+ *
+ * Config: {"children": ..., "salt": "..."}
+ */
+template <class RouterInfo, class Child, class HashFunc = Ch3HashFunc>
+class StaticHashRoute {
+ private:
+  using RouteHandleIf = typename RouterInfo::RouteHandleIf;
+
+ public:
+  static StaticHashRoute create(
+      RouteHandleFactory<RouteHandleIf>& factory,
+      const folly::dynamic& json) {
+    auto children = detail::createStaticChildren<Child>(
+        factory, json, "StaticHashRoute");
+    std::string salt;
+    if (auto jsalt = json.get_ptr("salt")) {
+      checkLogic(jsalt->isString(), "StaticHashRoute: salt is not a string");
+      salt = jsalt->getString();
+    }
+    return StaticHashRoute(std::move(children), std::move(salt));
+  }
+
+  StaticHashRoute(std::vector<Child> children, std::string salt)
+      : children_(std::move(children)),
+        selector_(std::move(salt), HashFunc(children_.size())) {
+    assert(!children_.empty());
+  }
+
+  std::string routeName() const {
+    return folly::to<std::string>("static-", selector_.type());
+  }
+
+  template <class Request>
+  void traverse(
+      const Request& req,
+      const RouteHandleTraverser<RouteHandleIf>& t) const {
+    children_[selector_.select(req, children_.size())].traverse(req, t);
+  }
+
+  template <class Request>
+  ReplyT<Request> route(const Request& req) const {
+    return children_[selector_.select(req, children_.size())].route(req);
+  }
+
+ private:
+  std::vector<Child> children_;
+  HashSelector<HashFunc> selector_;
+};
+
+/**
+ * Sends to the children in order until a reply is not a failover error
+ * (according to "failover_errors", like FailoverRoute), and returns the
+ * last reply. Unlike FailoverRoute there is no failover rate limiting,
+ * tagging, lease pairing or failover stats.
+ *
+ * Config: {"children": [...], "failover_errors": ...}
+ */
+template <class RouterInfo, class Child>
+class StaticFailoverRoute {
+ private:
+  using RouteHandleIf = typename RouterInfo::RouteHandleIf;
+
+ public:
+  static StaticFailoverRoute create(
+      RouteHandleFactory<RouteHandleIf>& factory,
+      const folly::dynamic& json) {
+    auto children = detail::createStaticChildren<Child>(
+        factory, json, "StaticFailoverRoute");
+    FailoverErrorsSettings failoverErrors;
+    if (auto jFailoverErrors = json.get_ptr("failover_errors")) {
+      failoverErrors = FailoverErrorsSettings(*jFailoverErrors);
+    }
+    return StaticFailoverRoute(std::move(children), std::move(failoverErrors));
+  }
+
+  StaticFailoverRoute(
+      std::vector<Child> children,
+      FailoverErrorsSettings failoverErrors = FailoverErrorsSettings())
+      : children_(std::move(children)),
+        failoverErrors_(std::move(failoverErrors)) {
+    assert(!children_.empty());
+  }
+
+  std::string routeName() const {
+    return "static-failover";
+  }
+
+  template <class Request>
+  void traverse(
+      const Request& req,
+      const RouteHandleTraverser<RouteHandleIf>& t) const {
+    for (const auto& child : children_) {
+      child.traverse(req, t);
+    }
+  }
+
+  template <class Request>
+  ReplyT<Request> route(const Request& req) const {
+    auto reply = children_[0].route(req);
+    for (size_t i = 1; i < children_.size() &&
+         failoverErrors_.shouldFailover(reply, req) !=
+             FailoverErrorsSettingsBase::FailoverType::NONE;
+         ++i) {
+      reply = children_[i].route(req);
+    }
+    return reply;
+  }
+
+ private:
+  std::vector<Child> children_;
+  FailoverErrorsSettings failoverErrors_;
+};
+
+/**
+ * Sends requests of the types in SelectedRequests (a carbon::List) to
+ * Selected and everything else to Default; the choice is made at compile
+ * time.
+ *
+ * Config: {"selected": ..., "default_policy": ...}
+ */
+template <
+    class RouterInfo,
+    class SelectedRequests,
+    class Selected,
+    class Default>
+class StaticOperationSelectorRoute {
+ private:
+  using RouteHandleIf = typename RouterInfo::RouteHandleIf;
+
+  template <class Request>
+  using IsSelected = std::integral_constant<
+      bool,
+      carbon::ListContains<SelectedRequests, Request>::value>;
+
+ public:
+  static StaticOperationSelectorRoute create(
+      RouteHandleFactory<RouteHandleIf>& factory,
+      const folly::dynamic& json) {
+    checkLogic(
+        json.isObject(),
+        "StaticOperationSelectorRoute: config is not an object");
+    auto jselected = json.get_ptr("selected");
+    auto jdefault = json.get_ptr("default_policy");
+    checkLogic(
+        jselected && jdefault,
+        "StaticOperationSelectorRoute needs 'selected' and 'default_policy'");
+    return StaticOperationSelectorRoute(
+        Selected::create(factory, *jselected),
+        Default::create(factory, *jdefault));
+  }
+
+  StaticOperationSelectorRoute(Selected selected, Default defaultPolicy)
+      : selected_(std::move(selected)),
+        defaultPolicy_(std::move(defaultPolicy)) {}
+
+  std::string routeName() const {
+    return "static-operation-selector";
+  }
+
+  template <class Request>
+  void traverse(
+      const Request& req,
+      const RouteHandleTraverser<RouteHandleIf>& t) const {
+    target(IsSelected<Request>()).traverse(req, t);
+  }
+
+  template <class Request>
+  ReplyT<Request> route(const Request& req) const {
+    return target(IsSelected<Request>()).route(req);
+  }
+
+ private:
+  Selected selected_;
+  Default defaultPolicy_;
+
+  const Selected& target(std::true_type) const {
+    return selected_;
+  }
+  const Default& target(std::false_type) const {
+    return defaultPolicy_;
+  }
+};
+
+/**
+ * Builds a static route tree from json and wraps it into a single route
+ * handle. Has the signature of a RouteHandleFactoryMap entry.
+ */
+template <class RouterInfo, class Route>
+typename RouterInfo::RouteHandlePtr makeStaticRoute(
+    RouteHandleFactory<typename RouterInfo::RouteHandleIf>& factory,
+    const folly::dynamic& json) {
+  return std::make_shared<typename RouterInfo::template RouteHandle<Route>>(
+      Route::create(factory, json));
+}
+
+} // mcrouter
+} // memcache
+} // facebook
@@ -10,6 +10,7 @@
 #include <folly/dynamic.h>
 
 #include "mcrouter/config.h"
+#include "mcrouter/lib/config/RouteHandleBuilder.h"
 #include "mcrouter/lib/config/RouteHandleFactory.h"
 #include "mcrouter/routes/McRouteHandleBuilder.h"
 #include "mcrouter/routes/McrouterRouteHandle.h"
@@ -21,14 +22,16 @@ namespace mcrouter {
 McrouterRouteHandlePtr makeWarmUpRoute(
     McrouterRouteHandlePtr warm,
     McrouterRouteHandlePtr cold,
-    folly::Optional<uint32_t> exptime) {
-  return makeMcrouterRouteHandle<WarmUpRoute>(
-      std::move(warm), std::move(cold), std::move(exptime));
+    folly::Optional<uint32_t> exptime,
+    RefillLimiter* refillLimiter) {
+  return makeRouteHandleWithInfo<McrouterRouterInfo, WarmUpRoute>(
+      std::move(warm), std::move(cold), std::move(exptime), refillLimiter);
 }
 
 McrouterRouteHandlePtr makeWarmUpRoute(
     RouteHandleFactory<McrouterRouteHandleIf>& factory,
-    const folly::dynamic& json) {
+    const folly::dynamic& json,
+    RefillLimiter* refillLimiter) {
   checkLogic(json.isObject(), "WarmUpRoute should be object");
   checkLogic(json.count("cold"), "WarmUpRoute: no cold route");
   checkLogic(json.count("warm"), "WarmUpRoute: no warm route");
@@ -50,7 +53,8 @@ McrouterRouteHandlePtr makeWarmUpRoute(
   return makeWarmUpRoute(
       factory.create(json["warm"]),
       factory.create(json["cold"]),
-      std::move(exptime));
+      std::move(exptime),
+      refillLimiter);
 }
 }
 }
@@ -13,9 +13,12 @@
 #include <folly/fibers/FiberManager.h>
 #include <folly/io/IOBuf.h>
 
+#include "mcrouter/McrouterFiberContext.h"
+#include "mcrouter/ProxyRequestContext.h"
 #include "mcrouter/lib/McOperation.h"
 #include "mcrouter/lib/McResUtil.h"
 #include "mcrouter/lib/Operation.h"
+#include "mcrouter/lib/RefillLimiter.h"
 #include "mcrouter/lib/Reply.h"
 #include "mcrouter/lib/RouteHandleTraverser.h"
 #include "mcrouter/lib/fbi/cpp/util.h"
@@ -49,13 +52,21 @@ namespace mcrouter {
  * set/delete/incr/decr/etc.: send to the "cold" route, do not modify "warm".
  *     Client is responsible for "warm" consistency.
  *
+ * If the request deadline has passed by the time "cold" replies, "warm" is
+ * not queried and the "cold" reply is returned as is.
+ *
  * Expiration time (TTL) for automatic warm -> cold update requests is
  * configured with "exptime" field. If the field is not present and
  * "enable_metaget" is true, exptime is fetched from "warm" on every update
  * operation with additional 'metaget' request.
+ *
+ * Asynchronous updates of "cold" go through refillLimiter, if any.
  */
-template <class RouteHandleIf>
+template <class RouterInfo>
 class WarmUpRoute {
+ private:
+  using RouteHandleIf = typename RouterInfo::RouteHandleIf;
+
  public:
   static std::string routeName() {
     return "warm-up";
@@ -72,10 +83,12 @@ class WarmUpRoute {
   WarmUpRoute(
       std::shared_ptr<RouteHandleIf> warm,
       std::shared_ptr<RouteHandleIf> cold,
-      folly::Optional<uint32_t> exptime)
+      folly::Optional<uint32_t> exptime,
+      RefillLimiter* refillLimiter = nullptr)
       : warm_(std::move(warm)),
         cold_(std::move(cold)),
-        exptime_(std::move(exptime)) {
+        exptime_(std::move(exptime)),
+        refillLimiter_(refillLimiter) {
     assert(warm_ != nullptr);
     assert(cold_ != nullptr);
   }
@@ -83,7 +96,7 @@ class WarmUpRoute {
   //////////////////////////////// get /////////////////////////////////////
   McGetReply route(const McGetRequest& req) {
     auto coldReply = cold_->route(req);
-    if (isHitResult(coldReply.result())) {
+    if (isHitResult(coldReply.result()) || deadlineExceeded()) {
       return coldReply;
     }
 
@@ -91,10 +104,10 @@ class WarmUpRoute {
     auto warmReply = warm_->route(req);
     uint32_t exptime = 0;
     if (isHitResult(warmReply.result()) && getExptimeForCold(req, exptime)) {
-      folly::fibers::addTask([
-        cold = cold_,
-        addReq = coldUpdateFromWarm<McAddRequest>(req, warmReply, exptime)
-      ]() { cold->route(addReq); });
+      sendRefill(
+          refillLimiter_,
+          cold_,
+          coldUpdateFromWarm<McAddRequest>(req, warmReply, exptime));
     }
     return warmReply;
   }
@@ -102,7 +115,7 @@ class WarmUpRoute {
   ///////////////////////////////metaget//////////////////////////////////
   McMetagetReply route(const McMetagetRequest& req) {
     auto coldReply = cold_->route(req);
-    if (isHitResult(coldReply.result())) {
+    if (isHitResult(coldReply.result()) || deadlineExceeded()) {
       return coldReply;
     }
     return warm_->route(req);
@@ -112,7 +125,7 @@ class WarmUpRoute {
   McLeaseGetReply route(const McLeaseGetRequest& req) {
     auto coldReply = cold_->route(req);
     if (isHitResult(coldReply.result()) ||
-        isHotMissResult(coldReply.result())) {
+        isHotMissResult(coldReply.result()) || deadlineExceeded()) {
       // in case of a hot miss somebody else will set the value
       return coldReply;
     }
@@ -128,8 +141,7 @@ class WarmUpRoute {
           coldUpdateFromWarm<McLeaseSetRequest>(reqOpGet, warmReply, exptime);
       setReq.leaseToken() = coldReply.leaseToken();
 
-      folly::fibers::addTask(
-          [ cold = cold_, req = std::move(setReq) ]() { cold->route(req); });
+      sendRefill(refillLimiter_, cold_, std::move(setReq));
       // On hit, no need to copy appSpecificErrorCode or message
       McLeaseGetReply reply(warmReply.result());
       reply.flags() = warmReply.flags();
@@ -142,7 +154,7 @@ class WarmUpRoute {
   ////////////////////////////////gets////////////////////////////////////
   McGetsReply route(const McGetsRequest& req) {
     auto coldReply = cold_->route(req);
-    if (isHitResult(coldReply.result())) {
+    if (isHitResult(coldReply.result()) || deadlineExceeded()) {
       return coldReply;
     }
 
@@ -171,6 +183,11 @@ class WarmUpRoute {
   const std::shared_ptr<RouteHandleIf> warm_;
   const std::shared_ptr<RouteHandleIf> cold_;
   const folly::Optional<uint32_t> exptime_;
+  RefillLimiter* const refillLimiter_;
+
+  static bool deadlineExceeded() {
+    return fiber_local<RouterInfo>::deadlineExceeded();
+  }
 
   template <class ToRequest, class Request, class Reply>
   static ToRequest coldUpdateFromWarm(
@@ -0,0 +1,138 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include <folly/Benchmark.h>
+#include <folly/Format.h>
+#include <folly/fibers/FiberManager.h>
+#include <folly/init/Init.h>
+#include <glog/logging.h>
+
+#include "mcrouter/lib/network/gen/Memcache.h"
+#include "mcrouter/lib/test/RouteHandleTestUtil.h"
+#include "mcrouter/routes/BigValueRoute.h"
+#include "mcrouter/routes/McrouterRouteHandle.h"
+
+using namespace facebook::memcache;
+using namespace facebook::memcache::mcrouter;
+
+namespace {
+
+constexpr size_t kChunkSize = 64 * 1024;
+constexpr size_t kMaxInflight = 32;
+constexpr uint64_t kSuffix = 1234;
+
+/**
+ * Serves a single big value, already split into chunks. Replies share the
+ * stored buffers, and every reply yields first to emulate a network
+ * round trip, so that chunk requests overlap like they would on the wire.
+ */
+class ChunkStoreRoute {
+ public:
+  static std::string routeName() {
+    return "chunk-store";
+  }
+
+  template <class Request>
+  void traverse(
+      const Request&,
+      const RouteHandleTraverser<McrouterRouteHandleIf>&) const {}
+
+  explicit ChunkStoreRoute(size_t valueSize) {
+    const size_t numChunks = (valueSize + kChunkSize - 1) / kChunkSize;
+    chunks_.emplace(
+        "key",
+        folly::IOBuf(
+            folly::IOBuf::COPY_BUFFER,
+            folly::sformat("1-{}-{}", numChunks, kSuffix)));
+    for (size_t i = 0; i < numChunks; ++i) {
+      chunks_.emplace(
+          folly::sformat("key:{}:{}", i, kSuffix),
+          folly::IOBuf(
+              folly::IOBuf::COPY_BUFFER, std::string(kChunkSize, 'v')));
+    }
+  }
+
+  McGetReply route(const McGetRequest& req) {
+    folly::fibers::yield();
+    auto it = chunks_.find(req.key().fullKey().str());
+    if (it == chunks_.end()) {
+      return McGetReply(mc_res_notfound);
+    }
+    McGetReply reply(mc_res_found);
+    reply.value() = it->second.cloneAsValue();
+    if (req.key().fullKey() == "key") {
+      reply.flags() = MC_MSG_FLAG_BIG_VALUE;
+    }
+    return reply;
+  }
+
+  template <class Request>
+  ReplyT<Request> route(const Request& req) {
+    return createReply(DefaultReply, req);
+  }
+
+ private:
+  std::unordered_map<std::string, folly::IOBuf> chunks_;
+};
+
+// Bytes of the last reply's value that live in buffers not shared with the
+// store, i.e. that were copied by BigValueRoute.
+size_t bytesCopied = 0;
+
+void getBigValue(size_t iters, size_t valueSize) {
+  std::shared_ptr<McrouterRouteHandleIf> rh;
+  BENCHMARK_SUSPEND {
+    rh = std::make_shared<McrouterRouteHandle<BigValueRoute>>(
+        std::make_shared<McrouterRouteHandle<ChunkStoreRoute>>(valueSize),
+        BigValueRouteOptions(kChunkSize, kMaxInflight));
+  }
+
+  TestFiberManager fm;
+  fm.run([&]() {
+    McGetRequest req("key");
+    for (size_t i = 0; i < iters; ++i) {
+      auto reply = rh->route(req);
+      folly::doNotOptimizeAway(reply);
+      BENCHMARK_SUSPEND {
+        bytesCopied = 0;
+        auto value = carbon::valuePtrUnsafe(reply);
+        auto cur = value;
+        do {
+          if (!cur->isSharedOne()) {
+            bytesCopied += cur->length();
+          }
+          cur = cur->next();
+        } while (cur != value);
+      }
+    }
+  });
+}
+
+} // anonymous namespace
+
+BENCHMARK(get_1MB, iters) {
+  getBigValue(iters, 1 << 20);
+}
+
+BENCHMARK(get_4MB, iters) {
+  getBigValue(iters, 4 << 20);
+}
+
+BENCHMARK(get_16MB, iters) {
+  getBigValue(iters, 16 << 20);
+}
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv, true /* removeFlags */);
+  folly::runBenchmarks();
+  LOG(INFO) << "Bytes copied by the last get: " << bytesCopied;
+  return 0;
+}
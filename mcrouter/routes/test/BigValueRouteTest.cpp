@@ -12,6 +12,7 @@
 
 #include <folly/Conv.h>
 #include <folly/Format.h>
+#include <folly/Portability.h>
 
 #include "mcrouter/lib/network/gen/MemcacheMessages.h"
 #include "mcrouter/lib/test/RouteHandleTestUtil.h"
@@ -196,3 +197,77 @@ TEST(BigValueRouteTest, bigvalue) {
     }
   }});
 }
+
+TEST(BigValueRouteTest, bigvalueWindowedGet) {
+  const size_t num_chunks = 10;
+  const auto init_reply = folly::sformat("{}-{}-{}", version, num_chunks, 42);
+  vector<std::shared_ptr<TestHandle>> test_handles{make_shared<TestHandle>(
+      GetRouteTestData(mc_res_found, init_reply, MC_MSG_FLAG_BIG_VALUE))};
+  auto route_handles = get_route_handles(test_handles);
+
+  TestFiberManager fm;
+  fm.run([&]() {
+    McrouterRouteHandle<BigValueRoute> rh(
+        route_handles[0], BigValueRouteOptions(threshold, /* batchSize= */ 3));
+
+    auto reply = rh.route(McGetRequest("key_get"));
+    EXPECT_EQ(mc_res_found, reply.result());
+
+    auto keys_get = test_handles[0]->saw_keys;
+    ASSERT_EQ(num_chunks + 1, keys_get.size());
+    std::string merged_str;
+    for (size_t i = 0; i < num_chunks; i++) {
+      EXPECT_EQ(folly::sformat("key_get:{}:42", i), keys_get[i + 1]);
+      merged_str.append(init_reply);
+    }
+    EXPECT_EQ(merged_str, carbon::valueRangeSlow(reply).str());
+    // chunks are chained, not copied into a single buffer
+    EXPECT_EQ(num_chunks, carbon::valuePtrUnsafe(reply)->countChainElements());
+  });
+}
+
+#if FOLLY_HAVE_LIBZSTD && !defined(DISABLE_COMPRESSION)
+TEST(BigValueRouteTest, compressedBigvalue) {
+  const size_t num_chunks = 10;
+  vector<std::shared_ptr<TestHandle>> test_handles{
+      make_shared<TestHandle>(UpdateRouteTestData(mc_res_stored)),
+      make_shared<TestHandle>(GetRouteTestData(
+          mc_res_found,
+          folly::sformat("2-1-{}-2-{}", 42, threshold * num_chunks),
+          MC_MSG_FLAG_BIG_VALUE))};
+  auto route_handles = get_route_handles(test_handles);
+  const BigValueRouteOptions compressedOpts(
+      threshold, /* batchSize= */ 0, CompressionCodecType::ZSTD);
+
+  TestFiberManager fm;
+  fm.run([&]() {
+    { // Highly compressible value is stored as a single compressed chunk
+      McrouterRouteHandle<BigValueRoute> rh(route_handles[0], compressedOpts);
+
+      McSetRequest req_set("key_set");
+      req_set.value() = folly::IOBuf(
+          folly::IOBuf::COPY_BUFFER, std::string(threshold * num_chunks, 'a'));
+
+      EXPECT_EQ(mc_res_stored, rh.route(req_set).result());
+      auto keys_set = test_handles[0]->saw_keys;
+      auto values_set = test_handles[0]->sawValues;
+      ASSERT_EQ(2, keys_set.size());
+      EXPECT_EQ("key_set", keys_set[1]);
+      // version-numChunks-suffix-compression-uncompressedSize
+      const auto& info = values_set[1];
+      const auto info_end = folly::sformat("-2-{}", threshold * num_chunks);
+      EXPECT_EQ(0, info.find("2-1-"));
+      ASSERT_GT(info.size(), info_end.size());
+      EXPECT_EQ(info_end, info.substr(info.size() - info_end.size()));
+    }
+
+    { // Chunk that doesn't uncompress is a miss
+      McrouterRouteHandle<BigValueRoute> rh(route_handles[1], compressedOpts);
+
+      auto reply = rh.route(McGetRequest("key_get"));
+      EXPECT_EQ(mc_res_notfound, reply.result());
+      EXPECT_EQ(2, test_handles[1]->saw_keys.size());
+    }
+  });
+}
+#endif // FOLLY_HAVE_LIBZSTD && !defined(DISABLE_COMPRESSION)
@@ -0,0 +1,143 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <folly/Benchmark.h>
+#include <folly/Format.h>
+#include <folly/fibers/FiberManager.h>
+#include <folly/init/Init.h>
+#include <folly/json.h>
+#include <glog/logging.h>
+
+#include "mcrouter/lib/network/gen/Memcache.h"
+#include "mcrouter/lib/test/RouteHandleTestUtil.h"
+#include "mcrouter/routes/HashRouteFactory.h"
+#include "mcrouter/routes/McrouterRouteHandle.h"
+
+using namespace facebook::memcache;
+using namespace facebook::memcache::mcrouter;
+
+namespace {
+
+constexpr size_t kNumChildren = 16;
+constexpr size_t kNumKeys = 10000;
+constexpr size_t kConcurrency = 256;
+
+/**
+ * Yields a few times to keep the request in flight, and tracks the highest
+ * number of requests it had in flight at once.
+ */
+class InflightTrackingRoute {
+ public:
+  static std::string routeName() {
+    return "inflight-tracking";
+  }
+
+  template <class Request>
+  void traverse(
+      const Request&,
+      const RouteHandleTraverser<McrouterRouteHandleIf>&) const {}
+
+  explicit InflightTrackingRoute(size_t& maxInflight)
+      : maxInflight_(maxInflight) {}
+
+  template <class Request>
+  ReplyT<Request> route(const Request& req) {
+    maxInflight_ = std::max(maxInflight_, ++inflight_);
+    for (size_t i = 0; i < 4; ++i) {
+      folly::fibers::yield();
+    }
+    --inflight_;
+    return createReply(DefaultReply, req);
+  }
+
+ private:
+  size_t& maxInflight_;
+  size_t inflight_{0};
+};
+
+// Keys in Zipf order: key i is requested with probability ~ 1 / (i + 1).
+std::vector<std::string> zipfKeys(size_t count) {
+  std::vector<double> weights;
+  for (size_t i = 0; i < kNumKeys; ++i) {
+    weights.push_back(1.0 / (i + 1));
+  }
+  std::mt19937 gen(1234);
+  std::discrete_distribution<size_t> dist(weights.begin(), weights.end());
+  std::vector<std::string> keys;
+  for (size_t i = 0; i < count; ++i) {
+    keys.push_back(folly::sformat("key:{}", dist(gen)));
+  }
+  return keys;
+}
+
+// Peak in-flight requests of the busiest child over the average child.
+double peakToAverage = 0;
+
+void routeSkewedKeys(size_t iters, folly::StringPiece hashFunc) {
+  std::vector<size_t> maxInflight(kNumChildren, 0);
+  std::shared_ptr<McrouterRouteHandleIf> rh;
+  std::vector<std::string> keys;
+  BENCHMARK_SUSPEND {
+    std::vector<std::shared_ptr<McrouterRouteHandleIf>> children;
+    for (size_t i = 0; i < kNumChildren; ++i) {
+      children.push_back(
+          std::make_shared<McrouterRouteHandle<InflightTrackingRoute>>(
+              maxInflight[i]));
+    }
+    rh = createHashRoute<McrouterRouterInfo>(
+        folly::dynamic::object("hash_func", hashFunc),
+        std::move(children),
+        0 /* threadId */);
+    keys = zipfKeys(iters);
+  }
+
+  TestFiberManager testfm;
+  auto& fm = testfm.getFiberManager();
+  size_t next = 0;
+  for (size_t i = 0; i < std::min(kConcurrency, iters); ++i) {
+    fm.addTask([&]() {
+      while (next < keys.size()) {
+        McGetRequest req(keys[next++]);
+        folly::doNotOptimizeAway(rh->route(req));
+      }
+    });
+  }
+  fm.loopUntilNoReady();
+
+  BENCHMARK_SUSPEND {
+    double total = 0;
+    for (auto m : maxInflight) {
+      total += m;
+    }
+    auto peak = *std::max_element(maxInflight.begin(), maxInflight.end());
+    peakToAverage = total > 0 ? peak * kNumChildren / total : 0;
+    LOG(INFO) << hashFunc << ": peak/average in-flight " << peakToAverage;
+  }
+}
+
+} // anonymous namespace
+
+BENCHMARK(route_Ch3, iters) {
+  routeSkewedKeys(iters, "Ch3");
+}
+
+BENCHMARK_RELATIVE(route_BoundedLoadCh3, iters) {
+  routeSkewedKeys(iters, "BoundedLoadCh3");
+}
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv, true /* removeFlags */);
+  folly::runBenchmarks();
+  return 0;
+}
@@ -0,0 +1,114 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <folly/json.h>
+
+#include "mcrouter/lib/network/gen/Memcache.h"
+#include "mcrouter/routes/BoundedLoadRoute.h"
+#include "mcrouter/routes/test/RouteHandleTestUtil.h"
+
+using namespace facebook::memcache;
+using namespace facebook::memcache::mcrouter;
+
+namespace {
+
+constexpr size_t kNumChildren = 4;
+
+std::vector<std::shared_ptr<TestHandle>> makeHandles() {
+  std::vector<std::shared_ptr<TestHandle>> handles;
+  for (size_t i = 0; i < kNumChildren; ++i) {
+    handles.push_back(
+        std::make_shared<TestHandle>(GetRouteTestData(mc_res_found, "a")));
+  }
+  return handles;
+}
+
+} // anonymous namespace
+
+TEST(boundedLoadRouteTest, sequentialRequestsStickToOneChild) {
+  auto handles = makeHandles();
+  McrouterRouteHandle<BoundedLoadRoute<McrouterRouterInfo>> rh(
+      get_route_handles(handles), "", 0.25);
+
+  TestFiberManager testfm{
+      typename fiber_local<MemcacheRouterInfo>::ContextTypeTag()};
+  testfm.run([&]() {
+    fiber_local<MemcacheRouterInfo>::setSharedCtx(getTestContext());
+    for (size_t i = 0; i < 10; ++i) {
+      EXPECT_EQ(mc_res_found, rh.route(McGetRequest("key")).result());
+    }
+  });
+
+  size_t used = 0;
+  for (const auto& handle : handles) {
+    if (!handle->saw_keys.empty()) {
+      ++used;
+      EXPECT_EQ(10, handle->saw_keys.size());
+    }
+  }
+  EXPECT_EQ(1, used);
+}
+
+TEST(boundedLoadRouteTest, hotKeySpillsOver) {
+  auto handles = makeHandles();
+  McrouterRouteHandle<BoundedLoadRoute<McrouterRouterInfo>> rh(
+      get_route_handles(handles), "", 0.25);
+  for (auto& handle : handles) {
+    handle->pause();
+  }
+
+  constexpr size_t kRequests = 20;
+  size_t replies = 0;
+
+  TestFiberManager testfm{
+      typename fiber_local<MemcacheRouterInfo>::ContextTypeTag()};
+  auto& fm = testfm.getFiberManager();
+  for (size_t i = 0; i < kRequests; ++i) {
+    auto context = getTestContext();
+    fm.addTask([&rh, context, &replies]() {
+      fiber_local<MemcacheRouterInfo>::setSharedCtx(std::move(context));
+      EXPECT_EQ(mc_res_found, rh.route(McGetRequest("key")).result());
+      ++replies;
+    });
+  }
+
+  auto& loopController =
+      dynamic_cast<folly::fibers::SimpleLoopController&>(fm.loopController());
+  loopController.loop([&]() {
+    fm.addTask([&]() {
+      for (auto& handle : handles) {
+        handle->unpause();
+      }
+    });
+    loopController.stop();
+  });
+
+  EXPECT_EQ(kRequests, replies);
+  // ceil(20 * 1.25 / 4)
+  for (const auto& handle : handles) {
+    EXPECT_LE(handle->saw_keys.size(), 7);
+  }
+}
+
+TEST(boundedLoadRouteTest, createFromJson) {
+  auto handles = makeHandles();
+  auto rh = createBoundedLoadRoute<McrouterRouterInfo>(
+      folly::parseJson(R"({"salt": "s", "epsilon": 0.5})"),
+      get_route_handles(handles));
+  EXPECT_EQ("hash|BoundedLoadCh3|epsilon=0.5|salt=s", rh->routeName());
+
+  EXPECT_THROW(
+      createBoundedLoadRoute<McrouterRouterInfo>(
+          folly::parseJson(R"({"epsilon": 0})"), get_route_handles(handles)),
+      std::logic_error);
+}
@@ -0,0 +1,256 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/lib/config/RouteHandleBuilder.h"
+#include "mcrouter/lib/network/gen/Memcache.h"
+#include "mcrouter/routes/CoalescingRoute.h"
+#include "mcrouter/routes/test/RouteHandleTestUtil.h"
+
+using namespace facebook::memcache;
+using namespace facebook::memcache::mcrouter;
+
+namespace {
+
+void sendGet(
+    folly::fibers::FiberManager& fm,
+    McrouterRouteHandleIf& rh,
+    std::string key,
+    std::vector<std::string>& values) {
+  auto context = getTestContext();
+  fm.addTask([&rh, key = std::move(key), context, &values]() {
+    McGetRequest request(key);
+    fiber_local<MemcacheRouterInfo>::setSharedCtx(std::move(context));
+    auto reply = rh.route(request);
+    EXPECT_EQ(mc_res_found, reply.result());
+    values.push_back(carbon::valueRangeSlow(reply).str());
+  });
+}
+
+/* Hands out a lease token to every lease-get and stores every lease-set */
+template <class RouteHandleIf>
+struct LeaseRoute {
+  static std::string routeName() {
+    return "lease";
+  }
+
+  template <class Request>
+  void traverse(const Request&, const RouteHandleTraverser<RouteHandleIf>&)
+      const {}
+
+  LeaseRoute(std::vector<std::string>& ops, int64_t token)
+      : ops_(ops), token_(token) {}
+
+  McLeaseGetReply route(const McLeaseGetRequest&) {
+    ops_.push_back("lease-get");
+    McLeaseGetReply reply(mc_res_notfound);
+    reply.leaseToken() = token_;
+    return reply;
+  }
+
+  McLeaseSetReply route(const McLeaseSetRequest&) {
+    ops_.push_back("lease-set");
+    return McLeaseSetReply(mc_res_stored);
+  }
+
+  template <class Request>
+  ReplyT<Request> route(const Request& req) {
+    return createReply(DefaultReply, req);
+  }
+
+ private:
+  std::vector<std::string>& ops_;
+  const int64_t token_;
+};
+
+void sendLeaseGet(
+    folly::fibers::FiberManager& fm,
+    McrouterRouteHandleIf& rh,
+    std::vector<McLeaseGetReply>& replies) {
+  auto context = getTestContext();
+  fm.addTask([&rh, context, &replies]() {
+    McLeaseGetRequest request("key");
+    fiber_local<MemcacheRouterInfo>::setSharedCtx(std::move(context));
+    replies.push_back(rh.route(request));
+  });
+}
+
+void sendLeaseSet(
+    folly::fibers::FiberManager& fm,
+    McrouterRouteHandleIf& rh,
+    int64_t token) {
+  auto context = getTestContext();
+  fm.addTask([&rh, context, token]() {
+    McLeaseSetRequest request("key");
+    request.leaseToken() = token;
+    request.value() = folly::IOBuf(folly::IOBuf::COPY_BUFFER, "filled");
+    fiber_local<MemcacheRouterInfo>::setSharedCtx(std::move(context));
+    EXPECT_EQ(mc_res_stored, rh.route(request).result());
+  });
+}
+
+} // anonymous namespace
+
+TEST(coalescingRouteTest, identicalGetsAreCoalesced) {
+  auto normalHandle =
+      std::make_shared<TestHandle>(GetRouteTestData(mc_res_found, "a"));
+
+  McrouterRouteHandle<CoalescingRoute<McrouterRouterInfo>> rh(
+      normalHandle->rh);
+
+  normalHandle->pause();
+
+  std::vector<std::string> values;
+
+  TestFiberManager testfm{
+      typename fiber_local<MemcacheRouterInfo>::ContextTypeTag()};
+  auto& fm = testfm.getFiberManager();
+
+  sendGet(fm, rh, "key1", values);
+  sendGet(fm, rh, "key1", values);
+  sendGet(fm, rh, "key2", values);
+  sendGet(fm, rh, "key1", values);
+
+  auto& loopController =
+      dynamic_cast<folly::fibers::SimpleLoopController&>(fm.loopController());
+  loopController.loop([&]() {
+    fm.addTask([&]() { normalHandle->unpause(); });
+    loopController.stop();
+  });
+
+  EXPECT_EQ(4, values.size());
+  for (const auto& value : values) {
+    EXPECT_EQ("a", value);
+  }
+  EXPECT_EQ(
+      std::vector<std::string>({"key1", "key2"}), normalHandle->saw_keys);
+}
+
+TEST(coalescingRouteTest, sequentialGetsAreNotCoalesced) {
+  auto normalHandle =
+      std::make_shared<TestHandle>(GetRouteTestData(mc_res_found, "a"));
+
+  McrouterRouteHandle<CoalescingRoute<McrouterRouterInfo>> rh(
+      normalHandle->rh);
+
+  std::vector<std::string> values;
+
+  TestFiberManager testfm{
+      typename fiber_local<MemcacheRouterInfo>::ContextTypeTag()};
+  auto& fm = testfm.getFiberManager();
+
+  sendGet(fm, rh, "key1", values);
+  fm.loopUntilNoReady();
+  sendGet(fm, rh, "key1", values);
+  fm.loopUntilNoReady();
+
+  EXPECT_EQ(2, values.size());
+  EXPECT_EQ(
+      std::vector<std::string>({"key1", "key1"}), normalHandle->saw_keys);
+}
+
+TEST(coalescingRouteTest, leaseGetsWaitForFill) {
+  std::vector<std::string> ops;
+  auto leaseHandle = makeRouteHandle<McrouterRouteHandleIf, LeaseRoute>(
+      ops, static_cast<int64_t>(42));
+  McrouterRouteHandle<CoalescingRoute<McrouterRouterInfo>> rh(
+      leaseHandle, false, std::chrono::milliseconds(60000));
+
+  std::vector<McLeaseGetReply> replies;
+
+  TestFiberManager testfm{
+      typename fiber_local<MemcacheRouterInfo>::ContextTypeTag()};
+  auto& fm = testfm.getFiberManager();
+
+  // The first lease-get gets the token, the next ones wait for the fill.
+  sendLeaseGet(fm, rh, replies);
+  fm.loopUntilNoReady();
+  sendLeaseGet(fm, rh, replies);
+  sendLeaseGet(fm, rh, replies);
+  fm.loopUntilNoReady();
+  ASSERT_EQ(1, replies.size());
+  EXPECT_EQ(mc_res_notfound, replies[0].result());
+  EXPECT_EQ(42, replies[0].leaseToken());
+
+  // A lease-set with another token doesn't release them.
+  sendLeaseSet(fm, rh, 7);
+  fm.loopUntilNoReady();
+  EXPECT_EQ(1, replies.size());
+
+  sendLeaseSet(fm, rh, 42);
+  fm.loopUntilNoReady();
+  ASSERT_EQ(3, replies.size());
+  for (size_t i = 1; i < replies.size(); ++i) {
+    EXPECT_EQ(mc_res_found, replies[i].result());
+    EXPECT_EQ("filled", carbon::valueRangeSlow(replies[i]).str());
+  }
+  EXPECT_EQ(
+      std::vector<std::string>({"lease-get", "lease-set", "lease-set"}), ops);
+
+  // The fill is done, so the next lease-get goes to the child again.
+  sendLeaseGet(fm, rh, replies);
+  fm.loopUntilNoReady();
+  EXPECT_EQ(4, replies.size());
+  EXPECT_EQ(4, ops.size());
+}
+
+TEST(coalescingRouteTest, leaseGetsNotCoalescedByDefault) {
+  std::vector<std::string> ops;
+  auto leaseHandle = makeRouteHandle<McrouterRouteHandleIf, LeaseRoute>(
+      ops, static_cast<int64_t>(42));
+  McrouterRouteHandle<CoalescingRoute<McrouterRouterInfo>> rh(leaseHandle);
+
+  std::vector<McLeaseGetReply> replies;
+
+  TestFiberManager testfm{
+      typename fiber_local<MemcacheRouterInfo>::ContextTypeTag()};
+  auto& fm = testfm.getFiberManager();
+
+  sendLeaseGet(fm, rh, replies);
+  sendLeaseGet(fm, rh, replies);
+  fm.loopUntilNoReady();
+  EXPECT_EQ(2, replies.size());
+  EXPECT_EQ(std::vector<std::string>({"lease-get", "lease-get"}), ops);
+}
+
+TEST(coalescingRouteTest, expiredLeasesAreSwept) {
+  std::vector<std::string> ops;
+  auto leaseHandle = makeRouteHandle<McrouterRouteHandleIf, LeaseRoute>(
+      ops, static_cast<int64_t>(42));
+  CoalescingRoute<McrouterRouterInfo> rh(
+      leaseHandle, false, std::chrono::milliseconds(10));
+
+  TestFiberManager testfm{
+      typename fiber_local<MemcacheRouterInfo>::ContextTypeTag()};
+  auto leaseGet = [&](std::string key) {
+    testfm.run([&]() {
+      fiber_local<MemcacheRouterInfo>::setSharedCtx(getTestContext());
+      EXPECT_EQ(42, rh.route(McLeaseGetRequest(key)).leaseToken());
+    });
+  };
+
+  // None of these keys is ever filled.
+  for (size_t i = 0; i < 10; ++i) {
+    leaseGet("key" + std::to_string(i));
+  }
+  EXPECT_EQ(10, rh.leasesPending());
+
+  /* sleep override */
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+  // A lease-get for any key drops all of the expired leases.
+  leaseGet("other");
+  EXPECT_EQ(1, rh.leasesPending());
+  EXPECT_EQ(11, ops.size());
+}
@@ -473,6 +473,57 @@ TEST(failoverRouteTest, leastFailuresFailAllLimit) {
   EXPECT_EQ("b", carbon::valueRangeSlow(reply).str());
 }
 
+TEST(failoverRouteTest, loadAwarePrefersHealthyChildren) {
+  std::vector<std::shared_ptr<TestHandle>> test_handles{
+      make_shared<TestHandle>(GetRouteTestData(mc_res_timeout, "a")),
+      make_shared<TestHandle>(GetRouteTestData(mc_res_timeout, "b")),
+      make_shared<TestHandle>(GetRouteTestData(mc_res_found, "c"))};
+
+  mockFiberContext();
+  folly::dynamic json =
+      folly::dynamic::object("type", "LoadAwarePolicy")("max_tries", 3);
+  auto rh = makeFailoverRouteLoadAware<McrouterRouterInfo, FailoverRoute>(
+      get_route_handles(test_handles),
+      FailoverErrorsSettings(),
+      nullptr,
+      /* failoverTagging */ false,
+      /* enableLeasePairing */ false,
+      "route01",
+      json);
+
+  auto reply1 = rh->route(McGetRequest("0"));
+  EXPECT_EQ("c", carbon::valueRangeSlow(reply1).str());
+  EXPECT_EQ(1, test_handles[1]->saw_keys.size());
+
+  // b errored on the first request, so c is tried before it now.
+  auto reply2 = rh->route(McGetRequest("0"));
+  EXPECT_EQ("c", carbon::valueRangeSlow(reply2).str());
+  EXPECT_EQ(2, test_handles[0]->saw_keys.size());
+  EXPECT_EQ(1, test_handles[1]->saw_keys.size());
+}
+
+TEST(failoverRouteTest, loadAwareFailAll) {
+  std::vector<std::shared_ptr<TestHandle>> test_handles{
+      make_shared<TestHandle>(GetRouteTestData(mc_res_timeout, "a")),
+      make_shared<TestHandle>(GetRouteTestData(mc_res_timeout, "b")),
+      make_shared<TestHandle>(GetRouteTestData(mc_res_timeout, "c"))};
+
+  mockFiberContext();
+  folly::dynamic json =
+      folly::dynamic::object("type", "LoadAwarePolicy")("max_tries", 2);
+  auto rh = makeFailoverRouteLoadAware<McrouterRouterInfo, FailoverRoute>(
+      get_route_handles(test_handles),
+      FailoverErrorsSettings(),
+      nullptr,
+      /* failoverTagging */ false,
+      /* enableLeasePairing */ false,
+      "route01",
+      json);
+
+  auto reply = rh->route(McGetRequest("0"));
+  EXPECT_EQ("b", carbon::valueRangeSlow(reply).str());
+}
+
 TEST(failoverRouteTest, leastFailuresComplex) {
   std::vector<std::shared_ptr<TestHandle>> test_handles{
       make_shared<TestHandle>(
@@ -533,3 +584,84 @@ TEST(failoverRouteTest, leastFailuresComplex) {
   auto reply7 = rh->route(McGetRequest("0"));
   EXPECT_EQ("c", carbon::valueRangeSlow(reply7).str());
 }
+
+namespace {
+
+// Behaves like a destination with a full queue: spills requests over
+// whenever it's allowed to, and replies notfound otherwise.
+class SaturatedRoute {
+ public:
+  std::string routeName() const {
+    return "saturated";
+  }
+
+  template <class Request>
+  void traverse(
+      const Request&,
+      const RouteHandleTraverser<McrouterRouteHandleIf>&) const {}
+
+  template <class Request>
+  ReplyT<Request> route(const Request&) {
+    if (fiber_local<McrouterRouterInfo>::getSpilloverAllowed()) {
+      fiber_local<McrouterRouterInfo>::setSpilledOver(true);
+      return ReplyT<Request>(mc_res_local_error);
+    }
+    return ReplyT<Request>(mc_res_notfound);
+  }
+};
+
+McrouterRouteHandlePtr makeSpilloverRoute(
+    std::vector<McrouterRouteHandlePtr> rh,
+    bool spillover) {
+  return makeFailoverRouteInOrder<McrouterRouterInfo, FailoverRoute>(
+      std::move(rh),
+      // Spillovers don't depend on failover errors.
+      FailoverErrorsSettings(std::vector<std::string>{"remote_error"}),
+      nullptr,
+      /* failoverTagging */ false,
+      /* enableLeasePairing */ false,
+      "",
+      nullptr,
+      spillover);
+}
+
+} // anonymous namespace
+
+TEST(failoverRouteTest, spillover) {
+  auto saturated = make_shared<McrouterRouteHandle<SaturatedRoute>>();
+  auto b = make_shared<TestHandle>(GetRouteTestData(mc_res_found, "b"));
+  auto c = make_shared<TestHandle>(GetRouteTestData(mc_res_found, "c"));
+
+  mockFiberContext();
+  auto rh = makeSpilloverRoute({saturated, b->rh, c->rh}, true);
+  auto reply = rh->route(McGetRequest("0"));
+  EXPECT_EQ(mc_res_found, reply.result());
+  EXPECT_EQ("b", carbon::valueRangeSlow(reply).str());
+  EXPECT_FALSE(fiber_local<McrouterRouterInfo>::getSpilledOver());
+
+  // Spills over from failover children as well.
+  auto a = make_shared<TestHandle>(GetRouteTestData(mc_res_remote_error, "a"));
+  rh = makeSpilloverRoute({a->rh, saturated, c->rh}, true);
+  reply = rh->route(McGetRequest("0"));
+  EXPECT_EQ("c", carbon::valueRangeSlow(reply).str());
+}
+
+TEST(failoverRouteTest, spilloverNotFromLastChild) {
+  auto saturated = make_shared<McrouterRouteHandle<SaturatedRoute>>();
+  auto b = make_shared<TestHandle>(GetRouteTestData(mc_res_remote_error, "b"));
+
+  mockFiberContext();
+  auto rh = makeSpilloverRoute({b->rh, saturated}, true);
+  auto reply = rh->route(McGetRequest("0"));
+  EXPECT_EQ(mc_res_notfound, reply.result());
+}
+
+TEST(failoverRouteTest, spilloverDisabled) {
+  auto saturated = make_shared<McrouterRouteHandle<SaturatedRoute>>();
+  auto b = make_shared<TestHandle>(GetRouteTestData(mc_res_found, "b"));
+
+  mockFiberContext();
+  auto rh = makeSpilloverRoute({saturated, b->rh}, false);
+  auto reply = rh->route(McGetRequest("0"));
+  EXPECT_EQ(mc_res_notfound, reply.result());
+}
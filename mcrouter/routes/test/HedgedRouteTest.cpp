@@ -0,0 +1,255 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <folly/fibers/Baton.h>
+#include <folly/fibers/FiberManager.h>
+
+#include "mcrouter/lib/network/gen/Memcache.h"
+#include "mcrouter/routes/HedgedRoute.h"
+#include "mcrouter/routes/test/RouteHandleTestUtil.h"
+
+using namespace facebook::memcache;
+using namespace facebook::memcache::mcrouter;
+
+namespace {
+
+// Collects enough fast samples from the primary for hedging to kick in.
+template <class Rh>
+void warmUp(Rh& rh) {
+  for (size_t i = 0; i < LatencyQuantile::kWindow; ++i) {
+    rh.route(McGetRequest("warmup"));
+  }
+}
+
+// Routes a get while the primary is held for holdMs, then waits for the
+// held request to finish so that it doesn't overlap with the next one.
+template <class Rh>
+McGetReply routeWithSlowPrimary(Rh& rh, TestHandle& primary, int holdMs) {
+  primary.pause();
+  folly::fibers::addTask([&primary, holdMs]() {
+    folly::fibers::Baton baton;
+    baton.try_wait_for(std::chrono::milliseconds(holdMs));
+    primary.unpause();
+  });
+  auto reply = rh.route(McGetRequest("key"));
+  folly::fibers::Baton baton;
+  baton.try_wait_for(std::chrono::milliseconds(2 * holdMs));
+  return reply;
+}
+
+} // anonymous namespace
+
+TEST(latencyQuantileTest, quantile) {
+  LatencyQuantile latency(0.95);
+  for (size_t i = 0; i < LatencyQuantile::kWindow - 1; ++i) {
+    latency.add(i % 100);
+    EXPECT_FALSE(latency.value().hasValue());
+  }
+  latency.add(0);
+  ASSERT_TRUE(latency.value().hasValue());
+  EXPECT_GE(*latency.value(), 93);
+  EXPECT_LE(*latency.value(), 96);
+
+  // Old samples are forgotten.
+  for (size_t i = 0; i < LatencyQuantile::kWindow; ++i) {
+    latency.add(1000);
+  }
+  EXPECT_EQ(1000, *latency.value());
+}
+
+TEST(hedgedRouteTest, goesToPrimaryWithoutSamples) {
+  std::vector<std::shared_ptr<TestHandle>> test_handles{
+      std::make_shared<TestHandle>(
+          GetRouteTestData(mc_res_found, "a"),
+          UpdateRouteTestData(mc_res_stored)),
+      std::make_shared<TestHandle>(
+          GetRouteTestData(mc_res_found, "b"),
+          UpdateRouteTestData(mc_res_stored))};
+  McrouterRouteHandle<HedgedRoute<McrouterRouterInfo>> rh(
+      get_route_handles(test_handles),
+      0.95,
+      100 /* maxHedgePercent */,
+      std::chrono::milliseconds(1));
+
+  TestFiberManager testfm{
+      typename fiber_local<MemcacheRouterInfo>::ContextTypeTag()};
+  testfm.run([&]() {
+    fiber_local<MemcacheRouterInfo>::setSharedCtx(getTestContext());
+    auto reply = rh.route(McGetRequest("key"));
+    EXPECT_EQ(mc_res_found, reply.result());
+    EXPECT_EQ("a", carbon::valueRangeSlow(reply).str());
+
+    McSetRequest set("key");
+    set.value() = folly::IOBuf(folly::IOBuf::COPY_BUFFER, "value");
+    EXPECT_EQ(mc_res_stored, rh.route(set).result());
+  });
+
+  EXPECT_EQ(
+      std::vector<std::string>({"key", "key"}), test_handles[0]->saw_keys);
+  EXPECT_TRUE(test_handles[1]->saw_keys.empty());
+}
+
+TEST(hedgedRouteTest, errorFromPrimaryIsReturnedWhenAlone) {
+  std::vector<std::shared_ptr<TestHandle>> test_handles{
+      std::make_shared<TestHandle>(GetRouteTestData(mc_res_timeout, "a")),
+      std::make_shared<TestHandle>(GetRouteTestData(mc_res_found, "b"))};
+  McrouterRouteHandle<HedgedRoute<McrouterRouterInfo>> rh(
+      get_route_handles(test_handles),
+      0.95,
+      0 /* maxHedgePercent */,
+      std::chrono::milliseconds(1));
+
+  TestFiberManager testfm{
+      typename fiber_local<MemcacheRouterInfo>::ContextTypeTag()};
+  testfm.run([&]() {
+    fiber_local<MemcacheRouterInfo>::setSharedCtx(getTestContext());
+    EXPECT_EQ(mc_res_timeout, rh.route(McGetRequest("key")).result());
+  });
+  EXPECT_TRUE(test_handles[1]->saw_keys.empty());
+}
+
+TEST(hedgedRouteTest, hedgesToNextChildAfterDelay) {
+  std::vector<std::shared_ptr<TestHandle>> test_handles{
+      std::make_shared<TestHandle>(GetRouteTestData(mc_res_found, "a")),
+      std::make_shared<TestHandle>(GetRouteTestData(mc_res_found, "b"))};
+  McrouterRouteHandle<HedgedRoute<McrouterRouterInfo>> rh(
+      get_route_handles(test_handles),
+      0.95,
+      100 /* maxHedgePercent */,
+      std::chrono::milliseconds(1));
+
+  TestFiberManager testfm{
+      typename fiber_local<MemcacheRouterInfo>::ContextTypeTag()};
+  testfm.run([&]() {
+    fiber_local<MemcacheRouterInfo>::setSharedCtx(getTestContext());
+    warmUp(rh);
+    EXPECT_TRUE(test_handles[1]->saw_keys.empty());
+
+    // The primary answers well after the 1ms hedge delay, so the copy sent
+    // to the second child wins.
+    auto reply = routeWithSlowPrimary(rh, *test_handles[0], 50);
+    EXPECT_EQ(mc_res_found, reply.result());
+    EXPECT_EQ("b", carbon::valueRangeSlow(reply).str());
+  });
+
+  EXPECT_EQ(std::vector<std::string>({"key"}), test_handles[1]->saw_keys);
+  // The late primary reply still completed.
+  EXPECT_EQ(LatencyQuantile::kWindow + 1, test_handles[0]->saw_keys.size());
+  EXPECT_EQ("key", test_handles[0]->saw_keys.back());
+}
+
+TEST(hedgedRouteTest, hedgeBudgetIsCapped) {
+  std::vector<std::shared_ptr<TestHandle>> test_handles{
+      std::make_shared<TestHandle>(GetRouteTestData(mc_res_found, "a")),
+      std::make_shared<TestHandle>(GetRouteTestData(mc_res_found, "b"))};
+  // Every request earns 0.2 hedges, so the warm-up alone would earn ~100
+  // without the burst cap of 10.
+  McrouterRouteHandle<HedgedRoute<McrouterRouterInfo>> rh(
+      get_route_handles(test_handles),
+      0.95,
+      20 /* maxHedgePercent */,
+      std::chrono::milliseconds(1));
+
+  TestFiberManager testfm{
+      typename fiber_local<MemcacheRouterInfo>::ContextTypeTag()};
+  testfm.run([&]() {
+    fiber_local<MemcacheRouterInfo>::setSharedCtx(getTestContext());
+    warmUp(rh);
+
+    // Budget before the k-th slow request is 10 - 0.8 * (k - 1), so the
+    // first 12 are hedged and the 13th waits for the primary.
+    for (size_t i = 0; i < 12; ++i) {
+      auto reply = routeWithSlowPrimary(rh, *test_handles[0], 20);
+      EXPECT_EQ("b", carbon::valueRangeSlow(reply).str());
+    }
+    auto reply = routeWithSlowPrimary(rh, *test_handles[0], 20);
+    EXPECT_EQ("a", carbon::valueRangeSlow(reply).str());
+  });
+
+  EXPECT_EQ(12, test_handles[1]->saw_keys.size());
+}
+
+TEST(hedgedRouteTest, noHedgingWithoutBudget) {
+  std::vector<std::shared_ptr<TestHandle>> test_handles{
+      std::make_shared<TestHandle>(GetRouteTestData(mc_res_found, "a")),
+      std::make_shared<TestHandle>(GetRouteTestData(mc_res_found, "b"))};
+  McrouterRouteHandle<HedgedRoute<McrouterRouterInfo>> rh(
+      get_route_handles(test_handles),
+      0.95,
+      0 /* maxHedgePercent */,
+      std::chrono::milliseconds(1));
+
+  TestFiberManager testfm{
+      typename fiber_local<MemcacheRouterInfo>::ContextTypeTag()};
+  testfm.run([&]() {
+    fiber_local<MemcacheRouterInfo>::setSharedCtx(getTestContext());
+    warmUp(rh);
+    auto reply = routeWithSlowPrimary(rh, *test_handles[0], 20);
+    EXPECT_EQ("a", carbon::valueRangeSlow(reply).str());
+  });
+
+  EXPECT_TRUE(test_handles[1]->saw_keys.empty());
+}
+
+TEST(hedgedRouteTest, exceptionFromPrimaryBecomesErrorReply) {
+  auto secondary =
+      std::make_shared<TestHandle>(GetRouteTestData(mc_res_found, "b"));
+  std::vector<std::shared_ptr<McrouterRouteHandleIf>> children{
+      std::make_shared<
+          McrouterRouteHandle<ThrowingRoute<McrouterRouteHandleIf>>>(),
+      secondary->rh};
+  McrouterRouteHandle<HedgedRoute<McrouterRouterInfo>> rh(
+      std::move(children),
+      0.95,
+      100 /* maxHedgePercent */,
+      std::chrono::milliseconds(1));
+
+  TestFiberManager testfm{
+      typename fiber_local<MemcacheRouterInfo>::ContextTypeTag()};
+  bool replied = false;
+  testfm.run([&]() {
+    fiber_local<MemcacheRouterInfo>::setSharedCtx(getTestContext());
+    EXPECT_EQ(mc_res_local_error, rh.route(McGetRequest("key")).result());
+    replied = true;
+  });
+
+  EXPECT_TRUE(replied);
+  EXPECT_TRUE(secondary->saw_keys.empty());
+}
+
+TEST(hedgedRouteTest, exceptionFromHedgeWaitsForPrimary) {
+  auto primary =
+      std::make_shared<TestHandle>(GetRouteTestData(mc_res_found, "a"));
+  std::vector<std::shared_ptr<McrouterRouteHandleIf>> children{
+      primary->rh,
+      std::make_shared<
+          McrouterRouteHandle<ThrowingRoute<McrouterRouteHandleIf>>>()};
+  McrouterRouteHandle<HedgedRoute<McrouterRouterInfo>> rh(
+      std::move(children),
+      0.95,
+      100 /* maxHedgePercent */,
+      std::chrono::milliseconds(1));
+
+  TestFiberManager testfm{
+      typename fiber_local<MemcacheRouterInfo>::ContextTypeTag()};
+  testfm.run([&]() {
+    fiber_local<MemcacheRouterInfo>::setSharedCtx(getTestContext());
+    warmUp(rh);
+
+    // The hedge fails, so the late reply of the primary is returned.
+    auto reply = routeWithSlowPrimary(rh, *primary, 20);
+    EXPECT_EQ(mc_res_found, reply.result());
+    EXPECT_EQ("a", carbon::valueRangeSlow(reply).str());
+  });
+}
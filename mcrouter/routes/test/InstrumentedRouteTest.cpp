@@ -0,0 +1,50 @@
+/*
+ *  Copyright (c) 2016-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <memory>
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/RouteStats.h"
+#include "mcrouter/lib/network/gen/Memcache.h"
+#include "mcrouter/routes/InstrumentedRoute.h"
+#include "mcrouter/routes/test/RouteHandleTestUtil.h"
+
+using namespace facebook::memcache;
+using namespace facebook::memcache::mcrouter;
+
+TEST(instrumentedRouteTest, recordsCallsAndErrors) {
+  RouteStatsMap statsMap;
+  auto okHandle =
+      std::make_shared<TestHandle>(GetRouteTestData(mc_res_found, "a"));
+  auto errorHandle =
+      std::make_shared<TestHandle>(GetRouteTestData(mc_res_timeout, ""));
+  McrouterRouteHandle<InstrumentedRoute<McrouterRouterInfo>> okRoute(
+      okHandle->rh, statsMap.get("ok"));
+  McrouterRouteHandle<InstrumentedRoute<McrouterRouterInfo>> errorRoute(
+      errorHandle->rh, statsMap.get("error"));
+
+  TestFiberManager testfm{
+      typename fiber_local<MemcacheRouterInfo>::ContextTypeTag()};
+  testfm.run([&]() {
+    EXPECT_EQ(mc_res_found, okRoute.route(McGetRequest("key")).result());
+    EXPECT_EQ(mc_res_found, okRoute.route(McGetRequest("key")).result());
+    EXPECT_EQ(mc_res_timeout, errorRoute.route(McGetRequest("key")).result());
+  });
+
+  EXPECT_EQ(2, statsMap.get("ok")->calls());
+  EXPECT_EQ(0, statsMap.get("ok")->errors());
+  EXPECT_EQ(2, statsMap.get("ok")->latencyUs().histogram().count());
+  EXPECT_EQ(1, statsMap.get("error")->calls());
+  EXPECT_EQ(1, statsMap.get("error")->errors());
+
+  size_t numRoutes = 0;
+  statsMap.foreach([&numRoutes](const std::string&, const RouteStats&) {
+    ++numRoutes;
+  });
+  EXPECT_EQ(2, numRoutes);
+}
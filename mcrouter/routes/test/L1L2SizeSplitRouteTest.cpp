@@ -0,0 +1,108 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/lib/mc/msg.h"
+#include "mcrouter/lib/network/gen/Memcache.h"
+#include "mcrouter/routes/L1L2SizeSplitRoute.h"
+#include "mcrouter/routes/test/RouteHandleTestUtil.h"
+
+using namespace facebook::memcache;
+using namespace facebook::memcache::mcrouter;
+
+namespace {
+
+/* Returns the value "l2" for every get, or throws once told to */
+struct FlakyL2Route {
+  static std::string routeName() {
+    return "flaky-l2";
+  }
+
+  template <class Request>
+  void traverse(
+      const Request&,
+      const RouteHandleTraverser<McrouterRouteHandleIf>&) const {}
+
+  explicit FlakyL2Route(const bool& fail) : fail_(fail) {}
+
+  McGetReply route(const McGetRequest&) {
+    if (fail_) {
+      throw std::runtime_error("L2 failed");
+    }
+    McGetReply reply(mc_res_found);
+    reply.value() = folly::IOBuf(folly::IOBuf::COPY_BUFFER, "l2");
+    return reply;
+  }
+
+  template <class Request>
+  ReplyT<Request> route(const Request& req) {
+    return createReply(DefaultReply, req);
+  }
+
+ private:
+  const bool& fail_;
+};
+
+} // anonymous namespace
+
+TEST(l1l2SizeSplitRouteTest, speculativeGet) {
+  // L1 always has a sentinel.
+  auto l1 = std::make_shared<TestHandle>(
+      GetRouteTestData(mc_res_found, "", MC_MSG_FLAG_SIZE_SPLIT));
+  bool failL2 = false;
+  L1L2SizeSplitRoute rh(
+      l1->rh,
+      std::make_shared<McrouterRouteHandle<FlakyL2Route>>(failL2),
+      /* threshold */ 100,
+      /* ttlThreshold */ 0,
+      /* failureTtl */ 10,
+      /* bothFullSet */ false,
+      /* speculativeL2Get */ true);
+
+  TestFiberManager fm;
+  fm.run([&]() {
+    // The first get learns that the key is split, the second one goes to
+    // L2 in parallel.
+    for (size_t i = 0; i < 2; ++i) {
+      auto reply = rh.route(McGetRequest("key"));
+      EXPECT_EQ(mc_res_found, reply.result());
+      EXPECT_EQ("l2", carbon::valueRangeSlow(reply).str());
+    }
+  });
+}
+
+TEST(l1l2SizeSplitRouteTest, speculativeGetL2Throws) {
+  auto l1 = std::make_shared<TestHandle>(
+      GetRouteTestData(mc_res_found, "", MC_MSG_FLAG_SIZE_SPLIT));
+  bool failL2 = false;
+  L1L2SizeSplitRoute rh(
+      l1->rh,
+      std::make_shared<McrouterRouteHandle<FlakyL2Route>>(failL2),
+      /* threshold */ 100,
+      /* ttlThreshold */ 0,
+      /* failureTtl */ 10,
+      /* bothFullSet */ false,
+      /* speculativeL2Get */ true);
+
+  TestFiberManager fm;
+  bool replied = false;
+  fm.run([&]() {
+    EXPECT_EQ(mc_res_found, rh.route(McGetRequest("key")).result());
+
+    // L1 returns a sentinel, so the speculative L2 get has to be waited
+    // for, and its exception becomes the reply.
+    failL2 = true;
+    EXPECT_EQ(mc_res_local_error, rh.route(McGetRequest("key")).result());
+    replied = true;
+  });
+  EXPECT_TRUE(replied);
+}
@@ -5,7 +5,9 @@
  *  file in the root directory of this source tree.
  *
  */
+#include <chrono>
 #include <memory>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -80,6 +82,37 @@ class TestRoute {
   mc_res_t result_;
 };
 
+template <class RouteHandleIf>
+class DelayedTestRoute {
+ public:
+  DelayedTestRoute(
+      std::string name,
+      std::chrono::microseconds delay,
+      mc_res_t result = mc_res_ok)
+      : name_(std::move(name)), delay_(delay), result_(result) {}
+
+  template <class Request>
+  void traverse(const Request&, const RouteHandleTraverser<RouteHandleIf>&)
+      const {}
+
+  template <class Request>
+  ReplyT<Request> route(const Request& /* req */) {
+    std::this_thread::sleep_for(delay_);
+    ReplyT<Request> reply(result_);
+    reply.value() = folly::IOBuf(folly::IOBuf::COPY_BUFFER, name_);
+    return reply;
+  }
+
+  static std::string routeName() {
+    return "delayed-test-route";
+  }
+
+ private:
+  std::string name_;
+  std::chrono::microseconds delay_;
+  mc_res_t result_;
+};
+
 } // anonymous namespace
 
 TEST(LoadBalancerRouteTest, basic) {
@@ -640,3 +673,65 @@ TEST(CpuLoadBalancerRouteTest, LoadsWithWaitTwoChoice) {
   EXPECT_TRUE((cmap["cpub"] >= 35) && (cmap["cpub"] <= 47));
   EXPECT_TRUE((cmap["cpuc"] >= 35) && (cmap["cpuc"] <= 47));
 }
+
+TEST(LoadBalancerRouteTest, peakEwmaAvoidsSlowChild) {
+  std::vector<std::shared_ptr<TestRouteHandleIf>> testHandles{
+      makeRouteHandle<TestRouteHandleIf, DelayedTestRoute>(
+          "fasta", std::chrono::microseconds(0)),
+      makeRouteHandle<TestRouteHandleIf, DelayedTestRoute>(
+          "fastb", std::chrono::microseconds(0)),
+      makeRouteHandle<TestRouteHandleIf, DelayedTestRoute>(
+          "slow", std::chrono::microseconds(5000))};
+
+  TestRouteHandle<LoadBalancerRoute<TestRouterInfo>> rh(
+      testHandles,
+      "",
+      std::chrono::milliseconds(100),
+      ServerLoad::fromPercentLoad(50),
+      /* failoverCount */ 1,
+      LoadBalancerRoute<TestRouterInfo>::AlgorithmType::PEAK_EWMA,
+      /* fixed seed */ 0,
+      /* ewmaDecayTime */ std::chrono::seconds(10));
+
+  std::unordered_map<std::string, size_t> cmap;
+  for (int i = 0; i < 100; i++) {
+    auto reply = rh.route(McGetRequest("0" + std::to_string(i)));
+    cmap[carbon::valueRangeSlow(reply).str()]++;
+  }
+  LOG(INFO) << cmap["fasta"] << " " << cmap["fastb"] << " " << cmap["slow"];
+  // The slow child is only picked while it hasn't been measured yet.
+  EXPECT_LE(cmap["slow"], 2);
+  EXPECT_EQ(100, cmap["fasta"] + cmap["fastb"] + cmap["slow"]);
+}
+
+TEST(LoadBalancerRouteTest, peakEwmaAvoidsFastErroringChild) {
+  std::vector<std::shared_ptr<TestRouteHandleIf>> testHandles{
+      makeRouteHandle<TestRouteHandleIf, DelayedTestRoute>(
+          "fasta", std::chrono::microseconds(1000)),
+      makeRouteHandle<TestRouteHandleIf, DelayedTestRoute>(
+          "fastb", std::chrono::microseconds(1000)),
+      makeRouteHandle<TestRouteHandleIf, DelayedTestRoute>(
+          "broken", std::chrono::microseconds(0), mc_res_connect_error)};
+
+  TestRouteHandle<LoadBalancerRoute<TestRouterInfo>> rh(
+      testHandles,
+      "",
+      std::chrono::milliseconds(100),
+      ServerLoad::fromPercentLoad(50),
+      /* failoverCount */ 1,
+      LoadBalancerRoute<TestRouterInfo>::AlgorithmType::PEAK_EWMA,
+      /* fixed seed */ 0,
+      /* ewmaDecayTime */ std::chrono::seconds(10),
+      /* ewmaErrorPenalty */ std::chrono::seconds(1));
+
+  std::unordered_map<std::string, size_t> cmap;
+  for (int i = 0; i < 100; i++) {
+    auto reply = rh.route(McGetRequest("0" + std::to_string(i)));
+    cmap[carbon::valueRangeSlow(reply).str()]++;
+  }
+  LOG(INFO) << cmap["fasta"] << " " << cmap["fastb"] << " " << cmap["broken"];
+  // Replying faster than the others doesn't make the broken child win: it
+  // is only picked while it hasn't been measured yet.
+  EXPECT_LE(cmap["broken"], 2);
+  EXPECT_EQ(100, cmap["fasta"] + cmap["fastb"] + cmap["broken"]);
+}
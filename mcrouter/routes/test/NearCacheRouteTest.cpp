@@ -0,0 +1,95 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/lib/network/gen/Memcache.h"
+#include "mcrouter/routes/NearCacheRoute.h"
+#include "mcrouter/routes/test/RouteHandleTestUtil.h"
+
+using namespace facebook::memcache;
+using namespace facebook::memcache::mcrouter;
+
+namespace {
+
+NearCache::Options testOptions() {
+  NearCache::Options opts;
+  opts.capacity = 16;
+  opts.ttl = std::chrono::milliseconds(60000);
+  opts.admissionThreshold = 2;
+  return opts;
+}
+
+} // anonymous namespace
+
+TEST(nearCacheRouteTest, hotKeyIsServedFromCache) {
+  auto normalHandle =
+      std::make_shared<TestHandle>(GetRouteTestData(mc_res_found, "a"));
+  McrouterRouteHandle<NearCacheRoute<McrouterRouterInfo>> rh(
+      normalHandle->rh, testOptions());
+
+  TestFiberManager testfm{
+      typename fiber_local<MemcacheRouterInfo>::ContextTypeTag()};
+
+  McGetRequest req("key");
+  for (size_t i = 0; i < 5; ++i) {
+    auto reply = routeInFiber(testfm, rh, req);
+    EXPECT_EQ(mc_res_found, reply.result());
+    EXPECT_EQ("a", carbon::valueRangeSlow(reply).str());
+  }
+
+  // First miss isn't hot yet, second one gets admitted, the rest are hits.
+  EXPECT_EQ(
+      std::vector<std::string>({"key", "key"}), normalHandle->saw_keys);
+}
+
+TEST(nearCacheRouteTest, missesAreNotCached) {
+  auto normalHandle =
+      std::make_shared<TestHandle>(GetRouteTestData(mc_res_notfound, ""));
+  McrouterRouteHandle<NearCacheRoute<McrouterRouterInfo>> rh(
+      normalHandle->rh, testOptions());
+
+  TestFiberManager testfm{
+      typename fiber_local<MemcacheRouterInfo>::ContextTypeTag()};
+
+  McGetRequest req("key");
+  for (size_t i = 0; i < 4; ++i) {
+    EXPECT_EQ(mc_res_notfound, routeInFiber(testfm, rh, req).result());
+  }
+  EXPECT_EQ(4, normalHandle->saw_keys.size());
+}
+
+TEST(nearCacheRouteTest, deleteInvalidates) {
+  auto normalHandle = std::make_shared<TestHandle>(
+      GetRouteTestData(mc_res_found, "a"),
+      UpdateRouteTestData(mc_res_stored),
+      DeleteRouteTestData(mc_res_deleted));
+  McrouterRouteHandle<NearCacheRoute<McrouterRouterInfo>> rh(
+      normalHandle->rh, testOptions());
+
+  TestFiberManager testfm{
+      typename fiber_local<MemcacheRouterInfo>::ContextTypeTag()};
+
+  McGetRequest get("key");
+  routeInFiber(testfm, rh, get);
+  routeInFiber(testfm, rh, get);
+  routeInFiber(testfm, rh, get);
+  EXPECT_EQ(2, normalHandle->saw_keys.size());
+
+  McDeleteRequest del("key");
+  EXPECT_EQ(mc_res_deleted, routeInFiber(testfm, rh, del).result());
+  EXPECT_EQ(3, normalHandle->saw_keys.size());
+
+  // Still hot, so the next get goes to the child and is re-admitted.
+  routeInFiber(testfm, rh, get);
+  routeInFiber(testfm, rh, get);
+  EXPECT_EQ(4, normalHandle->saw_keys.size());
+}
@@ -0,0 +1,137 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <folly/Conv.h>
+
+#include "mcrouter/lib/network/gen/Memcache.h"
+#include "mcrouter/routes/NegativeCacheRoute.h"
+#include "mcrouter/routes/test/RouteHandleTestUtil.h"
+
+using namespace facebook::memcache;
+using namespace facebook::memcache::mcrouter;
+
+namespace {
+
+NegativeCache::Options testOptions() {
+  NegativeCache::Options opts;
+  opts.capacity = 16;
+  opts.ttl = std::chrono::milliseconds(60000);
+  return opts;
+}
+
+} // anonymous namespace
+
+TEST(negativeCacheTest, insertEraseExpire) {
+  NegativeCache::Options opts;
+  opts.capacity = 64;
+  opts.ttl = std::chrono::milliseconds(100);
+  NegativeCache cache(opts);
+
+  EXPECT_FALSE(cache.contains("a", 1000));
+  cache.insert("a", 1000);
+  cache.insert("b", 1000);
+  EXPECT_TRUE(cache.contains("a", 1099));
+  EXPECT_TRUE(cache.contains("b", 1099));
+  EXPECT_FALSE(cache.contains("a", 1100));
+
+  cache.erase("b");
+  EXPECT_FALSE(cache.contains("b", 1050));
+
+  // Inserting again refreshes the TTL.
+  cache.insert("a", 1100);
+  EXPECT_TRUE(cache.contains("a", 1150));
+}
+
+TEST(negativeCacheTest, boundedCapacity) {
+  NegativeCache::Options opts;
+  opts.capacity = 1;
+  opts.ttl = std::chrono::milliseconds(1000);
+  NegativeCache cache(opts);
+  ASSERT_EQ(2 * NegativeCache::kSlotsPerBucket, cache.capacity());
+
+  const size_t kKeys = 100;
+  for (size_t i = 0; i < kKeys; ++i) {
+    cache.insert(folly::to<std::string>("key", i), i);
+  }
+  size_t remembered = 0;
+  for (size_t i = 0; i < kKeys; ++i) {
+    if (cache.contains(folly::to<std::string>("key", i), kKeys)) {
+      ++remembered;
+    }
+  }
+  EXPECT_LE(remembered, cache.capacity());
+  // The latest insert always finds a slot.
+  EXPECT_TRUE(cache.contains(folly::to<std::string>("key", kKeys - 1), kKeys));
+}
+
+TEST(negativeCacheRouteTest, missIsRemembered) {
+  auto normalHandle =
+      std::make_shared<TestHandle>(GetRouteTestData(mc_res_notfound, ""));
+  McrouterRouteHandle<NegativeCacheRoute<McrouterRouterInfo>> rh(
+      normalHandle->rh, testOptions());
+
+  TestFiberManager testfm{
+      typename fiber_local<MemcacheRouterInfo>::ContextTypeTag()};
+
+  McGetRequest req("key");
+  for (size_t i = 0; i < 4; ++i) {
+    EXPECT_EQ(mc_res_notfound, routeInFiber(testfm, rh, req).result());
+  }
+  EXPECT_EQ(std::vector<std::string>({"key"}), normalHandle->saw_keys);
+}
+
+TEST(negativeCacheRouteTest, hitsAreNotRemembered) {
+  auto normalHandle =
+      std::make_shared<TestHandle>(GetRouteTestData(mc_res_found, "a"));
+  McrouterRouteHandle<NegativeCacheRoute<McrouterRouterInfo>> rh(
+      normalHandle->rh, testOptions());
+
+  TestFiberManager testfm{
+      typename fiber_local<MemcacheRouterInfo>::ContextTypeTag()};
+
+  McGetRequest req("key");
+  for (size_t i = 0; i < 3; ++i) {
+    auto reply = routeInFiber(testfm, rh, req);
+    EXPECT_EQ(mc_res_found, reply.result());
+    EXPECT_EQ("a", carbon::valueRangeSlow(reply).str());
+  }
+  EXPECT_EQ(3, normalHandle->saw_keys.size());
+}
+
+TEST(negativeCacheRouteTest, setInvalidates) {
+  auto normalHandle = std::make_shared<TestHandle>(
+      GetRouteTestData(mc_res_notfound, ""),
+      UpdateRouteTestData(mc_res_stored),
+      DeleteRouteTestData(mc_res_deleted));
+  McrouterRouteHandle<NegativeCacheRoute<McrouterRouterInfo>> rh(
+      normalHandle->rh, testOptions());
+
+  TestFiberManager testfm{
+      typename fiber_local<MemcacheRouterInfo>::ContextTypeTag()};
+
+  McGetRequest get("key");
+  routeInFiber(testfm, rh, get);
+  routeInFiber(testfm, rh, get);
+  EXPECT_EQ(1, normalHandle->saw_keys.size());
+
+  McSetRequest set("key");
+  set.value() = folly::IOBuf(folly::IOBuf::COPY_BUFFER, "v");
+  EXPECT_EQ(mc_res_stored, routeInFiber(testfm, rh, set).result());
+  EXPECT_EQ(2, normalHandle->saw_keys.size());
+
+  // The miss was forgotten, so the next get goes to the child.
+  routeInFiber(testfm, rh, get);
+  EXPECT_EQ(3, normalHandle->saw_keys.size());
+  routeInFiber(testfm, rh, get);
+  EXPECT_EQ(3, normalHandle->saw_keys.size());
+}
@@ -29,20 +29,29 @@ std::string makeKey(uint64_t id) {
 void sendRequest(
     folly::fibers::FiberManager& fm,
     McrouterRouteHandleIf& rh,
-    size_t id,
+    std::string key,
     uint64_t senderId,
     std::vector<std::string>& replyOrder) {
   auto context = getTestContext();
   context->setSenderIdForTest(senderId);
 
-  fm.addTask([&rh, id, context, &replyOrder]() {
-    McGetRequest request(makeKey(id));
+  fm.addTask([&rh, key = std::move(key), context, &replyOrder]() {
+    McGetRequest request(key);
     fiber_local<MemcacheRouterInfo>::setSharedCtx(std::move(context));
     rh.route(request);
-    replyOrder.push_back(makeKey(id));
+    replyOrder.push_back(key);
   });
 }
 
+void sendRequest(
+    folly::fibers::FiberManager& fm,
+    McrouterRouteHandleIf& rh,
+    size_t id,
+    uint64_t senderId,
+    std::vector<std::string>& replyOrder) {
+  sendRequest(fm, rh, makeKey(id), senderId, replyOrder);
+}
+
 TEST(oustandingLimitRouteTest, basic) {
   auto normalHandle =
       std::make_shared<TestHandle>(GetRouteTestData(mc_res_found, "a"));
@@ -96,3 +105,96 @@ TEST(oustandingLimitRouteTest, basic) {
   EXPECT_EQ(makeKey(13), replyOrder[12]);
   EXPECT_EQ(makeKey(7), replyOrder[13]);
 }
+
+TEST(oustandingLimitRouteTest, deficitRoundRobin) {
+  auto normalHandle =
+      std::make_shared<TestHandle>(GetRouteTestData(mc_res_found, "a"));
+
+  // Each turn, a sender may send up to 100 bytes worth of keys.
+  McrouterRouteHandle<OutstandingLimitRoute<McrouterRouterInfo>> rh(
+      normalHandle->rh, 1, OutstandingLimitFairness::SENDER_ID, 100);
+
+  normalHandle->pause();
+
+  std::vector<std::string> replyOrder;
+
+  TestFiberManager testfm{
+      typename fiber_local<MemcacheRouterInfo>::ContextTypeTag()};
+  auto& fm = testfm.getFiberManager();
+
+  auto longKey = [](size_t i) {
+    return folly::sformat("{}:{}", std::string(58, 'l'), i);
+  };
+  auto shortKey = [](size_t i) { return folly::sformat("s:{}", i); };
+
+  sendRequest(fm, rh, "first", 3, replyOrder);
+  for (size_t i = 1; i <= 3; ++i) {
+    sendRequest(fm, rh, longKey(i), 1, replyOrder);
+  }
+  for (size_t i = 1; i <= 3; ++i) {
+    sendRequest(fm, rh, shortKey(i), 2, replyOrder);
+  }
+
+  auto& loopController =
+      dynamic_cast<folly::fibers::SimpleLoopController&>(fm.loopController());
+  loopController.loop([&]() {
+    fm.addTask([&]() { normalHandle->unpause(); });
+    loopController.stop();
+  });
+
+  // Sender 1 can only afford one 60 byte key per turn, while sender 2 sends
+  // all of its 3 byte keys in a single turn.
+  EXPECT_EQ(
+      std::vector<std::string>({"first",
+                                longKey(1),
+                                shortKey(1),
+                                shortKey(2),
+                                shortKey(3),
+                                longKey(2),
+                                longKey(3)}),
+      replyOrder);
+}
+
+TEST(oustandingLimitRouteTest, deficitRoundRobinCostlyRequests) {
+  auto normalHandle =
+      std::make_shared<TestHandle>(GetRouteTestData(mc_res_found, "a"));
+
+  // Requests cost 100-200 times the quantum.
+  McrouterRouteHandle<OutstandingLimitRoute<McrouterRouterInfo>> rh(
+      normalHandle->rh, 1, OutstandingLimitFairness::SENDER_ID, 1);
+
+  normalHandle->pause();
+
+  std::vector<std::string> replyOrder;
+
+  TestFiberManager testfm{
+      typename fiber_local<MemcacheRouterInfo>::ContextTypeTag()};
+  auto& fm = testfm.getFiberManager();
+
+  auto key200 = [](size_t i) {
+    return folly::sformat("{}:{}", std::string(198, 'a'), i);
+  };
+  auto key100 = [](size_t i) {
+    return folly::sformat("{}:{}", std::string(98, 'b'), i);
+  };
+
+  sendRequest(fm, rh, "first", 3, replyOrder);
+  sendRequest(fm, rh, key200(1), 1, replyOrder);
+  sendRequest(fm, rh, key200(2), 1, replyOrder);
+  sendRequest(fm, rh, key100(1), 2, replyOrder);
+  sendRequest(fm, rh, key100(2), 2, replyOrder);
+
+  auto& loopController =
+      dynamic_cast<folly::fibers::SimpleLoopController&>(fm.loopController());
+  loopController.loop([&]() {
+    fm.addTask([&]() { normalHandle->unpause(); });
+    loopController.stop();
+  });
+
+  // Same order as one quantum per turn: sender 2 can afford a request every
+  // 100 turns, sender 1 every 200 turns and goes first within a turn.
+  EXPECT_EQ(
+      std::vector<std::string>(
+          {"first", key100(1), key200(1), key100(2), key200(2)}),
+      replyOrder);
+}
@@ -130,3 +130,43 @@ TEST(rateLimitRouteTest, deletesBasic) {
 TEST(rateLimitRouteTest, deletesBurst) {
   testDeletes(true);
 }
+
+TEST(rateLimitRouteTest, sharedBuckets) {
+  vector<std::shared_ptr<TestHandle>> normalHandle{
+      make_shared<TestHandle>(GetRouteTestData(mc_res_found, "a")),
+  };
+  auto normalRh = get_route_handles(normalHandle)[0];
+
+  auto json = parseJsonString(
+      "{\"shared_name\": \"test\", \"gets_rate\": 2.0, \"gets_burst\": 4.0}");
+  SharedTokenBucketMap sharedBuckets;
+
+  // E.g. the same route in the configs of two proxies.
+  McrouterRouteHandle<RateLimitRoute<McrouterRouteHandleIf>> rh1(
+      normalRh, RateLimiter(json, &sharedBuckets));
+  McrouterRouteHandle<RateLimitRoute<McrouterRouteHandleIf>> rh2(
+      normalRh, RateLimiter(json, &sharedBuckets));
+
+  usleep(2001000);
+  McGetRequest req("key");
+  // Both routes take tokens from the same bucket of 4.
+  EXPECT_EQ(mc_res_found, rh1.route(req).result());
+  EXPECT_EQ(mc_res_found, rh2.route(req).result());
+  EXPECT_EQ(mc_res_found, rh1.route(req).result());
+  EXPECT_EQ(mc_res_found, rh2.route(req).result());
+  EXPECT_EQ(mc_res_notfound, rh1.route(req).result());
+  EXPECT_EQ(mc_res_notfound, rh2.route(req).result());
+
+  // Routes back off from the empty bucket, but not for longer than it takes
+  // a token to come back.
+  usleep(1001000);
+  EXPECT_EQ(mc_res_found, rh1.route(req).result());
+  EXPECT_EQ(mc_res_found, rh2.route(req).result());
+  EXPECT_EQ(mc_res_notfound, rh1.route(req).result());
+  EXPECT_EQ(mc_res_notfound, rh2.route(req).result());
+}
+
+TEST(rateLimitRouteTest, sharedNameWithoutSharedBuckets) {
+  auto json = parseJsonString("{\"shared_name\": \"test\", \"gets_rate\": 2}");
+  EXPECT_THROW(RateLimiter{json}, std::logic_error);
+}
@@ -0,0 +1,135 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/lib/network/gen/Memcache.h"
+#include "mcrouter/routes/RefreshAheadRoute.h"
+#include "mcrouter/routes/test/RouteHandleTestUtil.h"
+
+using namespace facebook::memcache;
+using namespace facebook::memcache::mcrouter;
+
+namespace {
+
+RefreshAhead::Options testOptions() {
+  RefreshAhead::Options opts;
+  opts.capacity = 16;
+  opts.refreshAhead = std::chrono::milliseconds(10000);
+  opts.hotThreshold = 2;
+  return opts;
+}
+
+McSetRequest setRequest(int32_t exptime) {
+  McSetRequest req("key");
+  req.value() = folly::IOBuf(folly::IOBuf::COPY_BUFFER, "b");
+  req.exptime() = exptime;
+  return req;
+}
+
+} // anonymous namespace
+
+TEST(RefreshAhead, tracksHotKeys) {
+  RefreshAhead refreshAhead(testOptions());
+  const int64_t nowMs = 1500000000000;
+
+  // Not hot yet.
+  refreshAhead.recordGet("key", nowMs);
+  refreshAhead.recordSet("key", 5, nowMs);
+  EXPECT_EQ(0, refreshAhead.size());
+
+  refreshAhead.recordGet("key", nowMs);
+  refreshAhead.recordSet("key", 60, nowMs);
+  EXPECT_EQ(1, refreshAhead.size());
+
+  // Too early, then exactly one get refreshes it.
+  EXPECT_FALSE(refreshAhead.recordGet("key", nowMs + 49000).hasValue());
+  auto exptime = refreshAhead.recordGet("key", nowMs + 51000);
+  ASSERT_TRUE(exptime.hasValue());
+  EXPECT_EQ(60, *exptime);
+  EXPECT_FALSE(refreshAhead.recordGet("key", nowMs + 52000).hasValue());
+
+  // Until it's set again.
+  refreshAhead.recordSet("key", 60, nowMs + 53000);
+  EXPECT_TRUE(refreshAhead.recordGet("key", nowMs + 104000).hasValue());
+
+  // No exptime, nothing to refresh.
+  refreshAhead.recordSet("key", 0, nowMs);
+  EXPECT_EQ(0, refreshAhead.size());
+
+  // Absolute exptime.
+  refreshAhead.recordSet("key", nowMs / 1000 + 5, nowMs);
+  exptime = refreshAhead.recordGet("key", nowMs);
+  ASSERT_TRUE(exptime.hasValue());
+  EXPECT_EQ(5, *exptime);
+}
+
+TEST(RefreshAheadRouteTest, oneClientRefreshes) {
+  auto normalHandle = std::make_shared<TestHandle>(
+      GetRouteTestData(mc_res_found, "a"),
+      UpdateRouteTestData(mc_res_stored),
+      DeleteRouteTestData(mc_res_deleted));
+  McrouterRouteHandle<RefreshAheadRoute<McrouterRouterInfo>> rh(
+      normalHandle->rh, nullptr, testOptions());
+
+  TestFiberManager testfm{
+      typename fiber_local<MemcacheRouterInfo>::ContextTypeTag()};
+
+  McGetRequest get("key");
+  routeInFiber(testfm, rh, get);
+  routeInFiber(testfm, rh, get);
+  // Expires within the refresh ahead window.
+  EXPECT_EQ(mc_res_stored, routeInFiber(testfm, rh, setRequest(5)).result());
+
+  EXPECT_EQ(mc_res_notfound, routeInFiber(testfm, rh, get).result());
+  EXPECT_EQ(mc_res_found, routeInFiber(testfm, rh, get).result());
+
+  // Refreshed by the client.
+  routeInFiber(testfm, rh, setRequest(5));
+  EXPECT_EQ(mc_res_notfound, routeInFiber(testfm, rh, get).result());
+
+  // Deletes stop tracking the key.
+  routeInFiber(testfm, rh, setRequest(5));
+  routeInFiber(testfm, rh, McDeleteRequest("key"));
+  EXPECT_EQ(mc_res_found, routeInFiber(testfm, rh, get).result());
+}
+
+TEST(RefreshAheadRouteTest, refillRoute) {
+  auto normalHandle = std::make_shared<TestHandle>(
+      GetRouteTestData(mc_res_found, "a"),
+      UpdateRouteTestData(mc_res_stored),
+      DeleteRouteTestData(mc_res_deleted));
+  auto refillHandle =
+      std::make_shared<TestHandle>(GetRouteTestData(mc_res_found, "c"));
+  McrouterRouteHandle<RefreshAheadRoute<McrouterRouterInfo>> rh(
+      normalHandle->rh, refillHandle->rh, testOptions());
+
+  TestFiberManager testfm{
+      typename fiber_local<MemcacheRouterInfo>::ContextTypeTag()};
+
+  McGetRequest get("key");
+  routeInFiber(testfm, rh, get);
+  routeInFiber(testfm, rh, get);
+  routeInFiber(testfm, rh, setRequest(5));
+
+  auto reply = routeInFiber(testfm, rh, get);
+  EXPECT_EQ(mc_res_found, reply.result());
+  EXPECT_EQ("a", carbon::valueRangeSlow(reply).str());
+  // Lets the background refresh finish.
+  testfm.run([]() {});
+
+  EXPECT_EQ(std::vector<std::string>({"key"}), refillHandle->saw_keys);
+  EXPECT_EQ(
+      std::vector<std::string>({"get", "get", "set", "get", "set"}),
+      normalHandle->sawOperations);
+  EXPECT_EQ(std::vector<std::string>({"b", "c"}), normalHandle->sawValues);
+  EXPECT_EQ(5, normalHandle->sawExptimes.back());
+}
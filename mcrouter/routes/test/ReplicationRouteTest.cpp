@@ -0,0 +1,109 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <folly/fibers/Baton.h>
+
+#include "mcrouter/lib/network/gen/Memcache.h"
+#include "mcrouter/routes/ReplicationRoute.h"
+#include "mcrouter/routes/test/RouteHandleTestUtil.h"
+
+using namespace facebook::memcache;
+using namespace facebook::memcache::mcrouter;
+
+namespace {
+
+McSetRequest makeSet(folly::StringPiece key, folly::StringPiece value) {
+  McSetRequest req(key);
+  req.value() = folly::IOBuf(folly::IOBuf::COPY_BUFFER, value);
+  return req;
+}
+
+// Lets the pending writes go out.
+void waitForFlush() {
+  folly::fibers::Baton baton;
+  baton.try_wait_for(std::chrono::milliseconds(50));
+}
+
+} // anonymous
+
+TEST(replicationRouteTest, coalescesWritesToTheSameKey) {
+  auto target = std::make_shared<TestHandle>(
+      GetRouteTestData(mc_res_found, "a"),
+      UpdateRouteTestData(mc_res_stored),
+      DeleteRouteTestData(mc_res_deleted));
+  McrouterRouteHandle<ReplicationRoute<McrouterRouterInfo>> rh(
+      target->rh, std::chrono::milliseconds(1), 1000, "");
+
+  TestFiberManager testfm{
+      typename fiber_local<MemcacheRouterInfo>::ContextTypeTag()};
+  testfm.run([&]() {
+    fiber_local<MemcacheRouterInfo>::setSharedCtx(getTestContext());
+    rh.route(makeSet("a", "1"));
+    rh.route(McDeleteRequest("b"));
+    rh.route(makeSet("a", "2"));
+    rh.route(McDeleteRequest("b"));
+    rh.route(McDeleteRequest("c"));
+    rh.route(makeSet("c", "3"));
+    // Not delayed.
+    EXPECT_EQ(mc_res_found, rh.route(McGetRequest("d")).result());
+    EXPECT_EQ(std::vector<std::string>{"d"}, target->saw_keys);
+
+    waitForFlush();
+  });
+
+  EXPECT_EQ(std::vector<std::string>({"d", "a", "b", "c"}), target->saw_keys);
+  EXPECT_EQ(
+      std::vector<std::string>({"get", "set", "delete", "set"}),
+      target->sawOperations);
+  EXPECT_EQ(std::vector<std::string>({"2", "3"}), target->sawValues);
+}
+
+TEST(replicationRouteTest, flushesFullBatches) {
+  auto target =
+      std::make_shared<TestHandle>(UpdateRouteTestData(mc_res_stored));
+  McrouterRouteHandle<ReplicationRoute<McrouterRouterInfo>> rh(
+      target->rh, std::chrono::milliseconds(60000), 2, "");
+
+  TestFiberManager testfm{
+      typename fiber_local<MemcacheRouterInfo>::ContextTypeTag()};
+  testfm.run([&]() {
+    fiber_local<MemcacheRouterInfo>::setSharedCtx(getTestContext());
+    rh.route(makeSet("a", "1"));
+    rh.route(makeSet("b", "2"));
+    waitForFlush();
+  });
+
+  EXPECT_EQ(std::vector<std::string>({"a", "b"}), target->saw_keys);
+}
+
+TEST(replicationRouteTest, failedSetsAreInvalidated) {
+  auto target = std::make_shared<TestHandle>(
+      GetRouteTestData(),
+      UpdateRouteTestData(mc_res_timeout),
+      DeleteRouteTestData(mc_res_deleted));
+  McrouterRouteHandle<ReplicationRoute<McrouterRouterInfo>> rh(
+      target->rh, std::chrono::milliseconds(1), 1000, "");
+
+  TestFiberManager testfm{
+      typename fiber_local<MemcacheRouterInfo>::ContextTypeTag()};
+  testfm.run([&]() {
+    fiber_local<MemcacheRouterInfo>::setSharedCtx(getTestContext());
+    rh.route(makeSet("a", "1"));
+    waitForFlush();
+  });
+
+  EXPECT_EQ(std::vector<std::string>({"a", "a"}), target->saw_keys);
+  EXPECT_EQ(
+      std::vector<std::string>({"set", "delete"}), target->sawOperations);
+}
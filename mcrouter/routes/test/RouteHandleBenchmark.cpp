@@ -0,0 +1,337 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <folly/Benchmark.h>
+#include <folly/Conv.h>
+#include <folly/Format.h>
+#include <folly/dynamic.h>
+#include <folly/init/Init.h>
+#include <glog/logging.h>
+
+#include "mcrouter/lib/SelectionRouteFactory.h"
+#include "mcrouter/lib/fbi/cpp/globals.h"
+#include "mcrouter/lib/network/gen/Memcache.h"
+#include "mcrouter/lib/routes/AllAsyncRoute.h"
+#include "mcrouter/lib/routes/AllFastestRoute.h"
+#include "mcrouter/lib/routes/AllInitialRoute.h"
+#include "mcrouter/lib/routes/AllMajorityRoute.h"
+#include "mcrouter/lib/routes/AllSyncRoute.h"
+#include "mcrouter/lib/test/RouteHandleTestUtil.h"
+#include "mcrouter/routes/BigValueRoute.h"
+#include "mcrouter/routes/DefaultShadowPolicy.h"
+#include "mcrouter/routes/FailoverRoute.h"
+#include "mcrouter/routes/LoadBalancerRoute.h"
+#include "mcrouter/routes/McrouterRouteHandle.h"
+#include "mcrouter/routes/ShadowRoute.h"
+#include "mcrouter/routes/ShadowRouteIf.h"
+#include "mcrouter/routes/ShadowSettings.h"
+#include "mcrouter/routes/ShardHashFunc.h"
+#include "mcrouter/routes/ShardSplitRoute.h"
+#include "mcrouter/routes/WarmUpRoute.h"
+#include "mcrouter/routes/test/RouteHandleTestUtil.h"
+
+/**
+ * Measures the overhead of individual routes: every route is benchmarked on
+ * top of destinations that reply right away, so time and allocations per
+ * request are the route's own (plus the fibers it spawns).
+ *
+ * Allocations per request are counted by replacing operator new, and
+ * printed after the benchmarks.
+ */
+
+namespace {
+size_t numAllocations = 0;
+} // anonymous namespace
+
+void* operator new(size_t size) {
+  ++numAllocations;
+  if (auto p = std::malloc(size)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  std::free(p);
+}
+
+using namespace facebook::memcache;
+using namespace facebook::memcache::mcrouter;
+
+namespace {
+
+constexpr size_t kNumChildren = 4;
+constexpr size_t kNumKeys = 1024;
+constexpr size_t kNumShards = 16;
+
+/**
+ * Stands in for a destination: replies right away with a fixed result.
+ */
+class FixedReplyRoute {
+ public:
+  static std::string routeName() {
+    return "fixed-reply";
+  }
+
+  template <class Request>
+  void traverse(
+      const Request&,
+      const RouteHandleTraverser<McrouterRouteHandleIf>&) const {}
+
+  explicit FixedReplyRoute(mc_res_t result) : result_(result) {}
+
+  template <class Request>
+  ReplyT<Request> route(const Request&) const {
+    return ReplyT<Request>(result_);
+  }
+
+ private:
+  const mc_res_t result_;
+};
+
+/**
+ * Picks the child by the shard id of the key ("prefix:<shard>:suffix"), like
+ * the shard selectors of ShardSelectionRouteFactory.
+ */
+class KeyShardSelector {
+ public:
+  std::string type() const {
+    return "key-shard-selector";
+  }
+
+  template <class Request>
+  size_t select(const Request& req, size_t size) const {
+    folly::StringPiece shardId;
+    if (!getShardId(req.key().routingKey(), shardId)) {
+      return size;
+    }
+    return folly::to<size_t>(shardId) % size;
+  }
+};
+
+McrouterRouteHandlePtr makeLeaf(mc_res_t result) {
+  return std::make_shared<McrouterRouteHandle<FixedReplyRoute>>(result);
+}
+
+std::vector<McrouterRouteHandlePtr> makeLeaves(mc_res_t result) {
+  std::vector<McrouterRouteHandlePtr> leaves;
+  for (size_t i = 0; i < kNumChildren; ++i) {
+    leaves.push_back(makeLeaf(result));
+  }
+  return leaves;
+}
+
+McrouterRouteHandlePtr makeLeafRoute() {
+  return makeLeaf(mc_res_found);
+}
+
+// The first child times out, so every request fails over once.
+McrouterRouteHandlePtr makeFailoverRoute() {
+  std::vector<McrouterRouteHandlePtr> children{makeLeaf(mc_res_timeout),
+                                               makeLeaf(mc_res_found)};
+  return makeFailoverRouteInOrder<McrouterRouterInfo, FailoverRoute>(
+      std::move(children),
+      FailoverErrorsSettings(),
+      nullptr,
+      /* failoverTagging */ false,
+      /* enableLeasePairing */ false,
+      "",
+      nullptr);
+}
+
+McrouterRouteHandlePtr makeLoadBalancerRoute() {
+  return std::make_shared<
+      McrouterRouteHandle<LoadBalancerRoute<McrouterRouterInfo>>>(
+      makeLeaves(mc_res_found),
+      "" /* salt */,
+      std::chrono::milliseconds(100) /* loadTtl */,
+      ServerLoad::zero(),
+      1 /* failoverCount */);
+}
+
+// Every request is shadowed.
+McrouterRouteHandlePtr makeShadowRoute() {
+  auto settings = ShadowSettings::create(
+      folly::dynamic::object("index_range", folly::dynamic::array(0, 1)),
+      *getTestRouter());
+  settings->setKeyRange(0, 1);
+  McrouterShadowData shadowData{{makeLeaf(mc_res_found), settings}};
+  return std::make_shared<McrouterRouteHandle<
+      ShadowRoute<McrouterRouterInfo, DefaultShadowPolicy>>>(
+      makeLeaf(mc_res_found), std::move(shadowData), DefaultShadowPolicy());
+}
+
+// Values are small, so requests are passed through.
+McrouterRouteHandlePtr makeBigValueRoute() {
+  return std::make_shared<McrouterRouteHandle<BigValueRoute>>(
+      makeLeaf(mc_res_found),
+      BigValueRouteOptions(1024 * 1024 /* threshold */, 32 /* batchSize */));
+}
+
+// Gets miss the cold child and are refilled from the warm one.
+McrouterRouteHandlePtr makeWarmUpRoute() {
+  return std::make_shared<
+      McrouterRouteHandle<WarmUpRoute<McrouterRouterInfo>>>(
+      makeLeaf(mc_res_found), makeLeaf(mc_res_notfound), folly::none);
+}
+
+template <template <class> class AllRoute>
+McrouterRouteHandlePtr makeAllRoute() {
+  return std::make_shared<McrouterRouteHandle<AllRoute<McrouterRouteHandleIf>>>(
+      makeLeaves(mc_res_stored));
+}
+
+// Every shard is split in kNumChildren.
+McrouterRouteHandlePtr makeShardSplitRoute() {
+  auto splits = folly::dynamic::object();
+  for (size_t i = 0; i < kNumShards; ++i) {
+    splits[folly::to<std::string>(i)] = kNumChildren;
+  }
+  return std::make_shared<
+      McrouterRouteHandle<ShardSplitRoute<McrouterRouterInfo>>>(
+      makeLeaf(mc_res_found), ShardSplitter(splits));
+}
+
+McrouterRouteHandlePtr makeShardSelectionRoute() {
+  return createSelectionRoute<McrouterRouterInfo, KeyShardSelector>(
+      makeLeaves(mc_res_found), KeyShardSelector());
+}
+
+// Allocations per request of the last run of every benchmark.
+std::map<std::string, double> allocationsPerRequest;
+
+template <class Request>
+void routeRequests(
+    size_t iters,
+    folly::StringPiece name,
+    McrouterRouteHandlePtr (*makeRoute)()) {
+  McrouterRouteHandlePtr rh;
+  std::vector<Request> requests;
+  BENCHMARK_SUSPEND {
+    rh = makeRoute();
+    for (size_t i = 0; i < kNumKeys; ++i) {
+      requests.emplace_back(folly::sformat("key:{}:{}", i % kNumShards, i));
+    }
+  }
+
+  // Not 0, so that ShardSplitRoute sends gets to a split.
+  globals::HostidMock hostidMock(1);
+  TestFiberManager testfm{fiber_local<McrouterRouterInfo>::ContextTypeTag()};
+  auto& fm = testfm.getFiberManager();
+  size_t allocationsBefore = 0;
+  fm.addTask([&]() {
+    mockFiberContext();
+    allocationsBefore = numAllocations;
+    for (size_t i = 0; i < iters; ++i) {
+      folly::doNotOptimizeAway(rh->route(requests[i % requests.size()]));
+    }
+  });
+  // Also runs the fibers spawned by the route.
+  fm.loopUntilNoReady();
+
+  BENCHMARK_SUSPEND {
+    allocationsPerRequest[name.str()] =
+        static_cast<double>(numAllocations - allocationsBefore) /
+        std::max<size_t>(iters, 1);
+  }
+}
+
+} // anonymous namespace
+
+BENCHMARK(leaf_get, iters) {
+  routeRequests<McGetRequest>(iters, "leaf_get", &makeLeafRoute);
+}
+
+BENCHMARK(FailoverRoute_get, iters) {
+  routeRequests<McGetRequest>(iters, "FailoverRoute_get", &makeFailoverRoute);
+}
+
+BENCHMARK(LoadBalancerRoute_get, iters) {
+  routeRequests<McGetRequest>(
+      iters, "LoadBalancerRoute_get", &makeLoadBalancerRoute);
+}
+
+BENCHMARK(ShadowRoute_get, iters) {
+  routeRequests<McGetRequest>(iters, "ShadowRoute_get", &makeShadowRoute);
+}
+
+BENCHMARK(BigValueRoute_get, iters) {
+  routeRequests<McGetRequest>(iters, "BigValueRoute_get", &makeBigValueRoute);
+}
+
+BENCHMARK(WarmUpRoute_get, iters) {
+  routeRequests<McGetRequest>(iters, "WarmUpRoute_get", &makeWarmUpRoute);
+}
+
+BENCHMARK(ShardSplitRoute_get, iters) {
+  routeRequests<McGetRequest>(
+      iters, "ShardSplitRoute_get", &makeShardSplitRoute);
+}
+
+BENCHMARK(ShardSelectionRoute_get, iters) {
+  routeRequests<McGetRequest>(
+      iters, "ShardSelectionRoute_get", &makeShardSelectionRoute);
+}
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK(leaf_set, iters) {
+  routeRequests<McSetRequest>(iters, "leaf_set", &makeLeafRoute);
+}
+
+BENCHMARK(AllSyncRoute_set, iters) {
+  routeRequests<McSetRequest>(
+      iters, "AllSyncRoute_set", &makeAllRoute<AllSyncRoute>);
+}
+
+BENCHMARK(AllAsyncRoute_set, iters) {
+  routeRequests<McSetRequest>(
+      iters, "AllAsyncRoute_set", &makeAllRoute<AllAsyncRoute>);
+}
+
+BENCHMARK(AllInitialRoute_set, iters) {
+  routeRequests<McSetRequest>(
+      iters, "AllInitialRoute_set", &makeAllRoute<AllInitialRoute>);
+}
+
+BENCHMARK(AllFastestRoute_set, iters) {
+  routeRequests<McSetRequest>(
+      iters, "AllFastestRoute_set", &makeAllRoute<AllFastestRoute>);
+}
+
+BENCHMARK(AllMajorityRoute_set, iters) {
+  routeRequests<McSetRequest>(
+      iters, "AllMajorityRoute_set", &makeAllRoute<AllMajorityRoute>);
+}
+
+BENCHMARK(ShardSplitRoute_delete, iters) {
+  routeRequests<McDeleteRequest>(
+      iters, "ShardSplitRoute_delete", &makeShardSplitRoute);
+}
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv, true /* removeFlags */);
+  folly::runBenchmarks();
+  for (const auto& kv : allocationsPerRequest) {
+    LOG(INFO) << folly::sformat(
+        "{:<32} {:>8.2f} allocations/request", kv.first, kv.second);
+  }
+  return 0;
+}
@@ -32,6 +32,22 @@ CarbonRouterInstance<McrouterRouterInfo>* getTestRouter();
 std::shared_ptr<ProxyRequestContextWithInfo<McrouterRouterInfo>>
 getTestContext();
 
+/**
+ * Routes req through rh on a fiber of testfm, with a test context set.
+ */
+template <class Request>
+ReplyT<Request> routeInFiber(
+    TestFiberManager& testfm,
+    McrouterRouteHandleIf& rh,
+    const Request& req) {
+  ReplyT<Request> reply;
+  testfm.run([&]() {
+    fiber_local<McrouterRouterInfo>::setSharedCtx(getTestContext());
+    reply = rh.route(req);
+  });
+  return reply;
+}
+
 /**
  * Set valid McrouterFiberContext in fiber locals
  */
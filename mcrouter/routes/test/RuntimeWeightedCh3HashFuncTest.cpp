@@ -0,0 +1,76 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <folly/Conv.h>
+#include <folly/dynamic.h>
+
+#include "mcrouter/RuntimeVarsData.h"
+#include "mcrouter/routes/RuntimeWeightedCh3HashFunc.h"
+
+using namespace facebook::memcache;
+using namespace facebook::memcache::mcrouter;
+
+namespace {
+
+// Checks that all keys go to the given server.
+void expectAllKeysTo(const RuntimeWeightedCh3HashFunc& func, size_t index) {
+  for (size_t i = 0; i < 100; ++i) {
+    EXPECT_EQ(index, func(folly::to<std::string>("key", i)));
+  }
+}
+
+void setRuntimeVars(ObservableRuntimeVars& rtVars, folly::StringPiece json) {
+  rtVars.set(std::make_shared<const RuntimeVarsData>(json));
+}
+
+} // anonymous namespace
+
+TEST(runtimeWeightedCh3HashFuncTest, configWeightsUntilSet) {
+  ObservableRuntimeVars rtVars;
+  RuntimeWeightedCh3HashFunc func(
+      folly::dynamic::object("weights_rv", "w")(
+          "weights", folly::dynamic::array(1.0, 0.0)),
+      2,
+      rtVars);
+  expectAllKeysTo(func, 0);
+
+  setRuntimeVars(rtVars, R"({"other": [0.0, 1.0]})");
+  expectAllKeysTo(func, 0);
+}
+
+TEST(runtimeWeightedCh3HashFuncTest, swapsWeights) {
+  ObservableRuntimeVars rtVars;
+  setRuntimeVars(rtVars, R"({"w": [0.0, 1.0, 0.0]})");
+  RuntimeWeightedCh3HashFunc func(
+      folly::dynamic::object("weights_rv", "w"), 3, rtVars);
+  auto copy = func;
+  expectAllKeysTo(func, 1);
+
+  setRuntimeVars(rtVars, R"({"w": [0.0, 0.0, 1.0]})");
+  expectAllKeysTo(func, 2);
+  expectAllKeysTo(copy, 2);
+  EXPECT_EQ(std::vector<double>({0.0, 0.0, 1.0}), func.weights());
+
+  // Invalid weights are ignored.
+  setRuntimeVars(rtVars, R"({"w": [1.0, 0.0]})");
+  setRuntimeVars(rtVars, R"({"w": [2.0, 0.0, 0.0]})");
+  expectAllKeysTo(func, 2);
+}
+
+TEST(runtimeWeightedCh3HashFuncTest, invalidConfig) {
+  ObservableRuntimeVars rtVars;
+  EXPECT_THROW(
+      RuntimeWeightedCh3HashFunc(
+          folly::dynamic::object("weights_rv", 1), 2, rtVars),
+      std::logic_error);
+}
@@ -0,0 +1,91 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <random>
+#include <unordered_map>
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/routes/ShardDestinationMap.h"
+
+using namespace facebook::memcache::mcrouter;
+
+namespace {
+
+void checkMatches(
+    const ShardDestinationMap& map,
+    const std::unordered_map<uint32_t, uint32_t>& expected) {
+  EXPECT_EQ(expected.size(), map.size());
+  for (const auto& it : expected) {
+    EXPECT_EQ(it.second, map.find(it.first)) << "shard " << it.first;
+  }
+}
+
+} // anonymous namespace
+
+TEST(ShardDestinationMap, empty) {
+  ShardDestinationMap map;
+  map.freeze();
+  EXPECT_EQ(0, map.size());
+  EXPECT_EQ(ShardDestinationMap::kNotFound, map.find(0));
+  EXPECT_EQ(ShardDestinationMap::kNotFound, map.find(12345));
+}
+
+TEST(ShardDestinationMap, dense) {
+  ShardDestinationMap map;
+  std::unordered_map<uint32_t, uint32_t> expected;
+  for (uint32_t shard = 1; shard < 1000; shard += 2) {
+    map.set(shard, shard % 7);
+    expected[shard] = shard % 7;
+  }
+  EXPECT_TRUE(map.contains(1));
+  EXPECT_FALSE(map.contains(2));
+  // overrides the previous mapping
+  map.set(1, 3);
+  expected[1] = 3;
+  map.freeze();
+
+  EXPECT_TRUE(map.isDense());
+  checkMatches(map, expected);
+  EXPECT_EQ(ShardDestinationMap::kNotFound, map.find(0));
+  EXPECT_EQ(ShardDestinationMap::kNotFound, map.find(2));
+  EXPECT_EQ(ShardDestinationMap::kNotFound, map.find(1000000));
+}
+
+TEST(ShardDestinationMap, sparse) {
+  std::mt19937 gen(1234);
+  for (size_t numShards : {1, 2, 3, 10, 5000}) {
+    ShardDestinationMap map;
+    std::unordered_map<uint32_t, uint32_t> expected;
+    // shard 0 collides with the contents of unused slots
+    map.set(0, 1);
+    expected[0] = 1;
+    while (expected.size() <= numShards) {
+      auto shard = static_cast<uint32_t>(gen());
+      map.set(shard, shard % 100);
+      expected[shard] = shard % 100;
+    }
+    map.freeze();
+
+    EXPECT_FALSE(map.isDense());
+    EXPECT_LE(map.memoryUsage(), 12 * expected.size() + 16);
+    checkMatches(map, expected);
+    for (size_t i = 0; i < 10000; ++i) {
+      auto shard = static_cast<uint32_t>(gen());
+      if (expected.find(shard) == expected.end()) {
+        EXPECT_EQ(ShardDestinationMap::kNotFound, map.find(shard));
+      }
+    }
+  }
+}
+
+TEST(ShardDestinationMap, setAfterFreeze) {
+  ShardDestinationMap map;
+  map.set(1, 1);
+  map.freeze();
+  EXPECT_THROW(map.set(2, 2), std::logic_error);
+}
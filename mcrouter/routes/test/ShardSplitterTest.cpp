@@ -6,10 +6,14 @@
  *
  */
 #include <chrono>
+#include <memory>
+#include <thread>
 
 #include <gtest/gtest.h>
 
+#include <folly/Conv.h>
 #include <folly/dynamic.h>
+#include <folly/experimental/FunctionScheduler.h>
 
 #include "mcrouter/lib/fbi/cpp/globals.h"
 #include "mcrouter/routes/ShardSplitter.h"
@@ -107,3 +111,55 @@ TEST(ShardSplitter, migration90Pct) {
   auto config = getConfigTemplate(nowInSec() - 6480);
   migrationTest(config, 0.9);
 }
+
+TEST(ShardSplitter, manyShards) {
+  auto config = folly::dynamic::object();
+  for (size_t i = 1; i <= 10000; ++i) {
+    config[folly::to<std::string>(i)] = i % 10 + 1;
+  }
+  ShardSplitter splitter(config);
+  EXPECT_EQ(9000, splitter.getShardSplits().size());
+  for (size_t i = 1; i <= 10000; ++i) {
+    auto key = folly::to<std::string>("abc:", i, ":");
+    folly::StringPiece shard;
+    auto split = splitter.getShardSplit(key, shard);
+    if (i % 10 == 0) {
+      // split size 1
+      EXPECT_EQ(nullptr, split);
+    } else {
+      ASSERT_NE(nullptr, split);
+      EXPECT_EQ(i % 10 + 1, split->getSplitSizeForCurrentHost());
+    }
+  }
+  folly::StringPiece shard;
+  EXPECT_EQ(nullptr, splitter.getShardSplit("abc:10001:", shard));
+}
+
+TEST(ShardSplitter, migrationTimer) {
+  auto scheduler = std::make_shared<folly::FunctionScheduler>();
+  scheduler->start();
+
+  // This host switches at 99% of a 100 seconds migration, i.e. ~1s from now.
+  HostidMock hostidMock(16384 * 99 / 100);
+  auto config = folly::dynamic::object(
+      "123",
+      folly::dynamic::object("old_split_size", 1)("new_split_size", 10)(
+          "migration_period", 100)("split_start", nowInSec() - 98));
+  ShardSplitter splitter(config, scheduler);
+  folly::StringPiece shard;
+  auto split = splitter.getShardSplit("abc:123:", shard);
+  ASSERT_NE(nullptr, split);
+  // The copy shares the migration state.
+  auto copy = splitter;
+  auto copySplit = copy.getShardSplit("abc:123:", shard);
+
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (split->getSplitSizeForCurrentHost() == 1 &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(10, split->getSplitSizeForCurrentHost());
+  EXPECT_EQ(10, copySplit->getSplitSizeForCurrentHost());
+
+  scheduler->shutdown();
+}
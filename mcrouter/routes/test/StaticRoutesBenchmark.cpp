@@ -0,0 +1,171 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <folly/Benchmark.h>
+#include <folly/init/Init.h>
+
+#include "mcrouter/lib/Ch3HashFunc.h"
+#include "mcrouter/lib/carbon/RequestReplyUtil.h"
+#include "mcrouter/lib/network/gen/Memcache.h"
+#include "mcrouter/lib/test/RouteHandleTestUtil.h"
+#include "mcrouter/routes/FailoverRoute.h"
+#include "mcrouter/routes/HashRouteFactory.h"
+#include "mcrouter/routes/McrouterRouteHandle.h"
+#include "mcrouter/routes/OperationSelectorRoute.h"
+#include "mcrouter/routes/StaticRoutes.h"
+#include "mcrouter/routes/test/RouteHandleTestUtil.h"
+
+using namespace facebook::memcache;
+using namespace facebook::memcache::mcrouter;
+
+namespace {
+
+constexpr size_t kPoolSize = 16;
+
+/**
+ * Stands in for a destination: replies right away with a fixed result.
+ * The first pool's hosts time out, so that gets fail over to the second
+ * pool.
+ */
+class FixedReplyRoute {
+ public:
+  static std::string routeName() {
+    return "fixed-reply";
+  }
+
+  template <class Request>
+  void traverse(
+      const Request&,
+      const RouteHandleTraverser<McrouterRouteHandleIf>&) const {}
+
+  explicit FixedReplyRoute(mc_res_t result) : result_(result) {}
+
+  template <class Request>
+  ReplyT<Request> route(const Request&) const {
+    return ReplyT<Request>(result_);
+  }
+
+ private:
+  const mc_res_t result_;
+};
+
+using Leaf = StaticChildRoute<McrouterRouterInfo, FixedReplyRoute>;
+using EdgeRoute = StaticOperationSelectorRoute<
+    McrouterRouterInfo,
+    carbon::List<McGetRequest>,
+    StaticFailoverRoute<
+        McrouterRouterInfo,
+        StaticHashRoute<McrouterRouterInfo, Leaf>>,
+    Leaf>;
+
+std::vector<McrouterRouteHandlePtr> makePool(mc_res_t result) {
+  std::vector<McrouterRouteHandlePtr> pool;
+  for (size_t i = 0; i < kPoolSize; ++i) {
+    pool.push_back(
+        std::make_shared<McrouterRouteHandle<FixedReplyRoute>>(result));
+  }
+  return pool;
+}
+
+/**
+ * The same tree, made of the regular route handles:
+ * OperationSelectorRoute -> FailoverRoute -> HashRoute -> hosts.
+ */
+McrouterRouteHandlePtr makeDynamicTree() {
+  std::vector<McrouterRouteHandlePtr> pools{
+      createHashRoute<McrouterRouterInfo>(
+          makePool(mc_res_timeout), "", Ch3HashFunc(kPoolSize)),
+      createHashRoute<McrouterRouterInfo>(
+          makePool(mc_res_found), "", Ch3HashFunc(kPoolSize))};
+  carbon::RequestIdMap<McrouterRouterInfo::RoutableRequests,
+                       McrouterRouteHandlePtr>
+      policies;
+  policies.set(
+      McGetRequest::typeId,
+      makeFailoverRouteInOrder<McrouterRouterInfo, FailoverRoute>(
+          std::move(pools),
+          FailoverErrorsSettings(),
+          nullptr,
+          /* failoverTagging */ false,
+          /* enableLeasePairing */ false,
+          "",
+          nullptr));
+  return std::make_shared<
+      McrouterRouteHandle<OperationSelectorRoute<McrouterRouterInfo>>>(
+      std::move(policies),
+      std::make_shared<McrouterRouteHandle<FixedReplyRoute>>(mc_res_stored));
+}
+
+McrouterRouteHandlePtr makeStaticTree() {
+  auto toLeaves = [](std::vector<McrouterRouteHandlePtr> pool) {
+    std::vector<Leaf> leaves;
+    for (auto& rh : pool) {
+      leaves.emplace_back(std::move(rh));
+    }
+    return StaticHashRoute<McrouterRouterInfo, Leaf>(std::move(leaves), "");
+  };
+  std::vector<StaticHashRoute<McrouterRouterInfo, Leaf>> pools;
+  pools.push_back(toLeaves(makePool(mc_res_timeout)));
+  pools.push_back(toLeaves(makePool(mc_res_found)));
+  return std::make_shared<McrouterRouteHandle<EdgeRoute>>(
+      StaticFailoverRoute<
+          McrouterRouterInfo,
+          StaticHashRoute<McrouterRouterInfo, Leaf>>(std::move(pools)),
+      Leaf(std::make_shared<McrouterRouteHandle<FixedReplyRoute>>(
+          mc_res_stored)));
+}
+
+template <class Request>
+void routeTree(size_t iters, McrouterRouteHandlePtr (*makeTree)()) {
+  McrouterRouteHandlePtr rh;
+  std::vector<Request> requests;
+  BENCHMARK_SUSPEND {
+    rh = makeTree();
+    for (size_t i = 0; i < 1024; ++i) {
+      requests.emplace_back("key" + std::to_string(i));
+    }
+  }
+
+  TestFiberManager fm;
+  fm.run([&]() {
+    mockFiberContext();
+    for (size_t i = 0; i < iters; ++i) {
+      auto reply = rh->route(requests[i % requests.size()]);
+      folly::doNotOptimizeAway(reply);
+    }
+  });
+}
+
+} // anonymous namespace
+
+BENCHMARK(get_dynamic, iters) {
+  routeTree<McGetRequest>(iters, &makeDynamicTree);
+}
+
+BENCHMARK_RELATIVE(get_static, iters) {
+  routeTree<McGetRequest>(iters, &makeStaticTree);
+}
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK(set_dynamic, iters) {
+  routeTree<McSetRequest>(iters, &makeDynamicTree);
+}
+
+BENCHMARK_RELATIVE(set_static, iters) {
+  routeTree<McSetRequest>(iters, &makeStaticTree);
+}
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv, true /* removeFlags */);
+  folly::runBenchmarks();
+  return 0;
+}
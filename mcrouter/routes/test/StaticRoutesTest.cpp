@@ -0,0 +1,118 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/lib/Ch3HashFunc.h"
+#include "mcrouter/lib/network/gen/Memcache.h"
+#include "mcrouter/routes/McrouterRouteHandle.h"
+#include "mcrouter/routes/StaticRoutes.h"
+#include "mcrouter/routes/test/RouteHandleTestUtil.h"
+
+using namespace facebook::memcache;
+using namespace facebook::memcache::mcrouter;
+
+namespace {
+
+using Leaf = StaticChildRoute<
+    McrouterRouterInfo,
+    RecordingRoute<McrouterRouteHandleIf>>;
+using Failover = StaticFailoverRoute<McrouterRouterInfo, Leaf>;
+using Hash = StaticHashRoute<McrouterRouterInfo, Leaf>;
+
+std::vector<Leaf> makeLeaves(
+    const std::vector<std::shared_ptr<TestHandle>>& handles) {
+  std::vector<Leaf> leaves;
+  for (const auto& handle : handles) {
+    leaves.emplace_back(handle->rh);
+  }
+  return leaves;
+}
+
+} // anonymous namespace
+
+TEST(staticRoutesTest, failover) {
+  std::vector<std::shared_ptr<TestHandle>> handles{
+      std::make_shared<TestHandle>(GetRouteTestData(mc_res_timeout, "a")),
+      std::make_shared<TestHandle>(GetRouteTestData(mc_res_found, "b")),
+      std::make_shared<TestHandle>(GetRouteTestData(mc_res_found, "c"))};
+  McrouterRouteHandle<Failover> rh(makeLeaves(handles));
+
+  TestFiberManager fm;
+  fm.run([&]() {
+    auto reply = rh.route(McGetRequest("key"));
+    EXPECT_EQ(mc_res_found, reply.result());
+    EXPECT_EQ("b", carbon::valueRangeSlow(reply).str());
+  });
+  EXPECT_EQ(std::vector<std::string>{"key"}, handles[0]->saw_keys);
+  EXPECT_EQ(std::vector<std::string>{"key"}, handles[1]->saw_keys);
+  EXPECT_TRUE(handles[2]->saw_keys.empty());
+}
+
+TEST(staticRoutesTest, hash) {
+  std::vector<std::shared_ptr<TestHandle>> handles;
+  for (size_t i = 0; i < 4; ++i) {
+    handles.push_back(
+        std::make_shared<TestHandle>(GetRouteTestData(mc_res_found, "a")));
+  }
+  McrouterRouteHandle<Hash> rh(makeLeaves(handles), "");
+
+  TestFiberManager fm;
+  fm.run([&]() {
+    for (size_t i = 0; i < 10; ++i) {
+      rh.route(McGetRequest("key" + std::to_string(i)));
+    }
+  });
+  Ch3HashFunc func(handles.size());
+  for (size_t i = 0; i < 10; ++i) {
+    auto key = "key" + std::to_string(i);
+    const auto& sawKeys = handles[func(key)]->saw_keys;
+    EXPECT_NE(sawKeys.end(), std::find(sawKeys.begin(), sawKeys.end(), key));
+  }
+}
+
+TEST(staticRoutesTest, operationSelector) {
+  auto getHandle =
+      std::make_shared<TestHandle>(GetRouteTestData(mc_res_found, "a"));
+  auto otherHandle = std::make_shared<TestHandle>(
+      GetRouteTestData(mc_res_found, "b"),
+      UpdateRouteTestData(mc_res_stored),
+      DeleteRouteTestData(mc_res_deleted));
+  McrouterRouteHandle<StaticOperationSelectorRoute<
+      McrouterRouterInfo,
+      carbon::List<McGetRequest>,
+      Leaf,
+      Leaf>>
+      rh(Leaf(getHandle->rh), Leaf(otherHandle->rh));
+
+  TestFiberManager fm;
+  fm.run([&]() {
+    EXPECT_EQ(mc_res_found, rh.route(McGetRequest("get")).result());
+    EXPECT_EQ(mc_res_stored, rh.route(McSetRequest("set")).result());
+    EXPECT_EQ(mc_res_deleted, rh.route(McDeleteRequest("delete")).result());
+  });
+  EXPECT_EQ(std::vector<std::string>{"get"}, getHandle->saw_keys);
+  EXPECT_EQ(
+      (std::vector<std::string>{"set", "delete"}), otherHandle->saw_keys);
+}
+
+TEST(staticRoutesTest, virtualLeaf) {
+  // Handles of other types are still called, through the interface.
+  auto handle =
+      std::make_shared<TestHandle>(GetRouteTestData(mc_res_found, "a"));
+  StaticChildRoute<McrouterRouterInfo> leaf(handle->rh);
+  TestFiberManager fm;
+  fm.run([&]() {
+    EXPECT_EQ(mc_res_found, leaf.route(McGetRequest("key")).result());
+  });
+  EXPECT_EQ(std::vector<std::string>{"key"}, handle->saw_keys);
+}
@@ -5,6 +5,8 @@
  *  file in the root directory of this source tree.
  *
  */
+#include <algorithm>
+#include <chrono>
 #include <functional>
 #include <memory>
 #include <string>
@@ -12,10 +14,12 @@
 
 #include <gtest/gtest.h>
 
+#include "mcrouter/lib/RefillLimiter.h"
 #include "mcrouter/lib/network/gen/Memcache.h"
 #include "mcrouter/lib/test/RouteHandleTestUtil.h"
 #include "mcrouter/lib/test/TestRouteHandle.h"
 #include "mcrouter/routes/WarmUpRoute.h"
+#include "mcrouter/routes/test/RouteHandleTestUtil.h"
 
 using namespace facebook::memcache;
 using namespace facebook::memcache::mcrouter;
@@ -24,8 +28,6 @@ using std::make_shared;
 using std::string;
 using std::vector;
 
-using TestHandle = TestHandleImpl<TestRouteHandleIf>;
-
 TEST(warmUpRouteTest, warmUp) {
   vector<std::shared_ptr<TestHandle>> test_handles{
       make_shared<TestHandle>(
@@ -46,7 +48,7 @@ TEST(warmUpRouteTest, warmUp) {
   TestFiberManager fm;
 
   fm.run([&]() {
-    TestRouteHandle<WarmUpRoute<TestRouteHandleIf>> rh(
+    TestRouteHandle<WarmUpRoute<TestRouterInfo>> rh(
         route_handles[0], route_handles[1], 1);
 
     auto reply_get = rh.route(McGetRequest("key_get"));
@@ -62,7 +64,7 @@ TEST(warmUpRouteTest, warmUp) {
     EXPECT_EQ(vector<string>{"key_del"}, test_handles[1]->saw_keys);
   });
   fm.run([&]() {
-    TestRouteHandle<WarmUpRoute<TestRouteHandleIf>> rh(
+    TestRouteHandle<WarmUpRoute<TestRouterInfo>> rh(
         route_handles[0], route_handles[2], 1);
 
     auto reply_get = rh.route(McGetRequest("key_get"));
@@ -78,7 +80,7 @@ TEST(warmUpRouteTest, warmUp) {
         (vector<std::string>{"get", "add"}), test_handles[2]->sawOperations);
   });
   fm.run([&]() {
-    TestRouteHandle<WarmUpRoute<TestRouteHandleIf>> rh(
+    TestRouteHandle<WarmUpRoute<TestRouterInfo>> rh(
         route_handles[0], route_handles[2], 1);
 
     auto reply_del = rh.route(McDeleteRequest("key_del"));
@@ -87,3 +89,90 @@ TEST(warmUpRouteTest, warmUp) {
     EXPECT_EQ(vector<string>{"key_del"}, test_handles[2]->saw_keys);
   });
 }
+
+TEST(warmUpRouteTest, refillDedup) {
+  auto warm = make_shared<TestHandle>(GetRouteTestData(mc_res_found, "a"));
+  auto cold = make_shared<TestHandle>(
+      GetRouteTestData(mc_res_notfound, ""),
+      UpdateRouteTestData(mc_res_stored),
+      DeleteRouteTestData(mc_res_notfound));
+
+  RefillLimiter::Options opts;
+  opts.dedupWindow = std::chrono::seconds(60);
+  RefillLimiter limiter(opts);
+
+  TestFiberManager fm;
+  fm.run([&]() {
+    TestRouteHandle<WarmUpRoute<TestRouterInfo>> rh(
+        warm->rh, cold->rh, 1, &limiter);
+
+    for (size_t i = 0; i < 3; ++i) {
+      auto reply = rh.route(McGetRequest("key"));
+      EXPECT_EQ("a", carbon::valueRangeSlow(reply).str());
+    }
+  });
+
+  // Three misses in cold, but a single add.
+  const auto& ops = cold->sawOperations;
+  EXPECT_EQ(3, std::count(ops.begin(), ops.end(), "get"));
+  EXPECT_EQ(1, std::count(ops.begin(), ops.end(), "add"));
+  EXPECT_EQ(0, limiter.outstanding());
+}
+
+namespace {
+
+std::shared_ptr<TestHandle> makeColdMiss() {
+  return make_shared<TestHandle>(
+      GetRouteTestData(mc_res_notfound, ""),
+      UpdateRouteTestData(mc_res_stored),
+      DeleteRouteTestData(mc_res_notfound));
+}
+
+// Routes a get, a metaget, a lease-get and a gets through a WarmUpRoute
+// whose request deadline is `budget` from now.
+void routeWithDeadline(
+    TestHandle& warm,
+    TestHandle& cold,
+    std::chrono::milliseconds budget,
+    mc_res_t expected) {
+  TestFiberManager fm{fiber_local<TestRouterInfo>::ContextTypeTag()};
+  fm.run([&]() {
+    auto ctx = getTestContext();
+    ctx->tightenDeadline(budget);
+    fiber_local<TestRouterInfo>::setSharedCtx(std::move(ctx));
+    TestRouteHandle<WarmUpRoute<TestRouterInfo>> rh(warm.rh, cold.rh, 1);
+
+    EXPECT_EQ(expected, rh.route(McGetRequest("get")).result());
+    EXPECT_EQ(expected, rh.route(McMetagetRequest("metaget")).result());
+    EXPECT_EQ(expected, rh.route(McLeaseGetRequest("lease_get")).result());
+    // On a warm hit, gets re-reads cold; its result is cold's either way.
+    EXPECT_EQ(mc_res_notfound, rh.route(McGetsRequest("gets")).result());
+  });
+}
+
+} // anonymous namespace
+
+TEST(warmUpRouteTest, coldMissPastDeadlineSkipsWarm) {
+  auto warm = make_shared<TestHandle>(GetRouteTestData(mc_res_found, "a"));
+  auto cold = makeColdMiss();
+
+  // The deadline is already due: cold replies are returned as is.
+  routeWithDeadline(
+      *warm, *cold, std::chrono::milliseconds(0), mc_res_notfound);
+
+  EXPECT_TRUE(warm->saw_keys.empty());
+  EXPECT_EQ(
+      (vector<string>{"get", "metaget", "lease_get", "gets"}),
+      cold->saw_keys);
+}
+
+TEST(warmUpRouteTest, coldMissBeforeDeadlineQueriesWarm) {
+  auto warm = make_shared<TestHandle>(GetRouteTestData(mc_res_found, "a"));
+  auto cold = makeColdMiss();
+
+  routeWithDeadline(*warm, *cold, std::chrono::hours(1), mc_res_found);
+
+  EXPECT_EQ(
+      (vector<string>{"get", "metaget", "lease_get", "gets"}),
+      warm->saw_keys);
+}
@@ -83,6 +83,54 @@ MCROUTER_OPTION_INTEGER(
     no_short,
     "TCP listen backlog size")
 
+MCROUTER_OPTION_STRING(
+    takeover_socket_path,
+    "",
+    "takeover-socket-path",
+    no_short,
+    "Unix socket for hitless restarts. On startup, listening sockets are"
+    " taken over from the mcrouter serving this path (which then stops"
+    " accepting and gracefully closes its connections, see"
+    " --go-away-timeout-ms), and this path is served for the next restart."
+    " Not supported with --reuse-port-per-worker.")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    go_away_timeout_ms,
+    0,
+    "go-away-timeout-ms",
+    no_short,
+    "On shutdown, caret clients are asked to move their traffic elsewhere"
+    " (GoAway) and their connections are closed after this many ms, instead"
+    " of immediately. 0 disables it.")
+
+MCROUTER_OPTION_TOGGLE(
+    reuse_port_per_worker,
+    false,
+    "reuse-port-per-worker",
+    no_short,
+    "Each worker thread listens on its own SO_REUSEPORT socket and accepts"
+    " its own connections (ports only)")
+
+MCROUTER_OPTION_TOGGLE(
+    reuse_port_cpu_steering,
+    false,
+    "reuse-port-cpu-steering",
+    no_short,
+    "With --reuse-port-per-worker, steer new connections to the worker"
+    " matching the CPU that received them (receiving CPU % num-proxies)")
+
+MCROUTER_OPTION_OTHER(
+    std::vector<uint16_t>,
+    worker_cpus,
+    ,
+    "worker-cpus",
+    no_short,
+    "CPUs to pin worker threads to (comma separated); worker i is pinned to"
+    " the (i % count)-th CPU in the list. Each worker also runs its proxy,"
+    " so with --reuse-port-cpu-steering and RX queues mapped to the same"
+    " CPUs a request never leaves the core that received it.")
+
 MCROUTER_OPTION_INTEGER(
     uint32_t,
     max_client_outstanding_reqs,
@@ -91,6 +139,48 @@ MCROUTER_OPTION_INTEGER(
     no_short,
     "Maximum requests outstanding per client (0 to disable)")
 
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    reply_zero_copy_threshold,
+    0,
+    "reply-zero-copy-threshold",
+    no_short,
+    "Replies to clients with values of at least this many bytes are written"
+    " with MSG_ZEROCOPY (plaintext connections only). 0 disables zero-copy"
+    " writes.")
+
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    caret_reply_frame_size,
+    0,
+    "caret-reply-frame-size",
+    no_short,
+    "Caret replies bigger than this many bytes are sent in frames of this"
+    " size interleaved with other replies, so that they don't delay the"
+    " replies behind them (to clients that support it). 0 disables"
+    " fragmentation.")
+
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    max_requests_per_loop,
+    0,
+    "max-requests-per-loop",
+    no_short,
+    "Each caret client connection gets at most this many requests processed"
+    " per event loop iteration, the rest waits for the next one. Keeps"
+    " clients with deep pipelines from starving others on the same thread."
+    " 0 disables the limit.")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    idle_buffer_release_timeout_ms,
+    0,
+    "idle-buffer-release-timeout-ms",
+    no_short,
+    "Read buffers of client connections that were idle for this long are"
+    " freed until the next read, so that mostly idle connections cost almost"
+    " no memory. 0 disables it.")
+
 MCROUTER_OPTION_INTEGER(
     size_t,
     requests_per_read,
@@ -140,6 +230,53 @@ MCROUTER_OPTION_INTEGER(
     "How often to collect server load data. "
     "(0 to disable exposing server load)")
 
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    overload_requests_per_client,
+    0,
+    "overload-requests-per-client",
+    no_short,
+    "While CPU load is at least --overload-cpu-percent, each client connection"
+    " may send this many requests per second. Connections over it are not"
+    " read from until they are back within it, so that the heaviest clients"
+    " are throttled first. Needs --server-load-interval-ms. 0 disables it.")
+
+MCROUTER_OPTION_DOUBLE(
+    double,
+    overload_cpu_percent,
+    90.0,
+    "overload-cpu-percent",
+    no_short,
+    "CPU load (in percent) above which --overload-requests-per-client is"
+    " enforced.")
+
+MCROUTER_OPTION_TOGGLE(
+    replay_async_spool,
+    false,
+    "replay-async-spool",
+    no_short,
+    "Instead of serving requests, replay the deletes logged in --async-spool"
+    " files that are no longer written to, remove the files if all deletes"
+    " succeeded, and exit. Deletes are de-duplicated and pipelined over one"
+    " ascii connection per destination; --server-timeout applies to each.")
+
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    replay_max_inflight,
+    16,
+    "replay-max-inflight",
+    no_short,
+    "With --replay-async-spool, deletes inflight per destination.")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    replay_rate,
+    10000,
+    "replay-rate",
+    no_short,
+    "With --replay-async-spool, deletes sent per second over all"
+    " destinations. 0 means no limit.")
+
 MCROUTER_OPTION_INTEGER(
     uint32_t,
     tfo_queue_size,
@@ -149,6 +286,26 @@ MCROUTER_OPTION_INTEGER(
     "TFO queue size for SSL connections.  "
     "(only matters if ssl tfo is enabled)")
 
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    ssl_handshake_threads,
+    0,
+    "ssl-handshake-threads",
+    no_short,
+    "Number of threads doing the SSL handshakes of new client connections,"
+    " so that reconnect storms don't stall the proxy threads. 0 means"
+    " handshakes are done on the proxy threads.")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    ssl_handshake_timeout_ms,
+    5000,
+    "ssl-handshake-timeout-ms",
+    no_short,
+    "Client connections that don't finish the SSL handshake within this"
+    " time are closed. Only used with ssl-handshake-threads. 0 means no"
+    " timeout.")
+
 #ifdef ADDITIONAL_STANDALONE_OPTIONS_FILE
 #include ADDITIONAL_STANDALONE_OPTIONS_FILE
 #endif
@@ -24,6 +24,10 @@ STUI(num_ssl_servers_up, 0, 1)
 STUI(num_clients, 0, 1)
 // Current number of open SSL connections
 STUI(num_suspect_servers, 0, 1)
+// Servers currently TKO for being latency outliers in their pool
+STUI(num_latency_tko_servers, 0, 1)
+// Servers currently TKO for a high error rate (pool error_rate_tko)
+STUI(num_error_rate_tko_servers, 0, 1)
 // Running total of successful SSL connection attempts
 STUI(num_ssl_connection_successes, 0, 1)
 STUI(num_ssl_resumption_attempts, 0, 1)
@@ -32,6 +36,8 @@ STUI(num_ssl_resumption_successes, 0, 1)
 #define GROUP mcproxy_stats | rate_stats
 STUI(destination_batches_sum, 0, 1)
 STUI(destination_requests_sum, 0, 1)
+/* Socket writes issued by destination writer loops. */
+STUI(destination_writes_sum, 0, 1)
 #undef GROUP
 /**
  * OutstandingLimitRoute (OLR) queue-related stats, broken down by request type
@@ -41,8 +47,48 @@ STUI(destination_requests_sum, 0, 1)
 /* Number of requests/second that couldn't be processed immediately in OLR */
 STUI(outstanding_route_get_reqs_queued, 0, 1)
 STUI(outstanding_route_update_reqs_queued, 0, 1)
+/* Gets served by an identical in-flight get in CoalescingRoute */
+STUI(coalesced_get_reqs, 0, 1)
+/* Lease-gets collapsed into an in-flight lease-get or a pending lease fill */
+STUI(coalesced_lease_get_reqs, 0, 1)
+/* Lease-sets whose value was also returned to collapsed lease-gets */
+STUI(lease_fills_shared, 0, 1)
+/* Gets served from NearCacheRoute's in-process cache */
+STUI(near_cache_hits, 0, 1)
+/* Replies admitted into NearCacheRoute's in-process cache */
+STUI(near_cache_admissions, 0, 1)
+/* Gets answered with a remembered miss by NegativeCacheRoute */
+STUI(negative_cache_hits, 0, 1)
+/* Gets sent to the child of NegativeCacheRoute */
+STUI(negative_cache_misses, 0, 1)
+/* Gets picked by RefreshAheadRoute to refresh a hot key about to expire */
+STUI(refresh_ahead_triggers, 0, 1)
+/* Extra copies of slow gets sent by HedgedRoute */
+STUI(hedged_reqs, 0, 1)
+/* Destination requests and failovers skipped because the deadline passed */
+STUI(deadline_exceeded_reqs, 0, 1)
+/* Shadow requests dropped because the proxy was under pressure */
+STUI(shadow_requests_shed, 0, 1)
+/* Asynchronous refills skipped because the key was just refilled */
+STUI(refills_deduped, 0, 1)
+/* Asynchronous refills dropped by the refill rate/outstanding limits */
+STUI(refills_dropped, 0, 1)
+/* Requests sent past an overloaded first choice by BoundedLoadCh3 */
+STUI(bounded_load_spills, 0, 1)
+/* Request samples dropped because the sample ring was full */
+STUI(request_samples_dropped, 0, 1)
+/* Timelines of slow requests kept for the slow_requests command */
+STUI(slow_requests_traced, 0, 1)
+/* Writes replaced by a later write of the same key in ReplicationRoute */
+STUI(replication_writes_coalesced, 0, 1)
+/* Batches of pending writes sent out by ReplicationRoute */
+STUI(replication_batches, 0, 1)
+/* Failed replicated sets replaced with deletes by ReplicationRoute */
+STUI(replication_sets_invalidated, 0, 1)
 #undef GROUP
 #define GROUP ods_stats | mcproxy_stats
+/* Gets currently waiting for an identical in-flight get */
+STUI(coalesced_get_reqs_waiting, 0, 1)
 /* Average number of requests waiting in OLR at any given time */
 STAT(outstanding_route_get_avg_queue_size, stat_double, 0, .dbl = 0.0)
 STAT(outstanding_route_update_avg_queue_size, stat_double, 0, .dbl = 0.0)
@@ -68,12 +114,21 @@ STUI(destination_pending_reqs, 0, 1)
 /* Total reqs waiting for reply from memcache. */
 STUI(destination_inflight_reqs, 0, 1)
 STAT(destination_batch_size, stat_double, 0, .dbl = 0.0)
+/* Average number of socket writes per destination batch. */
+STAT(destination_writes_per_batch, stat_double, 0, .dbl = 0.0)
 STUI(asynclog_requests, 0, 1)
 /* Proxy requests we started routing */
 STUI(proxy_reqs_processing, 0, 1)
 /* Proxy requests queued up and not routed yet */
 STUI(proxy_reqs_waiting, 0, 1)
+/* Waiting requests rejected to make room for higher priority ones */
+STUIR(proxy_reqs_shed, 0, 1)
+STUIR(proxy_reqs_memory_shed, 0, 1)
+/* Requests rejected for waiting too long in an overloaded queue */
+STUIR(proxy_reqs_codel_shed, 0, 1)
 STAT(client_queue_notify_period, stat_double, 0, .dbl = 0.0)
+/* Proxy wake ups per request received through the client queue */
+STAT(client_queue_notifications_per_request, stat_double, 0, .dbl = 0.0)
 //  STUI(bytes_read, 0)
 //  STUI(bytes_written, 0)
 //  STUI(get_hits, 0)
@@ -91,7 +146,34 @@ STUI(fibers_pool_size, 0, 0)
 STUI(fibers_stack_high_watermark, 0, 0)
 //  STUI(failed_client_connections, 0)
 STUI(successful_client_connections, 0, 1)
+/* Client connections that had more requests to parse than
+   --max-requests-per-loop and were put off to the next loop iteration */
+STUIR(client_reads_deferred, 0, 1)
+/* Keys of client multigets held back by multiget_max_inflight_keys until
+   earlier keys were replied */
+STUIR(multiget_keys_deferred, 0, 1)
+/* Reply batches written to client connections and the replies in them;
+   their ratio is the average number of replies per write */
+STUIR(client_reply_writes, 0, 1)
+STUIR(client_replies_written, 0, 1)
+/* Client SSL handshakes done on the handshake threads, and the total time
+   they waited for a handshake thread; their ratio is the average wait */
+STUIR(ssl_handshakes_offloaded, 0, 1)
+STUIR(ssl_handshake_queue_time_us, 0, 1)
 STAT(duration_us, stat_double, 0, .dbl = 0.0)
+// Percentiles of end-to-end request latency, over all proxies
+STUI(total_duration_us_p50, 0, 0)
+STUI(total_duration_us_p90, 0, 0)
+STUI(total_duration_us_p99, 0, 0)
+STUI(total_duration_us_p999, 0, 0)
+// Fiber scheduling delays and event loop busy times, over all proxies
+// (only with fiber_scheduling_stats)
+STUI(fiber_queue_delay_us_p50, 0, 0)
+STUI(fiber_queue_delay_us_p99, 0, 0)
+STUI(fiber_runnable_delay_us_p50, 0, 0)
+STUI(fiber_runnable_delay_us_p99, 0, 0)
+STUI(proxy_loop_busy_us_p50, 0, 0)
+STUI(proxy_loop_busy_us_p99, 0, 0)
 #undef GROUP
 #define GROUP ods_stats | mcproxy_stats | max_stats
 STUI(destination_max_pending_reqs, 0, 1)
@@ -109,6 +191,37 @@ STUI(redirected_lease_set_count, 0, 1)
   STUIR(replies_not_compressed, 0, 1)
   STUIR(reply_traffic_before_compression, 0, 1)
   STUIR(reply_traffic_after_compression, 0, 1)
+  STUIR(reply_values_copied, 0, 1)
+#undef GROUP
+#define GROUP ods_stats | detailed_stats
+/* Compressions and decompressions run on the CPU thread pool, their total
+ * uncompressed size and the average time they waited for a thread */
+STUI(compression_offloads, 0, 0)
+STUI(compression_offload_bytes, 0, 0)
+STAT(compression_offload_avg_queue_delay_us, stat_double, 0, .dbl = 0.0)
+#undef GROUP
+#define GROUP ods_stats | detailed_stats | rate_stats
+/* TKO probes sent, and probes postponed by max_probes_per_second */
+  STUIR(probes_sent, 0, 1)
+  STUIR(probes_deferred, 0, 1)
+/* Real requests sent to TKO destinations to check on them */
+  STUIR(tko_canaries_sent, 0, 1)
+#undef GROUP
+#define GROUP ods_stats | detailed_stats | rate_stats
+/* New connections delayed or refused by max_new_connections_per_second */
+  STUIR(connects_throttled, 0, 1)
+  STUIR(connects_throttle_timeouts, 0, 1)
+  STUIR(connects_prewarmed, 0, 1)
+#undef GROUP
+#define GROUP ods_stats | detailed_stats | rate_stats
+/* Proxy event loop iterations busy for longer than slow_loop_threshold_us */
+  STUIR(proxy_slow_loops, 0, 1)
+#undef GROUP
+#define GROUP ods_stats | detailed_stats | rate_stats
+/* With proxy_busy_poll_us, event loop iterations spent polling in vain and
+ * iterations that handled events */
+  STUIR(proxy_busy_poll_idle_spins, 0, 1)
+  STUIR(proxy_busy_poll_useful_loops, 0, 1)
 #undef GROUP
 #define GROUP ods_stats | detailed_stats
 STUI(config_age, 0, 0)
@@ -116,8 +229,14 @@ STUI(config_last_attempt, 0, 0)
 STUI(config_last_success, 0, 0)
 STUI(config_failures, 0, 0)
 STUI(configs_from_disk, 0, 0)
+/* Duration of the phases of the last successful (re)configuration */
+STUI(config_parse_time_us, 0, 0)
+STUI(config_preprocess_time_us, 0, 0)
+STUI(config_route_build_time_us, 0, 0)
 STUI(start_time, 0, 0)
 STUI(dev_null_requests, 0, 1)
+/* Routes built on first use, with lazy_route_construction */
+STUI(route_subtrees_materialized, 0, 1)
 STUI(proxy_request_num_outstanding, 0, 1)
 STAT(retrans_per_kbyte_avg, stat_double, 0, .dbl = 0.0)
 #undef GROUP
@@ -136,6 +255,7 @@ STUIR(request_error, 0, 1)
 STUIR(request_success, 0, 1)
 STUIR(request_replied, 0, 1)
 STUIR(client_queue_notifications, 0, 1)
+STUIR(client_queue_requests, 0, 1)
 STUIR(failover_all, 0, 1)
 STUIR(failover_conditional, 0, 1)
 STUIR(failover_all_failed, 0, 1)
@@ -144,8 +264,14 @@ STUIR(failover_inorder_policy, 0, 1)
 STUIR(failover_inorder_policy_failed, 0, 1)
 STUIR(failover_least_failures_policy, 0, 1)
 STUIR(failover_least_failures_policy_failed, 0, 1)
+STUIR(failover_load_aware_policy, 0, 1)
+STUIR(failover_load_aware_policy_failed, 0, 1)
 STUIR(failover_custom_policy, 0, 1)
 STUIR(failover_custom_policy_failed, 0, 1)
+/* Requests sent to another replica because of a destination's full queue */
+STUIR(failover_spillover, 0, 1)
+/* Times destinations filled their queue and started spilling requests over */
+STUIR(destination_spillover_saturated, 0, 1)
 #undef GROUP
 #define GROUP ods_stats | count_stats
 STUI(result_error_count, 0, 1)
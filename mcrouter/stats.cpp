@@ -14,6 +14,10 @@
 #include <unistd.h>
 
 #include <limits>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
 
 #include <folly/Conv.h>
 #include <folly/Range.h>
@@ -21,11 +25,18 @@
 #include <folly/json.h>
 
 #include "mcrouter/CarbonRouterInstanceBase.h"
+#include "mcrouter/KeyPrefixStats.h"
+#include "mcrouter/LatencyHistogram.h"
 #include "mcrouter/McrouterLogFailure.h"
 #include "mcrouter/ProxyBase.h"
 #include "mcrouter/ProxyDestination.h"
 #include "mcrouter/ProxyDestinationMap.h"
+#include "mcrouter/RequestCpuStats.h"
+#include "mcrouter/RouteStats.h"
+#include "mcrouter/ThreadUtil.h"
 #include "mcrouter/config.h"
+#include "mcrouter/lib/Clocks.h"
+#include "mcrouter/lib/CompressionOffload.h"
 #include "mcrouter/lib/StatsReply.h"
 #include "mcrouter/lib/fbi/cpp/util.h"
 #include "mcrouter/lib/network/gen/Memcache.h"
@@ -69,22 +80,51 @@ struct ServerStat {
   size_t states[(size_t)ProxyDestination::State::kNumStates] = {0};
   bool isHardTko{false};
   bool isSoftTko{false};
+  bool isLatencyTko{false};
+  bool isErrorRateTko{false};
   double sumLatencies{0.0};
   size_t cntLatencies{0};
   size_t pendingRequestsCount{0};
   size_t inflightRequestsCount{0};
+  size_t batches{0};
+  size_t batchedRequests{0};
+  size_t writes{0};
   double sumRetransPerKByte{0.0};
   size_t cntRetransPerKByte{0};
   double maxRetransPerKByte{0.0};
   double minRetransPerKByte{std::numeric_limits<double>::infinity()};
+  // Merged latency histograms of the destination in all proxies, only set
+  // with destination_latency_histograms.
+  std::unique_ptr<LatencyHistogram> latencies;
 
   std::string toString() const {
     double avgLatency = cntLatencies == 0 ? 0 : sumLatencies / cntLatencies;
     auto res = folly::format("avg_latency_us:{:.3f}", avgLatency).str();
+    if (latencies && latencies->count() > 0) {
+      folly::format(
+          " p50_latency_us:{} p90_latency_us:{} p99_latency_us:{}"
+          " p999_latency_us:{}",
+          latencies->percentile(0.5),
+          latencies->percentile(0.9),
+          latencies->percentile(0.99),
+          latencies->percentile(0.999))
+          .appendTo(res);
+    }
     folly::format(" pending_reqs:{}", pendingRequestsCount).appendTo(res);
     folly::format(" inflight_reqs:{}", inflightRequestsCount).appendTo(res);
+    if (batches > 0) {
+      folly::format(
+          " avg_batch_size:{:.3f} avg_writes_per_batch:{:.3f}",
+          batchedRequests / (double)batches,
+          writes / (double)batches)
+          .appendTo(res);
+    }
     if (isHardTko) {
       res.append(" hard_tko; ");
+    } else if (isLatencyTko) {
+      res.append(" latency_tko; ");
+    } else if (isErrorRateTko) {
+      res.append(" error_rate_tko; ");
     } else if (isSoftTko) {
       res.append(" soft_tko; ");
     }
@@ -361,6 +401,27 @@ void append_pool_stats(
   for (const auto& mergedPoolStatMapEntry : mergedPoolStatsMap) {
     stats.emplace_back(mergedPoolStatMapEntry.second);
   }
+
+  // Percentiles can't be summed like the stats above, merge the histograms
+  // instead.
+  struct PoolLatencies {
+    const PoolStats* poolStats{nullptr};
+    LatencyHistogram totalDurationUs;
+  };
+  std::unordered_map<std::string, PoolLatencies> poolLatencies;
+  for (size_t j = 0; j < router.opts().num_proxies; ++j) {
+    for (const auto& poolStats : router.getProxyBase(j)->stats().poolStats()) {
+      auto& entry = poolLatencies[poolStats.poolName()];
+      entry.poolStats = &poolStats;
+      entry.totalDurationUs.merge(poolStats.totalDurationUs().histogram());
+    }
+  }
+  for (const auto& it : poolLatencies) {
+    for (auto& stat :
+         it.second.poolStats->getPercentileStats(it.second.totalDurationUs)) {
+      stats.push_back(std::move(stat));
+    }
+  }
 }
 
 void prepare_stats(CarbonRouterInstanceBase& router, stat_t* stats) {
@@ -369,6 +430,7 @@ void prepare_stats(CarbonRouterInstanceBase& router, stat_t* stats) {
   uint64_t config_last_success = 0;
   uint64_t destinationBatchesSum = 0;
   uint64_t destinationRequestsSum = 0;
+  uint64_t destinationWritesSum = 0;
   uint64_t outstandingGetReqsTotal = 0;
   uint64_t outstandingGetReqsHelper = 0;
   uint64_t outstandingGetWaitTimeSumUs = 0;
@@ -386,6 +448,8 @@ void prepare_stats(CarbonRouterInstanceBase& router, stat_t* stats) {
         proxy->stats().getStatValueWithinWindow(destination_batches_sum_stat);
     destinationRequestsSum +=
         proxy->stats().getStatValueWithinWindow(destination_requests_sum_stat);
+    destinationWritesSum +=
+        proxy->stats().getStatValueWithinWindow(destination_writes_sum_stat);
 
     outstandingGetReqsTotal += proxy->stats().getStatValueWithinWindow(
         outstanding_route_get_reqs_queued_stat);
@@ -410,12 +474,32 @@ void prepare_stats(CarbonRouterInstanceBase& router, stat_t* stats) {
       stats,
       num_suspect_servers_stat,
       router.tkoTrackerMap().getSuspectServersCount());
+  stat_set_uint64(
+      stats,
+      num_latency_tko_servers_stat,
+      router.tkoTrackerMap().globalTkos().latencyTkos);
+  stat_set_uint64(
+      stats,
+      num_error_rate_tko_servers_stat,
+      router.tkoTrackerMap().globalTkos().errorRateTkos);
+  if (auto offload = router.compressionOffload()) {
+    const auto numOffloaded = offload->numOffloaded();
+    stat_set_uint64(stats, compression_offloads_stat, numOffloaded);
+    stat_set_uint64(
+        stats, compression_offload_bytes_stat, offload->bytesOffloaded());
+    stats[compression_offload_avg_queue_delay_us_stat].data.dbl =
+        numOffloaded == 0 ? 0.0
+                          : offload->queueDelayUs() / (double)numOffloaded;
+  }
 
   double avgBatchSize = 0.0;
+  double avgWritesPerBatch = 0.0;
   if (destinationBatchesSum != 0) {
     avgBatchSize = destinationRequestsSum / (double)destinationBatchesSum;
+    avgWritesPerBatch = destinationWritesSum / (double)destinationBatchesSum;
   }
   stats[destination_batch_size_stat].data.dbl = avgBatchSize;
+  stats[destination_writes_per_batch_stat].data.dbl = avgWritesPerBatch;
 
   double avgRetransPerKByte = 0.0;
   if (retransNumTotal != 0) {
@@ -457,6 +541,12 @@ void prepare_stats(CarbonRouterInstanceBase& router, stat_t* stats) {
   stats[config_failures_stat].data.uint64 = router.configFailures();
   stats[configs_from_disk_stat].data.uint64 =
       static_cast<uint64_t>(router.configuredFromDisk());
+  stats[config_parse_time_us_stat].data.uint64 =
+      router.configBuildTimes().parseUs;
+  stats[config_preprocess_time_us_stat].data.uint64 =
+      router.configBuildTimes().preprocessUs;
+  stats[config_route_build_time_us_stat].data.uint64 =
+      router.configBuildTimes().routeBuildUs;
 
   stats[pid_stat].data.int64 = getpid();
   stats[parent_pid_stat].data.int64 = getppid();
@@ -481,25 +571,67 @@ void prepare_stats(CarbonRouterInstanceBase& router, stat_t* stats) {
   stats[fibers_allocated_stat].data.uint64 = 0;
   stats[fibers_pool_size_stat].data.uint64 = 0;
   stats[fibers_stack_high_watermark_stat].data.uint64 = 0;
+  LatencyHistogram totalDurations;
+  LatencyHistogram fiberQueueDelays;
+  LatencyHistogram fiberRunnableDelays;
+  LatencyHistogram loopBusyTimes;
   for (size_t i = 0; i < router.opts().num_proxies; ++i) {
     auto pr = router.getProxyBase(i);
     stats[fibers_allocated_stat].data.uint64 +=
         pr->fiberManager().fibersAllocated();
     stats[fibers_pool_size_stat].data.uint64 +=
         pr->fiberManager().fibersPoolSize();
+    if (auto leafFm = pr->leafFiberManager()) {
+      stats[fibers_allocated_stat].data.uint64 += leafFm->fibersAllocated();
+      stats[fibers_pool_size_stat].data.uint64 += leafFm->fibersPoolSize();
+    }
     stats[fibers_stack_high_watermark_stat].data.uint64 = std::max(
         stats[fibers_stack_high_watermark_stat].data.uint64,
         pr->fiberManager().stackHighWatermark());
     stats[duration_us_stat].data.dbl += pr->stats().durationUs().value();
+    totalDurations.merge(pr->stats().totalDurationUs().histogram());
+    fiberQueueDelays.merge(pr->stats().fiberQueueDelayUs().histogram());
+    fiberRunnableDelays.merge(pr->stats().fiberRunnableDelayUs().histogram());
+    loopBusyTimes.merge(pr->stats().loopBusyUs().histogram());
     stats[client_queue_notify_period_stat].data.dbl += pr->queueNotifyPeriod();
   }
 
+  stats[total_duration_us_p50_stat].data.uint64 =
+      totalDurations.percentile(0.5);
+  stats[total_duration_us_p90_stat].data.uint64 =
+      totalDurations.percentile(0.9);
+  stats[total_duration_us_p99_stat].data.uint64 =
+      totalDurations.percentile(0.99);
+  stats[total_duration_us_p999_stat].data.uint64 =
+      totalDurations.percentile(0.999);
+  stats[fiber_queue_delay_us_p50_stat].data.uint64 =
+      fiberQueueDelays.percentile(0.5);
+  stats[fiber_queue_delay_us_p99_stat].data.uint64 =
+      fiberQueueDelays.percentile(0.99);
+  stats[fiber_runnable_delay_us_p50_stat].data.uint64 =
+      fiberRunnableDelays.percentile(0.5);
+  stats[fiber_runnable_delay_us_p99_stat].data.uint64 =
+      fiberRunnableDelays.percentile(0.99);
+  stats[proxy_loop_busy_us_p50_stat].data.uint64 =
+      loopBusyTimes.percentile(0.5);
+  stats[proxy_loop_busy_us_p99_stat].data.uint64 =
+      loopBusyTimes.percentile(0.99);
+
   if (router.opts().num_proxies > 0) {
     stats[duration_us_stat].data.dbl /= router.opts().num_proxies;
     stats[client_queue_notify_period_stat].data.dbl /=
         router.opts().num_proxies;
   }
 
+  auto queueRequestsRate =
+      stats_aggregate_rate_value(router, client_queue_requests_stat);
+  stats[client_queue_notifications_per_request_stat].data.dbl = 0.0;
+  if (queueRequestsRate > 0) {
+    stats[client_queue_notifications_per_request_stat].data.dbl =
+        stats_aggregate_rate_value(router, client_queue_notifications_stat) /
+        queueRequestsRate;
+  }
+
   for (int i = 0; i < num_stats; i++) {
     if (stats[i].aggregate && !(stats[i].group & rate_stats)) {
       for (size_t j = 0; j < router.opts().num_proxies; ++j) {
@@ -552,6 +684,14 @@ static stat_group_t stat_parse_group_str(folly::StringPiece str) {
     return suspect_server_stats;
   } else if (str == "count") {
     return count_stats;
+  } else if (str == "routes") {
+    return route_stats;
+  } else if (str == "arenas") {
+    return arena_stats;
+  } else if (str == "prefixes") {
+    return key_prefix_stats;
+  } else if (str == "cpu") {
+    return cpu_stats;
   } else if (str.empty()) {
     return mcproxy_stats;
   } else {
@@ -636,6 +776,8 @@ McStatsReply stats_reply(ProxyBase* proxy, folly::StringPiece group_str) {
             auto& stat = serverStats[key];
             stat.isHardTko = pdstn.tracker->isHardTko();
             stat.isSoftTko = pdstn.tracker->isSoftTko();
+            stat.isLatencyTko = pdstn.tracker->isLatencyTko();
+            stat.isErrorRateTko = pdstn.tracker->isErrorRateTko();
             if (pdstn.stats().results) {
               for (size_t j = 0; j < mc_nres; ++j) {
                 stat.results[j] += (*pdstn.stats().results)[j];
@@ -647,6 +789,12 @@ McStatsReply stats_reply(ProxyBase* proxy, folly::StringPiece group_str) {
               stat.sumLatencies += pdstn.stats().avgLatency.value();
               ++stat.cntLatencies;
             }
+            if (pdstn.stats().latencies) {
+              if (!stat.latencies) {
+                stat.latencies = std::make_unique<LatencyHistogram>();
+              }
+              stat.latencies->merge(pdstn.stats().latencies->histogram());
+            }
 
             if (pdstn.stats().retransPerKByte >= 0.0) {
               const auto val = pdstn.stats().retransPerKByte;
@@ -657,6 +805,9 @@ McStatsReply stats_reply(ProxyBase* proxy, folly::StringPiece group_str) {
             }
             stat.pendingRequestsCount += pdstn.getPendingRequestCount();
             stat.inflightRequestsCount += pdstn.getInflightRequestCount();
+            stat.batches += pdstn.stats().batches;
+            stat.batchedRequests += pdstn.stats().batchedRequests;
+            stat.writes += pdstn.stats().writes;
           });
     }
     for (const auto& it : serverStats) {
@@ -677,6 +828,122 @@ McStatsReply stats_reply(ProxyBase* proxy, folly::StringPiece group_str) {
     }
   }
 
+  if (groups & route_stats) {
+    struct Aggregate {
+      uint64_t calls{0};
+      uint64_t errors{0};
+      LatencyHistogram latencyUs;
+    };
+    std::map<std::string, Aggregate> routeStats;
+    auto& router = proxy->router();
+    for (size_t i = 0; i < router.opts().num_proxies; ++i) {
+      router.getProxyBase(i)->routeStats().foreach(
+          [&routeStats](const std::string& name, const RouteStats& stats) {
+            auto& aggregate = routeStats[name];
+            aggregate.calls += stats.calls();
+            aggregate.errors += stats.errors();
+            aggregate.latencyUs.merge(stats.latencyUs().histogram());
+          });
+    }
+    for (const auto& it : routeStats) {
+      reply.addStat(
+          it.first,
+          folly::sformat(
+              "calls:{} errors:{} p50_latency_us:{} p99_latency_us:{}",
+              it.second.calls,
+              it.second.errors,
+              it.second.latencyUs.percentile(0.5),
+              it.second.latencyUs.percentile(0.99)));
+    }
+  }
+
+  if (groups & key_prefix_stats) {
+    std::map<std::string, KeyPrefixStats::Counters> prefixStats;
+    auto& router = proxy->router();
+    for (size_t i = 0; i < router.opts().num_proxies; ++i) {
+      router.getProxyBase(i)->keyPrefixStats().foreach(
+          [&prefixStats](
+              folly::StringPiece prefix,
+              const KeyPrefixStats::Counters& counters) {
+            auto& total = prefixStats[prefix.str()];
+            total.ops += counters.ops;
+            total.bytesIn += counters.bytesIn;
+            total.bytesOut += counters.bytesOut;
+            total.hits += counters.hits;
+            total.misses += counters.misses;
+            total.latencyUs += counters.latencyUs;
+          });
+    }
+    for (const auto& it : prefixStats) {
+      const auto& total = it.second;
+      const auto lookups = total.hits + total.misses;
+      reply.addStat(
+          it.first.empty() ? "prefix_other" : "prefix:" + it.first,
+          folly::sformat(
+              "ops:{} bytes_in:{} bytes_out:{} hit_rate:{:.4f} "
+              "avg_latency_us:{}",
+              total.ops,
+              total.bytesIn,
+              total.bytesOut,
+              lookups ? static_cast<double>(total.hits) / lookups : 0.0,
+              total.ops ? total.latencyUs / total.ops : 0));
+    }
+  }
+
+  if (groups & cpu_stats) {
+    std::map<std::string, RequestCpuStats::Counters> prefixCpu;
+    std::map<std::string, RequestCpuStats::Counters> requestCpu;
+    auto add = [](std::map<std::string, RequestCpuStats::Counters>& map) {
+      return [&map](
+                 folly::StringPiece name,
+                 const RequestCpuStats::Counters& counters) {
+        auto& total = map[name.str()];
+        total.requests += counters.requests;
+        total.cpuCycles += counters.cpuCycles;
+      };
+    };
+    auto& router = proxy->router();
+    for (size_t i = 0; i < router.opts().num_proxies; ++i) {
+      const auto& cpuStats = router.getProxyBase(i)->requestCpuStats();
+      cpuStats.foreachRoutingPrefix(add(prefixCpu));
+      cpuStats.foreachRequest(add(requestCpu));
+    }
+    const auto cyclesPerUs = cycles::getCpuCyclesPerUs();
+    auto format = [cyclesPerUs](const RequestCpuStats::Counters& total) {
+      const auto cpuUs = cyclesPerUs ? total.cpuCycles / cyclesPerUs : 0.0;
+      return folly::sformat(
+          "requests:{} cpu_us:{:.0f} avg_cpu_us:{:.2f}",
+          total.requests,
+          cpuUs,
+          total.requests ? cpuUs / total.requests : 0.0);
+    };
+    for (const auto& it : prefixCpu) {
+      reply.addStat("cpu_prefix:" + it.first, format(it.second));
+    }
+    for (const auto& it : requestCpu) {
+      reply.addStat("cpu_request:" + it.first, format(it.second));
+    }
+  }
+
+  if (groups & arena_stats) {
+    auto& router = proxy->router();
+    for (size_t i = 0; i < router.opts().num_proxies; ++i) {
+      const auto arena = router.getProxyBase(i)->jemallocArena();
+      if (arena < 0) {
+        continue;
+      }
+      if (auto arenaStats = getJemallocArenaStats(arena)) {
+        reply.addStat(
+            folly::sformat("proxy_{}_arena", i),
+            folly::sformat(
+                "arena:{} allocated:{} active:{}",
+                arena,
+                arenaStats->allocated,
+                arenaStats->active));
+      }
+    }
+  }
+
   return reply.getReply();
 }
 
@@ -72,6 +72,10 @@ enum stat_group_t {
   all_stats = 0xffff,
   server_stats = 0x10000,
   suspect_server_stats = 0x40000,
+  route_stats = 0x80000,
+  arena_stats = 0x100000,
+  key_prefix_stats = 0x200000,
+  cpu_stats = 0x400000,
   unknown_stats = 0x10000000,
 };
 
@@ -607,12 +607,14 @@ class McrouterBase(MCProcess):
 
         self.log = os.path.join(base_dir.path, 'mcrouter.log')
 
+        # base_dir may be shared with an earlier mcrouter, e.g. to restart
+        # with its stats dir.
         self.async_spool = os.path.join(base_dir.path, 'spool.mcrouter')
-        os.mkdir(self.async_spool)
         self.stats_dir = os.path.join(base_dir.path, 'stats')
-        os.mkdir(self.stats_dir)
         self.debug_fifo_root = os.path.join(base_dir.path, 'fifos')
-        os.mkdir(self.debug_fifo_root)
+        for path in (self.async_spool, self.stats_dir, self.debug_fifo_root):
+            if not os.path.isdir(path):
+                os.mkdir(path)
 
         args.extend(['-L', self.log,
                      '-a', self.async_spool,
@@ -0,0 +1,87 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <chrono>
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/AdaptiveTimeout.h"
+
+using facebook::memcache::mcrouter::AdaptiveTimeout;
+using std::chrono::milliseconds;
+
+namespace {
+
+// Latencies on histogram bucket boundaries, so that quantiles are exact.
+// With a factor of 2 they give timeouts of 3ms, 33ms and 263ms.
+constexpr int64_t kFastUs = 1 << 10;
+constexpr int64_t kMediumUs = 1 << 14;
+constexpr int64_t kSlowUs = 1 << 17;
+
+// Records one update period worth of replies with the same latency.
+void feed(AdaptiveTimeout& timeout, int64_t latencyUs, bool failing = false) {
+  for (size_t i = 0; i < AdaptiveTimeout::kUpdatePeriod; ++i) {
+    timeout.onReply(latencyUs, failing);
+  }
+}
+
+} // anonymous namespace
+
+TEST(AdaptiveTimeout, staticTimeoutUntilEstimated) {
+  AdaptiveTimeout timeout(0.99, 2.0, milliseconds(1), milliseconds(0));
+  for (size_t i = 0; i + 1 < AdaptiveTimeout::kUpdatePeriod; ++i) {
+    timeout.onReply(kMediumUs, false);
+  }
+  EXPECT_EQ(milliseconds(1000), timeout.timeout(milliseconds(1000)));
+
+  timeout.onReply(kMediumUs, false);
+  EXPECT_EQ(milliseconds(33), timeout.timeout(milliseconds(1000)));
+}
+
+TEST(AdaptiveTimeout, clampedToMin) {
+  AdaptiveTimeout timeout(0.99, 2.0, milliseconds(10), milliseconds(0));
+  feed(timeout, kFastUs);
+  EXPECT_EQ(milliseconds(10), timeout.timeout(milliseconds(1000)));
+}
+
+TEST(AdaptiveTimeout, clampedToMax) {
+  AdaptiveTimeout timeout(0.99, 2.0, milliseconds(10), milliseconds(100));
+  feed(timeout, kSlowUs);
+  EXPECT_EQ(milliseconds(100), timeout.timeout(milliseconds(1000)));
+}
+
+TEST(AdaptiveTimeout, clampedToRouteTimeoutWithoutMax) {
+  AdaptiveTimeout timeout(0.99, 2.0, milliseconds(10), milliseconds(0));
+  feed(timeout, kSlowUs);
+  EXPECT_EQ(milliseconds(263), timeout.timeout(milliseconds(1000)));
+  EXPECT_EQ(milliseconds(200), timeout.timeout(milliseconds(200)));
+}
+
+TEST(AdaptiveTimeout, notTightenedWhileFailing) {
+  // With the median, one period of fast replies outweighs the decayed slow
+  // ones.
+  AdaptiveTimeout timeout(0.5, 2.0, milliseconds(1), milliseconds(0));
+  feed(timeout, kSlowUs);
+  EXPECT_EQ(milliseconds(263), timeout.timeout(milliseconds(1000)));
+
+  feed(timeout, kFastUs, /* failing */ true);
+  EXPECT_EQ(milliseconds(263), timeout.timeout(milliseconds(1000)));
+
+  feed(timeout, kFastUs);
+  EXPECT_EQ(milliseconds(3), timeout.timeout(milliseconds(1000)));
+}
+
+TEST(AdaptiveTimeout, grownWhileFailing) {
+  AdaptiveTimeout timeout(0.5, 2.0, milliseconds(1), milliseconds(0));
+  feed(timeout, kFastUs);
+  EXPECT_EQ(milliseconds(3), timeout.timeout(milliseconds(1000)));
+
+  // Timeouts that are too tight make the destination fail, they must still
+  // be able to grow back.
+  feed(timeout, kSlowUs, /* failing */ true);
+  EXPECT_EQ(milliseconds(263), timeout.timeout(milliseconds(1000)));
+}
@@ -0,0 +1,73 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/AsyncLogRecord.h"
+
+using namespace facebook::memcache::mcrouter;
+
+namespace {
+
+AsyncLogRecord makeRecord(std::string key) {
+  AsyncLogRecord record;
+  record.timestampMs = 1289416829836;
+  record.flavor = "web";
+  record.host = "10.0.0.1";
+  record.port = 11302;
+  record.pool = "pool_name";
+  record.key = std::move(key);
+  return record;
+}
+
+} // anonymous namespace
+
+TEST(AsyncLogRecord, binary) {
+  auto record1 = makeRecord("foo");
+  auto record2 = makeRecord(std::string(1000, 'k'));
+  std::string contents = AsyncLogRecord::kAsyncLogBinaryMagic.str();
+  record1.appendBinary(contents);
+  record2.appendBinary(contents);
+
+  auto records = parseAsyncLog(contents);
+  ASSERT_EQ(2, records.size());
+  EXPECT_EQ(record1, records[0]);
+  EXPECT_EQ(record2, records[1]);
+
+  // Partially written record is ignored.
+  contents.resize(contents.size() - 1);
+  records = parseAsyncLog(contents);
+  ASSERT_EQ(1, records.size());
+  EXPECT_EQ(record1, records[0]);
+}
+
+TEST(AsyncLogRecord, json) {
+  auto record = makeRecord("foo");
+  std::string contents;
+  record.appendJson(contents, true /* version2 */);
+  record.appendJson(contents, false /* version2 */);
+
+  auto records = parseAsyncLog(contents);
+  ASSERT_EQ(2, records.size());
+  EXPECT_EQ(record, records[0]);
+  // Version 1 has no flavor and pool.
+  record.flavor.clear();
+  record.pool.clear();
+  EXPECT_EQ(record, records[1]);
+
+  EXPECT_EQ(
+      records,
+      parseAsyncLog(
+          "[\"AS2.0\",1289416829.836,\"C\",{\"f\":\"web\","
+          "\"h\":\"[10.0.0.1]:11302\",\"p\":\"pool_name\",\"k\":\"foo\"}]\n"
+          "[\"AS1.0\",1289416829.836,\"C\","
+          "[\"10.0.0.1\",11302,\"delete foo\\r\\n\"]]\n"));
+
+  EXPECT_THROW(parseAsyncLog("[\"AS9.0\",1,\"C\",[]]\n"), std::runtime_error);
+}
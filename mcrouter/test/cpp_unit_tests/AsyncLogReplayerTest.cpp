@@ -0,0 +1,52 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/AsyncLogRecord.h"
+#include "mcrouter/AsyncLogReplayer.h"
+
+using namespace facebook::memcache::mcrouter;
+
+namespace {
+
+AsyncLogRecord makeRecord(std::string host, uint16_t port, std::string key) {
+  AsyncLogRecord record;
+  record.host = std::move(host);
+  record.port = port;
+  record.key = std::move(key);
+  return record;
+}
+
+} // anonymous namespace
+
+TEST(AsyncLogReplayer, batchDeletes) {
+  auto batches = batchAsyncLogDeletes({
+      makeRecord("10.0.0.1", 11302, "foo"),
+      makeRecord("10.0.0.2", 11302, "foo"),
+      makeRecord("10.0.0.1", 11302, "bar"),
+      makeRecord("10.0.0.1", 11303, "foo"),
+      makeRecord("10.0.0.1", 11302, "foo"),
+      makeRecord("10.0.0.2", 11302, "baz"),
+  });
+
+  ASSERT_EQ(3, batches.size());
+  EXPECT_EQ("10.0.0.1", batches[0].host);
+  EXPECT_EQ(11302, batches[0].port);
+  EXPECT_EQ(std::vector<std::string>({"foo", "bar"}), batches[0].keys);
+  EXPECT_EQ("10.0.0.2", batches[1].host);
+  EXPECT_EQ(11302, batches[1].port);
+  EXPECT_EQ(std::vector<std::string>({"foo", "baz"}), batches[1].keys);
+  EXPECT_EQ("10.0.0.1", batches[2].host);
+  EXPECT_EQ(11303, batches[2].port);
+  EXPECT_EQ(std::vector<std::string>({"foo"}), batches[2].keys);
+
+  EXPECT_TRUE(batchAsyncLogDeletes({}).empty());
+}
@@ -0,0 +1,56 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <gtest/gtest.h>
+
+#include "mcrouter/CoDel.h"
+
+using facebook::memcache::mcrouter::CoDel;
+using facebook::memcache::mcrouter::ProxyRequestPriority;
+
+namespace {
+
+constexpr auto kAsync = ProxyRequestPriority::kAsync;
+constexpr auto kCritical = ProxyRequestPriority::kCritical;
+
+} // anonymous namespace
+
+TEST(CoDel, burst) {
+  CoDel codel(1000, 100000);
+  // Requests that waited long, but the queue drained within the interval.
+  EXPECT_FALSE(codel.shouldShed(kAsync, 5000, 1000000));
+  EXPECT_FALSE(codel.shouldShed(kAsync, 5000, 1050000));
+  EXPECT_FALSE(codel.shouldShed(kAsync, 100, 1080000));
+  EXPECT_FALSE(codel.shouldShed(kAsync, 5000, 1100000));
+  EXPECT_FALSE(codel.overloaded());
+}
+
+TEST(CoDel, standingQueue) {
+  CoDel codel(1000, 100000);
+  EXPECT_FALSE(codel.shouldShed(kAsync, 1500, 1000000));
+  EXPECT_FALSE(codel.shouldShed(kAsync, 3000, 1050000));
+
+  // Nothing left in time during the last interval.
+  EXPECT_TRUE(codel.shouldShed(kAsync, 1500, 1100000));
+  EXPECT_TRUE(codel.overloaded());
+  EXPECT_FALSE(codel.shouldShed(kAsync, 500, 1110000));
+  // Critical requests get twice the target.
+  EXPECT_FALSE(codel.shouldShed(kCritical, 1500, 1120000));
+  EXPECT_TRUE(codel.shouldShed(kCritical, 2500, 1130000));
+
+  // The queue drained.
+  EXPECT_FALSE(codel.shouldShed(kAsync, 1500, 1200000));
+  EXPECT_FALSE(codel.overloaded());
+}
+
+TEST(CoDel, idle) {
+  CoDel codel(1000, 100000);
+  EXPECT_FALSE(codel.shouldShed(kAsync, 1500, 1000000));
+  // No request left the queue during the last interval.
+  EXPECT_FALSE(codel.shouldShed(kAsync, 1500, 1300000));
+  EXPECT_FALSE(codel.overloaded());
+}
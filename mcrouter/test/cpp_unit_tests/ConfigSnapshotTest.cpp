@@ -0,0 +1,91 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <folly/FileUtil.h>
+#include <folly/Format.h>
+#include <folly/experimental/TestUtil.h>
+#include <folly/json.h>
+
+#include "mcrouter/ConfigApi.h"
+#include "mcrouter/ConfigSnapshot.h"
+#include "mcrouter/lib/config/ConfigPreprocessor.h"
+#include "mcrouter/options.h"
+
+using namespace facebook::memcache;
+using namespace facebook::memcache::mcrouter;
+
+using folly::test::TemporaryDirectory;
+
+namespace {
+
+McrouterOptions getOpts(const TemporaryDirectory& dumpRoot) {
+  McrouterOptions opts;
+  opts.config_dump_root = dumpRoot.path().string();
+  opts.service_name = "test";
+  opts.router_name = "snapshot";
+  opts.config_snapshot = true;
+  return opts;
+}
+
+folly::Optional<folly::dynamic> preprocess(
+    const McrouterOptions& opts,
+    const std::string& jsonC) {
+  ConfigApi api(opts);
+  ConfigSnapshot snapshot(opts, api, jsonC, {});
+  if (auto config = snapshot.load()) {
+    return config;
+  }
+  snapshot.save(ConfigPreprocessor::getConfigWithoutMacros(
+      jsonC, snapshot.importResolver(), {}));
+  return folly::none;
+}
+
+} // anonymous namespace
+
+TEST(ConfigSnapshot, roundTrip) {
+  TemporaryDirectory dumpRoot("config_snapshot_test");
+  auto importPath = (dumpRoot.path() / "import.json").string();
+  ASSERT_TRUE(
+      folly::writeFile(std::string(R"({"a": [1, 2]})"), importPath.c_str()));
+  auto opts = getOpts(dumpRoot);
+  const auto jsonC = folly::sformat(
+      R"({{ // comment
+        "route": "@import(file:{})"
+      }})",
+      importPath);
+
+  EXPECT_FALSE(preprocess(opts, jsonC).hasValue());
+  auto config = preprocess(opts, jsonC);
+  ASSERT_TRUE(config.hasValue());
+  EXPECT_EQ(folly::parseJson(R"({"route": {"a": [1, 2]}})"), *config);
+
+  // Different config.
+  EXPECT_FALSE(preprocess(opts, jsonC + " ").hasValue());
+  EXPECT_TRUE(preprocess(opts, jsonC + " ").hasValue());
+
+  // Changed import.
+  ASSERT_TRUE(
+      folly::writeFile(std::string(R"({"a": 3})"), importPath.c_str()));
+  EXPECT_FALSE(preprocess(opts, jsonC + " ").hasValue());
+  config = preprocess(opts, jsonC + " ");
+  ASSERT_TRUE(config.hasValue());
+  EXPECT_EQ(folly::parseJson(R"({"route": {"a": 3}})"), *config);
+}
+
+TEST(ConfigSnapshot, disabled) {
+  TemporaryDirectory dumpRoot("config_snapshot_test");
+  auto opts = getOpts(dumpRoot);
+  opts.config_snapshot = false;
+  const std::string jsonC = R"({"route": "NullRoute"})";
+
+  EXPECT_FALSE(preprocess(opts, jsonC).hasValue());
+  EXPECT_FALSE(preprocess(opts, jsonC).hasValue());
+}
@@ -0,0 +1,79 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <chrono>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/ConnectionWarmUp.h"
+
+using facebook::memcache::mcrouter::ConnectionWarmUp;
+
+namespace {
+
+std::chrono::steady_clock::time_point in(std::chrono::milliseconds timeout) {
+  return std::chrono::steady_clock::now() + timeout;
+}
+
+} // anonymous namespace
+
+TEST(ConnectionWarmUp, enoughUp) {
+  ConnectionWarmUp warmUp;
+  warmUp.add(4);
+  warmUp.settle(true);
+  warmUp.settle(true);
+  EXPECT_EQ(2, warmUp.wait(2, in(std::chrono::seconds(10))));
+  EXPECT_EQ(4, warmUp.total());
+}
+
+TEST(ConnectionWarmUp, allSettled) {
+  ConnectionWarmUp warmUp;
+  warmUp.add(3);
+  warmUp.settle(true);
+  // Failed, closed or TKO: not up, but nothing to wait for anymore.
+  warmUp.settle(false);
+  warmUp.settle(false);
+
+  const auto start = std::chrono::steady_clock::now();
+  EXPECT_EQ(1, warmUp.wait(3, in(std::chrono::seconds(10))));
+  EXPECT_LT(
+      std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+}
+
+TEST(ConnectionWarmUp, timesOut) {
+  ConnectionWarmUp warmUp;
+  warmUp.add(2);
+  warmUp.settle(true);
+
+  const auto start = std::chrono::steady_clock::now();
+  EXPECT_EQ(1, warmUp.wait(2, in(std::chrono::milliseconds(50))));
+  EXPECT_GE(
+      std::chrono::steady_clock::now() - start,
+      std::chrono::milliseconds(50));
+}
+
+TEST(ConnectionWarmUp, wakesUpOnSettle) {
+  ConnectionWarmUp warmUp;
+  warmUp.add(2);
+
+  std::thread proxy([&warmUp]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    warmUp.settle(true);
+    warmUp.settle(false);
+  });
+  const auto start = std::chrono::steady_clock::now();
+  EXPECT_EQ(1, warmUp.wait(2, in(std::chrono::seconds(10))));
+  EXPECT_LT(
+      std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+  proxy.join();
+}
+
+TEST(ConnectionWarmUp, nothingToWaitFor) {
+  ConnectionWarmUp warmUp;
+  EXPECT_EQ(0, warmUp.wait(0, in(std::chrono::seconds(10))));
+}
@@ -0,0 +1,54 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <folly/Conv.h>
+
+#include "mcrouter/HotKeyTracker.h"
+
+using namespace facebook::memcache::mcrouter;
+
+TEST(HotKeyTracker, findsHotKeys) {
+  HotKeyTracker tracker(1 /* sampleRate */, 2 /* topK */);
+  for (size_t i = 0; i < 100; ++i) {
+    tracker.record("hot");
+    if (i % 2 == 0) {
+      tracker.record("warm");
+    }
+    tracker.record(folly::to<std::string>("cold", i));
+  }
+
+  auto top = tracker.topKeys();
+  ASSERT_EQ(2, top.size());
+  EXPECT_EQ("hot", top[0].first);
+  EXPECT_EQ(100, top[0].second);
+  EXPECT_EQ("warm", top[1].first);
+  EXPECT_EQ(50, top[1].second);
+}
+
+TEST(HotKeyTracker, sampling) {
+  HotKeyTracker tracker(10 /* sampleRate */, 4 /* topK */);
+  for (size_t i = 0; i < 1000; ++i) {
+    tracker.record("hot");
+  }
+
+  auto top = tracker.topKeys();
+  ASSERT_EQ(1, top.size());
+  EXPECT_EQ("hot", top[0].first);
+  EXPECT_EQ(1000, top[0].second);
+}
+
+TEST(HotKeyTracker, disabled) {
+  HotKeyTracker tracker(0 /* sampleRate */, 4 /* topK */);
+  for (size_t i = 0; i < 100; ++i) {
+    tracker.record("hot");
+  }
+  EXPECT_TRUE(tracker.topKeys().empty());
+}
@@ -0,0 +1,59 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <gtest/gtest.h>
+
+#include "mcrouter/IncastWindow.h"
+
+using facebook::memcache::mcrouter::IncastWindow;
+
+TEST(IncastWindow, fixedWithoutThreshold) {
+  IncastWindow window(2, 8, 0);
+  EXPECT_EQ(8, window.window());
+  EXPECT_FALSE(window.onRetransmits(100.0, 1000000));
+  EXPECT_EQ(8, window.window());
+}
+
+TEST(IncastWindow, decreaseOncePerInterval) {
+  IncastWindow window(2, 8, 5.0);
+  EXPECT_FALSE(window.onRetransmits(5.0, 1000000));
+  EXPECT_EQ(8, window.window());
+
+  EXPECT_TRUE(window.onRetransmits(6.0, 1000000));
+  EXPECT_EQ(4, window.window());
+
+  // Other destinations sampled at the same time.
+  EXPECT_FALSE(window.onRetransmits(6.0, 1000000 + 10));
+  EXPECT_EQ(4, window.window());
+
+  EXPECT_TRUE(window.onRetransmits(
+      6.0, 1000000 + IncastWindow::kMinDecreaseIntervalUs));
+  EXPECT_EQ(2, window.window());
+
+  // Never below the min.
+  EXPECT_FALSE(window.onRetransmits(
+      6.0, 1000000 + 2 * IncastWindow::kMinDecreaseIntervalUs));
+  EXPECT_EQ(2, window.window());
+}
+
+TEST(IncastWindow, additiveIncrease) {
+  IncastWindow window(1, 8, 5.0);
+  window.onRetransmits(6.0, 1000000);
+  window.onRetransmits(6.0, 2000000);
+  EXPECT_EQ(2, window.window());
+
+  // Each good sample adds 1/window of a key.
+  EXPECT_FALSE(window.onRetransmits(0.0, 3000000));
+  EXPECT_FALSE(window.onRetransmits(0.0, 3000000));
+  EXPECT_TRUE(window.onRetransmits(0.0, 3000000));
+  EXPECT_EQ(3, window.window());
+
+  for (int i = 0; i < 100; ++i) {
+    window.onRetransmits(0.0, 4000000);
+  }
+  EXPECT_EQ(8, window.window());
+}
@@ -0,0 +1,65 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <gtest/gtest.h>
+
+#include "mcrouter/InflightWindow.h"
+
+using facebook::memcache::mcrouter::InflightWindow;
+
+TEST(InflightWindow, startsAtMax) {
+  InflightWindow window(2, 8, 2.0);
+  EXPECT_EQ(8, window.window());
+
+  // Replies that came back in time can't grow the window over the max.
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_FALSE(window.onReply(false, 1000, 1000000 + i * 10));
+  }
+  EXPECT_EQ(8, window.window());
+}
+
+TEST(InflightWindow, decreaseOncePerRoundTrip) {
+  InflightWindow window(2, 8, 2.0);
+  EXPECT_TRUE(window.onReply(true, 1000, 1000000));
+  EXPECT_EQ(4, window.window());
+
+  // Requests sent before the decrease.
+  EXPECT_FALSE(window.onReply(true, 1000, 1000500));
+  EXPECT_EQ(4, window.window());
+
+  EXPECT_TRUE(window.onReply(true, 1000, 1002000));
+  EXPECT_EQ(2, window.window());
+
+  // Never below the min.
+  EXPECT_FALSE(window.onReply(true, 1000, 1004000));
+  EXPECT_EQ(2, window.window());
+}
+
+TEST(InflightWindow, slowReplies) {
+  InflightWindow window(1, 8, 2.0);
+  window.onReply(false, 1000, 1000000);
+  EXPECT_EQ(8, window.window());
+
+  window.onReply(false, 1900, 1010000);
+  EXPECT_EQ(8, window.window());
+
+  window.onReply(false, 2100, 1020000);
+  EXPECT_EQ(4, window.window());
+}
+
+TEST(InflightWindow, additiveIncrease) {
+  InflightWindow window(1, 8, 2.0);
+  window.onReply(true, 1000, 1000000);
+  window.onReply(true, 1000, 1002000);
+  EXPECT_EQ(2, window.window());
+
+  // Each good reply adds 1/window of a request.
+  EXPECT_FALSE(window.onReply(false, 1000, 1003000));
+  EXPECT_FALSE(window.onReply(false, 1000, 1004000));
+  EXPECT_TRUE(window.onReply(false, 1000, 1005000));
+  EXPECT_EQ(3, window.window());
+}
@@ -0,0 +1,82 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <map>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <folly/Conv.h>
+
+#include "mcrouter/KeyPrefixStats.h"
+
+using namespace facebook::memcache::mcrouter;
+
+namespace {
+
+std::map<std::string, KeyPrefixStats::Counters> collect(
+    const KeyPrefixStats& stats) {
+  std::map<std::string, KeyPrefixStats::Counters> result;
+  stats.foreach([&result](
+                    folly::StringPiece prefix,
+                    const KeyPrefixStats::Counters& counters) {
+    result[prefix.str()] = counters;
+  });
+  return result;
+}
+
+} // anonymous namespace
+
+TEST(KeyPrefixStats, countsByPrefix) {
+  KeyPrefixStats stats(":", 16 /* maxPrefixes */);
+  stats.record("a:1", 10, 100, true, 5);
+  stats.record("a:2", 10, 0, false, 15);
+  stats.record("b:1", 20, 0, folly::none, 7);
+  stats.record("nodelimiter", 1, 2, true, 3);
+
+  auto result = collect(stats);
+  ASSERT_EQ(3, result.size());
+
+  const auto& a = result["a"];
+  EXPECT_EQ(2, a.ops);
+  EXPECT_EQ(20, a.bytesIn);
+  EXPECT_EQ(100, a.bytesOut);
+  EXPECT_EQ(1, a.hits);
+  EXPECT_EQ(1, a.misses);
+  EXPECT_EQ(20, a.latencyUs);
+
+  const auto& b = result["b"];
+  EXPECT_EQ(1, b.ops);
+  EXPECT_EQ(0, b.hits);
+  EXPECT_EQ(0, b.misses);
+
+  // Keys without the delimiter go to the overflow slot.
+  const auto& other = result[""];
+  EXPECT_EQ(1, other.ops);
+  EXPECT_EQ(1, other.hits);
+}
+
+TEST(KeyPrefixStats, overflow) {
+  KeyPrefixStats stats(":", 4 /* maxPrefixes */);
+  for (size_t i = 0; i < 10; ++i) {
+    stats.record(folly::to<std::string>("p", i, ":key"), 1, 0, true, 1);
+  }
+
+  auto result = collect(stats);
+  ASSERT_EQ(5, result.size());
+  EXPECT_EQ(6, result[""].ops);
+  for (size_t i = 0; i < 4; ++i) {
+    EXPECT_EQ(1, result[folly::to<std::string>("p", i)].ops);
+  }
+}
+
+TEST(KeyPrefixStats, disabled) {
+  KeyPrefixStats stats("", 16 /* maxPrefixes */);
+  EXPECT_FALSE(stats.enabled());
+  stats.record("a:1", 10, 100, true, 5);
+  EXPECT_TRUE(collect(stats).empty());
+}
@@ -0,0 +1,72 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <folly/Benchmark.h>
+#include <folly/experimental/FunctionScheduler.h>
+#include <folly/init/Init.h>
+
+#include "mcrouter/LeaseTokenMap.h"
+
+using namespace facebook::memcache::mcrouter;
+
+namespace {
+
+/**
+ * Every thread (think proxy) inserts tokens as lease-gets fail over and
+ * redeems them as the matching lease-sets come back.
+ */
+void insertAndQuery(size_t iters, size_t numThreads) {
+  std::shared_ptr<folly::FunctionScheduler> scheduler;
+  std::unique_ptr<LeaseTokenMap> map;
+  BENCHMARK_SUSPEND {
+    scheduler = std::make_shared<folly::FunctionScheduler>();
+    scheduler->start();
+    map = std::make_unique<LeaseTokenMap>(scheduler);
+  }
+
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < numThreads; ++t) {
+    threads.emplace_back([&map, iters, numThreads, t]() {
+      for (size_t i = t; i < iters; i += numThreads) {
+        auto token = map->insert("route01", {i, t});
+        folly::doNotOptimizeAway(map->query("route01", token));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  BENCHMARK_SUSPEND {
+    map.reset();
+    scheduler.reset();
+  }
+}
+
+} // anonymous namespace
+
+BENCHMARK(insertAndQuery_1thread, iters) {
+  insertAndQuery(iters, 1);
+}
+
+BENCHMARK_RELATIVE(insertAndQuery_4threads, iters) {
+  insertAndQuery(iters, 4);
+}
+
+BENCHMARK_RELATIVE(insertAndQuery_16threads, iters) {
+  insertAndQuery(iters, 16);
+}
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv, true /* removeFlags */);
+  folly::runBenchmarks();
+  return 0;
+}
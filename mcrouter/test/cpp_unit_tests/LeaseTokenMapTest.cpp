@@ -7,6 +7,7 @@
  */
 #include <chrono>
 #include <thread>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -149,3 +150,34 @@ TEST(LeaseTokenMap, stress) {
     }
   }
 }
+
+TEST(LeaseTokenMap, multipleThreads) {
+  auto scheduler = std::make_shared<folly::FunctionScheduler>();
+  scheduler->start();
+  LeaseTokenMap map(scheduler);
+
+  // Tokens inserted by different threads (i.e. in different shards) can be
+  // queried from any thread.
+  const size_t kThreads = LeaseTokenMap::kNumShards + 1;
+  const size_t kTokens = 100;
+  std::vector<std::vector<uint64_t>> tokens(kThreads);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&map, &tokens, t, kTokens]() {
+      for (size_t i = 0; i < kTokens; ++i) {
+        tokens[t].push_back(map.insert("route01", {t * kTokens + i, t}));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(kThreads * kTokens, map.size());
+
+  for (size_t t = 0; t < kThreads; ++t) {
+    for (size_t i = 0; i < kTokens; ++i) {
+      assertQueryTrue(map, "route01", tokens[t][i], {t * kTokens + i, t});
+    }
+  }
+  EXPECT_EQ(0, map.size());
+}
@@ -5,20 +5,28 @@
  *  file in the root directory of this source tree.
  *
  */
+#include <algorithm>
+#include <atomic>
 #include <memory>
+#include <string>
 #include <thread>
 #include <utility>
 #include <vector>
 
 #include <gtest/gtest.h>
 
+#include <folly/Portability.h>
 #include <folly/fibers/Baton.h>
 #include <folly/io/async/EventBase.h>
+#if FOLLY_HAS_COROUTINES
+#include <folly/experimental/coro/BlockingWait.h>
+#endif
 
 #include "mcrouter/CarbonRouterClient.h"
 #include "mcrouter/CarbonRouterInstance.h"
 #include "mcrouter/config.h"
 #include "mcrouter/lib/network/gen/MemcacheRouterInfo.h"
+#include "mcrouter/stats.h"
 
 using facebook::memcache::McGetReply;
 using facebook::memcache::McGetRequest;
@@ -27,6 +35,7 @@ using facebook::memcache::McStatsRequest;
 using facebook::memcache::MemcacheRouterInfo;
 using facebook::memcache::mcrouter::CarbonRouterClient;
 using facebook::memcache::mcrouter::CarbonRouterInstance;
+using facebook::memcache::mcrouter::client_queue_requests_stat;
 using facebook::memcache::mcrouter::defaultTestOptions;
 
 /**
@@ -116,6 +125,41 @@ TEST(CarbonRouterClient, basicUsageSameThreadClient) {
   EXPECT_TRUE(replyReceived);
 }
 
+TEST(CarbonRouterClient, inlineSameThreadClient) {
+  auto opts = defaultTestOptions();
+  opts.num_proxies = 1;
+  opts.config_str = R"({ "route": "NullRoute" })";
+
+  folly::EventBase eventBase;
+  std::thread thread([&eventBase]() { eventBase.loopForever(); });
+  auto router = CarbonRouterInstance<MemcacheRouterInfo>::init(
+      "inlineSameThreadClientTest", opts, {&eventBase});
+
+  // With runInline, requests that don't have to wait for anything are
+  // replied to before send() returns.
+  auto client = router->createSameThreadClient(
+      0 /* max_outstanding_requests */, true /* runInline */);
+  client->setProxy(router->getProxy(0));
+
+  bool repliedInline = false;
+  eventBase.runInEventBaseThreadAndWait(
+      [client = client.get(), &repliedInline]() {
+        const McGetRequest req("key");
+        bool replyReceived = false;
+        client->send(
+            req, [&replyReceived](const McGetRequest&, McGetReply&& reply) {
+              EXPECT_EQ(mc_res_notfound, reply.result());
+              replyReceived = true;
+            });
+        repliedInline = replyReceived;
+      });
+
+  router->shutdown();
+  eventBase.terminateLoopSoon();
+  thread.join();
+  EXPECT_TRUE(repliedInline);
+}
+
 TEST(CarbonRouterClient, basicUsageRemoteThreadClient) {
   // This test is a lot like the previous one, except this test demonstrates
   // the use of a client that can safely send a request through a Proxy
@@ -152,6 +196,25 @@ TEST(CarbonRouterClient, basicUsageRemoteThreadClient) {
   EXPECT_TRUE(replyReceived);
 }
 
+#if FOLLY_HAS_COROUTINES
+TEST(CarbonRouterClient, coroutineRemoteThreadClient) {
+  // Same as the previous test, but for coroutine-based code: co_send()
+  // returns a task that completes with the reply, no callback needed.
+  auto opts = defaultTestOptions();
+  opts.config_str = R"({ "route": "NullRoute" })";
+
+  auto router = CarbonRouterInstance<MemcacheRouterInfo>::init(
+      "coroutineRemoteThreadClientTest", opts);
+  auto client = router->createClient(0 /* max_outstanding_requests */);
+
+  const McGetRequest req("key");
+  auto reply = folly::coro::blockingWait(client->co_send(req));
+  EXPECT_EQ(mc_res_notfound, reply.result());
+
+  router->shutdown();
+}
+#endif
+
 TEST(CarbonRouterClient, remoteThreadStatsRequestUsage) {
   // This test is a lot like the previous one, except this test demonstrates
   // how to collect libmcrouter stats using the McStatsRequest.
@@ -188,3 +251,103 @@ TEST(CarbonRouterClient, remoteThreadStatsRequestUsage) {
   router->shutdown();
   EXPECT_TRUE(replyReceived);
 }
+
+namespace {
+
+/**
+ * Sends reqs through client as a single multi-request send(), waits for all
+ * the replies.
+ */
+template <class Client>
+void sendBatchAndWait(Client& client, const std::vector<McGetRequest>& reqs) {
+  std::atomic<size_t> replies{0};
+  folly::fibers::Baton baton;
+  client.send(
+      reqs.begin(),
+      reqs.end(),
+      [&replies, &baton, n = reqs.size()](
+          const McGetRequest&, McGetReply&& reply) {
+        EXPECT_EQ(mc_res_notfound, reply.result());
+        if (++replies == n) {
+          baton.post();
+        }
+      });
+  baton.wait();
+  EXPECT_EQ(reqs.size(), replies.load());
+}
+
+std::vector<size_t> requestsPerProxy(
+    const CarbonRouterInstance<MemcacheRouterInfo>& router,
+    size_t numProxies) {
+  std::vector<size_t> requests;
+  for (size_t i = 0; i < numProxies; ++i) {
+    requests.push_back(
+        router.getProxy(i)->stats().getValue(client_queue_requests_stat));
+  }
+  return requests;
+}
+
+} // anonymous namespace
+
+TEST(CarbonRouterClient, batchSendRemoteThreadClient) {
+  auto opts = defaultTestOptions();
+  opts.num_proxies = 1;
+  opts.config_str = R"({ "route": "NullRoute" })";
+
+  auto router = CarbonRouterInstance<MemcacheRouterInfo>::init(
+      "batchSendRemoteThreadClientTest", opts);
+
+  std::vector<McGetRequest> reqs;
+  for (size_t i = 0; i < 100; ++i) {
+    reqs.emplace_back("key" + std::to_string(i));
+  }
+
+  // The whole batch crosses to the proxy as one message.
+  auto client = router->createClient(0 /* max_outstanding_requests */);
+  sendBatchAndWait(*client, reqs);
+  EXPECT_EQ(std::vector<size_t>({100}), requestsPerProxy(*router, 1));
+
+  // With a limit on outstanding requests, one message per chunk.
+  auto limitedClient = router->createClient(16 /* max_outstanding_requests */);
+  sendBatchAndWait(*limitedClient, reqs);
+  EXPECT_EQ(std::vector<size_t>({200}), requestsPerProxy(*router, 1));
+
+  router->shutdown();
+}
+
+TEST(CarbonRouterClient, keyAffinity) {
+  auto opts = defaultTestOptions();
+  opts.num_proxies = 4;
+  opts.proxy_key_affinity = true;
+  opts.config_str = R"({ "route": "NullRoute" })";
+
+  auto router = CarbonRouterInstance<MemcacheRouterInfo>::init(
+      "keyAffinityTest", opts);
+  auto client = router->createClient(0 /* max_outstanding_requests */);
+  auto otherClient = router->createClient(0 /* max_outstanding_requests */);
+
+  // All requests for a key go to one proxy, whatever the client.
+  std::vector<McGetRequest> sameKey(10, McGetRequest("/a/b/key"));
+  sendBatchAndWait(*client, sameKey);
+  sendBatchAndWait(*otherClient, sameKey);
+  auto requests = requestsPerProxy(*router, opts.num_proxies);
+  const size_t keyProxy =
+      std::find(requests.begin(), requests.end(), 20) - requests.begin();
+  ASSERT_LT(keyProxy, opts.num_proxies);
+  EXPECT_EQ(3, std::count(requests.begin(), requests.end(), 0));
+
+  // The routing prefix doesn't matter, only the routing key does.
+  sendBatchAndWait(*client, {McGetRequest("/c/d/key")});
+  EXPECT_EQ(21, requestsPerProxy(*router, opts.num_proxies)[keyProxy]);
+
+  // Different keys are spread over the proxies.
+  std::vector<McGetRequest> keys;
+  for (size_t i = 0; i < 100; ++i) {
+    keys.emplace_back("key" + std::to_string(i));
+  }
+  sendBatchAndWait(*client, keys);
+  requests = requestsPerProxy(*router, opts.num_proxies);
+  EXPECT_EQ(0, std::count(requests.begin(), requests.end(), 0));
+
+  router->shutdown();
+}
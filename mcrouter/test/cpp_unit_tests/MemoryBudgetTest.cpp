@@ -0,0 +1,29 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <gtest/gtest.h>
+
+#include "mcrouter/MemoryBudget.h"
+
+using namespace facebook::memcache::mcrouter;
+
+TEST(MemoryBudget, batching) {
+  const auto before = MemoryBudget::used();
+  {
+    MemoryBudget budget;
+    budget.charge(MemoryBudget::kBatchBytes - 1);
+    EXPECT_EQ(before, MemoryBudget::used());
+    budget.charge(1);
+    EXPECT_EQ(before + MemoryBudget::kBatchBytes, MemoryBudget::used());
+
+    budget.charge(-MemoryBudget::kBatchBytes + 1);
+    EXPECT_EQ(before + MemoryBudget::kBatchBytes, MemoryBudget::used());
+    budget.charge(10);
+  }
+  // Destruction publishes everything left.
+  EXPECT_EQ(before + 11, MemoryBudget::used());
+}
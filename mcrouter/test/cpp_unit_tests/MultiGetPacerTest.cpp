@@ -0,0 +1,140 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/MultiGetPacer.h"
+
+using facebook::memcache::mcrouter::MultiGetPacer;
+
+namespace {
+
+/**
+ * Keys of multigets sent through a MultiGetPacer. Replies to keys listed in
+ * replyWhenSent right away, keeps the reply callbacks of the others.
+ */
+struct Keys {
+  std::vector<int> sent;
+  std::map<int, folly::Function<void()>> inflight;
+  std::vector<int> replyWhenSent;
+
+  MultiGetPacer::SendKey key(int id) {
+    return [this, id](folly::Function<void()> onReplied) {
+      sent.push_back(id);
+      if (std::find(replyWhenSent.begin(), replyWhenSent.end(), id) !=
+          replyWhenSent.end()) {
+        onReplied();
+      } else {
+        inflight.emplace(id, std::move(onReplied));
+      }
+    };
+  }
+
+  void reply(int id) {
+    auto it = inflight.find(id);
+    ASSERT_NE(inflight.end(), it);
+    auto onReplied = std::move(it->second);
+    inflight.erase(it);
+    onReplied();
+  }
+};
+
+const int kMultiGet = 0;
+
+} // anonymous namespace
+
+TEST(MultiGetPacer, defersKeysBeyondWindow) {
+  size_t window = 2;
+  MultiGetPacer pacer([&window]() { return window; });
+  Keys keys;
+
+  EXPECT_TRUE(pacer.send(&kMultiGet, keys.key(0)));
+  EXPECT_TRUE(pacer.send(&kMultiGet, keys.key(1)));
+  for (int i = 2; i < 6; ++i) {
+    EXPECT_FALSE(pacer.send(&kMultiGet, keys.key(i)));
+  }
+  EXPECT_EQ(std::vector<int>({0, 1}), keys.sent);
+
+  // Held back keys go out in order as replies come back, in any order.
+  keys.reply(1);
+  EXPECT_EQ(std::vector<int>({0, 1, 2}), keys.sent);
+  keys.reply(0);
+  EXPECT_EQ(std::vector<int>({0, 1, 2, 3}), keys.sent);
+
+  // The window is read again on every reply.
+  window = 3;
+  keys.reply(2);
+  EXPECT_EQ(std::vector<int>({0, 1, 2, 3, 4, 5}), keys.sent);
+  EXPECT_EQ(1, pacer.numMultiGets());
+
+  keys.reply(3);
+  keys.reply(5);
+  EXPECT_EQ(1, pacer.numMultiGets());
+  keys.reply(4);
+  EXPECT_EQ(0, pacer.numMultiGets());
+  EXPECT_EQ(std::vector<int>({0, 1, 2, 3, 4, 5}), keys.sent);
+}
+
+TEST(MultiGetPacer, repliesWhileSending) {
+  MultiGetPacer pacer([]() { return 2; });
+  Keys keys;
+  keys.replyWhenSent = {0, 1, 2, 3, 4};
+
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_TRUE(pacer.send(&kMultiGet, keys.key(i)));
+    EXPECT_EQ(0, pacer.numMultiGets());
+  }
+  EXPECT_EQ(std::vector<int>({0, 1, 2, 3, 4}), keys.sent);
+}
+
+TEST(MultiGetPacer, deferredKeysReplyWhileSending) {
+  MultiGetPacer pacer([]() { return 2; });
+  Keys keys;
+  // Key 2 is released by the reply to key 0, and the replies to the
+  // following keys release the rest from within the send of key 2.
+  keys.replyWhenSent = {2, 3, 4, 5};
+
+  EXPECT_TRUE(pacer.send(&kMultiGet, keys.key(0)));
+  EXPECT_TRUE(pacer.send(&kMultiGet, keys.key(1)));
+  for (int i = 2; i < 6; ++i) {
+    EXPECT_FALSE(pacer.send(&kMultiGet, keys.key(i)));
+  }
+
+  keys.reply(0);
+  EXPECT_EQ(std::vector<int>({0, 1, 2, 3, 4, 5}), keys.sent);
+  EXPECT_EQ(1, pacer.numMultiGets());
+
+  keys.reply(1);
+  EXPECT_EQ(0, pacer.numMultiGets());
+  EXPECT_EQ(std::vector<int>({0, 1, 2, 3, 4, 5}), keys.sent);
+}
+
+TEST(MultiGetPacer, multiGetsArePacedSeparately) {
+  const int kOther = 1;
+  MultiGetPacer pacer([]() { return 1; });
+  Keys keys;
+
+  EXPECT_TRUE(pacer.send(&kMultiGet, keys.key(0)));
+  EXPECT_FALSE(pacer.send(&kMultiGet, keys.key(1)));
+  EXPECT_TRUE(pacer.send(&kOther, keys.key(10)));
+  EXPECT_FALSE(pacer.send(&kOther, keys.key(11)));
+  EXPECT_EQ(2, pacer.numMultiGets());
+
+  keys.reply(10);
+  EXPECT_EQ(std::vector<int>({0, 10, 11}), keys.sent);
+  keys.reply(11);
+  EXPECT_EQ(1, pacer.numMultiGets());
+
+  keys.reply(0);
+  keys.reply(1);
+  EXPECT_EQ(0, pacer.numMultiGets());
+  EXPECT_EQ(std::vector<int>({0, 10, 11, 1}), keys.sent);
+}
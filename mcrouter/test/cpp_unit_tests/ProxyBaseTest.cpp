@@ -0,0 +1,95 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include <folly/io/async/EventBase.h>
+
+#include "mcrouter/CarbonRouterInstance.h"
+#include "mcrouter/config.h"
+#include "mcrouter/lib/network/gen/MemcacheRouterInfo.h"
+
+using namespace facebook::memcache;
+using namespace facebook::memcache::mcrouter;
+
+namespace {
+
+McrouterOptions testOptions() {
+  auto opts = defaultTestOptions();
+  opts.config_str = R"({ "route": "NullRoute" })";
+  return opts;
+}
+
+/**
+ * @return  maxNoFlushEventLoops() of a fresh proxy after a single batch of
+ *          batchSize requests, which is then its exact average.
+ */
+size_t noFlushLoopsAfterBatch(const McrouterOptions& opts, size_t batchSize) {
+  static size_t instance = 0;
+  auto router = CarbonRouterInstance<MemcacheRouterInfo>::init(
+      "proxyBaseTest" + std::to_string(instance++), opts);
+  EXPECT_NE(nullptr, router);
+  auto* proxy = router->getProxy(0);
+  size_t loops = 0;
+  proxy->eventBase().getEventBase().runInEventBaseThreadAndWait([&]() {
+    proxy->onDestinationBatch(batchSize);
+    loops = proxy->maxNoFlushEventLoops();
+  });
+  return loops;
+}
+
+} // anonymous namespace
+
+TEST(ProxyBase, maxNoFlushEventLoopsWithoutAdaptiveFlush) {
+  auto opts = testOptions();
+  opts.max_no_flush_event_loops = 5;
+  EXPECT_EQ(5, noFlushLoopsAfterBatch(opts, 1));
+  EXPECT_EQ(5, noFlushLoopsAfterBatch(opts, 100));
+}
+
+TEST(ProxyBase, maxNoFlushEventLoopsAdaptiveFlush) {
+  auto opts = testOptions();
+  opts.adaptive_flush = true;
+  opts.max_no_flush_event_loops = 5;
+  // One loop per doubling of the average batch size.
+  EXPECT_EQ(0, noFlushLoopsAfterBatch(opts, 0));
+  EXPECT_EQ(0, noFlushLoopsAfterBatch(opts, 1));
+  EXPECT_EQ(1, noFlushLoopsAfterBatch(opts, 2));
+  EXPECT_EQ(1, noFlushLoopsAfterBatch(opts, 3));
+  EXPECT_EQ(2, noFlushLoopsAfterBatch(opts, 4));
+  EXPECT_EQ(2, noFlushLoopsAfterBatch(opts, 7));
+  EXPECT_EQ(3, noFlushLoopsAfterBatch(opts, 8));
+  EXPECT_EQ(4, noFlushLoopsAfterBatch(opts, 16));
+  // Capped by max_no_flush_event_loops.
+  EXPECT_EQ(5, noFlushLoopsAfterBatch(opts, 32));
+  EXPECT_EQ(5, noFlushLoopsAfterBatch(opts, 1000));
+
+  opts.max_no_flush_event_loops = 2;
+  EXPECT_EQ(2, noFlushLoopsAfterBatch(opts, 1000));
+}
+
+TEST(ProxyBase, prefaultedFibersStayInPool) {
+  auto opts = testOptions();
+  opts.fibers_prefault_stacks = 8;
+  // Would free every fiber left idle for a period.
+  opts.fibers_pool_resize_period_ms = 10;
+  auto router = CarbonRouterInstance<MemcacheRouterInfo>::init(
+      "proxyBaseTestPrefault", opts);
+  ASSERT_NE(nullptr, router);
+  auto* proxy = router->getProxy(0);
+
+  /* sleep override */
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  size_t poolSize = 0;
+  proxy->eventBase().getEventBase().runInEventBaseThreadAndWait(
+      [&]() { poolSize = proxy->fiberManager().fibersPoolSize(); });
+  EXPECT_GE(poolSize, 8);
+}
@@ -0,0 +1,335 @@
+/*
+ *  Copyright (c) 2016-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gflags/gflags.h>
+
+#include <folly/Format.h>
+#include <folly/String.h>
+#include <folly/fibers/Baton.h>
+#include <folly/init/Init.h>
+#include <folly/io/async/EventBase.h>
+
+#include "mcrouter/CarbonRouterClient.h"
+#include "mcrouter/CarbonRouterInstance.h"
+#include "mcrouter/lib/McResUtil.h"
+#include "mcrouter/lib/network/gen/MemcacheRouterInfo.h"
+#include "mcrouter/lib/network/test/TestClientServerUtil.h"
+#include "mcrouter/mcrouter_config.h"
+
+/**
+ * End-to-end benchmark of the proxy core: a CarbonRouterInstance with the
+ * given route config in front of in-process test servers, driven by
+ * CarbonRouterClients with a fixed number of outstanding requests.
+ *
+ * Reports throughput, latency percentiles, allocations per request (global
+ * operator new, so the servers' allocations are included) and proxy thread
+ * CPU time per request.
+ *
+ * Example:
+ *   ProxyBenchmark --concurrency=64 --num_requests=1000000 \
+ *     --route='"PoolRoute|A"'
+ */
+
+DEFINE_string(
+    route,
+    "\"PoolRoute|A\"",
+    "Route of the config (JSON). Pool \"A\" contains all the test servers.");
+DEFINE_string(protocol, "caret", "Protocol used to talk to the test servers.");
+DEFINE_uint32(num_servers, 2, "Number of test servers.");
+DEFINE_uint32(num_proxies, 2, "Number of proxy threads.");
+DEFINE_uint32(concurrency, 32, "Number of outstanding requests.");
+DEFINE_uint64(num_requests, 500000, "Number of measured requests.");
+DEFINE_uint64(num_warmup_requests, 50000, "Number of warm up requests.");
+DEFINE_string(operation, "get", "Operation to send: \"get\" or \"set\".");
+DEFINE_uint32(value_size, 100, "Size of the values of gets and sets.");
+
+namespace {
+
+std::atomic<uint64_t> gNumAllocations{0};
+
+} // anonymous namespace
+
+void* operator new(size_t size) {
+  gNumAllocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(size)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+  return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+  std::free(p);
+}
+
+using namespace facebook::memcache;
+using namespace facebook::memcache::mcrouter;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct RunResult {
+  std::chrono::nanoseconds duration{0};
+  // Latency of every request, in microseconds.
+  std::vector<uint32_t> latenciesUs;
+  uint64_t numErrors{0};
+  uint64_t numAllocations{0};
+  std::chrono::nanoseconds proxyCpu{0};
+};
+
+std::chrono::nanoseconds threadCpuTime() {
+  timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return std::chrono::seconds(ts.tv_sec) +
+      std::chrono::nanoseconds(ts.tv_nsec);
+}
+
+std::chrono::nanoseconds proxyCpuTime(
+    const std::vector<std::unique_ptr<folly::EventBase>>& evbs) {
+  std::chrono::nanoseconds total{0};
+  for (auto& evb : evbs) {
+    evb->runInEventBaseThreadAndWait([&total]() { total += threadCpuTime(); });
+  }
+  return total;
+}
+
+/**
+ * Keeps FLAGS_concurrency requests in flight until numRequests replies are
+ * received. Every slot owns its request and sends the next one from the
+ * reply callback.
+ */
+template <class Request>
+class Driver {
+ public:
+  Driver(
+      std::vector<CarbonRouterClient<MemcacheRouterInfo>::Pointer>& clients,
+      std::vector<Request>& requests)
+      : clients_(clients), requests_(requests) {}
+
+  RunResult run(
+      uint64_t numRequests,
+      const std::vector<std::unique_ptr<folly::EventBase>>& evbs) {
+    RunResult result;
+    result.latenciesUs.resize(numRequests);
+    latenciesUs_ = result.latenciesUs.data();
+    numRequests_ = numRequests;
+    sent_ = 0;
+    done_ = 0;
+    errors_ = 0;
+    baton_.reset();
+
+    const auto allocationsBefore = gNumAllocations.load();
+    const auto cpuBefore = proxyCpuTime(evbs);
+    const auto start = Clock::now();
+    for (size_t slot = 0; slot < requests_.size(); ++slot) {
+      sendNext(slot);
+    }
+    baton_.wait();
+    result.duration = Clock::now() - start;
+    result.proxyCpu = proxyCpuTime(evbs) - cpuBefore;
+    result.numAllocations = gNumAllocations.load() - allocationsBefore;
+    result.numErrors = errors_.load();
+    return result;
+  }
+
+ private:
+  std::vector<CarbonRouterClient<MemcacheRouterInfo>::Pointer>& clients_;
+  std::vector<Request>& requests_;
+  uint32_t* latenciesUs_{nullptr};
+  uint64_t numRequests_{0};
+  std::atomic<uint64_t> sent_{0};
+  std::atomic<uint64_t> done_{0};
+  std::atomic<uint64_t> errors_{0};
+  folly::fibers::Baton baton_;
+
+  void sendNext(size_t slot) {
+    const auto seq = sent_.fetch_add(1);
+    if (seq >= numRequests_) {
+      return;
+    }
+    const auto start = Clock::now();
+    auto& client = clients_[slot % clients_.size()];
+    client->send(
+        requests_[slot],
+        [this, slot, seq, start](const Request&, ReplyT<Request>&& reply) {
+          latenciesUs_[seq] =
+              std::chrono::duration_cast<std::chrono::microseconds>(
+                  Clock::now() - start)
+                  .count();
+          if (isErrorResult(reply.result())) {
+            ++errors_;
+          }
+          if (done_.fetch_add(1) + 1 == numRequests_) {
+            baton_.post();
+          } else {
+            sendNext(slot);
+          }
+        });
+  }
+};
+
+void report(const char* name, RunResult result) {
+  const auto numRequests = result.latenciesUs.size();
+  std::sort(result.latenciesUs.begin(), result.latenciesUs.end());
+  auto percentile = [&result](double p) {
+    const auto& l = result.latenciesUs;
+    return l.empty() ? 0 : l[std::min<size_t>(l.size() - 1, l.size() * p)];
+  };
+  const double seconds =
+      std::chrono::duration<double>(result.duration).count();
+
+  std::cout << folly::sformat(
+      "{}: {} requests in {:.3f}s, {:.0f} req/s, {} errors\n"
+      "  latency us: p50 {} p90 {} p99 {} p99.9 {} max {}\n"
+      "  allocations/req: {:.1f}\n"
+      "  proxy cpu/req: {:.2f} us\n",
+      name,
+      numRequests,
+      seconds,
+      numRequests / seconds,
+      result.numErrors,
+      percentile(0.5),
+      percentile(0.9),
+      percentile(0.99),
+      percentile(0.999),
+      result.latenciesUs.empty() ? 0 : result.latenciesUs.back(),
+      static_cast<double>(result.numAllocations) / numRequests,
+      std::chrono::duration<double, std::micro>(result.proxyCpu).count() /
+          numRequests);
+}
+
+template <class Request>
+void runBenchmark(
+    CarbonRouterInstance<MemcacheRouterInfo>& router,
+    const std::vector<std::unique_ptr<folly::EventBase>>& evbs,
+    std::vector<Request> requests) {
+  std::vector<CarbonRouterClient<MemcacheRouterInfo>::Pointer> clients;
+  for (size_t i = 0; i < FLAGS_num_proxies; ++i) {
+    clients.push_back(router.createClient(0 /* max_outstanding_requests */));
+  }
+
+  Driver<Request> driver(clients, requests);
+  if (FLAGS_num_warmup_requests > 0) {
+    report("warmup", driver.run(FLAGS_num_warmup_requests, evbs));
+  }
+  report("measured", driver.run(FLAGS_num_requests, evbs));
+}
+
+std::string buildConfig(
+    const std::vector<std::unique_ptr<TestServer>>& servers) {
+  std::vector<std::string> addresses;
+  for (const auto& server : servers) {
+    addresses.push_back(
+        folly::sformat("\"localhost:{}\"", server->getListenPort()));
+  }
+  return folly::sformat(
+      R"({{"pools": {{"A": {{"servers": [{}], "protocol": "{}"}}}},
+           "route": {}}})",
+      folly::join(",", addresses),
+      FLAGS_protocol,
+      FLAGS_route);
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv, true /* removeFlags */);
+
+  std::vector<std::unique_ptr<TestServer>> servers;
+  for (size_t i = 0; i < FLAGS_num_servers; ++i) {
+    TestServer::Config config;
+    config.useSsl = false;
+    config.maxInflight = 0;
+    config.maxConns = 1000;
+    servers.push_back(TestServer::create(std::move(config)));
+  }
+
+  std::vector<std::unique_ptr<folly::EventBase>> evbs;
+  std::vector<folly::EventBase*> evbPtrs;
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < FLAGS_num_proxies; ++i) {
+    evbs.push_back(std::make_unique<folly::EventBase>());
+    evbPtrs.push_back(evbs.back().get());
+  }
+  for (auto evbPtr : evbPtrs) {
+    threads.emplace_back([evbPtr]() { evbPtr->loopForever(); });
+  }
+
+  auto opts = defaultTestOptions();
+  opts.num_proxies = FLAGS_num_proxies;
+  opts.config_str = buildConfig(servers);
+  auto router = CarbonRouterInstance<MemcacheRouterInfo>::init(
+      "ProxyBenchmark", opts, evbPtrs);
+  if (!router) {
+    std::cerr << "Failed to create router with config: " << opts.config_str
+              << std::endl;
+    return 1;
+  }
+
+  // The test servers reply to "value_size:N" gets with an N bytes value.
+  const auto key = folly::sformat("value_size:{}", FLAGS_value_size);
+  if (FLAGS_operation == "get") {
+    std::vector<McGetRequest> requests;
+    for (size_t i = 0; i < FLAGS_concurrency; ++i) {
+      requests.emplace_back(key);
+    }
+    runBenchmark(*router, evbs, std::move(requests));
+  } else if (FLAGS_operation == "set") {
+    std::vector<McSetRequest> requests;
+    for (size_t i = 0; i < FLAGS_concurrency; ++i) {
+      requests.emplace_back(folly::sformat("key:{}", i));
+      requests.back().value() = folly::IOBuf(
+          folly::IOBuf::COPY_BUFFER, std::string(FLAGS_value_size, 'a'));
+    }
+    runBenchmark(*router, evbs, std::move(requests));
+  } else {
+    std::cerr << "Unknown operation: " << FLAGS_operation << std::endl;
+    return 1;
+  }
+
+  router->shutdown();
+  for (auto& evb : evbs) {
+    evb->terminateLoopSoon();
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (auto& server : servers) {
+    server->shutdown();
+    server->join();
+  }
+  return 0;
+}
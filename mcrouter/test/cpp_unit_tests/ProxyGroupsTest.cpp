@@ -0,0 +1,48 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/ProxyGroups.h"
+
+using namespace facebook::memcache::mcrouter;
+
+TEST(ProxyGroups, empty) {
+  ProxyGroups groups("", 4, "/a/a/");
+  EXPECT_TRUE(groups.empty());
+  EXPECT_EQ(std::vector<size_t>({0, 1, 2, 3}), groups.proxiesFor("/a/b/"));
+  EXPECT_EQ(std::vector<size_t>({0, 1, 2, 3}), groups.proxiesFor(""));
+}
+
+TEST(ProxyGroups, groups) {
+  ProxyGroups groups("/a/b/:0-1,c/d:3", 5, "/c/d/");
+  EXPECT_FALSE(groups.empty());
+  EXPECT_EQ(std::vector<size_t>({0, 1}), groups.proxiesFor("/a/b/"));
+  EXPECT_EQ(std::vector<size_t>({3}), groups.proxiesFor("/c/d/"));
+  // No routing prefix: the default route is used.
+  EXPECT_EQ(std::vector<size_t>({3}), groups.proxiesFor(""));
+  EXPECT_EQ(std::vector<size_t>({2, 4}), groups.proxiesFor("/a/c/"));
+  EXPECT_EQ(std::vector<size_t>({2, 4}), groups.defaultProxies());
+}
+
+TEST(ProxyGroups, invalid) {
+  // Malformed.
+  EXPECT_THROW(ProxyGroups("/a/b/", 4, "/a/a/"), std::logic_error);
+  EXPECT_THROW(ProxyGroups("/a/:0", 4, "/a/a/"), std::logic_error);
+  EXPECT_THROW(ProxyGroups("/a/b/:x", 4, "/a/a/"), std::logic_error);
+  EXPECT_THROW(ProxyGroups("/a/b/:2-1", 4, "/a/a/"), std::logic_error);
+  // Out of range.
+  EXPECT_THROW(ProxyGroups("/a/b/:3-4", 4, "/a/a/"), std::logic_error);
+  // Overlapping.
+  EXPECT_THROW(ProxyGroups("/a/b/:0-1,/a/c/:1", 4, "/a/a/"), std::logic_error);
+  EXPECT_THROW(ProxyGroups("/a/b/:0,/a/b/:1", 4, "/a/a/"), std::logic_error);
+  // Nothing left for the other routing prefixes.
+  EXPECT_THROW(ProxyGroups("/a/b/:0-3", 4, "/a/a/"), std::logic_error);
+}
@@ -0,0 +1,90 @@
+/*
+ *  Copyright (c) 2016-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <gtest/gtest.h>
+
+#include "mcrouter/ProxySchedulingObserver.h"
+#include "mcrouter/ProxyStats.h"
+#include "mcrouter/lib/Clocks.h"
+
+using namespace facebook::memcache::mcrouter;
+
+TEST(ProxySchedulingObserver, runnableDelay) {
+  ProxyStats stats({});
+  ProxySchedulingObserver observer(stats, true, 0);
+
+  // Fibers that were never made runnable (e.g. observer attached late) are
+  // not recorded.
+  observer.starting(1);
+  EXPECT_EQ(0, stats.fiberRunnableDelayUs().histogram().count());
+
+  observer.runnable(1);
+  observer.runnable(2);
+  observer.starting(1);
+  observer.stopped(1);
+  EXPECT_EQ(1, stats.fiberRunnableDelayUs().histogram().count());
+  observer.starting(2);
+  observer.starting(2);
+  EXPECT_EQ(2, stats.fiberRunnableDelayUs().histogram().count());
+}
+
+TEST(ProxySchedulingObserver, slowLoops) {
+  ProxyStats stats({});
+  ProxySchedulingObserver observer(stats, true, 1000);
+
+  observer.loopSample(10, 5000);
+  observer.loopSample(1000, 0);
+  EXPECT_EQ(0, stats.getValue(proxy_slow_loops_stat));
+  observer.loopSample(1001, 0);
+  EXPECT_EQ(1, stats.getValue(proxy_slow_loops_stat));
+  EXPECT_EQ(3, stats.loopBusyUs().histogram().count());
+}
+
+TEST(ProxySchedulingObserver, noDelaysRecorded) {
+  ProxyStats stats({});
+  ProxySchedulingObserver observer(stats, false, 0);
+
+  observer.runnable(1);
+  observer.starting(1);
+  EXPECT_EQ(0, stats.fiberRunnableDelayUs().histogram().count());
+}
+
+TEST(ProxySchedulingObserver, chargeRunningFiber) {
+  if (facebook::memcache::cycles::getCpuCyclesPerUs() == 0) {
+    return;
+  }
+  ProxyStats stats({});
+  ProxySchedulingObserver observer(stats, false, 0);
+
+  uint64_t cpuCycles1 = 0;
+  uint64_t cpuCycles2 = 0;
+  observer.starting(1);
+  observer.chargeRunningFiber(&cpuCycles1);
+  observer.stopped(1);
+  const auto afterFirstRun = cpuCycles1;
+  EXPECT_GT(afterFirstRun, 0);
+
+  // Other fibers are charged separately.
+  observer.starting(2);
+  observer.chargeRunningFiber(&cpuCycles2);
+  observer.stopped(2);
+  EXPECT_EQ(afterFirstRun, cpuCycles1);
+  EXPECT_GT(cpuCycles2, 0);
+
+  observer.starting(3);
+  observer.stopped(3);
+  EXPECT_EQ(afterFirstRun, cpuCycles1);
+
+  observer.starting(1);
+  observer.stopCharging();
+  const auto total = cpuCycles1;
+  EXPECT_GT(total, afterFirstRun);
+  observer.stopped(1);
+  observer.starting(1);
+  observer.stopped(1);
+  EXPECT_EQ(total, cpuCycles1);
+}
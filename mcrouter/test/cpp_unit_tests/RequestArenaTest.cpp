@@ -0,0 +1,74 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/RequestArena.h"
+
+using namespace facebook::memcache::mcrouter;
+
+namespace {
+
+struct Destructed {
+  explicit Destructed(int& counter) : counter_(counter) {}
+  ~Destructed() {
+    ++counter_;
+  }
+
+  int& counter_;
+};
+
+} // anonymous namespace
+
+TEST(RequestArena, disabled) {
+  RequestArena arena(0);
+  EXPECT_EQ(nullptr, arena.allocate(1));
+  EXPECT_FALSE(arena.concat({"a"}).hasValue());
+  EXPECT_EQ(nullptr, arena.create<int>(1));
+}
+
+TEST(RequestArena, concat) {
+  RequestArena arena(4096);
+  auto key = arena.concat({"/a/b/", "foo", "key"});
+  ASSERT_TRUE(key.hasValue());
+  EXPECT_EQ("/a/b/fookey", *key);
+  // Served from the inline buffer.
+  EXPECT_EQ(0, arena.heapBytes());
+}
+
+TEST(RequestArena, create) {
+  int destructed = 0;
+  {
+    RequestArena arena(RequestArena::kBlockSize * 4);
+    for (int i = 0; i < 100; ++i) {
+      auto* str = arena.create<std::string>(100, 'x');
+      ASSERT_NE(nullptr, str);
+      EXPECT_EQ(100, str->size());
+      ASSERT_NE(nullptr, arena.create<Destructed>(destructed));
+    }
+    EXPECT_GT(arena.heapBytes(), 0);
+    EXPECT_EQ(0, destructed);
+  }
+  EXPECT_EQ(100, destructed);
+}
+
+TEST(RequestArena, maxBytes) {
+  const size_t maxBytes = RequestArena::kBlockSize * 4;
+  RequestArena arena(maxBytes);
+  EXPECT_EQ(nullptr, arena.allocate(maxBytes + 1));
+
+  // Big allocations get a block of their own.
+  ASSERT_NE(nullptr, arena.allocate(RequestArena::kBlockSize * 2));
+  size_t allocated = 0;
+  while (arena.allocate(64) != nullptr) {
+    allocated += 64;
+  }
+  EXPECT_GT(allocated, 0);
+  EXPECT_LE(arena.heapBytes(), maxBytes);
+}
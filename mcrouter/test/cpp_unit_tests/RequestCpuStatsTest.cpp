@@ -0,0 +1,46 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <map>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/RequestCpuStats.h"
+
+using namespace facebook::memcache::mcrouter;
+
+TEST(RequestCpuStats, record) {
+  RequestCpuStats stats;
+  stats.record("/a/b/", "get", 10);
+  stats.record("/a/b/", "set", 30);
+  stats.record("/c/d/", "get", 5);
+
+  std::map<std::string, RequestCpuStats::Counters> byPrefix;
+  stats.foreachRoutingPrefix(
+      [&byPrefix](
+          folly::StringPiece prefix, const RequestCpuStats::Counters& c) {
+        byPrefix[prefix.str()] = c;
+      });
+  ASSERT_EQ(2, byPrefix.size());
+  EXPECT_EQ(2, byPrefix["/a/b/"].requests);
+  EXPECT_EQ(40, byPrefix["/a/b/"].cpuCycles);
+  EXPECT_EQ(1, byPrefix["/c/d/"].requests);
+  EXPECT_EQ(5, byPrefix["/c/d/"].cpuCycles);
+
+  std::map<std::string, RequestCpuStats::Counters> byRequest;
+  stats.foreachRequest(
+      [&byRequest](
+          folly::StringPiece name, const RequestCpuStats::Counters& c) {
+        byRequest[name.str()] = c;
+      });
+  ASSERT_EQ(2, byRequest.size());
+  EXPECT_EQ(2, byRequest["get"].requests);
+  EXPECT_EQ(15, byRequest["get"].cpuCycles);
+  EXPECT_EQ(1, byRequest["set"].requests);
+  EXPECT_EQ(30, byRequest["set"].cpuCycles);
+}
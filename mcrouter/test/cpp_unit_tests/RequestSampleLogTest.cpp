@@ -0,0 +1,58 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/RequestSampleLog.h"
+
+using namespace facebook::memcache::mcrouter;
+
+namespace {
+
+RequestSample makeSample(std::string pool) {
+  RequestSample sample;
+  sample.startTimeUs = 1289416829836123;
+  sample.latencyUs = 512;
+  sample.keyHash = 0xdeadbeef;
+  sample.operation = "get";
+  sample.pool = std::move(pool);
+  sample.host = "10.0.0.1";
+  sample.port = 11302;
+  sample.result = mc_res_timeout;
+  sample.replySize = 1024;
+  sample.serverLoad = 5000;
+  return sample;
+}
+
+} // anonymous namespace
+
+TEST(RequestSampleLog, parse) {
+  auto sample1 = makeSample("pool_a");
+  auto sample2 = makeSample(std::string(1000, 'p'));
+  std::string contents = RequestSample::kMagic.str();
+  sample1.appendBinary(contents);
+  sample2.appendBinary(contents);
+
+  auto samples = parseRequestSampleLog(contents);
+  ASSERT_EQ(2, samples.size());
+  EXPECT_EQ(sample1, samples[0]);
+  EXPECT_EQ(sample2, samples[1]);
+
+  // Partially written sample is ignored.
+  contents.resize(contents.size() - 1);
+  samples = parseRequestSampleLog(contents);
+  ASSERT_EQ(1, samples.size());
+  EXPECT_EQ(sample1, samples[0]);
+}
+
+TEST(RequestSampleLog, badMagic) {
+  std::string contents;
+  makeSample("pool_a").appendBinary(contents);
+  EXPECT_THROW(parseRequestSampleLog(contents), std::runtime_error);
+}
@@ -0,0 +1,67 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/SenderRoundRobinQueue.h"
+#include "mcrouter/lib/network/UniqueIntrusiveList.h"
+
+using facebook::memcache::UniqueIntrusiveList;
+using facebook::memcache::UniqueIntrusiveListHook;
+using facebook::memcache::mcrouter::SenderRoundRobinQueue;
+
+namespace {
+
+struct Item {
+  explicit Item(int id_) : id(id_) {}
+
+  UniqueIntrusiveListHook hook;
+  int id;
+};
+
+using Queue = SenderRoundRobinQueue<UniqueIntrusiveList<Item, &Item::hook>>;
+
+std::vector<int> popAll(Queue& queue) {
+  std::vector<int> ids;
+  while (!queue.empty()) {
+    ids.push_back(queue.pop()->id);
+  }
+  return ids;
+}
+
+} // anonymous namespace
+
+TEST(SenderRoundRobinQueue, fifoPerSender) {
+  Queue queue;
+  EXPECT_TRUE(queue.empty());
+  for (int i = 0; i < 3; ++i) {
+    queue.push(1, std::make_unique<Item>(i));
+  }
+  EXPECT_FALSE(queue.empty());
+  EXPECT_EQ(std::vector<int>({0, 1, 2}), popAll(queue));
+}
+
+TEST(SenderRoundRobinQueue, roundRobinAcrossSenders) {
+  Queue queue;
+  // Sender 1 has a big backlog, sender 2 comes later.
+  for (int i = 0; i < 4; ++i) {
+    queue.push(1, std::make_unique<Item>(10 + i));
+  }
+  queue.push(2, std::make_unique<Item>(20));
+  queue.push(2, std::make_unique<Item>(21));
+  queue.push(3, std::make_unique<Item>(30));
+
+  EXPECT_EQ(10, queue.pop()->id);
+  EXPECT_EQ(20, queue.pop()->id);
+  EXPECT_EQ(30, queue.pop()->id);
+  // A sender that runs out of items and comes back goes to the end.
+  queue.push(3, std::make_unique<Item>(31));
+  EXPECT_EQ(std::vector<int>({11, 21, 31, 12, 13}), popAll(queue));
+}
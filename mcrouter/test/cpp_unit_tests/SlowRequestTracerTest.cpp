@@ -0,0 +1,77 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <folly/Conv.h>
+
+#include "mcrouter/SlowRequestTracer.h"
+
+using namespace facebook::memcache::mcrouter;
+
+namespace {
+
+RequestTimeline makeTimeline(folly::StringPiece key) {
+  RequestTimeline timeline(1000 /* startUs */, "get", key);
+  timeline.record(RequestTimeline::Event::RouteStart, 1005);
+  timeline.record(RequestTimeline::Event::DestinationSend, 1010, "pool");
+  timeline.record(
+      RequestTimeline::Event::DestinationReply, 1200, "pool", mc_res_found);
+  timeline.record(RequestTimeline::Event::ReplySent, 1201);
+  return timeline;
+}
+
+} // anonymous namespace
+
+TEST(SlowRequestTracer, timeline) {
+  EXPECT_EQ(
+      "300us get key: +5us route_start, +10us send pool,"
+      " +200us reply pool mc_res_found, +201us reply_sent",
+      makeTimeline("key").toString(300));
+
+  RequestTimeline full(0, "set", "key");
+  for (size_t i = 0; i < RequestTimeline::kMaxEvents + 2; ++i) {
+    full.record(RequestTimeline::Event::RouteStart, i);
+  }
+  auto str = full.toString(100);
+  EXPECT_NE(std::string::npos, str.find(" 2 more events"));
+}
+
+TEST(SlowRequestTracer, keepsSlowRequests) {
+  SlowRequestTracer tracer(100 /* thresholdUs */, 1, 2 /* capacity */);
+  ASSERT_TRUE(tracer.enabled());
+
+  EXPECT_FALSE(tracer.finish(makeTimeline("fast"), 99));
+  for (size_t i = 0; i < 3; ++i) {
+    EXPECT_TRUE(
+        tracer.finish(makeTimeline(folly::to<std::string>("slow", i)), 100));
+  }
+
+  auto recent = tracer.recent();
+  ASSERT_EQ(2, recent.size());
+  EXPECT_EQ(0, recent[0].find("100us get slow1:"));
+  EXPECT_EQ(0, recent[1].find("100us get slow2:"));
+}
+
+TEST(SlowRequestTracer, sampling) {
+  SlowRequestTracer tracer(100 /* thresholdUs */, 3 /* sampleRate */, 10);
+  size_t kept = 0;
+  for (size_t i = 0; i < 9; ++i) {
+    kept += tracer.finish(makeTimeline("slow"), 1000) ? 1 : 0;
+  }
+  EXPECT_EQ(3, kept);
+  EXPECT_EQ(3, tracer.recent().size());
+}
+
+TEST(SlowRequestTracer, disabled) {
+  SlowRequestTracer tracer(0 /* thresholdUs */, 1, 10);
+  EXPECT_FALSE(tracer.enabled());
+  EXPECT_FALSE(tracer.finish(makeTimeline("slow"), 1000000));
+  EXPECT_TRUE(tracer.recent().empty());
+}
@@ -0,0 +1,88 @@
+/*
+ *  Copyright (c) 2016-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <folly/FileUtil.h>
+#include <folly/experimental/TestUtil.h>
+
+#include "mcrouter/StatsMmap.h"
+#include "mcrouter/stats.h"
+
+using namespace facebook::memcache::mcrouter;
+
+namespace {
+
+std::string readStatsFile(const std::string& path) {
+  std::string contents;
+  EXPECT_TRUE(folly::readFile(path.c_str(), contents));
+  return contents;
+}
+
+const StatsMmapEntry* findEntry(const std::string& file, const char* name) {
+  StatsMmapHeader header;
+  std::memcpy(&header, file.data(), sizeof(header));
+  auto entries =
+      reinterpret_cast<const StatsMmapEntry*>(file.data() + sizeof(header));
+  for (size_t i = 0; i < header.numEntries; ++i) {
+    if (std::strcmp(entries[i].name, name) == 0) {
+      return &entries[i];
+    }
+  }
+  return nullptr;
+}
+
+} // anonymous
+
+TEST(StatsMmap, layout) {
+  folly::test::TemporaryDirectory dir;
+  const auto path = (dir.path() / "stats.mmap").string();
+
+  std::vector<stat_t> stats(num_stats);
+  init_stats(stats.data());
+  stats[num_suspect_servers_stat].data.uint64 = 17;
+
+  StatsMmapWriter writer(path, stats);
+  auto file = readStatsFile(path);
+  ASSERT_GE(file.size(), sizeof(StatsMmapHeader));
+
+  StatsMmapHeader header;
+  std::memcpy(&header, file.data(), sizeof(header));
+  EXPECT_EQ(StatsMmapHeader::kMagic, header.magic);
+  EXPECT_EQ(StatsMmapHeader::kVersion, header.version);
+  EXPECT_EQ(0, header.sequence);
+  EXPECT_EQ(sizeof(StatsMmapEntry), header.entrySize);
+  EXPECT_EQ(
+      sizeof(StatsMmapHeader) + header.numEntries * sizeof(StatsMmapEntry),
+      file.size());
+  // String stats are not exported.
+  EXPECT_EQ(nullptr, findEntry(file, "version"));
+
+  auto entry = findEntry(file, "num_suspect_servers");
+  ASSERT_NE(nullptr, entry);
+  EXPECT_EQ(stat_uint64, entry->type);
+  EXPECT_EQ(17, entry->value);
+
+  stats[num_suspect_servers_stat].type = stat_double;
+  stats[num_suspect_servers_stat].data.dbl = 2.5;
+  writer.write(stats);
+
+  file = readStatsFile(path);
+  std::memcpy(&header, file.data(), sizeof(header));
+  EXPECT_EQ(2, header.sequence);
+  EXPECT_NE(0, header.updateTimeMs);
+  entry = findEntry(file, "num_suspect_servers");
+  ASSERT_NE(nullptr, entry);
+  EXPECT_EQ(stat_double, entry->type);
+  double value;
+  std::memcpy(&value, &entry->value, sizeof(value));
+  EXPECT_EQ(2.5, value);
+}
@@ -0,0 +1,42 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/ThreadUtil.h"
+
+using namespace facebook::memcache::mcrouter;
+
+TEST(ThreadUtil, parseCpuList) {
+  EXPECT_EQ(std::vector<size_t>({0}), parseCpuList("0"));
+  EXPECT_EQ(std::vector<size_t>({0, 1, 2, 3}), parseCpuList("0-3"));
+  EXPECT_EQ(
+      std::vector<size_t>({0, 1, 2, 3, 8, 10, 11}),
+      parseCpuList("0-3,8,10-11"));
+  // As read from sysfs.
+  EXPECT_EQ(std::vector<size_t>({4, 5}), parseCpuList("4-5\n"));
+  // Memory-only nodes have an empty cpulist.
+  EXPECT_TRUE(parseCpuList("\n").empty());
+  EXPECT_TRUE(parseCpuList("").empty());
+}
+
+TEST(ThreadUtil, parseCpuListMalformed) {
+  EXPECT_ANY_THROW(parseCpuList("a"));
+  EXPECT_ANY_THROW(parseCpuList("0-b"));
+}
+
+TEST(ThreadUtil, getNumaNodesWithCpus) {
+  EXPECT_TRUE(getNumaNodesWithCpus({}).empty());
+  EXPECT_EQ(
+      std::vector<size_t>({0, 1}), getNumaNodesWithCpus({{0, 1}, {2, 3}}));
+  // Node 1 is offline (a gap in node ids), node 3 has memory only.
+  EXPECT_EQ(
+      std::vector<size_t>({0, 2}),
+      getNumaNodesWithCpus({{0, 1}, {}, {2, 3}, {}}));
+}
@@ -0,0 +1,57 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <gtest/gtest.h>
+
+#include <folly/dynamic.h>
+
+#include "mcrouter/TkoTracker.h"
+
+using namespace facebook::memcache::mcrouter;
+
+TEST(TkoTrackerMap, noRestoredState) {
+  TkoTrackerMap map;
+  EXPECT_FALSE(map.popRestoredTko("127.0.0.1:11211").hasValue());
+  EXPECT_TRUE(map.getTkoState().empty());
+}
+
+TEST(TkoTrackerMap, restoredStateIsPoppedOnce) {
+  TkoTrackerMap map;
+  map.setRestoredTkoState(folly::dynamic::object("127.0.0.1:11211", "hard")(
+      "127.0.0.1:11212", "soft"));
+
+  auto hard = map.popRestoredTko("127.0.0.1:11211");
+  ASSERT_TRUE(hard.hasValue());
+  EXPECT_TRUE(*hard);
+  EXPECT_FALSE(map.popRestoredTko("127.0.0.1:11211").hasValue());
+
+  auto soft = map.popRestoredTko("127.0.0.1:11212");
+  ASSERT_TRUE(soft.hasValue());
+  EXPECT_FALSE(*soft);
+
+  EXPECT_FALSE(map.popRestoredTko("127.0.0.1:11213").hasValue());
+}
+
+TEST(TkoTrackerMap, invalidRestoredStateIsIgnored) {
+  TkoTrackerMap map;
+  map.setRestoredTkoState(folly::dynamic::array("127.0.0.1:11211"));
+  EXPECT_FALSE(map.popRestoredTko("127.0.0.1:11211").hasValue());
+
+  // Entries that aren't strings are skipped, the rest are kept.
+  map.setRestoredTkoState(folly::dynamic::object("127.0.0.1:11211", 1)(
+      "127.0.0.1:11212", "soft"));
+  EXPECT_FALSE(map.popRestoredTko("127.0.0.1:11211").hasValue());
+  EXPECT_TRUE(map.popRestoredTko("127.0.0.1:11212").hasValue());
+}
+
+TEST(TkoTrackerMap, restoredStateIsReplaced) {
+  TkoTrackerMap map;
+  map.setRestoredTkoState(folly::dynamic::object("127.0.0.1:11211", "hard"));
+  map.setRestoredTkoState(folly::dynamic::object("127.0.0.1:11212", "soft"));
+  EXPECT_FALSE(map.popRestoredTko("127.0.0.1:11211").hasValue());
+  EXPECT_TRUE(map.popRestoredTko("127.0.0.1:11212").hasValue());
+}
@@ -12,6 +12,7 @@
 #include <condition_variable>
 #include <memory>
 #include <mutex>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -240,3 +241,24 @@ TEST(awriter, invalid_fd) {
 
   EXPECT_EQ(testCounter.failure, num_entries);
 }
+
+// Test that Normal priority work runs before the Low priority one.
+TEST(awriter, priority) {
+  std::vector<int> order;
+  auto w = std::make_unique<AsyncWriter>(0);
+
+  for (int i = 0; i < 3; i++) {
+    EXPECT_TRUE(w->run(
+        [&order, i]() { order.push_back(10 + i); },
+        AsyncWriter::Priority::Low));
+  }
+  for (int i = 0; i < 3; i++) {
+    EXPECT_TRUE(w->run([&order, i]() { order.push_back(i); }));
+  }
+
+  // Functions still run on stop, writes would fail with EPIPE.
+  w->stop();
+
+  EXPECT_EQ(std::vector<int>({0, 1, 2, 10, 11, 12}), order);
+  EXPECT_FALSE(w->run([]() {}));
+}
@@ -0,0 +1,47 @@
+/*
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <gtest/gtest.h>
+
+#include "mcrouter/ErrorRateWindow.h"
+
+using facebook::memcache::mcrouter::ErrorRateWindow;
+
+TEST(ErrorRateWindow, counts) {
+  ErrorRateWindow window(std::chrono::milliseconds(1000));
+  EXPECT_EQ(0, window.requests());
+  EXPECT_EQ(0, window.errors());
+
+  for (int i = 0; i < 10; ++i) {
+    window.record(i % 3 == 0, 1000000 + i * 1000);
+  }
+  EXPECT_EQ(10, window.requests());
+  EXPECT_EQ(4, window.errors());
+
+  window.reset();
+  EXPECT_EQ(0, window.requests());
+  EXPECT_EQ(0, window.errors());
+}
+
+TEST(ErrorRateWindow, expiry) {
+  // 10 buckets of 100ms each.
+  ErrorRateWindow window(std::chrono::milliseconds(1000));
+  window.record(true, 1000000);
+  window.record(false, 1500000);
+  EXPECT_EQ(2, window.requests());
+  EXPECT_EQ(1, window.errors());
+
+  // The first bucket slides out of the window.
+  window.record(false, 2050000);
+  EXPECT_EQ(2, window.requests());
+  EXPECT_EQ(0, window.errors());
+
+  // Everything expires after a long pause.
+  window.record(true, 10000000);
+  EXPECT_EQ(1, window.requests());
+  EXPECT_EQ(1, window.errors());
+}
@@ -5,6 +5,9 @@
  *  file in the root directory of this source tree.
  *
  */
+#include <stdio.h>
+#include <unistd.h>
+
 #include <condition_variable>
 #include <mutex>
 #include <string>
@@ -13,11 +16,11 @@
 
 #include <folly/FileUtil.h>
 #include <folly/experimental/TestUtil.h>
-#include <folly/io/async/ScopedEventBaseThread.h>
 
 #include "mcrouter/FileObserver.h"
 
 using facebook::memcache::mcrouter::startObservingFile;
+using folly::test::TemporaryDirectory;
 using folly::test::TemporaryFile;
 
 const std::string BOGUS_CONFIG = "this/file/doesnot/exists";
@@ -33,14 +36,10 @@ TEST(FileObserver, sanity) {
       folly::writeFull(config.fd(), contents.data(), contents.size()),
       contents.size());
 
-  const auto scheduler = std::make_shared<folly::FunctionScheduler>();
-  scheduler->start();
   int counter = 0;
   auto handle = startObservingFile(
       path,
-      scheduler,
       std::chrono::milliseconds(100),
-      std::chrono::milliseconds(500),
       [&counter, &cv](std::string) {
         counter++;
         cv.notify_all();
@@ -81,22 +80,16 @@ TEST(FileObserver, sanity) {
 }
 
 TEST(FileObserver, on_error_callback) {
-  const auto scheduler = std::make_shared<folly::FunctionScheduler>();
-  scheduler->start();
   int successCounter1 = 0;
   auto handle1 = startObservingFile(
       BOGUS_CONFIG,
-      scheduler,
       std::chrono::milliseconds(100),
-      std::chrono::milliseconds(500),
       [&successCounter1](std::string) { successCounter1++; });
 
   int successCounter2 = 0;
   auto handle2 = startObservingFile(
       "",
-      scheduler,
       std::chrono::milliseconds(100),
-      std::chrono::milliseconds(500),
       [&successCounter2](std::string) { successCounter2++; });
 
   EXPECT_EQ(successCounter1, 0);
@@ -105,3 +98,76 @@ TEST(FileObserver, on_error_callback) {
   EXPECT_EQ(successCounter2, 0);
   EXPECT_FALSE(handle2);
 }
+
+namespace {
+
+class Updates {
+ public:
+  std::function<void(std::string)> callback() {
+    return [this](std::string contents) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      contents_ = std::move(contents);
+      cv_.notify_all();
+    };
+  }
+
+  bool waitFor(const std::string& contents) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return cv_.wait_for(lock, std::chrono::seconds(5), [&]() {
+      return contents_ == contents;
+    });
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::string contents_;
+};
+
+} // anonymous namespace
+
+TEST(FileObserver, atomic_rename) {
+  TemporaryDirectory dir("file_observer_test");
+  auto path = (dir.path() / "config").string();
+  auto tmpPath = (dir.path() / "config.tmp").string();
+  ASSERT_TRUE(folly::writeFile(std::string("a"), path.c_str()));
+
+  Updates updates;
+  auto handle = startObservingFile(
+      path, std::chrono::milliseconds(0), updates.callback());
+  ASSERT_TRUE(handle);
+  EXPECT_TRUE(updates.waitFor("a"));
+
+  ASSERT_TRUE(folly::writeFile(std::string("b"), tmpPath.c_str()));
+  ASSERT_EQ(0, rename(tmpPath.c_str(), path.c_str()));
+  EXPECT_TRUE(updates.waitFor("b"));
+
+  ASSERT_TRUE(folly::writeFile(std::string("c"), tmpPath.c_str()));
+  ASSERT_EQ(0, rename(tmpPath.c_str(), path.c_str()));
+  EXPECT_TRUE(updates.waitFor("c"));
+}
+
+TEST(FileObserver, symlink_swap) {
+  TemporaryDirectory dir("file_observer_test");
+  auto link = (dir.path() / "config").string();
+  auto tmpLink = (dir.path() / "config.tmp").string();
+  auto target1 = (dir.path() / "config.1").string();
+  auto target2 = (dir.path() / "config.2").string();
+  ASSERT_TRUE(folly::writeFile(std::string("a"), target1.c_str()));
+  ASSERT_TRUE(folly::writeFile(std::string("b"), target2.c_str()));
+  ASSERT_EQ(0, symlink(target1.c_str(), link.c_str()));
+
+  Updates updates;
+  auto handle = startObservingFile(
+      link, std::chrono::milliseconds(0), updates.callback());
+  ASSERT_TRUE(handle);
+  EXPECT_TRUE(updates.waitFor("a"));
+
+  ASSERT_EQ(0, symlink(target2.c_str(), tmpLink.c_str()));
+  ASSERT_EQ(0, rename(tmpLink.c_str(), link.c_str()));
+  EXPECT_TRUE(updates.waitFor("b"));
+
+  // The new target is watched now.
+  ASSERT_TRUE(folly::writeFile(std::string("c"), target2.c_str()));
+  EXPECT_TRUE(updates.waitFor("c"));
+}
@@ -0,0 +1,109 @@
+/*
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <limits>
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/LatencyHistogram.h"
+
+using facebook::memcache::mcrouter::LatencyHistogram;
+using facebook::memcache::mcrouter::RecentLatencyHistogram;
+
+TEST(LatencyHistogram, empty) {
+  LatencyHistogram hist;
+  EXPECT_EQ(0, hist.count());
+  EXPECT_EQ(0, hist.percentile(0.5));
+}
+
+TEST(LatencyHistogram, bucketBounds) {
+  for (uint64_t us : {0, 1, 3, 4, 7, 8, 15, 100, 1000, 123456, 1000000}) {
+    auto lower = LatencyHistogram::bucketLowerBound(
+        LatencyHistogram::bucketIndex(us));
+    EXPECT_LE(lower, us);
+    EXPECT_GE(lower * 5 / 4 + 1, us);
+  }
+  EXPECT_EQ(
+      LatencyHistogram::kNumBuckets - 1,
+      LatencyHistogram::bucketIndex(std::numeric_limits<uint64_t>::max()));
+}
+
+TEST(LatencyHistogram, percentile) {
+  LatencyHistogram hist;
+  for (size_t i = 0; i < 90; ++i) {
+    hist.insertSample(1000);
+  }
+  for (size_t i = 0; i < 10; ++i) {
+    hist.insertSample(800000);
+  }
+  EXPECT_EQ(100, hist.count());
+
+  EXPECT_EQ(
+      LatencyHistogram::bucketLowerBound(LatencyHistogram::bucketIndex(1000)),
+      hist.percentile(0.5));
+  EXPECT_EQ(
+      LatencyHistogram::bucketLowerBound(LatencyHistogram::bucketIndex(1000)),
+      hist.percentile(0.9));
+  EXPECT_EQ(
+      LatencyHistogram::bucketLowerBound(
+          LatencyHistogram::bucketIndex(800000)),
+      hist.percentile(0.99));
+
+  hist.reset();
+  EXPECT_EQ(0, hist.count());
+  EXPECT_EQ(0, hist.percentile(0.9));
+}
+
+TEST(LatencyHistogram, decay) {
+  LatencyHistogram hist;
+  for (size_t i = 0; i < 100; ++i) {
+    hist.insertSample(1000);
+  }
+  hist.decay();
+  EXPECT_EQ(50, hist.count());
+
+  // New samples now outweigh the old ones.
+  for (size_t i = 0; i < 60; ++i) {
+    hist.insertSample(100000);
+  }
+  EXPECT_EQ(
+      LatencyHistogram::bucketLowerBound(
+          LatencyHistogram::bucketIndex(100000)),
+      hist.percentile(0.5));
+}
+
+TEST(LatencyHistogram, merge) {
+  LatencyHistogram fast;
+  LatencyHistogram slow;
+  for (size_t i = 0; i < 90; ++i) {
+    fast.insertSample(100);
+  }
+  for (size_t i = 0; i < 10; ++i) {
+    slow.insertSample(100000);
+  }
+
+  LatencyHistogram merged;
+  merged.merge(fast);
+  merged.merge(slow);
+  EXPECT_EQ(100, merged.count());
+  EXPECT_EQ(
+      LatencyHistogram::bucketLowerBound(LatencyHistogram::bucketIndex(100)),
+      merged.percentile(0.5));
+  EXPECT_EQ(
+      LatencyHistogram::bucketLowerBound(
+          LatencyHistogram::bucketIndex(100000)),
+      merged.percentile(0.99));
+}
+
+TEST(RecentLatencyHistogram, decaysPeriodically) {
+  const size_t decayPeriod = RecentLatencyHistogram::kDecayPeriod;
+  RecentLatencyHistogram hist;
+  for (size_t i = 0; i < decayPeriod; ++i) {
+    hist.insertSample(1000);
+  }
+  EXPECT_EQ(decayPeriod / 2, hist.histogram().count());
+}
@@ -5,7 +5,9 @@
  *  file in the root directory of this source tree.
  *
  */
+#include <algorithm>
 #include <string>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -15,6 +17,9 @@
 #include "mcrouter/CarbonRouterInstance.h"
 #include "mcrouter/PoolFactory.h"
 #include "mcrouter/Proxy.h"
+#include "mcrouter/ProxyConfig.h"
+#include "mcrouter/ProxyConfigBuilder.h"
+#include "mcrouter/lib/RouteHandleTraverser.h"
 #include "mcrouter/lib/config/RouteHandleFactory.h"
 #include "mcrouter/lib/network/gen/MemcacheRouterInfo.h"
 #include "mcrouter/options.h"
@@ -119,3 +124,114 @@ TEST(McRouteHandleProvider, pool_route) {
   EXPECT_EQ(1, asynclogRoutes.size());
   EXPECT_EQ("asynclog:mock", asynclogRoutes["mock"]->routeName());
 }
+
+TEST(McRouteHandleProvider, pool_route_reuse) {
+  const char* const kServersPoolRoute = R"({
+    "type": "PoolRoute",
+    "pool": { "name": "reuse", "servers": [ "localhost:12345" ] }
+  })";
+  const char* const kChangedPoolRoute = R"({
+    "type": "PoolRoute",
+    "pool": { "name": "reuse", "servers": [ "localhost:12346" ] }
+  })";
+
+  TestSetup setup;
+  auto rh = setup.getRoute(kServersPoolRoute);
+  auto previous = setup.provider().releasePoolRoutes();
+  ASSERT_EQ(1, previous.size());
+
+  TestSetup next;
+  next.provider().setPreviousPoolRoutes(&previous);
+  EXPECT_EQ(rh, next.getRoute(kServersPoolRoute));
+  EXPECT_EQ(1, next.provider().numReusedPoolRoutes());
+  EXPECT_EQ(1, next.provider().releasePools().size());
+  EXPECT_EQ(1, next.provider().releaseDestinations().size());
+  EXPECT_EQ(1, next.provider().releaseAsyncLogRoutes().size());
+  // Carried over again into the config after next.
+  EXPECT_EQ(1, next.provider().releasePoolRoutes().size());
+
+  TestSetup changed;
+  changed.provider().setPreviousPoolRoutes(&previous);
+  EXPECT_NE(rh, changed.getRoute(kChangedPoolRoute));
+  EXPECT_EQ(0, changed.provider().numReusedPoolRoutes());
+}
+
+TEST(McRouteHandleProvider, pool_route_not_reusable) {
+  // Servers that are routes may depend on other parts of the config.
+  TestSetup setup;
+  setup.getRoute(R"({
+    "type": "PoolRoute",
+    "pool": {
+      "name": "routes",
+      "servers": [ { "type": "NullRoute" }, { "type": "ErrorRoute" } ]
+    }
+  })");
+  EXPECT_TRUE(setup.provider().releasePoolRoutes().empty());
+}
+
+TEST(McRouteHandleProvider, single_shot_only) {
+  TestSetup setup;
+  setup.getRoute(kPoolRoute);
+  setup.getRoute(kConstShard);
+  EXPECT_TRUE(setup.provider().singleShotOnly());
+
+  TestSetup shadowed;
+  shadowed.getRoute(R"({
+    "type": "PoolRoute",
+    "pool": { "name": "mock", "servers": [ ] },
+    "shadows": [ ]
+  })");
+  EXPECT_FALSE(shadowed.provider().singleShotOnly());
+
+  TestSetup warmUp;
+  warmUp.getRoute(kWarmUp);
+  EXPECT_FALSE(warmUp.provider().singleShotOnly());
+}
+
+TEST(McRouteHandleProvider, lazy_routes) {
+  auto opts = defaultTestOptions();
+  opts.config = std::string("file:") + kMemcacheConfig;
+  opts.lazy_route_construction = true;
+  auto router = CarbonRouterInstance<McrouterRouterInfo>::init(
+      "test_lazy_routes", opts);
+  ASSERT_TRUE(router != nullptr);
+  auto& proxy = *router->getProxy(0);
+
+  ProxyConfigBuilder builder(router->opts(), router->configApi(), R"({
+    "routes": [
+      {
+        "aliases": ["/a/a/"],
+        "route": {"type": "PoolRoute", "pool": {"name": "A", "servers": []}}
+      },
+      {
+        "aliases": ["/b/b/"],
+        "route": {"type": "UnknownRoute"}
+      }
+    ]
+  })");
+  // The invalid route is not built yet.
+  auto config = builder.buildConfig(proxy);
+  EXPECT_TRUE(config->getPools().empty());
+  EXPECT_EQ(0, proxy.stats().getValue(route_subtrees_materialized_stat));
+
+  std::vector<std::string> names;
+  RouteHandleTraverser<McrouterRouteHandleIf> t(
+      [&names](const McrouterRouteHandleIf& rh) {
+        names.push_back(rh.routeName());
+      });
+  config->proxyRoute().traverse(McGetRequest("/a/a/key"), t);
+  EXPECT_EQ(1, config->getPools().size());
+  EXPECT_EQ(1, config->getPools().count("A"));
+  EXPECT_EQ(1, std::count(names.begin(), names.end(), "asynclog:A"));
+  EXPECT_EQ(1, proxy.stats().getValue(route_subtrees_materialized_stat));
+
+  // Built only once.
+  config->proxyRoute().traverse(McGetRequest("/a/a/key2"), t);
+  EXPECT_EQ(1, proxy.stats().getValue(route_subtrees_materialized_stat));
+
+  names.clear();
+  config->proxyRoute().traverse(McGetRequest("/b/b/key"), t);
+  EXPECT_EQ(
+      1, std::count(names.begin(), names.end(), "error|Failed to build route"));
+  EXPECT_EQ(2, proxy.stats().getValue(route_subtrees_materialized_stat));
+}
@@ -83,6 +83,26 @@ TEST(Observable, sanity) {
   }
 }
 
+TEST(Observable, snapshot) {
+  Observable<std::shared_ptr<const int>> data(std::make_shared<const int>(1));
+
+  std::weak_ptr<const int> first = data.snapshot();
+  EXPECT_EQ(1, *data.snapshot());
+
+  data.set(std::make_shared<const int>(2));
+  // Still referenced by this thread's snapshot.
+  EXPECT_FALSE(first.expired());
+  EXPECT_EQ(2, *data.snapshot());
+  EXPECT_TRUE(first.expired());
+
+  std::thread([&data]() {
+    EXPECT_EQ(2, *data.snapshot());
+    data.set(std::make_shared<const int>(3));
+    EXPECT_EQ(3, *data.snapshot());
+  }).join();
+  EXPECT_EQ(3, *data.snapshot());
+}
+
 TEST(Observable, rand) {
   Observable<int> data(1);
 
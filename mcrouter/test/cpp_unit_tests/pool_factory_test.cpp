@@ -6,6 +6,8 @@
  *
  */
 #include <stdexcept>
+#include <thread>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -116,3 +118,36 @@ TEST(PoolFactory, inherit_cache) {
   EXPECT_EQ(15, poolC.json["server_timeout"].getInt());
   EXPECT_EQ(api.getCalls(), 1);
 }
+
+TEST(PoolFactory, inherit_concurrent) {
+  MockConfigApi api(folly::StringKeyedUnorderedMap<std::string>{
+      {"api_pool", "{ \"servers\": [ \"localhost:1234\" ] }"}});
+  PoolFactory factory(
+      folly::parseJson(R"({
+    "pools": {
+      "A": {
+        "inherit": "api_pool",
+        "server_timeout": 5
+      },
+      "B": {
+        "inherit": "A",
+        "server_timeout": 10
+      }
+    }
+  })"),
+      api);
+  // Proxies' configs are built concurrently from the same factory.
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < 8; ++i) {
+    threads.emplace_back([&factory, i]() {
+      auto pool = factory.parsePool(i % 2 ? "A" : "B");
+      EXPECT_EQ(i % 2 ? 5 : 10, pool.json["server_timeout"].getInt());
+      EXPECT_EQ(1, pool.json["servers"].size());
+      EXPECT_EQ(nullptr, pool.json.get_ptr("inherit"));
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(api.getCalls(), 1);
+}
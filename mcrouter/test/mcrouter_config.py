@@ -14,6 +14,7 @@ class McrouterGlobals:
         bins = {
             'mcrouter': './mcrouter/mcrouter',
             'mcpiper': './mcrouter/tools/mcpiper/mcpiper',
+            'mcreplay': './mcrouter/tools/mcpiper/mcreplay',
             'mockmc': './mcrouter/lib/network/mock_mc_server',
             'prodmc': './mcrouter/lib/network/mock_mc_server',
         }
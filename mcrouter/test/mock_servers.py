@@ -167,3 +167,37 @@ class TkoServer(MockServer):
                         len(str(self.port)), str(self.port)))
             elif cmd.startswith('get'):
                 client_socket.send('END\r\n')
+
+class DelayServer(MockServer):
+    """Replies to 'get' with a miss and to 'version' with a version, both
+    after 'delay' seconds. The delay can be changed while running."""
+    def __init__(self, delay=0):
+        super(DelayServer, self).__init__()
+        self.delay = delay
+
+    def setDelay(self, delay):
+        self.delay = delay
+
+    def runServer(self, client_socket, client_address):
+        f = client_socket.makefile()
+        while not self.is_stopped():
+            cmd = f.readline()
+            if not cmd:
+                break
+            if self.delay:
+                time.sleep(self.delay)
+            if cmd == 'version\r\n':
+                client_socket.send('VERSION DELAY_SERVER\r\n')
+            elif cmd.startswith('get'):
+                client_socket.send('END\r\n')
+        f.close()
+
+class ReplyAndCloseServer(MockServer):
+    """Replies to a single 'get' with a hit, then closes the connection, so
+    that every request needs a new connection."""
+    def runServer(self, client_socket, client_address):
+        f = client_socket.makefile()
+        cmd = f.readline()
+        if cmd.startswith('get'):
+            client_socket.send('VALUE key 0 5\r\nvalue\r\nEND\r\n')
+        f.close()
@@ -0,0 +1,52 @@
+# Copyright (c) 2018-present, Facebook, Inc.
+#
+# This source code is licensed under the MIT license found in the LICENSE
+# file in the root directory of this source tree.
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import time
+
+from mcrouter.test.McrouterTestCase import McrouterTestCase
+from mcrouter.test.mock_servers import ReplyAndCloseServer
+
+
+class TestConnectThrottle(McrouterTestCase):
+    config = './mcrouter/test/mcrouter_test_basic_1_1_1.json'
+    # The server closing connections must not make the host TKO, and
+    # requests must not time out while waiting for a connection.
+    extra_args = ['--disable-tko-tracking',
+                  '--server-timeout', '10000']
+    num_gets = 14
+
+    def setUp(self):
+        self.add_server(ReplyAndCloseServer())
+
+    def time_gets(self, mcrouter):
+        start = time.time()
+        for _ in range(self.num_gets):
+            self.assertEqual('value', mcrouter.get('key'))
+            # Let mcrouter see the connection closed before the next get.
+            time.sleep(0.05)
+        return time.time() - start
+
+    def test_unthrottled(self):
+        mcrouter = self.add_mcrouter(self.config, extra_args=self.extra_args)
+        self.assertLess(self.time_gets(mcrouter), 4)
+
+    def test_reconnects_are_throttled(self):
+        mcrouter = self.add_mcrouter(
+            self.config,
+            extra_args=self.extra_args +
+            ['--max-new-connections-per-second', '2'])
+        # Every get reconnects. After a burst of 2 that's one get every 0.5s,
+        # about 6s in total; it would be twice that if a connection took two
+        # tokens.
+        elapsed = self.time_gets(mcrouter)
+        self.assertGreater(elapsed, 5)
+        self.assertLess(elapsed, 10)
+        stats = mcrouter.stats('detailed')
+        self.assertGreater(float(stats['connects_throttled']), 0)
@@ -0,0 +1,58 @@
+# Copyright (c) 2018-present, Facebook, Inc.
+#
+# This source code is licensed under the MIT license found in the LICENSE
+# file in the root directory of this source tree.
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import time
+
+from mcrouter.test.McrouterTestCase import McrouterTestCase
+from mcrouter.test.mock_servers import DelayServer
+
+
+class TestErrorRateTko(McrouterTestCase):
+    config = './mcrouter/test/test_error_rate_tko.json'
+    # Timeouts only count towards the error rate, and probes are too far
+    # apart to unmark the host: only half-open samples can.
+    extra_args = ['--server-timeout', '50',
+                  '--timeouts-until-tko', '1000',
+                  '--probe-timeout-initial', '60000',
+                  '--probe-timeout-max', '60000']
+
+    def setUp(self):
+        self.server = self.add_server(DelayServer(0.2))
+        self.mcrouter = self.add_mcrouter(
+            self.config, extra_args=self.extra_args)
+
+    def num_error_rate_tko(self):
+        return int(self.mcrouter.stats()['num_error_rate_tko_servers'])
+
+    def wait_for_error_rate_tko(self, expected, timeout=10):
+        deadline = time.time() + timeout
+        while time.time() < deadline:
+            self.mcrouter.get('key')
+            if self.num_error_rate_tko() == expected:
+                return True
+        return False
+
+    def test_breaker_trips(self):
+        self.assertTrue(self.wait_for_error_rate_tko(1))
+        servers = self.mcrouter.stats('servers')
+        self.assertTrue(any('error_rate_tko' in v for v in servers.values()))
+
+    def test_half_open_sample_unmarks_tko(self):
+        self.assertTrue(self.wait_for_error_rate_tko(1))
+
+        # Every request is a sample candidate, but they keep timing out.
+        for _ in range(5):
+            self.mcrouter.get('key')
+        self.assertEqual(1, self.num_error_rate_tko())
+
+        # The failed samples were released, so the next one goes out and
+        # its success closes the breaker.
+        self.server.setDelay(0)
+        self.assertTrue(self.wait_for_error_rate_tko(0))
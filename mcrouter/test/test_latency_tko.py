@@ -0,0 +1,87 @@
+# Copyright (c) 2018-present, Facebook, Inc.
+#
+# This source code is licensed under the MIT license found in the LICENSE
+# file in the root directory of this source tree.
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import time
+
+from mcrouter.test.McrouterTestCase import McrouterTestCase
+from mcrouter.test.mock_servers import DelayServer
+
+
+class TestLatencyTko(McrouterTestCase):
+    config = './mcrouter/test/test_latency_tko.json'
+    # Every get goes to all 5 hosts, so each of them gets a sample per get.
+    extra_args = ['--latency-tko-interval-ms', '500',
+                  '--latency-tko-min-samples', '3',
+                  '--latency-tko-min-latency-us', '20000',
+                  '--probe-timeout-initial', '100',
+                  '--probe-timeout-max', '100']
+    slow_delay = 0.1
+
+    def setUp(self):
+        self.servers = []
+
+    def add_servers(self, num_slow):
+        for i in range(5):
+            server = DelayServer(self.slow_delay if i < num_slow else 0)
+            self.servers.append(self.add_server(server))
+
+    def num_latency_tko(self, mcrouter):
+        return int(mcrouter.stats()['num_latency_tko_servers'])
+
+    def wait_for_latency_tko(self, mcrouter, expected, timeout=10):
+        deadline = time.time() + timeout
+        while time.time() < deadline:
+            mcrouter.get('key')
+            if self.num_latency_tko(mcrouter) == expected:
+                return True
+        return False
+
+    def test_slow_host_is_ejected(self):
+        self.add_servers(num_slow=1)
+        # 10% of a pool of 5 rounds up to one host.
+        mcrouter = self.add_mcrouter(
+            self.config,
+            extra_args=self.extra_args + ['--latency-tko-max-fraction', '0.1'])
+        self.assertTrue(self.wait_for_latency_tko(mcrouter, 1))
+        servers = mcrouter.stats('servers')
+        self.assertTrue(any('latency_tko' in v for v in servers.values()))
+
+    def test_max_fraction(self):
+        self.add_servers(num_slow=2)
+        mcrouter = self.add_mcrouter(
+            self.config,
+            extra_args=self.extra_args + ['--latency-tko-max-fraction', '0.2'])
+        self.assertTrue(self.wait_for_latency_tko(mcrouter, 1))
+        # Both hosts are outliers, but only one may be ejected at a time.
+        for _ in range(20):
+            mcrouter.get('key')
+        time.sleep(1)
+        for _ in range(20):
+            mcrouter.get('key')
+        self.assertEqual(1, self.num_latency_tko(mcrouter))
+
+    def test_probe_must_be_fast(self):
+        self.add_servers(num_slow=1)
+        mcrouter = self.add_mcrouter(
+            self.config,
+            extra_args=self.extra_args + ['--latency-tko-max-fraction', '0.2'])
+        self.assertTrue(self.wait_for_latency_tko(mcrouter, 1))
+
+        # Probes get replies, but as slow as the ones that got the host
+        # ejected, so it stays TKO.
+        time.sleep(1)
+        self.assertEqual(1, self.num_latency_tko(mcrouter))
+
+        self.servers[0].setDelay(0)
+        deadline = time.time() + 5
+        while (self.num_latency_tko(mcrouter) != 0 and
+               time.time() < deadline):
+            time.sleep(0.1)
+        self.assertEqual(0, self.num_latency_tko(mcrouter))
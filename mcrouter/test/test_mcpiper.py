@@ -8,10 +8,14 @@ from __future__ import division
 from __future__ import print_function
 from __future__ import unicode_literals
 
+import os
+import signal
+import subprocess
 import time
 
 from mcrouter.test.MCProcess import BaseDirectory, Memcached, Mcpiper
 from mcrouter.test.McrouterTestCase import McrouterTestCase
+from mcrouter.test.config import McrouterGlobals
 
 class TestMcpiper(McrouterTestCase):
     mcrouter_ascii_config = './mcrouter/test/mcrouter_test_basic_1_1_1.json'
@@ -156,3 +160,54 @@ class TestMcpiper(McrouterTestCase):
 
     def test_delete_caret_raw(self):
         self.do_delete_test(self.mcrouter_caret, True, '^')
+
+    def test_aggregate_caret(self):
+        mcpiper = Mcpiper(self.mcrouter_caret.debug_fifo_root,
+                          ['--aggregate', '--aggregate-interval-ms', '200'])
+
+        # Make sure mcrouter creates fifos and start replicating data to them.
+        self.mcrouter_caret.set('abc', '123')
+        time.sleep(3)
+
+        for _ in range(10):
+            self.assertTrue(self.mcrouter_caret.set('hot_key', 'value'))
+            self.assertEquals('value', self.mcrouter_caret.get('hot_key'))
+
+        # wait for a summary that covers the data
+        time.sleep(2)
+
+        self.assertTrue(mcpiper.contains('requests/s'))
+        self.assertTrue(mcpiper.contains('hot_key'))
+        self.assertTrue(mcpiper.contains('get'))
+        self.assertTrue(mcpiper.contains('p99 us'))
+
+    def test_capture_and_replay(self):
+        capture = os.path.join(BaseDirectory('mcpiper_capture').path,
+                               'capture')
+        mcpiper = Mcpiper(self.mcrouter_caret.debug_fifo_root,
+                          ['--capture', capture,
+                           '--filename-pattern', 'server'])
+
+        # Make sure mcrouter creates fifos and start replicating data to them.
+        self.mcrouter_caret.set('abc', '123')
+        time.sleep(3)
+
+        self.assertTrue(self.mcrouter_caret.set('replay_key', 'value1'))
+        self.assertEquals('value1', self.mcrouter_caret.get('replay_key'))
+
+        # wait for data to arrive in mcpiper, then flush the capture
+        time.sleep(2)
+        mcpiper.getprocess().send_signal(signal.SIGINT)
+        mcpiper.getprocess().wait()
+
+        self.assertTrue(self.memcached.delete('replay_key'))
+        output = subprocess.check_output(
+            [McrouterGlobals.binPath('mcreplay'),
+             '--port', str(self.memcached.getport()),
+             '--protocol', 'ascii',
+             '--speed', '10',
+             capture]).decode('ascii', errors='ignore')
+
+        self.assertIn('replayed at 10x', output)
+        self.assertIn('errors: 0', output)
+        self.assertEquals('value1', self.memcached.get('replay_key'))
@@ -869,6 +869,26 @@ class TestMcrouterBasicL1L2SizeSplit(McrouterTestCase):
         self.assertFalse(mcr.get("key"))
 
 
+class TestMcrouterBasicL1L2SizeSplitSpeculative(TestMcrouterBasicL1L2SizeSplit):
+    config = './mcrouter/test/test_basic_l1_l2_sizesplit_speculative.json'
+
+    def test_l1_l2_sizesplit_speculative_overwrite(self):
+        """
+        A split key overwritten with a small value directly in L1 must not be
+        served from L2, even though the speculative L2 get finds it there.
+        """
+        mcr = self.get_mcrouter(self.config)
+
+        value = "foo" * 200
+        mcr.set("key", value)
+        self.assertEqual(mcr.get("key"), value)
+
+        self.l1.set("key", "small")
+        self.assertEqual(self.l2.get("key"), value)
+        self.assertEqual(mcr.get("key"), "small")
+        self.assertEqual(mcr.get("key"), "small")
+
+
 class TestMcrouterPortOverride(McrouterTestCase):
     config = './mcrouter/test/mcrouter_test_portoverride.json'
 
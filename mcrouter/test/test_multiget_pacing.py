@@ -0,0 +1,50 @@
+# Copyright (c) 2018-present, Facebook, Inc.
+#
+# This source code is licensed under the MIT license found in the LICENSE
+# file in the root directory of this source tree.
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+from mcrouter.test.MCProcess import MockMemcached
+from mcrouter.test.McrouterTestCase import McrouterTestCase
+
+
+class TestMultigetPacing(McrouterTestCase):
+    config = './mcrouter/test/mcrouter_test_basic_1_1_1.json'
+    extra_args = ['--multiget-max-inflight-keys', '2',
+                  '--multiget-min-inflight-keys', '2']
+
+    def setUp(self):
+        self.add_server(MockMemcached(), logical_port=12345)
+        self.mcrouter = self.add_mcrouter(self.config, None, self.extra_args)
+
+    def deferred(self):
+        return int(self.mcrouter.stats()['multiget_keys_deferred'])
+
+    def test_wide_multiget(self):
+        keys = ['test:pacing:{}'.format(i) for i in range(20)]
+        for i, key in enumerate(keys[:15]):
+            self.assertTrue(self.mcrouter.set(key, str(i)))
+
+        expected = {key: str(i) for i, key in enumerate(keys[:15])}
+        expected.update({key: None for key in keys[15:]})
+        self.assertEqual(self.mcrouter.get(keys), expected)
+        # At most 2 keys are routed at a time, the others waited for
+        # replies to earlier keys.
+        deferred = self.deferred()
+        self.assertGreater(deferred, 0)
+        self.assertLessEqual(deferred, 18)
+
+        # Pacing state of the first multiget doesn't affect the next one.
+        self.assertEqual(self.mcrouter.get(keys), expected)
+        self.assertGreater(self.deferred(), deferred)
+
+    def test_narrow_multiget(self):
+        self.assertTrue(self.mcrouter.set('test:pacing:a', 'A'))
+        self.assertEqual(
+            self.mcrouter.get(['test:pacing:a', 'test:pacing:b']),
+            {'test:pacing:a': 'A', 'test:pacing:b': None})
+        self.assertEqual(self.deferred(), 0)
@@ -0,0 +1,57 @@
+# Copyright (c) 2018-present, Facebook, Inc.
+#
+# This source code is licensed under the MIT license found in the LICENSE
+# file in the root directory of this source tree.
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import time
+
+from mcrouter.test.McrouterTestCase import McrouterTestCase
+from mcrouter.test.mock_servers import SleepServer
+
+
+class TestProbeScheduler(McrouterTestCase):
+    # Every get goes to all 5 hosts.
+    config = './mcrouter/test/test_latency_tko.json'
+    extra_args = ['--timeouts-until-tko', '1',
+                  '--server-timeout', '100',
+                  '--probe-timeout-initial', '100',
+                  '--probe-timeout-max', '100',
+                  '--probe-scheduler-tick-ms', '10']
+
+    def setUp(self):
+        for _ in range(5):
+            self.add_server(SleepServer())
+
+    def make_all_tko(self, extra_args=None):
+        mcrouter = self.add_mcrouter(
+            self.config, extra_args=self.extra_args + (extra_args or []))
+        self.assertIsNone(mcrouter.get('key'))
+        return mcrouter
+
+    def probe_rates(self, mcrouter):
+        stats = mcrouter.stats('detailed')
+        return float(stats['probes_sent']), float(stats['probes_deferred'])
+
+    def test_probes_are_sent(self):
+        mcrouter = self.make_all_tko()
+        time.sleep(3)
+        sent, deferred = self.probe_rates(mcrouter)
+        # Each host is probed every 100-150ms once the previous probe timed
+        # out, which is several probes a second per host.
+        self.assertGreater(sent, 5)
+        self.assertEqual(0, deferred)
+
+    def test_probe_budget(self):
+        mcrouter = self.make_all_tko(['--max-probes-per-second', '2'])
+        time.sleep(3)
+        sent, deferred = self.probe_rates(mcrouter)
+        # The budget starts full, so a burst of 2 comes on top of the rate.
+        self.assertLessEqual(sent, 3)
+        self.assertGreater(sent, 0)
+        # Probes over the budget wait for the next tick instead.
+        self.assertGreater(deferred, 0)
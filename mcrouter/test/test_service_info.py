@@ -49,3 +49,22 @@ class TestServiceInfo(McrouterTestCase):
         self._check_route_handles("get")
         self._check_route_handles("set")
         self._check_route_handles("delete")
+
+
+class TestServiceInfoActiveProxies(McrouterTestCase):
+    config = './mcrouter/test/test_service_info.json'
+
+    def setUp(self):
+        self.add_server(Memcached())
+        self.add_server(Memcached())
+        self.mcrouter = self.add_mcrouter(
+            self.config, extra_args=['--num-proxies', '4'])
+
+    def test_active_proxies(self):
+        self.assertEqual(
+            "4", self.mcrouter.get("__mcrouter__.active_proxies"))
+        self.assertEqual(
+            "4 -> 2", self.mcrouter.get("__mcrouter__.active_proxies(2)"))
+        # Clamped to num-proxies.
+        self.assertEqual(
+            "2 -> 4", self.mcrouter.get("__mcrouter__.active_proxies(10)"))
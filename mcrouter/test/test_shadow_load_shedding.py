@@ -0,0 +1,64 @@
+# Copyright (c) 2018-present, Facebook, Inc.
+#
+# This source code is licensed under the MIT license found in the LICENSE
+# file in the root directory of this source tree.
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import time
+
+from mcrouter.test.MCProcess import Memcached
+from mcrouter.test.McrouterTestCase import McrouterTestCase
+
+
+class TestShadowLoadShedding(McrouterTestCase):
+    config = './mcrouter/test/test_max_shadow_requests.json'
+    extra_args = []
+
+    def setUp(self):
+        # The order here must corresponds to the order of hosts in the .json
+        self.mc = self.add_server(Memcached())
+        self.mc_shadow = self.add_server(Memcached())
+
+    def set_keys(self, mcrouter, n):
+        for i in range(n):
+            self.assertTrue(mcrouter.set('key' + str(i), 'value'))
+        # Shadow requests complete asynchronously.
+        time.sleep(0.5)
+
+    def shadowed_keys(self, n):
+        return [i for i in range(n)
+                if self.mc_shadow.get('key' + str(i)) == 'value']
+
+    def test_disabled_by_default(self):
+        # One fiber in use is already full pressure, but shedding is off.
+        mcrouter = self.add_mcrouter(
+            self.config,
+            extra_args=self.extra_args + ['--shadow-shed-fibers', '1'])
+        self.set_keys(mcrouter, 10)
+        self.assertEqual(list(range(10)), self.shadowed_keys(10))
+        self.assertEqual('0', mcrouter.stats()['shadow_requests_shed'])
+
+    def test_shed_under_pressure(self):
+        # Every request runs on a fiber, so the fiber utilization is at
+        # least 1 and all shadow requests are dropped.
+        mcrouter = self.add_mcrouter(
+            self.config,
+            extra_args=self.extra_args + ['--shadow-load-shedding',
+                                          '--shadow-shed-fibers', '1'])
+        self.set_keys(mcrouter, 10)
+        self.assertEqual([], self.shadowed_keys(10))
+        self.assertEqual('10', mcrouter.stats()['shadow_requests_shed'])
+        for i in range(10):
+            self.assertEqual('value', self.mc.get('key' + str(i)))
+
+    def test_no_shedding_without_pressure(self):
+        mcrouter = self.add_mcrouter(
+            self.config,
+            extra_args=self.extra_args + ['--shadow-load-shedding'])
+        self.set_keys(mcrouter, 10)
+        self.assertEqual(list(range(10)), self.shadowed_keys(10))
+        self.assertEqual('0', mcrouter.stats()['shadow_requests_shed'])
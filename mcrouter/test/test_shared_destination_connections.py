@@ -0,0 +1,57 @@
+# Copyright (c) 2018-present, Facebook, Inc.
+#
+# This source code is licensed under the MIT license found in the LICENSE
+# file in the root directory of this source tree.
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import time
+
+from mcrouter.test.MCProcess import McrouterClients
+from mcrouter.test.McrouterTestCase import McrouterTestCase
+from mcrouter.test.mock_servers import SleepServer
+
+
+class TestSharedDestinationConnections(McrouterTestCase):
+    config = './mcrouter/test/test_shared_destination_connections.json'
+    extra_args = ['--num-proxies', '4', '--shared-destination-connections']
+
+    def setUp(self):
+        self.mc = self.add_server(self.make_memcached())
+
+    def test_shared_connections(self):
+        mcrouter = self.add_mcrouter(self.config, extra_args=self.extra_args)
+        # Client connections are spread over all proxies.
+        clients = McrouterClients(mcrouter.port, 8)
+        for i in range(8):
+            key = 'key{}'.format(i)
+            self.assertTrue(clients[i].set(key, 'value{}'.format(i)))
+            self.assertEqual('value{}'.format(i), clients[i].get(key))
+
+        # Only the owner proxy connected to the destination.
+        stats = mcrouter.stats()
+        self.assertEqual('4', stats['num_servers'])
+        self.assertEqual('1', stats['num_servers_up'])
+
+
+class TestSharedDestinationConnectionsDeadline(McrouterTestCase):
+    config = './mcrouter/test/test_shared_destination_connections.json'
+    extra_args = ['--num-proxies', '4', '--shared-destination-connections',
+                  '--server-timeout', '5000',
+                  '--request-deadline-ms', '500']
+
+    def setUp(self):
+        self.mc = self.add_server(SleepServer())
+
+    def test_deadline(self):
+        mcrouter = self.add_mcrouter(self.config, extra_args=self.extra_args)
+        clients = McrouterClients(mcrouter.port, 8)
+        # Requests forwarded to the owner proxy still time out at the
+        # request deadline, not the server timeout.
+        for i in range(8):
+            start = time.time()
+            self.assertIsNone(clients[i].get('key'))
+            self.assertLess(time.time() - start, 2)
@@ -0,0 +1,87 @@
+# Copyright (c) 2018-present, Facebook, Inc.
+#
+# This source code is licensed under the MIT license found in the LICENSE
+# file in the root directory of this source tree.
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import time
+
+from mcrouter.test.McrouterTestCase import McrouterTestCase
+from mcrouter.test.mock_servers import DelayServer
+
+
+class TestTkoCanary(McrouterTestCase):
+    config = './mcrouter/test/mcrouter_test_basic_1_1_1.json'
+    # One timeout marks the host soft TKO, and probes are too far apart to
+    # unmark it: only canaries can.
+    extra_args = ['--server-timeout', '50',
+                  '--timeouts-until-tko', '1',
+                  '--probe-timeout-initial', '60000',
+                  '--probe-timeout-max', '60000']
+
+    def setUp(self):
+        self.server = self.add_server(DelayServer(0.2))
+
+    def is_tko(self, mcrouter):
+        servers = mcrouter.stats('servers')
+        return any('soft_tko' in v for v in servers.values())
+
+    def start(self, canary_args):
+        mcrouter = self.add_mcrouter(
+            self.config, extra_args=self.extra_args + canary_args)
+        mcrouter.get('key')
+        self.assertTrue(self.is_tko(mcrouter))
+        # Let the server catch up with the timed out request.
+        self.server.setDelay(0)
+        time.sleep(0.5)
+        return mcrouter
+
+    def test_canaries_unmark_tko(self):
+        mcrouter = self.start(['--tko-canary-ratio', '1',
+                               '--tko-canary-interval-ms', '0',
+                               '--tko-canary-successes', '3'])
+        for _ in range(2):
+            mcrouter.get('key')
+        self.assertTrue(self.is_tko(mcrouter))
+        mcrouter.get('key')
+        self.assertFalse(self.is_tko(mcrouter))
+
+    def test_one_canary_success(self):
+        mcrouter = self.start(['--tko-canary-ratio', '1',
+                               '--tko-canary-interval-ms', '0',
+                               '--tko-canary-successes', '1'])
+        mcrouter.get('key')
+        self.assertFalse(self.is_tko(mcrouter))
+
+    def test_canary_interval(self):
+        mcrouter = self.start(['--tko-canary-ratio', '1',
+                               '--tko-canary-interval-ms', '60000',
+                               '--tko-canary-successes', '2'])
+        # Only the first request is a canary, the rest fail fast.
+        for _ in range(10):
+            mcrouter.get('key')
+        self.assertTrue(self.is_tko(mcrouter))
+
+    def test_canary_failure_restarts_count(self):
+        mcrouter = self.start(['--tko-canary-ratio', '1',
+                               '--tko-canary-interval-ms', '0',
+                               '--tko-canary-successes', '2'])
+        mcrouter.get('key')
+        self.server.setDelay(0.2)
+        mcrouter.get('key')
+        self.server.setDelay(0)
+        time.sleep(0.5)
+        mcrouter.get('key')
+        self.assertTrue(self.is_tko(mcrouter))
+        mcrouter.get('key')
+        self.assertFalse(self.is_tko(mcrouter))
+
+    def test_no_canaries(self):
+        mcrouter = self.start([])
+        for _ in range(10):
+            mcrouter.get('key')
+        self.assertTrue(self.is_tko(mcrouter))
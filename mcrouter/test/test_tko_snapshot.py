@@ -0,0 +1,103 @@
+# Copyright (c) 2018-present, Facebook, Inc.
+#
+# This source code is licensed under the MIT license found in the LICENSE
+# file in the root directory of this source tree.
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import glob
+import json
+import os
+import time
+
+from mcrouter.test.MCProcess import Mcrouter
+from mcrouter.test.McrouterTestCase import McrouterTestCase
+from mcrouter.test.mock_servers import SleepServer
+
+
+class TestTkoSnapshot(McrouterTestCase):
+    config = './mcrouter/test/mcrouter_test_basic_1_1_1.json'
+    # One timeout marks the host soft TKO, and probes are too far apart to
+    # unmark it during the test.
+    extra_args = ['--timeouts-until-tko', '1',
+                  '--server-timeout', '100',
+                  '--probe-timeout-initial', '60000',
+                  '--probe-timeout-max', '60000',
+                  '--tko-snapshot-interval-ms', '100']
+
+    def setUp(self):
+        self.add_server(SleepServer())
+
+    def snapshot_path(self, mcrouter):
+        paths = glob.glob(os.path.join(mcrouter.stats_dir, '*.tko_state'))
+        return paths[0] if paths else None
+
+    def read_snapshot(self, mcrouter):
+        path = self.snapshot_path(mcrouter)
+        if path is None:
+            return None
+        with open(path) as f:
+            return json.load(f)
+
+    def wait_for_snapshot(self, mcrouter, num_tkos, timeout=10):
+        deadline = time.time() + timeout
+        while time.time() < deadline:
+            snapshot = self.read_snapshot(mcrouter)
+            if snapshot is not None and len(snapshot['tkos']) == num_tkos:
+                return snapshot
+            time.sleep(0.1)
+        return None
+
+    def restart(self, mcrouter):
+        """Starts a new mcrouter reading the stats dir of `mcrouter`."""
+        mcrouter.terminate()
+        restarted = Mcrouter(self.config,
+                             extra_args=self.extra_args,
+                             base_dir=mcrouter.base_dir,
+                             substitute_config_ports=self.get_open_ports())
+        restarted.ensure_connected()
+        self.open_mcrouters.append(restarted)
+        return restarted
+
+    def is_soft_tko(self, mcrouter):
+        servers = mcrouter.stats('servers')
+        return any('soft_tko' in v for v in servers.values())
+
+    def test_tko_is_saved(self):
+        mcrouter = self.add_mcrouter(self.config, extra_args=self.extra_args)
+        self.assertIsNone(mcrouter.get('key'))
+        self.assertTrue(self.is_soft_tko(mcrouter))
+
+        snapshot = self.wait_for_snapshot(mcrouter, 1)
+        self.assertIsNotNone(snapshot)
+        self.assertEqual(['soft'], list(snapshot['tkos'].values()))
+
+    def test_tko_is_restored(self):
+        mcrouter = self.add_mcrouter(self.config, extra_args=self.extra_args)
+        mcrouter.get('key')
+        self.assertIsNotNone(self.wait_for_snapshot(mcrouter, 1))
+
+        # The host starts out TKO: no request needs to time out first.
+        restarted = self.restart(mcrouter)
+        self.assertTrue(self.is_soft_tko(restarted))
+        start = time.time()
+        self.assertIsNone(restarted.get('key'))
+        self.assertLess(time.time() - start, 0.1)
+
+    def test_old_snapshot_is_ignored(self):
+        mcrouter = self.add_mcrouter(self.config, extra_args=self.extra_args)
+        mcrouter.get('key')
+        snapshot = self.wait_for_snapshot(mcrouter, 1)
+        self.assertIsNotNone(snapshot)
+        path = self.snapshot_path(mcrouter)
+        mcrouter.terminate()
+
+        # Older than the default tko-snapshot-max-age-s of 5 minutes.
+        snapshot['time'] -= 3600
+        with open(path, 'w') as f:
+            json.dump(snapshot, f)
+        restarted = self.restart(mcrouter)
+        self.assertFalse(self.is_soft_tko(restarted))
@@ -0,0 +1,53 @@
+# Copyright (c) 2018-present, Facebook, Inc.
+#
+# This source code is licensed under the MIT license found in the LICENSE
+# file in the root directory of this source tree.
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import time
+
+from mcrouter.test.MCProcess import replace_ports
+from mcrouter.test.McrouterTestCase import McrouterTestCase
+from mcrouter.test.mock_servers import DelayServer
+
+
+class TestWarmStart(McrouterTestCase):
+    config = './mcrouter/test/mcrouter_test_basic_1_1_1.json'
+    config_two_servers = './mcrouter/test/test_warm_start.json'
+    extra_args = ['--warm-start-connect-fraction', '1',
+                  '--warm-start-timeout-ms', '20000']
+
+    def setUp(self):
+        self.add_server(DelayServer())
+        down = self.add_server(DelayServer())
+        # Nothing listens on its port anymore, so connecting to it fails.
+        down.terminate()
+        self.mcrouter = self.add_mcrouter(
+            self.config, extra_args=self.extra_args)
+
+    def last_config_success(self):
+        return self.mcrouter.stats('detailed')['config_last_success']
+
+    def test_failed_destination_is_not_waited_for(self):
+        last_success = self.last_config_success()
+        # config_last_success is in seconds.
+        time.sleep(1.1)
+
+        with open(self.config_two_servers, 'r') as config_file:
+            config = replace_ports(
+                config_file.read(), self.get_open_ports()[:2])
+        start = time.time()
+        with open(self.mcrouter.config, 'w') as config_file:
+            config_file.write(config)
+        while (self.last_config_success() == last_success and
+               time.time() - start < 30):
+            time.sleep(0.1)
+
+        # The destination that failed to connect settles the warm-up, so the
+        # config is swapped in without running into warm-start-timeout-ms.
+        self.assertNotEqual(last_success, self.last_config_success())
+        self.assertLess(time.time() - start, 10)
@@ -0,0 +1,133 @@
+/*
+ *  Copyright (c) 2016-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include "Distributions.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include <folly/Conv.h>
+#include <folly/String.h>
+
+namespace facebook {
+namespace memcache {
+namespace mcload {
+
+namespace {
+
+double zeta(uint64_t n, double theta) {
+  double sum = 0;
+  for (uint64_t i = 1; i <= n; ++i) {
+    sum += 1.0 / std::pow(i, theta);
+  }
+  return sum;
+}
+
+template <class T, class ParseValue>
+WeightedChoice<T> parseWeighted(folly::StringPiece spec, ParseValue parse) {
+  std::vector<folly::StringPiece> items;
+  folly::split(',', spec, items, true /* ignoreEmpty */);
+  if (items.empty()) {
+    throw std::invalid_argument("Empty distribution");
+  }
+
+  std::vector<T> values;
+  std::vector<double> weights;
+  for (auto item : items) {
+    folly::StringPiece value;
+    folly::StringPiece weight;
+    if (folly::split(':', item, value, weight)) {
+      weights.push_back(folly::to<double>(weight));
+    } else {
+      value = item;
+      weights.push_back(1);
+    }
+    values.push_back(parse(value));
+  }
+  return WeightedChoice<T>(std::move(values), weights);
+}
+
+} // anonymous
+
+ZipfianGenerator::ZipfianGenerator(uint64_t numKeys, double theta)
+    : numKeys_(numKeys), theta_(theta) {
+  if (numKeys_ == 0) {
+    throw std::invalid_argument("Number of keys must be positive");
+  }
+  if (theta_ < 0 || theta_ >= 1) {
+    throw std::invalid_argument("Zipf theta must be in [0, 1)");
+  }
+  if (theta_ == 0) {
+    return;
+  }
+  zetaN_ = zeta(numKeys_, theta_);
+  alpha_ = 1 / (1 - theta_);
+  eta_ = (1 - std::pow(2.0 / numKeys_, 1 - theta_)) /
+      (1 - zeta(2, theta_) / zetaN_);
+}
+
+uint64_t ZipfianGenerator::sample(double u) const {
+  if (theta_ == 0) {
+    return std::min<uint64_t>(u * numKeys_, numKeys_ - 1);
+  }
+  const double uz = u * zetaN_;
+  if (uz < 1) {
+    return 0;
+  }
+  if (uz < 1 + std::pow(0.5, theta_)) {
+    return std::min<uint64_t>(1, numKeys_ - 1);
+  }
+  const auto idx = static_cast<uint64_t>(
+      numKeys_ * std::pow(eta_ * u - eta_ + 1, alpha_));
+  return std::min(idx, numKeys_ - 1);
+}
+
+template <class T>
+WeightedChoice<T>::WeightedChoice(
+    std::vector<T> values,
+    const std::vector<double>& weights)
+    : values_(std::move(values)) {
+  if (values_.empty() || values_.size() != weights.size()) {
+    throw std::invalid_argument("Invalid weighted choice");
+  }
+  double total = 0;
+  for (auto weight : weights) {
+    if (weight < 0) {
+      throw std::invalid_argument("Weights must not be negative");
+    }
+    total += weight;
+    cumulative_.push_back(total);
+  }
+  if (total <= 0) {
+    throw std::invalid_argument("Weights must not all be zero");
+  }
+}
+
+template class WeightedChoice<uint32_t>;
+template class WeightedChoice<std::string>;
+
+WeightedChoice<uint32_t> parseSizeDistribution(folly::StringPiece spec) {
+  return parseWeighted<uint32_t>(spec, [](folly::StringPiece value) {
+    return folly::to<uint32_t>(value);
+  });
+}
+
+WeightedChoice<std::string> parseOperationMix(folly::StringPiece spec) {
+  return parseWeighted<std::string>(spec, [](folly::StringPiece value) {
+    if (value != "get" && value != "set" && value != "multiget" &&
+        value != "lease") {
+      throw std::invalid_argument(
+          folly::to<std::string>("Unknown operation: ", value));
+    }
+    return value.str();
+  });
+}
+
+} // mcload
+} // memcache
+} // facebook
@@ -0,0 +1,93 @@
+/*
+ *  Copyright (c) 2016-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <folly/Range.h>
+
+namespace facebook {
+namespace memcache {
+namespace mcload {
+
+/**
+ * Draws key indices in [0, numKeys) with Zipfian popularity: index i is
+ * requested with probability proportional to 1 / (i + 1)^theta.
+ * theta == 0 means uniform. Uses the algorithm from "Quickly Generating
+ * Billion-Record Synthetic Databases" (Gray et al.), which needs O(numKeys)
+ * precomputation and O(1) per sample.
+ */
+class ZipfianGenerator {
+ public:
+  /**
+   * @throw std::invalid_argument  if numKeys is 0 or theta is not in [0, 1).
+   */
+  ZipfianGenerator(uint64_t numKeys, double theta);
+
+  template <class Rng>
+  uint64_t operator()(Rng& rng) const {
+    const double u = std::uniform_real_distribution<double>(0, 1)(rng);
+    return sample(u);
+  }
+
+  /**
+   * Maps a uniform sample u in [0, 1) to a key index.
+   */
+  uint64_t sample(double u) const;
+
+ private:
+  uint64_t numKeys_;
+  double theta_;
+  double zetaN_{0};
+  double alpha_{0};
+  double eta_{0};
+};
+
+/**
+ * Picks one of a fixed set of values with the given weights.
+ * Parsed from "value:weight,value:weight,...", e.g. "100:0.7,4096:0.3".
+ * A single value without weight ("100") is also accepted.
+ */
+template <class T>
+class WeightedChoice {
+ public:
+  WeightedChoice() = default;
+  WeightedChoice(std::vector<T> values, const std::vector<double>& weights);
+
+  template <class Rng>
+  const T& operator()(Rng& rng) const {
+    const double u =
+        std::uniform_real_distribution<double>(0, cumulative_.back())(rng);
+    size_t i = 0;
+    while (i + 1 < cumulative_.size() && u >= cumulative_[i]) {
+      ++i;
+    }
+    return values_[i];
+  }
+
+  const std::vector<T>& values() const {
+    return values_;
+  }
+
+ private:
+  std::vector<T> values_;
+  std::vector<double> cumulative_;
+};
+
+/**
+ * @throw std::exception  if spec is malformed.
+ */
+WeightedChoice<uint32_t> parseSizeDistribution(folly::StringPiece spec);
+WeightedChoice<std::string> parseOperationMix(folly::StringPiece spec);
+
+} // mcload
+} // memcache
+} // facebook
@@ -0,0 +1,331 @@
+/*
+ *  Copyright (c) 2016-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include "LoadGenerator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+#include <folly/Conv.h>
+#include <folly/Format.h>
+#include <folly/Random.h>
+#include <folly/fibers/AddTasks.h>
+#include <folly/fibers/EventBaseLoopController.h>
+#include <folly/fibers/FiberManager.h>
+#include <folly/io/async/EventBase.h>
+
+#include "mcrouter/lib/McResUtil.h"
+#include "mcrouter/lib/network/AsyncMcClient.h"
+#include "mcrouter/lib/network/gen/MemcacheMessages.h"
+#include "mcrouter/tools/mcload/Distributions.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcload {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// How often workers check for due operations.
+constexpr uint32_t kTickIntervalMs = 1;
+
+} // anonymous
+
+class LoadGenerator::Worker {
+ public:
+  Worker(
+      const Settings& settings,
+      Stats& stats,
+      const ZipfianGenerator& keys,
+      const WeightedChoice<uint32_t>& valueSizes,
+      const WeightedChoice<std::string>& operations,
+      const std::string& valueData)
+      : settings_(settings),
+        stats_(stats),
+        keys_(keys),
+        valueSizes_(valueSizes),
+        operations_(operations),
+        valueData_(valueData),
+        fm_(std::make_unique<folly::fibers::EventBaseLoopController>()),
+        rng_(folly::Random::rand64()),
+        interval_(std::chrono::nanoseconds(static_cast<int64_t>(
+            1e9 * settings.numThreads / settings.rate))),
+        timeout_(settings.timeoutMs) {
+    dynamic_cast<folly::fibers::EventBaseLoopController&>(fm_.loopController())
+        .attachEventBase(evb_);
+
+    ConnectionOptions opts(
+        settings_.host,
+        settings_.port,
+        mc_string_to_protocol(settings_.protocol.c_str()));
+    opts.writeTimeout = timeout_;
+    for (size_t i = 0; i < settings_.connectionsPerThread; ++i) {
+      clients_.push_back(std::make_unique<AsyncMcClient>(evb_, opts));
+    }
+  }
+
+  void start(Clock::time_point start, Clock::time_point end) {
+    start_ = start;
+    end_ = end;
+    thread_ = std::thread([this]() {
+      evb_.runInEventBaseThread([this]() { tick(); });
+      evb_.loopForever();
+      clients_.clear();
+    });
+  }
+
+  void stop() {
+    evb_.runInEventBaseThread([this]() { end_ = Clock::now(); });
+  }
+
+  void join() {
+    thread_.join();
+  }
+
+ private:
+  const Settings& settings_;
+  Stats& stats_;
+  const ZipfianGenerator& keys_;
+  const WeightedChoice<uint32_t>& valueSizes_;
+  const WeightedChoice<std::string>& operations_;
+  const std::string& valueData_;
+
+  folly::EventBase evb_;
+  folly::fibers::FiberManager fm_;
+  std::vector<std::unique_ptr<AsyncMcClient>> clients_;
+  size_t nextClient_{0};
+  std::mt19937_64 rng_;
+  std::thread thread_;
+
+  const std::chrono::nanoseconds interval_;
+  const std::chrono::milliseconds timeout_;
+  Clock::time_point start_;
+  Clock::time_point end_;
+  uint64_t issued_{0};
+  uint64_t backlog_{0};
+  size_t outstanding_{0};
+
+  void tick() {
+    issueDue();
+    if (Clock::now() < end_) {
+      evb_.runAfterDelay([this]() { tick(); }, kTickIntervalMs);
+    } else if (outstanding_ == 0) {
+      evb_.terminateLoopSoon();
+    }
+  }
+
+  void issueDue() {
+    const auto now = std::min(Clock::now(), end_);
+    const uint64_t due = now < start_ ? 0 : (now - start_) / interval_ + 1;
+    while (issued_ < due && outstanding_ < settings_.maxOutstanding) {
+      const auto intended = start_ + interval_ * issued_;
+      ++issued_;
+      ++outstanding_;
+      fm_.addTask([this, intended]() {
+        runOperation(intended);
+        --outstanding_;
+        issueDue();
+        if (outstanding_ == 0 && Clock::now() >= end_) {
+          evb_.terminateLoopSoon();
+        }
+      });
+    }
+    const uint64_t backlog = due > issued_ ? due - issued_ : 0;
+    // Unsigned wrap around makes this a subtraction when backlog shrinks.
+    stats_.backlog.fetch_add(backlog - backlog_, std::memory_order_relaxed);
+    backlog_ = backlog;
+  }
+
+  AsyncMcClient& nextClient() {
+    return *clients_[nextClient_++ % clients_.size()];
+  }
+
+  std::string randomKey() {
+    return folly::to<std::string>(settings_.keyPrefix, keys_(rng_));
+  }
+
+  folly::IOBuf randomValue() {
+    return folly::IOBuf(
+        folly::IOBuf::WRAP_BUFFER, valueData_.data(), valueSizes_(rng_));
+  }
+
+  template <class Request>
+  mc_res_t send(const Request& req) {
+    return nextClient().sendSync(req, timeout_).result();
+  }
+
+  mc_res_t get() {
+    return send(McGetRequest(randomKey()));
+  }
+
+  mc_res_t set() {
+    McSetRequest req(randomKey());
+    req.value() = randomValue();
+    return send(req);
+  }
+
+  mc_res_t multiget() {
+    std::vector<std::function<mc_res_t()>> gets;
+    for (size_t i = 0; i < settings_.multigetSize; ++i) {
+      gets.emplace_back([this, key = randomKey()]() {
+        return send(McGetRequest(key));
+      });
+    }
+    auto results = folly::fibers::collectAll(gets.begin(), gets.end());
+    for (auto result : results) {
+      if (isErrorResult(result)) {
+        return result;
+      }
+    }
+    return mc_res_found;
+  }
+
+  mc_res_t lease() {
+    auto key = randomKey();
+    auto reply = nextClient().sendSync(McLeaseGetRequest(key), timeout_);
+    // A token is handed out on miss: fill the key, as a client would.
+    if (reply.result() != mc_res_notfound || reply.leaseToken() <= 1) {
+      return reply.result();
+    }
+    McLeaseSetRequest req(key);
+    req.leaseToken() = reply.leaseToken();
+    req.value() = randomValue();
+    return send(req);
+  }
+
+  void runOperation(Clock::time_point intended) {
+    const auto& operation = operations_(rng_);
+    mc_res_t result;
+    if (operation == "get") {
+      result = get();
+    } else if (operation == "set") {
+      result = set();
+    } else if (operation == "multiget") {
+      result = multiget();
+    } else {
+      result = lease();
+    }
+
+    const auto latencyUs =
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            Clock::now() - intended)
+            .count();
+    stats_.latency.insertSample(latencyUs);
+    stats_.intervalLatency.insertSample(latencyUs);
+    stats_.completed.fetch_add(1, std::memory_order_relaxed);
+    if (result == mc_res_timeout) {
+      stats_.timeouts.fetch_add(1, std::memory_order_relaxed);
+    } else if (isErrorResult(result)) {
+      stats_.errors.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+};
+
+LoadGenerator::LoadGenerator(Settings settings)
+    : settings_(std::move(settings)) {
+  if (settings_.rate <= 0 || settings_.numThreads == 0 ||
+      settings_.connectionsPerThread == 0) {
+    throw std::invalid_argument(
+        "rate, threads and connections must be positive");
+  }
+  if (mc_string_to_protocol(settings_.protocol.c_str()) ==
+      mc_unknown_protocol) {
+    throw std::invalid_argument("Unknown protocol: " + settings_.protocol);
+  }
+}
+
+LoadGenerator::~LoadGenerator() {}
+
+void LoadGenerator::stop() {
+  stopped_ = true;
+}
+
+void LoadGenerator::run() {
+  const ZipfianGenerator keys(settings_.numKeys, settings_.zipfTheta);
+  const auto valueSizes = parseSizeDistribution(settings_.valueSizes);
+  const auto operations = parseOperationMix(settings_.operationMix);
+  uint32_t maxValueSize = 0;
+  for (auto size : valueSizes.values()) {
+    maxValueSize = std::max(maxValueSize, size);
+  }
+  const std::string valueData(maxValueSize, 'v');
+
+  for (size_t i = 0; i < settings_.numThreads; ++i) {
+    workers_.push_back(std::make_unique<Worker>(
+        settings_, stats_, keys, valueSizes, operations, valueData));
+  }
+  const auto start = Clock::now();
+  const auto end = start + std::chrono::seconds(settings_.durationS);
+  for (auto& worker : workers_) {
+    worker->start(start, end);
+  }
+
+  uint64_t lastCompleted = 0;
+  auto lastReport = start;
+  while (Clock::now() < end && !stopped_) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    const auto now = Clock::now();
+    if (now - lastReport >= std::chrono::seconds(settings_.reportIntervalS)) {
+      const auto completed = stats_.completed.load();
+      report(
+          std::chrono::duration<double>(now - lastReport).count(),
+          completed - lastCompleted);
+      lastCompleted = completed;
+      lastReport = now;
+    }
+  }
+
+  for (auto& worker : workers_) {
+    worker->stop();
+  }
+  for (auto& worker : workers_) {
+    worker->join();
+  }
+  printSummary(std::chrono::duration<double>(Clock::now() - start).count());
+  workers_.clear();
+}
+
+void LoadGenerator::report(double seconds, uint64_t completed) {
+  std::cerr << folly::sformat(
+                   "{:.0f} ops/s, p50 {}us, p99 {}us, backlog {}",
+                   completed / seconds,
+                   stats_.intervalLatency.percentile(0.5),
+                   stats_.intervalLatency.percentile(0.99),
+                   stats_.backlog.load())
+            << std::endl;
+  stats_.intervalLatency.reset();
+}
+
+void LoadGenerator::printSummary(double seconds) {
+  const auto completed = stats_.completed.load();
+  std::cout << folly::sformat(
+      "{} operations in {:.1f}s: {:.0f} ops/s (target {:.0f})\n"
+      "errors: {}, timeouts: {}\n"
+      "latency us (lower bound of a 25% bucket): "
+      "p50 {} p90 {} p99 {} p99.9 {} p99.99 {}\n",
+      completed,
+      seconds,
+      completed / seconds,
+      settings_.rate,
+      stats_.errors.load(),
+      stats_.timeouts.load(),
+      stats_.latency.percentile(0.5),
+      stats_.latency.percentile(0.9),
+      stats_.latency.percentile(0.99),
+      stats_.latency.percentile(0.999),
+      stats_.latency.percentile(0.9999));
+}
+
+} // mcload
+} // memcache
+} // facebook
@@ -0,0 +1,102 @@
+/*
+ *  Copyright (c) 2016-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mcrouter/LatencyHistogram.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcload {
+
+struct Settings {
+  std::string host{"localhost"};
+  uint16_t port{5000};
+  std::string protocol{"caret"};
+  size_t numThreads{4};
+  size_t connectionsPerThread{4};
+  // Target rate of operations per second, over all threads.
+  double rate{10000};
+  uint32_t durationS{10};
+  uint32_t timeoutMs{1000};
+  // Per thread. Operations due while this many are in flight are delayed,
+  // their latency still counts from the time they were due.
+  size_t maxOutstanding{10000};
+  uint64_t numKeys{1000000};
+  double zipfTheta{0.99};
+  std::string keyPrefix{"mcload:"};
+  std::string valueSizes{"100"};
+  std::string operationMix{"get:0.9,set:0.1"};
+  uint32_t multigetSize{10};
+  uint32_t reportIntervalS{1};
+};
+
+/**
+ * Open-loop memcache load generator.
+ *
+ * Every thread sends operations at fixed intervals, whether or not the
+ * previous ones completed. Latency is measured from the time an operation
+ * was due, not from the time it was actually sent, so that a slow server
+ * can't hide its latency by slowing down the load (coordinated omission).
+ */
+class LoadGenerator {
+ public:
+  struct Stats {
+    std::atomic<uint64_t> completed{0};
+    std::atomic<uint64_t> errors{0};
+    std::atomic<uint64_t> timeouts{0};
+    // Number of operations that were due but not sent yet.
+    std::atomic<uint64_t> backlog{0};
+    // Latency of operations, in microseconds.
+    mcrouter::LatencyHistogram latency;
+    // Same, reset at every report.
+    mcrouter::LatencyHistogram intervalLatency;
+  };
+
+  /**
+   * @throw std::exception  if settings are invalid.
+   */
+  explicit LoadGenerator(Settings settings);
+  ~LoadGenerator();
+
+  /**
+   * Runs the load for settings.durationS seconds (or until stop() is
+   * called), printing progress every settings.reportIntervalS seconds and a
+   * summary at the end.
+   */
+  void run();
+
+  /**
+   * Makes run() return early. Thread-safe.
+   */
+  void stop();
+
+  const Stats& stats() const {
+    return stats_;
+  }
+
+ private:
+  class Worker;
+
+  const Settings settings_;
+  Stats stats_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::atomic<bool> stopped_{false};
+
+  void report(double seconds, uint64_t completed);
+  void printSummary(double seconds);
+};
+
+} // mcload
+} // memcache
+} // facebook
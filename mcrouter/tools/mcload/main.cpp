@@ -0,0 +1,142 @@
+/*
+ *  Copyright (c) 2016-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <signal.h>
+
+#include <cstring>
+#include <iostream>
+
+#include <boost/program_options.hpp>
+
+#include <folly/Format.h>
+#include <folly/init/Init.h>
+
+#include "mcrouter/tools/mcload/LoadGenerator.h"
+
+using namespace facebook::memcache::mcload;
+
+namespace {
+
+std::unique_ptr<LoadGenerator> gLoadGenerator;
+
+void onSignal(int) {
+  gLoadGenerator->stop();
+}
+
+std::string getUsage(const char* binaryName) {
+  return folly::sformat(
+      "Usage: {} [OPTION]...\n"
+      "Sends memcache traffic to HOST:PORT at a fixed rate and reports "
+      "throughput and latency.\n"
+      "Operations are \"get\", \"set\", \"multiget\" and \"lease\" "
+      "(lease-get, then lease-set on miss).\n"
+      "Distributions are \"value:weight,...\", e.g. "
+      "--value-sizes=100:0.8,10000:0.2\n",
+      binaryName);
+}
+
+Settings parseOptions(int argc, char** argv) {
+  Settings settings;
+
+  namespace po = boost::program_options;
+
+  po::options_description namedOpts("Allowed options");
+  namedOpts.add_options()("help,h", "Print this help message.")(
+      "host,H",
+      po::value<std::string>(&settings.host),
+      "Host to send traffic to.")(
+      "port,p", po::value<uint16_t>(&settings.port), "Port.")(
+      "protocol",
+      po::value<std::string>(&settings.protocol),
+      "\"ascii\", \"umbrella\" or \"caret\".")(
+      "threads,t",
+      po::value<size_t>(&settings.numThreads),
+      "Number of event base threads.")(
+      "connections,c",
+      po::value<size_t>(&settings.connectionsPerThread),
+      "Number of connections per thread.")(
+      "rate,r",
+      po::value<double>(&settings.rate),
+      "Target number of operations per second (over all threads).")(
+      "duration,d",
+      po::value<uint32_t>(&settings.durationS),
+      "Duration of the test in seconds.")(
+      "timeout",
+      po::value<uint32_t>(&settings.timeoutMs),
+      "Request timeout in milliseconds.")(
+      "max-outstanding",
+      po::value<size_t>(&settings.maxOutstanding),
+      "Maximum number of operations in flight per thread.")(
+      "num-keys,k",
+      po::value<uint64_t>(&settings.numKeys),
+      "Number of distinct keys.")(
+      "zipf-theta",
+      po::value<double>(&settings.zipfTheta),
+      "Skew of key popularity in [0, 1), 0 means uniform.")(
+      "key-prefix",
+      po::value<std::string>(&settings.keyPrefix),
+      "Prefix of all keys.")(
+      "value-sizes",
+      po::value<std::string>(&settings.valueSizes),
+      "Distribution of value sizes of sets.")(
+      "operations,o",
+      po::value<std::string>(&settings.operationMix),
+      "Distribution of operations.")(
+      "multiget-size",
+      po::value<uint32_t>(&settings.multigetSize),
+      "Number of keys per multiget.")(
+      "report-interval",
+      po::value<uint32_t>(&settings.reportIntervalS),
+      "Seconds between progress reports.");
+
+  po::variables_map vm;
+  try {
+    po::store(po::parse_command_line(argc, argv, namedOpts), vm);
+    po::notify(vm);
+  } catch (po::error& ex) {
+    LOG(ERROR) << ex.what();
+    exit(1);
+  }
+
+  if (vm.count("help")) {
+    std::cerr << getUsage(argv[0]) << std::endl;
+    namedOpts.print(std::cerr);
+    exit(0);
+  }
+
+  return settings;
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+  // Just give the binary name to folly::init() because we use
+  // boost::program_options instead of gflags.
+  int tempArgc = 1;
+  folly::init(&tempArgc, &argv, false);
+
+  try {
+    gLoadGenerator = std::make_unique<LoadGenerator>(parseOptions(argc, argv));
+  } catch (const std::exception& e) {
+    LOG(ERROR) << e.what();
+    return 1;
+  }
+
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(struct sigaction));
+  sa.sa_handler = onSignal;
+  sigaction(SIGINT, &sa, nullptr);
+  signal(SIGPIPE, SIG_IGN);
+
+  try {
+    gLoadGenerator->run();
+  } catch (const std::exception& e) {
+    LOG(ERROR) << e.what();
+    return 1;
+  }
+  return 0;
+}
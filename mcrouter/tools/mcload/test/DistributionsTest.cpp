@@ -0,0 +1,63 @@
+/*
+ *  Copyright (c) 2016-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/tools/mcload/Distributions.h"
+
+using namespace facebook::memcache::mcload;
+
+TEST(ZipfianGenerator, uniform) {
+  ZipfianGenerator keys(10, 0);
+  EXPECT_EQ(0, keys.sample(0));
+  EXPECT_EQ(5, keys.sample(0.55));
+  EXPECT_EQ(9, keys.sample(0.9999));
+}
+
+TEST(ZipfianGenerator, skewed) {
+  ZipfianGenerator keys(1000, 0.99);
+  std::mt19937_64 rng(42);
+  std::vector<uint64_t> counts(1000);
+  for (size_t i = 0; i < 100000; ++i) {
+    auto key = keys(rng);
+    ASSERT_LT(key, 1000);
+    ++counts[key];
+  }
+  // Popularity decreases with the index.
+  EXPECT_GT(counts[0], counts[1]);
+  EXPECT_GT(counts[1], counts[10]);
+  EXPECT_GT(counts[10], counts[500]);
+}
+
+TEST(ZipfianGenerator, invalid) {
+  EXPECT_THROW(ZipfianGenerator(0, 0.5), std::invalid_argument);
+  EXPECT_THROW(ZipfianGenerator(10, 1), std::invalid_argument);
+  EXPECT_THROW(ZipfianGenerator(10, -0.1), std::invalid_argument);
+}
+
+TEST(WeightedChoice, parse) {
+  auto sizes = parseSizeDistribution("100:0,200:1");
+  EXPECT_EQ((std::vector<uint32_t>{100, 200}), sizes.values());
+  std::mt19937_64 rng(42);
+  for (size_t i = 0; i < 100; ++i) {
+    EXPECT_EQ(200, sizes(rng));
+  }
+
+  auto fixed = parseSizeDistribution("4096");
+  EXPECT_EQ(4096, fixed(rng));
+
+  auto operations = parseOperationMix("get:0.9,set:0.1");
+  EXPECT_EQ((std::vector<std::string>{"get", "set"}), operations.values());
+
+  EXPECT_ANY_THROW(parseOperationMix("append:1"));
+  EXPECT_ANY_THROW(parseSizeDistribution(""));
+  EXPECT_ANY_THROW(parseSizeDistribution("100:-1"));
+  EXPECT_ANY_THROW(parseSizeDistribution("abc"));
+}
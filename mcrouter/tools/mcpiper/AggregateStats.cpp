@@ -0,0 +1,113 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include "AggregateStats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <folly/lang/Bits.h>
+
+namespace facebook {
+namespace memcache {
+
+void TopKeys::add(folly::StringPiece key, uint64_t count) {
+  if (capacity_ == 0) {
+    return;
+  }
+  auto str = key.str();
+  auto it = counts_.find(str);
+  if (it != counts_.end()) {
+    byCount_.erase(std::make_pair(it->second, str));
+    it->second += count;
+    byCount_.emplace(it->second, std::move(str));
+    return;
+  }
+
+  uint64_t base = 0;
+  if (counts_.size() >= capacity_) {
+    auto least = byCount_.begin();
+    base = least->first;
+    counts_.erase(least->second);
+    byCount_.erase(least);
+  }
+  counts_.emplace(str, base + count);
+  byCount_.emplace(base + count, std::move(str));
+}
+
+void TopKeys::merge(const TopKeys& other) {
+  for (const auto& kv : other.counts_) {
+    add(kv.first, kv.second);
+  }
+}
+
+std::vector<std::pair<std::string, uint64_t>> TopKeys::top(size_t k) const {
+  std::vector<std::pair<std::string, uint64_t>> result;
+  for (auto it = byCount_.rbegin(); it != byCount_.rend() && result.size() < k;
+       ++it) {
+    result.emplace_back(it->second, it->first);
+  }
+  return result;
+}
+
+constexpr size_t Log2Histogram::kNumBuckets;
+
+void Log2Histogram::add(uint64_t value) {
+  ++buckets_[folly::findLastSet(value)];
+  ++count_;
+  sum_ += value;
+  max_ = std::max(max_, value);
+}
+
+void Log2Histogram::merge(const Log2Histogram& other) {
+  for (size_t i = 0; i < kNumBuckets; ++i) {
+    buckets_[i] += other.buckets_[i];
+  }
+  count_ += other.count_;
+  sum_ += other.sum_;
+  max_ = std::max(max_, other.max_);
+}
+
+uint64_t Log2Histogram::bucketUpperBound(size_t bucket) {
+  if (bucket >= kNumBuckets - 1) {
+    return std::numeric_limits<uint64_t>::max();
+  }
+  return (uint64_t(1) << bucket) - 1;
+}
+
+uint64_t Log2Histogram::percentile(double p) const {
+  if (count_ == 0) {
+    return 0;
+  }
+  const auto target = std::max<uint64_t>(
+      1, static_cast<uint64_t>(std::ceil(p / 100.0 * count_)));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < kNumBuckets; ++i) {
+    seen += buckets_[i];
+    if (seen >= target) {
+      return std::min(bucketUpperBound(i), max_);
+    }
+  }
+  return max_;
+}
+
+void AggregateStats::merge(const AggregateStats& other) {
+  requests += other.requests;
+  replies += other.replies;
+  for (const auto& kv : other.requestsByOperation) {
+    requestsByOperation[kv.first] += kv.second;
+  }
+  topKeys.merge(other.topKeys);
+  valueSizes.merge(other.valueSizes);
+  for (const auto& kv : other.latencyByDestination) {
+    latencyByDestination[kv.first].merge(kv.second);
+  }
+}
+
+} // memcache
+} // facebook
@@ -0,0 +1,125 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <folly/Range.h>
+
+namespace facebook {
+namespace memcache {
+
+/**
+ * Approximate counts of the most frequent keys of a stream (Space-Saving):
+ * at most "capacity" keys are tracked, and an untracked key replaces the
+ * least frequent one, inheriting its count. So the count of a key is
+ * overestimated by at most the smallest tracked count, and any key seen
+ * more often than that is guaranteed to be tracked.
+ */
+class TopKeys {
+ public:
+  explicit TopKeys(size_t capacity) : capacity_(capacity) {}
+
+  void add(folly::StringPiece key, uint64_t count = 1);
+
+  /**
+   * Adds all keys tracked by other, with their counts.
+   */
+  void merge(const TopKeys& other);
+
+  /**
+   * @return  up to k (key, count) pairs, most frequent first.
+   */
+  std::vector<std::pair<std::string, uint64_t>> top(size_t k) const;
+
+  size_t size() const {
+    return counts_.size();
+  }
+
+ private:
+  size_t capacity_;
+  std::unordered_map<std::string, uint64_t> counts_;
+  // (count, key) of every tracked key, to find the least frequent one.
+  std::set<std::pair<uint64_t, std::string>> byCount_;
+};
+
+/**
+ * Histogram with power of two buckets: bucket 0 holds zeros and bucket i
+ * holds values in [2^(i-1), 2^i).
+ */
+class Log2Histogram {
+ public:
+  static constexpr size_t kNumBuckets = 65;
+
+  void add(uint64_t value);
+  void merge(const Log2Histogram& other);
+
+  uint64_t count() const {
+    return count_;
+  }
+
+  uint64_t max() const {
+    return max_;
+  }
+
+  double average() const {
+    return count_ == 0 ? 0.0 : static_cast<double>(sum_) / count_;
+  }
+
+  uint64_t bucketCount(size_t bucket) const {
+    return buckets_[bucket];
+  }
+
+  /**
+   * @return  the largest value that falls in the given bucket.
+   */
+  static uint64_t bucketUpperBound(size_t bucket);
+
+  /**
+   * @param p  percentile, in [0, 100].
+   * @return   upper bound of the bucket that holds the p-th percentile
+   *           (capped at the largest value added), or 0 if empty.
+   */
+  uint64_t percentile(double p) const;
+
+ private:
+  std::array<uint64_t, kNumBuckets> buckets_{};
+  uint64_t count_{0};
+  uint64_t sum_{0};
+  uint64_t max_{0};
+};
+
+/**
+ * Stats of the traffic seen by mcpiper in aggregation mode.
+ */
+struct AggregateStats {
+  explicit AggregateStats(size_t topKeysCapacity) : topKeys(topKeysCapacity) {}
+
+  uint64_t requests{0};
+  uint64_t replies{0};
+  // Request name (e.g. "get") -> number of requests.
+  std::map<std::string, uint64_t> requestsByOperation;
+  // Keys of requests.
+  TopKeys topKeys;
+  // Sizes of the values carried by requests and replies, in bytes.
+  Log2Histogram valueSizes;
+  // Address that sent the reply -> request/reply latency, in microseconds.
+  std::unordered_map<std::string, Log2Histogram> latencyByDestination;
+
+  void merge(const AggregateStats& other);
+};
+
+} // memcache
+} // facebook
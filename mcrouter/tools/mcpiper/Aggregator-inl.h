@@ -0,0 +1,55 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include "mcrouter/lib/McResUtil.h"
+#include "mcrouter/lib/carbon/RequestReplyUtil.h"
+
+namespace facebook {
+namespace memcache {
+
+template <class Request>
+void AggregatorWorker::requestReady(
+    uint64_t /* msgId */,
+    Request&& request,
+    const folly::SocketAddress& /* from */,
+    const folly::SocketAddress& /* to */,
+    mc_protocol_t /* protocol */) {
+  ++totals_.totalMessages;
+  ++stats_.requests;
+  ++stats_.requestsByOperation[Request::name];
+  stats_.topKeys.add(request.key().fullKey());
+  if (Request::hasValue) {
+    stats_.valueSizes.add(carbon::valueRangeSlow(request).size());
+  }
+}
+
+template <class Reply>
+void AggregatorWorker::replyReady(
+    uint64_t /* msgId */,
+    Reply&& reply,
+    std::string /* key */,
+    const folly::SocketAddress& from,
+    const folly::SocketAddress& /* to */,
+    mc_protocol_t /* protocol */,
+    int64_t latencyUs,
+    ReplyStatsContext /* replyStatsContext */) {
+  ++totals_.totalMessages;
+  ++stats_.replies;
+  // Misses carry no value, don't let them skew the sizes towards zero.
+  if (Reply::hasValue && !isMissResult(reply.result())) {
+    stats_.valueSizes.add(carbon::valueRangeSlow(reply).size());
+  }
+  // Latency is only known when the request was seen too.
+  if (latencyUs > 0) {
+    latencies_[from].add(latencyUs);
+  }
+}
+
+} // memcache
+} // facebook
@@ -0,0 +1,244 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include "Aggregator.h"
+
+#include <algorithm>
+
+#include <folly/Format.h>
+#include <folly/hash/Hash.h>
+
+#include "mcrouter/tools/mcpiper/Config.h"
+
+namespace facebook {
+namespace memcache {
+
+namespace {
+
+// Keys tracked per hot key displayed: the more, the better the estimates.
+constexpr size_t kTopKeysTrackedPerDisplayed = 100;
+constexpr size_t kMinTopKeysTracked = 1000;
+
+size_t topKeysCapacity(size_t numTopKeys) {
+  return std::max(kMinTopKeysTracked, numTopKeys * kTopKeysTrackedPerDisplayed);
+}
+
+std::string describeBucket(size_t bucket) {
+  if (bucket == 0) {
+    return "0";
+  }
+  return folly::sformat(
+      "{}-{}",
+      Log2Histogram::bucketUpperBound(bucket - 1) + 1,
+      Log2Histogram::bucketUpperBound(bucket));
+}
+
+} // anonymous namespace
+
+AggregatorWorker::AggregatorWorker(
+    size_t topKeysCapacity,
+    MessagePrinter::Stats& totals)
+    : topKeysCapacity_(topKeysCapacity),
+      totals_(totals),
+      stats_(topKeysCapacity),
+      thread_("mcpiper-agg") {}
+
+void AggregatorWorker::messageReady(
+    uint64_t connectionId,
+    uint64_t packetId,
+    folly::SocketAddress from,
+    folly::SocketAddress to,
+    uint32_t typeId,
+    uint64_t msgStartTime,
+    std::string routerName,
+    std::unique_ptr<folly::IOBuf> data) {
+  thread_.getEventBase()->runInEventBaseThread(
+      [this,
+       connectionId,
+       packetId,
+       from = std::move(from),
+       to = std::move(to),
+       typeId,
+       msgStartTime,
+       routerName = std::move(routerName),
+       data = std::move(data)]() {
+        parse(
+            connectionId,
+            packetId,
+            from,
+            to,
+            typeId,
+            msgStartTime,
+            routerName,
+            folly::ByteRange(data->data(), data->length()));
+      });
+}
+
+void AggregatorWorker::parse(
+    uint64_t connectionId,
+    uint64_t packetId,
+    const folly::SocketAddress& from,
+    const folly::SocketAddress& to,
+    uint32_t typeId,
+    uint64_t msgStartTime,
+    const std::string& routerName,
+    folly::ByteRange data) {
+  auto it = parsers_.find(connectionId);
+  if (it == parsers_.end()) {
+    it = addCarbonSnifferParser(routerName, parsers_, connectionId, *this);
+  }
+  auto& snifferParser = it->second;
+
+  if (packetId == 0) {
+    snifferParser->resetParser();
+  }
+
+  snifferParser->setAddresses(from, to);
+  snifferParser->setCurrentMsgStartTime(msgStartTime);
+  snifferParser->parse(data, typeId, packetId == 0 /* isFirstPacket */);
+}
+
+AggregateStats AggregatorWorker::takeStats() {
+  AggregateStats result(topKeysCapacity_);
+  thread_.getEventBase()->runInEventBaseThreadAndWait([this, &result]() {
+    std::swap(result, stats_);
+    // Addresses are only formatted here, not for every reply.
+    for (auto& kv : latencies_) {
+      result.latencyByDestination[kv.first.describe()].merge(kv.second);
+    }
+    latencies_.clear();
+  });
+  return result;
+}
+
+Aggregator::Aggregator(Options options, std::ostream& targetOut)
+    : options_(std::move(options)),
+      targetOut_(targetOut),
+      cumulative_(topKeysCapacity(options_.numTopKeys)) {
+  const auto numThreads = std::max<size_t>(1, options_.numThreads);
+  for (size_t i = 0; i < numThreads; ++i) {
+    workers_.push_back(std::make_unique<AggregatorWorker>(
+        topKeysCapacity(options_.numTopKeys), totals_));
+  }
+}
+
+void Aggregator::messageReady(
+    uint64_t connectionId,
+    uint64_t packetId,
+    folly::SocketAddress from,
+    folly::SocketAddress to,
+    uint32_t typeId,
+    uint64_t msgStartTime,
+    std::string routerName,
+    folly::ByteRange data) {
+  // The packets of a connection must be parsed in order, by the same parser.
+  auto& worker =
+      *workers_[folly::hash::twang_mix64(connectionId) % workers_.size()];
+  worker.messageReady(
+      connectionId,
+      packetId,
+      std::move(from),
+      std::move(to),
+      typeId,
+      msgStartTime,
+      std::move(routerName),
+      folly::IOBuf::copyBuffer(data.data(), data.size()));
+}
+
+void Aggregator::refresh() {
+  AggregateStats interval(topKeysCapacity(options_.numTopKeys));
+  for (auto& worker : workers_) {
+    interval.merge(worker->takeStats());
+  }
+  cumulative_.merge(interval);
+
+  const auto now = Clock::now();
+  const auto intervalSec =
+      std::chrono::duration<double>(now - lastRefresh_).count();
+  lastRefresh_ = now;
+
+  print(interval, intervalSec);
+}
+
+void Aggregator::print(const AggregateStats& interval, double intervalSec) {
+  const auto perSec = [intervalSec](uint64_t count) {
+    return intervalSec > 0 ? count / intervalSec : 0.0;
+  };
+
+  if (options_.clearScreen) {
+    // Move the cursor home and clear the screen.
+    targetOut_ << "\x1b[H\x1b[2J";
+  }
+
+  targetOut_ << folly::sformat(
+                    "requests/s: {:.1f}  replies/s: {:.1f}  "
+                    "(total: {} requests, {} replies)",
+                    perSec(interval.requests),
+                    perSec(interval.replies),
+                    cumulative_.requests,
+                    cumulative_.replies)
+             << "\n\n";
+
+  targetOut_ << folly::sformat("{:<24} {:>12}", "operation", "requests/s")
+             << "\n";
+  for (const auto& kv : interval.requestsByOperation) {
+    targetOut_ << folly::sformat(
+                      "{:<24} {:>12.1f}", kv.first, perSec(kv.second))
+               << "\n";
+  }
+
+  targetOut_ << "\n"
+             << folly::sformat("{:<48} {:>12}", "top keys", "~requests")
+             << "\n";
+  for (const auto& kv : cumulative_.topKeys.top(options_.numTopKeys)) {
+    targetOut_ << folly::sformat("{:<48} {:>12}", kv.first, kv.second) << "\n";
+  }
+
+  targetOut_ << "\n"
+             << folly::sformat(
+                    "{:<24} {:>12} {:>8}", "value size", "count", "%")
+             << "\n";
+  const auto& sizes = cumulative_.valueSizes;
+  for (size_t i = 0; i < Log2Histogram::kNumBuckets; ++i) {
+    if (sizes.bucketCount(i) == 0) {
+      continue;
+    }
+    targetOut_ << folly::sformat(
+                      "{:<24} {:>12} {:>8.1f}",
+                      describeBucket(i),
+                      sizes.bucketCount(i),
+                      100.0 * sizes.bucketCount(i) / sizes.count())
+               << "\n";
+  }
+
+  targetOut_ << "\n"
+             << folly::sformat(
+                    "{:<32} {:>10} {:>10} {:>10} {:>10} {:>10}",
+                    "destination",
+                    "replies",
+                    "avg us",
+                    "p50 us",
+                    "p99 us",
+                    "max us")
+             << "\n";
+  for (const auto& kv : cumulative_.latencyByDestination) {
+    const auto& latency = kv.second;
+    targetOut_ << folly::sformat(
+                      "{:<32} {:>10} {:>10.0f} {:>10} {:>10} {:>10}",
+                      kv.first,
+                      latency.count(),
+                      latency.average(),
+                      latency.percentile(50),
+                      latency.percentile(99),
+                      latency.max())
+               << "\n";
+  }
+  targetOut_ << std::flush;
+}
+
+} // memcache
+} // facebook
@@ -0,0 +1,163 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <folly/SocketAddress.h>
+#include <folly/io/IOBuf.h>
+#include <folly/io/async/ScopedEventBaseThread.h>
+
+#include "mcrouter/tools/mcpiper/AggregateStats.h"
+#include "mcrouter/tools/mcpiper/MessagePrinter.h"
+#include "mcrouter/tools/mcpiper/SnifferParser.h"
+
+namespace facebook {
+namespace memcache {
+
+/**
+ * Parses the traffic of a subset of the connections on a thread of its own,
+ * and accumulates AggregateStats about it.
+ */
+class AggregatorWorker {
+ public:
+  AggregatorWorker(size_t topKeysCapacity, MessagePrinter::Stats& totals);
+
+  AggregatorWorker(const AggregatorWorker&) = delete;
+  AggregatorWorker& operator=(const AggregatorWorker&) = delete;
+
+  /**
+   * Schedules a packet read from the fifos to be parsed on this worker's
+   * thread. All the packets of a connection must go to the same worker.
+   */
+  void messageReady(
+      uint64_t connectionId,
+      uint64_t packetId,
+      folly::SocketAddress from,
+      folly::SocketAddress to,
+      uint32_t typeId,
+      uint64_t msgStartTime,
+      std::string routerName,
+      std::unique_ptr<folly::IOBuf> data);
+
+  /**
+   * Returns the stats accumulated since the last call and starts over.
+   * Blocks until the worker thread has processed the packets scheduled
+   * before the call.
+   */
+  AggregateStats takeStats();
+
+ private:
+  const size_t topKeysCapacity_;
+  MessagePrinter::Stats& totals_;
+  // Only accessed from the worker thread.
+  std::unordered_map<
+      uint64_t,
+      std::unique_ptr<SnifferParserBase<AggregatorWorker>>>
+      parsers_;
+  AggregateStats stats_;
+  std::unordered_map<folly::SocketAddress, Log2Histogram> latencies_;
+  // Last member, so the thread is joined before the state above goes away.
+  folly::ScopedEventBaseThread thread_;
+
+  void parse(
+      uint64_t connectionId,
+      uint64_t packetId,
+      const folly::SocketAddress& from,
+      const folly::SocketAddress& to,
+      uint32_t typeId,
+      uint64_t msgStartTime,
+      const std::string& routerName,
+      folly::ByteRange data);
+
+  // SnifferParser Callbacks
+  template <class Request>
+  void requestReady(
+      uint64_t msgId,
+      Request&& request,
+      const folly::SocketAddress& from,
+      const folly::SocketAddress& to,
+      mc_protocol_t protocol);
+
+  template <class Reply>
+  void replyReady(
+      uint64_t msgId,
+      Reply&& reply,
+      std::string key,
+      const folly::SocketAddress& from,
+      const folly::SocketAddress& to,
+      mc_protocol_t protocol,
+      int64_t latencyUs,
+      ReplyStatsContext replyStatsContext);
+
+  friend class SnifferParserBase<AggregatorWorker>;
+};
+
+/**
+ * Live aggregation mode of mcpiper: instead of printing every message,
+ * parses the fifo streams on several threads and periodically prints a
+ * summary of the traffic (operations per second, hottest keys, value sizes
+ * and latency by destination).
+ */
+class Aggregator {
+ public:
+  struct Options {
+    // Number of parsing threads.
+    size_t numThreads{4};
+    // Number of hot keys to display.
+    size_t numTopKeys{10};
+    // Clear the terminal before every summary.
+    bool clearScreen{true};
+  };
+
+  explicit Aggregator(Options options, std::ostream& targetOut = std::cout);
+
+  /**
+   * Called from the fifo reader thread when a packet is read.
+   */
+  void messageReady(
+      uint64_t connectionId,
+      uint64_t packetId,
+      folly::SocketAddress from,
+      folly::SocketAddress to,
+      uint32_t typeId,
+      uint64_t msgStartTime,
+      std::string routerName,
+      folly::ByteRange data);
+
+  /**
+   * Collects the stats of all workers and prints the summary.
+   */
+  void refresh();
+
+  const MessagePrinter::Stats& stats() const noexcept {
+    return totals_;
+  }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  const Options options_;
+  std::ostream& targetOut_;
+  MessagePrinter::Stats totals_;
+  AggregateStats cumulative_;
+  Clock::time_point lastRefresh_{Clock::now()};
+  std::vector<std::unique_ptr<AggregatorWorker>> workers_;
+
+  void print(const AggregateStats& interval, double intervalSec);
+};
+
+} // memcache
+} // facebook
+
+#include "Aggregator-inl.h"
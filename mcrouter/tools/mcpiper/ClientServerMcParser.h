@@ -12,6 +12,7 @@
 #include <folly/Range.h>
 #include <folly/io/IOBuf.h>
 
+#include "mcrouter/lib/CompressionCodecManager.h"
 #include "mcrouter/lib/Operation.h"
 #include "mcrouter/lib/network/CarbonMessageDispatcher.h"
 #include "mcrouter/lib/network/ClientMcParser.h"
@@ -112,6 +113,23 @@ class ClientServerMcParser {
     void caretRequestReady(
         const UmbrellaMessageInfo& headerInfo,
         const folly::IOBuf& buffer) {
+      if (headerInfo.usedCodecId > 0) {
+        auto* codecMap = getCompressionCodecMap();
+        auto* codec =
+            codecMap ? codecMap->get(headerInfo.usedCodecId) : nullptr;
+        if (!codec) {
+          // Compressed with a codec we don't have, can't be printed.
+          return;
+        }
+        auto body = codec->uncompress(
+            buffer.data() + headerInfo.headerSize,
+            headerInfo.bodySize,
+            headerInfo.uncompressedBodySize);
+        auto info = headerInfo;
+        info.headerSize = 0;
+        this->dispatchTypedRequest(info, *body, info);
+        return;
+      }
       this->dispatchTypedRequest(headerInfo, buffer, headerInfo);
     }
 
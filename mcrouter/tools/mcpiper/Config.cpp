@@ -11,6 +11,7 @@
 
 #include "mcrouter/lib/network/gen/MemcacheRouterInfo.h"
 #include "mcrouter/lib/network/gen/MemcacheServer.h"
+#include "mcrouter/tools/mcpiper/Aggregator.h"
 #include "mcrouter/tools/mcpiper/MessagePrinter.h"
 #include "mcrouter/tools/mcpiper/SnifferParser.h"
 
@@ -68,5 +69,24 @@ addCarbonSnifferParser(
       .first;
 }
 
+std::unordered_map<
+    uint64_t,
+    std::unique_ptr<SnifferParserBase<AggregatorWorker>>>::iterator
+addCarbonSnifferParser(
+    std::string /* routerName */,
+    std::unordered_map<
+        uint64_t,
+        std::unique_ptr<SnifferParserBase<AggregatorWorker>>>& parserMap,
+    uint64_t connectionId,
+    AggregatorWorker& aggregator) {
+  return parserMap
+      .emplace(
+          connectionId,
+          std::make_unique<SnifferParser<
+              AggregatorWorker,
+              memcache::detail::MemcacheRequestList>>(aggregator))
+      .first;
+}
+
 } // memcache
 } // facebook
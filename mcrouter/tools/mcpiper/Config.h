@@ -15,6 +15,7 @@
 namespace facebook {
 namespace memcache {
 
+class AggregatorWorker;
 class CompressionCodecMap;
 class MessagePrinter;
 template <class T>
@@ -68,5 +69,19 @@ addCarbonSnifferParser(
         std::unique_ptr<SnifferParserBase<MessagePrinter>>>& parserMap,
     uint64_t connectionId,
     MessagePrinter& printer);
+
+/**
+ * Same as above, for parsers that feed the aggregation mode.
+ */
+std::unordered_map<
+    uint64_t,
+    std::unique_ptr<SnifferParserBase<AggregatorWorker>>>::iterator
+addCarbonSnifferParser(
+    std::string name,
+    std::unordered_map<
+        uint64_t,
+        std::unique_ptr<SnifferParserBase<AggregatorWorker>>>& parserMap,
+    uint64_t connectionId,
+    AggregatorWorker& aggregator);
 }
 } // facebook::memcache
@@ -8,14 +8,17 @@
 #include "FifoReader.h"
 
 #include <fcntl.h>
+#include <sys/stat.h>
 
 #include <algorithm>
+#include <cstdio>
 #include <cstring>
 #include <vector>
 
 #include <boost/filesystem.hpp>
 #include <boost/regex.hpp>
 
+#include <folly/FileUtil.h>
 #include <folly/io/async/EventBase.h>
 
 namespace fs = boost::filesystem;
@@ -201,12 +204,15 @@ FifoReaderManager::FifoReaderManager(
     folly::EventBase& evb,
     MessageReadyFn messageReady,
     std::string dir,
-    std::unique_ptr<boost::regex> filenamePattern)
+    std::unique_ptr<boost::regex> filenamePattern,
+    folly::Optional<FifoFilter> filter)
     : evb_(evb),
       messageReady_(std::move(messageReady)),
       directory_(std::move(dir)),
-      filenamePattern_(std::move(filenamePattern)) {
+      filenamePattern_(std::move(filenamePattern)),
+      filter_(std::move(filter)) {
   runScanDirectory();
+  pollRings();
 }
 
 std::vector<std::string> FifoReaderManager::getMatchedFiles() const {
@@ -224,6 +230,10 @@ std::vector<std::string> FifoReaderManager::getMatchedFiles() const {
           continue;
         }
         auto& path = it->path();
+        if (folly::StringPiece(path.filename().string())
+                .endsWith(FifoFilter::kFileSuffix)) {
+          continue;
+        }
         if (!filenamePattern_ || boost::regex_search(
                                      path.filename().string(),
                                      *filenamePattern_,
@@ -245,6 +255,10 @@ void FifoReaderManager::runScanDirectory() {
     if (fifoReaders_.find(fifo) != fifoReaders_.end()) {
       continue;
     }
+    if (tryAddRing(fifo)) {
+      continue;
+    }
+    publishFilter(fifo);
     auto fd = ::open(fifo.c_str(), O_RDONLY | O_NONBLOCK);
     if (fd >= 0) {
       auto pipeReader = folly::AsyncPipeReader::UniquePtr(
@@ -258,14 +272,93 @@ void FifoReaderManager::runScanDirectory() {
     }
   }
 
-  evb_.runAfterDelay(
-      [this]() { runScanDirectory(); }, kPollDirectoryIntervalMs);
+  if (running_) {
+    evb_.runAfterDelay(
+        [this]() { runScanDirectory(); }, kPollDirectoryIntervalMs);
+  }
+}
+
+bool FifoReaderManager::tryAddRing(const std::string& path) {
+  struct stat st;
+  if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+    return false;
+  }
+  auto it = ringReaders_.find(path);
+  if (it != ringReaders_.end() && it->second.inode == st.st_ino) {
+    return true;
+  }
+  if (!ShmRingReader::isRing(path)) {
+    return false;
+  }
+
+  try {
+    RingReader reader;
+    reader.ring = std::make_unique<ShmRingReader>(path);
+    reader.callback = std::make_unique<FifoReadCallback>(path, messageReady_);
+    reader.inode = st.st_ino;
+    ringReaders_[path] = std::move(reader);
+    publishFilter(path);
+  } catch (const std::exception& e) {
+    LOG(WARNING) << "Error opening ring " << path << ": " << e.what();
+  }
+  return true;
+}
+
+void FifoReaderManager::pollRings() {
+  for (auto& kv : ringReaders_) {
+    auto& reader = kv.second;
+    auto lost = reader.ring->read([&reader](folly::ByteRange record) {
+      while (!record.empty()) {
+        void* buf;
+        size_t len;
+        reader.callback->getReadBuffer(&buf, &len);
+        len = std::min(len, record.size());
+        std::memcpy(buf, record.data(), len);
+        reader.callback->readDataAvailable(len);
+        record.advance(len);
+      }
+    });
+    if (lost > 0) {
+      LOG(WARNING) << "Ring " << kv.first << " overrun, lost " << lost
+                   << " bytes.";
+      // Every record starts at a packet boundary, so resync the parser
+      // by starting over.
+      reader.callback =
+          std::make_unique<FifoReadCallback>(kv.first, messageReady_);
+    }
+  }
+
+  if (running_) {
+    evb_.runAfterDelay([this]() { pollRings(); }, kPollRingsIntervalMs);
+  }
+}
+
+void FifoReaderManager::publishFilter(const std::string& fifoPath) const {
+  if (!filter_) {
+    return;
+  }
+  try {
+    folly::writeFileAtomic(FifoFilter::filterPath(fifoPath), filter_->toJson());
+  } catch (const std::exception& e) {
+    LOG(WARNING) << "Error publishing filter for " << fifoPath << ": "
+                 << e.what();
+  }
 }
 
 void FifoReaderManager::unregisterCallbacks() {
   for (auto& fifoReader : fifoReaders_) {
     fifoReader.second.first->setReadCB(nullptr);
   }
+  if (filter_) {
+    for (const auto& kv : fifoReaders_) {
+      ::remove(FifoFilter::filterPath(kv.first).c_str());
+    }
+    for (const auto& kv : ringReaders_) {
+      ::remove(FifoFilter::filterPath(kv.first).c_str());
+    }
+  }
+  ringReaders_.clear();
+  running_ = false;
 }
 
 } // memcache
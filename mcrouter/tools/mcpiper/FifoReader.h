@@ -7,6 +7,8 @@
  */
 #pragma once
 
+#include <sys/types.h>
+
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -21,6 +23,8 @@
 #include <folly/io/async/AsyncSocketException.h>
 
 #include "mcrouter/lib/debug/ConnectionFifoProtocol.h"
+#include "mcrouter/lib/debug/FifoFilter.h"
+#include "mcrouter/lib/debug/ShmRing.h"
 #include "mcrouter/lib/network/gen/MemcacheRouterInfo.h"
 
 namespace folly {
@@ -109,19 +113,22 @@ class FifoReaderManager {
    *                        read from the fifo.
    * @param dir             Directory to watch.
    * @param filenamePattern Regex that file names must match.
+   * @param filter          If set, published next to every fifo, so that
+   *                        mcrouter only writes matching traffic.
    */
   FifoReaderManager(
       folly::EventBase& evb,
       MessageReadyFn messageReady,
       std::string dir,
-      std::unique_ptr<boost::regex> filenamePattern);
+      std::unique_ptr<boost::regex> filenamePattern,
+      folly::Optional<FifoFilter> filter = folly::none);
 
   // non-copyable
   FifoReaderManager(const FifoReaderManager&) = delete;
   FifoReaderManager& operator=(const FifoReaderManager&) = delete;
 
   /**
-   * Unregisters all fifo readers
+   * Unregisters all fifo readers and removes the published filters.
    */
   void unregisterCallbacks();
 
@@ -130,15 +137,29 @@ class FifoReaderManager {
       folly::AsyncPipeReader::UniquePtr,
       std::unique_ptr<FifoReadCallback>>;
 
+  struct RingReader {
+    std::unique_ptr<ShmRingReader> ring;
+    std::unique_ptr<FifoReadCallback> callback;
+    // Inode of the ring file, to notice when the writer recreates it.
+    ino_t inode;
+  };
+
   static constexpr size_t kPollDirectoryIntervalMs = 1000;
+  static constexpr size_t kPollRingsIntervalMs = 10;
   folly::EventBase& evb_;
   MessageReadyFn messageReady_;
   const std::string directory_;
   const std::unique_ptr<boost::regex> filenamePattern_;
+  const folly::Optional<FifoFilter> filter_;
   std::unordered_map<std::string, FifoReader> fifoReaders_;
+  std::unordered_map<std::string, RingReader> ringReaders_;
+  bool running_{true};
 
   std::vector<std::string> getMatchedFiles() const;
   void runScanDirectory();
+  bool tryAddRing(const std::string& path);
+  void publishFilter(const std::string& fifoPath) const;
+  void pollRings();
 };
 } // memcache
 } // facebook
@@ -7,11 +7,17 @@
  */
 #include "McPiper.h"
 
+#include <algorithm>
+#include <limits>
 #include <unordered_set>
 
+#include <folly/String.h>
+
+#include "mcrouter/lib/carbon/RequestReplyUtil.h"
 #include "mcrouter/lib/network/CarbonMessageList.h"
 #include "mcrouter/tools/mcpiper/FifoReader.h"
 #include "mcrouter/tools/mcpiper/MessagePrinter.h"
+#include "mcrouter/tools/mcpiper/TrafficCapture.h"
 
 using namespace facebook::memcache::mcpiper;
 
@@ -67,6 +73,7 @@ MessagePrinter::Filter getFilter(const Settings& settings) {
   filter.valueMaxSize = settings.valueMaxSize;
   filter.minLatencyUs = settings.minLatencyUs;
   filter.invertMatch = settings.invertMatch;
+  filter.keyPrefix = settings.keyPrefix;
 
   // Host
   if (!settings.host.empty()) {
@@ -114,6 +121,48 @@ MessagePrinter::Filter getFilter(const Settings& settings) {
   return filter;
 }
 
+/**
+ * Builds the filter that mcrouter applies before writing to the fifos.
+ * Returns none if there's nothing to filter.
+ */
+folly::Optional<FifoFilter> getFifoFilter(const Settings& settings) {
+  FifoFilter filter;
+  filter.keyPrefix = settings.keyPrefix;
+  filter.valueMinSize = settings.valueMinSize;
+  filter.valueMaxSize = settings.valueMaxSize;
+  filter.sampleRate = std::max<uint32_t>(1, settings.sampleRate);
+
+  std::vector<folly::StringPiece> operations;
+  folly::split(',', settings.operations, operations, true /* ignoreEmpty */);
+  for (auto operation : operations) {
+    auto typeId = carbon::getTypeIdByName(operation, McRequestList());
+    if (typeId == 0) {
+      LOG(ERROR) << "Unknown operation: " << operation;
+      exit(1);
+    }
+    filter.typeIds.push_back(typeId);
+  }
+
+  if (filter.keyPrefix.empty() && filter.typeIds.empty() &&
+      filter.sampleRate == 1 && filter.valueMinSize == 0 &&
+      filter.valueMaxSize == std::numeric_limits<uint32_t>::max()) {
+    return folly::none;
+  }
+  if (filter.sampleRate > 1) {
+    std::cerr << "Sampling 1 out of " << filter.sampleRate << " connections"
+              << std::endl;
+  }
+  return filter;
+}
+
+Aggregator::Options getAggregatorOptions(const Settings& settings) {
+  Aggregator::Options options;
+  options.numThreads = settings.aggregateThreads;
+  options.numTopKeys = settings.aggregateTopKeys;
+  options.clearScreen = !settings.script && isatty(fileno(stdout));
+  return options;
+}
+
 } // anonymous
 
 void McPiper::stop() {
@@ -134,11 +183,25 @@ void McPiper::run(Settings settings, std::ostream& targetOut) {
     std::cerr << "Filename pattern: " << *filenamePattern << std::endl;
   }
 
-  messagePrinter_ = std::make_unique<MessagePrinter>(
-      getOptions(settings, this),
-      getFilter(settings),
-      createValueFormatter(),
-      targetOut);
+  if (!settings.captureFile.empty()) {
+    try {
+      captureWriter_ = std::make_unique<CaptureWriter>(settings.captureFile);
+    } catch (const std::exception& e) {
+      LOG(ERROR) << e.what();
+      exit(1);
+    }
+    std::cerr << "Capturing to " << settings.captureFile << std::endl;
+  } else if (settings.aggregate) {
+    aggregator_ = std::make_unique<Aggregator>(
+        getAggregatorOptions(settings), targetOut);
+    scheduleRefresh(std::max<uint32_t>(1, settings.aggregateIntervalMs));
+  } else {
+    messagePrinter_ = std::make_unique<MessagePrinter>(
+        getOptions(settings, this),
+        getFilter(settings),
+        createValueFormatter(),
+        targetOut);
+  }
 
   std::unordered_map<
       uint64_t,
@@ -161,6 +224,27 @@ void McPiper::run(Settings settings, std::ostream& targetOut) {
     if (kNotSupporttedTypes.find(typeId) != kNotSupporttedTypes.end()) {
       return;
     }
+    if (captureWriter_) {
+      if (packetId == 0) {
+        ++captureStats_.totalMessages;
+      }
+      captureWriter_->write(
+          connectionId, packetId, typeId, msgStartTime, routerName, data);
+      return;
+    }
+    if (aggregator_) {
+      // Parsed on the aggregator's threads.
+      aggregator_->messageReady(
+          connectionId,
+          packetId,
+          std::move(from),
+          std::move(to),
+          typeId,
+          msgStartTime,
+          std::move(routerName),
+          data);
+      return;
+    }
     auto it = parserMap.find(connectionId);
     if (it == parserMap.end()) {
       it = addCarbonSnifferParser(
@@ -183,7 +267,8 @@ void McPiper::run(Settings settings, std::ostream& targetOut) {
       eventBase_,
       fifoReaderCallback,
       settings.fifoRoot,
-      std::move(filenamePattern));
+      std::move(filenamePattern),
+      getFifoFilter(settings));
 
   while (running_) {
     eventBase_.loopOnce();
@@ -192,6 +277,18 @@ void McPiper::run(Settings settings, std::ostream& targetOut) {
   fifoReaderManager_.reset();
 }
 
+void McPiper::scheduleRefresh(uint32_t intervalMs) {
+  eventBase_.runAfterDelay(
+      [this, intervalMs]() {
+        if (!running_) {
+          return;
+        }
+        aggregator_->refresh();
+        scheduleRefresh(intervalMs);
+      },
+      intervalMs);
+}
+
 } // mcpiper namespace
 } // memcache namespace
 } // facebook namespace
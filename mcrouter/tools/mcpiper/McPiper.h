@@ -12,9 +12,11 @@
 
 #include <folly/io/async/EventBase.h>
 
+#include "mcrouter/tools/mcpiper/Aggregator.h"
 #include "mcrouter/tools/mcpiper/Config.h"
 #include "mcrouter/tools/mcpiper/FifoReader.h"
 #include "mcrouter/tools/mcpiper/MessagePrinter.h"
+#include "mcrouter/tools/mcpiper/TrafficCapture.h"
 
 namespace facebook {
 namespace memcache {
@@ -40,8 +42,16 @@ struct Settings {
   int64_t minLatencyUs{0};
   size_t verboseLevel{0};
   std::string protocol;
+  std::string keyPrefix;
+  std::string operations;
+  uint32_t sampleRate{1};
   bool raw{false};
   bool script{false};
+  bool aggregate{false};
+  size_t aggregateThreads{4};
+  size_t aggregateTopKeys{10};
+  uint32_t aggregateIntervalMs{1000};
+  std::string captureFile;
 };
 
 class McPiper {
@@ -51,14 +61,22 @@ class McPiper {
   void stop();
 
   const MessagePrinter::Stats& stats() const noexcept {
-    return messagePrinter_->stats();
+    if (captureWriter_) {
+      return captureStats_;
+    }
+    return aggregator_ ? aggregator_->stats() : messagePrinter_->stats();
   }
 
  private:
   folly::EventBase eventBase_;
   std::unique_ptr<MessagePrinter> messagePrinter_;
+  std::unique_ptr<Aggregator> aggregator_;
+  std::unique_ptr<CaptureWriter> captureWriter_;
+  MessagePrinter::Stats captureStats_;
   std::unique_ptr<FifoReaderManager> fifoReaderManager_;
   std::atomic<bool> running_{false};
+
+  void scheduleRefresh(uint32_t intervalMs);
 };
 
 } // mcpiper
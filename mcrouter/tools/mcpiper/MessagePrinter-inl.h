@@ -180,6 +180,9 @@ folly::Optional<StyledString> MessagePrinter::filterAndBuildOutput(
   if (filter_.protocol.hasValue() && filter_.protocol.value() != protocol) {
     return folly::none;
   }
+  if (!folly::StringPiece(key).startsWith(filter_.keyPrefix)) {
+    return folly::none;
+  }
 
   auto value = carbon::valueRangeSlow(const_cast<Message&>(message));
   if (value.size() < filter_.valueMinSize ||
@@ -386,6 +389,7 @@ void MessagePrinter::printRawReply(
               nullptr, /* codec map */
               0.0, /* drop probability */
               ServerLoad::zero(),
+              0, /* credit window */
               iovsBegin,
               iovsCount)) {
         LOG(ERROR) << "Serialization failed for caret reply " << msgId;
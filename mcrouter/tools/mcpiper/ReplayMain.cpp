@@ -0,0 +1,129 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <signal.h>
+
+#include <cstring>
+#include <iostream>
+
+#include <boost/program_options.hpp>
+
+#include <folly/Format.h>
+#include <folly/init/Init.h>
+
+#include "mcrouter/tools/mcpiper/Replayer.h"
+
+using namespace facebook::memcache::mcpiper;
+
+namespace {
+
+std::unique_ptr<Replayer> gReplayer;
+
+void onSignal(int) {
+  gReplayer->stop();
+}
+
+std::string getUsage(const char* binaryName) {
+  return folly::sformat(
+      "Usage: {} [OPTION]... CAPTURE\n"
+      "Replays the requests of CAPTURE (written by mcpiper --capture) "
+      "against HOST:PORT, with their original timing, and compares "
+      "throughput and latency with the captured ones.\n",
+      binaryName);
+}
+
+ReplaySettings parseOptions(int argc, char** argv) {
+  ReplaySettings settings;
+
+  namespace po = boost::program_options;
+
+  po::options_description namedOpts("Allowed options");
+  namedOpts.add_options()("help,h", "Print this help message.")(
+      "host,H",
+      po::value<std::string>(&settings.host),
+      "Host to send traffic to.")(
+      "port,p", po::value<uint16_t>(&settings.port), "Port.")(
+      "protocol",
+      po::value<std::string>(&settings.protocol),
+      "\"ascii\", \"umbrella\" or \"caret\".")(
+      "speed,s",
+      po::value<double>(&settings.speed),
+      "Replay speed, relative to the capture (e.g. 2 for twice as fast).")(
+      "threads,t",
+      po::value<size_t>(&settings.numThreads),
+      "Number of event base threads.")(
+      "timeout",
+      po::value<uint32_t>(&settings.timeoutMs),
+      "Request timeout in milliseconds.")(
+      "report-interval",
+      po::value<uint32_t>(&settings.reportIntervalS),
+      "Seconds between progress reports.");
+
+  // Positional arguments - hidden from the help message
+  po::options_description hiddenOpts("Hidden options");
+  hiddenOpts.add_options()(
+      "capture",
+      po::value<std::string>(&settings.captureFile),
+      "Capture file");
+  po::positional_options_description posArgs;
+  posArgs.add("capture", 1);
+
+  po::variables_map vm;
+  try {
+    po::options_description allOpts;
+    allOpts.add(namedOpts).add(hiddenOpts);
+    po::store(
+        po::command_line_parser(argc, argv)
+            .options(allOpts)
+            .positional(posArgs)
+            .run(),
+        vm);
+    po::notify(vm);
+  } catch (po::error& ex) {
+    LOG(ERROR) << ex.what();
+    exit(1);
+  }
+
+  if (vm.count("help") || settings.captureFile.empty()) {
+    std::cerr << getUsage(argv[0]) << std::endl;
+    namedOpts.print(std::cerr);
+    exit(vm.count("help") ? 0 : 1);
+  }
+
+  return settings;
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+  // Just give the binary name to folly::init() because we use
+  // boost::program_options instead of gflags.
+  int tempArgc = 1;
+  folly::init(&tempArgc, &argv, false);
+
+  try {
+    gReplayer = std::make_unique<Replayer>(parseOptions(argc, argv));
+    gReplayer->load();
+  } catch (const std::exception& e) {
+    LOG(ERROR) << e.what();
+    return 1;
+  }
+
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(struct sigaction));
+  sa.sa_handler = onSignal;
+  sigaction(SIGINT, &sa, nullptr);
+  signal(SIGPIPE, SIG_IGN);
+
+  try {
+    gReplayer->run();
+  } catch (const std::exception& e) {
+    LOG(ERROR) << e.what();
+    return 1;
+  }
+  return 0;
+}
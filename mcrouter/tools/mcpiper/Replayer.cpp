@@ -0,0 +1,399 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include "Replayer.h"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+
+#include <folly/Format.h>
+#include <folly/fibers/EventBaseLoopController.h>
+#include <folly/fibers/FiberManager.h>
+#include <folly/hash/Hash.h>
+#include <folly/io/async/EventBase.h>
+
+#include "mcrouter/lib/McResUtil.h"
+#include "mcrouter/lib/network/AsyncMcClient.h"
+#include "mcrouter/lib/network/gen/MemcacheMessages.h"
+#include "mcrouter/lib/network/gen/MemcacheRouterInfo.h"
+#include "mcrouter/tools/mcpiper/SnifferParser.h"
+#include "mcrouter/tools/mcpiper/TrafficCapture.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcpiper {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// How often workers check for due requests.
+constexpr uint32_t kTickIntervalMs = 1;
+
+size_t workerIndex(uint64_t connectionId, size_t numWorkers) {
+  return folly::hash::twang_mix64(connectionId) % numWorkers;
+}
+
+// Requests that would take the replay target down.
+template <class Request>
+constexpr bool isReplayable() {
+  return !std::is_same<Request, McQuitRequest>::value &&
+      !std::is_same<Request, McShutdownRequest>::value;
+}
+
+double percentDelta(double before, double after) {
+  return before > 0 ? 100.0 * (after - before) / before : 0.0;
+}
+
+} // anonymous
+
+/**
+ * Parses the captured packets and turns the requests into ReplayRequests.
+ */
+class Replayer::Loader {
+ public:
+  explicit Loader(Replayer& replayer) : replayer_(replayer) {}
+
+  void add(const CapturedPacket& packet) {
+    if (packet.typeId == McStatsReply::typeId) {
+      // Not supported by the parser.
+      return;
+    }
+    auto it = parsers_.find(packet.connectionId);
+    if (it == parsers_.end()) {
+      it = parsers_
+               .emplace(
+                   packet.connectionId,
+                   std::make_unique<SnifferParser<
+                       Loader,
+                       memcache::detail::MemcacheRequestList>>(*this))
+               .first;
+    }
+    auto& snifferParser = it->second;
+
+    if (packet.packetId == 0) {
+      snifferParser->resetParser();
+    }
+
+    connectionId_ = packet.connectionId;
+    timeUs_ = packet.msgStartTimeUs;
+    snifferParser->setCurrentMsgStartTime(packet.msgStartTimeUs);
+    snifferParser->parse(
+        folly::ByteRange(folly::StringPiece(packet.data)),
+        packet.typeId,
+        packet.packetId == 0 /* isFirstPacket */);
+  }
+
+  // SnifferParser Callbacks
+  template <class Request>
+  void requestReady(
+      uint64_t /* msgId */,
+      Request&& request,
+      const folly::SocketAddress& /* from */,
+      const folly::SocketAddress& /* to */,
+      mc_protocol_t /* protocol */) {
+    if (!isReplayable<Request>()) {
+      return;
+    }
+    auto& requests = replayer_.requests_[workerIndex(
+        connectionId_, replayer_.requests_.size())];
+    requests.push_back(ReplayRequest{
+        timeUs_,
+        connectionId_,
+        [request = std::move(request)](
+            AsyncMcClient& client, std::chrono::milliseconds timeout) {
+          return client.sendSync(request, timeout).result();
+        }});
+
+    if (replayer_.numRequests_++ == 0) {
+      replayer_.firstTimeUs_ = timeUs_;
+      replayer_.lastTimeUs_ = timeUs_;
+    }
+    replayer_.firstTimeUs_ = std::min(replayer_.firstTimeUs_, timeUs_);
+    replayer_.lastTimeUs_ = std::max(replayer_.lastTimeUs_, timeUs_);
+  }
+
+  template <class Reply>
+  void replyReady(
+      uint64_t /* msgId */,
+      Reply&& /* reply */,
+      std::string /* key */,
+      const folly::SocketAddress& /* from */,
+      const folly::SocketAddress& /* to */,
+      mc_protocol_t /* protocol */,
+      int64_t latencyUs,
+      ReplyStatsContext /* replyStatsContext */) {
+    if (latencyUs > 0) {
+      replayer_.capturedLatency_.insertSample(latencyUs);
+    }
+  }
+
+ private:
+  Replayer& replayer_;
+  std::unordered_map<uint64_t, std::unique_ptr<SnifferParserBase<Loader>>>
+      parsers_;
+  // Connection and time of the packet being parsed.
+  uint64_t connectionId_{0};
+  uint64_t timeUs_{0};
+};
+
+class Replayer::Worker {
+ public:
+  Worker(
+      const ReplaySettings& settings,
+      Stats& stats,
+      std::atomic<size_t>& workersDone,
+      std::vector<ReplayRequest>& requests,
+      uint64_t firstTimeUs)
+      : settings_(settings),
+        stats_(stats),
+        workersDone_(workersDone),
+        requests_(requests),
+        firstTimeUs_(firstTimeUs),
+        fm_(std::make_unique<folly::fibers::EventBaseLoopController>()),
+        timeout_(settings.timeoutMs) {
+    dynamic_cast<folly::fibers::EventBaseLoopController&>(fm_.loopController())
+        .attachEventBase(evb_);
+  }
+
+  void start(Clock::time_point start) {
+    start_ = start;
+    thread_ = std::thread([this]() {
+      evb_.runInEventBaseThread([this]() { tick(); });
+      evb_.loopForever();
+      clients_.clear();
+      ++workersDone_;
+    });
+  }
+
+  void stop() {
+    evb_.runInEventBaseThread([this]() { stopped_ = true; });
+  }
+
+  void join() {
+    thread_.join();
+  }
+
+ private:
+  const ReplaySettings& settings_;
+  Stats& stats_;
+  std::atomic<size_t>& workersDone_;
+  std::vector<ReplayRequest>& requests_;
+  const uint64_t firstTimeUs_;
+
+  folly::EventBase evb_;
+  folly::fibers::FiberManager fm_;
+  // Captured connection id -> connection replaying it.
+  std::unordered_map<uint64_t, std::unique_ptr<AsyncMcClient>> clients_;
+  std::thread thread_;
+
+  const std::chrono::milliseconds timeout_;
+  Clock::time_point start_;
+  size_t next_{0};
+  size_t outstanding_{0};
+  bool stopped_{false};
+
+  bool issuedAll() const {
+    return stopped_ || next_ == requests_.size();
+  }
+
+  void tick() {
+    issueDue();
+    if (!issuedAll()) {
+      evb_.runAfterDelay([this]() { tick(); }, kTickIntervalMs);
+    } else if (outstanding_ == 0) {
+      evb_.terminateLoopSoon();
+    }
+  }
+
+  Clock::time_point dueTime(const ReplayRequest& request) const {
+    return start_ +
+        std::chrono::nanoseconds(static_cast<int64_t>(
+            1000.0 * (request.timeUs - firstTimeUs_) / settings_.speed));
+  }
+
+  void issueDue() {
+    const auto now = Clock::now();
+    while (!issuedAll() && dueTime(requests_[next_]) <= now) {
+      auto& request = requests_[next_++];
+      const auto intended = dueTime(request);
+      ++outstanding_;
+      fm_.addTask([this, &request, intended]() {
+        send(request, intended);
+        --outstanding_;
+        if (outstanding_ == 0 && issuedAll()) {
+          evb_.terminateLoopSoon();
+        }
+      });
+    }
+  }
+
+  AsyncMcClient& client(uint64_t connectionId) {
+    auto& client = clients_[connectionId];
+    if (!client) {
+      ConnectionOptions opts(
+          settings_.host,
+          settings_.port,
+          mc_string_to_protocol(settings_.protocol.c_str()));
+      opts.writeTimeout = timeout_;
+      client = std::make_unique<AsyncMcClient>(evb_, opts);
+    }
+    return *client;
+  }
+
+  void send(ReplayRequest& request, Clock::time_point intended) {
+    const auto result = request.send(client(request.connectionId), timeout_);
+
+    const auto latencyUs =
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            Clock::now() - intended)
+            .count();
+    stats_.latency.insertSample(latencyUs);
+    stats_.intervalLatency.insertSample(latencyUs);
+    stats_.completed.fetch_add(1, std::memory_order_relaxed);
+    if (result == mc_res_timeout) {
+      stats_.timeouts.fetch_add(1, std::memory_order_relaxed);
+    } else if (isErrorResult(result)) {
+      stats_.errors.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+};
+
+Replayer::Replayer(ReplaySettings settings) : settings_(std::move(settings)) {
+  if (settings_.speed <= 0 || settings_.numThreads == 0) {
+    throw std::invalid_argument("speed and threads must be positive");
+  }
+  if (mc_string_to_protocol(settings_.protocol.c_str()) ==
+      mc_unknown_protocol) {
+    throw std::invalid_argument("Unknown protocol: " + settings_.protocol);
+  }
+  requests_.resize(settings_.numThreads);
+}
+
+Replayer::~Replayer() {}
+
+void Replayer::load() {
+  CaptureReader reader(settings_.captureFile);
+  Loader loader(*this);
+  CapturedPacket packet;
+  while (reader.next(packet)) {
+    loader.add(packet);
+  }
+  // Packets of different fifos are captured in the order they are read.
+  for (auto& requests : requests_) {
+    std::stable_sort(
+        requests.begin(),
+        requests.end(),
+        [](const ReplayRequest& a, const ReplayRequest& b) {
+          return a.timeUs < b.timeUs;
+        });
+  }
+  std::cerr << folly::sformat(
+                   "Loaded {} requests spanning {:.1f}s",
+                   numRequests_,
+                   (lastTimeUs_ - firstTimeUs_) / 1e6)
+            << std::endl;
+}
+
+void Replayer::stop() {
+  stopped_ = true;
+}
+
+void Replayer::run() {
+  for (auto& requests : requests_) {
+    workers_.push_back(std::make_unique<Worker>(
+        settings_, stats_, workersDone_, requests, firstTimeUs_));
+  }
+  const auto start = Clock::now();
+  for (auto& worker : workers_) {
+    worker->start(start);
+  }
+
+  uint64_t lastCompleted = 0;
+  auto lastReport = start;
+  while (workersDone_ < workers_.size() && !stopped_) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    const auto now = Clock::now();
+    if (now - lastReport >= std::chrono::seconds(settings_.reportIntervalS)) {
+      const auto completed = stats_.completed.load();
+      report(
+          std::chrono::duration<double>(now - lastReport).count(),
+          completed - lastCompleted);
+      lastCompleted = completed;
+      lastReport = now;
+    }
+  }
+
+  for (auto& worker : workers_) {
+    worker->stop();
+  }
+  for (auto& worker : workers_) {
+    worker->join();
+  }
+  printSummary(std::chrono::duration<double>(Clock::now() - start).count());
+  workers_.clear();
+}
+
+void Replayer::report(double seconds, uint64_t completed) {
+  std::cerr << folly::sformat(
+                   "{:.0f} req/s, p50 {}us, p99 {}us, {}/{} done",
+                   completed / seconds,
+                   stats_.intervalLatency.percentile(0.5),
+                   stats_.intervalLatency.percentile(0.99),
+                   stats_.completed.load(),
+                   numRequests_)
+            << std::endl;
+  stats_.intervalLatency.reset();
+}
+
+void Replayer::printSummary(double seconds) {
+  const double capturedSeconds = (lastTimeUs_ - firstTimeUs_) / 1e6;
+  const double capturedRate =
+      capturedSeconds > 0 ? numRequests_ / capturedSeconds : 0.0;
+  const auto completed = stats_.completed.load();
+  // Throughput the replay would have at 1x speed, to compare with capture.
+  const double replayedRate =
+      seconds > 0 ? completed / seconds / settings_.speed : 0.0;
+
+  std::cout << folly::sformat(
+      "captured: {} requests in {:.1f}s: {:.0f} req/s, "
+      "latency us p50 {} p99 {} p99.9 {}\n"
+      "replayed at {}x: {} requests in {:.1f}s: {:.0f} req/s at 1x "
+      "({:+.1f}%), errors: {}, timeouts: {}\n"
+      "latency us p50 {} ({:+.1f}%) p99 {} ({:+.1f}%) p99.9 {} ({:+.1f}%)\n",
+      numRequests_,
+      capturedSeconds,
+      capturedRate,
+      capturedLatency_.percentile(0.5),
+      capturedLatency_.percentile(0.99),
+      capturedLatency_.percentile(0.999),
+      settings_.speed,
+      completed,
+      seconds,
+      replayedRate,
+      percentDelta(capturedRate, replayedRate),
+      stats_.errors.load(),
+      stats_.timeouts.load(),
+      stats_.latency.percentile(0.5),
+      percentDelta(
+          capturedLatency_.percentile(0.5), stats_.latency.percentile(0.5)),
+      stats_.latency.percentile(0.99),
+      percentDelta(
+          capturedLatency_.percentile(0.99), stats_.latency.percentile(0.99)),
+      stats_.latency.percentile(0.999),
+      percentDelta(
+          capturedLatency_.percentile(0.999),
+          stats_.latency.percentile(0.999)));
+}
+
+} // mcpiper
+} // memcache
+} // facebook
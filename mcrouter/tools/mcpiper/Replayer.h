@@ -0,0 +1,129 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <folly/Function.h>
+
+#include "mcrouter/LatencyHistogram.h"
+#include "mcrouter/lib/mc/msg.h"
+
+namespace facebook {
+namespace memcache {
+
+class AsyncMcClient;
+
+namespace mcpiper {
+
+struct ReplaySettings {
+  std::string captureFile;
+  std::string host{"localhost"};
+  uint16_t port{5000};
+  std::string protocol{"caret"};
+  // 2 replays the capture twice as fast as it was recorded.
+  double speed{1.0};
+  size_t numThreads{4};
+  uint32_t timeoutMs{1000};
+  uint32_t reportIntervalS{1};
+};
+
+/**
+ * Replays the requests of a capture written by mcpiper --capture.
+ *
+ * Every captured connection gets a connection of its own, and requests are
+ * sent at their original time (scaled by settings.speed), whether or not
+ * the previous ones completed, so the replay has the inter-arrival times and
+ * concurrency of the captured traffic. As in mcload, latency is measured
+ * from the time a request was due. The summary compares throughput and
+ * latency with the ones of the capture.
+ *
+ * The whole capture is loaded in memory before the replay starts.
+ */
+class Replayer {
+ public:
+  struct Stats {
+    std::atomic<uint64_t> completed{0};
+    std::atomic<uint64_t> errors{0};
+    std::atomic<uint64_t> timeouts{0};
+    // Latency of requests, in microseconds.
+    mcrouter::LatencyHistogram latency;
+    // Same, reset at every report.
+    mcrouter::LatencyHistogram intervalLatency;
+  };
+
+  /**
+   * @throw std::exception  if settings are invalid.
+   */
+  explicit Replayer(ReplaySettings settings);
+  ~Replayer();
+
+  /**
+   * Parses the capture and prepares the requests to replay.
+   *
+   * @throw std::runtime_error  if the capture can't be read.
+   */
+  void load();
+
+  /**
+   * Replays the capture (until the last request completes or stop() is
+   * called), printing progress every settings.reportIntervalS seconds and a
+   * summary at the end.
+   */
+  void run();
+
+  /**
+   * Makes run() return early. Thread-safe.
+   */
+  void stop();
+
+  const Stats& stats() const {
+    return stats_;
+  }
+
+ private:
+  class Loader;
+  class Worker;
+
+  using SendFn = folly::Function<mc_res_t(
+      AsyncMcClient& client,
+      std::chrono::milliseconds timeout)>;
+
+  struct ReplayRequest {
+    // Time the request was captured, in microseconds.
+    uint64_t timeUs;
+    uint64_t connectionId;
+    SendFn send;
+  };
+
+  const ReplaySettings settings_;
+  Stats stats_;
+  // Requests to replay, by worker.
+  std::vector<std::vector<ReplayRequest>> requests_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::atomic<size_t> workersDone_{0};
+  std::atomic<bool> stopped_{false};
+
+  // Captured traffic.
+  uint64_t numRequests_{0};
+  uint64_t firstTimeUs_{0};
+  uint64_t lastTimeUs_{0};
+  mcrouter::LatencyHistogram capturedLatency_;
+
+  void report(double seconds, uint64_t completed);
+  void printSummary(double seconds);
+};
+
+} // mcpiper
+} // memcache
+} // facebook
@@ -0,0 +1,108 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include "TrafficCapture.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace facebook {
+namespace memcache {
+
+namespace {
+
+constexpr folly::StringPiece kMagic{"MCPCAP01"};
+
+template <class T>
+void writeInt(std::ofstream& out, T value) {
+  char bytes[sizeof(T)];
+  for (size_t i = 0; i < sizeof(T); ++i) {
+    bytes[i] = static_cast<char>(value >> (8 * i));
+  }
+  out.write(bytes, sizeof(T));
+}
+
+template <class T>
+bool readInt(std::ifstream& in, T& value) {
+  unsigned char bytes[sizeof(T)];
+  if (!in.read(reinterpret_cast<char*>(bytes), sizeof(T))) {
+    return false;
+  }
+  value = 0;
+  for (size_t i = 0; i < sizeof(T); ++i) {
+    value |= static_cast<T>(bytes[i]) << (8 * i);
+  }
+  return true;
+}
+
+bool readString(std::ifstream& in, size_t size, std::string& str) {
+  str.resize(size);
+  return size == 0 || in.read(&str[0], size);
+}
+
+} // anonymous namespace
+
+CaptureWriter::CaptureWriter(const std::string& path)
+    : path_(path), out_(path, std::ios::binary | std::ios::trunc) {
+  out_.write(kMagic.data(), kMagic.size());
+  if (!out_) {
+    throw std::runtime_error("Can't create capture file " + path_);
+  }
+}
+
+void CaptureWriter::write(
+    uint64_t connectionId,
+    uint64_t packetId,
+    uint32_t typeId,
+    uint64_t msgStartTimeUs,
+    folly::StringPiece routerName,
+    folly::ByteRange data) {
+  routerName = routerName.subpiece(
+      0, std::min<size_t>(routerName.size(), UINT8_MAX));
+  writeInt<uint64_t>(out_, connectionId);
+  writeInt<uint64_t>(out_, packetId);
+  writeInt<uint64_t>(out_, msgStartTimeUs);
+  writeInt<uint32_t>(out_, typeId);
+  writeInt<uint32_t>(out_, data.size());
+  writeInt<uint8_t>(out_, routerName.size());
+  out_.write(routerName.data(), routerName.size());
+  out_.write(reinterpret_cast<const char*>(data.data()), data.size());
+  if (!out_) {
+    throw std::runtime_error("Error writing to capture file " + path_);
+  }
+  ++numPackets_;
+}
+
+CaptureReader::CaptureReader(const std::string& path)
+    : path_(path), in_(path, std::ios::binary) {
+  std::string magic;
+  if (!in_ || !readString(in_, kMagic.size(), magic) || magic != kMagic) {
+    throw std::runtime_error(path_ + " is not an mcpiper capture");
+  }
+}
+
+bool CaptureReader::next(CapturedPacket& packet) {
+  if (!readInt(in_, packet.connectionId)) {
+    if (in_.gcount() == 0 && in_.eof()) {
+      return false;
+    }
+    throw std::runtime_error("Truncated capture file " + path_);
+  }
+  uint32_t dataSize;
+  uint8_t routerNameSize;
+  if (!readInt(in_, packet.packetId) || !readInt(in_, packet.msgStartTimeUs) ||
+      !readInt(in_, packet.typeId) || !readInt(in_, dataSize) ||
+      !readInt(in_, routerNameSize) ||
+      !readString(in_, routerNameSize, packet.routerName) ||
+      !readString(in_, dataSize, packet.data)) {
+    throw std::runtime_error("Truncated capture file " + path_);
+  }
+  return true;
+}
+
+} // memcache
+} // facebook
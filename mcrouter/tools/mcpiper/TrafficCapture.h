@@ -0,0 +1,94 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+#include <folly/Range.h>
+
+namespace facebook {
+namespace memcache {
+
+/**
+ * A packet read from mcrouter's debug fifos, as stored in a capture.
+ */
+struct CapturedPacket {
+  uint64_t connectionId{0};
+  uint64_t packetId{0};
+  uint32_t typeId{0};
+  // Time mcrouter sent/received the message, in microseconds.
+  uint64_t msgStartTimeUs{0};
+  std::string routerName;
+  std::string data;
+};
+
+/**
+ * Writes the packets read from the debug fifos to a compact binary capture
+ * (mcpiper --capture), to be replayed later by mcreplay.
+ *
+ * Format: the magic "MCPCAP01", then for every packet its connection id,
+ * packet id and start time (8 bytes each), its type id and data size
+ * (4 bytes each), the size of the router name (1 byte), the router name and
+ * the data. Integers are little endian. Addresses are not stored.
+ */
+class CaptureWriter {
+ public:
+  /**
+   * @throw std::runtime_error  if the file can't be created.
+   */
+  explicit CaptureWriter(const std::string& path);
+
+  /**
+   * @throw std::runtime_error  on write errors.
+   */
+  void write(
+      uint64_t connectionId,
+      uint64_t packetId,
+      uint32_t typeId,
+      uint64_t msgStartTimeUs,
+      folly::StringPiece routerName,
+      folly::ByteRange data);
+
+  uint64_t numPackets() const {
+    return numPackets_;
+  }
+
+ private:
+  const std::string path_;
+  std::ofstream out_;
+  uint64_t numPackets_{0};
+};
+
+/**
+ * Reads a capture written by CaptureWriter.
+ */
+class CaptureReader {
+ public:
+  /**
+   * @throw std::runtime_error  if the file can't be opened or is not a
+   *                            capture.
+   */
+  explicit CaptureReader(const std::string& path);
+
+  /**
+   * Reads the next packet.
+   *
+   * @return  false at the end of the capture.
+   * @throw std::runtime_error  if the capture is truncated.
+   */
+  bool next(CapturedPacket& packet);
+
+ private:
+  const std::string path_;
+  std::ifstream in_;
+};
+
+} // memcache
+} // facebook
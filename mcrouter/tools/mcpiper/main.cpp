@@ -107,6 +107,15 @@ Settings parseOptions(int argc, char** argv) {
       po::value<std::string>(&settings.protocol),
       "Show only data transmitted in the provided protocol; "
       "ARG is \"ascii\", \"umbrella\" or \"caret\".")(
+      "key-prefix",
+      po::value<std::string>(&settings.keyPrefix),
+      "Show only messages whose key starts with the provided prefix.")(
+      "operations",
+      po::value<std::string>(&settings.operations),
+      "Comma separated list of operations (e.g. \"get,set\") to show.")(
+      "sample-rate",
+      po::value<uint32_t>(&settings.sampleRate),
+      "Show only 1 out of <arg> connections.")(
       "verbose",
       po::value<size_t>(&settings.verboseLevel),
       "Set verbose level")(
@@ -116,7 +125,28 @@ Settings parseOptions(int argc, char** argv) {
       "ASCII protocol is not supported")(
       "script",
       po::bool_switch(&settings.script)->default_value(false),
-      "Machine-readable JSON output (useful for post-processing).");
+      "Machine-readable JSON output (useful for post-processing).")(
+      "aggregate",
+      po::bool_switch(&settings.aggregate)->default_value(false),
+      "Instead of printing messages, periodically print a summary of the "
+      "traffic: requests/s by operation, hottest keys, value sizes and "
+      "latency by destination. Only fifo-side filters (--key-prefix, "
+      "--operations, --sample-rate and value sizes) apply.")(
+      "aggregate-threads",
+      po::value<size_t>(&settings.aggregateThreads),
+      "Number of threads parsing messages in --aggregate mode.")(
+      "aggregate-top-keys",
+      po::value<size_t>(&settings.aggregateTopKeys),
+      "Number of hottest keys to show in --aggregate mode.")(
+      "aggregate-interval-ms",
+      po::value<uint32_t>(&settings.aggregateIntervalMs),
+      "Interval between summaries in --aggregate mode.")(
+      "capture",
+      po::value<std::string>(&settings.captureFile),
+      "Instead of printing messages, write the raw fifo traffic to the "
+      "given file, to be replayed by mcreplay. Only fifo-side filters apply; "
+      "use --filename-pattern=server to capture only the traffic of "
+      "mcrouter's clients.");
 
   // Positional arguments - hidden from the help message
   po::options_description hiddenOpts("Hidden options");
@@ -0,0 +1,105 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/tools/mcpiper/AggregateStats.h"
+
+using namespace facebook::memcache;
+
+TEST(TopKeys, exactBelowCapacity) {
+  TopKeys topKeys(8);
+  for (size_t i = 0; i < 5; ++i) {
+    for (size_t j = 0; j <= i; ++j) {
+      topKeys.add("key" + std::to_string(i));
+    }
+  }
+  auto top = topKeys.top(3);
+  ASSERT_EQ(3, top.size());
+  EXPECT_EQ("key4", top[0].first);
+  EXPECT_EQ(5, top[0].second);
+  EXPECT_EQ("key3", top[1].first);
+  EXPECT_EQ(4, top[1].second);
+  EXPECT_EQ("key2", top[2].first);
+  EXPECT_EQ(3, top[2].second);
+}
+
+TEST(TopKeys, hotKeySurvivesEvictions) {
+  TopKeys topKeys(4);
+  for (size_t i = 0; i < 1000; ++i) {
+    topKeys.add("hot");
+    topKeys.add("cold" + std::to_string(i));
+  }
+  EXPECT_EQ(4, topKeys.size());
+  auto top = topKeys.top(1);
+  ASSERT_EQ(1, top.size());
+  EXPECT_EQ("hot", top[0].first);
+  EXPECT_GE(top[0].second, 1000);
+}
+
+TEST(TopKeys, merge) {
+  TopKeys a(8);
+  TopKeys b(8);
+  a.add("x", 3);
+  b.add("x", 4);
+  b.add("y", 5);
+  a.merge(b);
+  auto top = a.top(2);
+  ASSERT_EQ(2, top.size());
+  EXPECT_EQ("x", top[0].first);
+  EXPECT_EQ(7, top[0].second);
+  EXPECT_EQ("y", top[1].first);
+  EXPECT_EQ(5, top[1].second);
+}
+
+TEST(Log2Histogram, buckets) {
+  Log2Histogram histogram;
+  EXPECT_EQ(0, histogram.percentile(50));
+
+  histogram.add(0);
+  histogram.add(1);
+  histogram.add(100);
+  histogram.add(100);
+  EXPECT_EQ(4, histogram.count());
+  EXPECT_EQ(100, histogram.max());
+  EXPECT_DOUBLE_EQ(50.25, histogram.average());
+  EXPECT_EQ(1, histogram.bucketCount(0));
+  EXPECT_EQ(1, histogram.bucketCount(1));
+  // 100 is in [64, 128).
+  EXPECT_EQ(2, histogram.bucketCount(7));
+  EXPECT_EQ(127, Log2Histogram::bucketUpperBound(7));
+
+  EXPECT_EQ(1, histogram.percentile(50));
+  // Capped at the largest value seen.
+  EXPECT_EQ(100, histogram.percentile(99));
+}
+
+TEST(AggregateStats, merge) {
+  AggregateStats a(16);
+  a.requests = 2;
+  a.requestsByOperation["get"] = 2;
+  a.latencyByDestination["host1"].add(10);
+
+  AggregateStats b(16);
+  b.requests = 3;
+  b.replies = 1;
+  b.requestsByOperation["get"] = 1;
+  b.requestsByOperation["set"] = 2;
+  b.latencyByDestination["host1"].add(30);
+  b.latencyByDestination["host2"].add(5);
+
+  a.merge(b);
+  EXPECT_EQ(5, a.requests);
+  EXPECT_EQ(1, a.replies);
+  EXPECT_EQ(3, a.requestsByOperation["get"]);
+  EXPECT_EQ(2, a.requestsByOperation["set"]);
+  EXPECT_EQ(2, a.latencyByDestination["host1"].count());
+  EXPECT_EQ(30, a.latencyByDestination["host1"].max());
+  EXPECT_EQ(1, a.latencyByDestination["host2"].count());
+}
@@ -0,0 +1,87 @@
+/*
+ *  Copyright (c) 2018-present, Facebook, Inc.
+ *
+ *  This source code is licensed under the MIT license found in the LICENSE
+ *  file in the root directory of this source tree.
+ *
+ */
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/tools/mcpiper/TrafficCapture.h"
+
+using namespace facebook::memcache;
+
+namespace {
+
+std::string tempPath() {
+  char path[] = "/tmp/mcpiper_capture_XXXXXX";
+  int fd = mkstemp(path);
+  EXPECT_GE(fd, 0);
+  close(fd);
+  return path;
+}
+
+folly::ByteRange bytes(folly::StringPiece str) {
+  return folly::ByteRange(str);
+}
+
+} // anonymous namespace
+
+TEST(TrafficCapture, roundTrip) {
+  auto path = tempPath();
+  std::string large(100000, 'x');
+  {
+    CaptureWriter writer(path);
+    writer.write(1, 0, 7, 1000, "router", bytes("get a\r\n"));
+    writer.write(1, 1, 7, 1000, "router", bytes(""));
+    writer.write(0xffffffffffULL, 0, 8, 2000, "", bytes(large));
+    EXPECT_EQ(3, writer.numPackets());
+  }
+
+  CaptureReader reader(path);
+  CapturedPacket packet;
+  ASSERT_TRUE(reader.next(packet));
+  EXPECT_EQ(1, packet.connectionId);
+  EXPECT_EQ(0, packet.packetId);
+  EXPECT_EQ(7, packet.typeId);
+  EXPECT_EQ(1000, packet.msgStartTimeUs);
+  EXPECT_EQ("router", packet.routerName);
+  EXPECT_EQ("get a\r\n", packet.data);
+
+  ASSERT_TRUE(reader.next(packet));
+  EXPECT_EQ(1, packet.packetId);
+  EXPECT_EQ("", packet.data);
+
+  ASSERT_TRUE(reader.next(packet));
+  EXPECT_EQ(0xffffffffffULL, packet.connectionId);
+  EXPECT_EQ(8, packet.typeId);
+  EXPECT_EQ(2000, packet.msgStartTimeUs);
+  EXPECT_EQ("", packet.routerName);
+  EXPECT_EQ(large, packet.data);
+
+  EXPECT_FALSE(reader.next(packet));
+  unlink(path.c_str());
+}
+
+TEST(TrafficCapture, invalidFiles) {
+  auto path = tempPath();
+  EXPECT_THROW(CaptureReader reader(path), std::runtime_error);
+
+  {
+    CaptureWriter writer(path);
+    writer.write(1, 0, 7, 1000, "router", bytes("get a\r\n"));
+  }
+  // Cut the last packet short.
+  ASSERT_EQ(0, truncate(path.c_str(), 20));
+  CaptureReader reader(path);
+  CapturedPacket packet;
+  EXPECT_THROW(reader.next(packet), std::runtime_error);
+  unlink(path.c_str());
+}